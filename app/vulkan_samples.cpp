@@ -17,8 +17,17 @@
 
 #include "vulkan_samples.h"
 
+#include <chrono>
+#include <fstream>
+#include <thread>
+
+#include "common/helpers.h"
 #include "common/logging.h"
+#include "platform/asset_archive.h"
+#include "platform/filesystem.h"
 #include "platform/platform.h"
+#include "platform/process.h"
+#include "timer.h"
 
 #if defined(VK_USE_PLATFORM_ANDROID_KHR)
 #	include <jni.h>
@@ -117,7 +126,7 @@ VulkanSamples::VulkanSamples()
 	    R"(Vulkan Samples.
 	Usage:
 		vulkan_samples <sample>
-		vulkan_samples (--sample <arg> | --test <arg> | --batch <arg> [<tags>...]) [--benchmark <frames>] [--width <arg>] [--height <arg>] [--headless] 
+		vulkan_samples (--sample <arg> | --test <arg> | --batch <arg> [<tags>...]) [--benchmark <frames>] [--benchmark-warmup <frames>] [--benchmark-report <file>] [--jobs <count>] [--gpu <index>] [--gpu-count <count>] [--cores-per-job <count>] [--screenshot-interval <frames>] [--screenshot-qoi] [--frame-count <count>] [--width <arg>] [--height <arg>] [--headless] [--pipeline-cache <dir>] [--progressive-loading] [--asset-archive <file>] [--scene-cache] [--gpu-profile] [--capture-spikes] [--record-stats] [--analyze-render-passes] [--msaa <samples>] [--msaa-separate-resolve] [--tune-frame-strategies] [--sweep] [--target-fps <fps>] [--thermal-pacing] [--decoupled-simulation] [--parallel-recording] [--device-group] [--configuration <index>] [--reload-shaders] [--cache-budget <count>] [--low-latency-present] [--immediate-present]
 		vulkan_samples --help
 
 	Options:
@@ -126,7 +135,38 @@ VulkanSamples::VulkanSamples()
 		--test TEST_ID            Run test.
 		--batch CATEGORY          Run all samples within a certain category, specify 'all' to run all.
 		--benchmark FRAMES        Run app under benchmark mode for n amount of frames.
-		--headless                Run the app with headless rendering.)"
+		--benchmark-warmup FRAMES Run n frames before the measured benchmark frames.
+		--benchmark-report FILE   Write the benchmark results to FILE in the graphs directory [default: benchmark.json].
+		--jobs COUNT              Run the batch samples headless in COUNT parallel processes and write one report of their benchmarks.
+		--gpu INDEX               Run on the physical device INDEX, in the order they are enumerated.
+		--gpu-count COUNT         Spread the parallel batch processes over the first COUNT physical devices.
+		--cores-per-job COUNT     Pin each parallel batch process to its own COUNT CPU cores.
+		--screenshot-interval FRAMES Capture a screenshot every n frames, in the background.
+		--screenshot-qoi          Write the screenshots as QOI rather than PNG images.
+		--frame-count COUNT       Render with COUNT frames in turn, the CPU recording up to COUNT frames ahead of the GPU.
+		--headless                Run the app with headless rendering.
+		--pipeline-cache DIR      Persist the pipeline cache in DIR and warm it up on the next launch.
+		--progressive-loading     Start rendering before the scene textures are loaded.
+		--asset-archive FILE      Load the assets packed in FILE by asset_packer, before the assets directory.
+		--scene-cache             Cache the loaded scenes in the temporary directory and load them from it on later launches.
+		--gpu-profile             Show the GPU time of subpasses and write it to a JSON file.
+		--capture-spikes          Write the timings, cache misses and memory usage of the frames before frame time spikes.
+		--record-stats            Write the raw samples of the requested stats of every frame to a CSV file.
+		--analyze-render-passes   Log the render passes to merge and attachment loads and stores to skip on tile based GPUs.
+		--msaa SAMPLES            Render with SAMPLES samples per pixel, resolved on writeback of the tiles.
+		--msaa-separate-resolve   Resolve the multisampled color after the render pass instead, to compare the bandwidth.
+		--tune-frame-strategies   Pick the descriptor set caching and buffer allocation strategies of the frames at runtime.
+		--sweep                   Run the parameter sweep of the sample if it has one, writing the results to JSON, then exit.
+		--target-fps FPS          Pace the frames at FPS frames per second, sleeping then spinning until each frame is due.
+		--thermal-pacing          Only sleep between frames, pacing at 30 fps unless --target-fps is set, to keep mobile devices cool.
+		--decoupled-simulation    Simulate the scene of the next frame on another thread while the current frame is recorded.
+		--parallel-recording      Record the draws of the scene subpasses into secondary command buffers on all the cores.
+		--device-group            Combine the GPUs of a device group and render frames on each of them in turn.
+		--configuration INDEX     Run a permutation of the settings of the sample configuration, parallel batch benchmarks run all of them.
+		--reload-shaders          Recompile the shaders when their file changes, and rebuild the pipelines using them.
+		--cache-budget COUNT      Keep at most COUNT cached descriptor sets, framebuffers and pipelines of each type, evicting the least recently used.
+		--low-latency-present     Present in mailbox mode with two images, starting each frame once the previous one is displayed.
+		--immediate-present       Like --low-latency-present in immediate mode, frames tear as with front buffer rendering.)"
 #ifndef VK_USE_PLATFORM_DISPLAY_KHR
 	    R"(
 		--width WIDTH             The width of the screen if visible [default: 1280].
@@ -146,6 +186,21 @@ bool VulkanSamples::prepare(Platform &platform)
 		return false;
 	}
 
+	read_sample_settings();
+
+	if (options.contains("--asset-archive"))
+	{
+		try
+		{
+			vkb::fs::AssetArchive::mount(options.get_string("--asset-archive"));
+		}
+		catch (const std::runtime_error &e)
+		{
+			LOGE("Failed to mount asset archive: {}", e.what());
+			return false;
+		}
+	}
+
 	auto result = false;
 
 	if (options.contains("--batch"))
@@ -182,6 +237,19 @@ bool VulkanSamples::prepare(Platform &platform)
 			return false;
 		}
 
+#ifndef VK_USE_PLATFORM_ANDROID_KHR
+		if (options.contains("--jobs"))
+		{
+			// The samples run in child processes, this one only waits for them and writes the report
+			result = run_batch_jobs();
+			platform.close();
+			return result;
+		}
+#endif
+
+		// The samples of the batch run one after the other in this process, they share the assets they decode
+		sample_settings.asset_memory_cache = true;
+
 		this->batch_mode_sample_iter = batch_mode_sample_list.begin();
 
 		result = prepare_active_app(
@@ -265,6 +333,11 @@ bool VulkanSamples::prepare_active_app(CreateAppFunc create_app_func, const std:
 		}
 	}
 
+	if (auto *vulkan_app = dynamic_cast<vkb::VulkanSample *>(active_app.get()))
+	{
+		vulkan_app->apply_settings(sample_settings);
+	}
+
 	if (batch)
 	{
 		this->batch_mode = true;
@@ -287,6 +360,251 @@ bool VulkanSamples::prepare_active_app(CreateAppFunc create_app_func, const std:
 	return result;
 }
 
+void VulkanSamples::read_sample_settings()
+{
+	if (options.contains("--pipeline-cache"))
+	{
+		sample_settings.pipeline_cache_directory = options.get_string("--pipeline-cache");
+	}
+
+	sample_settings.progressive_scene_loading = options.contains("--progressive-loading");
+	sample_settings.scene_cache               = options.contains("--scene-cache");
+	sample_settings.gpu_profiling             = options.contains("--gpu-profile");
+	sample_settings.frame_spike_capture       = options.contains("--capture-spikes");
+	sample_settings.stats_recording           = options.contains("--record-stats");
+	sample_settings.render_pass_analysis      = options.contains("--analyze-render-passes");
+	sample_settings.frame_strategy_tuning     = options.contains("--tune-frame-strategies");
+	sample_settings.decoupled_simulation      = options.contains("--decoupled-simulation");
+	sample_settings.parallel_recording        = options.contains("--parallel-recording");
+	sample_settings.device_group              = options.contains("--device-group");
+	sample_settings.shader_reload             = options.contains("--reload-shaders");
+
+	if (options.contains("--msaa"))
+	{
+		sample_settings.multisample.sample_count = static_cast<VkSampleCountFlagBits>(to_u32(std::max(options.get_int("--msaa"), 1)));
+		if (options.contains("--msaa-separate-resolve"))
+		{
+			sample_settings.multisample.color_resolve_mode = vkb::ColorResolveMode::Separate;
+		}
+	}
+
+	if (options.contains("--frame-count"))
+	{
+		sample_settings.frame_count = to_u32(options.get_int("--frame-count"));
+	}
+
+	if (options.contains("--immediate-present"))
+	{
+		sample_settings.present_latency_mode = vkb::PresentLatencyMode::Immediate;
+	}
+	else if (options.contains("--low-latency-present"))
+	{
+		sample_settings.present_latency_mode = vkb::PresentLatencyMode::Low;
+	}
+
+	if (options.contains("--cache-budget"))
+	{
+		sample_settings.resource_cache_budget = to_u32(std::max(options.get_int("--cache-budget"), 0));
+	}
+
+	sample_settings.screenshots = options.contains("--screenshot-interval") || options.contains("--screenshot-qoi");
+	if (options.contains("--screenshot-interval"))
+	{
+		sample_settings.screenshot_interval = to_u32(options.get_int("--screenshot-interval"));
+	}
+	if (options.contains("--screenshot-qoi"))
+	{
+		sample_settings.screenshot_format = vkb::ScreenshotCapture::Format::QOI;
+	}
+
+	if (options.contains("--gpu"))
+	{
+		sample_settings.gpu_index = options.get_int("--gpu");
+	}
+
+	if (options.contains("--configuration"))
+	{
+		sample_settings.configuration_index = std::max(options.get_int("--configuration"), 0);
+	}
+}
+
+bool VulkanSamples::run_batch_jobs()
+{
+	if (!options.contains("--benchmark"))
+	{
+		LOGE("Parallel batch jobs need --benchmark, so that the samples exit after a number of frames");
+		return false;
+	}
+
+	const uint32_t job_count     = to_u32(std::max(options.get_int("--jobs"), 1));
+	const uint32_t gpu_count     = options.contains("--gpu-count") ? to_u32(std::max(options.get_int("--gpu-count"), 1)) : 0;
+	const uint32_t cores_per_job = options.contains("--cores-per-job") ? to_u32(std::max(options.get_int("--cores-per-job"), 0)) : 0;
+
+	// Options forwarded to every sample
+	std::vector<std::string> common_arguments{"--headless", "--benchmark", options.get_string("--benchmark")};
+	for (const char *option : {"--benchmark-warmup", "--pipeline-cache", "--asset-archive", "--screenshot-interval", "--frame-count", "--msaa", "--target-fps", "--cache-budget"})
+	{
+		if (options.contains(option))
+		{
+			common_arguments.push_back(option);
+			common_arguments.push_back(options.get_string(option));
+		}
+	}
+	for (const char *flag : {"--progressive-loading", "--scene-cache", "--gpu-profile", "--capture-spikes", "--record-stats", "--analyze-render-passes", "--screenshot-qoi", "--msaa-separate-resolve", "--tune-frame-strategies", "--thermal-pacing", "--decoupled-simulation", "--parallel-recording", "--device-group"})
+	{
+		if (options.contains(flag))
+		{
+			common_arguments.push_back(flag);
+		}
+	}
+
+	const std::string executable = Process::get_executable_path();
+
+	// A benchmark of a sample for each permutation of the settings of its configuration
+	struct Run
+	{
+		std::string id;
+
+		std::string name;
+
+		int configuration;
+	};
+
+	std::vector<Run> runs;
+
+	for (auto &sample : batch_mode_sample_list)
+	{
+		size_t configuration_count = 0;
+
+		// Samples only declare their configuration when constructed, which does not touch the GPU
+		auto app = sample_create_functions.at(sample.id)();
+		if (auto *vulkan_app = dynamic_cast<vkb::VulkanSample *>(app.get()))
+		{
+			vulkan_app->get_configuration().expand_permutations();
+			configuration_count = vulkan_app->get_configuration().size();
+		}
+
+		if (configuration_count < 2)
+		{
+			runs.push_back({sample.id, sample.id, -1});
+			continue;
+		}
+
+		for (size_t i = 0; i < configuration_count; ++i)
+		{
+			runs.push_back({sample.id, sample.id + "_config" + std::to_string(i), static_cast<int>(i)});
+		}
+	}
+
+	struct Job
+	{
+		std::unique_ptr<Process> process;
+
+		std::vector<Run>::const_iterator run;
+	};
+
+	// Each job slot keeps its GPU and CPU cores, so that the processes running at once do not share them
+	std::vector<Job> jobs(job_count);
+	auto             next_run = runs.cbegin();
+	uint32_t         running  = 0;
+	uint32_t         failed   = 0;
+	nlohmann::json   results  = nlohmann::json::object();
+
+	Timer timer;
+	timer.start();
+
+	LOGI("Running {} configurations of {} samples in {} parallel jobs", runs.size(), batch_mode_sample_list.size(), job_count);
+
+	while (next_run != runs.cend() || running > 0)
+	{
+		for (uint32_t slot = 0; slot < job_count; ++slot)
+		{
+			auto &job       = jobs[slot];
+			int   exit_code = 0;
+
+			if (job.process && job.process->poll(exit_code))
+			{
+				job.process.reset();
+				--running;
+
+				nlohmann::json result = {{"exit_code", exit_code}};
+				if (gpu_count > 0)
+				{
+					result["gpu"] = slot % gpu_count;
+				}
+				if (cores_per_job > 0)
+				{
+					result["cpu_cores"] = {slot * cores_per_job, (slot + 1) * cores_per_job - 1};
+				}
+
+				if (job.run->configuration >= 0)
+				{
+					result["configuration"] = job.run->configuration;
+				}
+
+				std::ifstream report{fs::path::get(fs::path::Type::Graphs) + "benchmark_" + job.run->name + ".json"};
+				try
+				{
+					result["benchmark"] = nlohmann::json::parse(report);
+					LOGI("Sample {} completed", job.run->name);
+				}
+				catch (const std::exception &)
+				{
+					result["benchmark"] = nullptr;
+					LOGE("Sample {} exited with code {} without a benchmark report", job.run->name, exit_code);
+					++failed;
+				}
+
+				results[job.run->name] = result;
+			}
+
+			if (!job.process && next_run != runs.cend())
+			{
+				job.run = next_run++;
+
+				// Remove the report of a previous run, so that a failure is not mistaken for a success
+				const std::string report_file = "benchmark_" + job.run->name + ".json";
+				std::remove((fs::path::get(fs::path::Type::Graphs) + report_file).c_str());
+
+				std::vector<std::string> arguments{executable, "--sample", job.run->id, "--benchmark-report", report_file};
+				arguments.insert(arguments.end(), common_arguments.begin(), common_arguments.end());
+				if (job.run->configuration >= 0)
+				{
+					arguments.push_back("--configuration");
+					arguments.push_back(std::to_string(job.run->configuration));
+				}
+				if (gpu_count > 0)
+				{
+					arguments.push_back("--gpu");
+					arguments.push_back(std::to_string(slot % gpu_count));
+				}
+
+				std::vector<uint32_t> cpu_cores;
+				for (uint32_t core = 0; core < cores_per_job; ++core)
+				{
+					cpu_cores.push_back(slot * cores_per_job + core);
+				}
+
+				job.process = std::make_unique<Process>(arguments, cpu_cores);
+				++running;
+			}
+		}
+
+		std::this_thread::sleep_for(std::chrono::milliseconds(100));
+	}
+
+	auto duration = timer.stop();
+	LOGI("Batch completed in {:.1f} seconds, {} of {} benchmarks failed", duration, failed, runs.size());
+
+	nlohmann::json report = {
+	    {"jobs", job_count},
+	    {"duration_s", duration},
+	    {"samples", results},
+	};
+
+	return fs::write_json(report, "batch_benchmark.json") && failed == 0;
+}
+
 void VulkanSamples::update(float delta_time)
 {
 	if (active_app)
@@ -356,6 +674,16 @@ void VulkanSamples::resize(const uint32_t width, const uint32_t height)
 	}
 }
 
+void VulkanSamples::record_benchmark_samples(BenchmarkReport &report)
+{
+	if (active_app)
+	{
+		report.set_group(active_app->get_name());
+
+		active_app->record_benchmark_samples(report);
+	}
+}
+
 void VulkanSamples::input_event(const InputEvent &input_event)
 {
 	if (active_app && !batch_mode && !is_benchmark_mode())
@@ -45,6 +45,11 @@ class VulkanSamples : public Application
 
 	virtual void input_event(const InputEvent &input_event) override;
 
+	/**
+	 * @brief Records the samples of the active application, grouped by its name
+	 */
+	virtual void record_benchmark_samples(BenchmarkReport &report) override;
+
 	/**
 	 * @brief Prepares a sample or a test to be run under certain conditions
 	 * @param run_info A struct containing the information needed to run
@@ -53,6 +58,18 @@ class VulkanSamples : public Application
 	bool prepare_active_app(CreateAppFunc create_app_func, const std::string &name, bool test, bool batch);
 
   private:
+	/**
+	 * @brief Runs each batch mode sample headless in a child process, a number of them at once,
+	 *        and writes their benchmark reports into a single one
+	 * @returns true if every sample wrote its benchmark report
+	 */
+	bool run_batch_jobs();
+
+	/**
+	 * @brief Reads the framework options from the command line into sample_settings
+	 */
+	void read_sample_settings();
+
 	/// Platform pointer
 	Platform *platform;
 
@@ -65,6 +82,9 @@ class VulkanSamples : public Application
 	/// An iterator to the current batch mode sample info object
 	std::vector<SampleInfo>::const_iterator batch_mode_sample_iter;
 
+	/// The framework options applied to each sample, read once at startup
+	VulkanSampleSettings sample_settings{};
+
 	/// If batch mode is enabled
 	bool batch_mode{false};
 
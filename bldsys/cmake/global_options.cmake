@@ -35,9 +35,25 @@ set(VKB_WARNINGS_AS_ERRORS ON CACHE BOOL "Enable Warnings as Errors")
 set(VKB_ENTRYPOINTS OFF CACHE BOOL "Enable create entrypoint project for every application.")
 set(VKB_SYMLINKS OFF CACHE BOOL "Enable create symlink folders for every application.")
 set(VKB_VALIDATION_LAYERS OFF CACHE BOOL "Enable validation layers for every application.")
+set(VKB_CPU_PROFILING OFF CACHE BOOL "Enable scoped CPU profiling, written as a Chrome trace when applications finish.")
+set(VKB_ASYNC_LOGGING OFF CACHE BOOL "Enable writing the log from a background thread, dropping the oldest messages when it falls behind.")
+set(VKB_DEBUG_MARKERS OFF CACHE BOOL "Enable VK_EXT_debug_utils labels of command regions and names of cached objects, for GPU captures.")
+set(VKB_VERIFY_CACHE_KEYS OFF CACHE BOOL "Enable comparing the requests which hit the resource cache or the descriptor sets cached by command buffers with the cached objects, to detect hash collisions.")
+set(VKB_KTX2 OFF CACHE BOOL "Enable KTX2 and Basis Universal textures, needs KTX-Software 4 in third_party/ktx.")
 set(VKB_BUILD_SAMPLES ON CACHE BOOL "Enable generation and building of Vulkan best practice samples.")
 set(VKB_BUILD_TESTS OFF CACHE BOOL "Enable generation and building of Vulkan best practice tests.")
+set(VKB_BUILD_TOOLS OFF CACHE BOOL "Enable generation and building of the asset tools.")
 set(VKB_DIRECT_2_DISPLAY OFF CACHE BOOL "Force using D2D (if available)")
+set(VKB_UNITY_BUILD OFF CACHE BOOL "Enable unity builds of the framework and samples, compiling batches of sources as a single translation unit. Needs CMake 3.16.")
+set(VKB_PRECOMPILED_HEADERS OFF CACHE BOOL "Enable precompiling the framework headers of pch.h once, shared by the framework and every sample. Needs CMake 3.16.")
+set(VKB_BUILD_TIME_TRACE OFF CACHE BOOL "Enable reporting the time spent compiling every source of the framework and samples.")
+set(VKB_UNITY_BUILD_BATCH_SIZE 16 CACHE STRING "Number of sources compiled together by unity builds.")
+
+if((VKB_UNITY_BUILD OR VKB_PRECOMPILED_HEADERS) AND CMAKE_VERSION VERSION_LESS 3.16)
+    message(WARNING "Unity builds and precompiled headers need CMake 3.16, building without them")
+    set(VKB_UNITY_BUILD OFF)
+    set(VKB_PRECOMPILED_HEADERS OFF)
+endif()
 
 set(CMAKE_RUNTIME_OUTPUT_DIRECTORY "bin/${CMAKE_BUILD_TYPE}/${TARGET_ARCH}")
 set(CMAKE_LIBRARY_OUTPUT_DIRECTORY "lib/${CMAKE_BUILD_TYPE}/${TARGET_ARCH}")
@@ -226,6 +226,8 @@ function(add_project)
     # inherit compile definitions from framework target
     target_compile_definitions(${PROJECT_NAME} PUBLIC $<TARGET_PROPERTY:framework,COMPILE_DEFINITIONS>)
 
+    set_build_speed_options(TARGET ${PROJECT_NAME})
+
     # inherit include directories from framework target
     target_include_directories(${PROJECT_NAME} PUBLIC 
         $<TARGET_PROPERTY:framework,INCLUDE_DIRECTORIES>
@@ -17,6 +17,40 @@
 
  ]]
 
+# Applies the build speed options to a target of the framework or of a sample
+function(set_build_speed_options)
+    set(options)
+    set(oneValueArgs TARGET)
+    set(multiValueArgs)
+
+    cmake_parse_arguments(TARGET "${options}" "${oneValueArgs}" "${multiValueArgs}" ${ARGN})
+
+    if(VKB_UNITY_BUILD)
+        set_target_properties(${TARGET_TARGET}
+            PROPERTIES
+                UNITY_BUILD ON
+                UNITY_BUILD_BATCH_SIZE ${VKB_UNITY_BUILD_BATCH_SIZE})
+    endif()
+
+    if(VKB_PRECOMPILED_HEADERS AND NOT ${TARGET_TARGET} STREQUAL "framework")
+        # Samples share the precompiled header of the framework, built with the same definitions
+        target_precompile_headers(${TARGET_TARGET} REUSE_FROM framework)
+    endif()
+
+    if(VKB_BUILD_TIME_TRACE)
+        if("${CMAKE_CXX_COMPILER_ID}" STREQUAL "Clang")
+            # Writes a Chrome trace of the time spent in headers, templates and code generation next to every object
+            target_compile_options(${TARGET_TARGET} PRIVATE -ftime-trace)
+        elseif("${CMAKE_CXX_COMPILER_ID}" STREQUAL "MSVC")
+            # Prints the time spent in the front end and back end for every source
+            target_compile_options(${TARGET_TARGET} PRIVATE /Bt+)
+        else()
+            # Prints the time taken by every compile command, with Makefile and Ninja generators
+            set_target_properties(${TARGET_TARGET} PROPERTIES RULE_LAUNCH_COMPILE "${CMAKE_COMMAND} -E time")
+        endif()
+    endif()
+endfunction()
+
 function(scan_dirs)
     set(options)
     set(oneValueArgs LIST DIR)
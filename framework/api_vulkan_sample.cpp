@@ -18,6 +18,7 @@
 #include "api_vulkan_sample.h"
 
 #include "core/device.h"
+#include "core/staging_manager.h"
 #include "core/swapchain.h"
 #include "gltf_loader.h"
 #include "scene_graph/components/image.h"
@@ -34,17 +35,8 @@ bool ApiVulkanSample::prepare(vkb::Platform &platform)
 
 	depth_format = vkb::get_suitable_depth_format(device->get_gpu().get_handle());
 
-	// Create synchronization objects
-	VkSemaphoreCreateInfo semaphore_create_info = vkb::initializers::semaphore_create_info();
-	// Create a semaphore used to synchronize image presentation
-	// Ensures that the current swapchain render target has completed presentation and has been released by the presentation engine, ready for rendering
-	VK_CHECK(vkCreateSemaphore(device->get_handle(), &semaphore_create_info, nullptr, &semaphores.acquired_image_ready));
-	// Create a semaphore used to synchronize command submission
-	// Ensures that the image is not presented until all commands have been sumbitted and executed
-	VK_CHECK(vkCreateSemaphore(device->get_handle(), &semaphore_create_info, nullptr, &semaphores.render_complete));
-
 	// Set up submit info structure
-	// Semaphores will stay the same during application lifetime
+	// The semaphores point at the current frame slot's handles, which prepare_frame switches
 	// Command buffer submission info is set by each example
 	submit_info                   = vkb::initializers::submit_info();
 	submit_info.pWaitDstStageMask = &submit_pipeline_stages;
@@ -66,12 +58,13 @@ bool ApiVulkanSample::prepare(vkb::Platform &platform)
 	setup_render_pass();
 	create_pipeline_cache();
 	setup_framebuffer();
+	setup_overlay();
 
 	width  = get_render_context().get_surface_extent().width;
 	height = get_render_context().get_surface_extent().height;
 
 	gui = std::make_unique<vkb::Gui>(*this, platform.get_window(), /*stats=*/nullptr, 15.0f, true);
-	gui->prepare(pipeline_cache, render_pass,
+	gui->prepare(pipeline_cache, overlay_render_pass,
 	             {load_shader("uioverlay/uioverlay.vert", VK_SHADER_STAGE_VERTEX_BIT),
 	              load_shader("uioverlay/uioverlay.frag", VK_SHADER_STAGE_FRAGMENT_BIT)});
 
@@ -149,6 +142,11 @@ void ApiVulkanSample::resize(const uint32_t, const uint32_t)
 		vkDestroyFramebuffer(device->get_handle(), framebuffers[i], nullptr);
 	}
 	setup_framebuffer();
+	for (auto &overlay_framebuffer : overlay_framebuffers)
+	{
+		vkDestroyFramebuffer(device->get_handle(), overlay_framebuffer, nullptr);
+	}
+	setup_overlay();
 
 	if ((width > 0.0f) && (height > 0.0f))
 	{
@@ -162,6 +160,7 @@ void ApiVulkanSample::resize(const uint32_t, const uint32_t)
 	// references to the recreated frame buffer
 	destroy_command_buffers();
 	create_command_buffers();
+	image_fences.assign(draw_cmd_buffers.size(), VK_NULL_HANDLE);
 	build_command_buffers();
 
 	device->wait_idle();
@@ -408,11 +407,17 @@ void ApiVulkanSample::create_command_buffers()
 	        static_cast<uint32_t>(draw_cmd_buffers.size()));
 
 	VK_CHECK(vkAllocateCommandBuffers(device->get_handle(), &allocate_info, draw_cmd_buffers.data()));
+
+	// The overlay command buffers are recorded on their first submission
+	overlay_cmd_buffers.resize(draw_cmd_buffers.size());
+	overlay_outdated.assign(overlay_cmd_buffers.size(), true);
+	VK_CHECK(vkAllocateCommandBuffers(device->get_handle(), &allocate_info, overlay_cmd_buffers.data()));
 }
 
 void ApiVulkanSample::destroy_command_buffers()
 {
 	vkFreeCommandBuffers(device->get_handle(), cmd_pool, static_cast<uint32_t>(draw_cmd_buffers.size()), draw_cmd_buffers.data());
+	vkFreeCommandBuffers(device->get_handle(), cmd_pool, static_cast<uint32_t>(overlay_cmd_buffers.size()), overlay_cmd_buffers.data());
 }
 
 void ApiVulkanSample::create_pipeline_cache()
@@ -444,29 +449,60 @@ void ApiVulkanSample::update_overlay(float delta_time)
 
 		gui->update(delta_time);
 
-		if (gui->update_buffers() || gui->get_drawer().is_dirty())
+		// Only the small overlay command buffers record the gui geometry
+		if (gui->update_buffers())
 		{
+			std::fill(overlay_outdated.begin(), overlay_outdated.end(), true);
+		}
+
+		// Changed settings may affect what the sample records
+		if (gui->get_drawer().is_dirty())
+		{
+			// The command buffers of frames in flight may not be recorded again while they execute
+			if (frames_in_flight > 1)
+			{
+				device->wait_idle();
+			}
 			build_command_buffers();
 			gui->get_drawer().clear();
 		}
 	}
 }
 
-void ApiVulkanSample::draw_ui(const VkCommandBuffer command_buffer)
+void ApiVulkanSample::build_overlay_command_buffer(uint32_t index)
 {
-	if (gui)
-	{
-		const VkViewport viewport = vkb::initializers::viewport(static_cast<float>(width), static_cast<float>(height), 0.0f, 1.0f);
-		const VkRect2D   scissor  = vkb::initializers::rect2D(width, height, 0, 0);
-		vkCmdSetViewport(command_buffer, 0, 1, &viewport);
-		vkCmdSetScissor(command_buffer, 0, 1, &scissor);
+	VkCommandBuffer command_buffer = overlay_cmd_buffers[index];
 
-		gui->draw(command_buffer);
-	}
+	VkCommandBufferBeginInfo command_buffer_begin_info = vkb::initializers::command_buffer_begin_info();
+
+	VkRenderPassBeginInfo render_pass_begin_info    = vkb::initializers::render_pass_begin_info();
+	render_pass_begin_info.renderPass               = overlay_render_pass;
+	render_pass_begin_info.framebuffer              = overlay_framebuffers[index];
+	render_pass_begin_info.renderArea.extent.width  = width;
+	render_pass_begin_info.renderArea.extent.height = height;
+
+	VK_CHECK(vkBeginCommandBuffer(command_buffer, &command_buffer_begin_info));
+
+	vkCmdBeginRenderPass(command_buffer, &render_pass_begin_info, VK_SUBPASS_CONTENTS_INLINE);
+
+	const VkViewport viewport = vkb::initializers::viewport(static_cast<float>(width), static_cast<float>(height), 0.0f, 1.0f);
+	const VkRect2D   scissor  = vkb::initializers::rect2D(width, height, 0, 0);
+	vkCmdSetViewport(command_buffer, 0, 1, &viewport);
+	vkCmdSetScissor(command_buffer, 0, 1, &scissor);
+
+	gui->draw(command_buffer);
+
+	vkCmdEndRenderPass(command_buffer);
+
+	VK_CHECK(vkEndCommandBuffer(command_buffer));
 }
 
 void ApiVulkanSample::prepare_frame()
 {
+	// The frame slot's semaphores may only be reused once the GPU has finished the frame that last used them
+	VK_CHECK(vkWaitForFences(device->get_handle(), 1, &wait_fences[frame_index], VK_TRUE, UINT64_MAX));
+	semaphores = frame_semaphores[frame_index];
+
 	if (render_context->has_swapchain())
 	{
 		handle_surface_changes();
@@ -482,10 +518,54 @@ void ApiVulkanSample::prepare_frame()
 			VK_CHECK(result);
 		}
 	}
+
+	// Images may be acquired out of order, so the image's command buffers can still be in use by another frame slot
+	if (image_fences[current_buffer] != VK_NULL_HANDLE && image_fences[current_buffer] != wait_fences[frame_index])
+	{
+		VK_CHECK(vkWaitForFences(device->get_handle(), 1, &image_fences[current_buffer], VK_TRUE, UINT64_MAX));
+	}
+	image_fences[current_buffer] = wait_fences[frame_index];
+
+	// Samples submit to the raw queue handle, so buffer writes of the previous frame are flushed here
+	device->flush_deferred();
 }
 
 void ApiVulkanSample::submit_frame()
 {
+	VK_CHECK(vkResetFences(device->get_handle(), 1, &wait_fences[frame_index]));
+
+	// Draw the overlay on top of the sample's rendering, its command buffer is only recorded again when the gui geometry changed
+	if (gui)
+	{
+		if (overlay_outdated[current_buffer])
+		{
+			build_overlay_command_buffer(current_buffer);
+			overlay_outdated[current_buffer] = false;
+		}
+
+		VkSubmitInfo overlay_submit_info       = vkb::initializers::submit_info();
+		overlay_submit_info.commandBufferCount = 1;
+		overlay_submit_info.pCommandBuffers    = &overlay_cmd_buffers[current_buffer];
+		if (!is_headless())
+		{
+			overlay_submit_info.waitSemaphoreCount   = 1;
+			overlay_submit_info.pWaitSemaphores      = &semaphores.render_complete;
+			overlay_submit_info.pWaitDstStageMask    = &submit_pipeline_stages;
+			overlay_submit_info.signalSemaphoreCount = 1;
+			overlay_submit_info.pSignalSemaphores    = &semaphores.overlay_complete;
+		}
+		VK_CHECK(vkQueueSubmit(queue, 1, &overlay_submit_info, wait_fences[frame_index]));
+	}
+	else
+	{
+		// Signal the fence after the sample's submissions to the same queue
+		VK_CHECK(vkQueueSubmit(queue, 0, nullptr, wait_fences[frame_index]));
+	}
+
+	device->get_destruction_queue().update();
+
+	frame_index = (frame_index + 1) % frames_in_flight;
+
 	if (render_context->has_swapchain())
 	{
 		const auto &queue = device->get_queue_by_present(0);
@@ -499,9 +579,10 @@ void ApiVulkanSample::submit_frame()
 		present_info.pSwapchains      = &sc;
 		present_info.pImageIndices    = &current_buffer;
 		// Check if a wait semaphore has been specified to wait for before presenting the image
-		if (semaphores.render_complete != VK_NULL_HANDLE)
+		VkSemaphore &present_semaphore = gui ? semaphores.overlay_complete : semaphores.render_complete;
+		if (present_semaphore != VK_NULL_HANDLE)
 		{
-			present_info.pWaitSemaphores    = &semaphores.render_complete;
+			present_info.pWaitSemaphores    = &present_semaphore;
 			present_info.waitSemaphoreCount = 1;
 		}
 
@@ -525,7 +606,11 @@ void ApiVulkanSample::submit_frame()
 	// DO NOT USE
 	// vkDeviceWaitIdle and vkQueueWaitIdle are extremely expensive functions, and are used here purely for demonstrating the vulkan API
 	// without having to concern ourselves with proper syncronization. These functions should NEVER be used inside the render loop like this (every frame).
-	VK_CHECK(vkDeviceWaitIdle(device->get_handle()));
+	// Samples with more than one frame in flight are synchronized by the frame slot fences instead
+	if (frames_in_flight == 1)
+	{
+		VK_CHECK(vkDeviceWaitIdle(device->get_handle()));
+	}
 }
 
 ApiVulkanSample::~ApiVulkanSample()
@@ -545,6 +630,11 @@ ApiVulkanSample::~ApiVulkanSample()
 		{
 			vkDestroyFramebuffer(device->get_handle(), framebuffers[i], nullptr);
 		}
+		vkDestroyRenderPass(device->get_handle(), overlay_render_pass, nullptr);
+		for (auto &overlay_framebuffer : overlay_framebuffers)
+		{
+			vkDestroyFramebuffer(device->get_handle(), overlay_framebuffer, nullptr);
+		}
 
 		for (auto &swapchain_buffer : swapchain_buffers)
 		{
@@ -563,8 +653,12 @@ ApiVulkanSample::~ApiVulkanSample()
 
 		vkDestroyCommandPool(device->get_handle(), cmd_pool, nullptr);
 
-		vkDestroySemaphore(device->get_handle(), semaphores.acquired_image_ready, nullptr);
-		vkDestroySemaphore(device->get_handle(), semaphores.render_complete, nullptr);
+		for (auto &frame : frame_semaphores)
+		{
+			vkDestroySemaphore(device->get_handle(), frame.acquired_image_ready, nullptr);
+			vkDestroySemaphore(device->get_handle(), frame.render_complete, nullptr);
+			vkDestroySemaphore(device->get_handle(), frame.overlay_complete, nullptr);
+		}
 		for (auto &fence : wait_fences)
 		{
 			vkDestroyFence(device->get_handle(), fence, nullptr);
@@ -582,13 +676,52 @@ void ApiVulkanSample::build_command_buffers()
 
 void ApiVulkanSample::create_synchronization_primitives()
 {
-	// Wait fences to sync command buffer access
+	frames_in_flight = std::max(frames_in_flight, 1u);
+
+	VkSemaphoreCreateInfo semaphore_create_info = vkb::initializers::semaphore_create_info();
+	frame_semaphores.resize(frames_in_flight);
+	for (auto &frame : frame_semaphores)
+	{
+		// Create a semaphore used to synchronize image presentation
+		// Ensures that the current swapchain render target has completed presentation and has been released by the presentation engine, ready for rendering
+		VK_CHECK(vkCreateSemaphore(device->get_handle(), &semaphore_create_info, nullptr, &frame.acquired_image_ready));
+		// Create a semaphore used to synchronize command submission
+		// Ensures that the image is not presented until all commands have been sumbitted and executed
+		VK_CHECK(vkCreateSemaphore(device->get_handle(), &semaphore_create_info, nullptr, &frame.render_complete));
+		// Create a semaphore used to synchronize the UI overlay submission
+		// Ensures that the image is not presented until the overlay has been drawn on top of the sample's rendering
+		VK_CHECK(vkCreateSemaphore(device->get_handle(), &semaphore_create_info, nullptr, &frame.overlay_complete));
+	}
+	semaphores = frame_semaphores[frame_index];
+
+	// Wait fences to sync command buffer access, signaled so the first use of each frame slot does not wait
 	VkFenceCreateInfo fence_create_info = vkb::initializers::fence_create_info(VK_FENCE_CREATE_SIGNALED_BIT);
-	wait_fences.resize(draw_cmd_buffers.size());
+	wait_fences.resize(frames_in_flight);
 	for (auto &fence : wait_fences)
 	{
 		VK_CHECK(vkCreateFence(device->get_handle(), &fence_create_info, nullptr, &fence));
 	}
+
+	image_fences.assign(draw_cmd_buffers.size(), VK_NULL_HANDLE);
+}
+
+VkDeviceSize ApiVulkanSample::get_uniform_stride(VkDeviceSize size) const
+{
+	VkDeviceSize alignment = device->get_gpu().get_properties().limits.minUniformBufferOffsetAlignment;
+	return (size + alignment - 1) / alignment * alignment;
+}
+
+std::unique_ptr<vkb::core::Buffer> ApiVulkanSample::create_ring_uniform_buffer(VkDeviceSize size)
+{
+	return std::make_unique<vkb::core::Buffer>(get_device(),
+	                                           get_uniform_stride(size) * draw_cmd_buffers.size(),
+	                                           VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT,
+	                                           VMA_MEMORY_USAGE_CPU_TO_GPU);
+}
+
+uint32_t ApiVulkanSample::get_ring_uniform_offset(VkDeviceSize size, uint32_t index) const
+{
+	return vkb::to_u32(index * get_uniform_stride(size));
 }
 
 void ApiVulkanSample::create_command_pool()
@@ -710,7 +843,7 @@ void ApiVulkanSample::setup_render_pass()
 	subpass_description.pResolveAttachments     = nullptr;
 
 	// Subpass dependencies for layout transitions
-	std::array<VkSubpassDependency, 2> dependencies;
+	std::array<VkSubpassDependency, 3> dependencies;
 
 	dependencies[0].srcSubpass      = VK_SUBPASS_EXTERNAL;
 	dependencies[0].dstSubpass      = 0;
@@ -728,6 +861,15 @@ void ApiVulkanSample::setup_render_pass()
 	dependencies[1].dstAccessMask   = VK_ACCESS_MEMORY_READ_BIT;
 	dependencies[1].dependencyFlags = VK_DEPENDENCY_BY_REGION_BIT;
 
+	// The depth buffer is shared by all frames in flight, so its writes are ordered against the previous frame's
+	dependencies[2].srcSubpass      = VK_SUBPASS_EXTERNAL;
+	dependencies[2].dstSubpass      = 0;
+	dependencies[2].srcStageMask    = VK_PIPELINE_STAGE_LATE_FRAGMENT_TESTS_BIT;
+	dependencies[2].dstStageMask    = VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT | VK_PIPELINE_STAGE_LATE_FRAGMENT_TESTS_BIT;
+	dependencies[2].srcAccessMask   = VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT;
+	dependencies[2].dstAccessMask   = VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_READ_BIT | VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT;
+	dependencies[2].dependencyFlags = 0;
+
 	VkRenderPassCreateInfo render_pass_create_info = {};
 	render_pass_create_info.sType                  = VK_STRUCTURE_TYPE_RENDER_PASS_CREATE_INFO;
 	render_pass_create_info.attachmentCount        = static_cast<uint32_t>(attachments.size());
@@ -740,6 +882,78 @@ void ApiVulkanSample::setup_render_pass()
 	VK_CHECK(vkCreateRenderPass(device->get_handle(), &render_pass_create_info, nullptr, &render_pass));
 }
 
+void ApiVulkanSample::setup_overlay()
+{
+	// The render pass is independent of the swap chain extent and survives resizes
+	if (overlay_render_pass == VK_NULL_HANDLE)
+	{
+		// The image is loaded in the presentable layout the sample's rendering leaves it in
+		VkAttachmentDescription attachment = {};
+		attachment.format                  = render_context->get_format();
+		attachment.samples                 = VK_SAMPLE_COUNT_1_BIT;
+		attachment.loadOp                  = VK_ATTACHMENT_LOAD_OP_LOAD;
+		attachment.storeOp                 = VK_ATTACHMENT_STORE_OP_STORE;
+		attachment.stencilLoadOp           = VK_ATTACHMENT_LOAD_OP_DONT_CARE;
+		attachment.stencilStoreOp          = VK_ATTACHMENT_STORE_OP_DONT_CARE;
+		attachment.initialLayout           = VK_IMAGE_LAYOUT_PRESENT_SRC_KHR;
+		attachment.finalLayout             = VK_IMAGE_LAYOUT_PRESENT_SRC_KHR;
+
+		VkAttachmentReference color_reference = {};
+		color_reference.attachment            = 0;
+		color_reference.layout                = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
+
+		VkSubpassDescription subpass_description = {};
+		subpass_description.pipelineBindPoint    = VK_PIPELINE_BIND_POINT_GRAPHICS;
+		subpass_description.colorAttachmentCount = 1;
+		subpass_description.pColorAttachments    = &color_reference;
+
+		std::array<VkSubpassDependency, 2> dependencies;
+
+		// Wait for the sample's color writes to the same image
+		dependencies[0].srcSubpass      = VK_SUBPASS_EXTERNAL;
+		dependencies[0].dstSubpass      = 0;
+		dependencies[0].srcStageMask    = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT;
+		dependencies[0].dstStageMask    = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT;
+		dependencies[0].srcAccessMask   = VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT;
+		dependencies[0].dstAccessMask   = VK_ACCESS_COLOR_ATTACHMENT_READ_BIT | VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT;
+		dependencies[0].dependencyFlags = VK_DEPENDENCY_BY_REGION_BIT;
+
+		dependencies[1].srcSubpass      = 0;
+		dependencies[1].dstSubpass      = VK_SUBPASS_EXTERNAL;
+		dependencies[1].srcStageMask    = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT;
+		dependencies[1].dstStageMask    = VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT;
+		dependencies[1].srcAccessMask   = VK_ACCESS_COLOR_ATTACHMENT_READ_BIT | VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT;
+		dependencies[1].dstAccessMask   = VK_ACCESS_MEMORY_READ_BIT;
+		dependencies[1].dependencyFlags = VK_DEPENDENCY_BY_REGION_BIT;
+
+		VkRenderPassCreateInfo render_pass_create_info = {};
+		render_pass_create_info.sType                  = VK_STRUCTURE_TYPE_RENDER_PASS_CREATE_INFO;
+		render_pass_create_info.attachmentCount        = 1;
+		render_pass_create_info.pAttachments           = &attachment;
+		render_pass_create_info.subpassCount           = 1;
+		render_pass_create_info.pSubpasses             = &subpass_description;
+		render_pass_create_info.dependencyCount        = static_cast<uint32_t>(dependencies.size());
+		render_pass_create_info.pDependencies          = dependencies.data();
+
+		VK_CHECK(vkCreateRenderPass(device->get_handle(), &render_pass_create_info, nullptr, &overlay_render_pass));
+	}
+
+	VkFramebufferCreateInfo framebuffer_create_info = {};
+	framebuffer_create_info.sType                   = VK_STRUCTURE_TYPE_FRAMEBUFFER_CREATE_INFO;
+	framebuffer_create_info.renderPass              = overlay_render_pass;
+	framebuffer_create_info.attachmentCount         = 1;
+	framebuffer_create_info.width                   = get_render_context().get_surface_extent().width;
+	framebuffer_create_info.height                  = get_render_context().get_surface_extent().height;
+	framebuffer_create_info.layers                  = 1;
+
+	overlay_framebuffers.resize(render_context->get_render_frames().size());
+	for (uint32_t i = 0; i < overlay_framebuffers.size(); i++)
+	{
+		framebuffer_create_info.pAttachments = &swapchain_buffers[i].view;
+		VK_CHECK(vkCreateFramebuffer(device->get_handle(), &framebuffer_create_info, nullptr, &overlay_framebuffers[i]));
+	}
+}
+
 void ApiVulkanSample::on_update_ui_overlay(vkb::Drawer &drawer)
 {}
 
@@ -860,17 +1074,6 @@ Texture ApiVulkanSample::load_texture(const std::string &file)
 	texture.image = vkb::sg::Image::load(file, file);
 	texture.image->create_vk_image(*device);
 
-	const auto &queue = device->get_queue_by_flags(VK_QUEUE_GRAPHICS_BIT, 0);
-
-	VkCommandBuffer command_buffer = device->create_command_buffer(VK_COMMAND_BUFFER_LEVEL_PRIMARY, true);
-
-	vkb::core::Buffer stage_buffer{*device,
-	                               texture.image->get_data().size(),
-	                               VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
-	                               VMA_MEMORY_USAGE_CPU_ONLY};
-
-	stage_buffer.update(texture.image->get_data());
-
 	// Setup buffer copy regions for each mip level
 	std::vector<VkBufferImageCopy> bufferCopyRegions;
 
@@ -897,33 +1100,11 @@ Texture ApiVulkanSample::load_texture(const std::string &file)
 	subresource_range.levelCount              = vkb::to_u32(mipmaps.size());
 	subresource_range.layerCount              = 1;
 
-	// Image barrier for optimal image (target)
-	// Optimal image will be used as destination for the copy
-	vkb::set_image_layout(
-	    command_buffer,
-	    texture.image->get_vk_image().get_handle(),
-	    VK_IMAGE_LAYOUT_UNDEFINED,
-	    VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
-	    subresource_range);
-
-	// Copy mip levels from staging buffer
-	vkCmdCopyBufferToImage(
-	    command_buffer,
-	    stage_buffer.get_handle(),
-	    texture.image->get_vk_image().get_handle(),
-	    VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
-	    static_cast<uint32_t>(bufferCopyRegions.size()),
-	    bufferCopyRegions.data());
-
-	// Change texture image layout to shader read after all mip levels have been copied
-	vkb::set_image_layout(
-	    command_buffer,
-	    texture.image->get_vk_image().get_handle(),
-	    VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
-	    VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL,
-	    subresource_range);
-
-	device->flush_command_buffer(command_buffer, queue.get_handle());
+	// The copy is batched with other uploads, work submitted to the graphics queue afterwards samples the texture
+	auto &data    = texture.image->get_data();
+	auto &staging = device->get_staging_manager();
+	staging.copy_to_image(data.data(), data.size(), texture.image->get_vk_image(), bufferCopyRegions, subresource_range);
+	staging.flush();
 
 	// Create a defaultsampler
 	VkSamplerCreateInfo sampler_create_info = {};
@@ -958,17 +1139,6 @@ Texture ApiVulkanSample::load_texture_array(const std::string &file)
 	texture.image = vkb::sg::Image::load(file, file);
 	texture.image->create_vk_image(*device, VK_IMAGE_VIEW_TYPE_2D_ARRAY);
 
-	const auto &queue = device->get_queue_by_flags(VK_QUEUE_GRAPHICS_BIT, 0);
-
-	VkCommandBuffer command_buffer = device->create_command_buffer(VK_COMMAND_BUFFER_LEVEL_PRIMARY, true);
-
-	vkb::core::Buffer stage_buffer{*device,
-	                               texture.image->get_data().size(),
-	                               VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
-	                               VMA_MEMORY_USAGE_CPU_ONLY};
-
-	stage_buffer.update(texture.image->get_data());
-
 	// Setup buffer copy regions for each mip level
 	std::vector<VkBufferImageCopy> buffer_copy_regions;
 
@@ -1001,33 +1171,11 @@ Texture ApiVulkanSample::load_texture_array(const std::string &file)
 	subresource_range.levelCount              = vkb::to_u32(mipmaps.size());
 	subresource_range.layerCount              = layers;
 
-	// Image barrier for optimal image (target)
-	// Optimal image will be used as destination for the copy
-	vkb::set_image_layout(
-	    command_buffer,
-	    texture.image->get_vk_image().get_handle(),
-	    VK_IMAGE_LAYOUT_UNDEFINED,
-	    VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
-	    subresource_range);
-
-	// Copy mip levels from staging buffer
-	vkCmdCopyBufferToImage(
-	    command_buffer,
-	    stage_buffer.get_handle(),
-	    texture.image->get_vk_image().get_handle(),
-	    VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
-	    static_cast<uint32_t>(buffer_copy_regions.size()),
-	    buffer_copy_regions.data());
-
-	// Change texture image layout to shader read after all mip levels have been copied
-	vkb::set_image_layout(
-	    command_buffer,
-	    texture.image->get_vk_image().get_handle(),
-	    VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
-	    VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL,
-	    subresource_range);
-
-	device->flush_command_buffer(command_buffer, queue.get_handle());
+	// The copy is batched with other uploads, work submitted to the graphics queue afterwards samples the texture
+	auto &data    = texture.image->get_data();
+	auto &staging = device->get_staging_manager();
+	staging.copy_to_image(data.data(), data.size(), texture.image->get_vk_image(), buffer_copy_regions, subresource_range);
+	staging.flush();
 
 	// Create a defaultsampler
 	VkSamplerCreateInfo sampler_create_info = {};
@@ -1059,17 +1207,6 @@ Texture ApiVulkanSample::load_texture_cubemap(const std::string &file)
 	texture.image = vkb::sg::Image::load(file, file);
 	texture.image->create_vk_image(*device, VK_IMAGE_VIEW_TYPE_CUBE, VK_IMAGE_CREATE_CUBE_COMPATIBLE_BIT);
 
-	const auto &queue = device->get_queue_by_flags(VK_QUEUE_GRAPHICS_BIT, 0);
-
-	VkCommandBuffer command_buffer = device->create_command_buffer(VK_COMMAND_BUFFER_LEVEL_PRIMARY, true);
-
-	vkb::core::Buffer stage_buffer{*device,
-	                               texture.image->get_data().size(),
-	                               VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
-	                               VMA_MEMORY_USAGE_CPU_ONLY};
-
-	stage_buffer.update(texture.image->get_data());
-
 	// Setup buffer copy regions for each mip level
 	std::vector<VkBufferImageCopy> buffer_copy_regions;
 
@@ -1102,33 +1239,11 @@ Texture ApiVulkanSample::load_texture_cubemap(const std::string &file)
 	subresource_range.levelCount              = vkb::to_u32(mipmaps.size());
 	subresource_range.layerCount              = layers;
 
-	// Image barrier for optimal image (target)
-	// Optimal image will be used as destination for the copy
-	vkb::set_image_layout(
-	    command_buffer,
-	    texture.image->get_vk_image().get_handle(),
-	    VK_IMAGE_LAYOUT_UNDEFINED,
-	    VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
-	    subresource_range);
-
-	// Copy mip levels from staging buffer
-	vkCmdCopyBufferToImage(
-	    command_buffer,
-	    stage_buffer.get_handle(),
-	    texture.image->get_vk_image().get_handle(),
-	    VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
-	    static_cast<uint32_t>(buffer_copy_regions.size()),
-	    buffer_copy_regions.data());
-
-	// Change texture image layout to shader read after all mip levels have been copied
-	vkb::set_image_layout(
-	    command_buffer,
-	    texture.image->get_vk_image().get_handle(),
-	    VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
-	    VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL,
-	    subresource_range);
-
-	device->flush_command_buffer(command_buffer, queue.get_handle());
+	// The copy is batched with other uploads, work submitted to the graphics queue afterwards samples the texture
+	auto &data    = texture.image->get_data();
+	auto &staging = device->get_staging_manager();
+	staging.copy_to_image(data.data(), data.size(), texture.image->get_vk_image(), buffer_copy_regions, subresource_range);
+	staging.flush();
 
 	// Create a defaultsampler
 	VkSamplerCreateInfo sampler_create_info = {};
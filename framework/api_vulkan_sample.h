@@ -128,6 +128,18 @@ class ApiVulkanSample : public vkb::VulkanSample
 	// List of available frame buffers (same as number of swap chain images)
 	std::vector<VkFramebuffer> framebuffers;
 
+	// Render pass drawing the UI overlay on top of the finished swap chain image
+	VkRenderPass overlay_render_pass = VK_NULL_HANDLE;
+
+	// Color only frame buffers of the overlay render pass (same as number of swap chain images)
+	std::vector<VkFramebuffer> overlay_framebuffers;
+
+	// Command buffers drawing the UI overlay, submitted after the sample's command buffers
+	std::vector<VkCommandBuffer> overlay_cmd_buffers;
+
+	// Overlay command buffers that have to be recorded again before their next submission
+	std::vector<bool> overlay_outdated;
+
 	// Active frame buffer index
 	uint32_t current_buffer = 0;
 
@@ -140,19 +152,35 @@ class ApiVulkanSample : public vkb::VulkanSample
 	// Pipeline cache object
 	VkPipelineCache pipeline_cache;
 
-	// Synchronization semaphores
-	struct
+	// Number of frames the CPU may record ahead of the GPU, set by samples before prepare
+	// With a single frame the device is idled after each submission, so uniform buffers may be updated in place
+	uint32_t frames_in_flight = 1;
+
+	// Frame slot in [0, frames_in_flight) the current frame uses
+	uint32_t frame_index = 0;
+
+	// Synchronization semaphores of the current frame slot
+	struct Semaphores
 	{
 		// Swap chain image presentation
 		VkSemaphore acquired_image_ready;
 
 		// Command buffer submission and execution
 		VkSemaphore render_complete;
+
+		// UI overlay drawn on top of the rendered image
+		VkSemaphore overlay_complete;
 	} semaphores;
 
-	// Synchronization fences
+	// Synchronization semaphores of every frame slot
+	std::vector<Semaphores> frame_semaphores;
+
+	// Synchronization fences, signaled when the GPU has finished a frame slot
 	std::vector<VkFence> wait_fences;
 
+	// Fence of the frame slot that last rendered to each swap chain image
+	std::vector<VkFence> image_fences;
+
 	/**
 	 * @brief Populates the swapchain_buffers vector with the image and imageviews 
 	 */
@@ -228,7 +256,7 @@ class ApiVulkanSample : public vkb::VulkanSample
 	virtual void build_command_buffers() = 0;
 
 	/**
-	 * @brief Creates the fences for rendering
+	 * @brief Creates the semaphores and fences of every frame slot
 	 */
 	void create_synchronization_primitives();
 
@@ -254,6 +282,18 @@ class ApiVulkanSample : public vkb::VulkanSample
 	 */
 	virtual void setup_render_pass();
 
+	/**
+	 * @brief Setup the render pass and frame buffers the UI overlay is drawn with
+	 *        The overlay loads the presented image, so it is independent of the sample's render pass
+	 */
+	void setup_overlay();
+
+	/**
+	 * @brief Records the UI overlay command buffer of a swap chain image
+	 * @param index The swap chain image index
+	 */
+	void build_overlay_command_buffer(uint32_t index);
+
 	/**
 	 * @brief Check if command buffers are valid (!= VK_NULL_HANDLE)
 	 */
@@ -287,23 +327,54 @@ class ApiVulkanSample : public vkb::VulkanSample
 	 */
 	void update_overlay(float delta_time);
 
-	/**
-	 * @brief If the gui is enabled, then record the drawing commands to a command buffer
-	 * @param command_buffer A valid command buffer that is ready to be recorded to
-	 */
-	void draw_ui(const VkCommandBuffer command_buffer);
-
 	/**
 	 * @brief Prepare the frame for workload submission, acquires the next image from the swap chain and 
 	 *        sets the default wait and signal semaphores
+	 *        Waits until the GPU has finished the frame slot and the acquired image's previous frame,
+	 *        so their command buffers and uniform regions may be recorded and written again
 	 */
 	void prepare_frame();
 
 	/**
 	 * @brief Submit the frames' workload
+	 *        The framework's final submission signals the frame slot fence, the samples submit without a fence
 	 */
 	void submit_frame();
 
+	/**
+	 * @brief Size of one swap chain image's region in a ring-buffered uniform buffer
+	 * @param size The size of the uniform data
+	 * @returns The size aligned to minUniformBufferOffsetAlignment
+	 */
+	VkDeviceSize get_uniform_stride(VkDeviceSize size) const;
+
+	/**
+	 * @brief Creates a host visible uniform buffer with one region per swap chain image
+	 *        Bound as VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC with a dynamic offset of image index * stride, so
+	 *        each pre-recorded command buffer reads the region only it uses
+	 * @param size The size of the uniform data
+	 */
+	std::unique_ptr<vkb::core::Buffer> create_ring_uniform_buffer(VkDeviceSize size);
+
+	/**
+	 * @brief Dynamic offset of a swap chain image's region in a ring-buffered uniform buffer
+	 * @param size The size of the uniform data
+	 * @param index The index of the swap chain image
+	 */
+	uint32_t get_ring_uniform_offset(VkDeviceSize size, uint32_t index) const;
+
+	/**
+	 * @brief Writes uniform data to the acquired image's region of a ring-buffered uniform buffer
+	 *        Called after prepare_frame, the regions of the other images may still be read by frames in flight
+	 * @param buffer A buffer created by create_ring_uniform_buffer for the size of the data
+	 * @param data The uniform data
+	 */
+	template <class T>
+	void update_ring_uniform_buffer(vkb::core::Buffer &buffer, const T &data)
+	{
+		buffer.convert_and_update(data, get_ring_uniform_offset(sizeof(T), current_buffer));
+	}
+
 	/**
 	 * @brief Called when the UI overlay is updating, can be used to add custom elements to the overlay
 	 * @param drawer The drawer from the gui to draw certain elements
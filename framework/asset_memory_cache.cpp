@@ -0,0 +1,169 @@
+/* Copyright (c) 2020, Arm Limited and Contributors
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 the "License";
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "asset_memory_cache.h"
+
+#include <tiny_gltf.h>
+
+#include "common/logging.h"
+#include "platform/filesystem.h"
+
+namespace vkb
+{
+namespace
+{
+/**
+ * @return Estimated bytes of a parsed glTF file, counted from its buffers and embedded images
+ */
+size_t get_model_size(const tinygltf::Model &model)
+{
+	size_t size = sizeof(tinygltf::Model);
+
+	for (auto &buffer : model.buffers)
+	{
+		size += buffer.data.size();
+	}
+
+	for (auto &image : model.images)
+	{
+		size += image.image.size();
+	}
+
+	return size;
+}
+}        // namespace
+
+constexpr size_t AssetMemoryCache::DEFAULT_BUDGET;
+
+AssetMemoryCache &AssetMemoryCache::get()
+{
+	static AssetMemoryCache asset_memory_cache;
+
+	return asset_memory_cache;
+}
+
+void AssetMemoryCache::set_budget(size_t budget_)
+{
+	std::lock_guard<std::mutex> lock{mutex};
+
+	budget = budget_;
+
+	evict();
+}
+
+std::shared_ptr<const tinygltf::Model> AssetMemoryCache::find_model(const std::string &path)
+{
+	return std::static_pointer_cast<const tinygltf::Model>(find(path));
+}
+
+void AssetMemoryCache::store_model(const std::string &path, const tinygltf::Model &model)
+{
+	store(path, std::make_shared<const tinygltf::Model>(model), get_model_size(model));
+}
+
+std::shared_ptr<const std::vector<uint8_t>> AssetMemoryCache::find_image(const std::string &path)
+{
+	return std::static_pointer_cast<const std::vector<uint8_t>>(find(path));
+}
+
+void AssetMemoryCache::store_image(const std::string &path, std::vector<uint8_t> &&packed_image)
+{
+	size_t image_size = packed_image.size();
+
+	store(path, std::make_shared<const std::vector<uint8_t>>(std::move(packed_image)), image_size);
+}
+
+void AssetMemoryCache::clear()
+{
+	std::lock_guard<std::mutex> lock{mutex};
+
+	entries.clear();
+
+	size = 0;
+}
+
+size_t AssetMemoryCache::get_size()
+{
+	std::lock_guard<std::mutex> lock{mutex};
+
+	return size;
+}
+
+std::shared_ptr<const void> AssetMemoryCache::find(const std::string &path)
+{
+	// The file is checked before locking, the other threads keep looking up their assets meanwhile
+	int64_t modification_time = fs::get_modification_time(path);
+
+	std::lock_guard<std::mutex> lock{mutex};
+
+	auto it = entries.find(path);
+
+	if (it == entries.end() || modification_time == 0 || it->second.modification_time != modification_time)
+	{
+		return nullptr;
+	}
+
+	it->second.last_use = ++use_count;
+
+	return it->second.asset;
+}
+
+void AssetMemoryCache::store(const std::string &path, std::shared_ptr<const void> asset, size_t asset_size)
+{
+	int64_t modification_time = fs::get_modification_time(path);
+
+	// Files which can't be found, such as archived ones, can't be told apart from a newer version
+	if (modification_time == 0)
+	{
+		return;
+	}
+
+	std::lock_guard<std::mutex> lock{mutex};
+
+	auto &entry = entries[path];
+
+	size = size - entry.size + asset_size;
+
+	entry.modification_time = modification_time;
+	entry.size              = asset_size;
+	entry.last_use          = ++use_count;
+	entry.asset             = std::move(asset);
+
+	evict();
+}
+
+void AssetMemoryCache::evict()
+{
+	while (size > budget && !entries.empty())
+	{
+		auto oldest = entries.begin();
+
+		for (auto it = entries.begin(); it != entries.end(); ++it)
+		{
+			if (it->second.last_use < oldest->second.last_use)
+			{
+				oldest = it;
+			}
+		}
+
+		LOGD("Evicting {} from the asset memory cache", oldest->first);
+
+		size -= oldest->second.size;
+		entries.erase(oldest);
+	}
+}
+}        // namespace vkb
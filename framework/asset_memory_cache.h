@@ -0,0 +1,144 @@
+/* Copyright (c) 2020, Arm Limited and Contributors
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 the "License";
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace tinygltf
+{
+class Model;
+}        // namespace tinygltf
+
+namespace vkb
+{
+/**
+ * @brief Process wide cache of decoded assets, so that the samples of a batch run load the assets they share once
+ *
+ * It keeps parsed glTF files and decoded images, as the output of sg::Image::pack, keyed by the path of their
+ * file and its modification time, so a file written since it was cached is loaded again. The assets are
+ * independent of the device, they outlive the samples which loaded them. The least recently used ones are
+ * evicted once their size exceeds the budget. It is thread safe.
+ */
+class AssetMemoryCache
+{
+  public:
+	/// Bytes cached by default
+	static constexpr size_t DEFAULT_BUDGET = size_t{1} << 30;
+
+	/**
+	 * @brief The cache used by the framework, created on first use
+	 */
+	static AssetMemoryCache &get();
+
+	AssetMemoryCache() = default;
+
+	AssetMemoryCache(const AssetMemoryCache &) = delete;
+
+	AssetMemoryCache(AssetMemoryCache &&) = delete;
+
+	AssetMemoryCache &operator=(const AssetMemoryCache &) = delete;
+
+	AssetMemoryCache &operator=(AssetMemoryCache &&) = delete;
+
+	/**
+	 * @brief Sets the number of bytes cached, evicting the least recently used assets beyond it
+	 */
+	void set_budget(size_t budget);
+
+	/**
+	 * @brief Finds a parsed glTF file
+	 * @param path Absolute path of the file
+	 * @return The model, or null if the file is not cached or was written since it was cached
+	 */
+	std::shared_ptr<const tinygltf::Model> find_model(const std::string &path);
+
+	/**
+	 * @brief Caches a parsed glTF file, before any of its data is moved out of it
+	 * @param path Absolute path of the file
+	 * @param model The model
+	 */
+	void store_model(const std::string &path, const tinygltf::Model &model);
+
+	/**
+	 * @brief Finds a decoded image
+	 * @param path Absolute path of the image file
+	 * @return The image packed by sg::Image::pack, or null if the file is not cached or was written since it was cached
+	 */
+	std::shared_ptr<const std::vector<uint8_t>> find_image(const std::string &path);
+
+	/**
+	 * @brief Caches a decoded image
+	 * @param path Absolute path of the image file
+	 * @param packed_image The output of sg::Image::pack for the image
+	 */
+	void store_image(const std::string &path, std::vector<uint8_t> &&packed_image);
+
+	/**
+	 * @brief Evicts all the assets
+	 */
+	void clear();
+
+	/**
+	 * @return The bytes cached
+	 */
+	size_t get_size();
+
+  private:
+	struct Entry
+	{
+		/// Modification time of the file when it was loaded
+		int64_t modification_time{0};
+
+		/// Estimated bytes of the asset
+		size_t size{0};
+
+		/// Value of use_count when the asset was last stored or found
+		uint64_t last_use{0};
+
+		/// The model or the packed image
+		std::shared_ptr<const void> asset;
+	};
+
+	/**
+	 * @return The asset of a file, or null if it is not cached or was written since it was cached
+	 */
+	std::shared_ptr<const void> find(const std::string &path);
+
+	void store(const std::string &path, std::shared_ptr<const void> asset, size_t size);
+
+	/**
+	 * @brief Evicts the least recently used assets until the cache fits its budget
+	 */
+	void evict();
+
+	std::mutex mutex;
+
+	std::unordered_map<std::string, Entry> entries;
+
+	size_t budget{DEFAULT_BUDGET};
+
+	size_t size{0};
+
+	uint64_t use_count{0};
+};
+}        // namespace vkb
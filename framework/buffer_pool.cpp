@@ -36,11 +36,12 @@ BufferBlock::BufferBlock(Device &device, VkDeviceSize size, VkBufferUsageFlags u
 	{
 		alignment = device.get_gpu().get_properties().limits.minStorageBufferOffsetAlignment;
 	}
-	else if (usage == VK_BUFFER_USAGE_UNIFORM_TEXEL_BUFFER_BIT)
+	else if (usage == VK_BUFFER_USAGE_UNIFORM_TEXEL_BUFFER_BIT || usage == VK_BUFFER_USAGE_STORAGE_TEXEL_BUFFER_BIT)
 	{
 		alignment = device.get_gpu().get_properties().limits.minTexelBufferOffsetAlignment;
 	}
-	else if (usage == VK_BUFFER_USAGE_INDEX_BUFFER_BIT || usage == VK_BUFFER_USAGE_VERTEX_BUFFER_BIT || usage == VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT)
+	else if (usage == VK_BUFFER_USAGE_INDEX_BUFFER_BIT || usage == VK_BUFFER_USAGE_VERTEX_BUFFER_BIT || usage == VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT ||
+	         usage == VK_BUFFER_USAGE_TRANSFER_SRC_BIT)
 	{
 		// Used to calculate the offset, required when allocating memory (its value should be power of 2)
 		alignment = 16;
@@ -73,6 +74,11 @@ VkDeviceSize BufferBlock::get_size() const
 	return buffer.get_size();
 }
 
+VkDeviceSize BufferBlock::get_used_size() const
+{
+	return offset;
+}
+
 void BufferBlock::reset()
 {
 	offset = 0;
@@ -110,14 +116,119 @@ BufferBlock &BufferPool::request_buffer_block(const VkDeviceSize minimum_size)
 	return *block.get();
 }
 
+BufferAllocation BufferPool::allocate_stream(const VkDeviceSize size)
+{
+	if (stream_block)
+	{
+		auto allocation = stream_block->allocate(to_u32(size));
+
+		if (!allocation.empty())
+		{
+			return allocation;
+		}
+	}
+
+	LOGD("Streaming {} bytes in a dedicated buffer ({}), the stream block grows on reset", size, usage);
+
+	stream_overflow_blocks.emplace_back(std::make_unique<BufferBlock>(device, size, usage, memory_usage));
+
+	return stream_overflow_blocks.back()->allocate(to_u32(size));
+}
+
+void BufferPool::reserve(const BufferPoolDemand &demand)
+{
+	// Blocks are created inactive, to be recycled by the next requests
+	while (buffer_blocks.size() < demand.block_count)
+	{
+		buffer_blocks.emplace_back(std::make_unique<BufferBlock>(device, block_size, usage, memory_usage));
+	}
+
+	if (demand.stream_size > 0 && (!stream_block || stream_block->get_size() < demand.stream_size))
+	{
+		assert(get_stream_demand() == 0 && "The stream block is in use");
+
+		stream_block = std::make_unique<BufferBlock>(device, demand.stream_size, usage, memory_usage);
+	}
+}
+
+VkDeviceSize BufferPool::get_block_size() const
+{
+	return block_size;
+}
+
+size_t BufferPool::get_block_count() const
+{
+	return buffer_blocks.size();
+}
+
+VkDeviceSize BufferPool::get_memory_size() const
+{
+	VkDeviceSize memory_size = 0;
+
+	for (auto &buffer_block : buffer_blocks)
+	{
+		memory_size += buffer_block->get_size();
+	}
+
+	if (stream_block)
+	{
+		memory_size += stream_block->get_size();
+	}
+
+	for (auto &overflow_block : stream_overflow_blocks)
+	{
+		memory_size += overflow_block->get_size();
+	}
+
+	return memory_size;
+}
+
+BufferPoolDemand BufferPool::get_high_water_mark() const
+{
+	BufferPoolDemand demand = high_water_mark;
+	demand.block_count      = std::max(demand.block_count, active_buffer_block_count);
+	demand.stream_size      = std::max(demand.stream_size, get_stream_demand());
+
+	return demand;
+}
+
+VkDeviceSize BufferPool::get_stream_demand() const
+{
+	VkDeviceSize demand = stream_block ? stream_block->get_used_size() : 0;
+
+	for (auto &overflow_block : stream_overflow_blocks)
+	{
+		demand += overflow_block->get_size();
+	}
+
+	return demand;
+}
+
 void BufferPool::reset()
 {
+	high_water_mark = get_high_water_mark();
+
 	for (auto &buffer_block : buffer_blocks)
 	{
 		buffer_block->reset();
 	}
 
 	active_buffer_block_count = 0;
+
+	if (!stream_overflow_blocks.empty())
+	{
+		// The device is done with the frame, so the stream block can be replaced by one holding the whole peak,
+		// rounded up to blocks so that slowly growing streams do not recreate it every frame
+		VkDeviceSize stream_size = (high_water_mark.stream_size + block_size - 1) / block_size * block_size;
+
+		stream_overflow_blocks.clear();
+
+		stream_block = std::make_unique<BufferBlock>(device, stream_size, usage, memory_usage);
+	}
+	else if (stream_block)
+	{
+		stream_block->reset();
+	}
 }
 
 BufferAllocation::BufferAllocation(core::Buffer &buffer, VkDeviceSize size, VkDeviceSize offset) :
@@ -128,12 +239,17 @@ BufferAllocation::BufferAllocation(core::Buffer &buffer, VkDeviceSize size, VkDe
 }
 
 void BufferAllocation::update(const std::vector<uint8_t> &data, uint32_t offset)
+{
+	update(data.data(), data.size(), offset);
+}
+
+void BufferAllocation::update(const uint8_t *data, size_t data_size, uint32_t offset)
 {
 	assert(buffer && "Invalid buffer pointer");
 
-	if (offset + data.size() <= size)
+	if (offset + data_size <= size)
 	{
-		buffer->update(data, to_u32(base_offset) + offset);
+		buffer->update(data, data_size, to_u32(base_offset) + offset);
 	}
 	else
 	{
@@ -141,6 +257,18 @@ void BufferAllocation::update(const std::vector<uint8_t> &data, uint32_t offset)
 	}
 }
 
+uint8_t *BufferAllocation::map()
+{
+	assert(buffer && "Invalid buffer pointer");
+	return buffer->map() + base_offset;
+}
+
+void BufferAllocation::flush()
+{
+	assert(buffer && "Invalid buffer pointer");
+	buffer->flush(base_offset, size);
+}
+
 bool BufferAllocation::empty() const
 {
 	return size == 0 || buffer == nullptr;
@@ -17,6 +17,8 @@
 
 #pragma once
 
+#include <new>
+
 #include "common/helpers.h"
 #include "core/buffer.h"
 
@@ -45,10 +47,38 @@ class BufferAllocation
 
 	void update(const std::vector<uint8_t> &data, uint32_t offset = 0);
 
+	void update(const uint8_t *data, size_t data_size, uint32_t offset = 0);
+
 	template <class T>
 	void update(const T &value, uint32_t offset = 0)
 	{
-		update(to_bytes(value), offset);
+		update(reinterpret_cast<const uint8_t *>(&value), sizeof(T), offset);
+	}
+
+	/**
+	 * @brief Maps the underlying buffer to write into the allocation directly
+	 *        Writes need to be followed by a call to flush()
+	 * @return Pointer to the start of the allocation
+	 */
+	uint8_t *map();
+
+	/**
+	 * @brief Flushes the memory of the allocation if it is not HOST_COHERENT
+	 */
+	void flush();
+
+	/**
+	 * @brief Constructs an object in place in the mapped memory of the allocation
+	 *        Writes through the returned pointer need to be followed by a call to flush()
+	 * @param offset Offset of the object from the start of the allocation
+	 * @param args Arguments forwarded to the constructor of the object
+	 * @return Pointer to the object, valid until the allocation is recycled
+	 */
+	template <class T, class... A>
+	T *emplace(uint32_t offset = 0, A &&... args)
+	{
+		assert(offset + sizeof(T) <= size && "Object does not fit in the allocation");
+		return new (map() + offset) T(std::forward<A>(args)...);
 	}
 
 	bool empty() const;
@@ -82,6 +112,11 @@ class BufferBlock
 
 	VkDeviceSize get_size() const;
 
+	/**
+	 * @return The bytes allocated since the last reset, including alignment padding
+	 */
+	VkDeviceSize get_used_size() const;
+
 	void reset();
 
   private:
@@ -94,6 +129,18 @@ class BufferBlock
 	VkDeviceSize offset{0};
 };
 
+/**
+ * @brief Peak demand of a buffer pool in the frames it was used for, to size a pool up front
+ */
+struct BufferPoolDemand
+{
+	/// Largest number of blocks active in a frame
+	uint32_t block_count{0};
+
+	/// Largest number of bytes streamed in a frame, by allocations larger than a block
+	VkDeviceSize stream_size{0};
+};
+
 /**
  * @brief A pool of buffer blocks for a specific usage.
  * It may contain inactive blocks that can be recycled.
@@ -104,8 +151,13 @@ class BufferBlock
  * (set_resource_dynamic).
  *
  * When a new frame starts, buffer blocks are returned: the offset is reset and contents are
- * overwritten. The minimum allocation size is 256 kb, if you ask for more you get a dedicated
- * buffer allocation.
+ * overwritten. The minimum allocation size is 256 kb.
+ *
+ * Allocations larger than a block, such as per-frame instance or particle streams, are streamed
+ * through a persistent stream block instead. The render frames in flight each own a pool, so their
+ * stream blocks form a ring which the device consumes while the host writes the next segment.
+ * A frame which streams more than its block holds gets dedicated buffers until the pool is reset,
+ * when the stream block grows to the peak demand so that the following frames fit in it.
  *
  * We re-use descriptor sets: we only need one for the corresponding buffer infos (and we only
  * have one VkBuffer per BufferBlock), then it is bound and we use dynamic offsets.
@@ -117,9 +169,46 @@ class BufferPool
 
 	BufferBlock &request_buffer_block(VkDeviceSize minimum_size);
 
+	/**
+	 * @brief Allocates from the stream block, for allocations larger than a block
+	 * @return An allocation valid until the pool is reset
+	 */
+	BufferAllocation allocate_stream(VkDeviceSize size);
+
+	/**
+	 * @brief Creates the blocks and the stream block of a demand up front, the pool keeps any larger ones
+	 */
+	void reserve(const BufferPoolDemand &demand);
+
+	/**
+	 * @brief Returns the blocks and the stream block, releasing the dedicated stream buffers
+	 *        The stream block grows to the peak demand of the frames since it was created.
+	 */
 	void reset();
 
+	VkDeviceSize get_block_size() const;
+
+	/**
+	 * @return The number of blocks the pool owns, active or not
+	 */
+	size_t get_block_count() const;
+
+	/**
+	 * @return The size in bytes of all the blocks the pool owns
+	 */
+	VkDeviceSize get_memory_size() const;
+
+	/**
+	 * @return The peak demand of the frames since the pool was created, including the frame in progress
+	 */
+	BufferPoolDemand get_high_water_mark() const;
+
   private:
+	/**
+	 * @return The bytes streamed since the last reset
+	 */
+	VkDeviceSize get_stream_demand() const;
+
 	Device &device;
 
 	/// List of blocks requested
@@ -134,5 +223,14 @@ class BufferPool
 
 	/// Numbers of active blocks from the start of buffer_blocks
 	uint32_t active_buffer_block_count{0};
+
+	/// Block of the allocations larger than block_size, null until one is requested
+	std::unique_ptr<BufferBlock> stream_block;
+
+	/// Dedicated blocks of the allocations which did not fit in the stream block, released on reset
+	std::vector<std::unique_ptr<BufferBlock>> stream_overflow_blocks;
+
+	/// Peak demand of the frames before the current one
+	BufferPoolDemand high_water_mark;
 };
 }        // namespace vkb
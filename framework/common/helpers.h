@@ -19,8 +19,10 @@
 
 #include <algorithm>
 #include <array>
+#include <cstdint>
 #include <cstdio>
 #include <cstdlib>
+#include <cstring>
 #include <fstream>
 #include <functional>
 #include <iterator>
@@ -164,15 +166,64 @@ inline void write(std::ostringstream &os, const T &first_arg, const Args &... ar
 	write(os, args...);
 }
 
+/**
+ * @brief Mixes the bits of a 64-bit value, so that each of them affects all the bits of the result
+ *        This is the finalizer of MurmurHash3.
+ */
+inline uint64_t hash_mix(uint64_t value)
+{
+	value ^= value >> 33;
+	value *= 0xff51afd7ed558ccdULL;
+	value ^= value >> 33;
+	value *= 0xc4ceb9fe1a85ec53ULL;
+	value ^= value >> 33;
+
+	return value;
+}
+
 /**
  * @brief Helper function to combine a given hash
  *        with a generated hash for the input param.
+ *        The combined hash is mixed, as std::hash of integers and handles is usually the value itself.
  */
 template <class T>
 inline void hash_combine(size_t &seed, const T &v)
 {
 	std::hash<T> hasher;
-	glm::detail::hash_combine(seed, hasher(v));
+	seed = static_cast<size_t>(hash_mix(static_cast<uint64_t>(seed) ^ (static_cast<uint64_t>(hasher(v)) + 0x9e3779b97f4a7c15ULL)));
+}
+
+/**
+ * @brief Combines the bytes of plain data with a given hash, 8 bytes at a time
+ * @param seed The hash to combine with
+ * @param data The data, which must not have padding bytes as their value is undefined
+ * @param size The size of the data in bytes
+ */
+inline void hash_bytes(size_t &seed, const void *data, size_t size)
+{
+	auto     bytes = static_cast<const uint8_t *>(data);
+	uint64_t hash  = static_cast<uint64_t>(seed) ^ (static_cast<uint64_t>(size) * 0x9e3779b97f4a7c15ULL);
+
+	uint64_t word;
+
+	for (; size >= sizeof(word); bytes += sizeof(word), size -= sizeof(word))
+	{
+		std::memcpy(&word, bytes, sizeof(word));
+
+		hash ^= word * 0x87c37b91114253d5ULL;
+		hash = ((hash << 31) | (hash >> 33)) * 0x4cf5ad432745937fULL;
+	}
+
+	if (size > 0)
+	{
+		word = 0;
+		std::memcpy(&word, bytes, size);
+
+		hash ^= word * 0x87c37b91114253d5ULL;
+		hash = ((hash << 31) | (hash >> 33)) * 0x4cf5ad432745937fULL;
+	}
+
+	seed = static_cast<size_t>(hash_mix(hash));
 }
 
 /**
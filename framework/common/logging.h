@@ -28,4 +28,16 @@
 #define LOGI(...) spdlog::info(__VA_ARGS__);
 #define LOGW(...) spdlog::warn(__VA_ARGS__);
 #define LOGE(...) spdlog::error("[{}:{}] {}", __FILENAME__, __LINE__, fmt::format(__VA_ARGS__));
-#define LOGD(...) spdlog::debug(__VA_ARGS__);
+// Debug messages are compiled out of release builds, their arguments are not evaluated
+#if !defined(NDEBUG) || defined(DEBUG) || defined(_DEBUG)
+#	define LOGD(...) spdlog::debug(__VA_ARGS__);
+#else
+#	define LOGD(...)                                                \
+		do                                                           \
+		{                                                            \
+			static_cast<void>(sizeof(fmt::format(__VA_ARGS__)));     \
+		} while (0);
+#endif
+
+/// Number of messages the asynchronous logger can queue before the oldest ones are dropped
+#define LOGGER_QUEUE_SIZE 8192
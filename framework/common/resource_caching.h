@@ -22,6 +22,7 @@
 #include "core/descriptor_set_layout.h"
 #include "core/framebuffer.h"
 #include "core/pipeline.h"
+#include "core/sampler.h"
 #include "rendering/pipeline_state.h"
 #include "rendering/render_target.h"
 #include "resource_record.h"
@@ -125,13 +126,40 @@ template <>
 struct hash<vkb::Attachment>
 {
 	std::size_t operator()(const vkb::Attachment &attachment) const
+	{
+		static_assert(sizeof(vkb::Attachment) == 4 * sizeof(uint32_t), "Attachment must be hashed as packed data");
+
+		std::size_t result = 0;
+
+		vkb::hash_bytes(result, &attachment, sizeof(attachment));
+
+		return result;
+	}
+};
+
+template <>
+struct hash<VkSamplerCreateInfo>
+{
+	std::size_t operator()(const VkSamplerCreateInfo &sampler_info) const
 	{
 		std::size_t result = 0;
 
-		vkb::hash_combine(result, static_cast<std::underlying_type<VkFormat>::type>(attachment.format));
-		vkb::hash_combine(result, static_cast<std::underlying_type<VkSampleCountFlagBits>::type>(attachment.samples));
-		vkb::hash_combine(result, attachment.usage);
-		vkb::hash_combine(result, static_cast<std::underlying_type<VkImageLayout>::type>(attachment.initial_layout));
+		vkb::hash_combine(result, sampler_info.flags);
+		vkb::hash_combine(result, static_cast<std::underlying_type<VkFilter>::type>(sampler_info.magFilter));
+		vkb::hash_combine(result, static_cast<std::underlying_type<VkFilter>::type>(sampler_info.minFilter));
+		vkb::hash_combine(result, static_cast<std::underlying_type<VkSamplerMipmapMode>::type>(sampler_info.mipmapMode));
+		vkb::hash_combine(result, static_cast<std::underlying_type<VkSamplerAddressMode>::type>(sampler_info.addressModeU));
+		vkb::hash_combine(result, static_cast<std::underlying_type<VkSamplerAddressMode>::type>(sampler_info.addressModeV));
+		vkb::hash_combine(result, static_cast<std::underlying_type<VkSamplerAddressMode>::type>(sampler_info.addressModeW));
+		vkb::hash_combine(result, sampler_info.mipLodBias);
+		vkb::hash_combine(result, sampler_info.anisotropyEnable);
+		vkb::hash_combine(result, sampler_info.maxAnisotropy);
+		vkb::hash_combine(result, sampler_info.compareEnable);
+		vkb::hash_combine(result, static_cast<std::underlying_type<VkCompareOp>::type>(sampler_info.compareOp));
+		vkb::hash_combine(result, sampler_info.minLod);
+		vkb::hash_combine(result, sampler_info.maxLod);
+		vkb::hash_combine(result, static_cast<std::underlying_type<VkBorderColor>::type>(sampler_info.borderColor));
+		vkb::hash_combine(result, sampler_info.unnormalizedCoordinates);
 
 		return result;
 	}
@@ -142,10 +170,11 @@ struct hash<vkb::LoadStoreInfo>
 {
 	std::size_t operator()(const vkb::LoadStoreInfo &load_store_info) const
 	{
+		static_assert(sizeof(vkb::LoadStoreInfo) == 2 * sizeof(uint32_t), "LoadStoreInfo must be hashed as packed data");
+
 		std::size_t result = 0;
 
-		vkb::hash_combine(result, static_cast<std::underlying_type<VkAttachmentLoadOp>::type>(load_store_info.load_op));
-		vkb::hash_combine(result, static_cast<std::underlying_type<VkAttachmentStoreOp>::type>(load_store_info.store_op));
+		vkb::hash_bytes(result, &load_store_info, sizeof(load_store_info));
 
 		return result;
 	}
@@ -158,24 +187,18 @@ struct hash<vkb::SubpassInfo>
 	{
 		std::size_t result = 0;
 
-		for (uint32_t output_attachment : subpass_info.output_attachments)
-		{
-			vkb::hash_combine(result, output_attachment);
-		}
-
-		for (uint32_t input_attachment : subpass_info.input_attachments)
-		{
-			vkb::hash_combine(result, input_attachment);
-		}
-
-		for (uint32_t resolve_attachment : subpass_info.color_resolve_attachments)
-		{
-			vkb::hash_combine(result, resolve_attachment);
-		}
+		// The size of each list is hashed with it, so that attachments cannot move from one list to the next
+		vkb::hash_bytes(result, subpass_info.output_attachments.data(), subpass_info.output_attachments.size() * sizeof(uint32_t));
+		vkb::hash_bytes(result, subpass_info.input_attachments.data(), subpass_info.input_attachments.size() * sizeof(uint32_t));
+		vkb::hash_bytes(result, subpass_info.color_resolve_attachments.data(), subpass_info.color_resolve_attachments.size() * sizeof(uint32_t));
 
 		vkb::hash_combine(result, subpass_info.disable_depth_stencil_attachment);
 		vkb::hash_combine(result, subpass_info.depth_stencil_resolve_attachment);
-		vkb::hash_combine(result, subpass_info.depth_stencil_resolve_mode);
+		vkb::hash_combine(result, static_cast<std::underlying_type<VkResolveModeFlagBits>::type>(subpass_info.depth_stencil_resolve_mode));
+		vkb::hash_combine(result, subpass_info.shading_rate_attachment);
+		vkb::hash_combine(result, subpass_info.shading_rate_texel_size.width);
+		vkb::hash_combine(result, subpass_info.shading_rate_texel_size.height);
+		vkb::hash_combine(result, subpass_info.view_mask);
 
 		return result;
 	}
@@ -230,11 +253,11 @@ struct hash<VkDescriptorBufferInfo>
 {
 	std::size_t operator()(const VkDescriptorBufferInfo &descriptor_buffer_info) const
 	{
+		static_assert(sizeof(VkDescriptorBufferInfo) == sizeof(VkBuffer) + 2 * sizeof(VkDeviceSize), "VkDescriptorBufferInfo must be hashed as packed data");
+
 		std::size_t result = 0;
 
-		vkb::hash_combine(result, descriptor_buffer_info.buffer);
-		vkb::hash_combine(result, descriptor_buffer_info.range);
-		vkb::hash_combine(result, descriptor_buffer_info.offset);
+		vkb::hash_bytes(result, &descriptor_buffer_info, sizeof(descriptor_buffer_info));
 
 		return result;
 	}
@@ -403,79 +426,8 @@ struct hash<vkb::PipelineState>
 {
 	std::size_t operator()(const vkb::PipelineState &pipeline_state) const
 	{
-		std::size_t result = 0;
-
-		vkb::hash_combine(result, pipeline_state.get_pipeline_layout().get_handle());
-
-		// For graphics only
-		if (auto render_pass = pipeline_state.get_render_pass())
-		{
-			vkb::hash_combine(result, render_pass->get_handle());
-		}
-
-		vkb::hash_combine(result, pipeline_state.get_specialization_constant_state());
-
-		vkb::hash_combine(result, pipeline_state.get_subpass_index());
-
-		for (auto shader_module : pipeline_state.get_pipeline_layout().get_shader_modules())
-		{
-			vkb::hash_combine(result, shader_module->get_id());
-		}
-
-		// VkPipelineVertexInputStateCreateInfo
-		for (auto &attribute : pipeline_state.get_vertex_input_state().attributes)
-		{
-			vkb::hash_combine(result, attribute);
-		}
-
-		for (auto &binding : pipeline_state.get_vertex_input_state().bindings)
-		{
-			vkb::hash_combine(result, binding);
-		}
-
-		// VkPipelineInputAssemblyStateCreateInfo
-		vkb::hash_combine(result, pipeline_state.get_input_assembly_state().primitive_restart_enable);
-		vkb::hash_combine(result, static_cast<std::underlying_type<VkPrimitiveTopology>::type>(pipeline_state.get_input_assembly_state().topology));
-
-		//VkPipelineViewportStateCreateInfo
-		vkb::hash_combine(result, pipeline_state.get_viewport_state().viewport_count);
-		vkb::hash_combine(result, pipeline_state.get_viewport_state().scissor_count);
-
-		// VkPipelineRasterizationStateCreateInfo
-		vkb::hash_combine(result, pipeline_state.get_rasterization_state().cull_mode);
-		vkb::hash_combine(result, pipeline_state.get_rasterization_state().depth_bias_enable);
-		vkb::hash_combine(result, pipeline_state.get_rasterization_state().depth_clamp_enable);
-		vkb::hash_combine(result, static_cast<std::underlying_type<VkFrontFace>::type>(pipeline_state.get_rasterization_state().front_face));
-		vkb::hash_combine(result, static_cast<std::underlying_type<VkPolygonMode>::type>(pipeline_state.get_rasterization_state().polygon_mode));
-		vkb::hash_combine(result, pipeline_state.get_rasterization_state().rasterizer_discard_enable);
-
-		// VkPipelineMultisampleStateCreateInfo
-		vkb::hash_combine(result, pipeline_state.get_multisample_state().alpha_to_coverage_enable);
-		vkb::hash_combine(result, pipeline_state.get_multisample_state().alpha_to_one_enable);
-		vkb::hash_combine(result, pipeline_state.get_multisample_state().min_sample_shading);
-		vkb::hash_combine(result, static_cast<std::underlying_type<VkSampleCountFlagBits>::type>(pipeline_state.get_multisample_state().rasterization_samples));
-		vkb::hash_combine(result, pipeline_state.get_multisample_state().sample_shading_enable);
-		vkb::hash_combine(result, pipeline_state.get_multisample_state().sample_mask);
-
-		// VkPipelineDepthStencilStateCreateInfo
-		vkb::hash_combine(result, pipeline_state.get_depth_stencil_state().back);
-		vkb::hash_combine(result, pipeline_state.get_depth_stencil_state().depth_bounds_test_enable);
-		vkb::hash_combine(result, static_cast<std::underlying_type<VkCompareOp>::type>(pipeline_state.get_depth_stencil_state().depth_compare_op));
-		vkb::hash_combine(result, pipeline_state.get_depth_stencil_state().depth_test_enable);
-		vkb::hash_combine(result, pipeline_state.get_depth_stencil_state().depth_write_enable);
-		vkb::hash_combine(result, pipeline_state.get_depth_stencil_state().front);
-		vkb::hash_combine(result, pipeline_state.get_depth_stencil_state().stencil_test_enable);
-
-		// VkPipelineColorBlendStateCreateInfo
-		vkb::hash_combine(result, static_cast<std::underlying_type<VkLogicOp>::type>(pipeline_state.get_color_blend_state().logic_op));
-		vkb::hash_combine(result, pipeline_state.get_color_blend_state().logic_op_enable);
-
-		for (auto &attachment : pipeline_state.get_color_blend_state().attachments)
-		{
-			vkb::hash_combine(result, attachment);
-		}
-
-		return result;
+		// The state keeps the hashes of its parts up to date as they are set
+		return pipeline_state.get_hash();
 	}
 };
 }        // namespace std
@@ -500,7 +452,14 @@ inline void hash_param<std::vector<uint8_t>>(
     size_t &                    seed,
     const std::vector<uint8_t> &value)
 {
-	hash_combine(seed, std::string{value.begin(), value.end()});
+	hash_bytes(seed, value.data(), value.size());
+}
+
+template <>
+inline void hash_param<RenderPass>(size_t &seed, const RenderPass &value)
+{
+	// A framebuffer is shared by all the render passes of a compatibility class
+	hash_combine(seed, value.get_compatibility_hash());
 }
 
 template <>
@@ -508,10 +467,9 @@ inline void hash_param<std::vector<Attachment>>(
     size_t &                       seed,
     const std::vector<Attachment> &value)
 {
-	for (auto &attachment : value)
-	{
-		hash_combine(seed, attachment);
-	}
+	static_assert(sizeof(Attachment) == 4 * sizeof(uint32_t), "Attachment must be hashed as packed data");
+
+	hash_bytes(seed, value.data(), value.size() * sizeof(Attachment));
 }
 
 template <>
@@ -519,10 +477,9 @@ inline void hash_param<std::vector<LoadStoreInfo>>(
     size_t &                          seed,
     const std::vector<LoadStoreInfo> &value)
 {
-	for (auto &load_store_info : value)
-	{
-		hash_combine(seed, load_store_info);
-	}
+	static_assert(sizeof(LoadStoreInfo) == 2 * sizeof(uint32_t), "LoadStoreInfo must be hashed as packed data");
+
+	hash_bytes(seed, value.data(), value.size() * sizeof(LoadStoreInfo));
 }
 
 template <>
@@ -544,6 +501,12 @@ inline void hash_param<std::vector<ShaderModule *>>(
 	for (auto &shader_module : value)
 	{
 		hash_combine(seed, shader_module->get_id());
+
+		// Resource modes are set on shared shader modules, the layout depends on the ones set when requesting it
+		for (auto &resource : shader_module->get_resources())
+		{
+			hash_combine(seed, resource.mode);
+		}
 	}
 }
 
@@ -592,6 +555,23 @@ inline void hash_param<std::map<uint32_t, std::map<uint32_t, VkDescriptorImageIn
 	}
 }
 
+template <>
+inline void hash_param<std::map<uint32_t, std::map<uint32_t, VkAccelerationStructureKHR>>>(
+    size_t &                                                                 seed,
+    const std::map<uint32_t, std::map<uint32_t, VkAccelerationStructureKHR>> &value)
+{
+	for (auto &binding_set : value)
+	{
+		hash_combine(seed, binding_set.first);
+
+		for (auto &binding_element : binding_set.second)
+		{
+			hash_combine(seed, binding_element.first);
+			hash_combine(seed, binding_element.second);
+		}
+	}
+}
+
 template <typename T, typename... Args>
 inline void hash_param(size_t &seed, const T &first_arg, const Args &... args)
 {
@@ -668,6 +648,113 @@ struct RecordHelper<GraphicsPipeline, A...>
 		recorder.set_graphics_pipeline(index, graphics_pipeline);
 	}
 };
+
+#ifdef VKB_VERIFY_CACHE_KEYS
+template <class T, class E>
+inline bool equal_binding_maps(const BindingMap<T> &lhs, const BindingMap<T> &rhs, E equal)
+{
+	if (lhs.size() != rhs.size())
+	{
+		return false;
+	}
+
+	for (auto lhs_it = lhs.begin(), rhs_it = rhs.begin(); lhs_it != lhs.end(); ++lhs_it, ++rhs_it)
+	{
+		if (lhs_it->first != rhs_it->first || lhs_it->second.size() != rhs_it->second.size())
+		{
+			return false;
+		}
+
+		for (auto lhs_element = lhs_it->second.begin(), rhs_element = rhs_it->second.begin(); lhs_element != lhs_it->second.end(); ++lhs_element, ++rhs_element)
+		{
+			if (lhs_element->first != rhs_element->first || !equal(lhs_element->second, rhs_element->second))
+			{
+				return false;
+			}
+		}
+	}
+
+	return true;
+}
+
+/**
+ * @brief Compares the key of a request with the object cached under its hash, to detect hash collisions
+ *        Objects which do not keep the parameters they were built with always match.
+ */
+template <class T, class... A>
+inline bool matches_key(const T & /*resource*/, const A &... /*args*/)
+{
+	return true;
+}
+
+inline bool matches_key(const ShaderModule &shader_module, VkShaderStageFlagBits stage, const ShaderSource &glsl_source, const std::string &entry_point, const ShaderVariant &shader_variant)
+{
+	return shader_module.get_stage() == stage &&
+	       shader_module.get_entry_point() == entry_point &&
+	       shader_module.get_filename() == glsl_source.get_filename() &&
+	       shader_module.get_variant().get_id() == shader_variant.get_id();
+}
+
+inline bool matches_key(const PipelineLayout &pipeline_layout, const std::vector<ShaderModule *> &shader_modules)
+{
+	return pipeline_layout.get_shader_modules() == shader_modules;
+}
+
+inline bool matches_key(const DescriptorSetLayout &descriptor_set_layout, uint32_t set_index, const std::vector<ShaderResource> & /*set_resources*/)
+{
+	return descriptor_set_layout.get_index() == set_index;
+}
+
+inline bool matches_key(DescriptorSet &                               descriptor_set,
+                        const DescriptorSetLayout &                   descriptor_set_layout,
+                        const DescriptorPool & /*descriptor_pool*/,
+                        const BindingMap<VkDescriptorBufferInfo> &    buffer_infos,
+                        const BindingMap<VkDescriptorImageInfo> &     image_infos,
+                        const BindingMap<VkAccelerationStructureKHR> &acceleration_structure_infos)
+{
+	return descriptor_set.get_layout().get_handle() == descriptor_set_layout.get_handle() &&
+	       equal_binding_maps(descriptor_set.get_buffer_infos(), buffer_infos, [](const VkDescriptorBufferInfo &lhs, const VkDescriptorBufferInfo &rhs) {
+		       return lhs.buffer == rhs.buffer && lhs.offset == rhs.offset && lhs.range == rhs.range;
+	       }) &&
+	       equal_binding_maps(descriptor_set.get_image_infos(), image_infos, [](const VkDescriptorImageInfo &lhs, const VkDescriptorImageInfo &rhs) {
+		       return lhs.sampler == rhs.sampler && lhs.imageView == rhs.imageView && lhs.imageLayout == rhs.imageLayout;
+	       }) &&
+	       equal_binding_maps(descriptor_set.get_acceleration_structure_infos(), acceleration_structure_infos, [](VkAccelerationStructureKHR lhs, VkAccelerationStructureKHR rhs) {
+		       return lhs == rhs;
+	       });
+}
+
+inline bool matches_pipeline_key(const Pipeline &pipeline, const PipelineState &pipeline_state)
+{
+	auto &state = pipeline.get_state();
+
+	// Pipelines are shared by the render passes of a compatibility class
+	auto render_pass_hash = [](const RenderPass *render_pass) {
+		return render_pass ? render_pass->get_compatibility_hash() : 0;
+	};
+
+	return &state.get_pipeline_layout() == &pipeline_state.get_pipeline_layout() &&
+	       state.get_subpass_index() == pipeline_state.get_subpass_index() &&
+	       render_pass_hash(state.get_render_pass()) == render_pass_hash(pipeline_state.get_render_pass());
+}
+
+inline bool matches_key(const GraphicsPipeline &pipeline, VkPipelineCache /*pipeline_cache*/, const PipelineState &pipeline_state)
+{
+	return matches_pipeline_key(pipeline, pipeline_state);
+}
+
+inline bool matches_key(const ComputePipeline &pipeline, VkPipelineCache /*pipeline_cache*/, const PipelineState &pipeline_state)
+{
+	return matches_pipeline_key(pipeline, pipeline_state);
+}
+
+inline bool matches_key(const Framebuffer &framebuffer, const RenderTarget &render_target, const RenderPass & /*render_pass*/)
+{
+	auto &extent = render_target.get_extent();
+
+	return framebuffer.get_extent().width == extent.width && framebuffer.get_extent().height == extent.height;
+}
+#endif
 }        // namespace
 
 template <class T, class... A>
@@ -682,6 +769,12 @@ T &request_resource(Device &device, ResourceRecord *recorder, std::unordered_map
 
 	if (res_it != resources.end())
 	{
+#ifdef VKB_VERIFY_CACHE_KEYS
+		if (!matches_key(res_it->second, args...))
+		{
+			throw std::runtime_error{std::string{"Hash collision of cache object ("} + typeid(T).name() + ")"};
+		}
+#endif
 		return res_it->second;
 	}
 
@@ -723,4 +816,35 @@ T &request_resource(Device &device, ResourceRecord *recorder, std::unordered_map
 
 	return res_it->second;
 }
+
+/**
+ * @brief Adds an object which was built outside of the cache, for example by a worker thread.
+ *        It is recorded the same way as an object built by request_resource.
+ * @return The cached object, which is the given one unless an object with the same key was already cached
+ */
+template <class T, class... A>
+T &insert_resource(ResourceRecord *recorder, std::unordered_map<std::size_t, T> &resources, T &&resource, A &... args)
+{
+	RecordHelper<T, A...> record_helper;
+
+	std::size_t hash{0U};
+	hash_param(hash, args...);
+
+	auto res_it = resources.find(hash);
+
+	if (res_it != resources.end())
+	{
+		return res_it->second;
+	}
+
+	res_it = resources.emplace(hash, std::move(resource)).first;
+
+	if (recorder)
+	{
+		size_t index = record_helper.record(*recorder, args...);
+		record_helper.index(*recorder, index, res_it->second);
+	}
+
+	return res_it->second;
+}
 }        // namespace vkb
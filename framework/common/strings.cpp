@@ -1145,6 +1145,8 @@ const std::string to_string(ShaderResourceType type)
 			return "BufferUniform";
 		case ShaderResourceType::BufferStorage:
 			return "BufferStorage";
+		case ShaderResourceType::AccelerationStructure:
+			return "AccelerationStructure";
 		case ShaderResourceType::PushConstant:
 			return "PushConstant";
 		case ShaderResourceType::SpecializationConstant:
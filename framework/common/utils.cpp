@@ -72,7 +72,7 @@ void screenshot(RenderContext &render_context, const std::string &filename)
 
 	core::ImageView dst_image_view{dst_image, VK_IMAGE_VIEW_TYPE_2D};
 
-	const auto &queue = render_context.get_device().get_queue_by_flags(VK_QUEUE_GRAPHICS_BIT, 0);
+	const auto &queue = render_context.get_device().get_queue_by_role(QueueRole::Graphics);
 
 	auto &cmd_buf = render_context.get_device().request_command_buffer();
 
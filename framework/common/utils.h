@@ -46,7 +46,7 @@ std::string get_extension(const std::string &uri);
 std::string to_snake_case(const std::string &name);
 
 /**
- * @brief Takes a screenshot of the app by writing the swapchain image to file (slow function)
+ * @brief Takes a screenshot of the app by writing the swapchain image to file (slow function, ScreenshotCapture does not stall the frame)
  * @param filename The name of the file to save the output to
  */
 void screenshot(RenderContext &render_context, const std::string &filename);
@@ -0,0 +1,166 @@
+/* Copyright (c) 2020, Arm Limited and Contributors
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 the "License";
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "acceleration_structure.h"
+
+#include "device.h"
+
+namespace vkb
+{
+namespace core
+{
+AccelerationStructure::AccelerationStructure(Device &                                                             device,
+                                             VkAccelerationStructureTypeKHR                                       type,
+                                             VkBuildAccelerationStructureFlagsKHR                                 flags,
+                                             const std::vector<VkAccelerationStructureCreateGeometryTypeInfoKHR> &geometry_infos) :
+    device{device},
+    type{type},
+    flags{flags}
+{
+	VkAccelerationStructureCreateInfoKHR create_info{VK_STRUCTURE_TYPE_ACCELERATION_STRUCTURE_CREATE_INFO_KHR};
+	create_info.type             = type;
+	create_info.flags            = flags;
+	create_info.maxGeometryCount = to_u32(geometry_infos.size());
+	create_info.pGeometryInfos   = geometry_infos.data();
+
+	VK_CHECK(vkCreateAccelerationStructureKHR(device.get_handle(), &create_info, nullptr, &handle));
+
+	bind_memory();
+}
+
+AccelerationStructure::AccelerationStructure(Device &device, VkAccelerationStructureTypeKHR type, VkBuildAccelerationStructureFlagsKHR flags, VkDeviceSize compacted_size) :
+    device{device},
+    type{type},
+    flags{flags}
+{
+	VkAccelerationStructureCreateInfoKHR create_info{VK_STRUCTURE_TYPE_ACCELERATION_STRUCTURE_CREATE_INFO_KHR};
+	create_info.compactedSize = compacted_size;
+	create_info.type          = type;
+	create_info.flags         = flags;
+
+	VK_CHECK(vkCreateAccelerationStructureKHR(device.get_handle(), &create_info, nullptr, &handle));
+
+	bind_memory();
+}
+
+AccelerationStructure::AccelerationStructure(AccelerationStructure &&other) :
+    device{other.device},
+    handle{other.handle},
+    type{other.type},
+    flags{other.flags},
+    allocation{other.allocation},
+    memory_size{other.memory_size},
+    device_address{other.device_address}
+{
+	other.handle     = VK_NULL_HANDLE;
+	other.allocation = VK_NULL_HANDLE;
+}
+
+AccelerationStructure::~AccelerationStructure()
+{
+	if (handle != VK_NULL_HANDLE)
+	{
+		vkDestroyAccelerationStructureKHR(device.get_handle(), handle, nullptr);
+	}
+
+	if (allocation != VK_NULL_HANDLE)
+	{
+		vmaFreeMemory(device.get_memory_allocator(), allocation);
+	}
+}
+
+void AccelerationStructure::bind_memory()
+{
+	VkAccelerationStructureMemoryRequirementsInfoKHR requirements_info{VK_STRUCTURE_TYPE_ACCELERATION_STRUCTURE_MEMORY_REQUIREMENTS_INFO_KHR};
+	requirements_info.type                  = VK_ACCELERATION_STRUCTURE_MEMORY_REQUIREMENTS_TYPE_OBJECT_KHR;
+	requirements_info.buildType             = VK_ACCELERATION_STRUCTURE_BUILD_TYPE_DEVICE_KHR;
+	requirements_info.accelerationStructure = handle;
+
+	VkMemoryRequirements2 requirements{VK_STRUCTURE_TYPE_MEMORY_REQUIREMENTS_2};
+	vkGetAccelerationStructureMemoryRequirementsKHR(device.get_handle(), &requirements_info, &requirements);
+
+	// Acceleration structures are suballocated from device local memory instead of owning a device memory each
+	VmaAllocationCreateInfo memory_info{};
+	memory_info.usage = VMA_MEMORY_USAGE_GPU_ONLY;
+
+	VmaAllocationInfo allocation_info{};
+	VK_CHECK(vmaAllocateMemory(device.get_memory_allocator(), &requirements.memoryRequirements, &memory_info, &allocation, &allocation_info));
+
+	memory_size = requirements.memoryRequirements.size;
+
+	VkBindAccelerationStructureMemoryInfoKHR bind_info{VK_STRUCTURE_TYPE_BIND_ACCELERATION_STRUCTURE_MEMORY_INFO_KHR};
+	bind_info.accelerationStructure = handle;
+	bind_info.memory                = allocation_info.deviceMemory;
+	bind_info.memoryOffset          = allocation_info.offset;
+
+	VK_CHECK(vkBindAccelerationStructureMemoryKHR(device.get_handle(), 1, &bind_info));
+
+	VkAccelerationStructureDeviceAddressInfoKHR address_info{VK_STRUCTURE_TYPE_ACCELERATION_STRUCTURE_DEVICE_ADDRESS_INFO_KHR};
+	address_info.accelerationStructure = handle;
+
+	device_address = vkGetAccelerationStructureDeviceAddressKHR(device.get_handle(), &address_info);
+}
+
+VkAccelerationStructureKHR AccelerationStructure::get_handle() const
+{
+	return handle;
+}
+
+const VkAccelerationStructureKHR *AccelerationStructure::get() const
+{
+	return &handle;
+}
+
+VkAccelerationStructureTypeKHR AccelerationStructure::get_type() const
+{
+	return type;
+}
+
+VkBuildAccelerationStructureFlagsKHR AccelerationStructure::get_flags() const
+{
+	return flags;
+}
+
+uint64_t AccelerationStructure::get_device_address() const
+{
+	return device_address;
+}
+
+VkDeviceSize AccelerationStructure::get_memory_size() const
+{
+	return memory_size;
+}
+
+VkDeviceSize AccelerationStructure::get_scratch_size(bool update) const
+{
+	VkAccelerationStructureMemoryRequirementsInfoKHR requirements_info{VK_STRUCTURE_TYPE_ACCELERATION_STRUCTURE_MEMORY_REQUIREMENTS_INFO_KHR};
+	requirements_info.type                  = VK_ACCELERATION_STRUCTURE_MEMORY_REQUIREMENTS_TYPE_BUILD_SCRATCH_KHR;
+	requirements_info.buildType             = VK_ACCELERATION_STRUCTURE_BUILD_TYPE_DEVICE_KHR;
+	requirements_info.accelerationStructure = handle;
+
+	if (update)
+	{
+		requirements_info.type = VK_ACCELERATION_STRUCTURE_MEMORY_REQUIREMENTS_TYPE_UPDATE_SCRATCH_KHR;
+	}
+
+	VkMemoryRequirements2 requirements{VK_STRUCTURE_TYPE_MEMORY_REQUIREMENTS_2};
+	vkGetAccelerationStructureMemoryRequirementsKHR(device.get_handle(), &requirements_info, &requirements);
+
+	return requirements.memoryRequirements.size;
+}
+}        // namespace core
+}        // namespace vkb
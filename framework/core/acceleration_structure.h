@@ -0,0 +1,109 @@
+/* Copyright (c) 2020, Arm Limited and Contributors
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 the "License";
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <vector>
+
+#include "common/helpers.h"
+#include "common/vk_common.h"
+
+namespace vkb
+{
+class Device;
+
+namespace core
+{
+/**
+ * @brief A Vulkan ray tracing acceleration structure, with device local memory bound to it
+ */
+class AccelerationStructure
+{
+  public:
+	/**
+	 * @brief Creates an acceleration structure to be built from geometries
+	 * @param device The device to create the acceleration structure on
+	 * @param type Bottom level for geometries, top level for instances
+	 * @param flags Build flags, which the builds must match
+	 * @param geometry_infos Maximum sizes of each geometry of the builds
+	 */
+	AccelerationStructure(Device &                                                             device,
+	                      VkAccelerationStructureTypeKHR                                       type,
+	                      VkBuildAccelerationStructureFlagsKHR                                 flags,
+	                      const std::vector<VkAccelerationStructureCreateGeometryTypeInfoKHR> &geometry_infos);
+
+	/**
+	 * @brief Creates an acceleration structure to copy a compacted one to
+	 * @param compacted_size Size of the compacted acceleration structure, as queried after its build
+	 */
+	AccelerationStructure(Device &device, VkAccelerationStructureTypeKHR type, VkBuildAccelerationStructureFlagsKHR flags, VkDeviceSize compacted_size);
+
+	AccelerationStructure(const AccelerationStructure &) = delete;
+
+	AccelerationStructure(AccelerationStructure &&other);
+
+	~AccelerationStructure();
+
+	AccelerationStructure &operator=(const AccelerationStructure &) = delete;
+
+	AccelerationStructure &operator=(AccelerationStructure &&) = delete;
+
+	VkAccelerationStructureKHR get_handle() const;
+
+	const VkAccelerationStructureKHR *get() const;
+
+	VkAccelerationStructureTypeKHR get_type() const;
+
+	VkBuildAccelerationStructureFlagsKHR get_flags() const;
+
+	/**
+	 * @return The address instances refer to the acceleration structure with
+	 */
+	uint64_t get_device_address() const;
+
+	/**
+	 * @return The size of the memory bound to the acceleration structure
+	 */
+	VkDeviceSize get_memory_size() const;
+
+	/**
+	 * @return The size of the scratch memory of a build, or of an update if the flags allow updates
+	 */
+	VkDeviceSize get_scratch_size(bool update = false) const;
+
+  private:
+	/**
+	 * @brief Allocates and binds the memory of the acceleration structure, once created
+	 */
+	void bind_memory();
+
+	Device &device;
+
+	VkAccelerationStructureKHR handle{VK_NULL_HANDLE};
+
+	VkAccelerationStructureTypeKHR type;
+
+	VkBuildAccelerationStructureFlagsKHR flags;
+
+	VmaAllocation allocation{VK_NULL_HANDLE};
+
+	VkDeviceSize memory_size{0};
+
+	uint64_t device_address{0};
+};
+}        // namespace core
+}        // namespace vkb
@@ -17,37 +17,56 @@
 
 #include "buffer.h"
 
+#include <algorithm>
+
 #include "device.h"
+#include "memory_pools.h"
 
 namespace vkb
 {
 namespace core
 {
-Buffer::Buffer(Device &device, VkDeviceSize size, VkBufferUsageFlags buffer_usage, VmaMemoryUsage memory_usage, VmaAllocationCreateFlags flags) :
+Buffer::Buffer(Device &device, VkDeviceSize size, VkBufferUsageFlags buffer_usage, VmaMemoryUsage memory_usage, VmaAllocationCreateFlags flags,
+               const std::vector<uint32_t> &queue_families) :
     device{device},
-    size{size}
+    size{size},
+    usage{buffer_usage}
 {
+	// Host accessible memory stays mapped, VMA leaves the memory of device only buffers unmapped
+	if (memory_usage == VMA_MEMORY_USAGE_CPU_ONLY || memory_usage == VMA_MEMORY_USAGE_CPU_TO_GPU || memory_usage == VMA_MEMORY_USAGE_GPU_TO_CPU)
+	{
+		flags |= VMA_ALLOCATION_CREATE_MAPPED_BIT;
+	}
+
 #ifdef VK_USE_PLATFORM_MACOS_MVK
 	// Workaround for Mac (MoltenVK requires unmapping https://github.com/KhronosGroup/MoltenVK/issues/175)
 	// Force cleares the flag VMA_ALLOCATION_CREATE_MAPPED_BIT
 	flags &= ~VMA_ALLOCATION_CREATE_MAPPED_BIT;
 #endif
 
-	persistent = (flags & VMA_ALLOCATION_CREATE_MAPPED_BIT) != 0;
-
 	VkBufferCreateInfo buffer_info{VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO};
 	buffer_info.usage = buffer_usage;
 	buffer_info.size  = size;
 
+	std::vector<uint32_t> unique_families{queue_families};
+	std::sort(unique_families.begin(), unique_families.end());
+	unique_families.erase(std::unique(unique_families.begin(), unique_families.end()), unique_families.end());
+
+	if (unique_families.size() > 1)
+	{
+		buffer_info.sharingMode           = VK_SHARING_MODE_CONCURRENT;
+		buffer_info.queueFamilyIndexCount = to_u32(unique_families.size());
+		buffer_info.pQueueFamilyIndices   = unique_families.data();
+	}
+
 	VmaAllocationCreateInfo memory_info{};
 	memory_info.flags = flags;
 	memory_info.usage = memory_usage;
 
 	VmaAllocationInfo allocation_info{};
-	auto              result = vmaCreateBuffer(device.get_memory_allocator(),
-                                  &buffer_info, &memory_info,
-                                  &handle, &allocation,
-                                  &allocation_info);
+	auto              result = device.get_memory_pools().create_buffer(buffer_info, memory_info,
+                                                          handle, allocation,
+                                                          allocation_info);
 
 	if (result != VK_SUCCESS)
 	{
@@ -56,10 +75,14 @@ Buffer::Buffer(Device &device, VkDeviceSize size, VkBufferUsageFlags buffer_usag
 
 	memory = allocation_info.deviceMemory;
 
-	if (persistent)
-	{
-		mapped_data = static_cast<uint8_t *>(allocation_info.pMappedData);
-	}
+	// Only allocations which ended up in host visible memory are mapped
+	mapped_data = static_cast<uint8_t *>(allocation_info.pMappedData);
+	persistent  = mapped_data != nullptr;
+
+	VkMemoryPropertyFlags memory_properties{0};
+	vmaGetMemoryTypeProperties(device.get_memory_allocator(), allocation_info.memoryType, &memory_properties);
+
+	coherent = (memory_properties & VK_MEMORY_PROPERTY_HOST_COHERENT_BIT) != 0;
 }
 
 Buffer::Buffer(Buffer &&other) :
@@ -68,9 +91,18 @@ Buffer::Buffer(Buffer &&other) :
     allocation{other.allocation},
     memory{other.memory},
     size{other.size},
+    usage{other.usage},
     mapped_data{other.mapped_data},
-    mapped{other.mapped}
+    persistent{other.persistent},
+    mapped{other.mapped},
+    coherent{other.coherent}
 {
+	// Writes deferred for the moved buffer cannot be tracked by address anymore
+	if (!coherent)
+	{
+		device.flush_deferred(other);
+	}
+
 	// Reset other handles to avoid releasing on destruction
 	other.handle      = VK_NULL_HANDLE;
 	other.allocation  = VK_NULL_HANDLE;
@@ -83,6 +115,11 @@ Buffer::~Buffer()
 {
 	if (handle != VK_NULL_HANDLE && allocation != VK_NULL_HANDLE)
 	{
+		if (!coherent)
+		{
+			device.cancel_deferred_flush(*this);
+		}
+
 		unmap();
 		vmaDestroyBuffer(device.get_memory_allocator(), handle, allocation);
 	}
@@ -113,6 +150,11 @@ VkDeviceMemory Buffer::get_memory() const
 	return memory;
 }
 
+bool Buffer::is_coherent() const
+{
+	return coherent;
+}
+
 VkDeviceSize Buffer::get_size() const
 {
 	return size;
@@ -138,9 +180,36 @@ void Buffer::unmap()
 	}
 }
 
-void Buffer::flush() const
+void Buffer::flush(VkDeviceSize offset, VkDeviceSize flush_size) const
 {
-	vmaFlushAllocation(device.get_memory_allocator(), allocation, 0, size);
+	if (coherent)
+	{
+		return;
+	}
+
+	vmaFlushAllocation(device.get_memory_allocator(), allocation, offset, flush_size == VK_WHOLE_SIZE ? size - offset : flush_size);
+}
+
+void Buffer::rebind_memory()
+{
+	vkDestroyBuffer(device.get_handle(), handle, nullptr);
+
+	VkBufferCreateInfo buffer_info{VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO};
+	buffer_info.usage = usage;
+	buffer_info.size  = size;
+
+	VK_CHECK(vkCreateBuffer(device.get_handle(), &buffer_info, nullptr, &handle));
+	VK_CHECK(vmaBindBufferMemory(device.get_memory_allocator(), allocation, handle));
+
+	VmaAllocationInfo allocation_info{};
+	vmaGetAllocationInfo(device.get_memory_allocator(), allocation, &allocation_info);
+
+	memory = allocation_info.deviceMemory;
+
+	if (persistent)
+	{
+		mapped_data = static_cast<uint8_t *>(allocation_info.pMappedData);
+	}
 }
 
 void Buffer::update(const std::vector<uint8_t> &data, size_t offset)
@@ -158,13 +227,18 @@ void Buffer::update(const uint8_t *data, const size_t size, const size_t offset)
 	if (persistent)
 	{
 		std::copy(data, data + size, mapped_data + offset);
-		flush();
+
+		// Ranges written in a frame are merged and flushed once before the device reads them
+		if (!coherent)
+		{
+			device.defer_flush(*this, offset, size);
+		}
 	}
 	else
 	{
 		map();
 		std::copy(data, data + size, mapped_data + offset);
-		flush();
+		flush(offset, size);
 		unmap();
 	}
 }
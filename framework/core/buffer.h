@@ -30,18 +30,21 @@ class Buffer
 {
   public:
 	/**
-	 * @brief Creates a buffer using VMA
+	 * @brief Creates a buffer using VMA, host visible buffers are persistently mapped
 	 * @param device A valid Vulkan device
 	 * @param size The size in bytes of the buffer
 	 * @param buffer_usage The usage flags for the VkBuffer
 	 * @param memory_usage The memory usage of the buffer
 	 * @param flags The allocation create flags
+	 * @param queue_families Queue families sharing the buffer concurrently, without ownership transfers,
+	 *        the buffer is exclusive to a queue family at a time if there are less than two different ones
 	 */
-	Buffer(Device &                 device,
-	       VkDeviceSize             size,
-	       VkBufferUsageFlags       buffer_usage,
-	       VmaMemoryUsage           memory_usage,
-	       VmaAllocationCreateFlags flags = VMA_ALLOCATION_CREATE_MAPPED_BIT);
+	Buffer(Device &                     device,
+	       VkDeviceSize                 size,
+	       VkBufferUsageFlags           buffer_usage,
+	       VmaMemoryUsage               memory_usage,
+	       VmaAllocationCreateFlags     flags          = VMA_ALLOCATION_CREATE_MAPPED_BIT,
+	       const std::vector<uint32_t> &queue_families = {});
 
 	Buffer(const Buffer &) = delete;
 
@@ -65,8 +68,15 @@ class Buffer
 
 	/**
 	 * @brief Flushes memory if it is HOST_VISIBLE and not HOST_COHERENT
+	 * @param offset Offset of the range to flush
+	 * @param size Size of the range to flush, the whole buffer by default
 	 */
-	void flush() const;
+	void flush(VkDeviceSize offset = 0, VkDeviceSize size = VK_WHOLE_SIZE) const;
+
+	/**
+	 * @return Whether host writes are visible to the device without flushing
+	 */
+	bool is_coherent() const;
 
 	/**
 	 * @brief Maps vulkan memory if it isn't already mapped to an host visible address
@@ -90,7 +100,7 @@ class Buffer
 	}
 
 	/**
-	 * @brief Copies byte data into the buffer
+	 * @brief Copies byte data into the buffer, non coherent memory is flushed by the device at the next submission
 	 * @param data The data to copy from
 	 * @param size The amount of bytes to copy
 	 * @param offset The offset to start the copying into the mapped data
@@ -123,6 +133,11 @@ class Buffer
 		update(reinterpret_cast<const uint8_t *>(&object), sizeof(T), offset);
 	}
 
+	/**
+	 * @brief Recreates the buffer handle bound to its allocation after defragmentation moved it
+	 */
+	void rebind_memory();
+
   private:
 	Device &device;
 
@@ -134,6 +149,8 @@ class Buffer
 
 	VkDeviceSize size{0};
 
+	VkBufferUsageFlags usage{0};
+
 	uint8_t *mapped_data{nullptr};
 
 	/// Whether the buffer is persistently mapped or not
@@ -141,6 +158,9 @@ class Buffer
 
 	/// Whether the buffer has been mapped with vmaMapMemory
 	bool mapped{false};
+
+	/// Whether the memory of the buffer is HOST_COHERENT
+	bool coherent{false};
 };
 }        // namespace core
 }        // namespace vkb
@@ -17,14 +17,119 @@
 
 #include "command_buffer.h"
 
+#include <mutex>
+#include <set>
+#include <tuple>
+
 #include "command_pool.h"
 #include "common/error.h"
 #include "device.h"
+#include "image_compression.h"
 #include "rendering/render_frame.h"
 #include "rendering/subpass.h"
 
 namespace vkb
 {
+namespace
+{
+/// Accesses which later accesses have to wait for and see
+constexpr VkAccessFlags WRITE_ACCESS_MASK = VK_ACCESS_SHADER_WRITE_BIT | VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT | VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT |
+                                            VK_ACCESS_TRANSFER_WRITE_BIT | VK_ACCESS_HOST_WRITE_BIT | VK_ACCESS_MEMORY_WRITE_BIT;
+
+bool is_stencil_op_changed(const StencilOpState &lhs, const StencilOpState &rhs)
+{
+	return std::tie(lhs.fail_op, lhs.pass_op, lhs.depth_fail_op, lhs.compare_op) != std::tie(rhs.fail_op, rhs.pass_op, rhs.depth_fail_op, rhs.compare_op);
+}
+
+/**
+ * @brief Barriers of depth images cover their depth and stencil aspects, whatever the aspects of their views
+ */
+VkImageAspectFlags get_barrier_aspect_mask(VkFormat format, VkImageAspectFlags aspect_mask)
+{
+	if (is_depth_only_format(format))
+	{
+		return VK_IMAGE_ASPECT_DEPTH_BIT;
+	}
+	else if (is_depth_stencil_format(format))
+	{
+		return VK_IMAGE_ASPECT_DEPTH_BIT | VK_IMAGE_ASPECT_STENCIL_BIT;
+	}
+
+	return aspect_mask;
+}
+
+#ifdef VKB_VERIFY_CACHE_KEYS
+/**
+ * @brief Compares the resources a cached descriptor set was written from with the resources of a resource set
+ */
+bool equal_resource_bindings(const std::vector<ResourceBinding> &lhs, const ResourceSet::ResourceBindings &rhs)
+{
+	return std::equal(lhs.begin(), lhs.end(), rhs.begin(), rhs.end(), [](const ResourceBinding &lhs_binding, const ResourceBinding &rhs_binding) {
+		auto &lhs_info = lhs_binding.info;
+		auto &rhs_info = rhs_binding.info;
+
+		return lhs_binding.binding == rhs_binding.binding && lhs_binding.array_element == rhs_binding.array_element &&
+		       lhs_info.buffer == rhs_info.buffer && lhs_info.offset == rhs_info.offset && lhs_info.range == rhs_info.range &&
+		       lhs_info.image_view == rhs_info.image_view && lhs_info.sampler == rhs_info.sampler &&
+		       lhs_info.acceleration_structure == rhs_info.acceleration_structure;
+	});
+}
+#endif
+
+#ifdef VKB_DEBUG
+/**
+ * @brief Warns once about each combination of stage masks which makes a barrier wait for or block every command,
+ *        as the pipeline_barriers sample shows the cost of
+ */
+void warn_broad_stage_masks(VkPipelineStageFlags src_stage_mask, VkPipelineStageFlags dst_stage_mask)
+{
+	constexpr VkPipelineStageFlags broad_stages = VK_PIPELINE_STAGE_ALL_COMMANDS_BIT | VK_PIPELINE_STAGE_ALL_GRAPHICS_BIT;
+
+	if (!((src_stage_mask | dst_stage_mask) & broad_stages))
+	{
+		return;
+	}
+
+	static std::mutex                                                        warned_mutex;
+	static std::set<std::pair<VkPipelineStageFlags, VkPipelineStageFlags>> warned;
+
+	std::lock_guard<std::mutex> lock{warned_mutex};
+
+	if (warned.emplace(src_stage_mask, dst_stage_mask).second)
+	{
+		LOGW("Barrier from stages {:#x} to stages {:#x} waits for or blocks all commands, prefer the stages actually accessing the resource", src_stage_mask, dst_stage_mask);
+	}
+}
+#endif
+
+/**
+ * @brief Sets the tracked state of the subresources of an image accessed by a transfer command
+ */
+void track_transfer(const core::Image &image, const VkImageSubresourceLayers &layers, VkImageLayout layout, VkAccessFlags access_mask)
+{
+	VkImageSubresourceRange range{layers.aspectMask, layers.mipLevel, 1, layers.baseArrayLayer, layers.layerCount};
+
+	image.set_state(range, {layout, VK_PIPELINE_STAGE_TRANSFER_BIT, access_mask});
+}
+}        // namespace
+
+BindCounters &BindCounters::operator+=(const BindCounters &other)
+{
+	pipeline_binds += other.pipeline_binds;
+	pipeline_binds_saved += other.pipeline_binds_saved;
+	descriptor_set_binds += other.descriptor_set_binds;
+
+	return *this;
+}
+
+AttachmentTraffic &AttachmentTraffic::operator+=(const AttachmentTraffic &other)
+{
+	read_bytes += other.read_bytes;
+	write_bytes += other.write_bytes;
+
+	return *this;
+}
+
 CommandBuffer::CommandBuffer(CommandPool &command_pool, VkCommandBufferLevel level) :
     command_pool{command_pool},
     max_push_constants_size{command_pool.get_device().get_gpu().get_properties().limits.maxPushConstantsSize},
@@ -42,6 +147,9 @@ CommandBuffer::CommandBuffer(CommandPool &command_pool, VkCommandBufferLevel lev
 	{
 		throw VulkanException{result, "Failed to allocate command buffer"};
 	}
+
+	// Push constants are bounded by the device limit, so reserve it once instead of growing every recording
+	stored_push_constants.reserve(max_push_constants_size);
 }
 
 CommandBuffer::~CommandBuffer()
@@ -79,6 +187,16 @@ bool CommandBuffer::is_recording() const
 	return state == State::Recording;
 }
 
+const BindCounters &CommandBuffer::get_bind_counters() const
+{
+	return bind_counters;
+}
+
+const AttachmentTraffic &CommandBuffer::get_attachment_traffic() const
+{
+	return attachment_traffic;
+}
+
 void CommandBuffer::clear(VkClearAttachment attachment, VkClearRect rect)
 {
 	vkCmdClearAttachments(handle, 1, &attachment, 1, &rect);
@@ -97,27 +215,44 @@ VkResult CommandBuffer::begin(VkCommandBufferUsageFlags flags, CommandBuffer *pr
 
 	// Reset state
 	pipeline_state.reset();
-	resource_binding_state.reset();
-	descriptor_set_layout_binding_state.clear();
 	stored_push_constants.clear();
+	secondary_inheritance.render_pass = {};
 
-	VkCommandBufferBeginInfo       begin_info{VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO};
-	VkCommandBufferInheritanceInfo inheritance = {VK_STRUCTURE_TYPE_COMMAND_BUFFER_INHERITANCE_INFO};
-	begin_info.flags                           = flags;
+	bound_graphics_pipeline = VK_NULL_HANDLE;
+	bound_compute_pipeline  = VK_NULL_HANDLE;
+	bind_counters           = {};
+	attachment_traffic      = {};
+	pending_image_barriers.clear();
+	pending_buffer_barriers.clear();
+	pending_src_stage_mask = 0;
+	pending_dst_stage_mask = 0;
+	graphics_pipeline_cache.fill({});
+
+	pipeline_state.set_extended_dynamic_state(extended_dynamic_state);
+	extended_dynamic_state_set = false;
+
+	// Binding state of command buffers of a frame lives in the frame arena of the recording thread
+	auto render_frame = command_pool.get_render_frame();
+	reset_recording_state(render_frame ? &render_frame->get_memory_arena(command_pool.get_thread_index()) : nullptr);
+
+	VkCommandBufferBeginInfo begin_info{VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO};
+	begin_info.flags = flags;
 
 	if (level == VK_COMMAND_BUFFER_LEVEL_SECONDARY)
 	{
 		assert(primary_cmd_buf && "A primary command buffer pointer must be provided when calling begin from a secondary one");
 
-		auto render_pass_binding        = primary_cmd_buf->get_current_render_pass();
-		current_render_pass.render_pass = render_pass_binding.render_pass;
-		current_render_pass.framebuffer = render_pass_binding.framebuffer;
+		// The primary command buffer prepared the inheritance when its subpass began, it is only read here
+		const auto &inheritance = primary_cmd_buf->secondary_inheritance;
+		assert(inheritance.render_pass.render_pass && "Secondary command buffers only inherit render passes, not dynamic rendering");
+
+		current_render_pass = inheritance.render_pass;
 
-		inheritance.renderPass  = current_render_pass.render_pass->get_handle();
-		inheritance.framebuffer = current_render_pass.framebuffer->get_handle();
-		inheritance.subpass     = primary_cmd_buf->get_current_subpass_index();
+		begin_info.pInheritanceInfo = &inheritance.info;
 
-		begin_info.pInheritanceInfo = &inheritance;
+		// Pipelines recorded in the secondary command buffer are for the subpass of the primary one
+		pipeline_state = inheritance.pipeline_state;
+		pipeline_state.set_extended_dynamic_state(extended_dynamic_state);
 	}
 
 	return vkBeginCommandBuffer(get_handle(), &begin_info);
@@ -132,15 +267,28 @@ VkResult CommandBuffer::end()
 		return VK_NOT_READY;
 	}
 
+	flush_barriers();
+
 	vkEndCommandBuffer(get_handle());
 
 	state = State::Executable;
 
+	// The binding state is only needed while recording, command buffers replayed over several frames must not keep arena memory
+	reset_recording_state(nullptr);
+
+	if (auto render_frame = command_pool.get_render_frame())
+	{
+		render_frame->add_bind_counters(bind_counters, command_pool.get_thread_index());
+		render_frame->add_attachment_traffic(attachment_traffic, command_pool.get_thread_index());
+	}
+
 	return VK_SUCCESS;
 }
 
 void CommandBuffer::flush(VkPipelineBindPoint pipeline_bind_point)
 {
+	flush_barriers();
+
 	flush_pipeline_state(pipeline_bind_point);
 
 	flush_push_constants();
@@ -150,11 +298,6 @@ void CommandBuffer::flush(VkPipelineBindPoint pipeline_bind_point)
 
 void CommandBuffer::begin_render_pass(const RenderTarget &render_target, const std::vector<LoadStoreInfo> &load_store_infos, const std::vector<VkClearValue> &clear_values, const std::vector<std::unique_ptr<Subpass>> &subpasses, VkSubpassContents contents)
 {
-	// Reset state
-	pipeline_state.reset();
-	resource_binding_state.reset();
-	descriptor_set_layout_binding_state.clear();
-
 	// Create render pass
 	assert(subpasses.size() > 0 && "Cannot create a render pass without any subpass");
 	std::vector<SubpassInfo> subpass_infos(subpasses.size());
@@ -167,17 +310,35 @@ void CommandBuffer::begin_render_pass(const RenderTarget &render_target, const s
 		subpass_info_it->disable_depth_stencil_attachment = subpass->get_disable_depth_stencil_attachment();
 		subpass_info_it->depth_stencil_resolve_mode       = subpass->get_depth_stencil_resolve_mode();
 		subpass_info_it->depth_stencil_resolve_attachment = subpass->get_depth_stencil_resolve_attachment();
+		subpass_info_it->shading_rate_attachment          = subpass->get_shading_rate_attachment();
+		subpass_info_it->shading_rate_texel_size          = subpass->get_shading_rate_texel_size();
+		subpass_info_it->view_mask                        = subpass->get_view_mask();
 
 		++subpass_info_it;
 	}
+
+	begin_render_pass(render_target, load_store_infos, clear_values, subpass_infos, contents);
+}
+
+void CommandBuffer::begin_render_pass(const RenderTarget &render_target, const std::vector<LoadStoreInfo> &load_store_infos, const std::vector<VkClearValue> &clear_values, const std::vector<SubpassInfo> &subpass_infos, VkSubpassContents contents)
+{
+	// Reset state
+	pipeline_state.reset();
+	pipeline_state.set_extended_dynamic_state(extended_dynamic_state);
+	resource_binding_state.reset();
+	descriptor_set_layout_binding_state.clear();
+
+	flush_barriers();
+
 	current_render_pass.render_pass = &get_device().get_resource_cache().request_render_pass(render_target.get_attachments(), load_store_infos, subpass_infos);
 	current_render_pass.framebuffer = &get_device().get_resource_cache().request_framebuffer(render_target, *current_render_pass.render_pass);
+	current_render_pass.render_area = render_target.get_render_area();
 
 	// Begin render pass
 	VkRenderPassBeginInfo begin_info{VK_STRUCTURE_TYPE_RENDER_PASS_BEGIN_INFO};
 	begin_info.renderPass        = current_render_pass.render_pass->get_handle();
 	begin_info.framebuffer       = current_render_pass.framebuffer->get_handle();
-	begin_info.renderArea.extent = render_target.get_extent();
+	begin_info.renderArea.extent = render_target.get_render_area();
 	begin_info.clearValueCount   = to_u32(clear_values.size());
 	begin_info.pClearValues      = clear_values.data();
 
@@ -199,13 +360,23 @@ void CommandBuffer::begin_render_pass(const RenderTarget &render_target, const s
 
 	vkCmdBeginRenderPass(get_handle(), &begin_info, contents);
 
+	// Missing load store operations are zero initialized, which loads and stores
+	for (uint32_t i = 0; i < to_u32(render_target.get_attachments().size()); ++i)
+	{
+		add_attachment_traffic(render_target, i, i < load_store_infos.size() ? load_store_infos[i] : LoadStoreInfo{VK_ATTACHMENT_LOAD_OP_LOAD, VK_ATTACHMENT_STORE_OP_STORE});
+
+		track_attachment(render_target.get_views()[i], current_render_pass.render_pass->get_final_layouts()[i]);
+	}
+
 	// Update blend state attachments for first subpass
 	auto blend_state = pipeline_state.get_color_blend_state();
 	blend_state.attachments.resize(current_render_pass.render_pass->get_color_output_count(pipeline_state.get_subpass_index()));
 	pipeline_state.set_color_blend_state(blend_state);
+
+	update_secondary_inheritance();
 }
 
-void CommandBuffer::next_subpass()
+void CommandBuffer::next_subpass(VkSubpassContents contents)
 {
 	// Increment subpass index
 	pipeline_state.set_subpass_index(pipeline_state.get_subpass_index() + 1);
@@ -222,12 +393,152 @@ void CommandBuffer::next_subpass()
 	// Clear stored push constants
 	stored_push_constants.clear();
 
-	vkCmdNextSubpass(get_handle(), VK_SUBPASS_CONTENTS_INLINE);
+	vkCmdNextSubpass(get_handle(), contents);
+
+	update_secondary_inheritance();
+}
+
+void CommandBuffer::begin_rendering(const RenderTarget &render_target, const std::vector<LoadStoreInfo> &load_store_infos, const std::vector<VkClearValue> &clear_values, const SubpassInfo &subpass_info)
+{
+	assert(subpass_info.input_attachments.empty() && "Input attachments need a render pass");
+
+	// Reset state
+	pipeline_state.reset();
+	pipeline_state.set_extended_dynamic_state(extended_dynamic_state);
+	resource_binding_state.reset();
+	descriptor_set_layout_binding_state.clear();
+
+	flush_barriers();
+
+	current_render_pass.render_pass = nullptr;
+	current_render_pass.framebuffer = nullptr;
+	current_render_pass.render_area = render_target.get_render_area();
+
+	secondary_inheritance.render_pass = {};
+
+	auto &attachments = render_target.get_attachments();
+	auto &views       = render_target.get_views();
+
+	auto get_attachment_info = [&](uint32_t index, VkImageLayout default_layout) {
+		VkRenderingAttachmentInfoKHR attachment_info{VK_STRUCTURE_TYPE_RENDERING_ATTACHMENT_INFO_KHR};
+		attachment_info.imageView   = views[index].get_handle();
+		attachment_info.imageLayout = attachments[index].initial_layout == VK_IMAGE_LAYOUT_UNDEFINED ? default_layout : attachments[index].initial_layout;
+
+		if (index < load_store_infos.size())
+		{
+			attachment_info.loadOp  = load_store_infos[index].load_op;
+			attachment_info.storeOp = load_store_infos[index].store_op;
+		}
+
+		add_attachment_traffic(render_target, index, {attachment_info.loadOp, attachment_info.storeOp});
+
+		track_attachment(views[index], attachment_info.imageLayout);
+
+		if (index < clear_values.size())
+		{
+			attachment_info.clearValue = clear_values[index];
+		}
+
+		return attachment_info;
+	};
+
+	RenderingState rendering_state;
+
+	std::vector<VkRenderingAttachmentInfoKHR> color_attachments;
+
+	for (auto o_attachment : subpass_info.output_attachments)
+	{
+		if (!is_depth_stencil_format(attachments[o_attachment].format))
+		{
+			color_attachments.push_back(get_attachment_info(o_attachment, VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL));
+			rendering_state.color_attachment_formats.push_back(attachments[o_attachment].format);
+		}
+	}
+
+	// Resolve attachments match the color attachments in order, as in a render pass
+	for (size_t i = 0; i < subpass_info.color_resolve_attachments.size() && i < color_attachments.size(); ++i)
+	{
+		auto r_attachment = subpass_info.color_resolve_attachments[i];
+
+		color_attachments[i].resolveMode        = VK_RESOLVE_MODE_AVERAGE_BIT_KHR;
+		color_attachments[i].resolveImageView   = views[r_attachment].get_handle();
+		color_attachments[i].resolveImageLayout = attachments[r_attachment].initial_layout == VK_IMAGE_LAYOUT_UNDEFINED ? VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL : attachments[r_attachment].initial_layout;
+
+		// Resolves always write their image
+		add_attachment_traffic(render_target, r_attachment, {VK_ATTACHMENT_LOAD_OP_DONT_CARE, VK_ATTACHMENT_STORE_OP_STORE});
+
+		track_attachment(views[r_attachment], color_attachments[i].resolveImageLayout);
+	}
+
+	VkRenderingAttachmentInfoKHR depth_stencil_attachment{VK_STRUCTURE_TYPE_RENDERING_ATTACHMENT_INFO_KHR};
+
+	bool has_depth   = false;
+	bool has_stencil = false;
+
+	if (!subpass_info.disable_depth_stencil_attachment)
+	{
+		// The first depth stencil attachment is used, as in a render pass
+		auto it = std::find_if(attachments.begin(), attachments.end(), [](const Attachment &attachment) { return is_depth_stencil_format(attachment.format); });
+
+		if (it != attachments.end())
+		{
+			auto i_depth_stencil = to_u32(std::distance(attachments.begin(), it));
+
+			depth_stencil_attachment = get_attachment_info(i_depth_stencil, VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL);
+
+			if (subpass_info.depth_stencil_resolve_mode != VK_RESOLVE_MODE_NONE)
+			{
+				auto i_resolve = subpass_info.depth_stencil_resolve_attachment;
+
+				depth_stencil_attachment.resolveMode        = subpass_info.depth_stencil_resolve_mode;
+				depth_stencil_attachment.resolveImageView   = views[i_resolve].get_handle();
+				depth_stencil_attachment.resolveImageLayout = attachments[i_resolve].initial_layout == VK_IMAGE_LAYOUT_UNDEFINED ? VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL : attachments[i_resolve].initial_layout;
+
+				add_attachment_traffic(render_target, i_resolve, {VK_ATTACHMENT_LOAD_OP_DONT_CARE, VK_ATTACHMENT_STORE_OP_STORE});
+
+				track_attachment(views[i_resolve], depth_stencil_attachment.resolveImageLayout);
+			}
+
+			has_depth   = true;
+			has_stencil = !is_depth_only_format(it->format);
+
+			rendering_state.depth_attachment_format   = it->format;
+			rendering_state.stencil_attachment_format = has_stencil ? it->format : VK_FORMAT_UNDEFINED;
+		}
+	}
+
+	VkRenderingInfoKHR rendering_info{VK_STRUCTURE_TYPE_RENDERING_INFO_KHR};
+	rendering_info.renderArea.extent    = render_target.get_render_area();
+	rendering_info.layerCount           = 1;
+	rendering_info.colorAttachmentCount = to_u32(color_attachments.size());
+	rendering_info.pColorAttachments    = color_attachments.empty() ? nullptr : color_attachments.data();
+	rendering_info.pDepthAttachment     = has_depth ? &depth_stencil_attachment : nullptr;
+	rendering_info.pStencilAttachment   = has_stencil ? &depth_stencil_attachment : nullptr;
+	rendering_info.viewMask             = subpass_info.view_mask;
+
+	rendering_state.view_mask = subpass_info.view_mask;
+
+	vkCmdBeginRenderingKHR(get_handle(), &rendering_info);
+
+	dynamic_rendering_active = true;
+
+	pipeline_state.set_rendering_state(rendering_state);
+
+	// Update blend state attachments
+	auto blend_state = pipeline_state.get_color_blend_state();
+	blend_state.attachments.resize(color_attachments.size());
+	pipeline_state.set_color_blend_state(blend_state);
 }
 
 void CommandBuffer::execute_commands(CommandBuffer &secondary_command_buffer)
 {
+	flush_barriers();
+
 	vkCmdExecuteCommands(get_handle(), 1, &secondary_command_buffer.get_handle());
+
+	bound_graphics_pipeline    = VK_NULL_HANDLE;
+	bound_compute_pipeline     = VK_NULL_HANDLE;
+	extended_dynamic_state_set = false;
 }
 
 void CommandBuffer::execute_commands(std::vector<CommandBuffer *> &secondary_command_buffers)
@@ -235,12 +546,28 @@ void CommandBuffer::execute_commands(std::vector<CommandBuffer *> &secondary_com
 	std::vector<VkCommandBuffer> sec_cmd_buf_handles(secondary_command_buffers.size(), VK_NULL_HANDLE);
 	std::transform(secondary_command_buffers.begin(), secondary_command_buffers.end(), sec_cmd_buf_handles.begin(),
 	               [](const vkb::CommandBuffer *sec_cmd_buf) { return sec_cmd_buf->get_handle(); });
+
+	flush_barriers();
+
 	vkCmdExecuteCommands(get_handle(), to_u32(sec_cmd_buf_handles.size()), sec_cmd_buf_handles.data());
+
+	bound_graphics_pipeline    = VK_NULL_HANDLE;
+	bound_compute_pipeline     = VK_NULL_HANDLE;
+	extended_dynamic_state_set = false;
 }
 
 void CommandBuffer::end_render_pass()
 {
-	vkCmdEndRenderPass(get_handle());
+	if (dynamic_rendering_active)
+	{
+		vkCmdEndRenderingKHR(get_handle());
+
+		dynamic_rendering_active = false;
+	}
+	else
+	{
+		vkCmdEndRenderPass(get_handle());
+	}
 }
 
 void CommandBuffer::bind_pipeline_layout(PipelineLayout &pipeline_layout)
@@ -255,16 +582,21 @@ void CommandBuffer::set_specialization_constant(uint32_t constant_id, const std:
 
 void CommandBuffer::push_constants(const std::vector<uint8_t> &values)
 {
-	uint32_t push_constant_size = to_u32(stored_push_constants.size() + values.size());
+	push_constants(values.data(), values.size());
+}
+
+void CommandBuffer::push_constants(const uint8_t *values, size_t size)
+{
+	uint32_t push_constant_size = to_u32(stored_push_constants.size() + size);
 
 	if (push_constant_size > max_push_constants_size)
 	{
-		LOGE("Push constant limit of {} exceeded (pushing {} bytes for a total of {} bytes)", max_push_constants_size, values.size(), push_constant_size);
+		LOGE("Push constant limit of {} exceeded (pushing {} bytes for a total of {} bytes)", max_push_constants_size, size, push_constant_size);
 		throw std::runtime_error("Push constant limit exceeded.");
 	}
 	else
 	{
-		stored_push_constants.insert(stored_push_constants.end(), values.begin(), values.end());
+		stored_push_constants.insert(stored_push_constants.end(), values, values + size);
 	}
 }
 
@@ -278,6 +610,16 @@ void CommandBuffer::bind_image(const core::ImageView &image_view, const core::Sa
 	resource_binding_state.bind_image(image_view, sampler, set, binding, array_element);
 }
 
+void CommandBuffer::bind_image(const core::ImageView &image_view, uint32_t set, uint32_t binding, uint32_t array_element)
+{
+	resource_binding_state.bind_input(image_view, set, binding, array_element);
+}
+
+void CommandBuffer::bind_acceleration_structure(const core::AccelerationStructure &acceleration_structure, uint32_t set, uint32_t binding, uint32_t array_element)
+{
+	resource_binding_state.bind_acceleration_structure(acceleration_structure, set, binding, array_element);
+}
+
 void CommandBuffer::bind_input(const core::ImageView &image_view, uint32_t set, uint32_t binding, uint32_t array_element)
 {
 	resource_binding_state.bind_input(image_view, set, binding, array_element);
@@ -311,6 +653,13 @@ void CommandBuffer::set_input_assembly_state(const InputAssemblyState &state_inf
 	pipeline_state.set_input_assembly_state(state_info);
 }
 
+void CommandBuffer::set_extended_dynamic_state(bool enable)
+{
+	extended_dynamic_state = enable && get_device().is_enabled(VK_EXT_EXTENDED_DYNAMIC_STATE_EXTENSION_NAME);
+
+	pipeline_state.set_extended_dynamic_state(extended_dynamic_state);
+}
+
 void CommandBuffer::set_rasterization_state(const RasterizationState &state_info)
 {
 	pipeline_state.set_rasterization_state(state_info);
@@ -331,6 +680,31 @@ void CommandBuffer::set_color_blend_state(const ColorBlendState &state_info)
 	pipeline_state.set_color_blend_state(state_info);
 }
 
+void CommandBuffer::set_fragment_shading_rate_state(const FragmentShadingRateState &state_info)
+{
+	if (!get_device().is_enabled(VK_KHR_FRAGMENT_SHADING_RATE_EXTENSION_NAME))
+	{
+		return;
+	}
+
+	pipeline_state.set_fragment_shading_rate_state(state_info);
+
+	if (secondary_inheritance.render_pass.render_pass)
+	{
+		secondary_inheritance.pipeline_state.set_fragment_shading_rate_state(state_info);
+	}
+}
+
+void CommandBuffer::set_subgroup_size_state(const SubgroupSizeState &state_info)
+{
+	if (!get_device().is_enabled(VK_EXT_SUBGROUP_SIZE_CONTROL_EXTENSION_NAME))
+	{
+		return;
+	}
+
+	pipeline_state.set_subgroup_size_state(state_info);
+}
+
 void CommandBuffer::set_viewport(uint32_t first_viewport, const std::vector<VkViewport> &viewports)
 {
 	vkCmdSetViewport(get_handle(), first_viewport, to_u32(viewports.size()), viewports.data());
@@ -382,6 +756,20 @@ void CommandBuffer::draw_indexed_indirect(const core::Buffer &buffer, VkDeviceSi
 	vkCmdDrawIndexedIndirect(get_handle(), buffer.get_handle(), offset, draw_count, stride);
 }
 
+void CommandBuffer::draw_indexed_indirect_count(const core::Buffer &buffer, VkDeviceSize offset, const core::Buffer &count_buffer, VkDeviceSize count_offset, uint32_t max_draw_count, uint32_t stride)
+{
+	flush(VK_PIPELINE_BIND_POINT_GRAPHICS);
+
+	vkCmdDrawIndexedIndirectCountKHR(get_handle(), buffer.get_handle(), offset, count_buffer.get_handle(), count_offset, max_draw_count, stride);
+}
+
+void CommandBuffer::draw_mesh_tasks(uint32_t task_count, uint32_t first_task)
+{
+	flush(VK_PIPELINE_BIND_POINT_GRAPHICS);
+
+	vkCmdDrawMeshTasksNV(get_handle(), task_count, first_task);
+}
+
 void CommandBuffer::dispatch(uint32_t group_count_x, uint32_t group_count_y, uint32_t group_count_z)
 {
 	flush(VK_PIPELINE_BIND_POINT_COMPUTE);
@@ -398,25 +786,45 @@ void CommandBuffer::dispatch_indirect(const core::Buffer &buffer, VkDeviceSize o
 
 void CommandBuffer::update_buffer(const core::Buffer &buffer, VkDeviceSize offset, const std::vector<uint8_t> &data)
 {
+	flush_barriers();
+
 	vkCmdUpdateBuffer(get_handle(), buffer.get_handle(), offset, data.size(), data.data());
 }
 
-void CommandBuffer::blit_image(const core::Image &src_img, const core::Image &dst_img, const std::vector<VkImageBlit> &regions)
+void CommandBuffer::blit_image(const core::Image &src_img, const core::Image &dst_img, const std::vector<VkImageBlit> &regions, VkFilter filter)
 {
+	flush_barriers();
+
 	vkCmdBlitImage(get_handle(), src_img.get_handle(), VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL,
 	               dst_img.get_handle(), VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
-	               to_u32(regions.size()), regions.data(), VK_FILTER_NEAREST);
+	               to_u32(regions.size()), regions.data(), filter);
+
+	for (auto &region : regions)
+	{
+		track_transfer(src_img, region.srcSubresource, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, VK_ACCESS_TRANSFER_READ_BIT);
+		track_transfer(dst_img, region.dstSubresource, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, VK_ACCESS_TRANSFER_WRITE_BIT);
+	}
 }
 
 void CommandBuffer::resolve_image(const core::Image &src_img, const core::Image &dst_img, const std::vector<VkImageResolve> &regions)
 {
+	flush_barriers();
+
 	vkCmdResolveImage(get_handle(), src_img.get_handle(), VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL,
 	                  dst_img.get_handle(), VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
 	                  to_u32(regions.size()), regions.data());
+
+	for (auto &region : regions)
+	{
+		track_transfer(src_img, region.srcSubresource, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, VK_ACCESS_TRANSFER_READ_BIT);
+		track_transfer(dst_img, region.dstSubresource, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, VK_ACCESS_TRANSFER_WRITE_BIT);
+	}
 }
 
 void CommandBuffer::copy_buffer(const core::Buffer &src_buffer, const core::Buffer &dst_buffer, VkDeviceSize size)
 {
+	flush_barriers();
+
 	VkBufferCopy copy_region = {};
 	copy_region.size         = size;
 	vkCmdCopyBuffer(get_handle(), src_buffer.get_handle(), dst_buffer.get_handle(), 1, &copy_region);
@@ -424,108 +832,391 @@ void CommandBuffer::copy_buffer(const core::Buffer &src_buffer, const core::Buff
 
 void CommandBuffer::copy_image(const core::Image &src_img, const core::Image &dst_img, const std::vector<VkImageCopy> &regions)
 {
+	flush_barriers();
+
 	vkCmdCopyImage(get_handle(), src_img.get_handle(), VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL,
 	               dst_img.get_handle(), VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
 	               to_u32(regions.size()), regions.data());
+
+	for (auto &region : regions)
+	{
+		track_transfer(src_img, region.srcSubresource, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, VK_ACCESS_TRANSFER_READ_BIT);
+		track_transfer(dst_img, region.dstSubresource, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, VK_ACCESS_TRANSFER_WRITE_BIT);
+	}
 }
 
 void CommandBuffer::copy_buffer_to_image(const core::Buffer &buffer, const core::Image &image, const std::vector<VkBufferImageCopy> &regions)
 {
+	flush_barriers();
+
 	vkCmdCopyBufferToImage(get_handle(), buffer.get_handle(),
 	                       image.get_handle(), VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
 	                       to_u32(regions.size()), regions.data());
-}
 
-void CommandBuffer::image_memory_barrier(const core::ImageView &image_view, const ImageMemoryBarrier &memory_barrier)
-{
-	// Adjust barrier's subresource range for depth images
-	auto subresource_range = image_view.get_subresource_range();
-	auto format            = image_view.get_format();
-	if (is_depth_only_format(format))
+	for (auto &region : regions)
 	{
-		subresource_range.aspectMask = VK_IMAGE_ASPECT_DEPTH_BIT;
-	}
-	else if (is_depth_stencil_format(format))
-	{
-		subresource_range.aspectMask = VK_IMAGE_ASPECT_DEPTH_BIT | VK_IMAGE_ASPECT_STENCIL_BIT;
+		track_transfer(image, region.imageSubresource, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, VK_ACCESS_TRANSFER_WRITE_BIT);
 	}
+}
 
-	VkImageMemoryBarrier image_memory_barrier{VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER};
-	image_memory_barrier.oldLayout        = memory_barrier.old_layout;
-	image_memory_barrier.newLayout        = memory_barrier.new_layout;
-	image_memory_barrier.image            = image_view.get_image().get_handle();
-	image_memory_barrier.subresourceRange = subresource_range;
-	image_memory_barrier.srcAccessMask    = memory_barrier.src_access_mask;
-	image_memory_barrier.dstAccessMask    = memory_barrier.dst_access_mask;
+void CommandBuffer::copy_image_to_buffer(const core::Image &image, const core::Buffer &buffer, const std::vector<VkBufferImageCopy> &regions)
+{
+	flush_barriers();
 
-	VkPipelineStageFlags src_stage_mask = memory_barrier.src_stage_mask;
-	VkPipelineStageFlags dst_stage_mask = memory_barrier.dst_stage_mask;
+	vkCmdCopyImageToBuffer(get_handle(), image.get_handle(), VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL,
+	                       buffer.get_handle(),
+	                       to_u32(regions.size()), regions.data());
 
-	vkCmdPipelineBarrier(
-	    get_handle(),
-	    src_stage_mask,
-	    dst_stage_mask,
-	    0,
-	    0, nullptr,
-	    0, nullptr,
-	    1,
-	    &image_memory_barrier);
+	for (auto &region : regions)
+	{
+		track_transfer(image, region.imageSubresource, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, VK_ACCESS_TRANSFER_READ_BIT);
+	}
 }
 
-void CommandBuffer::buffer_memory_barrier(const core::Buffer &buffer, VkDeviceSize offset, VkDeviceSize size, const BufferMemoryBarrier &memory_barrier)
+void CommandBuffer::image_memory_barrier(const core::ImageView &image_view, const ImageMemoryBarrier &memory_barrier)
 {
-	VkBufferMemoryBarrier buffer_memory_barrier{VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER};
-	buffer_memory_barrier.srcAccessMask = memory_barrier.src_access_mask;
-	buffer_memory_barrier.dstAccessMask = memory_barrier.dst_access_mask;
-	buffer_memory_barrier.buffer        = buffer.get_handle();
-	buffer_memory_barrier.offset        = offset;
-	buffer_memory_barrier.size          = size;
+	flush_image_barriers(image_view.get_image().get_handle());
 
-	VkPipelineStageFlags src_stage_mask = memory_barrier.src_stage_mask;
-	VkPipelineStageFlags dst_stage_mask = memory_barrier.dst_stage_mask;
+#ifdef VKB_DEBUG
+	warn_broad_stage_masks(memory_barrier.src_stage_mask, memory_barrier.dst_stage_mask);
+#endif
 
-	vkCmdPipelineBarrier(
-	    get_handle(),
-	    src_stage_mask,
-	    dst_stage_mask,
-	    0,
-	    0, nullptr,
-	    1, &buffer_memory_barrier,
-	    0, nullptr);
+	// Adjust barrier's subresource range for depth images
+	auto subresource_range       = image_view.get_subresource_range();
+	subresource_range.aspectMask = get_barrier_aspect_mask(image_view.get_format(), subresource_range.aspectMask);
+
+	VkImageMemoryBarrier image_memory_barrier{VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER};
+	image_memory_barrier.oldLayout           = memory_barrier.old_layout;
+	image_memory_barrier.newLayout           = memory_barrier.new_layout;
+	image_memory_barrier.image               = image_view.get_image().get_handle();
+	image_memory_barrier.subresourceRange    = subresource_range;
+	image_memory_barrier.srcAccessMask       = memory_barrier.src_access_mask;
+	image_memory_barrier.dstAccessMask       = memory_barrier.dst_access_mask;
+	image_memory_barrier.srcQueueFamilyIndex = memory_barrier.old_queue_family;
+	image_memory_barrier.dstQueueFamilyIndex = memory_barrier.new_queue_family;
+
+	add_pending_barrier(image_memory_barrier, memory_barrier.src_stage_mask, memory_barrier.dst_stage_mask);
+
+	image_view.get_image().set_state(subresource_range, {memory_barrier.new_layout, memory_barrier.dst_stage_mask, memory_barrier.dst_access_mask});
 }
 
-void CommandBuffer::flush_pipeline_state(VkPipelineBindPoint pipeline_bind_point)
+void CommandBuffer::require_layout(const core::Image &image, VkImageSubresourceRange range, VkImageLayout layout, VkPipelineStageFlags stage_mask, VkAccessFlags access_mask, bool discard_contents)
 {
-	// Create a new pipeline only if the graphics state changed
-	if (!pipeline_state.is_dirty())
-	{
-		return;
-	}
+	auto subresource = image.get_subresource();
 
-	pipeline_state.clear_dirty();
+	range.aspectMask = get_barrier_aspect_mask(image.get_format(), range.aspectMask);
+	range.levelCount = range.levelCount == VK_REMAINING_MIP_LEVELS ? subresource.mipLevel - range.baseMipLevel : range.levelCount;
+	range.layerCount = range.layerCount == VK_REMAINING_ARRAY_LAYERS ? subresource.arrayLayer - range.baseArrayLayer : range.layerCount;
 
-	// Create and bind pipeline
-	if (pipeline_bind_point == VK_PIPELINE_BIND_POINT_GRAPHICS)
+	flush_image_barriers(image.get_handle());
+
+	bool write = (access_mask & WRITE_ACCESS_MASK) != 0;
+
+	for (uint32_t layer = range.baseArrayLayer; layer < range.baseArrayLayer + range.layerCount; ++layer)
 	{
-		pipeline_state.set_render_pass(*current_render_pass.render_pass);
-		auto &pipeline = get_device().get_resource_cache().request_graphics_pipeline(pipeline_state);
+		for (uint32_t level = range.baseMipLevel; level < range.baseMipLevel + range.levelCount; ++level)
+		{
+			auto state = image.get_state(level, layer);
 
-		vkCmdBindPipeline(get_handle(),
-		                  pipeline_bind_point,
-		                  pipeline.get_handle());
+			VkImageSubresourceRange subresource_range{range.aspectMask, level, 1, layer, 1};
+
+			// Reads of data already visible to their stages and types in the same layout
+			bool visible = (state.access_mask & WRITE_ACCESS_MASK) == 0 &&
+			               (stage_mask & ~state.stage_mask) == 0 && (access_mask & ~state.access_mask) == 0;
+
+			if (state.layout == layout && !write && visible)
+			{
+				continue;
+			}
+
+			VkImageMemoryBarrier barrier{VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER};
+			barrier.oldLayout           = discard_contents ? VK_IMAGE_LAYOUT_UNDEFINED : state.layout;
+			barrier.newLayout           = layout;
+			barrier.image               = image.get_handle();
+			barrier.subresourceRange    = subresource_range;
+			barrier.srcAccessMask       = state.access_mask & WRITE_ACCESS_MASK;
+			barrier.dstAccessMask       = access_mask;
+			barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+			barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+
+			add_pending_barrier(barrier, state.stage_mask != 0 ? state.stage_mask : VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, stage_mask);
+
+			// Other reads in the layout keep seeing the data if there was no write to wait for
+			if (state.layout == layout && !write && (state.access_mask & WRITE_ACCESS_MASK) == 0)
+			{
+				image.set_state(subresource_range, {layout, state.stage_mask | stage_mask, state.access_mask | access_mask});
+			}
+			else
+			{
+				image.set_state(subresource_range, {layout, stage_mask, access_mask});
+			}
+		}
+	}
+}
+
+void CommandBuffer::require_layout(const core::ImageView &image_view, VkImageLayout layout, VkPipelineStageFlags stage_mask, VkAccessFlags access_mask, bool discard_contents)
+{
+	require_layout(image_view.get_image(), image_view.get_subresource_range(), layout, stage_mask, access_mask, discard_contents);
+}
+
+void CommandBuffer::flush_barriers()
+{
+	if (pending_image_barriers.empty() && pending_buffer_barriers.empty())
+	{
+		return;
+	}
+
+	vkCmdPipelineBarrier(
+	    get_handle(),
+	    pending_src_stage_mask,
+	    pending_dst_stage_mask,
+	    0,
+	    0, nullptr,
+	    to_u32(pending_buffer_barriers.size()),
+	    pending_buffer_barriers.empty() ? nullptr : pending_buffer_barriers.data(),
+	    to_u32(pending_image_barriers.size()),
+	    pending_image_barriers.empty() ? nullptr : pending_image_barriers.data());
+
+	pending_image_barriers.clear();
+	pending_buffer_barriers.clear();
+	pending_src_stage_mask = 0;
+	pending_dst_stage_mask = 0;
+}
+
+void CommandBuffer::flush_image_barriers(VkImage image)
+{
+	// Barriers of a single vkCmdPipelineBarrier are unordered, so a barrier pending for the image is recorded first
+	auto it = std::find_if(pending_image_barriers.begin(), pending_image_barriers.end(), [image](const VkImageMemoryBarrier &barrier) {
+		return barrier.image == image;
+	});
+
+	if (it != pending_image_barriers.end())
+	{
+		flush_barriers();
+	}
+}
+
+void CommandBuffer::flush_buffer_barriers(VkBuffer buffer)
+{
+	auto it = std::find_if(pending_buffer_barriers.begin(), pending_buffer_barriers.end(), [buffer](const VkBufferMemoryBarrier &barrier) {
+		return barrier.buffer == buffer;
+	});
+
+	if (it != pending_buffer_barriers.end())
+	{
+		flush_barriers();
+	}
+}
+
+void CommandBuffer::add_pending_barrier(const VkImageMemoryBarrier &barrier, VkPipelineStageFlags src_stage_mask, VkPipelineStageFlags dst_stage_mask)
+{
+	pending_src_stage_mask |= src_stage_mask;
+	pending_dst_stage_mask |= dst_stage_mask;
+
+	if (!pending_image_barriers.empty())
+	{
+		auto &last = pending_image_barriers.back();
+
+		auto &range      = barrier.subresourceRange;
+		auto &last_range = last.subresourceRange;
+
+		// Subresources of a layer which were in the same state share a barrier
+		if (last.image == barrier.image && last.oldLayout == barrier.oldLayout && last.newLayout == barrier.newLayout &&
+		    last.srcAccessMask == barrier.srcAccessMask && last.dstAccessMask == barrier.dstAccessMask &&
+		    last_range.aspectMask == range.aspectMask && last_range.baseArrayLayer == range.baseArrayLayer && last_range.layerCount == range.layerCount &&
+		    last_range.baseMipLevel + last_range.levelCount == range.baseMipLevel)
+		{
+			last_range.levelCount += range.levelCount;
+			return;
+		}
+
+		// Layers whose mip levels were all in the same state share a barrier too
+		if (last.image == barrier.image && last.oldLayout == barrier.oldLayout && last.newLayout == barrier.newLayout &&
+		    last.srcAccessMask == barrier.srcAccessMask && last.dstAccessMask == barrier.dstAccessMask &&
+		    last_range.aspectMask == range.aspectMask && last_range.baseMipLevel == range.baseMipLevel && last_range.levelCount == range.levelCount &&
+		    last_range.baseArrayLayer + last_range.layerCount == range.baseArrayLayer)
+		{
+			last_range.layerCount += range.layerCount;
+			return;
+		}
+	}
+
+	pending_image_barriers.push_back(barrier);
+}
+
+void CommandBuffer::track_attachment(const core::ImageView &image_view, VkImageLayout layout)
+{
+	auto range       = image_view.get_subresource_range();
+	range.aspectMask = get_barrier_aspect_mask(image_view.get_format(), range.aspectMask);
+
+	if (is_depth_stencil_format(image_view.get_format()))
+	{
+		image_view.get_image().set_state(range, {layout, VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT | VK_PIPELINE_STAGE_LATE_FRAGMENT_TESTS_BIT, VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT});
+	}
+	else
+	{
+		image_view.get_image().set_state(range, {layout, VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT, VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT});
+	}
+}
+
+void CommandBuffer::buffer_memory_barrier(const core::Buffer &buffer, VkDeviceSize offset, VkDeviceSize size, const BufferMemoryBarrier &memory_barrier)
+{
+	flush_buffer_barriers(buffer.get_handle());
+
+#ifdef VKB_DEBUG
+	warn_broad_stage_masks(memory_barrier.src_stage_mask, memory_barrier.dst_stage_mask);
+#endif
+
+	VkBufferMemoryBarrier buffer_memory_barrier{VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER};
+	buffer_memory_barrier.srcAccessMask = memory_barrier.src_access_mask;
+	buffer_memory_barrier.dstAccessMask = memory_barrier.dst_access_mask;
+	buffer_memory_barrier.buffer        = buffer.get_handle();
+	buffer_memory_barrier.offset        = offset;
+	buffer_memory_barrier.size          = size;
+
+	buffer_memory_barrier.srcQueueFamilyIndex = memory_barrier.old_queue_family;
+	buffer_memory_barrier.dstQueueFamilyIndex = memory_barrier.new_queue_family;
+
+	pending_buffer_barriers.push_back(buffer_memory_barrier);
+
+	pending_src_stage_mask |= memory_barrier.src_stage_mask;
+	pending_dst_stage_mask |= memory_barrier.dst_stage_mask;
+}
+
+void CommandBuffer::flush_pipeline_state(VkPipelineBindPoint pipeline_bind_point)
+{
+	VkPipeline bound_handle = pipeline_bind_point == VK_PIPELINE_BIND_POINT_COMPUTE ? bound_compute_pipeline : bound_graphics_pipeline;
+
+	// Create a new pipeline only if the state changed, or if the bound pipeline is unknown, as after raw recording
+	if (!pipeline_state.is_dirty() && bound_handle != VK_NULL_HANDLE)
+	{
+		return;
+	}
+
+	pipeline_state.clear_dirty();
+
+	// Create and bind pipeline
+	VkPipeline *bound_pipeline;
+	VkPipeline  pipeline_handle;
+
+	if (pipeline_bind_point == VK_PIPELINE_BIND_POINT_GRAPHICS)
+	{
+		// Dynamic rendering sets the attachment formats in the state instead
+		if (current_render_pass.render_pass)
+		{
+			pipeline_state.set_render_pass(*current_render_pass.render_pass);
+		}
+
+		// States seen before in the recording skip the resource cache lookup
+		size_t hash         = pipeline_state.get_hash();
+		auto & cached_entry = graphics_pipeline_cache[hash & (GRAPHICS_PIPELINE_CACHE_SIZE - 1)];
+
+		if (!cached_entry.pipeline || cached_entry.hash != hash)
+		{
+			cached_entry.hash     = hash;
+			cached_entry.pipeline = &get_device().get_resource_cache().request_graphics_pipeline(pipeline_state);
+		}
+
+		bound_pipeline  = &bound_graphics_pipeline;
+		pipeline_handle = cached_entry.pipeline->get_handle();
 	}
 	else if (pipeline_bind_point == VK_PIPELINE_BIND_POINT_COMPUTE)
 	{
 		auto &pipeline = get_device().get_resource_cache().request_compute_pipeline(pipeline_state);
 
-		vkCmdBindPipeline(get_handle(),
-		                  pipeline_bind_point,
-		                  pipeline.get_handle());
+		bound_pipeline  = &bound_compute_pipeline;
+		pipeline_handle = pipeline.get_handle();
 	}
 	else
 	{
 		throw "Only graphics and compute pipeline bind points are supported now";
 	}
+
+	// State set back and forth between draws often resolves to the pipeline already bound
+	if (*bound_pipeline == pipeline_handle)
+	{
+		bind_counters.pipeline_binds_saved++;
+	}
+	else
+	{
+		vkCmdBindPipeline(get_handle(),
+		                  pipeline_bind_point,
+		                  pipeline_handle);
+
+		*bound_pipeline = pipeline_handle;
+		bind_counters.pipeline_binds++;
+
+		// A pipeline with static state overwrites the dynamic state set before
+		if (pipeline_bind_point == VK_PIPELINE_BIND_POINT_GRAPHICS && !pipeline_state.has_extended_dynamic_state())
+		{
+			extended_dynamic_state_set = false;
+		}
+	}
+
+	if (pipeline_bind_point == VK_PIPELINE_BIND_POINT_GRAPHICS && pipeline_state.has_extended_dynamic_state())
+	{
+		flush_extended_dynamic_state();
+	}
+}
+
+void CommandBuffer::flush_extended_dynamic_state()
+{
+	const auto &rasterization_state = pipeline_state.get_rasterization_state();
+	const auto &depth_stencil_state = pipeline_state.get_depth_stencil_state();
+
+	// Only the values which changed since they were last set are recorded
+	bool set_all = !extended_dynamic_state_set;
+
+	if (set_all || rasterization_state.cull_mode != dynamic_rasterization_state.cull_mode)
+	{
+		vkCmdSetCullModeEXT(get_handle(), rasterization_state.cull_mode);
+	}
+
+	if (set_all || rasterization_state.front_face != dynamic_rasterization_state.front_face)
+	{
+		vkCmdSetFrontFaceEXT(get_handle(), rasterization_state.front_face);
+	}
+
+	if (set_all || depth_stencil_state.depth_test_enable != dynamic_depth_stencil_state.depth_test_enable)
+	{
+		vkCmdSetDepthTestEnableEXT(get_handle(), depth_stencil_state.depth_test_enable);
+	}
+
+	if (set_all || depth_stencil_state.depth_write_enable != dynamic_depth_stencil_state.depth_write_enable)
+	{
+		vkCmdSetDepthWriteEnableEXT(get_handle(), depth_stencil_state.depth_write_enable);
+	}
+
+	if (set_all || depth_stencil_state.depth_compare_op != dynamic_depth_stencil_state.depth_compare_op)
+	{
+		vkCmdSetDepthCompareOpEXT(get_handle(), depth_stencil_state.depth_compare_op);
+	}
+
+	if (set_all || depth_stencil_state.depth_bounds_test_enable != dynamic_depth_stencil_state.depth_bounds_test_enable)
+	{
+		vkCmdSetDepthBoundsTestEnableEXT(get_handle(), depth_stencil_state.depth_bounds_test_enable);
+	}
+
+	if (set_all || depth_stencil_state.stencil_test_enable != dynamic_depth_stencil_state.stencil_test_enable)
+	{
+		vkCmdSetStencilTestEnableEXT(get_handle(), depth_stencil_state.stencil_test_enable);
+	}
+
+	if (set_all || is_stencil_op_changed(depth_stencil_state.front, dynamic_depth_stencil_state.front))
+	{
+		const auto &front = depth_stencil_state.front;
+		vkCmdSetStencilOpEXT(get_handle(), VK_STENCIL_FACE_FRONT_BIT, front.fail_op, front.pass_op, front.depth_fail_op, front.compare_op);
+	}
+
+	if (set_all || is_stencil_op_changed(depth_stencil_state.back, dynamic_depth_stencil_state.back))
+	{
+		const auto &back = depth_stencil_state.back;
+		vkCmdSetStencilOpEXT(get_handle(), VK_STENCIL_FACE_BACK_BIT, back.fail_op, back.pass_op, back.depth_fail_op, back.compare_op);
+	}
+
+	dynamic_rasterization_state = rasterization_state;
+	dynamic_depth_stencil_state = depth_stencil_state;
+	extended_dynamic_state_set  = true;
 }
 
 void CommandBuffer::flush_descriptor_state(VkPipelineBindPoint pipeline_bind_point)
@@ -597,19 +1288,59 @@ void CommandBuffer::flush_descriptor_state(VkPipelineBindPoint pipeline_bind_poi
 			// Make descriptor set layout bound for current set
 			descriptor_set_layout_binding_state[descriptor_set_id] = &descriptor_set_layout;
 
-			BindingMap<VkDescriptorBufferInfo> buffer_infos;
-			BindingMap<VkDescriptorImageInfo>  image_infos;
+			// Descriptor sets already built by this recording are found from the incremental hash of the resource set,
+			// without rebuilding and hashing binding maps. Update after bind sets are skipped since the caller updates them
+			size_t descriptor_set_key{resource_set.get_hash()};
+			hash_combine(descriptor_set_key, descriptor_set_id);
+			hash_combine(descriptor_set_key, &descriptor_set_layout);
+
+			if (!update_after_bind && !descriptor_set_layout.is_push_descriptor())
+			{
+				auto cached_it = descriptor_set_cache.find(descriptor_set_key);
+
+				if (cached_it != descriptor_set_cache.end())
+				{
+					auto &cached_descriptor_set = cached_it->second;
+
+#ifdef VKB_VERIFY_CACHE_KEYS
+					if (cached_descriptor_set.set_index != descriptor_set_id || cached_descriptor_set.layout != &descriptor_set_layout ||
+					    !equal_resource_bindings(cached_descriptor_set.resource_bindings, resource_set.get_resource_bindings()))
+					{
+						throw std::runtime_error{"Hash collision of cached descriptor set of set " + std::to_string(descriptor_set_id)};
+					}
+#endif
+
+					vkCmdBindDescriptorSets(get_handle(),
+					                        pipeline_bind_point,
+					                        pipeline_layout.get_handle(),
+					                        descriptor_set_id,
+					                        1, &cached_descriptor_set.handle,
+					                        cached_descriptor_set.dynamic_offset_count,
+					                        descriptor_set_cache_dynamic_offsets.data() + cached_descriptor_set.first_dynamic_offset);
+
+					bind_counters.descriptor_set_binds++;
+					continue;
+				}
+			}
+
+			BindingMap<VkDescriptorBufferInfo>     buffer_infos;
+			BindingMap<VkDescriptorImageInfo>      image_infos;
+			BindingMap<VkAccelerationStructureKHR> acceleration_structure_infos;
 
 			std::vector<uint32_t> dynamic_offsets;
 
 			// The bindings we want to update before binding, if empty we update all bindings
 			std::vector<uint32_t> bindings_to_update;
 
-			// Iterate over all resource bindings
-			for (auto &binding_it : resource_set.get_resource_bindings())
+			auto &resource_bindings = resource_set.get_resource_bindings();
+
+			// Iterate over all resource bindings, the array elements of a binding are contiguous
+			for (auto binding_it = resource_bindings.begin(); binding_it != resource_bindings.end();)
 			{
-				auto  binding_index     = binding_it.first;
-				auto &binding_resources = binding_it.second;
+				auto binding_index = binding_it->binding;
+
+				auto binding_end = std::find_if(binding_it, resource_bindings.end(),
+				                                [binding_index](const ResourceBinding &resource_binding) { return resource_binding.binding != binding_index; });
 
 				// Check if binding exists in the pipeline layout
 				if (auto binding_info = descriptor_set_layout.get_layout_binding(binding_index))
@@ -621,18 +1352,25 @@ void CommandBuffer::flush_descriptor_state(VkPipelineBindPoint pipeline_bind_poi
 					}
 
 					// Iterate over all binding resources
-					for (auto &element_it : binding_resources)
+					for (auto element_it = binding_it; element_it != binding_end; ++element_it)
 					{
-						auto  array_element = element_it.first;
-						auto &resource_info = element_it.second;
+						auto  array_element = element_it->array_element;
+						auto &resource_info = element_it->info;
 
 						// Pointer references
-						auto &buffer     = resource_info.buffer;
-						auto &sampler    = resource_info.sampler;
-						auto &image_view = resource_info.image_view;
+						auto &buffer                 = resource_info.buffer;
+						auto &sampler                = resource_info.sampler;
+						auto &image_view             = resource_info.image_view;
+						auto &acceleration_structure = resource_info.acceleration_structure;
+
+						// Get acceleration structure
+						if (acceleration_structure != nullptr && binding_info->descriptorType == VK_DESCRIPTOR_TYPE_ACCELERATION_STRUCTURE_KHR)
+						{
+							acceleration_structure_infos[binding_index][array_element] = acceleration_structure->get_handle();
+						}
 
 						// Get buffer info
-						if (buffer != nullptr && is_buffer_descriptor_type(binding_info->descriptorType))
+						else if (buffer != nullptr && is_buffer_descriptor_type(binding_info->descriptorType))
 						{
 							VkDescriptorBufferInfo buffer_info{};
 
@@ -689,14 +1427,40 @@ void CommandBuffer::flush_descriptor_state(VkPipelineBindPoint pipeline_bind_poi
 						}
 					}
 				}
+
+				binding_it = binding_end;
+			}
+
+			// Push descriptors are written into the command buffer, without a descriptor set to allocate or cache
+			if (descriptor_set_layout.is_push_descriptor())
+			{
+				push_descriptor_set(pipeline_bind_point, descriptor_set_layout, buffer_infos, image_infos, acceleration_structure_infos);
+				continue;
 			}
 
 			// Request a descriptor set from the render frame, and write the buffer infos and image infos of all the specified bindings
-			auto &descriptor_set = command_pool.get_render_frame()->request_descriptor_set(descriptor_set_layout, buffer_infos, image_infos, command_pool.get_thread_index());
+			auto &descriptor_set = command_pool.get_render_frame()->request_descriptor_set(descriptor_set_layout, buffer_infos, image_infos, acceleration_structure_infos, command_pool.get_thread_index());
 			descriptor_set.update(bindings_to_update);
 
 			VkDescriptorSet descriptor_set_handle = descriptor_set.get_handle();
 
+			if (!update_after_bind)
+			{
+				CachedDescriptorSet cached_descriptor_set;
+				cached_descriptor_set.handle               = descriptor_set_handle;
+				cached_descriptor_set.first_dynamic_offset = to_u32(descriptor_set_cache_dynamic_offsets.size());
+				cached_descriptor_set.dynamic_offset_count = to_u32(dynamic_offsets.size());
+
+#ifdef VKB_VERIFY_CACHE_KEYS
+				cached_descriptor_set.set_index = descriptor_set_id;
+				cached_descriptor_set.layout    = &descriptor_set_layout;
+				cached_descriptor_set.resource_bindings.assign(resource_bindings.begin(), resource_bindings.end());
+#endif
+
+				descriptor_set_cache_dynamic_offsets.insert(descriptor_set_cache_dynamic_offsets.end(), dynamic_offsets.begin(), dynamic_offsets.end());
+				descriptor_set_cache.emplace(descriptor_set_key, cached_descriptor_set);
+			}
+
 			// Bind descriptor set
 			vkCmdBindDescriptorSets(get_handle(),
 			                        pipeline_bind_point,
@@ -705,10 +1469,92 @@ void CommandBuffer::flush_descriptor_state(VkPipelineBindPoint pipeline_bind_poi
 			                        1, &descriptor_set_handle,
 			                        to_u32(dynamic_offsets.size()),
 			                        dynamic_offsets.data());
+
+			bind_counters.descriptor_set_binds++;
 		}
 	}
 }
 
+void CommandBuffer::push_descriptor_set(VkPipelineBindPoint pipeline_bind_point, const DescriptorSetLayout &descriptor_set_layout, const BindingMap<VkDescriptorBufferInfo> &buffer_infos, const BindingMap<VkDescriptorImageInfo> &image_infos,
+                                        const BindingMap<VkAccelerationStructureKHR> &acceleration_structure_infos)
+{
+	std::vector<VkWriteDescriptorSet> writes;
+
+	for (auto &binding_it : buffer_infos)
+	{
+		auto binding_info = descriptor_set_layout.get_layout_binding(binding_it.first);
+
+		for (auto &element_it : binding_it.second)
+		{
+			VkWriteDescriptorSet write{VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET};
+			write.dstBinding      = binding_it.first;
+			write.dstArrayElement = element_it.first;
+			write.descriptorCount = 1;
+			write.descriptorType  = binding_info->descriptorType;
+			write.pBufferInfo     = &element_it.second;
+
+			writes.push_back(write);
+		}
+	}
+
+	for (auto &binding_it : image_infos)
+	{
+		auto binding_info = descriptor_set_layout.get_layout_binding(binding_it.first);
+
+		for (auto &element_it : binding_it.second)
+		{
+			VkWriteDescriptorSet write{VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET};
+			write.dstBinding      = binding_it.first;
+			write.dstArrayElement = element_it.first;
+			write.descriptorCount = 1;
+			write.descriptorType  = binding_info->descriptorType;
+			write.pImageInfo      = &element_it.second;
+
+			writes.push_back(write);
+		}
+	}
+
+	// The acceleration structure writes are chained to the descriptor writes, their storage must not move
+	std::vector<VkWriteDescriptorSetAccelerationStructureKHR> acceleration_structure_writes;
+	for (auto &binding_it : acceleration_structure_infos)
+	{
+		acceleration_structure_writes.resize(acceleration_structure_writes.size() + binding_it.second.size());
+	}
+
+	auto acceleration_structure_write = acceleration_structure_writes.begin();
+
+	for (auto &binding_it : acceleration_structure_infos)
+	{
+		auto binding_info = descriptor_set_layout.get_layout_binding(binding_it.first);
+
+		for (auto &element_it : binding_it.second)
+		{
+			acceleration_structure_write->sType                      = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET_ACCELERATION_STRUCTURE_KHR;
+			acceleration_structure_write->accelerationStructureCount = 1;
+			acceleration_structure_write->pAccelerationStructures    = &element_it.second;
+
+			VkWriteDescriptorSet write{VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET};
+			write.pNext           = &*acceleration_structure_write;
+			write.dstBinding      = binding_it.first;
+			write.dstArrayElement = element_it.first;
+			write.descriptorCount = 1;
+			write.descriptorType  = binding_info->descriptorType;
+
+			writes.push_back(write);
+			++acceleration_structure_write;
+		}
+	}
+
+	vkCmdPushDescriptorSetKHR(get_handle(),
+	                          pipeline_bind_point,
+	                          pipeline_state.get_pipeline_layout().get_handle(),
+	                          descriptor_set_layout.get_index(),
+	                          to_u32(writes.size()),
+	                          writes.data());
+
+	bind_counters.descriptor_set_binds++;
+}
+
 void CommandBuffer::flush_push_constants()
 {
 	if (stored_push_constants.empty())
@@ -742,16 +1588,76 @@ void CommandBuffer::set_update_after_bind(bool update_after_bind_)
 	update_after_bind = update_after_bind_;
 }
 
+void CommandBuffer::update_secondary_inheritance()
+{
+	secondary_inheritance.render_pass = current_render_pass;
+
+	secondary_inheritance.info.renderPass  = current_render_pass.render_pass->get_handle();
+	secondary_inheritance.info.framebuffer = current_render_pass.framebuffer->get_handle();
+	secondary_inheritance.info.subpass     = pipeline_state.get_subpass_index();
+
+	// Only the subpass dependent part of the state is inherited, the rest starts from the defaults
+	auto &inherited_state = secondary_inheritance.pipeline_state;
+	inherited_state.reset();
+	inherited_state.set_subpass_index(secondary_inheritance.info.subpass);
+	inherited_state.set_fragment_shading_rate_state(pipeline_state.get_fragment_shading_rate_state());
+
+	ColorBlendState blend_state{};
+	blend_state.attachments.resize(current_render_pass.render_pass->get_color_output_count(secondary_inheritance.info.subpass));
+	inherited_state.set_color_blend_state(blend_state);
+}
+
 const CommandBuffer::RenderPassBinding &CommandBuffer::get_current_render_pass() const
 {
 	return current_render_pass;
 }
 
+const PipelineState &CommandBuffer::get_pipeline_state() const
+{
+	return pipeline_state;
+}
+
 const uint32_t CommandBuffer::get_current_subpass_index() const
 {
 	return pipeline_state.get_subpass_index();
 }
 
+uint32_t CommandBuffer::get_queue_family_index() const
+{
+	return command_pool.get_queue_family_index();
+}
+
+CommandBuffer::ResetMode CommandBuffer::get_reset_mode() const
+{
+	return command_pool.get_reset_mode();
+}
+
+void CommandBuffer::add_attachment_traffic(const RenderTarget &render_target, uint32_t attachment, const LoadStoreInfo &load_store)
+{
+	auto &description = render_target.get_attachments()[attachment];
+	auto &image       = render_target.get_views()[attachment].get_image();
+	auto &area        = render_target.get_render_area();
+
+	auto bytes = static_cast<uint64_t>(area.width) * area.height * description.samples * std::max(get_bits_per_pixel(description.format), 0) / 8;
+
+	// Storage usage prevents AFBC, as the afbc sample relies on to disable it
+	auto &gpu = get_device().get_gpu();
+	if (is_framebuffer_compressed(gpu, description.format, image.get_usage(), image.get_tiling()))
+	{
+		bytes = static_cast<uint64_t>(bytes * get_framebuffer_compression(gpu)->compression_ratio);
+	}
+
+	if (load_store.load_op == VK_ATTACHMENT_LOAD_OP_LOAD)
+	{
+		attachment_traffic.read_bytes += bytes;
+	}
+
+	if (load_store.store_op == VK_ATTACHMENT_STORE_OP_STORE)
+	{
+		attachment_traffic.write_bytes += bytes;
+	}
+}
+
 const bool CommandBuffer::is_render_size_optimal(const VkExtent2D &framebuffer_extent, const VkRect2D &render_area)
 {
 	auto render_area_granularity = current_render_pass.render_pass->get_render_area_granularity();
@@ -763,25 +1669,174 @@ const bool CommandBuffer::is_render_size_optimal(const VkExtent2D &framebuffer_e
 
 void CommandBuffer::reset_query_pool(const QueryPool &query_pool, uint32_t first_query, uint32_t query_count)
 {
+	flush_barriers();
+
 	vkCmdResetQueryPool(get_handle(), query_pool.get_handle(), first_query, query_count);
 }
 
 void CommandBuffer::begin_query(const QueryPool &query_pool, uint32_t query, VkQueryControlFlags flags)
 {
+	flush_barriers();
+
 	vkCmdBeginQuery(get_handle(), query_pool.get_handle(), query, flags);
 }
 
 void CommandBuffer::end_query(const QueryPool &query_pool, uint32_t query)
 {
+	flush_barriers();
+
 	vkCmdEndQuery(get_handle(), query_pool.get_handle(), query);
 }
 
 void CommandBuffer::write_timestamp(VkPipelineStageFlagBits pipeline_stage,
                                     const QueryPool &query_pool, uint32_t query)
 {
+	flush_barriers();
+
 	vkCmdWriteTimestamp(get_handle(), pipeline_stage, query_pool.get_handle(), query);
 }
 
+void CommandBuffer::copy_query_pool_results(const QueryPool &query_pool, uint32_t first_query, uint32_t query_count,
+                                            const core::Buffer &buffer, VkDeviceSize offset, VkDeviceSize stride, VkQueryResultFlags flags)
+{
+	flush_barriers();
+
+	vkCmdCopyQueryPoolResults(get_handle(), query_pool.get_handle(), first_query, query_count,
+	                          buffer.get_handle(), offset, stride, flags);
+}
+
+#ifdef VKB_DEBUG_MARKERS
+void CommandBuffer::begin_debug_label(const char *name)
+{
+	if (!get_device().is_debug_utils_enabled())
+	{
+		return;
+	}
+
+	VkDebugUtilsLabelEXT label_info{VK_STRUCTURE_TYPE_DEBUG_UTILS_LABEL_EXT};
+	label_info.pLabelName = name;
+
+	vkCmdBeginDebugUtilsLabelEXT(get_handle(), &label_info);
+}
+
+void CommandBuffer::end_debug_label()
+{
+	if (get_device().is_debug_utils_enabled())
+	{
+		vkCmdEndDebugUtilsLabelEXT(get_handle());
+	}
+}
+#endif
+
+CommandBuffer::DebugLabelScope::DebugLabelScope(CommandBuffer &command_buffer, const std::string &name, bool enabled) :
+    command_buffer{enabled ? &command_buffer : nullptr}
+{
+	if (this->command_buffer)
+	{
+		this->command_buffer->begin_debug_label(name.c_str());
+	}
+}
+
+CommandBuffer::DebugLabelScope::~DebugLabelScope()
+{
+	if (command_buffer)
+	{
+		command_buffer->end_debug_label();
+	}
+}
+
+CommandBuffer::RawRecording::RawRecording(CommandBuffer &command_buffer) :
+    command_buffer{command_buffer},
+    handle{command_buffer.get_handle()}
+{
+	command_buffer.flush_barriers();
+}
+
+CommandBuffer::RawRecording::~RawRecording()
+{
+	// The tracked state no longer describes what is bound
+	if (graphics_pipeline_bound)
+	{
+		command_buffer.bound_graphics_pipeline    = VK_NULL_HANDLE;
+		command_buffer.extended_dynamic_state_set = false;
+	}
+
+	if (compute_pipeline_bound)
+	{
+		command_buffer.bound_compute_pipeline = VK_NULL_HANDLE;
+	}
+
+	if (descriptor_sets_bound)
+	{
+		command_buffer.resource_binding_state.reset();
+		command_buffer.descriptor_set_layout_binding_state.clear();
+	}
+}
+
+void CommandBuffer::RawRecording::bind_pipeline(const GraphicsPipeline &pipeline)
+{
+	vkCmdBindPipeline(handle, VK_PIPELINE_BIND_POINT_GRAPHICS, pipeline.get_handle());
+
+	graphics_pipeline_bound = true;
+	command_buffer.bind_counters.pipeline_binds++;
+}
+
+void CommandBuffer::RawRecording::bind_pipeline(const ComputePipeline &pipeline)
+{
+	vkCmdBindPipeline(handle, VK_PIPELINE_BIND_POINT_COMPUTE, pipeline.get_handle());
+
+	compute_pipeline_bound = true;
+	command_buffer.bind_counters.pipeline_binds++;
+}
+
+void CommandBuffer::RawRecording::bind_descriptor_set(VkPipelineBindPoint pipeline_bind_point, const PipelineLayout &pipeline_layout, uint32_t set, const DescriptorSet &descriptor_set,
+                                                      uint32_t dynamic_offset_count, const uint32_t *dynamic_offsets)
+{
+	VkDescriptorSet descriptor_set_handle = descriptor_set.get_handle();
+
+	vkCmdBindDescriptorSets(handle, pipeline_bind_point, pipeline_layout.get_handle(), set, 1, &descriptor_set_handle, dynamic_offset_count, dynamic_offsets);
+
+	descriptor_sets_bound = true;
+	command_buffer.bind_counters.descriptor_set_binds++;
+}
+
+void CommandBuffer::RawRecording::push_constants(const PipelineLayout &pipeline_layout, VkShaderStageFlags stages, uint32_t offset, uint32_t size, const void *values)
+{
+	vkCmdPushConstants(handle, pipeline_layout.get_handle(), stages, offset, size, values);
+}
+
+void CommandBuffer::RawRecording::bind_vertex_buffer(uint32_t binding, const core::Buffer &buffer, VkDeviceSize offset)
+{
+	VkBuffer buffer_handle = buffer.get_handle();
+
+	vkCmdBindVertexBuffers(handle, binding, 1, &buffer_handle, &offset);
+}
+
+void CommandBuffer::RawRecording::bind_index_buffer(const core::Buffer &buffer, VkDeviceSize offset, VkIndexType index_type)
+{
+	vkCmdBindIndexBuffer(handle, buffer.get_handle(), offset, index_type);
+}
+
+void CommandBuffer::RawRecording::draw(uint32_t vertex_count, uint32_t instance_count, uint32_t first_vertex, uint32_t first_instance)
+{
+	vkCmdDraw(handle, vertex_count, instance_count, first_vertex, first_instance);
+}
+
+void CommandBuffer::RawRecording::draw_indexed(uint32_t index_count, uint32_t instance_count, uint32_t first_index, int32_t vertex_offset, uint32_t first_instance)
+{
+	vkCmdDrawIndexed(handle, index_count, instance_count, first_index, vertex_offset, first_instance);
+}
+
+void CommandBuffer::RawRecording::draw_indexed_indirect(const core::Buffer &buffer, VkDeviceSize offset, uint32_t draw_count, uint32_t stride)
+{
+	vkCmdDrawIndexedIndirect(handle, buffer.get_handle(), offset, draw_count, stride);
+}
+
+void CommandBuffer::RawRecording::dispatch(uint32_t group_count_x, uint32_t group_count_y, uint32_t group_count_z)
+{
+	vkCmdDispatch(handle, group_count_x, group_count_y, group_count_z);
+}
+
 VkResult CommandBuffer::reset(ResetMode reset_mode)
 {
 	VkResult result = VK_SUCCESS;
@@ -790,6 +1845,9 @@ VkResult CommandBuffer::reset(ResetMode reset_mode)
 
 	state = State::Initial;
 
+	// Release the arena allocations before the render frame resets its arena
+	reset_recording_state(nullptr);
+
 	if (reset_mode == ResetMode::ResetIndividually)
 	{
 		result = vkResetCommandBuffer(handle, VK_COMMAND_BUFFER_RESET_RELEASE_RESOURCES_BIT);
@@ -797,4 +1855,13 @@ VkResult CommandBuffer::reset(ResetMode reset_mode)
 
 	return result;
 }
+
+void CommandBuffer::reset_recording_state(MemoryArena *arena)
+{
+	// Move assignment propagates the allocator, the previous containers are destroyed while their arena memory is still valid
+	resource_binding_state              = ResourceBindingState{arena};
+	descriptor_set_layout_binding_state = DescriptorSetLayoutBindingState{ArenaAllocator<std::pair<const uint32_t, DescriptorSetLayout *>>{arena}};
+	descriptor_set_cache                 = DescriptorSetCache{ArenaAllocator<std::pair<const size_t, CachedDescriptorSet>>{arena}};
+	descriptor_set_cache_dynamic_offsets = std::vector<uint32_t, ArenaAllocator<uint32_t>>{ArenaAllocator<uint32_t>{arena}};
+}
 }        // namespace vkb
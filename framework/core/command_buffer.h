@@ -17,6 +17,7 @@
 
 #pragma once
 
+#include <array>
 #include <list>
 
 #include "common/helpers.h"
@@ -26,20 +27,62 @@
 #include "core/image_view.h"
 #include "core/query_pool.h"
 #include "core/sampler.h"
+#include "memory_arena.h"
 #include "rendering/pipeline_state.h"
 #include "rendering/render_target.h"
 #include "resource_binding_state.h"
 
+// Debug labels are compiled out unless building with VKB_DEBUG_MARKERS, the arguments are not even evaluated
+#ifdef VKB_DEBUG_MARKERS
+#	define DEBUG_LABEL_CONCATENATE_IMPL(a, b) a##b
+#	define DEBUG_LABEL_CONCATENATE(a, b) DEBUG_LABEL_CONCATENATE_IMPL(a, b)
+#	define DEBUG_LABEL_SCOPE(command_buffer, ...) ::vkb::CommandBuffer::DebugLabelScope DEBUG_LABEL_CONCATENATE(debug_label_scope_, __LINE__){command_buffer, __VA_ARGS__}
+#else
+#	define DEBUG_LABEL_SCOPE(command_buffer, ...)
+#endif
+
 namespace vkb
 {
 class CommandPool;
+class ComputePipeline;
 class DescriptorSet;
+class DescriptorSetLayout;
 class Framebuffer;
+class GraphicsPipeline;
 class Pipeline;
 class PipelineLayout;
 class PipelineState;
 class RenderTarget;
 class Subpass;
+struct SubpassInfo;
+
+/**
+ * @brief Numbers of state binds recorded in command buffers
+ */
+struct BindCounters
+{
+	uint64_t pipeline_binds{0};
+
+	/// Pipeline state changes which resolved to the bound pipeline, so no bind was recorded
+	uint64_t pipeline_binds_saved{0};
+
+	uint64_t descriptor_set_binds{0};
+
+	BindCounters &operator+=(const BindCounters &other);
+};
+
+/**
+ * @brief Bytes of external memory the attachments of render passes are estimated to read and write,
+ *        from their extent, samples, format, load store operations and likely compression
+ */
+struct AttachmentTraffic
+{
+	uint64_t read_bytes{0};
+
+	uint64_t write_bytes{0};
+
+	AttachmentTraffic &operator+=(const AttachmentTraffic &other);
+};
 
 /**
  * @brief Helper class to manage and record a command buffer, building and
@@ -71,6 +114,8 @@ class CommandBuffer
 		const RenderPass *render_pass;
 
 		const Framebuffer *framebuffer;
+
+		VkExtent2D render_area;
 	};
 
 	CommandBuffer(CommandPool &command_pool, VkCommandBufferLevel level);
@@ -91,6 +136,16 @@ class CommandBuffer
 
 	bool is_recording() const;
 
+	/**
+	 * @return The binds recorded since the command buffer began recording
+	 */
+	const BindCounters &get_bind_counters() const;
+
+	/**
+	 * @return The attachment traffic of the render passes begun since the command buffer began recording
+	 */
+	const AttachmentTraffic &get_attachment_traffic() const;
+
 	/**
 	 * @brief Flushes the command buffer, pushing the new changes
 	 * @param pipeline_bind_point The type of pipeline we want to flush
@@ -113,7 +168,23 @@ class CommandBuffer
 
 	void begin_render_pass(const RenderTarget &render_target, const std::vector<LoadStoreInfo> &load_store_infos, const std::vector<VkClearValue> &clear_values, const std::vector<std::unique_ptr<Subpass>> &subpasses, VkSubpassContents contents = VK_SUBPASS_CONTENTS_INLINE);
 
-	void next_subpass();
+	/**
+	 * @brief Begins a render pass described by subpass infos, for passes which do not draw through Subpass objects
+	 */
+	void begin_render_pass(const RenderTarget &render_target, const std::vector<LoadStoreInfo> &load_store_infos, const std::vector<VkClearValue> &clear_values, const std::vector<SubpassInfo> &subpass_infos, VkSubpassContents contents = VK_SUBPASS_CONTENTS_INLINE);
+
+	void next_subpass(VkSubpassContents contents = VK_SUBPASS_CONTENTS_INLINE);
+
+	/**
+	 * @brief Begins dynamic rendering to the attachments of a single subpass, without render pass or framebuffer objects.
+	 *        The attachments are used in the layouts a render pass would use, end_render_pass ends the rendering.
+	 *        Requires the VK_KHR_dynamic_rendering extension.
+	 * @param render_target The render target with the attachments
+	 * @param load_store_infos The load and store operations of the attachments
+	 * @param clear_values The clear values of the attachments
+	 * @param subpass_info The attachments drawn to, which cannot include input attachments
+	 */
+	void begin_rendering(const RenderTarget &render_target, const std::vector<LoadStoreInfo> &load_store_infos, const std::vector<VkClearValue> &clear_values, const SubpassInfo &subpass_info);
 
 	void execute_commands(CommandBuffer &secondary_command_buffer);
 
@@ -134,28 +205,30 @@ class CommandBuffer
 	 */
 	void push_constants(const std::vector<uint8_t> &values);
 
+	void push_constants(const uint8_t *values, size_t size);
+
 	template <typename T>
 	void push_constants(const T &value)
 	{
-		auto data = to_bytes(value);
-
-		uint32_t size = to_u32(stored_push_constants.size() + data.size());
-
-		if (size > max_push_constants_size)
-		{
-			LOGE("Push constant limit exceeded ({} / {} bytes)", size, max_push_constants_size);
-			throw std::runtime_error("Cannot overflow push constant limit");
-		}
-
-		stored_push_constants.insert(stored_push_constants.end(), data.begin(), data.end());
+		push_constants(reinterpret_cast<const uint8_t *>(&value), sizeof(T));
 	}
 
 	void bind_buffer(const core::Buffer &buffer, VkDeviceSize offset, VkDeviceSize range, uint32_t set, uint32_t binding, uint32_t array_element);
 
 	void bind_image(const core::ImageView &image_view, const core::Sampler &sampler, uint32_t set, uint32_t binding, uint32_t array_element);
 
+	/**
+	 * @brief Binds an image without a sampler, such as a storage image, which shaders access in the general layout
+	 */
+	void bind_image(const core::ImageView &image_view, uint32_t set, uint32_t binding, uint32_t array_element);
+
 	void bind_input(const core::ImageView &image_view, uint32_t set, uint32_t binding, uint32_t array_element);
 
+	/**
+	 * @brief Binds a top level acceleration structure, which shaders trace rays against with ray queries
+	 */
+	void bind_acceleration_structure(const core::AccelerationStructure &acceleration_structure, uint32_t set, uint32_t binding, uint32_t array_element);
+
 	void bind_vertex_buffers(uint32_t first_binding, const std::vector<std::reference_wrapper<const vkb::core::Buffer>> &buffers, const std::vector<VkDeviceSize> &offsets);
 
 	void bind_index_buffer(const core::Buffer &buffer, VkDeviceSize offset, VkIndexType index_type);
@@ -166,6 +239,13 @@ class CommandBuffer
 
 	void set_input_assembly_state(const InputAssemblyState &state_info);
 
+	/**
+	 * @brief Sets the cull mode, the front face and the depth stencil state with dynamic state,
+	 *        so that pipelines differing only by them are shared. The mode is kept across recordings
+	 * @param enable Whether to use dynamic state, it has no effect unless VK_EXT_extended_dynamic_state is enabled
+	 */
+	void set_extended_dynamic_state(bool enable);
+
 	void set_rasterization_state(const RasterizationState &state_info);
 
 	void set_multisample_state(const MultisampleState &state_info);
@@ -174,6 +254,19 @@ class CommandBuffer
 
 	void set_color_blend_state(const ColorBlendState &state_info);
 
+	/**
+	 * @brief Sets the fragment shading rate of the next pipelines, secondary command buffers begun
+	 *        afterwards in the same subpass inherit it
+	 *        It has no effect unless VK_KHR_fragment_shading_rate is enabled.
+	 */
+	void set_fragment_shading_rate_state(const FragmentShadingRateState &state_info);
+
+	/**
+	 * @brief Sets the subgroup size of the next compute pipelines, see PhysicalDevice::get_subgroup_size_control_properties
+	 *        for the sizes supported. It has no effect unless VK_EXT_subgroup_size_control is enabled.
+	 */
+	void set_subgroup_size_state(const SubgroupSizeState &state_info);
+
 	void set_viewport(uint32_t first_viewport, const std::vector<VkViewport> &viewports);
 
 	void set_scissor(uint32_t first_scissor, const std::vector<VkRect2D> &scissors);
@@ -192,13 +285,31 @@ class CommandBuffer
 
 	void draw_indexed_indirect(const core::Buffer &buffer, VkDeviceSize offset, uint32_t draw_count, uint32_t stride);
 
+	/**
+	 * @brief Draws with the number of draws read from a buffer, requires VK_KHR_draw_indirect_count
+	 * @param buffer Buffer of VkDrawIndexedIndirectCommand
+	 * @param offset Offset of the first command in the buffer
+	 * @param count_buffer Buffer containing the draw count
+	 * @param count_offset Offset of the draw count in the count buffer
+	 * @param max_draw_count Maximum number of draws to execute
+	 * @param stride Stride between commands
+	 */
+	void draw_indexed_indirect_count(const core::Buffer &buffer, VkDeviceSize offset, const core::Buffer &count_buffer, VkDeviceSize count_offset, uint32_t max_draw_count, uint32_t stride);
+
+	/**
+	 * @brief Launches task shader workgroups, requires VK_NV_mesh_shader
+	 * @param task_count Number of task shader workgroups
+	 * @param first_task First task shader workgroup
+	 */
+	void draw_mesh_tasks(uint32_t task_count, uint32_t first_task);
+
 	void dispatch(uint32_t group_count_x, uint32_t group_count_y, uint32_t group_count_z);
 
 	void dispatch_indirect(const core::Buffer &buffer, VkDeviceSize offset);
 
 	void update_buffer(const core::Buffer &buffer, VkDeviceSize offset, const std::vector<uint8_t> &data);
 
-	void blit_image(const core::Image &src_img, const core::Image &dst_img, const std::vector<VkImageBlit> &regions);
+	void blit_image(const core::Image &src_img, const core::Image &dst_img, const std::vector<VkImageBlit> &regions, VkFilter filter = VK_FILTER_NEAREST);
 
 	void resolve_image(const core::Image &src_img, const core::Image &dst_img, const std::vector<VkImageResolve> &regions);
 
@@ -208,8 +319,49 @@ class CommandBuffer
 
 	void copy_buffer_to_image(const core::Buffer &buffer, const core::Image &image, const std::vector<VkBufferImageCopy> &regions);
 
+	void copy_image_to_buffer(const core::Image &image, const core::Buffer &buffer, const std::vector<VkBufferImageCopy> &regions);
+
+	/**
+	 * @brief Queues a barrier for the subresources of an image view
+	 *
+	 * Queued barriers are recorded in a single pipeline barrier, combining their stage masks, before the next
+	 * command. A barrier already queued for the same image is recorded first. Commands recorded directly on
+	 * the handle have to be preceded by flush_barriers.
+	 */
 	void image_memory_barrier(const core::ImageView &image_view, const ImageMemoryBarrier &memory_barrier);
 
+	/**
+	 * @brief Requires subresources of an image to be in a layout for accesses of the next commands
+	 *
+	 * The transition and the hazards with previous accesses are found from the state tracked by the image.
+	 * Reads of subresources which were only read in the same layout, by stages the last barrier covered,
+	 * need no barrier. The barriers required until the next command are recorded in a single pipeline
+	 * barrier before it. Must be called outside render passes.
+	 *
+	 * A swapchain image has to be set by Image::set_state to the wait stage of its acquire semaphore before
+	 * it is first required, so that the barrier waits for the semaphore.
+	 * @param image Image whose subresources are accessed
+	 * @param range Subresources accessed, whose aspects follow the format of the image
+	 * @param layout Layout of the accesses
+	 * @param stage_mask Stages of the accesses
+	 * @param access_mask Types of the accesses
+	 * @param discard_contents Whether the contents can be discarded, transitioning from the undefined layout
+	 */
+	void require_layout(const core::Image &image, VkImageSubresourceRange range, VkImageLayout layout, VkPipelineStageFlags stage_mask, VkAccessFlags access_mask, bool discard_contents = false);
+
+	/**
+	 * @brief Requires the subresources of an image view to be in a layout for accesses of the next commands
+	 */
+	void require_layout(const core::ImageView &image_view, VkImageLayout layout, VkPipelineStageFlags stage_mask, VkAccessFlags access_mask, bool discard_contents = false);
+
+	/**
+	 * @brief Records the barriers queued or required since the last command, which commands do before being recorded
+	 */
+	void flush_barriers();
+
+	/**
+	 * @brief Queues a barrier for a range of a buffer, recorded with the other queued barriers before the next command
+	 */
 	void buffer_memory_barrier(const core::Buffer &buffer, VkDeviceSize offset, VkDeviceSize size, const BufferMemoryBarrier &memory_barrier);
 
 	const State get_state() const;
@@ -224,12 +376,153 @@ class CommandBuffer
 
 	void write_timestamp(VkPipelineStageFlagBits pipeline_stage, const QueryPool &query_pool, uint32_t query);
 
+	/**
+	 * @brief Copies the results of queries into a buffer on the device, so that reading them does not wait on the host
+	 *        Must be recorded outside of a render pass, after the queries have ended.
+	 * @param query_pool Pool of the queries
+	 * @param first_query Index of the first query
+	 * @param query_count Number of queries
+	 * @param buffer Buffer the results are written to
+	 * @param offset Offset in the buffer of the results of the first query
+	 * @param stride Distance in bytes between the results of consecutive queries
+	 * @param flags How the results are written, as for QueryPool::get_results
+	 */
+	void copy_query_pool_results(const QueryPool &query_pool, uint32_t first_query, uint32_t query_count,
+	                             const core::Buffer &buffer, VkDeviceSize offset, VkDeviceSize stride, VkQueryResultFlags flags);
+
+	/**
+	 * @brief Opens a labeled region of commands shown by GPU captures
+	 *        Only builds with VKB_DEBUG_MARKERS record labels, the call is empty otherwise.
+	 */
+	void begin_debug_label(const char *name);
+
+	/**
+	 * @brief Closes the last region opened by begin_debug_label
+	 */
+	void end_debug_label();
+
+	/**
+	 * @brief Labels the commands recorded during its lifetime, use DEBUG_LABEL_SCOPE so that release builds do not even build the name
+	 */
+	class DebugLabelScope
+	{
+	  public:
+		/**
+		 * @param command_buffer The command buffer to label
+		 * @param name The label
+		 * @param enabled Whether to label the commands, labels can not be recorded in subpasses with secondary command buffer contents
+		 */
+		DebugLabelScope(CommandBuffer &command_buffer, const std::string &name, bool enabled = true);
+
+		DebugLabelScope(const DebugLabelScope &) = delete;
+
+		DebugLabelScope(DebugLabelScope &&) = delete;
+
+		~DebugLabelScope();
+
+		DebugLabelScope &operator=(const DebugLabelScope &) = delete;
+
+		DebugLabelScope &operator=(DebugLabelScope &&) = delete;
+
+	  private:
+		/// Null if the commands are not labeled
+		CommandBuffer *command_buffer;
+	};
+
+	/**
+	 * @brief Records commands straight to the handle during its lifetime, each call mapping to a single vkCmd,
+	 *        with no pipeline state, resource binding state or barrier tracking
+	 *
+	 * It is meant for hot loops whose callers hold the pipelines and descriptor sets they bind, or which only
+	 * draw with the state a tracked draw flushed. The barriers queued before it are recorded when it begins.
+	 * Once it ends, tracked draws bind their pipeline again if it bound one, and resources bound through the
+	 * command buffer have to be bound again, as in a new subpass, if it bound descriptor sets.
+	 */
+	class RawRecording
+	{
+	  public:
+		RawRecording(CommandBuffer &command_buffer);
+
+		RawRecording(const RawRecording &) = delete;
+
+		RawRecording(RawRecording &&) = delete;
+
+		~RawRecording();
+
+		RawRecording &operator=(const RawRecording &) = delete;
+
+		RawRecording &operator=(RawRecording &&) = delete;
+
+		/**
+		 * @brief Binds a pipeline built for the current subpass, such as one of the resource cache
+		 */
+		void bind_pipeline(const GraphicsPipeline &pipeline);
+
+		void bind_pipeline(const ComputePipeline &pipeline);
+
+		/**
+		 * @brief Binds a descriptor set, which has to be written before the commands using it are submitted
+		 * @param pipeline_bind_point Bind point of the pipelines using the set
+		 * @param pipeline_layout Layout the set is bound for
+		 * @param set Index of the set in the layout
+		 * @param descriptor_set The descriptor set
+		 * @param dynamic_offset_count Number of dynamic offsets
+		 * @param dynamic_offsets Offsets of the dynamic buffers of the set, in binding order
+		 */
+		void bind_descriptor_set(VkPipelineBindPoint pipeline_bind_point, const PipelineLayout &pipeline_layout, uint32_t set, const DescriptorSet &descriptor_set,
+		                         uint32_t dynamic_offset_count = 0, const uint32_t *dynamic_offsets = nullptr);
+
+		void push_constants(const PipelineLayout &pipeline_layout, VkShaderStageFlags stages, uint32_t offset, uint32_t size, const void *values);
+
+		void bind_vertex_buffer(uint32_t binding, const core::Buffer &buffer, VkDeviceSize offset);
+
+		void bind_index_buffer(const core::Buffer &buffer, VkDeviceSize offset, VkIndexType index_type);
+
+		void draw(uint32_t vertex_count, uint32_t instance_count, uint32_t first_vertex, uint32_t first_instance);
+
+		void draw_indexed(uint32_t index_count, uint32_t instance_count, uint32_t first_index, int32_t vertex_offset, uint32_t first_instance);
+
+		void draw_indexed_indirect(const core::Buffer &buffer, VkDeviceSize offset, uint32_t draw_count, uint32_t stride);
+
+		void dispatch(uint32_t group_count_x, uint32_t group_count_y, uint32_t group_count_z);
+
+	  private:
+		CommandBuffer &command_buffer;
+
+		VkCommandBuffer handle;
+
+		/// Whether a pipeline was bound at each bind point, so that the tracked state binds its own again
+		bool graphics_pipeline_bound{false};
+
+		bool compute_pipeline_bound{false};
+
+		/// Whether descriptor sets were bound, which disturbs the sets bound from the tracked resources
+		bool descriptor_sets_bound{false};
+	};
+
 	/**
 	 * @brief Reset the command buffer to a state where it can be recorded to
 	 * @param reset_mode How to reset the buffer, should match the one used by the pool to allocate it
 	 */
 	VkResult reset(ResetMode reset_mode);
 
+	/**
+	 * @return The render pass, framebuffer and render area of the current subpass
+	 */
+	const RenderPassBinding &get_current_render_pass() const;
+
+	/**
+	 * @return The state the following draws and dispatches are recorded with
+	 */
+	const PipelineState &get_pipeline_state() const;
+
+	const uint32_t get_current_subpass_index() const;
+
+	/**
+	 * @return The queue family of the pool of the command buffer, which it can be submitted to
+	 */
+	uint32_t get_queue_family_index() const;
+
 	const VkCommandBufferLevel level;
 
   private:
@@ -241,6 +534,9 @@ class CommandBuffer
 
 	RenderPassBinding current_render_pass;
 
+	/// Whether the current rendering was begun with begin_rendering rather than a render pass
+	bool dynamic_rendering_active{false};
+
 	PipelineState pipeline_state;
 
 	ResourceBindingState resource_binding_state;
@@ -257,11 +553,143 @@ class CommandBuffer
 	// that contain update after bind, as they wont be implicitly updated
 	bool update_after_bind{false};
 
-	std::unordered_map<uint32_t, DescriptorSetLayout *> descriptor_set_layout_binding_state;
+	/// Pipelines bound by the recording, its state is undefined after executing secondary command buffers
+	VkPipeline bound_graphics_pipeline{VK_NULL_HANDLE};
 
-	const RenderPassBinding &get_current_render_pass() const;
+	VkPipeline bound_compute_pipeline{VK_NULL_HANDLE};
 
-	const uint32_t get_current_subpass_index() const;
+	/// Number of entries of the graphics pipeline cache, a power of two
+	static constexpr size_t GRAPHICS_PIPELINE_CACHE_SIZE = 64;
+
+	/**
+	 * @brief A graphics pipeline requested by the recording, with the hash of its state
+	 */
+	struct CachedGraphicsPipeline
+	{
+		size_t hash{0};
+
+		GraphicsPipeline *pipeline{nullptr};
+	};
+
+	/// Pipelines of the states seen by the recording, direct mapped by the low bits of the state hash.
+	/// It is cleared when recording begins, as the resource cache may destroy its pipelines between recordings
+	std::array<CachedGraphicsPipeline, GRAPHICS_PIPELINE_CACHE_SIZE> graphics_pipeline_cache;
+
+	BindCounters bind_counters;
+
+	AttachmentTraffic attachment_traffic;
+
+	/// Image barriers required or requested which are not recorded yet
+	std::vector<VkImageMemoryBarrier> pending_image_barriers;
+
+	/// Buffer barriers queued which are not recorded yet
+	std::vector<VkBufferMemoryBarrier> pending_buffer_barriers;
+
+	VkPipelineStageFlags pending_src_stage_mask{0};
+
+	VkPipelineStageFlags pending_dst_stage_mask{0};
+
+	bool extended_dynamic_state{false};
+
+	/// Whether the dynamic state below was set since the last bind of a pipeline with static state
+	bool extended_dynamic_state_set{false};
+
+	RasterizationState dynamic_rasterization_state;
+
+	DepthStencilState dynamic_depth_stencil_state;
+
+	using DescriptorSetLayoutBindingState = std::unordered_map<uint32_t, DescriptorSetLayout *, std::hash<uint32_t>, std::equal_to<uint32_t>,
+	                                                           ArenaAllocator<std::pair<const uint32_t, DescriptorSetLayout *>>>;
+
+	DescriptorSetLayoutBindingState descriptor_set_layout_binding_state;
+
+	/**
+	 * @brief A descriptor set built during the current recording, with the dynamic offsets it was bound with
+	 */
+	struct CachedDescriptorSet
+	{
+		VkDescriptorSet handle{VK_NULL_HANDLE};
+
+		uint32_t first_dynamic_offset{0};
+
+		uint32_t dynamic_offset_count{0};
+
+#ifdef VKB_VERIFY_CACHE_KEYS
+		/// Set index, layout and resources the descriptor set was written from, compared on hits to detect hash collisions
+		uint32_t set_index{0};
+
+		const DescriptorSetLayout *layout{nullptr};
+
+		std::vector<ResourceBinding> resource_bindings;
+#endif
+	};
+
+	using DescriptorSetCache = std::unordered_map<size_t, CachedDescriptorSet, std::hash<size_t>, std::equal_to<size_t>,
+	                                              ArenaAllocator<std::pair<const size_t, CachedDescriptorSet>>>;
+
+	/// Descriptor sets of the recording keyed by the hash of their resource set, set index and layout
+	DescriptorSetCache descriptor_set_cache;
+
+	/// Dynamic offsets of all the cached descriptor sets
+	std::vector<uint32_t, ArenaAllocator<uint32_t>> descriptor_set_cache_dynamic_offsets;
+
+	/**
+	 * @brief Recreates the containers tracking the bound state of a recording
+	 * @param arena The arena to allocate them from, it must outlive the recording or be null to use the heap
+	 */
+	void reset_recording_state(MemoryArena *arena);
+
+	/**
+	 * @brief State secondary command buffers inherit from the current subpass of a primary one
+	 */
+	struct SecondaryInheritance
+	{
+		/// Render pass and framebuffer of the subpass, null outside of a render pass
+		RenderPassBinding render_pass{};
+
+		VkCommandBufferInheritanceInfo info{VK_STRUCTURE_TYPE_COMMAND_BUFFER_INHERITANCE_INFO};
+
+		/// Pipeline state secondary command buffers start from, with the subpass index and its color blend attachments
+		PipelineState pipeline_state;
+	};
+
+	/// Built once per subpass so that secondary command buffers begun concurrently only copy it
+	SecondaryInheritance secondary_inheritance;
+
+	/**
+	 * @brief Rebuilds the inheritance of secondary command buffers for the current subpass
+	 */
+	void update_secondary_inheritance();
+
+	/**
+	 * @return The reset mode of the pool of the command buffer
+	 */
+	ResetMode get_reset_mode() const;
+
+	/**
+	 * @brief Records the pending barriers if one of them is for the image
+	 */
+	void flush_image_barriers(VkImage image);
+
+	/**
+	 * @brief Records the pending barriers if one of them is for the buffer
+	 */
+	void flush_buffer_barriers(VkBuffer buffer);
+
+	/**
+	 * @brief Adds a barrier to the pending ones, extending the last one when it is for the previous mip level
+	 */
+	void add_pending_barrier(const VkImageMemoryBarrier &barrier, VkPipelineStageFlags src_stage_mask, VkPipelineStageFlags dst_stage_mask);
+
+	/**
+	 * @brief Sets the tracked state of the image of an attachment written by a render pass
+	 */
+	void track_attachment(const core::ImageView &image_view, VkImageLayout layout);
+
+	/**
+	 * @brief Adds the estimated traffic of an attachment loaded and stored over the render area
+	 */
+	void add_attachment_traffic(const RenderTarget &render_target, uint32_t attachment, const LoadStoreInfo &load_store);
 
 	/**
 	 * @brief Check that the render area is an optimal size by comparing to the render area granularity
@@ -273,11 +701,22 @@ class CommandBuffer
 	 */
 	void flush_pipeline_state(VkPipelineBindPoint pipeline_bind_point);
 
+	/**
+	 * @brief Records the extended dynamic state of the pipeline state which changed since it was last set
+	 */
+	void flush_extended_dynamic_state();
+
 	/**
 	 * @brief Flush the descriptor set state
 	 */
 	void flush_descriptor_state(VkPipelineBindPoint pipeline_bind_point);
 
+	/**
+	 * @brief Writes the descriptors of a push descriptor set into the command buffer
+	 */
+	void push_descriptor_set(VkPipelineBindPoint pipeline_bind_point, const DescriptorSetLayout &descriptor_set_layout, const BindingMap<VkDescriptorBufferInfo> &buffer_infos, const BindingMap<VkDescriptorImageInfo> &image_infos,
+	                         const BindingMap<VkAccelerationStructureKHR> &acceleration_structure_infos);
+
 	/**
 	 * @brief Flush the push constant state
 	 */
@@ -295,4 +734,14 @@ inline void CommandBuffer::set_specialization_constant<bool>(std::uint32_t const
 {
 	set_specialization_constant(constant_id, to_bytes(to_u32(data)));
 }
+
+#ifndef VKB_DEBUG_MARKERS
+inline void CommandBuffer::begin_debug_label(const char * /*name*/)
+{
+}
+
+inline void CommandBuffer::end_debug_label()
+{
+}
+#endif
 }        // namespace vkb
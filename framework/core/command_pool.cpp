@@ -22,6 +22,15 @@
 
 namespace vkb
 {
+CommandBufferCounters &CommandBufferCounters::operator+=(const CommandBufferCounters &other)
+{
+	allocated += other.allocated;
+	reused += other.reused;
+	reset += other.reset;
+
+	return *this;
+}
+
 CommandPool::CommandPool(Device &d, uint32_t queue_family_index, RenderFrame *render_frame, size_t thread_index, CommandBuffer::ResetMode reset_mode) :
     device{d},
     render_frame{render_frame},
@@ -76,7 +85,8 @@ CommandPool::CommandPool(CommandPool &&other) :
     active_secondary_command_buffer_count{other.active_secondary_command_buffer_count},
     render_frame{other.render_frame},
     thread_index{other.thread_index},
-    reset_mode{other.reset_mode}
+    reset_mode{other.reset_mode},
+    counters{other.counters}
 {
 	other.handle = VK_NULL_HANDLE;
 
@@ -139,6 +149,8 @@ VkResult CommandPool::reset_pool()
 		}
 		case CommandBuffer::ResetMode::AlwaysAllocate:
 		{
+			counters.reset += active_primary_command_buffer_count + active_secondary_command_buffer_count;
+
 			primary_command_buffers.clear();
 			active_primary_command_buffer_count = 0;
 
@@ -158,9 +170,10 @@ VkResult CommandPool::reset_command_buffers()
 {
 	VkResult result = VK_SUCCESS;
 
-	for (auto &cmd_buf : primary_command_buffers)
+	// Command buffers past the active ones were not requested since their last reset
+	for (uint32_t i = 0; i < active_primary_command_buffer_count; ++i)
 	{
-		result = cmd_buf->reset(reset_mode);
+		result = primary_command_buffers[i]->reset(reset_mode);
 
 		if (result != VK_SUCCESS)
 		{
@@ -168,11 +181,13 @@ VkResult CommandPool::reset_command_buffers()
 		}
 	}
 
+	counters.reset += active_primary_command_buffer_count;
+
 	active_primary_command_buffer_count = 0;
 
-	for (auto &cmd_buf : secondary_command_buffers)
+	for (uint32_t i = 0; i < active_secondary_command_buffer_count; ++i)
 	{
-		result = cmd_buf->reset(reset_mode);
+		result = secondary_command_buffers[i]->reset(reset_mode);
 
 		if (result != VK_SUCCESS)
 		{
@@ -180,6 +195,8 @@ VkResult CommandPool::reset_command_buffers()
 		}
 	}
 
+	counters.reset += active_secondary_command_buffer_count;
+
 	active_secondary_command_buffer_count = 0;
 
 	return result;
@@ -191,11 +208,15 @@ CommandBuffer &CommandPool::request_command_buffer(VkCommandBufferLevel level)
 	{
 		if (active_primary_command_buffer_count < primary_command_buffers.size())
 		{
+			counters.reused++;
+
 			return *primary_command_buffers.at(active_primary_command_buffer_count++);
 		}
 
 		primary_command_buffers.emplace_back(std::make_unique<CommandBuffer>(*this, level));
 
+		counters.allocated++;
+
 		active_primary_command_buffer_count++;
 
 		return *primary_command_buffers.back();
@@ -204,19 +225,49 @@ CommandBuffer &CommandPool::request_command_buffer(VkCommandBufferLevel level)
 	{
 		if (active_secondary_command_buffer_count < secondary_command_buffers.size())
 		{
+			counters.reused++;
+
 			return *secondary_command_buffers.at(active_secondary_command_buffer_count++);
 		}
 
 		secondary_command_buffers.emplace_back(std::make_unique<CommandBuffer>(*this, level));
 
+		counters.allocated++;
+
 		active_secondary_command_buffer_count++;
 
 		return *secondary_command_buffers.back();
 	}
 }
 
+void CommandPool::reserve(uint32_t primary_count, uint32_t secondary_count)
+{
+	// Buffers of always allocating pools are freed on reset, reserving them would not outlast the frame
+	if (reset_mode == CommandBuffer::ResetMode::AlwaysAllocate)
+	{
+		return;
+	}
+
+	while (primary_command_buffers.size() < primary_count)
+	{
+		primary_command_buffers.emplace_back(std::make_unique<CommandBuffer>(*this, VK_COMMAND_BUFFER_LEVEL_PRIMARY));
+		counters.allocated++;
+	}
+
+	while (secondary_command_buffers.size() < secondary_count)
+	{
+		secondary_command_buffers.emplace_back(std::make_unique<CommandBuffer>(*this, VK_COMMAND_BUFFER_LEVEL_SECONDARY));
+		counters.allocated++;
+	}
+}
+
 CommandBuffer::ResetMode const CommandPool::get_reset_mode() const
 {
 	return reset_mode;
 }
+
+const CommandBufferCounters &CommandPool::get_counters() const
+{
+	return counters;
+}
 }        // namespace vkb
@@ -26,6 +26,23 @@ namespace vkb
 class Device;
 class RenderFrame;
 
+/**
+ * @brief Numbers of command buffers handed out and recycled by command pools
+ */
+struct CommandBufferCounters
+{
+	/// Command buffers created, either on request or when reserving them
+	uint64_t allocated{0};
+
+	/// Requests served with a command buffer of a previous frame
+	uint64_t reused{0};
+
+	/// Command buffers reset for reuse
+	uint64_t reset{0};
+
+	CommandBufferCounters &operator+=(const CommandBufferCounters &other);
+};
+
 class CommandPool
 {
   public:
@@ -57,8 +74,20 @@ class CommandPool
 
 	CommandBuffer &request_command_buffer(VkCommandBufferLevel level = VK_COMMAND_BUFFER_LEVEL_PRIMARY);
 
+	/**
+	 * @brief Allocates command buffers up front, so that the first requests reuse them instead of allocating
+	 * @param primary_count The number of primary command buffers the pool should hold at least
+	 * @param secondary_count The number of secondary command buffers the pool should hold at least
+	 */
+	void reserve(uint32_t primary_count, uint32_t secondary_count);
+
 	const CommandBuffer::ResetMode get_reset_mode() const;
 
+	/**
+	 * @return The command buffers allocated, reused and reset by the pool since its creation
+	 */
+	const CommandBufferCounters &get_counters() const;
+
   private:
 	Device &device;
 
@@ -80,6 +109,8 @@ class CommandPool
 
 	CommandBuffer::ResetMode reset_mode{CommandBuffer::ResetMode::ResetPool};
 
+	CommandBufferCounters counters;
+
 	VkResult reset_command_buffers();
 };
 }        // namespace vkb
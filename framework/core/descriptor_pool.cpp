@@ -39,44 +39,47 @@ DescriptorPool::DescriptorPool(Device &                   device,
 		descriptor_type_counts[binding.descriptorType] += binding.descriptorCount;
 	}
 
-	// Allocate pool sizes array
-	pool_sizes.resize(descriptor_type_counts.size());
-
-	auto pool_size_it = pool_sizes.begin();
-
-	// Fill pool size for each descriptor type count multiplied by the pool size
+	// Pool sizes are these counts multiplied by the number of sets of each pool
 	for (auto &it : descriptor_type_counts)
 	{
-		pool_size_it->type = it.first;
-
-		pool_size_it->descriptorCount = it.second * pool_size;
-
-		++pool_size_it;
+		set_sizes.push_back({it.first, it.second});
 	}
 
-	pool_max_sets = pool_size;
+	pool_max_sets = std::min(std::max(pool_size, 1U), MAX_POOL_SETS);
 }
 
 DescriptorPool::~DescriptorPool()
 {
-	// Destroy all descriptor pools
-	for (auto pool : pools)
-	{
-		vkDestroyDescriptorPool(device.get_handle(), pool, nullptr);
-	}
+	destroy_pools();
 }
 
 void DescriptorPool::reset()
 {
-	// Reset all descriptor pools
-	for (auto pool : pools)
+	if (pools.size() > 1)
 	{
-		vkResetDescriptorPool(device.get_handle(), pool, 0);
+		// The sets did not fit in one pool, so a single pool for all of them replaces the pools
+		uint32_t max_sets = pool_max_sets;
+		while (max_sets < set_count && max_sets < MAX_POOL_SETS)
+		{
+			max_sets *= 2;
+		}
+
+		destroy_pools();
+
+		pool_max_sets = max_sets;
+	}
+	else
+	{
+		// Reset all descriptor pools
+		for (auto pool : pools)
+		{
+			vkResetDescriptorPool(device.get_handle(), pool, 0);
+		}
 	}
 
 	// Clear internal tracking of descriptor set allocations
 	std::fill(pool_sets_count.begin(), pool_sets_count.end(), 0);
-	set_pool_mapping.clear();
+	set_count = 0;
 
 	// Reset the pool index from which descriptor sets are allocated
 	pool_index = 0;
@@ -95,112 +98,138 @@ void DescriptorPool::set_descriptor_set_layout(const DescriptorSetLayout &set_la
 
 VkDescriptorSet DescriptorPool::allocate()
 {
-	pool_index = find_available_pool(pool_index);
+	VkDescriptorSetLayout set_layout = get_descriptor_set_layout().get_handle();
 
-	// Increment allocated set count for the current pool
-	++pool_sets_count[pool_index];
+	while (true)
+	{
+		pool_index = find_available_pool(pool_index);
 
-	VkDescriptorSetLayout set_layout = get_descriptor_set_layout().get_handle();
+		VkDescriptorSetAllocateInfo alloc_info{VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO};
+		alloc_info.descriptorPool     = pools[pool_index];
+		alloc_info.descriptorSetCount = 1;
+		alloc_info.pSetLayouts        = &set_layout;
 
-	VkDescriptorSetAllocateInfo alloc_info{VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO};
-	alloc_info.descriptorPool     = pools[pool_index];
-	alloc_info.descriptorSetCount = 1;
-	alloc_info.pSetLayouts        = &set_layout;
+		VkDescriptorSet handle = VK_NULL_HANDLE;
 
-	VkDescriptorSet handle = VK_NULL_HANDLE;
+		// Allocate a new descriptor set from the current pool
+		auto result = vkAllocateDescriptorSets(device.get_handle(), &alloc_info, &handle);
 
-	// Allocate a new descriptor set from the current pool
-	auto result = vkAllocateDescriptorSets(device.get_handle(), &alloc_info, &handle);
+		if (result == VK_SUCCESS)
+		{
+			// Increment allocated set count for the current pool
+			++pool_sets_count[pool_index];
+			++set_count;
 
-	if (result != VK_SUCCESS)
-	{
-		// Decrement allocated set count for the current pool
-		--pool_sets_count[pool_index];
+			return handle;
+		}
 
-		return VK_NULL_HANDLE;
-	}
+		if (result != VK_ERROR_OUT_OF_POOL_MEMORY && result != VK_ERROR_FRAGMENTED_POOL)
+		{
+			return VK_NULL_HANDLE;
+		}
 
-	// Store mapping between the descriptor set and the pool
-	set_pool_mapping.emplace(handle, pool_index);
+		// The pool ran out of descriptors before reaching its set count, so the next one is tried
+		pool_sets_count[pool_index] = pool_capacities[pool_index];
+	}
+}
 
-	return handle;
+size_t DescriptorPool::get_pool_count() const
+{
+	return pools.size();
 }
 
-VkResult DescriptorPool::free(VkDescriptorSet descriptor_set)
+uint32_t DescriptorPool::get_set_capacity() const
 {
-	// Get the pool index of the descriptor set
-	auto it = set_pool_mapping.find(descriptor_set);
+	uint32_t capacity = 0;
 
-	if (it == set_pool_mapping.end())
+	for (auto pool_capacity : pool_capacities)
 	{
-		return VK_INCOMPLETE;
+		capacity += pool_capacity;
 	}
 
-	auto desc_pool_index = it->second;
+	return capacity;
+}
 
-	// Free descriptor set from the pool
-	vkFreeDescriptorSets(device.get_handle(), pools[desc_pool_index], 1, &descriptor_set);
+uint32_t DescriptorPool::get_set_count() const
+{
+	return set_count;
+}
 
-	// Remove descriptor set mapping to the pool
-	set_pool_mapping.erase(it);
+std::uint32_t DescriptorPool::find_available_pool(std::uint32_t search_index)
+{
+	while (search_index < pools.size() && pool_sets_count[search_index] >= pool_capacities[search_index])
+	{
+		++search_index;
+	}
 
-	// Decrement allocated set count for the pool
-	--pool_sets_count[desc_pool_index];
+	// Create a new pool
+	if (search_index == pools.size())
+	{
+		create_pool(pool_max_sets);
 
-	// Change the current pool index to use the available pool
-	pool_index = desc_pool_index;
+		// Pools grow geometrically, so that a frame needing many sets soon needs few pools
+		pool_max_sets = std::min(pool_max_sets * 2, MAX_POOL_SETS);
+	}
 
-	return VK_SUCCESS;
+	return search_index;
 }
 
-std::uint32_t DescriptorPool::find_available_pool(std::uint32_t search_index)
+void DescriptorPool::create_pool(uint32_t max_sets)
 {
-	// Create a new pool
-	if (pools.size() <= search_index)
+	std::vector<VkDescriptorPoolSize> pool_sizes{set_sizes};
+
+	for (auto &pool_size : pool_sizes)
 	{
-		VkDescriptorPoolCreateInfo create_info{VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO};
+		pool_size.descriptorCount *= max_sets;
+	}
 
-		create_info.poolSizeCount = to_u32(pool_sizes.size());
-		create_info.pPoolSizes    = pool_sizes.data();
-		create_info.maxSets       = pool_max_sets;
+	VkDescriptorPoolCreateInfo create_info{VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO};
 
-		// We do not set FREE_DESCRIPTOR_SET_BIT as we do not need to free individual descriptor sets
-		create_info.flags = 0;
+	create_info.poolSizeCount = to_u32(pool_sizes.size());
+	create_info.pPoolSizes    = pool_sizes.data();
+	create_info.maxSets       = max_sets;
 
-		// Check descriptor set layout and enable the required flags
-		auto &binding_flags = descriptor_set_layout->get_binding_flags();
-		for (auto binding_flag : binding_flags)
+	// We do not set FREE_DESCRIPTOR_SET_BIT as we do not need to free individual descriptor sets
+	create_info.flags = 0;
+
+	// Check descriptor set layout and enable the required flags
+	auto &binding_flags = descriptor_set_layout->get_binding_flags();
+	for (auto binding_flag : binding_flags)
+	{
+		if (binding_flag & VK_DESCRIPTOR_BINDING_UPDATE_AFTER_BIND_BIT_EXT)
 		{
-			if (binding_flag & VK_DESCRIPTOR_BINDING_UPDATE_AFTER_BIND_BIT_EXT)
-			{
-				create_info.flags |= VK_DESCRIPTOR_POOL_CREATE_UPDATE_AFTER_BIND_BIT_EXT;
-			}
+			create_info.flags |= VK_DESCRIPTOR_POOL_CREATE_UPDATE_AFTER_BIND_BIT_EXT;
 		}
+	}
 
-		VkDescriptorPool handle = VK_NULL_HANDLE;
+	VkDescriptorPool handle = VK_NULL_HANDLE;
 
-		// Create the Vulkan descriptor pool
-		auto result = vkCreateDescriptorPool(device.get_handle(), &create_info, nullptr, &handle);
+	// Create the Vulkan descriptor pool
+	auto result = vkCreateDescriptorPool(device.get_handle(), &create_info, nullptr, &handle);
 
-		if (result != VK_SUCCESS)
-		{
-			return VK_NULL_HANDLE;
-		}
+	if (result != VK_SUCCESS)
+	{
+		throw VulkanException{result, "Cannot create descriptor pool"};
+	}
 
-		// Store internally the Vulkan handle
-		pools.push_back(handle);
+	// Store internally the Vulkan handle
+	pools.push_back(handle);
 
-		// Add set count for the descriptor pool
-		pool_sets_count.push_back(0);
+	// Add set count for the descriptor pool
+	pool_capacities.push_back(max_sets);
+	pool_sets_count.push_back(0);
+}
 
-		return search_index;
-	}
-	else if (pool_sets_count[search_index] < pool_max_sets)
+void DescriptorPool::destroy_pools()
+{
+	// Destroy all descriptor pools
+	for (auto pool : pools)
 	{
-		return search_index;
+		vkDestroyDescriptorPool(device.get_handle(), pool, nullptr);
 	}
 
-	// Increment pool index
-	return find_available_pool(++search_index);
+	pools.clear();
+	pool_capacities.clear();
+	pool_sets_count.clear();
 }
 }        // namespace vkb
@@ -17,8 +17,6 @@
 
 #pragma once
 
-#include <unordered_map>
-
 #include "common/helpers.h"
 #include "common/vk_common.h"
 
@@ -28,13 +26,20 @@ class Device;
 class DescriptorSetLayout;
 
 /**
- * @brief Manages an array of fixed size VkDescriptorPool and is able to allocate descriptor sets
+ * @brief Manages an array of VkDescriptorPool and is able to allocate descriptor sets
+ *
+ * Each new pool holds twice as many sets as the previous one. Sets are not freed individually,
+ * whole pools are recycled by reset(); if the sets allocated since the last reset needed several
+ * pools, they are replaced by a single pool large enough for all of them.
  */
 class DescriptorPool
 {
   public:
 	static const uint32_t MAX_SETS_PER_POOL = 16;
 
+	/// Largest number of sets of a pool, pools stop growing past it
+	static const uint32_t MAX_POOL_SETS = 1024;
+
 	DescriptorPool(Device &                   device,
 	               const DescriptorSetLayout &descriptor_set_layout,
 	               uint32_t                   pool_size = MAX_SETS_PER_POOL);
@@ -57,32 +62,53 @@ class DescriptorPool
 
 	VkDescriptorSet allocate();
 
-	VkResult free(VkDescriptorSet descriptor_set);
+	/**
+	 * @return Number of Vulkan descriptor pools created
+	 */
+	size_t get_pool_count() const;
+
+	/**
+	 * @return Number of sets the created pools can hold
+	 */
+	uint32_t get_set_capacity() const;
+
+	/**
+	 * @return Number of sets allocated since the last reset
+	 */
+	uint32_t get_set_count() const;
 
   private:
 	Device &device;
 
 	const DescriptorSetLayout *descriptor_set_layout{nullptr};
 
-	// Descriptor pool size
-	std::vector<VkDescriptorPoolSize> pool_sizes;
+	// Number of descriptors of each type in a set
+	std::vector<VkDescriptorPoolSize> set_sizes;
 
-	// Number of sets to allocate for each pool
+	// Number of sets of the next pool created
 	uint32_t pool_max_sets{0};
 
 	// Total descriptor pools created
 	std::vector<VkDescriptorPool> pools;
 
+	// Number of sets each pool can hold
+	std::vector<uint32_t> pool_capacities;
+
 	// Count sets for each pool
 	std::vector<uint32_t> pool_sets_count;
 
 	// Current pool index to allocate descriptor set
 	uint32_t pool_index{0};
 
-	// Map between descriptor set and pool index
-	std::unordered_map<VkDescriptorSet, uint32_t> set_pool_mapping;
+	// Sets allocated since the last reset
+	uint32_t set_count{0};
 
 	// Find next pool index or create new pool
 	uint32_t find_available_pool(uint32_t pool_index);
+
+	// Creates a pool for a number of sets
+	void create_pool(uint32_t max_sets);
+
+	void destroy_pools();
 };
 }        // namespace vkb
@@ -24,27 +24,60 @@
 
 namespace vkb
 {
-DescriptorSet::DescriptorSet(Device &                                  device,
-                             DescriptorSetLayout &                     descriptor_set_layout,
-                             DescriptorPool &                          descriptor_pool,
-                             const BindingMap<VkDescriptorBufferInfo> &buffer_infos,
-                             const BindingMap<VkDescriptorImageInfo> & image_infos) :
+namespace
+{
+template <class T>
+bool pack_descriptors(const BindingMap<T> &infos, const VkDescriptorUpdateTemplateEntryKHR &entry, std::vector<uint8_t> &data)
+{
+	auto binding_it = infos.find(entry.dstBinding);
+
+	if (binding_it == infos.end())
+	{
+		return false;
+	}
+
+	for (uint32_t array_element = 0; array_element < entry.descriptorCount; ++array_element)
+	{
+		auto element_it = binding_it->second.find(array_element);
+
+		if (element_it == binding_it->second.end())
+		{
+			return false;
+		}
+
+		std::memcpy(data.data() + entry.offset + array_element * entry.stride, &element_it->second, sizeof(T));
+	}
+
+	return true;
+}
+}        // namespace
+
+DescriptorSet::DescriptorSet(Device &                                      device,
+                             DescriptorSetLayout &                         descriptor_set_layout,
+                             DescriptorPool &                              descriptor_pool,
+                             const BindingMap<VkDescriptorBufferInfo> &    buffer_infos,
+                             const BindingMap<VkDescriptorImageInfo> &     image_infos,
+                             const BindingMap<VkAccelerationStructureKHR> &acceleration_structure_infos) :
     device{device},
     descriptor_set_layout{descriptor_set_layout},
     descriptor_pool{descriptor_pool},
     buffer_infos{buffer_infos},
     image_infos{image_infos},
+    acceleration_structure_infos{acceleration_structure_infos},
     handle{descriptor_pool.allocate()}
 {
 	prepare();
 }
 
-void DescriptorSet::reset(const BindingMap<VkDescriptorBufferInfo> &new_buffer_infos, const BindingMap<VkDescriptorImageInfo> &new_image_infos)
+void DescriptorSet::reset(const BindingMap<VkDescriptorBufferInfo> &    new_buffer_infos,
+                          const BindingMap<VkDescriptorImageInfo> &     new_image_infos,
+                          const BindingMap<VkAccelerationStructureKHR> &new_acceleration_structure_infos)
 {
-	if (!new_buffer_infos.empty() || !new_image_infos.empty())
+	if (!new_buffer_infos.empty() || !new_image_infos.empty() || !new_acceleration_structure_infos.empty())
 	{
-		buffer_infos = new_buffer_infos;
-		image_infos  = new_image_infos;
+		buffer_infos                 = new_buffer_infos;
+		image_infos                  = new_image_infos;
+		acceleration_structure_infos = new_acceleration_structure_infos;
 	}
 	else
 	{
@@ -52,7 +85,9 @@ void DescriptorSet::reset(const BindingMap<VkDescriptorBufferInfo> &new_buffer_i
 	}
 
 	this->write_descriptor_sets.clear();
+	this->acceleration_structure_writes.clear();
 	this->updated_bindings.clear();
+	this->template_data.clear();
 
 	prepare();
 }
@@ -146,10 +181,106 @@ void DescriptorSet::prepare()
 			LOGE("Shader layout set does not use image binding at #{}", binding_index);
 		}
 	}
+
+	// Reserve the acceleration structure writes upfront, as the write operations point to them
+	size_t acceleration_structure_count = 0;
+	for (auto &binding_it : acceleration_structure_infos)
+	{
+		acceleration_structure_count += binding_it.second.size();
+	}
+	acceleration_structure_writes.reserve(acceleration_structure_count);
+
+	// Iterate over all acceleration structure bindings
+	for (auto &binding_it : acceleration_structure_infos)
+	{
+		auto  binding_index     = binding_it.first;
+		auto &binding_resources = binding_it.second;
+
+		if (auto binding_info = descriptor_set_layout.get_layout_binding(binding_index))
+		{
+			for (auto &element_it : binding_resources)
+			{
+				VkWriteDescriptorSetAccelerationStructureKHR acceleration_structure_write{VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET_ACCELERATION_STRUCTURE_KHR};
+				acceleration_structure_write.accelerationStructureCount = 1;
+				acceleration_structure_write.pAccelerationStructures    = &element_it.second;
+
+				acceleration_structure_writes.push_back(acceleration_structure_write);
+
+				VkWriteDescriptorSet write_descriptor_set{VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET};
+
+				write_descriptor_set.pNext           = &acceleration_structure_writes.back();
+				write_descriptor_set.dstBinding      = binding_index;
+				write_descriptor_set.descriptorType  = binding_info->descriptorType;
+				write_descriptor_set.dstSet          = handle;
+				write_descriptor_set.dstArrayElement = element_it.first;
+				write_descriptor_set.descriptorCount = 1;
+
+				write_descriptor_sets.push_back(write_descriptor_set);
+			}
+		}
+		else
+		{
+			LOGE("Shader layout set does not use acceleration structure binding at #{}", binding_index);
+		}
+	}
+
+	// Pack the descriptors last, the buffer ranges have been clipped to the device limits above
+	prepare_template_data();
+}
+
+void DescriptorSet::prepare_template_data()
+{
+	if (descriptor_set_layout.get_update_template() == VK_NULL_HANDLE)
+	{
+		return;
+	}
+
+	template_data.resize(descriptor_set_layout.get_update_template_size());
+
+	for (auto &entry : descriptor_set_layout.get_update_template_entries())
+	{
+		bool packed = false;
+
+		switch (entry.descriptorType)
+		{
+			case VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER:
+			case VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC:
+			case VK_DESCRIPTOR_TYPE_STORAGE_BUFFER:
+			case VK_DESCRIPTOR_TYPE_STORAGE_BUFFER_DYNAMIC:
+				packed = pack_descriptors(buffer_infos, entry, template_data);
+				break;
+			case VK_DESCRIPTOR_TYPE_ACCELERATION_STRUCTURE_KHR:
+				packed = pack_descriptors(acceleration_structure_infos, entry, template_data);
+				break;
+			default:
+				packed = pack_descriptors(image_infos, entry, template_data);
+				break;
+		}
+
+		// A template writes every descriptor of the layout, a set leaving some out is updated with the write operations
+		if (!packed)
+		{
+			template_data.clear();
+			return;
+		}
+	}
 }
 
 void DescriptorSet::update(const std::vector<uint32_t> &bindings_to_update)
 {
+	// A set updated as a whole for the first time is written in a single call, without gathering write operations
+	if (!template_data.empty() && bindings_to_update.empty() && updated_bindings.empty())
+	{
+		vkUpdateDescriptorSetWithTemplateKHR(device.get_handle(), handle, descriptor_set_layout.get_update_template(), template_data.data());
+
+		for (auto &write_operation : write_descriptor_sets)
+		{
+			updated_bindings.push_back(write_operation.dstBinding);
+		}
+
+		return;
+	}
+
 	std::vector<VkWriteDescriptorSet> write_operations;
 
 	// If the 'bindings_to_update' vector is empty, we want to write to all the bindings (skipping those that haven't already been written)
@@ -200,9 +331,12 @@ DescriptorSet::DescriptorSet(DescriptorSet &&other) :
     descriptor_pool{other.descriptor_pool},
     buffer_infos{std::move(other.buffer_infos)},
     image_infos{std::move(other.image_infos)},
+    acceleration_structure_infos{std::move(other.acceleration_structure_infos)},
     handle{other.handle},
     write_descriptor_sets{std::move(other.write_descriptor_sets)},
-    updated_bindings{std::move(other.updated_bindings)}
+    acceleration_structure_writes{std::move(other.acceleration_structure_writes)},
+    updated_bindings{std::move(other.updated_bindings)},
+    template_data{std::move(other.template_data)}
 {
 	other.handle = VK_NULL_HANDLE;
 }
@@ -227,4 +361,9 @@ BindingMap<VkDescriptorImageInfo> &DescriptorSet::get_image_infos()
 	return image_infos;
 }
 
+BindingMap<VkAccelerationStructureKHR> &DescriptorSet::get_acceleration_structure_infos()
+{
+	return acceleration_structure_infos;
+}
+
 }        // namespace vkb
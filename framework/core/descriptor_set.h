@@ -43,12 +43,14 @@ class DescriptorSet
 	 * @param descriptor_pool The Vulkan descriptor pool the descriptor set is allocated from
 	 * @param buffer_infos The descriptors that describe buffer data
 	 * @param image_infos The descriptors that describe image data
+	 * @param acceleration_structure_infos The acceleration structures bound to acceleration structure descriptors
 	 */
-	DescriptorSet(Device &                                  device,
-	              DescriptorSetLayout &                     descriptor_set_layout,
-	              DescriptorPool &                          descriptor_pool,
-	              const BindingMap<VkDescriptorBufferInfo> &buffer_infos = {},
-	              const BindingMap<VkDescriptorImageInfo> & image_infos  = {});
+	DescriptorSet(Device &                                      device,
+	              DescriptorSetLayout &                         descriptor_set_layout,
+	              DescriptorPool &                              descriptor_pool,
+	              const BindingMap<VkDescriptorBufferInfo> &    buffer_infos                 = {},
+	              const BindingMap<VkDescriptorImageInfo> &     image_infos                  = {},
+	              const BindingMap<VkAccelerationStructureKHR> &acceleration_structure_infos = {});
 
 	DescriptorSet(const DescriptorSet &) = delete;
 
@@ -66,12 +68,15 @@ class DescriptorSet
 	 *        Optionally prepares a new set of buffer infos and/or image infos
 	 * @param new_buffer_infos A map of buffer descriptors and their respective bindings
 	 * @param new_image_infos A map of image descriptors and their respective bindings
+	 * @param new_acceleration_structure_infos A map of acceleration structures and their respective bindings
 	 */
-	void reset(const BindingMap<VkDescriptorBufferInfo> &new_buffer_infos = {},
-	           const BindingMap<VkDescriptorImageInfo> & new_image_infos  = {});
+	void reset(const BindingMap<VkDescriptorBufferInfo> &    new_buffer_infos                 = {},
+	           const BindingMap<VkDescriptorImageInfo> &     new_image_infos                  = {},
+	           const BindingMap<VkAccelerationStructureKHR> &new_acceleration_structure_infos = {});
 
 	/**
 	 * @brief Updates the contents of the DescriptorSet by performing the write operations
+	 *        A set updated as a whole is written in a single call through the update template of its layout, when it provides every descriptor
 	 * @param bindings_to_update If empty. we update all bindings. Otherwise, only write the specified bindings if they haven't already been written
 	 */
 	void update(const std::vector<uint32_t> &bindings_to_update = {});
@@ -84,6 +89,8 @@ class DescriptorSet
 
 	BindingMap<VkDescriptorImageInfo> &get_image_infos();
 
+	BindingMap<VkAccelerationStructureKHR> &get_acceleration_structure_infos();
+
   protected:
 	/**
 	 * @brief Prepares the descriptor set to have its contents updated by loading a vector of write operations
@@ -92,6 +99,12 @@ class DescriptorSet
 	void prepare();
 
   private:
+	/**
+	 * @brief Packs the descriptor infos at the offsets of the layout's update template
+	 *        Leaves the packed data empty if the layout has no template or a descriptor of the set is missing
+	 */
+	void prepare_template_data();
+
 	Device &device;
 
 	DescriptorSetLayout &descriptor_set_layout;
@@ -102,11 +115,19 @@ class DescriptorSet
 
 	BindingMap<VkDescriptorImageInfo> image_infos;
 
+	BindingMap<VkAccelerationStructureKHR> acceleration_structure_infos;
+
 	VkDescriptorSet handle{VK_NULL_HANDLE};
 
 	// The list of write operations for the descriptor set
 	std::vector<VkWriteDescriptorSet> write_descriptor_sets;
 
+	// The acceleration structure writes chained to the write operations of acceleration structure descriptors
+	std::vector<VkWriteDescriptorSetAccelerationStructureKHR> acceleration_structure_writes;
+
+	// The descriptor infos packed for vkUpdateDescriptorSetWithTemplate, empty if the set is updated with the write operations
+	std::vector<uint8_t> template_data;
+
 	// The bindings of the write descriptors that have had vkUpdateDescriptorSets since the last call to update()
 	std::vector<uint32_t> updated_bindings;
 };
@@ -64,6 +64,9 @@ inline VkDescriptorType find_descriptor_type(ShaderResourceType resource_type, b
 				return VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
 			}
 			break;
+		case ShaderResourceType::AccelerationStructure:
+			return VK_DESCRIPTOR_TYPE_ACCELERATION_STRUCTURE_KHR;
+			break;
 		default:
 			throw std::runtime_error("No conversion possible for the shader resource type.");
 			break;
@@ -92,6 +95,28 @@ inline bool validate_flags(const PhysicalDevice &gpu, const std::vector<VkDescri
 
 	return true;
 }
+
+inline size_t get_update_template_stride(VkDescriptorType descriptor_type)
+{
+	switch (descriptor_type)
+	{
+		case VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER:
+		case VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC:
+		case VK_DESCRIPTOR_TYPE_STORAGE_BUFFER:
+		case VK_DESCRIPTOR_TYPE_STORAGE_BUFFER_DYNAMIC:
+			return sizeof(VkDescriptorBufferInfo);
+		case VK_DESCRIPTOR_TYPE_SAMPLER:
+		case VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER:
+		case VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE:
+		case VK_DESCRIPTOR_TYPE_STORAGE_IMAGE:
+		case VK_DESCRIPTOR_TYPE_INPUT_ATTACHMENT:
+			return sizeof(VkDescriptorImageInfo);
+		case VK_DESCRIPTOR_TYPE_ACCELERATION_STRUCTURE_KHR:
+			return sizeof(VkAccelerationStructureKHR);
+		default:
+			return 0;
+	}
+}
 }        // namespace
 
 DescriptorSetLayout::DescriptorSetLayout(Device &device, const uint32_t set_index, const std::vector<ShaderResource> &resource_set) :
@@ -147,6 +172,28 @@ DescriptorSetLayout::DescriptorSetLayout(Device &device, const uint32_t set_inde
 	create_info.bindingCount = to_u32(bindings.size());
 	create_info.pBindings    = bindings.data();
 
+	// A resource in push mode makes the whole set a push descriptor set
+	if (std::find_if(resource_set.begin(), resource_set.end(),
+	                 [](const ShaderResource &shader_resource) { return shader_resource.mode == ShaderResourceMode::Push; }) != resource_set.end())
+	{
+		if (std::find_if(resource_set.begin(), resource_set.end(),
+		                 [](const ShaderResource &shader_resource) { return shader_resource.mode == ShaderResourceMode::Dynamic || shader_resource.mode == ShaderResourceMode::UpdateAfterBind; }) != resource_set.end())
+		{
+			throw std::runtime_error("Cannot create descriptor set layout, dynamic and update-after-bind resources are not allowed in a push descriptor set.");
+		}
+
+		if (device.is_enabled(VK_KHR_PUSH_DESCRIPTOR_EXTENSION_NAME))
+		{
+			push_descriptor = true;
+
+			create_info.flags |= VK_DESCRIPTOR_SET_LAYOUT_CREATE_PUSH_DESCRIPTOR_BIT_KHR;
+		}
+		else
+		{
+			LOGW("Descriptor set {} is allocated from a pool, {} is not enabled", set_index, VK_KHR_PUSH_DESCRIPTOR_EXTENSION_NAME);
+		}
+	}
+
 	// Handle update-after-bind extensions
 	if (std::find_if(resource_set.begin(), resource_set.end(),
 	                 [](const ShaderResource &shader_resource) { return shader_resource.mode == ShaderResourceMode::UpdateAfterBind; }) != resource_set.end())
@@ -178,23 +225,122 @@ DescriptorSetLayout::DescriptorSetLayout(Device &device, const uint32_t set_inde
 	{
 		throw VulkanException{result, "Cannot create DescriptorSetLayout"};
 	}
+
+	create_update_template();
+}
+
+void DescriptorSetLayout::create_update_template()
+{
+	// Push descriptor sets are written into the command buffers, and update-after-bind sets are updated a few elements at a time
+	if (push_descriptor || !device.is_enabled(VK_KHR_DESCRIPTOR_UPDATE_TEMPLATE_EXTENSION_NAME) ||
+	    std::find_if(binding_flags.begin(), binding_flags.end(), [](VkDescriptorBindingFlagsEXT flags) { return flags != 0; }) != binding_flags.end())
+	{
+		return;
+	}
+
+	size_t offset = 0;
+
+	for (auto &binding : bindings)
+	{
+		if (binding.descriptorCount == 0)
+		{
+			continue;
+		}
+
+		auto stride = get_update_template_stride(binding.descriptorType);
+
+		if (stride == 0)
+		{
+			update_template_entries.clear();
+			return;
+		}
+
+		// Keep every entry aligned for the 64-bit handles and sizes of the descriptor infos
+		offset = (offset + alignof(VkDescriptorBufferInfo) - 1) & ~(alignof(VkDescriptorBufferInfo) - 1);
+
+		VkDescriptorUpdateTemplateEntryKHR entry{};
+		entry.dstBinding      = binding.binding;
+		entry.dstArrayElement = 0;
+		entry.descriptorCount = binding.descriptorCount;
+		entry.descriptorType  = binding.descriptorType;
+		entry.offset          = offset;
+		entry.stride          = stride;
+
+		update_template_entries.push_back(entry);
+
+		offset += stride * binding.descriptorCount;
+	}
+
+	if (update_template_entries.empty())
+	{
+		return;
+	}
+
+	VkDescriptorUpdateTemplateCreateInfoKHR create_info{VK_STRUCTURE_TYPE_DESCRIPTOR_UPDATE_TEMPLATE_CREATE_INFO_KHR};
+	create_info.descriptorUpdateEntryCount = to_u32(update_template_entries.size());
+	create_info.pDescriptorUpdateEntries   = update_template_entries.data();
+	create_info.templateType               = VK_DESCRIPTOR_UPDATE_TEMPLATE_TYPE_DESCRIPTOR_SET_KHR;
+	create_info.descriptorSetLayout        = handle;
+
+	VkResult result = vkCreateDescriptorUpdateTemplateKHR(device.get_handle(), &create_info, nullptr, &update_template);
+
+	if (result != VK_SUCCESS)
+	{
+		LOGW("Cannot create descriptor update template for set {}, falling back to write operations", set_index);
+
+		update_template = VK_NULL_HANDLE;
+		update_template_entries.clear();
+		return;
+	}
+
+	update_template_size = offset;
 }
 
 DescriptorSetLayout::DescriptorSetLayout(DescriptorSetLayout &&other) :
     device{other.device},
     handle{other.handle},
     set_index{other.set_index},
+    push_descriptor{other.push_descriptor},
     bindings{std::move(other.bindings)},
     binding_flags{std::move(other.binding_flags)},
     bindings_lookup{std::move(other.bindings_lookup)},
     binding_flags_lookup{std::move(other.binding_flags_lookup)},
-    resources_lookup{std::move(other.resources_lookup)}
+    resources_lookup{std::move(other.resources_lookup)},
+    update_template{other.update_template},
+    update_template_entries{std::move(other.update_template_entries)},
+    update_template_size{other.update_template_size}
+{
+	other.handle          = VK_NULL_HANDLE;
+	other.update_template = VK_NULL_HANDLE;
+}
+
+bool DescriptorSetLayout::is_push_descriptor() const
 {
-	other.handle = VK_NULL_HANDLE;
+	return push_descriptor;
+}
+
+VkDescriptorUpdateTemplateKHR DescriptorSetLayout::get_update_template() const
+{
+	return update_template;
+}
+
+const std::vector<VkDescriptorUpdateTemplateEntryKHR> &DescriptorSetLayout::get_update_template_entries() const
+{
+	return update_template_entries;
+}
+
+size_t DescriptorSetLayout::get_update_template_size() const
+{
+	return update_template_size;
 }
 
 DescriptorSetLayout::~DescriptorSetLayout()
 {
+	if (update_template != VK_NULL_HANDLE)
+	{
+		vkDestroyDescriptorUpdateTemplateKHR(device.get_handle(), update_template, nullptr);
+	}
+
 	// Destroy descriptor set layout
 	if (handle != VK_NULL_HANDLE)
 	{
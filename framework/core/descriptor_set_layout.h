@@ -66,13 +66,41 @@ class DescriptorSetLayout
 
 	VkDescriptorBindingFlagsEXT get_layout_binding_flag(const uint32_t binding_index) const;
 
+	/**
+	 * @return True if the descriptors of the set are pushed into command buffers instead of being allocated from a pool
+	 */
+	bool is_push_descriptor() const;
+
+	/**
+	 * @return The template descriptor sets of this layout are updated with, or a null handle if they are updated with write operations
+	 */
+	VkDescriptorUpdateTemplateKHR get_update_template() const;
+
+	/**
+	 * @return The entries of the update template, mapping each binding to its offset and stride in the packed descriptor data
+	 */
+	const std::vector<VkDescriptorUpdateTemplateEntryKHR> &get_update_template_entries() const;
+
+	/**
+	 * @return The size in bytes of the packed descriptor data read by the update template
+	 */
+	size_t get_update_template_size() const;
+
   private:
+	/**
+	 * @brief Creates the update template covering every binding of the layout
+	 *        Leaves the template null if a binding cannot be packed, the sets then fall back to write operations
+	 */
+	void create_update_template();
+
 	Device &device;
 
 	VkDescriptorSetLayout handle{VK_NULL_HANDLE};
 
 	const uint32_t set_index;
 
+	bool push_descriptor{false};
+
 	std::vector<VkDescriptorSetLayoutBinding> bindings;
 
 	std::vector<VkDescriptorBindingFlagsEXT> binding_flags;
@@ -82,5 +110,11 @@ class DescriptorSetLayout
 	std::unordered_map<uint32_t, VkDescriptorBindingFlagsEXT> binding_flags_lookup;
 
 	std::unordered_map<std::string, uint32_t> resources_lookup;
+
+	VkDescriptorUpdateTemplateKHR update_template{VK_NULL_HANDLE};
+
+	std::vector<VkDescriptorUpdateTemplateEntryKHR> update_template_entries;
+
+	size_t update_template_size{0};
 };
 }        // namespace vkb
@@ -0,0 +1,153 @@
+/* Copyright (c) 2020, Arm Limited and Contributors
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 the "License";
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "destruction_queue.h"
+
+#include "core/device.h"
+
+namespace vkb
+{
+DestructionQueue::DestructionQueue(Device &device) :
+    device{device}
+{
+	for (auto &queue_family_properties : device.get_gpu().get_queue_family_properties())
+	{
+		fenced_submit_counts.emplace_back(queue_family_properties.queueCount, 0);
+	}
+}
+
+DestructionQueue::~DestructionQueue()
+{
+	device.wait_idle();
+
+	for (auto &batch : batches)
+	{
+		for (auto fence : batch.fences)
+		{
+			device.get_transient_fence_pool().wait(fence);
+		}
+
+		for (auto &destructor : batch.destructors)
+		{
+			destructor();
+		}
+	}
+
+	for (auto &destructor : pending_destructors)
+	{
+		destructor();
+	}
+}
+
+void DestructionQueue::defer(std::function<void()> &&destructor)
+{
+	std::lock_guard<std::mutex> lock{mutex};
+
+	pending_destructors.push_back(std::move(destructor));
+}
+
+void DestructionQueue::update()
+{
+	std::vector<std::function<void()>> released;
+
+	{
+		std::lock_guard<std::mutex> lock{mutex};
+
+		if (!pending_destructors.empty())
+		{
+			Batch batch;
+			batch.destructors = std::move(pending_destructors);
+			batch.fences      = submit_fences();
+
+			pending_destructors.clear();
+			batches.push_back(std::move(batch));
+		}
+
+		// Batches are fenced in order, so later ones can not complete first
+		while (!batches.empty())
+		{
+			auto &fences = batches.front().fences;
+
+			fences.erase(std::remove_if(fences.begin(), fences.end(),
+			                            [this](VkFence fence) { return device.get_transient_fence_pool().wait(fence, 0) == VK_SUCCESS; }),
+			             fences.end());
+
+			if (!fences.empty())
+			{
+				break;
+			}
+
+			for (auto &destructor : batches.front().destructors)
+			{
+				released.push_back(std::move(destructor));
+			}
+
+			batches.pop_front();
+		}
+	}
+
+	// Destructors run without the lock, so that they can queue further resources
+	for (auto &destructor : released)
+	{
+		destructor();
+	}
+}
+
+size_t DestructionQueue::get_pending_count() const
+{
+	std::lock_guard<std::mutex> lock{mutex};
+
+	size_t count = pending_destructors.size();
+
+	for (auto &batch : batches)
+	{
+		count += batch.destructors.size();
+	}
+
+	return count;
+}
+
+std::vector<VkFence> DestructionQueue::submit_fences()
+{
+	std::vector<VkFence> fences;
+
+	for (uint32_t family_index = 0; family_index < fenced_submit_counts.size(); ++family_index)
+	{
+		auto &submit_counts = fenced_submit_counts[family_index];
+
+		for (uint32_t queue_index = 0; queue_index < submit_counts.size(); ++queue_index)
+		{
+			auto &queue = device.get_queue(family_index, queue_index);
+
+			if (queue_index > 0 && queue.get_submit_count() == submit_counts[queue_index])
+			{
+				continue;
+			}
+
+			// An empty submission signals its fence once the previous submissions of the queue complete
+			VkFence fence = device.get_transient_fence_pool().request_fence();
+			VK_CHECK(queue.submit(std::vector<VkSubmitInfo>{}, fence));
+
+			submit_counts[queue_index] = queue.get_submit_count();
+
+			fences.push_back(fence);
+		}
+	}
+
+	return fences;
+}
+}        // namespace vkb
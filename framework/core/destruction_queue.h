@@ -0,0 +1,118 @@
+/* Copyright (c) 2020, Arm Limited and Contributors
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 the "License";
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+#include "common/vk_common.h"
+
+namespace vkb
+{
+class Device;
+
+/**
+ * @brief Releases resources once the GPU has finished the work submitted while they were in use, without waiting for the device
+ *
+ * Resources given to the queue form a batch which update() closes by submitting a fence to the queues of the device,
+ * signaled when their previous submissions complete. Batches whose fences are signaled are released by later updates.
+ * The first queue of every family is always fenced, as many samples submit to it directly, other queues only when
+ * they submitted through Queue since their last fence. Queuing resources is thread-safe.
+ */
+class DestructionQueue
+{
+  public:
+	DestructionQueue(Device &device);
+
+	DestructionQueue(const DestructionQueue &) = delete;
+
+	DestructionQueue(DestructionQueue &&) = delete;
+
+	/**
+	 * @brief Waits for the device, then releases all the queued resources
+	 */
+	~DestructionQueue();
+
+	DestructionQueue &operator=(const DestructionQueue &) = delete;
+
+	DestructionQueue &operator=(DestructionQueue &&) = delete;
+
+	/**
+	 * @brief Keeps an object alive until the work submitted so far completes, then destroys it
+	 * @param object An object owning Vulkan resources, such as a core::Buffer, a core::Image or a unique pointer to them
+	 */
+	template <class T>
+	void destroy(T &&object)
+	{
+		auto kept = std::make_shared<typename std::decay<T>::type>(std::forward<T>(object));
+		defer([kept]() {});
+	}
+
+	/**
+	 * @brief Calls a function once the work submitted so far completes
+	 * @param destructor The function destroying the resources, such as Vulkan handles
+	 */
+	void defer(std::function<void()> &&destructor);
+
+	/**
+	 * @brief Fences the resources queued since the last update, and releases those the GPU has finished with
+	 *        Does not block, it should be called after the submissions of each frame.
+	 */
+	void update();
+
+	/**
+	 * @return The number of resources queued and not released yet
+	 */
+	size_t get_pending_count() const;
+
+  private:
+	/**
+	 * @brief Resources released together once fences of the queues are signaled
+	 */
+	struct Batch
+	{
+		std::vector<std::function<void()>> destructors;
+
+		/// Fences not signaled yet, requested from the transient fence pool of the device
+		std::vector<VkFence> fences;
+	};
+
+	/**
+	 * @brief Submits a fence to every queue which may have used the resources
+	 * @return The fences submitted
+	 */
+	std::vector<VkFence> submit_fences();
+
+	Device &device;
+
+	/// Guards the queued resources
+	mutable std::mutex mutex;
+
+	/// Resources queued since the last update
+	std::vector<std::function<void()>> pending_destructors;
+
+	/// Fenced batches, oldest first
+	std::deque<Batch> batches;
+
+	/// Submit count of every queue of the device when it was last fenced, by family
+	std::vector<std::vector<uint64_t>> fenced_submit_counts;
+};
+}        // namespace vkb
@@ -18,6 +18,14 @@
 
 #include "device.h"
 
+#include <algorithm>
+#include <cstring>
+
+#include "core/geometry_allocator.h"
+#include "core/memory_pools.h"
+#include "core/staging_manager.h"
+#include "platform/filesystem.h"
+
 VKBP_DISABLE_WARNINGS()
 #define VMA_IMPLEMENTATION
 #include <vk_mem_alloc.h>
@@ -25,12 +33,24 @@ VKBP_ENABLE_WARNINGS()
 
 namespace vkb
 {
-Device::Device(PhysicalDevice &gpu, VkSurfaceKHR surface, std::unordered_map<const char *, bool> requested_extensions) :
+namespace
+{
+bool is_extension_requested(const std::unordered_map<const char *, bool> &requested_extensions, const char *extension)
+{
+	return std::any_of(requested_extensions.begin(), requested_extensions.end(), [extension](const std::pair<const char *const, bool> &requested_extension) {
+		return std::strcmp(requested_extension.first, extension) == 0;
+	});
+}
+}        // namespace
+
+Device::Device(PhysicalDevice &gpu, VkSurfaceKHR surface, std::unordered_map<const char *, bool> requested_extensions, const std::vector<PhysicalDevice *> &gpu_group) :
     gpu{gpu},
     resource_cache{*this}
 {
 	LOGI("Selected GPU: {}", gpu.get_properties().deviceName);
 
+	debug_utils = gpu.get_instance().is_enabled(VK_EXT_DEBUG_UTILS_EXTENSION_NAME);
+
 	// Prepare the device queues
 	uint32_t                             queue_family_properties_count = to_u32(gpu.get_queue_family_properties().size());
 	std::vector<VkDeviceQueueCreateInfo> queue_create_infos(queue_family_properties_count, {VK_STRUCTURE_TYPE_DEVICE_QUEUE_CREATE_INFO});
@@ -49,17 +69,11 @@ Device::Device(PhysicalDevice &gpu, VkSurfaceKHR surface, std::unordered_map<con
 		queue_create_info.pQueuePriorities = queue_priorities[queue_family_index].data();
 	}
 
-	// Check extensions to enable Vma Dedicated Allocation
-	uint32_t device_extension_count;
-	VK_CHECK(vkEnumerateDeviceExtensionProperties(gpu.get_handle(), nullptr, &device_extension_count, nullptr));
-	device_extensions = std::vector<VkExtensionProperties>(device_extension_count);
-	VK_CHECK(vkEnumerateDeviceExtensionProperties(gpu.get_handle(), nullptr, &device_extension_count, device_extensions.data()));
-
 	// Display supported extensions
-	if (device_extensions.size() > 0)
+	if (gpu.get_extensions().size() > 0)
 	{
 		LOGD("Device supports the following extensions:");
-		for (auto &extension : device_extensions)
+		for (auto &extension : gpu.get_extensions())
 		{
 			LOGD("  \t{}", extension.extensionName);
 		}
@@ -76,6 +90,28 @@ Device::Device(PhysicalDevice &gpu, VkSurfaceKHR surface, std::unordered_map<con
 		LOGI("Dedicated Allocation enabled");
 	}
 
+	// Descriptor update templates let descriptor sets be written from a packed block of descriptor infos
+	if (is_extension_supported(VK_KHR_DESCRIPTOR_UPDATE_TEMPLATE_EXTENSION_NAME) &&
+	    !is_extension_requested(requested_extensions, VK_KHR_DESCRIPTOR_UPDATE_TEMPLATE_EXTENSION_NAME))
+	{
+		enabled_extensions.push_back(VK_KHR_DESCRIPTOR_UPDATE_TEMPLATE_EXTENSION_NAME);
+
+		LOGI("Descriptor update templates enabled");
+	}
+
+	bool can_request_features = gpu.get_instance().is_enabled(VK_KHR_GET_PHYSICAL_DEVICE_PROPERTIES_2_EXTENSION_NAME);
+
+	// Memory budget lets the allocator report the usage and budget of each heap as seen by the driver,
+	// which includes the memory of other processes
+	bool has_memory_budget = can_request_features && is_extension_supported(VK_EXT_MEMORY_BUDGET_EXTENSION_NAME);
+
+	if (has_memory_budget)
+	{
+		enabled_extensions.push_back(VK_EXT_MEMORY_BUDGET_EXTENSION_NAME);
+
+		LOGI("Memory budget enabled");
+	}
+
 	// For performance queries, we also use host query reset since queryPool resets cannot
 	// live in the same command buffer as beginQuery
 	if (is_extension_supported("VK_KHR_performance_query") &&
@@ -92,6 +128,158 @@ Device::Device(PhysicalDevice &gpu, VkSurfaceKHR surface, std::unordered_map<con
 		}
 	}
 
+	// Extended dynamic state lets command buffers share pipelines differing by their cull mode and depth stencil state
+	if (can_request_features && is_extension_supported(VK_EXT_EXTENDED_DYNAMIC_STATE_EXTENSION_NAME) &&
+	    !is_extension_requested(requested_extensions, VK_EXT_EXTENDED_DYNAMIC_STATE_EXTENSION_NAME))
+	{
+		auto &extended_dynamic_state_features = gpu.request_extension_features<VkPhysicalDeviceExtendedDynamicStateFeaturesEXT>(VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_EXTENDED_DYNAMIC_STATE_FEATURES_EXT);
+
+		if (extended_dynamic_state_features.extendedDynamicState)
+		{
+			enabled_extensions.push_back(VK_EXT_EXTENDED_DYNAMIC_STATE_EXTENSION_NAME);
+			LOGI("Extended dynamic state enabled");
+		}
+	}
+
+	// Timeline semaphores let the render context pace frames with a single semaphore instead of fences
+	if (can_request_features && is_extension_supported(VK_KHR_TIMELINE_SEMAPHORE_EXTENSION_NAME) &&
+	    !is_extension_requested(requested_extensions, VK_KHR_TIMELINE_SEMAPHORE_EXTENSION_NAME))
+	{
+		auto &timeline_semaphore_features = gpu.request_extension_features<VkPhysicalDeviceTimelineSemaphoreFeaturesKHR>(VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_TIMELINE_SEMAPHORE_FEATURES_KHR);
+
+		if (timeline_semaphore_features.timelineSemaphore)
+		{
+			enabled_extensions.push_back(VK_KHR_TIMELINE_SEMAPHORE_EXTENSION_NAME);
+			LOGI("Timeline semaphore enabled");
+		}
+	}
+
+	// Dynamic rendering lets render pipelines draw single subpasses without render pass and framebuffer objects,
+	// the extensions it depends on are core in Vulkan 1.2 but enabled here for 1.1 devices
+	if (can_request_features && is_extension_supported(VK_KHR_DYNAMIC_RENDERING_EXTENSION_NAME) &&
+	    is_extension_supported(VK_KHR_DEPTH_STENCIL_RESOLVE_EXTENSION_NAME) && is_extension_supported(VK_KHR_CREATE_RENDERPASS_2_EXTENSION_NAME) &&
+	    !is_extension_requested(requested_extensions, VK_KHR_DYNAMIC_RENDERING_EXTENSION_NAME))
+	{
+		auto &dynamic_rendering_features = gpu.request_extension_features<VkPhysicalDeviceDynamicRenderingFeaturesKHR>(VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_DYNAMIC_RENDERING_FEATURES_KHR);
+
+		if (dynamic_rendering_features.dynamicRendering)
+		{
+			for (auto extension : {VK_KHR_MULTIVIEW_EXTENSION_NAME, VK_KHR_MAINTENANCE2_EXTENSION_NAME, VK_KHR_CREATE_RENDERPASS_2_EXTENSION_NAME, VK_KHR_DEPTH_STENCIL_RESOLVE_EXTENSION_NAME})
+			{
+				if (is_extension_supported(extension) && !is_extension_requested(requested_extensions, extension))
+				{
+					enabled_extensions.push_back(extension);
+				}
+			}
+
+			enabled_extensions.push_back(VK_KHR_DYNAMIC_RENDERING_EXTENSION_NAME);
+			LOGI("Dynamic rendering enabled");
+		}
+	}
+
+	// Fragment shading rate lets subpasses shade fewer pixels where detail is low, the render passes using
+	// a shading rate attachment are created with vkCreateRenderPass2, which the extension depends on
+	if (can_request_features && is_extension_supported(VK_KHR_FRAGMENT_SHADING_RATE_EXTENSION_NAME) &&
+	    is_extension_supported(VK_KHR_CREATE_RENDERPASS_2_EXTENSION_NAME) &&
+	    !is_extension_requested(requested_extensions, VK_KHR_FRAGMENT_SHADING_RATE_EXTENSION_NAME))
+	{
+		auto &fragment_shading_rate_features = gpu.request_extension_features<VkPhysicalDeviceFragmentShadingRateFeaturesKHR>(VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_FRAGMENT_SHADING_RATE_FEATURES_KHR);
+
+		if (fragment_shading_rate_features.pipelineFragmentShadingRate)
+		{
+			for (auto extension : {VK_KHR_MULTIVIEW_EXTENSION_NAME, VK_KHR_MAINTENANCE2_EXTENSION_NAME, VK_KHR_CREATE_RENDERPASS_2_EXTENSION_NAME})
+			{
+				// The dependencies may already be enabled for dynamic rendering
+				if (is_extension_supported(extension) && !is_extension_requested(requested_extensions, extension) && !is_enabled(extension))
+				{
+					enabled_extensions.push_back(extension);
+				}
+			}
+
+			enabled_extensions.push_back(VK_KHR_FRAGMENT_SHADING_RATE_EXTENSION_NAME);
+			LOGI("Fragment shading rate enabled");
+		}
+	}
+
+	// Descriptor indexing lets the indirect draws of a geometry subpass index material textures non uniformly from a
+	// bindless array, the features are requested whenever the extension is supported, as samples may enable it themselves
+	if (can_request_features && is_extension_supported(VK_EXT_DESCRIPTOR_INDEXING_EXTENSION_NAME) && is_extension_supported(VK_KHR_MAINTENANCE3_EXTENSION_NAME))
+	{
+		auto &descriptor_indexing_features = gpu.request_extension_features<VkPhysicalDeviceDescriptorIndexingFeaturesEXT>(VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_DESCRIPTOR_INDEXING_FEATURES_EXT);
+
+		if (descriptor_indexing_features.shaderSampledImageArrayNonUniformIndexing)
+		{
+			for (auto extension : {VK_KHR_MAINTENANCE3_EXTENSION_NAME, VK_EXT_DESCRIPTOR_INDEXING_EXTENSION_NAME})
+			{
+				if (!is_extension_requested(requested_extensions, extension) && !is_enabled(extension))
+				{
+					enabled_extensions.push_back(extension);
+				}
+			}
+
+			LOGI("Descriptor indexing enabled");
+		}
+	}
+
+	// Multiview lets a subpass draw the views of several cameras into the layers of its attachments at once,
+	// the extension may already be enabled as a dependency, but its feature is only requested here
+	if (can_request_features && is_extension_supported(VK_KHR_MULTIVIEW_EXTENSION_NAME))
+	{
+		auto &multiview_features = gpu.request_extension_features<VkPhysicalDeviceMultiviewFeaturesKHR>(VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_MULTIVIEW_FEATURES_KHR);
+
+		if (multiview_features.multiview)
+		{
+			if (!is_extension_requested(requested_extensions, VK_KHR_MULTIVIEW_EXTENSION_NAME) && !is_enabled(VK_KHR_MULTIVIEW_EXTENSION_NAME))
+			{
+				enabled_extensions.push_back(VK_KHR_MULTIVIEW_EXTENSION_NAME);
+			}
+
+			LOGI("Multiview enabled");
+		}
+	}
+
+	// Subgroup size control lets compute pipelines require the subgroup size their kernels are tuned for
+	if (can_request_features && gpu.get_properties().apiVersion >= VK_API_VERSION_1_1 &&
+	    is_extension_supported(VK_EXT_SUBGROUP_SIZE_CONTROL_EXTENSION_NAME) &&
+	    !is_extension_requested(requested_extensions, VK_EXT_SUBGROUP_SIZE_CONTROL_EXTENSION_NAME))
+	{
+		auto &subgroup_size_control_features = gpu.request_extension_features<VkPhysicalDeviceSubgroupSizeControlFeaturesEXT>(VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_SUBGROUP_SIZE_CONTROL_FEATURES_EXT);
+
+		if (subgroup_size_control_features.subgroupSizeControl)
+		{
+			enabled_extensions.push_back(VK_EXT_SUBGROUP_SIZE_CONTROL_EXTENSION_NAME);
+			LOGI("Subgroup size control enabled");
+		}
+	}
+
+	// Image compression control lets images be asked whether the driver compresses them
+	if (can_request_features && is_extension_supported(VK_EXT_IMAGE_COMPRESSION_CONTROL_EXTENSION_NAME) &&
+	    !is_extension_requested(requested_extensions, VK_EXT_IMAGE_COMPRESSION_CONTROL_EXTENSION_NAME))
+	{
+		auto &image_compression_control_features = gpu.request_extension_features<VkPhysicalDeviceImageCompressionControlFeaturesEXT>(VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_IMAGE_COMPRESSION_CONTROL_FEATURES_EXT);
+
+		if (image_compression_control_features.imageCompressionControl)
+		{
+			enabled_extensions.push_back(VK_EXT_IMAGE_COMPRESSION_CONTROL_EXTENSION_NAME);
+			LOGI("Image compression control enabled");
+		}
+	}
+
+	// Present wait lets the render context measure when frames reach the display
+	if (can_request_features && is_extension_supported(VK_KHR_PRESENT_ID_EXTENSION_NAME) && is_extension_supported(VK_KHR_PRESENT_WAIT_EXTENSION_NAME) &&
+	    !is_extension_requested(requested_extensions, VK_KHR_PRESENT_ID_EXTENSION_NAME) && !is_extension_requested(requested_extensions, VK_KHR_PRESENT_WAIT_EXTENSION_NAME))
+	{
+		auto &present_id_features   = gpu.request_extension_features<VkPhysicalDevicePresentIdFeaturesKHR>(VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_PRESENT_ID_FEATURES_KHR);
+		auto &present_wait_features = gpu.request_extension_features<VkPhysicalDevicePresentWaitFeaturesKHR>(VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_PRESENT_WAIT_FEATURES_KHR);
+
+		if (present_id_features.presentId && present_wait_features.presentWait)
+		{
+			enabled_extensions.push_back(VK_KHR_PRESENT_ID_EXTENSION_NAME);
+			enabled_extensions.push_back(VK_KHR_PRESENT_WAIT_EXTENSION_NAME);
+			LOGI("Present wait enabled");
+		}
+	}
+
 	// Check that extensions are supported before trying to create the device
 	std::vector<const char *> unsupported_extensions{};
 	for (auto &extension : requested_extensions)
@@ -143,6 +331,32 @@ Device::Device(PhysicalDevice &gpu, VkSurfaceKHR surface, std::unordered_map<con
 	// Latest requested feature will have the pNext's all set up for device creation.
 	create_info.pNext = gpu.get_extension_feature_chain();
 
+	// The physical devices of a group share the logical device, the first one being gpu
+	std::vector<VkPhysicalDevice>    group_devices;
+	VkDeviceGroupDeviceCreateInfoKHR group_info{VK_STRUCTURE_TYPE_DEVICE_GROUP_DEVICE_CREATE_INFO_KHR};
+
+	if (gpu_group.size() > 1 && is_enabled(VK_KHR_DEVICE_GROUP_EXTENSION_NAME))
+	{
+		group_devices.push_back(gpu.get_handle());
+
+		for (auto *group_gpu : gpu_group)
+		{
+			if (group_gpu != &gpu)
+			{
+				group_devices.push_back(group_gpu->get_handle());
+			}
+		}
+
+		group_info.pNext               = create_info.pNext;
+		group_info.physicalDeviceCount = to_u32(group_devices.size());
+		group_info.pPhysicalDevices    = group_devices.data();
+
+		create_info.pNext = &group_info;
+		device_count      = group_info.physicalDeviceCount;
+
+		LOGI("Combining {} GPUs of a device group", device_count);
+	}
+
 	create_info.pQueueCreateInfos       = queue_create_infos.data();
 	create_info.queueCreateInfoCount    = to_u32(queue_create_infos.size());
 	create_info.enabledExtensionCount   = to_u32(enabled_extensions.size());
@@ -178,6 +392,16 @@ Device::Device(PhysicalDevice &gpu, VkSurfaceKHR surface, std::unordered_map<con
 		}
 	}
 
+	assign_queue_roles();
+
+	if (device_count > 1 && surface != VK_NULL_HANDLE)
+	{
+		VkDeviceGroupPresentCapabilitiesKHR present_capabilities{VK_STRUCTURE_TYPE_DEVICE_GROUP_PRESENT_CAPABILITIES_KHR};
+		VK_CHECK(vkGetDeviceGroupPresentCapabilitiesKHR(handle, &present_capabilities));
+
+		device_group_present_modes = present_capabilities.modes;
+	}
+
 	VmaVulkanFunctions vma_vulkan_func{};
 	vma_vulkan_func.vkAllocateMemory                    = vkAllocateMemory;
 	vma_vulkan_func.vkBindBufferMemory                  = vkBindBufferMemory;
@@ -214,6 +438,12 @@ Device::Device(PhysicalDevice &gpu, VkSurfaceKHR surface, std::unordered_map<con
 		allocator_info.flags |= VMA_ALLOCATOR_CREATE_BUFFER_DEVICE_ADDRESS_BIT;
 	}
 
+	if (has_memory_budget)
+	{
+		allocator_info.flags |= VMA_ALLOCATOR_CREATE_EXT_MEMORY_BUDGET_BIT;
+		vma_vulkan_func.vkGetPhysicalDeviceMemoryProperties2KHR = vkGetPhysicalDeviceMemoryProperties2KHR;
+	}
+
 	allocator_info.pVulkanFunctions = &vma_vulkan_func;
 
 	result = vmaCreateAllocator(&allocator_info, &memory_allocator);
@@ -223,16 +453,33 @@ Device::Device(PhysicalDevice &gpu, VkSurfaceKHR surface, std::unordered_map<con
 		throw VulkanException{result, "Cannot create allocator"};
 	}
 
+	memory_pools = std::make_unique<MemoryPools>(*this);
+
 	command_pool = std::make_unique<CommandPool>(*this, get_queue_by_flags(VK_QUEUE_GRAPHICS_BIT | VK_QUEUE_COMPUTE_BIT, 0).get_family_index());
 	fence_pool   = std::make_unique<FencePool>(*this);
+
+	transient_fence_pool = std::make_unique<TransientFencePool>(*this);
+
+	destruction_queue = std::make_unique<DestructionQueue>(*this);
 }
 
 Device::~Device()
 {
+	// Queued resources are released once the device is idle, they may still be referenced by the resource cache
+	destruction_queue.reset();
+
 	resource_cache.clear();
 
+	// Pending copies use the queues and the transient fences
+	staging_manager.reset();
+
+	geometry_allocator.reset();
+
 	command_pool.reset();
 	fence_pool.reset();
+	transient_fence_pool.reset();
+
+	memory_pools.reset();
 
 	if (memory_allocator != VK_NULL_HANDLE)
 	{
@@ -252,10 +499,7 @@ Device::~Device()
 
 bool Device::is_extension_supported(const std::string &requested_extension)
 {
-	return std::find_if(device_extensions.begin(), device_extensions.end(),
-	                    [requested_extension](auto &device_extension) {
-		                    return std::strcmp(device_extension.extensionName, requested_extension.c_str()) == 0;
-	                    }) != device_extensions.end();
+	return gpu.is_extension_supported(requested_extension);
 }
 
 bool Device::is_enabled(const char *extension)
@@ -273,11 +517,85 @@ VkDevice Device::get_handle() const
 	return handle;
 }
 
+uint32_t Device::get_device_count() const
+{
+	return device_count;
+}
+
+VkDeviceGroupPresentModeFlagsKHR Device::get_device_group_present_modes() const
+{
+	return device_group_present_modes;
+}
+
 VmaAllocator Device::get_memory_allocator() const
 {
 	return memory_allocator;
 }
 
+MemoryPools &Device::get_memory_pools()
+{
+	return *memory_pools;
+}
+
+void Device::defer_flush(const core::Buffer &buffer, VkDeviceSize offset, VkDeviceSize size)
+{
+	std::lock_guard<std::mutex> lock{deferred_flushes_mutex};
+
+	auto it = deferred_flushes.find(&buffer);
+	if (it == deferred_flushes.end())
+	{
+		deferred_flushes.emplace(&buffer, DeferredFlush{offset, offset + size});
+	}
+	else
+	{
+		it->second.begin = std::min(it->second.begin, offset);
+		it->second.end   = std::max(it->second.end, offset + size);
+	}
+}
+
+void Device::flush_deferred()
+{
+	std::lock_guard<std::mutex> lock{deferred_flushes_mutex};
+
+	for (auto &it : deferred_flushes)
+	{
+		vmaFlushAllocation(memory_allocator, it.first->get_allocation(), it.second.begin, it.second.end - it.second.begin);
+	}
+
+	deferred_flushes.clear();
+}
+
+void Device::flush_deferred(const core::Buffer &buffer)
+{
+	std::lock_guard<std::mutex> lock{deferred_flushes_mutex};
+
+	auto it = deferred_flushes.find(&buffer);
+	if (it != deferred_flushes.end())
+	{
+		vmaFlushAllocation(memory_allocator, buffer.get_allocation(), it->second.begin, it->second.end - it->second.begin);
+		deferred_flushes.erase(it);
+	}
+}
+
+void Device::cancel_deferred_flush(const core::Buffer &buffer)
+{
+	std::lock_guard<std::mutex> lock{deferred_flushes_mutex};
+
+	deferred_flushes.erase(&buffer);
+}
+
+bool Device::write_memory_stats(const std::string &filename) const
+{
+	char *stats_string = nullptr;
+	vmaBuildStatsString(memory_allocator, &stats_string, VK_TRUE);
+
+	auto data = nlohmann::json::parse(stats_string);
+
+	vmaFreeStatsString(memory_allocator, stats_string);
+
+	return fs::write_json(data, filename);
+}
+
 DriverVersion Device::get_driver_version() const
 {
 	DriverVersion version;
@@ -347,6 +665,22 @@ uint32_t Device::get_memory_type(uint32_t bits, VkMemoryPropertyFlags properties
 	}
 }
 
+const Queue *Device::find_queue(VkQueue handle) const
+{
+	for (auto &family_queues : queues)
+	{
+		for (auto &queue : family_queues)
+		{
+			if (queue.get_handle() == handle)
+			{
+				return &queue;
+			}
+		}
+	}
+
+	return nullptr;
+}
+
 const Queue &Device::get_queue(uint32_t queue_family_index, uint32_t queue_index)
 {
 	return queues[queue_family_index][queue_index];
@@ -434,19 +768,90 @@ uint32_t Device::get_queue_family_index(VkQueueFlagBits queue_flag)
 
 const Queue &Device::get_suitable_graphics_queue()
 {
-	for (uint32_t queue_family_index = 0U; queue_family_index < queues.size(); ++queue_family_index)
+	return get_queue_by_role(QueueRole::Graphics);
+}
+
+const Queue &Device::get_suitable_compute_queue()
+{
+	return get_queue_by_role(QueueRole::Compute);
+}
+
+const Queue &Device::get_queue_by_role(QueueRole role) const
+{
+	return *role_queues[static_cast<size_t>(role)];
+}
+
+void Device::assign_queue_roles()
+{
+	const Queue *graphics_queue{nullptr};
+	const Queue *present_queue{nullptr};
+	const Queue *compute_queue{nullptr};
+	const Queue *transfer_queue{nullptr};
+
+	for (auto &family_queues : queues)
 	{
-		Queue &first_queue = queues[queue_family_index][0];
+		if (family_queues.empty())
+		{
+			continue;
+		}
 
-		uint32_t queue_count = first_queue.get_properties().queueCount;
+		const Queue &queue = family_queues[0];
 
-		if (first_queue.support_present() && 0 < queue_count)
+		VkQueueFlags flags = queue.get_properties().queueFlags;
+
+		if (flags & VK_QUEUE_GRAPHICS_BIT)
+		{
+			// The graphics family which can present is preferred, so that frames don't need an ownership transfer
+			if (!graphics_queue || (queue.support_present() && !graphics_queue->support_present()))
+			{
+				graphics_queue = &queue;
+			}
+		}
+		else if ((flags & VK_QUEUE_COMPUTE_BIT) && !compute_queue)
 		{
-			return queues[queue_family_index][0];
+			compute_queue = &queue;
+
+			// The second queue of the async compute family lets uploads run alongside compute work
+			if (!transfer_queue && family_queues.size() > 1)
+			{
+				transfer_queue = &family_queues[1];
+			}
 		}
+		else if ((flags & VK_QUEUE_TRANSFER_BIT) && !(flags & VK_QUEUE_COMPUTE_BIT))
+		{
+			// A DMA family is always better suited to transfers than a compute one
+			if (!transfer_queue || (transfer_queue->get_properties().queueFlags & VK_QUEUE_COMPUTE_BIT))
+			{
+				transfer_queue = &queue;
+			}
+		}
+
+		if (queue.support_present() && !present_queue)
+		{
+			present_queue = &queue;
+		}
+	}
+
+	if (!graphics_queue)
+	{
+		throw std::runtime_error("Device has no graphics queue");
+	}
+
+	if (graphics_queue->support_present() || !present_queue)
+	{
+		present_queue = graphics_queue;
 	}
 
-	return get_queue_by_flags(VK_QUEUE_GRAPHICS_BIT, 0);
+	role_queues[static_cast<size_t>(QueueRole::Graphics)] = graphics_queue;
+	role_queues[static_cast<size_t>(QueueRole::Present)]  = present_queue;
+	role_queues[static_cast<size_t>(QueueRole::Compute)]  = compute_queue ? compute_queue : graphics_queue;
+	role_queues[static_cast<size_t>(QueueRole::Transfer)] = transfer_queue ? transfer_queue : role_queues[static_cast<size_t>(QueueRole::Compute)];
+
+	LOGI("Queue families: graphics {}, compute {}, transfer {}, present {}",
+	     graphics_queue->get_family_index(),
+	     get_queue_by_role(QueueRole::Compute).get_family_index(),
+	     get_queue_by_role(QueueRole::Transfer).get_family_index(),
+	     present_queue->get_family_index());
 }
 
 VkBuffer Device::create_buffer(VkBufferUsageFlags usage, VkMemoryPropertyFlags properties, VkDeviceSize size, VkDeviceMemory *memory, void *data)
@@ -501,8 +906,6 @@ void Device::copy_buffer(vkb::core::Buffer &src, vkb::core::Buffer &dst, VkQueue
 	assert(dst.get_size() <= src.get_size());
 	assert(src.get_handle());
 
-	VkCommandBuffer command_buffer = create_command_buffer(VK_COMMAND_BUFFER_LEVEL_PRIMARY, true);
-
 	VkBufferCopy buffer_copy{};
 	if (copy_region == nullptr)
 	{
@@ -513,9 +916,12 @@ void Device::copy_buffer(vkb::core::Buffer &src, vkb::core::Buffer &dst, VkQueue
 		buffer_copy = *copy_region;
 	}
 
-	vkCmdCopyBuffer(command_buffer, src.get_handle(), dst.get_handle(), 1, &buffer_copy);
+	auto &staging = get_staging_manager();
+
+	staging.copy_buffer(src, dst, buffer_copy);
 
-	flush_command_buffer(command_buffer, queue);
+	// Callers release the source buffer once the copy returns
+	staging.wait(staging.flush());
 }
 
 VkCommandPool Device::create_command_pool(uint32_t queue_index, VkCommandPoolCreateFlags flags)
@@ -562,6 +968,20 @@ void Device::flush_command_buffer(VkCommandBuffer command_buffer, VkQueue queue,
 
 	VK_CHECK(vkEndCommandBuffer(command_buffer));
 
+	StagingManager *staging = nullptr;
+	{
+		std::lock_guard<std::mutex> lock{staging_manager_mutex};
+		staging = staging_manager.get();
+	}
+
+	// Uploads recorded before the command buffer are submitted before it
+	if (staging && staging->has_pending_copies())
+	{
+		staging->flush();
+	}
+
+	flush_deferred();
+
 	VkSubmitInfo submit_info{};
 	submit_info.sType              = VK_STRUCTURE_TYPE_SUBMIT_INFO;
 	submit_info.commandBufferCount = 1;
@@ -576,7 +996,9 @@ void Device::flush_command_buffer(VkCommandBuffer command_buffer, VkQueue queue,
 	VK_CHECK(vkCreateFence(handle, &fence_info, nullptr, &fence));
 
 	// Submit to the queue
-	VkResult result = vkQueueSubmit(queue, 1, &submit_info, fence);
+	const Queue *device_queue = find_queue(queue);
+
+	VkResult result = device_queue ? device_queue->submit({submit_info}, fence) : vkQueueSubmit(queue, 1, &submit_info, fence);
 	// Wait for the fence to signal that command buffer has finished executing
 	VK_CHECK(vkWaitForFences(handle, 1, &fence, VK_TRUE, DEFAULT_FENCE_TIMEOUT));
 
@@ -603,6 +1025,75 @@ CommandBuffer &Device::request_command_buffer()
 	return command_pool->request_command_buffer();
 }
 
+TransientFencePool &Device::get_transient_fence_pool()
+{
+	return *transient_fence_pool;
+}
+
+void Device::request_staging_transfer_queue(bool use)
+{
+	std::lock_guard<std::mutex> lock{staging_manager_mutex};
+
+	if (staging_manager)
+	{
+		LOGW("The staging manager already exists, its queue is not changed");
+		return;
+	}
+
+	staging_transfer_queue = use;
+}
+
+StagingManager &Device::get_staging_manager()
+{
+	std::lock_guard<std::mutex> lock{staging_manager_mutex};
+
+	if (!staging_manager)
+	{
+		staging_manager = std::make_unique<StagingManager>(*this, StagingManager::DEFAULT_RING_SIZE, staging_transfer_queue);
+	}
+
+	return *staging_manager;
+}
+
+GeometryAllocator &Device::get_geometry_allocator()
+{
+	std::lock_guard<std::mutex> lock{geometry_allocator_mutex};
+
+	if (!geometry_allocator)
+	{
+		geometry_allocator = std::make_unique<GeometryAllocator>(*this);
+	}
+
+	return *geometry_allocator;
+}
+
+bool Device::is_debug_utils_enabled() const
+{
+	return debug_utils;
+}
+
+#ifdef VKB_DEBUG_MARKERS
+void Device::set_debug_name(VkObjectType object_type, uint64_t object_handle, const char *name) const
+{
+	if (!debug_utils || object_handle == 0)
+	{
+		return;
+	}
+
+	VkDebugUtilsObjectNameInfoEXT name_info{VK_STRUCTURE_TYPE_DEBUG_UTILS_OBJECT_NAME_INFO_EXT};
+	name_info.objectType   = object_type;
+	name_info.objectHandle = object_handle;
+	name_info.pObjectName  = name;
+
+	vkSetDebugUtilsObjectNameEXT(handle, &name_info);
+}
+#endif
+
+DestructionQueue &Device::get_destruction_queue()
+{
+	return *destruction_queue;
+}
+
 VkFence Device::request_fence()
 {
 	return fence_pool->request_fence();
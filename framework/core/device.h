@@ -25,6 +25,7 @@
 #include "core/command_pool.h"
 #include "core/descriptor_set.h"
 #include "core/descriptor_set_layout.h"
+#include "core/destruction_queue.h"
 #include "core/framebuffer.h"
 #include "core/instance.h"
 #include "core/pipeline.h"
@@ -42,6 +43,10 @@
 
 namespace vkb
 {
+class GeometryAllocator;
+class MemoryPools;
+class StagingManager;
+
 struct DriverVersion
 {
 	uint16_t major;
@@ -49,6 +54,26 @@ struct DriverVersion
 	uint16_t patch;
 };
 
+/**
+ * @brief The work a queue of the device is assigned to
+ */
+enum class QueueRole
+{
+	/// Rendering, on a family which can present if there is one
+	Graphics,
+
+	/// Compute work running alongside graphics, on a family without graphics support if there is one
+	Compute,
+
+	/// Uploads running alongside graphics, on a family without graphics support if there is one
+	Transfer,
+
+	/// Presentation of the swapchain images
+	Present,
+
+	Count
+};
+
 class Device
 {
   public:
@@ -57,8 +82,9 @@ class Device
 	 * @param gpu A valid Vulkan physical device and the requested gpu features
 	 * @param surface The surface
 	 * @param requested_extensions (Optional) List of required device extensions and whether support is optional or not
+	 * @param gpu_group (Optional) Physical devices of the device group of gpu to combine in the device, needs VK_KHR_device_group
 	 */
-	Device(PhysicalDevice &gpu, VkSurfaceKHR surface, std::unordered_map<const char *, bool> requested_extensions = {});
+	Device(PhysicalDevice &gpu, VkSurfaceKHR surface, std::unordered_map<const char *, bool> requested_extensions = {}, const std::vector<PhysicalDevice *> &gpu_group = {});
 
 	Device(const Device &) = delete;
 
@@ -74,8 +100,55 @@ class Device
 
 	VkDevice get_handle() const;
 
+	/**
+	 * @return The number of physical devices in the device, more than one if it was created from a device group
+	 */
+	uint32_t get_device_count() const;
+
+	/**
+	 * @return The modes a device group can present with, with VK_DEVICE_GROUP_PRESENT_MODE_REMOTE_BIT_KHR set if
+	 *         each physical device can present images rendered by the others, 0 for a single physical device
+	 */
+	VkDeviceGroupPresentModeFlagsKHR get_device_group_present_modes() const;
+
 	VmaAllocator get_memory_allocator() const;
 
+	/**
+	 * @brief Retrieves the pools buffers and images are allocated from depending on their usage
+	 */
+	MemoryPools &get_memory_pools();
+
+	/**
+	 * @brief Records a range written to a persistently mapped buffer in non coherent memory,
+	 *        ranges of the same buffer are merged and flushed together before the next submission
+	 * @param buffer The buffer written to
+	 * @param offset Offset of the written range
+	 * @param size Size of the written range
+	 */
+	void defer_flush(const core::Buffer &buffer, VkDeviceSize offset, VkDeviceSize size);
+
+	/**
+	 * @brief Flushes the ranges written to non coherent buffers since the last submission
+	 */
+	void flush_deferred();
+
+	/**
+	 * @brief Flushes the ranges written to a buffer since the last submission
+	 */
+	void flush_deferred(const core::Buffer &buffer);
+
+	/**
+	 * @brief Drops the deferred ranges of a buffer which is being destroyed
+	 */
+	void cancel_deferred_flush(const core::Buffer &buffer);
+
+	/**
+	 * @brief Writes the detailed statistics of the memory allocator, as built by vmaBuildStatsString
+	 * @param filename Name of the JSON file, in the graphs directory
+	 * @return True if the file was written
+	 */
+	bool write_memory_stats(const std::string &filename) const;
+
 	/**
 	 * @return The version of the driver of the current physical device
 	 */
@@ -92,16 +165,42 @@ class Device
 
 	const Queue &get_queue_by_present(uint32_t queue_index);
 
+	/**
+	 * @brief Retrieves the queue assigned to a role when the device was created, by the topology of its queue families.
+	 *        Roles share a queue when the device has no better suited family.
+	 */
+	const Queue &get_queue_by_role(QueueRole role) const;
+
 	/**
 	 * @brief Finds a suitable graphics queue to submit to
 	 * @return The first present supported queue, otherwise just any graphics queue
 	 */
 	const Queue &get_suitable_graphics_queue();
 
+	/**
+	 * @brief Finds a compute queue which can run alongside graphics work
+	 * @return The first queue of a compute family without graphics support, otherwise any compute queue
+	 */
+	const Queue &get_suitable_compute_queue();
+
 	bool is_extension_supported(const std::string &extension);
 
 	bool is_enabled(const char *extension);
 
+	/**
+	 * @return Whether the instance enabled VK_EXT_debug_utils, so that objects and command regions can be labeled
+	 */
+	bool is_debug_utils_enabled() const;
+
+	/**
+	 * @brief Names a Vulkan object in GPU captures and validation messages
+	 *        Only builds with VKB_DEBUG_MARKERS name objects, the call is empty otherwise.
+	 * @param object_type The type of the object
+	 * @param object_handle The handle of the object, cast to a 64-bit integer
+	 * @param name The name of the object
+	 */
+	void set_debug_name(VkObjectType object_type, uint64_t object_handle, const char *name) const;
+
 	uint32_t get_queue_family_index(VkQueueFlagBits queue_flag);
 
 	CommandPool &get_command_pool();
@@ -127,10 +226,11 @@ class Device
 	VkBuffer create_buffer(VkBufferUsageFlags usage, VkMemoryPropertyFlags properties, VkDeviceSize size, VkDeviceMemory *memory, void *data = nullptr);
 
 	/**
-	* @brief Copies a buffer from one to another
+	* @brief Copies a buffer from one to another, and waits for the copy to complete
+	*        The copy is submitted by the staging manager with its other pending copies.
 	* @param src The buffer to copy from
 	* @param dst The buffer to copy to
-	* @param queue The queue to submit the copy command to
+	* @param queue Unused, the copy is submitted to the queue of the staging manager
 	* @param copy_region The amount to copy, if null copies the entire buffer
 	*/
 	void copy_buffer(vkb::core::Buffer &src, vkb::core::Buffer &dst, VkQueue queue, VkBufferCopy *copy_region = nullptr);
@@ -153,6 +253,8 @@ class Device
 
 	/**
 	 * @brief Submits and frees up a given command buffer
+	 *        The submission is serialized with the other ones if the queue is one of the device.
+	 *        Pending copies of the staging manager are flushed first, so that the command buffer sees their data.
 	 * @param command_buffer The command buffer
 	 * @param queue The queue to submit the work to
 	 * @param free Whether the command buffer should be implictly freed up
@@ -173,6 +275,33 @@ class Device
 	 */
 	VkFence request_fence();
 
+	/**
+	 * @brief Retrieves the pool of fences for one-off submissions, which can be waited for from any thread
+	 *        without waiting for or resetting the fences of other users of the device
+	 */
+	TransientFencePool &get_transient_fence_pool();
+
+	/**
+	 * @brief Requests the staging manager to copy on a dedicated transfer queue, must be called before it is first retrieved
+	 */
+	void request_staging_transfer_queue(bool use);
+
+	/**
+	 * @brief Retrieves the staging manager batching uploads to buffers and images, it is created on first use
+	 */
+	StagingManager &get_staging_manager();
+
+	/**
+	 * @brief Retrieves the allocator suballocating geometry from shared device local buffers, it is created on first use
+	 */
+	GeometryAllocator &get_geometry_allocator();
+
+	/**
+	 * @brief Retrieves the queue releasing resources once the GPU has finished with them, so that replacing
+	 *        resources while frames are in flight does not need to wait for the device
+	 */
+	DestructionQueue &get_destruction_queue();
+
 	VkResult wait_idle();
 
 	ResourceCache &get_resource_cache();
@@ -184,20 +313,77 @@ class Device
 
 	VkDevice handle{VK_NULL_HANDLE};
 
-	std::vector<VkExtensionProperties> device_extensions;
-
 	std::vector<const char *> enabled_extensions{};
 
+	uint32_t device_count{1};
+
+	VkDeviceGroupPresentModeFlagsKHR device_group_present_modes{0};
+
 	VmaAllocator memory_allocator{VK_NULL_HANDLE};
 
+	/// Custom memory pools by resource usage, destroyed before the allocator
+	std::unique_ptr<MemoryPools> memory_pools;
+
+	/// Range written to a non coherent buffer, from the first byte to one past the last
+	struct DeferredFlush
+	{
+		VkDeviceSize begin;
+
+		VkDeviceSize end;
+	};
+
+	std::unordered_map<const core::Buffer *, DeferredFlush> deferred_flushes;
+
+	/// Guards the deferred flushes, buffers are written from the worker threads recording a frame
+	std::mutex deferred_flushes_mutex;
+
 	std::vector<std::vector<Queue>> queues;
 
+	/// Queue of each role
+	std::array<const Queue *, static_cast<size_t>(QueueRole::Count)> role_queues{};
+
+	/**
+	 * @brief Assigns a queue to each role, preferring dedicated families for compute and transfers
+	 */
+	void assign_queue_roles();
+
+	/**
+	 * @return The queue of the device with a given handle, null if there is none
+	 */
+	const Queue *find_queue(VkQueue handle) const;
+
 	/// A command pool associated to the primary queue
 	std::unique_ptr<CommandPool> command_pool;
 
 	/// A fence pool associated to the primary queue
 	std::unique_ptr<FencePool> fence_pool;
 
+	/// A fence pool for one-off submissions such as uploads
+	std::unique_ptr<TransientFencePool> transient_fence_pool;
+
+	std::unique_ptr<StagingManager> staging_manager;
+
+	/// Guards the creation of the staging manager
+	std::mutex staging_manager_mutex;
+
+	bool staging_transfer_queue{false};
+
+	/// Destroyed after the staging manager, which may still copy to its buffers
+	std::unique_ptr<GeometryAllocator> geometry_allocator;
+
+	/// Guards the creation of the geometry allocator
+	std::mutex geometry_allocator_mutex;
+
+	bool debug_utils{false};
+
+	std::unique_ptr<DestructionQueue> destruction_queue;
+
 	ResourceCache resource_cache;
 };
+
+#ifndef VKB_DEBUG_MARKERS
+inline void Device::set_debug_name(VkObjectType /*object_type*/, uint64_t /*object_handle*/, const char * /*name*/) const
+{
+}
+#endif
 }        // namespace vkb
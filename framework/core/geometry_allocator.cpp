@@ -0,0 +1,264 @@
+/* Copyright (c) 2020, Arm Limited and Contributors
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 the "License";
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "geometry_allocator.h"
+
+#include <algorithm>
+
+#include "core/buffer.h"
+#include "core/device.h"
+#include "core/staging_manager.h"
+
+namespace vkb
+{
+constexpr VkDeviceSize GeometryAllocator::DEFAULT_BLOCK_SIZE;
+
+constexpr VkDeviceSize GeometryAllocator::DEFAULT_ALIGNMENT;
+
+GeometryAllocation::GeometryAllocation(GeometryAllocator &allocator, core::Buffer &buffer, VkDeviceSize offset, VkDeviceSize size) :
+    allocator{&allocator},
+    buffer{&buffer},
+    offset{offset},
+    size{size}
+{
+}
+
+GeometryAllocation::GeometryAllocation(GeometryAllocation &&other) :
+    allocator{other.allocator},
+    buffer{other.buffer},
+    offset{other.offset},
+    size{other.size}
+{
+	other.allocator = nullptr;
+	other.buffer    = nullptr;
+	other.offset    = 0;
+	other.size      = 0;
+}
+
+GeometryAllocation::~GeometryAllocation()
+{
+	release();
+}
+
+GeometryAllocation &GeometryAllocation::operator=(GeometryAllocation &&other)
+{
+	if (this != &other)
+	{
+		release();
+
+		allocator = other.allocator;
+		buffer    = other.buffer;
+		offset    = other.offset;
+		size      = other.size;
+
+		other.allocator = nullptr;
+		other.buffer    = nullptr;
+		other.offset    = 0;
+		other.size      = 0;
+	}
+
+	return *this;
+}
+
+void GeometryAllocation::release()
+{
+	if (allocator && buffer)
+	{
+		allocator->free(*buffer, offset, size);
+	}
+
+	allocator = nullptr;
+	buffer    = nullptr;
+	offset    = 0;
+	size      = 0;
+}
+
+bool GeometryAllocation::empty() const
+{
+	return buffer == nullptr;
+}
+
+const core::Buffer &GeometryAllocation::get_buffer() const
+{
+	assert(buffer && "Geometry allocation is empty");
+	return *buffer;
+}
+
+VkDeviceSize GeometryAllocation::get_offset() const
+{
+	return offset;
+}
+
+VkDeviceSize GeometryAllocation::get_size() const
+{
+	return size;
+}
+
+GeometryAllocator::GeometryAllocator(Device &device, VkDeviceSize block_size) :
+    device{device},
+    block_size{block_size}
+{
+}
+
+GeometryAllocator::~GeometryAllocator()
+{
+	if (allocated_size > 0)
+	{
+		LOGW("Geometry allocator destroyed with {} bytes still allocated", allocated_size);
+	}
+}
+
+GeometryAllocation GeometryAllocator::allocate(VkDeviceSize size, VkBufferUsageFlags usage, VkDeviceSize alignment)
+{
+	if (size == 0)
+	{
+		return {};
+	}
+
+	if (usage & VK_BUFFER_USAGE_STORAGE_BUFFER_BIT)
+	{
+		alignment = std::max(alignment, device.get_gpu().get_properties().limits.minStorageBufferOffsetAlignment);
+	}
+
+	// Copies through the staging manager write to the buffers
+	usage |= VK_BUFFER_USAGE_TRANSFER_DST_BIT;
+
+	std::lock_guard<std::mutex> lock{mutex};
+
+	// Best fit, the smallest free range holding the aligned allocation
+	Block *      best_block = nullptr;
+	VkDeviceSize best_range{0};
+	VkDeviceSize best_size{0};
+
+	for (auto &block : blocks)
+	{
+		if (block.usage != usage)
+		{
+			continue;
+		}
+
+		for (auto &free_range : block.free_ranges)
+		{
+			VkDeviceSize aligned_offset = (free_range.first + alignment - 1) / alignment * alignment;
+
+			if (aligned_offset + size <= free_range.first + free_range.second && (!best_block || free_range.second < best_size))
+			{
+				best_block = &block;
+				best_range = free_range.first;
+				best_size  = free_range.second;
+			}
+		}
+	}
+
+	if (!best_block)
+	{
+		Block block;
+		block.usage  = usage;
+		block.buffer = std::make_unique<core::Buffer>(device, std::max(block_size, size), usage, VMA_MEMORY_USAGE_GPU_ONLY);
+		block.free_ranges.emplace(0, block.buffer->get_size());
+
+		LOGD("Created geometry buffer #{} of {} bytes", blocks.size(), block.buffer->get_size());
+
+		blocks.push_back(std::move(block));
+
+		best_block = &blocks.back();
+		best_range = 0;
+		best_size  = best_block->buffer->get_size();
+	}
+
+	VkDeviceSize aligned_offset = (best_range + alignment - 1) / alignment * alignment;
+
+	// The padding before the allocation and the space after it stay free
+	best_block->free_ranges.erase(best_range);
+
+	if (aligned_offset > best_range)
+	{
+		best_block->free_ranges.emplace(best_range, aligned_offset - best_range);
+	}
+
+	if (aligned_offset + size < best_range + best_size)
+	{
+		best_block->free_ranges.emplace(aligned_offset + size, best_range + best_size - aligned_offset - size);
+	}
+
+	allocated_size += size;
+
+	return GeometryAllocation{*this, *best_block->buffer, aligned_offset, size};
+}
+
+GeometryAllocation GeometryAllocator::upload(const void *data, VkDeviceSize size, VkBufferUsageFlags usage, VkDeviceSize alignment)
+{
+	auto allocation = allocate(size, usage, alignment);
+
+	if (!allocation.empty())
+	{
+		device.get_staging_manager().copy_to_buffer(data, size, allocation.get_buffer(), allocation.get_offset());
+	}
+
+	return allocation;
+}
+
+size_t GeometryAllocator::get_buffer_count() const
+{
+	std::lock_guard<std::mutex> lock{mutex};
+	return blocks.size();
+}
+
+VkDeviceSize GeometryAllocator::get_allocated_size() const
+{
+	std::lock_guard<std::mutex> lock{mutex};
+	return allocated_size;
+}
+
+void GeometryAllocator::free(const core::Buffer &buffer, VkDeviceSize offset, VkDeviceSize size)
+{
+	std::lock_guard<std::mutex> lock{mutex};
+
+	auto block_it = std::find_if(blocks.begin(), blocks.end(), [&buffer](const Block &block) { return block.buffer.get() == &buffer; });
+
+	if (block_it == blocks.end())
+	{
+		LOGE("Freed geometry range does not belong to a geometry buffer");
+		return;
+	}
+
+	auto &free_ranges = block_it->free_ranges;
+
+	auto range_it = free_ranges.emplace(offset, size).first;
+
+	// Merge with the following free range
+	auto next_it = std::next(range_it);
+	if (next_it != free_ranges.end() && range_it->first + range_it->second == next_it->first)
+	{
+		range_it->second += next_it->second;
+		free_ranges.erase(next_it);
+	}
+
+	// Merge with the preceding free range
+	if (range_it != free_ranges.begin())
+	{
+		auto previous_it = std::prev(range_it);
+		if (previous_it->first + previous_it->second == range_it->first)
+		{
+			previous_it->second += range_it->second;
+			free_ranges.erase(range_it);
+		}
+	}
+
+	allocated_size -= size;
+}
+}        // namespace vkb
@@ -0,0 +1,164 @@
+/* Copyright (c) 2020, Arm Limited and Contributors
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 the "License";
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <map>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+#include "common/helpers.h"
+#include "common/vk_common.h"
+
+namespace vkb
+{
+class Device;
+class GeometryAllocator;
+
+namespace core
+{
+class Buffer;
+}
+
+/**
+ * @brief A range of a shared geometry buffer, given back to its allocator when destroyed
+ *        The range must not be in use by the GPU anymore, allocations can be handed to the destruction queue of the device
+ */
+class GeometryAllocation
+{
+  public:
+	GeometryAllocation() = default;
+
+	GeometryAllocation(GeometryAllocator &allocator, core::Buffer &buffer, VkDeviceSize offset, VkDeviceSize size);
+
+	GeometryAllocation(const GeometryAllocation &) = delete;
+
+	GeometryAllocation(GeometryAllocation &&other);
+
+	~GeometryAllocation();
+
+	GeometryAllocation &operator=(const GeometryAllocation &) = delete;
+
+	GeometryAllocation &operator=(GeometryAllocation &&other);
+
+	bool empty() const;
+
+	const core::Buffer &get_buffer() const;
+
+	VkDeviceSize get_offset() const;
+
+	VkDeviceSize get_size() const;
+
+  private:
+	/**
+	 * @brief Gives the range back to the allocator, leaving the allocation empty
+	 */
+	void release();
+
+	GeometryAllocator *allocator{nullptr};
+
+	core::Buffer *buffer{nullptr};
+
+	VkDeviceSize offset{0};
+
+	VkDeviceSize size{0};
+};
+
+/**
+ * @brief Suballocates vertex and index data from a few large device local buffers, instead of a buffer per attribute of each sub mesh.
+ *        Each buffer keeps its free ranges ordered by offset, allocations take the smallest range they fit in, and freed ranges
+ *        merge with their neighbours, so that geometry streamed in and out reuses the buffers without fragmenting them.
+ */
+class GeometryAllocator
+{
+  public:
+	/**
+	 * @param device A valid Vulkan device
+	 * @param block_size Size of the buffers, larger allocations get a buffer of their own
+	 */
+	GeometryAllocator(Device &device, VkDeviceSize block_size = DEFAULT_BLOCK_SIZE);
+
+	GeometryAllocator(const GeometryAllocator &) = delete;
+
+	GeometryAllocator(GeometryAllocator &&) = delete;
+
+	~GeometryAllocator();
+
+	GeometryAllocator &operator=(const GeometryAllocator &) = delete;
+
+	GeometryAllocator &operator=(GeometryAllocator &&) = delete;
+
+	/**
+	 * @brief Allocates a range of a geometry buffer
+	 * @param size Size in bytes of the range
+	 * @param usage Usage of the buffer holding the range, buffers are shared by the allocations of the same usage
+	 * @param alignment Alignment of the offset of the range, raised to the storage buffer offset alignment for storage buffers
+	 */
+	GeometryAllocation allocate(VkDeviceSize size, VkBufferUsageFlags usage, VkDeviceSize alignment = DEFAULT_ALIGNMENT);
+
+	/**
+	 * @brief Allocates a range and copies data to it through the staging manager of the device
+	 *        The copy is submitted by the next flush of the staging manager
+	 */
+	GeometryAllocation upload(const void *data, VkDeviceSize size, VkBufferUsageFlags usage, VkDeviceSize alignment = DEFAULT_ALIGNMENT);
+
+	/**
+	 * @return The number of geometry buffers created
+	 */
+	size_t get_buffer_count() const;
+
+	/**
+	 * @return The number of bytes allocated from the geometry buffers
+	 */
+	VkDeviceSize get_allocated_size() const;
+
+	static constexpr VkDeviceSize DEFAULT_BLOCK_SIZE{64 * 1024 * 1024};
+
+	/// Suits every index type and the vertex formats of the scenes
+	static constexpr VkDeviceSize DEFAULT_ALIGNMENT{16};
+
+  private:
+	friend class GeometryAllocation;
+
+	struct Block
+	{
+		std::unique_ptr<core::Buffer> buffer;
+
+		VkBufferUsageFlags usage{0};
+
+		/// Free ranges of the buffer, mapping their offset to their size
+		std::map<VkDeviceSize, VkDeviceSize> free_ranges;
+	};
+
+	/**
+	 * @brief Returns a range to the free ranges of its buffer, merging it with the free ranges around it
+	 */
+	void free(const core::Buffer &buffer, VkDeviceSize offset, VkDeviceSize size);
+
+	Device &device;
+
+	VkDeviceSize block_size;
+
+	std::vector<Block> blocks;
+
+	VkDeviceSize allocated_size{0};
+
+	/// Guards the blocks, sub meshes are loaded and released from several threads
+	mutable std::mutex mutex;
+};
+}        // namespace vkb
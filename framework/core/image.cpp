@@ -18,7 +18,9 @@
 #include "image.h"
 
 #include "device.h"
+#include "image_compression.h"
 #include "image_view.h"
+#include "memory_pools.h"
 
 namespace vkb
 {
@@ -63,6 +65,21 @@ inline VkImageType find_image_type(VkExtent3D extent)
 
 	return result;
 }
+
+VkImageCreateInfo get_aliased_image_info(const VkExtent3D &extent, VkFormat format, VkImageUsageFlags image_usage, VkSampleCountFlagBits sample_count)
+{
+	VkImageCreateInfo image_info{VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO};
+	image_info.imageType   = find_image_type(extent);
+	image_info.format      = format;
+	image_info.extent      = extent;
+	image_info.mipLevels   = 1;
+	image_info.arrayLayers = 1;
+	image_info.samples     = sample_count;
+	image_info.tiling      = VK_IMAGE_TILING_OPTIMAL;
+	image_info.usage       = image_usage;
+
+	return image_info;
+}
 }        // namespace
 
 namespace core
@@ -111,15 +128,67 @@ Image::Image(Device &              device,
 		memory_info.preferredFlags = VK_MEMORY_PROPERTY_LAZILY_ALLOCATED_BIT;
 	}
 
-	auto result = vmaCreateImage(device.get_memory_allocator(),
-	                             &image_info, &memory_info,
-	                             &handle, &memory,
-	                             nullptr);
+	auto result = device.get_memory_pools().create_image(image_info, memory_info, handle, memory);
 
 	if (result != VK_SUCCESS)
 	{
 		throw VulkanException{result, "Cannot create Image"};
 	}
+
+	// Images only written by compute shaders need storage usage anyway, render targets could avoid it
+	if (image_usage & VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT)
+	{
+		check_image_compression(device, handle, format, extent, image_usage, tiling, "Color attachment");
+	}
+}
+
+Image::Image(Device &device, const VkExtent3D &extent, VkFormat format, VkImageUsageFlags image_usage, VmaAllocation memory, VkSampleCountFlagBits sample_count) :
+    device{device},
+    memory{memory},
+    type{find_image_type(extent)},
+    extent{extent},
+    format{format},
+    sample_count{sample_count},
+    usage{image_usage},
+    array_layer_count{1},
+    tiling{VK_IMAGE_TILING_OPTIMAL},
+    aliased{true}
+{
+	subresource.mipLevel   = 1;
+	subresource.arrayLayer = 1;
+
+	VkImageCreateInfo image_info = get_aliased_image_info(extent, format, image_usage, sample_count);
+
+	auto result = vkCreateImage(device.get_handle(), &image_info, nullptr, &handle);
+
+	if (result != VK_SUCCESS)
+	{
+		throw VulkanException{result, "Cannot create Image"};
+	}
+
+	result = vmaBindImageMemory(device.get_memory_allocator(), memory, handle);
+
+	if (result != VK_SUCCESS)
+	{
+		vkDestroyImage(device.get_handle(), handle, nullptr);
+
+		throw VulkanException{result, "Cannot bind Image memory"};
+	}
+}
+
+VkMemoryRequirements Image::get_memory_requirements(Device &device, const VkExtent3D &extent, VkFormat format, VkImageUsageFlags image_usage, VkSampleCountFlagBits sample_count)
+{
+	VkImageCreateInfo image_info = get_aliased_image_info(extent, format, image_usage, sample_count);
+
+	VkImage image{VK_NULL_HANDLE};
+	VK_CHECK(vkCreateImage(device.get_handle(), &image_info, nullptr, &image));
+
+	VkMemoryRequirements requirements{};
+	vkGetImageMemoryRequirements(device.get_handle(), image, &requirements);
+
+	vkDestroyImage(device.get_handle(), image, nullptr);
+
+	return requirements;
 }
 
 Image::Image(Device &device, VkImage handle, const VkExtent3D &extent, VkFormat format, VkImageUsageFlags image_usage, VkSampleCountFlagBits sample_count) :
@@ -146,8 +215,13 @@ Image::Image(Image &&other) :
     usage{other.usage},
     tiling{other.tiling},
     subresource{other.subresource},
+    array_layer_count{other.array_layer_count},
+    views{std::move(other.views)},
+    cached_views{std::move(other.cached_views)},
+    states{std::move(other.states)},
     mapped_data{other.mapped_data},
-    mapped{other.mapped}
+    mapped{other.mapped},
+    aliased{other.aliased}
 {
 	other.handle      = VK_NULL_HANDLE;
 	other.memory      = VK_NULL_HANDLE;
@@ -163,10 +237,21 @@ Image::Image(Image &&other) :
 
 Image::~Image()
 {
+	// Cached views have to be destroyed before the image
+	cached_views.clear();
+
 	if (handle != VK_NULL_HANDLE && memory != VK_NULL_HANDLE)
 	{
 		unmap();
-		vmaDestroyImage(device.get_memory_allocator(), handle, memory);
+
+		if (aliased)
+		{
+			vkDestroyImage(device.get_handle(), handle, nullptr);
+		}
+		else
+		{
+			vmaDestroyImage(device.get_memory_allocator(), handle, memory);
+		}
 	}
 }
 
@@ -254,5 +339,77 @@ std::unordered_set<ImageView *> &Image::get_views()
 	return views;
 }
 
+ImageView &Image::request_view(VkImageViewType view_type, VkFormat view_format, uint32_t base_array_layer, uint32_t n_array_layers,
+                               uint32_t base_mip_level, uint32_t n_mip_levels)
+{
+	// Resolve the defaults, so that views of the same subresources are shared however they are requested
+	if (view_format == VK_FORMAT_UNDEFINED)
+	{
+		view_format = format;
+	}
+
+	if (n_array_layers == 0)
+	{
+		n_array_layers = subresource.arrayLayer - base_array_layer;
+	}
+
+	if (n_mip_levels == 0)
+	{
+		n_mip_levels = subresource.mipLevel - base_mip_level;
+	}
+
+	std::size_t hash{0U};
+	hash_combine(hash, static_cast<std::underlying_type<VkImageViewType>::type>(view_type));
+	hash_combine(hash, static_cast<std::underlying_type<VkFormat>::type>(view_format));
+	hash_combine(hash, base_array_layer);
+	hash_combine(hash, n_array_layers);
+	hash_combine(hash, base_mip_level);
+	hash_combine(hash, n_mip_levels);
+
+	std::lock_guard<std::mutex> guard(cached_views_mutex);
+
+	auto it = cached_views.find(hash);
+
+	if (it == cached_views.end())
+	{
+		auto view = std::make_unique<ImageView>(*this, view_type, view_format, base_array_layer, n_array_layers, base_mip_level, n_mip_levels);
+
+		it = cached_views.emplace(hash, std::move(view)).first;
+	}
+
+	return *it->second;
+}
+
+const ImageSubresourceState &Image::get_state(uint32_t mip_level, uint32_t array_layer) const
+{
+	assert(mip_level < subresource.mipLevel && array_layer < subresource.arrayLayer && "Subresource is out of the image");
+
+	if (states.empty())
+	{
+		states.resize(subresource.mipLevel * subresource.arrayLayer);
+	}
+
+	return states[array_layer * subresource.mipLevel + mip_level];
+}
+
+void Image::set_state(const VkImageSubresourceRange &range, const ImageSubresourceState &state) const
+{
+	if (states.empty())
+	{
+		states.resize(subresource.mipLevel * subresource.arrayLayer);
+	}
+
+	uint32_t level_count = range.levelCount == VK_REMAINING_MIP_LEVELS ? subresource.mipLevel - range.baseMipLevel : range.levelCount;
+	uint32_t layer_count = range.layerCount == VK_REMAINING_ARRAY_LAYERS ? subresource.arrayLayer - range.baseArrayLayer : range.layerCount;
+
+	for (uint32_t layer = range.baseArrayLayer; layer < range.baseArrayLayer + layer_count; ++layer)
+	{
+		for (uint32_t level = range.baseMipLevel; level < range.baseMipLevel + level_count; ++level)
+		{
+			states[layer * subresource.mipLevel + level] = state;
+		}
+	}
+}
+
 }        // namespace core
 }        // namespace vkb
@@ -17,6 +17,9 @@
 
 #pragma once
 
+#include <memory>
+#include <mutex>
+#include <unordered_map>
 #include <unordered_set>
 
 #include "common/helpers.h"
@@ -29,6 +32,21 @@ class Device;
 namespace core
 {
 class ImageView;
+
+/**
+ * @brief Layout of a subresource of an image and the accesses to it since its last barrier,
+ *        as recorded by command buffers
+ */
+struct ImageSubresourceState
+{
+	VkImageLayout layout{VK_IMAGE_LAYOUT_UNDEFINED};
+
+	/// Stages of the accesses, which later accesses may have to wait for
+	VkPipelineStageFlags stage_mask{0};
+
+	VkAccessFlags access_mask{0};
+};
+
 class Image
 {
   public:
@@ -50,6 +68,27 @@ class Image
 	      VkImageTiling         tiling       = VK_IMAGE_TILING_OPTIMAL,
 	      VkImageCreateFlags    flags        = 0);
 
+	/**
+	 * @brief Creates an image bound to memory allocated by somebody else,
+	 *        which images not used at the same time can share
+	 * @param memory Allocation fitting the memory requirements of the image, which has to outlive it
+	 */
+	Image(Device &              device,
+	      const VkExtent3D &    extent,
+	      VkFormat              format,
+	      VkImageUsageFlags     image_usage,
+	      VmaAllocation         memory,
+	      VkSampleCountFlagBits sample_count = VK_SAMPLE_COUNT_1_BIT);
+
+	/**
+	 * @return The memory requirements of an image created with the given parameters and bound to an allocation
+	 */
+	static VkMemoryRequirements get_memory_requirements(Device &              device,
+	                                                    const VkExtent3D &    extent,
+	                                                    VkFormat              format,
+	                                                    VkImageUsageFlags     image_usage,
+	                                                    VkSampleCountFlagBits sample_count = VK_SAMPLE_COUNT_1_BIT);
+
 	Image(const Image &) = delete;
 
 	Image(Image &&other);
@@ -93,8 +132,34 @@ class Image
 
 	uint32_t get_array_layer_count() const;
 
+	/**
+	 * @return The tracked state of a subresource, undefined until a command buffer records its layout
+	 */
+	const ImageSubresourceState &get_state(uint32_t mip_level, uint32_t array_layer) const;
+
+	/**
+	 * @brief Sets the tracked state of the subresources of a range, when recording commands which change it
+	 *
+	 * The state follows the recording order, so command buffers using the image have to be submitted in the
+	 * order they are recorded, and the state has to be set again for layouts changed outside command buffers.
+	 */
+	void set_state(const VkImageSubresourceRange &range, const ImageSubresourceState &state) const;
+
 	std::unordered_set<ImageView *> &get_views();
 
+	/**
+	 * @brief Requests a view of the image, created on the first request and kept until the image is destroyed
+	 *
+	 * Views requested with the same parameters share a handle, so that the descriptor sets referring to them
+	 * are reused.
+	 * @param base_array_layer First array layer of the view
+	 * @param n_array_layers Number of array layers of the view, all the layers from the base one if 0
+	 * @param base_mip_level First mip level of the view
+	 * @param n_mip_levels Number of mip levels of the view, all the levels from the base one if 0
+	 */
+	ImageView &request_view(VkImageViewType view_type, VkFormat format = VK_FORMAT_UNDEFINED, uint32_t base_array_layer = 0, uint32_t n_array_layers = 0,
+	                        uint32_t base_mip_level = 0, uint32_t n_mip_levels = 0);
+
   private:
 	Device &device;
 
@@ -121,10 +186,21 @@ class Image
 	/// Image views referring to this image
 	std::unordered_set<ImageView *> views;
 
+	/// Views owned by the image, by hash of their request
+	std::unordered_map<std::size_t, std::unique_ptr<ImageView>> cached_views;
+
+	std::mutex cached_views_mutex;
+
+	/// Tracked state of every mip level of every array layer, layer by layer, changed by recordings of const images
+	mutable std::vector<ImageSubresourceState> states;
+
 	uint8_t *mapped_data{nullptr};
 
 	/// Whether it was mapped with vmaMapMemory
 	bool mapped{false};
+
+	/// Whether the memory is owned by somebody else
+	bool aliased{false};
 };
 }        // namespace core
 }        // namespace vkb
@@ -0,0 +1,112 @@
+/* Copyright (c) 2020, Arm Limited and Contributors
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 the "License";
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "core/image_compression.h"
+
+#include <algorithm>
+
+#include "common/logging.h"
+#include "common/strings.h"
+#include "core/device.h"
+#include "core/physical_device.h"
+
+namespace vkb
+{
+namespace
+{
+/// Compression of the vendors whose rules are known, AFBC is disabled by storage usage as the afbc sample shows
+const FramebufferCompression FRAMEBUFFER_COMPRESSIONS[] = {
+    {ARM_VENDOR_ID, "AFBC", VK_IMAGE_USAGE_STORAGE_BIT, 0.5},
+};
+
+/// Compression ratio assumed when the driver reports an image of an unknown vendor is not compressed
+constexpr double DEFAULT_COMPRESSION_RATIO = 0.5;
+
+/// Writes per second the bandwidth cost is estimated for, e.g. a render target drawn every frame
+constexpr double WRITES_PER_SECOND = 60.0;
+
+/**
+ * @return True if the driver reports that the image is not compressed
+ */
+bool is_compression_disabled(Device &device, VkImage image)
+{
+	VkImageCompressionPropertiesEXT compression_properties{VK_STRUCTURE_TYPE_IMAGE_COMPRESSION_PROPERTIES_EXT};
+
+	VkSubresourceLayout2EXT layout{VK_STRUCTURE_TYPE_SUBRESOURCE_LAYOUT_2_EXT};
+	layout.pNext = &compression_properties;
+
+	VkImageSubresource2EXT subresource{VK_STRUCTURE_TYPE_IMAGE_SUBRESOURCE_2_EXT};
+	subresource.imageSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+
+	vkGetImageSubresourceLayout2EXT(device.get_handle(), image, &subresource, &layout);
+
+	return compression_properties.imageCompressionFlags & VK_IMAGE_COMPRESSION_DISABLED_EXT;
+}
+}        // namespace
+
+const FramebufferCompression *get_framebuffer_compression(const PhysicalDevice &gpu)
+{
+	for (auto &compression : FRAMEBUFFER_COMPRESSIONS)
+	{
+		if (compression.vendor_id == gpu.get_properties().vendorID)
+		{
+			return &compression;
+		}
+	}
+
+	return nullptr;
+}
+
+bool is_framebuffer_compressed(const PhysicalDevice &gpu, VkFormat format, VkImageUsageFlags usage, VkImageTiling tiling)
+{
+	auto *compression = get_framebuffer_compression(gpu);
+
+	return compression && !is_depth_stencil_format(format) && tiling == VK_IMAGE_TILING_OPTIMAL && !(usage & compression->disabling_usage);
+}
+
+void check_image_compression(Device &device, VkImage image, VkFormat format, const VkExtent3D &extent, VkImageUsageFlags usage, VkImageTiling tiling, const char *description)
+{
+	if (is_depth_stencil_format(format) || tiling != VK_IMAGE_TILING_OPTIMAL)
+	{
+		return;
+	}
+
+	auto *compression = get_framebuffer_compression(device.get_gpu());
+
+	if (image != VK_NULL_HANDLE && device.is_enabled(VK_EXT_IMAGE_COMPRESSION_CONTROL_EXTENSION_NAME))
+	{
+		if (!is_compression_disabled(device, image))
+		{
+			return;
+		}
+	}
+	else if (!compression || !(usage & compression->disabling_usage))
+	{
+		return;
+	}
+
+	double ratio = compression ? compression->compression_ratio : DEFAULT_COMPRESSION_RATIO;
+
+	// Extra bytes of every write of the whole image
+	double extra_mib = static_cast<double>(extent.width) * extent.height * extent.depth * std::max(get_bits_per_pixel(format), 0) / 8 * (1.0 - ratio) / (1024 * 1024);
+
+	LOGW("{} image {}x{} {} with usage {} is not compressed{}{}, writing it costs about {:.1f} MiB more ({:.0f} MiB/s at {:.0f} writes per second)",
+	     description, extent.width, extent.height, to_string(format), image_usage_to_string(usage),
+	     compression ? " with " : "", compression ? compression->name : "",
+	     extra_mib, extra_mib * WRITES_PER_SECOND, WRITES_PER_SECOND);
+}
+}        // namespace vkb
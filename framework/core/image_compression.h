@@ -0,0 +1,72 @@
+/* Copyright (c) 2020, Arm Limited and Contributors
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 the "License";
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include "common/vk_common.h"
+
+namespace vkb
+{
+class Device;
+class PhysicalDevice;
+
+/// Vendor identifier of Arm GPUs, which compress images with AFBC
+constexpr uint32_t ARM_VENDOR_ID = 0x13B5;
+
+/**
+ * @brief Lossless framebuffer compression of the GPUs of a vendor, and the image usages known to disable it
+ */
+struct FramebufferCompression
+{
+	/// Vendor identifier of the GPUs
+	uint32_t vendor_id;
+
+	/// Name of the compression scheme
+	const char *name;
+
+	/// Usages which disable the compression of the images created with them
+	VkImageUsageFlags disabling_usage;
+
+	/// Typical size of compressed color images relative to their uncompressed size
+	double compression_ratio;
+};
+
+/**
+ * @return The framebuffer compression of a GPU, null if it is not known
+ */
+const FramebufferCompression *get_framebuffer_compression(const PhysicalDevice &gpu);
+
+/**
+ * @return True if the known framebuffer compression of a GPU applies to images created with these parameters,
+ *         only optimally tiled color images are compressed
+ */
+bool is_framebuffer_compressed(const PhysicalDevice &gpu, VkFormat format, VkImageUsageFlags usage, VkImageTiling tiling);
+
+/**
+ * @brief Warns if a color image is not losslessly compressed, with the bandwidth it costs
+ *        If VK_EXT_image_compression_control is enabled the driver tells whether the image is compressed,
+ *        otherwise the usage is checked against the ones known to disable the compression of the GPU.
+ * @param device Device which created the image
+ * @param image The image, or a null handle if it can't be queried, like swapchain images
+ * @param format Format of the image
+ * @param extent Extent of the image
+ * @param usage Usage the image was created with
+ * @param tiling Tiling of the image
+ * @param description What the image is used for, to name it in the warning
+ */
+void check_image_compression(Device &device, VkImage image, VkFormat format, const VkExtent3D &extent, VkImageUsageFlags usage, VkImageTiling tiling, const char *description);
+}        // namespace vkb
@@ -24,18 +24,22 @@ namespace vkb
 {
 namespace core
 {
-ImageView::ImageView(Image &img, VkImageViewType view_type, VkFormat format) :
+ImageView::ImageView(Image &img, VkImageViewType view_type, VkFormat format, uint32_t base_array_layer, uint32_t n_array_layers,
+                     uint32_t base_mip_level, uint32_t n_mip_levels) :
     device{img.get_device()},
     image{&img},
-    format{format}
+    format{format},
+    view_type{view_type}
 {
 	if (format == VK_FORMAT_UNDEFINED)
 	{
 		this->format = format = image->get_format();
 	}
 
-	subresource_range.levelCount = image->get_subresource().mipLevel;
-	subresource_range.layerCount = image->get_subresource().arrayLayer;
+	subresource_range.baseMipLevel   = base_mip_level;
+	subresource_range.levelCount     = n_mip_levels == 0 ? image->get_subresource().mipLevel - base_mip_level : n_mip_levels;
+	subresource_range.baseArrayLayer = base_array_layer;
+	subresource_range.layerCount     = n_array_layers == 0 ? image->get_subresource().arrayLayer - base_array_layer : n_array_layers;
 
 	if (is_depth_stencil_format(format))
 	{
@@ -69,6 +73,7 @@ ImageView::ImageView(ImageView &&other) :
     image{other.image},
     handle{other.handle},
     format{other.format},
+    view_type{other.view_type},
     subresource_range{other.subresource_range}
 {
 	// Remove old view from image set and add this new one
@@ -108,6 +113,11 @@ VkFormat ImageView::get_format() const
 	return format;
 }
 
+VkImageViewType ImageView::get_view_type() const
+{
+	return view_type;
+}
+
 VkImageSubresourceRange ImageView::get_subresource_range() const
 {
 	return subresource_range;
@@ -28,7 +28,15 @@ namespace core
 class ImageView
 {
   public:
-	ImageView(Image &image, VkImageViewType view_type, VkFormat format = VK_FORMAT_UNDEFINED);
+	/**
+	 * @brief Creates a view of the image
+	 * @param base_array_layer First array layer of the view
+	 * @param n_array_layers Number of array layers of the view, all the layers from the base one if 0
+	 * @param base_mip_level First mip level of the view
+	 * @param n_mip_levels Number of mip levels of the view, all the levels from the base one if 0
+	 */
+	ImageView(Image &image, VkImageViewType view_type, VkFormat format = VK_FORMAT_UNDEFINED, uint32_t base_array_layer = 0, uint32_t n_array_layers = 0,
+	          uint32_t base_mip_level = 0, uint32_t n_mip_levels = 0);
 
 	ImageView(ImageView &) = delete;
 
@@ -52,6 +60,8 @@ class ImageView
 
 	VkFormat get_format() const;
 
+	VkImageViewType get_view_type() const;
+
 	VkImageSubresourceRange get_subresource_range() const;
 
 	VkImageSubresourceLayers get_subresource_layers() const;
@@ -65,6 +75,8 @@ class ImageView
 
 	VkFormat format{};
 
+	VkImageViewType view_type{};
+
 	VkImageSubresourceRange subresource_range{};
 };
 }        // namespace core
@@ -25,7 +25,7 @@ namespace vkb
 {
 namespace
 {
-#if defined(VKB_DEBUG) || defined(VKB_VALIDATION_LAYERS)
+#if defined(VKB_DEBUG) || defined(VKB_VALIDATION_LAYERS) || defined(VKB_DEBUG_MARKERS)
 
 VKAPI_ATTR VkBool32 VKAPI_CALL debug_utils_messenger_callback(VkDebugUtilsMessageSeverityFlagBitsEXT message_severity, VkDebugUtilsMessageTypeFlagsEXT message_type,
                                                               const VkDebugUtilsMessengerCallbackDataEXT *callback_data,
@@ -132,7 +132,9 @@ std::vector<const char *> get_optimal_validation_layers(const std::vector<VkLaye
 Instance::Instance(const std::string &                           application_name,
                    const std::unordered_map<const char *, bool> &required_extensions,
                    const std::vector<const char *> &             required_validation_layers,
-                   bool                                          headless)
+                   bool                                          headless,
+                   uint32_t                                      api_version) :
+    api_version{api_version}
 {
 	VkResult result = volkInitialize();
 	if (result)
@@ -140,13 +142,31 @@ Instance::Instance(const std::string &                           application_nam
 		throw VulkanException(result, "Failed to initialize volk.");
 	}
 
+	// Vulkan 1.0 loaders reject other versions, and do not provide vkEnumerateInstanceVersion
+	if (api_version > VK_API_VERSION_1_0)
+	{
+		uint32_t instance_version = VK_API_VERSION_1_0;
+		if (vkEnumerateInstanceVersion)
+		{
+			VK_CHECK(vkEnumerateInstanceVersion(&instance_version));
+		}
+
+		if (instance_version < api_version)
+		{
+			LOGW("Vulkan {}.{} is not supported by the instance, using {}.{}",
+			     VK_VERSION_MAJOR(api_version), VK_VERSION_MINOR(api_version),
+			     VK_VERSION_MAJOR(instance_version), VK_VERSION_MINOR(instance_version));
+			this->api_version = instance_version;
+		}
+	}
+
 	uint32_t instance_extension_count;
 	VK_CHECK(vkEnumerateInstanceExtensionProperties(nullptr, &instance_extension_count, nullptr));
 
 	std::vector<VkExtensionProperties> available_instance_extensions(instance_extension_count);
 	VK_CHECK(vkEnumerateInstanceExtensionProperties(nullptr, &instance_extension_count, available_instance_extensions.data()));
 
-#if defined(VKB_DEBUG) || defined(VKB_VALIDATION_LAYERS)
+#if defined(VKB_DEBUG) || defined(VKB_VALIDATION_LAYERS) || defined(VKB_DEBUG_MARKERS)
 	// Check if VK_EXT_debug_utils is supported, which supersedes VK_EXT_Debug_Report
 	bool debug_utils = false;
 	for (auto &available_extension : available_instance_extensions)
@@ -260,7 +280,7 @@ Instance::Instance(const std::string &                           application_nam
 	app_info.applicationVersion = 0;
 	app_info.pEngineName        = "Vulkan Samples";
 	app_info.engineVersion      = 0;
-	app_info.apiVersion         = VK_MAKE_VERSION(1, 0, 0);
+	app_info.apiVersion         = this->api_version;
 
 	VkInstanceCreateInfo instance_info = {VK_STRUCTURE_TYPE_INSTANCE_CREATE_INFO};
 
@@ -272,7 +292,7 @@ Instance::Instance(const std::string &                           application_nam
 	instance_info.enabledLayerCount   = to_u32(requested_validation_layers.size());
 	instance_info.ppEnabledLayerNames = requested_validation_layers.data();
 
-#if defined(VKB_DEBUG) || defined(VKB_VALIDATION_LAYERS)
+#if defined(VKB_DEBUG) || defined(VKB_VALIDATION_LAYERS) || defined(VKB_DEBUG_MARKERS)
 	VkDebugUtilsMessengerCreateInfoEXT debug_utils_create_info  = {VK_STRUCTURE_TYPE_DEBUG_UTILS_MESSENGER_CREATE_INFO_EXT};
 	VkDebugReportCallbackCreateInfoEXT debug_report_create_info = {VK_STRUCTURE_TYPE_DEBUG_REPORT_CREATE_INFO_EXT};
 	if (debug_utils)
@@ -302,7 +322,7 @@ Instance::Instance(const std::string &                           application_nam
 
 	volkLoadInstance(handle);
 
-#if defined(VKB_DEBUG) || defined(VKB_VALIDATION_LAYERS)
+#if defined(VKB_DEBUG) || defined(VKB_VALIDATION_LAYERS) || defined(VKB_DEBUG_MARKERS)
 	if (debug_utils)
 	{
 		result = vkCreateDebugUtilsMessengerEXT(handle, &debug_utils_create_info, nullptr, &debug_utils_messenger);
@@ -339,7 +359,7 @@ Instance::Instance(VkInstance instance) :
 
 Instance::~Instance()
 {
-#if defined(VKB_DEBUG) || defined(VKB_VALIDATION_LAYERS)
+#if defined(VKB_DEBUG) || defined(VKB_VALIDATION_LAYERS) || defined(VKB_DEBUG_MARKERS)
 	if (debug_utils_messenger != VK_NULL_HANDLE)
 	{
 		vkDestroyDebugUtilsMessengerEXT(handle, debug_utils_messenger, nullptr);
@@ -376,24 +396,104 @@ void Instance::query_gpus()
 	{
 		gpus.push_back(std::make_unique<PhysicalDevice>(*this, physical_device));
 	}
+
+	if (!is_enabled(VK_KHR_DEVICE_GROUP_CREATION_EXTENSION_NAME))
+	{
+		return;
+	}
+
+	uint32_t group_count{0};
+	VK_CHECK(vkEnumeratePhysicalDeviceGroupsKHR(handle, &group_count, nullptr));
+
+	std::vector<VkPhysicalDeviceGroupPropertiesKHR> group_properties(group_count, {VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_GROUP_PROPERTIES_KHR});
+	VK_CHECK(vkEnumeratePhysicalDeviceGroupsKHR(handle, &group_count, group_properties.data()));
+
+	for (auto &properties : group_properties)
+	{
+		std::vector<PhysicalDevice *> group;
+
+		for (uint32_t i = 0; i < properties.physicalDeviceCount; ++i)
+		{
+			auto it = std::find_if(gpus.begin(), gpus.end(), [&properties, i](const std::unique_ptr<PhysicalDevice> &gpu) {
+				return gpu->get_handle() == properties.physicalDevices[i];
+			});
+
+			if (it != gpus.end())
+			{
+				group.push_back(it->get());
+			}
+		}
+
+		if (group.size() > 1)
+		{
+			LOGI("Found a device group of {} GPUs", group.size());
+		}
+
+		gpu_groups.push_back(std::move(group));
+	}
 }
 
-PhysicalDevice &Instance::get_suitable_gpu()
+PhysicalDevice &Instance::get_suitable_gpu(VkSurfaceKHR surface)
 {
 	assert(!gpus.empty() && "No physical devices were found on the system.");
 
-	// Find a discrete GPU
+	// The first of the GPUs with the best score, so that equal GPUs keep their enumeration order
+	PhysicalDevice *best_gpu{nullptr};
+	uint64_t        best_score{0};
+
 	for (auto &gpu : gpus)
 	{
-		if (gpu->get_properties().deviceType == VK_PHYSICAL_DEVICE_TYPE_DISCRETE_GPU)
+		uint64_t score = gpu->get_score(surface);
+
+		if (score > best_score)
 		{
-			return *gpu;
+			best_gpu   = gpu.get();
+			best_score = score;
 		}
 	}
 
-	// Otherwise just pick the first one
-	LOGW("Couldn't find a discrete physical device, picking default GPU");
-	return *gpus.at(0);
+	if (!best_gpu)
+	{
+		LOGW("Couldn't find a physical device which can render to the surface, picking default GPU");
+		return *gpus.at(0);
+	}
+
+	if (best_gpu->get_properties().deviceType != VK_PHYSICAL_DEVICE_TYPE_DISCRETE_GPU)
+	{
+		LOGW("Couldn't find a discrete physical device, picking {}", best_gpu->get_properties().deviceName);
+	}
+
+	return *best_gpu;
+}
+
+PhysicalDevice &Instance::get_gpu(size_t index)
+{
+	if (index >= gpus.size())
+	{
+		throw std::runtime_error("No physical device at index " + std::to_string(index) + ", found " + std::to_string(gpus.size()));
+	}
+
+	return *gpus[index];
+}
+
+std::vector<PhysicalDevice *> Instance::get_gpu_group(const PhysicalDevice &gpu) const
+{
+	for (auto &group : gpu_groups)
+	{
+		if (std::find(group.begin(), group.end(), &gpu) != group.end())
+		{
+			return group;
+		}
+	}
+
+	auto it = std::find_if(gpus.begin(), gpus.end(), [&gpu](const std::unique_ptr<PhysicalDevice> &candidate) { return candidate.get() == &gpu; });
+
+	if (it == gpus.end())
+	{
+		throw std::runtime_error("Physical device does not belong to the instance");
+	}
+
+	return {it->get()};
 }
 
 bool Instance::is_enabled(const char *extension) const
@@ -410,4 +510,9 @@ const std::vector<const char *> &Instance::get_extensions()
 {
 	return enabled_extensions;
 }
+
+uint32_t Instance::get_api_version() const
+{
+	return api_version;
+}
 }        // namespace vkb
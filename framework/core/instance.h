@@ -45,12 +45,14 @@ class Instance
 	 * @param required_extensions The extensions requested to be enabled
 	 * @param required_validation_layers The validation layers to be enabled
 	 * @param headless Whether the application is requesting a headless setup or not
+	 * @param api_version The Vulkan API version the application uses
 	 * @throws runtime_error if the required extensions and validation layers are not found
 	 */
 	Instance(const std::string &                           application_name,
 	         const std::unordered_map<const char *, bool> &required_extensions        = {},
 	         const std::vector<const char *> &             required_validation_layers = {},
-	         bool                                          headless                   = false);
+	         bool                                          headless                   = false,
+	         uint32_t                                      api_version                = VK_API_VERSION_1_0);
 
 	/**
 	 * @brief Queries the GPUs of a VkInstance that is already created
@@ -74,10 +76,23 @@ class Instance
 	void query_gpus();
 
 	/**
-	 * @brief Tries to find the first available discrete GPU
+	 * @brief Picks the physical device with the best score, discrete GPUs first
+	 * @param surface The surface the GPU must present to, or VK_NULL_HANDLE for headless rendering
 	 * @returns A valid physical device
 	 */
-	PhysicalDevice &get_suitable_gpu();
+	PhysicalDevice &get_suitable_gpu(VkSurfaceKHR surface = VK_NULL_HANDLE);
+
+	/**
+	 * @brief Gets a physical device by its index, in the order they were enumerated
+	 * @throws std::runtime_error if there is no physical device at that index
+	 */
+	PhysicalDevice &get_gpu(size_t index);
+
+	/**
+	 * @brief Gets the device group a physical device belongs to, whose devices can be combined in a single logical device
+	 * @return The physical devices of the group, only the given one if device groups were not queried
+	 */
+	std::vector<PhysicalDevice *> get_gpu_group(const PhysicalDevice &gpu) const;
 
 	/**
 	 * @brief Checks if the given extension is enabled in the VkInstance
@@ -89,18 +104,28 @@ class Instance
 
 	const std::vector<const char *> &get_extensions();
 
+	/**
+	 * @return The Vulkan API version the instance was created with, which bounds the version of its devices
+	 */
+	uint32_t get_api_version() const;
+
   private:
 	/**
 	 * @brief The Vulkan instance
 	 */
 	VkInstance handle{VK_NULL_HANDLE};
 
+	/**
+	 * @brief The API version of the instance, assumed to be 1.0 for instances created elsewhere
+	 */
+	uint32_t api_version{VK_API_VERSION_1_0};
+
 	/**
 	 * @brief The enabled extensions
 	 */
 	std::vector<const char *> enabled_extensions;
 
-#if defined(VKB_DEBUG) || defined(VKB_VALIDATION_LAYERS)
+#if defined(VKB_DEBUG) || defined(VKB_VALIDATION_LAYERS) || defined(VKB_DEBUG_MARKERS)
 	/**
 	 * @brief Debug utils messenger callback for VK_EXT_Debug_Utils
 	 */
@@ -116,5 +141,10 @@ class Instance
 	 * @brief The physical devices found on the machine
 	 */
 	std::vector<std::unique_ptr<PhysicalDevice>> gpus;
+
+	/**
+	 * @brief The device groups found on the machine, queried if VK_KHR_device_group_creation is enabled
+	 */
+	std::vector<std::vector<PhysicalDevice *>> gpu_groups;
 };        // namespace Instance
 }        // namespace vkb
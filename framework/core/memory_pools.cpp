@@ -0,0 +1,293 @@
+/* Copyright (c) 2020, Arm Limited and Contributors
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 the "License";
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#include "memory_pools.h"
+
+#include "common/error.h"
+#include "common/helpers.h"
+#include "common/strings.h"
+#include "core/buffer.h"
+#include "core/device.h"
+
+namespace vkb
+{
+namespace
+{
+const VmaAllocationCreateFlags UNPOOLED_FLAGS = VMA_ALLOCATION_CREATE_DEDICATED_MEMORY_BIT | VMA_ALLOCATION_CREATE_NEVER_ALLOCATE_BIT;
+
+inline bool is_out_of_memory(VkResult result)
+{
+	return result == VK_ERROR_OUT_OF_DEVICE_MEMORY || result == VK_ERROR_OUT_OF_HOST_MEMORY;
+}
+
+inline const char *usage_class_name(MemoryUsageClass usage_class)
+{
+	switch (usage_class)
+	{
+		case MemoryUsageClass::FrameUniforms:
+			return "frame uniforms";
+		case MemoryUsageClass::StaticGeometry:
+			return "static geometry";
+		case MemoryUsageClass::RenderTarget:
+			return "render target";
+		case MemoryUsageClass::Transient:
+			return "transient";
+		default:
+			return "default";
+	}
+}
+}        // namespace
+
+constexpr VkDeviceSize MemoryPools::FRAME_UNIFORMS_BLOCK_SIZE;
+constexpr VkDeviceSize MemoryPools::STATIC_GEOMETRY_BLOCK_SIZE;
+constexpr VkDeviceSize MemoryPools::RENDER_TARGET_BLOCK_SIZE;
+constexpr VkDeviceSize MemoryPools::TRANSIENT_BLOCK_SIZE;
+constexpr uint32_t     MemoryPools::DEDICATED_RENDER_TARGET_TEXELS;
+
+MemoryPools::MemoryPools(Device &device) :
+    device{device}
+{
+}
+
+MemoryPools::~MemoryPools()
+{
+	for (auto &it : pools)
+	{
+		vmaDestroyPool(device.get_memory_allocator(), it.second);
+	}
+}
+
+MemoryUsageClass MemoryPools::classify(const VkBufferCreateInfo &buffer_info, VmaMemoryUsage memory_usage)
+{
+	if (memory_usage == VMA_MEMORY_USAGE_CPU_ONLY && buffer_info.usage == VK_BUFFER_USAGE_TRANSFER_SRC_BIT)
+	{
+		return MemoryUsageClass::Transient;
+	}
+
+	if (memory_usage == VMA_MEMORY_USAGE_CPU_TO_GPU && (buffer_info.usage & VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT))
+	{
+		return MemoryUsageClass::FrameUniforms;
+	}
+
+	if (memory_usage == VMA_MEMORY_USAGE_GPU_ONLY && (buffer_info.usage & (VK_BUFFER_USAGE_VERTEX_BUFFER_BIT | VK_BUFFER_USAGE_INDEX_BUFFER_BIT)))
+	{
+		return MemoryUsageClass::StaticGeometry;
+	}
+
+	return MemoryUsageClass::Default;
+}
+
+MemoryUsageClass MemoryPools::classify(const VkImageCreateInfo &image_info, VmaMemoryUsage memory_usage)
+{
+	// Lazily allocated memory is left to the default selection of the allocator
+	if (memory_usage != VMA_MEMORY_USAGE_GPU_ONLY || (image_info.usage & VK_IMAGE_USAGE_TRANSIENT_ATTACHMENT_BIT))
+	{
+		return MemoryUsageClass::Default;
+	}
+
+	if (image_info.usage & (VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT | VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT))
+	{
+		return MemoryUsageClass::RenderTarget;
+	}
+
+	return MemoryUsageClass::Default;
+}
+
+VkResult MemoryPools::create_buffer(const VkBufferCreateInfo &buffer_info, const VmaAllocationCreateInfo &memory_info,
+                                    VkBuffer &buffer, VmaAllocation &allocation, VmaAllocationInfo &allocation_info)
+{
+	VmaAllocator allocator = device.get_memory_allocator();
+
+	return allocate(
+	    classify(buffer_info, memory_info.usage), memory_info,
+	    [&](const VmaAllocationCreateInfo &info) {
+		    return vmaCreateBuffer(allocator, &buffer_info, &info, &buffer, &allocation, &allocation_info);
+	    },
+	    [&](const VmaAllocationCreateInfo &info, uint32_t &memory_type) {
+		    return vmaFindMemoryTypeIndexForBufferInfo(allocator, &buffer_info, &info, &memory_type);
+	    });
+}
+
+VkResult MemoryPools::create_image(const VkImageCreateInfo &image_info, const VmaAllocationCreateInfo &memory_info,
+                                   VkImage &image, VmaAllocation &allocation)
+{
+	VmaAllocator allocator = device.get_memory_allocator();
+
+	auto usage_class = classify(image_info, memory_info.usage);
+
+	VmaAllocationCreateInfo image_memory_info{memory_info};
+
+	if (usage_class == MemoryUsageClass::RenderTarget && image_memory_info.pool == VK_NULL_HANDLE &&
+	    image_info.extent.width * image_info.extent.height * image_info.extent.depth * image_info.samples >= DEDICATED_RENDER_TARGET_TEXELS)
+	{
+		// Full screen attachments are resized with the swapchain, in their own memory they do not leave holes in the pool
+		image_memory_info.flags |= VMA_ALLOCATION_CREATE_DEDICATED_MEMORY_BIT;
+	}
+
+	return allocate(
+	    usage_class, image_memory_info,
+	    [&](const VmaAllocationCreateInfo &info) {
+		    return vmaCreateImage(allocator, &image_info, &info, &image, &allocation, nullptr);
+	    },
+	    [&](const VmaAllocationCreateInfo &info, uint32_t &memory_type) {
+		    return vmaFindMemoryTypeIndexForImageInfo(allocator, &image_info, &info, &memory_type);
+	    });
+}
+
+VkResult MemoryPools::allocate(MemoryUsageClass usage_class, const VmaAllocationCreateInfo &memory_info,
+                               const CreateFunc &create, const FindMemoryTypeFunc &find_memory_type)
+{
+	VmaAllocationCreateInfo info{memory_info};
+	info.flags |= VMA_ALLOCATION_CREATE_WITHIN_BUDGET_BIT;
+
+	if (usage_class != MemoryUsageClass::Default && info.pool == VK_NULL_HANDLE && (info.flags & UNPOOLED_FLAGS) == 0)
+	{
+		info.pool = request_pool(usage_class, memory_info, find_memory_type);
+	}
+
+	VkResult result = create(info);
+
+	bool fallback{false};
+
+	if (is_out_of_memory(result) && info.pool != memory_info.pool)
+	{
+		// The pool is bound to a single memory type, any other type compatible with the resource may still have room
+		info.pool = memory_info.pool;
+		result    = create(info);
+		fallback  = true;
+	}
+
+	if (is_out_of_memory(result))
+	{
+		// Exceeding the budget may page memory out, but it is better than failing to load
+		info.flags &= ~VMA_ALLOCATION_CREATE_WITHIN_BUDGET_BIT;
+		result   = create(info);
+		fallback = true;
+	}
+
+	if (fallback && result == VK_SUCCESS && !reported_fallback.exchange(true))
+	{
+		LOGW("Memory budget exceeded for a {} allocation, falling back to other memory types", usage_class_name(usage_class));
+	}
+
+	return result;
+}
+
+VmaPool MemoryPools::request_pool(MemoryUsageClass usage_class, const VmaAllocationCreateInfo &memory_info, const FindMemoryTypeFunc &find_memory_type)
+{
+	uint32_t memory_type{0};
+
+	if (find_memory_type(memory_info, memory_type) != VK_SUCCESS)
+	{
+		return VK_NULL_HANDLE;
+	}
+
+	uint64_t key = (static_cast<uint64_t>(usage_class) << 32) | memory_type;
+
+	std::lock_guard<std::mutex> lock{pools_mutex};
+
+	auto it = pools.find(key);
+	if (it != pools.end())
+	{
+		return it->second;
+	}
+
+	VmaPoolCreateInfo pool_info{};
+	pool_info.memoryTypeIndex = memory_type;
+
+	switch (usage_class)
+	{
+		case MemoryUsageClass::FrameUniforms:
+			pool_info.blockSize = FRAME_UNIFORMS_BLOCK_SIZE;
+			break;
+		case MemoryUsageClass::StaticGeometry:
+			pool_info.blockSize = STATIC_GEOMETRY_BLOCK_SIZE;
+			break;
+		case MemoryUsageClass::RenderTarget:
+			pool_info.blockSize = RENDER_TARGET_BLOCK_SIZE;
+			break;
+		case MemoryUsageClass::Transient:
+			// Staging data is released in the order it was uploaded, which the linear algorithm reclaims as a ring
+			pool_info.flags     = VMA_POOL_CREATE_LINEAR_ALGORITHM_BIT;
+			pool_info.blockSize = TRANSIENT_BLOCK_SIZE;
+			break;
+		default:
+			break;
+	}
+
+	VmaPool pool{VK_NULL_HANDLE};
+
+	auto result = vmaCreatePool(device.get_memory_allocator(), &pool_info, &pool);
+	if (result != VK_SUCCESS)
+	{
+		LOGW("Cannot create a {} memory pool ({}), using the default pool", usage_class_name(usage_class), to_string(result));
+		return VK_NULL_HANDLE;
+	}
+
+	pools.emplace(key, pool);
+
+	return pool;
+}
+
+uint32_t MemoryPools::defragment(const std::vector<core::Buffer *> &buffers)
+{
+	std::vector<VmaAllocation> allocations;
+	allocations.reserve(buffers.size());
+
+	for (auto buffer : buffers)
+	{
+		allocations.push_back(buffer->get_allocation());
+	}
+
+	std::vector<VkBool32> allocations_changed(allocations.size(), VK_FALSE);
+
+	// Without a command buffer only host visible memory is compacted, on the CPU
+	VmaDefragmentationInfo2 defragmentation_info{};
+	defragmentation_info.allocationCount         = to_u32(allocations.size());
+	defragmentation_info.pAllocations            = allocations.data();
+	defragmentation_info.pAllocationsChanged     = allocations_changed.data();
+	defragmentation_info.maxCpuBytesToMove       = VK_WHOLE_SIZE;
+	defragmentation_info.maxCpuAllocationsToMove = UINT32_MAX;
+
+	VmaDefragmentationStats    stats{};
+	VmaDefragmentationContext context{VK_NULL_HANDLE};
+
+	auto result = vmaDefragmentationBegin(device.get_memory_allocator(), &defragmentation_info, &stats, &context);
+	if (result != VK_SUCCESS && result != VK_NOT_READY)
+	{
+		throw VulkanException{result, "Cannot defragment memory"};
+	}
+
+	VK_CHECK(vmaDefragmentationEnd(device.get_memory_allocator(), context));
+
+	uint32_t moved{0};
+
+	for (size_t i = 0; i < buffers.size(); ++i)
+	{
+		if (allocations_changed[i])
+		{
+			buffers[i]->rebind_memory();
+			++moved;
+		}
+	}
+
+	LOGI("Defragmentation moved {} buffers ({} bytes) and freed {} memory blocks", moved, stats.bytesMoved, stats.deviceMemoryBlocksFreed);
+
+	return moved;
+}
+}        // namespace vkb
@@ -0,0 +1,162 @@
+/* Copyright (c) 2020, Arm Limited and Contributors
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 the "License";
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#pragma once
+
+#include <atomic>
+#include <functional>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+#include "common/vk_common.h"
+
+namespace vkb
+{
+class Device;
+
+namespace core
+{
+class Buffer;
+}
+
+/**
+ * @brief Classes of resources sharing an allocation policy
+ */
+enum class MemoryUsageClass
+{
+	/// Allocated from the default memory of the allocator
+	Default,
+
+	/// Host visible uniform data rewritten every frame
+	FrameUniforms,
+
+	/// Device local vertex and index data uploaded once
+	StaticGeometry,
+
+	/// Color and depth attachments, large ones get a dedicated allocation
+	RenderTarget,
+
+	/// Short lived host staging data, freed roughly in allocation order
+	Transient
+};
+
+/**
+ * @brief Routes the allocations of buffers and images to custom VMA pools depending on their usage class,
+ *        keeping long lived resources apart from transient ones so they do not fragment each other.
+ *        Every allocation is first tried within the memory budget of the device, falling back to
+ *        other memory types when device local memory is exhausted.
+ */
+class MemoryPools
+{
+  public:
+	/// Size of the blocks of the per usage class pools
+	static constexpr VkDeviceSize FRAME_UNIFORMS_BLOCK_SIZE = 16 * 1024 * 1024;
+
+	static constexpr VkDeviceSize STATIC_GEOMETRY_BLOCK_SIZE = 64 * 1024 * 1024;
+
+	static constexpr VkDeviceSize RENDER_TARGET_BLOCK_SIZE = 64 * 1024 * 1024;
+
+	static constexpr VkDeviceSize TRANSIENT_BLOCK_SIZE = 64 * 1024 * 1024;
+
+	/// Render targets with at least this many texels per layer and sample get their own device memory
+	static constexpr uint32_t DEDICATED_RENDER_TARGET_TEXELS = 1024 * 1024;
+
+	MemoryPools(Device &device);
+
+	MemoryPools(const MemoryPools &) = delete;
+
+	MemoryPools(MemoryPools &&) = delete;
+
+	~MemoryPools();
+
+	MemoryPools &operator=(const MemoryPools &) = delete;
+
+	MemoryPools &operator=(MemoryPools &&) = delete;
+
+	/**
+	 * @return The usage class of a buffer
+	 */
+	static MemoryUsageClass classify(const VkBufferCreateInfo &buffer_info, VmaMemoryUsage memory_usage);
+
+	/**
+	 * @return The usage class of an image
+	 */
+	static MemoryUsageClass classify(const VkImageCreateInfo &image_info, VmaMemoryUsage memory_usage);
+
+	/**
+	 * @brief Creates a buffer and allocates its memory following the policy of its usage class
+	 * @param buffer_info The buffer to create
+	 * @param memory_info The requested allocation, a pool or a dedicated allocation set by the caller is kept
+	 * @param buffer The created buffer
+	 * @param allocation The allocation bound to the buffer
+	 * @param allocation_info Information about the allocation
+	 * @return VK_SUCCESS or the error of the last allocation attempt
+	 */
+	VkResult create_buffer(const VkBufferCreateInfo &buffer_info, const VmaAllocationCreateInfo &memory_info,
+	                       VkBuffer &buffer, VmaAllocation &allocation, VmaAllocationInfo &allocation_info);
+
+	/**
+	 * @brief Creates an image and allocates its memory following the policy of its usage class
+	 * @param image_info The image to create
+	 * @param memory_info The requested allocation, a pool or a dedicated allocation set by the caller is kept
+	 * @param image The created image
+	 * @param allocation The allocation bound to the image
+	 * @return VK_SUCCESS or the error of the last allocation attempt
+	 */
+	VkResult create_image(const VkImageCreateInfo &image_info, const VmaAllocationCreateInfo &memory_info,
+	                      VkImage &image, VmaAllocation &allocation);
+
+	/**
+	 * @brief Compacts the host visible memory of a set of buffers, moving their allocations
+	 *        and recreating the handles of the buffers which moved. The buffers must not be in use by the GPU
+	 *        nor mapped with Buffer::map, and descriptor sets referencing them have to be updated afterwards.
+	 * @param buffers The buffers allowed to move
+	 * @return The number of buffers which moved
+	 */
+	uint32_t defragment(const std::vector<core::Buffer *> &buffers);
+
+  private:
+	using CreateFunc = std::function<VkResult(const VmaAllocationCreateInfo &)>;
+
+	using FindMemoryTypeFunc = std::function<VkResult(const VmaAllocationCreateInfo &, uint32_t &)>;
+
+	/**
+	 * @brief Tries the allocation from the pool of the usage class, then within budget from any memory type,
+	 *        then regardless of the budget
+	 */
+	VkResult allocate(MemoryUsageClass usage_class, const VmaAllocationCreateInfo &memory_info,
+	                  const CreateFunc &create, const FindMemoryTypeFunc &find_memory_type);
+
+	/**
+	 * @return The pool of a usage class for the memory type selected for an allocation, created on first use
+	 */
+	VmaPool request_pool(MemoryUsageClass usage_class, const VmaAllocationCreateInfo &memory_info, const FindMemoryTypeFunc &find_memory_type);
+
+	Device &device;
+
+	/// Pools by usage class in the high bits and memory type index in the low bits
+	std::unordered_map<uint64_t, VmaPool> pools;
+
+	/// Guards the pools, resources are created from several threads while loading
+	std::mutex pools_mutex;
+
+	/// Whether the budget fallback was already reported
+	std::atomic<bool> reported_fallback{false};
+};
+}        // namespace vkb
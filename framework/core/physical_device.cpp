@@ -17,22 +17,96 @@
 
 #include "physical_device.h"
 
+#include <algorithm>
+#include <cstring>
+#include <mutex>
+#include <unordered_map>
+
+#include "common/helpers.h"
+
 namespace vkb
 {
+namespace
+{
+/**
+ * @brief Identifies a model of GPU with a given driver, as pipeline caches do
+ */
+std::string get_capabilities_key(const VkPhysicalDeviceProperties &properties)
+{
+	uint32_t ids[] = {properties.vendorID, properties.deviceID, properties.driverVersion};
+
+	std::string key(sizeof(ids) + VK_UUID_SIZE, '\0');
+	std::memcpy(&key[0], ids, sizeof(ids));
+	std::memcpy(&key[sizeof(ids)], properties.pipelineCacheUUID, VK_UUID_SIZE);
+
+	return key;
+}
+
+std::shared_ptr<const PhysicalDeviceCapabilities> query_capabilities(VkPhysicalDevice physical_device, const VkPhysicalDeviceProperties &properties)
+{
+	static std::mutex                                                                         mutex;
+	static std::unordered_map<std::string, std::shared_ptr<const PhysicalDeviceCapabilities>> cache;
+
+	auto key = get_capabilities_key(properties);
+
+	std::lock_guard<std::mutex> lock{mutex};
+
+	auto it = cache.find(key);
+	if (it != cache.end())
+	{
+		return it->second;
+	}
+
+	auto capabilities = std::make_shared<PhysicalDeviceCapabilities>();
+
+	vkGetPhysicalDeviceFeatures(physical_device, &capabilities->features);
+	vkGetPhysicalDeviceMemoryProperties(physical_device, &capabilities->memory_properties);
+
+	uint32_t queue_family_properties_count = 0;
+	vkGetPhysicalDeviceQueueFamilyProperties(physical_device, &queue_family_properties_count, nullptr);
+	capabilities->queue_family_properties.resize(queue_family_properties_count);
+	vkGetPhysicalDeviceQueueFamilyProperties(physical_device, &queue_family_properties_count, capabilities->queue_family_properties.data());
+
+	uint32_t extension_count = 0;
+	VK_CHECK(vkEnumerateDeviceExtensionProperties(physical_device, nullptr, &extension_count, nullptr));
+	capabilities->extensions.resize(extension_count);
+	VK_CHECK(vkEnumerateDeviceExtensionProperties(physical_device, nullptr, &extension_count, capabilities->extensions.data()));
+
+	for (auto &extension : capabilities->extensions)
+	{
+		capabilities->extension_names.insert(extension.extensionName);
+	}
+
+	cache.emplace(key, capabilities);
+
+	return capabilities;
+}
+}        // namespace
+
 PhysicalDevice::PhysicalDevice(Instance &instance, VkPhysicalDevice physical_device) :
     instance{instance},
     handle{physical_device}
 {
-	vkGetPhysicalDeviceFeatures(physical_device, &features);
 	vkGetPhysicalDeviceProperties(physical_device, &properties);
-	vkGetPhysicalDeviceMemoryProperties(physical_device, &memory_properties);
 
-	LOGI("Found GPU: {}", properties.deviceName);
+	capabilities = query_capabilities(physical_device, properties);
 
-	uint32_t queue_family_properties_count = 0;
-	vkGetPhysicalDeviceQueueFamilyProperties(physical_device, &queue_family_properties_count, nullptr);
-	queue_family_properties = std::vector<VkQueueFamilyProperties>(queue_family_properties_count);
-	vkGetPhysicalDeviceQueueFamilyProperties(physical_device, &queue_family_properties_count, queue_family_properties.data());
+	if (instance.get_api_version() >= VK_API_VERSION_1_1 && properties.apiVersion >= VK_API_VERSION_1_1)
+	{
+		VkPhysicalDeviceProperties2 properties2{VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_PROPERTIES_2};
+		properties2.pNext = &subgroup_properties;
+
+		if (is_extension_supported(VK_EXT_SUBGROUP_SIZE_CONTROL_EXTENSION_NAME))
+		{
+			subgroup_properties.pNext = &subgroup_size_control_properties;
+		}
+
+		vkGetPhysicalDeviceProperties2(physical_device, &properties2);
+
+		subgroup_properties.pNext = nullptr;
+	}
+
+	LOGI("Found GPU: {}", properties.deviceName);
 }
 
 Instance &PhysicalDevice::get_instance() const
@@ -68,7 +142,7 @@ VkPhysicalDevice PhysicalDevice::get_handle() const
 
 const VkPhysicalDeviceFeatures &PhysicalDevice::get_features() const
 {
-	return features;
+	return capabilities->features;
 }
 
 const VkPhysicalDeviceProperties PhysicalDevice::get_properties() const
@@ -78,12 +152,86 @@ const VkPhysicalDeviceProperties PhysicalDevice::get_properties() const
 
 const VkPhysicalDeviceMemoryProperties PhysicalDevice::get_memory_properties() const
 {
-	return memory_properties;
+	return capabilities->memory_properties;
 }
 
 const std::vector<VkQueueFamilyProperties> &PhysicalDevice::get_queue_family_properties() const
 {
-	return queue_family_properties;
+	return capabilities->queue_family_properties;
+}
+
+const std::vector<VkExtensionProperties> &PhysicalDevice::get_extensions() const
+{
+	return capabilities->extensions;
+}
+
+bool PhysicalDevice::is_extension_supported(const std::string &extension) const
+{
+	return capabilities->extension_names.count(extension) > 0;
+}
+
+uint64_t PhysicalDevice::get_score(VkSurfaceKHR surface) const
+{
+	bool     can_render{false};
+	uint64_t score{1};
+
+	for (uint32_t i = 0; i < to_u32(capabilities->queue_family_properties.size()); ++i)
+	{
+		VkQueueFlags flags = capabilities->queue_family_properties[i].queueFlags;
+
+		if ((flags & VK_QUEUE_GRAPHICS_BIT) && (surface == VK_NULL_HANDLE || is_present_supported(surface, i)))
+		{
+			can_render = true;
+		}
+		else if (flags & (VK_QUEUE_COMPUTE_BIT | VK_QUEUE_TRANSFER_BIT))
+		{
+			// Async compute and dedicated transfers
+			score += 1ULL << 20;
+		}
+	}
+
+	if (!can_render)
+	{
+		return 0;
+	}
+
+	switch (properties.deviceType)
+	{
+		case VK_PHYSICAL_DEVICE_TYPE_DISCRETE_GPU:
+			score += 4ULL << 40;
+			break;
+		case VK_PHYSICAL_DEVICE_TYPE_INTEGRATED_GPU:
+			score += 3ULL << 40;
+			break;
+		case VK_PHYSICAL_DEVICE_TYPE_VIRTUAL_GPU:
+			score += 2ULL << 40;
+			break;
+		default:
+			score += 1ULL << 40;
+			break;
+	}
+
+	// Device local memory in MiB breaks the remaining ties
+	VkDeviceSize local_memory{0};
+	for (uint32_t i = 0; i < capabilities->memory_properties.memoryHeapCount; ++i)
+	{
+		if (capabilities->memory_properties.memoryHeaps[i].flags & VK_MEMORY_HEAP_DEVICE_LOCAL_BIT)
+		{
+			local_memory = std::max(local_memory, capabilities->memory_properties.memoryHeaps[i].size);
+		}
+	}
+
+	return score + std::min<VkDeviceSize>(local_memory >> 20, (1ULL << 20) - 1);
+}
+
+const VkPhysicalDeviceSubgroupProperties &PhysicalDevice::get_subgroup_properties() const
+{
+	return subgroup_properties;
+}
+
+const VkPhysicalDeviceSubgroupSizeControlPropertiesEXT &PhysicalDevice::get_subgroup_size_control_properties() const
+{
+	return subgroup_size_control_properties;
 }
 
 uint32_t PhysicalDevice::get_queue_family_performance_query_passes(
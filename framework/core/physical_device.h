@@ -17,12 +17,33 @@
 
 #pragma once
 
+#include <string>
+#include <unordered_set>
+
 #include "core/instance.h"
 
 namespace vkb
 {
 class Instance;
 
+/**
+ * @brief Capabilities of a physical device which only change with its driver, they are queried once per
+ *        process for each model of GPU and driver version, even when several instances enumerate it
+ */
+struct PhysicalDeviceCapabilities
+{
+	VkPhysicalDeviceFeatures features{};
+
+	VkPhysicalDeviceMemoryProperties memory_properties{};
+
+	std::vector<VkQueueFamilyProperties> queue_family_properties;
+
+	std::vector<VkExtensionProperties> extensions;
+
+	/// Names of the extensions, for constant time lookups
+	std::unordered_set<std::string> extension_names;
+};
+
 /**
  * @brief A wrapper class for VkPhysicalDevice
  *
@@ -57,6 +78,35 @@ class PhysicalDevice
 
 	const std::vector<VkQueueFamilyProperties> &get_queue_family_properties() const;
 
+	/**
+	 * @return The device extensions supported by the GPU
+	 */
+	const std::vector<VkExtensionProperties> &get_extensions() const;
+
+	/**
+	 * @return Whether the GPU supports a device extension
+	 */
+	bool is_extension_supported(const std::string &extension) const;
+
+	/**
+	 * @brief Rates how suitable the GPU is to run samples, preferring discrete GPUs, then the GPUs with
+	 *        dedicated compute or transfer queues and more device local memory
+	 * @param surface The surface a queue must present to, or VK_NULL_HANDLE for headless rendering
+	 * @return The score of the GPU, 0 if it has no graphics queue or can't present to the surface
+	 */
+	uint64_t get_score(VkSurfaceKHR surface) const;
+
+	/**
+	 * @return The subgroup properties of the GPU, which report no supported stages or operations
+	 *         unless both the instance and the GPU use Vulkan 1.1 or later
+	 */
+	const VkPhysicalDeviceSubgroupProperties &get_subgroup_properties() const;
+
+	/**
+	 * @return The range of subgroup sizes pipelines can require, which is empty unless the GPU supports VK_EXT_subgroup_size_control
+	 */
+	const VkPhysicalDeviceSubgroupSizeControlPropertiesEXT &get_subgroup_size_control_properties() const;
+
 	uint32_t get_queue_family_performance_query_passes(
 	    const VkQueryPoolPerformanceCreateInfoKHR *perf_query_create_info) const;
 
@@ -128,6 +178,19 @@ class PhysicalDevice
 		return *extension_ptr;
 	}
 
+	/**
+	 * @brief Reads the features of an extension which were requested to be enabled in the logical device
+	 * @param type The VkStructureType of the extension feature struct
+	 * @returns The extension feature struct, or nullptr if it was never requested
+	 */
+	template <typename T>
+	const T *get_requested_extension_features(VkStructureType type) const
+	{
+		auto extension_features_it = extension_features.find(type);
+
+		return extension_features_it != extension_features.end() ? static_cast<const T *>(extension_features_it->second.get()) : nullptr;
+	}
+
   private:
 	// Handle to the Vulkan instance
 	Instance &instance;
@@ -135,17 +198,17 @@ class PhysicalDevice
 	// Handle to the Vulkan physical device
 	VkPhysicalDevice handle{VK_NULL_HANDLE};
 
-	// The features that this GPU supports
-	VkPhysicalDeviceFeatures features{};
-
 	// The GPU properties
 	VkPhysicalDeviceProperties properties;
 
-	// The GPU memory properties
-	VkPhysicalDeviceMemoryProperties memory_properties;
+	// The features, memory, queue families and extensions of the GPU, shared by the GPUs of the same model and driver
+	std::shared_ptr<const PhysicalDeviceCapabilities> capabilities;
 
-	// The GPU queue family properties
-	std::vector<VkQueueFamilyProperties> queue_family_properties;
+	// The GPU subgroup properties
+	VkPhysicalDeviceSubgroupProperties subgroup_properties{VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_SUBGROUP_PROPERTIES};
+
+	// The subgroup sizes pipelines can require
+	VkPhysicalDeviceSubgroupSizeControlPropertiesEXT subgroup_size_control_properties{VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_SUBGROUP_SIZE_CONTROL_PROPERTIES_EXT};
 
 	// The features that will be requested to be enabled in the logical device
 	VkPhysicalDeviceFeatures requested_features{};
@@ -20,6 +20,7 @@
 #include "device.h"
 #include "pipeline_layout.h"
 #include "shader_module.h"
+#include "timer.h"
 
 namespace vkb
 {
@@ -30,7 +31,8 @@ Pipeline::Pipeline(Device &device) :
 Pipeline::Pipeline(Pipeline &&other) :
     device{other.device},
     handle{other.handle},
-    state{other.state}
+    state{other.state},
+    creation_feedback{other.creation_feedback}
 {
 	other.handle = VK_NULL_HANDLE;
 }
@@ -54,6 +56,20 @@ const PipelineState &Pipeline::get_state() const
 	return state;
 }
 
+const PipelineCreationFeedback &Pipeline::get_creation_feedback() const
+{
+	return creation_feedback;
+}
+
+void Pipeline::set_creation_feedback(const VkPipelineCreationFeedbackEXT &feedback, double duration)
+{
+	creation_feedback.valid     = (feedback.flags & VK_PIPELINE_CREATION_FEEDBACK_VALID_BIT_EXT) != 0;
+	creation_feedback.cache_hit = (feedback.flags & VK_PIPELINE_CREATION_FEEDBACK_APPLICATION_PIPELINE_CACHE_HIT_BIT_EXT) != 0;
+
+	// The driver measures the whole creation, including the time spent outside of the call on other threads
+	creation_feedback.duration = creation_feedback.valid ? feedback.duration / 1000000.0 : duration;
+}
+
 ComputePipeline::ComputePipeline(Device &        device,
                                  VkPipelineCache pipeline_cache,
                                  PipelineState & pipeline_state) :
@@ -104,11 +120,64 @@ ComputePipeline::ComputePipeline(Device &        device,
 
 	stage.pSpecializationInfo = &specialization_info;
 
+	// Pipelines with the default subgroup size are created without the extension
+	VkPipelineShaderStageRequiredSubgroupSizeCreateInfoEXT required_subgroup_size_info{VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_REQUIRED_SUBGROUP_SIZE_CREATE_INFO_EXT};
+
+	if (pipeline_state.has_subgroup_size_control())
+	{
+		auto &subgroup_size_state = pipeline_state.get_subgroup_size_state();
+
+		if (subgroup_size_state.required_size > 0)
+		{
+			required_subgroup_size_info.requiredSubgroupSize = subgroup_size_state.required_size;
+
+			stage.pNext = &required_subgroup_size_info;
+		}
+		else if (subgroup_size_state.allow_varying_size)
+		{
+			stage.flags |= VK_PIPELINE_SHADER_STAGE_CREATE_ALLOW_VARYING_SUBGROUP_SIZE_BIT_EXT;
+		}
+
+		if (subgroup_size_state.require_full_subgroups)
+		{
+			stage.flags |= VK_PIPELINE_SHADER_STAGE_CREATE_REQUIRE_FULL_SUBGROUPS_BIT_EXT;
+		}
+	}
+
 	VkComputePipelineCreateInfo create_info{VK_STRUCTURE_TYPE_COMPUTE_PIPELINE_CREATE_INFO};
 
 	create_info.layout = pipeline_state.get_pipeline_layout().get_handle();
 	create_info.stage  = stage;
 
+	// Pipelines with the default shading rate are created without the extension
+	VkPipelineFragmentShadingRateStateCreateInfoKHR fragment_shading_rate_info{VK_STRUCTURE_TYPE_PIPELINE_FRAGMENT_SHADING_RATE_STATE_CREATE_INFO_KHR};
+
+	if (pipeline_state.has_fragment_shading_rate())
+	{
+		auto &fragment_shading_rate_state = pipeline_state.get_fragment_shading_rate_state();
+
+		fragment_shading_rate_info.fragmentSize   = fragment_shading_rate_state.fragment_size;
+		fragment_shading_rate_info.combinerOps[0] = fragment_shading_rate_state.combiner_ops[0];
+		fragment_shading_rate_info.combinerOps[1] = fragment_shading_rate_state.combiner_ops[1];
+
+		fragment_shading_rate_info.pNext = create_info.pNext;
+		create_info.pNext                = &fragment_shading_rate_info;
+	}
+
+	VkPipelineCreationFeedbackEXT           feedback{};
+	VkPipelineCreationFeedbackCreateInfoEXT feedback_info{VK_STRUCTURE_TYPE_PIPELINE_CREATION_FEEDBACK_CREATE_INFO_EXT};
+
+	if (device.is_enabled(VK_EXT_PIPELINE_CREATION_FEEDBACK_EXTENSION_NAME))
+	{
+		feedback_info.pPipelineCreationFeedback = &feedback;
+
+		feedback_info.pNext = create_info.pNext;
+		create_info.pNext   = &feedback_info;
+	}
+
+	Timer timer;
+	timer.start();
+
 	result = vkCreateComputePipelines(device.get_handle(), pipeline_cache, 1, &create_info, nullptr, &handle);
 
 	if (result != VK_SUCCESS)
@@ -116,6 +185,8 @@ ComputePipeline::ComputePipeline(Device &        device,
 		throw VulkanException{result, "Cannot create ComputePipelines"};
 	}
 
+	set_creation_feedback(feedback, timer.stop<Timer::Milliseconds>());
+
 	vkDestroyShaderModule(device.get_handle(), stage.module, nullptr);
 }
 
@@ -207,6 +278,15 @@ GraphicsPipeline::GraphicsPipeline(Device &        device,
 	rasterization_state.depthBiasSlopeFactor    = 1.0f;
 	rasterization_state.lineWidth               = 1.0f;
 
+	VkPipelineRasterizationConservativeStateCreateInfoEXT conservative_state{VK_STRUCTURE_TYPE_PIPELINE_RASTERIZATION_CONSERVATIVE_STATE_CREATE_INFO_EXT};
+
+	if (pipeline_state.get_rasterization_state().conservative_rasterization_mode != VK_CONSERVATIVE_RASTERIZATION_MODE_DISABLED_EXT)
+	{
+		conservative_state.conservativeRasterizationMode = pipeline_state.get_rasterization_state().conservative_rasterization_mode;
+
+		rasterization_state.pNext = &conservative_state;
+	}
+
 	VkPipelineMultisampleStateCreateInfo multisample_state{VK_STRUCTURE_TYPE_PIPELINE_MULTISAMPLE_STATE_CREATE_INFO};
 
 	multisample_state.sampleShadingEnable   = pipeline_state.get_multisample_state().sample_shading_enable;
@@ -253,7 +333,7 @@ GraphicsPipeline::GraphicsPipeline(Device &        device,
 	color_blend_state.blendConstants[2] = 1.0f;
 	color_blend_state.blendConstants[3] = 1.0f;
 
-	std::array<VkDynamicState, 9> dynamic_states{
+	std::vector<VkDynamicState> dynamic_states{
 	    VK_DYNAMIC_STATE_VIEWPORT,
 	    VK_DYNAMIC_STATE_SCISSOR,
 	    VK_DYNAMIC_STATE_LINE_WIDTH,
@@ -265,6 +345,23 @@ GraphicsPipeline::GraphicsPipeline(Device &        device,
 	    VK_DYNAMIC_STATE_STENCIL_REFERENCE,
 	};
 
+	if (pipeline_state.has_extended_dynamic_state())
+	{
+		// Set by the command buffer before drawing
+		std::array<VkDynamicState, 8> extended_dynamic_states{
+		    VK_DYNAMIC_STATE_CULL_MODE_EXT,
+		    VK_DYNAMIC_STATE_FRONT_FACE_EXT,
+		    VK_DYNAMIC_STATE_DEPTH_TEST_ENABLE_EXT,
+		    VK_DYNAMIC_STATE_DEPTH_WRITE_ENABLE_EXT,
+		    VK_DYNAMIC_STATE_DEPTH_COMPARE_OP_EXT,
+		    VK_DYNAMIC_STATE_DEPTH_BOUNDS_TEST_ENABLE_EXT,
+		    VK_DYNAMIC_STATE_STENCIL_TEST_ENABLE_EXT,
+		    VK_DYNAMIC_STATE_STENCIL_OP_EXT,
+		};
+
+		dynamic_states.insert(dynamic_states.end(), extended_dynamic_states.begin(), extended_dynamic_states.end());
+	}
+
 	VkPipelineDynamicStateCreateInfo dynamic_state{VK_STRUCTURE_TYPE_PIPELINE_DYNAMIC_STATE_CREATE_INFO};
 
 	dynamic_state.pDynamicStates    = dynamic_states.data();
@@ -279,9 +376,43 @@ GraphicsPipeline::GraphicsPipeline(Device &        device,
 	create_info.pColorBlendState    = &color_blend_state;
 	create_info.pDynamicState       = &dynamic_state;
 
-	create_info.layout     = pipeline_state.get_pipeline_layout().get_handle();
-	create_info.renderPass = pipeline_state.get_render_pass()->get_handle();
-	create_info.subpass    = pipeline_state.get_subpass_index();
+	create_info.layout = pipeline_state.get_pipeline_layout().get_handle();
+
+	// Without a render pass the pipeline is created for the attachment formats of dynamic rendering
+	VkPipelineRenderingCreateInfoKHR rendering_info{VK_STRUCTURE_TYPE_PIPELINE_RENDERING_CREATE_INFO_KHR};
+
+	if (pipeline_state.get_render_pass())
+	{
+		create_info.renderPass = pipeline_state.get_render_pass()->get_handle();
+		create_info.subpass    = pipeline_state.get_subpass_index();
+	}
+	else
+	{
+		auto &rendering_state = pipeline_state.get_rendering_state();
+
+		rendering_info.colorAttachmentCount    = to_u32(rendering_state.color_attachment_formats.size());
+		rendering_info.pColorAttachmentFormats = rendering_state.color_attachment_formats.data();
+		rendering_info.depthAttachmentFormat   = rendering_state.depth_attachment_format;
+		rendering_info.stencilAttachmentFormat = rendering_state.stencil_attachment_format;
+		rendering_info.viewMask                = rendering_state.view_mask;
+
+		rendering_info.pNext = create_info.pNext;
+		create_info.pNext    = &rendering_info;
+	}
+
+	VkPipelineCreationFeedbackEXT           feedback{};
+	VkPipelineCreationFeedbackCreateInfoEXT feedback_info{VK_STRUCTURE_TYPE_PIPELINE_CREATION_FEEDBACK_CREATE_INFO_EXT};
+
+	if (device.is_enabled(VK_EXT_PIPELINE_CREATION_FEEDBACK_EXTENSION_NAME))
+	{
+		feedback_info.pPipelineCreationFeedback = &feedback;
+
+		feedback_info.pNext = create_info.pNext;
+		create_info.pNext   = &feedback_info;
+	}
+
+	Timer timer;
+	timer.start();
 
 	auto result = vkCreateGraphicsPipelines(device.get_handle(), pipeline_cache, 1, &create_info, nullptr, &handle);
 
@@ -290,6 +421,8 @@ GraphicsPipeline::GraphicsPipeline(Device &        device,
 		throw VulkanException{result, "Cannot create GraphicsPipelines"};
 	}
 
+	set_creation_feedback(feedback, timer.stop<Timer::Milliseconds>());
+
 	for (auto shader_module : shader_modules)
 	{
 		vkDestroyShaderModule(device.get_handle(), shader_module, nullptr);
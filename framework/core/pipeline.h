@@ -25,6 +25,21 @@ namespace vkb
 {
 class Device;
 
+/**
+ * @brief How the creation of a pipeline went, as reported by VK_EXT_pipeline_creation_feedback
+ */
+struct PipelineCreationFeedback
+{
+	/// Whether the driver reported feedback, otherwise only the duration is known
+	bool valid{false};
+
+	/// Whether the driver found the pipeline in the pipeline cache, without compiling it
+	bool cache_hit{false};
+
+	/// Time spent creating the pipeline, in milliseconds
+	double duration{0.0};
+};
+
 class Pipeline
 {
   public:
@@ -44,12 +59,23 @@ class Pipeline
 
 	const PipelineState &get_state() const;
 
+	const PipelineCreationFeedback &get_creation_feedback() const;
+
   protected:
+	/**
+	 * @brief Fills the creation feedback once the pipeline is created
+	 * @param feedback The feedback written by the driver, ignored unless the extension is enabled
+	 * @param duration CPU time spent creating the pipeline, in milliseconds
+	 */
+	void set_creation_feedback(const VkPipelineCreationFeedbackEXT &feedback, double duration);
+
 	Device &device;
 
 	VkPipeline handle = VK_NULL_HANDLE;
 
 	PipelineState state;
+
+	PipelineCreationFeedback creation_feedback;
 };
 
 class ComputePipeline : public Pipeline
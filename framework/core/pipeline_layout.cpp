@@ -84,6 +84,12 @@ PipelineLayout::PipelineLayout(Device &device, const std::vector<ShaderModule *>
 		descriptor_set_layouts.emplace_back(&device.get_resource_cache().request_descriptor_set_layout(shader_set_it.first, shader_set_it.second));
 	}
 
+	if (std::count_if(descriptor_set_layouts.begin(), descriptor_set_layouts.end(),
+	                  [](const DescriptorSetLayout *descriptor_set_layout) { return descriptor_set_layout && descriptor_set_layout->is_push_descriptor(); }) > 1)
+	{
+		throw std::runtime_error("Cannot create pipeline layout, only one descriptor set can use push descriptors.");
+	}
+
 	// Collect all the descriptor set layout handles, maintaining set order
 	std::vector<VkDescriptorSetLayout> descriptor_set_layout_handles;
 	for (uint32_t i = 0; i < descriptor_set_layouts.size(); ++i)
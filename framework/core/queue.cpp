@@ -17,6 +17,8 @@
 
 #include "queue.h"
 
+#include <chrono>
+
 #include "command_buffer.h"
 #include "device.h"
 
@@ -38,7 +40,8 @@ Queue::Queue(Queue &&other) :
     family_index{other.family_index},
     index{other.index},
     can_present{other.can_present},
-    properties{other.properties}
+    properties{other.properties},
+    synchronization{std::move(other.synchronization)}
 {
 	other.handle       = VK_NULL_HANDLE;
 	other.family_index = {};
@@ -79,7 +82,24 @@ VkBool32 Queue::support_present() const
 
 VkResult Queue::submit(const std::vector<VkSubmitInfo> &submit_infos, VkFence fence) const
 {
-	return vkQueueSubmit(handle, to_u32(submit_infos.size()), submit_infos.data(), fence);
+	// Host writes to non coherent memory must be flushed before the device reads them
+	device.flush_deferred();
+
+	auto start = std::chrono::steady_clock::now();
+
+	VkResult result;
+	{
+		std::lock_guard<std::mutex> lock{synchronization->mutex};
+
+		result = vkQueueSubmit(handle, to_u32(submit_infos.size()), submit_infos.data(), fence);
+	}
+
+	auto duration = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start);
+
+	synchronization->submit_count += 1;
+	synchronization->submit_time += static_cast<uint64_t>(duration.count());
+
+	return result;
 }
 
 VkResult Queue::submit(const CommandBuffer &command_buffer, VkFence fence) const
@@ -98,11 +118,25 @@ VkResult Queue::present(const VkPresentInfoKHR &present_info) const
 		return VK_ERROR_INCOMPATIBLE_DISPLAY_KHR;
 	}
 
+	std::lock_guard<std::mutex> lock{synchronization->mutex};
+
 	return vkQueuePresentKHR(handle, &present_info);
-}        // namespace vkb
+}
 
 VkResult Queue::wait_idle() const
 {
+	std::lock_guard<std::mutex> lock{synchronization->mutex};
+
 	return vkQueueWaitIdle(handle);
 }
+
+uint64_t Queue::get_submit_count() const
+{
+	return synchronization->submit_count;
+}
+
+double Queue::get_submit_time() const
+{
+	return synchronization->submit_time * 1e-9;
+}
 }        // namespace vkb
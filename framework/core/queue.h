@@ -17,6 +17,10 @@
 
 #pragma once
 
+#include <atomic>
+#include <memory>
+#include <mutex>
+
 #include "common/helpers.h"
 #include "common/vk_common.h"
 #include "core/swapchain.h"
@@ -26,6 +30,10 @@ namespace vkb
 class Device;
 class CommandBuffer;
 
+/**
+ * @brief A device queue, whose submissions, presents and waits are serialized by a lock shared with its copies,
+ *        so that it can be used from several threads
+ */
 class Queue
 {
   public:
@@ -59,7 +67,33 @@ class Queue
 
 	VkResult wait_idle() const;
 
+	/**
+	 * @return Number of submissions since the queue was created
+	 */
+	uint64_t get_submit_count() const;
+
+	/**
+	 * @return Total time in seconds spent in submissions since the queue was created, including waiting for other threads
+	 */
+	double get_submit_time() const;
+
   private:
+	/**
+	 * @brief State shared by the copies of a queue
+	 */
+	struct Synchronization
+	{
+		/// Vulkan requires external synchronization of the queue for submits, presents and waits
+		std::mutex mutex;
+
+		std::atomic<uint64_t> submit_count{0};
+
+		/// Total duration of the submissions in nanoseconds
+		std::atomic<uint64_t> submit_time{0};
+	};
+
+	std::shared_ptr<Synchronization> synchronization{std::make_shared<Synchronization>()};
+
 	Device &device;
 
 	VkQueue handle{VK_NULL_HANDLE};
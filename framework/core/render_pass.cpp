@@ -88,9 +88,23 @@ inline const VkAttachmentReference2KHR *get_depth_resolve_reference(const VkSubp
 	return nullptr;
 }
 
+inline const VkBaseInStructure *find_structure(const void *next, VkStructureType type)
+{
+	auto structure = static_cast<const VkBaseInStructure *>(next);
+
+	while (structure && structure->sType != type)
+	{
+		structure = structure->pNext;
+	}
+
+	return structure;
+}
+
 inline const VkAttachmentReference2KHR *get_depth_resolve_reference(const VkSubpassDescription2KHR &subpass_description)
 {
-	auto description_depth_resolve = static_cast<const VkSubpassDescriptionDepthStencilResolveKHR *>(subpass_description.pNext);
+	// The depth resolve may share the pNext chain with a shading rate attachment
+	auto description_depth_resolve = reinterpret_cast<const VkSubpassDescriptionDepthStencilResolveKHR *>(
+	    find_structure(subpass_description.pNext, VK_STRUCTURE_TYPE_SUBPASS_DESCRIPTION_DEPTH_STENCIL_RESOLVE_KHR));
 
 	const VkAttachmentReference2KHR *depth_resolve_attachment = nullptr;
 	if (description_depth_resolve)
@@ -101,6 +115,59 @@ inline const VkAttachmentReference2KHR *get_depth_resolve_reference(const VkSubp
 	return depth_resolve_attachment;
 }
 
+inline void set_shading_rate_attachment(VkSubpassDescription &subpass_description, VkFragmentShadingRateAttachmentInfoKHR &shading_rate, VkAttachmentReference &shading_rate_attachment)
+{
+	throw VulkanException{VK_ERROR_FEATURE_NOT_PRESENT, "Shading rate attachments need VK_KHR_create_renderpass2"};
+}
+
+inline void set_shading_rate_attachment(VkSubpassDescription2KHR &subpass_description, VkFragmentShadingRateAttachmentInfoKHR &shading_rate, VkAttachmentReference2KHR &shading_rate_attachment)
+{
+	shading_rate.pFragmentShadingRateAttachment = &shading_rate_attachment;
+	shading_rate.pNext                          = subpass_description.pNext;
+	subpass_description.pNext                   = &shading_rate;
+}
+
+inline const VkAttachmentReference2KHR *get_shading_rate_reference(const VkSubpassDescription &subpass_description)
+{
+	// VkSubpassDescription cannot have a shading rate attachment
+	return nullptr;
+}
+
+inline const VkAttachmentReference2KHR *get_shading_rate_reference(const VkSubpassDescription2KHR &subpass_description)
+{
+	auto shading_rate = reinterpret_cast<const VkFragmentShadingRateAttachmentInfoKHR *>(
+	    find_structure(subpass_description.pNext, VK_STRUCTURE_TYPE_FRAGMENT_SHADING_RATE_ATTACHMENT_INFO_KHR));
+
+	return shading_rate ? shading_rate->pFragmentShadingRateAttachment : nullptr;
+}
+
+inline void set_view_mask(VkSubpassDescription &subpass_description, uint32_t view_mask)
+{
+	// The view masks of VkSubpassDescription are chained to the create info by set_multiview
+}
+
+inline void set_view_mask(VkSubpassDescription2KHR &subpass_description, uint32_t view_mask)
+{
+	subpass_description.viewMask = view_mask;
+}
+
+inline void set_multiview(VkRenderPassCreateInfo &create_info, VkRenderPassMultiviewCreateInfoKHR &multiview, const std::vector<uint32_t> &view_masks, const uint32_t &correlation_mask)
+{
+	multiview.subpassCount         = to_u32(view_masks.size());
+	multiview.pViewMasks           = view_masks.data();
+	multiview.correlationMaskCount = 1;
+	multiview.pCorrelationMasks    = &correlation_mask;
+	multiview.pNext                = create_info.pNext;
+	create_info.pNext              = &multiview;
+}
+
+inline void set_multiview(VkRenderPassCreateInfo2KHR &create_info, VkRenderPassMultiviewCreateInfoKHR &multiview, const std::vector<uint32_t> &view_masks, const uint32_t &correlation_mask)
+{
+	// The view masks are in the subpass descriptions
+	create_info.correlatedViewMaskCount = 1;
+	create_info.pCorrelatedViewMasks    = &correlation_mask;
+}
+
 inline VkResult create_vk_renderpass(VkDevice device, VkRenderPassCreateInfo &create_info, VkRenderPass *handle)
 {
 	return vkCreateRenderPass(device, &create_info, nullptr, handle);
@@ -127,6 +194,12 @@ std::vector<T> get_attachment_descriptions(const std::vector<Attachment> &attach
 		attachment.initialLayout = attachments[i].initial_layout;
 		attachment.finalLayout   = is_depth_stencil_format(attachment.format) ? VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL : VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
 
+		// Shading rate images cannot be color attachments
+		if (attachments[i].usage & VK_IMAGE_USAGE_FRAGMENT_SHADING_RATE_ATTACHMENT_BIT_KHR)
+		{
+			attachment.finalLayout = VK_IMAGE_LAYOUT_FRAGMENT_SHADING_RATE_ATTACHMENT_OPTIMAL_KHR;
+		}
+
 		if (i < load_store_infos.size())
 		{
 			attachment.loadOp         = load_store_infos[i].load_op;
@@ -198,6 +271,15 @@ void set_attachment_layouts(std::vector<T_SubpassDescription> &subpass_descripti
 				attachment_descriptions[depth_resolve->attachment].initialLayout = depth_resolve->layout;
 			}
 		}
+
+		if (const auto shading_rate = get_shading_rate_reference(subpass))
+		{
+			// Set it only if not defined yet
+			if (attachment_descriptions[shading_rate->attachment].initialLayout == VK_IMAGE_LAYOUT_UNDEFINED)
+			{
+				attachment_descriptions[shading_rate->attachment].initialLayout = shading_rate->layout;
+			}
+		}
 	}
 
 	// Make the final layout same as the last subpass layout
@@ -294,6 +376,7 @@ void RenderPass::create_renderpass(const std::vector<Attachment> &attachments, c
 	std::vector<std::vector<T_AttachmentReference>> depth_stencil_attachments{subpass_count};
 	std::vector<std::vector<T_AttachmentReference>> color_resolve_attachments{subpass_count};
 	std::vector<std::vector<T_AttachmentReference>> depth_resolve_attachments{subpass_count};
+	std::vector<std::vector<T_AttachmentReference>> shading_rate_attachments{subpass_count};
 
 	for (size_t i = 0; i < subpasses.size(); ++i)
 	{
@@ -342,11 +425,20 @@ void RenderPass::create_renderpass(const std::vector<Attachment> &attachments, c
 				}
 			}
 		}
+
+		if (subpass.shading_rate_attachment != VK_ATTACHMENT_UNUSED)
+		{
+			shading_rate_attachments[i].push_back(get_attachment_reference<T_AttachmentReference>(subpass.shading_rate_attachment, VK_IMAGE_LAYOUT_FRAGMENT_SHADING_RATE_ATTACHMENT_OPTIMAL_KHR));
+		}
 	}
 
 	std::vector<T_SubpassDescription> subpass_descriptions;
 	subpass_descriptions.reserve(subpass_count);
 	VkSubpassDescriptionDepthStencilResolveKHR depth_resolve{};
+
+	// Chained to the subpass descriptions, so they are not reallocated
+	std::vector<VkFragmentShadingRateAttachmentInfoKHR> shading_rates(subpass_count, {VK_STRUCTURE_TYPE_FRAGMENT_SHADING_RATE_ATTACHMENT_INFO_KHR});
+
 	for (size_t i = 0; i < subpasses.size(); ++i)
 	{
 		auto &subpass = subpasses[i];
@@ -385,6 +477,14 @@ void RenderPass::create_renderpass(const std::vector<Attachment> &attachments, c
 			}
 		}
 
+		if (!shading_rate_attachments[i].empty())
+		{
+			shading_rates[i].shadingRateAttachmentTexelSize = subpass.shading_rate_texel_size;
+			set_shading_rate_attachment(subpass_description, shading_rates[i], shading_rate_attachments[i][0]);
+		}
+
+		set_view_mask(subpass_description, subpass.view_mask);
+
 		subpass_descriptions.push_back(subpass_description);
 	}
 
@@ -430,6 +530,12 @@ void RenderPass::create_renderpass(const std::vector<Attachment> &attachments, c
 		color_output_count.push_back(to_u32(color_attachments[i].size()));
 	}
 
+	final_layouts.reserve(attachment_descriptions.size());
+	for (auto &description : attachment_descriptions)
+	{
+		final_layouts.push_back(description.finalLayout);
+	}
+
 	const auto &subpass_dependencies = get_subpass_dependencies<T_SubpassDependency>(subpass_count);
 
 	T_RenderPassCreateInfo create_info{};
@@ -441,6 +547,23 @@ void RenderPass::create_renderpass(const std::vector<Attachment> &attachments, c
 	create_info.dependencyCount = to_u32(subpass_dependencies.size());
 	create_info.pDependencies   = subpass_dependencies.data();
 
+	std::vector<uint32_t> view_masks;
+	uint32_t              correlation_mask{0};
+
+	for (auto &subpass : subpasses)
+	{
+		view_masks.push_back(subpass.view_mask);
+		correlation_mask |= subpass.view_mask;
+	}
+
+	VkRenderPassMultiviewCreateInfoKHR multiview{VK_STRUCTURE_TYPE_RENDER_PASS_MULTIVIEW_CREATE_INFO_KHR};
+
+	if (correlation_mask != 0)
+	{
+		// The views are rendered from nearby cameras, which lets implementations render them concurrently
+		set_multiview(create_info, multiview, view_masks, correlation_mask);
+	}
+
 	auto result = create_vk_renderpass(device.get_handle(), create_info, &handle);
 
 	if (result != VK_SUCCESS)
@@ -449,10 +572,59 @@ void RenderPass::create_renderpass(const std::vector<Attachment> &attachments, c
 	}
 }
 
+namespace
+{
+size_t hash_compatibility(const std::vector<Attachment> &attachments, const std::vector<SubpassInfo> &subpasses)
+{
+	size_t result{0};
+
+	for (auto &attachment : attachments)
+	{
+		hash_combine(result, static_cast<std::underlying_type<VkFormat>::type>(attachment.format));
+		hash_combine(result, static_cast<std::underlying_type<VkSampleCountFlagBits>::type>(attachment.samples));
+	}
+
+	// Dependencies only depend on the number of subpasses
+	hash_combine(result, subpasses.size());
+
+	for (auto &subpass : subpasses)
+	{
+		hash_combine(result, subpass.input_attachments.size());
+		for (auto index : subpass.input_attachments)
+		{
+			hash_combine(result, index);
+		}
+
+		hash_combine(result, subpass.output_attachments.size());
+		for (auto index : subpass.output_attachments)
+		{
+			hash_combine(result, index);
+		}
+
+		hash_combine(result, subpass.color_resolve_attachments.size());
+		for (auto index : subpass.color_resolve_attachments)
+		{
+			hash_combine(result, index);
+		}
+
+		hash_combine(result, subpass.disable_depth_stencil_attachment);
+		hash_combine(result, subpass.depth_stencil_resolve_attachment);
+		hash_combine(result, static_cast<std::underlying_type<VkResolveModeFlagBits>::type>(subpass.depth_stencil_resolve_mode));
+		hash_combine(result, subpass.shading_rate_attachment);
+		hash_combine(result, subpass.shading_rate_texel_size.width);
+		hash_combine(result, subpass.shading_rate_texel_size.height);
+		hash_combine(result, subpass.view_mask);
+	}
+
+	return result;
+}
+}        // namespace
+
 RenderPass::RenderPass(Device &device, const std::vector<Attachment> &attachments, const std::vector<LoadStoreInfo> &load_store_infos, const std::vector<SubpassInfo> &subpasses) :
     device{device},
     subpass_count{std::max<size_t>(1, subpasses.size())},        // At least 1 subpass
-    color_output_count{}
+    color_output_count{},
+    compatibility_hash{hash_compatibility(attachments, subpasses)}
 {
 	if (device.is_enabled(VK_KHR_CREATE_RENDERPASS_2_EXTENSION_NAME))
 	{
@@ -468,7 +640,9 @@ RenderPass::RenderPass(RenderPass &&other) :
     device{other.device},
     handle{other.handle},
     subpass_count{other.subpass_count},
-    color_output_count{other.color_output_count}
+    color_output_count{other.color_output_count},
+    final_layouts{other.final_layouts},
+    compatibility_hash{other.compatibility_hash}
 {
 	other.handle = VK_NULL_HANDLE;
 }
@@ -487,6 +661,11 @@ const uint32_t RenderPass::get_color_output_count(uint32_t subpass_index) const
 	return color_output_count[subpass_index];
 }
 
+size_t RenderPass::get_compatibility_hash() const
+{
+	return compatibility_hash;
+}
+
 const VkExtent2D RenderPass::get_render_area_granularity() const
 {
 	VkExtent2D render_area_granularity = {};
@@ -494,4 +673,9 @@ const VkExtent2D RenderPass::get_render_area_granularity() const
 
 	return render_area_granularity;
 }
+
+const std::vector<VkImageLayout> &RenderPass::get_final_layouts() const
+{
+	return final_layouts;
+}
 }        // namespace vkb
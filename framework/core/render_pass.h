@@ -38,6 +38,16 @@ struct SubpassInfo
 	uint32_t depth_stencil_resolve_attachment;
 
 	VkResolveModeFlagBits depth_stencil_resolve_mode;
+
+	/// Attachment giving the fragment shading rate of the subpass, VK_ATTACHMENT_UNUSED if none, it needs VK_KHR_create_renderpass2
+	uint32_t shading_rate_attachment{VK_ATTACHMENT_UNUSED};
+
+	/// Pixels covered by a texel of the shading rate attachment
+	VkExtent2D shading_rate_texel_size{};
+
+	/// Views rendered by the subpass with VK_KHR_multiview, bit i rendering to layer i of the attachments, 0 without multiview
+	/// Either all the subpasses of a render pass have a view mask, or none of them.
+	uint32_t view_mask{0};
 };
 
 class RenderPass
@@ -64,6 +74,18 @@ class RenderPass
 
 	const VkExtent2D get_render_area_granularity() const;
 
+	/**
+	 * @return Layouts the attachments are in when the render pass ends
+	 */
+	const std::vector<VkImageLayout> &get_final_layouts() const;
+
+	/**
+	 * @brief Render passes differing only in load and store operations or layouts are compatible,
+	 *        so framebuffers and pipelines created for one can be used with the others
+	 * @return Hash of the attachment formats and sample counts and of the subpass structure
+	 */
+	size_t get_compatibility_hash() const;
+
   private:
 	Device &device;
 
@@ -75,5 +97,9 @@ class RenderPass
 	void create_renderpass(const std::vector<Attachment> &attachments, const std::vector<LoadStoreInfo> &load_store_infos, const std::vector<SubpassInfo> &subpasses);
 
 	std::vector<uint32_t> color_output_count;
+
+	std::vector<VkImageLayout> final_layouts;
+
+	size_t compatibility_hash{0};
 };
 }        // namespace vkb
@@ -17,10 +17,13 @@
 
 #include "shader_module.h"
 
+#include <cassert>
+
 #include "common/logging.h"
 #include "device.h"
 #include "glsl_compiler.h"
 #include "platform/filesystem.h"
+#include "shader_binary_cache.h"
 #include "spirv_reflection.h"
 
 namespace vkb
@@ -28,7 +31,9 @@ namespace vkb
 ShaderModule::ShaderModule(Device &device, VkShaderStageFlagBits stage, const ShaderSource &glsl_source, const std::string &entry_point, const ShaderVariant &shader_variant) :
     device{device},
     stage{stage},
-    entry_point{entry_point}
+    entry_point{entry_point},
+    filename{glsl_source.get_filename()},
+    variant{shader_variant}
 {
 	// Check if application is passing in GLSL source code to compile to SPIR-V
 	if (glsl_source.get_data().empty())
@@ -42,22 +47,30 @@ ShaderModule::ShaderModule(Device &device, VkShaderStageFlagBits stage, const Sh
 		throw VulkanException{VK_ERROR_INITIALIZATION_FAILED};
 	}
 
-	GLSLCompiler glsl_compiler;
+	size_t cache_key = ShaderBinaryCache::get_key(stage, glsl_source, entry_point, shader_variant);
 
-	// Compile the GLSL source
-	if (!glsl_compiler.compile_to_spirv(stage, glsl_source.get_data(), entry_point, shader_variant, spirv, info_log))
+	// Skip compilation and reflection if a previous run already processed this shader
+	if (!ShaderBinaryCache::load(cache_key, spirv, resources))
 	{
-		LOGE("Shader compilation failed for shader \"{}\"", glsl_source.get_filename());
-		LOGE("{}", info_log);
-		throw VulkanException{VK_ERROR_INITIALIZATION_FAILED};
-	}
+		GLSLCompiler glsl_compiler;
+
+		// Compile the GLSL source
+		if (!glsl_compiler.compile_to_spirv(stage, glsl_source.get_data(), entry_point, shader_variant, spirv, info_log))
+		{
+			LOGE("Shader compilation failed for shader \"{}\"", glsl_source.get_filename());
+			LOGE("{}", info_log);
+			throw VulkanException{VK_ERROR_INITIALIZATION_FAILED};
+		}
 
-	SPIRVReflection spirv_reflection;
+		SPIRVReflection spirv_reflection;
 
-	// Reflect all shader resouces
-	if (!spirv_reflection.reflect_shader_resources(stage, spirv, resources, shader_variant))
-	{
-		throw VulkanException{VK_ERROR_INITIALIZATION_FAILED};
+		// Reflect all shader resouces
+		if (!spirv_reflection.reflect_shader_resources(stage, spirv, resources, shader_variant))
+		{
+			throw VulkanException{VK_ERROR_INITIALIZATION_FAILED};
+		}
+
+		ShaderBinaryCache::store(cache_key, spirv, resources);
 	}
 
 	// Generate a unique id, determined by source and variant
@@ -71,6 +84,8 @@ ShaderModule::ShaderModule(ShaderModule &&other) :
     stage{other.stage},
     entry_point{other.entry_point},
     spirv{other.spirv},
+    filename{other.filename},
+    variant{other.variant},
     resources{other.resources},
     info_log{other.info_log}
 {
@@ -107,6 +122,37 @@ const std::vector<uint32_t> &ShaderModule::get_binary() const
 	return spirv;
 }
 
+const std::string &ShaderModule::get_filename() const
+{
+	return filename;
+}
+
+const ShaderVariant &ShaderModule::get_variant() const
+{
+	return variant;
+}
+
+void ShaderModule::replace(ShaderModule &&other)
+{
+	assert(other.stage == stage && other.entry_point == entry_point && "A shader module can only be replaced by a version of itself");
+
+	// Resource modes are set by the users of the module, which keep using it
+	for (auto &resource : other.resources)
+	{
+		auto it = std::find_if(resources.begin(), resources.end(), [&resource](const ShaderResource &old_resource) { return old_resource.name == resource.name; });
+
+		if (it != resources.end() && it->type == resource.type)
+		{
+			resource.mode = it->mode;
+		}
+	}
+
+	id        = other.id;
+	spirv     = std::move(other.spirv);
+	resources = std::move(other.resources);
+	info_log  = std::move(other.info_log);
+}
+
 void ShaderModule::set_resource_mode(const std::string &resource_name, const ShaderResourceMode &resource_mode)
 {
 	auto it = std::find_if(resources.begin(), resources.end(), [&resource_name](const ShaderResource &resource) { return resource.name == resource_name; });
@@ -155,6 +201,34 @@ void ShaderVariant::add_definitions(const std::vector<std::string> &definitions)
 	}
 }
 
+void ShaderVariant::add_subgroup_definitions(const VkPhysicalDeviceSubgroupProperties &properties, VkShaderStageFlagBits stage, uint32_t subgroup_size)
+{
+	if (!(properties.supportedStages & stage))
+	{
+		return;
+	}
+
+	add_define("SUBGROUP_SIZE " + std::to_string(subgroup_size > 0 ? subgroup_size : properties.subgroupSize));
+
+	const std::pair<VkSubgroupFeatureFlagBits, const char *> operation_definitions[] = {
+	    {VK_SUBGROUP_FEATURE_BASIC_BIT, "SUBGROUP_BASIC"},
+	    {VK_SUBGROUP_FEATURE_VOTE_BIT, "SUBGROUP_VOTE"},
+	    {VK_SUBGROUP_FEATURE_ARITHMETIC_BIT, "SUBGROUP_ARITHMETIC"},
+	    {VK_SUBGROUP_FEATURE_BALLOT_BIT, "SUBGROUP_BALLOT"},
+	    {VK_SUBGROUP_FEATURE_SHUFFLE_BIT, "SUBGROUP_SHUFFLE"},
+	    {VK_SUBGROUP_FEATURE_SHUFFLE_RELATIVE_BIT, "SUBGROUP_SHUFFLE_RELATIVE"},
+	    {VK_SUBGROUP_FEATURE_CLUSTERED_BIT, "SUBGROUP_CLUSTERED"},
+	    {VK_SUBGROUP_FEATURE_QUAD_BIT, "SUBGROUP_QUAD"}};
+
+	for (auto &operation_definition : operation_definitions)
+	{
+		if (properties.supportedOperations & operation_definition.first)
+		{
+			add_define(operation_definition.second);
+		}
+	}
+}
+
 void ShaderVariant::add_define(const std::string &def)
 {
 	processes.push_back("D" + def);
@@ -36,6 +36,7 @@ enum class ShaderResourceType
 	Sampler,
 	BufferUniform,
 	BufferStorage,
+	AccelerationStructure,
 	PushConstant,
 	SpecializationConstant,
 	All
@@ -46,7 +47,9 @@ enum class ShaderResourceMode
 {
 	Static,
 	Dynamic,
-	UpdateAfterBind
+	UpdateAfterBind,
+	/// The whole set of the resource is written into the command buffer with VK_KHR_push_descriptor, if it is enabled
+	Push
 };
 
 /// Store shader resource data.
@@ -113,6 +116,17 @@ class ShaderVariant
 	 */
 	void add_undefine(const std::string &undef);
 
+	/**
+	 * @brief Adds the standard subgroup definitions of a shader stage: SUBGROUP_SIZE, and SUBGROUP_BASIC, SUBGROUP_VOTE,
+	 *        SUBGROUP_ARITHMETIC, SUBGROUP_BALLOT, SUBGROUP_SHUFFLE, SUBGROUP_SHUFFLE_RELATIVE, SUBGROUP_CLUSTERED and
+	 *        SUBGROUP_QUAD for the operations supported in the stage. Nothing is defined if the stage has no subgroup support.
+	 *        Shaders using the operations require the GLSLCompiler to target SPIR-V 1.3 or later.
+	 * @param properties Subgroup properties of the GPU, see PhysicalDevice::get_subgroup_properties
+	 * @param stage Stage of the shader
+	 * @param subgroup_size Subgroup size the pipeline requires with VK_EXT_subgroup_size_control, 0 for the default size of the GPU
+	 */
+	void add_subgroup_definitions(const VkPhysicalDeviceSubgroupProperties &properties, VkShaderStageFlagBits stage, uint32_t subgroup_size = 0);
+
 	/**
 	 * @brief Specifies the size of a named runtime array for automatic reflection. If already specified, overrides the size.
 	 * @param runtime_array_name String under which the runtime array is named in the shader
@@ -204,6 +218,24 @@ class ShaderModule
 
 	const std::vector<uint32_t> &get_binary() const;
 
+	/**
+	 * @return The file the module was compiled from, empty if its source was given in memory
+	 */
+	const std::string &get_filename() const;
+
+	/**
+	 * @return The variant the module was compiled with
+	 */
+	const ShaderVariant &get_variant() const;
+
+	/**
+	 * @brief Replaces the code and reflection of the module by the ones of a recompiled version of it,
+	 *        keeping the modes set on its resources. Its id changes, so that the pipeline layouts and
+	 *        pipelines requested with it afterwards are new ones.
+	 * @param other The module compiled from the new source, with the same stage and entry point
+	 */
+	void replace(ShaderModule &&other);
+
 	/**
 	 * @brief Flags a resource to use a different method of being bound to the shader
 	 * @param resource_name The name of the shader resource
@@ -226,6 +258,11 @@ class ShaderModule
 	/// Compiled source
 	std::vector<uint32_t> spirv;
 
+	/// File of the source, to recompile the module when it changes
+	std::string filename;
+
+	ShaderVariant variant;
+
 	std::vector<ShaderResource> resources;
 
 	std::string info_log;
@@ -0,0 +1,592 @@
+/* Copyright (c) 2020, Arm Limited and Contributors
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 the "License";
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "staging_manager.h"
+
+#include "common/error.h"
+#include "core/device.h"
+#include "core/image.h"
+
+namespace vkb
+{
+namespace
+{
+// Copies from a buffer to an image need offsets aligned to the texel block size, 16 bytes covers the formats loaded
+const VkDeviceSize STAGING_ALIGNMENT = 16;
+
+const VkCommandPoolCreateFlags STAGING_COMMAND_POOL_FLAGS = VK_COMMAND_POOL_CREATE_RESET_COMMAND_BUFFER_BIT | VK_COMMAND_POOL_CREATE_TRANSIENT_BIT;
+}        // namespace
+
+constexpr VkDeviceSize StagingManager::DEFAULT_RING_SIZE;
+
+StagingManager::StagingManager(Device &device, VkDeviceSize ring_size, bool use_transfer_queue) :
+    device{device},
+    graphics_queue{device.get_queue_by_role(QueueRole::Graphics)},
+    transfer_queue{&graphics_queue},
+    ring_buffer{device, ring_size, VK_BUFFER_USAGE_TRANSFER_SRC_BIT, VMA_MEMORY_USAGE_CPU_ONLY}
+{
+	if (use_transfer_queue)
+	{
+		transfer_queue = &device.get_queue_by_role(QueueRole::Transfer);
+	}
+
+	command_pool = device.create_command_pool(transfer_queue->get_family_index(), STAGING_COMMAND_POOL_FLAGS);
+
+	if (transfer_queue->get_family_index() != graphics_queue.get_family_index())
+	{
+		acquire_command_pool = device.create_command_pool(graphics_queue.get_family_index(), STAGING_COMMAND_POOL_FLAGS);
+	}
+
+	if (device.is_enabled(VK_KHR_TIMELINE_SEMAPHORE_EXTENSION_NAME))
+	{
+		VkSemaphoreTypeCreateInfoKHR type_info{VK_STRUCTURE_TYPE_SEMAPHORE_TYPE_CREATE_INFO_KHR};
+		type_info.semaphoreType = VK_SEMAPHORE_TYPE_TIMELINE_KHR;
+		type_info.initialValue  = 0;
+
+		VkSemaphoreCreateInfo create_info{VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO};
+		create_info.pNext = &type_info;
+
+		VK_CHECK(vkCreateSemaphore(device.get_handle(), &create_info, nullptr, &timeline_semaphore));
+	}
+}
+
+StagingManager::~StagingManager()
+{
+	wait_idle();
+
+	for (VkSemaphore semaphore : free_semaphores)
+	{
+		vkDestroySemaphore(device.get_handle(), semaphore, nullptr);
+	}
+
+	if (timeline_semaphore != VK_NULL_HANDLE)
+	{
+		vkDestroySemaphore(device.get_handle(), timeline_semaphore, nullptr);
+	}
+
+	// Destroying the pools frees their command buffers
+	if (acquire_command_pool != VK_NULL_HANDLE)
+	{
+		vkDestroyCommandPool(device.get_handle(), acquire_command_pool, nullptr);
+	}
+
+	vkDestroyCommandPool(device.get_handle(), command_pool, nullptr);
+}
+
+void StagingManager::copy_to_buffer(const void *data, VkDeviceSize size, const core::Buffer &buffer, VkDeviceSize offset)
+{
+	{
+		std::lock_guard<std::mutex> lock{mutex};
+
+		VkDeviceSize staging_offset{0};
+		const auto & staging_buffer = stage(data, size, staging_offset);
+
+		VkBufferCopy region{staging_offset, offset, size};
+		vkCmdCopyBuffer(get_command_buffer(), staging_buffer.get_handle(), buffer.get_handle(), 1, &region);
+
+		VkBufferMemoryBarrier barrier{VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER};
+		barrier.srcAccessMask       = VK_ACCESS_TRANSFER_WRITE_BIT;
+		barrier.dstAccessMask       = VK_ACCESS_MEMORY_READ_BIT;
+		barrier.srcQueueFamilyIndex = transfer_queue->get_family_index();
+		barrier.dstQueueFamilyIndex = graphics_queue.get_family_index();
+		barrier.buffer              = buffer.get_handle();
+		barrier.offset              = offset;
+		barrier.size                = size;
+		current_batch.buffer_barriers.push_back(barrier);
+	}
+
+	run_completed_callbacks();
+}
+
+void StagingManager::copy_to_image(const void *data, VkDeviceSize size, const core::Image &image, const std::vector<VkBufferImageCopy> &regions,
+                                   const VkImageSubresourceRange &subresource_range, VkImageLayout final_layout)
+{
+	{
+		std::lock_guard<std::mutex> lock{mutex};
+
+		VkDeviceSize staging_offset{0};
+		const auto & staging_buffer = stage(data, size, staging_offset);
+
+		VkCommandBuffer command_buffer = get_command_buffer();
+
+		VkImageMemoryBarrier barrier{VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER};
+		barrier.srcAccessMask       = 0;
+		barrier.dstAccessMask       = VK_ACCESS_TRANSFER_WRITE_BIT;
+		barrier.oldLayout           = VK_IMAGE_LAYOUT_UNDEFINED;
+		barrier.newLayout           = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+		barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+		barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+		barrier.image               = image.get_handle();
+		barrier.subresourceRange    = subresource_range;
+
+		vkCmdPipelineBarrier(command_buffer, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT, 0, 0, nullptr, 0, nullptr, 1, &barrier);
+
+		std::vector<VkBufferImageCopy> staged_regions = regions;
+		for (auto &region : staged_regions)
+		{
+			region.bufferOffset += staging_offset;
+		}
+
+		vkCmdCopyBufferToImage(command_buffer, staging_buffer.get_handle(), image.get_handle(), VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+		                       to_u32(staged_regions.size()), staged_regions.data());
+
+		// The transition to the final layout is recorded with the other barriers of the batch
+		barrier.srcAccessMask       = VK_ACCESS_TRANSFER_WRITE_BIT;
+		barrier.dstAccessMask       = VK_ACCESS_MEMORY_READ_BIT;
+		barrier.oldLayout           = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+		barrier.newLayout           = final_layout;
+		barrier.srcQueueFamilyIndex = transfer_queue->get_family_index();
+		barrier.dstQueueFamilyIndex = graphics_queue.get_family_index();
+		current_batch.image_barriers.push_back(barrier);
+	}
+
+	run_completed_callbacks();
+}
+
+void StagingManager::copy_buffer(const core::Buffer &src, const core::Buffer &dst, const VkBufferCopy &region)
+{
+	std::lock_guard<std::mutex> lock{mutex};
+
+	vkCmdCopyBuffer(get_command_buffer(), src.get_handle(), dst.get_handle(), 1, &region);
+
+	VkBufferMemoryBarrier barrier{VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER};
+	barrier.srcAccessMask       = VK_ACCESS_TRANSFER_WRITE_BIT;
+	barrier.dstAccessMask       = VK_ACCESS_MEMORY_READ_BIT;
+	barrier.srcQueueFamilyIndex = transfer_queue->get_family_index();
+	barrier.dstQueueFamilyIndex = graphics_queue.get_family_index();
+	barrier.buffer              = dst.get_handle();
+	barrier.offset              = region.dstOffset;
+	barrier.size                = region.size;
+	current_batch.buffer_barriers.push_back(barrier);
+}
+
+uint64_t StagingManager::flush(std::function<void()> on_complete)
+{
+	uint64_t submission{0};
+
+	{
+		std::lock_guard<std::mutex> lock{mutex};
+
+		if (current_batch.command_buffer != VK_NULL_HANDLE)
+		{
+			current_batch.on_complete = std::move(on_complete);
+
+			submission = submit();
+		}
+		else if (!in_flight_batches.empty())
+		{
+			// Nothing new to submit, the callback waits for the last submission
+			auto &batch = in_flight_batches.back();
+
+			if (on_complete)
+			{
+				auto previous     = std::move(batch.on_complete);
+				batch.on_complete = [previous, on_complete]() {
+					if (previous)
+					{
+						previous();
+					}
+					on_complete();
+				};
+			}
+
+			submission = batch.submission;
+		}
+		else
+		{
+			// Every submission already completed
+			if (on_complete)
+			{
+				completed_callbacks.push_back(std::move(on_complete));
+			}
+
+			submission = submission_count;
+		}
+	}
+
+	run_completed_callbacks();
+
+	return submission;
+}
+
+void StagingManager::update()
+{
+	{
+		std::lock_guard<std::mutex> lock{mutex};
+
+		while (!in_flight_batches.empty() && is_complete(in_flight_batches.front()))
+		{
+			retire_oldest_batch();
+		}
+	}
+
+	run_completed_callbacks();
+}
+
+void StagingManager::wait(uint64_t submission)
+{
+	{
+		std::lock_guard<std::mutex> lock{mutex};
+
+		// Batches complete in submission order, since each one signals after the work submitted before it
+		while (!in_flight_batches.empty() && (in_flight_batches.front().submission <= submission || is_complete(in_flight_batches.front())))
+		{
+			retire_oldest_batch();
+		}
+	}
+
+	run_completed_callbacks();
+}
+
+void StagingManager::wait_idle()
+{
+	{
+		std::lock_guard<std::mutex> lock{mutex};
+
+		if (current_batch.command_buffer != VK_NULL_HANDLE)
+		{
+			submit();
+		}
+
+		while (!in_flight_batches.empty())
+		{
+			retire_oldest_batch();
+		}
+	}
+
+	run_completed_callbacks();
+}
+
+const Queue &StagingManager::get_queue() const
+{
+	return *transfer_queue;
+}
+
+bool StagingManager::has_pending_copies()
+{
+	std::lock_guard<std::mutex> lock{mutex};
+
+	return current_batch.command_buffer != VK_NULL_HANDLE;
+}
+
+core::Buffer &StagingManager::stage(const void *data, VkDeviceSize size, VkDeviceSize &offset)
+{
+	core::Buffer *buffer = &ring_buffer;
+
+	if (size <= ring_buffer.get_size())
+	{
+		// Retire batches until the data fits, this always succeeds once the ring is empty
+		while (!allocate(size, offset))
+		{
+			if (current_batch.ring_bytes > 0)
+			{
+				submit();
+			}
+			else
+			{
+				retire_oldest_batch();
+			}
+		}
+	}
+	else
+	{
+		current_batch.dedicated_buffers.push_back(std::make_unique<core::Buffer>(device, size, VK_BUFFER_USAGE_TRANSFER_SRC_BIT, VMA_MEMORY_USAGE_CPU_ONLY));
+		buffer = current_batch.dedicated_buffers.back().get();
+		offset = 0;
+	}
+
+	buffer->update(static_cast<const uint8_t *>(data), static_cast<size_t>(size), static_cast<size_t>(offset));
+
+	return *buffer;
+}
+
+bool StagingManager::allocate(VkDeviceSize size, VkDeviceSize &offset)
+{
+	const VkDeviceSize ring_size = ring_buffer.get_size();
+
+	if (ring_used == 0)
+	{
+		head = 0;
+	}
+
+	// Data in use is contiguous from the oldest batch to the head, wrapping around the end of the ring
+	VkDeviceSize aligned = (head + STAGING_ALIGNMENT - 1) / STAGING_ALIGNMENT * STAGING_ALIGNMENT;
+	VkDeviceSize padding = aligned - head;
+
+	if (aligned + size > ring_size)
+	{
+		// The end of the ring is skipped
+		padding = ring_size - head;
+		aligned = 0;
+	}
+
+	if (ring_used + padding + size > ring_size)
+	{
+		return false;
+	}
+
+	ring_used += padding + size;
+	current_batch.ring_bytes += padding + size;
+
+	head   = aligned + size;
+	offset = aligned;
+
+	return true;
+}
+
+VkCommandBuffer StagingManager::get_command_buffer()
+{
+	if (current_batch.command_buffer == VK_NULL_HANDLE)
+	{
+		current_batch.command_buffer = request_command_buffer(command_pool, free_command_buffers);
+
+		VkCommandBufferBeginInfo begin_info{VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO};
+		begin_info.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+		VK_CHECK(vkBeginCommandBuffer(current_batch.command_buffer, &begin_info));
+	}
+
+	return current_batch.command_buffer;
+}
+
+VkCommandBuffer StagingManager::request_command_buffer(VkCommandPool pool, std::vector<VkCommandBuffer> &free_pool_command_buffers)
+{
+	if (!free_pool_command_buffers.empty())
+	{
+		VkCommandBuffer command_buffer = free_pool_command_buffers.back();
+		free_pool_command_buffers.pop_back();
+		return command_buffer;
+	}
+
+	VkCommandBufferAllocateInfo allocate_info{VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO};
+	allocate_info.commandPool        = pool;
+	allocate_info.level              = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
+	allocate_info.commandBufferCount = 1;
+
+	VkCommandBuffer command_buffer{VK_NULL_HANDLE};
+	VK_CHECK(vkAllocateCommandBuffers(device.get_handle(), &allocate_info, &command_buffer));
+
+	return command_buffer;
+}
+
+uint64_t StagingManager::submit()
+{
+	auto &batch = current_batch;
+
+	if (batch.command_buffer == VK_NULL_HANDLE)
+	{
+		// Staged data needs a command buffer to be copied, so this only happens for empty batches
+		return submission_count;
+	}
+
+	batch.submission = ++submission_count;
+
+	bool ownership_transfer = transfer_queue->get_family_index() != graphics_queue.get_family_index();
+
+	if (ownership_transfer)
+	{
+		// Release barriers only need the source access, the acquire barriers make the data visible
+		for (auto &barrier : batch.buffer_barriers)
+		{
+			barrier.dstAccessMask = 0;
+		}
+		for (auto &barrier : batch.image_barriers)
+		{
+			barrier.dstAccessMask = 0;
+		}
+	}
+	else
+	{
+		for (auto &barrier : batch.buffer_barriers)
+		{
+			barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+			barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+		}
+		for (auto &barrier : batch.image_barriers)
+		{
+			barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+			barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+		}
+	}
+
+	if (!batch.buffer_barriers.empty() || !batch.image_barriers.empty())
+	{
+		vkCmdPipelineBarrier(batch.command_buffer, VK_PIPELINE_STAGE_TRANSFER_BIT,
+		                     ownership_transfer ? VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT : VK_PIPELINE_STAGE_ALL_COMMANDS_BIT, 0,
+		                     0, nullptr,
+		                     to_u32(batch.buffer_barriers.size()), batch.buffer_barriers.data(),
+		                     to_u32(batch.image_barriers.size()), batch.image_barriers.data());
+	}
+
+	VK_CHECK(vkEndCommandBuffer(batch.command_buffer));
+
+	VkSubmitInfo submit_info{VK_STRUCTURE_TYPE_SUBMIT_INFO};
+	submit_info.commandBufferCount = 1;
+	submit_info.pCommandBuffers    = &batch.command_buffer;
+
+	if (ownership_transfer)
+	{
+		if (!free_semaphores.empty())
+		{
+			batch.transfer_semaphore = free_semaphores.back();
+			free_semaphores.pop_back();
+		}
+		else
+		{
+			VkSemaphoreCreateInfo semaphore_info{VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO};
+			VK_CHECK(vkCreateSemaphore(device.get_handle(), &semaphore_info, nullptr, &batch.transfer_semaphore));
+		}
+
+		submit_info.signalSemaphoreCount = 1;
+		submit_info.pSignalSemaphores    = &batch.transfer_semaphore;
+
+		VK_CHECK(transfer_queue->submit({submit_info}, VK_NULL_HANDLE));
+
+		// The graphics queue acquires the resources once the copies complete
+		for (auto &barrier : batch.buffer_barriers)
+		{
+			barrier.srcAccessMask = 0;
+			barrier.dstAccessMask = VK_ACCESS_MEMORY_READ_BIT;
+		}
+		for (auto &barrier : batch.image_barriers)
+		{
+			barrier.srcAccessMask = 0;
+			barrier.dstAccessMask = VK_ACCESS_MEMORY_READ_BIT;
+		}
+
+		batch.acquire_command_buffer = request_command_buffer(acquire_command_pool, free_acquire_command_buffers);
+
+		VkCommandBufferBeginInfo begin_info{VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO};
+		begin_info.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+		VK_CHECK(vkBeginCommandBuffer(batch.acquire_command_buffer, &begin_info));
+
+		vkCmdPipelineBarrier(batch.acquire_command_buffer, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, VK_PIPELINE_STAGE_ALL_COMMANDS_BIT, 0,
+		                     0, nullptr,
+		                     to_u32(batch.buffer_barriers.size()), batch.buffer_barriers.data(),
+		                     to_u32(batch.image_barriers.size()), batch.image_barriers.data());
+
+		VK_CHECK(vkEndCommandBuffer(batch.acquire_command_buffer));
+
+		static const VkPipelineStageFlags wait_stage = VK_PIPELINE_STAGE_ALL_COMMANDS_BIT;
+
+		submit_info                    = {VK_STRUCTURE_TYPE_SUBMIT_INFO};
+		submit_info.waitSemaphoreCount = 1;
+		submit_info.pWaitSemaphores    = &batch.transfer_semaphore;
+		submit_info.pWaitDstStageMask  = &wait_stage;
+		submit_info.commandBufferCount = 1;
+		submit_info.pCommandBuffers    = &batch.acquire_command_buffer;
+	}
+
+	// The last submission of the batch signals its completion
+	const Queue &completion_queue = ownership_transfer ? graphics_queue : *transfer_queue;
+
+	VkTimelineSemaphoreSubmitInfoKHR timeline_info{VK_STRUCTURE_TYPE_TIMELINE_SEMAPHORE_SUBMIT_INFO_KHR};
+
+	if (timeline_semaphore != VK_NULL_HANDLE)
+	{
+		timeline_info.signalSemaphoreValueCount = 1;
+		timeline_info.pSignalSemaphoreValues    = &batch.submission;
+
+		submit_info.signalSemaphoreCount = 1;
+		submit_info.pSignalSemaphores    = &timeline_semaphore;
+		submit_info.pNext                = &timeline_info;
+	}
+	else
+	{
+		batch.fence = device.get_transient_fence_pool().request_fence();
+	}
+
+	VK_CHECK(completion_queue.submit({submit_info}, batch.fence));
+
+	uint64_t submission = batch.submission;
+
+	in_flight_batches.push_back(std::move(batch));
+
+	current_batch = {};
+
+	return submission;
+}
+
+bool StagingManager::is_complete(const Batch &batch) const
+{
+	if (timeline_semaphore != VK_NULL_HANDLE)
+	{
+		uint64_t value{0};
+		VK_CHECK(vkGetSemaphoreCounterValueKHR(device.get_handle(), timeline_semaphore, &value));
+
+		return value >= batch.submission;
+	}
+
+	return vkGetFenceStatus(device.get_handle(), batch.fence) == VK_SUCCESS;
+}
+
+void StagingManager::retire_oldest_batch()
+{
+	auto &batch = in_flight_batches.front();
+
+	if (timeline_semaphore != VK_NULL_HANDLE)
+	{
+		VkSemaphoreWaitInfoKHR wait_info{VK_STRUCTURE_TYPE_SEMAPHORE_WAIT_INFO_KHR};
+		wait_info.semaphoreCount = 1;
+		wait_info.pSemaphores    = &timeline_semaphore;
+		wait_info.pValues        = &batch.submission;
+
+		VK_CHECK(vkWaitSemaphoresKHR(device.get_handle(), &wait_info, std::numeric_limits<uint64_t>::max()));
+	}
+	else
+	{
+		VK_CHECK(device.get_transient_fence_pool().wait(batch.fence));
+	}
+
+	ring_used -= batch.ring_bytes;
+
+	VK_CHECK(vkResetCommandBuffer(batch.command_buffer, 0));
+	free_command_buffers.push_back(batch.command_buffer);
+
+	if (batch.acquire_command_buffer != VK_NULL_HANDLE)
+	{
+		VK_CHECK(vkResetCommandBuffer(batch.acquire_command_buffer, 0));
+		free_acquire_command_buffers.push_back(batch.acquire_command_buffer);
+	}
+
+	if (batch.transfer_semaphore != VK_NULL_HANDLE)
+	{
+		free_semaphores.push_back(batch.transfer_semaphore);
+	}
+
+	if (batch.on_complete)
+	{
+		completed_callbacks.push_back(std::move(batch.on_complete));
+	}
+
+	in_flight_batches.pop_front();
+}
+
+void StagingManager::run_completed_callbacks()
+{
+	std::vector<std::function<void()>> callbacks;
+
+	{
+		std::lock_guard<std::mutex> lock{mutex};
+		std::swap(callbacks, completed_callbacks);
+	}
+
+	for (auto &callback : callbacks)
+	{
+		callback();
+	}
+}
+}        // namespace vkb
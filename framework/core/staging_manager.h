@@ -0,0 +1,238 @@
+/* Copyright (c) 2020, Arm Limited and Contributors
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 the "License";
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+#include "common/vk_common.h"
+#include "core/buffer.h"
+
+namespace vkb
+{
+class Device;
+class Queue;
+
+namespace core
+{
+class Image;
+}
+
+/**
+ * @brief Uploads data to device local buffers and images through a persistent staging ring buffer
+ *
+ * Copies are recorded into one command buffer and submitted together on flush, which does not wait for them.
+ * The ring space of a submission is reused once it completes, which is tracked with a timeline semaphore
+ * if the device enables them, or with a fence otherwise. Recording and flushing are thread-safe.
+ *
+ * Copies recorded on a dedicated transfer queue release the resources to the graphics queue, which acquires them
+ * in a submission waiting for the copies. In both cases, work submitted to the graphics queue after a flush sees the uploaded data.
+ */
+class StagingManager
+{
+  public:
+	/**
+	 * @brief Constructs a StagingManager
+	 * @param device The device to upload to
+	 * @param ring_size Size of the staging ring buffer, larger uploads use a dedicated staging buffer
+	 * @param use_transfer_queue Whether to record the copies on a dedicated transfer queue, if the device has one
+	 */
+	StagingManager(Device &device, VkDeviceSize ring_size = DEFAULT_RING_SIZE, bool use_transfer_queue = false);
+
+	StagingManager(const StagingManager &) = delete;
+
+	StagingManager(StagingManager &&) = delete;
+
+	/**
+	 * @brief Waits for the pending copies, as the GPU reads from the staging memory
+	 */
+	~StagingManager();
+
+	StagingManager &operator=(const StagingManager &) = delete;
+
+	StagingManager &operator=(StagingManager &&) = delete;
+
+	/**
+	 * @brief Stages data and records its copy into a buffer
+	 * @param data The data to copy
+	 * @param size Size of the data in bytes
+	 * @param buffer The destination buffer
+	 * @param offset Offset of the copy in the destination buffer
+	 */
+	void copy_to_buffer(const void *data, VkDeviceSize size, const core::Buffer &buffer, VkDeviceSize offset = 0);
+
+	/**
+	 * @brief Stages data and records its copy into regions of an image
+	 *        The image goes from an undefined layout to final_layout.
+	 * @param data The data to copy
+	 * @param size Size of the data in bytes
+	 * @param image The destination image
+	 * @param regions The copied regions, with buffer offsets relative to the data
+	 * @param subresource_range The subresources the regions cover
+	 * @param final_layout Layout of the image once the copies complete
+	 */
+	void copy_to_image(const void *data, VkDeviceSize size, const core::Image &image, const std::vector<VkBufferImageCopy> &regions,
+	                   const VkImageSubresourceRange &subresource_range, VkImageLayout final_layout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL);
+
+	/**
+	 * @brief Records a copy between two buffers
+	 *        The source buffer must stay alive until the copy completes.
+	 */
+	void copy_buffer(const core::Buffer &src, const core::Buffer &dst, const VkBufferCopy &region);
+
+	/**
+	 * @brief Submits the copies recorded since the previous flush
+	 * @param on_complete Called by update or wait once the copies completed
+	 * @return The submission, to be waited for with wait
+	 */
+	uint64_t flush(std::function<void()> on_complete = nullptr);
+
+	/**
+	 * @brief Retires the completed submissions without blocking, calling their callbacks
+	 */
+	void update();
+
+	/**
+	 * @brief Blocks until a submission completes, then retires the completed submissions
+	 * @param submission A submission returned by flush
+	 */
+	void wait(uint64_t submission);
+
+	/**
+	 * @brief Flushes the recorded copies and waits for all the submissions
+	 */
+	void wait_idle();
+
+	/**
+	 * @return The queue the copies are submitted to
+	 */
+	const Queue &get_queue() const;
+
+	/**
+	 * @return True if there are copies recorded since the previous flush
+	 */
+	bool has_pending_copies();
+
+	static constexpr VkDeviceSize DEFAULT_RING_SIZE{32 * 1024 * 1024};
+
+  private:
+	/// Copies recorded into one command buffer and submitted together
+	struct Batch
+	{
+		VkCommandBuffer command_buffer{VK_NULL_HANDLE};
+
+		/// Command buffer acquiring the resources on the graphics queue, when copying on a transfer queue
+		VkCommandBuffer acquire_command_buffer{VK_NULL_HANDLE};
+
+		/// Signals the acquire submission that the copies completed, when copying on a transfer queue
+		VkSemaphore transfer_semaphore{VK_NULL_HANDLE};
+
+		/// Signaled by the last submission of the batch, if timeline semaphores are not enabled
+		VkFence fence{VK_NULL_HANDLE};
+
+		uint64_t submission{0};
+
+		/// Bytes of the ring used by the batch, including alignment padding
+		VkDeviceSize ring_bytes{0};
+
+		/// Staging buffers of uploads that do not fit in the ring
+		std::vector<std::unique_ptr<core::Buffer>> dedicated_buffers;
+
+		/// Barriers making the copies visible, or releasing the resources to the graphics queue, once they complete
+		std::vector<VkBufferMemoryBarrier> buffer_barriers;
+
+		std::vector<VkImageMemoryBarrier> image_barriers;
+
+		std::function<void()> on_complete;
+	};
+
+	/**
+	 * @brief Copies data to the ring or to a dedicated buffer of the current batch
+	 * @param[out] offset Offset of the data in the returned buffer
+	 * @return The staging buffer holding the data
+	 */
+	core::Buffer &stage(const void *data, VkDeviceSize size, VkDeviceSize &offset);
+
+	/**
+	 * @brief Allocates a range of the ring
+	 * @return True if the range fits in the free part of the ring
+	 */
+	bool allocate(VkDeviceSize size, VkDeviceSize &offset);
+
+	VkCommandBuffer get_command_buffer();
+
+	VkCommandBuffer request_command_buffer(VkCommandPool command_pool, std::vector<VkCommandBuffer> &free_command_buffers);
+
+	uint64_t submit();
+
+	bool is_complete(const Batch &batch) const;
+
+	/**
+	 * @brief Retires the oldest in flight batch, waiting for it if needed, and releases its resources
+	 *        Its callback is queued to be called by run_completed_callbacks.
+	 */
+	void retire_oldest_batch();
+
+	/**
+	 * @brief Calls the callbacks of the retired batches, without holding the lock so that they can upload more data
+	 */
+	void run_completed_callbacks();
+
+	Device &device;
+
+	const Queue &graphics_queue;
+
+	const Queue *transfer_queue;
+
+	core::Buffer ring_buffer;
+
+	/// Next free byte of the ring
+	VkDeviceSize head{0};
+
+	/// Bytes of the ring in use by the current and the in flight batches
+	VkDeviceSize ring_used{0};
+
+	VkCommandPool command_pool{VK_NULL_HANDLE};
+
+	/// Command pool of the graphics queue, when copying on a transfer queue
+	VkCommandPool acquire_command_pool{VK_NULL_HANDLE};
+
+	std::vector<VkCommandBuffer> free_command_buffers;
+
+	std::vector<VkCommandBuffer> free_acquire_command_buffers;
+
+	std::vector<VkSemaphore> free_semaphores;
+
+	/// Signaled with the submission of each batch once it completes, null if timeline semaphores are not enabled
+	VkSemaphore timeline_semaphore{VK_NULL_HANDLE};
+
+	uint64_t submission_count{0};
+
+	Batch current_batch;
+
+	std::deque<Batch> in_flight_batches;
+
+	std::vector<std::function<void()>> completed_callbacks;
+
+	/// Guards the batches, the ring and the pools, copies are recorded by a single thread at a time
+	std::mutex mutex;
+};
+}        // namespace vkb
@@ -0,0 +1,154 @@
+/* Copyright (c) 2020, Arm Limited and Contributors
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 the "License";
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "submit_batch.h"
+
+#include <algorithm>
+#include <cassert>
+
+#include "common/helpers.h"
+#include "core/command_buffer.h"
+#include "core/queue.h"
+
+namespace vkb
+{
+SubmitBatch::SubmitBatch(const Queue &queue) :
+    queue{queue}
+{
+}
+
+void SubmitBatch::add(const VkSubmitInfo &submit_info)
+{
+	Submission submission;
+
+	submission.command_buffers.assign(submit_info.pCommandBuffers, submit_info.pCommandBuffers + submit_info.commandBufferCount);
+	submission.wait_semaphores.assign(submit_info.pWaitSemaphores, submit_info.pWaitSemaphores + submit_info.waitSemaphoreCount);
+	submission.wait_stages.assign(submit_info.pWaitDstStageMask, submit_info.pWaitDstStageMask + submit_info.waitSemaphoreCount);
+	submission.signal_semaphores.assign(submit_info.pSignalSemaphores, submit_info.pSignalSemaphores + submit_info.signalSemaphoreCount);
+
+	if (submit_info.pNext)
+	{
+		auto *timeline_info = static_cast<const VkTimelineSemaphoreSubmitInfoKHR *>(submit_info.pNext);
+
+		assert(timeline_info->sType == VK_STRUCTURE_TYPE_TIMELINE_SEMAPHORE_SUBMIT_INFO_KHR && timeline_info->pNext == nullptr &&
+		       timeline_info->waitSemaphoreValueCount == 0 && "Only timeline signal values can be batched");
+
+		submission.signal_values.assign(timeline_info->pSignalSemaphoreValues, timeline_info->pSignalSemaphoreValues + timeline_info->signalSemaphoreValueCount);
+	}
+
+	std::lock_guard<std::mutex> lock{mutex};
+
+	submissions.push_back(std::move(submission));
+}
+
+void SubmitBatch::add(const CommandBuffer &command_buffer)
+{
+	VkSubmitInfo submit_info{VK_STRUCTURE_TYPE_SUBMIT_INFO};
+	submit_info.commandBufferCount = 1;
+	submit_info.pCommandBuffers    = &command_buffer.get_handle();
+
+	add(submit_info);
+}
+
+bool SubmitBatch::empty() const
+{
+	std::lock_guard<std::mutex> lock{mutex};
+
+	return submissions.empty();
+}
+
+VkResult SubmitBatch::flush(VkFence fence, uint32_t device_mask)
+{
+	std::lock_guard<std::mutex> lock{mutex};
+
+	if (submissions.empty() && fence == VK_NULL_HANDLE)
+	{
+		return VK_SUCCESS;
+	}
+
+	std::vector<VkSubmitInfo>                     submit_infos(submissions.size(), {VK_STRUCTURE_TYPE_SUBMIT_INFO});
+	std::vector<VkTimelineSemaphoreSubmitInfoKHR> timeline_infos(submissions.size(), {VK_STRUCTURE_TYPE_TIMELINE_SEMAPHORE_SUBMIT_INFO_KHR});
+	std::vector<VkDeviceGroupSubmitInfoKHR>       group_infos(submissions.size(), {VK_STRUCTURE_TYPE_DEVICE_GROUP_SUBMIT_INFO_KHR});
+
+	// Semaphores are waited for and signaled by the physical device executing the submissions
+	uint32_t              device_index = 0;
+	std::vector<uint32_t> device_masks;
+	std::vector<uint32_t> device_indices;
+
+	if (device_mask != 0)
+	{
+		assert((device_mask & (device_mask - 1)) == 0 && "Submissions are executed by a single physical device");
+
+		while ((device_mask >> device_index) != 1)
+		{
+			++device_index;
+		}
+
+		size_t max_count = 0;
+		for (auto &submission : submissions)
+		{
+			max_count = std::max({max_count, submission.command_buffers.size(), submission.wait_semaphores.size(), submission.signal_semaphores.size()});
+		}
+
+		device_masks.resize(max_count, device_mask);
+		device_indices.resize(max_count, device_index);
+	}
+
+	for (size_t i = 0; i < submissions.size(); ++i)
+	{
+		auto &submission  = submissions[i];
+		auto &submit_info = submit_infos[i];
+
+		submit_info.commandBufferCount   = to_u32(submission.command_buffers.size());
+		submit_info.pCommandBuffers      = submission.command_buffers.data();
+		submit_info.waitSemaphoreCount   = to_u32(submission.wait_semaphores.size());
+		submit_info.pWaitSemaphores      = submission.wait_semaphores.data();
+		submit_info.pWaitDstStageMask    = submission.wait_stages.data();
+		submit_info.signalSemaphoreCount = to_u32(submission.signal_semaphores.size());
+		submit_info.pSignalSemaphores    = submission.signal_semaphores.data();
+
+		if (!submission.signal_values.empty())
+		{
+			timeline_infos[i].signalSemaphoreValueCount = to_u32(submission.signal_values.size());
+			timeline_infos[i].pSignalSemaphoreValues    = submission.signal_values.data();
+
+			submit_info.pNext = &timeline_infos[i];
+		}
+
+		if (device_mask != 0)
+		{
+			auto &group_info = group_infos[i];
+
+			group_info.commandBufferCount            = submit_info.commandBufferCount;
+			group_info.pCommandBufferDeviceMasks     = device_masks.data();
+			group_info.waitSemaphoreCount            = submit_info.waitSemaphoreCount;
+			group_info.pWaitSemaphoreDeviceIndices   = device_indices.data();
+			group_info.signalSemaphoreCount          = submit_info.signalSemaphoreCount;
+			group_info.pSignalSemaphoreDeviceIndices = device_indices.data();
+
+			group_info.pNext  = submit_info.pNext;
+			submit_info.pNext = &group_info;
+		}
+	}
+
+	VkResult result = queue.submit(submit_infos, fence);
+
+	submissions.clear();
+
+	return result;
+}
+}        // namespace vkb
@@ -0,0 +1,88 @@
+/* Copyright (c) 2020, Arm Limited and Contributors
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 the "License";
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <deque>
+#include <mutex>
+#include <vector>
+
+#include "common/vk_common.h"
+
+namespace vkb
+{
+class CommandBuffer;
+class Queue;
+
+/**
+ * @brief Collects submissions to a queue and issues them with a single vkQueueSubmit
+ *
+ * Submissions are issued in the order they were added, so semaphore signals and waits keep their
+ * meaning. Adding and flushing are thread-safe.
+ */
+class SubmitBatch
+{
+  public:
+	SubmitBatch(const Queue &queue);
+
+	SubmitBatch(const SubmitBatch &) = delete;
+
+	SubmitBatch &operator=(const SubmitBatch &) = delete;
+
+	/**
+	 * @brief Adds a submission, copying the arrays it points to
+	 * @param submit_info Submission whose pNext chain is empty or a VkTimelineSemaphoreSubmitInfoKHR with signal values only
+	 */
+	void add(const VkSubmitInfo &submit_info);
+
+	/**
+	 * @brief Adds a submission of a command buffer without semaphores
+	 */
+	void add(const CommandBuffer &command_buffer);
+
+	bool empty() const;
+
+	/**
+	 * @brief Submits the submissions added since the last flush
+	 * @param fence Fence signaled once they have completed, it is submitted even if the batch is empty
+	 * @param device_mask Single physical device of a device group executing the submissions, 0 for all of them
+	 * @return The result of vkQueueSubmit, or VK_SUCCESS if there was nothing to submit
+	 */
+	VkResult flush(VkFence fence = VK_NULL_HANDLE, uint32_t device_mask = 0);
+
+  private:
+	struct Submission
+	{
+		std::vector<VkCommandBuffer> command_buffers;
+
+		std::vector<VkSemaphore> wait_semaphores;
+
+		std::vector<VkPipelineStageFlags> wait_stages;
+
+		std::vector<VkSemaphore> signal_semaphores;
+
+		/// Values of the signal semaphores, empty if none of them is a timeline semaphore
+		std::vector<uint64_t> signal_values;
+	};
+
+	const Queue &queue;
+
+	mutable std::mutex mutex;
+
+	std::deque<Submission> submissions;
+};
+}        // namespace vkb
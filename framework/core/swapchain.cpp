@@ -19,6 +19,7 @@
 
 #include "common/logging.h"
 #include "device.h"
+#include "image_compression.h"
 
 namespace vkb
 {
@@ -410,6 +411,15 @@ void Swapchain::create()
 	create_info.oldSwapchain     = properties.old_swapchain;
 	create_info.surface          = surface;
 
+	// Device groups present with any of their modes, the one of each present is chosen when presenting
+	VkDeviceGroupSwapchainCreateInfoKHR group_info{VK_STRUCTURE_TYPE_DEVICE_GROUP_SWAPCHAIN_CREATE_INFO_KHR};
+
+	if (device.get_device_group_present_modes() != 0)
+	{
+		group_info.modes  = device.get_device_group_present_modes();
+		create_info.pNext = &group_info;
+	}
+
 	VkResult result = vkCreateSwapchainKHR(device.get_handle(), &create_info, nullptr, &handle);
 
 	if (result != VK_SUCCESS)
@@ -423,7 +433,11 @@ void Swapchain::create()
 	images.resize(image_available);
 
 	VK_CHECK(vkGetSwapchainImagesKHR(device.get_handle(), handle, &image_available, images.data()));
-}        // namespace vkb
+
+	// Swapchain images can't be queried without VK_EXT_image_compression_control_swapchain, only the usage is checked
+	check_image_compression(device, VK_NULL_HANDLE, properties.surface_format.format, {properties.extent.width, properties.extent.height, 1},
+	                        properties.image_usage, VK_IMAGE_TILING_OPTIMAL, "Swapchain");
+}
 
 bool Swapchain::is_valid() const
 {
@@ -445,9 +459,21 @@ SwapchainProperties &Swapchain::get_properties()
 	return properties;
 }
 
-VkResult Swapchain::acquire_next_image(uint32_t &image_index, VkSemaphore image_acquired_semaphore, VkFence fence)
+VkResult Swapchain::acquire_next_image(uint32_t &image_index, VkSemaphore image_acquired_semaphore, VkFence fence, uint32_t device_mask)
 {
-	return vkAcquireNextImageKHR(device.get_handle(), handle, std::numeric_limits<uint64_t>::max(), image_acquired_semaphore, fence, &image_index);
+	if (device_mask == 0)
+	{
+		return vkAcquireNextImageKHR(device.get_handle(), handle, std::numeric_limits<uint64_t>::max(), image_acquired_semaphore, fence, &image_index);
+	}
+
+	VkAcquireNextImageInfoKHR acquire_info{VK_STRUCTURE_TYPE_ACQUIRE_NEXT_IMAGE_INFO_KHR};
+	acquire_info.swapchain  = handle;
+	acquire_info.timeout    = std::numeric_limits<uint64_t>::max();
+	acquire_info.semaphore  = image_acquired_semaphore;
+	acquire_info.fence      = fence;
+	acquire_info.deviceMask = device_mask;
+
+	return vkAcquireNextImage2KHR(device.get_handle(), &acquire_info, &image_index);
 }
 
 const VkExtent2D &Swapchain::get_extent() const
@@ -114,7 +114,11 @@ class Swapchain
 
 	SwapchainProperties &get_properties();
 
-	VkResult acquire_next_image(uint32_t &image_index, VkSemaphore image_acquired_semaphore, VkFence fence = VK_NULL_HANDLE);
+	/**
+	 * @brief Acquires the next image of the swapchain
+	 * @param device_mask Physical devices of a device group the semaphore and fence are signaled on, 0 for the default
+	 */
+	VkResult acquire_next_image(uint32_t &image_index, VkSemaphore image_acquired_semaphore, VkFence fence = VK_NULL_HANDLE, uint32_t device_mask = 0);
 
 	const VkExtent2D &get_extent() const;
 
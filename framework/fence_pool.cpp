@@ -17,10 +17,14 @@
 
 #include "fence_pool.h"
 
+#include "common/error.h"
 #include "core/device.h"
 
 namespace vkb
 {
+constexpr uint32_t FencePool::TRIM_PERIOD;
+constexpr size_t   TransientFencePool::MAX_FREE_FENCES;
+
 FencePool::FencePool(Device &device) :
     device{device}
 {
@@ -76,6 +80,13 @@ VkResult FencePool::wait(uint32_t timeout) const
 	return vkWaitForFences(device.get_handle(), active_fence_count, fences.data(), true, timeout);
 }
 
+VkResult FencePool::poll() const
+{
+	VkResult result = wait(0);
+
+	return result == VK_TIMEOUT ? VK_NOT_READY : result;
+}
+
 VkResult FencePool::reset()
 {
 	if (active_fence_count < 1 || fences.empty())
@@ -90,8 +101,114 @@ VkResult FencePool::reset()
 		return result;
 	}
 
+	high_water_mark = std::max(high_water_mark, active_fence_count);
+
 	active_fence_count = 0;
 
+	if (++reset_count >= TRIM_PERIOD)
+	{
+		// Fences beyond the high water mark were not requested over the whole period
+		for (size_t i = high_water_mark; i < fences.size(); ++i)
+		{
+			vkDestroyFence(device.get_handle(), fences[i], nullptr);
+		}
+
+		fences.resize(std::min<size_t>(fences.size(), high_water_mark));
+
+		high_water_mark = 0;
+		reset_count     = 0;
+	}
+
 	return VK_SUCCESS;
 }
+
+TransientFencePool::TransientFencePool(Device &device) :
+    device{device}
+{
+}
+
+TransientFencePool::~TransientFencePool()
+{
+	if (!used_fences.empty())
+	{
+		VK_CHECK(vkWaitForFences(device.get_handle(), to_u32(used_fences.size()), used_fences.data(), VK_TRUE, std::numeric_limits<uint64_t>::max()));
+	}
+
+	for (VkFence fence : used_fences)
+	{
+		vkDestroyFence(device.get_handle(), fence, nullptr);
+	}
+
+	for (VkFence fence : free_fences)
+	{
+		vkDestroyFence(device.get_handle(), fence, nullptr);
+	}
+}
+
+VkFence TransientFencePool::request_fence()
+{
+	std::lock_guard<std::mutex> lock{mutex};
+
+	VkFence fence{VK_NULL_HANDLE};
+
+	if (!free_fences.empty())
+	{
+		fence = free_fences.back();
+		free_fences.pop_back();
+	}
+	else
+	{
+		VkFenceCreateInfo create_info{VK_STRUCTURE_TYPE_FENCE_CREATE_INFO};
+
+		VkResult result = vkCreateFence(device.get_handle(), &create_info, nullptr, &fence);
+
+		if (result != VK_SUCCESS)
+		{
+			throw VulkanException{result, "Failed to create fence"};
+		}
+	}
+
+	used_fences.push_back(fence);
+
+	return fence;
+}
+
+VkResult TransientFencePool::wait(VkFence fence, uint64_t timeout)
+{
+	// Waiting does not hold the lock, so that other threads can request and wait for their own fences meanwhile
+	VkResult result = vkWaitForFences(device.get_handle(), 1, &fence, VK_TRUE, timeout);
+
+	if (result != VK_SUCCESS)
+	{
+		return result;
+	}
+
+	std::lock_guard<std::mutex> lock{mutex};
+
+	auto fence_it = std::find(used_fences.begin(), used_fences.end(), fence);
+
+	assert(fence_it != used_fences.end() && "The fence was not requested from this pool");
+
+	used_fences.erase(fence_it);
+
+	if (free_fences.size() >= MAX_FREE_FENCES)
+	{
+		vkDestroyFence(device.get_handle(), fence, nullptr);
+
+		return VK_SUCCESS;
+	}
+
+	result = vkResetFences(device.get_handle(), 1, &fence);
+
+	if (result == VK_SUCCESS)
+	{
+		free_fences.push_back(fence);
+	}
+	else
+	{
+		vkDestroyFence(device.get_handle(), fence, nullptr);
+	}
+
+	return result;
+}
 }        // namespace vkb
@@ -17,6 +17,8 @@
 
 #pragma once
 
+#include <mutex>
+
 #include "common/helpers.h"
 
 namespace vkb
@@ -42,13 +44,82 @@ class FencePool
 
 	VkResult wait(uint32_t timeout = std::numeric_limits<uint32_t>::max()) const;
 
+	/**
+	 * @brief Checks without blocking whether the fences requested since the last reset are signaled
+	 * @return VK_SUCCESS if they all are, VK_NOT_READY otherwise
+	 */
+	VkResult poll() const;
+
+	/**
+	 * @brief Resets the fences requested since the last reset, so that they can be requested again
+	 *        Every TRIM_PERIOD resets, the fences beyond the most requested over the period are destroyed.
+	 */
 	VkResult reset();
 
+	/**
+	 * @brief Number of resets over which the peak number of requested fences is tracked
+	 */
+	static constexpr uint32_t TRIM_PERIOD{256};
+
   private:
 	Device &device;
 
 	std::vector<VkFence> fences;
 
 	uint32_t active_fence_count{0};
+
+	/// Most fences requested between two resets since the last trim
+	uint32_t high_water_mark{0};
+
+	/// Resets since the last trim
+	uint32_t reset_count{0};
+};
+
+/**
+ * @brief Thread safe pool of fences for one-off submissions such as uploads
+ *        Unlike a FencePool, its fences are waited for and recycled one by one,
+ *        so that users of the pool on other threads are neither waited for nor reset.
+ */
+class TransientFencePool
+{
+  public:
+	TransientFencePool(Device &device);
+
+	TransientFencePool(const TransientFencePool &) = delete;
+
+	TransientFencePool(TransientFencePool &&other) = delete;
+
+	~TransientFencePool();
+
+	TransientFencePool &operator=(const TransientFencePool &) = delete;
+
+	TransientFencePool &operator=(TransientFencePool &&) = delete;
+
+	/**
+	 * @return An unsignaled fence, to be passed back to wait once submitted
+	 */
+	VkFence request_fence();
+
+	/**
+	 * @brief Waits for a fence of the pool to be signaled, then resets it and returns it to the pool
+	 * @param fence A fence requested from the pool
+	 * @param timeout Timeout in nanoseconds, the fence stays in use if it expires
+	 */
+	VkResult wait(VkFence fence, uint64_t timeout = std::numeric_limits<uint64_t>::max());
+
+	/**
+	 * @brief Most unused fences kept for later requests, further returned fences are destroyed
+	 */
+	static constexpr size_t MAX_FREE_FENCES{16};
+
+  private:
+	Device &device;
+
+	std::mutex mutex;
+
+	/// Fences requested and not returned yet
+	std::vector<VkFence> used_fences;
+
+	std::vector<VkFence> free_fences;
 };
 }        // namespace vkb
@@ -0,0 +1,548 @@
+/* Copyright (c) 2020, Arm Limited and Contributors
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 the "License";
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "bvh.h"
+
+#include <algorithm>
+#include <array>
+#include <future>
+
+#include "geometry/frustum.h"
+#include "job_system.h"
+
+namespace vkb
+{
+namespace
+{
+/// Subtrees of more primitives are built on another worker
+constexpr uint32_t PARALLEL_BUILD_SIZE = 4096;
+
+/// Maximum depth of the subtrees built in parallel
+constexpr uint32_t PARALLEL_BUILD_DEPTH = 4;
+
+constexpr uint32_t NO_PARENT = ~0U;
+}        // namespace
+
+constexpr uint32_t BVH::MAX_LEAF_SIZE;
+constexpr uint32_t BVH::BIN_COUNT;
+
+void BVH::Bounds::expand(const glm::vec3 &point)
+{
+	min = glm::min(min, point);
+	max = glm::max(max, point);
+}
+
+void BVH::Bounds::expand(const Bounds &bounds)
+{
+	min = glm::min(min, bounds.min);
+	max = glm::max(max, bounds.max);
+}
+
+glm::vec3 BVH::Bounds::get_center() const
+{
+	return (min + max) * 0.5f;
+}
+
+float BVH::Bounds::get_surface_area() const
+{
+	glm::vec3 extent = glm::max(max - min, glm::vec3(0.0f));
+	return 2.0f * (extent.x * extent.y + extent.y * extent.z + extent.z * extent.x);
+}
+
+bool BVH::Bounds::overlaps(const Bounds &bounds) const
+{
+	return glm::all(glm::lessThanEqual(min, bounds.max)) && glm::all(glm::lessThanEqual(bounds.min, max));
+}
+
+float BVH::Bounds::intersect_ray(const glm::vec3 &origin, const glm::vec3 &inverse_direction, float max_distance) const
+{
+	glm::vec3 t0 = (min - origin) * inverse_direction;
+	glm::vec3 t1 = (max - origin) * inverse_direction;
+
+	glm::vec3 t_near = glm::min(t0, t1);
+	glm::vec3 t_far  = glm::max(t0, t1);
+
+	float entry = std::max(std::max(t_near.x, t_near.y), std::max(t_near.z, 0.0f));
+	float exit  = std::min(std::min(t_far.x, t_far.y), std::min(t_far.z, max_distance));
+
+	return entry <= exit ? entry : std::numeric_limits<float>::infinity();
+}
+
+void BVH::build(const std::vector<Bounds> &primitive_bounds)
+{
+	nodes.clear();
+	parent_indices.clear();
+
+	uint32_t primitive_count = static_cast<uint32_t>(primitive_bounds.size());
+
+	primitive_indices.resize(primitive_count);
+	primitive_leaves.assign(primitive_count, 0);
+	primitive_slots.assign(primitive_count, 0);
+	leaf_bounds.resize(primitive_count);
+	leaf_boxes.resize(primitive_count);
+
+	if (primitive_count == 0)
+	{
+		return;
+	}
+
+	for (uint32_t i = 0; i < primitive_count; ++i)
+	{
+		primitive_indices[i] = i;
+	}
+
+	build_bounds = &primitive_bounds;
+
+	build_centroids.resize(primitive_count);
+	std::transform(primitive_bounds.begin(), primitive_bounds.end(), build_centroids.begin(),
+	               [](const Bounds &bounds) { return bounds.get_center(); });
+
+	nodes.reserve(2 * primitive_count / MAX_LEAF_SIZE + 1);
+	build_node(nodes, 0, primitive_count, 0);
+
+	build_bounds = nullptr;
+	build_centroids.clear();
+
+	// Links used by refits
+	parent_indices.assign(nodes.size(), NO_PARENT);
+
+	for (uint32_t i = 0; i < nodes.size(); ++i)
+	{
+		auto &node = nodes[i];
+
+		if (node.count == 0)
+		{
+			parent_indices[i + 1]       = i;
+			parent_indices[node.offset] = i;
+		}
+		else
+		{
+			for (uint32_t j = node.offset; j < node.offset + node.count; ++j)
+			{
+				primitive_leaves[primitive_indices[j]] = i;
+				primitive_slots[primitive_indices[j]]  = j;
+				leaf_bounds[j]                         = primitive_bounds[primitive_indices[j]];
+
+				leaf_boxes.set(j, leaf_bounds[j].min, leaf_bounds[j].max);
+			}
+		}
+	}
+}
+
+uint32_t BVH::build_node(std::vector<Node> &out_nodes, uint32_t first, uint32_t last, uint32_t depth)
+{
+	uint32_t node_index = static_cast<uint32_t>(out_nodes.size());
+	out_nodes.emplace_back();
+
+	Bounds bounds;
+	Bounds centroid_bounds;
+
+	for (uint32_t i = first; i < last; ++i)
+	{
+		bounds.expand((*build_bounds)[primitive_indices[i]]);
+		centroid_bounds.expand(build_centroids[primitive_indices[i]]);
+	}
+
+	out_nodes[node_index].bounds = bounds;
+
+	uint32_t count = last - first;
+
+	auto make_leaf = [&]() {
+		out_nodes[node_index].offset = first;
+		out_nodes[node_index].count  = count;
+		return node_index;
+	};
+
+	if (count <= MAX_LEAF_SIZE)
+	{
+		return make_leaf();
+	}
+
+	// Bin the centroids along their largest extent
+	glm::vec3 extent = centroid_bounds.max - centroid_bounds.min;
+
+	int axis = 0;
+	if (extent.y > extent[axis])
+	{
+		axis = 1;
+	}
+	if (extent.z > extent[axis])
+	{
+		axis = 2;
+	}
+
+	uint32_t mid = first + count / 2;
+
+	if (extent[axis] > 0.0f)
+	{
+		struct Bin
+		{
+			Bounds bounds;
+
+			uint32_t count{0};
+		};
+
+		std::array<Bin, BIN_COUNT> bins;
+
+		float axis_min   = centroid_bounds.min[axis];
+		float axis_scale = BIN_COUNT / extent[axis];
+
+		auto get_bin = [&](uint32_t primitive) {
+			return std::min(BIN_COUNT - 1, static_cast<uint32_t>((build_centroids[primitive][axis] - axis_min) * axis_scale));
+		};
+
+		for (uint32_t i = first; i < last; ++i)
+		{
+			auto &bin = bins[get_bin(primitive_indices[i])];
+			bin.bounds.expand((*build_bounds)[primitive_indices[i]]);
+			bin.count++;
+		}
+
+		// Cost of the primitives left of every split, then of the primitives right of it
+		std::array<float, BIN_COUNT - 1> split_costs;
+
+		Bounds   left_bounds;
+		uint32_t left_count = 0;
+
+		for (uint32_t i = 0; i + 1 < BIN_COUNT; ++i)
+		{
+			left_bounds.expand(bins[i].bounds);
+			left_count += bins[i].count;
+			split_costs[i] = left_count ? left_bounds.get_surface_area() * left_count : 0.0f;
+		}
+
+		Bounds   right_bounds;
+		uint32_t right_count = 0;
+
+		for (uint32_t i = BIN_COUNT - 1; i > 0; --i)
+		{
+			right_bounds.expand(bins[i].bounds);
+			right_count += bins[i].count;
+			split_costs[i - 1] += right_count ? right_bounds.get_surface_area() * right_count : 0.0f;
+		}
+
+		auto best_split = static_cast<uint32_t>(std::min_element(split_costs.begin(), split_costs.end()) - split_costs.begin());
+
+		// Traversing the node costs about as much as testing one primitive
+		float leaf_cost  = bounds.get_surface_area() * count;
+		float split_cost = bounds.get_surface_area() + split_costs[best_split];
+
+		if (count <= 2 * MAX_LEAF_SIZE && leaf_cost <= split_cost)
+		{
+			return make_leaf();
+		}
+
+		auto split_it = std::partition(primitive_indices.begin() + first, primitive_indices.begin() + last,
+		                               [&](uint32_t primitive) { return get_bin(primitive) <= best_split; });
+
+		auto split = static_cast<uint32_t>(split_it - primitive_indices.begin());
+		if (split != first && split != last)
+		{
+			mid = split;
+		}
+	}
+
+	// The left child follows its parent, the right one is placed after the left subtree
+	if (depth < PARALLEL_BUILD_DEPTH && count >= PARALLEL_BUILD_SIZE)
+	{
+		auto &job_system = JobSystem::get();
+
+		std::vector<Node> right_nodes;
+
+		auto right_future = job_system.push([this, &right_nodes, mid, last, depth](size_t) {
+			build_node(right_nodes, mid, last, depth + 1);
+		},
+		                                    JobPriority::High);
+
+		build_node(out_nodes, first, mid, depth + 1);
+
+		job_system.wait(right_future);
+
+		auto right_offset = static_cast<uint32_t>(out_nodes.size());
+
+		for (auto &node : right_nodes)
+		{
+			if (node.count == 0)
+			{
+				node.offset += right_offset;
+			}
+			out_nodes.push_back(node);
+		}
+
+		out_nodes[node_index].offset = right_offset;
+	}
+	else
+	{
+		build_node(out_nodes, first, mid, depth + 1);
+
+		auto right_index = build_node(out_nodes, mid, last, depth + 1);
+
+		out_nodes[node_index].offset = right_index;
+	}
+
+	return node_index;
+}
+
+void BVH::refit(const std::vector<Bounds> &primitive_bounds, const std::vector<uint32_t> &changed_primitives)
+{
+	assert(primitive_bounds.size() == primitive_indices.size() && "BVH refit with a different primitive count");
+
+	for (auto primitive : changed_primitives)
+	{
+		uint32_t slot = primitive_slots[primitive];
+
+		leaf_bounds[slot] = primitive_bounds[primitive];
+		leaf_boxes.set(slot, leaf_bounds[slot].min, leaf_bounds[slot].max);
+	}
+
+	// Ancestors of a node whose bounds did not change are already up to date
+	for (auto primitive : changed_primitives)
+	{
+		uint32_t node_index = primitive_leaves[primitive];
+
+		while (node_index != NO_PARENT)
+		{
+			auto & node = nodes[node_index];
+			Bounds bounds;
+
+			if (node.count == 0)
+			{
+				bounds.expand(nodes[node_index + 1].bounds);
+				bounds.expand(nodes[node.offset].bounds);
+			}
+			else
+			{
+				for (uint32_t i = node.offset; i < node.offset + node.count; ++i)
+				{
+					bounds.expand(leaf_bounds[i]);
+				}
+			}
+
+			if (bounds.min == node.bounds.min && bounds.max == node.bounds.max)
+			{
+				break;
+			}
+
+			node.bounds = bounds;
+
+			node_index = parent_indices[node_index];
+		}
+	}
+}
+
+void BVH::query_frustum(const Frustum &frustum, std::vector<uint32_t> &primitives) const
+{
+	if (nodes.empty())
+	{
+		return;
+	}
+
+	const auto &planes = frustum.get_planes();
+
+	// Tests a box against the planes of a mask, removing the planes it is fully inside of from the mask,
+	// and returns false if the box is outside of a plane
+	auto test_planes = [&planes](const Bounds &bounds, uint32_t &plane_mask) {
+		for (uint32_t i = 0; i < planes.size(); ++i)
+		{
+			if (!(plane_mask & (1 << i)))
+			{
+				continue;
+			}
+
+			glm::vec3 normal{planes[i]};
+
+			// The corners of the box furthest along and against the plane normal
+			auto      facing   = glm::greaterThanEqual(normal, glm::vec3(0.0f));
+			glm::vec3 positive = glm::mix(bounds.min, bounds.max, facing);
+			glm::vec3 negative = glm::mix(bounds.max, bounds.min, facing);
+
+			if (glm::dot(normal, positive) + planes[i].w < 0.0f)
+			{
+				return false;
+			}
+
+			if (glm::dot(normal, negative) + planes[i].w >= 0.0f)
+			{
+				plane_mask &= ~(1 << i);
+			}
+		}
+
+		return true;
+	};
+
+	// Once a node is inside of a plane, so are its descendants
+	constexpr uint32_t ALL_PLANES = (1 << 6) - 1;
+
+	std::vector<std::pair<uint32_t, uint32_t>> stack{{0, ALL_PLANES}};
+
+	while (!stack.empty())
+	{
+		uint32_t node_index = stack.back().first;
+		uint32_t plane_mask = stack.back().second;
+		stack.pop_back();
+
+		auto &node = nodes[node_index];
+
+		if (!test_planes(node.bounds, plane_mask))
+		{
+			continue;
+		}
+
+		if (node.count == 0)
+		{
+			stack.emplace_back(node.offset, plane_mask);
+			stack.emplace_back(node_index + 1, plane_mask);
+			continue;
+		}
+
+		// The primitives of a leaf inside of all the planes are all visible, the others are tested at once
+		uint32_t visible = plane_mask == 0 ? (1U << node.count) - 1 : frustum.check_boxes(leaf_boxes, node.offset, node.count);
+
+		for (uint32_t i = 0; i < node.count; ++i)
+		{
+			if (visible & (1U << i))
+			{
+				primitives.push_back(primitive_indices[node.offset + i]);
+			}
+		}
+	}
+}
+
+void BVH::query_bounds(const Bounds &bounds, std::vector<uint32_t> &primitives) const
+{
+	if (nodes.empty())
+	{
+		return;
+	}
+
+	std::vector<uint32_t> stack{0};
+
+	while (!stack.empty())
+	{
+		uint32_t node_index = stack.back();
+		stack.pop_back();
+
+		auto &node = nodes[node_index];
+
+		if (!node.bounds.overlaps(bounds))
+		{
+			continue;
+		}
+
+		if (node.count == 0)
+		{
+			stack.push_back(node.offset);
+			stack.push_back(node_index + 1);
+			continue;
+		}
+
+		for (uint32_t i = node.offset; i < node.offset + node.count; ++i)
+		{
+			if (leaf_bounds[i].overlaps(bounds))
+			{
+				primitives.push_back(primitive_indices[i]);
+			}
+		}
+	}
+}
+
+bool BVH::query_ray(const glm::vec3 &origin, const glm::vec3 &direction, uint32_t &primitive, float &distance) const
+{
+	glm::vec3 inverse_direction = 1.0f / direction;
+
+	return query_ray(
+	    origin, direction, [&](uint32_t hit_primitive, float max_distance) {
+		    return leaf_bounds[primitive_slots[hit_primitive]].intersect_ray(origin, inverse_direction, max_distance);
+	    },
+	    primitive, distance);
+}
+
+bool BVH::query_ray(const glm::vec3 &origin, const glm::vec3 &direction, const RayIntersectFunc &intersect,
+                    uint32_t &primitive, float &distance, float max_distance) const
+{
+	if (nodes.empty())
+	{
+		return false;
+	}
+
+	glm::vec3 inverse_direction = 1.0f / direction;
+
+	float nearest = max_distance;
+	bool  hit     = false;
+
+	std::vector<uint32_t> stack{0};
+
+	while (!stack.empty())
+	{
+		uint32_t node_index = stack.back();
+		stack.pop_back();
+
+		auto &node = nodes[node_index];
+
+		if (node.bounds.intersect_ray(origin, inverse_direction, nearest) == std::numeric_limits<float>::infinity())
+		{
+			continue;
+		}
+
+		if (node.count == 0)
+		{
+			// Visit the nearest child first, so that the other one is more likely to be skipped
+			uint32_t near_child = node_index + 1;
+			uint32_t far_child  = node.offset;
+
+			if (nodes[far_child].bounds.intersect_ray(origin, inverse_direction, nearest) < nodes[near_child].bounds.intersect_ray(origin, inverse_direction, nearest))
+			{
+				std::swap(near_child, far_child);
+			}
+
+			stack.push_back(far_child);
+			stack.push_back(near_child);
+			continue;
+		}
+
+		for (uint32_t i = node.offset; i < node.offset + node.count; ++i)
+		{
+			if (leaf_bounds[i].intersect_ray(origin, inverse_direction, nearest) == std::numeric_limits<float>::infinity())
+			{
+				continue;
+			}
+
+			float t = intersect(primitive_indices[i], nearest);
+			if (t < nearest)
+			{
+				nearest   = t;
+				primitive = primitive_indices[i];
+				hit       = true;
+			}
+		}
+	}
+
+	distance = nearest;
+
+	return hit;
+}
+
+size_t BVH::get_primitive_count() const
+{
+	return primitive_indices.size();
+}
+
+size_t BVH::get_node_count() const
+{
+	return nodes.size();
+}
+}        // namespace vkb
@@ -0,0 +1,184 @@
+/* Copyright (c) 2020, Arm Limited and Contributors
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 the "License";
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <cstdint>
+#include <functional>
+#include <limits>
+#include <vector>
+
+#include "common/error.h"
+#include "geometry/frustum.h"
+
+VKBP_DISABLE_WARNINGS()
+#include "common/glm_common.h"
+VKBP_ENABLE_WARNINGS()
+
+namespace vkb
+{
+/**
+ * @brief Bounding volume hierarchy over the axis aligned bounds of primitives
+ *
+ * The tree is built top-down with a binned surface area heuristic, large subtrees being
+ * built on the workers of the job system. Nodes are stored depth first, so that the left
+ * child of an interior node follows it. When primitives move, their bounds are refitted
+ * up to the root without rebuilding the tree.
+ */
+class BVH
+{
+  public:
+	/**
+	 * @brief Intersects a ray with a primitive whose bounds it hits
+	 * @param primitive The primitive to test
+	 * @param max_distance Distance of the nearest hit so far, farther hits can be ignored
+	 * @return Distance to the hit along the direction of the ray, or infinity if it misses
+	 */
+	using RayIntersectFunc = std::function<float(uint32_t primitive, float max_distance)>;
+
+	struct Bounds
+	{
+		glm::vec3 min{std::numeric_limits<float>::max()};
+
+		glm::vec3 max{std::numeric_limits<float>::lowest()};
+
+		void expand(const glm::vec3 &point);
+
+		void expand(const Bounds &bounds);
+
+		glm::vec3 get_center() const;
+
+		float get_surface_area() const;
+
+		bool overlaps(const Bounds &bounds) const;
+
+		/**
+		 * @brief Slab test of a ray against the box
+		 * @param origin Origin of the ray
+		 * @param inverse_direction Component-wise inverse of the direction of the ray
+		 * @param max_distance Hits farther than this distance are ignored
+		 * @return Distance to the entry of the ray in the box, or infinity if it misses
+		 */
+		float intersect_ray(const glm::vec3 &origin, const glm::vec3 &inverse_direction, float max_distance) const;
+	};
+
+	/// Primitives of a leaf, below which nodes are not split
+	static constexpr uint32_t MAX_LEAF_SIZE = 4;
+
+	/// Number of bins along the split axis for the surface area heuristic
+	static constexpr uint32_t BIN_COUNT = 16;
+
+	/**
+	 * @brief Builds the tree over the bounds of all primitives
+	 * @param primitive_bounds World space bounds of every primitive, indexed by primitive
+	 */
+	void build(const std::vector<Bounds> &primitive_bounds);
+
+	/**
+	 * @brief Updates the bounds of the nodes above primitives which moved, keeping the tree structure
+	 *        The tree degrades as primitives move away from their neighbours, rebuild it after large changes.
+	 * @param primitive_bounds New bounds of every primitive, same count as at build
+	 * @param changed_primitives Primitives whose bounds changed
+	 */
+	void refit(const std::vector<Bounds> &primitive_bounds, const std::vector<uint32_t> &changed_primitives);
+
+	/**
+	 * @brief Finds the primitives whose bounds intersect a frustum
+	 * @param frustum Frustum to test
+	 * @param primitives Receives the intersecting primitives
+	 */
+	void query_frustum(const Frustum &frustum, std::vector<uint32_t> &primitives) const;
+
+	/**
+	 * @brief Finds the primitives whose bounds overlap a box
+	 * @param bounds Box to test
+	 * @param primitives Receives the overlapping primitives
+	 */
+	void query_bounds(const Bounds &bounds, std::vector<uint32_t> &primitives) const;
+
+	/**
+	 * @brief Finds the nearest primitive whose bounds are hit by a ray
+	 * @param origin Origin of the ray
+	 * @param direction Direction of the ray
+	 * @param primitive Receives the hit primitive
+	 * @param distance Receives the distance to the hit along the direction, in units of its length
+	 * @return True if a primitive is hit
+	 */
+	bool query_ray(const glm::vec3 &origin, const glm::vec3 &direction, uint32_t &primitive, float &distance) const;
+
+	/**
+	 * @brief Finds the nearest primitive hit by a ray, as tested by a function on the primitives whose bounds are hit
+	 *        Nodes are visited nearest first, and nodes farther than the nearest hit so far are skipped.
+	 * @param origin Origin of the ray
+	 * @param direction Direction of the ray
+	 * @param intersect Tests the ray against a primitive
+	 * @param primitive Receives the hit primitive
+	 * @param distance Receives the distance to the hit along the direction, in units of its length
+	 * @param max_distance Hits farther than this distance are ignored
+	 * @return True if a primitive is hit
+	 */
+	bool query_ray(const glm::vec3 &origin, const glm::vec3 &direction, const RayIntersectFunc &intersect,
+	               uint32_t &primitive, float &distance, float max_distance = std::numeric_limits<float>::max()) const;
+
+	size_t get_primitive_count() const;
+
+	size_t get_node_count() const;
+
+  private:
+	struct Node
+	{
+		Bounds bounds;
+
+		/// Index of the right child for interior nodes, or of the first primitive index of a leaf
+		uint32_t offset{0};
+
+		/// Number of primitives of a leaf, 0 for interior nodes
+		uint32_t count{0};
+	};
+
+	/**
+	 * @brief Builds the subtree of a range of primitive indices, appending its nodes depth first
+	 * @return Index of the subtree root in the nodes, relative to their start
+	 */
+	uint32_t build_node(std::vector<Node> &out_nodes, uint32_t first, uint32_t last, uint32_t depth);
+
+	/// Primitive bounds and centroids of the build in progress
+	const std::vector<Bounds> *build_bounds{nullptr};
+
+	std::vector<glm::vec3> build_centroids;
+
+	std::vector<Node> nodes;
+
+	/// Primitives in leaf order
+	std::vector<uint32_t> primitive_indices;
+
+	/// Bounds of the primitives in leaf order
+	std::vector<Bounds> leaf_bounds;
+
+	/// Bounds of the primitives in leaf order as centers and extents, to test a leaf against frustums at once
+	BoxBatch leaf_boxes;
+
+	/// Parent of every node, the root has none
+	std::vector<uint32_t> parent_indices;
+
+	/// Leaf of every primitive
+	std::vector<uint32_t> primitive_leaves;
+
+	/// Position of every primitive in leaf order
+	std::vector<uint32_t> primitive_slots;
+};
+}        // namespace vkb
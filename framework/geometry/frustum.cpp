@@ -17,8 +17,53 @@
 
 #include "frustum.h"
 
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#	define VKB_FRUSTUM_SSE2
+#	include <emmintrin.h>
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__)
+#	define VKB_FRUSTUM_NEON
+#	include <arm_neon.h>
+#endif
+
 namespace vkb
 {
+namespace
+{
+constexpr size_t PLANE_COUNT = 6;
+}        // namespace
+
+void BoxBatch::resize(size_t count)
+{
+	center_x.resize(count);
+	center_y.resize(count);
+	center_z.resize(count);
+	extent_x.resize(count);
+	extent_y.resize(count);
+	extent_z.resize(count);
+}
+
+void BoxBatch::set(size_t index, const glm::vec3 &min, const glm::vec3 &max)
+{
+	glm::vec3 center = (min + max) * 0.5f;
+	glm::vec3 extent = (max - min) * 0.5f;
+
+	center_x[index] = center.x;
+	center_y[index] = center.y;
+	center_z[index] = center.z;
+	extent_x[index] = extent.x;
+	extent_y[index] = extent.y;
+	extent_z[index] = extent.z;
+}
+
+size_t BoxBatch::size() const
+{
+	return center_x.size();
+}
+
 void Frustum::update(const glm::mat4 &matrix)
 {
 	planes[LEFT].x = matrix[0].w + matrix[0].x;
@@ -69,6 +114,145 @@ bool Frustum::check_sphere(glm::vec3 pos, float radius)
 	}
 	return true;
 }
+uint32_t Frustum::check_boxes(const BoxBatch &boxes, size_t first, uint32_t count) const
+{
+	assert(count <= 32 && first + count <= boxes.size() && "Box range is out of bounds");
+
+	// A box is outside of a plane if its center is further behind it than the projection of its extent on the normal
+	uint32_t visible = 0;
+	uint32_t i       = 0;
+
+#if defined(VKB_FRUSTUM_SSE2)
+	__m128 normal_x[PLANE_COUNT], normal_y[PLANE_COUNT], normal_z[PLANE_COUNT], distance[PLANE_COUNT];
+	__m128 abs_normal_x[PLANE_COUNT], abs_normal_y[PLANE_COUNT], abs_normal_z[PLANE_COUNT];
+
+	for (size_t p = 0; p < PLANE_COUNT; ++p)
+	{
+		normal_x[p]     = _mm_set1_ps(planes[p].x);
+		normal_y[p]     = _mm_set1_ps(planes[p].y);
+		normal_z[p]     = _mm_set1_ps(planes[p].z);
+		distance[p]     = _mm_set1_ps(planes[p].w);
+		abs_normal_x[p] = _mm_set1_ps(std::abs(planes[p].x));
+		abs_normal_y[p] = _mm_set1_ps(std::abs(planes[p].y));
+		abs_normal_z[p] = _mm_set1_ps(std::abs(planes[p].z));
+	}
+
+	for (; i + 4 <= count; i += 4)
+	{
+		size_t index = first + i;
+
+		__m128 center_x = _mm_loadu_ps(&boxes.center_x[index]);
+		__m128 center_y = _mm_loadu_ps(&boxes.center_y[index]);
+		__m128 center_z = _mm_loadu_ps(&boxes.center_z[index]);
+		__m128 extent_x = _mm_loadu_ps(&boxes.extent_x[index]);
+		__m128 extent_y = _mm_loadu_ps(&boxes.extent_y[index]);
+		__m128 extent_z = _mm_loadu_ps(&boxes.extent_z[index]);
+
+		__m128 inside = _mm_castsi128_ps(_mm_set1_epi32(-1));
+
+		for (size_t p = 0; p < PLANE_COUNT; ++p)
+		{
+			__m128 center_distance = _mm_add_ps(_mm_add_ps(_mm_mul_ps(normal_x[p], center_x), _mm_mul_ps(normal_y[p], center_y)),
+			                                    _mm_add_ps(_mm_mul_ps(normal_z[p], center_z), distance[p]));
+			__m128 radius          = _mm_add_ps(_mm_add_ps(_mm_mul_ps(abs_normal_x[p], extent_x), _mm_mul_ps(abs_normal_y[p], extent_y)),
+			                                    _mm_mul_ps(abs_normal_z[p], extent_z));
+
+			inside = _mm_and_ps(inside, _mm_cmpge_ps(_mm_add_ps(center_distance, radius), _mm_setzero_ps()));
+		}
+
+		visible |= static_cast<uint32_t>(_mm_movemask_ps(inside)) << i;
+	}
+#elif defined(VKB_FRUSTUM_NEON)
+	float32x4_t normal_x[PLANE_COUNT], normal_y[PLANE_COUNT], normal_z[PLANE_COUNT], distance[PLANE_COUNT];
+	float32x4_t abs_normal_x[PLANE_COUNT], abs_normal_y[PLANE_COUNT], abs_normal_z[PLANE_COUNT];
+
+	for (size_t p = 0; p < PLANE_COUNT; ++p)
+	{
+		normal_x[p]     = vdupq_n_f32(planes[p].x);
+		normal_y[p]     = vdupq_n_f32(planes[p].y);
+		normal_z[p]     = vdupq_n_f32(planes[p].z);
+		distance[p]     = vdupq_n_f32(planes[p].w);
+		abs_normal_x[p] = vdupq_n_f32(std::abs(planes[p].x));
+		abs_normal_y[p] = vdupq_n_f32(std::abs(planes[p].y));
+		abs_normal_z[p] = vdupq_n_f32(std::abs(planes[p].z));
+	}
+
+	const uint32_t    lane_bit_values[4] = {1, 2, 4, 8};
+	const uint32x4_t  lane_bits          = vld1q_u32(lane_bit_values);
+	const float32x4_t zero               = vdupq_n_f32(0.0f);
+
+	for (; i + 4 <= count; i += 4)
+	{
+		size_t index = first + i;
+
+		float32x4_t center_x = vld1q_f32(&boxes.center_x[index]);
+		float32x4_t center_y = vld1q_f32(&boxes.center_y[index]);
+		float32x4_t center_z = vld1q_f32(&boxes.center_z[index]);
+		float32x4_t extent_x = vld1q_f32(&boxes.extent_x[index]);
+		float32x4_t extent_y = vld1q_f32(&boxes.extent_y[index]);
+		float32x4_t extent_z = vld1q_f32(&boxes.extent_z[index]);
+
+		uint32x4_t inside = vdupq_n_u32(~0U);
+
+		for (size_t p = 0; p < PLANE_COUNT; ++p)
+		{
+			float32x4_t side = vmlaq_f32(distance[p], normal_x[p], center_x);
+			side             = vmlaq_f32(side, normal_y[p], center_y);
+			side             = vmlaq_f32(side, normal_z[p], center_z);
+			side             = vmlaq_f32(side, abs_normal_x[p], extent_x);
+			side             = vmlaq_f32(side, abs_normal_y[p], extent_y);
+			side             = vmlaq_f32(side, abs_normal_z[p], extent_z);
+
+			inside = vandq_u32(inside, vcgeq_f32(side, zero));
+		}
+
+		// Gathers a bit per lane, with pairwise additions available on both ARMv7 and AArch64
+		uint32x4_t bits = vandq_u32(inside, lane_bits);
+		uint32x2_t sum  = vadd_u32(vget_low_u32(bits), vget_high_u32(bits));
+		sum             = vpadd_u32(sum, sum);
+
+		visible |= vget_lane_u32(sum, 0) << i;
+	}
+#endif
+
+	// Boxes left over by the vector loop, or all of them without SIMD
+	for (; i < count; ++i)
+	{
+		size_t index = first + i;
+
+		bool inside = true;
+
+		for (size_t p = 0; p < PLANE_COUNT && inside; ++p)
+		{
+			float center_distance = planes[p].x * boxes.center_x[index] + planes[p].y * boxes.center_y[index] + planes[p].z * boxes.center_z[index] + planes[p].w;
+			float radius          = std::abs(planes[p].x) * boxes.extent_x[index] + std::abs(planes[p].y) * boxes.extent_y[index] + std::abs(planes[p].z) * boxes.extent_z[index];
+
+			inside = center_distance + radius >= 0.0f;
+		}
+
+		if (inside)
+		{
+			visible |= 1U << i;
+		}
+	}
+
+	return visible;
+}
+
+void Frustum::check_boxes(const BoxBatch &boxes, std::vector<uint64_t> &visibility) const
+{
+	size_t count = boxes.size();
+
+	visibility.assign((count + 63) / 64, 0);
+
+	for (size_t first = 0; first < count; first += 32)
+	{
+		uint32_t mask = check_boxes(boxes, first, static_cast<uint32_t>(std::min<size_t>(32, count - first)));
+
+		visibility[first / 64] |= static_cast<uint64_t>(mask) << (first % 64);
+	}
+}
+
 const std::array<glm::vec4, 6> &Frustum::get_planes() const
 {
 	return planes;
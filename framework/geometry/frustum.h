@@ -15,7 +15,11 @@
  * limitations under the License.
  */
 
+#pragma once
+
 #include <array>
+#include <cstdint>
+#include <vector>
 
 #include "common/error.h"
 
@@ -35,6 +39,37 @@ enum Side
 	FRONT  = 5
 };
 
+/**
+ * @brief Axis aligned boxes stored as a structure of arrays, so that a Frustum can test several of them at once
+ */
+struct BoxBatch
+{
+	std::vector<float> center_x;
+
+	std::vector<float> center_y;
+
+	std::vector<float> center_z;
+
+	/// Half of the size of the boxes along each axis
+	std::vector<float> extent_x;
+
+	std::vector<float> extent_y;
+
+	std::vector<float> extent_z;
+
+	void resize(size_t count);
+
+	/**
+	 * @brief Sets a box from its corners
+	 * @param index Index of the box
+	 * @param min The corner with the smallest coordinates
+	 * @param max The corner with the largest coordinates
+	 */
+	void set(size_t index, const glm::vec3 &min, const glm::vec3 &max);
+
+	size_t size() const;
+};
+
 /**
  * @brief Represents a matrix by extracting its planes. Responsible for doing 
  * intersection tests
@@ -55,6 +90,22 @@ class Frustum
 	 */
 	bool check_sphere(glm::vec3 pos, float radius);
 
+	/**
+	 * @brief Checks a range of boxes against the Frustum, four at a time with SSE2 or NEON
+	 * @param boxes The boxes to test
+	 * @param first Index of the first box of the range
+	 * @param count Number of boxes in the range, at most 32
+	 * @return A mask with bit i set if the box first + i intersects the Frustum
+	 */
+	uint32_t check_boxes(const BoxBatch &boxes, size_t first, uint32_t count) const;
+
+	/**
+	 * @brief Checks all the boxes of a batch against the Frustum
+	 * @param boxes The boxes to test
+	 * @param visibility Receives a bit per box, set if the box intersects the Frustum, 64 boxes per word
+	 */
+	void check_boxes(const BoxBatch &boxes, std::vector<uint64_t> &visibility) const;
+
 	const std::array<glm::vec4, 6> &get_planes() const;
 
   private:
@@ -0,0 +1,659 @@
+/* Copyright (c) 2020, Arm Limited and Contributors
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 the "License";
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "geometry/mesh_optimizer.h"
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstring>
+#include <limits>
+#include <set>
+#include <unordered_map>
+
+VKBP_DISABLE_WARNINGS()
+#include <glm/gtc/packing.hpp>
+VKBP_ENABLE_WARNINGS()
+
+#include "common/helpers.h"
+
+namespace vkb
+{
+namespace
+{
+/// Size of the cache modelled when scoring vertices
+constexpr size_t SCORING_CACHE_SIZE = 32;
+
+/// Size of the FIFO cache used to count the vertices transformed
+constexpr size_t FIFO_CACHE_SIZE = 16;
+
+float get_vertex_score(int32_t cache_position, uint32_t remaining_triangles)
+{
+	if (remaining_triangles == 0)
+	{
+		return -1.0f;
+	}
+
+	float score = 0.0f;
+
+	if (cache_position >= 0)
+	{
+		if (cache_position < 3)
+		{
+			// The vertices of the last triangle score the same, so that the next one may use any edge
+			score = 0.75f;
+		}
+		else
+		{
+			score = std::pow(1.0f - static_cast<float>(cache_position - 3) / (SCORING_CACHE_SIZE - 3), 1.5f);
+		}
+	}
+
+	// Favour vertices with few triangles left, so that they leave the cache for good
+	return score + 2.0f / std::sqrt(static_cast<float>(remaining_triangles));
+}
+
+/**
+ * @brief FIFO post-transform vertex cache, a vertex is evicted once as many misses as the cache size followed it
+ */
+class FifoCache
+{
+  public:
+	FifoCache(size_t vertex_count) :
+	    timestamps(vertex_count, 0)
+	{}
+
+	/// @return The number of vertices of the triangle that were not in the cache
+	uint32_t access(const uint32_t *triangle)
+	{
+		uint32_t misses = 0;
+
+		for (size_t i = 0; i < 3; ++i)
+		{
+			if (time - timestamps[triangle[i]] > FIFO_CACHE_SIZE)
+			{
+				timestamps[triangle[i]] = time++;
+				++misses;
+			}
+		}
+
+		return misses;
+	}
+
+	void reset()
+	{
+		time += FIFO_CACHE_SIZE + 1;
+	}
+
+  private:
+	std::vector<size_t> timestamps;
+
+	size_t time{FIFO_CACHE_SIZE + 1};
+};
+
+void quantize_normals(VertexStream &stream, size_t vertex_count)
+{
+	std::vector<uint8_t> data(vertex_count * sizeof(uint32_t));
+
+	for (size_t i = 0; i < vertex_count; ++i)
+	{
+		glm::vec3 normal;
+		std::memcpy(&normal, stream.data.data() + i * stream.stride, sizeof(normal));
+
+		uint32_t packed = glm::packSnorm4x8(glm::vec4(normal, 0.0f));
+		std::memcpy(data.data() + i * sizeof(uint32_t), &packed, sizeof(uint32_t));
+	}
+
+	stream.format = VK_FORMAT_R8G8B8A8_SNORM;
+	stream.stride = sizeof(uint32_t);
+	stream.data.swap(data);
+}
+
+void quantize_texcoords(VertexStream &stream, size_t vertex_count)
+{
+	std::vector<uint8_t> data(vertex_count * sizeof(uint32_t));
+
+	for (size_t i = 0; i < vertex_count; ++i)
+	{
+		glm::vec2 texcoord;
+		std::memcpy(&texcoord, stream.data.data() + i * stream.stride, sizeof(texcoord));
+
+		uint32_t packed = glm::packHalf2x16(texcoord);
+		std::memcpy(data.data() + i * sizeof(uint32_t), &packed, sizeof(uint32_t));
+	}
+
+	stream.format = VK_FORMAT_R16G16_SFLOAT;
+	stream.stride = sizeof(uint32_t);
+	stream.data.swap(data);
+}
+}        // namespace
+
+void optimize_vertex_cache(std::vector<uint32_t> &indices, size_t vertex_count)
+{
+	const size_t triangle_count = indices.size() / 3;
+
+	if (triangle_count == 0)
+	{
+		return;
+	}
+
+	// The triangles using each vertex, the ones not emitted yet come first
+	std::vector<uint32_t> remaining(vertex_count, 0);
+
+	for (size_t i = 0; i < triangle_count * 3; ++i)
+	{
+		++remaining[indices[i]];
+	}
+
+	std::vector<uint32_t> offsets(vertex_count + 1, 0);
+
+	for (size_t v = 0; v < vertex_count; ++v)
+	{
+		offsets[v + 1] = offsets[v] + remaining[v];
+	}
+
+	std::vector<uint32_t> adjacency(triangle_count * 3);
+	std::vector<uint32_t> fill(offsets.begin(), offsets.end() - 1);
+
+	for (size_t i = 0; i < triangle_count * 3; ++i)
+	{
+		adjacency[fill[indices[i]]++] = to_u32(i / 3);
+	}
+
+	std::vector<int32_t> cache_positions(vertex_count, -1);
+	std::vector<float>   vertex_scores(vertex_count);
+
+	for (size_t v = 0; v < vertex_count; ++v)
+	{
+		vertex_scores[v] = get_vertex_score(-1, remaining[v]);
+	}
+
+	auto get_triangle_score = [&](uint32_t triangle) {
+		return vertex_scores[indices[triangle * 3]] + vertex_scores[indices[triangle * 3 + 1]] + vertex_scores[indices[triangle * 3 + 2]];
+	};
+
+	uint32_t best_triangle = 0;
+	float    best_score    = get_triangle_score(0);
+
+	for (uint32_t t = 1; t < triangle_count; ++t)
+	{
+		float score = get_triangle_score(t);
+		if (score > best_score)
+		{
+			best_triangle = t;
+			best_score    = score;
+		}
+	}
+
+	bool has_best = true;
+
+	std::vector<bool> emitted(triangle_count, false);
+
+	// When no triangle uses the cached vertices, the next one is found by scanning from the last one found
+	size_t scan_cursor = 0;
+
+	std::vector<uint32_t> cache;
+	std::vector<uint32_t> next_cache;
+	cache.reserve(SCORING_CACHE_SIZE + 3);
+	next_cache.reserve(SCORING_CACHE_SIZE + 3);
+
+	std::vector<uint32_t> result;
+	result.reserve(triangle_count * 3);
+
+	while (result.size() < triangle_count * 3)
+	{
+		if (!has_best)
+		{
+			while (emitted[scan_cursor])
+			{
+				++scan_cursor;
+			}
+
+			best_triangle = to_u32(scan_cursor);
+		}
+
+		emitted[best_triangle] = true;
+
+		next_cache.clear();
+
+		for (size_t i = 0; i < 3; ++i)
+		{
+			uint32_t vertex = indices[best_triangle * 3 + i];
+			result.push_back(vertex);
+
+			// Move the triangle past the ones remaining for the vertex
+			auto begin = adjacency.begin() + offsets[vertex];
+			auto end   = begin + remaining[vertex];
+			std::iter_swap(std::find(begin, end, best_triangle), end - 1);
+			--remaining[vertex];
+
+			if (std::find(next_cache.begin(), next_cache.end(), vertex) == next_cache.end())
+			{
+				next_cache.push_back(vertex);
+			}
+		}
+
+		for (auto vertex : cache)
+		{
+			if (std::find(next_cache.begin(), next_cache.end(), vertex) == next_cache.end())
+			{
+				next_cache.push_back(vertex);
+			}
+		}
+
+		// Rescore the cached vertices, and the ones which were just pushed out of the cache
+		for (size_t i = 0; i < next_cache.size(); ++i)
+		{
+			uint32_t vertex         = next_cache[i];
+			cache_positions[vertex] = i < SCORING_CACHE_SIZE ? static_cast<int32_t>(i) : -1;
+			vertex_scores[vertex]   = get_vertex_score(cache_positions[vertex], remaining[vertex]);
+		}
+
+		has_best = false;
+
+		for (auto vertex : next_cache)
+		{
+			for (uint32_t i = offsets[vertex]; i < offsets[vertex] + remaining[vertex]; ++i)
+			{
+				float score = get_triangle_score(adjacency[i]);
+				if (!has_best || score > best_score)
+				{
+					best_triangle = adjacency[i];
+					best_score    = score;
+					has_best      = true;
+				}
+			}
+		}
+
+		next_cache.resize(std::min(next_cache.size(), SCORING_CACHE_SIZE));
+		std::swap(cache, next_cache);
+	}
+
+	indices.swap(result);
+}
+
+void optimize_overdraw(std::vector<uint32_t> &indices, const std::vector<glm::vec3> &positions, float threshold)
+{
+	const size_t triangle_count = indices.size() / 3;
+
+	if (triangle_count == 0)
+	{
+		return;
+	}
+
+	FifoCache cache{positions.size()};
+
+	// Hard boundaries are where the order starts over, with no vertex of a triangle in the cache
+	std::vector<size_t> hard_boundaries;
+
+	for (size_t t = 0; t < triangle_count; ++t)
+	{
+		if (cache.access(&indices[t * 3]) == 3 || t == 0)
+		{
+			hard_boundaries.push_back(t);
+		}
+	}
+
+	hard_boundaries.push_back(triangle_count);
+
+	// Soft boundaries split the hard clusters where starting with an empty cache keeps the miss ratio within the threshold
+	std::vector<size_t> boundaries;
+
+	for (size_t c = 0; c + 1 < hard_boundaries.size(); ++c)
+	{
+		size_t begin = hard_boundaries[c];
+		size_t end   = hard_boundaries[c + 1];
+
+		cache.reset();
+
+		size_t cluster_misses = 0;
+		for (size_t t = begin; t < end; ++t)
+		{
+			cluster_misses += cache.access(&indices[t * 3]);
+		}
+
+		float max_ratio = threshold * cluster_misses / (end - begin);
+
+		cache.reset();
+		boundaries.push_back(begin);
+
+		size_t start  = begin;
+		size_t misses = 0;
+		for (size_t t = begin; t + 1 < end; ++t)
+		{
+			misses += cache.access(&indices[t * 3]);
+
+			if (misses <= max_ratio * (t + 1 - start))
+			{
+				boundaries.push_back(t + 1);
+
+				start  = t + 1;
+				misses = 0;
+				cache.reset();
+			}
+		}
+	}
+
+	boundaries.push_back(triangle_count);
+
+	glm::vec3 mesh_center{0.0f};
+	for (size_t i = 0; i < triangle_count * 3; ++i)
+	{
+		mesh_center += positions[indices[i]];
+	}
+	mesh_center /= static_cast<float>(triangle_count * 3);
+
+	struct Cluster
+	{
+		size_t begin;
+
+		size_t end;
+
+		float sort_key;
+	};
+
+	std::vector<Cluster> clusters;
+	clusters.reserve(boundaries.size() - 1);
+
+	for (size_t c = 0; c + 1 < boundaries.size(); ++c)
+	{
+		glm::vec3 center{0.0f};
+		glm::vec3 normal{0.0f};
+		float     area{0.0f};
+
+		for (size_t t = boundaries[c]; t < boundaries[c + 1]; ++t)
+		{
+			const auto &p0 = positions[indices[t * 3]];
+			const auto &p1 = positions[indices[t * 3 + 1]];
+			const auto &p2 = positions[indices[t * 3 + 2]];
+
+			glm::vec3 triangle_normal = glm::cross(p1 - p0, p2 - p0);
+			float     triangle_area   = glm::length(triangle_normal);
+
+			center += (p0 + p1 + p2) * (triangle_area / 3.0f);
+			normal += triangle_normal;
+			area += triangle_area;
+		}
+
+		float sort_key = 0.0f;
+
+		// Clusters facing away from the center of the mesh are likely to occlude the other ones
+		if (area > 0.0f && glm::length(normal) > 0.0f)
+		{
+			sort_key = glm::dot(center / area - mesh_center, glm::normalize(normal));
+		}
+
+		clusters.push_back({boundaries[c], boundaries[c + 1], sort_key});
+	}
+
+	std::stable_sort(clusters.begin(), clusters.end(), [](const Cluster &a, const Cluster &b) {
+		return a.sort_key > b.sort_key;
+	});
+
+	std::vector<uint32_t> result;
+	result.reserve(triangle_count * 3);
+
+	for (auto &cluster : clusters)
+	{
+		result.insert(result.end(), indices.begin() + cluster.begin * 3, indices.begin() + cluster.end * 3);
+	}
+
+	indices.swap(result);
+}
+
+std::vector<uint32_t> optimize_vertex_fetch(std::vector<uint32_t> &indices, size_t vertex_count)
+{
+	std::vector<uint32_t> remap(vertex_count, std::numeric_limits<uint32_t>::max());
+
+	std::vector<uint32_t> order;
+	order.reserve(vertex_count);
+
+	for (auto &index : indices)
+	{
+		if (remap[index] == std::numeric_limits<uint32_t>::max())
+		{
+			remap[index] = to_u32(order.size());
+			order.push_back(index);
+		}
+
+		index = remap[index];
+	}
+
+	return order;
+}
+
+float get_vertex_cache_miss_ratio(const std::vector<uint32_t> &indices, size_t vertex_count)
+{
+	const size_t triangle_count = indices.size() / 3;
+
+	if (triangle_count == 0)
+	{
+		return 0.0f;
+	}
+
+	FifoCache cache{vertex_count};
+
+	size_t misses = 0;
+	for (size_t t = 0; t < triangle_count; ++t)
+	{
+		misses += cache.access(&indices[t * 3]);
+	}
+
+	return static_cast<float>(misses) / triangle_count;
+}
+
+std::vector<uint32_t> simplify_mesh(const std::vector<uint32_t> &indices, const std::vector<glm::vec3> &positions, float cell_size, float &error)
+{
+	error = 0.0f;
+
+	glm::vec3 min{std::numeric_limits<float>::max()};
+
+	for (auto index : indices)
+	{
+		min = glm::min(min, positions[index]);
+	}
+
+	// Cells are keyed by their packed coordinates, 21 bits per axis
+	auto get_cell = [&](uint32_t index) {
+		glm::uvec3 cell{glm::clamp((positions[index] - min) / cell_size, glm::vec3{0.0f}, glm::vec3{2097151.0f})};
+
+		return (uint64_t{cell.x} << 42) | (uint64_t{cell.y} << 21) | uint64_t{cell.z};
+	};
+
+	std::unordered_map<uint64_t, std::pair<glm::vec3, uint32_t>> cell_sums;
+
+	for (auto index : indices)
+	{
+		auto &sum = cell_sums[get_cell(index)];
+		sum.first += positions[index];
+		sum.second++;
+	}
+
+	// The vertex closest to the average of its cell represents it, so that no new vertex is needed
+	std::unordered_map<uint64_t, std::pair<uint32_t, float>> representatives;
+
+	for (auto index : indices)
+	{
+		auto  cell     = get_cell(index);
+		auto &sum      = cell_sums[cell];
+		float distance = glm::distance(positions[index], sum.first / static_cast<float>(sum.second));
+
+		auto it = representatives.find(cell);
+
+		if (it == representatives.end())
+		{
+			representatives.emplace(cell, std::make_pair(index, distance));
+		}
+		else if (distance < it->second.second)
+		{
+			it->second = std::make_pair(index, distance);
+		}
+	}
+
+	std::unordered_map<uint32_t, uint32_t> remap;
+
+	for (auto index : indices)
+	{
+		auto representative = representatives[get_cell(index)].first;
+
+		if (remap.emplace(index, representative).second)
+		{
+			error = std::max(error, glm::distance(positions[index], positions[representative]));
+		}
+	}
+
+	std::vector<uint32_t> simplified;
+	simplified.reserve(indices.size());
+
+	std::set<std::array<uint32_t, 3>> triangles;
+
+	for (size_t i = 0; i + 2 < indices.size(); i += 3)
+	{
+		std::array<uint32_t, 3> triangle{remap[indices[i]], remap[indices[i + 1]], remap[indices[i + 2]]};
+
+		if (triangle[0] == triangle[1] || triangle[1] == triangle[2] || triangle[2] == triangle[0])
+		{
+			continue;
+		}
+
+		// Rotated to start with its smallest index, keeping its winding, so that duplicates compare equal
+		std::rotate(triangle.begin(), std::min_element(triangle.begin(), triangle.end()), triangle.end());
+
+		if (triangles.insert(triangle).second)
+		{
+			simplified.insert(simplified.end(), triangle.begin(), triangle.end());
+		}
+	}
+
+	return simplified;
+}
+
+std::vector<MeshLod> generate_lods(const std::vector<uint32_t> &indices, const std::vector<glm::vec3> &positions, const MeshOptimizationOptions &options)
+{
+	std::vector<MeshLod> lods;
+
+	if (indices.empty())
+	{
+		return lods;
+	}
+
+	glm::vec3 min{std::numeric_limits<float>::max()};
+	glm::vec3 max{std::numeric_limits<float>::lowest()};
+
+	for (auto index : indices)
+	{
+		min = glm::min(min, positions[index]);
+		max = glm::max(max, positions[index]);
+	}
+
+	float extent = std::max(max.x - min.x, std::max(max.y - min.y, max.z - min.z));
+
+	if (extent <= 0.0f)
+	{
+		return lods;
+	}
+
+	// Coarser levels use coarser grids, the resolution only ever decreases
+	uint32_t resolution = 1024;
+
+	while (lods.size() < options.lod_count && resolution > 1)
+	{
+		const auto &previous = lods.empty() ? indices : lods.back().indices;
+
+		auto target = static_cast<size_t>(previous.size() * options.lod_reduction);
+
+		MeshLod lod;
+
+		do
+		{
+			resolution /= 2;
+			lod.indices = simplify_mesh(previous, positions, extent / resolution, lod.error);
+		} while (lod.indices.size() > target && resolution > 1);
+
+		if (lod.indices.empty() || lod.indices.size() >= previous.size())
+		{
+			break;
+		}
+
+		// Levels are simplified from the previous one, so their errors add up
+		if (!lods.empty())
+		{
+			lod.error += lods.back().error;
+		}
+
+		if (options.vertex_cache)
+		{
+			optimize_vertex_cache(lod.indices, positions.size());
+		}
+
+		lods.push_back(std::move(lod));
+	}
+
+	return lods;
+}
+
+void optimize_mesh(std::vector<uint32_t> &indices, std::map<std::string, VertexStream> &streams, uint32_t &vertex_count, const MeshOptimizationOptions &options)
+{
+	if (options.vertex_cache)
+	{
+		optimize_vertex_cache(indices, vertex_count);
+	}
+
+	if (options.overdraw)
+	{
+		std::vector<glm::vec3> positions(vertex_count);
+		std::memcpy(positions.data(), streams.at("position").data.data(), vertex_count * sizeof(glm::vec3));
+
+		optimize_overdraw(indices, positions, options.overdraw_threshold);
+	}
+
+	if (options.vertex_fetch)
+	{
+		auto order = optimize_vertex_fetch(indices, vertex_count);
+
+		for (auto &stream : streams)
+		{
+			auto &stride = stream.second.stride;
+
+			std::vector<uint8_t> data(order.size() * stride);
+			for (size_t i = 0; i < order.size(); ++i)
+			{
+				std::memcpy(data.data() + i * stride, stream.second.data.data() + order[i] * stride, stride);
+			}
+
+			stream.second.data.swap(data);
+		}
+
+		vertex_count = to_u32(order.size());
+	}
+
+	if (options.quantize)
+	{
+		for (auto &stream : streams)
+		{
+			if (stream.first == "normal" && stream.second.format == VK_FORMAT_R32G32B32_SFLOAT)
+			{
+				quantize_normals(stream.second, vertex_count);
+			}
+			else if (stream.first.compare(0, 9, "texcoord_") == 0 && stream.second.format == VK_FORMAT_R32G32_SFLOAT)
+			{
+				quantize_texcoords(stream.second, vertex_count);
+			}
+		}
+	}
+}
+}        // namespace vkb
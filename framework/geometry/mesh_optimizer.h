@@ -0,0 +1,156 @@
+/* Copyright (c) 2020, Arm Limited and Contributors
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 the "License";
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <cstdint>
+#include <map>
+#include <string>
+#include <vector>
+
+#include "common/error.h"
+
+VKBP_DISABLE_WARNINGS()
+#include "common/glm_common.h"
+VKBP_ENABLE_WARNINGS()
+
+#include "common/vk_common.h"
+
+namespace vkb
+{
+/**
+ * @brief Selects the load-time optimizations applied to indexed triangle meshes
+ */
+struct MeshOptimizationOptions
+{
+	/// Reorders triangles so that post-transform vertex cache hits are more likely
+	bool vertex_cache{false};
+
+	/// Reorders clusters of triangles so that outward facing ones are drawn first
+	bool overdraw{false};
+
+	/// Reorders vertices in the order they are first referenced by the indices
+	bool vertex_fetch{false};
+
+	/// Stores normals as snorm bytes and texture coordinates as half floats
+	bool quantize{false};
+
+	/// How much worse the vertex cache miss ratio may get when reordering for overdraw
+	float overdraw_threshold{1.05f};
+
+	/// Number of coarser levels of detail simplified from every mesh, each drawing the same vertices
+	uint32_t lod_count{0};
+
+	/// Target ratio of the triangles of a level of detail to those of the previous level
+	float lod_reduction{0.5f};
+
+	/// Caches the optimized meshes in the temporary directory
+	bool cache{true};
+
+	bool enabled() const
+	{
+		return vertex_cache || overdraw || vertex_fetch || quantize || lod_count > 0;
+	}
+};
+
+/**
+ * @brief The triangles of a simplified level of detail of a mesh
+ */
+struct MeshLod
+{
+	/// Triangle list referencing the vertices of the full mesh
+	std::vector<uint32_t> indices;
+
+	/// Largest distance a vertex was moved by the simplification, in the units of the positions
+	float error{0.0f};
+};
+
+/**
+ * @brief A tightly packed vertex attribute of a mesh
+ */
+struct VertexStream
+{
+	VkFormat format{VK_FORMAT_UNDEFINED};
+
+	uint32_t stride{0};
+
+	std::vector<uint8_t> data;
+};
+
+/**
+ * @brief Reorders the triangles of a mesh for the post-transform vertex cache
+ *        Implements Tom Forsyth's linear-speed vertex cache optimisation
+ * @param indices The triangle list to reorder
+ * @param vertex_count The number of vertices referenced by the indices
+ */
+void optimize_vertex_cache(std::vector<uint32_t> &indices, size_t vertex_count);
+
+/**
+ * @brief Reorders clusters of triangles to reduce overdraw, keeping each cluster in its vertex cache order
+ *        Clusters start where the cache miss ratio of the order is within the threshold, and are sorted
+ *        so that the ones facing away from the center of the mesh are drawn first
+ * @param indices The triangle list to reorder, optimized for the vertex cache beforehand
+ * @param positions Tightly packed vertex positions
+ * @param threshold How much worse the vertex cache miss ratio may get
+ */
+void optimize_overdraw(std::vector<uint32_t> &indices, const std::vector<glm::vec3> &positions, float threshold);
+
+/**
+ * @brief Renumbers the vertices in the order they are first referenced, dropping the unused ones
+ * @param indices The triangle list, whose indices are remapped
+ * @param vertex_count The number of vertices referenced by the indices
+ * @return For each new vertex, the index of the vertex it was before
+ */
+std::vector<uint32_t> optimize_vertex_fetch(std::vector<uint32_t> &indices, size_t vertex_count);
+
+/**
+ * @brief Simulates a FIFO post-transform vertex cache
+ * @return The average number of vertices transformed per triangle
+ */
+float get_vertex_cache_miss_ratio(const std::vector<uint32_t> &indices, size_t vertex_count);
+
+/**
+ * @brief Simplifies a triangle list by clustering its vertices on a uniform grid
+ *        Every vertex collapses onto the vertex of its cell closest to the average of the cell,
+ *        and the triangles left degenerate or duplicated are removed.
+ * @param indices The triangle list
+ * @param positions Tightly packed vertex positions
+ * @param cell_size Size of the grid cells
+ * @param error Receives the largest distance a vertex moved
+ * @return The simplified triangle list, referencing the same vertices
+ */
+std::vector<uint32_t> simplify_mesh(const std::vector<uint32_t> &indices, const std::vector<glm::vec3> &positions, float cell_size, float &error);
+
+/**
+ * @brief Generates coarser levels of detail of a triangle list, each about lod_reduction times smaller than the previous
+ *        Generation stops early when the mesh can't be simplified further.
+ * @param indices The triangle list of the full mesh
+ * @param positions Tightly packed vertex positions
+ * @param options Number of levels and reduction between levels, vertex cache optimization is applied to every level when enabled
+ * @return The levels of detail from finest to coarsest
+ */
+std::vector<MeshLod> generate_lods(const std::vector<uint32_t> &indices, const std::vector<glm::vec3> &positions, const MeshOptimizationOptions &options);
+
+/**
+ * @brief Applies the enabled optimizations to an indexed triangle mesh
+ * @param indices The triangle list
+ * @param streams The vertex attributes by name, with a R32G32B32_SFLOAT "position"
+ * @param vertex_count The number of vertices, updated if unused vertices were dropped
+ * @param options The optimizations to apply
+ */
+void optimize_mesh(std::vector<uint32_t> &indices, std::map<std::string, VertexStream> &streams, uint32_t &vertex_count, const MeshOptimizationOptions &options);
+}        // namespace vkb
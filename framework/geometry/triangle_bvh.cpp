@@ -0,0 +1,114 @@
+/* Copyright (c) 2020, Arm Limited and Contributors
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 the "License";
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "triangle_bvh.h"
+
+#include <cmath>
+
+namespace vkb
+{
+namespace
+{
+/**
+ * @brief Intersects a ray with a triangle with the Möller-Trumbore algorithm
+ * @return Distance to the hit along the direction, or infinity if the ray misses or the hit is behind its origin
+ */
+float intersect_triangle(const glm::vec3 &origin, const glm::vec3 &direction, const glm::vec3 &v0, const glm::vec3 &v1, const glm::vec3 &v2)
+{
+	const float epsilon = 1e-9f;
+	const float miss    = std::numeric_limits<float>::infinity();
+
+	glm::vec3 edge1 = v1 - v0;
+	glm::vec3 edge2 = v2 - v0;
+
+	glm::vec3 p           = glm::cross(direction, edge2);
+	float     determinant = glm::dot(edge1, p);
+
+	// Parallel to the plane of the triangle, or degenerate triangle
+	if (std::abs(determinant) < epsilon)
+	{
+		return miss;
+	}
+
+	float inverse_determinant = 1.0f / determinant;
+
+	glm::vec3 s = origin - v0;
+	float     u = glm::dot(s, p) * inverse_determinant;
+	if (u < 0.0f || u > 1.0f)
+	{
+		return miss;
+	}
+
+	glm::vec3 q = glm::cross(s, edge1);
+	float     v = glm::dot(direction, q) * inverse_determinant;
+	if (v < 0.0f || u + v > 1.0f)
+	{
+		return miss;
+	}
+
+	float t = glm::dot(edge2, q) * inverse_determinant;
+
+	return t >= 0.0f ? t : miss;
+}
+}        // namespace
+
+void TriangleBVH::build(std::vector<glm::vec3> &&positions, std::vector<uint32_t> &&indices)
+{
+	this->positions = std::move(positions);
+	this->indices   = std::move(indices);
+
+	// Drops the indices of an incomplete last triangle
+	this->indices.resize(this->indices.size() - this->indices.size() % 3);
+
+	std::vector<BVH::Bounds> triangle_bounds(get_triangle_count());
+
+	for (size_t triangle = 0; triangle < triangle_bounds.size(); ++triangle)
+	{
+		for (size_t corner = 0; corner < 3; ++corner)
+		{
+			triangle_bounds[triangle].expand(this->positions[this->indices[triangle * 3 + corner]]);
+		}
+	}
+
+	bvh.build(triangle_bounds);
+}
+
+bool TriangleBVH::intersect(const glm::vec3 &origin, const glm::vec3 &direction, float &distance, uint32_t &triangle, float max_distance) const
+{
+	return bvh.query_ray(
+	    origin, direction, [&](uint32_t primitive, float) {
+		    const uint32_t *corners = &indices[primitive * 3];
+		    return intersect_triangle(origin, direction, positions[corners[0]], positions[corners[1]], positions[corners[2]]);
+	    },
+	    triangle, distance, max_distance);
+}
+
+size_t TriangleBVH::get_triangle_count() const
+{
+	return indices.size() / 3;
+}
+
+const std::vector<glm::vec3> &TriangleBVH::get_positions() const
+{
+	return positions;
+}
+
+const std::vector<uint32_t> &TriangleBVH::get_indices() const
+{
+	return indices;
+}
+}        // namespace vkb
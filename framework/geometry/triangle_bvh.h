@@ -0,0 +1,68 @@
+/* Copyright (c) 2020, Arm Limited and Contributors
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 the "License";
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+#include "geometry/bvh.h"
+
+namespace vkb
+{
+/**
+ * @brief CPU copy of the triangles of a mesh with a BVH over them, to cast rays against the exact geometry
+ *
+ * The positions and indices are kept in the local space of the mesh, rays in world space have to be
+ * transformed by the inverse world matrix of the instance before being cast.
+ */
+class TriangleBVH
+{
+  public:
+	/**
+	 * @brief Copies the triangles and builds the BVH over their bounds
+	 * @param positions Vertex positions
+	 * @param indices Vertex indices, three per triangle
+	 */
+	void build(std::vector<glm::vec3> &&positions, std::vector<uint32_t> &&indices);
+
+	/**
+	 * @brief Finds the nearest triangle hit by a ray, from either side
+	 * @param origin Origin of the ray
+	 * @param direction Direction of the ray
+	 * @param distance Receives the distance to the hit along the direction, in units of its length
+	 * @param triangle Receives the hit triangle, its vertex indices start at three times it
+	 * @param max_distance Hits farther than this distance are ignored
+	 * @return True if a triangle is hit
+	 */
+	bool intersect(const glm::vec3 &origin, const glm::vec3 &direction, float &distance, uint32_t &triangle,
+	               float max_distance = std::numeric_limits<float>::max()) const;
+
+	size_t get_triangle_count() const;
+
+	const std::vector<glm::vec3> &get_positions() const;
+
+	const std::vector<uint32_t> &get_indices() const;
+
+  private:
+	std::vector<glm::vec3> positions;
+
+	std::vector<uint32_t> indices;
+
+	BVH bvh;
+};
+}        // namespace vkb
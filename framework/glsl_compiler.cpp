@@ -61,12 +61,61 @@ inline EShLanguage FindShaderLanguage(VkShaderStageFlagBits stage)
 		case VK_SHADER_STAGE_CLOSEST_HIT_BIT_NV:
 			return EShLangClosestHitNV;
 
+		case VK_SHADER_STAGE_TASK_BIT_NV:
+			return EShLangTaskNV;
+
+		case VK_SHADER_STAGE_MESH_BIT_NV:
+			return EShLangMeshNV;
+
 		default:
 			return EShLangVertex;
 	}
 }
+
+/**
+ * @brief Keeps the glslang library initialized for the lifetime of the application,
+ *        instead of initializing and finalizing it for every compilation
+ */
+struct GlslangProcess
+{
+	GlslangProcess()
+	{
+		glslang::InitializeProcess();
+	}
+
+	~GlslangProcess()
+	{
+		glslang::FinalizeProcess();
+	}
+};
 }        // namespace
 
+glslang::EShTargetLanguage        GLSLCompiler::env_target_language         = glslang::EShTargetLanguage::EShTargetNone;
+glslang::EShTargetLanguageVersion GLSLCompiler::env_target_language_version = static_cast<glslang::EShTargetLanguageVersion>(0);
+
+void GLSLCompiler::set_target_environment(glslang::EShTargetLanguage        target_language,
+                                          glslang::EShTargetLanguageVersion target_language_version)
+{
+	GLSLCompiler::env_target_language         = target_language;
+	GLSLCompiler::env_target_language_version = target_language_version;
+}
+
+void GLSLCompiler::reset_target_environment()
+{
+	GLSLCompiler::env_target_language         = glslang::EShTargetLanguage::EShTargetNone;
+	GLSLCompiler::env_target_language_version = static_cast<glslang::EShTargetLanguageVersion>(0);
+}
+
+glslang::EShTargetLanguage GLSLCompiler::get_target_language()
+{
+	return env_target_language;
+}
+
+glslang::EShTargetLanguageVersion GLSLCompiler::get_target_language_version()
+{
+	return env_target_language_version;
+}
+
 bool GLSLCompiler::compile_to_spirv(VkShaderStageFlagBits       stage,
                                     const std::vector<uint8_t> &glsl_source,
                                     const std::string &         entry_point,
@@ -74,8 +123,8 @@ bool GLSLCompiler::compile_to_spirv(VkShaderStageFlagBits       stage,
                                     std::vector<std::uint32_t> &spirv,
                                     std::string &               info_log)
 {
-	// Initialize glslang library.
-	glslang::InitializeProcess();
+	// Initialize glslang library once, thread-safe as it is a function-local static
+	static GlslangProcess process;
 
 	EShMessages messages = static_cast<EShMessages>(EShMsgDefault | EShMsgVulkanRules | EShMsgSpvRules);
 
@@ -91,6 +140,10 @@ bool GLSLCompiler::compile_to_spirv(VkShaderStageFlagBits       stage,
 	shader.setSourceEntryPoint(entry_point.c_str());
 	shader.setPreamble(shader_variant.get_preamble().c_str());
 	shader.addProcesses(shader_variant.get_processes());
+	if (GLSLCompiler::env_target_language != glslang::EShTargetLanguage::EShTargetNone)
+	{
+		shader.setEnvTarget(GLSLCompiler::env_target_language, GLSLCompiler::env_target_language_version);
+	}
 
 	if (!shader.parse(&glslang::DefaultTBuiltInResource, 100, false, messages))
 	{
@@ -135,9 +188,6 @@ bool GLSLCompiler::compile_to_spirv(VkShaderStageFlagBits       stage,
 
 	info_log += logger.getAllMessages() + "\n";
 
-	// Shutdown glslang library.
-	glslang::FinalizeProcess();
-
 	return true;
 }
 }        // namespace vkb
@@ -35,7 +35,35 @@ namespace vkb
 /// A very simple version of the glslValidator application
 class GLSLCompiler
 {
+  private:
+	static glslang::EShTargetLanguage        env_target_language;
+	static glslang::EShTargetLanguageVersion env_target_language_version;
+
   public:
+	/**
+	 * @brief Sets the target environment of all following compilations, such as SPIR-V 1.3
+	 *        which is required by subgroup operations
+	 * @param target_language The target language, EShTargetNone to use the glslang default
+	 * @param target_language_version The version of the target language
+	 */
+	static void set_target_environment(glslang::EShTargetLanguage        target_language,
+	                                   glslang::EShTargetLanguageVersion target_language_version);
+
+	/**
+	 * @brief Resets the target environment to the glslang default
+	 */
+	static void reset_target_environment();
+
+	/**
+	 * @return The target language, EShTargetNone if the glslang default is used
+	 */
+	static glslang::EShTargetLanguage get_target_language();
+
+	/**
+	 * @return The version of the target language
+	 */
+	static glslang::EShTargetLanguageVersion get_target_language_version();
+
 	/**
 	 * @brief Compiles GLSL to SPIRV code
 	 * @param stage The Vulkan shader stage flag
@@ -19,23 +19,34 @@
 #define TINYGLTF_IMPLEMENTATION
 #include "gltf_loader.h"
 
+#include <cstring>
+#include <deque>
 #include <limits>
+#include <numeric>
 #include <queue>
+#include <sstream>
 
 #include "common/error.h"
 
 VKBP_DISABLE_WARNINGS()
 #include "common/glm_common.h"
+#include <glm/gtc/packing.hpp>
 #include <glm/gtc/type_ptr.hpp>
 VKBP_ENABLE_WARNINGS()
 
 #include "api_vulkan_sample.h"
+#include "asset_memory_cache.h"
+#include "common/helpers.h"
 #include "common/logging.h"
 #include "common/utils.h"
 #include "common/vk_common.h"
 #include "core/device.h"
 #include "core/image.h"
+#include "core/staging_manager.h"
+#include "job_system.h"
+#include "platform/asset_archive.h"
 #include "platform/filesystem.h"
+#include "platform/io_service.h"
 #include "scene_graph/components/camera.h"
 #include "scene_graph/components/image.h"
 #include "scene_graph/components/image/astc.h"
@@ -47,10 +58,12 @@ VKBP_ENABLE_WARNINGS()
 #include "scene_graph/components/sub_mesh.h"
 #include "scene_graph/components/texture.h"
 #include "scene_graph/components/transform.h"
+#include "scene_graph/meshlet_builder.h"
 #include "scene_graph/node.h"
 #include "scene_graph/scene.h"
+#include "scene_graph/scene_cache.h"
+#include "stats/cpu_profiler.h"
 
-#include <ctpl_stl.h>
 
 namespace vkb
 {
@@ -129,6 +142,24 @@ inline std::vector<uint8_t> get_attribute_data(const tinygltf::Model *model, uin
 	return {buffer.data.begin() + startByte, buffer.data.begin() + endByte};
 };
 
+/**
+ * @brief Points to the data of an accessor in its glTF buffer, without copying it
+ * @param[out] size The size in bytes of the accessor data
+ */
+inline const uint8_t *get_attribute_view(const tinygltf::Model *model, uint32_t accessorId, size_t &size)
+{
+	auto &accessor   = model->accessors.at(accessorId);
+	auto &bufferView = model->bufferViews.at(accessor.bufferView);
+	auto &buffer     = model->buffers.at(bufferView.buffer);
+
+	size_t stride    = accessor.ByteStride(bufferView);
+	size_t startByte = accessor.byteOffset + bufferView.byteOffset;
+
+	size = accessor.count * stride;
+
+	return buffer.data.data() + startByte;
+};
+
 inline size_t get_attribute_size(const tinygltf::Model *model, uint32_t accessorId)
 {
 	return model->accessors.at(accessorId).count;
@@ -277,10 +308,253 @@ inline std::vector<uint8_t> convert_underlying_data_stride(const std::vector<uin
 	return result;
 }
 
-inline void upload_image_to_gpu(CommandBuffer &command_buffer, core::Buffer &staging_buffer, sg::Image &image)
+/**
+ * @brief Parses a glTF file straight from its mapping in memory
+ */
+bool load_gltf_file(tinygltf::TinyGLTF &loader, tinygltf::Model &model, std::string &err, std::string &warn, const std::string &gltf_file)
+{
+	try
+	{
+		auto file = fs::map_file(gltf_file);
+
+		size_t      pos      = gltf_file.find_last_of('/');
+		std::string base_dir = pos == std::string::npos ? "" : gltf_file.substr(0, pos);
+
+		return loader.LoadASCIIFromString(&model, &err, &warn, reinterpret_cast<const char *>(file.data()), to_u32(file.size()), base_dir);
+	}
+	catch (const std::runtime_error &ex)
+	{
+		err = ex.what();
+		return false;
+	}
+}
+
+/**
+ * @return Whether an asset is in the mounted asset archive
+ */
+bool is_archived(const std::string &uri)
+{
+	auto archive = fs::AssetArchive::get_mounted();
+
+	return archive && archive->find(uri);
+}
+
+/// Must be increased whenever the output of the mesh optimizer changes
+constexpr uint32_t MESH_CACHE_VERSION = 2;
+
+const std::string MESH_CACHE_FOLDER = "mesh_cache/";
+
+inline std::string get_mesh_cache_filename(size_t key)
+{
+	std::stringstream filename;
+	filename << MESH_CACHE_FOLDER << std::hex << key << ".bin";
+	return filename.str();
+}
+
+bool read_mesh_cache(size_t key, std::vector<uint32_t> &indices, std::map<std::string, VertexStream> &streams, uint32_t &vertex_count, std::vector<MeshLod> &lods)
+{
+	std::string file_data;
+
+	try
+	{
+		auto file = fs::map_temp(get_mesh_cache_filename(key));
+		file_data.assign(reinterpret_cast<const char *>(file.data()), file.size());
+	}
+	catch (const std::runtime_error &)
+	{
+		return false;
+	}
+
+	std::istringstream is{std::move(file_data)};
+
+	size_t                stored_key{0};
+	uint32_t              cached_vertex_count{0};
+	std::vector<uint32_t> cached_indices;
+	size_t                stream_count{0};
+	read(is, stored_key, cached_vertex_count, cached_indices, stream_count);
+
+	std::map<std::string, VertexStream> cached_streams;
+
+	for (size_t i = 0; is && i < stream_count; ++i)
+	{
+		std::string  name;
+		VertexStream stream;
+		read(is, name, stream.format, stream.stride, stream.data);
+
+		cached_streams.emplace(name, std::move(stream));
+	}
+
+	size_t lod_count{0};
+	read(is, lod_count);
+
+	std::vector<MeshLod> cached_lods;
+
+	for (size_t i = 0; is && i < lod_count; ++i)
+	{
+		MeshLod lod;
+		read(is, lod.indices, lod.error);
+
+		cached_lods.push_back(std::move(lod));
+	}
+
+	if (!is || stored_key != key)
+	{
+		return false;
+	}
+
+	indices.swap(cached_indices);
+	streams.swap(cached_streams);
+	lods.swap(cached_lods);
+	vertex_count = cached_vertex_count;
+
+	return true;
+}
+
+void write_mesh_cache(size_t key, const std::vector<uint32_t> &indices, const std::map<std::string, VertexStream> &streams, uint32_t vertex_count, const std::vector<MeshLod> &lods)
+{
+	std::ostringstream os;
+	write(os, key, vertex_count, indices, streams.size());
+
+	for (auto &stream : streams)
+	{
+		write(os, stream.first, stream.second.format, stream.second.stride, stream.second.data);
+	}
+
+	write(os, lods.size());
+
+	for (auto &lod : lods)
+	{
+		write(os, lod.indices, lod.error);
+	}
+
+	std::string str = os.str();
+
+	try
+	{
+		auto temp_directory = fs::path::get(fs::path::Type::Temp);
+
+		if (!fs::is_directory(temp_directory + MESH_CACHE_FOLDER))
+		{
+			fs::create_path(temp_directory, MESH_CACHE_FOLDER);
+		}
+
+		fs::write_temp({str.begin(), str.end()}, get_mesh_cache_filename(key));
+	}
+	catch (const std::runtime_error &ex)
+	{
+		LOGW("Failed to cache optimized mesh. {}", ex.what());
+	}
+}
+
+const std::string SCENE_CACHE_FOLDER = "scene_cache/";
+
+inline std::string get_scene_cache_filename(uint64_t key)
+{
+	std::stringstream filename;
+	filename << SCENE_CACHE_FOLDER << std::hex << key << ".bin";
+	return filename.str();
+}
+
+inline VkSamplerCreateInfo get_sampler_info(const tinygltf::Sampler &gltf_sampler)
+{
+	VkSamplerCreateInfo sampler_info{VK_STRUCTURE_TYPE_SAMPLER_CREATE_INFO};
+
+	sampler_info.magFilter    = find_mag_filter(gltf_sampler.magFilter);
+	sampler_info.minFilter    = find_min_filter(gltf_sampler.minFilter);
+	sampler_info.mipmapMode   = find_mipmap_mode(gltf_sampler.minFilter);
+	sampler_info.addressModeU = find_wrap_mode(gltf_sampler.wrapS);
+	sampler_info.addressModeV = find_wrap_mode(gltf_sampler.wrapT);
+	sampler_info.addressModeW = find_wrap_mode(gltf_sampler.wrapR);
+	sampler_info.borderColor  = VK_BORDER_COLOR_FLOAT_OPAQUE_WHITE;
+	sampler_info.maxLod       = std::numeric_limits<float>::max();
+
+	return sampler_info;
+}
+
+inline tinygltf::Sampler get_default_gltf_sampler()
+{
+	tinygltf::Sampler gltf_sampler;
+
+	gltf_sampler.minFilter = TINYGLTF_TEXTURE_FILTER_LINEAR;
+	gltf_sampler.magFilter = TINYGLTF_TEXTURE_FILTER_LINEAR;
+
+	gltf_sampler.wrapS = TINYGLTF_TEXTURE_WRAP_REPEAT;
+	gltf_sampler.wrapT = TINYGLTF_TEXTURE_WRAP_REPEAT;
+	gltf_sampler.wrapR = TINYGLTF_TEXTURE_WRAP_REPEAT;
+
+	return gltf_sampler;
+}
+
+/**
+ * @brief Checks whether the mip levels of an image with the given format can be generated with linear blits
+ */
+inline bool is_blit_supported(Device &device, VkFormat format)
+{
+	VkFormatProperties format_properties;
+	vkGetPhysicalDeviceFormatProperties(device.get_gpu().get_handle(), format, &format_properties);
+
+	VkFormatFeatureFlags required_features = VK_FORMAT_FEATURE_BLIT_SRC_BIT | VK_FORMAT_FEATURE_BLIT_DST_BIT | VK_FORMAT_FEATURE_SAMPLED_IMAGE_FILTER_LINEAR_BIT;
+
+	return (format_properties.optimalTilingFeatures & required_features) == required_features;
+}
+
+/**
+ * @brief Fills the mip levels of an image by blitting each level from the previous one
+ *        Level 0 is expected in the transfer destination layout, all levels end up in the transfer source layout
+ */
+inline void generate_mipmaps_on_gpu(CommandBuffer &command_buffer, sg::Image &image)
+{
+	auto &vk_image = image.get_vk_image();
+	auto &mipmaps  = image.get_mipmaps();
+
+	VkImageMemoryBarrier barrier{VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER};
+	barrier.srcQueueFamilyIndex         = VK_QUEUE_FAMILY_IGNORED;
+	barrier.dstQueueFamilyIndex         = VK_QUEUE_FAMILY_IGNORED;
+	barrier.image                       = vk_image.get_handle();
+	barrier.subresourceRange            = image.get_vk_image_view().get_subresource_range();
+	barrier.subresourceRange.levelCount = 1;
+	barrier.oldLayout                   = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+	barrier.newLayout                   = VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL;
+	barrier.srcAccessMask               = VK_ACCESS_TRANSFER_WRITE_BIT;
+	barrier.dstAccessMask               = VK_ACCESS_TRANSFER_READ_BIT;
+
+	for (uint32_t level = 1; level < to_u32(mipmaps.size()); ++level)
+	{
+		// Previous level becomes the source of the blit, once the copy or blit writing it is done
+		barrier.subresourceRange.baseMipLevel = level - 1;
+
+		vkCmdPipelineBarrier(command_buffer.get_handle(), VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT, 0,
+		                     0, nullptr, 0, nullptr, 1, &barrier);
+
+		auto &src_extent = mipmaps.at(level - 1).extent;
+		auto &dst_extent = mipmaps.at(level).extent;
+
+		VkImageBlit blit{};
+		blit.srcSubresource          = image.get_vk_image_view().get_subresource_layers();
+		blit.srcSubresource.mipLevel = level - 1;
+		blit.srcOffsets[1]           = {static_cast<int32_t>(src_extent.width), static_cast<int32_t>(src_extent.height), 1};
+		blit.dstSubresource          = image.get_vk_image_view().get_subresource_layers();
+		blit.dstSubresource.mipLevel = level;
+		blit.dstOffsets[1]           = {static_cast<int32_t>(dst_extent.width), static_cast<int32_t>(dst_extent.height), 1};
+
+		command_buffer.blit_image(vk_image, vk_image, {blit}, VK_FILTER_LINEAR);
+	}
+
+	// The last level is only written
+	barrier.subresourceRange.baseMipLevel = to_u32(mipmaps.size()) - 1;
+
+	vkCmdPipelineBarrier(command_buffer.get_handle(), VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT, 0,
+	                     0, nullptr, 0, nullptr, 1, &barrier);
+}
+
+inline void upload_image_to_gpu(CommandBuffer &command_buffer, core::Buffer &staging_buffer, VkDeviceSize staging_offset, sg::Image &image,
+                                uint32_t src_queue_family, uint32_t dst_queue_family, bool keep_data = false)
 {
 	// Clean up the image data, as they are copied in the staging buffer
-	image.clear_data();
+	if (!keep_data)
+	{
+		image.clear_data();
+	}
 
 	{
 		ImageMemoryBarrier memory_barrier{};
@@ -294,17 +568,17 @@ inline void upload_image_to_gpu(CommandBuffer &command_buffer, core::Buffer &sta
 		command_buffer.image_memory_barrier(image.get_vk_image_view(), memory_barrier);
 	}
 
-	// Create a buffer image copy for every mip level
+	// Create a buffer image copy for every mip level, levels generated on the GPU have no data
 	auto &mipmaps = image.get_mipmaps();
 
-	std::vector<VkBufferImageCopy> buffer_copy_regions(mipmaps.size());
+	std::vector<VkBufferImageCopy> buffer_copy_regions(image.has_gpu_mipmaps() ? 1 : mipmaps.size());
 
-	for (size_t i = 0; i < mipmaps.size(); ++i)
+	for (size_t i = 0; i < buffer_copy_regions.size(); ++i)
 	{
 		auto &mipmap      = mipmaps[i];
 		auto &copy_region = buffer_copy_regions[i];
 
-		copy_region.bufferOffset     = mipmap.offset;
+		copy_region.bufferOffset     = staging_offset + mipmap.offset;
 		copy_region.imageSubresource = image.get_vk_image_view().get_subresource_layers();
 		// Update miplevel
 		copy_region.imageSubresource.mipLevel = mipmap.level;
@@ -313,524 +587,2224 @@ inline void upload_image_to_gpu(CommandBuffer &command_buffer, core::Buffer &sta
 
 	command_buffer.copy_buffer_to_image(staging_buffer, image.get_vk_image(), buffer_copy_regions);
 
+	if (image.has_gpu_mipmaps())
+	{
+		generate_mipmaps_on_gpu(command_buffer, image);
+	}
+
 	{
 		ImageMemoryBarrier memory_barrier{};
-		memory_barrier.old_layout      = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+		memory_barrier.old_layout      = image.has_gpu_mipmaps() ? VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL : VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
 		memory_barrier.new_layout      = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
 		memory_barrier.src_access_mask = VK_ACCESS_TRANSFER_WRITE_BIT;
 		memory_barrier.dst_access_mask = VK_ACCESS_SHADER_READ_BIT;
 		memory_barrier.src_stage_mask  = VK_PIPELINE_STAGE_TRANSFER_BIT;
 		memory_barrier.dst_stage_mask  = VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT;
 
+		if (src_queue_family != dst_queue_family)
+		{
+			// Release the image to the graphics queue, which acquires it once the upload is complete
+			memory_barrier.dst_access_mask  = 0;
+			memory_barrier.dst_stage_mask   = VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT;
+			memory_barrier.old_queue_family = src_queue_family;
+			memory_barrier.new_queue_family = dst_queue_family;
+		}
+
 		command_buffer.image_memory_barrier(image.get_vk_image_view(), memory_barrier);
 	}
 }
-}        // namespace
 
-std::unordered_map<std::string, bool> GLTFLoader::supported_extensions = {
-    {KHR_LIGHTS_PUNCTUAL_EXTENSION, false}};
-
-GLTFLoader::GLTFLoader(Device &device) :
-    device{device}
+/**
+ * @brief Streams image data to the GPU through a fixed size staging ring buffer.
+ *        Images are recorded into batches which are submitted with a fence, and the space used
+ *        by a batch is reused once its fence is signaled, so staging memory stays bounded
+ *        regardless of the size of the scene.
+ */
+class ImageUploader
 {
-}
+  public:
+	ImageUploader(Device &device, VkDeviceSize staging_size, bool use_transfer_queue, bool keep_data = false) :
+	    device{device},
+	    keep_data{keep_data},
+	    graphics_queue{device.get_queue_by_role(QueueRole::Graphics)},
+	    transfer_queue{&graphics_queue},
+	    staging_buffer{device, staging_size, VK_BUFFER_USAGE_TRANSFER_SRC_BIT, VMA_MEMORY_USAGE_CPU_ONLY}
+	{
+		if (use_transfer_queue)
+		{
+			transfer_queue = &device.get_queue_by_role(QueueRole::Transfer);
+		}
 
-std::unique_ptr<sg::Scene> GLTFLoader::read_scene_from_file(const std::string &file_name, int scene_index)
-{
-	std::string err;
-	std::string warn;
+		command_pool = std::make_unique<CommandPool>(device, transfer_queue->get_family_index());
+	}
 
-	tinygltf::TinyGLTF gltf_loader;
+	~ImageUploader()
+	{
+		// Staging memory can't be released while the GPU reads from it
+		while (!in_flight_batches.empty())
+		{
+			wait_oldest_batch();
+		}
+	}
 
-	std::string gltf_file = vkb::fs::path::get(vkb::fs::path::Type::Assets) + file_name;
+	/**
+	 * @brief Copies the image data to the staging buffer and records its upload
+	 *        The image data is cleared once copied, unless the uploader keeps it
+	 */
+	void upload(sg::Image &image)
+	{
+		auto &data = image.get_data();
+		auto  size = static_cast<VkDeviceSize>(data.size());
 
-	bool importResult = gltf_loader.LoadASCIIFromFile(&model, &err, &warn, gltf_file.c_str());
+		core::Buffer *buffer = &staging_buffer;
+		VkDeviceSize  offset = 0;
 
-	if (!importResult)
-	{
-		LOGE("Failed to load gltf file {}.", gltf_file.c_str());
+		if (size <= staging_buffer.get_size())
+		{
+			// Retire batches until the image fits, this always succeeds once the ring is empty
+			while (!allocate(size, offset))
+			{
+				if (current_batch.command_buffer)
+				{
+					submit();
+				}
+				else
+				{
+					wait_oldest_batch();
+				}
+			}
 
-		return nullptr;
+			current_batch.uses_ring = true;
+		}
+		else
+		{
+			// Drain the ring so that an oversized image is the only data being staged
+			submit();
+			while (!in_flight_batches.empty())
+			{
+				wait_oldest_batch();
+			}
+
+			LOGW("Image {} is bigger than the staging buffer, using a dedicated staging buffer", image.get_name());
+
+			current_batch.dedicated_buffers.emplace_back(device, size, VK_BUFFER_USAGE_TRANSFER_SRC_BIT, VMA_MEMORY_USAGE_CPU_ONLY);
+			buffer = &current_batch.dedicated_buffers.back();
+		}
+
+		buffer->update(data, static_cast<size_t>(offset));
+
+		upload_image_to_gpu(get_command_buffer(), *buffer, offset, image, transfer_queue->get_family_index(), graphics_queue.get_family_index(), keep_data);
+
+		if (transfer_queue->get_family_index() != graphics_queue.get_family_index())
+		{
+			released_images.push_back(&image);
+		}
+
+		current_batch.size += size;
+
+		// Keep the GPU busy while the ring is being filled
+		if (!current_batch.dedicated_buffers.empty() || current_batch.size >= staging_buffer.get_size() / 4)
+		{
+			submit();
+		}
 	}
 
-	if (!err.empty())
+	/**
+	 * @brief Submits the batch being recorded, if any
+	 */
+	void submit()
 	{
-		LOGE("Error loading gltf model: {}.", err.c_str());
+		if (!current_batch.command_buffer)
+		{
+			return;
+		}
 
-		return nullptr;
+		current_batch.command_buffer->end();
+
+		current_batch.fence = device.get_transient_fence_pool().request_fence();
+
+		VK_CHECK(transfer_queue->submit(*current_batch.command_buffer, current_batch.fence));
+
+		in_flight_batches.push_back(std::move(current_batch));
+
+		current_batch = {};
+
+		batch_count++;
 	}
 
-	if (!warn.empty())
+	/**
+	 * @brief Submits pending uploads and waits for all of them to complete
+	 *        Images uploaded on a dedicated transfer queue are then acquired by the graphics queue
+	 */
+	void finish()
 	{
-		LOGI("{}", warn.c_str());
-	}
+		submit();
 
-	size_t pos = file_name.find_last_of('/');
+		while (!in_flight_batches.empty())
+		{
+			wait_oldest_batch();
+		}
 
-	model_path = file_name.substr(0, pos);
+		if (released_images.empty())
+		{
+			return;
+		}
 
-	if (pos == std::string::npos)
-	{
-		model_path.clear();
-	}
+		CommandPool graphics_command_pool{device, graphics_queue.get_family_index()};
 
-	return std::make_unique<sg::Scene>(load_scene(scene_index));
-}
+		auto &command_buffer = graphics_command_pool.request_command_buffer();
 
-std::unique_ptr<sg::SubMesh> GLTFLoader::read_model_from_file(const std::string &file_name, uint32_t index)
-{
-	std::string err;
-	std::string warn;
+		command_buffer.begin(VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT);
 
-	tinygltf::TinyGLTF gltf_loader;
+		for (auto image : released_images)
+		{
+			ImageMemoryBarrier memory_barrier{};
+			memory_barrier.old_layout       = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+			memory_barrier.new_layout       = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+			memory_barrier.src_access_mask  = 0;
+			memory_barrier.dst_access_mask  = VK_ACCESS_SHADER_READ_BIT;
+			memory_barrier.src_stage_mask   = VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT;
+			memory_barrier.dst_stage_mask   = VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT;
+			memory_barrier.old_queue_family = transfer_queue->get_family_index();
+			memory_barrier.new_queue_family = graphics_queue.get_family_index();
+
+			command_buffer.image_memory_barrier(image->get_vk_image_view(), memory_barrier);
+		}
 
-	std::string gltf_file = vkb::fs::path::get(vkb::fs::path::Type::Assets) + file_name;
+		command_buffer.end();
 
-	bool importResult = gltf_loader.LoadASCIIFromFile(&model, &err, &warn, gltf_file.c_str());
+		auto &fence_pool = device.get_transient_fence_pool();
 
-	if (!importResult)
-	{
-		LOGE("Failed to load gltf file {}.", gltf_file.c_str());
+		VkFence fence = fence_pool.request_fence();
 
-		return nullptr;
+		VK_CHECK(graphics_queue.submit(command_buffer, fence));
+
+		VK_CHECK(fence_pool.wait(fence));
+
+		released_images.clear();
 	}
 
-	if (!err.empty())
+	uint32_t get_batch_count() const
 	{
-		LOGE("Error loading gltf model: {}.", err.c_str());
-
-		return nullptr;
+		return batch_count;
 	}
 
-	if (!warn.empty())
+	bool uses_transfer_queue() const
 	{
-		LOGI("{}", warn.c_str());
+		return transfer_queue->get_family_index() != graphics_queue.get_family_index();
 	}
 
-	size_t pos = file_name.find_last_of('/');
+  private:
+	/// Images recorded into one command buffer and submitted together
+	struct Batch
+	{
+		CommandBuffer *command_buffer{nullptr};
 
-	model_path = file_name.substr(0, pos);
+		VkFence fence{VK_NULL_HANDLE};
 
-	if (pos == std::string::npos)
-	{
-		model_path.clear();
-	}
+		/// Offset of the first allocation of the batch in the staging ring
+		VkDeviceSize begin{0};
 
-	return std::move(load_model(index));
-}
+		/// Amount of staged bytes
+		VkDeviceSize size{0};
 
-sg::Scene GLTFLoader::load_scene(int scene_index)
-{
-	auto scene = sg::Scene();
+		bool uses_ring{false};
 
-	scene.set_name("gltf_scene");
+		/// Staging buffers of images that do not fit in the ring
+		std::vector<core::Buffer> dedicated_buffers;
+	};
 
-	// Check extensions
-	for (auto &used_extension : model.extensionsUsed)
+	CommandBuffer &get_command_buffer()
 	{
-		auto it = supported_extensions.find(used_extension);
+		if (!current_batch.command_buffer)
+		{
+			current_batch.command_buffer = &command_pool->request_command_buffer();
+			current_batch.command_buffer->begin(VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT);
+		}
 
-		// Check if extension isn't supported by the GLTFLoader
-		if (it == supported_extensions.end())
+		return *current_batch.command_buffer;
+	}
+
+	/**
+	 * @brief Finds a free range in the staging ring
+	 * @param size Size of the range
+	 * @param[out] offset Offset of the range in the staging buffer
+	 * @return True if the range could be allocated without overwriting data in use
+	 */
+	bool allocate(VkDeviceSize size, VkDeviceSize &offset)
+	{
+		// Copies require offsets aligned to the texel block size, 16 bytes covers all formats we load
+		const VkDeviceSize alignment = 16;
+
+		const Batch *oldest_batch = &current_batch;
+
+		for (auto &batch : in_flight_batches)
 		{
-			// If extension is required then we shouldn't allow the scene to be loaded
-			if (std::find(model.extensionsRequired.begin(), model.extensionsRequired.end(), used_extension) != model.extensionsRequired.end())
+			if (batch.uses_ring)
 			{
-				throw std::runtime_error("Cannot load glTF file. Contains a required unsupported extension: " + used_extension);
+				oldest_batch = &batch;
+				break;
 			}
-			else
+		}
+
+		bool ring_empty = !oldest_batch->uses_ring;
+
+		if (ring_empty)
+		{
+			offset = 0;
+		}
+		else
+		{
+			// Data in use lies between the start of the oldest batch and the head, possibly wrapping around
+			VkDeviceSize tail    = oldest_batch->begin;
+			VkDeviceSize aligned = (head + alignment - 1) / alignment * alignment;
+
+			if (head > tail && aligned + size <= staging_buffer.get_size())
+			{
+				offset = aligned;
+			}
+			else if (head > tail && size < tail)
+			{
+				offset = 0;
+			}
+			else if (head < tail && aligned + size < tail)
+			{
+				offset = aligned;
+			}
+			else
+			{
+				return false;
+			}
+		}
+
+		if (!current_batch.uses_ring)
+		{
+			current_batch.begin = offset;
+		}
+
+		head = offset + size;
+
+		return true;
+	}
+
+	void wait_oldest_batch()
+	{
+		auto &batch = in_flight_batches.front();
+
+		VK_CHECK(device.get_transient_fence_pool().wait(batch.fence));
+
+		in_flight_batches.pop_front();
+	}
+
+	Device &device;
+
+	/// Whether the image data is kept once copied to the staging buffer
+	bool keep_data;
+
+	const Queue &graphics_queue;
+
+	const Queue *transfer_queue;
+
+	std::unique_ptr<CommandPool> command_pool;
+
+	core::Buffer staging_buffer;
+
+	/// End of the last allocation in the staging ring
+	VkDeviceSize head{0};
+
+	Batch current_batch;
+
+	std::deque<Batch> in_flight_batches;
+
+	/// Images owned by the transfer queue, waiting to be acquired by the graphics queue
+	std::vector<sg::Image *> released_images;
+
+	uint32_t batch_count{0};
+};
+
+/**
+ * @brief White image sampled by textures whose image is still loading
+ */
+class PlaceholderImage : public sg::Image
+{
+  public:
+	PlaceholderImage() :
+	    sg::Image{"placeholder", {255, 255, 255, 255}, {{0, 0, {1, 1, 1}}}}
+	{
+		set_format(VK_FORMAT_R8G8B8A8_UNORM);
+	}
+};
+}        // namespace
+
+/**
+ * @brief Makes the images of a scene resident over several frames.
+ *        Decoded images are uploaded with a per call budget, and their textures
+ *        are switched from the placeholder once the GPU has completed the copy.
+ */
+class ImageStreamer
+{
+  public:
+	ImageStreamer(Device &device, std::vector<std::future<std::unique_ptr<sg::Image>>> &&image_futures) :
+	    device{device},
+	    command_pool{device, device.get_queue_by_role(QueueRole::Graphics).get_family_index()}
+	{
+		for (auto &image_future : image_futures)
+		{
+			images.emplace_back();
+			images.back().future = std::move(image_future);
+		}
+
+		VkFenceCreateInfo create_info{VK_STRUCTURE_TYPE_FENCE_CREATE_INFO};
+
+		VK_CHECK(vkCreateFence(device.get_handle(), &create_info, nullptr, &fence));
+	}
+
+	~ImageStreamer()
+	{
+		// Decoding jobs still queued refer to the loader
+		for (auto &streamed_image : images)
+		{
+			if (streamed_image.future.valid())
+			{
+				JobSystem::get().wait(streamed_image.future);
+			}
+		}
+
+		if (!uploading_images.empty())
+		{
+			vkWaitForFences(device.get_handle(), 1, &fence, VK_TRUE, std::numeric_limits<uint64_t>::max());
+		}
+
+		vkDestroyFence(device.get_handle(), fence, nullptr);
+	}
+
+	void set_scene(sg::Scene &scene_)
+	{
+		scene = &scene_;
+	}
+
+	/**
+	 * @brief Records a texture to be switched to the image once it is resident
+	 */
+	void add_texture(size_t image_index, sg::Texture &texture)
+	{
+		images.at(image_index).textures.push_back(&texture);
+	}
+
+	size_t update(VkDeviceSize budget)
+	{
+		if (!uploading_images.empty())
+		{
+			if (vkGetFenceStatus(device.get_handle(), fence) != VK_SUCCESS)
+			{
+				return get_pending_count();
+			}
+
+			make_resident();
+		}
+
+		VkDeviceSize staged_size = 0;
+
+		for (size_t image_index = 0; image_index < images.size() && staged_size < budget; image_index++)
+		{
+			auto &streamed_image = images.at(image_index);
+
+			if (!streamed_image.future.valid() || streamed_image.future.wait_for(std::chrono::seconds(0)) != std::future_status::ready)
+			{
+				continue;
+			}
+
+			streamed_image.image = streamed_image.future.get();
+
+			auto &image = *streamed_image.image;
+
+			if (uploading_images.empty())
+			{
+				command_buffer = &command_pool.request_command_buffer();
+				command_buffer->begin(VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT);
+			}
+
+			staged_size += image.get_data().size();
+
+			staging_buffers.emplace_back(device, image.get_data().size(), VK_BUFFER_USAGE_TRANSFER_SRC_BIT, VMA_MEMORY_USAGE_CPU_ONLY);
+			staging_buffers.back().update(image.get_data());
+
+			upload_image_to_gpu(*command_buffer, staging_buffers.back(), 0, image, VK_QUEUE_FAMILY_IGNORED, VK_QUEUE_FAMILY_IGNORED);
+
+			uploading_images.push_back(image_index);
+		}
+
+		if (!uploading_images.empty())
+		{
+			command_buffer->end();
+
+			auto &queue = device.get_queue_by_role(QueueRole::Graphics);
+
+			VK_CHECK(queue.submit(*command_buffer, fence));
+		}
+
+		return get_pending_count();
+	}
+
+  private:
+	struct StreamedImage
+	{
+		std::future<std::unique_ptr<sg::Image>> future;
+
+		/// Decoded image, moved to the scene once resident
+		std::unique_ptr<sg::Image> image;
+
+		/// Textures using the image
+		std::vector<sg::Texture *> textures;
+
+		bool resident{false};
+	};
+
+	void make_resident()
+	{
+		VK_CHECK(vkResetFences(device.get_handle(), 1, &fence));
+
+		staging_buffers.clear();
+		command_pool.reset_pool();
+
+		for (auto image_index : uploading_images)
+		{
+			auto &streamed_image = images.at(image_index);
+
+			for (auto texture : streamed_image.textures)
+			{
+				texture->set_image(*streamed_image.image);
+			}
+
+			// The placeholder is never destroyed, so frames still in flight can keep sampling it
+			scene->add_component(std::move(streamed_image.image));
+
+			streamed_image.resident = true;
+			resident_count++;
+		}
+
+		uploading_images.clear();
+	}
+
+	size_t get_pending_count() const
+	{
+		return images.size() - resident_count;
+	}
+
+	Device &device;
+
+	sg::Scene *scene{nullptr};
+
+	std::vector<StreamedImage> images;
+
+	size_t resident_count{0};
+
+	CommandPool command_pool;
+
+	CommandBuffer *command_buffer{nullptr};
+
+	/// Signaled when the copies of uploading_images have completed
+	VkFence fence{VK_NULL_HANDLE};
+
+	std::vector<size_t> uploading_images;
+
+	std::vector<core::Buffer> staging_buffers;
+};
+
+std::unordered_map<std::string, bool> GLTFLoader::supported_extensions = {
+    {KHR_LIGHTS_PUNCTUAL_EXTENSION, false}};
+
+GLTFLoader::GLTFLoader(Device &device) :
+    device{device}
+{
+}
+
+GLTFLoader::~GLTFLoader() = default;
+
+void GLTFLoader::set_staging_buffer_size(VkDeviceSize size)
+{
+	staging_buffer_size = size;
+}
+
+void GLTFLoader::set_use_transfer_queue(bool use)
+{
+	use_transfer_queue = use;
+}
+
+void GLTFLoader::set_gpu_mipmap_generation(bool gpu)
+{
+	gpu_mipmap_generation = gpu;
+}
+
+void GLTFLoader::set_progressive_loading(bool progressive)
+{
+	progressive_loading = progressive;
+}
+
+void GLTFLoader::set_mesh_optimization(const MeshOptimizationOptions &options)
+{
+	mesh_optimization = options;
+}
+
+void GLTFLoader::set_keep_image_data(bool keep)
+{
+	keep_image_data = keep;
+}
+
+void GLTFLoader::set_interleaved_vertices(bool interleaved)
+{
+	interleaved_vertices = interleaved;
+}
+
+void GLTFLoader::set_scene_cache(bool enable)
+{
+	scene_cache = enable;
+}
+
+void GLTFLoader::set_asset_memory_cache(bool enable)
+{
+	asset_memory_cache = enable;
+}
+
+void GLTFLoader::set_texture_arrays(bool enable)
+{
+	texture_arrays = enable;
+}
+
+void GLTFLoader::set_vertex_compression(bool enable)
+{
+	vertex_compression = enable;
+}
+
+void GLTFLoader::set_meshlets(bool enable)
+{
+	meshlets = enable;
+}
+
+void GLTFLoader::set_ray_cast_geometry(bool enable)
+{
+	ray_cast_geometry = enable;
+}
+
+void GLTFLoader::set_geometry_buffer_usage(VkBufferUsageFlags usage)
+{
+	geometry_buffer_usage = usage;
+}
+
+void GLTFLoader::set_shared_geometry_buffers(bool shared)
+{
+	shared_geometry_buffers = shared;
+}
+
+void GLTFLoader::set_node_subtrees(const std::vector<std::string> &node_names)
+{
+	node_subtrees = node_names;
+}
+
+size_t GLTFLoader::stream_images(VkDeviceSize budget)
+{
+	if (!image_streamer)
+	{
+		return 0;
+	}
+
+	return image_streamer->update(budget);
+}
+
+std::unique_ptr<sg::Scene> GLTFLoader::read_scene_from_file(const std::string &file_name, int scene_index)
+{
+	PROFILE_FUNCTION();
+
+	std::string err;
+	std::string warn;
+
+	tinygltf::TinyGLTF gltf_loader;
+
+	std::string gltf_file = vkb::fs::path::get(vkb::fs::path::Type::Assets) + file_name;
+
+	uint64_t scene_cache_key = 0;
+
+	// The cache stores one image per glTF image and float vertex attributes, without meshlets or triangle BVHs
+	bool use_scene_cache = scene_cache && !texture_arrays && !vertex_compression && !meshlets && !ray_cast_geometry;
+
+	if (use_scene_cache)
+	{
+		scene_cache_key = get_scene_cache_key(gltf_file, scene_index);
+
+		if (auto scene = read_scene_cache(scene_cache_key))
+		{
+			LOGI("Loaded scene {} from its cache", file_name);
+
+			move_to_shared_geometry_buffers(*scene);
+
+			return scene;
+		}
+	}
+
+	auto cached_model = asset_memory_cache ? AssetMemoryCache::get().find_model(gltf_file) : nullptr;
+
+	if (cached_model)
+	{
+		LOGI("Parsed gltf file {} found in memory", file_name);
+
+		model = *cached_model;
+	}
+	else
+	{
+		bool importResult = load_gltf_file(gltf_loader, model, err, warn, gltf_file);
+
+		if (!importResult)
+		{
+			LOGE("Failed to load gltf file {}.", gltf_file.c_str());
+
+			return nullptr;
+		}
+
+		if (!err.empty())
+		{
+			LOGE("Error loading gltf model: {}.", err.c_str());
+
+			return nullptr;
+		}
+
+		if (!warn.empty())
+		{
+			LOGI("{}", warn.c_str());
+		}
+
+		// Loading the scene moves the embedded images out of the model
+		if (asset_memory_cache)
+		{
+			AssetMemoryCache::get().store_model(gltf_file, model);
+		}
+	}
+
+	size_t pos = file_name.find_last_of('/');
+
+	model_path = file_name.substr(0, pos);
+
+	if (pos == std::string::npos)
+	{
+		model_path.clear();
+	}
+
+	auto scene = std::make_unique<sg::Scene>(load_scene(scene_index));
+
+	if (image_streamer)
+	{
+		image_streamer->set_scene(*scene);
+	}
+
+	if (use_scene_cache && !progressive_loading)
+	{
+		write_scene_cache(scene_cache_key, *scene);
+	}
+
+	move_to_shared_geometry_buffers(*scene);
+
+	packed_scene_images.clear();
+	texture_array_placements.clear();
+
+	return scene;
+}
+
+std::unique_ptr<sg::SubMesh> GLTFLoader::read_model_from_file(const std::string &file_name, uint32_t index)
+{
+	std::string err;
+	std::string warn;
+
+	tinygltf::TinyGLTF gltf_loader;
+
+	std::string gltf_file = vkb::fs::path::get(vkb::fs::path::Type::Assets) + file_name;
+
+	bool importResult = load_gltf_file(gltf_loader, model, err, warn, gltf_file);
+
+	if (!importResult)
+	{
+		LOGE("Failed to load gltf file {}.", gltf_file.c_str());
+
+		return nullptr;
+	}
+
+	if (!err.empty())
+	{
+		LOGE("Error loading gltf model: {}.", err.c_str());
+
+		return nullptr;
+	}
+
+	if (!warn.empty())
+	{
+		LOGI("{}", warn.c_str());
+	}
+
+	size_t pos = file_name.find_last_of('/');
+
+	model_path = file_name.substr(0, pos);
+
+	if (pos == std::string::npos)
+	{
+		model_path.clear();
+	}
+
+	return std::move(load_model(index));
+}
+
+sg::Scene GLTFLoader::load_scene(int scene_index)
+{
+	PROFILE_FUNCTION();
+
+	auto scene = sg::Scene();
+
+	scene.set_name("gltf_scene");
+
+	// Check extensions
+	for (auto &used_extension : model.extensionsUsed)
+	{
+		auto it = supported_extensions.find(used_extension);
+
+		// Check if extension isn't supported by the GLTFLoader
+		if (it == supported_extensions.end())
+		{
+			// If extension is required then we shouldn't allow the scene to be loaded
+			if (std::find(model.extensionsRequired.begin(), model.extensionsRequired.end(), used_extension) != model.extensionsRequired.end())
+			{
+				throw std::runtime_error("Cannot load glTF file. Contains a required unsupported extension: " + used_extension);
+			}
+			else
+			{
+				// Otherwise, if extension isn't required (but is in the file) then print a warning to the user
+				LOGW("glTF file contains an unsupported extension, unexpected results may occur: {}", used_extension);
+			}
+		}
+		else
+		{
+			// Extension is supported, so enable it
+			LOGI("glTF file contains extension: {}", used_extension);
+			it->second = true;
+		}
+	}
+
+	// Resources no node of the scene refers to are left out, for files holding several scenes
+	auto &gltf_scene = get_gltf_scene(scene_index);
+	auto  used       = find_used_resources(gltf_scene);
+
+	LOGI("Loading {} of {} meshes and {} of {} images referenced by scene '{}'",
+	     std::count(used.meshes.begin(), used.meshes.end(), true), model.meshes.size(),
+	     std::count(used.images.begin(), used.images.end(), true), model.images.size(), gltf_scene.name);
+
+	// Load lights
+	std::vector<std::unique_ptr<sg::Light>> light_components = parse_khr_lights_punctual();
+
+	scene.set_components(std::move(light_components));
+
+	// Load samplers
+	std::vector<std::unique_ptr<sg::Sampler>>
+	    sampler_components(model.samplers.size());
+
+	for (size_t sampler_index = 0; sampler_index < model.samplers.size(); sampler_index++)
+	{
+		auto sampler                      = parse_sampler(model.samplers.at(sampler_index));
+		sampler_components[sampler_index] = std::move(sampler);
+	}
+
+	scene.set_components(std::move(sampler_components));
+
+	Timer timer;
+	timer.start();
+
+	// Load images
+	auto &job_system   = JobSystem::get();
+	auto  thread_count = job_system.get_thread_count();
+
+	auto image_count = to_u32(model.images.size());
+
+	auto &io_service = fs::IoService::get();
+
+	std::vector<std::future<std::unique_ptr<sg::Image>>> image_component_futures;
+	for (size_t image_index = 0; image_index < image_count; image_index++)
+	{
+		auto &gltf_image = model.images.at(image_index);
+
+		// Unused images keep their index with a placeholder, so that textures still find their image
+		if (!used.images.at(image_index))
+		{
+			image_component_futures.push_back(job_system.push([this](size_t) { return prepare_image(std::make_unique<PlaceholderImage>()); }));
+
+			continue;
+		}
+
+		// Archived images are already in memory, they are unpacked by parse_image
+		if (gltf_image.image.empty() && !gltf_image.uri.empty() && !is_archived(model_path + "/" + gltf_image.uri))
+		{
+			auto image_file = fs::path::get(fs::path::Type::Assets) + model_path + "/" + gltf_image.uri;
+
+			// Images decoded by an earlier load of the process are copied as they are
+			if (auto packed_image = asset_memory_cache ? AssetMemoryCache::get().find_image(image_file) : nullptr)
+			{
+				image_component_futures.push_back(job_system.push([this, image_index, packed_image](size_t) {
+					return prepare_image(sg::Image::unpack(model.images.at(image_index).name, packed_image->data(), packed_image->size()));
+				}));
+
+				continue;
+			}
+
+			// The file is read on an I/O thread, a worker decodes it once it is in memory
+			auto promise = std::make_shared<std::promise<std::unique_ptr<sg::Image>>>();
+
+			image_component_futures.push_back(promise->get_future());
+
+			io_service.read(image_file,
+			                [this, image_index, image_file, promise](std::vector<uint8_t> &&data, std::exception_ptr error) {
+				                if (error)
+				                {
+					                promise->set_exception(error);
+					                return;
+				                }
+
+				                JobSystem::get().push([this, image_index, image_file, promise, file_data = std::move(data)](size_t) {
+					                try
+					                {
+						                promise->set_value(parse_image_file(model.images.at(image_index), image_file, file_data));
+
+						                LOGI("Loaded gltf image #{} ({})", image_index, model.images.at(image_index).uri.c_str());
+					                }
+					                catch (...)
+					                {
+						                promise->set_exception(std::current_exception());
+					                }
+				                });
+			                });
+
+			continue;
+		}
+
+		auto fut = job_system.push(
+		    [this, image_index](size_t) {
+			    auto image = parse_image(model.images.at(image_index));
+
+			    LOGI("Loaded gltf image #{} ({})", image_index, model.images.at(image_index).uri.c_str());
+
+			    return image;
+		    });
+
+		image_component_futures.push_back(std::move(fut));
+	}
+
+	if (progressive_loading)
+	{
+		// Textures sample a placeholder, images are made resident by stream_images
+		image_streamer = std::make_unique<ImageStreamer>(device, std::move(image_component_futures));
+
+		std::unique_ptr<sg::Image> placeholder = std::make_unique<PlaceholderImage>();
+		placeholder->create_vk_image(device);
+
+		ImageUploader image_uploader{device, placeholder->get_data().size(), false};
+		image_uploader.upload(*placeholder);
+		image_uploader.finish();
+
+		std::vector<std::unique_ptr<sg::Image>> image_components;
+		image_components.push_back(std::move(placeholder));
+
+		scene.set_components(std::move(image_components));
+
+		LOGI("Streaming {} images across {} threads.", image_count, thread_count);
+	}
+	else if (texture_arrays)
+	{
+		// Every image has to be decoded before packing, the packed images are uploaded once created
+		std::vector<std::unique_ptr<sg::Image>> decoded_images;
+
+		for (auto &fut : image_component_futures)
+		{
+			job_system.wait(fut);
+			decoded_images.push_back(fut.get());
+		}
+
+		auto image_components = sg::TextureArrayPacker{}.pack(device, std::move(decoded_images), texture_array_placements);
+
+		ImageUploader image_uploader{device, staging_buffer_size, use_transfer_queue, keep_image_data};
+
+		for (auto &image : image_components)
+		{
+			image->create_vk_image(device, VK_IMAGE_VIEW_TYPE_2D_ARRAY);
+			image_uploader.upload(*image);
+		}
+
+		image_uploader.finish();
+
+		LOGI("Uploaded {} images as {} images in {} batches.", image_count, image_components.size(), image_uploader.get_batch_count());
+
+		scene.set_components(std::move(image_components));
+	}
+	else
+	{
+		// Upload images to GPU as soon as they are decoded
+		std::vector<std::unique_ptr<sg::Image>> image_components(image_count);
+
+		if (scene_cache)
+		{
+			packed_scene_images.resize(image_count);
+		}
+
+		ImageUploader image_uploader{device, staging_buffer_size, use_transfer_queue, keep_image_data};
+
+		size_t uploaded_image_count = 0;
+
+		while (uploaded_image_count < image_count)
+		{
+			bool uploaded = false;
+
+			for (size_t image_index = 0; image_index < image_count; image_index++)
+			{
+				auto &fut = image_component_futures.at(image_index);
+
+				if (fut.valid() && fut.wait_for(std::chrono::seconds(0)) == std::future_status::ready)
+				{
+					image_components.at(image_index) = fut.get();
+
+					if (scene_cache)
+					{
+						packed_scene_images.at(image_index) = image_components.at(image_index)->pack();
+					}
+
+					image_uploader.upload(*image_components.at(image_index));
+
+					uploaded_image_count++;
+					uploaded = true;
+				}
+			}
+
+			if (!uploaded && uploaded_image_count < image_count)
+			{
+				// Let the GPU copy what is staged while waiting for the next image to be decoded
+				image_uploader.submit();
+
+				auto pending = std::find_if(image_component_futures.begin(), image_component_futures.end(),
+				                            [](const std::future<std::unique_ptr<sg::Image>> &fut) { return fut.valid(); });
+
+				job_system.wait(*pending);
+			}
+		}
+
+		image_uploader.finish();
+
+		LOGI("Uploaded {} images in {} batches{}.", image_count, image_uploader.get_batch_count(),
+		     image_uploader.uses_transfer_queue() ? " on a dedicated transfer queue" : "");
+
+		scene.set_components(std::move(image_components));
+	}
+
+	auto elapsed_time = timer.stop();
+
+	LOGI("Time spent loading images: {} seconds across {} threads.", vkb::to_string(elapsed_time), thread_count);
+
+	// Load textures
+	auto images          = scene.get_components<sg::Image>();
+	auto samplers        = scene.get_components<sg::Sampler>();
+	auto default_sampler = create_default_sampler();
+
+	for (auto &gltf_texture : model.textures)
+	{
+		auto texture = parse_texture(gltf_texture);
+
+		if (image_streamer)
+		{
+			texture->set_image(*images.at(0));
+			image_streamer->add_texture(gltf_texture.source, *texture);
+		}
+		else if (!texture_array_placements.empty())
+		{
+			auto &placement = texture_array_placements.at(gltf_texture.source);
+
+			texture->set_image(*images.at(placement.image));
+			texture->set_array_layer(placement.layer);
+		}
+		else
+		{
+			texture->set_image(*images.at(gltf_texture.source));
+		}
+
+		if (gltf_texture.sampler >= 0 && gltf_texture.sampler < static_cast<int>(samplers.size()))
+		{
+			texture->set_sampler(*samplers.at(gltf_texture.sampler));
+		}
+		else
+		{
+			if (gltf_texture.name.empty())
+			{
+				gltf_texture.name = model.images.at(gltf_texture.source).name;
+			}
+
+			texture->set_sampler(*default_sampler);
+		}
+
+		scene.add_component(std::move(texture));
+	}
+
+	scene.add_component(std::move(default_sampler));
+
+	// Load materials
+	bool                            has_textures = scene.has_component<sg::Texture>();
+	std::vector<vkb::sg::Texture *> textures;
+	if (has_textures)
+	{
+		textures = scene.get_components<sg::Texture>().to_vector();
+	}
+
+	// Materials are parsed by jobs, and added to the scene in the order of the glTF file
+	std::vector<std::future<std::unique_ptr<sg::PBRMaterial>>> material_futures;
+
+	for (auto &gltf_material : model.materials)
+	{
+		material_futures.push_back(job_system.push([this, &gltf_material, &textures](size_t) {
+			auto material = parse_material(gltf_material);
+
+			for (auto &gltf_value : gltf_material.values)
+			{
+				if (gltf_value.first.find("Texture") != std::string::npos)
+				{
+					std::string tex_name = to_snake_case(gltf_value.first);
+
+					material->textures[tex_name] = textures.at(gltf_value.second.TextureIndex());
+				}
+			}
+
+			for (auto &gltf_value : gltf_material.additionalValues)
+			{
+				if (gltf_value.first.find("Texture") != std::string::npos)
+				{
+					std::string tex_name = to_snake_case(gltf_value.first);
+
+					material->textures[tex_name] = textures.at(gltf_value.second.TextureIndex());
+				}
+			}
+
+			return material;
+		}));
+	}
+
+	// Every job completes before a failure is rethrown, as they refer to the textures
+	for (auto &fut : material_futures)
+	{
+		job_system.wait(fut);
+	}
+
+	for (auto &fut : material_futures)
+	{
+		scene.add_component(fut.get());
+	}
+
+	auto default_material = create_default_material();
+
+	timer.start();
+
+	// Load meshes, every primitive is parsed and copied to its buffers by a job
+	std::vector<std::vector<std::future<std::unique_ptr<sg::SubMesh>>>> submesh_futures(model.meshes.size());
+
+	size_t primitive_count = 0;
+
+	for (size_t mesh_index = 0; mesh_index < model.meshes.size(); ++mesh_index)
+	{
+		// Meshes outside of the loaded scene stay empty
+		if (!used.meshes.at(mesh_index))
+		{
+			continue;
+		}
+
+		for (auto &gltf_primitive : model.meshes.at(mesh_index).primitives)
+		{
+			submesh_futures.at(mesh_index).push_back(job_system.push([this, &gltf_primitive](size_t) { return load_primitive(gltf_primitive); }));
+		}
+
+		primitive_count += model.meshes.at(mesh_index).primitives.size();
+	}
+
+	// Sub meshes are added to the scene in the order of the glTF file, whichever job completes first
+	auto materials = scene.get_components<sg::PBRMaterial>();
+
+	for (size_t mesh_index = 0; mesh_index < model.meshes.size(); ++mesh_index)
+	{
+		auto &gltf_mesh = model.meshes.at(mesh_index);
+
+		auto mesh = parse_mesh(gltf_mesh);
+
+		for (size_t primitive_index = 0; primitive_index < submesh_futures.at(mesh_index).size(); ++primitive_index)
+		{
+			auto &gltf_primitive = gltf_mesh.primitives.at(primitive_index);
+			auto &fut            = submesh_futures.at(mesh_index).at(primitive_index);
+
+			job_system.wait(fut);
+
+			auto submesh = fut.get();
+
+			if (gltf_primitive.material < 0)
+			{
+				submesh->set_material(*default_material);
+			}
+			else
+			{
+				submesh->set_material(*materials.at(gltf_primitive.material));
+			}
+
+			mesh->add_submesh(*submesh);
+
+			scene.add_component(std::move(submesh));
+		}
+
+		scene.add_component(std::move(mesh));
+	}
+
+	elapsed_time = timer.stop();
+
+	LOGI("Time spent loading {} primitives: {} seconds across {} threads.", primitive_count, vkb::to_string(elapsed_time), thread_count);
+
+	scene.add_component(std::move(default_material));
+
+	// Load cameras
+	for (auto &gltf_camera : model.cameras)
+	{
+		auto camera = parse_camera(gltf_camera);
+		scene.add_component(std::move(camera));
+	}
+
+	// Load nodes
+	auto meshes = scene.get_components<sg::Mesh>();
+
+	std::vector<std::unique_ptr<sg::Node>> nodes;
+
+	for (size_t node_index = 0; node_index < model.nodes.size(); ++node_index)
+	{
+		auto gltf_node = model.nodes[node_index];
+		auto node      = parse_node(gltf_node, node_index);
+
+		if (gltf_node.mesh >= 0 && used.nodes.at(node_index))
+		{
+			auto mesh = meshes.at(gltf_node.mesh);
+
+			node->set_component(*mesh);
+
+			mesh->add_node(*node);
+		}
+
+		if (gltf_node.camera >= 0)
+		{
+			auto cameras = scene.get_components<sg::Camera>();
+			auto camera  = cameras.at(gltf_node.camera);
+
+			node->set_component(*camera);
+
+			camera->set_node(*node);
+		}
+
+		if (auto extension = get_extension(gltf_node.extensions, KHR_LIGHTS_PUNCTUAL_EXTENSION))
+		{
+			auto lights = scene.get_components<sg::Light>();
+			auto light  = lights.at(static_cast<size_t>(extension->Get("light").Get<int>()));
+
+			node->set_component(*light);
+
+			light->set_node(*node);
+		}
+
+		nodes.push_back(std::move(node));
+	}
+
+	// Load animations
+	for (auto &gltf_animation : model.animations)
+	{
+		for (auto &gltf_channel : gltf_animation.channels)
+		{
+			auto &gltf_sampler = gltf_animation.samplers.at(gltf_channel.sampler);
+
+			sg::AnimationTarget target;
+			if (gltf_channel.target_path == "translation")
+			{
+				target = sg::AnimationTarget::Translation;
+			}
+			else if (gltf_channel.target_path == "rotation")
+			{
+				target = sg::AnimationTarget::Rotation;
+			}
+			else if (gltf_channel.target_path == "scale")
+			{
+				target = sg::AnimationTarget::Scale;
+			}
+			else
+			{
+				LOGW("Animation '{}' targets unsupported path '{}'", gltf_animation.name, gltf_channel.target_path);
+				continue;
+			}
+
+			auto &input_accessor  = model.accessors.at(gltf_sampler.input);
+			auto &output_accessor = model.accessors.at(gltf_sampler.output);
+
+			if (gltf_channel.target_node < 0 || gltf_sampler.interpolation != "LINEAR" ||
+			    input_accessor.componentType != TINYGLTF_COMPONENT_TYPE_FLOAT || output_accessor.componentType != TINYGLTF_COMPONENT_TYPE_FLOAT ||
+			    output_accessor.count < input_accessor.count)
+			{
+				LOGW("Animation '{}' has a channel with unsupported interpolation or data, only linear float keyframes are loaded", gltf_animation.name);
+				continue;
+			}
+
+			auto input_data    = get_attribute_data(&model, gltf_sampler.input);
+			auto input_stride  = get_attribute_stride(&model, gltf_sampler.input);
+			auto output_data   = get_attribute_data(&model, gltf_sampler.output);
+			auto output_stride = get_attribute_stride(&model, gltf_sampler.output);
+
+			size_t component_count = target == sg::AnimationTarget::Rotation ? 4 : 3;
+
+			std::vector<float>     times(input_accessor.count);
+			std::vector<glm::vec4> values(input_accessor.count, glm::vec4(0.0f));
+
+			for (size_t i = 0; i < times.size(); ++i)
+			{
+				std::memcpy(&times[i], &input_data[i * input_stride], sizeof(float));
+				std::memcpy(glm::value_ptr(values[i]), &output_data[i * output_stride], component_count * sizeof(float));
+			}
+
+			scene.get_animation_system().add_channel(nodes.at(gltf_channel.target_node)->get_transform(), target, times, values);
+		}
+	}
+
+	// Load scenes
+	std::queue<std::pair<sg::Node &, int>> traverse_nodes;
+
+	auto root_node = std::make_unique<sg::Node>(0, gltf_scene.name);
+
+	for (auto node_index : gltf_scene.nodes)
+	{
+		traverse_nodes.push(std::make_pair(std::ref(*root_node), node_index));
+	}
+
+	while (!traverse_nodes.empty())
+	{
+		auto node_it = traverse_nodes.front();
+		traverse_nodes.pop();
+
+		auto &current_node       = *nodes.at(node_it.second);
+		auto &traverse_root_node = node_it.first;
+
+		current_node.set_parent(traverse_root_node);
+		traverse_root_node.add_child(current_node);
+
+		for (auto child_node_index : model.nodes[node_it.second].children)
+		{
+			traverse_nodes.push(std::make_pair(std::ref(traverse_root_node), child_node_index));
+		}
+	}
+
+	scene.set_root_node(*root_node);
+	nodes.push_back(std::move(root_node));
+
+	// Store nodes into the scene
+	scene.set_nodes(std::move(nodes));
+
+	// Create node for the default camera
+	auto camera_node = std::make_unique<sg::Node>(-1, "default_camera");
+
+	auto default_camera = create_default_camera();
+	default_camera->set_node(*camera_node);
+	camera_node->set_component(*default_camera);
+	scene.add_component(std::move(default_camera));
+
+	scene.get_root_node().add_child(*camera_node);
+	scene.add_node(std::move(camera_node));
+
+	if (!scene.has_component<vkb::sg::Light>())
+	{
+		// Add a default light if none are present
+		vkb::add_directional_light(scene, glm::quat({glm::radians(-90.0f), 0.0f, glm::radians(30.0f)}));
+	}
+
+	return scene;
+}
+
+const tinygltf::Scene &GLTFLoader::get_gltf_scene(int scene_index) const
+{
+	if (scene_index >= 0 && scene_index < static_cast<int>(model.scenes.size()))
+	{
+		return model.scenes[scene_index];
+	}
+	else if (model.defaultScene >= 0 && model.defaultScene < static_cast<int>(model.scenes.size()))
+	{
+		return model.scenes[model.defaultScene];
+	}
+	else if (model.scenes.size() > 0)
+	{
+		return model.scenes[0];
+	}
+
+	throw std::runtime_error("Couldn't determine which scene to load!");
+}
+
+GLTFLoader::UsedResources GLTFLoader::find_used_resources(const tinygltf::Scene &gltf_scene) const
+{
+	UsedResources used;
+	used.nodes.resize(model.nodes.size(), false);
+	used.meshes.resize(model.meshes.size(), false);
+	used.materials.resize(model.materials.size(), false);
+	used.images.resize(model.images.size(), false);
+
+	// Nodes are visited with whether they are in a loaded subtree, every node is in one without subtrees
+	std::vector<bool>                visited(model.nodes.size(), false);
+	std::queue<std::pair<int, bool>> traverse_nodes;
+
+	for (auto node_index : gltf_scene.nodes)
+	{
+		traverse_nodes.push(std::make_pair(node_index, node_subtrees.empty()));
+	}
+
+	while (!traverse_nodes.empty())
+	{
+		auto node_index = traverse_nodes.front().first;
+		auto in_subtree = traverse_nodes.front().second;
+		traverse_nodes.pop();
+
+		if (node_index < 0 || node_index >= static_cast<int>(model.nodes.size()) || (visited[node_index] && (used.nodes[node_index] || !in_subtree)))
+		{
+			continue;
+		}
+
+		auto &gltf_node = model.nodes[node_index];
+
+		in_subtree = in_subtree || std::find(node_subtrees.begin(), node_subtrees.end(), gltf_node.name) != node_subtrees.end();
+
+		visited[node_index]    = true;
+		used.nodes[node_index] = in_subtree;
+
+		if (in_subtree && gltf_node.mesh >= 0 && gltf_node.mesh < static_cast<int>(used.meshes.size()))
+		{
+			used.meshes[gltf_node.mesh] = true;
+		}
+
+		for (auto child_node_index : gltf_node.children)
+		{
+			traverse_nodes.push(std::make_pair(child_node_index, in_subtree));
+		}
+	}
+
+	for (size_t mesh_index = 0; mesh_index < model.meshes.size(); ++mesh_index)
+	{
+		if (!used.meshes[mesh_index])
+		{
+			continue;
+		}
+
+		for (auto &gltf_primitive : model.meshes[mesh_index].primitives)
+		{
+			if (gltf_primitive.material >= 0 && gltf_primitive.material < static_cast<int>(used.materials.size()))
 			{
-				// Otherwise, if extension isn't required (but is in the file) then print a warning to the user
-				LOGW("glTF file contains an unsupported extension, unexpected results may occur: {}", used_extension);
+				used.materials[gltf_primitive.material] = true;
+			}
+		}
+	}
+
+	// Materials refer to images through their textures, with the value names parse_material reads
+	auto use_texture = [this, &used](const tinygltf::Parameter &parameter) {
+		auto texture_index = parameter.TextureIndex();
+
+		if (texture_index >= 0 && texture_index < static_cast<int>(model.textures.size()))
+		{
+			auto image_index = model.textures[texture_index].source;
+
+			if (image_index >= 0 && image_index < static_cast<int>(used.images.size()))
+			{
+				used.images[image_index] = true;
+			}
+		}
+	};
+
+	for (size_t material_index = 0; material_index < model.materials.size(); ++material_index)
+	{
+		if (!used.materials[material_index])
+		{
+			continue;
+		}
+
+		for (auto &gltf_value : model.materials[material_index].values)
+		{
+			if (gltf_value.first.find("Texture") != std::string::npos)
+			{
+				use_texture(gltf_value.second);
+			}
+		}
+
+		for (auto &gltf_value : model.materials[material_index].additionalValues)
+		{
+			if (gltf_value.first.find("Texture") != std::string::npos)
+			{
+				use_texture(gltf_value.second);
+			}
+		}
+	}
+
+	return used;
+}
+
+std::unique_ptr<sg::SubMesh> GLTFLoader::load_primitive(const tinygltf::Primitive &gltf_primitive)
+{
+	auto submesh = std::make_unique<sg::SubMesh>();
+
+	if (!mesh_optimization.enabled() || !load_optimized_primitive(gltf_primitive, *submesh))
+	{
+		for (auto &attribute : gltf_primitive.attributes)
+		{
+			std::string attrib_name = attribute.first;
+			std::transform(attrib_name.begin(), attrib_name.end(), attrib_name.begin(), ::tolower);
+
+			size_t vertex_data_size = 0;
+			auto   vertex_data      = get_attribute_view(&model, attribute.second, vertex_data_size);
+
+			if (attrib_name == "position")
+			{
+				submesh->vertices_count = to_u32(model.accessors.at(attribute.second).count);
+			}
+
+			// The accessor is copied straight from the glTF buffer into the mapped vertex buffer
+			core::Buffer buffer{device,
+			                    vertex_data_size,
+			                    VK_BUFFER_USAGE_VERTEX_BUFFER_BIT | geometry_buffer_usage,
+			                    VMA_MEMORY_USAGE_GPU_TO_CPU};
+			buffer.update(vertex_data, vertex_data_size);
+
+			submesh->vertex_buffers.insert(std::make_pair(attrib_name, std::move(buffer)));
+
+			sg::VertexAttribute attrib;
+			attrib.format = get_attribute_format(&model, attribute.second);
+			attrib.stride = to_u32(get_attribute_stride(&model, attribute.second));
+
+			submesh->set_attribute(attrib_name, attrib);
+		}
+
+		if (gltf_primitive.indices >= 0)
+		{
+			submesh->vertex_indices = to_u32(get_attribute_size(&model, gltf_primitive.indices));
+
+			auto format = get_attribute_format(&model, gltf_primitive.indices);
+
+			size_t index_data_size = 0;
+			auto   index_data      = get_attribute_view(&model, gltf_primitive.indices, index_data_size);
+
+			// Only 8-bit indices are converted, other indices are copied straight into the mapped index buffer
+			std::vector<uint8_t> converted_index_data;
+
+			switch (format)
+			{
+				case VK_FORMAT_R8_UINT:
+					// Converts uint8 data into uint16 data, still represented by a uint8 vector
+					converted_index_data = convert_underlying_data_stride(get_attribute_data(&model, gltf_primitive.indices), 1, 2);
+					index_data           = converted_index_data.data();
+					index_data_size      = converted_index_data.size();
+					submesh->index_type  = VK_INDEX_TYPE_UINT16;
+					break;
+				case VK_FORMAT_R16_UINT:
+					submesh->index_type = VK_INDEX_TYPE_UINT16;
+					break;
+				case VK_FORMAT_R32_UINT:
+					submesh->index_type = VK_INDEX_TYPE_UINT32;
+					break;
+				default:
+					LOGE("gltf primitive has invalid format type");
+					break;
 			}
+
+			submesh->index_buffer = std::make_unique<core::Buffer>(device,
+			                                                       index_data_size,
+			                                                       VK_BUFFER_USAGE_INDEX_BUFFER_BIT | geometry_buffer_usage,
+			                                                       VMA_MEMORY_USAGE_GPU_TO_CPU);
+
+			submesh->index_buffer->update(index_data, index_data_size);
 		}
 		else
 		{
-			// Extension is supported, so enable it
-			LOGI("glTF file contains extension: {}", used_extension);
-			it->second = true;
+			submesh->vertices_count = to_u32(get_attribute_size(&model, gltf_primitive.attributes.at("POSITION")));
 		}
 	}
 
-	// Load lights
-	std::vector<std::unique_ptr<sg::Light>> light_components = parse_khr_lights_punctual();
+	// Before compression, as meshlet bounds and triangle BVHs are computed from float positions
+	if (meshlets)
+	{
+		build_meshlets(*submesh);
+	}
 
-	scene.set_components(std::move(light_components));
+	if (ray_cast_geometry)
+	{
+		build_triangle_bvh(*submesh);
+	}
 
-	// Load samplers
-	std::vector<std::unique_ptr<sg::Sampler>>
-	    sampler_components(model.samplers.size());
+	if (vertex_compression)
+	{
+		compress_vertex_attributes(*submesh);
+	}
 
-	for (size_t sampler_index = 0; sampler_index < model.samplers.size(); sampler_index++)
+	if (interleaved_vertices)
 	{
-		auto sampler                      = parse_sampler(model.samplers.at(sampler_index));
-		sampler_components[sampler_index] = std::move(sampler);
+		interleave_vertex_buffers(*submesh);
 	}
 
-	scene.set_components(std::move(sampler_components));
 
-	Timer timer;
-	timer.start();
+	return submesh;
+}
 
-	// Load images
-	auto thread_count = std::thread::hardware_concurrency();
-	thread_count      = thread_count == 0 ? 1 : thread_count;
-	ctpl::thread_pool thread_pool(thread_count);
+bool GLTFLoader::load_optimized_primitive(const tinygltf::Primitive &gltf_primitive, sg::SubMesh &submesh)
+{
+	auto position_it = gltf_primitive.attributes.find("POSITION");
 
-	auto image_count = to_u32(model.images.size());
+	if (gltf_primitive.indices < 0 ||
+	    (gltf_primitive.mode != TINYGLTF_MODE_TRIANGLES && gltf_primitive.mode != -1) ||
+	    position_it == gltf_primitive.attributes.end() ||
+	    get_attribute_format(&model, position_it->second) != VK_FORMAT_R32G32B32_SFLOAT)
+	{
+		return false;
+	}
 
-	std::vector<std::future<std::unique_ptr<sg::Image>>> image_component_futures;
-	for (size_t image_index = 0; image_index < image_count; image_index++)
+	auto index_format = get_attribute_format(&model, gltf_primitive.indices);
+
+	if (index_format != VK_FORMAT_R8_UINT && index_format != VK_FORMAT_R16_UINT && index_format != VK_FORMAT_R32_UINT)
 	{
-		auto fut = thread_pool.push(
-		    [this, image_index](size_t) {
-			    auto image = parse_image(model.images.at(image_index));
+		return false;
+	}
 
-			    LOGI("Loaded gltf image #{} ({})", image_index, model.images.at(image_index).uri.c_str());
+	auto vertex_count = to_u32(get_attribute_size(&model, position_it->second));
 
-			    return image;
-		    });
+	std::vector<uint32_t> indices(get_attribute_size(&model, gltf_primitive.indices));
 
-		image_component_futures.push_back(std::move(fut));
+	auto index_data   = get_attribute_data(&model, gltf_primitive.indices);
+	auto index_stride = get_attribute_stride(&model, gltf_primitive.indices);
+
+	for (size_t i = 0; i < indices.size(); ++i)
+	{
+		const uint8_t *index = index_data.data() + i * index_stride;
+
+		switch (index_format)
+		{
+			case VK_FORMAT_R8_UINT:
+				indices[i] = *index;
+				break;
+			case VK_FORMAT_R16_UINT:
+				indices[i] = *reinterpret_cast<const uint16_t *>(index);
+				break;
+			default:
+				indices[i] = *reinterpret_cast<const uint32_t *>(index);
+				break;
+		}
+	}
+
+	if (indices.size() < 3 || *std::max_element(indices.begin(), indices.end()) >= vertex_count)
+	{
+		return false;
+	}
+
+	// The optimizer works on tightly packed attributes, interleaved ones are split
+	std::map<std::string, VertexStream> streams;
+
+	for (auto &attribute : gltf_primitive.attributes)
+	{
+		std::string attrib_name = attribute.first;
+		std::transform(attrib_name.begin(), attrib_name.end(), attrib_name.begin(), ::tolower);
+
+		auto &accessor = model.accessors.at(attribute.second);
+
+		VertexStream stream;
+		stream.format = get_attribute_format(&model, attribute.second);
+		stream.stride = to_u32(tinygltf::GetComponentSizeInBytes(accessor.componentType) * tinygltf::GetNumComponentsInType(accessor.type));
+		stream.data.resize(vertex_count * stream.stride);
+
+		auto vertex_data   = get_attribute_data(&model, attribute.second);
+		auto vertex_stride = get_attribute_stride(&model, attribute.second);
+
+		for (size_t i = 0; i < std::min<size_t>(vertex_count, accessor.count); ++i)
+		{
+			std::memcpy(stream.data.data() + i * stream.stride, vertex_data.data() + i * vertex_stride, stream.stride);
+		}
+
+		streams.emplace(attrib_name, std::move(stream));
+	}
+
+	size_t key = 0;
+	hash_combine(key, MESH_CACHE_VERSION);
+	hash_combine(key, mesh_optimization.vertex_cache);
+	hash_combine(key, mesh_optimization.overdraw);
+	hash_combine(key, mesh_optimization.vertex_fetch);
+	hash_combine(key, mesh_optimization.quantize);
+	hash_combine(key, mesh_optimization.overdraw_threshold);
+	hash_combine(key, mesh_optimization.lod_count);
+	hash_combine(key, mesh_optimization.lod_reduction);
+	hash_bytes(key, indices.data(), indices.size() * sizeof(uint32_t));
+
+	for (auto &stream : streams)
+	{
+		hash_combine(key, stream.first);
+		hash_combine(key, stream.second.format);
+		hash_bytes(key, stream.second.data.data(), stream.second.data.size());
+	}
+
+	std::vector<MeshLod> lods;
+
+	if (!mesh_optimization.cache || !read_mesh_cache(key, indices, streams, vertex_count, lods))
+	{
+		float miss_ratio = get_vertex_cache_miss_ratio(indices, vertex_count);
+
+		optimize_mesh(indices, streams, vertex_count, mesh_optimization);
+
+		LOGD("Optimized primitive of {} triangles, vertex cache miss ratio {:.3f} -> {:.3f}",
+		     indices.size() / 3, miss_ratio, get_vertex_cache_miss_ratio(indices, vertex_count));
+
+		if (mesh_optimization.lod_count > 0)
+		{
+			std::vector<glm::vec3> positions(vertex_count);
+			std::memcpy(positions.data(), streams.at("position").data.data(), vertex_count * sizeof(glm::vec3));
+
+			lods = generate_lods(indices, positions, mesh_optimization);
+		}
+
+		if (mesh_optimization.cache)
+		{
+			write_mesh_cache(key, indices, streams, vertex_count, lods);
+		}
+	}
+
+	for (auto &stream : streams)
+	{
+		core::Buffer buffer{device,
+		                    stream.second.data.size(),
+		                    VK_BUFFER_USAGE_VERTEX_BUFFER_BIT | geometry_buffer_usage,
+		                    VMA_MEMORY_USAGE_GPU_TO_CPU};
+		buffer.update(stream.second.data);
+
+		submesh.vertex_buffers.insert(std::make_pair(stream.first, std::move(buffer)));
+
+		sg::VertexAttribute attrib;
+		attrib.format = stream.second.format;
+		attrib.stride = stream.second.stride;
+
+		submesh.set_attribute(stream.first, attrib);
+	}
+
+	submesh.vertices_count = vertex_count;
+	submesh.vertex_indices = to_u32(indices.size());
+
+	// The levels of detail follow the full sub mesh in the index buffer
+	for (auto &lod : lods)
+	{
+		sg::LevelOfDetail level;
+		level.first_index = to_u32(indices.size());
+		level.index_count = to_u32(lod.indices.size());
+		level.error       = lod.error;
+
+		submesh.lods.push_back(level);
+
+		indices.insert(indices.end(), lod.indices.begin(), lod.indices.end());
+	}
+
+	std::vector<uint8_t> buffer_data;
+
+	if (vertex_count <= std::numeric_limits<uint16_t>::max())
+	{
+		std::vector<uint16_t> short_indices(indices.begin(), indices.end());
+
+		auto bytes = reinterpret_cast<const uint8_t *>(short_indices.data());
+		buffer_data.assign(bytes, bytes + short_indices.size() * sizeof(uint16_t));
+
+		submesh.index_type = VK_INDEX_TYPE_UINT16;
+	}
+	else
+	{
+		auto bytes = reinterpret_cast<const uint8_t *>(indices.data());
+		buffer_data.assign(bytes, bytes + indices.size() * sizeof(uint32_t));
+
+		submesh.index_type = VK_INDEX_TYPE_UINT32;
 	}
 
-	std::vector<std::unique_ptr<sg::Image>> image_components;
-	for (auto &fut : image_component_futures)
+	submesh.index_buffer = std::make_unique<core::Buffer>(device,
+	                                                      buffer_data.size(),
+	                                                      VK_BUFFER_USAGE_INDEX_BUFFER_BIT | geometry_buffer_usage,
+	                                                      VMA_MEMORY_USAGE_GPU_TO_CPU);
+
+	submesh.index_buffer->update(buffer_data);
+
+	return true;
+}
+
+/**
+ * @brief Reads the float positions of a sub mesh back from its mapped vertex buffer
+ * @return False if the sub mesh has no such positions
+ */
+inline bool read_float_positions(const sg::SubMesh &submesh, std::vector<glm::vec3> &positions)
+{
+	auto position_it = submesh.vertex_buffers.find("position");
+
+	sg::VertexAttribute position_attribute;
+
+	if (position_it == submesh.vertex_buffers.end() || !position_it->second.get_data() ||
+	    !submesh.get_attribute("position", position_attribute) || position_attribute.format != VK_FORMAT_R32G32B32_SFLOAT)
+	{
+		return false;
+	}
+
+	positions.resize(submesh.vertices_count);
+
+	const uint8_t *position_data = position_it->second.get_data() + position_attribute.offset;
+
+	for (size_t v = 0; v < positions.size(); ++v)
+	{
+		positions[v] = glm::make_vec3(reinterpret_cast<const float *>(position_data + v * position_attribute.stride));
+	}
+
+	return true;
+}
+
+/**
+ * @brief Reads the indices of a sub mesh back from its mapped index buffer
+ * @return False if the sub mesh is not indexed
+ */
+inline bool read_indices(const sg::SubMesh &submesh, std::vector<uint32_t> &indices)
+{
+	if (submesh.vertex_indices == 0 || !submesh.index_buffer || !submesh.index_buffer->get_data())
+	{
+		return false;
+	}
+
+	indices.resize(submesh.vertex_indices);
+
+	const uint8_t *index_data = submesh.index_buffer->get_data() + submesh.index_offset;
+
+	for (size_t i = 0; i < indices.size(); ++i)
 	{
-		image_components.push_back(fut.get());
+		if (submesh.index_type == VK_INDEX_TYPE_UINT16)
+		{
+			indices[i] = reinterpret_cast<const uint16_t *>(index_data)[i];
+		}
+		else
+		{
+			indices[i] = reinterpret_cast<const uint32_t *>(index_data)[i];
+		}
 	}
 
-	// Upload images to GPU
-	std::vector<core::Buffer> transient_buffers;
-
-	auto &command_buffer = device.request_command_buffer();
+	return true;
+}
 
-	command_buffer.begin(VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT, 0);
+void GLTFLoader::build_meshlets(sg::SubMesh &submesh)
+{
+	std::vector<uint32_t>  indices;
+	std::vector<glm::vec3> positions;
 
-	for (size_t image_index = 0; image_index < image_count; image_index++)
+	if (!read_indices(submesh, indices) || !read_float_positions(submesh, positions))
 	{
-		auto &image = image_components.at(image_index);
-
-		core::Buffer stage_buffer{device,
-		                          image->get_data().size(),
-		                          VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
-		                          VMA_MEMORY_USAGE_CPU_ONLY};
+		return;
+	}
 
-		stage_buffer.update(image->get_data());
+	std::vector<sg::Meshlet> meshlet_data;
+	std::vector<uint32_t>    meshlet_vertices;
+	std::vector<uint8_t>     meshlet_triangles;
 
-		upload_image_to_gpu(command_buffer, stage_buffer, *image);
+	sg::MeshletBuilder{}.build(indices, positions, meshlet_data, meshlet_vertices, meshlet_triangles);
 
-		transient_buffers.push_back(std::move(stage_buffer));
+	if (meshlet_data.empty())
+	{
+		return;
 	}
 
-	command_buffer.end();
-
-	auto &queue = device.get_queue_by_flags(VK_QUEUE_GRAPHICS_BIT, 0);
+	auto create_buffer = [this](const void *data, size_t size) {
+		auto buffer = std::make_unique<core::Buffer>(device, size, VK_BUFFER_USAGE_STORAGE_BUFFER_BIT, VMA_MEMORY_USAGE_CPU_TO_GPU);
+		buffer->update(reinterpret_cast<const uint8_t *>(data), size);
+		return buffer;
+	};
 
-	queue.submit(command_buffer, device.request_fence());
+	submesh.meshlet_buffer          = create_buffer(meshlet_data.data(), meshlet_data.size() * sizeof(sg::Meshlet));
+	submesh.meshlet_vertex_buffer   = create_buffer(meshlet_vertices.data(), meshlet_vertices.size() * sizeof(uint32_t));
+	submesh.meshlet_triangle_buffer = create_buffer(meshlet_triangles.data(), meshlet_triangles.size());
+	submesh.meshlet_count           = to_u32(meshlet_data.size());
+}
 
-	device.get_fence_pool().wait();
-	device.get_fence_pool().reset();
-	device.get_command_pool().reset_pool();
-	device.wait_idle();
+void GLTFLoader::build_triangle_bvh(sg::SubMesh &submesh)
+{
+	std::vector<uint32_t>  indices;
+	std::vector<glm::vec3> positions;
 
-	transient_buffers.clear();
+	if (!read_float_positions(submesh, positions))
+	{
+		return;
+	}
 
-	scene.set_components(std::move(image_components));
+	if (!read_indices(submesh, indices))
+	{
+		indices.resize(positions.size());
+		std::iota(indices.begin(), indices.end(), 0u);
+	}
 
-	auto elapsed_time = timer.stop();
+	submesh.triangle_bvh = std::make_unique<TriangleBVH>();
+	submesh.triangle_bvh->build(std::move(positions), std::move(indices));
+}
 
-	LOGI("Time spent loading images: {} seconds across {} threads.", vkb::to_string(elapsed_time), thread_count);
+/**
+ * @brief Maps a unit vector to the octahedron unfolded on the [-1, 1] square
+ */
+inline glm::vec2 octahedral_encode(const glm::vec3 &n)
+{
+	glm::vec3 p = n / std::max(std::abs(n.x) + std::abs(n.y) + std::abs(n.z), 1e-20f);
 
-	// Load textures
-	auto images          = scene.get_components<sg::Image>();
-	auto samplers        = scene.get_components<sg::Sampler>();
-	auto default_sampler = create_default_sampler();
+	glm::vec2 e{p.x, p.y};
 
-	for (auto &gltf_texture : model.textures)
+	if (p.z < 0.0f)
 	{
-		auto texture = parse_texture(gltf_texture);
+		// The lower half is folded over the diagonals
+		e = (1.0f - glm::abs(glm::vec2{p.y, p.x})) * glm::vec2{p.x >= 0.0f ? 1.0f : -1.0f, p.y >= 0.0f ? 1.0f : -1.0f};
+	}
 
-		texture->set_image(*images.at(gltf_texture.source));
+	return e;
+}
 
-		if (gltf_texture.sampler >= 0 && gltf_texture.sampler < static_cast<int>(samplers.size()))
+void GLTFLoader::compress_vertex_attributes(sg::SubMesh &submesh)
+{
+	auto read_attribute = [&submesh](const std::string &name, VkFormat format, sg::VertexAttribute &attribute) -> const uint8_t * {
+		auto buffer_it = submesh.vertex_buffers.find(name);
+
+		if (buffer_it == submesh.vertex_buffers.end() || !buffer_it->second.get_data() ||
+		    !submesh.get_attribute(name, attribute) || attribute.format != format)
 		{
-			texture->set_sampler(*samplers.at(gltf_texture.sampler));
+			return nullptr;
 		}
-		else
-		{
-			if (gltf_texture.name.empty())
-			{
-				gltf_texture.name = images.at(gltf_texture.source)->get_name();
-			}
 
-			texture->set_sampler(*default_sampler);
-		}
+		return buffer_it->second.get_data() + attribute.offset;
+	};
 
-		scene.add_component(std::move(texture));
-	}
+	auto write_attribute = [this, &submesh](const std::string &name, VkFormat format, const std::vector<uint8_t> &data) {
+		core::Buffer buffer{device,
+		                    data.size(),
+		                    VK_BUFFER_USAGE_VERTEX_BUFFER_BIT | geometry_buffer_usage,
+		                    VMA_MEMORY_USAGE_GPU_TO_CPU};
+		buffer.update(data);
 
-	scene.add_component(std::move(default_sampler));
+		submesh.vertex_buffers.erase(name);
+		submesh.vertex_buffers.insert(std::make_pair(name, std::move(buffer)));
 
-	// Load materials
-	bool                            has_textures = scene.has_component<sg::Texture>();
-	std::vector<vkb::sg::Texture *> textures;
-	if (has_textures)
+		sg::VertexAttribute attribute;
+		attribute.format = format;
+		attribute.stride = to_u32(data.size() / submesh.vertices_count);
+
+		submesh.set_attribute(name, attribute);
+	};
+
+	if (submesh.vertices_count == 0)
 	{
-		textures = scene.get_components<sg::Texture>();
+		return;
 	}
 
-	for (auto &gltf_material : model.materials)
+	sg::VertexAttribute attribute;
+
+	if (auto source = read_attribute("position", VK_FORMAT_R32G32B32_SFLOAT, attribute))
 	{
-		auto material = parse_material(gltf_material);
+		glm::vec3 min{std::numeric_limits<float>::max()};
+		glm::vec3 max{std::numeric_limits<float>::lowest()};
 
-		for (auto &gltf_value : gltf_material.values)
+		for (size_t v = 0; v < submesh.vertices_count; ++v)
 		{
-			if (gltf_value.first.find("Texture") != std::string::npos)
-			{
-				std::string tex_name = to_snake_case(gltf_value.first);
+			auto position = glm::make_vec3(reinterpret_cast<const float *>(source + v * attribute.stride));
 
-				material->textures[tex_name] = textures.at(gltf_value.second.TextureIndex());
-			}
+			min = glm::min(min, position);
+			max = glm::max(max, position);
 		}
 
-		for (auto &gltf_value : gltf_material.additionalValues)
+		// Flat sub meshes keep a scale of 1 on their flat axis
+		glm::vec3 extent = max - min;
+		extent           = glm::vec3{extent.x > 0.0f ? extent.x : 1.0f, extent.y > 0.0f ? extent.y : 1.0f, extent.z > 0.0f ? extent.z : 1.0f};
+
+		std::vector<uint8_t> data(submesh.vertices_count * 4 * sizeof(uint16_t));
+		auto                 quantized = reinterpret_cast<uint16_t *>(data.data());
+
+		for (size_t v = 0; v < submesh.vertices_count; ++v)
 		{
-			if (gltf_value.first.find("Texture") != std::string::npos)
-			{
-				std::string tex_name = to_snake_case(gltf_value.first);
+			auto position = glm::make_vec3(reinterpret_cast<const float *>(source + v * attribute.stride));
 
-				material->textures[tex_name] = textures.at(gltf_value.second.TextureIndex());
-			}
+			glm::vec3 normalized = (position - min) / extent;
+
+			quantized[v * 4 + 0] = glm::packUnorm1x16(normalized.x);
+			quantized[v * 4 + 1] = glm::packUnorm1x16(normalized.y);
+			quantized[v * 4 + 2] = glm::packUnorm1x16(normalized.z);
+			quantized[v * 4 + 3] = 0xFFFF;
 		}
 
-		scene.add_component(std::move(material));
-	}
+		write_attribute("position", VK_FORMAT_R16G16B16A16_UNORM, data);
 
-	auto default_material = create_default_material();
+		// Read by the vertex shader as the std140 offset and scale of the positions
+		glm::vec4 dequantization[2] = {glm::vec4{min, 0.0f}, glm::vec4{extent, 0.0f}};
 
-	// Load meshes
-	auto materials = scene.get_components<sg::PBRMaterial>();
+		submesh.position_dequantization = std::make_unique<core::Buffer>(device, sizeof(dequantization), VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT, VMA_MEMORY_USAGE_CPU_TO_GPU);
+		submesh.position_dequantization->update(reinterpret_cast<const uint8_t *>(dequantization), sizeof(dequantization));
+	}
 
-	for (auto &gltf_mesh : model.meshes)
+	if (auto source = read_attribute("normal", VK_FORMAT_R32G32B32_SFLOAT, attribute))
 	{
-		auto mesh = parse_mesh(gltf_mesh);
+		std::vector<uint8_t> data(submesh.vertices_count * 2 * sizeof(uint16_t));
+		auto                 encoded = reinterpret_cast<uint16_t *>(data.data());
 
-		for (auto &gltf_primitive : gltf_mesh.primitives)
+		for (size_t v = 0; v < submesh.vertices_count; ++v)
 		{
-			auto submesh = std::make_unique<sg::SubMesh>();
-
-			for (auto &attribute : gltf_primitive.attributes)
-			{
-				std::string attrib_name = attribute.first;
-				std::transform(attrib_name.begin(), attrib_name.end(), attrib_name.begin(), ::tolower);
+			auto e = octahedral_encode(glm::make_vec3(reinterpret_cast<const float *>(source + v * attribute.stride)));
 
-				auto vertex_data = get_attribute_data(&model, attribute.second);
+			encoded[v * 2 + 0] = glm::packSnorm1x16(e.x);
+			encoded[v * 2 + 1] = glm::packSnorm1x16(e.y);
+		}
 
-				if (attrib_name == "position")
-				{
-					submesh->vertices_count = to_u32(model.accessors.at(attribute.second).count);
-				}
+		write_attribute("normal", VK_FORMAT_R16G16_SNORM, data);
+	}
 
-				core::Buffer buffer{device,
-				                    vertex_data.size(),
-				                    VK_BUFFER_USAGE_VERTEX_BUFFER_BIT,
-				                    VMA_MEMORY_USAGE_GPU_TO_CPU};
-				buffer.update(vertex_data);
+	if (auto source = read_attribute("tangent", VK_FORMAT_R32G32B32A32_SFLOAT, attribute))
+	{
+		std::vector<uint8_t> data(submesh.vertices_count * 4 * sizeof(uint16_t));
+		auto                 encoded = reinterpret_cast<uint16_t *>(data.data());
 
-				submesh->vertex_buffers.insert(std::make_pair(attrib_name, std::move(buffer)));
+		for (size_t v = 0; v < submesh.vertices_count; ++v)
+		{
+			auto tangent = glm::make_vec4(reinterpret_cast<const float *>(source + v * attribute.stride));
+			auto e       = octahedral_encode(glm::vec3{tangent});
+
+			// The handedness of the bitangent is kept in the third component
+			encoded[v * 4 + 0] = glm::packSnorm1x16(e.x);
+			encoded[v * 4 + 1] = glm::packSnorm1x16(e.y);
+			encoded[v * 4 + 2] = glm::packSnorm1x16(tangent.w < 0.0f ? -1.0f : 1.0f);
+			encoded[v * 4 + 3] = 0;
+		}
 
-				sg::VertexAttribute attrib;
-				attrib.format = get_attribute_format(&model, attribute.second);
-				attrib.stride = to_u32(get_attribute_stride(&model, attribute.second));
+		write_attribute("tangent", VK_FORMAT_R16G16B16A16_SNORM, data);
+	}
 
-				submesh->set_attribute(attrib_name, attrib);
-			}
+	for (auto &name : {"texcoord_0", "texcoord_1"})
+	{
+		if (auto source = read_attribute(name, VK_FORMAT_R32G32_SFLOAT, attribute))
+		{
+			std::vector<uint8_t> data(submesh.vertices_count * 2 * sizeof(uint16_t));
+			auto                 encoded = reinterpret_cast<uint16_t *>(data.data());
 
-			if (gltf_primitive.indices >= 0)
+			for (size_t v = 0; v < submesh.vertices_count; ++v)
 			{
-				submesh->vertex_indices = to_u32(get_attribute_size(&model, gltf_primitive.indices));
+				auto uv = reinterpret_cast<const float *>(source + v * attribute.stride);
 
-				auto format = get_attribute_format(&model, gltf_primitive.indices);
-
-				auto vertex_data = get_attribute_data(&model, gltf_primitive.indices);
-				auto index_data  = get_attribute_data(&model, gltf_primitive.indices);
-
-				switch (format)
-				{
-					case VK_FORMAT_R8_UINT:
-						// Converts uint8 data into uint16 data, still represented by a uint8 vector
-						index_data          = convert_underlying_data_stride(index_data, 1, 2);
-						submesh->index_type = VK_INDEX_TYPE_UINT16;
-						break;
-					case VK_FORMAT_R16_UINT:
-						submesh->index_type = VK_INDEX_TYPE_UINT16;
-						break;
-					case VK_FORMAT_R32_UINT:
-						submesh->index_type = VK_INDEX_TYPE_UINT32;
-						break;
-					default:
-						LOGE("gltf primitive has invalid format type");
-						break;
-				}
+				encoded[v * 2 + 0] = glm::packHalf1x16(uv[0]);
+				encoded[v * 2 + 1] = glm::packHalf1x16(uv[1]);
+			}
 
-				submesh->index_buffer = std::make_unique<core::Buffer>(device,
-				                                                       index_data.size(),
-				                                                       VK_BUFFER_USAGE_INDEX_BUFFER_BIT,
-				                                                       VMA_MEMORY_USAGE_GPU_TO_CPU);
+			write_attribute(name, VK_FORMAT_R16G16_SFLOAT, data);
+		}
+	}
+}
 
-				submesh->index_buffer->update(index_data);
-			}
-			else
-			{
-				submesh->vertices_count = to_u32(get_attribute_size(&model, gltf_primitive.attributes.at("POSITION")));
-			}
+void GLTFLoader::interleave_vertex_buffers(sg::SubMesh &submesh)
+{
+	using NamedAttribute = std::pair<std::string, sg::VertexAttribute>;
 
-			if (gltf_primitive.material < 0)
-			{
-				submesh->set_material(*default_material);
-			}
-			else
-			{
-				submesh->set_material(*materials.at(gltf_primitive.material));
-			}
+	std::vector<NamedAttribute> attributes;
 
-			mesh->add_submesh(*submesh);
+	for (auto &vertex_buffer : submesh.vertex_buffers)
+	{
+		sg::VertexAttribute attribute;
 
-			scene.add_component(std::move(submesh));
+		if (!submesh.get_attribute(vertex_buffer.first, attribute) || !vertex_buffer.second.get_data() || get_bits_per_pixel(attribute.format) <= 0)
+		{
+			return;
 		}
 
-		scene.add_component(std::move(mesh));
+		attributes.emplace_back(vertex_buffer.first, attribute);
 	}
 
-	device.get_fence_pool().wait();
-	device.get_fence_pool().reset();
-	device.get_command_pool().reset_pool();
+	if (attributes.empty())
+	{
+		return;
+	}
 
-	transient_buffers.clear();
+	// Position comes first, the other attributes follow in name order
+	std::sort(attributes.begin(), attributes.end(), [](const NamedAttribute &a, const NamedAttribute &b) {
+		if ((a.first == "position") != (b.first == "position"))
+		{
+			return a.first == "position";
+		}
+		return a.first < b.first;
+	});
 
-	scene.add_component(std::move(default_material));
+	// Attributes are aligned to 4 bytes within a vertex
+	std::vector<uint32_t> offsets;
+	uint32_t              vertex_stride{0};
 
-	// Load cameras
-	for (auto &gltf_camera : model.cameras)
+	for (auto &attribute : attributes)
 	{
-		auto camera = parse_camera(gltf_camera);
-		scene.add_component(std::move(camera));
+		offsets.push_back(vertex_stride);
+		vertex_stride += (to_u32(get_bits_per_pixel(attribute.second.format)) / 8 + 3) & ~3u;
 	}
 
-	// Load nodes
-	auto meshes = scene.get_components<sg::Mesh>();
-
-	std::vector<std::unique_ptr<sg::Node>> nodes;
+	std::vector<uint8_t> vertex_data(static_cast<size_t>(submesh.vertices_count) * vertex_stride);
 
-	for (size_t node_index = 0; node_index < model.nodes.size(); ++node_index)
+	for (size_t i = 0; i < attributes.size(); ++i)
 	{
-		auto gltf_node = model.nodes[node_index];
-		auto node      = parse_node(gltf_node, node_index);
+		auto &attribute = attributes[i].second;
+		auto &source    = submesh.vertex_buffers.at(attributes[i].first);
+
+		size_t element_size = to_u32(get_bits_per_pixel(attribute.format)) / 8;
 
-		if (gltf_node.mesh >= 0)
+		for (size_t v = 0; v < submesh.vertices_count; ++v)
 		{
-			auto mesh = meshes.at(gltf_node.mesh);
+			size_t source_offset = attribute.offset + v * attribute.stride;
 
-			node->set_component(*mesh);
+			if (source_offset + element_size > source.get_size())
+			{
+				break;
+			}
 
-			mesh->add_node(*node);
+			std::memcpy(vertex_data.data() + v * vertex_stride + offsets[i], source.get_data() + source_offset, element_size);
 		}
 
-		if (gltf_node.camera >= 0)
-		{
-			auto cameras = scene.get_components<sg::Camera>();
-			auto camera  = cameras.at(gltf_node.camera);
+		attribute.offset = offsets[i];
+		attribute.stride = vertex_stride;
 
-			node->set_component(*camera);
+		submesh.set_attribute(attributes[i].first, attribute);
+	}
 
-			camera->set_node(*node);
-		}
+	submesh.interleaved_vertex_buffer = std::make_unique<core::Buffer>(device,
+	                                                                   vertex_data.size(),
+	                                                                   VK_BUFFER_USAGE_VERTEX_BUFFER_BIT | geometry_buffer_usage,
+	                                                                   VMA_MEMORY_USAGE_GPU_TO_CPU);
 
-		if (auto extension = get_extension(gltf_node.extensions, KHR_LIGHTS_PUNCTUAL_EXTENSION))
-		{
-			auto lights = scene.get_components<sg::Light>();
-			auto light  = lights.at(static_cast<size_t>(extension->Get("light").Get<int>()));
+	submesh.interleaved_vertex_buffer->update(vertex_data);
 
-			node->set_component(*light);
+	submesh.vertex_stride = vertex_stride;
+	submesh.vertex_buffers.clear();
+}
 
-			light->set_node(*node);
-		}
+void GLTFLoader::move_to_shared_geometry_buffers(sg::Scene &scene)
+{
+	if (!shared_geometry_buffers || !scene.has_component<sg::SubMesh>())
+	{
+		return;
+	}
 
-		nodes.push_back(std::move(node));
+	auto &allocator = device.get_geometry_allocator();
+
+	auto submeshes = scene.get_components<sg::SubMesh>();
+
+	for (auto submesh : submeshes)
+	{
+		submesh->move_to_geometry_buffers(allocator, VK_BUFFER_USAGE_VERTEX_BUFFER_BIT | VK_BUFFER_USAGE_INDEX_BUFFER_BIT | geometry_buffer_usage);
 	}
 
-	// Load scenes
-	std::queue<std::pair<sg::Node &, int>> traverse_nodes;
+	// Work submitted to the graphics queue afterwards draws the sub meshes
+	device.get_staging_manager().flush();
 
-	tinygltf::Scene *gltf_scene{nullptr};
+	LOGI("Moved the geometry of {} sub meshes to {} shared geometry buffers ({} bytes)", submeshes.size(), allocator.get_buffer_count(), allocator.get_allocated_size());
+}
 
-	if (scene_index >= 0 && scene_index < static_cast<int>(model.scenes.size()))
+uint64_t GLTFLoader::get_scene_cache_key(const std::string &gltf_file, int scene_index) const
+{
+	size_t key = 0;
+	hash_combine(key, sg::SceneCache::VERSION);
+	hash_combine(key, gltf_file);
+	hash_combine(key, scene_index);
+	for (auto &node_name : node_subtrees)
 	{
-		gltf_scene = &model.scenes[scene_index];
+		hash_combine(key, node_name);
 	}
-	else if (model.defaultScene >= 0 && model.defaultScene < static_cast<int>(model.scenes.size()))
+	hash_combine(key, gpu_mipmap_generation);
+	hash_combine(key, interleaved_vertices);
+	hash_combine(key, mesh_optimization.enabled());
+	hash_combine(key, mesh_optimization.vertex_cache);
+	hash_combine(key, mesh_optimization.overdraw);
+	hash_combine(key, mesh_optimization.vertex_fetch);
+	hash_combine(key, mesh_optimization.quantize);
+	hash_combine(key, mesh_optimization.overdraw_threshold);
+	hash_combine(key, mesh_optimization.lod_count);
+	hash_combine(key, mesh_optimization.lod_reduction);
+
+	// Cached ASTC images are decoded when the device doesn't support them
+	hash_combine(key, device.is_image_format_supported(VK_FORMAT_ASTC_4x4_UNORM_BLOCK));
+
+	try
 	{
-		gltf_scene = &model.scenes[model.defaultScene];
+		auto file = fs::map_file(gltf_file);
+		hash_combine(key, std::string{reinterpret_cast<const char *>(file.data()), file.size()});
 	}
-	else if (model.scenes.size() > 0)
+	catch (const std::runtime_error &)
 	{
-		gltf_scene = &model.scenes[0];
+		// The load fails later on, when the file is parsed
 	}
 
-	if (!gltf_scene)
+	return key;
+}
+
+std::unique_ptr<sg::Scene> GLTFLoader::read_scene_cache(uint64_t key)
+{
+	PROFILE_FUNCTION();
+
+	std::unique_ptr<sg::Scene> scene;
+
+	try
 	{
-		throw std::runtime_error("Couldn't determine which scene to load!");
-	}
+		auto file = fs::map_temp(get_scene_cache_filename(key));
+
+		uint64_t stored_key{0};
+		if (file.size() < sizeof(stored_key))
+		{
+			return nullptr;
+		}
+		std::memcpy(&stored_key, file.data(), sizeof(stored_key));
 
-	auto root_node = std::make_unique<sg::Node>(0, gltf_scene->name);
+		if (stored_key != key)
+		{
+			return nullptr;
+		}
 
-	for (auto node_index : gltf_scene->nodes)
+		scene = sg::SceneCache::read(device, file.data() + sizeof(stored_key), file.size() - sizeof(stored_key), geometry_buffer_usage);
+	}
+	catch (const std::runtime_error &ex)
 	{
-		traverse_nodes.push(std::make_pair(std::ref(*root_node), node_index));
+		LOGD("Scene cache not used. {}", ex.what());
+		return nullptr;
 	}
 
-	while (!traverse_nodes.empty())
+	// The images are already decoded, they only need to be uploaded
+	ImageUploader image_uploader{device, staging_buffer_size, use_transfer_queue, keep_image_data};
+
+	for (auto image : scene->get_components<sg::Image>())
 	{
-		auto node_it = traverse_nodes.front();
-		traverse_nodes.pop();
+		image->create_vk_image(device);
+		image_uploader.upload(*image);
+	}
 
-		auto &current_node       = *nodes.at(node_it.second);
-		auto &traverse_root_node = node_it.first;
+	image_uploader.finish();
 
-		current_node.set_parent(traverse_root_node);
-		traverse_root_node.add_child(current_node);
+	return scene;
+}
 
-		for (auto child_node_index : model.nodes[node_it.second].children)
-		{
-			traverse_nodes.push(std::make_pair(std::ref(traverse_root_node), child_node_index));
-		}
+void GLTFLoader::write_scene_cache(uint64_t key, sg::Scene &scene)
+{
+	// The samplers of the scene are those of the glTF file followed by the default sampler
+	std::vector<VkSamplerCreateInfo> sampler_infos;
+	for (auto &gltf_sampler : model.samplers)
+	{
+		sampler_infos.push_back(get_sampler_info(gltf_sampler));
 	}
+	sampler_infos.push_back(get_sampler_info(get_default_gltf_sampler()));
 
-	scene.set_root_node(*root_node);
-	nodes.push_back(std::move(root_node));
-
-	// Store nodes into the scene
-	scene.set_nodes(std::move(nodes));
+	try
+	{
+		auto cache = sg::SceneCache::write(scene, packed_scene_images, sampler_infos);
 
-	// Create node for the default camera
-	auto camera_node = std::make_unique<sg::Node>(-1, "default_camera");
+		std::vector<uint8_t> file_data(sizeof(key));
+		std::memcpy(file_data.data(), &key, sizeof(key));
+		file_data.insert(file_data.end(), cache.begin(), cache.end());
 
-	auto default_camera = create_default_camera();
-	default_camera->set_node(*camera_node);
-	camera_node->set_component(*default_camera);
-	scene.add_component(std::move(default_camera));
+		auto temp_directory = fs::path::get(fs::path::Type::Temp);
 
-	scene.get_root_node().add_child(*camera_node);
-	scene.add_node(std::move(camera_node));
+		if (!fs::is_directory(temp_directory + SCENE_CACHE_FOLDER))
+		{
+			fs::create_path(temp_directory, SCENE_CACHE_FOLDER);
+		}
 
-	if (!scene.has_component<vkb::sg::Light>())
+		fs::write_temp(file_data, get_scene_cache_filename(key));
+	}
+	catch (const std::runtime_error &ex)
 	{
-		// Add a default light if none are present
-		vkb::add_directional_light(scene, glm::quat({glm::radians(-90.0f), 0.0f, glm::radians(30.0f)}));
+		LOGW("Failed to cache scene. {}", ex.what());
 	}
-
-	return scene;
 }
 
 std::unique_ptr<sg::SubMesh> GLTFLoader::load_model(uint32_t index)
@@ -839,7 +2813,7 @@ std::unique_ptr<sg::SubMesh> GLTFLoader::load_model(uint32_t index)
 
 	std::vector<core::Buffer> transient_buffers;
 
-	auto &queue = device.get_queue_by_flags(VK_QUEUE_GRAPHICS_BIT, 0);
+	auto &queue = device.get_queue_by_role(QueueRole::Graphics);
 
 	auto &command_buffer = device.request_command_buffer();
 
@@ -978,10 +2952,14 @@ std::unique_ptr<sg::SubMesh> GLTFLoader::load_model(uint32_t index)
 
 	command_buffer.end();
 
-	queue.submit(command_buffer, device.request_fence());
+	auto &fence_pool = device.get_transient_fence_pool();
+
+	VkFence fence = fence_pool.request_fence();
+
+	queue.submit(command_buffer, fence);
+
+	VK_CHECK(fence_pool.wait(fence));
 
-	device.get_fence_pool().wait();
-	device.get_fence_pool().reset();
 	device.get_command_pool().reset_pool();
 
 	return std::move(submesh);
@@ -1140,6 +3118,26 @@ std::unique_ptr<sg::Image> GLTFLoader::parse_image(tinygltf::Image &gltf_image)
 		image          = sg::Image::load(gltf_image.name, image_uri);
 	}
 
+	return prepare_image(std::move(image));
+}
+
+std::unique_ptr<sg::Image> GLTFLoader::parse_image_file(const tinygltf::Image &gltf_image, const std::string &image_file, const std::vector<uint8_t> &file_data) const
+{
+	auto image_uri = model_path + "/" + gltf_image.uri;
+
+	auto image = sg::Image::decode(gltf_image.name, image_uri, file_data.data(), file_data.size());
+
+	// Cached before its format is adapted to the device, so that any device can use it
+	if (asset_memory_cache)
+	{
+		AssetMemoryCache::get().store_image(image_file, image->pack());
+	}
+
+	return prepare_image(std::move(image));
+}
+
+std::unique_ptr<sg::Image> GLTFLoader::prepare_image(std::unique_ptr<sg::Image> image) const
+{
 	// Check whether the format is supported by the GPU
 	if (sg::is_astc(image->get_format()))
 	{
@@ -1147,11 +3145,24 @@ std::unique_ptr<sg::Image> GLTFLoader::parse_image(tinygltf::Image &gltf_image)
 		{
 			LOGW("ASTC not supported: decoding {}", image->get_name());
 			image = std::make_unique<sg::Astc>(*image);
-			image->generate_mipmaps();
+
+			// Blits can't be recorded on a transfer only queue
+			if (gpu_mipmap_generation && !use_transfer_queue && is_blit_supported(device, image->get_format()))
+			{
+				image->add_gpu_mipmaps();
+			}
+			else
+			{
+				image->generate_mipmaps();
+			}
 		}
 	}
 
-	image->create_vk_image(device);
+	// Packed images are created once every image is decoded
+	if (!texture_arrays || progressive_loading)
+	{
+		image->create_vk_image(device);
+	}
 
 	return image;
 }
@@ -1160,29 +3171,10 @@ std::unique_ptr<sg::Sampler> GLTFLoader::parse_sampler(const tinygltf::Sampler &
 {
 	auto name = gltf_sampler.name;
 
-	VkFilter min_filter = find_min_filter(gltf_sampler.minFilter);
-	VkFilter mag_filter = find_mag_filter(gltf_sampler.magFilter);
-
-	VkSamplerMipmapMode mipmap_mode = find_mipmap_mode(gltf_sampler.minFilter);
+	// Samplers with the same parameters, within and across scenes, share a Vulkan sampler
+	auto &vk_sampler = device.get_resource_cache().request_sampler(get_sampler_info(gltf_sampler));
 
-	VkSamplerAddressMode address_mode_u = find_wrap_mode(gltf_sampler.wrapS);
-	VkSamplerAddressMode address_mode_v = find_wrap_mode(gltf_sampler.wrapT);
-	VkSamplerAddressMode address_mode_w = find_wrap_mode(gltf_sampler.wrapR);
-
-	VkSamplerCreateInfo sampler_info{VK_STRUCTURE_TYPE_SAMPLER_CREATE_INFO};
-
-	sampler_info.magFilter    = mag_filter;
-	sampler_info.minFilter    = min_filter;
-	sampler_info.mipmapMode   = mipmap_mode;
-	sampler_info.addressModeU = address_mode_u;
-	sampler_info.addressModeV = address_mode_v;
-	sampler_info.addressModeW = address_mode_w;
-	sampler_info.borderColor  = VK_BORDER_COLOR_FLOAT_OPAQUE_WHITE;
-	sampler_info.maxLod       = std::numeric_limits<float>::max();
-
-	core::Sampler vk_sampler{device, sampler_info};
-
-	return std::make_unique<sg::Sampler>(name, std::move(vk_sampler));
+	return std::make_unique<sg::Sampler>(name, vk_sampler);
 }
 
 std::unique_ptr<sg::Texture> GLTFLoader::parse_texture(const tinygltf::Texture &gltf_texture) const
@@ -1198,16 +3190,7 @@ std::unique_ptr<sg::PBRMaterial> GLTFLoader::create_default_material()
 
 std::unique_ptr<sg::Sampler> GLTFLoader::create_default_sampler()
 {
-	tinygltf::Sampler gltf_sampler;
-
-	gltf_sampler.minFilter = TINYGLTF_TEXTURE_FILTER_LINEAR;
-	gltf_sampler.magFilter = TINYGLTF_TEXTURE_FILTER_LINEAR;
-
-	gltf_sampler.wrapS = TINYGLTF_TEXTURE_WRAP_REPEAT;
-	gltf_sampler.wrapT = TINYGLTF_TEXTURE_WRAP_REPEAT;
-	gltf_sampler.wrapR = TINYGLTF_TEXTURE_WRAP_REPEAT;
-
-	return parse_sampler(gltf_sampler);
+	return parse_sampler(get_default_gltf_sampler());
 }
 
 std::unique_ptr<sg::Camera> GLTFLoader::create_default_camera()
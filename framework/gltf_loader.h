@@ -26,6 +26,8 @@
 #define TINYGLTF_NO_EXTERNAL_IMAGE
 #include <tiny_gltf.h>
 
+#include "geometry/mesh_optimizer.h"
+#include "scene_graph/texture_array_packer.h"
 #include "timer.h"
 
 #define KHR_LIGHTS_PUNCTUAL_EXTENSION "KHR_lights_punctual"
@@ -33,6 +35,7 @@
 namespace vkb
 {
 class Device;
+class ImageStreamer;
 
 namespace sg
 {
@@ -71,7 +74,7 @@ class GLTFLoader
   public:
 	GLTFLoader(Device &device);
 
-	virtual ~GLTFLoader() = default;
+	virtual ~GLTFLoader();
 
 	std::unique_ptr<sg::Scene> read_scene_from_file(const std::string &file_name, int scene_index = -1);
 
@@ -81,6 +84,122 @@ class GLTFLoader
 	 */
 	std::unique_ptr<sg::SubMesh> read_model_from_file(const std::string &file_name, uint32_t index);
 
+	/**
+	 * @brief Sets the size of the ring buffer used to stream images to the GPU
+	 *        Images bigger than it are staged in a dedicated buffer
+	 */
+	void set_staging_buffer_size(VkDeviceSize size);
+
+	/**
+	 * @brief Uploads images on a dedicated transfer queue if the device has one
+	 */
+	void set_use_transfer_queue(bool use);
+
+	/**
+	 * @brief Generates the mip levels of images on the GPU, when the loader needs to generate them
+	 *        Only level 0 is uploaded, formats which can't be blitted fall back to generating them on the CPU
+	 */
+	void set_gpu_mipmap_generation(bool gpu);
+
+	/**
+	 * @brief Makes read_scene_from_file return without waiting for the images
+	 *        Textures sample a placeholder until stream_images() makes their image resident
+	 */
+	void set_progressive_loading(bool progressive);
+
+	/**
+	 * @brief Optimizes indexed triangle primitives when loading a scene
+	 *        The optimized meshes are cached in the temporary directory, keyed by a hash of the primitive data
+	 */
+	void set_mesh_optimization(const MeshOptimizationOptions &options);
+
+	/**
+	 * @brief Stores the vertex attributes of scene sub meshes interleaved in a single vertex buffer
+	 *        Position comes first in a vertex, and every attribute is aligned to 4 bytes
+	 */
+	void set_interleaved_vertices(bool interleaved);
+
+	/**
+	 * @brief Writes the loaded scenes to a binary cache in the temporary directory, which later loads read instead of the glTF file
+	 *        The cache is keyed by a hash of the glTF file and of the loader options. It is not written for progressive loads,
+	 *        and reading it uploads every image before returning.
+	 */
+	void set_scene_cache(bool enable);
+
+	/**
+	 * @brief Keeps the parsed glTF file and the decoded image files in the AssetMemoryCache, and loads them from it,
+	 *        so that later loads in the process skip reading, parsing and decoding them
+	 */
+	void set_asset_memory_cache(bool enable);
+
+	/**
+	 * @brief Packs the small images of a scene sharing a format, extent and mip chain into 2D texture arrays,
+	 *        with each texture selecting its layer. Every image view is then a 2D array view, so the scene
+	 *        has to be drawn by shaders sampling arrays, like base.frag with TEXTURE_ARRAYS defined.
+	 *        Progressive loads and the scene cache keep one image per glTF image.
+	 */
+	void set_texture_arrays(bool enable);
+
+	/**
+	 * @brief Stores float vertex attributes in compressed formats, roughly halving vertex memory and fetch bandwidth:
+	 *        positions as 16-bit unorm relative to the bounds of their sub mesh, normals and tangents as octahedral
+	 *        16-bit snorm, and texture coordinates as half floats. The vertex shaders have to decode them when
+	 *        QUANTIZED_POSITION, OCTAHEDRAL_NORMAL and OCTAHEDRAL_TANGENT are defined, as base.vert and
+	 *        deferred/geometry.vert do. Scenes used to build acceleration structures need float positions.
+	 *        The scene cache is not used with compressed attributes.
+	 */
+	void set_vertex_compression(bool enable);
+
+	/**
+	 * @brief Splits indexed sub meshes into meshlets, drawn by GeometrySubpass with task and mesh shaders
+	 *        The mesh shaders read the vertex buffers as storage buffers, so their usage has to include
+	 *        VK_BUFFER_USAGE_STORAGE_BUFFER_BIT through set_geometry_buffer_usage.
+	 *        The scene cache is not used with meshlets.
+	 */
+	void set_meshlets(bool enable);
+
+	/**
+	 * @brief Keeps a CPU copy of the triangles of the sub meshes with float positions and a BVH over them,
+	 *        so that Scene::ray_cast hits the exact geometry instead of the bounds of the meshes
+	 *        The scene cache is not used with ray cast geometry.
+	 */
+	void set_ray_cast_geometry(bool enable);
+
+	/**
+	 * @brief Adds usages to the vertex and index buffers of scene sub meshes, in addition to the vertex or index buffer usage
+	 *        For example the shader device address usage, to build ray tracing acceleration structures from them.
+	 */
+	void set_geometry_buffer_usage(VkBufferUsageFlags usage);
+
+	/**
+	 * @brief Moves the vertex and index data of loaded scenes to ranges of a few shared device local buffers,
+	 *        suballocated by the geometry allocator of the device, instead of buffers of their own
+	 *        GeometrySubpass does not merge such sub meshes into batches, as their data is not mapped.
+	 */
+	void set_shared_geometry_buffers(bool shared);
+
+	/**
+	 * @brief Restricts the meshes loaded to the subtrees of the scene under the nodes with the given names
+	 *        Every node of the scene is still part of the hierarchy, nodes outside the subtrees have no mesh.
+	 *        Whatever the subtrees, only the meshes, materials and images referenced from the loaded scene are loaded.
+	 * @param node_names Names of the roots of the subtrees, empty to load every mesh of the scene
+	 */
+	void set_node_subtrees(const std::vector<std::string> &node_names);
+
+	/**
+	 * @brief Keeps the data of the scene images once uploaded, so that TextureResidency can upload their mip levels again
+	 *        Progressive loads always clear it.
+	 */
+	void set_keep_image_data(bool keep);
+
+	/**
+	 * @brief Uploads the images decoded since the last call, without blocking
+	 *        Textures switch to their image once its upload has completed
+	 * @param budget Maximum amount of image data to stage in this call, at least one image is staged
+	 * @return The number of images still loading
+	 */
+	size_t stream_images(VkDeviceSize budget);
+
   protected:
 	virtual std::unique_ptr<sg::Node> parse_node(const tinygltf::Node &gltf_node, size_t index) const;
 
@@ -131,9 +250,142 @@ class GLTFLoader
 	/// The extensions that the GLTFLoader can load mapped to whether they should be enabled or not
 	static std::unordered_map<std::string, bool> supported_extensions;
 
+	/// Size of the staging ring buffer used to upload images
+	VkDeviceSize staging_buffer_size{64 * 1024 * 1024};
+
+	bool use_transfer_queue{false};
+
+	bool progressive_loading{false};
+
+	bool gpu_mipmap_generation{true};
+
+	MeshOptimizationOptions mesh_optimization;
+
+	bool interleaved_vertices{false};
+
+	bool scene_cache{false};
+
+	bool asset_memory_cache{false};
+
+	bool texture_arrays{false};
+
+	bool vertex_compression{false};
+
+	bool meshlets{false};
+
+	bool ray_cast_geometry{false};
+
+	VkBufferUsageFlags geometry_buffer_usage{0};
+
+	bool shared_geometry_buffers{false};
+
+	std::vector<std::string> node_subtrees;
+
+	bool keep_image_data{false};
+
   private:
+	/// Resources of the glTF file referenced by the scene being loaded, by index in the file
+	struct UsedResources
+	{
+		/// Nodes in the loaded subtrees of the scene, whose meshes are loaded
+		std::vector<bool> nodes;
+
+		std::vector<bool> meshes;
+
+		std::vector<bool> materials;
+
+		std::vector<bool> images;
+	};
+
 	sg::Scene load_scene(int scene_index = -1);
 
+	/**
+	 * @brief Finds the glTF scene to load, the default scene if the index is out of range
+	 */
+	const tinygltf::Scene &get_gltf_scene(int scene_index) const;
+
+	/**
+	 * @brief Follows the nodes of a scene to the meshes, materials and images they reference
+	 */
+	UsedResources find_used_resources(const tinygltf::Scene &gltf_scene) const;
+
 	std::unique_ptr<sg::SubMesh> load_model(uint32_t index);
+
+	/**
+	 * @brief Decodes the image file of a glTF image, read beforehand
+	 * @param gltf_image The glTF image
+	 * @param image_file The absolute path of the file, which keys the decoded image in the asset memory cache
+	 * @param file_data The contents of the file
+	 */
+	std::unique_ptr<sg::Image> parse_image_file(const tinygltf::Image &gltf_image, const std::string &image_file, const std::vector<uint8_t> &file_data) const;
+
+	/**
+	 * @brief Decodes the images the GPU can't sample and creates their Vulkan image
+	 */
+	std::unique_ptr<sg::Image> prepare_image(std::unique_ptr<sg::Image> image) const;
+
+	/**
+	 * @brief Loads an indexed triangle primitive through the mesh optimizer
+	 * @return False if the primitive can't be optimized, leaving the submesh untouched
+	 */
+	bool load_optimized_primitive(const tinygltf::Primitive &gltf_primitive, sg::SubMesh &submesh);
+
+	/**
+	 * @brief Loads a primitive into a sub mesh without its material, called by the jobs loading the meshes of a scene
+	 *        Only touches the sub mesh and the model, the buffers are allocated from the thread safe memory pools
+	 */
+	std::unique_ptr<sg::SubMesh> load_primitive(const tinygltf::Primitive &gltf_primitive);
+
+	/**
+	 * @brief Moves the vertex attributes of a sub mesh into a single interleaved vertex buffer
+	 */
+	void interleave_vertex_buffers(sg::SubMesh &submesh);
+
+	/**
+	 * @brief Replaces the float positions, normals, tangents and texture coordinates of a sub mesh with compressed ones
+	 *        The positions are quantized relative to the bounds of the sub mesh, stored in its position dequantization buffer.
+	 */
+	void compress_vertex_attributes(sg::SubMesh &submesh);
+
+	/**
+	 * @brief Builds the meshlet buffers of an indexed sub mesh with float positions
+	 */
+	void build_meshlets(sg::SubMesh &submesh);
+
+	/**
+	 * @brief Builds the triangle BVH of a sub mesh with float positions, from sequential indices if it is not indexed
+	 */
+	void build_triangle_bvh(sg::SubMesh &submesh);
+
+	/**
+	 * @brief Moves the geometry of the sub meshes of a loaded scene to the shared geometry buffers, if enabled
+	 *        Called once the scene cache is written, as it reads the vertex and index buffers of the sub meshes
+	 */
+	void move_to_shared_geometry_buffers(sg::Scene &scene);
+
+	/**
+	 * @brief Hashes a glTF file along with the options which change the scene loaded from it
+	 */
+	uint64_t get_scene_cache_key(const std::string &gltf_file, int scene_index) const;
+
+	/**
+	 * @brief Recreates a scene from its cache and uploads its images
+	 * @return The scene, or nullptr if it is not cached
+	 */
+	std::unique_ptr<sg::Scene> read_scene_cache(uint64_t key);
+
+	/**
+	 * @brief Writes the cache of a scene loaded from its glTF file, from the images packed by load_scene
+	 */
+	void write_scene_cache(uint64_t key, sg::Scene &scene);
+
+	/// Images of the scene being loaded, packed before their upload clears them when the scene cache is written
+	std::vector<std::vector<uint8_t>> packed_scene_images;
+
+	/// Texture array and layer of every glTF image of the scene being loaded, empty when images are not packed
+	std::vector<sg::TextureArrayPlacement> texture_array_placements;
+
+	/// Uploads the images of a progressively loaded scene, declared last as its decoding tasks use the model
+	std::unique_ptr<ImageStreamer> image_streamer;
 };
 }        // namespace vkb
@@ -42,7 +42,8 @@ bool generate(RenderContext &context)
 	auto &device = context.get_device();
 
 	auto & resource_cache    = device.get_resource_cache();
-	size_t resource_cache_id = resource_cache_node(graph, resource_cache);
+	auto   resource_cache_usage = resource_cache.get_usage();
+	size_t resource_cache_id    = resource_cache_node(graph, resource_cache, resource_cache_usage);
 	graph.add_edge(device_id, resource_cache_id);
 
 	const auto &resource_cache_state = resource_cache.get_internal_state();
@@ -50,7 +51,7 @@ bool generate(RenderContext &context)
 	auto it_pipeline_layouts = resource_cache_state.pipeline_layouts.begin();
 	while (it_pipeline_layouts != resource_cache_state.pipeline_layouts.end())
 	{
-		size_t pipeline_layouts_id = pipeline_layout_node(graph, it_pipeline_layouts->second);
+		size_t pipeline_layouts_id = pipeline_layout_node(graph, it_pipeline_layouts->second, find_usage(resource_cache_usage.pipeline_layouts, it_pipeline_layouts->first));
 		graph.add_edge(resource_cache_id, pipeline_layouts_id);
 
 		auto &shader_modules = it_pipeline_layouts->second.get_shader_modules();
@@ -73,7 +74,7 @@ bool generate(RenderContext &context)
 	auto it_descriptor_set_layouts = resource_cache_state.descriptor_set_layouts.begin();
 	while (it_descriptor_set_layouts != resource_cache_state.descriptor_set_layouts.end())
 	{
-		size_t descriptor_set_layouts_id = descriptor_set_layout_node(graph, it_descriptor_set_layouts->second);
+		size_t descriptor_set_layouts_id = descriptor_set_layout_node(graph, it_descriptor_set_layouts->second, find_usage(resource_cache_usage.descriptor_set_layouts, it_descriptor_set_layouts->first));
 		graph.add_edge(resource_cache_id, descriptor_set_layouts_id);
 		it_descriptor_set_layouts++;
 	}
@@ -83,7 +84,7 @@ bool generate(RenderContext &context)
 		size_t pipeline_layout = pipeline_layout_node(graph, it_graphics_pipelines->second.get_state().get_pipeline_layout());
 		graph.add_edge(resource_cache_id, pipeline_layout);
 
-		size_t graphics_pipelines_id = graphics_pipeline_node(graph, it_graphics_pipelines->second);
+		size_t graphics_pipelines_id = graphics_pipeline_node(graph, it_graphics_pipelines->second, find_usage(resource_cache_usage.graphics_pipelines, it_graphics_pipelines->first));
 		graph.add_edge(pipeline_layout, graphics_pipelines_id);
 
 		size_t graphics_pipelines_state_id = pipeline_state_node(graph, it_graphics_pipelines->second.get_state());
@@ -120,7 +121,7 @@ bool generate(RenderContext &context)
 	auto it_compute_pipelines = resource_cache_state.compute_pipelines.begin();
 	while (it_compute_pipelines != resource_cache_state.compute_pipelines.end())
 	{
-		size_t compute_pipelines_id = compute_pipeline_node(graph, it_compute_pipelines->second);
+		size_t compute_pipelines_id = compute_pipeline_node(graph, it_compute_pipelines->second, find_usage(resource_cache_usage.compute_pipelines, it_compute_pipelines->first));
 		graph.add_edge(resource_cache_id, compute_pipelines_id);
 		it_compute_pipelines++;
 	}
@@ -128,7 +129,7 @@ bool generate(RenderContext &context)
 	auto it_framebuffers = resource_cache_state.framebuffers.begin();
 	while (it_framebuffers != resource_cache_state.framebuffers.end())
 	{
-		size_t framebuffers_id = framebuffer_node(graph, it_framebuffers->second);
+		size_t framebuffers_id = framebuffer_node(graph, it_framebuffers->second, find_usage(resource_cache_usage.framebuffers, it_framebuffers->first));
 		graph.add_edge(resource_cache_id, framebuffers_id);
 		it_framebuffers++;
 	}
@@ -169,7 +170,7 @@ bool generate(RenderContext &context)
 		{
 			size_t      image_view_id = image_view_node(graph, view);
 			const auto &image         = view.get_image();
-			size_t      image_id      = image_node(graph, image);
+			size_t      image_id      = image_node(graph, device, image);
 
 			graph.add_edge(render_target_id, image_view_id);
 			graph.add_edge(image_view_id, image_id);
@@ -185,6 +186,29 @@ bool generate(RenderContext &context)
 	return graph.dump_to_file("framework.json");
 }
 
+void add_usage(nlohmann::json &data, const ResourceUsage *usage)
+{
+	if (!usage)
+	{
+		return;
+	}
+
+	data["created_frame"] = usage->created_frame;
+	data["created_time"]  = usage->created_time;
+
+	if (usage->last_used_tracked)
+	{
+		data["last_used_frame"] = usage->last_used_frame;
+	}
+}
+
+const ResourceUsage *find_usage(const std::unordered_map<std::size_t, ResourceUsage> &usage, std::size_t hash)
+{
+	auto it = usage.find(hash);
+
+	return it != usage.end() ? &it->second : nullptr;
+}
+
 size_t create_vk_image(Graph &graph, const VkImage &image)
 {
 	return create_vk_node(graph, "VkImage", image);
@@ -235,7 +259,15 @@ size_t fence_pool_node(Graph &graph, const FencePool &fence_pool)
 
 size_t render_frame_node(Graph &graph, const std::unique_ptr<RenderFrame> &frame, std::string label)
 {
-	return graph.create_node(label.c_str(), "Rendering");
+	nlohmann::json data = {{"buffer_block_count", frame->get_buffer_block_count()},
+	                       {"buffer_pool_memory_size", frame->get_buffer_pool_memory_size()},
+	                       {"memory_arena_reserved_size", frame->get_memory_arena_reserved_size()},
+	                       {"descriptor_pool_count", frame->get_descriptor_pool_count()},
+	                       {"descriptor_set_count", frame->get_descriptor_set_count()},
+	                       {"descriptor_set_capacity", frame->get_descriptor_set_capacity()},
+	                       {"timeline_value", frame->get_timeline_value()}};
+
+	return graph.create_node(label.c_str(), "Rendering", data);
 }
 
 size_t render_target_node(Graph &graph, const RenderTarget &render_target)
@@ -271,7 +303,7 @@ size_t image_view_node(Graph &graph, const core::ImageView &image_view)
 	return graph.create_node("Image View", "Core", data);
 }
 
-size_t image_node(Graph &graph, const core::Image &image)
+size_t image_node(Graph &graph, const Device &device, const core::Image &image)
 {
 	std::string result{""};
 	bool        append = false;
@@ -298,6 +330,15 @@ size_t image_node(Graph &graph, const core::Image &image)
 	                       {"VkImageType", to_string(image.get_type())},
 	                       {"VkSubresource", {{"VkImageAspectFlags", image_aspect_to_string(subresource.aspectMask)}, {"mip_level", subresource.mipLevel}, {"array_layer", subresource.arrayLayer}}}};
 
+	// Images which do not own their memory, such as the ones of the swapchain, have no allocation
+	if (image.get_memory() != VK_NULL_HANDLE)
+	{
+		VmaAllocationInfo allocation_info{};
+		vmaGetAllocationInfo(device.get_memory_allocator(), image.get_memory(), &allocation_info);
+
+		data["allocation_size"] = allocation_info.size;
+	}
+
 	return graph.create_node(result.c_str(), "Core", data);
 }
 
@@ -317,12 +358,55 @@ size_t swapchain_node(Graph &graph, const Swapchain &swapchain)
 	return graph.create_node("Swapchain", "Core", data);
 }
 
-size_t resource_cache_node(Graph &graph, const ResourceCache &resource_cache)
+namespace
 {
-	return graph.create_node("Resource Cache", "Core");
+/**
+ * @return The number of objects of a map of the Resource Cache, and the bytes they take on the CPU side
+ *         without counting the containers they own, with the frame of creation of the newest one
+ */
+template <class T>
+nlohmann::json cache_map_data(const std::unordered_map<std::size_t, T> &resources, const std::unordered_map<std::size_t, ResourceUsage> &usage)
+{
+	uint64_t newest_frame = 0;
+
+	for (auto &it : usage)
+	{
+		newest_frame = std::max(newest_frame, it.second.created_frame);
+	}
+
+	return {{"count", resources.size()},
+	        {"object_size", resources.size() * sizeof(T)},
+	        {"newest_created_frame", newest_frame}};
 }
+}        // namespace
 
-size_t descriptor_set_layout_node(Graph &graph, const DescriptorSetLayout &descriptor_set_layout)
+size_t resource_cache_node(Graph &graph, const ResourceCache &resource_cache, const ResourceCacheUsage &usage)
+{
+	const auto &state = resource_cache.get_internal_state();
+
+	size_t shader_binary_size = 0;
+
+	for (auto &it : state.shader_modules)
+	{
+		shader_binary_size += it.second.get_binary().size() * sizeof(uint32_t);
+	}
+
+	nlohmann::json data = {{"shader_modules", cache_map_data(state.shader_modules, usage.shader_modules)},
+	                       {"shader_binary_size", shader_binary_size},
+	                       {"pipeline_layouts", cache_map_data(state.pipeline_layouts, usage.pipeline_layouts)},
+	                       {"descriptor_set_layouts", cache_map_data(state.descriptor_set_layouts, usage.descriptor_set_layouts)},
+	                       {"descriptor_pools", cache_map_data(state.descriptor_pools, usage.descriptor_pools)},
+	                       {"render_passes", cache_map_data(state.render_passes, usage.render_passes)},
+	                       {"graphics_pipelines", cache_map_data(state.graphics_pipelines, usage.graphics_pipelines)},
+	                       {"compute_pipelines", cache_map_data(state.compute_pipelines, usage.compute_pipelines)},
+	                       {"descriptor_sets", cache_map_data(state.descriptor_sets, usage.descriptor_sets)},
+	                       {"framebuffers", cache_map_data(state.framebuffers, usage.framebuffers)},
+	                       {"samplers", cache_map_data(state.samplers, usage.samplers)}};
+
+	return graph.create_node("Resource Cache", "Core", data);
+}
+
+size_t descriptor_set_layout_node(Graph &graph, const DescriptorSetLayout &descriptor_set_layout, const ResourceUsage *usage)
 {
 	std::vector<nlohmann::json> bindings;
 
@@ -339,14 +423,18 @@ size_t descriptor_set_layout_node(Graph &graph, const DescriptorSetLayout &descr
 	    {"handle", Node::handle_to_uintptr_t(descriptor_set_layout.get_handle())},
 	    {"VkDescriptorSetLayoutBinding", bindings}};
 
+	add_usage(data, usage);
+
 	return graph.create_node("Descriptor Set Layout", "Core", data);
 }
 
-size_t framebuffer_node(Graph &graph, const Framebuffer &framebuffer)
+size_t framebuffer_node(Graph &graph, const Framebuffer &framebuffer, const ResourceUsage *usage)
 {
 	nlohmann::json data = {
 	    {"handle", Node::handle_to_uintptr_t(framebuffer.get_handle())}};
 
+	add_usage(data, usage);
+
 	return graph.create_node("Frame Buffer", "Core", data);
 }
 
@@ -367,7 +455,8 @@ size_t shader_module_node(Graph &graph, const ShaderModule &shader_module)
 	nlohmann::json data = {{"stage", stage},
 	                       {"infoLog", shader_module.get_info_log()},
 	                       {"entry_point", shader_module.get_entry_point()},
-	                       {"id", shader_module.get_id()}};
+	                       {"id", shader_module.get_id()},
+	                       {"binary_size", shader_module.get_binary().size() * sizeof(uint32_t)}};
 
 	stage = "Shader Module: " + stage;
 
@@ -396,26 +485,32 @@ size_t shader_resource_node(Graph &graph, const ShaderResource &shader_resource)
 	return graph.create_node(label.c_str(), "Rendering", data);
 }
 
-size_t pipeline_layout_node(Graph &graph, const PipelineLayout &pipeline_layout)
+size_t pipeline_layout_node(Graph &graph, const PipelineLayout &pipeline_layout, const ResourceUsage *usage)
 {
 	nlohmann::json data = {{"handle", Node::handle_to_uintptr_t(pipeline_layout.get_handle())}};
 
+	add_usage(data, usage);
+
 	return graph.create_node("Pipeline Layout", "Core", data);
 }
 
-size_t graphics_pipeline_node(Graph &graph, const GraphicsPipeline &graphics_pipeline)
+size_t graphics_pipeline_node(Graph &graph, const GraphicsPipeline &graphics_pipeline, const ResourceUsage *usage)
 {
 	nlohmann::json data = {
 	    {"handle", Node::handle_to_uintptr_t(graphics_pipeline.get_handle())}};
 
+	add_usage(data, usage);
+
 	return graph.create_node("Graphics Pipeline", "Core", data);
 }
 
-size_t compute_pipeline_node(Graph &graph, const ComputePipeline &compute_pipeline)
+size_t compute_pipeline_node(Graph &graph, const ComputePipeline &compute_pipeline, const ResourceUsage *usage)
 {
 	nlohmann::json data = {
 	    {"handle", Node::handle_to_uintptr_t(compute_pipeline.get_handle())}};
 
+	add_usage(data, usage);
+
 	return graph.create_node("Compute Pipeline", "Core", data);
 }
 
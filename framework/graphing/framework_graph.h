@@ -59,6 +59,20 @@ size_t create_vk_node(Graph &graph, const char *name, const T &handle)
 	return id;
 }
 
+/**
+ * @brief Adds when a cached object was created and last requested to the data of its node
+ * @param data The data of the node
+ * @param usage The usage of the object, nullptr if it is unknown
+ */
+void add_usage(nlohmann::json &data, const ResourceUsage *usage);
+
+/**
+ * @param usage The usage of the cached objects of a type by hash
+ * @param hash The hash of an object in the Resource Cache
+ * @return The usage of the object, nullptr if it is unknown
+ */
+const ResourceUsage *find_usage(const std::unordered_map<std::size_t, ResourceUsage> &usage, std::size_t hash);
+
 size_t create_vk_image(Graph &graph, const VkImage &image);
 
 size_t create_vk_image_view(Graph &graph, const VkImageView &image);
@@ -70,17 +84,17 @@ size_t fence_pool_node(Graph &graph, const FencePool &fence_pool);
 size_t render_frame_node(Graph &graph, const std::unique_ptr<RenderFrame> &frame, std::string label);
 size_t render_target_node(Graph &graph, const RenderTarget &render_target);
 size_t image_view_node(Graph &graph, const core::ImageView &image_view);
-size_t image_node(Graph &graph, const core::Image &image);
+size_t image_node(Graph &graph, const Device &device, const core::Image &image);
 size_t swapchain_node(Graph &graph, const Swapchain &swapchain);
-size_t resource_cache_node(Graph &graph, const ResourceCache &resource_cache);
-size_t descriptor_set_layout_node(Graph &graph, const DescriptorSetLayout &descriptor_set_layout);
-size_t framebuffer_node(Graph &graph, const Framebuffer &framebuffer);
+size_t resource_cache_node(Graph &graph, const ResourceCache &resource_cache, const ResourceCacheUsage &usage);
+size_t descriptor_set_layout_node(Graph &graph, const DescriptorSetLayout &descriptor_set_layout, const ResourceUsage *usage = nullptr);
+size_t framebuffer_node(Graph &graph, const Framebuffer &framebuffer, const ResourceUsage *usage = nullptr);
 size_t render_pass_node(Graph &graph, const RenderPass &render_pass);
 size_t shader_module_node(Graph &graph, const ShaderModule &shader_module);
 size_t shader_resource_node(Graph &graph, const ShaderResource &shader_resource);
-size_t pipeline_layout_node(Graph &graph, const PipelineLayout &pipeline_layout);
-size_t graphics_pipeline_node(Graph &graph, const GraphicsPipeline &graphics_pipeline);
-size_t compute_pipeline_node(Graph &graph, const ComputePipeline &compute_pipeline);
+size_t pipeline_layout_node(Graph &graph, const PipelineLayout &pipeline_layout, const ResourceUsage *usage = nullptr);
+size_t graphics_pipeline_node(Graph &graph, const GraphicsPipeline &graphics_pipeline, const ResourceUsage *usage = nullptr);
+size_t compute_pipeline_node(Graph &graph, const ComputePipeline &compute_pipeline, const ResourceUsage *usage = nullptr);
 size_t pipeline_state_node(Graph &graph, const PipelineState &pipeline_state);
 size_t descriptor_set_node(Graph &graph, const DescriptorSet &descriptor_set);
 size_t specialization_constant_state_node(Graph &graph, const SpecializationConstantState &specialization_constant_state);
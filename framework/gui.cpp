@@ -37,6 +37,7 @@ VKBP_ENABLE_WARNINGS()
 #include "core/descriptor_set_layout.h"
 #include "core/pipeline.h"
 #include "core/pipeline_layout.h"
+#include "core/render_pass.h"
 #include "core/shader_module.h"
 #include "imgui_internal.h"
 #include "platform/filesystem.h"
@@ -64,6 +65,34 @@ void upload_draw_data(ImDrawData *draw_data, const uint8_t *vertex_data, const u
 	}
 }
 
+/**
+ * @brief Recreates a buffer if it cannot hold the given size, growing its capacity geometrically
+ *        so that slowly growing draw data does not recreate it every frame
+ * @return True if the buffer was recreated
+ */
+bool reserve_buffer(Device &device, std::unique_ptr<core::Buffer> &buffer, VkDeviceSize size, VkBufferUsageFlags usage)
+{
+	if (buffer->get_handle() != VK_NULL_HANDLE && buffer->get_size() >= size)
+	{
+		return false;
+	}
+
+	auto capacity = std::max(size, buffer->get_size() + buffer->get_size() / 2);
+
+	// Command buffers in flight may still read from the old buffer
+	device.get_destruction_queue().destroy(std::move(buffer));
+
+	buffer = std::make_unique<core::Buffer>(device, capacity, usage, VMA_MEMORY_USAGE_CPU_TO_GPU);
+
+	return true;
+}
+
+void append_bytes(std::vector<uint8_t> &bytes, const void *data, size_t size)
+{
+	auto begin = static_cast<const uint8_t *>(data);
+	bytes.insert(bytes.end(), begin, begin + size);
+}
+
 inline void reset_graph_max_value(StatGraphData &graph_data)
 {
 	// If it does not have a fixed max
@@ -216,7 +245,7 @@ Gui::Gui(VulkanSample &sample_, const Window &window, const Stats *stats,
 		// End recording
 		command_buffer.end();
 
-		auto &queue = device.get_queue_by_flags(VK_QUEUE_GRAPHICS_BIT, 0);
+		auto &queue = device.get_queue_by_role(QueueRole::Graphics);
 
 		queue.submit(command_buffer, device.request_fence());
 
@@ -246,12 +275,21 @@ Gui::Gui(VulkanSample &sample_, const Window &window, const Stats *stats,
 
 	pipeline_layout = &device.get_resource_cache().request_pipeline_layout(shader_modules);
 
+	vkb::ShaderSource composite_vert_shader("postprocessing/postprocessing.vert");
+	vkb::ShaderSource composite_frag_shader("imgui_composite.frag");
+
+	std::vector<vkb::ShaderModule *> composite_shader_modules;
+	composite_shader_modules.push_back(&device.get_resource_cache().request_shader_module(VK_SHADER_STAGE_VERTEX_BIT, composite_vert_shader, {}));
+	composite_shader_modules.push_back(&device.get_resource_cache().request_shader_module(VK_SHADER_STAGE_FRAGMENT_BIT, composite_frag_shader, {}));
+
+	composite_pipeline_layout = &device.get_resource_cache().request_pipeline_layout(composite_shader_modules);
+
 	sampler = std::make_unique<core::Sampler>(device, sampler_info);
 
 	if (explicit_update)
 	{
-		vertex_buffer = std::make_unique<core::Buffer>(sample.get_render_context().get_device(), 1, VK_BUFFER_USAGE_VERTEX_BUFFER_BIT, VMA_MEMORY_USAGE_GPU_TO_CPU);
-		index_buffer  = std::make_unique<core::Buffer>(sample.get_render_context().get_device(), 1, VK_BUFFER_USAGE_INDEX_BUFFER_BIT, VMA_MEMORY_USAGE_GPU_TO_CPU);
+		vertex_buffer = std::make_unique<core::Buffer>(sample.get_render_context().get_device(), 1, VK_BUFFER_USAGE_VERTEX_BUFFER_BIT, VMA_MEMORY_USAGE_CPU_TO_GPU);
+		index_buffer  = std::make_unique<core::Buffer>(sample.get_render_context().get_device(), 1, VK_BUFFER_USAGE_INDEX_BUFFER_BIT, VMA_MEMORY_USAGE_CPU_TO_GPU);
 	}
 }
 
@@ -390,36 +428,24 @@ bool Gui::update_buffers()
 		return false;
 	}
 
-	if ((vertex_buffer->get_handle() == VK_NULL_HANDLE) || (vertex_buffer_size != last_vertex_buffer_size))
-	{
-		last_vertex_buffer_size = vertex_buffer_size;
-		updated                 = true;
+	auto &device = sample.get_render_context().get_device();
 
-		vertex_buffer.reset();
-		vertex_buffer = std::make_unique<core::Buffer>(sample.get_render_context().get_device(), vertex_buffer_size,
-		                                               VK_BUFFER_USAGE_VERTEX_BUFFER_BIT,
-		                                               VMA_MEMORY_USAGE_GPU_TO_CPU);
-	}
+	updated |= reserve_buffer(device, vertex_buffer, vertex_buffer_size, VK_BUFFER_USAGE_VERTEX_BUFFER_BIT);
+	updated |= reserve_buffer(device, index_buffer, index_buffer_size, VK_BUFFER_USAGE_INDEX_BUFFER_BIT);
 
-	if ((index_buffer->get_handle() == VK_NULL_HANDLE) || (index_buffer_size != last_index_buffer_size))
+	// The recorded draws depend on the amount of geometry, even if the buffers can still hold it
+	if (vertex_buffer_size != last_vertex_buffer_size || index_buffer_size != last_index_buffer_size)
 	{
-		last_index_buffer_size = index_buffer_size;
-		updated                = true;
-
-		index_buffer.reset();
-		index_buffer = std::make_unique<core::Buffer>(sample.get_render_context().get_device(), index_buffer_size,
-		                                              VK_BUFFER_USAGE_INDEX_BUFFER_BIT,
-		                                              VMA_MEMORY_USAGE_GPU_TO_CPU);
+		last_vertex_buffer_size = vertex_buffer_size;
+		last_index_buffer_size  = index_buffer_size;
+		updated                 = true;
 	}
 
-	// Upload data
+	// Upload data, the buffers stay persistently mapped
 	upload_draw_data(draw_data, vertex_buffer->map(), index_buffer->map());
 
-	vertex_buffer->flush();
-	index_buffer->flush();
-
-	vertex_buffer->unmap();
-	index_buffer->unmap();
+	vertex_buffer->flush(0, vertex_buffer_size);
+	index_buffer->flush(0, index_buffer_size);
 
 	return updated;
 }
@@ -441,14 +467,14 @@ void Gui::update_buffers(CommandBuffer &command_buffer, RenderFrame &render_fram
 		return;
 	}
 
-	std::vector<uint8_t> vertex_data(vertex_buffer_size);
-	std::vector<uint8_t> index_data(index_buffer_size);
-
-	upload_draw_data(draw_data, vertex_data.data(), index_data.data());
+	// Write the draw data straight into the mapped memory of the frame's buffer pools
+	auto vertex_allocation = render_frame.allocate_buffer(VK_BUFFER_USAGE_VERTEX_BUFFER_BIT, vertex_buffer_size);
+	auto index_allocation  = render_frame.allocate_buffer(VK_BUFFER_USAGE_INDEX_BUFFER_BIT, index_buffer_size);
 
-	auto vertex_allocation = sample.get_render_context().get_active_frame().allocate_buffer(VK_BUFFER_USAGE_VERTEX_BUFFER_BIT, vertex_buffer_size);
+	upload_draw_data(draw_data, vertex_allocation.map(), index_allocation.map());
 
-	vertex_allocation.update(vertex_data);
+	vertex_allocation.flush();
+	index_allocation.flush();
 
 	std::vector<std::reference_wrapper<const core::Buffer>> buffers;
 	buffers.emplace_back(std::ref(vertex_allocation.get_buffer()));
@@ -457,10 +483,6 @@ void Gui::update_buffers(CommandBuffer &command_buffer, RenderFrame &render_fram
 
 	command_buffer.bind_vertex_buffers(0, buffers, offsets);
 
-	auto index_allocation = sample.get_render_context().get_active_frame().allocate_buffer(VK_BUFFER_USAGE_INDEX_BUFFER_BIT, index_buffer_size);
-
-	index_allocation.update(index_data);
-
 	command_buffer.bind_index_buffer(index_allocation.get_buffer(), index_allocation.get_offset(), VK_INDEX_TYPE_UINT16);
 }
 
@@ -471,6 +493,126 @@ void Gui::resize(const uint32_t width, const uint32_t height) const
 	io.DisplaySize.y = static_cast<float>(height);
 }
 
+void Gui::set_caching(bool caching)
+{
+	this->caching = caching;
+}
+
+bool Gui::is_caching() const
+{
+	return caching;
+}
+
+void Gui::update_cache(CommandBuffer &command_buffer)
+{
+	cache_ready = false;
+
+	ImDrawData *draw_data = ImGui::GetDrawData();
+
+	if (!caching || explicit_update || !visible || !draw_data || draw_data->CmdListsCount == 0)
+	{
+		return;
+	}
+
+	frame_contents.clear();
+
+	for (int32_t i = 0; i < draw_data->CmdListsCount; i++)
+	{
+		const ImDrawList *cmd_list = draw_data->CmdLists[i];
+
+		append_bytes(frame_contents, cmd_list->VtxBuffer.Data, cmd_list->VtxBuffer.Size * sizeof(ImDrawVert));
+		append_bytes(frame_contents, cmd_list->IdxBuffer.Data, cmd_list->IdxBuffer.Size * sizeof(ImDrawIdx));
+
+		for (int32_t j = 0; j < cmd_list->CmdBuffer.Size; j++)
+		{
+			const ImDrawCmd &cmd = cmd_list->CmdBuffer[j];
+
+			append_bytes(frame_contents, &cmd.ClipRect, sizeof(cmd.ClipRect));
+			append_bytes(frame_contents, &cmd.ElemCount, sizeof(cmd.ElemCount));
+		}
+	}
+
+	// While the overlay changes every frame, drawing it directly is cheaper than rendering and compositing a cache
+	if (frame_contents != cache_contents)
+	{
+		std::swap(frame_contents, cache_contents);
+		cache_valid = false;
+		return;
+	}
+
+	auto extent = sample.get_render_context().get_surface_extent();
+
+	if (!cache_target || cache_target->get_extent().width != extent.width || cache_target->get_extent().height != extent.height)
+	{
+		auto &device = sample.get_render_context().get_device();
+
+		// Frames in flight may still sample the previous cache
+		if (cache_target)
+		{
+			device.get_destruction_queue().destroy(std::move(cache_target));
+		}
+
+		std::vector<core::Image> images;
+		images.emplace_back(device, VkExtent3D{extent.width, extent.height, 1}, VK_FORMAT_R8G8B8A8_UNORM,
+		                    VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT | VK_IMAGE_USAGE_SAMPLED_BIT, VMA_MEMORY_USAGE_GPU_ONLY);
+
+		cache_target = std::make_unique<RenderTarget>(std::move(images));
+		cache_valid  = false;
+	}
+
+	if (!cache_valid)
+	{
+		auto &view = cache_target->get_views().at(0);
+
+		{
+			ImageMemoryBarrier memory_barrier{};
+			memory_barrier.old_layout      = VK_IMAGE_LAYOUT_UNDEFINED;
+			memory_barrier.new_layout      = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
+			memory_barrier.src_access_mask = 0;
+			memory_barrier.dst_access_mask = VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT;
+			memory_barrier.src_stage_mask  = VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT;
+			memory_barrier.dst_stage_mask  = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT;
+
+			command_buffer.image_memory_barrier(view, memory_barrier);
+		}
+
+		SubpassInfo subpass_info{};
+		subpass_info.output_attachments               = {0};
+		subpass_info.disable_depth_stencil_attachment = true;
+
+		VkClearValue clear_value{};
+
+		command_buffer.begin_render_pass(*cache_target, {{VK_ATTACHMENT_LOAD_OP_CLEAR, VK_ATTACHMENT_STORE_OP_STORE}}, {clear_value}, {subpass_info});
+
+		VkViewport viewport{};
+		viewport.width    = static_cast<float>(extent.width);
+		viewport.height   = static_cast<float>(extent.height);
+		viewport.minDepth = 0.0f;
+		viewport.maxDepth = 1.0f;
+		command_buffer.set_viewport(0, {viewport});
+
+		draw_geometry(command_buffer, true);
+
+		command_buffer.end_render_pass();
+
+		{
+			ImageMemoryBarrier memory_barrier{};
+			memory_barrier.old_layout      = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
+			memory_barrier.new_layout      = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+			memory_barrier.src_access_mask = VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT;
+			memory_barrier.dst_access_mask = VK_ACCESS_SHADER_READ_BIT;
+			memory_barrier.src_stage_mask  = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT;
+			memory_barrier.dst_stage_mask  = VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT;
+
+			command_buffer.image_memory_barrier(view, memory_barrier);
+		}
+
+		cache_valid = true;
+	}
+
+	cache_ready = true;
+}
+
 void Gui::draw(CommandBuffer &command_buffer)
 {
 	if (!visible)
@@ -478,6 +620,54 @@ void Gui::draw(CommandBuffer &command_buffer)
 		return;
 	}
 
+	if (cache_ready)
+	{
+		cache_ready = false;
+		draw_cache(command_buffer);
+		return;
+	}
+
+	draw_geometry(command_buffer, false);
+}
+
+void Gui::draw_cache(CommandBuffer &command_buffer)
+{
+	command_buffer.set_vertex_input_state({});
+
+	// The cache holds premultiplied colors
+	vkb::ColorBlendAttachmentState color_attachment{};
+	color_attachment.blend_enable           = VK_TRUE;
+	color_attachment.color_write_mask       = VK_COLOR_COMPONENT_R_BIT | VK_COLOR_COMPONENT_G_BIT | VK_COLOR_COMPONENT_B_BIT;
+	color_attachment.src_color_blend_factor = VK_BLEND_FACTOR_ONE;
+	color_attachment.dst_color_blend_factor = VK_BLEND_FACTOR_ONE_MINUS_SRC_ALPHA;
+
+	vkb::ColorBlendState blend_state{};
+	blend_state.attachments = {color_attachment};
+
+	command_buffer.set_color_blend_state(blend_state);
+
+	vkb::RasterizationState rasterization_state{};
+	rasterization_state.cull_mode = VK_CULL_MODE_NONE;
+	command_buffer.set_rasterization_state(rasterization_state);
+
+	vkb::DepthStencilState depth_state{};
+	depth_state.depth_test_enable  = VK_FALSE;
+	depth_state.depth_write_enable = VK_FALSE;
+	command_buffer.set_depth_stencil_state(depth_state);
+
+	VkRect2D scissor{};
+	scissor.extent = command_buffer.get_current_render_pass().render_area;
+	command_buffer.set_scissor(0, {scissor});
+
+	command_buffer.bind_pipeline_layout(*composite_pipeline_layout);
+
+	command_buffer.bind_image(cache_target->get_views().at(0), *sampler, 0, 0, 0);
+
+	command_buffer.draw(3, 1, 0, 0);
+}
+
+void Gui::draw_geometry(CommandBuffer &command_buffer, bool to_cache)
+{
 	// Vertex input state
 	VkVertexInputBindingDescription vertex_input_binding{};
 	vertex_input_binding.stride = to_u32(sizeof(ImDrawVert));
@@ -513,6 +703,14 @@ void Gui::draw(CommandBuffer &command_buffer)
 	color_attachment.dst_color_blend_factor = VK_BLEND_FACTOR_ONE_MINUS_SRC_ALPHA;
 	color_attachment.src_alpha_blend_factor = VK_BLEND_FACTOR_ONE_MINUS_SRC_ALPHA;
 
+	if (to_cache)
+	{
+		// Accumulate coverage in the alpha of the cache, which then holds premultiplied colors over transparent black
+		color_attachment.color_write_mask |= VK_COLOR_COMPONENT_A_BIT;
+		color_attachment.src_alpha_blend_factor = VK_BLEND_FACTOR_ONE;
+		color_attachment.dst_alpha_blend_factor = VK_BLEND_FACTOR_ONE_MINUS_SRC_ALPHA;
+	}
+
 	vkb::ColorBlendState blend_state{};
 	blend_state.attachments = {color_attachment};
 
@@ -764,7 +962,7 @@ void Gui::StatsView::reset_max_values()
 	              [](auto &pr) { reset_graph_max_value(pr.second); });
 }
 
-void Gui::show_top_window(const std::string &app_name, const Stats *stats, DebugInfo *debug_info)
+void Gui::show_top_window(const std::string &app_name, const Stats *stats, DebugInfo *debug_info, const GpuProfiler *gpu_profiler)
 {
 	// Transparent background
 	ImGui::SetNextWindowBgAlpha(overlay_alpha);
@@ -783,6 +981,7 @@ void Gui::show_top_window(const std::string &app_name, const Stats *stats, Debug
 	if (stats)
 	{
 		show_stats(*stats);
+		show_subpass_counters(*stats);
 
 		// Reset max values if user taps on this window
 		if (ImGui::IsWindowHovered() && ImGui::IsMouseClicked(0 /* left */))
@@ -791,6 +990,11 @@ void Gui::show_top_window(const std::string &app_name, const Stats *stats, Debug
 		}
 	}
 
+	if (gpu_profiler)
+	{
+		show_gpu_timings(*gpu_profiler);
+	}
+
 	if (debug_info)
 	{
 		if (debug_view.active)
@@ -911,7 +1115,8 @@ void Gui::show_stats(const Stats &stats)
 
 		// Draw graph
 		auto &      graph_data     = pr->second;
-		const auto &graph_elements = stats.get_data(stat_index);
+		const auto &graph_buffer   = stats.get_data(stat_index);
+		const auto &graph_elements = graph_buffer.get_values();
 		float       graph_min      = 0.0f;
 		float &     graph_max      = graph_data.max_value;
 
@@ -936,7 +1141,7 @@ void Gui::show_stats(const Stats &stats)
 		{
 			graph_label << fmt::format(graph_data.name + ": " + graph_data.format, avg * graph_data.scale_factor);
 			ImGui::PushItemFlag(ImGuiItemFlags_Disabled, true);
-			ImGui::PlotLines("", &graph_elements[0], static_cast<int>(graph_elements.size()), 0, graph_label.str().c_str(), graph_min, graph_max, graph_size);
+			ImGui::PlotLines("", &graph_elements[0], static_cast<int>(graph_elements.size()), static_cast<int>(graph_buffer.get_offset()), graph_label.str().c_str(), graph_min, graph_max, graph_size);
 			ImGui::PopItemFlag();
 		}
 		else
@@ -947,6 +1152,59 @@ void Gui::show_stats(const Stats &stats)
 	}
 }
 
+void Gui::show_subpass_counters(const Stats &stats)
+{
+	for (const auto &subpass : stats.get_subpass_counters())
+	{
+		std::string line = subpass.name + ":";
+
+		for (const auto &stat_index : stats.get_requested_stats())
+		{
+			auto counter = subpass.counters.find(stat_index);
+			if (counter == subpass.counters.end())
+				continue;
+
+			const auto &graph_data = stats.get_graph_data(stat_index);
+			line += fmt::format("  " + graph_data.name + ": " + graph_data.format, counter->second.result * graph_data.scale_factor);
+		}
+
+		ImGui::Text("%s", line.c_str());
+	}
+}
+
+void Gui::show_gpu_timings(const GpuProfiler &gpu_profiler)
+{
+	const ImU32 graphics_color = ImGui::GetColorU32(ImVec4{0.3f, 0.6f, 0.9f, 1.0f});
+	const ImU32 compute_color  = ImGui::GetColorU32(ImVec4{0.9f, 0.6f, 0.2f, 1.0f});
+
+	// The timeline takes the right half of the window, scaled to the span of the frame
+	float timeline_offset = ImGui::GetWindowContentRegionMax().x * 0.5f;
+	float timeline_width  = ImGui::GetWindowContentRegionMax().x - timeline_offset;
+	float frame_span      = gpu_profiler.get_frame_span();
+
+	for (const auto &timing : gpu_profiler.get_timings())
+	{
+		std::string indent(timing.depth * 2, ' ');
+		ImGui::Text("%s%s: %.3f ms", indent.c_str(), timing.name.c_str(), timing.time);
+
+		if (frame_span <= 0.0f)
+		{
+			continue;
+		}
+
+		ImGui::SameLine(timeline_offset);
+
+		ImVec2 position = ImGui::GetCursorScreenPos();
+		float  height   = ImGui::GetTextLineHeight();
+		float  begin    = position.x + timeline_width * timing.start / frame_span;
+		float  end      = std::max(begin + 1.0f, begin + timeline_width * timing.time / frame_span);
+
+		ImGui::GetWindowDrawList()->AddRectFilled(ImVec2{begin, position.y}, ImVec2{end, position.y + height},
+		                                          timing.async_compute ? compute_color : graphics_color);
+		ImGui::Dummy(ImVec2{timeline_width, height});
+	}
+}
+
 void Gui::show_options_window(std::function<void()> body, const uint32_t lines)
 {
 	// Add padding around the text so that the options are not
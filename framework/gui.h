@@ -32,6 +32,7 @@
 #include "platform/filesystem.h"
 #include "platform/input_events.h"
 #include "rendering/render_context.h"
+#include "stats/gpu_profiler.h"
 #include "stats/stats.h"
 
 namespace vkb
@@ -271,6 +272,11 @@ class Gui
 	 */
 	void update(const float delta_time);
 
+	/**
+	 * @brief Writes the draw data into the persistent vertex and index buffers, growing them if needed
+	 * @return True if the buffers were recreated or the amount of geometry changed,
+	 *         in which case command buffers drawing the Gui must be recorded again
+	 */
 	bool update_buffers();
 
 	/**
@@ -279,6 +285,21 @@ class Gui
 	 */
 	void draw(CommandBuffer &command_buffer);
 
+	/**
+	 * @brief Enables caching the overlay in an image, composited with a single full screen draw
+	 *        while the overlay does not change
+	 */
+	void set_caching(bool caching);
+
+	bool is_caching() const;
+
+	/**
+	 * @brief Renders the overlay into its cache if it stopped changing, so that the next draw() composites it
+	 *        Must be recorded outside of a render pass, before draw()
+	 * @param command_buffer Command buffer to record the cache render pass into
+	 */
+	void update_cache(CommandBuffer &command_buffer);
+
 	/**
 	 * @brief Draws the Gui
 	 * @param command_buffer Command buffer to register draw-commands
@@ -290,8 +311,9 @@ class Gui
 	 * @param app_name Application name
 	 * @param stats Statistics to show (can be null)
 	 * @param debug_info Debug info to show (can be null)
+	 * @param gpu_profiler GPU timings to show (can be null)
 	 */
-	void show_top_window(const std::string &app_name, const Stats *stats = nullptr, DebugInfo *debug_info = nullptr);
+	void show_top_window(const std::string &app_name, const Stats *stats = nullptr, DebugInfo *debug_info = nullptr, const GpuProfiler *gpu_profiler = nullptr);
 
 	/**
 	 * @brief Shows the ImGui Demo window
@@ -317,6 +339,19 @@ class Gui
 	 */
 	void show_stats(const Stats &stats);
 
+	/**
+	 * @brief Shows the counters attributed to each subpass, if stats are sampled per subpass
+	 * @param stats Statistics to show
+	 */
+	void show_subpass_counters(const Stats &stats);
+
+	/**
+	 * @brief Shows the GPU time of the profiled scopes, indented by nesting, next to a timeline
+	 *        of the frame where async compute scopes are colored differently from graphics ones
+	 * @param gpu_profiler Profiler to show the timings of
+	 */
+	void show_gpu_timings(const GpuProfiler &gpu_profiler);
+
 	/**
 	 * @brief Shows an options windows, to be filled by the sample,
 	 *        which will be positioned at the top
@@ -348,11 +383,24 @@ class Gui
 	static constexpr uint32_t BUFFER_POOL_BLOCK_SIZE = 256;
 
 	/**
-	 * @brief Updates Vulkan buffers
-	 * @param frame Frame to render into
+	 * @brief Writes the draw data into buffers allocated from the frame, and binds them
+	 * @param command_buffer Command buffer to bind the buffers to
+	 * @param render_frame Frame to allocate the buffers from
 	 */
 	void update_buffers(CommandBuffer &command_buffer, RenderFrame &render_frame);
 
+	/**
+	 * @brief Composites the cached overlay over the current subpass
+	 */
+	void draw_cache(CommandBuffer &command_buffer);
+
+	/**
+	 * @brief Draws the geometry of the overlay
+	 * @param command_buffer Command buffer to register draw-commands
+	 * @param to_cache Whether the overlay is drawn into its cache, which also accumulates its alpha
+	 */
+	void draw_geometry(CommandBuffer &command_buffer, bool to_cache);
+
 	static const double press_time_ms;
 
 	static const float overlay_alpha;
@@ -392,6 +440,27 @@ class Gui
 
 	PipelineLayout *pipeline_layout{nullptr};
 
+	/// Pipeline layout of the full screen draw compositing the cache
+	PipelineLayout *composite_pipeline_layout{nullptr};
+
+	/// Whether the overlay may be drawn from a cache, see update_cache()
+	bool caching{true};
+
+	/// Whether the cache holds the draw data of the current frame, so that draw() composites it
+	bool cache_ready{false};
+
+	/// Whether the cache image was rendered from cache_contents
+	bool cache_valid{false};
+
+	/// Image the overlay is cached in
+	std::unique_ptr<RenderTarget> cache_target;
+
+	/// Draw data of the previous frame
+	std::vector<uint8_t> cache_contents;
+
+	/// Draw data of the current frame, compared against cache_contents
+	std::vector<uint8_t> frame_contents;
+
 	StatsView stats_view;
 
 	DebugView debug_view;
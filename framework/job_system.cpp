@@ -0,0 +1,335 @@
+/* Copyright (c) 2020, Arm Limited and Contributors
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 the "License";
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "job_system.h"
+
+#include <algorithm>
+#include <stdexcept>
+
+namespace vkb
+{
+namespace
+{
+/// Job system and worker index of the calling thread, if it is a worker
+thread_local const JobSystem *current_job_system{nullptr};
+
+thread_local size_t current_thread_index{0};
+}        // namespace
+
+struct JobSystem::GraphRun
+{
+	std::vector<JobGraph::Node> nodes;
+
+	/// Dependencies of every job which have not completed yet
+	std::unique_ptr<std::atomic<uint32_t>[]> dependency_counts;
+
+	std::atomic<size_t> remaining_job_count{0};
+
+	std::mutex exception_mutex;
+
+	std::exception_ptr exception;
+
+	std::promise<void> completed;
+};
+
+JobGraph::JobId JobGraph::add(std::function<void(size_t)> &&job, JobPriority priority)
+{
+	nodes.emplace_back();
+	nodes.back().job      = std::move(job);
+	nodes.back().priority = priority;
+
+	return nodes.size() - 1;
+}
+
+void JobGraph::add_dependency(JobId job, JobId dependency)
+{
+	if (job >= nodes.size() || dependency >= nodes.size())
+	{
+		throw std::out_of_range("Job id is not in the graph");
+	}
+
+	nodes[dependency].dependents.push_back(job);
+	nodes[job].dependency_count++;
+}
+
+size_t JobGraph::get_job_count() const
+{
+	return nodes.size();
+}
+
+JobSystem::JobSystem(size_t thread_count)
+{
+	thread_count = std::max<size_t>(thread_count, 1);
+
+	for (size_t i = 0; i < thread_count; ++i)
+	{
+		workers.push_back(std::make_unique<Worker>());
+	}
+
+	// Workers are started once they all exist, as they steal from each other
+	for (size_t i = 0; i < thread_count; ++i)
+	{
+		workers[i]->thread = std::thread(&JobSystem::worker_loop, this, i);
+	}
+}
+
+JobSystem::~JobSystem()
+{
+	{
+		std::lock_guard<std::mutex> lock{sleep_mutex};
+		stopping = true;
+	}
+
+	wake_condition.notify_all();
+
+	for (auto &worker : workers)
+	{
+		worker->thread.join();
+	}
+}
+
+JobSystem &JobSystem::get()
+{
+	static JobSystem job_system{std::max<size_t>(std::thread::hardware_concurrency(), 2) - 1};
+
+	return job_system;
+}
+
+size_t JobSystem::get_thread_count() const
+{
+	return workers.size();
+}
+
+size_t JobSystem::get_current_thread_index() const
+{
+	return current_job_system == this ? current_thread_index : workers.size();
+}
+
+std::future<void> JobSystem::run(JobGraph &&graph)
+{
+	auto graph_run = std::make_shared<GraphRun>();
+
+	auto future = graph_run->completed.get_future();
+
+	auto job_count = graph.nodes.size();
+
+	if (job_count == 0)
+	{
+		graph_run->completed.set_value();
+		return future;
+	}
+
+	graph_run->dependency_counts = std::make_unique<std::atomic<uint32_t>[]>(job_count);
+
+	std::vector<uint32_t> dependency_counts(job_count);
+	std::vector<JobGraph::JobId> ready_jobs;
+
+	for (JobGraph::JobId i = 0; i < job_count; ++i)
+	{
+		dependency_counts[i] = graph.nodes[i].dependency_count;
+		graph_run->dependency_counts[i].store(dependency_counts[i]);
+
+		if (dependency_counts[i] == 0)
+		{
+			ready_jobs.push_back(i);
+		}
+	}
+
+	// Every job has to be reachable from the ones without dependencies, or the graph would never complete
+	std::vector<JobGraph::JobId> visit = ready_jobs;
+	size_t                       visited_count{0};
+
+	while (!visit.empty())
+	{
+		auto id = visit.back();
+		visit.pop_back();
+		visited_count++;
+
+		for (auto dependent : graph.nodes[id].dependents)
+		{
+			if (--dependency_counts[dependent] == 0)
+			{
+				visit.push_back(dependent);
+			}
+		}
+	}
+
+	if (visited_count != job_count)
+	{
+		throw std::runtime_error("Job graph has cyclic dependencies");
+	}
+
+	graph_run->remaining_job_count.store(job_count);
+	graph_run->nodes = std::move(graph.nodes);
+
+	for (auto id : ready_jobs)
+	{
+		queue_graph_job(graph_run, id);
+	}
+
+	return future;
+}
+
+void JobSystem::queue_graph_job(const std::shared_ptr<GraphRun> &graph_run, JobGraph::JobId id)
+{
+	auto job = [this, graph_run, id](size_t thread_index) {
+		auto &node = graph_run->nodes[id];
+
+		try
+		{
+			node.job(thread_index);
+		}
+		catch (...)
+		{
+			std::lock_guard<std::mutex> lock{graph_run->exception_mutex};
+
+			if (!graph_run->exception)
+			{
+				graph_run->exception = std::current_exception();
+			}
+		}
+
+		for (auto dependent : node.dependents)
+		{
+			if (graph_run->dependency_counts[dependent].fetch_sub(1) == 1)
+			{
+				queue_graph_job(graph_run, dependent);
+			}
+		}
+
+		if (graph_run->remaining_job_count.fetch_sub(1) == 1)
+		{
+			if (graph_run->exception)
+			{
+				graph_run->completed.set_exception(graph_run->exception);
+			}
+			else
+			{
+				graph_run->completed.set_value();
+			}
+		}
+	};
+
+	schedule(std::move(job), graph_run->nodes[id].priority);
+}
+
+void JobSystem::schedule(Job &&job, JobPriority priority)
+{
+	auto thread_index = get_current_thread_index();
+
+	// Jobs pushed by a worker stay on it, the others are spread across the workers
+	if (thread_index == workers.size())
+	{
+		thread_index = next_worker.fetch_add(1, std::memory_order_relaxed) % workers.size();
+	}
+
+	{
+		auto &worker = *workers[thread_index];
+
+		std::lock_guard<std::mutex> lock{worker.queue_mutex};
+		worker.queues[static_cast<size_t>(priority)].push_back(std::move(job));
+	}
+
+	queued_job_count.fetch_add(1);
+
+	{
+		// Locking makes sure a worker checking for jobs is either awake or already waiting for the notification
+		std::lock_guard<std::mutex> lock{sleep_mutex};
+	}
+
+	wake_condition.notify_one();
+}
+
+bool JobSystem::pop_job(size_t thread_index, Job &job)
+{
+	for (size_t priority = 0; priority < workers[thread_index]->queues.size(); ++priority)
+	{
+		for (size_t i = 0; i < workers.size(); ++i)
+		{
+			auto &worker = *workers[(thread_index + i) % workers.size()];
+			auto &queue  = worker.queues[priority];
+
+			std::lock_guard<std::mutex> lock{worker.queue_mutex};
+
+			if (queue.empty())
+			{
+				continue;
+			}
+
+			if (i == 0)
+			{
+				job = std::move(queue.back());
+				queue.pop_back();
+			}
+			else
+			{
+				job = std::move(queue.front());
+				queue.pop_front();
+			}
+
+			queued_job_count.fetch_sub(1);
+
+			return true;
+		}
+	}
+
+	return false;
+}
+
+bool JobSystem::run_queued_job()
+{
+	auto thread_index = get_current_thread_index();
+
+	Job job;
+
+	if (thread_index == workers.size() || !pop_job(thread_index, job))
+	{
+		return false;
+	}
+
+	job(thread_index);
+
+	return true;
+}
+
+void JobSystem::worker_loop(size_t thread_index)
+{
+	current_job_system   = this;
+	current_thread_index = thread_index;
+
+	while (true)
+	{
+		Job job;
+
+		if (pop_job(thread_index, job))
+		{
+			job(thread_index);
+			continue;
+		}
+
+		std::unique_lock<std::mutex> lock{sleep_mutex};
+
+		wake_condition.wait(lock, [this] { return stopping || queued_job_count.load() > 0; });
+
+		// Queued jobs are still run when stopping
+		if (stopping && queued_job_count.load() == 0)
+		{
+			return;
+		}
+	}
+}
+}        // namespace vkb
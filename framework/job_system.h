@@ -0,0 +1,232 @@
+/* Copyright (c) 2020, Arm Limited and Contributors
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 the "License";
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace vkb
+{
+/**
+ * @brief Order in which queued jobs are picked up by the workers
+ */
+enum class JobPriority
+{
+	High,
+	Normal,
+	Low
+};
+
+class JobSystem;
+
+/**
+ * @brief A set of jobs with dependencies between them, run with JobSystem::run
+ *
+ * A job is queued once all the jobs it depends on have completed.
+ */
+class JobGraph
+{
+  public:
+	using JobId = size_t;
+
+	/**
+	 * @brief Adds a job to the graph
+	 * @param job Function called with the index of the worker running it
+	 * @param priority Priority of the job once it is queued
+	 * @return The id of the job in the graph
+	 */
+	JobId add(std::function<void(size_t)> &&job, JobPriority priority = JobPriority::Normal);
+
+	/**
+	 * @brief Makes a job wait for the completion of another one
+	 * @param job The job to delay
+	 * @param dependency The job which has to complete first
+	 */
+	void add_dependency(JobId job, JobId dependency);
+
+	size_t get_job_count() const;
+
+  private:
+	friend class JobSystem;
+
+	struct Node
+	{
+		std::function<void(size_t)> job;
+
+		JobPriority priority;
+
+		/// Jobs depending on this one
+		std::vector<JobId> dependents;
+
+		uint32_t dependency_count{0};
+	};
+
+	std::vector<Node> nodes;
+};
+
+/**
+ * @brief A pool of worker threads shared by the framework subsystems
+ *
+ * Every worker has its own queues, one per priority. Jobs pushed from a worker go to its
+ * own queues and are run most recent first, idle workers steal the oldest jobs of the others.
+ * Higher priority jobs are always picked before lower priority ones, wherever they are queued.
+ * Jobs still queued when the system is destroyed are run before the workers exit.
+ */
+class JobSystem
+{
+  public:
+	/**
+	 * @brief Creates the workers
+	 * @param thread_count Number of worker threads, at least one
+	 */
+	JobSystem(size_t thread_count);
+
+	JobSystem(const JobSystem &) = delete;
+
+	JobSystem(JobSystem &&) = delete;
+
+	~JobSystem();
+
+	JobSystem &operator=(const JobSystem &) = delete;
+
+	JobSystem &operator=(JobSystem &&) = delete;
+
+	/**
+	 * @brief The job system used by the framework, created on first use with a worker for every core but one
+	 */
+	static JobSystem &get();
+
+	size_t get_thread_count() const;
+
+	/**
+	 * @return The index of the worker running the calling thread, or get_thread_count() if it is not a worker
+	 */
+	size_t get_current_thread_index() const;
+
+	/**
+	 * @brief Queues a job
+	 * @param job Function called with the index of the worker running it
+	 * @param priority Order of the job among the queued ones
+	 * @return A future of the result of the job, holding the exception it threw if any
+	 */
+	template <typename F>
+	auto push(F &&job, JobPriority priority = JobPriority::Normal) -> std::future<decltype(job(size_t{}))>
+	{
+		using ResultType = decltype(job(size_t{}));
+
+		auto task = std::make_shared<std::packaged_task<ResultType(size_t)>>(std::forward<F>(job));
+
+		auto future = task->get_future();
+
+		schedule([task](size_t thread_index) { (*task)(thread_index); }, priority);
+
+		return future;
+	}
+
+	/**
+	 * @brief Queues the jobs of a graph which have no dependency, the others follow as their dependencies complete
+	 * @param graph The jobs to run, it must not have cyclic dependencies
+	 * @return A future which is ready once all the jobs have completed, holding the first exception thrown by a job if any
+	 */
+	std::future<void> run(JobGraph &&graph);
+
+	/**
+	 * @brief Waits for a future
+	 *        On a worker, queued jobs are run meanwhile, so that waiting on other jobs does not block a worker.
+	 */
+	template <typename T>
+	void wait(const std::future<T> &future)
+	{
+		if (get_current_thread_index() == get_thread_count())
+		{
+			future.wait();
+			return;
+		}
+
+		while (future.wait_for(std::chrono::seconds(0)) != std::future_status::ready)
+		{
+			if (!run_queued_job())
+			{
+				future.wait_for(std::chrono::microseconds(100));
+			}
+		}
+	}
+
+  private:
+	using Job = std::function<void(size_t)>;
+
+	struct Worker
+	{
+		std::mutex queue_mutex;
+
+		/// Queued jobs of every priority
+		std::array<std::deque<Job>, 3> queues;
+
+		std::thread thread;
+	};
+
+	/**
+	 * @brief Completion state shared by the jobs of a graph being run
+	 */
+	struct GraphRun;
+
+	void schedule(Job &&job, JobPriority priority);
+
+	/**
+	 * @brief Queues a job of a graph, its dependents are queued once it completes if they have no dependency left
+	 */
+	void queue_graph_job(const std::shared_ptr<GraphRun> &graph_run, JobGraph::JobId id);
+
+	/**
+	 * @brief Takes the highest priority job, from the back of the worker queues or from the front of the other ones
+	 */
+	bool pop_job(size_t thread_index, Job &job);
+
+	/**
+	 * @brief Runs a queued job on the calling worker
+	 * @return False if there was no job to run
+	 */
+	bool run_queued_job();
+
+	void worker_loop(size_t thread_index);
+
+	std::vector<std::unique_ptr<Worker>> workers;
+
+	/// Number of jobs in the worker queues
+	std::atomic<size_t> queued_job_count{0};
+
+	/// Worker receiving the next job pushed by a thread which is not a worker
+	std::atomic<size_t> next_worker{0};
+
+	std::mutex sleep_mutex;
+
+	std::condition_variable wake_condition;
+
+	bool stopping{false};
+};
+}        // namespace vkb
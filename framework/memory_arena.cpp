@@ -0,0 +1,101 @@
+/* Copyright (c) 2020, Arm Limited and Contributors
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 the "License";
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "memory_arena.h"
+
+#include <algorithm>
+#include <cassert>
+
+namespace vkb
+{
+MemoryArena::MemoryArena(size_t block_size) :
+    block_size{block_size}
+{
+}
+
+void *MemoryArena::allocate(size_t size, size_t alignment)
+{
+	assert((alignment & (alignment - 1)) == 0 && "Alignment must be a power of two");
+
+	while (active_block < blocks.size())
+	{
+		auto &block = blocks[active_block];
+
+		auto address = reinterpret_cast<uintptr_t>(block.data.get()) + offset;
+		auto padding = (alignment - (address & (alignment - 1))) & (alignment - 1);
+
+		if (offset + padding + size <= block.size)
+		{
+			offset += padding + size;
+			used_size += padding + size;
+
+			return reinterpret_cast<void *>(address + padding);
+		}
+
+		// Move to the next block, the rest of this one is wasted until the next reset
+		++active_block;
+		offset = 0;
+	}
+
+	// Oversized allocations get a block of their own
+	Block block;
+	block.size = std::max(block_size, size + alignment);
+	block.data = std::make_unique<uint8_t[]>(block.size);
+
+	blocks.push_back(std::move(block));
+	++block_allocation_count;
+
+	active_block = blocks.size() - 1;
+
+	auto address = reinterpret_cast<uintptr_t>(blocks.back().data.get());
+	auto padding = (alignment - (address & (alignment - 1))) & (alignment - 1);
+
+	offset = padding + size;
+	used_size += padding + size;
+
+	return reinterpret_cast<void *>(address + padding);
+}
+
+void MemoryArena::reset()
+{
+	active_block = 0;
+	offset       = 0;
+	used_size    = 0;
+}
+
+size_t MemoryArena::get_block_allocation_count() const
+{
+	return block_allocation_count;
+}
+
+size_t MemoryArena::get_used_size() const
+{
+	return used_size;
+}
+
+size_t MemoryArena::get_reserved_size() const
+{
+	size_t reserved_size = 0;
+
+	for (auto &block : blocks)
+	{
+		reserved_size += block.size;
+	}
+
+	return reserved_size;
+}
+}        // namespace vkb
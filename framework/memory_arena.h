@@ -0,0 +1,172 @@
+/* Copyright (c) 2020, Arm Limited and Contributors
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 the "License";
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <type_traits>
+#include <vector>
+
+namespace vkb
+{
+/**
+ * @brief A monotonic memory arena, allocations are bump allocated from a list of blocks
+ *        and only released all at once with reset().
+ *
+ * Blocks are kept alive across resets, so once the arena has grown to the peak usage
+ * of a frame, the following frames do not allocate from the heap anymore.
+ * It is not thread-safe, each recording thread should use its own arena.
+ */
+class MemoryArena
+{
+  public:
+	/**
+	 * @brief Default size of an arena block in bytes
+	 */
+	static constexpr size_t DEFAULT_BLOCK_SIZE = 64 * 1024;
+
+	MemoryArena(size_t block_size = DEFAULT_BLOCK_SIZE);
+
+	MemoryArena(const MemoryArena &) = delete;
+
+	MemoryArena(MemoryArena &&) = delete;
+
+	MemoryArena &operator=(const MemoryArena &) = delete;
+
+	MemoryArena &operator=(MemoryArena &&) = delete;
+
+	/**
+	 * @brief Allocates memory from the current block, a new block is used if it does not fit
+	 * @param size Size of the allocation in bytes
+	 * @param alignment Alignment of the allocation, must be a power of two
+	 * @return A pointer to the allocated memory, valid until the next reset
+	 */
+	void *allocate(size_t size, size_t alignment);
+
+	/**
+	 * @brief Releases all the allocations, keeping the blocks for reuse
+	 *        All the objects allocated from the arena must have been destroyed
+	 */
+	void reset();
+
+	/**
+	 * @return The number of blocks allocated from the heap since the arena was created
+	 */
+	size_t get_block_allocation_count() const;
+
+	/**
+	 * @return The number of bytes allocated from the arena since the last reset
+	 */
+	size_t get_used_size() const;
+
+	/**
+	 * @return The number of bytes of the blocks the arena holds
+	 */
+	size_t get_reserved_size() const;
+
+  private:
+	struct Block
+	{
+		std::unique_ptr<uint8_t[]> data;
+
+		size_t size{0};
+	};
+
+	size_t block_size;
+
+	std::vector<Block> blocks;
+
+	/// Index of the block allocations are served from
+	size_t active_block{0};
+
+	/// Offset of the next allocation in the active block
+	size_t offset{0};
+
+	size_t used_size{0};
+
+	size_t block_allocation_count{0};
+};
+
+/**
+ * @brief A standard allocator serving memory from a MemoryArena
+ *
+ * Deallocation is a no-op, the memory is released when the arena is reset.
+ * A null arena falls back to the global operator new and delete, so that containers
+ * not associated to a frame keep working.
+ */
+template <typename T>
+class ArenaAllocator
+{
+  public:
+	using value_type = T;
+
+	using propagate_on_container_copy_assignment = std::true_type;
+
+	using propagate_on_container_move_assignment = std::true_type;
+
+	using propagate_on_container_swap = std::true_type;
+
+	ArenaAllocator(MemoryArena *arena = nullptr) :
+	    arena{arena}
+	{}
+
+	template <typename U>
+	ArenaAllocator(const ArenaAllocator<U> &other) :
+	    arena{other.get_arena()}
+	{}
+
+	T *allocate(size_t count)
+	{
+		if (arena)
+		{
+			return static_cast<T *>(arena->allocate(count * sizeof(T), alignof(T)));
+		}
+
+		return static_cast<T *>(::operator new(count * sizeof(T)));
+	}
+
+	void deallocate(T *pointer, size_t)
+	{
+		if (!arena)
+		{
+			::operator delete(pointer);
+		}
+	}
+
+	MemoryArena *get_arena() const
+	{
+		return arena;
+	}
+
+  private:
+	MemoryArena *arena;
+};
+
+template <typename T, typename U>
+bool operator==(const ArenaAllocator<T> &lhs, const ArenaAllocator<U> &rhs)
+{
+	return lhs.get_arena() == rhs.get_arena();
+}
+
+template <typename T, typename U>
+bool operator!=(const ArenaAllocator<T> &lhs, const ArenaAllocator<U> &rhs)
+{
+	return lhs.get_arena() != rhs.get_arena();
+}
+}        // namespace vkb
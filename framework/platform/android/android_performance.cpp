@@ -0,0 +1,259 @@
+/* Copyright (c) 2020, Arm Limited and Contributors
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 the "License";
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "android_performance.h"
+
+#include <limits>
+
+#include <dlfcn.h>
+#include <unistd.h>
+
+#include "common/logging.h"
+
+namespace vkb
+{
+namespace
+{
+template <class T>
+void load_function(void *library, const char *name, T &function)
+{
+	function = library ? reinterpret_cast<T>(dlsym(library, name)) : nullptr;
+}
+}        // namespace
+
+const char *to_string(ThermalStatus status)
+{
+	switch (status)
+	{
+		case ThermalStatus::None:
+			return "None";
+		case ThermalStatus::Light:
+			return "Light";
+		case ThermalStatus::Moderate:
+			return "Moderate";
+		case ThermalStatus::Severe:
+			return "Severe";
+		case ThermalStatus::Critical:
+			return "Critical";
+		case ThermalStatus::Emergency:
+			return "Emergency";
+		case ThermalStatus::Shutdown:
+			return "Shutdown";
+		default:
+			return "Error";
+	}
+}
+
+AndroidPerformance::AndroidPerformance() :
+    library{dlopen("libandroid.so", RTLD_NOW | RTLD_LOCAL)}
+{
+	if (!library)
+	{
+		LOGW("Unable to load libandroid, frames will not be paced with the display: {}", dlerror());
+		return;
+	}
+
+	AChoreographer *(*get_choreographer)(){nullptr};
+	load_function(library, "AChoreographer_getInstance", get_choreographer);
+	load_function(library, "AChoreographer_postFrameCallback", post_frame_callback);
+	load_function(library, "AChoreographer_postFrameCallback64", post_frame_callback64);
+
+	// The Choreographer is per thread, it needs the looper of the thread which creates the object
+	if (get_choreographer && (post_frame_callback || post_frame_callback64))
+	{
+		choreographer = get_choreographer();
+	}
+
+	AThermalManager *(*acquire_thermal_manager)(){nullptr};
+	load_function(library, "AThermal_acquireManager", acquire_thermal_manager);
+	load_function(library, "AThermal_releaseManager", release_thermal_manager);
+	load_function(library, "AThermal_getCurrentThermalStatus", get_current_thermal_status);
+	load_function(library, "AThermal_getThermalHeadroom", get_thermal_headroom_fn);
+
+	if (acquire_thermal_manager && release_thermal_manager)
+	{
+		thermal_manager = acquire_thermal_manager();
+	}
+
+	APerformanceHintManager *(*get_hint_manager)(){nullptr};
+	load_function(library, "APerformanceHint_getManager", get_hint_manager);
+	load_function(library, "APerformanceHint_createSession", create_hint_session);
+	load_function(library, "APerformanceHint_updateTargetWorkDuration", update_target_work_duration);
+	load_function(library, "APerformanceHint_reportActualWorkDuration", report_work_duration);
+	load_function(library, "APerformanceHint_closeSession", close_hint_session);
+
+	if (get_hint_manager && create_hint_session && update_target_work_duration && report_work_duration && close_hint_session)
+	{
+		hint_manager = get_hint_manager();
+	}
+
+	LOGI("Android performance APIs: choreographer {}, thermal status {}, thermal headroom {}, performance hints {}",
+	     choreographer != nullptr, thermal_manager && get_current_thermal_status, thermal_manager && get_thermal_headroom_fn, hint_manager != nullptr);
+}
+
+AndroidPerformance::~AndroidPerformance()
+{
+	if (hint_session)
+	{
+		close_hint_session(hint_session);
+	}
+
+	if (thermal_manager)
+	{
+		release_thermal_manager(thermal_manager);
+	}
+
+	// libandroid stays loaded, a frame callback may still be pending until the looper of the thread is gone
+}
+
+bool AndroidPerformance::has_choreographer() const
+{
+	return choreographer != nullptr;
+}
+
+void AndroidPerformance::request_vsync()
+{
+	if (!choreographer || vsync_pending)
+	{
+		return;
+	}
+
+	// The 64-bit callback replaces the other one from API 29, which truncates the time on 32-bit devices
+	if (post_frame_callback64)
+	{
+		post_frame_callback64(choreographer, on_vsync64, this);
+	}
+	else
+	{
+		post_frame_callback(choreographer, on_vsync, this);
+	}
+
+	vsync_pending = true;
+}
+
+bool AndroidPerformance::is_vsync_pending() const
+{
+	return vsync_pending;
+}
+
+bool AndroidPerformance::consume_vsync()
+{
+	bool signaled  = vsync_signaled;
+	vsync_signaled = false;
+
+	return signaled;
+}
+
+int64_t AndroidPerformance::get_vsync_period() const
+{
+	return static_cast<int64_t>(vsync_period);
+}
+
+void AndroidPerformance::on_vsync(long frame_time, void *data)
+{
+	static_cast<AndroidPerformance *>(data)->signal_vsync(frame_time);
+}
+
+void AndroidPerformance::on_vsync64(int64_t frame_time, void *data)
+{
+	static_cast<AndroidPerformance *>(data)->signal_vsync(frame_time);
+}
+
+void AndroidPerformance::signal_vsync(int64_t frame_time)
+{
+	vsync_pending  = false;
+	vsync_signaled = true;
+
+	if (last_vsync_time > 0 && frame_time > last_vsync_time)
+	{
+		double interval = static_cast<double>(frame_time - last_vsync_time);
+
+		// The callback is only requested for the frames the sample renders, skipped vsyncs are not intervals
+		if (vsync_period == 0.0)
+		{
+			vsync_period = interval;
+		}
+		else if (interval < vsync_period * 1.5)
+		{
+			vsync_period += (interval - vsync_period) * VSYNC_PERIOD_SMOOTHING;
+		}
+	}
+
+	last_vsync_time = frame_time;
+}
+
+ThermalStatus AndroidPerformance::get_thermal_status() const
+{
+	if (!thermal_manager || !get_current_thermal_status)
+	{
+		return ThermalStatus::Error;
+	}
+
+	return static_cast<ThermalStatus>(get_current_thermal_status(thermal_manager));
+}
+
+float AndroidPerformance::get_thermal_headroom(int forecast_seconds) const
+{
+	if (!thermal_manager || !get_thermal_headroom_fn)
+	{
+		return std::numeric_limits<float>::quiet_NaN();
+	}
+
+	return get_thermal_headroom_fn(thermal_manager, forecast_seconds);
+}
+
+bool AndroidPerformance::set_target_work_duration(int64_t target_duration)
+{
+	if (!hint_manager || target_duration <= 0)
+	{
+		return hint_session != nullptr;
+	}
+
+	if (!hint_session)
+	{
+		int32_t thread_id = gettid();
+
+		hint_session = create_hint_session(hint_manager, &thread_id, 1, target_duration);
+
+		if (!hint_session)
+		{
+			LOGW("Unable to create a performance hint session, work durations will not be reported");
+
+			// Do not retry every frame
+			hint_manager = nullptr;
+			return false;
+		}
+
+		target_work_duration = target_duration;
+	}
+	else if (target_duration != target_work_duration)
+	{
+		update_target_work_duration(hint_session, target_duration);
+		target_work_duration = target_duration;
+	}
+
+	return true;
+}
+
+void AndroidPerformance::report_actual_work_duration(int64_t actual_duration)
+{
+	if (hint_session && actual_duration > 0)
+	{
+		report_work_duration(hint_session, actual_duration);
+	}
+}
+}        // namespace vkb
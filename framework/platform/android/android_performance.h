@@ -0,0 +1,170 @@
+/* Copyright (c) 2020, Arm Limited and Contributors
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 the "License";
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <cstdint>
+
+struct AChoreographer;
+struct AThermalManager;
+struct APerformanceHintManager;
+struct APerformanceHintSession;
+
+namespace vkb
+{
+/**
+ * @brief Thermal status of the device, with the values of AThermalStatus
+ */
+enum class ThermalStatus
+{
+	Error     = -1,
+	None      = 0,
+	Light     = 1,
+	Moderate  = 2,
+	Severe    = 3,
+	Critical  = 4,
+	Emergency = 5,
+	Shutdown  = 6
+};
+
+const char *to_string(ThermalStatus status);
+
+/**
+ * @brief Paces frames with the display through the Choreographer, and reports the thermal state
+ *        of the device and the work duration of the frames to the Android performance APIs.
+ *
+ * The functions are looked up in libandroid at runtime, as they need newer API levels than the samples
+ * are built for: frame callbacks need API 24, the thermal status 30, the thermal headroom 31 and the
+ * performance hint sessions 33. Each feature is unavailable on devices which do not have its functions.
+ */
+class AndroidPerformance
+{
+  public:
+	AndroidPerformance();
+
+	~AndroidPerformance();
+
+	AndroidPerformance(const AndroidPerformance &) = delete;
+
+	AndroidPerformance &operator=(const AndroidPerformance &) = delete;
+
+	/**
+	 * @return Whether frames can be paced by the Choreographer of the thread which created the object
+	 */
+	bool has_choreographer() const;
+
+	/**
+	 * @brief Asks the Choreographer to signal the next vsync, if it is not already going to
+	 *        The signal is received while the looper of the thread is polled
+	 */
+	void request_vsync();
+
+	/**
+	 * @return Whether a vsync was requested and has not been signaled yet
+	 */
+	bool is_vsync_pending() const;
+
+	/**
+	 * @brief Consumes the signal of the last vsync
+	 * @return Whether a vsync was signaled since the last call
+	 */
+	bool consume_vsync();
+
+	/**
+	 * @return The average time between the last vsyncs in nanoseconds, 0 until two were signaled
+	 */
+	int64_t get_vsync_period() const;
+
+	/**
+	 * @return The current thermal status of the device, ThermalStatus::Error if it is unavailable
+	 */
+	ThermalStatus get_thermal_status() const;
+
+	/**
+	 * @brief Queries how far the device is from severe throttling, which the system allows at most once per second
+	 * @param forecast_seconds How many seconds ahead to forecast the headroom at the current workload
+	 * @return 0 without any thermal pressure up to 1 when severe throttling starts, NaN if it is unavailable
+	 */
+	float get_thermal_headroom(int forecast_seconds = 0) const;
+
+	/**
+	 * @brief Creates the performance hint session for the calling thread, or updates its target
+	 * @param target_duration Work duration of a frame the system should provision the CPU for, in nanoseconds
+	 * @return Whether a session is open
+	 */
+	bool set_target_work_duration(int64_t target_duration);
+
+	/**
+	 * @brief Reports the time a frame of work took to the performance hint session, if there is one
+	 * @param actual_duration Work duration of the frame in nanoseconds
+	 */
+	void report_actual_work_duration(int64_t actual_duration);
+
+	/// Weight of the last interval in the average vsync period
+	static constexpr double VSYNC_PERIOD_SMOOTHING{0.1};
+
+  private:
+	using FrameCallback   = void (*)(long frame_time, void *data);
+	using FrameCallback64 = void (*)(int64_t frame_time, void *data);
+
+	static void on_vsync(long frame_time, void *data);
+
+	static void on_vsync64(int64_t frame_time, void *data);
+
+	void signal_vsync(int64_t frame_time);
+
+	void *library{nullptr};
+
+	AChoreographer *choreographer{nullptr};
+
+	void (*post_frame_callback)(AChoreographer *, FrameCallback, void *){nullptr};
+
+	void (*post_frame_callback64)(AChoreographer *, FrameCallback64, void *){nullptr};
+
+	bool vsync_pending{false};
+
+	bool vsync_signaled{false};
+
+	/// Time of the last vsync in nanoseconds, 0 before the first one
+	int64_t last_vsync_time{0};
+
+	double vsync_period{0.0};
+
+	AThermalManager *thermal_manager{nullptr};
+
+	void (*release_thermal_manager)(AThermalManager *){nullptr};
+
+	int (*get_current_thermal_status)(AThermalManager *){nullptr};
+
+	float (*get_thermal_headroom_fn)(AThermalManager *, int){nullptr};
+
+	APerformanceHintManager *hint_manager{nullptr};
+
+	APerformanceHintSession *hint_session{nullptr};
+
+	APerformanceHintSession *(*create_hint_session)(APerformanceHintManager *, const int32_t *, size_t, int64_t){nullptr};
+
+	int (*update_target_work_duration)(APerformanceHintSession *, int64_t){nullptr};
+
+	int (*report_work_duration)(APerformanceHintSession *, int64_t){nullptr};
+
+	void (*close_hint_session)(APerformanceHintSession *){nullptr};
+
+	/// Target of the hint session in nanoseconds
+	int64_t target_work_duration{0};
+};
+}        // namespace vkb
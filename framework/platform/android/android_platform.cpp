@@ -391,6 +391,14 @@ bool AndroidPlatform::initialize(std::unique_ptr<Application> &&application)
 	app->activity->callbacks->onContentRectChanged = on_content_rect_changed;
 	app->userData                                  = this;
 
+	if (performance.has_choreographer())
+	{
+		LOGI("Pacing frames with the Choreographer");
+	}
+
+	thermal_timer.start();
+	update_thermal_state();
+
 	return Platform::initialize(std::move(application));
 }
 
@@ -411,10 +419,80 @@ void AndroidPlatform::main_loop()
 			break;
 		}
 
-		if (!window->should_close())
+		if (window->should_close())
+		{
+			continue;
+		}
+
+		if (is_choreographer_pacing() && !performance.consume_vsync())
 		{
-			run();
+			// The next polling of events blocks until the vsync is signaled
+			performance.request_vsync();
+			continue;
 		}
+
+		run_frame();
+	}
+}
+
+void AndroidPlatform::run_frame()
+{
+	if (thermal_timer.elapsed() >= THERMAL_UPDATE_INTERVAL)
+	{
+		update_thermal_state();
+	}
+
+	int64_t target_duration = DEFAULT_TARGET_WORK_DURATION;
+
+	if (frame_pacer.get_target_fps() > 0.0f)
+	{
+		target_duration = static_cast<int64_t>(1e9 / frame_pacer.get_target_fps());
+	}
+	else if (performance.get_vsync_period() > 0)
+	{
+		target_duration = performance.get_vsync_period();
+	}
+
+	bool report = performance.set_target_work_duration(target_duration);
+
+	run();
+
+	// The pacing of the frame is not work, so the time waiting for it is left out
+	if (report && step_duration > 0.0)
+	{
+		performance.report_actual_work_duration(static_cast<int64_t>(step_duration * 1e9));
+	}
+}
+
+void AndroidPlatform::update_thermal_state()
+{
+	thermal_timer.lap();
+
+	Platform::set_thermal_headroom(performance.get_thermal_headroom());
+
+	auto status = performance.get_thermal_status();
+
+	if (status == thermal_status)
+	{
+		return;
+	}
+
+	LOGI("Thermal status changed from {} to {}", to_string(thermal_status), to_string(status));
+	thermal_status = status;
+
+	bool throttled = status >= ThermalStatus::Severe;
+
+	if (throttled && !frame_pacer.is_thermal_mode())
+	{
+		LOGW("Device is throttled, enabling the thermal mode of the frame pacer");
+		frame_pacer.set_thermal_mode(true);
+		thermal_throttled = true;
+	}
+	else if (!throttled && thermal_throttled)
+	{
+		LOGI("Device is no longer throttled, disabling the thermal mode of the frame pacer");
+		frame_pacer.set_thermal_mode(false);
+		thermal_throttled = false;
 	}
 }
 
@@ -425,9 +503,14 @@ void AndroidPlatform::poll_events()
 	int ident;
 	int events;
 
-	while ((ident = ALooper_pollAll(0, nullptr, &events,
+	// Block until an event or the vsync when a frame is waiting for it
+	int timeout = performance.is_vsync_pending() ? -1 : 0;
+
+	while ((ident = ALooper_pollAll(timeout, nullptr, &events,
 	                                (void **) &source)) >= 0)
 	{
+		timeout = 0;
+
 		if (source)
 		{
 			source->process(app, source);
@@ -486,6 +569,21 @@ android_app *AndroidPlatform::get_android_app()
 	return app;
 }
 
+void AndroidPlatform::set_choreographer_pacing(bool enable)
+{
+	choreographer_pacing = enable;
+}
+
+bool AndroidPlatform::is_choreographer_pacing() const
+{
+	return choreographer_pacing && performance.has_choreographer();
+}
+
+AndroidPerformance &AndroidPlatform::get_performance()
+{
+	return performance;
+}
+
 std::vector<spdlog::sink_ptr> AndroidPlatform::get_platform_sinks()
 {
 	std::vector<spdlog::sink_ptr> sinks;
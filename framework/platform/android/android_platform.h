@@ -19,6 +19,7 @@
 
 #include <android_native_app_glue.h>
 
+#include "platform/android/android_performance.h"
 #include "platform/platform.h"
 
 namespace vkb
@@ -56,11 +57,50 @@ class AndroidPlatform : public Platform
 
 	ANativeActivity *get_activity();
 
+	/**
+	 * @brief Paces the frames with the vsync signal of the Choreographer, when the device supports it
+	 * @param enable Whether the main loop waits for the next vsync before each frame
+	 */
+	void set_choreographer_pacing(bool enable);
+
+	bool is_choreographer_pacing() const;
+
+	AndroidPerformance &get_performance();
+
+	/// Interval between the queries of the thermal state, which the system rate limits to one per second
+	static constexpr double THERMAL_UPDATE_INTERVAL{1.0};
+
+	/// Target work duration reported to the performance hint session without a target frame rate or vsync period, in nanoseconds
+	static constexpr int64_t DEFAULT_TARGET_WORK_DURATION{16666667};
+
   private:
 	void poll_events();
 
+	/**
+	 * @brief Runs a frame and reports its work duration to the performance hint session
+	 */
+	void run_frame();
+
+	/**
+	 * @brief Publishes the thermal headroom and enables the thermal mode of the frame pacer
+	 *        while the device is severely throttled
+	 */
+	void update_thermal_state();
+
 	android_app *app{nullptr};
 
+	AndroidPerformance performance;
+
+	bool choreographer_pacing{true};
+
+	ThermalStatus thermal_status{ThermalStatus::None};
+
+	/// Whether the thermal mode of the frame pacer was enabled because of the thermal status
+	bool thermal_throttled{false};
+
+	/// Runs since the last query of the thermal state
+	Timer thermal_timer;
+
 	std::string log_output;
 
 	virtual std::vector<spdlog::sink_ptr> get_platform_sinks() override;
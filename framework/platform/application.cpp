@@ -95,6 +95,10 @@ void Application::input_event(const InputEvent &input_event)
 	}
 }
 
+void Application::record_benchmark_samples(BenchmarkReport & /*report*/)
+{
+}
+
 void Application::parse_options(const std::vector<std::string> &args)
 {
 	options.parse(usage, args);
@@ -27,6 +27,7 @@
 
 namespace vkb
 {
+class BenchmarkReport;
 class Platform;
 
 class Application
@@ -72,6 +73,13 @@ class Application
 	 */
 	virtual void input_event(const InputEvent &input_event);
 
+	/**
+	 * @brief Adds samples of the last frame to a benchmark report, called after every measured frame in benchmark mode
+	 *        The platform then adds the CPU time of the frame to the group selected by the application.
+	 * @param report The report of the benchmark
+	 */
+	virtual void record_benchmark_samples(BenchmarkReport &report);
+
 	/**
 	 * @brief Parses the arguments against Application::usage
 	 * @param args The argument list
@@ -0,0 +1,195 @@
+/* Copyright (c) 2020, Arm Limited and Contributors
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 the "License";
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "platform/asset_archive.h"
+
+#include <algorithm>
+#include <cstring>
+#include <stdexcept>
+
+#include "common/helpers.h"
+#include "common/logging.h"
+
+namespace vkb
+{
+namespace fs
+{
+namespace
+{
+std::unique_ptr<AssetArchive> mounted_archive;
+}        // namespace
+
+constexpr uint32_t AssetArchive::MAGIC;
+constexpr uint32_t AssetArchive::VERSION;
+constexpr uint64_t AssetArchive::ALIGNMENT;
+
+AssetArchive::AssetArchive(const std::string &filename) :
+    file{map_file(filename)}
+{
+	Header header;
+	if (file.size() < sizeof(header))
+	{
+		throw std::runtime_error{"Asset archive " + filename + " is truncated"};
+	}
+	std::memcpy(&header, file.data(), sizeof(header));
+
+	if (header.magic != MAGIC || header.version != VERSION)
+	{
+		throw std::runtime_error{"Asset archive " + filename + " has an unsupported format"};
+	}
+
+	if (sizeof(Header) + header.entry_count * sizeof(Entry) > file.size())
+	{
+		throw std::runtime_error{"Asset archive " + filename + " is truncated"};
+	}
+
+	// The header is 16 bytes and the mapping is page aligned, so the table can be read in place
+	entries     = reinterpret_cast<const Entry *>(file.data() + sizeof(Header));
+	entry_count = header.entry_count;
+
+	for (uint32_t i = 0; i < entry_count; ++i)
+	{
+		if (entries[i].offset + entries[i].size > file.size())
+		{
+			throw std::runtime_error{"Asset archive " + filename + " is truncated"};
+		}
+	}
+}
+
+uint64_t AssetArchive::hash_path(const std::string &path)
+{
+	// 64-bit FNV-1a, stable across platforms and runs
+	uint64_t hash = 14695981039346656037ull;
+
+	for (auto c : path)
+	{
+		// Paths packed on Windows must match the same path on other platforms
+		hash ^= static_cast<uint8_t>(c == '\\' ? '/' : c);
+		hash *= 1099511628211ull;
+	}
+
+	return hash;
+}
+
+const AssetArchive::Entry *AssetArchive::find(const std::string &path) const
+{
+	auto hash = hash_path(path);
+
+	auto it = std::lower_bound(entries, entries + entry_count, hash, [](const Entry &entry, uint64_t value) {
+		return entry.path_hash < value;
+	});
+
+	if (it == entries + entry_count || it->path_hash != hash)
+	{
+		return nullptr;
+	}
+
+	return it;
+}
+
+const uint8_t *AssetArchive::get_data(const Entry &entry) const
+{
+	return file.data() + entry.offset;
+}
+
+uint32_t AssetArchive::get_entry_count() const
+{
+	return entry_count;
+}
+
+void AssetArchive::mount(const std::string &filename)
+{
+	if (filename.empty())
+	{
+		mounted_archive.reset();
+		return;
+	}
+
+	mounted_archive = std::make_unique<AssetArchive>(filename);
+
+	LOGI("Mounted asset archive {} ({} entries)", filename, mounted_archive->get_entry_count());
+}
+
+const AssetArchive *AssetArchive::get_mounted()
+{
+	return mounted_archive.get();
+}
+
+void AssetArchiveBuilder::add(const std::string &path, AssetArchive::EntryType type, std::vector<uint8_t> &&data)
+{
+	auto hash = AssetArchive::hash_path(path);
+
+	auto it = std::find_if(pending_entries.begin(), pending_entries.end(), [hash](const PendingEntry &entry) {
+		return entry.path_hash == hash;
+	});
+
+	if (it != pending_entries.end())
+	{
+		throw std::runtime_error{"Assets " + it->path + " and " + path + " have the same path hash"};
+	}
+
+	pending_entries.push_back({path, hash, type, std::move(data)});
+}
+
+void AssetArchiveBuilder::write(const std::string &filename) const
+{
+	std::vector<AssetArchive::Entry> entries;
+	entries.reserve(pending_entries.size());
+
+	auto align = [](uint64_t offset) {
+		return (offset + AssetArchive::ALIGNMENT - 1) & ~(AssetArchive::ALIGNMENT - 1);
+	};
+
+	// Payloads follow the table of entries
+	uint64_t offset = align(sizeof(AssetArchive::Header) + pending_entries.size() * sizeof(AssetArchive::Entry));
+
+	for (auto &pending_entry : pending_entries)
+	{
+		AssetArchive::Entry entry{};
+		entry.path_hash = pending_entry.path_hash;
+		entry.offset    = offset;
+		entry.size      = pending_entry.data.size();
+		entry.type      = pending_entry.type;
+
+		entries.push_back(entry);
+
+		offset = align(offset + entry.size);
+	}
+
+	std::vector<uint8_t> archive(static_cast<size_t>(offset), 0);
+
+	for (size_t i = 0; i < pending_entries.size(); ++i)
+	{
+		std::copy(pending_entries[i].data.begin(), pending_entries[i].data.end(), archive.begin() + entries[i].offset);
+	}
+
+	std::sort(entries.begin(), entries.end(), [](const AssetArchive::Entry &a, const AssetArchive::Entry &b) {
+		return a.path_hash < b.path_hash;
+	});
+
+	AssetArchive::Header header{};
+	header.magic       = AssetArchive::MAGIC;
+	header.version     = AssetArchive::VERSION;
+	header.entry_count = to_u32(entries.size());
+
+	std::memcpy(archive.data(), &header, sizeof(header));
+	std::memcpy(archive.data() + sizeof(header), entries.data(), entries.size() * sizeof(AssetArchive::Entry));
+
+	write_file(archive, filename);
+}
+}        // namespace fs
+}        // namespace vkb
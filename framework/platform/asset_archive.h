@@ -0,0 +1,170 @@
+/* Copyright (c) 2020, Arm Limited and Contributors
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 the "License";
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "platform/filesystem.h"
+
+namespace vkb
+{
+namespace fs
+{
+/**
+ * @brief A read-only pack of assets, mapped in memory and indexed by the hash of their path
+ *        Payloads start on 4 KB boundaries, so a payload can be read straight into a staging buffer.
+ *        Images are stored transcoded with their mip chain, in the layout written by sg::Image::pack.
+ */
+class AssetArchive
+{
+  public:
+	/// "VKPK"
+	static constexpr uint32_t MAGIC = 0x4B504B56;
+
+	/// Must be increased whenever the layout of archives changes
+	static constexpr uint32_t VERSION = 1;
+
+	/// Alignment of the payloads, relative to the start of the archive
+	static constexpr uint64_t ALIGNMENT = 4096;
+
+	enum class EntryType : uint32_t
+	{
+		/// The file as it is on disk
+		File,
+
+		/// An image written by sg::Image::pack
+		Image
+	};
+
+	struct Header
+	{
+		uint32_t magic;
+
+		uint32_t version;
+
+		uint32_t entry_count;
+
+		uint32_t reserved;
+	};
+
+	/**
+	 * @brief The table of entries follows the header, sorted by path hash
+	 */
+	struct Entry
+	{
+		uint64_t path_hash;
+
+		/// Offset of the payload from the start of the archive
+		uint64_t offset;
+
+		/// Size of the payload in bytes
+		uint64_t size;
+
+		EntryType type;
+
+		uint32_t reserved;
+	};
+
+	/**
+	 * @brief Maps an archive in memory and validates its table of entries
+	 * @param filename The path to the archive
+	 * @throws runtime_error if the file is not a valid archive
+	 */
+	AssetArchive(const std::string &filename);
+
+	/**
+	 * @brief Hashes a path relative to the assets directory, the same path must be used to pack and find an entry
+	 */
+	static uint64_t hash_path(const std::string &path);
+
+	/**
+	 * @param path The path of the asset, relative to the assets directory
+	 * @return The entry of the asset, nullptr if it is not in the archive
+	 */
+	const Entry *find(const std::string &path) const;
+
+	/**
+	 * @return The payload of an entry of this archive
+	 */
+	const uint8_t *get_data(const Entry &entry) const;
+
+	/**
+	 * @return The number of entries in the archive
+	 */
+	uint32_t get_entry_count() const;
+
+	/**
+	 * @brief Mounts an archive, assets found in it are no longer read from the assets directory
+	 *        Must be called before any asset is loaded.
+	 * @param filename The path to the archive, an empty string unmounts the current archive
+	 */
+	static void mount(const std::string &filename);
+
+	/**
+	 * @return The mounted archive, nullptr if there is none
+	 */
+	static const AssetArchive *get_mounted();
+
+  private:
+	MappedFile file;
+
+	const Entry *entries{nullptr};
+
+	uint32_t entry_count{0};
+};
+
+/**
+ * @brief Writes asset archives read by AssetArchive
+ */
+class AssetArchiveBuilder
+{
+  public:
+	/**
+	 * @brief Adds an asset to the archive
+	 * @param path The path of the asset, relative to the assets directory
+	 * @param type How the payload is stored
+	 * @param data The payload
+	 * @throws runtime_error if an asset with the same path hash was already added
+	 */
+	void add(const std::string &path, AssetArchive::EntryType type, std::vector<uint8_t> &&data);
+
+	/**
+	 * @brief Writes the archive, payloads are laid out in the order they were added
+	 * @param filename The path to the archive
+	 */
+	void write(const std::string &filename) const;
+
+  private:
+	struct PendingEntry
+	{
+		std::string path;
+
+		uint64_t path_hash;
+
+		AssetArchive::EntryType type;
+
+		std::vector<uint8_t> data;
+	};
+
+	std::vector<PendingEntry> pending_entries;
+};
+}        // namespace fs
+}        // namespace vkb
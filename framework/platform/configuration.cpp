@@ -17,6 +17,8 @@
 
 #include "configuration.h"
 
+#include <iterator>
+
 namespace vkb
 {
 BoolSetting::BoolSetting(bool &handle, bool value) :
@@ -35,6 +37,16 @@ std::type_index BoolSetting::get_type()
 	return typeid(BoolSetting);
 }
 
+const void *BoolSetting::get_target() const
+{
+	return &handle;
+}
+
+int BoolSetting::get_value() const
+{
+	return value ? 1 : 0;
+}
+
 IntSetting::IntSetting(int &handle, int value) :
     handle{handle},
     value{value}
@@ -51,6 +63,16 @@ std::type_index IntSetting::get_type()
 	return typeid(IntSetting);
 }
 
+const void *IntSetting::get_target() const
+{
+	return &handle;
+}
+
+int IntSetting::get_value() const
+{
+	return value;
+}
+
 EmptySetting::EmptySetting()
 {
 }
@@ -97,6 +119,93 @@ void Configuration::reset()
 	current_configuration = configs.begin();
 }
 
+void Configuration::expand_permutations()
+{
+	// Distinct settings of each variable, in the order the configurations first use them
+	std::vector<std::pair<const void *, std::vector<Setting *>>> variables;
+
+	for (auto &config : configs)
+	{
+		for (auto &pair : config.second)
+		{
+			for (auto *setting : pair.second)
+			{
+				const void *target = setting->get_target();
+
+				if (!target)
+				{
+					continue;
+				}
+
+				auto variable = std::find_if(variables.begin(), variables.end(), [target](const std::pair<const void *, std::vector<Setting *>> &v) { return v.first == target; });
+
+				if (variable == variables.end())
+				{
+					variables.emplace_back(target, std::vector<Setting *>{});
+					variable = std::prev(variables.end());
+				}
+
+				auto &values = variable->second;
+				if (std::find_if(values.begin(), values.end(), [setting](Setting *value) { return value->get_value() == setting->get_value(); }) == values.end())
+				{
+					values.push_back(setting);
+				}
+			}
+		}
+	}
+
+	if (variables.empty())
+	{
+		reset();
+		return;
+	}
+
+	ConfigMap permutations;
+
+	size_t permutation_count = 1;
+	for (auto &variable : variables)
+	{
+		permutation_count *= variable.second.size();
+	}
+
+	for (size_t index = 0; index < permutation_count; ++index)
+	{
+		// The first variable changes fastest
+		size_t remainder = index;
+
+		for (auto &variable : variables)
+		{
+			Setting *setting = variable.second[remainder % variable.second.size()];
+			remainder /= variable.second.size();
+
+			permutations[static_cast<uint32_t>(index)][setting->get_type()].push_back(setting);
+		}
+	}
+
+	configs = std::move(permutations);
+
+	reset();
+}
+
+size_t Configuration::size() const
+{
+	return configs.size();
+}
+
+bool Configuration::select(size_t index)
+{
+	if (index >= configs.size())
+	{
+		return false;
+	}
+
+	current_configuration = std::next(configs.begin(), static_cast<std::ptrdiff_t>(index));
+
+	set();
+
+	return true;
+}
+
 void Configuration::insert_setting(uint32_t config_index, std::unique_ptr<Setting> setting)
 {
 	settings.push_back(std::move(setting));
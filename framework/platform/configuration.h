@@ -40,6 +40,22 @@ class Setting
 	virtual void set() = 0;
 
 	virtual std::type_index get_type() = 0;
+
+	/**
+	 * @return The variable the setting writes to, nullptr if it writes none
+	 */
+	virtual const void *get_target() const
+	{
+		return nullptr;
+	}
+
+	/**
+	 * @return The value the setting writes, converted to an integer
+	 */
+	virtual int get_value() const
+	{
+		return 0;
+	}
 };
 
 class BoolSetting : public Setting
@@ -51,6 +67,10 @@ class BoolSetting : public Setting
 
 	virtual std::type_index get_type() override;
 
+	virtual const void *get_target() const override;
+
+	virtual int get_value() const override;
+
   private:
 	bool &handle;
 
@@ -66,6 +86,10 @@ class IntSetting : public Setting
 
 	virtual std::type_index get_type() override;
 
+	virtual const void *get_target() const override;
+
+	virtual int get_value() const override;
+
   private:
 	int &handle;
 
@@ -111,6 +135,24 @@ class Configuration
 	 */
 	void reset();
 
+	/**
+	 * @brief Replaces the configurations with every combination of the values their settings take, so that
+	 *        each variable is swept independently of the others. The configuration is reset.
+	 */
+	void expand_permutations();
+
+	/**
+	 * @return The number of configurations
+	 */
+	size_t size() const;
+
+	/**
+	 * @brief Makes a configuration the current one and configures its settings
+	 * @param index Index of the configuration, in the order they are iterated by next
+	 * @return False if there is no configuration at that index
+	 */
+	bool select(size_t index);
+
 	/**
 	 * @brief Inserts a setting into the current configuration
 	 * @param config_index The configuration to insert the setting into
@@ -17,6 +17,8 @@
 
 #include "platform/filesystem.h"
 
+#include <array>
+
 #include "common/error.h"
 
 VKBP_DISABLE_WARNINGS()
@@ -26,6 +28,14 @@ VKBP_ENABLE_WARNINGS()
 
 #include "platform/platform.h"
 
+#if defined(_WIN32)
+#	include <windows.h>
+#else
+#	include <fcntl.h>
+#	include <sys/mman.h>
+#	include <unistd.h>
+#endif
+
 namespace vkb
 {
 namespace fs
@@ -161,6 +171,143 @@ static void write_binary_file(const std::vector<uint8_t> &data, const std::strin
 	file.close();
 }
 
+#if defined(_WIN32)
+MappedFile::MappedFile(const std::string &filename)
+{
+	HANDLE file = CreateFileA(filename.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+
+	if (file == INVALID_HANDLE_VALUE)
+	{
+		throw std::runtime_error("Failed to open file: " + filename);
+	}
+
+	LARGE_INTEGER file_size{};
+	GetFileSizeEx(file, &file_size);
+
+	mapped_size = static_cast<size_t>(file_size.QuadPart);
+
+	if (mapped_size > 0)
+	{
+		mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+
+		if (mapping)
+		{
+			mapped_data = static_cast<const uint8_t *>(MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0));
+		}
+	}
+
+	// The mapping keeps the file open
+	CloseHandle(file);
+
+	if (mapped_size > 0 && !mapped_data)
+	{
+		if (mapping)
+		{
+			CloseHandle(mapping);
+		}
+
+		throw std::runtime_error("Failed to map file: " + filename);
+	}
+}
+
+MappedFile::~MappedFile()
+{
+	if (mapped_data)
+	{
+		UnmapViewOfFile(mapped_data);
+	}
+
+	if (mapping)
+	{
+		CloseHandle(mapping);
+	}
+}
+#else
+MappedFile::MappedFile(const std::string &filename)
+{
+	int file = open(filename.c_str(), O_RDONLY);
+
+	if (file < 0)
+	{
+		throw std::runtime_error("Failed to open file: " + filename);
+	}
+
+	struct stat file_stat;
+
+	if (fstat(file, &file_stat) != 0)
+	{
+		close(file);
+		throw std::runtime_error("Failed to open file: " + filename);
+	}
+
+	mapped_size = static_cast<size_t>(file_stat.st_size);
+
+	if (mapped_size > 0)
+	{
+		void *data = mmap(nullptr, mapped_size, PROT_READ, MAP_PRIVATE, file, 0);
+
+		if (data == MAP_FAILED)
+		{
+			close(file);
+			throw std::runtime_error("Failed to map file: " + filename);
+		}
+
+		mapped_data = static_cast<const uint8_t *>(data);
+	}
+
+	// The mapping keeps the file open
+	close(file);
+}
+
+MappedFile::~MappedFile()
+{
+	if (mapped_data)
+	{
+		munmap(const_cast<uint8_t *>(mapped_data), mapped_size);
+	}
+}
+#endif
+
+MappedFile::MappedFile(MappedFile &&other) :
+    mapped_data{other.mapped_data},
+    mapped_size{other.mapped_size}
+#if defined(_WIN32)
+    ,
+    mapping{other.mapping}
+#endif
+{
+	other.mapped_data = nullptr;
+	other.mapped_size = 0;
+#if defined(_WIN32)
+	other.mapping = nullptr;
+#endif
+}
+
+const uint8_t *MappedFile::data() const
+{
+	return mapped_data;
+}
+
+size_t MappedFile::size() const
+{
+	return mapped_size;
+}
+
+MappedFile map_asset(const std::string &filename)
+{
+	return MappedFile{path::get(path::Type::Assets) + filename};
+}
+
+MappedFile map_temp(const std::string &filename)
+{
+	return MappedFile{path::get(path::Type::Temp) + filename};
+}
+
+MappedFile map_file(const std::string &filename)
+{
+	return MappedFile{filename};
+}
+
 std::vector<uint8_t> read_asset(const std::string &filename, const uint32_t count)
 {
 	return read_binary_file(path::get(path::Type::Assets) + filename, count);
@@ -171,6 +318,22 @@ std::vector<uint8_t> read_shader(const std::string &filename)
 	return read_binary_file(path::get(path::Type::Shaders) + filename, 0);
 }
 
+int64_t get_modification_time(const std::string &path)
+{
+	struct stat info;
+	if (stat(path.c_str(), &info) != 0)
+	{
+		return 0;
+	}
+
+	return static_cast<int64_t>(info.st_mtime);
+}
+
+int64_t get_shader_modification_time(const std::string &filename)
+{
+	return get_modification_time(path::get(path::Type::Shaders) + filename);
+}
+
 std::vector<uint8_t> read_temp(const std::string &filename, const uint32_t count)
 {
 	return read_binary_file(path::get(path::Type::Temp) + filename, count);
@@ -181,11 +344,114 @@ void write_temp(const std::vector<uint8_t> &data, const std::string &filename, c
 	write_binary_file(data, path::get(path::Type::Temp) + filename, count);
 }
 
+std::vector<uint8_t> read_file(const std::string &filename, const uint32_t count)
+{
+	return read_binary_file(filename, count);
+}
+
+void write_file(const std::vector<uint8_t> &data, const std::string &filename, const uint32_t count)
+{
+	write_binary_file(data, filename, count);
+}
+
 void write_image(const uint8_t *data, const std::string &filename, const uint32_t width, const uint32_t height, const uint32_t components, const uint32_t row_stride)
 {
 	stbi_write_png((path::get(path::Type::Screenshots) + filename + ".png").c_str(), width, height, components, data, row_stride);
 }
 
+void write_image_qoi(const uint8_t *data, const std::string &filename, const uint32_t width, const uint32_t height)
+{
+	// Format described at https://qoiformat.org/qoi-specification.pdf
+	std::vector<uint8_t> qoi;
+	qoi.reserve(14 + width * height * 5 + 8);
+
+	auto write_u32 = [&qoi](uint32_t value) {
+		for (int shift = 24; shift >= 0; shift -= 8)
+		{
+			qoi.push_back(static_cast<uint8_t>(value >> shift));
+		}
+	};
+
+	qoi.insert(qoi.end(), {'q', 'o', 'i', 'f'});
+	write_u32(width);
+	write_u32(height);
+	// 4 channels, sRGB with linear alpha
+	qoi.insert(qoi.end(), {4, 0});
+
+	std::array<std::array<uint8_t, 4>, 64> index{};
+	std::array<uint8_t, 4>                 previous{0, 0, 0, 255};
+	uint8_t                                run = 0;
+
+	const size_t pixel_count = static_cast<size_t>(width) * height;
+
+	for (size_t i = 0; i < pixel_count; ++i)
+	{
+		std::array<uint8_t, 4> pixel{data[i * 4], data[i * 4 + 1], data[i * 4 + 2], data[i * 4 + 3]};
+
+		if (pixel == previous)
+		{
+			++run;
+			if (run == 62 || i + 1 == pixel_count)
+			{
+				qoi.push_back(static_cast<uint8_t>(0xc0 | (run - 1)));
+				run = 0;
+			}
+			continue;
+		}
+
+		if (run > 0)
+		{
+			qoi.push_back(static_cast<uint8_t>(0xc0 | (run - 1)));
+			run = 0;
+		}
+
+		uint8_t hash = (pixel[0] * 3 + pixel[1] * 5 + pixel[2] * 7 + pixel[3] * 11) % 64;
+
+		if (index[hash] == pixel)
+		{
+			qoi.push_back(hash);
+		}
+		else
+		{
+			index[hash] = pixel;
+
+			if (pixel[3] == previous[3])
+			{
+				int8_t dr = static_cast<int8_t>(pixel[0] - previous[0]);
+				int8_t dg = static_cast<int8_t>(pixel[1] - previous[1]);
+				int8_t db = static_cast<int8_t>(pixel[2] - previous[2]);
+
+				int8_t dr_dg = static_cast<int8_t>(dr - dg);
+				int8_t db_dg = static_cast<int8_t>(db - dg);
+
+				if (dr >= -2 && dr <= 1 && dg >= -2 && dg <= 1 && db >= -2 && db <= 1)
+				{
+					qoi.push_back(static_cast<uint8_t>(0x40 | (dr + 2) << 4 | (dg + 2) << 2 | (db + 2)));
+				}
+				else if (dg >= -32 && dg <= 31 && dr_dg >= -8 && dr_dg <= 7 && db_dg >= -8 && db_dg <= 7)
+				{
+					qoi.push_back(static_cast<uint8_t>(0x80 | (dg + 32)));
+					qoi.push_back(static_cast<uint8_t>((dr_dg + 8) << 4 | (db_dg + 8)));
+				}
+				else
+				{
+					qoi.insert(qoi.end(), {0xfe, pixel[0], pixel[1], pixel[2]});
+				}
+			}
+			else
+			{
+				qoi.insert(qoi.end(), {0xff, pixel[0], pixel[1], pixel[2], pixel[3]});
+			}
+		}
+
+		previous = pixel;
+	}
+
+	qoi.insert(qoi.end(), {0, 0, 0, 0, 0, 0, 0, 1});
+
+	write_file(qoi, path::get(path::Type::Screenshots) + filename + ".qoi");
+}
+
 bool write_json(nlohmann::json &data, const std::string &filename)
 {
 	std::stringstream json;
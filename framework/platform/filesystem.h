@@ -90,6 +90,74 @@ void create_directory(const std::string &path);
  */
 void create_path(const std::string &root, const std::string &path);
 
+/**
+ * @brief A read-only view of a whole file mapped in memory, the file is unmapped when the view is destroyed
+ */
+class MappedFile
+{
+  public:
+	/**
+	 * @brief Maps a file in memory
+	 * @param filename The path to the file
+	 * @throws runtime_error if the file can't be opened or mapped
+	 */
+	MappedFile(const std::string &filename);
+
+	MappedFile(const MappedFile &) = delete;
+
+	MappedFile(MappedFile &&other);
+
+	~MappedFile();
+
+	MappedFile &operator=(const MappedFile &) = delete;
+
+	MappedFile &operator=(MappedFile &&) = delete;
+
+	/**
+	 * @return The contents of the file, nullptr if it is empty
+	 */
+	const uint8_t *data() const;
+
+	/**
+	 * @return The size of the file in bytes
+	 */
+	size_t size() const;
+
+  private:
+	const uint8_t *mapped_data{nullptr};
+
+	size_t mapped_size{0};
+
+#if defined(_WIN32)
+	/// Handle of the file mapping object
+	void *mapping{nullptr};
+#endif
+};
+
+/**
+ * @brief Helper to map an asset file in memory, without copying it
+ *
+ * @param filename The path to the file (relative to the assets directory)
+ * @return A read-only view of the file
+ */
+MappedFile map_asset(const std::string &filename);
+
+/**
+ * @brief Helper to map a temporary file in memory, without copying it
+ *
+ * @param filename The path to the file (relative to the temporary storage directory)
+ * @return A read-only view of the file
+ */
+MappedFile map_temp(const std::string &filename);
+
+/**
+ * @brief Helper to map a file at an arbitrary path in memory, without copying it
+ *
+ * @param filename The path to the file
+ * @return A read-only view of the file
+ */
+MappedFile map_file(const std::string &filename);
+
 /**
  * @brief Helper to read an asset file into a byte-array
  *
@@ -108,6 +176,20 @@ std::vector<uint8_t> read_asset(const std::string &filename, const uint32_t coun
  */
 std::vector<uint8_t> read_shader(const std::string &filename);
 
+/**
+ * @brief Gets the time a file was last written
+ * @param path The absolute path to the file
+ * @return The modification time in seconds since the epoch, 0 if the file can't be found
+ */
+int64_t get_modification_time(const std::string &path);
+
+/**
+ * @brief Gets the time a shader file was last written
+ * @param filename The path to the file (relative to the shaders directory)
+ * @return The modification time in seconds since the epoch, 0 if the file can't be found
+ */
+int64_t get_shader_modification_time(const std::string &filename);
+
 /**
  * @brief Helper to read a temporary file into a byte-array
  *
@@ -128,6 +210,26 @@ std::vector<uint8_t> read_temp(const std::string &filename, const uint32_t count
  */
 void write_temp(const std::vector<uint8_t> &data, const std::string &filename, const uint32_t count = 0);
 
+/**
+ * @brief Helper to read a file at an arbitrary path into a byte-array
+ *
+ * @param filename The path to the file
+ * @param count (optional) How many bytes to read. If 0 or not specified, the size
+ * of the file will be used.
+ * @return A vector filled with data read from the file
+ */
+std::vector<uint8_t> read_file(const std::string &filename, const uint32_t count = 0);
+
+/**
+ * @brief Helper to write to a file at an arbitrary path
+ *
+ * @param data A vector filled with data to write
+ * @param filename The path to the file
+ * @param count (optional) How many bytes to write. If 0 or not specified, the size
+ * of data will be used.
+ */
+void write_file(const std::vector<uint8_t> &data, const std::string &filename, const uint32_t count = 0);
+
 /**
  * @brief Helper to write to a png image in permanent storage
  *
@@ -140,6 +242,16 @@ void write_temp(const std::vector<uint8_t> &data, const std::string &filename, c
  */
 void write_image(const uint8_t *data, const std::string &filename, const uint32_t width, const uint32_t height, const uint32_t components, const uint32_t row_stride);
 
+/**
+ * @brief Helper to write to a qoi image in permanent storage, which encodes several times faster than png
+ *
+ * @param data       Tightly packed pixel data to write in (R, G, B, A) format
+ * @param filename   The name of the image file without an extension
+ * @param width      The width of the image
+ * @param height     The height of the image
+ */
+void write_image_qoi(const uint8_t *data, const std::string &filename, const uint32_t width, const uint32_t height);
+
 /**
  * @brief Helper to output a json graph
  * 
@@ -0,0 +1,86 @@
+/* Copyright (c) 2020, Arm Limited and Contributors
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 the "License";
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "frame_pacer.h"
+
+#include <thread>
+
+namespace vkb
+{
+void FramePacer::set_target_fps(float fps)
+{
+	target_fps = fps;
+	next_frame = {};
+}
+
+float FramePacer::get_target_fps() const
+{
+	return target_fps;
+}
+
+void FramePacer::set_thermal_mode(bool enable)
+{
+	thermal_mode = enable;
+	next_frame   = {};
+}
+
+bool FramePacer::is_thermal_mode() const
+{
+	return thermal_mode;
+}
+
+void FramePacer::wait()
+{
+	float fps = target_fps > 0.0f ? target_fps : (thermal_mode ? THERMAL_FPS : 0.0f);
+
+	if (fps <= 0.0f)
+	{
+		return;
+	}
+
+	auto interval = std::chrono::duration_cast<Timer::Clock::duration>(std::chrono::duration<double>(1.0 / fps));
+	auto now      = Timer::Clock::now();
+
+	if (next_frame <= now)
+	{
+		// First frame, or the previous frame ran late
+		next_frame = now + interval;
+		return;
+	}
+
+	if (thermal_mode)
+	{
+		std::this_thread::sleep_until(next_frame);
+	}
+	else
+	{
+		auto spin_margin = std::chrono::duration_cast<Timer::Clock::duration>(std::chrono::duration<double, Timer::Milliseconds>(SPIN_MARGIN));
+
+		if (next_frame - now > spin_margin)
+		{
+			std::this_thread::sleep_until(next_frame - spin_margin);
+		}
+
+		while (Timer::Clock::now() < next_frame)
+		{
+			std::this_thread::yield();
+		}
+	}
+
+	next_frame += interval;
+}
+}        // namespace vkb
@@ -0,0 +1,70 @@
+/* Copyright (c) 2020, Arm Limited and Contributors
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 the "License";
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include "timer.h"
+
+namespace vkb
+{
+/**
+ * @brief Limits the frame rate of the main loop to a target, waiting before each frame
+ *
+ * The wait sleeps until shortly before the frame is due, then spins for the rest of it,
+ * as sleeps can overshoot by the scheduler granularity. In thermal mode it only sleeps,
+ * trading precise timing for an idle CPU, which keeps mobile devices from heating up.
+ */
+class FramePacer
+{
+  public:
+	/**
+	 * @brief Sets the frame rate to pace frames at
+	 * @param fps Frames per second, 0 to run frames as fast as possible
+	 */
+	void set_target_fps(float fps);
+
+	float get_target_fps() const;
+
+	/**
+	 * @brief Enables the thermal mode, which sleeps without spinning.
+	 *        Without a target frame rate, frames are paced at THERMAL_FPS.
+	 */
+	void set_thermal_mode(bool enable);
+
+	bool is_thermal_mode() const;
+
+	/**
+	 * @brief Waits until the next frame is due
+	 * If a frame ran late, pacing restarts from it instead of running the next frames early to catch up
+	 */
+	void wait();
+
+	/// Frame rate of the thermal mode when no target is set
+	static constexpr float THERMAL_FPS{30.0f};
+
+	/// Time before the frame is due at which the wait stops sleeping and spins, in milliseconds
+	static constexpr double SPIN_MARGIN{2.0};
+
+  private:
+	float target_fps{0.0f};
+
+	bool thermal_mode{false};
+
+	/// The time the next frame is due
+	Timer::Clock::time_point next_frame{};
+};
+}        // namespace vkb
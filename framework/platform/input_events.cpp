@@ -21,7 +21,8 @@ namespace vkb
 {
 InputEvent::InputEvent(Platform &platform, EventSource source) :
     platform{platform},
-    source{source}
+    source{source},
+    timestamp{Timer::Clock::now()}
 {
 }
 
@@ -35,6 +36,11 @@ EventSource InputEvent::get_source() const
 	return source;
 }
 
+Timer::Clock::time_point InputEvent::get_timestamp() const
+{
+	return timestamp;
+}
+
 KeyInputEvent::KeyInputEvent(Platform &platform, KeyCode code, KeyAction action) :
     InputEvent{platform, EventSource::Keyboard},
     code{code},
@@ -20,6 +20,8 @@
 #include <cstddef>
 #include <cstdint>
 
+#include "timer.h"
+
 namespace vkb
 {
 class Platform;
@@ -40,10 +42,17 @@ class InputEvent
 
 	EventSource get_source() const;
 
+	/**
+	 * @return The time the event was received from the platform
+	 */
+	Timer::Clock::time_point get_timestamp() const;
+
   private:
 	Platform &platform;
 
 	EventSource source;
+
+	Timer::Clock::time_point timestamp;
 };
 
 enum class KeyCode
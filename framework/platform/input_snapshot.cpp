@@ -0,0 +1,167 @@
+/* Copyright (c) 2020, Arm Limited and Contributors
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 the "License";
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "input_snapshot.h"
+
+#include <cmath>
+
+namespace vkb
+{
+constexpr size_t InputSnapshot::MAX_TOUCH_POINTERS;
+
+void InputSnapshot::add(const InputEvent &input_event)
+{
+	event_count++;
+	timestamp = input_event.get_timestamp();
+
+	if (input_event.get_source() == EventSource::Keyboard)
+	{
+		const auto &key_event = static_cast<const KeyInputEvent &>(input_event);
+
+		auto index = static_cast<size_t>(key_event.get_code());
+
+		if (key_event.get_action() == KeyAction::Down)
+		{
+			keys_pressed.set(index);
+			keys_down.set(index);
+		}
+		else if (key_event.get_action() == KeyAction::Repeat)
+		{
+			keys_pressed.set(index);
+		}
+		else
+		{
+			keys_pressed.reset(index);
+		}
+	}
+	else if (input_event.get_source() == EventSource::Mouse)
+	{
+		const auto &mouse_button = static_cast<const MouseButtonInputEvent &>(input_event);
+
+		auto index = static_cast<size_t>(mouse_button.get_button());
+
+		if (mouse_button.get_action() == MouseAction::Down)
+		{
+			mouse_buttons_pressed.set(index);
+		}
+		else if (mouse_button.get_action() == MouseAction::Up)
+		{
+			mouse_buttons_pressed.reset(index);
+		}
+		else if (mouse_button.get_action() == MouseAction::Move)
+		{
+			glm::vec2 position{std::floor(mouse_button.get_pos_x()), std::floor(mouse_button.get_pos_y())};
+
+			mouse_delta += position - mouse_position;
+			mouse_position = position;
+		}
+	}
+	else if (input_event.get_source() == EventSource::Touchscreen)
+	{
+		const auto &touch_event = static_cast<const TouchInputEvent &>(input_event);
+
+		auto pointer_id = touch_event.get_pointer_id();
+
+		if (pointer_id < 0 || static_cast<size_t>(pointer_id) >= MAX_TOUCH_POINTERS)
+		{
+			return;
+		}
+
+		glm::vec2 position{std::floor(touch_event.get_pos_x()), std::floor(touch_event.get_pos_y())};
+
+		if (touch_event.get_action() == TouchAction::Down)
+		{
+			touch_pointers_pressed.set(pointer_id);
+
+			if (pointer_id == 0)
+			{
+				touch_position = position;
+			}
+		}
+		else if (touch_event.get_action() == TouchAction::Up)
+		{
+			touch_pointers_pressed.reset(pointer_id);
+		}
+		else if (touch_event.get_action() == TouchAction::Move && pointer_id == 0)
+		{
+			touch_delta += position - touch_position;
+			touch_position = position;
+		}
+	}
+}
+
+void InputSnapshot::next_frame()
+{
+	keys_down.reset();
+
+	mouse_delta = glm::vec2{0.0f};
+	touch_delta = glm::vec2{0.0f};
+
+	event_count = 0;
+	timestamp   = {};
+}
+
+bool InputSnapshot::is_key_pressed(KeyCode code) const
+{
+	return keys_pressed.test(static_cast<size_t>(code));
+}
+
+bool InputSnapshot::was_key_pressed(KeyCode code) const
+{
+	return keys_down.test(static_cast<size_t>(code));
+}
+
+bool InputSnapshot::is_mouse_button_pressed(MouseButton button) const
+{
+	return mouse_buttons_pressed.test(static_cast<size_t>(button));
+}
+
+const glm::vec2 &InputSnapshot::get_mouse_position() const
+{
+	return mouse_position;
+}
+
+const glm::vec2 &InputSnapshot::get_mouse_delta() const
+{
+	return mouse_delta;
+}
+
+bool InputSnapshot::is_touch_pointer_pressed(int32_t pointer_id) const
+{
+	return pointer_id >= 0 && static_cast<size_t>(pointer_id) < MAX_TOUCH_POINTERS && touch_pointers_pressed.test(pointer_id);
+}
+
+const glm::vec2 &InputSnapshot::get_touch_position() const
+{
+	return touch_position;
+}
+
+const glm::vec2 &InputSnapshot::get_touch_delta() const
+{
+	return touch_delta;
+}
+
+uint32_t InputSnapshot::get_event_count() const
+{
+	return event_count;
+}
+
+Timer::Clock::time_point InputSnapshot::get_timestamp() const
+{
+	return timestamp;
+}
+}        // namespace vkb
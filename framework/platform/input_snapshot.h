@@ -0,0 +1,120 @@
+/* Copyright (c) 2020, Arm Limited and Contributors
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 the "License";
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <bitset>
+
+#include "common/error.h"
+
+VKBP_DISABLE_WARNINGS()
+#include "common/glm_common.h"
+VKBP_ENABLE_WARNINGS()
+
+#include "platform/input_events.h"
+
+namespace vkb
+{
+/**
+ * @brief The input state of a frame, folded from the events received since the previous one
+ *
+ * Keys, buttons and touch pointers keep their state across frames, while the movements
+ * of the mouse and of the first touch pointer are accumulated over the frame.
+ */
+class InputSnapshot
+{
+  public:
+	/// Number of touch pointers tracked, pointers with a higher id are ignored
+	static constexpr size_t MAX_TOUCH_POINTERS = 16;
+
+	/**
+	 * @brief Folds an event into the snapshot
+	 */
+	void add(const InputEvent &input_event);
+
+	/**
+	 * @brief Starts the snapshot of the next frame, clearing the movements and the events
+	 *        but keeping what is held down
+	 */
+	void next_frame();
+
+	/**
+	 * @return Whether the key is held down
+	 */
+	bool is_key_pressed(KeyCode code) const;
+
+	/**
+	 * @return Whether the key went down during the frame, even if it was released since
+	 */
+	bool was_key_pressed(KeyCode code) const;
+
+	bool is_mouse_button_pressed(MouseButton button) const;
+
+	const glm::vec2 &get_mouse_position() const;
+
+	/**
+	 * @return The movement of the mouse during the frame, in pixels
+	 */
+	const glm::vec2 &get_mouse_delta() const;
+
+	bool is_touch_pointer_pressed(int32_t pointer_id) const;
+
+	const glm::vec2 &get_touch_position() const;
+
+	/**
+	 * @return The movement of the first touch pointer during the frame, in pixels
+	 */
+	const glm::vec2 &get_touch_delta() const;
+
+	/**
+	 * @return The number of events folded during the frame
+	 */
+	uint32_t get_event_count() const;
+
+	/**
+	 * @return The time the newest event of the frame was received, the epoch of the clock if there was none
+	 */
+	Timer::Clock::time_point get_timestamp() const;
+
+  private:
+	static constexpr size_t KEY_CODE_COUNT = static_cast<size_t>(KeyCode::RightAlt) + 1;
+
+	static constexpr size_t MOUSE_BUTTON_COUNT = static_cast<size_t>(MouseButton::Unknown) + 1;
+
+	std::bitset<KEY_CODE_COUNT> keys_pressed;
+
+	/// Keys which went down during the frame
+	std::bitset<KEY_CODE_COUNT> keys_down;
+
+	std::bitset<MOUSE_BUTTON_COUNT> mouse_buttons_pressed;
+
+	glm::vec2 mouse_position{0.0f};
+
+	glm::vec2 mouse_delta{0.0f};
+
+	std::bitset<MAX_TOUCH_POINTERS> touch_pointers_pressed;
+
+	/// Position of the first touch pointer
+	glm::vec2 touch_position{0.0f};
+
+	glm::vec2 touch_delta{0.0f};
+
+	uint32_t event_count{0};
+
+	Timer::Clock::time_point timestamp{};
+};
+}        // namespace vkb
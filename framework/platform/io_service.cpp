@@ -0,0 +1,181 @@
+/* Copyright (c) 2020, Arm Limited and Contributors
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 the "License";
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "platform/io_service.h"
+
+#include <algorithm>
+
+#if defined(__linux__)
+#	include <fcntl.h>
+#	include <unistd.h>
+#endif
+
+#include "platform/filesystem.h"
+
+namespace vkb
+{
+namespace fs
+{
+namespace
+{
+/**
+ * @brief Lets the operating system start fetching a file which is about to be read
+ */
+void prefetch(const std::string &filename)
+{
+#if defined(__linux__)
+	int file = open(filename.c_str(), O_RDONLY);
+
+	if (file >= 0)
+	{
+		// The read ahead started here carries on once the file is closed
+		posix_fadvise(file, 0, 0, POSIX_FADV_WILLNEED);
+		close(file);
+	}
+#else
+	(void) filename;
+#endif
+}
+}        // namespace
+
+constexpr size_t IoService::MAX_BATCH_SIZE;
+
+IoService::IoService(size_t thread_count)
+{
+	thread_count = std::max<size_t>(thread_count, 1);
+
+	for (size_t i = 0; i < thread_count; ++i)
+	{
+		threads.emplace_back(&IoService::thread_loop, this);
+	}
+}
+
+IoService::~IoService()
+{
+	{
+		std::lock_guard<std::mutex> lock{queue_mutex};
+		stopping = true;
+	}
+
+	wake_condition.notify_all();
+
+	for (auto &thread : threads)
+	{
+		thread.join();
+	}
+}
+
+IoService &IoService::get()
+{
+	// Reads mostly wait on storage, a couple of threads keep enough of them in flight
+	static IoService io_service{2};
+
+	return io_service;
+}
+
+std::future<std::vector<uint8_t>> IoService::read(const std::string &filename, JobPriority priority)
+{
+	auto promise = std::make_shared<std::promise<std::vector<uint8_t>>>();
+
+	auto future = promise->get_future();
+
+	read(
+	    filename, [promise](std::vector<uint8_t> &&data, std::exception_ptr error) {
+		    if (error)
+		    {
+			    promise->set_exception(error);
+		    }
+		    else
+		    {
+			    promise->set_value(std::move(data));
+		    }
+	    },
+	    priority);
+
+	return future;
+}
+
+void IoService::read(const std::string &filename, ReadCallback &&callback, JobPriority priority)
+{
+	{
+		std::lock_guard<std::mutex> lock{queue_mutex};
+		queues[static_cast<size_t>(priority)].push_back({filename, std::move(callback)});
+	}
+
+	wake_condition.notify_one();
+}
+
+void IoService::thread_loop()
+{
+	std::vector<Request> batch;
+
+	while (true)
+	{
+		{
+			std::unique_lock<std::mutex> lock{queue_mutex};
+
+			wake_condition.wait(lock, [this]() {
+				return stopping || std::any_of(queues.begin(), queues.end(), [](const std::deque<Request> &queue) { return !queue.empty(); });
+			});
+
+			// Requests are taken from the highest priority queue first
+			for (auto &queue : queues)
+			{
+				while (!queue.empty() && batch.size() < MAX_BATCH_SIZE)
+				{
+					batch.push_back(std::move(queue.front()));
+					queue.pop_front();
+				}
+			}
+
+			if (batch.empty())
+			{
+				// Only reached when stopping with nothing left to read
+				return;
+			}
+		}
+
+		// Other threads may pick up the requests left behind
+		wake_condition.notify_one();
+
+		for (auto &request : batch)
+		{
+			prefetch(request.filename);
+		}
+
+		for (auto &request : batch)
+		{
+			std::vector<uint8_t> data;
+			std::exception_ptr   error;
+
+			try
+			{
+				data = read_file(request.filename);
+			}
+			catch (...)
+			{
+				error = std::current_exception();
+			}
+
+			request.callback(std::move(data), error);
+		}
+
+		batch.clear();
+	}
+}
+}        // namespace fs
+}        // namespace vkb
@@ -0,0 +1,117 @@
+/* Copyright (c) 2020, Arm Limited and Contributors
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 the "License";
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <array>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <future>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "job_system.h"
+
+namespace vkb
+{
+namespace fs
+{
+/**
+ * @brief Reads files on dedicated threads, so that storage latency overlaps with the work of the job system
+ *
+ * Requests are queued by priority and taken by the threads in batches. The files of a batch are
+ * announced to the operating system before any of them is read, so that it can fetch them concurrently.
+ * Requests still queued when the service is destroyed are completed before the threads exit.
+ */
+class IoService
+{
+  public:
+	/**
+	 * @brief Called on an I/O thread once a read has completed, it should only hand the data over to other threads
+	 * @param data The contents of the file
+	 * @param error The exception thrown by the read if it failed, in which case data is empty
+	 */
+	using ReadCallback = std::function<void(std::vector<uint8_t> &&data, std::exception_ptr error)>;
+
+	/**
+	 * @brief Creates the I/O threads
+	 * @param thread_count Number of threads, at least one
+	 */
+	IoService(size_t thread_count);
+
+	IoService(const IoService &) = delete;
+
+	IoService(IoService &&) = delete;
+
+	~IoService();
+
+	IoService &operator=(const IoService &) = delete;
+
+	IoService &operator=(IoService &&) = delete;
+
+	/**
+	 * @brief The I/O service used by the framework, created on first use
+	 */
+	static IoService &get();
+
+	/**
+	 * @brief Queues the read of a whole file
+	 * @param filename The path to the file
+	 * @param priority Order of the read among the queued ones
+	 * @return A future of the contents of the file, holding the exception thrown by the read if any
+	 */
+	std::future<std::vector<uint8_t>> read(const std::string &filename, JobPriority priority = JobPriority::Normal);
+
+	/**
+	 * @brief Queues the read of a whole file
+	 * @param filename The path to the file
+	 * @param callback Called with the contents of the file once it has been read
+	 * @param priority Order of the read among the queued ones
+	 */
+	void read(const std::string &filename, ReadCallback &&callback, JobPriority priority = JobPriority::Normal);
+
+  private:
+	struct Request
+	{
+		std::string filename;
+
+		ReadCallback callback;
+	};
+
+	/// Maximum number of requests a thread takes at once
+	static constexpr size_t MAX_BATCH_SIZE{16};
+
+	void thread_loop();
+
+	std::mutex queue_mutex;
+
+	std::condition_variable wake_condition;
+
+	/// Queued requests of every priority
+	std::array<std::deque<Request>, 3> queues;
+
+	bool stopping{false};
+
+	std::vector<std::thread> threads;
+};
+}        // namespace fs
+}        // namespace vkb
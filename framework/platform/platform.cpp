@@ -18,7 +18,9 @@
 #include "platform.h"
 
 #include <ctime>
+#include <limits>
 #include <mutex>
+#include <string>
 #include <vector>
 
 #include <spdlog/async_logger.h>
@@ -37,6 +39,8 @@ std::string Platform::external_storage_directory = "";
 
 std::string Platform::temp_directory = "";
 
+std::atomic<float> Platform::thermal_headroom{std::numeric_limits<float>::quiet_NaN()};
+
 bool Platform::initialize(std::unique_ptr<Application> &&app)
 {
 	assert(app && "Application is not valid");
@@ -44,7 +48,14 @@ bool Platform::initialize(std::unique_ptr<Application> &&app)
 
 	auto sinks = get_platform_sinks();
 
+#ifdef VKB_ASYNC_LOGGING
+	// Messages are written to the sinks by a background thread, so that logging does not block on file or logcat I/O.
+	// If the thread falls behind, the oldest queued messages are dropped rather than blocking the caller
+	spdlog::init_thread_pool(LOGGER_QUEUE_SIZE, 1);
+	auto logger = std::make_shared<spdlog::async_logger>("logger", sinks.begin(), sinks.end(), spdlog::thread_pool(), spdlog::async_overflow_policy::overrun_oldest);
+#else
 	auto logger = std::make_shared<spdlog::logger>("logger", sinks.begin(), sinks.end());
+#endif
 
 #ifdef VKB_DEBUG
 	logger->set_level(spdlog::level::debug);
@@ -53,6 +64,7 @@ bool Platform::initialize(std::unique_ptr<Application> &&app)
 #endif
 
 	logger->set_pattern(LOGGER_FORMAT);
+	logger->flush_on(spdlog::level::err);
 	spdlog::set_default_logger(logger);
 
 	LOGI("Logger initialized");
@@ -64,8 +76,28 @@ bool Platform::initialize(std::unique_ptr<Application> &&app)
 		total_benchmark_frames     = active_app->get_options().get_int("--benchmark");
 		remaining_benchmark_frames = total_benchmark_frames;
 		active_app->set_benchmark_mode(true);
+
+		if (active_app->get_options().contains("--benchmark-warmup"))
+		{
+			total_warmup_frames     = active_app->get_options().get_int("--benchmark-warmup");
+			remaining_warmup_frames = total_warmup_frames;
+		}
+
+		if (active_app->get_options().contains("--benchmark-report"))
+		{
+			benchmark_report_file = active_app->get_options().get_string("--benchmark-report");
+		}
+
+		benchmark_report.set_group(active_app->get_name());
+	}
+
+	if (active_app->get_options().contains("--target-fps"))
+	{
+		frame_pacer.set_target_fps(static_cast<float>(std::stod(active_app->get_options().get_string("--target-fps"))));
 	}
 
+	frame_pacer.set_thermal_mode(active_app->get_options().contains("--thermal-pacing"));
+
 	// Set the app as headless
 	active_app->set_headless(active_app->get_options().contains("--headless"));
 
@@ -102,14 +134,27 @@ void Platform::main_loop()
 
 void Platform::run()
 {
+	step_duration = 0.0;
+
+	frame_pacer.wait();
+
 	if (benchmark_mode)
 	{
-		timer.start();
+		if (timer.is_running())
+		{
+			// Time between the starts of consecutive measured frames, including event processing and pacing
+			benchmark_report.add_sample("frame_interval_ms", timer.elapsed<Timer::Milliseconds>());
+			timer.lap();
+		}
 
 		if (remaining_benchmark_frames == 0)
 		{
 			auto time_taken = timer.stop();
 			LOGI("Benchmark completed in {} seconds (ran {} frames, averaged {} fps)", time_taken, total_benchmark_frames, total_benchmark_frames / time_taken);
+
+			benchmark_report.log();
+			benchmark_report.write_json(benchmark_report_file, total_warmup_frames);
+
 			close();
 			return;
 		}
@@ -117,7 +162,35 @@ void Platform::run()
 
 	if (active_app->is_focused() || active_app->is_benchmark_mode())
 	{
+		// The measured frames start after the warm-up
+		if (benchmark_mode && remaining_warmup_frames == 0)
+		{
+			timer.start();
+		}
+
+		Timer frame_timer;
+		frame_timer.start();
+
 		active_app->step();
+
+		step_duration = frame_timer.elapsed();
+
+		if (!benchmark_mode)
+		{
+			return;
+		}
+
+		if (remaining_warmup_frames > 0)
+		{
+			remaining_warmup_frames--;
+			return;
+		}
+
+		auto frame_time = frame_timer.stop<Timer::Milliseconds>();
+
+		active_app->record_benchmark_samples(benchmark_report);
+		benchmark_report.add_sample("cpu_frame_time_ms", frame_time);
+
 		remaining_benchmark_frames--;
 	}
 }
@@ -132,7 +205,12 @@ void Platform::terminate(ExitCode code)
 	active_app.reset();
 	window.reset();
 
-	spdlog::drop_all();
+	// Writes the queued messages of the asynchronous logger before dropping it
+	if (auto logger = spdlog::default_logger())
+	{
+		logger->flush();
+	}
+	spdlog::shutdown();
 }
 
 void Platform::close() const
@@ -171,6 +249,16 @@ std::vector<std::string> &Platform::get_arguments()
 	return Platform::arguments;
 }
 
+JobSystem &Platform::get_job_system()
+{
+	return JobSystem::get();
+}
+
+FramePacer &Platform::get_frame_pacer()
+{
+	return frame_pacer;
+}
+
 void Platform::set_arguments(const std::vector<std::string> &args)
 {
 	arguments = args;
@@ -186,6 +274,16 @@ void Platform::set_temp_directory(const std::string &dir)
 	temp_directory = dir;
 }
 
+void Platform::set_thermal_headroom(float headroom)
+{
+	thermal_headroom.store(headroom, std::memory_order_relaxed);
+}
+
+float Platform::get_thermal_headroom()
+{
+	return thermal_headroom.load(std::memory_order_relaxed);
+}
+
 std::vector<spdlog::sink_ptr> Platform::get_platform_sinks()
 {
 	return {};
@@ -17,15 +17,19 @@
 
 #pragma once
 
+#include <atomic>
 #include <memory>
 #include <string>
 #include <vector>
 
 #include "common/utils.h"
 #include "common/vk_common.h"
+#include "job_system.h"
 #include "platform/application.h"
 #include "platform/filesystem.h"
 #include "platform/window.h"
+#include "platform/frame_pacer.h"
+#include "stats/benchmark_report.h"
 
 namespace vkb
 {
@@ -104,12 +108,33 @@ class Platform
 
 	std::vector<std::string> &get_arguments();
 
+	/**
+	 * @return The job system shared by the framework subsystems
+	 */
+	JobSystem &get_job_system();
+
+	/**
+	 * @return The pacer limiting the frame rate of the main loop
+	 */
+	FramePacer &get_frame_pacer();
+
 	static void set_arguments(const std::vector<std::string> &args);
 
 	static void set_external_storage_directory(const std::string &dir);
 
 	static void set_temp_directory(const std::string &dir);
 
+	/**
+	 * @brief Publishes how far the device is from severe thermal throttling, for the stats
+	 * @param headroom 0 without thermal pressure up to 1 when severe throttling starts, NaN if it is unknown
+	 */
+	static void set_thermal_headroom(float headroom);
+
+	/**
+	 * @return The last thermal headroom published by the platform, NaN if the platform does not report it
+	 */
+	static float get_thermal_headroom();
+
   protected:
 	std::unique_ptr<Window> window{nullptr};
 
@@ -121,8 +146,24 @@ class Platform
 
 	uint32_t remaining_benchmark_frames{0};
 
+	/// Frames run before the measured benchmark frames
+	uint32_t remaining_warmup_frames{0};
+
+	uint32_t total_warmup_frames{0};
+
+	BenchmarkReport benchmark_report;
+
+	/// File the benchmark report is written to, in the graphs directory
+	std::string benchmark_report_file{"benchmark.json"};
+
+	/// Runs from the start of the first measured benchmark frame, lapped at the start of every frame
 	Timer timer;
 
+	FramePacer frame_pacer;
+
+	/// Time the last frame spent in the step of the app, without the pacing, in seconds; 0 if no frame ran
+	double step_duration{0.0};
+
 	virtual std::vector<spdlog::sink_ptr> get_platform_sinks();
 
 	/**
@@ -137,5 +178,8 @@ class Platform
 	static std::string external_storage_directory;
 
 	static std::string temp_directory;
+
+	/// Static so that the stats providers can read it without the platform
+	static std::atomic<float> thermal_headroom;
 };
 }        // namespace vkb
@@ -0,0 +1,268 @@
+/* Copyright (c) 2020, Arm Limited and Contributors
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 the "License";
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "platform/process.h"
+
+#include <stdexcept>
+
+#include "common/logging.h"
+
+#if defined(_WIN32)
+#	include <windows.h>
+#else
+#	include <sys/types.h>
+#	include <sys/wait.h>
+#	include <unistd.h>
+#	if defined(__linux__)
+#		include <sched.h>
+#	elif defined(__APPLE__)
+#		include <mach-o/dyld.h>
+#	endif
+#endif
+
+namespace vkb
+{
+#if defined(_WIN32)
+namespace
+{
+/**
+ * @brief Quotes an argument for a Windows command line, escaping the quotes and the backslashes preceding them
+ */
+std::string quote_argument(const std::string &argument)
+{
+	std::string quoted = "\"";
+	size_t      slashes = 0;
+
+	for (char c : argument)
+	{
+		if (c == '\\')
+		{
+			++slashes;
+		}
+		else
+		{
+			if (c == '"')
+			{
+				quoted.append(slashes + 1, '\\');
+			}
+			slashes = 0;
+		}
+		quoted += c;
+	}
+
+	quoted.append(slashes, '\\');
+	return quoted + "\"";
+}
+}        // namespace
+
+Process::Process(const std::vector<std::string> &arguments, const std::vector<uint32_t> &cpu_cores)
+{
+	std::string command_line;
+	for (auto &argument : arguments)
+	{
+		command_line += (command_line.empty() ? "" : " ") + quote_argument(argument);
+	}
+
+	STARTUPINFOA        startup_info{};
+	PROCESS_INFORMATION process_info{};
+	startup_info.cb = sizeof(startup_info);
+
+	// Started suspended so that it is pinned before running any code
+	if (!CreateProcessA(nullptr, &command_line[0], nullptr, nullptr, FALSE, CREATE_SUSPENDED, nullptr, nullptr, &startup_info, &process_info))
+	{
+		throw std::runtime_error{"Failed to start process: " + arguments.at(0)};
+	}
+
+	if (!cpu_cores.empty())
+	{
+		DWORD_PTR mask = 0;
+		for (uint32_t core : cpu_cores)
+		{
+			if (core < sizeof(DWORD_PTR) * 8)
+			{
+				mask |= DWORD_PTR{1} << core;
+			}
+		}
+
+		if (mask == 0 || !SetProcessAffinityMask(process_info.hProcess, mask))
+		{
+			LOGW("Failed to pin process {} to its CPU cores", arguments.at(0));
+		}
+	}
+
+	ResumeThread(process_info.hThread);
+	CloseHandle(process_info.hThread);
+
+	handle = process_info.hProcess;
+}
+
+Process::~Process()
+{
+	wait();
+	CloseHandle(static_cast<HANDLE>(handle));
+}
+
+bool Process::poll(int &code)
+{
+	if (!exited && WaitForSingleObject(static_cast<HANDLE>(handle), 0) == WAIT_OBJECT_0)
+	{
+		DWORD process_exit_code = 0;
+		GetExitCodeProcess(static_cast<HANDLE>(handle), &process_exit_code);
+
+		exit_code = static_cast<int>(process_exit_code);
+		exited    = true;
+	}
+
+	code = exit_code;
+	return exited;
+}
+
+int Process::wait()
+{
+	if (!exited)
+	{
+		WaitForSingleObject(static_cast<HANDLE>(handle), INFINITE);
+	}
+
+	int code = 0;
+	poll(code);
+	return code;
+}
+
+std::string Process::get_executable_path()
+{
+	std::string path(MAX_PATH, '\0');
+	DWORD       length = GetModuleFileNameA(nullptr, &path[0], static_cast<DWORD>(path.size()));
+	path.resize(length);
+	return path;
+}
+#else
+namespace
+{
+/**
+ * @brief Converts the status returned by waitpid to an exit code, signals being reported as 128 plus their number
+ */
+int get_exit_code(int status)
+{
+	if (WIFEXITED(status))
+	{
+		return WEXITSTATUS(status);
+	}
+
+	return 128 + (WIFSIGNALED(status) ? WTERMSIG(status) : 0);
+}
+}        // namespace
+
+Process::Process(const std::vector<std::string> &arguments, const std::vector<uint32_t> &cpu_cores)
+{
+	std::vector<char *> argv;
+	for (auto &argument : arguments)
+	{
+		argv.push_back(const_cast<char *>(argument.c_str()));
+	}
+	argv.push_back(nullptr);
+
+#if defined(__linux__)
+	cpu_set_t cpu_set;
+	CPU_ZERO(&cpu_set);
+	for (uint32_t core : cpu_cores)
+	{
+		CPU_SET(core, &cpu_set);
+	}
+#else
+	if (!cpu_cores.empty())
+	{
+		LOGW("Pinning processes to CPU cores is not supported on this platform");
+	}
+#endif
+
+	pid = fork();
+
+	if (pid < 0)
+	{
+		pid = 0;
+		throw std::runtime_error{"Failed to start process: " + arguments.at(0)};
+	}
+
+	if (pid == 0)
+	{
+		// Only async-signal-safe calls are made in the child before exec
+#if defined(__linux__)
+		if (!cpu_cores.empty())
+		{
+			sched_setaffinity(0, sizeof(cpu_set), &cpu_set);
+		}
+#endif
+		execv(argv[0], argv.data());
+		_exit(127);
+	}
+}
+
+Process::~Process()
+{
+	wait();
+}
+
+bool Process::poll(int &code)
+{
+	if (!exited)
+	{
+		int status = 0;
+		if (waitpid(pid, &status, WNOHANG) == pid)
+		{
+			exit_code = get_exit_code(status);
+			exited    = true;
+		}
+	}
+
+	code = exit_code;
+	return exited;
+}
+
+int Process::wait()
+{
+	if (!exited)
+	{
+		int status = 0;
+		if (waitpid(pid, &status, 0) == pid)
+		{
+			exit_code = get_exit_code(status);
+		}
+		exited = true;
+	}
+
+	return exit_code;
+}
+
+std::string Process::get_executable_path()
+{
+#	if defined(__APPLE__)
+	uint32_t    size = 0;
+	_NSGetExecutablePath(nullptr, &size);
+	std::string path(size, '\0');
+	_NSGetExecutablePath(&path[0], &size);
+	path.resize(path.find('\0') == std::string::npos ? path.size() : path.find('\0'));
+	return path;
+#	else
+	std::string path(4096, '\0');
+	ssize_t     length = readlink("/proc/self/exe", &path[0], path.size());
+	path.resize(length > 0 ? static_cast<size_t>(length) : 0);
+	return path;
+#	endif
+}
+#endif
+}        // namespace vkb
@@ -0,0 +1,84 @@
+/* Copyright (c) 2020, Arm Limited and Contributors
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 the "License";
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace vkb
+{
+/**
+ * @brief A child process running a program, optionally pinned to a set of CPU cores
+ *
+ * The process is waited for when the object is destroyed, so that it does not outlive its parent unnoticed.
+ * Pinning is supported on Linux and Windows, and ignored with a warning elsewhere.
+ */
+class Process
+{
+  public:
+	/**
+	 * @brief Starts a program
+	 * @param arguments Path to the program followed by its arguments
+	 * @param cpu_cores Cores the process may run on, any core if empty
+	 * @throws std::runtime_error if the process cannot be started
+	 */
+	Process(const std::vector<std::string> &arguments, const std::vector<uint32_t> &cpu_cores = {});
+
+	Process(const Process &) = delete;
+
+	Process(Process &&) = delete;
+
+	~Process();
+
+	Process &operator=(const Process &) = delete;
+
+	Process &operator=(Process &&) = delete;
+
+	/**
+	 * @brief Checks whether the process exited, without blocking
+	 * @param exit_code Set to the exit code of the process if it exited
+	 * @return Whether the process exited
+	 */
+	bool poll(int &exit_code);
+
+	/**
+	 * @brief Blocks until the process exits
+	 * @return The exit code of the process
+	 */
+	int wait();
+
+	/**
+	 * @return The path to the executable of the current process
+	 */
+	static std::string get_executable_path();
+
+  private:
+#if defined(_WIN32)
+	/// Handle of the process, a HANDLE
+	void *handle{nullptr};
+#else
+	/// Process identifier, 0 once the process was waited for
+	int pid{0};
+#endif
+
+	bool exited{false};
+
+	int exit_code{0};
+};
+}        // namespace vkb
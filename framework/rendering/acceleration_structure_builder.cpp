@@ -0,0 +1,474 @@
+/* Copyright (c) 2020, Arm Limited and Contributors
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 the "License";
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "rendering/acceleration_structure_builder.h"
+
+#include <algorithm>
+#include <unordered_map>
+
+#include "common/logging.h"
+#include "core/device.h"
+#include "core/query_pool.h"
+#include "scene_graph/components/mesh.h"
+#include "scene_graph/components/sub_mesh.h"
+#include "scene_graph/node.h"
+#include "scene_graph/scene.h"
+
+namespace vkb
+{
+namespace
+{
+/// Alignment of the scratch memory of the builds of a batch
+constexpr VkDeviceSize SCRATCH_ALIGNMENT = 256;
+
+VkTransformMatrixKHR to_transform_matrix(const glm::mat4 &transform)
+{
+	// Rows of the upper 3x4 part, glm matrices are column major
+	VkTransformMatrixKHR matrix{};
+	for (int row = 0; row < 3; ++row)
+	{
+		for (int column = 0; column < 4; ++column)
+		{
+			matrix.matrix[row][column] = transform[column][row];
+		}
+	}
+	return matrix;
+}
+
+void acceleration_structure_barrier(VkCommandBuffer command_buffer, VkPipelineStageFlags dst_stage_mask, VkAccessFlags dst_access_mask)
+{
+	VkMemoryBarrier barrier{VK_STRUCTURE_TYPE_MEMORY_BARRIER};
+	barrier.srcAccessMask = VK_ACCESS_ACCELERATION_STRUCTURE_WRITE_BIT_KHR;
+	barrier.dstAccessMask = dst_access_mask;
+
+	vkCmdPipelineBarrier(command_buffer, VK_PIPELINE_STAGE_ACCELERATION_STRUCTURE_BUILD_BIT_KHR, dst_stage_mask, 0, 1, &barrier, 0, nullptr, 0, nullptr);
+}
+}        // namespace
+
+AccelerationStructureBuilder::AccelerationStructureBuilder(Device &device, VkBuildAccelerationStructureFlagsKHR bottom_level_flags, VkDeviceSize scratch_budget) :
+    device{device},
+    bottom_level_flags{bottom_level_flags},
+    scratch_budget{scratch_budget}
+{
+}
+
+uint32_t AccelerationStructureBuilder::add_sub_mesh(const sg::SubMesh &sub_mesh)
+{
+	sg::VertexAttribute position;
+	if (!sub_mesh.get_attribute("position", position))
+	{
+		throw std::runtime_error("Sub mesh has no position to build an acceleration structure from");
+	}
+
+	VkFormatProperties format_properties;
+	vkGetPhysicalDeviceFormatProperties(device.get_gpu().get_handle(), position.format, &format_properties);
+	if (!(format_properties.bufferFeatures & VK_FORMAT_FEATURE_ACCELERATION_STRUCTURE_VERTEX_BUFFER_BIT_KHR))
+	{
+		throw std::runtime_error("Position format " + to_string(position.format) + " is not supported by acceleration structures");
+	}
+
+	auto vertex_buffer = sub_mesh.has_interleaved_vertices() ? sub_mesh.get_interleaved_vertex_buffer() : sub_mesh.get_vertex_buffer("position");
+	if (!vertex_buffer.buffer)
+	{
+		throw std::runtime_error("Sub mesh has no position buffer to build an acceleration structure from");
+	}
+
+	auto index_buffer = sub_mesh.get_index_buffer();
+
+	BottomLevel bottom_level;
+
+	bottom_level.geometry_info.geometryType   = VK_GEOMETRY_TYPE_TRIANGLES_KHR;
+	bottom_level.geometry_info.maxVertexCount = sub_mesh.vertices_count;
+	bottom_level.geometry_info.vertexFormat   = position.format;
+
+	bottom_level.geometry.flags        = VK_GEOMETRY_OPAQUE_BIT_KHR;
+	bottom_level.geometry.geometryType = VK_GEOMETRY_TYPE_TRIANGLES_KHR;
+
+	auto &triangles                    = bottom_level.geometry.geometry.triangles;
+	triangles.sType                    = VK_STRUCTURE_TYPE_ACCELERATION_STRUCTURE_GEOMETRY_TRIANGLES_DATA_KHR;
+	triangles.vertexFormat             = position.format;
+	triangles.vertexData.deviceAddress = get_buffer_device_address(*vertex_buffer.buffer) + vertex_buffer.offset + position.offset;
+	triangles.vertexStride             = position.stride;
+
+	if (index_buffer.buffer)
+	{
+		bottom_level.geometry_info.indexType         = sub_mesh.index_type;
+		bottom_level.geometry_info.maxPrimitiveCount = sub_mesh.vertex_indices / 3;
+
+		triangles.indexType               = sub_mesh.index_type;
+		triangles.indexData.deviceAddress = get_buffer_device_address(*index_buffer.buffer) + index_buffer.offset;
+
+		// The index offset of sub meshes is in bytes, as the primitive offset of indexed geometries
+		bottom_level.build_offset.primitiveOffset = sub_mesh.index_offset;
+	}
+	else
+	{
+		bottom_level.geometry_info.indexType         = VK_INDEX_TYPE_NONE_KHR;
+		bottom_level.geometry_info.maxPrimitiveCount = sub_mesh.vertices_count / 3;
+
+		triangles.indexType = VK_INDEX_TYPE_NONE_KHR;
+	}
+
+	bottom_level.build_offset.primitiveCount = bottom_level.geometry_info.maxPrimitiveCount;
+
+	bottom_levels.push_back(std::move(bottom_level));
+
+	return to_u32(bottom_levels.size() - 1);
+}
+
+uint32_t AccelerationStructureBuilder::add_scene(const sg::Scene &scene)
+{
+	// Sub meshes may be shared by meshes, they only need one bottom level acceleration structure
+	std::unordered_map<const sg::SubMesh *, uint32_t> sub_mesh_bottom_levels;
+
+	uint32_t instance_count = 0;
+
+	for (auto mesh : scene.get_components<sg::Mesh>())
+	{
+		for (auto sub_mesh : mesh->get_submeshes())
+		{
+			auto it = sub_mesh_bottom_levels.find(sub_mesh);
+			if (it == sub_mesh_bottom_levels.end())
+			{
+				try
+				{
+					it = sub_mesh_bottom_levels.emplace(sub_mesh, add_sub_mesh(*sub_mesh)).first;
+				}
+				catch (const std::runtime_error &error)
+				{
+					LOGW("Sub mesh {} skipped in acceleration structures: {}", sub_mesh->get_name(), error.what());
+					continue;
+				}
+			}
+
+			for (auto node : mesh->get_nodes())
+			{
+				add_instance(it->second, node->get_transform().get_world_matrix());
+				instance_count++;
+			}
+		}
+	}
+
+	return instance_count;
+}
+
+void AccelerationStructureBuilder::build_bottom_level(VkQueue queue)
+{
+	if (built_count == bottom_levels.size())
+	{
+		return;
+	}
+
+	// Create the acceleration structures, and split their builds in batches within the scratch budget
+	std::vector<std::pair<size_t, size_t>> batches;
+	std::vector<VkDeviceSize>              scratch_offsets;
+
+	VkDeviceSize batch_scratch_size = 0;
+	VkDeviceSize max_scratch_size   = 0;
+
+	for (size_t i = built_count; i < bottom_levels.size(); ++i)
+	{
+		auto &bottom_level = bottom_levels[i];
+
+		bottom_level.acceleration_structure = std::make_unique<core::AccelerationStructure>(device, VK_ACCELERATION_STRUCTURE_TYPE_BOTTOM_LEVEL_KHR,
+		                                                                                    bottom_level_flags, std::vector<VkAccelerationStructureCreateGeometryTypeInfoKHR>{bottom_level.geometry_info});
+
+		auto scratch_size = bottom_level.acceleration_structure->get_scratch_size();
+		scratch_size      = (scratch_size + SCRATCH_ALIGNMENT - 1) / SCRATCH_ALIGNMENT * SCRATCH_ALIGNMENT;
+
+		if (batches.empty() || batch_scratch_size + scratch_size > scratch_budget)
+		{
+			batches.emplace_back(i, i);
+			batch_scratch_size = 0;
+		}
+
+		scratch_offsets.push_back(batch_scratch_size);
+
+		batch_scratch_size += scratch_size;
+		batches.back().second = i + 1;
+		max_scratch_size      = std::max(max_scratch_size, batch_scratch_size);
+	}
+
+	if (!scratch_buffer || scratch_buffer->get_size() < max_scratch_size)
+	{
+		scratch_buffer = std::make_unique<core::Buffer>(device, max_scratch_size,
+		                                                VK_BUFFER_USAGE_RAY_TRACING_BIT_KHR | VK_BUFFER_USAGE_SHADER_DEVICE_ADDRESS_BIT,
+		                                                VMA_MEMORY_USAGE_GPU_ONLY, 0);
+	}
+
+	uint64_t scratch_address = get_buffer_device_address(*scratch_buffer);
+
+	VkCommandBuffer command_buffer = device.create_command_buffer(VK_COMMAND_BUFFER_LEVEL_PRIMARY, true);
+
+	for (auto &batch : batches)
+	{
+		std::vector<VkAccelerationStructureBuildGeometryInfoKHR> build_infos;
+		std::vector<const VkAccelerationStructureGeometryKHR *>  geometries;
+		std::vector<const VkAccelerationStructureBuildOffsetInfoKHR *> build_offsets;
+
+		geometries.reserve(batch.second - batch.first);
+
+		for (size_t i = batch.first; i < batch.second; ++i)
+		{
+			auto &bottom_level = bottom_levels[i];
+
+			geometries.push_back(&bottom_level.geometry);
+			build_offsets.push_back(&bottom_level.build_offset);
+
+			VkAccelerationStructureBuildGeometryInfoKHR build_info{VK_STRUCTURE_TYPE_ACCELERATION_STRUCTURE_BUILD_GEOMETRY_INFO_KHR};
+			build_info.type                      = VK_ACCELERATION_STRUCTURE_TYPE_BOTTOM_LEVEL_KHR;
+			build_info.flags                     = bottom_level_flags;
+			build_info.update                    = VK_FALSE;
+			build_info.dstAccelerationStructure  = bottom_level.acceleration_structure->get_handle();
+			build_info.geometryArrayOfPointers   = VK_FALSE;
+			build_info.geometryCount             = 1;
+			build_info.ppGeometries              = &geometries.back();
+			build_info.scratchData.deviceAddress = scratch_address + scratch_offsets[i - built_count];
+
+			build_infos.push_back(build_info);
+		}
+
+		vkCmdBuildAccelerationStructureKHR(command_buffer, to_u32(build_infos.size()), build_infos.data(), build_offsets.data());
+
+		// The next batch reuses the scratch memory, and compaction reads the built acceleration structures
+		acceleration_structure_barrier(command_buffer, VK_PIPELINE_STAGE_ACCELERATION_STRUCTURE_BUILD_BIT_KHR,
+		                               VK_ACCESS_ACCELERATION_STRUCTURE_READ_BIT_KHR | VK_ACCESS_ACCELERATION_STRUCTURE_WRITE_BIT_KHR);
+	}
+
+	device.flush_command_buffer(command_buffer, queue);
+
+	if (bottom_level_flags & VK_BUILD_ACCELERATION_STRUCTURE_ALLOW_COMPACTION_BIT_KHR)
+	{
+		compact_bottom_level(queue, built_count);
+	}
+
+	LOGI("Built {} bottom level acceleration structures in {} batches", bottom_levels.size() - built_count, batches.size());
+
+	built_count = bottom_levels.size();
+
+	// Instances refer to the addresses of the new acceleration structures
+	top_level_dirty = true;
+}
+
+void AccelerationStructureBuilder::compact_bottom_level(VkQueue queue, size_t first)
+{
+	uint32_t count = to_u32(bottom_levels.size() - first);
+
+	VkQueryPoolCreateInfo query_pool_info{VK_STRUCTURE_TYPE_QUERY_POOL_CREATE_INFO};
+	query_pool_info.queryType  = VK_QUERY_TYPE_ACCELERATION_STRUCTURE_COMPACTED_SIZE_KHR;
+	query_pool_info.queryCount = count;
+
+	QueryPool query_pool{device, query_pool_info};
+
+	std::vector<VkAccelerationStructureKHR> handles;
+	for (size_t i = first; i < bottom_levels.size(); ++i)
+	{
+		handles.push_back(bottom_levels[i].acceleration_structure->get_handle());
+	}
+
+	VkCommandBuffer command_buffer = device.create_command_buffer(VK_COMMAND_BUFFER_LEVEL_PRIMARY, true);
+	vkCmdResetQueryPool(command_buffer, query_pool.get_handle(), 0, count);
+	vkCmdWriteAccelerationStructuresPropertiesKHR(command_buffer, count, handles.data(),
+	                                              VK_QUERY_TYPE_ACCELERATION_STRUCTURE_COMPACTED_SIZE_KHR, query_pool.get_handle(), 0);
+	device.flush_command_buffer(command_buffer, queue);
+
+	std::vector<VkDeviceSize> compacted_sizes(count);
+	VK_CHECK(query_pool.get_results(0, count, compacted_sizes.size() * sizeof(VkDeviceSize), compacted_sizes.data(), sizeof(VkDeviceSize),
+	                                VK_QUERY_RESULT_64_BIT | VK_QUERY_RESULT_WAIT_BIT));
+
+	std::vector<std::unique_ptr<core::AccelerationStructure>> compacted;
+
+	VkDeviceSize original_size  = 0;
+	VkDeviceSize compacted_size = 0;
+
+	command_buffer = device.create_command_buffer(VK_COMMAND_BUFFER_LEVEL_PRIMARY, true);
+
+	for (uint32_t i = 0; i < count; ++i)
+	{
+		auto &original = *bottom_levels[first + i].acceleration_structure;
+
+		compacted.push_back(std::make_unique<core::AccelerationStructure>(device, VK_ACCELERATION_STRUCTURE_TYPE_BOTTOM_LEVEL_KHR,
+		                                                                  bottom_level_flags, compacted_sizes[i]));
+
+		VkCopyAccelerationStructureInfoKHR copy_info{VK_STRUCTURE_TYPE_COPY_ACCELERATION_STRUCTURE_INFO_KHR};
+		copy_info.src  = original.get_handle();
+		copy_info.dst  = compacted.back()->get_handle();
+		copy_info.mode = VK_COPY_ACCELERATION_STRUCTURE_MODE_COMPACT_KHR;
+
+		vkCmdCopyAccelerationStructureKHR(command_buffer, &copy_info);
+
+		original_size += original.get_memory_size();
+		compacted_size += compacted.back()->get_memory_size();
+	}
+
+	device.flush_command_buffer(command_buffer, queue);
+
+	// The copies completed, the original acceleration structures can be destroyed
+	for (uint32_t i = 0; i < count; ++i)
+	{
+		bottom_levels[first + i].acceleration_structure = std::move(compacted[i]);
+	}
+
+	LOGI("Compacted bottom level acceleration structures from {} KB to {} KB", original_size / 1024, compacted_size / 1024);
+}
+
+const core::AccelerationStructure &AccelerationStructureBuilder::get_bottom_level(uint32_t index) const
+{
+	assert(index < built_count && "Bottom level acceleration structure is not built");
+	return *bottom_levels[index].acceleration_structure;
+}
+
+uint32_t AccelerationStructureBuilder::add_instance(uint32_t bottom_level, const glm::mat4 &transform, uint32_t custom_index, uint32_t mask, VkGeometryInstanceFlagsKHR flags)
+{
+	assert(bottom_level < bottom_levels.size() && "Instance of an unknown bottom level acceleration structure");
+
+	VkAccelerationStructureInstanceKHR instance{};
+	instance.transform                              = to_transform_matrix(transform);
+	instance.instanceCustomIndex                    = custom_index;
+	instance.mask                                   = mask;
+	instance.instanceShaderBindingTableRecordOffset = 0;
+	instance.flags                                  = flags;
+
+	instances.push_back(instance);
+	instance_bottom_levels.push_back(bottom_level);
+
+	top_level_dirty = true;
+
+	return to_u32(instances.size() - 1);
+}
+
+void AccelerationStructureBuilder::set_instance_transform(uint32_t instance, const glm::mat4 &transform)
+{
+	instances.at(instance).transform = to_transform_matrix(transform);
+}
+
+bool AccelerationStructureBuilder::record_top_level(VkCommandBuffer command_buffer)
+{
+	for (size_t i = 0; i < instances.size(); ++i)
+	{
+		instances[i].accelerationStructureReference = get_bottom_level(instance_bottom_levels[i]).get_device_address();
+	}
+
+	bool created = false;
+
+	if (!top_level || top_level_dirty)
+	{
+		VkAccelerationStructureCreateGeometryTypeInfoKHR geometry_info{VK_STRUCTURE_TYPE_ACCELERATION_STRUCTURE_CREATE_GEOMETRY_TYPE_INFO_KHR};
+		geometry_info.geometryType      = VK_GEOMETRY_TYPE_INSTANCES_KHR;
+		geometry_info.maxPrimitiveCount = to_u32(instances.size());
+		geometry_info.allowsTransforms  = VK_FALSE;
+
+		// Rebuilt ones are new acceleration structures, the previous one may still be read by commands in flight
+		top_level = std::make_unique<core::AccelerationStructure>(device, VK_ACCELERATION_STRUCTURE_TYPE_TOP_LEVEL_KHR,
+		                                                          VK_BUILD_ACCELERATION_STRUCTURE_PREFER_FAST_TRACE_BIT_KHR | VK_BUILD_ACCELERATION_STRUCTURE_ALLOW_UPDATE_BIT_KHR,
+		                                                          std::vector<VkAccelerationStructureCreateGeometryTypeInfoKHR>{geometry_info});
+
+		auto scratch_size = std::max(top_level->get_scratch_size(), top_level->get_scratch_size(true));
+
+		if (!top_level_scratch || top_level_scratch->get_size() < scratch_size)
+		{
+			top_level_scratch = std::make_unique<core::Buffer>(device, scratch_size,
+			                                                   VK_BUFFER_USAGE_RAY_TRACING_BIT_KHR | VK_BUFFER_USAGE_SHADER_DEVICE_ADDRESS_BIT,
+			                                                   VMA_MEMORY_USAGE_GPU_ONLY, 0);
+		}
+
+		auto instances_size = std::max<VkDeviceSize>(instances.size(), 1) * sizeof(VkAccelerationStructureInstanceKHR);
+
+		if (!instance_buffer || instance_buffer->get_size() < instances_size)
+		{
+			instance_buffer = std::make_unique<core::Buffer>(device, instances_size,
+			                                                 VK_BUFFER_USAGE_RAY_TRACING_BIT_KHR | VK_BUFFER_USAGE_SHADER_DEVICE_ADDRESS_BIT,
+			                                                 VMA_MEMORY_USAGE_CPU_TO_GPU);
+		}
+
+		created = true;
+	}
+	else
+	{
+		// Ray tracing shaders of previous commands read the acceleration structure being updated
+		VkMemoryBarrier barrier{VK_STRUCTURE_TYPE_MEMORY_BARRIER};
+		barrier.srcAccessMask = 0;
+		barrier.dstAccessMask = VK_ACCESS_ACCELERATION_STRUCTURE_WRITE_BIT_KHR;
+
+		vkCmdPipelineBarrier(command_buffer, VK_PIPELINE_STAGE_RAY_TRACING_SHADER_BIT_KHR, VK_PIPELINE_STAGE_ACCELERATION_STRUCTURE_BUILD_BIT_KHR,
+		                     0, 1, &barrier, 0, nullptr, 0, nullptr);
+	}
+
+	instance_buffer->update(instances.data(), instances.size() * sizeof(VkAccelerationStructureInstanceKHR));
+
+	VkAccelerationStructureGeometryKHR geometry{VK_STRUCTURE_TYPE_ACCELERATION_STRUCTURE_GEOMETRY_KHR};
+	geometry.flags                                 = VK_GEOMETRY_OPAQUE_BIT_KHR;
+	geometry.geometryType                          = VK_GEOMETRY_TYPE_INSTANCES_KHR;
+	geometry.geometry.instances.sType              = VK_STRUCTURE_TYPE_ACCELERATION_STRUCTURE_GEOMETRY_INSTANCES_DATA_KHR;
+	geometry.geometry.instances.arrayOfPointers    = VK_FALSE;
+	geometry.geometry.instances.data.deviceAddress = get_buffer_device_address(*instance_buffer);
+
+	const VkAccelerationStructureGeometryKHR *geometries = &geometry;
+
+	VkAccelerationStructureBuildGeometryInfoKHR build_info{VK_STRUCTURE_TYPE_ACCELERATION_STRUCTURE_BUILD_GEOMETRY_INFO_KHR};
+	build_info.type                      = VK_ACCELERATION_STRUCTURE_TYPE_TOP_LEVEL_KHR;
+	build_info.flags                     = top_level->get_flags();
+	build_info.update                    = created ? VK_FALSE : VK_TRUE;
+	build_info.srcAccelerationStructure  = created ? VK_NULL_HANDLE : top_level->get_handle();
+	build_info.dstAccelerationStructure  = top_level->get_handle();
+	build_info.geometryArrayOfPointers   = VK_FALSE;
+	build_info.geometryCount             = 1;
+	build_info.ppGeometries              = &geometries;
+	build_info.scratchData.deviceAddress = get_buffer_device_address(*top_level_scratch);
+
+	VkAccelerationStructureBuildOffsetInfoKHR build_offset{};
+	build_offset.primitiveCount = to_u32(instances.size());
+
+	const VkAccelerationStructureBuildOffsetInfoKHR *build_offsets = &build_offset;
+
+	vkCmdBuildAccelerationStructureKHR(command_buffer, 1, &build_info, &build_offsets);
+
+	acceleration_structure_barrier(command_buffer, VK_PIPELINE_STAGE_RAY_TRACING_SHADER_BIT_KHR, VK_ACCESS_ACCELERATION_STRUCTURE_READ_BIT_KHR);
+
+	top_level_dirty = false;
+
+	return created;
+}
+
+const core::AccelerationStructure *AccelerationStructureBuilder::get_top_level() const
+{
+	return top_level.get();
+}
+
+VkDeviceSize AccelerationStructureBuilder::get_memory_size() const
+{
+	VkDeviceSize memory_size = top_level ? top_level->get_memory_size() : 0;
+
+	for (auto &bottom_level : bottom_levels)
+	{
+		if (bottom_level.acceleration_structure)
+		{
+			memory_size += bottom_level.acceleration_structure->get_memory_size();
+		}
+	}
+
+	return memory_size;
+}
+
+uint64_t AccelerationStructureBuilder::get_buffer_device_address(const core::Buffer &buffer) const
+{
+	VkBufferDeviceAddressInfoKHR address_info{VK_STRUCTURE_TYPE_BUFFER_DEVICE_ADDRESS_INFO};
+	address_info.buffer = buffer.get_handle();
+
+	return vkGetBufferDeviceAddressKHR(device.get_handle(), &address_info);
+}
+}        // namespace vkb
@@ -0,0 +1,192 @@
+/* Copyright (c) 2020, Arm Limited and Contributors
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 the "License";
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <memory>
+#include <vector>
+
+#include "common/helpers.h"
+#include "common/vk_common.h"
+#include "core/acceleration_structure.h"
+#include "core/buffer.h"
+
+VKBP_DISABLE_WARNINGS()
+#include "common/glm_common.h"
+VKBP_ENABLE_WARNINGS()
+
+namespace vkb
+{
+class Device;
+
+namespace sg
+{
+class Scene;
+class SubMesh;
+}        // namespace sg
+
+/**
+ * @brief Builds the ray tracing acceleration structures of a scene: a bottom level one per sub mesh,
+ *        and a top level one over instances of them
+ *
+ * Bottom level acceleration structures are built in batches which share one scratch buffer, reused by
+ * the next batch once the previous one completed on the GPU. If their flags allow compaction, their
+ * compacted sizes are queried after the build, and they are copied to acceleration structures of that size.
+ *
+ * The top level acceleration structure is rebuilt when instances are added, and otherwise updated in place
+ * from the new transforms of the instances, which is much cheaper for moving instances.
+ */
+class AccelerationStructureBuilder
+{
+  public:
+	/// Scratch memory of the bottom level builds of a batch, a bigger build gets a batch of its own
+	static constexpr VkDeviceSize DEFAULT_SCRATCH_BUDGET = 32 * 1024 * 1024;
+
+	/**
+	 * @param bottom_level_flags Build flags of the bottom level acceleration structures
+	 * @param scratch_budget Maximum size of the scratch memory of a batch of bottom level builds
+	 */
+	AccelerationStructureBuilder(Device &                             device,
+	                             VkBuildAccelerationStructureFlagsKHR bottom_level_flags = VK_BUILD_ACCELERATION_STRUCTURE_PREFER_FAST_TRACE_BIT_KHR |
+	                                                                                       VK_BUILD_ACCELERATION_STRUCTURE_ALLOW_COMPACTION_BIT_KHR,
+	                             VkDeviceSize scratch_budget = DEFAULT_SCRATCH_BUDGET);
+
+	AccelerationStructureBuilder(const AccelerationStructureBuilder &) = delete;
+
+	AccelerationStructureBuilder(AccelerationStructureBuilder &&) = default;
+
+	AccelerationStructureBuilder &operator=(const AccelerationStructureBuilder &) = delete;
+
+	AccelerationStructureBuilder &operator=(AccelerationStructureBuilder &&) = delete;
+
+	/**
+	 * @brief Adds a bottom level acceleration structure for the triangles of a sub mesh, built by the next build_bottom_level
+	 *        The position and index buffers need the shader device address usage, see GLTFLoader::set_geometry_buffer_usage.
+	 *        The sub mesh must outlive the build.
+	 * @return Index of the bottom level acceleration structure
+	 */
+	uint32_t add_sub_mesh(const sg::SubMesh &sub_mesh);
+
+	/**
+	 * @brief Adds a bottom level acceleration structure for every sub mesh of a scene, and an instance of it
+	 *        for every node of its mesh, with the world matrix of the node
+	 *        Sub meshes an acceleration structure can not be built from are skipped with a warning.
+	 * @return Number of instances added
+	 */
+	uint32_t add_scene(const sg::Scene &scene);
+
+	/**
+	 * @brief Builds the bottom level acceleration structures added since the last call, and compacts them
+	 *        Waits for the GPU to complete the builds.
+	 * @param queue A queue supporting compute operations
+	 */
+	void build_bottom_level(VkQueue queue);
+
+	const core::AccelerationStructure &get_bottom_level(uint32_t index) const;
+
+	/**
+	 * @brief Adds an instance of a bottom level acceleration structure to the top level one
+	 * @param bottom_level Index of the bottom level acceleration structure
+	 * @param transform Transform of the instance, an affine transform
+	 * @param custom_index Index shaders read as gl_InstanceCustomIndexEXT
+	 * @param mask Visibility mask of the instance, tested against the cull mask of rays
+	 * @param flags Flags of the instance
+	 * @return Index of the instance
+	 */
+	uint32_t add_instance(uint32_t                   bottom_level,
+	                      const glm::mat4 &          transform,
+	                      uint32_t                   custom_index = 0,
+	                      uint32_t                   mask         = 0xFF,
+	                      VkGeometryInstanceFlagsKHR flags        = VK_GEOMETRY_INSTANCE_TRIANGLE_FACING_CULL_DISABLE_BIT_KHR);
+
+	/**
+	 * @brief Moves an instance, taken into account by the next update of the top level acceleration structure
+	 */
+	void set_instance_transform(uint32_t instance, const glm::mat4 &transform);
+
+	/**
+	 * @brief Records the build of the top level acceleration structure, or its update if only instance transforms changed
+	 *        The instances are written by the host, so the previous build must have completed on the GPU.
+	 *        Reads of the acceleration structure by ray tracing shaders are synchronized with the build.
+	 * @return True if a new top level acceleration structure was created, in which case descriptors referring to it must be updated
+	 */
+	bool record_top_level(VkCommandBuffer command_buffer);
+
+	/**
+	 * @return The top level acceleration structure, null before the first record_top_level
+	 */
+	const core::AccelerationStructure *get_top_level() const;
+
+	/**
+	 * @return The memory of all the acceleration structures, excluding scratch memory
+	 */
+	VkDeviceSize get_memory_size() const;
+
+  private:
+	/**
+	 * @brief A bottom level acceleration structure with the triangles it is built from
+	 */
+	struct BottomLevel
+	{
+		VkAccelerationStructureCreateGeometryTypeInfoKHR geometry_info{VK_STRUCTURE_TYPE_ACCELERATION_STRUCTURE_CREATE_GEOMETRY_TYPE_INFO_KHR};
+
+		VkAccelerationStructureGeometryKHR geometry{VK_STRUCTURE_TYPE_ACCELERATION_STRUCTURE_GEOMETRY_KHR};
+
+		VkAccelerationStructureBuildOffsetInfoKHR build_offset{};
+
+		std::unique_ptr<core::AccelerationStructure> acceleration_structure;
+	};
+
+	/**
+	 * @brief Copies built bottom level acceleration structures to compacted ones
+	 * @param first Index of the first bottom level acceleration structure built
+	 */
+	void compact_bottom_level(VkQueue queue, size_t first);
+
+	uint64_t get_buffer_device_address(const core::Buffer &buffer) const;
+
+	Device &device;
+
+	VkBuildAccelerationStructureFlagsKHR bottom_level_flags;
+
+	VkDeviceSize scratch_budget;
+
+	std::vector<BottomLevel> bottom_levels;
+
+	/// Number of bottom level acceleration structures built, the next ones are pending
+	size_t built_count{0};
+
+	/// Scratch memory shared by the batches of bottom level builds
+	std::unique_ptr<core::Buffer> scratch_buffer;
+
+	std::vector<VkAccelerationStructureInstanceKHR> instances;
+
+	/// Bottom level acceleration structure of each instance, resolved to an address when the top level is recorded
+	std::vector<uint32_t> instance_bottom_levels;
+
+	/// Whether the top level acceleration structure must be rebuilt instead of updated
+	bool top_level_dirty{true};
+
+	std::unique_ptr<core::AccelerationStructure> top_level;
+
+	/// Scratch memory of the top level builds and updates
+	std::unique_ptr<core::Buffer> top_level_scratch;
+
+	/// Host visible instances of the top level acceleration structure
+	std::unique_ptr<core::Buffer> instance_buffer;
+};
+}        // namespace vkb
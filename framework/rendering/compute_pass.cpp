@@ -0,0 +1,326 @@
+/* Copyright (c) 2020, Arm Limited and Contributors
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 the "License";
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "rendering/compute_pass.h"
+
+#include <algorithm>
+
+#include "core/buffer.h"
+#include "core/command_buffer.h"
+#include "core/image_view.h"
+
+namespace vkb
+{
+namespace
+{
+constexpr VkAccessFlags WRITE_ACCESS_MASK = VK_ACCESS_SHADER_WRITE_BIT;
+
+bool ranges_overlap(VkDeviceSize offset_a, VkDeviceSize size_a, VkDeviceSize offset_b, VkDeviceSize size_b)
+{
+	return offset_a < offset_b + size_b && offset_b < offset_a + size_a;
+}
+
+bool buffer_accesses_overlap(const ComputePass::BufferAccess &a, const ComputePass::BufferAccess &b)
+{
+	return a.buffer == b.buffer && ranges_overlap(a.offset, a.size, b.offset, b.size);
+}
+
+bool image_accesses_overlap(const ComputePass::ImageAccess &a, const ComputePass::ImageAccess &b)
+{
+	if (&a.image_view->get_image() != &b.image_view->get_image())
+	{
+		return false;
+	}
+
+	auto range_a = a.image_view->get_subresource_range();
+	auto range_b = b.image_view->get_subresource_range();
+
+	return ranges_overlap(range_a.baseMipLevel, range_a.levelCount, range_b.baseMipLevel, range_b.levelCount) &&
+	       ranges_overlap(range_a.baseArrayLayer, range_a.layerCount, range_b.baseArrayLayer, range_b.layerCount);
+}
+}        // namespace
+
+bool ComputePass::BufferAccess::is_write() const
+{
+	return (access_mask & WRITE_ACCESS_MASK) != 0;
+}
+
+bool ComputePass::ImageAccess::is_write() const
+{
+	return (access_mask & WRITE_ACCESS_MASK) != 0;
+}
+
+ComputePass::Dispatch::Dispatch(const std::string &name, RecordFunc &&record) :
+    name{name},
+    record_func{std::move(record)}
+{
+}
+
+ComputePass::Dispatch &ComputePass::Dispatch::reads(const core::Buffer &buffer, VkDeviceSize offset, VkDeviceSize size)
+{
+	return add_buffer_access(buffer, offset, size, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_ACCESS_SHADER_READ_BIT);
+}
+
+ComputePass::Dispatch &ComputePass::Dispatch::writes(const core::Buffer &buffer, VkDeviceSize offset, VkDeviceSize size)
+{
+	return add_buffer_access(buffer, offset, size, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT);
+}
+
+ComputePass::Dispatch &ComputePass::Dispatch::reads_indirect(const core::Buffer &buffer, VkDeviceSize offset)
+{
+	return add_buffer_access(buffer, offset, sizeof(VkDispatchIndirectCommand), VK_PIPELINE_STAGE_DRAW_INDIRECT_BIT, VK_ACCESS_INDIRECT_COMMAND_READ_BIT);
+}
+
+ComputePass::Dispatch &ComputePass::Dispatch::reads(const core::ImageView &image_view)
+{
+	image_accesses.push_back({&image_view, VK_ACCESS_SHADER_READ_BIT});
+
+	return *this;
+}
+
+ComputePass::Dispatch &ComputePass::Dispatch::writes(const core::ImageView &image_view)
+{
+	image_accesses.push_back({&image_view, VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT});
+
+	return *this;
+}
+
+ComputePass::Dispatch &ComputePass::Dispatch::add_buffer_access(const core::Buffer &buffer, VkDeviceSize offset, VkDeviceSize size, VkPipelineStageFlags stage_mask, VkAccessFlags access_mask)
+{
+	if (size == VK_WHOLE_SIZE)
+	{
+		size = buffer.get_size() - offset;
+	}
+
+	buffer_accesses.push_back({&buffer, offset, size, stage_mask, access_mask});
+
+	return *this;
+}
+
+const std::string &ComputePass::Dispatch::get_name() const
+{
+	return name;
+}
+
+const std::vector<ComputePass::BufferAccess> &ComputePass::Dispatch::get_buffer_accesses() const
+{
+	return buffer_accesses;
+}
+
+const std::vector<ComputePass::ImageAccess> &ComputePass::Dispatch::get_image_accesses() const
+{
+	return image_accesses;
+}
+
+bool ComputePass::Dispatch::depends_on(const Dispatch &other) const
+{
+	for (auto &access : buffer_accesses)
+	{
+		for (auto &other_access : other.buffer_accesses)
+		{
+			if ((access.is_write() || other_access.is_write()) && buffer_accesses_overlap(access, other_access))
+			{
+				return true;
+			}
+		}
+	}
+
+	for (auto &access : image_accesses)
+	{
+		for (auto &other_access : other.image_accesses)
+		{
+			if ((access.is_write() || other_access.is_write()) && image_accesses_overlap(access, other_access))
+			{
+				return true;
+			}
+		}
+	}
+
+	return false;
+}
+
+void ComputePass::Dispatch::record(CommandBuffer &command_buffer) const
+{
+	DEBUG_LABEL_SCOPE(command_buffer, name);
+
+	record_func(command_buffer);
+}
+
+ComputePass::Dispatch &ComputePass::add_dispatch(const std::string &name, RecordFunc &&record)
+{
+	dispatches.push_back(std::make_unique<Dispatch>(name, std::move(record)));
+
+	return *dispatches.back();
+}
+
+void ComputePass::clear()
+{
+	dispatches.clear();
+}
+
+size_t ComputePass::get_level_count() const
+{
+	return level_count;
+}
+
+size_t ComputePass::get_buffer_barrier_count() const
+{
+	return buffer_barrier_count;
+}
+
+std::vector<size_t> ComputePass::compute_levels() const
+{
+	std::vector<size_t> levels(dispatches.size(), 0);
+
+	for (size_t i = 0; i < dispatches.size(); ++i)
+	{
+		for (size_t j = 0; j < i; ++j)
+		{
+			if (levels[j] >= levels[i] && dispatches[i]->depends_on(*dispatches[j]))
+			{
+				levels[i] = levels[j] + 1;
+			}
+		}
+	}
+
+	return levels;
+}
+
+void ComputePass::record(CommandBuffer &command_buffer)
+{
+	auto levels = compute_levels();
+
+	level_count          = levels.empty() ? 0 : *std::max_element(levels.begin(), levels.end()) + 1;
+	buffer_barrier_count = 0;
+
+	// Barriers make writes visible to every access of the pass, so that the writes they cover need no other barrier
+	BufferAccess pass_access{nullptr, 0, 0, 0, 0};
+	for (auto &dispatch : dispatches)
+	{
+		for (auto &access : dispatch->get_buffer_accesses())
+		{
+			pass_access.stage_mask |= access.stage_mask;
+			pass_access.access_mask |= access.access_mask;
+		}
+	}
+
+	// Buffer accesses recorded which no barrier has synchronized with yet
+	std::vector<BufferAccess> previous_accesses;
+
+	for (size_t level = 0; level < level_count; ++level)
+	{
+		std::vector<const Dispatch *> level_dispatches;
+		std::vector<BufferAccess>     level_accesses;
+
+		for (size_t i = 0; i < dispatches.size(); ++i)
+		{
+			if (levels[i] == level)
+			{
+				level_dispatches.push_back(dispatches[i].get());
+				level_accesses.insert(level_accesses.end(), dispatches[i]->get_buffer_accesses().begin(), dispatches[i]->get_buffer_accesses().end());
+			}
+		}
+
+		queue_buffer_barriers(command_buffer, level_accesses, pass_access, previous_accesses);
+
+		// Required until the first dispatch of the level, so that the image barriers join the buffer barriers
+		for (auto dispatch : level_dispatches)
+		{
+			for (auto &access : dispatch->get_image_accesses())
+			{
+				command_buffer.require_layout(*access.image_view, VK_IMAGE_LAYOUT_GENERAL, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, access.access_mask);
+			}
+		}
+
+		for (auto dispatch : level_dispatches)
+		{
+			dispatch->record(command_buffer);
+		}
+
+		previous_accesses.insert(previous_accesses.end(), level_accesses.begin(), level_accesses.end());
+	}
+}
+
+void ComputePass::queue_buffer_barriers(CommandBuffer &command_buffer, const std::vector<BufferAccess> &level_accesses, const BufferAccess &pass_access, std::vector<BufferAccess> &previous_accesses)
+{
+	// A single barrier per buffer, as the command buffer records its pending barriers when another one is queued for the same buffer
+	struct Barrier
+	{
+		const core::Buffer *buffer;
+
+		VkDeviceSize begin;
+
+		VkDeviceSize end;
+
+		BufferMemoryBarrier memory_barrier;
+	};
+
+	std::vector<Barrier> barriers;
+
+	for (auto &access : level_accesses)
+	{
+		for (auto &previous_access : previous_accesses)
+		{
+			if (!(access.is_write() || previous_access.is_write()) || !buffer_accesses_overlap(access, previous_access))
+			{
+				continue;
+			}
+
+			auto barrier = std::find_if(barriers.begin(), barriers.end(), [&access](const Barrier &barrier) { return barrier.buffer == access.buffer; });
+			if (barrier == barriers.end())
+			{
+				barriers.push_back({access.buffer, access.offset, access.offset + access.size, {0, 0, 0, 0}});
+				barrier = barriers.end() - 1;
+			}
+
+			barrier->begin = std::min({barrier->begin, access.offset, previous_access.offset});
+			barrier->end   = std::max({barrier->end, access.offset + access.size, previous_access.offset + previous_access.size});
+
+			barrier->memory_barrier.src_stage_mask |= previous_access.stage_mask;
+			barrier->memory_barrier.dst_stage_mask = pass_access.stage_mask;
+
+			// Write after read only needs an execution dependency
+			if (previous_access.is_write())
+			{
+				barrier->memory_barrier.src_access_mask |= previous_access.access_mask & WRITE_ACCESS_MASK;
+				barrier->memory_barrier.dst_access_mask = pass_access.access_mask;
+			}
+		}
+	}
+
+	if (barriers.empty())
+	{
+		return;
+	}
+
+	for (auto &barrier : barriers)
+	{
+		command_buffer.buffer_memory_barrier(*barrier.buffer, barrier.begin, barrier.end - barrier.begin, barrier.memory_barrier);
+	}
+
+	buffer_barrier_count += barriers.size();
+
+	// The pipeline barrier waits for all the accesses recorded, which leaves the writes outside of the barriers to make visible
+	previous_accesses.erase(std::remove_if(previous_accesses.begin(), previous_accesses.end(), [&barriers](const BufferAccess &access) {
+		                        return !access.is_write() ||
+		                               std::any_of(barriers.begin(), barriers.end(), [&access](const Barrier &barrier) {
+			                               return barrier.buffer == access.buffer && barrier.begin <= access.offset && access.offset + access.size <= barrier.end;
+		                               });
+	                        }),
+	                        previous_accesses.end());
+}
+}        // namespace vkb
@@ -0,0 +1,208 @@
+/* Copyright (c) 2020, Arm Limited and Contributors
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 the "License";
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <functional>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "common/helpers.h"
+#include "common/vk_common.h"
+
+namespace vkb
+{
+class CommandBuffer;
+
+namespace core
+{
+class Buffer;
+class ImageView;
+}        // namespace core
+
+/**
+ * @brief Records a batch of compute dispatches with only the barriers their declared accesses require
+ *
+ * Each dispatch declares the ranges of buffers and the storage images it reads and writes. Recording
+ * orders the dispatches in levels, a dispatch going in the level after the last dispatch it depends on,
+ * so that independent dispatches are recorded together without barriers and may run concurrently.
+ * Before a level, a buffer barrier is queued for each buffer with a read after write, write after write
+ * or write after read hazard, and the barriers are recorded in a single pipeline barrier. Images are
+ * required in the general layout, so their barriers follow from the state tracked by the images.
+ *
+ * Like the compute primitives, the pass is bracketed by compute shader barriers: accesses of previous
+ * commands must be visible to compute shaders before record, and following commands synchronize with
+ * the compute shader writes of the pass.
+ */
+class ComputePass
+{
+  public:
+	/**
+	 * @brief Binds the pipeline and resources of a dispatch and dispatches it
+	 */
+	using RecordFunc = std::function<void(CommandBuffer &command_buffer)>;
+
+	/**
+	 * @brief Access of a dispatch to a range of a buffer
+	 */
+	struct BufferAccess
+	{
+		const core::Buffer *buffer;
+
+		VkDeviceSize offset;
+
+		VkDeviceSize size;
+
+		VkPipelineStageFlags stage_mask;
+
+		VkAccessFlags access_mask;
+
+		bool is_write() const;
+	};
+
+	/**
+	 * @brief Access of a dispatch to the subresources of a storage image view
+	 */
+	struct ImageAccess
+	{
+		const core::ImageView *image_view;
+
+		VkAccessFlags access_mask;
+
+		bool is_write() const;
+	};
+
+	/**
+	 * @brief A dispatch of the pass and the resources it accesses
+	 */
+	class Dispatch
+	{
+	  public:
+		Dispatch(const std::string &name, RecordFunc &&record);
+
+		/**
+		 * @brief Declares a range of a buffer read by the compute shader
+		 */
+		Dispatch &reads(const core::Buffer &buffer, VkDeviceSize offset = 0, VkDeviceSize size = VK_WHOLE_SIZE);
+
+		/**
+		 * @brief Declares a range of a buffer written by the compute shader, and possibly read before
+		 */
+		Dispatch &writes(const core::Buffer &buffer, VkDeviceSize offset = 0, VkDeviceSize size = VK_WHOLE_SIZE);
+
+		/**
+		 * @brief Declares the arguments of a dispatch_indirect, as written by a previous dispatch
+		 */
+		Dispatch &reads_indirect(const core::Buffer &buffer, VkDeviceSize offset = 0);
+
+		/**
+		 * @brief Declares a storage image read by the compute shader
+		 */
+		Dispatch &reads(const core::ImageView &image_view);
+
+		/**
+		 * @brief Declares a storage image written by the compute shader, and possibly read before
+		 */
+		Dispatch &writes(const core::ImageView &image_view);
+
+		const std::string &get_name() const;
+
+		const std::vector<BufferAccess> &get_buffer_accesses() const;
+
+		const std::vector<ImageAccess> &get_image_accesses() const;
+
+		/**
+		 * @return Whether the dispatch has to be recorded after another one, as one of them writes a resource both access
+		 */
+		bool depends_on(const Dispatch &other) const;
+
+		void record(CommandBuffer &command_buffer) const;
+
+	  private:
+		Dispatch &add_buffer_access(const core::Buffer &buffer, VkDeviceSize offset, VkDeviceSize size, VkPipelineStageFlags stage_mask, VkAccessFlags access_mask);
+
+		std::string name;
+
+		RecordFunc record_func;
+
+		std::vector<BufferAccess> buffer_accesses;
+
+		std::vector<ImageAccess> image_accesses;
+	};
+
+	ComputePass() = default;
+
+	ComputePass(const ComputePass &) = delete;
+
+	ComputePass(ComputePass &&) = default;
+
+	ComputePass &operator=(const ComputePass &) = delete;
+
+	ComputePass &operator=(ComputePass &&) = default;
+
+	/**
+	 * @brief Adds a dispatch to the pass, dispatches are recorded in this order unless they are independent
+	 * @param name Name of the dispatch, labeling its commands
+	 * @param record Records the dispatch once its barriers are queued
+	 * @return The dispatch, to declare its accesses
+	 */
+	Dispatch &add_dispatch(const std::string &name, RecordFunc &&record);
+
+	/**
+	 * @brief Records the dispatches of the pass and the barriers between their levels
+	 *        Must be called outside of a render pass, the dispatches are kept to record them again.
+	 */
+	void record(CommandBuffer &command_buffer);
+
+	/**
+	 * @brief Removes the dispatches of the pass
+	 */
+	void clear();
+
+	/**
+	 * @return The number of levels of the last record, the dispatches of a level are independent
+	 */
+	size_t get_level_count() const;
+
+	/**
+	 * @return The number of buffer barriers queued by the last record
+	 */
+	size_t get_buffer_barrier_count() const;
+
+  private:
+	/**
+	 * @return The level of each dispatch, one after the highest level of the dispatches it depends on
+	 */
+	std::vector<size_t> compute_levels() const;
+
+	/**
+	 * @brief Queues the buffer barriers of the hazards between the accesses of a level and those since the last barriers
+	 * @param level_accesses Buffer accesses of the dispatches of the level
+	 * @param pass_access Union of the stages and access types of the pass, which the barriers make writes visible to
+	 * @param previous_accesses Buffer accesses not synchronized yet, updated with the barriers queued
+	 */
+	void queue_buffer_barriers(CommandBuffer &command_buffer, const std::vector<BufferAccess> &level_accesses, const BufferAccess &pass_access, std::vector<BufferAccess> &previous_accesses);
+
+	/// Dispatches in the order they were added, owned by pointer so that the references returned stay valid
+	std::vector<std::unique_ptr<Dispatch>> dispatches;
+
+	size_t level_count{0};
+
+	size_t buffer_barrier_count{0};
+};
+}        // namespace vkb
@@ -0,0 +1,378 @@
+/* Copyright (c) 2020, Arm Limited and Contributors
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 the "License";
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "rendering/compute_primitives.h"
+
+#include <algorithm>
+#include <cassert>
+
+#include "core/command_buffer.h"
+#include "core/device.h"
+#include "glsl_compiler.h"
+
+namespace vkb
+{
+namespace
+{
+/// Invocations of a workgroup
+constexpr uint32_t GROUP_SIZE = 256;
+
+/// Consecutive elements of a workgroup processed by each invocation
+constexpr uint32_t ITEMS_PER_INVOCATION = 4;
+
+constexpr uint32_t BLOCK_SIZE = GROUP_SIZE * ITEMS_PER_INVOCATION;
+
+/// Smallest subgroup for which a single subgroup can scan the totals of all the subgroups of a workgroup
+constexpr uint32_t MIN_SUBGROUP_SIZE = 16;
+
+constexpr uint32_t RADIX_BITS = 4;
+
+constexpr uint32_t RADIX_SIZE = 1 << RADIX_BITS;
+}        // namespace
+
+ComputePrimitive::ComputePrimitive(Device &device) :
+    device{device},
+    subgroups{is_subgroup_supported(device)}
+{
+}
+
+bool ComputePrimitive::is_subgroup_supported(Device &device)
+{
+	if (GLSLCompiler::get_target_language() != glslang::EShTargetSpv ||
+	    GLSLCompiler::get_target_language_version() < glslang::EShTargetSpv_1_3)
+	{
+		return false;
+	}
+
+	auto &subgroup_properties = device.get_gpu().get_subgroup_properties();
+
+	VkSubgroupFeatureFlags required_operations = VK_SUBGROUP_FEATURE_BASIC_BIT | VK_SUBGROUP_FEATURE_ARITHMETIC_BIT;
+
+	return subgroup_properties.subgroupSize >= MIN_SUBGROUP_SIZE &&
+	       (subgroup_properties.supportedStages & VK_SHADER_STAGE_COMPUTE_BIT) &&
+	       (subgroup_properties.supportedOperations & required_operations) == required_operations;
+}
+
+uint32_t ComputePrimitive::get_block_size()
+{
+	return BLOCK_SIZE;
+}
+
+bool ComputePrimitive::uses_subgroups() const
+{
+	return subgroups;
+}
+
+ComputePrimitive::Kernel ComputePrimitive::create_kernel(const std::string &filename, const std::vector<std::string> &definitions)
+{
+	Kernel kernel{ShaderSource{"compute_primitives/" + filename}, {}};
+
+	kernel.variant.add_definitions({"GROUP_SIZE " + std::to_string(GROUP_SIZE),
+	                                "ITEMS_PER_INVOCATION " + std::to_string(ITEMS_PER_INVOCATION),
+	                                "MIN_SUBGROUP_SIZE " + std::to_string(MIN_SUBGROUP_SIZE)});
+	kernel.variant.add_definitions(definitions);
+
+	if (subgroups)
+	{
+		kernel.variant.add_subgroup_definitions(device.get_gpu().get_subgroup_properties(), VK_SHADER_STAGE_COMPUTE_BIT);
+	}
+
+	// Compile ahead of the first record
+	device.get_resource_cache().request_shader_module(VK_SHADER_STAGE_COMPUTE_BIT, kernel.source, kernel.variant);
+
+	return kernel;
+}
+
+std::unique_ptr<core::Buffer> ComputePrimitive::create_storage_buffer(uint32_t count)
+{
+	return std::make_unique<core::Buffer>(device, std::max(count, 1U) * sizeof(uint32_t),
+	                                      VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_SRC_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+	                                      VMA_MEMORY_USAGE_GPU_ONLY, 0);
+}
+
+void ComputePrimitive::bind_kernel(CommandBuffer &command_buffer, Kernel &kernel)
+{
+	auto &resource_cache  = device.get_resource_cache();
+	auto &shader_module   = resource_cache.request_shader_module(VK_SHADER_STAGE_COMPUTE_BIT, kernel.source, kernel.variant);
+	auto &pipeline_layout = resource_cache.request_pipeline_layout({&shader_module});
+
+	command_buffer.bind_pipeline_layout(pipeline_layout);
+}
+
+void ComputePrimitive::dispatch(CommandBuffer &command_buffer, uint32_t count, uint32_t parameter)
+{
+	command_buffer.push_constants(KernelParameters{count, parameter});
+
+	command_buffer.dispatch(get_block_count(count), 1, 1);
+}
+
+void ComputePrimitive::compute_barrier(CommandBuffer &command_buffer, const core::Buffer &buffer)
+{
+	BufferMemoryBarrier barrier;
+	barrier.src_stage_mask  = VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT;
+	barrier.dst_stage_mask  = VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT;
+	barrier.src_access_mask = VK_ACCESS_SHADER_WRITE_BIT;
+	barrier.dst_access_mask = VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT;
+
+	command_buffer.buffer_memory_barrier(buffer, 0, VK_WHOLE_SIZE, barrier);
+}
+
+uint32_t ComputePrimitive::get_block_count(uint32_t count)
+{
+	return std::max((count + BLOCK_SIZE - 1) / BLOCK_SIZE, 1U);
+}
+
+GpuScan::GpuScan(Device &device, uint32_t max_count) :
+    ComputePrimitive{device},
+    max_count{max_count}
+{
+	scan_kernel = create_kernel("scan.comp");
+	add_kernel  = create_kernel("scan_add.comp");
+
+	// One level per scan of block totals, down to a single block
+	uint32_t level_count = max_count;
+
+	do
+	{
+		level_count = get_block_count(level_count);
+		block_totals.push_back(create_storage_buffer(level_count));
+	} while (level_count > 1);
+}
+
+void GpuScan::record(CommandBuffer &command_buffer, const core::Buffer &source, const core::Buffer &result, uint32_t count)
+{
+	assert(count <= max_count && "Scan exceeds the maximum number of elements");
+
+	if (count == 0)
+	{
+		return;
+	}
+
+	record_level(command_buffer, source, result, count, 0);
+}
+
+void GpuScan::record_level(CommandBuffer &command_buffer, const core::Buffer &source, const core::Buffer &result, uint32_t count, size_t level)
+{
+	auto &totals      = *block_totals[level];
+	auto  block_count = get_block_count(count);
+
+	bind_kernel(command_buffer, scan_kernel);
+	command_buffer.bind_buffer(source, 0, source.get_size(), 0, 0, 0);
+	command_buffer.bind_buffer(result, 0, result.get_size(), 0, 1, 0);
+	command_buffer.bind_buffer(totals, 0, totals.get_size(), 0, 2, 0);
+	dispatch(command_buffer, count);
+
+	compute_barrier(command_buffer, result);
+
+	if (block_count == 1)
+	{
+		return;
+	}
+
+	// Scan the block totals in place into the offsets of the blocks, and add them to the blocks
+	compute_barrier(command_buffer, totals);
+
+	record_level(command_buffer, totals, totals, block_count, level + 1);
+
+	bind_kernel(command_buffer, add_kernel);
+	command_buffer.bind_buffer(result, 0, result.get_size(), 0, 0, 0);
+	command_buffer.bind_buffer(totals, 0, totals.get_size(), 0, 1, 0);
+	dispatch(command_buffer, count);
+
+	compute_barrier(command_buffer, result);
+}
+
+GpuReduction::GpuReduction(Device &device, uint32_t max_count, ReductionOperation operation) :
+    ComputePrimitive{device},
+    max_count{max_count}
+{
+	switch (operation)
+	{
+		case ReductionOperation::Min:
+			reduce_kernel = create_kernel("reduce.comp", {"REDUCE_MIN"});
+			break;
+		case ReductionOperation::Max:
+			reduce_kernel = create_kernel("reduce.comp", {"REDUCE_MAX"});
+			break;
+		default:
+			reduce_kernel = create_kernel("reduce.comp", {"REDUCE_ADD"});
+			break;
+	}
+
+	uint32_t level_count = get_block_count(max_count);
+
+	while (level_count > 1)
+	{
+		partials.push_back(create_storage_buffer(level_count));
+		level_count = get_block_count(level_count);
+	}
+}
+
+void GpuReduction::record(CommandBuffer &command_buffer, const core::Buffer &source, const core::Buffer &result, uint32_t count)
+{
+	assert(count <= max_count && "Reduction exceeds the maximum number of elements");
+
+	const core::Buffer *input = &source;
+
+	for (size_t level = 0;; ++level)
+	{
+		auto block_count = get_block_count(count);
+
+		// The last level reduces a single block into the result
+		auto &output = block_count == 1 ? result : *partials[level];
+
+		bind_kernel(command_buffer, reduce_kernel);
+		command_buffer.bind_buffer(*input, 0, input->get_size(), 0, 0, 0);
+		command_buffer.bind_buffer(output, 0, output.get_size(), 0, 1, 0);
+		dispatch(command_buffer, count);
+
+		compute_barrier(command_buffer, output);
+
+		if (block_count == 1)
+		{
+			break;
+		}
+
+		input = &output;
+		count = block_count;
+	}
+}
+
+GpuCompaction::GpuCompaction(Device &device, uint32_t max_count) :
+    ComputePrimitive{device},
+    max_count{max_count},
+    scan{device, max_count},
+    offsets{create_storage_buffer(max_count)}
+{
+	compact_kernel = create_kernel("compact.comp");
+}
+
+void GpuCompaction::record(CommandBuffer &command_buffer, const core::Buffer &values, const core::Buffer &flags,
+                           const core::Buffer &result, const core::Buffer &result_count, uint32_t count)
+{
+	assert(count <= max_count && "Compaction exceeds the maximum number of elements");
+
+	if (count == 0)
+	{
+		// Nothing is kept, so only the count is written
+		command_buffer.update_buffer(result_count, 0, std::vector<uint8_t>(sizeof(uint32_t), 0));
+
+		BufferMemoryBarrier barrier;
+		barrier.src_stage_mask  = VK_PIPELINE_STAGE_TRANSFER_BIT;
+		barrier.dst_stage_mask  = VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT;
+		barrier.src_access_mask = VK_ACCESS_TRANSFER_WRITE_BIT;
+		barrier.dst_access_mask = VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT;
+
+		command_buffer.buffer_memory_barrier(result_count, 0, VK_WHOLE_SIZE, barrier);
+		return;
+	}
+
+	scan.record(command_buffer, flags, *offsets, count);
+
+	bind_kernel(command_buffer, compact_kernel);
+	command_buffer.bind_buffer(values, 0, values.get_size(), 0, 0, 0);
+	command_buffer.bind_buffer(flags, 0, flags.get_size(), 0, 1, 0);
+	command_buffer.bind_buffer(*offsets, 0, offsets->get_size(), 0, 2, 0);
+	command_buffer.bind_buffer(result, 0, result.get_size(), 0, 3, 0);
+	command_buffer.bind_buffer(result_count, 0, result_count.get_size(), 0, 4, 0);
+	dispatch(command_buffer, count);
+
+	compute_barrier(command_buffer, result);
+	compute_barrier(command_buffer, result_count);
+}
+
+GpuRadixSort::GpuRadixSort(Device &device, uint32_t max_count, bool sort_values) :
+    ComputePrimitive{device},
+    max_count{max_count},
+    sort_values{sort_values},
+    scan{device, RADIX_SIZE * get_block_count(max_count)},
+    histogram{create_storage_buffer(RADIX_SIZE * get_block_count(max_count))},
+    scratch_keys{create_storage_buffer(max_count)}
+{
+	std::vector<std::string> definitions{"RADIX_BITS " + std::to_string(RADIX_BITS),
+	                                     "RADIX_SIZE " + std::to_string(RADIX_SIZE)};
+
+	histogram_kernel = create_kernel("radix_histogram.comp", definitions);
+
+	if (sort_values)
+	{
+		definitions.push_back("SORT_VALUES");
+		scratch_values = create_storage_buffer(max_count);
+	}
+
+	scatter_kernel = create_kernel("radix_scatter.comp", definitions);
+}
+
+void GpuRadixSort::record(CommandBuffer &command_buffer, const core::Buffer &keys, const core::Buffer *values, uint32_t count, uint32_t key_bits)
+{
+	assert(count <= max_count && "Sort exceeds the maximum number of elements");
+	assert((values != nullptr) == sort_values && "Values must be given if and only if the sort was created for them");
+
+	if (count <= 1)
+	{
+		return;
+	}
+
+	// An even number of passes ends in the buffers of the caller, extra passes over zero digits keep the order
+	uint32_t pass_count = (std::min(key_bits, 32U) + RADIX_BITS - 1) / RADIX_BITS;
+	pass_count          = std::max(pass_count + (pass_count & 1), 2U);
+
+	uint32_t histogram_count = RADIX_SIZE * get_block_count(count);
+
+	const core::Buffer *source_keys        = &keys;
+	const core::Buffer *destination_keys   = scratch_keys.get();
+	const core::Buffer *source_values      = values;
+	const core::Buffer *destination_values = scratch_values.get();
+
+	for (uint32_t pass = 0; pass < pass_count; ++pass)
+	{
+		uint32_t shift = pass * RADIX_BITS;
+
+		bind_kernel(command_buffer, histogram_kernel);
+		command_buffer.bind_buffer(*source_keys, 0, source_keys->get_size(), 0, 0, 0);
+		command_buffer.bind_buffer(*histogram, 0, histogram->get_size(), 0, 1, 0);
+		dispatch(command_buffer, count, shift);
+
+		compute_barrier(command_buffer, *histogram);
+
+		scan.record(command_buffer, *histogram, *histogram, histogram_count);
+
+		bind_kernel(command_buffer, scatter_kernel);
+		command_buffer.bind_buffer(*source_keys, 0, source_keys->get_size(), 0, 0, 0);
+		command_buffer.bind_buffer(*destination_keys, 0, destination_keys->get_size(), 0, 1, 0);
+		command_buffer.bind_buffer(*histogram, 0, histogram->get_size(), 0, 2, 0);
+
+		if (sort_values)
+		{
+			command_buffer.bind_buffer(*source_values, 0, source_values->get_size(), 0, 3, 0);
+			command_buffer.bind_buffer(*destination_values, 0, destination_values->get_size(), 0, 4, 0);
+		}
+
+		dispatch(command_buffer, count, shift);
+
+		compute_barrier(command_buffer, *destination_keys);
+
+		if (sort_values)
+		{
+			compute_barrier(command_buffer, *destination_values);
+		}
+
+		std::swap(source_keys, destination_keys);
+		std::swap(source_values, destination_values);
+	}
+}
+}        // namespace vkb
@@ -0,0 +1,263 @@
+/* Copyright (c) 2020, Arm Limited and Contributors
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 the "License";
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <memory>
+#include <vector>
+
+#include "common/helpers.h"
+#include "common/vk_common.h"
+#include "core/buffer.h"
+#include "core/shader_module.h"
+
+namespace vkb
+{
+class CommandBuffer;
+class Device;
+
+/**
+ * @brief Base of the compute primitives, parallel building blocks over storage buffers of uints
+ *
+ * Primitives record their dispatches outside of a render pass, to a command buffer of a render frame,
+ * and are bracketed by compute shader barriers: inputs must be visible to compute shaders before
+ * record, and outputs are visible to compute shaders after it. Workgroups process blocks of
+ * GROUP_SIZE * ITEMS_PER_INVOCATION elements, recursing over the totals of the blocks when needed.
+ *
+ * Workgroup scans and reductions use subgroup arithmetic if the device supports it, which requires
+ * a Vulkan 1.1 instance and device, and the GLSLCompiler to target SPIR-V 1.3 or later.
+ */
+class ComputePrimitive
+{
+  public:
+	ComputePrimitive(Device &device);
+
+	virtual ~ComputePrimitive() = default;
+
+	ComputePrimitive(const ComputePrimitive &) = delete;
+
+	ComputePrimitive(ComputePrimitive &&) = default;
+
+	ComputePrimitive &operator=(const ComputePrimitive &) = delete;
+
+	ComputePrimitive &operator=(ComputePrimitive &&) = delete;
+
+	/**
+	 * @return Whether the primitives can use subgroup arithmetic on the device
+	 */
+	static bool is_subgroup_supported(Device &device);
+
+	/**
+	 * @return Number of elements processed by a workgroup
+	 */
+	static uint32_t get_block_size();
+
+	/**
+	 * @return Whether the primitive was built with subgroup arithmetic
+	 */
+	bool uses_subgroups() const;
+
+  protected:
+	/// Compute shader and definitions of a dispatch of the primitive
+	struct Kernel
+	{
+		ShaderSource source;
+
+		ShaderVariant variant;
+	};
+
+	/// Push constants of every kernel, the second member depends on the kernel
+	struct KernelParameters
+	{
+		uint32_t count;
+
+		uint32_t parameter;
+	};
+
+	/**
+	 * @brief Builds a kernel with the block size and subgroup definitions of the primitive
+	 * @param filename Shader file in the compute_primitives folder
+	 * @param definitions Additional definitions of the kernel
+	 */
+	Kernel create_kernel(const std::string &filename, const std::vector<std::string> &definitions = {});
+
+	/**
+	 * @brief Creates a storage buffer for the intermediate results of the primitive
+	 * @param count Number of uints of the buffer
+	 */
+	std::unique_ptr<core::Buffer> create_storage_buffer(uint32_t count);
+
+	/**
+	 * @brief Binds the pipeline of a kernel, whose buffers are then bound to set 0 in binding order
+	 */
+	void bind_kernel(CommandBuffer &command_buffer, Kernel &kernel);
+
+	/**
+	 * @brief Pushes the parameters of the kernel and dispatches one workgroup per block
+	 */
+	void dispatch(CommandBuffer &command_buffer, uint32_t count, uint32_t parameter = 0);
+
+	/**
+	 * @brief Makes the compute shader writes to a buffer visible to the following compute shaders
+	 */
+	static void compute_barrier(CommandBuffer &command_buffer, const core::Buffer &buffer);
+
+	/**
+	 * @return Number of workgroups processing count elements, at least one
+	 */
+	static uint32_t get_block_count(uint32_t count);
+
+	Device &device;
+
+	bool subgroups{false};
+};
+
+/**
+ * @brief Exclusive prefix sum: the result of an element is the sum of the source elements before it
+ */
+class GpuScan : public ComputePrimitive
+{
+  public:
+	/**
+	 * @param max_count Maximum number of elements of a scan
+	 */
+	GpuScan(Device &device, uint32_t max_count);
+
+	/**
+	 * @brief Records the scan of count elements, result may be the source buffer
+	 */
+	void record(CommandBuffer &command_buffer, const core::Buffer &source, const core::Buffer &result, uint32_t count);
+
+  private:
+	void record_level(CommandBuffer &command_buffer, const core::Buffer &source, const core::Buffer &result, uint32_t count, size_t level);
+
+	uint32_t max_count;
+
+	Kernel scan_kernel;
+
+	Kernel add_kernel;
+
+	/// Totals of the blocks of each level, scanned in place into the offsets of the blocks
+	std::vector<std::unique_ptr<core::Buffer>> block_totals;
+};
+
+/**
+ * @brief Operations of a reduction
+ */
+enum class ReductionOperation
+{
+	Add,
+	Min,
+	Max
+};
+
+/**
+ * @brief Reduces elements to a single value, written to the first element of the result buffer
+ *        The reduction of no elements is the identity of the operation.
+ */
+class GpuReduction : public ComputePrimitive
+{
+  public:
+	/**
+	 * @param max_count Maximum number of elements of a reduction
+	 * @param operation Operation combining the elements
+	 */
+	GpuReduction(Device &device, uint32_t max_count, ReductionOperation operation = ReductionOperation::Add);
+
+	void record(CommandBuffer &command_buffer, const core::Buffer &source, const core::Buffer &result, uint32_t count);
+
+  private:
+	uint32_t max_count;
+
+	Kernel reduce_kernel;
+
+	/// Reductions of the blocks of each level but the last one
+	std::vector<std::unique_ptr<core::Buffer>> partials;
+};
+
+/**
+ * @brief Stream compaction: keeps the elements whose flag is 1, in order, and writes their number
+ */
+class GpuCompaction : public ComputePrimitive
+{
+  public:
+	/**
+	 * @param max_count Maximum number of elements of a compaction
+	 */
+	GpuCompaction(Device &device, uint32_t max_count);
+
+	/**
+	 * @brief Records the compaction of count elements
+	 * @param values Elements to compact
+	 * @param flags 1 for the elements to keep, 0 for the others
+	 * @param result Kept elements, in the order of the values
+	 * @param result_count Number of kept elements, written to its first element
+	 */
+	void record(CommandBuffer &command_buffer, const core::Buffer &values, const core::Buffer &flags,
+	            const core::Buffer &result, const core::Buffer &result_count, uint32_t count);
+
+  private:
+	uint32_t max_count;
+
+	GpuScan scan;
+
+	Kernel compact_kernel;
+
+	/// Destinations of the kept elements
+	std::unique_ptr<core::Buffer> offsets;
+};
+
+/**
+ * @brief Stable least significant digit radix sort of uint keys, with optional uint values,
+ *        sorting 4 bits per pass
+ */
+class GpuRadixSort : public ComputePrimitive
+{
+  public:
+	/**
+	 * @param max_count Maximum number of elements of a sort
+	 * @param sort_values Whether values are reordered along with the keys
+	 */
+	GpuRadixSort(Device &device, uint32_t max_count, bool sort_values = true);
+
+	/**
+	 * @brief Records the sort of count elements, in place
+	 * @param values Values reordered along with the keys, null if the sort does not have values
+	 * @param key_bits Number of low bits of the keys to sort by
+	 */
+	void record(CommandBuffer &command_buffer, const core::Buffer &keys, const core::Buffer *values, uint32_t count, uint32_t key_bits = 32);
+
+  private:
+	uint32_t max_count;
+
+	bool sort_values;
+
+	GpuScan scan;
+
+	Kernel histogram_kernel;
+
+	Kernel scatter_kernel;
+
+	/// Digit counts of each block, digit major, scanned in place into the destinations of the digits
+	std::unique_ptr<core::Buffer> histogram;
+
+	/// Keys and values of the odd passes
+	std::unique_ptr<core::Buffer> scratch_keys;
+
+	std::unique_ptr<core::Buffer> scratch_values;
+};
+}        // namespace vkb
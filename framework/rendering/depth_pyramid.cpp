@@ -0,0 +1,305 @@
+/* Copyright (c) 2020, Arm Limited and Contributors
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 the "License";
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "rendering/depth_pyramid.h"
+
+#include <algorithm>
+#include <cassert>
+
+#include "core/command_buffer.h"
+#include "core/device.h"
+#include "glsl_compiler.h"
+#include "rendering/render_context.h"
+
+namespace vkb
+{
+namespace
+{
+/// Texels of level 0 along each axis reduced by a workgroup of the pyramid shader
+constexpr uint32_t TILE_SIZE = 32;
+
+struct DepthPyramidParameters
+{
+	glm::vec2 inverse_depth_extent;
+
+	uint32_t level_count;
+
+	uint32_t group_count;
+};
+
+/**
+ * @return The smallest power of two greater than or equal to a value
+ */
+uint32_t next_power_of_two(uint32_t value)
+{
+	uint32_t result = 1;
+
+	while (result < value)
+	{
+		result <<= 1;
+	}
+
+	return result;
+}
+}        // namespace
+
+constexpr VkFormat DepthPyramid::FORMAT;
+
+constexpr uint32_t DepthPyramid::MAX_LEVEL_COUNT;
+
+DepthPyramid::DepthPyramid(RenderContext &render_context, VkSamplerReductionMode reduction_mode) :
+    render_context{render_context},
+    reduction_mode{reduction_mode},
+    shader{"depth_pyramid/depth_pyramid.comp"}
+{
+	auto &device = render_context.get_device();
+
+	if (reduction_mode != VK_SAMPLER_REDUCTION_MODE_MIN && reduction_mode != VK_SAMPLER_REDUCTION_MODE_MAX)
+	{
+		throw std::runtime_error("The depth pyramid keeps either the minimum or the maximum depth");
+	}
+
+	auto &subgroup_properties = device.get_gpu().get_subgroup_properties();
+
+	subgroups = GLSLCompiler::get_target_language() == glslang::EShTargetSpv &&
+	            GLSLCompiler::get_target_language_version() >= glslang::EShTargetSpv_1_3 &&
+	            subgroup_properties.subgroupSize >= 4 &&
+	            (subgroup_properties.supportedStages & VK_SHADER_STAGE_COMPUTE_BIT) &&
+	            (subgroup_properties.supportedOperations & VK_SUBGROUP_FEATURE_QUAD_BIT);
+
+	for (auto variant : {&gather_variant, &sampler_variant})
+	{
+		if (reduction_mode == VK_SAMPLER_REDUCTION_MODE_MAX)
+		{
+			variant->add_define("REDUCE_MAX");
+		}
+
+		if (subgroups)
+		{
+			variant->add_define("SUBGROUP_QUAD");
+		}
+	}
+
+	sampler_variant.add_define("SAMPLER_REDUCTION");
+
+	auto &resource_cache = device.get_resource_cache();
+	resource_cache.request_shader_module(VK_SHADER_STAGE_COMPUTE_BIT, shader, gather_variant);
+
+	VkSamplerCreateInfo sampler_info{VK_STRUCTURE_TYPE_SAMPLER_CREATE_INFO};
+	sampler_info.maxAnisotropy = 1.0f;
+	sampler_info.magFilter     = VK_FILTER_NEAREST;
+	sampler_info.minFilter     = VK_FILTER_NEAREST;
+	sampler_info.mipmapMode    = VK_SAMPLER_MIPMAP_MODE_NEAREST;
+	sampler_info.addressModeU  = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+	sampler_info.addressModeV  = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+	sampler_info.addressModeW  = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+	sampler_info.borderColor   = VK_BORDER_COLOR_FLOAT_OPAQUE_BLACK;
+	gather_sampler             = std::make_unique<core::Sampler>(device, sampler_info);
+
+	if (device.is_enabled(VK_EXT_SAMPLER_FILTER_MINMAX_EXTENSION_NAME))
+	{
+		// A linear filter spans the 2x2 texels around the sampled point, which the reduction combines
+		VkSamplerReductionModeCreateInfoEXT reduction_info{VK_STRUCTURE_TYPE_SAMPLER_REDUCTION_MODE_CREATE_INFO_EXT};
+		reduction_info.reductionMode = reduction_mode;
+
+		sampler_info.pNext     = &reduction_info;
+		sampler_info.magFilter = VK_FILTER_LINEAR;
+		sampler_info.minFilter = VK_FILTER_LINEAR;
+		reduction_sampler      = std::make_unique<core::Sampler>(device, sampler_info);
+
+		resource_cache.request_shader_module(VK_SHADER_STAGE_COMPUTE_BIT, shader, sampler_variant);
+	}
+}
+
+RenderTarget::CreateFunc DepthPyramid::get_create_func()
+{
+	return [](core::Image &&swapchain_image) -> std::unique_ptr<RenderTarget> {
+		auto &device = swapchain_image.get_device();
+
+		VkFormat depth_format = get_suitable_depth_format(device.get_gpu().get_handle());
+
+		core::Image depth_image{device, swapchain_image.get_extent(),
+		                        depth_format,
+		                        VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT | VK_IMAGE_USAGE_SAMPLED_BIT,
+		                        VMA_MEMORY_USAGE_GPU_ONLY};
+
+		std::vector<core::Image> images;
+		images.push_back(std::move(swapchain_image));
+		images.push_back(std::move(depth_image));
+
+		return std::make_unique<RenderTarget>(std::move(images));
+	};
+}
+
+void DepthPyramid::record(CommandBuffer &command_buffer, const core::ImageView &depth)
+{
+	const auto &extent = depth.get_image().get_extent();
+
+	if (!pyramid || extent.width != depth_extent.width || extent.height != depth_extent.height)
+	{
+		create_pyramid({extent.width, extent.height});
+	}
+
+	if (!counter_initialized)
+	{
+		command_buffer.flush_barriers();
+
+		vkCmdFillBuffer(command_buffer.get_handle(), counter_buffer->get_handle(), 0, VK_WHOLE_SIZE, 0);
+
+		counter_initialized = true;
+	}
+
+	{
+		// The last workgroup of the previous recording reset the counter
+		BufferMemoryBarrier barrier;
+		barrier.src_stage_mask  = VK_PIPELINE_STAGE_TRANSFER_BIT | VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT;
+		barrier.dst_stage_mask  = VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT;
+		barrier.src_access_mask = VK_ACCESS_TRANSFER_WRITE_BIT | VK_ACCESS_SHADER_WRITE_BIT;
+		barrier.dst_access_mask = VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT;
+
+		command_buffer.buffer_memory_barrier(*counter_buffer, 0, VK_WHOLE_SIZE, barrier);
+	}
+
+	{
+		// Previous frames may still sample the pyramid, its content is replaced
+		ImageMemoryBarrier barrier{};
+		barrier.old_layout      = VK_IMAGE_LAYOUT_UNDEFINED;
+		barrier.new_layout      = VK_IMAGE_LAYOUT_GENERAL;
+		barrier.src_access_mask = 0;
+		barrier.dst_access_mask = VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT;
+		barrier.src_stage_mask  = VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT | VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT;
+		barrier.dst_stage_mask  = VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT;
+
+		command_buffer.image_memory_barrier(*pyramid_view, barrier);
+	}
+
+	bool sampler_reduction = is_sampler_reduction_supported(depth.get_format());
+
+	auto &resource_cache  = render_context.get_device().get_resource_cache();
+	auto &shader_module   = resource_cache.request_shader_module(VK_SHADER_STAGE_COMPUTE_BIT, shader, sampler_reduction ? sampler_variant : gather_variant);
+	auto &pipeline_layout = resource_cache.request_pipeline_layout({&shader_module});
+
+	command_buffer.bind_pipeline_layout(pipeline_layout);
+
+	command_buffer.bind_image(depth, sampler_reduction ? *reduction_sampler : *gather_sampler, 0, 0, 0);
+
+	// Elements past the last level are never written, they repeat it to keep the descriptors valid
+	for (uint32_t i = 0; i < MAX_LEVEL_COUNT; ++i)
+	{
+		command_buffer.bind_image(*level_views[std::min<size_t>(i, level_views.size() - 1)], 0, 1, i);
+	}
+
+	command_buffer.bind_buffer(*counter_buffer, 0, counter_buffer->get_size(), 0, 2, 0);
+
+	const auto &level_extent = pyramid->get_extent();
+
+	uint32_t group_count_x = (level_extent.width + TILE_SIZE - 1) / TILE_SIZE;
+	uint32_t group_count_y = (level_extent.height + TILE_SIZE - 1) / TILE_SIZE;
+
+	command_buffer.push_constants(DepthPyramidParameters{glm::vec2(1.0f / depth_extent.width, 1.0f / depth_extent.height),
+	                                                     get_level_count(),
+	                                                     group_count_x * group_count_y});
+
+	command_buffer.dispatch(group_count_x, group_count_y, 1);
+
+	ImageMemoryBarrier barrier{};
+	barrier.old_layout      = VK_IMAGE_LAYOUT_GENERAL;
+	barrier.new_layout      = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+	barrier.src_access_mask = VK_ACCESS_SHADER_WRITE_BIT;
+	barrier.dst_access_mask = VK_ACCESS_SHADER_READ_BIT;
+	barrier.src_stage_mask  = VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT;
+	barrier.dst_stage_mask  = VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT | VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT;
+
+	command_buffer.image_memory_barrier(*pyramid_view, barrier);
+}
+
+const core::ImageView &DepthPyramid::get_output() const
+{
+	assert(pyramid_view && "The depth pyramid was not recorded");
+	return *pyramid_view;
+}
+
+uint32_t DepthPyramid::get_level_count() const
+{
+	return to_u32(level_views.size());
+}
+
+glm::vec2 DepthPyramid::get_uv_scale() const
+{
+	if (!pyramid)
+	{
+		return glm::vec2(1.0f);
+	}
+
+	const auto &level_extent = pyramid->get_extent();
+
+	return glm::vec2(static_cast<float>(depth_extent.width) / (2 * level_extent.width),
+	                 static_cast<float>(depth_extent.height) / (2 * level_extent.height));
+}
+
+bool DepthPyramid::is_sampler_reduction_supported(VkFormat depth_format) const
+{
+	return reduction_sampler &&
+	       (render_context.get_device().get_gpu().get_format_properties(depth_format).optimalTilingFeatures & VK_FORMAT_FEATURE_SAMPLED_IMAGE_FILTER_MINMAX_BIT_EXT);
+}
+
+bool DepthPyramid::uses_subgroups() const
+{
+	return subgroups;
+}
+
+void DepthPyramid::create_pyramid(const VkExtent2D &extent)
+{
+	auto &device = render_context.get_device();
+
+	depth_extent = extent;
+
+	level_views.clear();
+	pyramid_view = nullptr;
+	pyramid.reset();
+
+	// Powers of two, so that each level halves the previous one exactly
+	VkExtent3D level_extent{next_power_of_two((extent.width + 1) / 2), next_power_of_two((extent.height + 1) / 2), 1};
+
+	uint32_t level_count = 1;
+	while ((1u << (level_count - 1)) < std::max(level_extent.width, level_extent.height))
+	{
+		level_count++;
+	}
+
+	if (level_count > MAX_LEVEL_COUNT)
+	{
+		throw std::runtime_error("Depth attachments larger than " + std::to_string(1u << MAX_LEVEL_COUNT) + " texels are not supported by the depth pyramid");
+	}
+
+	pyramid = std::make_unique<core::Image>(device, level_extent, FORMAT, VK_IMAGE_USAGE_STORAGE_BIT | VK_IMAGE_USAGE_SAMPLED_BIT,
+	                                        VMA_MEMORY_USAGE_GPU_ONLY, VK_SAMPLE_COUNT_1_BIT, level_count);
+
+	pyramid_view = &pyramid->request_view(VK_IMAGE_VIEW_TYPE_2D);
+
+	for (uint32_t level = 0; level < level_count; ++level)
+	{
+		level_views.push_back(&pyramid->request_view(VK_IMAGE_VIEW_TYPE_2D, FORMAT, 0, 1, level, 1));
+	}
+
+	if (!counter_buffer)
+	{
+		counter_buffer = std::make_unique<core::Buffer>(device, sizeof(uint32_t),
+		                                                VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT, VMA_MEMORY_USAGE_GPU_ONLY);
+	}
+}
+}        // namespace vkb
@@ -0,0 +1,158 @@
+/* Copyright (c) 2020, Arm Limited and Contributors
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 the "License";
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <memory>
+#include <vector>
+
+#include "common/error.h"
+
+VKBP_DISABLE_WARNINGS()
+#include "common/glm_common.h"
+VKBP_ENABLE_WARNINGS()
+
+#include "core/buffer.h"
+#include "core/image.h"
+#include "core/image_view.h"
+#include "core/sampler.h"
+#include "core/shader_module.h"
+#include "rendering/render_target.h"
+
+namespace vkb
+{
+class CommandBuffer;
+class Device;
+class RenderContext;
+
+/**
+ * @brief Builds a hierarchical depth pyramid from a depth attachment, for occlusion culling and screen space effects
+ *
+ * Each level keeps the minimum, or the maximum, of the 2x2 texels of the previous level covering it. With the reversed
+ * depth of the framework, the minimum is the farthest depth, as occlusion culling needs it. Level 0 has the extent of
+ * the depth halved and rounded up to powers of two, so that every level reduces exactly its previous level, texels
+ * past the depth repeating its edges. Consumers scale screen coordinates with get_uv_scale to sample it.
+ *
+ * The whole chain is built in a single dispatch: workgroups reduce tiles to six levels in shared memory, and the last
+ * workgroup to finish reduces the remaining levels from the results of the others. The first level is fetched with a
+ * min/max reduction sampler if VK_EXT_sampler_filter_minmax is enabled and supported by the depth format, and
+ * with a gather otherwise. Quads of invocations reduce through subgroup quad operations where supported.
+ */
+class DepthPyramid
+{
+  public:
+	/// Format of the pyramid
+	static constexpr VkFormat FORMAT = VK_FORMAT_R32_SFLOAT;
+
+	/// Levels a single dispatch builds, a depth attachment of up to 4096x4096 is reduced to 1x1
+	static constexpr uint32_t MAX_LEVEL_COUNT = 12;
+
+	/**
+	 * @param reduction_mode VK_SAMPLER_REDUCTION_MODE_MIN to keep the farthest depths with reversed depth, or VK_SAMPLER_REDUCTION_MODE_MAX
+	 */
+	DepthPyramid(RenderContext &render_context, VkSamplerReductionMode reduction_mode = VK_SAMPLER_REDUCTION_MODE_MIN);
+
+	DepthPyramid(const DepthPyramid &) = delete;
+
+	DepthPyramid(DepthPyramid &&) = delete;
+
+	DepthPyramid &operator=(const DepthPyramid &) = delete;
+
+	DepthPyramid &operator=(DepthPyramid &&) = delete;
+
+	/**
+	 * @return Creates render targets with the attachments of RenderTarget::DEFAULT_CREATE_FUNC, with a depth attachment
+	 *         which can be sampled, 0 being the color and 1 the depth. Subpasses have to store depth for the pyramid.
+	 */
+	static RenderTarget::CreateFunc get_create_func();
+
+	/**
+	 * @brief Records the dispatch, outside of a render pass
+	 *        The pyramid is created again if the extent of the depth changes.
+	 * @param command_buffer Command buffer to record the dispatch to
+	 * @param depth View of the depth aspect of an image, in the shader read only layout and visible to compute shaders
+	 */
+	void record(CommandBuffer &command_buffer, const core::ImageView &depth);
+
+	/**
+	 * @return The pyramid of the last recording with all its levels, in the shader read only layout
+	 */
+	const core::ImageView &get_output() const;
+
+	/**
+	 * @return Number of levels of the pyramid, down to 1x1
+	 */
+	uint32_t get_level_count() const;
+
+	/**
+	 * @return Scale from the texture coordinates of the depth to those of the pyramid, which covers more than the depth
+	 */
+	glm::vec2 get_uv_scale() const;
+
+	/**
+	 * @return Whether the first level is fetched with a reduction sampler for a depth format
+	 */
+	bool is_sampler_reduction_supported(VkFormat depth_format) const;
+
+	/**
+	 * @return Whether quads of invocations reduce with subgroup operations
+	 */
+	bool uses_subgroups() const;
+
+  private:
+	/**
+	 * @brief Creates the pyramid for a depth extent
+	 */
+	void create_pyramid(const VkExtent2D &depth_extent);
+
+	RenderContext &render_context;
+
+	VkSamplerReductionMode reduction_mode;
+
+	bool subgroups{false};
+
+	ShaderSource shader;
+
+	/// Variant fetching the first level with a gather
+	ShaderVariant gather_variant;
+
+	/// Variant fetching the first level with the reduction sampler
+	ShaderVariant sampler_variant;
+
+	/// Sampler gathering depth texels
+	std::unique_ptr<core::Sampler> gather_sampler;
+
+	/// Sampler returning the minimum or maximum of its footprint, null if not supported
+	std::unique_ptr<core::Sampler> reduction_sampler;
+
+	/// Workgroups which finished their tile, reset to 0 by the last one
+	std::unique_ptr<core::Buffer> counter_buffer;
+
+	/// Whether the counter was cleared
+	bool counter_initialized{false};
+
+	VkExtent2D depth_extent{};
+
+	std::unique_ptr<core::Image> pyramid;
+
+	/// View of all the levels, owned by the pyramid
+	core::ImageView *pyramid_view{nullptr};
+
+	/// Views of each level, owned by the pyramid
+	std::vector<core::ImageView *> level_views;
+};
+}        // namespace vkb
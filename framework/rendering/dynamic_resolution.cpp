@@ -0,0 +1,252 @@
+/* Copyright (c) 2020, Arm Limited and Contributors
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 the "License";
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "rendering/dynamic_resolution.h"
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+
+#include "core/command_buffer.h"
+#include "rendering/render_context.h"
+
+namespace vkb
+{
+namespace
+{
+/// Fraction of the target frame time the controller aims for, leaving room for variations
+constexpr float TARGET_UTILIZATION = 0.9f;
+
+/// Weight of the latest GPU time in the smoothed one
+constexpr float GPU_TIME_SMOOTHING = 0.25f;
+
+/// Most the scale shrinks in a frame, it reacts faster to overruns than to spare time
+constexpr float MAX_SCALE_DECREASE = 0.9f;
+
+/// Most the scale grows in a frame
+constexpr float MAX_SCALE_INCREASE = 1.02f;
+
+/// Render areas are multiples of this many pixels, so small changes of the scale keep the same area
+constexpr uint32_t RENDER_AREA_ALIGNMENT = 8;
+
+uint32_t scale_dimension(uint32_t dimension, float scale)
+{
+	uint32_t scaled = static_cast<uint32_t>(std::round(dimension * scale / RENDER_AREA_ALIGNMENT)) * RENDER_AREA_ALIGNMENT;
+
+	return std::min(std::max(scaled, RENDER_AREA_ALIGNMENT), dimension);
+}
+}        // namespace
+
+DynamicResolution::DynamicResolution(RenderContext &render_context, RenderTarget::CreateFunc create_render_target_func) :
+    render_context{render_context},
+    create_render_target_func{create_render_target_func}
+{
+	auto &limits = render_context.get_device().get_gpu().get_properties().limits;
+
+	timestamps_supported = limits.timestampComputeAndGraphics;
+	timestamp_period     = limits.timestampPeriod;
+
+	if (!timestamps_supported)
+	{
+		LOGW("Timestamps are not supported, dynamic resolution keeps a constant scale");
+	}
+
+	// Offscreen images are upscaled to the swapchain images with blits
+	render_context.add_swapchain_usage(VK_IMAGE_USAGE_TRANSFER_DST_BIT);
+}
+
+bool DynamicResolution::is_supported() const
+{
+	return timestamps_supported;
+}
+
+void DynamicResolution::set_target_frame_time(float seconds)
+{
+	target_frame_time = seconds;
+}
+
+void DynamicResolution::set_scale_range(float min_scale_, float max_scale_)
+{
+	max_scale = std::min(std::max(max_scale_, 0.0f), 1.0f);
+	min_scale = std::min(std::max(min_scale_, 0.0f), max_scale);
+	scale     = std::min(std::max(scale, min_scale), max_scale);
+}
+
+float DynamicResolution::get_scale() const
+{
+	return scale;
+}
+
+float DynamicResolution::get_gpu_frame_time() const
+{
+	return gpu_frame_time;
+}
+
+void DynamicResolution::create_render_targets()
+{
+	auto &device = render_context.get_device();
+	auto &frames = render_context.get_render_frames();
+
+	render_targets.clear();
+	render_targets.resize(frames.size());
+
+	timestamps_written.assign(frames.size(), false);
+
+	if (timestamps_supported)
+	{
+		VkQueryPoolCreateInfo timestamp_pool_create_info{VK_STRUCTURE_TYPE_QUERY_POOL_CREATE_INFO};
+		timestamp_pool_create_info.queryType  = VK_QUERY_TYPE_TIMESTAMP;
+		timestamp_pool_create_info.queryCount = to_u32(frames.size() * 2);
+
+		timestamp_pool = std::make_unique<QueryPool>(device, timestamp_pool_create_info);
+	}
+}
+
+void DynamicResolution::update_scale()
+{
+	uint32_t frame_index = render_context.get_active_frame_index();
+
+	if (!timestamp_pool || !timestamps_written[frame_index])
+	{
+		return;
+	}
+
+	// The frame waited for its previous submission, so its timestamps are available
+	std::array<uint64_t, 2> timestamps;
+
+	VkResult result = timestamp_pool->get_results(frame_index * 2, 2,
+	                                              timestamps.size() * sizeof(uint64_t),
+	                                              timestamps.data(), sizeof(uint64_t),
+	                                              VK_QUERY_RESULT_64_BIT);
+	if (result != VK_SUCCESS)
+	{
+		return;
+	}
+
+	float frame_time = timestamp_period * static_cast<float>(timestamps[1] - timestamps[0]) * 0.000000001f;
+
+	gpu_frame_time = gpu_frame_time > 0.0f ? gpu_frame_time + (frame_time - gpu_frame_time) * GPU_TIME_SMOOTHING : frame_time;
+
+	if (gpu_frame_time <= 0.0f)
+	{
+		return;
+	}
+
+	// GPU time is mostly proportional to the number of pixels, which is the square of the scale
+	float factor = std::sqrt(target_frame_time * TARGET_UTILIZATION / gpu_frame_time);
+
+	scale *= std::min(std::max(factor, MAX_SCALE_DECREASE), MAX_SCALE_INCREASE);
+	scale = std::min(std::max(scale, min_scale), max_scale);
+}
+
+RenderTarget &DynamicResolution::begin(CommandBuffer &command_buffer)
+{
+	auto &frame       = render_context.get_active_frame();
+	auto  frame_index = render_context.get_active_frame_index();
+
+	if (render_targets.size() != render_context.get_render_frames().size())
+	{
+		create_render_targets();
+	}
+
+	update_scale();
+
+	// Frames receive new render targets when the swapchain is recreated
+	const auto &extent = frame.get_render_target().get_extent();
+
+	auto &render_target = render_targets[frame_index];
+
+	if (!render_target || render_target->get_extent().width != extent.width || render_target->get_extent().height != extent.height)
+	{
+		core::Image color_image{render_context.get_device(),
+		                        VkExtent3D{extent.width, extent.height, 1},
+		                        render_context.get_format(),
+		                        VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT | VK_IMAGE_USAGE_TRANSFER_SRC_BIT,
+		                        VMA_MEMORY_USAGE_GPU_ONLY};
+
+		render_target = create_render_target_func(std::move(color_image));
+	}
+
+	render_target->set_render_area({scale_dimension(extent.width, scale), scale_dimension(extent.height, scale)});
+
+	swapchain_render_target = frame.release_render_target();
+	frame.update_render_target(std::move(render_target));
+
+	if (timestamp_pool)
+	{
+		command_buffer.reset_query_pool(*timestamp_pool, frame_index * 2, 2);
+		command_buffer.write_timestamp(VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, *timestamp_pool, frame_index * 2);
+	}
+
+	return frame.get_render_target();
+}
+
+void DynamicResolution::end(CommandBuffer &command_buffer)
+{
+	auto &frame       = render_context.get_active_frame();
+	auto  frame_index = render_context.get_active_frame_index();
+
+	if (timestamp_pool)
+	{
+		command_buffer.write_timestamp(VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, *timestamp_pool, frame_index * 2 + 1);
+		timestamps_written[frame_index] = true;
+	}
+
+	auto &render_target = render_targets[frame_index];
+
+	render_target = frame.release_render_target();
+	frame.update_render_target(std::move(swapchain_render_target));
+
+	auto &swapchain_view = frame.get_render_target().get_views().at(0);
+	auto &offscreen_view = render_target->get_views().at(0);
+
+	{
+		// Wait for the swapchain image to be acquired, as the render passes would
+		ImageMemoryBarrier memory_barrier{};
+		memory_barrier.old_layout      = VK_IMAGE_LAYOUT_UNDEFINED;
+		memory_barrier.new_layout      = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+		memory_barrier.src_access_mask = 0;
+		memory_barrier.dst_access_mask = VK_ACCESS_TRANSFER_WRITE_BIT;
+		memory_barrier.src_stage_mask  = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT;
+		memory_barrier.dst_stage_mask  = VK_PIPELINE_STAGE_TRANSFER_BIT;
+
+		command_buffer.image_memory_barrier(swapchain_view, memory_barrier);
+	}
+
+	const auto &render_area = render_target->get_render_area();
+	const auto &extent      = frame.get_render_target().get_extent();
+
+	VkImageBlit blit{};
+	blit.srcSubresource = {VK_IMAGE_ASPECT_COLOR_BIT, 0, 0, 1};
+	blit.srcOffsets[1]  = {static_cast<int32_t>(render_area.width), static_cast<int32_t>(render_area.height), 1};
+	blit.dstSubresource = {VK_IMAGE_ASPECT_COLOR_BIT, 0, 0, 1};
+	blit.dstOffsets[1]  = {static_cast<int32_t>(extent.width), static_cast<int32_t>(extent.height), 1};
+
+	command_buffer.blit_image(offscreen_view.get_image(), swapchain_view.get_image(), {blit}, VK_FILTER_LINEAR);
+
+	{
+		ImageMemoryBarrier memory_barrier{};
+		memory_barrier.old_layout      = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+		memory_barrier.new_layout      = VK_IMAGE_LAYOUT_PRESENT_SRC_KHR;
+		memory_barrier.src_access_mask = VK_ACCESS_TRANSFER_WRITE_BIT;
+		memory_barrier.src_stage_mask  = VK_PIPELINE_STAGE_TRANSFER_BIT;
+		memory_barrier.dst_stage_mask  = VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT;
+
+		command_buffer.image_memory_barrier(swapchain_view, memory_barrier);
+	}
+}
+}        // namespace vkb
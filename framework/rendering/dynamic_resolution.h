@@ -0,0 +1,141 @@
+/* Copyright (c) 2020, Arm Limited and Contributors
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 the "License";
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include "core/query_pool.h"
+#include "rendering/render_target.h"
+
+namespace vkb
+{
+class CommandBuffer;
+class RenderContext;
+
+/**
+ * @brief Renders frames to offscreen render targets at a scale of the swapchain extent, which
+ *        follows the GPU time of the previous frames to keep it within a budget, then upscales
+ *        them to the swapchain images with a blit
+ *
+ * The offscreen images have the extent of the swapchain and a render area is used to render to
+ * part of them, so changing the scale creates no resources. GPU time is measured with timestamps
+ * around the work recorded between begin and end.
+ */
+class DynamicResolution
+{
+  public:
+	/**
+	 * @brief Adds the transfer destination usage to the swapchain images if they miss it,
+	 *        the render context needs a swapchain and to be prepared
+	 * @param render_context Context of the frames to render
+	 * @param create_render_target_func Creates an offscreen render target from its color image,
+	 *        as the render context does with swapchain images
+	 */
+	DynamicResolution(RenderContext &render_context, RenderTarget::CreateFunc create_render_target_func = RenderTarget::DEFAULT_CREATE_FUNC);
+
+	DynamicResolution(const DynamicResolution &) = delete;
+
+	DynamicResolution(DynamicResolution &&) = delete;
+
+	DynamicResolution &operator=(const DynamicResolution &) = delete;
+
+	DynamicResolution &operator=(DynamicResolution &&) = delete;
+
+	/**
+	 * @return True if the GPU can write timestamps, otherwise the scale does not change
+	 */
+	bool is_supported() const;
+
+	/**
+	 * @param seconds GPU time to keep frames within
+	 */
+	void set_target_frame_time(float seconds);
+
+	/**
+	 * @param min_scale Smallest scale of the swapchain extent to render at
+	 * @param max_scale Largest scale of the swapchain extent to render at, no more than 1
+	 */
+	void set_scale_range(float min_scale, float max_scale);
+
+	/**
+	 * @return The scale the current frame renders at
+	 */
+	float get_scale() const;
+
+	/**
+	 * @return The GPU time of recent frames, smoothed
+	 */
+	float get_gpu_frame_time() const;
+
+	/**
+	 * @brief Updates the scale from the GPU time of the previous use of the active frame,
+	 *        then makes the offscreen render target of the active frame its render target
+	 * @param command_buffer Command buffer of the active frame, outside of a render pass
+	 * @return The offscreen render target, whose images are transitioned by the caller
+	 */
+	RenderTarget &begin(CommandBuffer &command_buffer);
+
+	/**
+	 * @brief Gives the active frame its swapchain render target back and upscales the offscreen
+	 *        color to it, leaving the swapchain image in the present layout
+	 * @param command_buffer Command buffer of the active frame, outside of a render pass
+	 *        The offscreen color must be in the transfer source layout.
+	 */
+	void end(CommandBuffer &command_buffer);
+
+  private:
+	/**
+	 * @brief Updates the scale from the timestamps of the active frame, if available
+	 */
+	void update_scale();
+
+	/**
+	 * @brief Creates offscreen render targets matching the render targets of the frames
+	 */
+	void create_render_targets();
+
+	RenderContext &render_context;
+
+	RenderTarget::CreateFunc create_render_target_func;
+
+	bool timestamps_supported{false};
+
+	/// Nanoseconds per timestamp tick
+	float timestamp_period{1.0f};
+
+	/// Two timestamps for each frame
+	std::unique_ptr<QueryPool> timestamp_pool;
+
+	/// Whether the timestamps of a frame were written by its last submission
+	std::vector<bool> timestamps_written;
+
+	/// Offscreen render target of each frame, moved to the frame between begin and end
+	std::vector<std::unique_ptr<RenderTarget>> render_targets;
+
+	/// Render target of the swapchain image of the active frame, held between begin and end
+	std::unique_ptr<RenderTarget> swapchain_render_target;
+
+	float target_frame_time{1.0f / 60.0f};
+
+	float min_scale{0.5f};
+
+	float max_scale{1.0f};
+
+	float scale{1.0f};
+
+	float gpu_frame_time{0.0f};
+};
+}        // namespace vkb
@@ -0,0 +1,183 @@
+/* Copyright (c) 2020, Arm Limited and Contributors
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 the "License";
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "frame_strategy_tuner.h"
+
+#include <cmath>
+
+#include "common/logging.h"
+
+namespace vkb
+{
+namespace
+{
+const char *to_string(BufferAllocationStrategy strategy)
+{
+	return strategy == BufferAllocationStrategy::OneAllocationPerBuffer ? "One allocation per buffer" : "Multiple allocations per buffer";
+}
+
+BufferAllocationStrategy other_strategy(BufferAllocationStrategy strategy)
+{
+	return strategy == BufferAllocationStrategy::OneAllocationPerBuffer ? BufferAllocationStrategy::MultipleAllocationsPerBuffer : BufferAllocationStrategy::OneAllocationPerBuffer;
+}
+}        // namespace
+
+void FrameStrategyTuner::begin_frame(RenderFrame &frame)
+{
+	FrameCounters counters;
+	counters.descriptor_sets        = frame.get_descriptor_set_counters();
+	counters.buffer_block_requests  = frame.get_buffer_block_request_count();
+	counters.buffer_allocated_bytes = frame.get_buffer_allocated_bytes();
+
+	auto counters_it = frame_counters.find(&frame);
+
+	if (counters_it == frame_counters.end())
+	{
+		frame_counters.emplace(&frame, counters);
+	}
+	else
+	{
+		auto &last = counters_it->second;
+
+		// Counters start over when frames are re-created
+		bool valid = counters.descriptor_sets.requested >= last.descriptor_sets.requested &&
+		             counters.buffer_block_requests >= last.buffer_block_requests &&
+		             counters.buffer_allocated_bytes >= last.buffer_allocated_bytes;
+
+		if (valid && skipped_frame_count > 0)
+		{
+			--skipped_frame_count;
+		}
+		else if (valid)
+		{
+			window.descriptor_sets.requested += counters.descriptor_sets.requested - last.descriptor_sets.requested;
+			window.descriptor_sets.created += counters.descriptor_sets.created - last.descriptor_sets.created;
+			window.descriptor_sets.recreated += counters.descriptor_sets.recreated - last.descriptor_sets.recreated;
+			window.buffer_block_requests += counters.buffer_block_requests - last.buffer_block_requests;
+			window.buffer_allocated_bytes += counters.buffer_allocated_bytes - last.buffer_allocated_bytes;
+
+			++window_frame_count;
+		}
+
+		last = counters;
+	}
+
+	if (window_frame_count >= WINDOW_FRAMES)
+	{
+		evaluate();
+	}
+
+	frame.set_buffer_allocation_strategy(buffer_allocation_strategy);
+
+	if (descriptor_management_strategy == DescriptorManagementStrategy::ResetPools)
+	{
+		frame.clear_descriptors();
+	}
+}
+
+DescriptorManagementStrategy FrameStrategyTuner::get_descriptor_management_strategy() const
+{
+	return descriptor_management_strategy;
+}
+
+BufferAllocationStrategy FrameStrategyTuner::get_buffer_allocation_strategy() const
+{
+	return buffer_allocation_strategy;
+}
+
+void FrameStrategyTuner::evaluate()
+{
+	const auto &sets = window.descriptor_sets;
+
+	bool descriptors_switched = false;
+
+	if (sets.requested > 0)
+	{
+		double hit_rate       = 1.0 - static_cast<double>(sets.created) / sets.requested;
+		double recreated_rate = static_cast<double>(sets.recreated) / sets.requested;
+
+		if (descriptor_management_strategy == DescriptorManagementStrategy::CacheSets && hit_rate < MIN_CACHE_HIT_RATE)
+		{
+			LOGI("Descriptor set cache hit rate is {:.0f}%, resetting the descriptor pools every frame", hit_rate * 100.0);
+
+			descriptor_management_strategy = DescriptorManagementStrategy::ResetPools;
+			descriptors_switched           = true;
+		}
+		else if (descriptor_management_strategy == DescriptorManagementStrategy::ResetPools && recreated_rate > MIN_RECREATED_RATE)
+		{
+			LOGI("{:.0f}% of the descriptor sets are allocated again after resetting the descriptor pools, caching them", recreated_rate * 100.0);
+
+			descriptor_management_strategy = DescriptorManagementStrategy::CacheSets;
+			descriptors_switched           = true;
+		}
+	}
+
+	if (descriptors_switched)
+	{
+		// The window does not measure a single buffer allocation strategy, and the costs change with the descriptor sets
+		if (trying_buffer_allocation_strategy)
+		{
+			buffer_allocation_strategy        = other_strategy(buffer_allocation_strategy);
+			trying_buffer_allocation_strategy = false;
+		}
+
+		buffer_allocation_cost = -1.0;
+
+		skip_frames();
+	}
+	else if (window.buffer_allocated_bytes > 0)
+	{
+		// Buffer allocation strategies matter as much as the descriptor sets they make the frames allocate
+		double cost = static_cast<double>(sets.created + window.buffer_block_requests) / window_frame_count;
+
+		if (trying_buffer_allocation_strategy)
+		{
+			trying_buffer_allocation_strategy = false;
+
+			if (cost < buffer_allocation_cost * (1.0 - MIN_COST_SAVING))
+			{
+				LOGI("{} makes {:.1f} allocations per frame instead of {:.1f}, keeping it", to_string(buffer_allocation_strategy), cost, buffer_allocation_cost);
+
+				buffer_allocation_cost = cost;
+			}
+			else
+			{
+				buffer_allocation_strategy = other_strategy(buffer_allocation_strategy);
+
+				skip_frames();
+			}
+		}
+		else if (buffer_allocation_cost < 0.0 || std::abs(cost - buffer_allocation_cost) > WORKLOAD_CHANGE * buffer_allocation_cost)
+		{
+			buffer_allocation_cost            = cost;
+			buffer_allocation_strategy        = other_strategy(buffer_allocation_strategy);
+			trying_buffer_allocation_strategy = true;
+
+			skip_frames();
+		}
+	}
+
+	window             = {};
+	window_frame_count = 0;
+}
+
+void FrameStrategyTuner::skip_frames()
+{
+	// Frames in flight were recorded with the previous strategies, then cached descriptor sets are created again
+	skipped_frame_count = 2 * to_u32(frame_counters.size());
+}
+}        // namespace vkb
@@ -0,0 +1,128 @@
+/* Copyright (c) 2020, Arm Limited and Contributors
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 the "License";
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <unordered_map>
+
+#include "common/helpers.h"
+#include "common/vk_common.h"
+#include "rendering/render_frame.h"
+
+namespace vkb
+{
+/**
+ * @brief How the descriptor sets of a frame are managed between its uses
+ */
+enum class DescriptorManagementStrategy
+{
+	/// Sets are kept by the frame and found again by their bindings
+	CacheSets,
+
+	/// Sets are dropped and their pools reset when the frame begins, so sets are allocated every frame
+	ResetPools
+};
+
+/**
+ * @brief Picks the descriptor management and buffer allocation strategies of the render frames at runtime
+ *
+ * When a frame begins, the descriptor set and buffer block requests it made the last time it was recorded
+ * are accumulated over a window of frames, then:
+ * - the descriptor sets are reset every frame when few requests find a cached set, which means the cache
+ *   only grows, and cached again when most of the sets allocated after a reset were dropped by it
+ * - the other buffer allocation strategy is tried for a window when the workload changes, and kept if it
+ *   makes fewer descriptor set allocations and buffer block requests per frame
+ *
+ * The thresholds are apart so that strategies do not switch back and forth. Frames recorded before a switch
+ * are not measured. The descriptor set cache hit rate and buffer block requests are also reported by Stats.
+ */
+class FrameStrategyTuner
+{
+  public:
+	/// Frames measured before a decision
+	static constexpr uint32_t WINDOW_FRAMES{60};
+
+	/// Cache hit rate below which cached descriptor sets are reset every frame instead
+	static constexpr double MIN_CACHE_HIT_RATE{0.5};
+
+	/// Part of the requests which recreate sets dropped by the reset above which sets are cached again
+	static constexpr double MIN_RECREATED_RATE{0.75};
+
+	/// Relative change of the cost of frames which makes the buffer allocation strategies be compared again
+	static constexpr double WORKLOAD_CHANGE{0.5};
+
+	/// Relative cost saving a buffer allocation strategy needs to replace the current one
+	static constexpr double MIN_COST_SAVING{0.1};
+
+	FrameStrategyTuner() = default;
+
+	/**
+	 * @brief Measures the previous use of a frame which begins and applies the current strategies to it
+	 *        Must be called once the frame waited for its previous submissions, and before recording it.
+	 * @param frame The active frame
+	 */
+	void begin_frame(RenderFrame &frame);
+
+	DescriptorManagementStrategy get_descriptor_management_strategy() const;
+
+	BufferAllocationStrategy get_buffer_allocation_strategy() const;
+
+  private:
+	/**
+	 * @brief Counters of a frame when it last began
+	 */
+	struct FrameCounters
+	{
+		DescriptorSetCounters descriptor_sets;
+
+		uint64_t buffer_block_requests{0};
+
+		VkDeviceSize buffer_allocated_bytes{0};
+	};
+
+	/**
+	 * @brief Decides the strategies from the measured window
+	 */
+	void evaluate();
+
+	/**
+	 * @brief Switches strategies, the next uses of the frames were recorded before and are not measured
+	 */
+	void skip_frames();
+
+	DescriptorManagementStrategy descriptor_management_strategy{DescriptorManagementStrategy::CacheSets};
+
+	BufferAllocationStrategy buffer_allocation_strategy{BufferAllocationStrategy::MultipleAllocationsPerBuffer};
+
+	/// Counters of every frame when it last began
+	std::unordered_map<const RenderFrame *, FrameCounters> frame_counters;
+
+	/// Requests of the frames measured in the window
+	FrameCounters window;
+
+	uint32_t window_frame_count{0};
+
+	/// Frames to begin before measuring again
+	uint32_t skipped_frame_count{0};
+
+	/// Whether the window measures the buffer allocation strategy being tried
+	bool trying_buffer_allocation_strategy{false};
+
+	/// Cost per frame of the buffer allocation strategy in use, negative until measured
+	double buffer_allocation_cost{-1.0};
+};
+}        // namespace vkb
@@ -0,0 +1,428 @@
+/* Copyright (c) 2020, Arm Limited and Contributors
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 the "License";
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "rendering/image_based_lighting.h"
+
+#include <algorithm>
+#include <cmath>
+#include <sstream>
+
+#include "common/helpers.h"
+#include "common/logging.h"
+#include "core/command_buffer.h"
+#include "core/device.h"
+#include "platform/filesystem.h"
+
+VKBP_DISABLE_WARNINGS()
+#include "common/glm_common.h"
+VKBP_ENABLE_WARNINGS()
+
+namespace vkb
+{
+namespace
+{
+/// Must be increased whenever the file layout or the baking shaders change
+constexpr uint32_t IBL_CACHE_VERSION = 1;
+
+const std::string IBL_CACHE_FOLDER = "ibl_cache/";
+
+/// Half float storage is supported for four channels by every device, so the lookup table uses them too
+constexpr VkFormat MAP_FORMAT = VK_FORMAT_R16G16B16A16_SFLOAT;
+
+constexpr VkDeviceSize MAP_TEXEL_SIZE = 8;
+
+/// Invocations of the baking shaders along each axis of a face
+constexpr uint32_t BAKE_GROUP_SIZE = 8;
+
+/// Angle between the directions sampled over the hemisphere of each irradiance texel, in radians
+constexpr float IRRADIANCE_SAMPLE_DELTA = 0.025f;
+
+struct IrradianceParameters
+{
+	float    environment_lod;
+	uint32_t size;
+};
+
+struct PrefilterParameters
+{
+	float    roughness;
+	float    environment_size;
+	uint32_t size;
+};
+
+inline std::string get_filename(size_t key)
+{
+	std::stringstream filename;
+	filename << IBL_CACHE_FOLDER << std::hex << key << ".bin";
+	return filename.str();
+}
+
+inline uint32_t get_group_count(uint32_t size)
+{
+	return (size + BAKE_GROUP_SIZE - 1) / BAKE_GROUP_SIZE;
+}
+}        // namespace
+
+constexpr uint32_t ImageBasedLighting::IRRADIANCE_SIZE;
+constexpr uint32_t ImageBasedLighting::PREFILTERED_SIZE;
+constexpr uint32_t ImageBasedLighting::PREFILTERED_MIP_COUNT;
+constexpr uint32_t ImageBasedLighting::BRDF_LUT_SIZE;
+
+ImageBasedLighting::ImageBasedLighting(Device &device, const core::ImageView &environment, const std::string &cache_key) :
+    device{device}
+{
+	irradiance_image = std::make_unique<core::Image>(device, VkExtent3D{IRRADIANCE_SIZE, IRRADIANCE_SIZE, 1}, MAP_FORMAT,
+	                                                 VK_IMAGE_USAGE_STORAGE_BIT | VK_IMAGE_USAGE_SAMPLED_BIT | VK_IMAGE_USAGE_TRANSFER_SRC_BIT | VK_IMAGE_USAGE_TRANSFER_DST_BIT,
+	                                                 VMA_MEMORY_USAGE_GPU_ONLY, VK_SAMPLE_COUNT_1_BIT, 1, 6, VK_IMAGE_TILING_OPTIMAL, VK_IMAGE_CREATE_CUBE_COMPATIBLE_BIT);
+
+	prefiltered_image = std::make_unique<core::Image>(device, VkExtent3D{PREFILTERED_SIZE, PREFILTERED_SIZE, 1}, MAP_FORMAT,
+	                                                  VK_IMAGE_USAGE_STORAGE_BIT | VK_IMAGE_USAGE_SAMPLED_BIT | VK_IMAGE_USAGE_TRANSFER_SRC_BIT | VK_IMAGE_USAGE_TRANSFER_DST_BIT,
+	                                                  VMA_MEMORY_USAGE_GPU_ONLY, VK_SAMPLE_COUNT_1_BIT, PREFILTERED_MIP_COUNT, 6, VK_IMAGE_TILING_OPTIMAL, VK_IMAGE_CREATE_CUBE_COMPATIBLE_BIT);
+
+	brdf_lut_image = std::make_unique<core::Image>(device, VkExtent3D{BRDF_LUT_SIZE, BRDF_LUT_SIZE, 1}, MAP_FORMAT,
+	                                               VK_IMAGE_USAGE_STORAGE_BIT | VK_IMAGE_USAGE_SAMPLED_BIT | VK_IMAGE_USAGE_TRANSFER_SRC_BIT | VK_IMAGE_USAGE_TRANSFER_DST_BIT,
+	                                               VMA_MEMORY_USAGE_GPU_ONLY);
+
+	irradiance_view  = &irradiance_image->request_view(VK_IMAGE_VIEW_TYPE_CUBE);
+	prefiltered_view = &prefiltered_image->request_view(VK_IMAGE_VIEW_TYPE_CUBE);
+	brdf_lut_view    = &brdf_lut_image->request_view(VK_IMAGE_VIEW_TYPE_2D);
+
+	VkSamplerCreateInfo sampler_info{VK_STRUCTURE_TYPE_SAMPLER_CREATE_INFO};
+	sampler_info.magFilter    = VK_FILTER_LINEAR;
+	sampler_info.minFilter    = VK_FILTER_LINEAR;
+	sampler_info.mipmapMode   = VK_SAMPLER_MIPMAP_MODE_LINEAR;
+	sampler_info.addressModeU = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+	sampler_info.addressModeV = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+	sampler_info.addressModeW = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+	sampler_info.maxLod       = VK_LOD_CLAMP_NONE;
+
+	sampler = std::make_unique<core::Sampler>(device, sampler_info);
+
+	// The key changes with the environment and with the layout of the maps
+	const auto &environment_image = environment.get_image();
+
+	size_t key{0U};
+	hash_combine(key, cache_key);
+	hash_combine(key, static_cast<std::underlying_type<VkFormat>::type>(environment_image.get_format()));
+	hash_combine(key, environment_image.get_extent().width);
+	hash_combine(key, IRRADIANCE_SIZE);
+	hash_combine(key, PREFILTERED_SIZE);
+	hash_combine(key, PREFILTERED_MIP_COUNT);
+	hash_combine(key, BRDF_LUT_SIZE);
+
+	if (!cache_key.empty())
+	{
+		std::vector<uint8_t> data;
+
+		try
+		{
+			data = fs::read_temp(get_filename(key));
+		}
+		catch (const std::runtime_error &)
+		{
+		}
+
+		if (!data.empty())
+		{
+			std::istringstream is{std::string{data.begin(), data.end()}};
+
+			uint32_t version{0};
+			size_t   stored_key{0};
+			read(is, version, stored_key);
+
+			auto header_size = static_cast<size_t>(is.tellg());
+
+			if (is && version == IBL_CACHE_VERSION && stored_key == key &&
+			    upload({data.begin() + header_size, data.end()}))
+			{
+				return;
+			}
+
+			LOGW("Discarding outdated image based lighting cache entry {}", get_filename(key));
+		}
+	}
+
+	std::unique_ptr<core::Buffer> readback;
+
+	if (!cache_key.empty())
+	{
+		VkDeviceSize size{0};
+		get_regions(*irradiance_image, size);
+		get_regions(*prefiltered_image, size);
+		get_regions(*brdf_lut_image, size);
+
+		readback = std::make_unique<core::Buffer>(device, size, VK_BUFFER_USAGE_TRANSFER_DST_BIT, VMA_MEMORY_USAGE_GPU_TO_CPU);
+	}
+
+	auto &command_buffer = device.request_command_buffer();
+
+	command_buffer.begin(VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT);
+
+	record_bake(command_buffer, environment, readback.get());
+
+	command_buffer.end();
+
+	auto &queue      = device.get_queue_by_role(QueueRole::Graphics);
+	auto &fence_pool = device.get_transient_fence_pool();
+
+	VkFence fence = fence_pool.request_fence();
+
+	VK_CHECK(queue.submit(command_buffer, fence));
+
+	VK_CHECK(fence_pool.wait(fence));
+
+	device.get_command_pool().reset_pool();
+
+	if (!readback)
+	{
+		return;
+	}
+
+	std::ostringstream os;
+	write(os, IBL_CACHE_VERSION, key);
+	os.write(reinterpret_cast<const char *>(readback->map()), readback->get_size());
+	readback->unmap();
+
+	std::string str = os.str();
+
+	try
+	{
+		auto temp_directory = fs::path::get(fs::path::Type::Temp);
+
+		if (!fs::is_directory(temp_directory + IBL_CACHE_FOLDER))
+		{
+			fs::create_path(temp_directory, IBL_CACHE_FOLDER);
+		}
+
+		fs::write_temp({str.begin(), str.end()}, get_filename(key));
+	}
+	catch (const std::runtime_error &ex)
+	{
+		LOGW("Failed to write image based lighting cache entry. {}", ex.what());
+	}
+}
+
+std::vector<std::string> ImageBasedLighting::get_shader_definitions()
+{
+	return {"IMAGE_BASED_LIGHTING",
+	        "IBL_PREFILTERED_MIP_COUNT " + std::to_string(PREFILTERED_MIP_COUNT)};
+}
+
+void ImageBasedLighting::bind(CommandBuffer &command_buffer, uint32_t first_binding)
+{
+	command_buffer.bind_image(*irradiance_view, *sampler, 0, first_binding, 0);
+	command_buffer.bind_image(*prefiltered_view, *sampler, 0, first_binding + 1, 0);
+	command_buffer.bind_image(*brdf_lut_view, *sampler, 0, first_binding + 2, 0);
+}
+
+const core::ImageView &ImageBasedLighting::get_irradiance_view() const
+{
+	return *irradiance_view;
+}
+
+const core::ImageView &ImageBasedLighting::get_prefiltered_view() const
+{
+	return *prefiltered_view;
+}
+
+const core::ImageView &ImageBasedLighting::get_brdf_lut_view() const
+{
+	return *brdf_lut_view;
+}
+
+void ImageBasedLighting::record_bake(CommandBuffer &command_buffer, const core::ImageView &environment, const core::Buffer *readback)
+{
+	const std::vector<core::ImageView *> views{irradiance_view, prefiltered_view, brdf_lut_view};
+
+	for (auto view : views)
+	{
+		ImageMemoryBarrier barrier{};
+		barrier.old_layout      = VK_IMAGE_LAYOUT_UNDEFINED;
+		barrier.new_layout      = VK_IMAGE_LAYOUT_GENERAL;
+		barrier.src_stage_mask  = VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT;
+		barrier.dst_stage_mask  = VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT;
+		barrier.dst_access_mask = VK_ACCESS_SHADER_WRITE_BIT;
+
+		command_buffer.image_memory_barrier(*view, barrier);
+	}
+
+	auto &resource_cache = device.get_resource_cache();
+
+	ShaderVariant variant;
+	variant.add_definitions({"GROUP_SIZE " + std::to_string(BAKE_GROUP_SIZE)});
+
+	float environment_size = static_cast<float>(environment.get_image().get_extent().width);
+
+	{
+		ShaderVariant irradiance_variant = variant;
+		irradiance_variant.add_definitions({"SAMPLE_DELTA " + std::to_string(IRRADIANCE_SAMPLE_DELTA)});
+
+		auto &shader_module = resource_cache.request_shader_module(VK_SHADER_STAGE_COMPUTE_BIT, ShaderSource{"ibl/irradiance.comp"}, irradiance_variant);
+		command_buffer.bind_pipeline_layout(resource_cache.request_pipeline_layout({&shader_module}));
+
+		// Samples a level whose texels are about as far apart as the sampled directions, which avoids aliasing
+		IrradianceParameters parameters{};
+		parameters.environment_lod = std::max(std::log2(environment_size * IRRADIANCE_SAMPLE_DELTA * 2.0f / glm::pi<float>()), 0.0f);
+		parameters.size            = IRRADIANCE_SIZE;
+
+		command_buffer.bind_image(environment, *sampler, 0, 0, 0);
+		command_buffer.bind_image(irradiance_image->request_view(VK_IMAGE_VIEW_TYPE_2D_ARRAY), 0, 1, 0);
+		command_buffer.push_constants(parameters);
+
+		command_buffer.dispatch(get_group_count(IRRADIANCE_SIZE), get_group_count(IRRADIANCE_SIZE), 6);
+	}
+
+	{
+		auto &shader_module = resource_cache.request_shader_module(VK_SHADER_STAGE_COMPUTE_BIT, ShaderSource{"ibl/prefilter.comp"}, variant);
+		command_buffer.bind_pipeline_layout(resource_cache.request_pipeline_layout({&shader_module}));
+
+		command_buffer.bind_image(environment, *sampler, 0, 0, 0);
+
+		for (uint32_t mip = 0; mip < PREFILTERED_MIP_COUNT; ++mip)
+		{
+			uint32_t size = std::max(PREFILTERED_SIZE >> mip, 1U);
+
+			PrefilterParameters parameters{};
+			parameters.roughness        = static_cast<float>(mip) / (PREFILTERED_MIP_COUNT - 1);
+			parameters.environment_size = environment_size;
+			parameters.size             = size;
+
+			command_buffer.bind_image(prefiltered_image->request_view(VK_IMAGE_VIEW_TYPE_2D_ARRAY, VK_FORMAT_UNDEFINED, 0, 6, mip, 1), 0, 1, 0);
+			command_buffer.push_constants(parameters);
+
+			command_buffer.dispatch(get_group_count(size), get_group_count(size), 6);
+		}
+	}
+
+	{
+		auto &shader_module = resource_cache.request_shader_module(VK_SHADER_STAGE_COMPUTE_BIT, ShaderSource{"ibl/brdf_lut.comp"}, variant);
+		command_buffer.bind_pipeline_layout(resource_cache.request_pipeline_layout({&shader_module}));
+
+		command_buffer.bind_image(*brdf_lut_view, 0, 0, 0);
+		command_buffer.push_constants(BRDF_LUT_SIZE);
+
+		command_buffer.dispatch(get_group_count(BRDF_LUT_SIZE), get_group_count(BRDF_LUT_SIZE), 1);
+	}
+
+	if (readback)
+	{
+		const std::vector<core::Image *> images{irradiance_image.get(), prefiltered_image.get(), brdf_lut_image.get()};
+
+		VkDeviceSize offset{0};
+
+		for (size_t i = 0; i < views.size(); ++i)
+		{
+			ImageMemoryBarrier barrier{};
+			barrier.old_layout      = VK_IMAGE_LAYOUT_GENERAL;
+			barrier.new_layout      = VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL;
+			barrier.src_stage_mask  = VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT;
+			barrier.dst_stage_mask  = VK_PIPELINE_STAGE_TRANSFER_BIT;
+			barrier.src_access_mask = VK_ACCESS_SHADER_WRITE_BIT;
+			barrier.dst_access_mask = VK_ACCESS_TRANSFER_READ_BIT;
+
+			command_buffer.image_memory_barrier(*views[i], barrier);
+
+			command_buffer.copy_image_to_buffer(*images[i], *readback, get_regions(*images[i], offset));
+		}
+
+		BufferMemoryBarrier buffer_barrier{};
+		buffer_barrier.src_access_mask = VK_ACCESS_TRANSFER_WRITE_BIT;
+		buffer_barrier.dst_access_mask = VK_ACCESS_HOST_READ_BIT;
+		buffer_barrier.src_stage_mask  = VK_PIPELINE_STAGE_TRANSFER_BIT;
+		buffer_barrier.dst_stage_mask  = VK_PIPELINE_STAGE_HOST_BIT;
+
+		command_buffer.buffer_memory_barrier(*readback, 0, readback->get_size(), buffer_barrier);
+	}
+
+	for (auto view : views)
+	{
+		ImageMemoryBarrier barrier{};
+		barrier.old_layout      = readback ? VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL : VK_IMAGE_LAYOUT_GENERAL;
+		barrier.new_layout      = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+		barrier.src_stage_mask  = readback ? VK_PIPELINE_STAGE_TRANSFER_BIT : VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT;
+		barrier.dst_stage_mask  = VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT;
+		barrier.src_access_mask = readback ? 0 : VK_ACCESS_SHADER_WRITE_BIT;
+		barrier.dst_access_mask = VK_ACCESS_SHADER_READ_BIT;
+
+		command_buffer.image_memory_barrier(*view, barrier);
+	}
+}
+
+bool ImageBasedLighting::upload(const std::vector<uint8_t> &data)
+{
+	const std::vector<std::pair<core::Image *, core::ImageView *>> maps{{irradiance_image.get(), irradiance_view},
+	                                                                    {prefiltered_image.get(), prefiltered_view},
+	                                                                    {brdf_lut_image.get(), brdf_lut_view}};
+
+	VkDeviceSize total_size{0};
+	for (auto &map : maps)
+	{
+		get_regions(*map.first, total_size);
+	}
+
+	if (data.size() != total_size)
+	{
+		return false;
+	}
+
+	auto &staging_manager = device.get_staging_manager();
+
+	VkDeviceSize base{0};
+
+	for (auto &map : maps)
+	{
+		// Regions are relative to the data of the map
+		VkDeviceSize size{0};
+		auto         regions = get_regions(*map.first, size);
+
+		staging_manager.copy_to_image(data.data() + base, size, *map.first, regions, map.second->get_subresource_range());
+
+		base += size;
+	}
+
+	// Work submitted to the graphics queue after the flush sees the uploads
+	staging_manager.flush();
+
+	return true;
+}
+
+std::vector<VkBufferImageCopy> ImageBasedLighting::get_regions(const core::Image &image, VkDeviceSize &offset)
+{
+	const auto &extent = image.get_extent();
+
+	std::vector<VkBufferImageCopy> regions;
+
+	for (uint32_t mip = 0; mip < image.get_subresource().mipLevel; ++mip)
+	{
+		VkExtent3D mip_extent{std::max(extent.width >> mip, 1U), std::max(extent.height >> mip, 1U), 1};
+
+		VkBufferImageCopy region{};
+		region.bufferOffset                    = offset;
+		region.imageSubresource.aspectMask     = VK_IMAGE_ASPECT_COLOR_BIT;
+		region.imageSubresource.mipLevel       = mip;
+		region.imageSubresource.baseArrayLayer = 0;
+		region.imageSubresource.layerCount     = image.get_array_layer_count();
+		region.imageExtent                     = mip_extent;
+
+		regions.push_back(region);
+
+		offset += mip_extent.width * mip_extent.height * image.get_array_layer_count() * MAP_TEXEL_SIZE;
+	}
+
+	return regions;
+}
+}        // namespace vkb
@@ -0,0 +1,138 @@
+/* Copyright (c) 2020, Arm Limited and Contributors
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 the "License";
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "core/buffer.h"
+#include "core/image.h"
+#include "core/image_view.h"
+#include "core/sampler.h"
+#include "core/shader_module.h"
+
+namespace vkb
+{
+class CommandBuffer;
+class Device;
+
+/**
+ * @brief Prefilters an environment cube map for the image based lighting of PBR materials
+ *
+ * Bakes a diffuse irradiance cube map, a specular cube map whose mip levels are prefiltered for
+ * increasing roughness, and the BRDF lookup table of the split sum approximation. Baking runs in
+ * compute shaders when the lighting is constructed, and waits for the GPU, so it belongs to load time.
+ *
+ * With a cache key, the baked maps are read back and stored in a folder of the temporary directory,
+ * and later runs upload them instead of baking them again.
+ * Shaders built with get_shader_definitions sample the irradiance map, the prefiltered map and the
+ * lookup table from three consecutive bindings.
+ */
+class ImageBasedLighting
+{
+  public:
+	/**
+	 * @brief Bakes the maps of an environment, or loads them from the cache
+	 * @param device Device to bake the maps with
+	 * @param environment Cube view of the environment, in the shader read only layout
+	 * @param cache_key Identifies the environment in the cache, like the path of its file, empty to always bake the maps
+	 */
+	ImageBasedLighting(Device &device, const core::ImageView &environment, const std::string &cache_key = "");
+
+	ImageBasedLighting(const ImageBasedLighting &) = delete;
+
+	ImageBasedLighting(ImageBasedLighting &&) = delete;
+
+	ImageBasedLighting &operator=(const ImageBasedLighting &) = delete;
+
+	ImageBasedLighting &operator=(ImageBasedLighting &&) = delete;
+
+	/**
+	 * @return Definitions of the maps for the shaders sampling them
+	 */
+	static std::vector<std::string> get_shader_definitions();
+
+	/**
+	 * @brief Binds the maps for the shaders sampling them
+	 * @param first_binding Binding of the irradiance map, followed by the prefiltered map and the lookup table
+	 */
+	void bind(CommandBuffer &command_buffer, uint32_t first_binding);
+
+	const core::ImageView &get_irradiance_view() const;
+
+	const core::ImageView &get_prefiltered_view() const;
+
+	const core::ImageView &get_brdf_lut_view() const;
+
+	/**
+	 * @brief Extent of the faces of the irradiance map
+	 */
+	static constexpr uint32_t IRRADIANCE_SIZE = 32;
+
+	/**
+	 * @brief Extent of the faces of the first level of the prefiltered map
+	 */
+	static constexpr uint32_t PREFILTERED_SIZE = 128;
+
+	/**
+	 * @brief Levels of the prefiltered map, from a roughness of 0 for the first one to 1 for the last one
+	 */
+	static constexpr uint32_t PREFILTERED_MIP_COUNT = 6;
+
+	/**
+	 * @brief Extent of the BRDF lookup table, indexed by the cosine of the view angle and the roughness
+	 */
+	static constexpr uint32_t BRDF_LUT_SIZE = 256;
+
+  private:
+	Device &device;
+
+	std::unique_ptr<core::Image> irradiance_image;
+
+	std::unique_ptr<core::Image> prefiltered_image;
+
+	std::unique_ptr<core::Image> brdf_lut_image;
+
+	core::ImageView *irradiance_view{nullptr};
+
+	core::ImageView *prefiltered_view{nullptr};
+
+	core::ImageView *brdf_lut_view{nullptr};
+
+	/// Linear sampler clamping to the edges, for the environment and the baked maps
+	std::unique_ptr<core::Sampler> sampler;
+
+	/**
+	 * @brief Records the compute passes baking the maps, and the copy of the maps to the readback buffer if there is one
+	 */
+	void record_bake(CommandBuffer &command_buffer, const core::ImageView &environment, const core::Buffer *readback);
+
+	/**
+	 * @brief Uploads baked maps read from the cache
+	 * @return False if the cached data does not match the maps
+	 */
+	bool upload(const std::vector<uint8_t> &data);
+
+	/**
+	 * @brief Gets the copy regions of all the levels of a map, tightly packed one after the other
+	 * @param offset Buffer offset of the first region, advanced past the last one
+	 */
+	static std::vector<VkBufferImageCopy> get_regions(const core::Image &image, VkDeviceSize &offset);
+};
+}        // namespace vkb
@@ -0,0 +1,278 @@
+/* Copyright (c) 2020, Arm Limited and Contributors
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 the "License";
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "rendering/light_clustering.h"
+
+#include <algorithm>
+#include <cmath>
+
+#include "core/command_buffer.h"
+#include "rendering/render_context.h"
+#include "rendering/subpass.h"
+#include "stats/gpu_profiler.h"
+#include "scene_graph/components/camera.h"
+#include "scene_graph/components/light.h"
+#include "scene_graph/components/perspective_camera.h"
+#include "scene_graph/node.h"
+
+namespace vkb
+{
+namespace
+{
+/// Invocations of light_clustering.comp, one per cluster
+constexpr uint32_t CLUSTER_GROUP_SIZE = 64;
+
+constexpr uint32_t CLUSTER_COUNT = LIGHT_CLUSTER_COUNT_X * LIGHT_CLUSTER_COUNT_Y * LIGHT_CLUSTER_COUNT_Z;
+}        // namespace
+
+LightClustering::LightClustering(RenderContext &render_context, sg::Camera &camera) :
+    render_context{render_context},
+    camera{camera}
+{
+}
+
+bool LightClustering::is_supported(sg::Camera &camera)
+{
+	return dynamic_cast<sg::PerspectiveCamera *>(&camera) != nullptr;
+}
+
+std::vector<std::string> LightClustering::get_shader_definitions()
+{
+	return {"CLUSTERED_LIGHTING",
+	        "LIGHT_CLUSTER_COUNT_X " + std::to_string(LIGHT_CLUSTER_COUNT_X),
+	        "LIGHT_CLUSTER_COUNT_Y " + std::to_string(LIGHT_CLUSTER_COUNT_Y),
+	        "LIGHT_CLUSTER_COUNT_Z " + std::to_string(LIGHT_CLUSTER_COUNT_Z),
+	        "MAX_LIGHTS_PER_CLUSTER " + std::to_string(MAX_LIGHTS_PER_CLUSTER)};
+}
+
+void LightClustering::set_async_compute(bool enable)
+{
+	async_compute = enable;
+}
+
+bool LightClustering::is_async_compute() const
+{
+	return async_compute && render_context.has_async_compute();
+}
+
+void LightClustering::prepare()
+{
+	cluster_light_counts.clear();
+	cluster_light_indices.clear();
+	shared_lights.clear();
+	shared_cluster_uniforms.clear();
+
+	clustering_variant = {};
+	clustering_variant.add_definitions(get_shader_definitions());
+	clustering_variant.add_definitions({"CLUSTER_GROUP_SIZE " + std::to_string(CLUSTER_GROUP_SIZE)});
+
+	clustering_shader = ShaderSource{"deferred/light_clustering.comp"};
+
+	auto &device = render_context.get_device();
+
+	device.get_resource_cache().request_shader_module(VK_SHADER_STAGE_COMPUTE_BIT, clustering_shader, clustering_variant);
+
+	// Clusters written by the compute queue are read by the graphics one
+	std::vector<uint32_t> queue_families;
+
+	if (is_async_compute())
+	{
+		queue_families = {device.get_queue_by_role(QueueRole::Graphics).get_family_index(),
+		                  render_context.get_compute_queue().get_family_index()};
+	}
+
+	for (size_t i = 0; i < render_context.get_render_frames().size(); ++i)
+	{
+		cluster_light_counts.push_back(std::make_unique<core::Buffer>(device, CLUSTER_COUNT * sizeof(uint32_t),
+		                                                              VK_BUFFER_USAGE_STORAGE_BUFFER_BIT,
+		                                                              VMA_MEMORY_USAGE_GPU_ONLY, 0, queue_families));
+		cluster_light_indices.push_back(std::make_unique<core::Buffer>(device, CLUSTER_COUNT * MAX_LIGHTS_PER_CLUSTER * sizeof(uint32_t),
+		                                                               VK_BUFFER_USAGE_STORAGE_BUFFER_BIT,
+		                                                               VMA_MEMORY_USAGE_GPU_ONLY, 0, queue_families));
+	}
+
+	if (is_async_compute())
+	{
+		shared_lights.resize(render_context.get_render_frames().size());
+		shared_cluster_uniforms.resize(render_context.get_render_frames().size());
+	}
+}
+
+void LightClustering::update_shared_buffers(const std::vector<Light> &lights, const ClusterUniform &cluster_uniform)
+{
+	auto &device      = render_context.get_device();
+	auto  frame_index = render_context.get_active_frame_index();
+
+	std::vector<uint32_t> queue_families{device.get_queue_by_role(QueueRole::Graphics).get_family_index(),
+	                                     render_context.get_compute_queue().get_family_index()};
+
+	auto &light_buffer   = shared_lights[frame_index];
+	auto &uniform_buffer = shared_cluster_uniforms[frame_index];
+
+	// The buffers of a frame are no longer read once it waited for its previous submission
+	if (!light_buffer || light_buffer->get_size() < lights.size() * sizeof(Light))
+	{
+		light_buffer = std::make_unique<core::Buffer>(device, lights.size() * sizeof(Light), VK_BUFFER_USAGE_STORAGE_BUFFER_BIT,
+		                                              VMA_MEMORY_USAGE_CPU_TO_GPU, VMA_ALLOCATION_CREATE_MAPPED_BIT, queue_families);
+	}
+
+	if (!uniform_buffer)
+	{
+		uniform_buffer = std::make_unique<core::Buffer>(device, sizeof(ClusterUniform), VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT,
+		                                                VMA_MEMORY_USAGE_CPU_TO_GPU, VMA_ALLOCATION_CREATE_MAPPED_BIT, queue_families);
+	}
+
+	light_buffer->update(reinterpret_cast<const uint8_t *>(lights.data()), lights.size() * sizeof(Light));
+	uniform_buffer->convert_and_update(cluster_uniform);
+
+	light_allocation           = BufferAllocation{*light_buffer, lights.size() * sizeof(Light), 0};
+	cluster_uniform_allocation = BufferAllocation{*uniform_buffer, sizeof(ClusterUniform), 0};
+}
+
+void LightClustering::record(CommandBuffer &command_buffer, const sg::ComponentSpan<sg::Light> &scene_lights, const VkExtent2D &extent)
+{
+	assert(!cluster_light_counts.empty() && "Light clustering is not prepared");
+
+	std::vector<sg::Light *> sorted_lights = scene_lights.to_vector();
+
+	// Directional lights reach every cluster, so they are not binned
+	auto directional_end = std::stable_partition(sorted_lights.begin(), sorted_lights.end(), [](sg::Light *light) {
+		return light->get_light_type() == sg::LightType::Directional;
+	});
+
+	std::vector<Light> lights;
+	lights.reserve(std::max<size_t>(sorted_lights.size(), 1));
+
+	for (auto light : sorted_lights)
+	{
+		const auto &properties = light->get_properties();
+		auto &      transform  = light->get_node()->get_transform();
+
+		lights.push_back({{transform.get_translation(), static_cast<float>(light->get_light_type())},
+		                  {properties.color, properties.intensity},
+		                  {transform.get_rotation() * properties.direction, properties.range},
+		                  {properties.inner_cone_angle, properties.outer_cone_angle}});
+	}
+
+	// Storage buffers cannot be empty
+	if (lights.empty())
+	{
+		lights.emplace_back();
+	}
+
+	auto &perspective_camera = static_cast<sg::PerspectiveCamera &>(camera);
+
+	// The camera projects the far plane to depth 0
+	float near_plane = std::min(perspective_camera.get_near_plane(), perspective_camera.get_far_plane());
+	float far_plane  = std::max(perspective_camera.get_near_plane(), perspective_camera.get_far_plane());
+
+	// Tiles are in framebuffer space, which the pre-rotation maps the projection to
+	ClusterUniform cluster_uniform;
+	cluster_uniform.view           = camera.get_view();
+	cluster_uniform.inv_projection = glm::inverse(camera.get_pre_rotation() * vulkan_style_projection(camera.get_projection()));
+	cluster_uniform.depth_range    = {near_plane, far_plane, LIGHT_CLUSTER_COUNT_Z / std::log(far_plane / near_plane), 0.0f};
+	cluster_uniform.counts         = {to_u32(sorted_lights.size()), to_u32(std::distance(sorted_lights.begin(), directional_end)), 0, 0};
+	cluster_uniform.inv_resolution = {1.0f / extent.width, 1.0f / extent.height};
+
+	auto  frame_index   = render_context.get_active_frame_index();
+	auto &light_counts  = *cluster_light_counts[frame_index];
+	auto &light_indices = *cluster_light_indices[frame_index];
+
+	if (is_async_compute())
+	{
+		update_shared_buffers(lights, cluster_uniform);
+
+		auto &compute_command_buffer = render_context.request_compute_command_buffer();
+		compute_command_buffer.begin(VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT);
+
+		{
+			GpuProfiler::Scope scope{render_context.get_gpu_profiler(), compute_command_buffer, "Light clustering"};
+
+			dispatch(compute_command_buffer);
+		}
+
+		compute_command_buffer.end();
+
+		// The frame fence ordered the previous reads of the clusters, and the semaphore orders the next ones
+		render_context.submit_compute(compute_command_buffer, VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT);
+		return;
+	}
+
+	auto &render_frame = render_context.get_active_frame();
+
+	light_allocation = render_frame.allocate_buffer(VK_BUFFER_USAGE_STORAGE_BUFFER_BIT, lights.size() * sizeof(Light));
+	light_allocation.update(reinterpret_cast<const uint8_t *>(lights.data()), lights.size() * sizeof(Light));
+
+	cluster_uniform_allocation = render_frame.allocate_buffer(VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT, sizeof(ClusterUniform));
+	cluster_uniform_allocation.update(cluster_uniform);
+
+	{
+		// The clusters of this frame may still be read by the previous use of the frame
+		BufferMemoryBarrier barrier{};
+		barrier.src_stage_mask  = VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT;
+		barrier.dst_stage_mask  = VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT;
+		barrier.src_access_mask = 0;
+		barrier.dst_access_mask = VK_ACCESS_SHADER_WRITE_BIT;
+
+		command_buffer.buffer_memory_barrier(light_counts, 0, VK_WHOLE_SIZE, barrier);
+		command_buffer.buffer_memory_barrier(light_indices, 0, VK_WHOLE_SIZE, barrier);
+	}
+
+	dispatch(command_buffer);
+
+	BufferMemoryBarrier barrier{};
+	barrier.src_stage_mask  = VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT;
+	barrier.dst_stage_mask  = VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT;
+	barrier.src_access_mask = VK_ACCESS_SHADER_WRITE_BIT;
+	barrier.dst_access_mask = VK_ACCESS_SHADER_READ_BIT;
+
+	command_buffer.buffer_memory_barrier(light_counts, 0, VK_WHOLE_SIZE, barrier);
+	command_buffer.buffer_memory_barrier(light_indices, 0, VK_WHOLE_SIZE, barrier);
+}
+
+void LightClustering::dispatch(CommandBuffer &command_buffer)
+{
+	auto  frame_index   = render_context.get_active_frame_index();
+	auto &light_counts  = *cluster_light_counts[frame_index];
+	auto &light_indices = *cluster_light_indices[frame_index];
+
+	auto &resource_cache  = render_context.get_device().get_resource_cache();
+	auto &shader_module   = resource_cache.request_shader_module(VK_SHADER_STAGE_COMPUTE_BIT, clustering_shader, clustering_variant);
+	auto &pipeline_layout = resource_cache.request_pipeline_layout({&shader_module});
+
+	command_buffer.bind_pipeline_layout(pipeline_layout);
+
+	command_buffer.bind_buffer(light_allocation.get_buffer(), light_allocation.get_offset(), light_allocation.get_size(), 0, 0, 0);
+	command_buffer.bind_buffer(light_counts, 0, light_counts.get_size(), 0, 1, 0);
+	command_buffer.bind_buffer(light_indices, 0, light_indices.get_size(), 0, 2, 0);
+	command_buffer.bind_buffer(cluster_uniform_allocation.get_buffer(), cluster_uniform_allocation.get_offset(), cluster_uniform_allocation.get_size(), 0, 3, 0);
+
+	command_buffer.dispatch((CLUSTER_COUNT + CLUSTER_GROUP_SIZE - 1) / CLUSTER_GROUP_SIZE, 1, 1);
+}
+
+void LightClustering::bind(CommandBuffer &command_buffer, uint32_t first_binding)
+{
+	auto  frame_index   = render_context.get_active_frame_index();
+	auto &light_counts  = *cluster_light_counts[frame_index];
+	auto &light_indices = *cluster_light_indices[frame_index];
+
+	command_buffer.bind_buffer(light_allocation.get_buffer(), light_allocation.get_offset(), light_allocation.get_size(), 0, first_binding, 0);
+	command_buffer.bind_buffer(light_counts, 0, light_counts.get_size(), 0, first_binding + 1, 0);
+	command_buffer.bind_buffer(light_indices, 0, light_indices.get_size(), 0, first_binding + 2, 0);
+	command_buffer.bind_buffer(cluster_uniform_allocation.get_buffer(), cluster_uniform_allocation.get_offset(), cluster_uniform_allocation.get_size(), 0, first_binding + 3, 0);
+}
+}        // namespace vkb
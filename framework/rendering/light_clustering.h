@@ -0,0 +1,162 @@
+/* Copyright (c) 2020, Arm Limited and Contributors
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 the "License";
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include "buffer_pool.h"
+#include "core/buffer.h"
+#include "core/shader_module.h"
+#include "scene_graph/component_span.h"
+
+VKBP_DISABLE_WARNINGS()
+#include "common/glm_common.h"
+VKBP_ENABLE_WARNINGS()
+
+// Screen tiles and depth slices of the light clusters
+#define LIGHT_CLUSTER_COUNT_X 16
+#define LIGHT_CLUSTER_COUNT_Y 9
+#define LIGHT_CLUSTER_COUNT_Z 24
+
+#define MAX_LIGHTS_PER_CLUSTER 128
+
+namespace vkb
+{
+class CommandBuffer;
+class RenderContext;
+struct Light;
+
+namespace sg
+{
+class Camera;
+class Light;
+}        // namespace sg
+
+/**
+ * @brief Cluster uniform structure for the light clustering shader and the shaders reading the clusters
+ */
+struct alignas(16) ClusterUniform
+{
+	glm::mat4  view;
+	glm::mat4  inv_projection;
+	glm::vec4  depth_range;           // x is the near plane, y the far plane, z the number of slices over log(far / near)
+	glm::uvec4 counts;                // x is the number of lights, y the number of directional lights
+	glm::vec2  inv_resolution;        // Maps fragment coordinates to screen tiles
+};
+
+/**
+ * @brief Bins the lights of a scene into clusters of screen tiles and depth slices with a compute pass,
+ *        so that shaders only loop over the lights which can reach the cluster of a pixel.
+ * Lights are sorted with the directional ones first, which reach every cluster and are not binned.
+ * Shaders built with get_shader_definitions read the lights, the light count and indices of clusters,
+ * and the cluster uniform from four consecutive bindings.
+ * With async compute, the clustering pass is submitted to the compute queue of the render context, so that it
+ * overlaps with the graphics work recorded before the fragment shaders reading the clusters. Its buffers are then
+ * shared by the two queue families, which avoids ownership transfers.
+ */
+class LightClustering
+{
+  public:
+	LightClustering(RenderContext &render_context, sg::Camera &camera);
+
+	LightClustering(const LightClustering &) = delete;
+
+	LightClustering(LightClustering &&) = default;
+
+	LightClustering &operator=(const LightClustering &) = delete;
+
+	LightClustering &operator=(LightClustering &&) = delete;
+
+	/**
+	 * @return Whether the lights can be clustered for the camera, which needs to be a perspective one
+	 */
+	static bool is_supported(sg::Camera &camera);
+
+	/**
+	 * @return Definitions of the cluster grid for the shaders reading the clusters
+	 */
+	static std::vector<std::string> get_shader_definitions();
+
+	/**
+	 * @brief Sets whether the clustering pass runs on the async compute queue, when the render context has one
+	 *        Needs to be called before prepare
+	 */
+	void set_async_compute(bool enable);
+
+	/**
+	 * @return Whether the clustering pass is submitted to the async compute queue
+	 */
+	bool is_async_compute() const;
+
+	/**
+	 * @brief Creates the cluster buffers of each render frame and builds the clustering shader
+	 */
+	void prepare();
+
+	/**
+	 * @brief Uploads the lights of the frame and records the clustering pass, outside of a render pass
+	 * @param command_buffer Command buffer to record the compute dispatch to, unused with async compute,
+	 *        as the pass is then submitted to the compute queue before returning
+	 * @param scene_lights Lights of the scene
+	 * @param extent Extent of the render target the clusters are read with
+	 */
+	void record(CommandBuffer &command_buffer, const sg::ComponentSpan<sg::Light> &scene_lights, const VkExtent2D &extent);
+
+	/**
+	 * @brief Binds the clusters of the frame for the shaders reading them
+	 * @param first_binding Binding of the lights, followed by the light counts, the light indices and the cluster uniform
+	 */
+	void bind(CommandBuffer &command_buffer, uint32_t first_binding);
+
+  private:
+	/**
+	 * @brief Copies the lights and the cluster uniform of the active frame to buffers shared with the compute queue
+	 */
+	void update_shared_buffers(const std::vector<Light> &lights, const ClusterUniform &cluster_uniform);
+
+	/**
+	 * @brief Binds the buffers of the active frame and dispatches the clustering shader
+	 */
+	void dispatch(CommandBuffer &command_buffer);
+
+	RenderContext &render_context;
+
+	sg::Camera &camera;
+
+	bool async_compute{false};
+
+	ShaderSource clustering_shader;
+
+	ShaderVariant clustering_variant;
+
+	/// Lights of the frame, sorted with directional lights first
+	BufferAllocation light_allocation;
+
+	BufferAllocation cluster_uniform_allocation;
+
+	/// Number of lights in each cluster, per render frame
+	std::vector<std::unique_ptr<core::Buffer>> cluster_light_counts;
+
+	/// MAX_LIGHTS_PER_CLUSTER light indices for each cluster, per render frame
+	std::vector<std::unique_ptr<core::Buffer>> cluster_light_indices;
+
+	/// Lights of each render frame shared with the compute queue, grown to the number of lights
+	std::vector<std::unique_ptr<core::Buffer>> shared_lights;
+
+	/// Cluster uniform of each render frame shared with the compute queue
+	std::vector<std::unique_ptr<core::Buffer>> shared_cluster_uniforms;
+};
+}        // namespace vkb
@@ -0,0 +1,224 @@
+/* Copyright (c) 2020, Arm Limited and Contributors
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 the "License";
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "rendering/multisample_resolve.h"
+
+#include <algorithm>
+
+#include "common/logging.h"
+#include "common/utils.h"
+#include "core/command_buffer.h"
+#include "core/device.h"
+#include "rendering/render_pipeline.h"
+
+namespace vkb
+{
+MultisampleResolve::MultisampleResolve(Device &device, const MultisampleInfo &info_) :
+    info{info_}
+{
+	auto &limits = device.get_gpu().get_properties().limits;
+
+	VkSampleCountFlags supported_counts = limits.framebufferColorSampleCounts & limits.framebufferDepthSampleCounts;
+
+	// Keep the highest bit of a count which is not a power of two
+	while (info.sample_count & (info.sample_count - 1))
+	{
+		info.sample_count = static_cast<VkSampleCountFlagBits>(info.sample_count & (info.sample_count - 1));
+	}
+
+	while (info.sample_count > VK_SAMPLE_COUNT_1_BIT && !(supported_counts & info.sample_count))
+	{
+		info.sample_count = static_cast<VkSampleCountFlagBits>(info.sample_count >> 1);
+	}
+
+	if (info.sample_count != info_.sample_count)
+	{
+		LOGW("{} samples per pixel are not supported, falling back to {}", to_u32(info_.sample_count), to_u32(info.sample_count));
+	}
+
+	if (info.depth_resolve_mode != VK_RESOLVE_MODE_NONE && !device.is_enabled(VK_KHR_DEPTH_STENCIL_RESOLVE_EXTENSION_NAME))
+	{
+		LOGW("Depth can't be resolved without {}", VK_KHR_DEPTH_STENCIL_RESOLVE_EXTENSION_NAME);
+		info.depth_resolve_mode = VK_RESOLVE_MODE_NONE;
+	}
+}
+
+const MultisampleInfo &MultisampleResolve::get_info() const
+{
+	return info;
+}
+
+RenderTarget::CreateFunc MultisampleResolve::get_create_func() const
+{
+	auto info = this->info;
+
+	return [info](core::Image &&color_image) -> std::unique_ptr<RenderTarget> {
+		auto &device = color_image.get_device();
+		auto  extent = color_image.get_extent();
+
+		VkFormat depth_format = get_suitable_depth_format(device.get_gpu().get_handle());
+
+		// Transient images can live in lazily allocated memory, only the resolved images take memory
+		core::Image depth_image{device, extent, depth_format,
+		                        VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT | VK_IMAGE_USAGE_TRANSIENT_ATTACHMENT_BIT,
+		                        VMA_MEMORY_USAGE_GPU_ONLY, info.sample_count};
+
+		VkImageUsageFlags color_usage = VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT;
+		if (info.color_resolve_mode == ColorResolveMode::Subpass)
+		{
+			color_usage |= VK_IMAGE_USAGE_TRANSIENT_ATTACHMENT_BIT;
+		}
+		else
+		{
+			color_usage |= VK_IMAGE_USAGE_TRANSFER_SRC_BIT;
+		}
+
+		core::Image multisampled_color_image{device, extent, color_image.get_format(), color_usage, VMA_MEMORY_USAGE_GPU_ONLY, info.sample_count};
+
+		std::vector<core::Image> images;
+		images.push_back(std::move(color_image));
+		images.push_back(std::move(depth_image));
+		images.push_back(std::move(multisampled_color_image));
+
+		if (info.depth_resolve_mode != VK_RESOLVE_MODE_NONE)
+		{
+			images.emplace_back(device, extent, depth_format,
+			                    VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT | VK_IMAGE_USAGE_SAMPLED_BIT,
+			                    VMA_MEMORY_USAGE_GPU_ONLY);
+		}
+
+		return std::make_unique<RenderTarget>(std::move(images));
+	};
+}
+
+void MultisampleResolve::apply(RenderPipeline &render_pipeline) const
+{
+	auto &subpasses = render_pipeline.get_subpasses();
+	assert(!subpasses.empty() && "Render pipeline should contain at least one sub-pass");
+
+	for (auto &subpass : subpasses)
+	{
+		auto output_attachments = subpass->get_output_attachments();
+		std::replace(output_attachments.begin(), output_attachments.end(), 0u, 2u);
+
+		subpass->set_output_attachments(output_attachments);
+		subpass->set_sample_count(info.sample_count);
+		subpass->set_color_resolve_attachments({});
+		subpass->set_depth_stencil_resolve_attachment(VK_ATTACHMENT_UNUSED);
+		subpass->set_depth_stencil_resolve_mode(VK_RESOLVE_MODE_NONE);
+	}
+
+	// Resolving in the last subpass lets the earlier ones read the multisampled attachments
+	auto &last_subpass = subpasses.back();
+
+	std::vector<LoadStoreInfo> load_store(info.depth_resolve_mode != VK_RESOLVE_MODE_NONE ? 4 : 3);
+
+	// Multisampled depth is never stored, it can't be resolved after the render pass
+	load_store[1] = {VK_ATTACHMENT_LOAD_OP_CLEAR, VK_ATTACHMENT_STORE_OP_DONT_CARE};
+
+	if (info.color_resolve_mode == ColorResolveMode::Subpass)
+	{
+		// Every pixel of the resolved color is written on writeback, it needs not be loaded
+		last_subpass->set_color_resolve_attachments({0});
+		load_store[0] = {VK_ATTACHMENT_LOAD_OP_DONT_CARE, VK_ATTACHMENT_STORE_OP_STORE};
+		load_store[2] = {VK_ATTACHMENT_LOAD_OP_CLEAR, VK_ATTACHMENT_STORE_OP_DONT_CARE};
+	}
+	else
+	{
+		// All the samples are written to memory, to be read back by the resolve
+		load_store[0] = {VK_ATTACHMENT_LOAD_OP_DONT_CARE, VK_ATTACHMENT_STORE_OP_DONT_CARE};
+		load_store[2] = {VK_ATTACHMENT_LOAD_OP_CLEAR, VK_ATTACHMENT_STORE_OP_STORE};
+	}
+
+	if (info.depth_resolve_mode != VK_RESOLVE_MODE_NONE)
+	{
+		last_subpass->set_depth_stencil_resolve_attachment(3);
+		last_subpass->set_depth_stencil_resolve_mode(info.depth_resolve_mode);
+		load_store[3] = {VK_ATTACHMENT_LOAD_OP_DONT_CARE, VK_ATTACHMENT_STORE_OP_STORE};
+	}
+
+	render_pipeline.set_load_store(load_store);
+
+	// The multisampled attachments are cleared to the values of the ones they replace
+	auto clear_value = render_pipeline.get_clear_value();
+	clear_value.resize(load_store.size());
+	clear_value[2] = clear_value[0];
+	if (clear_value.size() > 3)
+	{
+		clear_value[3] = clear_value[1];
+	}
+	render_pipeline.set_clear_value(clear_value);
+}
+
+void MultisampleResolve::resolve(CommandBuffer &command_buffer, RenderTarget &render_target) const
+{
+	if (info.color_resolve_mode != ColorResolveMode::Separate)
+	{
+		return;
+	}
+
+	auto &views = render_target.get_views();
+
+	{
+		ImageMemoryBarrier memory_barrier{};
+		memory_barrier.old_layout      = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
+		memory_barrier.new_layout      = VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL;
+		memory_barrier.src_access_mask = VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT;
+		memory_barrier.dst_access_mask = VK_ACCESS_TRANSFER_READ_BIT;
+		memory_barrier.src_stage_mask  = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT;
+		memory_barrier.dst_stage_mask  = VK_PIPELINE_STAGE_TRANSFER_BIT;
+
+		command_buffer.image_memory_barrier(views.at(2), memory_barrier);
+
+		// The render pass did not touch the resolved image
+		memory_barrier.old_layout      = VK_IMAGE_LAYOUT_UNDEFINED;
+		memory_barrier.new_layout      = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+		memory_barrier.src_access_mask = 0;
+		memory_barrier.dst_access_mask = VK_ACCESS_TRANSFER_WRITE_BIT;
+
+		command_buffer.image_memory_barrier(views.at(0), memory_barrier);
+	}
+
+	VkImageSubresourceLayers subresource{};
+	subresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+	subresource.layerCount = 1;
+
+	VkImageResolve image_resolve{};
+	image_resolve.srcSubresource = subresource;
+	image_resolve.dstSubresource = subresource;
+	image_resolve.extent         = {render_target.get_render_area().width, render_target.get_render_area().height, 1};
+
+	command_buffer.resolve_image(views.at(2).get_image(), views.at(0).get_image(), {image_resolve});
+
+	{
+		ImageMemoryBarrier memory_barrier{};
+		memory_barrier.old_layout      = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+		memory_barrier.new_layout      = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
+		memory_barrier.src_access_mask = VK_ACCESS_TRANSFER_WRITE_BIT;
+		memory_barrier.dst_access_mask = VK_ACCESS_COLOR_ATTACHMENT_READ_BIT | VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT;
+		memory_barrier.src_stage_mask  = VK_PIPELINE_STAGE_TRANSFER_BIT;
+		memory_barrier.dst_stage_mask  = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT;
+
+		command_buffer.image_memory_barrier(views.at(0), memory_barrier);
+
+		memory_barrier.old_layout      = VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL;
+		memory_barrier.src_access_mask = VK_ACCESS_TRANSFER_READ_BIT;
+
+		command_buffer.image_memory_barrier(views.at(2), memory_barrier);
+	}
+}
+}        // namespace vkb
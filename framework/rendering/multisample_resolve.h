@@ -0,0 +1,111 @@
+/* Copyright (c) 2020, Arm Limited and Contributors
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 the "License";
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include "common/vk_common.h"
+#include "rendering/render_target.h"
+
+namespace vkb
+{
+class CommandBuffer;
+class Device;
+class RenderPipeline;
+
+/**
+ * @brief How the multisampled color is resolved to the single-sampled image presented or sampled afterwards
+ */
+enum class ColorResolveMode
+{
+	/// Resolved by the render pass on writeback of the tiles, the multisampled color never leaves tile memory
+	Subpass,
+
+	/// Stored by the render pass and resolved with vkCmdResolveImage afterwards, which writes and reads all the samples
+	Separate
+};
+
+/**
+ * @brief Multisampling options of the render targets and pipelines of a sample
+ */
+struct MultisampleInfo
+{
+	/// Samples per pixel, multisampling is disabled with one
+	VkSampleCountFlagBits sample_count{VK_SAMPLE_COUNT_1_BIT};
+
+	ColorResolveMode color_resolve_mode{ColorResolveMode::Subpass};
+
+	/// Resolve mode of depth with VK_KHR_depth_stencil_resolve, none if depth is not needed after the render pass
+	VkResolveModeFlagBits depth_resolve_mode{VK_RESOLVE_MODE_NONE};
+};
+
+/**
+ * @brief Renders pipelines multisampled and resolves their attachments the cheapest way available
+ *
+ * The render targets it creates keep the first two attachments of RenderTarget::DEFAULT_CREATE_FUNC,
+ * so that pipelines written for single sampling work unchanged once applied:
+ * - 0: the single-sampled color image, e.g. a swapchain image, which the pipeline resolves to
+ * - 1: multisampled depth stencil, transient
+ * - 2: multisampled color, transient unless it is resolved separately
+ * - 3: single-sampled depth stencil which depth resolves to, only if a depth resolve mode is set
+ */
+class MultisampleResolve
+{
+  public:
+	/**
+	 * @brief Lowers the options to what the device supports
+	 *        The sample count falls back to the largest one supported by color and depth attachments, and depth is not
+	 *        resolved if VK_KHR_depth_stencil_resolve is not enabled. Only VK_RESOLVE_MODE_SAMPLE_ZERO_BIT is always
+	 *        supported by the extension.
+	 */
+	MultisampleResolve(Device &device, const MultisampleInfo &info);
+
+	MultisampleResolve(const MultisampleResolve &) = delete;
+
+	MultisampleResolve(MultisampleResolve &&) = delete;
+
+	MultisampleResolve &operator=(const MultisampleResolve &) = delete;
+
+	MultisampleResolve &operator=(MultisampleResolve &&) = delete;
+
+	/**
+	 * @return The options supported by the device
+	 */
+	const MultisampleInfo &get_info() const;
+
+	/**
+	 * @return Creates render targets with the attachments above from the single-sampled color image
+	 */
+	RenderTarget::CreateFunc get_create_func() const;
+
+	/**
+	 * @brief Redirects the subpasses of a pipeline from attachment 0 to the multisampled color and sets their sample count
+	 *        The last subpass resolves color and depth, and the load and store operations are set so that only the resolved
+	 *        images are written to memory, overriding those of the pipeline.
+	 * @param render_pipeline Pipeline drawing to render targets created by get_create_func
+	 */
+	void apply(RenderPipeline &render_pipeline) const;
+
+	/**
+	 * @brief Resolves the multisampled color to attachment 0 if it is resolved separately, with the render pass ended
+	 *        Both images are left in the color attachment layout, as the render pass left them.
+	 */
+	void resolve(CommandBuffer &command_buffer, RenderTarget &render_target) const;
+
+  private:
+	MultisampleInfo info;
+};
+}        // namespace vkb
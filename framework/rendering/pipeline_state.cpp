@@ -17,6 +17,8 @@
 
 #include "pipeline_state.h"
 
+#include "common/resource_caching.h"
+
 bool operator==(const VkVertexInputAttributeDescription &lhs, const VkVertexInputAttributeDescription &rhs)
 {
 	return std::tie(lhs.binding, lhs.format, lhs.location, lhs.offset) == std::tie(rhs.binding, rhs.format, rhs.location, rhs.offset);
@@ -50,8 +52,8 @@ bool operator!=(const vkb::InputAssemblyState &lhs, const vkb::InputAssemblyStat
 
 bool operator!=(const vkb::RasterizationState &lhs, const vkb::RasterizationState &rhs)
 {
-	return std::tie(lhs.cull_mode, lhs.depth_bias_enable, lhs.depth_clamp_enable, lhs.front_face, lhs.front_face, lhs.polygon_mode, lhs.rasterizer_discard_enable) !=
-	       std::tie(rhs.cull_mode, rhs.depth_bias_enable, rhs.depth_clamp_enable, rhs.front_face, rhs.front_face, rhs.polygon_mode, rhs.rasterizer_discard_enable);
+	return std::tie(lhs.cull_mode, lhs.depth_bias_enable, lhs.depth_clamp_enable, lhs.front_face, lhs.front_face, lhs.polygon_mode, lhs.rasterizer_discard_enable, lhs.conservative_rasterization_mode) !=
+	       std::tie(rhs.cull_mode, rhs.depth_bias_enable, rhs.depth_clamp_enable, rhs.front_face, rhs.front_face, rhs.polygon_mode, rhs.rasterizer_discard_enable, rhs.conservative_rasterization_mode);
 }
 
 bool operator!=(const vkb::ViewportState &lhs, const vkb::ViewportState &rhs)
@@ -72,6 +74,16 @@ bool operator!=(const vkb::DepthStencilState &lhs, const vkb::DepthStencilState
 	       lhs.back != rhs.back || lhs.front != rhs.front;
 }
 
+bool operator!=(const vkb::FragmentShadingRateState &lhs, const vkb::FragmentShadingRateState &rhs)
+{
+	return std::tie(lhs.fragment_size.width, lhs.fragment_size.height, lhs.combiner_ops) != std::tie(rhs.fragment_size.width, rhs.fragment_size.height, rhs.combiner_ops);
+}
+
+bool operator!=(const vkb::SubgroupSizeState &lhs, const vkb::SubgroupSizeState &rhs)
+{
+	return std::tie(lhs.required_size, lhs.allow_varying_size, lhs.require_full_subgroups) != std::tie(rhs.required_size, rhs.allow_varying_size, rhs.require_full_subgroups);
+}
+
 bool operator!=(const vkb::ColorBlendState &lhs, const vkb::ColorBlendState &rhs)
 {
 	return std::tie(lhs.logic_op, lhs.logic_op_enable) != std::tie(rhs.logic_op, rhs.logic_op_enable) ||
@@ -84,6 +96,202 @@ bool operator!=(const vkb::ColorBlendState &lhs, const vkb::ColorBlendState &rhs
 
 namespace vkb
 {
+namespace
+{
+size_t hash_pipeline_layout(const PipelineLayout *pipeline_layout)
+{
+	size_t result = 0;
+
+	if (pipeline_layout)
+	{
+		hash_combine(result, pipeline_layout->get_handle());
+
+		for (auto shader_module : pipeline_layout->get_shader_modules())
+		{
+			hash_combine(result, shader_module->get_id());
+		}
+	}
+
+	return result;
+}
+
+size_t hash_render_pass(const RenderPass *render_pass, const RenderingState &rendering_state)
+{
+	size_t result = 0;
+
+	// For graphics only, a pipeline can be used with any render pass compatible with the one it was created for
+	if (render_pass)
+	{
+		hash_combine(result, render_pass->get_compatibility_hash());
+	}
+	else
+	{
+		for (auto format : rendering_state.color_attachment_formats)
+		{
+			hash_combine(result, static_cast<std::underlying_type<VkFormat>::type>(format));
+		}
+
+		hash_combine(result, static_cast<std::underlying_type<VkFormat>::type>(rendering_state.depth_attachment_format));
+		hash_combine(result, static_cast<std::underlying_type<VkFormat>::type>(rendering_state.stencil_attachment_format));
+		hash_combine(result, rendering_state.view_mask);
+	}
+
+	return result;
+}
+
+size_t hash_specialization_constants(const SpecializationConstantState &specialization_constant_state)
+{
+	size_t result = 0;
+
+	hash_combine(result, specialization_constant_state);
+
+	return result;
+}
+
+size_t hash_vertex_input(const VertexInputState &vertex_input_state)
+{
+	size_t result = 0;
+
+	// VkPipelineVertexInputStateCreateInfo
+	for (auto &attribute : vertex_input_state.attributes)
+	{
+		hash_combine(result, attribute);
+	}
+
+	for (auto &binding : vertex_input_state.bindings)
+	{
+		hash_combine(result, binding);
+	}
+
+	return result;
+}
+
+size_t hash_input_assembly(const InputAssemblyState &input_assembly_state)
+{
+	size_t result = 0;
+
+	// VkPipelineInputAssemblyStateCreateInfo
+	hash_combine(result, input_assembly_state.primitive_restart_enable);
+	hash_combine(result, static_cast<std::underlying_type<VkPrimitiveTopology>::type>(input_assembly_state.topology));
+
+	return result;
+}
+
+size_t hash_viewport(const ViewportState &viewport_state)
+{
+	size_t result = 0;
+
+	// VkPipelineViewportStateCreateInfo
+	hash_combine(result, viewport_state.viewport_count);
+	hash_combine(result, viewport_state.scissor_count);
+
+	return result;
+}
+
+size_t hash_rasterization(const RasterizationState &rasterization_state, bool extended_dynamic_state)
+{
+	size_t result = 0;
+
+	// VkPipelineRasterizationStateCreateInfo
+	if (!extended_dynamic_state)
+	{
+		hash_combine(result, rasterization_state.cull_mode);
+		hash_combine(result, static_cast<std::underlying_type<VkFrontFace>::type>(rasterization_state.front_face));
+	}
+
+	hash_combine(result, rasterization_state.depth_bias_enable);
+	hash_combine(result, rasterization_state.depth_clamp_enable);
+	hash_combine(result, static_cast<std::underlying_type<VkPolygonMode>::type>(rasterization_state.polygon_mode));
+	hash_combine(result, rasterization_state.rasterizer_discard_enable);
+
+	// VkPipelineRasterizationConservativeStateCreateInfoEXT
+	hash_combine(result, static_cast<std::underlying_type<VkConservativeRasterizationModeEXT>::type>(rasterization_state.conservative_rasterization_mode));
+
+	return result;
+}
+
+size_t hash_multisample(const MultisampleState &multisample_state)
+{
+	size_t result = 0;
+
+	// VkPipelineMultisampleStateCreateInfo
+	hash_combine(result, multisample_state.alpha_to_coverage_enable);
+	hash_combine(result, multisample_state.alpha_to_one_enable);
+	hash_combine(result, multisample_state.min_sample_shading);
+	hash_combine(result, static_cast<std::underlying_type<VkSampleCountFlagBits>::type>(multisample_state.rasterization_samples));
+	hash_combine(result, multisample_state.sample_shading_enable);
+	hash_combine(result, multisample_state.sample_mask);
+
+	return result;
+}
+
+size_t hash_depth_stencil(const DepthStencilState &depth_stencil_state, bool extended_dynamic_state)
+{
+	size_t result = 0;
+
+	// All of the depth stencil state is set by extended dynamic state
+	if (extended_dynamic_state)
+	{
+		return result;
+	}
+
+	// VkPipelineDepthStencilStateCreateInfo
+	hash_combine(result, depth_stencil_state.back);
+	hash_combine(result, depth_stencil_state.depth_bounds_test_enable);
+	hash_combine(result, static_cast<std::underlying_type<VkCompareOp>::type>(depth_stencil_state.depth_compare_op));
+	hash_combine(result, depth_stencil_state.depth_test_enable);
+	hash_combine(result, depth_stencil_state.depth_write_enable);
+	hash_combine(result, depth_stencil_state.front);
+	hash_combine(result, depth_stencil_state.stencil_test_enable);
+
+	return result;
+}
+
+size_t hash_color_blend(const ColorBlendState &color_blend_state)
+{
+	size_t result = 0;
+
+	// VkPipelineColorBlendStateCreateInfo
+	hash_combine(result, static_cast<std::underlying_type<VkLogicOp>::type>(color_blend_state.logic_op));
+	hash_combine(result, color_blend_state.logic_op_enable);
+
+	for (auto &attachment : color_blend_state.attachments)
+	{
+		hash_combine(result, attachment);
+	}
+
+	return result;
+}
+
+size_t hash_fragment_shading_rate(const FragmentShadingRateState &fragment_shading_rate_state)
+{
+	size_t result = 0;
+
+	// VkPipelineFragmentShadingRateStateCreateInfoKHR
+	hash_combine(result, fragment_shading_rate_state.fragment_size.width);
+	hash_combine(result, fragment_shading_rate_state.fragment_size.height);
+
+	for (auto combiner_op : fragment_shading_rate_state.combiner_ops)
+	{
+		hash_combine(result, static_cast<std::underlying_type<VkFragmentShadingRateCombinerOpKHR>::type>(combiner_op));
+	}
+
+	return result;
+}
+
+size_t hash_subgroup_size(const SubgroupSizeState &subgroup_size_state)
+{
+	size_t result = 0;
+
+	// VkPipelineShaderStageRequiredSubgroupSizeCreateInfoEXT and the stage flags
+	hash_combine(result, subgroup_size_state.required_size);
+	hash_combine(result, subgroup_size_state.allow_varying_size);
+	hash_combine(result, subgroup_size_state.require_full_subgroups);
+
+	return result;
+}
+}        // namespace
+
 void SpecializationConstantState::reset()
 {
 	if (dirty)
@@ -128,6 +336,11 @@ const std::map<uint32_t, std::vector<uint8_t>> &SpecializationConstantState::get
 	return specialization_constant_state;
 }
 
+PipelineState::PipelineState()
+{
+	update_state_hashes();
+}
+
 void PipelineState::reset()
 {
 	clear_dirty();
@@ -136,6 +349,8 @@ void PipelineState::reset()
 
 	render_pass = nullptr;
 
+	rendering_state = {};
+
 	specialization_constant_state.reset();
 
 	vertex_input_sate = {};
@@ -150,7 +365,15 @@ void PipelineState::reset()
 
 	color_blend_state = {};
 
+	fragment_shading_rate_state = {};
+
+	subgroup_size_state = {};
+
 	subpass_index = {0U};
+
+	extended_dynamic_state = false;
+
+	update_state_hashes();
 }
 
 void PipelineState::set_pipeline_layout(PipelineLayout &new_pipeline_layout)
@@ -161,6 +384,8 @@ void PipelineState::set_pipeline_layout(PipelineLayout &new_pipeline_layout)
 		{
 			pipeline_layout = &new_pipeline_layout;
 
+			state_hashes.pipeline_layout = hash_pipeline_layout(pipeline_layout);
+
 			dirty = true;
 		}
 	}
@@ -168,6 +393,8 @@ void PipelineState::set_pipeline_layout(PipelineLayout &new_pipeline_layout)
 	{
 		pipeline_layout = &new_pipeline_layout;
 
+		state_hashes.pipeline_layout = hash_pipeline_layout(pipeline_layout);
+
 		dirty = true;
 	}
 }
@@ -180,6 +407,8 @@ void PipelineState::set_render_pass(const RenderPass &new_render_pass)
 		{
 			render_pass = &new_render_pass;
 
+			state_hashes.render_pass = hash_render_pass(render_pass, rendering_state);
+
 			dirty = true;
 		}
 	}
@@ -187,16 +416,31 @@ void PipelineState::set_render_pass(const RenderPass &new_render_pass)
 	{
 		render_pass = &new_render_pass;
 
+		state_hashes.render_pass = hash_render_pass(render_pass, rendering_state);
+
 		dirty = true;
 	}
 }
 
+void PipelineState::set_rendering_state(const RenderingState &new_rendering_state)
+{
+	render_pass = nullptr;
+
+	rendering_state = new_rendering_state;
+
+	state_hashes.render_pass = hash_render_pass(render_pass, rendering_state);
+
+	dirty = true;
+}
+
 void PipelineState::set_specialization_constant(uint32_t constant_id, const std::vector<uint8_t> &data)
 {
 	specialization_constant_state.set_constant(constant_id, data);
 
 	if (specialization_constant_state.is_dirty())
 	{
+		state_hashes.specialization_constants = hash_specialization_constants(specialization_constant_state);
+
 		dirty = true;
 	}
 }
@@ -207,6 +451,8 @@ void PipelineState::set_vertex_input_state(const VertexInputState &new_vertex_in
 	{
 		vertex_input_sate = new_vertex_input_sate;
 
+		state_hashes.vertex_input = hash_vertex_input(vertex_input_sate);
+
 		dirty = true;
 	}
 }
@@ -217,6 +463,8 @@ void PipelineState::set_input_assembly_state(const InputAssemblyState &new_input
 	{
 		input_assembly_state = new_input_assembly_state;
 
+		state_hashes.input_assembly = hash_input_assembly(input_assembly_state);
+
 		dirty = true;
 	}
 }
@@ -227,6 +475,8 @@ void PipelineState::set_rasterization_state(const RasterizationState &new_raster
 	{
 		rasterization_state = new_rasterization_state;
 
+		state_hashes.rasterization = hash_rasterization(rasterization_state, extended_dynamic_state);
+
 		dirty = true;
 	}
 }
@@ -237,6 +487,8 @@ void PipelineState::set_viewport_state(const ViewportState &new_viewport_state)
 	{
 		viewport_state = new_viewport_state;
 
+		state_hashes.viewport = hash_viewport(viewport_state);
+
 		dirty = true;
 	}
 }
@@ -247,6 +499,8 @@ void PipelineState::set_multisample_state(const MultisampleState &new_multisampl
 	{
 		multisample_state = new_multisample_state;
 
+		state_hashes.multisample = hash_multisample(multisample_state);
+
 		dirty = true;
 	}
 }
@@ -257,6 +511,8 @@ void PipelineState::set_depth_stencil_state(const DepthStencilState &new_depth_s
 	{
 		depth_stencil_state = new_depth_stencil_state;
 
+		state_hashes.depth_stencil = hash_depth_stencil(depth_stencil_state, extended_dynamic_state);
+
 		dirty = true;
 	}
 }
@@ -267,6 +523,32 @@ void PipelineState::set_color_blend_state(const ColorBlendState &new_color_blend
 	{
 		color_blend_state = new_color_blend_state;
 
+		state_hashes.color_blend = hash_color_blend(color_blend_state);
+
+		dirty = true;
+	}
+}
+
+void PipelineState::set_fragment_shading_rate_state(const FragmentShadingRateState &new_fragment_shading_rate_state)
+{
+	if (fragment_shading_rate_state != new_fragment_shading_rate_state)
+	{
+		fragment_shading_rate_state = new_fragment_shading_rate_state;
+
+		state_hashes.fragment_shading_rate = hash_fragment_shading_rate(fragment_shading_rate_state);
+
+		dirty = true;
+	}
+}
+
+void PipelineState::set_subgroup_size_state(const SubgroupSizeState &new_subgroup_size_state)
+{
+	if (subgroup_size_state != new_subgroup_size_state)
+	{
+		subgroup_size_state = new_subgroup_size_state;
+
+		state_hashes.subgroup_size = hash_subgroup_size(subgroup_size_state);
+
 		dirty = true;
 	}
 }
@@ -281,12 +563,30 @@ void PipelineState::set_subpass_index(uint32_t new_subpass_index)
 	}
 }
 
+void PipelineState::set_extended_dynamic_state(bool enable)
+{
+	if (extended_dynamic_state != enable)
+	{
+		extended_dynamic_state = enable;
+
+		state_hashes.rasterization = hash_rasterization(rasterization_state, extended_dynamic_state);
+		state_hashes.depth_stencil = hash_depth_stencil(depth_stencil_state, extended_dynamic_state);
+
+		dirty = true;
+	}
+}
+
 const PipelineLayout &PipelineState::get_pipeline_layout() const
 {
 	assert(pipeline_layout && "Graphics state Pipeline layout is not set");
 	return *pipeline_layout;
 }
 
+const RenderingState &PipelineState::get_rendering_state() const
+{
+	return rendering_state;
+}
+
 const RenderPass *PipelineState::get_render_pass() const
 {
 	return render_pass;
@@ -332,11 +632,36 @@ const ColorBlendState &PipelineState::get_color_blend_state() const
 	return color_blend_state;
 }
 
+const FragmentShadingRateState &PipelineState::get_fragment_shading_rate_state() const
+{
+	return fragment_shading_rate_state;
+}
+
+bool PipelineState::has_fragment_shading_rate() const
+{
+	return fragment_shading_rate_state != FragmentShadingRateState{};
+}
+
+const SubgroupSizeState &PipelineState::get_subgroup_size_state() const
+{
+	return subgroup_size_state;
+}
+
+bool PipelineState::has_subgroup_size_control() const
+{
+	return subgroup_size_state != SubgroupSizeState{};
+}
+
 uint32_t PipelineState::get_subpass_index() const
 {
 	return subpass_index;
 }
 
+bool PipelineState::has_extended_dynamic_state() const
+{
+	return extended_dynamic_state;
+}
+
 bool PipelineState::is_dirty() const
 {
 	return dirty || specialization_constant_state.is_dirty();
@@ -347,4 +672,42 @@ void PipelineState::clear_dirty()
 	dirty = false;
 	specialization_constant_state.clear_dirty();
 }
+
+size_t PipelineState::get_hash() const
+{
+	size_t result = 0;
+
+	hash_combine(result, state_hashes.pipeline_layout);
+	hash_combine(result, state_hashes.render_pass);
+	hash_combine(result, state_hashes.specialization_constants);
+	hash_combine(result, subpass_index);
+	hash_combine(result, state_hashes.vertex_input);
+	hash_combine(result, state_hashes.input_assembly);
+	hash_combine(result, state_hashes.viewport);
+	hash_combine(result, state_hashes.rasterization);
+	hash_combine(result, state_hashes.multisample);
+	hash_combine(result, state_hashes.depth_stencil);
+	hash_combine(result, state_hashes.color_blend);
+	hash_combine(result, state_hashes.fragment_shading_rate);
+	hash_combine(result, state_hashes.subgroup_size);
+	hash_combine(result, extended_dynamic_state);
+
+	return result;
+}
+
+void PipelineState::update_state_hashes()
+{
+	state_hashes.pipeline_layout          = hash_pipeline_layout(pipeline_layout);
+	state_hashes.render_pass              = hash_render_pass(render_pass, rendering_state);
+	state_hashes.specialization_constants = hash_specialization_constants(specialization_constant_state);
+	state_hashes.vertex_input             = hash_vertex_input(vertex_input_sate);
+	state_hashes.input_assembly           = hash_input_assembly(input_assembly_state);
+	state_hashes.viewport                 = hash_viewport(viewport_state);
+	state_hashes.rasterization            = hash_rasterization(rasterization_state, extended_dynamic_state);
+	state_hashes.multisample              = hash_multisample(multisample_state);
+	state_hashes.depth_stencil            = hash_depth_stencil(depth_stencil_state, extended_dynamic_state);
+	state_hashes.color_blend              = hash_color_blend(color_blend_state);
+	state_hashes.fragment_shading_rate    = hash_fragment_shading_rate(fragment_shading_rate_state);
+	state_hashes.subgroup_size            = hash_subgroup_size(subgroup_size_state);
+}
 }        // namespace vkb
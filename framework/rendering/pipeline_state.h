@@ -17,6 +17,7 @@
 
 #pragma once
 
+#include <array>
 #include <vector>
 
 #include "common/vk_common.h"
@@ -52,6 +53,9 @@ struct RasterizationState
 	VkFrontFace front_face{VK_FRONT_FACE_COUNTER_CLOCKWISE};
 
 	VkBool32 depth_bias_enable{VK_FALSE};
+
+	/// Overestimation rasterizes every pixel a primitive touches, it needs VK_EXT_conservative_rasterization
+	VkConservativeRasterizationModeEXT conservative_rasterization_mode{VK_CONSERVATIVE_RASTERIZATION_MODE_DISABLED_EXT};
 };
 
 struct ViewportState
@@ -133,6 +137,51 @@ struct ColorBlendState
 	std::vector<ColorBlendAttachmentState> attachments;
 };
 
+/**
+ * @brief Fragment shading rate of the pipeline, combined with the rates of the primitives and of the
+ *        shading rate attachment of the subpass. The defaults shade every pixel and ignore the attachment.
+ * Requires the VK_KHR_fragment_shading_rate extension when it differs from the defaults.
+ */
+struct FragmentShadingRateState
+{
+	/// Size in pixels of the fragments shaded by a single invocation
+	VkExtent2D fragment_size{1, 1};
+
+	/// Combination of the pipeline rate with the primitive rate, then of the result with the attachment rate
+	std::array<VkFragmentShadingRateCombinerOpKHR, 2> combiner_ops{VK_FRAGMENT_SHADING_RATE_COMBINER_OP_KEEP_KHR, VK_FRAGMENT_SHADING_RATE_COMBINER_OP_KEEP_KHR};
+};
+
+/**
+ * @brief Subgroup size of the compute shader of the pipeline, the defaults let the implementation choose it.
+ * Requires the VK_EXT_subgroup_size_control extension when it differs from the defaults.
+ */
+struct SubgroupSizeState
+{
+	/// Subgroup size the shader is dispatched with, 0 for the implementation to choose it
+	uint32_t required_size{0};
+
+	/// Whether the subgroup size may vary within the range of the GPU, when no size is required
+	bool allow_varying_size{false};
+
+	/// Whether all the invocations of the subgroups are active, which requires the local size in x to be a multiple of the subgroup size
+	bool require_full_subgroups{false};
+};
+
+/**
+ * @brief Attachment formats of dynamic rendering, which pipelines created without a render pass are built for
+ */
+struct RenderingState
+{
+	std::vector<VkFormat> color_attachment_formats;
+
+	VkFormat depth_attachment_format{VK_FORMAT_UNDEFINED};
+
+	VkFormat stencil_attachment_format{VK_FORMAT_UNDEFINED};
+
+	/// Views rendered with VK_KHR_multiview, 0 without multiview
+	uint32_t view_mask{0};
+};
+
 /// Helper class to create specialization constants for a Vulkan pipeline. The state tracks a pipeline globally, and not per shader. Two shaders using the same constant_id will have the same data.
 class SpecializationConstantState
 {
@@ -173,12 +222,19 @@ inline void SpecializationConstantState::set_constant<bool>(std::uint32_t consta
 class PipelineState
 {
   public:
+	PipelineState();
+
 	void reset();
 
 	void set_pipeline_layout(PipelineLayout &pipeline_layout);
 
 	void set_render_pass(const RenderPass &render_pass);
 
+	/**
+	 * @brief Sets the attachment formats of dynamic rendering, the pipeline is then created without a render pass
+	 */
+	void set_rendering_state(const RenderingState &rendering_state);
+
 	void set_specialization_constant(uint32_t constant_id, const std::vector<uint8_t> &data);
 
 	void set_vertex_input_state(const VertexInputState &vertex_input_sate);
@@ -195,12 +251,26 @@ class PipelineState
 
 	void set_color_blend_state(const ColorBlendState &color_blend_state);
 
+	void set_fragment_shading_rate_state(const FragmentShadingRateState &fragment_shading_rate_state);
+
+	void set_subgroup_size_state(const SubgroupSizeState &subgroup_size_state);
+
 	void set_subpass_index(uint32_t subpass_index);
 
+	/**
+	 * @brief Moves the cull mode, the front face and the depth stencil state to dynamic state,
+	 *        so they are no longer part of the pipeline and its hash
+	 *
+	 * Requires the VK_EXT_extended_dynamic_state extension. The command buffer sets the dynamic state before drawing.
+	 */
+	void set_extended_dynamic_state(bool enable);
+
 	const PipelineLayout &get_pipeline_layout() const;
 
 	const RenderPass *get_render_pass() const;
 
+	const RenderingState &get_rendering_state() const;
+
 	const SpecializationConstantState &get_specialization_constant_state() const;
 
 	const VertexInputState &get_vertex_input_state() const;
@@ -217,19 +287,81 @@ class PipelineState
 
 	const ColorBlendState &get_color_blend_state() const;
 
+	const FragmentShadingRateState &get_fragment_shading_rate_state() const;
+
+	/**
+	 * @return Whether the fragment shading rate state differs from the defaults, which pipelines are created with otherwise
+	 */
+	bool has_fragment_shading_rate() const;
+
+	const SubgroupSizeState &get_subgroup_size_state() const;
+
+	/**
+	 * @return Whether the subgroup size state differs from the defaults, which compute pipelines are created with otherwise
+	 */
+	bool has_subgroup_size_control() const;
+
 	uint32_t get_subpass_index() const;
 
+	bool has_extended_dynamic_state() const;
+
 	bool is_dirty() const;
 
 	void clear_dirty();
 
+	/**
+	 * @return The hash identifying the pipeline of the state, combined from the hashes of its parts
+	 *         which the setters update when they change, so that the whole state is not rehashed
+	 */
+	size_t get_hash() const;
+
   private:
 	bool dirty{false};
 
+	/**
+	 * @brief Hashes of the parts of the state, each one recomputed only by the setter of its part
+	 */
+	struct StateHashes
+	{
+		/// Hash of the layout handle and of its shader modules
+		size_t pipeline_layout{0};
+
+		size_t render_pass{0};
+
+		size_t specialization_constants{0};
+
+		size_t vertex_input{0};
+
+		size_t input_assembly{0};
+
+		size_t rasterization{0};
+
+		size_t viewport{0};
+
+		size_t multisample{0};
+
+		size_t depth_stencil{0};
+
+		size_t color_blend{0};
+
+		size_t fragment_shading_rate{0};
+
+		size_t subgroup_size{0};
+	};
+
+	StateHashes state_hashes;
+
+	/**
+	 * @brief Recomputes the hashes of all the parts of the state
+	 */
+	void update_state_hashes();
+
 	PipelineLayout *pipeline_layout{nullptr};
 
 	const RenderPass *render_pass{nullptr};
 
+	RenderingState rendering_state{};
+
 	SpecializationConstantState specialization_constant_state{};
 
 	VertexInputState vertex_input_sate{};
@@ -246,6 +378,12 @@ class PipelineState
 
 	ColorBlendState color_blend_state{};
 
+	FragmentShadingRateState fragment_shading_rate_state{};
+
+	SubgroupSizeState subgroup_size_state{};
+
 	uint32_t subpass_index{0U};
+
+	bool extended_dynamic_state{false};
 };
 }        // namespace vkb
@@ -0,0 +1,485 @@
+/* Copyright (c) 2020, Arm Limited and Contributors
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 the "License";
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "rendering/postprocessing_chain.h"
+
+#include <algorithm>
+#include <cmath>
+
+#include "core/command_buffer.h"
+#include "glsl_compiler.h"
+#include "rendering/render_context.h"
+
+namespace vkb
+{
+namespace
+{
+/// Width and height of the workgroups of the post-processing shaders
+constexpr uint32_t POSTPROCESSING_GROUP_SIZE = 8;
+
+constexpr uint32_t MAX_BLOOM_LEVEL_COUNT = 5;
+
+constexpr VkFormat BLOOM_FORMAT = VK_FORMAT_R16G16B16A16_SFLOAT;
+
+constexpr VkFormat LDR_FORMAT = VK_FORMAT_R8G8B8A8_UNORM;
+
+/// Width and height of the workgroups of the luminance histogram, one invocation per bin
+constexpr uint32_t HISTOGRAM_GROUP_SIZE = 16;
+
+constexpr uint32_t HISTOGRAM_BIN_COUNT = HISTOGRAM_GROUP_SIZE * HISTOGRAM_GROUP_SIZE;
+
+/// Exposure the average luminance is adapted to, which maps it to about half of the output range
+constexpr float EXPOSURE_KEY = 0.7f;
+
+/// Longest time the exposure adapts over in one frame, so that a stall does not make it jump
+constexpr double MAX_ADAPTATION_TIME = 0.1;
+
+struct BloomThresholdParameters
+{
+	float threshold;
+};
+
+struct TonemapParameters
+{
+	float exposure;
+
+	float bloom_intensity;
+};
+
+struct HistogramParameters
+{
+	float min_log_luminance;
+
+	float inv_log_luminance_range;
+};
+
+struct AdaptationParameters
+{
+	float min_log_luminance;
+
+	float log_luminance_range;
+
+	float adaptation;
+
+	float key;
+};
+
+/**
+ * @return Whether the histogram can merge the pixels of a subgroup falling in the same bin with ballots
+ */
+bool is_subgroup_ballot_supported(Device &device)
+{
+	if (GLSLCompiler::get_target_language() != glslang::EShTargetSpv ||
+	    GLSLCompiler::get_target_language_version() < glslang::EShTargetSpv_1_3)
+	{
+		return false;
+	}
+
+	auto &subgroup_properties = device.get_gpu().get_subgroup_properties();
+
+	VkSubgroupFeatureFlags required_operations = VK_SUBGROUP_FEATURE_BASIC_BIT | VK_SUBGROUP_FEATURE_VOTE_BIT | VK_SUBGROUP_FEATURE_BALLOT_BIT;
+
+	return (subgroup_properties.supportedStages & VK_SHADER_STAGE_COMPUTE_BIT) &&
+	       (subgroup_properties.supportedOperations & required_operations) == required_operations;
+}
+
+void storage_barrier(CommandBuffer &command_buffer, const core::Buffer &buffer, VkPipelineStageFlags src_stage_mask, VkAccessFlags src_access_mask)
+{
+	BufferMemoryBarrier barrier;
+	barrier.src_stage_mask  = src_stage_mask;
+	barrier.dst_stage_mask  = VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT;
+	barrier.src_access_mask = src_access_mask;
+	barrier.dst_access_mask = VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT;
+
+	command_buffer.buffer_memory_barrier(buffer, 0, VK_WHOLE_SIZE, barrier);
+}
+}        // namespace
+
+PostProcessingChain::PostProcessingChain(RenderContext &render_context) :
+    render_context{render_context},
+    bloom_downsample_shader{"postprocessing/bloom_downsample.comp"},
+    bloom_upsample_shader{"postprocessing/bloom_upsample.comp"},
+    tonemap_shader{"postprocessing/tonemap.comp"},
+    fxaa_shader{"postprocessing/fxaa.comp"},
+    histogram_shader{"postprocessing/luminance_histogram.comp"},
+    adaptation_shader{"postprocessing/exposure_adaptation.comp"}
+{
+	VkSamplerCreateInfo sampler_info{VK_STRUCTURE_TYPE_SAMPLER_CREATE_INFO};
+	sampler_info.maxAnisotropy = 1.0f;
+	sampler_info.magFilter     = VK_FILTER_NEAREST;
+	sampler_info.minFilter     = VK_FILTER_NEAREST;
+	sampler_info.mipmapMode    = VK_SAMPLER_MIPMAP_MODE_NEAREST;
+	sampler_info.addressModeU  = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+	sampler_info.addressModeV  = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+	sampler_info.addressModeW  = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+	sampler_info.borderColor   = VK_BORDER_COLOR_FLOAT_OPAQUE_BLACK;
+	input_sampler              = std::make_unique<core::Sampler>(render_context.get_device(), sampler_info);
+}
+
+void PostProcessingChain::prepare()
+{
+	bloom_threshold_variant = {};
+	bloom_threshold_variant.add_define("BLOOM_THRESHOLD");
+
+	tonemap_variant = {};
+	if (bloom)
+	{
+		tonemap_variant.add_define("BLOOM");
+	}
+
+	auto &device = render_context.get_device();
+
+	if (auto_exposure)
+	{
+		tonemap_variant.add_define("AUTO_EXPOSURE");
+
+		histogram_variant = {};
+		if (is_subgroup_ballot_supported(device))
+		{
+			histogram_variant.add_subgroup_definitions(device.get_gpu().get_subgroup_properties(), VK_SHADER_STAGE_COMPUTE_BIT);
+		}
+
+		if (!histogram_buffer)
+		{
+			histogram_buffer = std::make_unique<core::Buffer>(device, HISTOGRAM_BIN_COUNT * sizeof(uint32_t),
+			                                                  VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT, VMA_MEMORY_USAGE_GPU_ONLY);
+			exposure_buffer  = std::make_unique<core::Buffer>(device, 2 * sizeof(float),
+			                                                  VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT, VMA_MEMORY_USAGE_GPU_ONLY);
+
+			exposure_initialized = false;
+		}
+	}
+
+	// Build all shaders upfront
+	auto &resource_cache = device.get_resource_cache();
+
+	if (bloom)
+	{
+		resource_cache.request_shader_module(VK_SHADER_STAGE_COMPUTE_BIT, bloom_downsample_shader, bloom_threshold_variant);
+		resource_cache.request_shader_module(VK_SHADER_STAGE_COMPUTE_BIT, bloom_downsample_shader, bloom_downsample_variant);
+		resource_cache.request_shader_module(VK_SHADER_STAGE_COMPUTE_BIT, bloom_upsample_shader, bloom_upsample_variant);
+	}
+
+	if (auto_exposure)
+	{
+		resource_cache.request_shader_module(VK_SHADER_STAGE_COMPUTE_BIT, histogram_shader, histogram_variant);
+		resource_cache.request_shader_module(VK_SHADER_STAGE_COMPUTE_BIT, adaptation_shader, adaptation_variant);
+
+		adaptation_timer.tick();
+	}
+
+	resource_cache.request_shader_module(VK_SHADER_STAGE_COMPUTE_BIT, tonemap_shader, tonemap_variant);
+
+	if (fxaa)
+	{
+		resource_cache.request_shader_module(VK_SHADER_STAGE_COMPUTE_BIT, fxaa_shader, fxaa_variant);
+	}
+
+	// Images are created for the extent of the first input
+	extent = {};
+}
+
+void PostProcessingChain::set_bloom(bool enable)
+{
+	bloom = enable;
+}
+
+void PostProcessingChain::set_bloom_threshold(float threshold)
+{
+	bloom_threshold = threshold;
+}
+
+void PostProcessingChain::set_bloom_intensity(float intensity)
+{
+	bloom_intensity = intensity;
+}
+
+void PostProcessingChain::set_exposure(float exposure_)
+{
+	exposure = exposure_;
+}
+
+void PostProcessingChain::set_fxaa(bool enable)
+{
+	fxaa = enable;
+}
+
+void PostProcessingChain::set_auto_exposure(bool enable)
+{
+	auto_exposure = enable;
+}
+
+void PostProcessingChain::set_luminance_range(float min_log_luminance_, float max_log_luminance_)
+{
+	min_log_luminance = min_log_luminance_;
+	max_log_luminance = std::max(max_log_luminance_, min_log_luminance_ + 1.0f);
+}
+
+void PostProcessingChain::set_adaptation_rate(float rate)
+{
+	adaptation_rate = rate;
+}
+
+void PostProcessingChain::create_images(const VkExtent2D &input_extent)
+{
+	auto &device = render_context.get_device();
+
+	extent = input_extent;
+
+	bloom_views.clear();
+	bloom_images.clear();
+	ldr_views.clear();
+	ldr_images.clear();
+
+	VkExtent3D level_extent{extent.width, extent.height, 1};
+
+	for (uint32_t i = 0; bloom && i < MAX_BLOOM_LEVEL_COUNT && (i == 0 || std::min(level_extent.width, level_extent.height) > 1); ++i)
+	{
+		level_extent.width  = std::max(level_extent.width / 2, 1u);
+		level_extent.height = std::max(level_extent.height / 2, 1u);
+
+		bloom_images.push_back(std::make_unique<core::Image>(device, level_extent, BLOOM_FORMAT, VK_IMAGE_USAGE_STORAGE_BIT, VMA_MEMORY_USAGE_GPU_ONLY));
+		bloom_views.push_back(&bloom_images.back()->request_view(VK_IMAGE_VIEW_TYPE_2D));
+	}
+
+	size_t ldr_count = fxaa ? 2 : 1;
+
+	for (size_t i = 0; i < ldr_count; ++i)
+	{
+		ldr_images.push_back(std::make_unique<core::Image>(device, VkExtent3D{extent.width, extent.height, 1}, LDR_FORMAT,
+		                                                   VK_IMAGE_USAGE_STORAGE_BIT | VK_IMAGE_USAGE_SAMPLED_BIT, VMA_MEMORY_USAGE_GPU_ONLY));
+		ldr_views.push_back(&ldr_images.back()->request_view(VK_IMAGE_VIEW_TYPE_2D));
+	}
+}
+
+void PostProcessingChain::compute_barrier(CommandBuffer &command_buffer, const core::ImageView &view)
+{
+	ImageMemoryBarrier barrier{};
+	barrier.old_layout      = VK_IMAGE_LAYOUT_GENERAL;
+	barrier.new_layout      = VK_IMAGE_LAYOUT_GENERAL;
+	barrier.src_access_mask = VK_ACCESS_SHADER_WRITE_BIT;
+	barrier.dst_access_mask = VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT;
+	barrier.src_stage_mask  = VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT;
+	barrier.dst_stage_mask  = VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT;
+
+	command_buffer.image_memory_barrier(view, barrier);
+}
+
+void PostProcessingChain::dispatch(CommandBuffer &command_buffer, const ShaderSource &shader, const ShaderVariant &variant, const VkExtent3D &dispatch_extent)
+{
+	auto &resource_cache  = render_context.get_device().get_resource_cache();
+	auto &shader_module   = resource_cache.request_shader_module(VK_SHADER_STAGE_COMPUTE_BIT, shader, variant);
+	auto &pipeline_layout = resource_cache.request_pipeline_layout({&shader_module});
+
+	command_buffer.bind_pipeline_layout(pipeline_layout);
+
+	command_buffer.dispatch((dispatch_extent.width + POSTPROCESSING_GROUP_SIZE - 1) / POSTPROCESSING_GROUP_SIZE,
+	                        (dispatch_extent.height + POSTPROCESSING_GROUP_SIZE - 1) / POSTPROCESSING_GROUP_SIZE,
+	                        1);
+}
+
+void PostProcessingChain::record_bloom(CommandBuffer &command_buffer, const core::ImageView &input)
+{
+	// Downsample from the input, keeping its bright parts in the first level
+	for (size_t i = 0; i < bloom_views.size(); ++i)
+	{
+		auto &level_view = *bloom_views[i];
+
+		if (i == 0)
+		{
+			command_buffer.bind_image(input, *input_sampler, 0, 0, 0);
+			command_buffer.push_constants(BloomThresholdParameters{bloom_threshold});
+		}
+		else
+		{
+			compute_barrier(command_buffer, *bloom_views[i - 1]);
+
+			command_buffer.bind_image(*bloom_views[i - 1], 0, 0, 0);
+		}
+
+		command_buffer.bind_image(level_view, 0, 1, 0);
+
+		dispatch(command_buffer, bloom_downsample_shader, i == 0 ? bloom_threshold_variant : bloom_downsample_variant, bloom_images[i]->get_extent());
+	}
+
+	// Upsample back to the first level, accumulating every level into the larger one
+	for (size_t i = bloom_views.size() - 1; i > 0; --i)
+	{
+		compute_barrier(command_buffer, *bloom_views[i]);
+		compute_barrier(command_buffer, *bloom_views[i - 1]);
+
+		command_buffer.bind_image(*bloom_views[i], 0, 0, 0);
+		command_buffer.bind_image(*bloom_views[i - 1], 0, 1, 0);
+
+		dispatch(command_buffer, bloom_upsample_shader, bloom_upsample_variant, bloom_images[i - 1]->get_extent());
+	}
+
+	compute_barrier(command_buffer, *bloom_views[0]);
+}
+
+void PostProcessingChain::record_auto_exposure(CommandBuffer &command_buffer, const core::ImageView &input)
+{
+	if (!exposure_initialized)
+	{
+		command_buffer.flush_barriers();
+
+		vkCmdFillBuffer(command_buffer.get_handle(), histogram_buffer->get_handle(), 0, VK_WHOLE_SIZE, 0);
+		vkCmdFillBuffer(command_buffer.get_handle(), exposure_buffer->get_handle(), 0, VK_WHOLE_SIZE, 0);
+
+		storage_barrier(command_buffer, *histogram_buffer, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_ACCESS_TRANSFER_WRITE_BIT);
+		storage_barrier(command_buffer, *exposure_buffer, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_ACCESS_TRANSFER_WRITE_BIT);
+
+		exposure_initialized = true;
+	}
+	else
+	{
+		// The adaptation of the previous frame cleared the histogram and wrote the exposure
+		storage_barrier(command_buffer, *histogram_buffer, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_ACCESS_SHADER_WRITE_BIT);
+		storage_barrier(command_buffer, *exposure_buffer, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_ACCESS_SHADER_WRITE_BIT);
+	}
+
+	auto &resource_cache = render_context.get_device().get_resource_cache();
+
+	float log_luminance_range = max_log_luminance - min_log_luminance;
+
+	{
+		auto &shader_module   = resource_cache.request_shader_module(VK_SHADER_STAGE_COMPUTE_BIT, histogram_shader, histogram_variant);
+		auto &pipeline_layout = resource_cache.request_pipeline_layout({&shader_module});
+
+		command_buffer.bind_pipeline_layout(pipeline_layout);
+
+		command_buffer.bind_image(input, *input_sampler, 0, 0, 0);
+		command_buffer.bind_buffer(*histogram_buffer, 0, histogram_buffer->get_size(), 0, 1, 0);
+		command_buffer.push_constants(HistogramParameters{min_log_luminance, 1.0f / log_luminance_range});
+
+		command_buffer.dispatch((extent.width + HISTOGRAM_GROUP_SIZE - 1) / HISTOGRAM_GROUP_SIZE,
+		                        (extent.height + HISTOGRAM_GROUP_SIZE - 1) / HISTOGRAM_GROUP_SIZE,
+		                        1);
+	}
+
+	storage_barrier(command_buffer, *histogram_buffer, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_ACCESS_SHADER_WRITE_BIT);
+
+	{
+		// Exponential adaptation, independent of the frame rate
+		auto  elapsed    = std::min(adaptation_timer.tick(), MAX_ADAPTATION_TIME);
+		float adaptation = 1.0f - std::exp(-static_cast<float>(elapsed) * adaptation_rate);
+
+		auto &shader_module   = resource_cache.request_shader_module(VK_SHADER_STAGE_COMPUTE_BIT, adaptation_shader, adaptation_variant);
+		auto &pipeline_layout = resource_cache.request_pipeline_layout({&shader_module});
+
+		command_buffer.bind_pipeline_layout(pipeline_layout);
+
+		command_buffer.bind_buffer(*histogram_buffer, 0, histogram_buffer->get_size(), 0, 1, 0);
+		command_buffer.bind_buffer(*exposure_buffer, 0, exposure_buffer->get_size(), 0, 2, 0);
+		command_buffer.push_constants(AdaptationParameters{min_log_luminance, log_luminance_range, adaptation, EXPOSURE_KEY});
+
+		command_buffer.dispatch(1, 1, 1);
+	}
+
+	storage_barrier(command_buffer, *exposure_buffer, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_ACCESS_SHADER_WRITE_BIT);
+}
+
+void PostProcessingChain::record(CommandBuffer &command_buffer, const core::ImageView &input)
+{
+	const auto &input_extent = input.get_image().get_extent();
+
+	if (input_extent.width != extent.width || input_extent.height != extent.height)
+	{
+		create_images({input_extent.width, input_extent.height});
+	}
+
+	{
+		// Previous frames may still read the images, their content is replaced
+		ImageMemoryBarrier barrier{};
+		barrier.old_layout      = VK_IMAGE_LAYOUT_UNDEFINED;
+		barrier.new_layout      = VK_IMAGE_LAYOUT_GENERAL;
+		barrier.src_access_mask = 0;
+		barrier.dst_access_mask = VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT;
+		barrier.src_stage_mask  = VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT | VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT;
+		barrier.dst_stage_mask  = VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT;
+
+		for (auto view : bloom_views)
+		{
+			command_buffer.image_memory_barrier(*view, barrier);
+		}
+
+		for (auto view : ldr_views)
+		{
+			command_buffer.image_memory_barrier(*view, barrier);
+		}
+	}
+
+	if (!bloom_views.empty())
+	{
+		record_bloom(command_buffer, input);
+	}
+
+	if (auto_exposure)
+	{
+		record_auto_exposure(command_buffer, input);
+	}
+
+	// Tone map into the first LDR image
+	command_buffer.bind_image(input, *input_sampler, 0, 0, 0);
+
+	if (!bloom_views.empty())
+	{
+		command_buffer.bind_image(*bloom_views[0], 0, 1, 0);
+	}
+
+	command_buffer.bind_image(*ldr_views[0], 0, 2, 0);
+
+	if (auto_exposure)
+	{
+		command_buffer.bind_buffer(*exposure_buffer, 0, exposure_buffer->get_size(), 0, 3, 0);
+	}
+
+	command_buffer.push_constants(TonemapParameters{exposure, bloom_intensity});
+
+	dispatch(command_buffer, tonemap_shader, tonemap_variant, ldr_images[0]->get_extent());
+
+	output_index = 0;
+
+	if (fxaa)
+	{
+		compute_barrier(command_buffer, *ldr_views[0]);
+
+		command_buffer.bind_image(*ldr_views[0], 0, 0, 0);
+		command_buffer.bind_image(*ldr_views[1], 0, 1, 0);
+
+		dispatch(command_buffer, fxaa_shader, fxaa_variant, ldr_images[1]->get_extent());
+
+		output_index = 1;
+	}
+
+	ImageMemoryBarrier barrier{};
+	barrier.old_layout      = VK_IMAGE_LAYOUT_GENERAL;
+	barrier.new_layout      = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+	barrier.src_access_mask = VK_ACCESS_SHADER_WRITE_BIT;
+	barrier.dst_access_mask = VK_ACCESS_SHADER_READ_BIT;
+	barrier.src_stage_mask  = VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT;
+	barrier.dst_stage_mask  = VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT;
+
+	command_buffer.image_memory_barrier(*ldr_views[output_index], barrier);
+}
+
+const core::ImageView &PostProcessingChain::get_output() const
+{
+	assert(!ldr_views.empty() && "Post-processing chain was not recorded");
+	return *ldr_views[output_index];
+}
+}        // namespace vkb
@@ -0,0 +1,216 @@
+/* Copyright (c) 2020, Arm Limited and Contributors
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 the "License";
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include "core/buffer.h"
+#include "core/image.h"
+#include "core/image_view.h"
+#include "core/sampler.h"
+#include "core/shader_module.h"
+#include "timer.h"
+
+namespace vkb
+{
+class CommandBuffer;
+class RenderContext;
+
+/**
+ * @brief Post-processing stages run as compute dispatches in the command stream of the frame,
+ *        instead of a render pass per full screen effect
+ *
+ * The HDR input goes through an optional bloom, tone mapping and an optional FXAA. Auto exposure adapts the
+ * exposure of the tone mapping to a luminance histogram of the input, entirely on the GPU. Stages share
+ * intermediate images which stay in the general layout and are read with image loads, so that
+ * they only need execution and memory dependencies between dispatches. The output is left in
+ * the shader read only layout, for a fragment pass to write it to the swapchain.
+ */
+class PostProcessingChain
+{
+  public:
+	PostProcessingChain(RenderContext &render_context);
+
+	PostProcessingChain(const PostProcessingChain &) = delete;
+
+	PostProcessingChain(PostProcessingChain &&) = delete;
+
+	PostProcessingChain &operator=(const PostProcessingChain &) = delete;
+
+	PostProcessingChain &operator=(PostProcessingChain &&) = delete;
+
+	/**
+	 * @brief Builds the shaders of the enabled stages, which need to be set before
+	 */
+	void prepare();
+
+	/**
+	 * @brief Adds the blurred bright parts of the input to it before tone mapping
+	 */
+	void set_bloom(bool enable);
+
+	/**
+	 * @param threshold Luminance above which the input contributes to the bloom
+	 */
+	void set_bloom_threshold(float threshold);
+
+	/**
+	 * @param intensity Scale of the bloom added to the input
+	 */
+	void set_bloom_intensity(float intensity);
+
+	/**
+	 * @param exposure Exposure of the tone mapping, as in the hdr sample, or the compensation of the adapted exposure
+	 */
+	void set_exposure(float exposure);
+
+	/**
+	 * @brief Adapts the exposure over time to the average luminance of the input, from a histogram computed every frame
+	 *        The exposure never leaves the GPU, so it is applied without waiting for a readback.
+	 */
+	void set_auto_exposure(bool enable);
+
+	/**
+	 * @brief Sets the luminance range of the histogram, darker and brighter pixels are counted in its extreme bins
+	 * @param min_log_luminance Base 2 logarithm of the lowest luminance
+	 * @param max_log_luminance Base 2 logarithm of the highest luminance
+	 */
+	void set_luminance_range(float min_log_luminance, float max_log_luminance);
+
+	/**
+	 * @param rate Speed at which the exposure adapts to a change of luminance, the inverse of its time constant in seconds
+	 */
+	void set_adaptation_rate(float rate);
+
+	/**
+	 * @brief Smooths the edges of the tone mapped image with FXAA
+	 */
+	void set_fxaa(bool enable);
+
+	/**
+	 * @brief Records the stages, outside of a render pass
+	 *        Intermediate images are created again if the extent of the input changes.
+	 * @param command_buffer Command buffer to record the dispatches to
+	 * @param input HDR color to process, in the shader read only layout and visible to compute shaders
+	 */
+	void record(CommandBuffer &command_buffer, const core::ImageView &input);
+
+	/**
+	 * @return The processed image of the last recording, in the shader read only layout
+	 */
+	const core::ImageView &get_output() const;
+
+  private:
+	/**
+	 * @brief Creates the intermediate images for an input extent
+	 */
+	void create_images(const VkExtent2D &extent);
+
+	/**
+	 * @brief Makes the writes of the previous dispatch to an image visible to the next one
+	 */
+	void compute_barrier(CommandBuffer &command_buffer, const core::ImageView &view);
+
+	/**
+	 * @brief Binds a compute shader and dispatches a thread per texel of the output extent
+	 */
+	void dispatch(CommandBuffer &command_buffer, const ShaderSource &shader, const ShaderVariant &variant, const VkExtent3D &extent);
+
+	void record_bloom(CommandBuffer &command_buffer, const core::ImageView &input);
+
+	/**
+	 * @brief Builds the luminance histogram of the input and adapts the exposure to it
+	 */
+	void record_auto_exposure(CommandBuffer &command_buffer, const core::ImageView &input);
+
+	RenderContext &render_context;
+
+	bool bloom{false};
+
+	float bloom_threshold{1.0f};
+
+	float bloom_intensity{0.05f};
+
+	float exposure{1.0f};
+
+	bool fxaa{false};
+
+	bool auto_exposure{false};
+
+	float min_log_luminance{-8.0f};
+
+	float max_log_luminance{4.0f};
+
+	float adaptation_rate{1.5f};
+
+	ShaderSource bloom_downsample_shader;
+
+	ShaderVariant bloom_threshold_variant;
+
+	ShaderVariant bloom_downsample_variant;
+
+	ShaderSource bloom_upsample_shader;
+
+	ShaderVariant bloom_upsample_variant;
+
+	ShaderSource tonemap_shader;
+
+	ShaderVariant tonemap_variant;
+
+	ShaderSource fxaa_shader;
+
+	ShaderVariant fxaa_variant;
+
+	ShaderSource histogram_shader;
+
+	ShaderVariant histogram_variant;
+
+	ShaderSource adaptation_shader;
+
+	ShaderVariant adaptation_variant;
+
+	/// Pixel counts of the luminance bins, cleared by the adaptation
+	std::unique_ptr<core::Buffer> histogram_buffer;
+
+	/// Adapted exposure and average luminance
+	std::unique_ptr<core::Buffer> exposure_buffer;
+
+	/// Whether the histogram and exposure buffers were cleared
+	bool exposure_initialized{false};
+
+	/// Measures the time the exposure adapts over between recordings
+	Timer adaptation_timer;
+
+	std::unique_ptr<core::Sampler> input_sampler;
+
+	VkExtent2D extent{};
+
+	/// Bloom levels from half the input extent down
+	std::vector<std::unique_ptr<core::Image>> bloom_images;
+
+	/// Views owned by the bloom images
+	std::vector<core::ImageView *> bloom_views;
+
+	/// Tone mapped images the LDR stages ping-pong between
+	std::vector<std::unique_ptr<core::Image>> ldr_images;
+
+	/// Views owned by the LDR images
+	std::vector<core::ImageView *> ldr_views;
+
+	/// Index of the LDR image written by the last stage
+	size_t output_index{0};
+};
+}        // namespace vkb
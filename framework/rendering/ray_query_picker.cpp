@@ -0,0 +1,109 @@
+/* Copyright (c) 2020, Arm Limited and Contributors
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 the "License";
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "rendering/ray_query_picker.h"
+
+#include <algorithm>
+#include <cstring>
+
+#include "core/acceleration_structure.h"
+#include "core/command_buffer.h"
+#include "core/device.h"
+
+namespace vkb
+{
+namespace
+{
+/// Invocations of a workgroup of the picking shader, one per ray
+constexpr uint32_t WORKGROUP_SIZE = 64;
+}        // namespace
+
+RayQueryPicker::RayQueryPicker(Device &device) :
+    device{device},
+    shader{"picking/ray_query_pick.comp"}
+{
+	if (!device.is_enabled(VK_KHR_RAY_TRACING_EXTENSION_NAME))
+	{
+		throw std::runtime_error("Ray query picking needs " + std::string(VK_KHR_RAY_TRACING_EXTENSION_NAME));
+	}
+
+	device.get_resource_cache().request_shader_module(VK_SHADER_STAGE_COMPUTE_BIT, shader, shader_variant);
+}
+
+void RayQueryPicker::record(CommandBuffer &command_buffer, const core::AccelerationStructure &top_level, const std::vector<Ray> &rays)
+{
+	ray_count = rays.size();
+
+	if (rays.empty())
+	{
+		return;
+	}
+
+	reserve(rays.size());
+
+	// Host writes before the submission are visible to the device without a barrier
+	ray_buffer->update(reinterpret_cast<const uint8_t *>(rays.data()), rays.size() * sizeof(Ray));
+
+	auto &resource_cache  = device.get_resource_cache();
+	auto &shader_module   = resource_cache.request_shader_module(VK_SHADER_STAGE_COMPUTE_BIT, shader, shader_variant);
+	auto &pipeline_layout = resource_cache.request_pipeline_layout({&shader_module});
+
+	command_buffer.bind_pipeline_layout(pipeline_layout);
+
+	command_buffer.bind_acceleration_structure(top_level, 0, 0, 0);
+	command_buffer.bind_buffer(*ray_buffer, 0, rays.size() * sizeof(Ray), 0, 1, 0);
+	command_buffer.bind_buffer(*hit_buffer, 0, rays.size() * sizeof(Hit), 0, 2, 0);
+
+	command_buffer.push_constants(to_u32(rays.size()));
+
+	command_buffer.dispatch((to_u32(rays.size()) + WORKGROUP_SIZE - 1) / WORKGROUP_SIZE, 1, 1);
+
+	BufferMemoryBarrier barrier;
+	barrier.src_stage_mask  = VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT;
+	barrier.dst_stage_mask  = VK_PIPELINE_STAGE_HOST_BIT;
+	barrier.src_access_mask = VK_ACCESS_SHADER_WRITE_BIT;
+	barrier.dst_access_mask = VK_ACCESS_HOST_READ_BIT;
+
+	command_buffer.buffer_memory_barrier(*hit_buffer, 0, rays.size() * sizeof(Hit), barrier);
+}
+
+std::vector<RayQueryPicker::Hit> RayQueryPicker::get_hits()
+{
+	std::vector<Hit> hits(ray_count);
+
+	if (ray_count > 0)
+	{
+		std::memcpy(hits.data(), hit_buffer->map(), ray_count * sizeof(Hit));
+	}
+
+	return hits;
+}
+
+void RayQueryPicker::reserve(size_t count)
+{
+	if (count <= capacity)
+	{
+		return;
+	}
+
+	// Grows geometrically, so that batches of slowly increasing size do not recreate the buffers every time
+	capacity = std::max(count, capacity * 2);
+
+	ray_buffer = std::make_unique<core::Buffer>(device, capacity * sizeof(Ray), VK_BUFFER_USAGE_STORAGE_BUFFER_BIT, VMA_MEMORY_USAGE_CPU_TO_GPU);
+	hit_buffer = std::make_unique<core::Buffer>(device, capacity * sizeof(Hit), VK_BUFFER_USAGE_STORAGE_BUFFER_BIT, VMA_MEMORY_USAGE_GPU_TO_CPU);
+}
+}        // namespace vkb
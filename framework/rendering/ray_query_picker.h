@@ -0,0 +1,131 @@
+/* Copyright (c) 2020, Arm Limited and Contributors
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 the "License";
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <memory>
+#include <vector>
+
+#include "common/error.h"
+
+VKBP_DISABLE_WARNINGS()
+#include "common/glm_common.h"
+VKBP_ENABLE_WARNINGS()
+
+#include "core/buffer.h"
+#include "core/shader_module.h"
+
+namespace vkb
+{
+class CommandBuffer;
+class Device;
+
+namespace core
+{
+class AccelerationStructure;
+}
+
+/**
+ * @brief Casts a batch of rays against a top level acceleration structure with ray queries in a compute shader
+ *
+ * It is the GPU counterpart of sg::Scene::ray_cast for devices with ray queries, when the scene already has
+ * acceleration structures, for instance built by an AccelerationStructureBuilder. The hits are written to a
+ * host visible buffer, which can be read once the command buffer completed, typically a few frames later.
+ *
+ * It needs the ray query feature of VK_KHR_ray_tracing and shaders compiled for SPIR-V 1.4.
+ */
+class RayQueryPicker
+{
+  public:
+	/**
+	 * @brief A ray to cast, as laid out in the ray buffer
+	 */
+	struct alignas(16) Ray
+	{
+		/// Origin in world space, w is the largest distance of a hit
+		glm::vec4 origin;
+
+		/// Direction in world space, w is unused
+		glm::vec4 direction;
+	};
+
+	/**
+	 * @brief The nearest hit of a ray, as written by the shader
+	 */
+	struct Hit
+	{
+		/// Index of the hit instance, in the order the instances were added to the acceleration structure
+		uint32_t instance;
+
+		/// Index of the hit triangle in the geometry of the instance
+		uint32_t primitive;
+
+		/// Distance to the hit along the direction of the ray, in units of its length
+		float distance;
+
+		/// 1 if the ray hit a triangle, 0 otherwise
+		uint32_t hit;
+	};
+
+	RayQueryPicker(Device &device);
+
+	RayQueryPicker(const RayQueryPicker &) = delete;
+
+	RayQueryPicker(RayQueryPicker &&) = delete;
+
+	RayQueryPicker &operator=(const RayQueryPicker &) = delete;
+
+	RayQueryPicker &operator=(RayQueryPicker &&) = delete;
+
+	/**
+	 * @brief Records the dispatch casting rays, outside of a render pass
+	 *        The buffers are reused, so the previous recording must have completed on the GPU.
+	 * @param command_buffer Command buffer to record the dispatch to
+	 * @param top_level Acceleration structure to cast the rays against, built before the dispatch
+	 * @param rays The rays to cast
+	 */
+	void record(CommandBuffer &command_buffer, const core::AccelerationStructure &top_level, const std::vector<Ray> &rays);
+
+	/**
+	 * @brief Reads the hits of the last recording, which must have completed on the GPU
+	 * @return The hit of every ray, in the order of the rays
+	 */
+	std::vector<Hit> get_hits();
+
+  private:
+	/**
+	 * @brief Creates the ray and hit buffers for a number of rays, if they are not large enough
+	 */
+	void reserve(size_t ray_count);
+
+	Device &device;
+
+	ShaderSource shader;
+
+	ShaderVariant shader_variant;
+
+	std::unique_ptr<core::Buffer> ray_buffer;
+
+	std::unique_ptr<core::Buffer> hit_buffer;
+
+	/// Number of rays the buffers hold
+	size_t capacity{0};
+
+	/// Number of rays of the last recording
+	size_t ray_count{0};
+};
+}        // namespace vkb
@@ -17,19 +17,250 @@
 
 #include "render_context.h"
 
+#include <algorithm>
+#include <limits>
+
+#include "rendering/frame_strategy_tuner.h"
+#include "rendering/render_pass_analyzer.h"
+#include "stats/cpu_profiler.h"
+
 namespace vkb
 {
+namespace
+{
+/**
+ * @brief Raises the demands of every usage and thread to those of other demands
+ */
+void merge_buffer_pool_demands(BufferPoolDemands &demands, const BufferPoolDemands &other)
+{
+	for (auto &other_it : other)
+	{
+		auto &usage_demands = demands[other_it.first];
+
+		if (usage_demands.size() < other_it.second.size())
+		{
+			usage_demands.resize(other_it.second.size());
+		}
+
+		for (size_t i = 0; i < other_it.second.size(); ++i)
+		{
+			usage_demands[i].block_count = std::max(usage_demands[i].block_count, other_it.second[i].block_count);
+			usage_demands[i].stream_size = std::max(usage_demands[i].stream_size, other_it.second[i].stream_size);
+		}
+	}
+}
+}        // namespace
+
 VkFormat RenderContext::DEFAULT_VK_FORMAT = VK_FORMAT_R8G8B8A8_SRGB;
 
+constexpr uint32_t RenderContext::NO_IMAGE;
+
+constexpr uint32_t RenderContext::HEADLESS_FRAME_COUNT;
+
 RenderContext::RenderContext(Device &device, VkSurfaceKHR surface, uint32_t window_width, uint32_t window_height) :
     device{device},
-    queue{device.get_suitable_graphics_queue()},
+    queue{device.get_queue_by_role(QueueRole::Graphics)},
+    compute_queue{device.get_queue_by_role(QueueRole::Compute)},
+    graphics_batch{queue},
+    compute_batch{compute_queue},
     surface_extent{window_width, window_height}
 {
 	if (surface != VK_NULL_HANDLE)
 	{
 		swapchain = std::make_unique<Swapchain>(device, surface);
 	}
+
+	if (device.is_enabled(VK_KHR_TIMELINE_SEMAPHORE_EXTENSION_NAME))
+	{
+		VkSemaphoreTypeCreateInfoKHR type_info{VK_STRUCTURE_TYPE_SEMAPHORE_TYPE_CREATE_INFO_KHR};
+		type_info.semaphoreType = VK_SEMAPHORE_TYPE_TIMELINE_KHR;
+		type_info.initialValue  = 0;
+
+		VkSemaphoreCreateInfo create_info{VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO};
+		create_info.pNext = &type_info;
+
+		VK_CHECK(vkCreateSemaphore(device.get_handle(), &create_info, nullptr, &timeline_semaphore));
+	}
+
+	present_timing = swapchain && device.is_enabled(VK_KHR_PRESENT_ID_EXTENSION_NAME) && device.is_enabled(VK_KHR_PRESENT_WAIT_EXTENSION_NAME);
+}
+
+RenderContext::~RenderContext()
+{
+	if (timeline_semaphore != VK_NULL_HANDLE)
+	{
+		vkDestroySemaphore(device.get_handle(), timeline_semaphore, nullptr);
+	}
+}
+
+void RenderContext::set_frames_in_flight(uint32_t count)
+{
+	frames_in_flight = count;
+}
+
+void RenderContext::set_descriptor_set_budget(size_t budget)
+{
+	descriptor_set_budget = budget;
+}
+
+void RenderContext::reserve_buffer_pools(const BufferPoolDemands &demands)
+{
+	merge_buffer_pool_demands(buffer_pool_reservations, demands);
+}
+
+BufferPoolDemands RenderContext::get_buffer_pool_high_water_marks() const
+{
+	BufferPoolDemands demands = buffer_pool_reservations;
+
+	for (auto &frame : frames)
+	{
+		merge_buffer_pool_demands(demands, frame->get_buffer_pool_high_water_marks());
+	}
+
+	return demands;
+}
+
+uint64_t RenderContext::get_frame_number() const
+{
+	return frame_number;
+}
+
+bool RenderContext::has_timeline_semaphore() const
+{
+	return timeline_semaphore != VK_NULL_HANDLE;
+}
+
+void RenderContext::set_late_latch_callback(std::function<void(RenderFrame &)> callback)
+{
+	late_latch_callback = std::move(callback);
+}
+
+void RenderContext::set_gpu_profiler(GpuProfiler *profiler)
+{
+	gpu_profiler = profiler;
+}
+
+GpuProfiler *RenderContext::get_gpu_profiler() const
+{
+	return gpu_profiler;
+}
+
+void RenderContext::set_stats(Stats *new_stats)
+{
+	stats = new_stats;
+}
+
+Stats *RenderContext::get_stats() const
+{
+	return stats;
+}
+
+void RenderContext::set_render_pass_analyzer(RenderPassAnalyzer *analyzer)
+{
+	render_pass_analyzer = analyzer;
+}
+
+RenderPassAnalyzer *RenderContext::get_render_pass_analyzer() const
+{
+	return render_pass_analyzer;
+}
+
+void RenderContext::set_frame_strategy_tuner(FrameStrategyTuner *tuner)
+{
+	frame_strategy_tuner = tuner;
+}
+
+FrameStrategyTuner *RenderContext::get_frame_strategy_tuner() const
+{
+	return frame_strategy_tuner;
+}
+
+void RenderContext::set_alternate_frame_rendering(bool enable)
+{
+	if (enable && device.get_device_count() < 2)
+	{
+		LOGW("Alternate frame rendering needs a device group, frames are rendered by a single GPU");
+
+		enable = false;
+	}
+	else if (enable && swapchain && (device.get_device_group_present_modes() & VK_DEVICE_GROUP_PRESENT_MODE_REMOTE_BIT_KHR) == 0)
+	{
+		LOGW("GPUs of the device group can't present remotely, every frame is rendered by all of them");
+
+		enable = false;
+	}
+
+	alternate_frame_rendering = enable;
+	frame_device_index        = 0;
+}
+
+bool RenderContext::has_alternate_frame_rendering() const
+{
+	return alternate_frame_rendering;
+}
+
+uint32_t RenderContext::get_frame_device_index() const
+{
+	return frame_device_index;
+}
+
+uint32_t RenderContext::get_frame_device_mask() const
+{
+	return alternate_frame_rendering ? 1u << frame_device_index : 0u;
+}
+
+bool RenderContext::has_present_timing() const
+{
+	return present_timing;
+}
+
+double RenderContext::get_input_to_present_latency() const
+{
+	return input_to_present_latency;
+}
+
+double RenderContext::get_present_to_display_latency() const
+{
+	return present_to_display_latency;
+}
+
+void RenderContext::wait_for_display()
+{
+	if (pending_presents.empty())
+	{
+		return;
+	}
+
+	PROFILE_SCOPE("Wait for display");
+
+	// A present which is never displayed, for example while the display is off, only delays the frame up to the timeout
+	vkWaitForPresentKHR(device.get_handle(), swapchain->get_handle(), pending_presents.back().present_id, DISPLAY_WAIT_TIMEOUT);
+}
+
+void RenderContext::poll_presents()
+{
+	auto now = Timer::Clock::now();
+
+	// Presents are displayed in order, so the first one not displayed yet ends the search
+	while (!pending_presents.empty())
+	{
+		auto &pending_present = pending_presents.front();
+
+		VkResult result = vkWaitForPresentKHR(device.get_handle(), swapchain->get_handle(), pending_present.present_id, 0);
+
+		if (result == VK_TIMEOUT)
+		{
+			break;
+		}
+
+		if (result == VK_SUCCESS)
+		{
+			input_to_present_latency   = std::chrono::duration<double>(now - pending_present.input_time).count();
+			present_to_display_latency = std::chrono::duration<double>(now - pending_present.present_time).count();
+		}
+
+		pending_presents.pop_front();
+	}
 }
 
 void RenderContext::request_present_mode(const VkPresentModeKHR present_mode)
@@ -41,6 +272,23 @@ void RenderContext::request_present_mode(const VkPresentModeKHR present_mode)
 	}
 }
 
+void RenderContext::request_frame_count(uint32_t frame_count)
+{
+	requested_frame_count = frame_count;
+}
+
+void RenderContext::reserve_command_buffers(uint32_t primary_count, uint32_t secondary_count, CommandBuffer::ResetMode reset_mode)
+{
+	reserved_primary_command_buffers   = primary_count;
+	reserved_secondary_command_buffers = secondary_count;
+	reserved_command_buffer_reset_mode = reset_mode;
+
+	for (auto &frame : frames)
+	{
+		reserve_frame_command_buffers(*frame);
+	}
+}
+
 void RenderContext::request_image_format(const VkFormat format)
 {
 	if (swapchain)
@@ -48,6 +296,10 @@ void RenderContext::request_image_format(const VkFormat format)
 		auto &properties                 = swapchain->get_properties();
 		properties.surface_format.format = format;
 	}
+	else
+	{
+		headless_format = format;
+	}
 }
 
 void RenderContext::prepare(size_t thread_count, RenderTarget::CreateFunc create_render_target_func)
@@ -56,38 +308,92 @@ void RenderContext::prepare(size_t thread_count, RenderTarget::CreateFunc create
 
 	if (swapchain)
 	{
+		if (present_latency_mode != PresentLatencyMode::Default)
+		{
+			VkSurfaceCapabilitiesKHR surface_capabilities{};
+			VK_CHECK(vkGetPhysicalDeviceSurfaceCapabilitiesKHR(device.get_gpu().get_handle(), swapchain->get_surface(), &surface_capabilities));
+
+			auto &properties       = swapchain->get_properties();
+			properties.image_count = std::max(2U, surface_capabilities.minImageCount);
+
+			if (present_latency_mode == PresentLatencyMode::Immediate)
+			{
+				properties.present_mode    = VK_PRESENT_MODE_IMMEDIATE_KHR;
+				present_mode_priority_list = {VK_PRESENT_MODE_IMMEDIATE_KHR, VK_PRESENT_MODE_MAILBOX_KHR, VK_PRESENT_MODE_FIFO_KHR};
+			}
+			else
+			{
+				properties.present_mode    = VK_PRESENT_MODE_MAILBOX_KHR;
+				present_mode_priority_list = {VK_PRESENT_MODE_MAILBOX_KHR, VK_PRESENT_MODE_FIFO_KHR};
+			}
+
+			if (!present_timing)
+			{
+				LOGW("Presents cannot be waited for without VK_KHR_present_wait, frames will not start after their previous one is displayed");
+			}
+		}
+
 		swapchain->set_present_mode_priority(present_mode_priority_list);
 		swapchain->set_surface_format_priority(surface_format_priority_list);
 		swapchain->create();
 
 		surface_extent = swapchain->get_extent();
 
-		VkExtent3D extent{surface_extent.width, surface_extent.height, 1};
+		if (requested_frame_count > 0)
+		{
+			this->create_render_target_func = create_render_target_func;
+
+			create_image_render_targets();
 
-		for (auto &image_handle : swapchain->get_images())
+			// Frames take the render target of their swapchain image once they acquire it
+			for (uint32_t i = 0; i < requested_frame_count; ++i)
+			{
+				frames.emplace_back(std::make_unique<RenderFrame>(device, nullptr, thread_count));
+				frame_image_indices.push_back(NO_IMAGE);
+			}
+		}
+		else
 		{
-			auto swapchain_image = core::Image{
-			    device, image_handle,
-			    extent,
-			    swapchain->get_format(),
-			    swapchain->get_usage()};
-			auto render_target = create_render_target_func(std::move(swapchain_image));
-			frames.emplace_back(std::make_unique<RenderFrame>(device, std::move(render_target), thread_count));
+			VkExtent3D extent{surface_extent.width, surface_extent.height, 1};
+
+			for (auto &image_handle : swapchain->get_images())
+			{
+				auto swapchain_image = core::Image{
+				    device, image_handle,
+				    extent,
+				    swapchain->get_format(),
+				    swapchain->get_usage()};
+				auto render_target = create_render_target_func(std::move(swapchain_image));
+				frames.emplace_back(std::make_unique<RenderFrame>(device, std::move(render_target), thread_count));
+			}
 		}
 	}
 	else
 	{
-		// Otherwise, create a single RenderFrame
+		// Otherwise, create frames rendering to their own images
 		swapchain = nullptr;
 
-		auto color_image = core::Image{device,
-		                               VkExtent3D{surface_extent.width, surface_extent.height, 1},
-		                               DEFAULT_VK_FORMAT,        // We can use any format here that we like
-		                               VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT | VK_IMAGE_USAGE_TRANSFER_SRC_BIT,
-		                               VMA_MEMORY_USAGE_GPU_ONLY};
+		uint32_t frame_count = requested_frame_count > 0 ? requested_frame_count : HEADLESS_FRAME_COUNT;
 
-		auto render_target = create_render_target_func(std::move(color_image));
-		frames.emplace_back(std::make_unique<RenderFrame>(device, std::move(render_target), thread_count));
+		for (uint32_t i = 0; i < frame_count; ++i)
+		{
+			auto color_image = core::Image{device,
+			                               VkExtent3D{surface_extent.width, surface_extent.height, 1},
+			                               headless_format,
+			                               VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT | VK_IMAGE_USAGE_TRANSFER_SRC_BIT,
+			                               VMA_MEMORY_USAGE_GPU_ONLY};
+
+			auto render_target = create_render_target_func(std::move(color_image));
+			frames.emplace_back(std::make_unique<RenderFrame>(device, std::move(render_target), thread_count));
+		}
+
+		// The first frame begun is the first one created
+		active_frame_index = frame_count - 1;
+	}
+
+	for (auto &frame : frames)
+	{
+		reserve_frame_command_buffers(*frame);
 	}
 
 	this->create_render_target_func = create_render_target_func;
@@ -100,6 +406,16 @@ void RenderContext::set_present_mode_priority(const std::vector<VkPresentModeKHR
 	this->present_mode_priority_list = new_present_mode_priority_list;
 }
 
+void RenderContext::set_present_latency_mode(PresentLatencyMode mode)
+{
+	present_latency_mode = mode;
+}
+
+PresentLatencyMode RenderContext::get_present_latency_mode() const
+{
+	return present_latency_mode;
+}
+
 void RenderContext::set_surface_format_priority(const std::vector<VkSurfaceFormatKHR> &new_surface_format_priority_list)
 {
 	this->surface_format_priority_list = new_surface_format_priority_list;
@@ -107,7 +423,7 @@ void RenderContext::set_surface_format_priority(const std::vector<VkSurfaceForma
 
 VkFormat RenderContext::get_format()
 {
-	VkFormat format = DEFAULT_VK_FORMAT;
+	VkFormat format = headless_format;
 
 	if (swapchain)
 	{
@@ -125,9 +441,7 @@ void RenderContext::update_swapchain(const VkExtent2D &extent)
 		return;
 	}
 
-	device.get_resource_cache().clear_framebuffers();
-
-	swapchain = std::make_unique<Swapchain>(*swapchain, extent);
+	replace_swapchain(std::make_unique<Swapchain>(*swapchain, extent));
 
 	recreate();
 }
@@ -157,13 +471,33 @@ void RenderContext::update_swapchain(const std::set<VkImageUsageFlagBits> &image
 		return;
 	}
 
-	device.get_resource_cache().clear_framebuffers();
-
-	swapchain = std::make_unique<Swapchain>(*swapchain, image_usage_flags);
+	replace_swapchain(std::make_unique<Swapchain>(*swapchain, image_usage_flags));
 
 	recreate();
 }
 
+void RenderContext::add_swapchain_usage(VkImageUsageFlagBits usage)
+{
+	if (!swapchain || (swapchain->get_usage() & usage))
+	{
+		return;
+	}
+
+	std::set<VkImageUsageFlagBits> image_usage_flags{usage};
+
+	VkImageUsageFlags current_usage = swapchain->get_usage();
+
+	for (uint32_t bit = 1; bit != 0 && bit <= current_usage; bit <<= 1)
+	{
+		if (current_usage & bit)
+		{
+			image_usage_flags.insert(static_cast<VkImageUsageFlagBits>(bit));
+		}
+	}
+
+	update_swapchain(image_usage_flags);
+}
+
 void RenderContext::update_swapchain(const VkExtent2D &extent, const VkSurfaceTransformFlagBitsKHR transform)
 {
 	if (!swapchain)
@@ -172,8 +506,6 @@ void RenderContext::update_swapchain(const VkExtent2D &extent, const VkSurfaceTr
 		return;
 	}
 
-	device.get_resource_cache().clear_framebuffers();
-
 	auto width  = extent.width;
 	auto height = extent.height;
 	if (transform == VK_SURFACE_TRANSFORM_ROTATE_90_BIT_KHR || transform == VK_SURFACE_TRANSFORM_ROTATE_270_BIT_KHR)
@@ -182,7 +514,7 @@ void RenderContext::update_swapchain(const VkExtent2D &extent, const VkSurfaceTr
 		std::swap(width, height);
 	}
 
-	swapchain = std::make_unique<Swapchain>(*swapchain, VkExtent2D{width, height}, transform);
+	replace_swapchain(std::make_unique<Swapchain>(*swapchain, VkExtent2D{width, height}, transform));
 
 	// Save the preTransform attribute for future rotations
 	pre_transform = transform;
@@ -194,6 +526,15 @@ void RenderContext::recreate()
 {
 	LOGI("Recreated swapchain");
 
+	// Presents to the previous swapchain can no longer be waited for
+	pending_presents.clear();
+
+	if (has_requested_frame_count())
+	{
+		create_image_render_targets();
+		return;
+	}
+
 	VkExtent2D swapchain_extent = swapchain->get_extent();
 	VkExtent3D extent{swapchain_extent.width, swapchain_extent.height, 1};
 
@@ -210,12 +551,15 @@ void RenderContext::recreate()
 
 		if (frame_it != frames.end())
 		{
+			retire_render_target((*frame_it)->release_render_target());
 			(*frame_it)->update_render_target(std::move(render_target));
 		}
 		else
 		{
 			// Create a new frame if the new swapchain has more images than current frames
 			frames.emplace_back(std::make_unique<RenderFrame>(device, std::move(render_target), thread_count));
+
+			reserve_frame_command_buffers(*frames.back());
 		}
 
 		++frame_it;
@@ -241,9 +585,7 @@ void RenderContext::handle_surface_changes()
 	if (surface_properties.currentExtent.width != surface_extent.width ||
 	    surface_properties.currentExtent.height != surface_extent.height)
 	{
-		// Recreate swapchain
-		device.wait_idle();
-
+		// The previous swapchain is retired while the frames in flight finish with it
 		update_swapchain(surface_properties.currentExtent, pre_transform);
 
 		surface_extent = surface_properties.currentExtent;
@@ -256,21 +598,37 @@ CommandBuffer &RenderContext::begin(CommandBuffer::ResetMode reset_mode)
 
 	acquired_semaphore = begin_frame();
 
-	if (acquired_semaphore == VK_NULL_HANDLE)
+	if (swapchain && acquired_semaphore == VK_NULL_HANDLE)
 	{
 		throw std::runtime_error("Couldn't begin frame");
 	}
 
-	const auto &queue = device.get_queue_by_flags(VK_QUEUE_GRAPHICS_BIT, 0);
+	frame_input_time = Timer::Clock::now();
+
+	if (frame_strategy_tuner)
+	{
+		frame_strategy_tuner->begin_frame(get_active_frame());
+	}
+
+	const auto &queue = device.get_queue_by_role(QueueRole::Graphics);
 	return get_active_frame().request_command_buffer(queue, reset_mode);
 }
 
 void RenderContext::submit(CommandBuffer &command_buffer)
 {
+	PROFILE_FUNCTION();
+
 	assert(frame_active && "RenderContext is inactive, cannot submit command buffer. Please call begin()");
 
 	VkSemaphore render_semaphore = VK_NULL_HANDLE;
 
+	if (late_latch_callback)
+	{
+		late_latch_callback(get_active_frame());
+
+		frame_input_time = Timer::Clock::now();
+	}
+
 	if (swapchain)
 	{
 		render_semaphore = submit(queue, command_buffer, acquired_semaphore, VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT);
@@ -287,6 +645,8 @@ void RenderContext::submit(CommandBuffer &command_buffer)
 
 VkSemaphore RenderContext::begin_frame()
 {
+	PROFILE_FUNCTION();
+
 	// Only handle surface changes if a swapchain exists
 	if (swapchain)
 	{
@@ -295,31 +655,58 @@ VkSemaphore RenderContext::begin_frame()
 
 	assert(!frame_active && "Frame is still active, please call end_frame");
 
+	if (present_timing)
+	{
+		if (present_latency_mode != PresentLatencyMode::Default)
+		{
+			wait_for_display();
+		}
+
+		poll_presents();
+	}
+
+	if (alternate_frame_rendering)
+	{
+		frame_device_index = (frame_device_index + 1) % device.get_device_count();
+	}
+
+	if (!swapchain)
+	{
+		begin_headless_frame();
+
+		return VK_NULL_HANDLE;
+	}
+
+	if (has_requested_frame_count())
+	{
+		return begin_requested_frame();
+	}
+
 	auto &prev_frame = *frames.at(active_frame_index);
 
 	auto aquired_semaphore = prev_frame.request_semaphore();
 
-	if (swapchain)
-	{
-		auto fence = prev_frame.request_fence();
+	auto fence = prev_frame.request_fence();
 
-		auto result = swapchain->acquire_next_image(active_frame_index, aquired_semaphore, fence);
+	auto result = swapchain->acquire_next_image(active_image_index, aquired_semaphore, fence, get_frame_device_mask());
 
-		if (result == VK_SUBOPTIMAL_KHR || result == VK_ERROR_OUT_OF_DATE_KHR)
-		{
-			handle_surface_changes();
+	if (result == VK_SUBOPTIMAL_KHR || result == VK_ERROR_OUT_OF_DATE_KHR)
+	{
+		handle_surface_changes();
 
-			result = swapchain->acquire_next_image(active_frame_index, aquired_semaphore, fence);
-		}
+		result = swapchain->acquire_next_image(active_image_index, aquired_semaphore, fence, get_frame_device_mask());
+	}
 
-		if (result != VK_SUCCESS)
-		{
-			prev_frame.reset();
+	if (result != VK_SUCCESS)
+	{
+		prev_frame.reset();
 
-			return VK_NULL_HANDLE;
-		}
+		return VK_NULL_HANDLE;
 	}
 
+	// There is a frame for each swapchain image
+	active_frame_index = active_image_index;
+
 	// Now the frame is active again
 	frame_active = true;
 
@@ -328,8 +715,181 @@ VkSemaphore RenderContext::begin_frame()
 	return aquired_semaphore;
 }
 
+VkSemaphore RenderContext::begin_requested_frame()
+{
+	active_frame_index = (active_frame_index + 1) % to_u32(frames.size());
+
+	frame_active = true;
+
+	wait_frame();
+
+	auto &frame = get_active_frame();
+
+	auto aquired_semaphore = frame.request_semaphore();
+	auto fence             = frame.request_fence();
+
+	auto result = swapchain->acquire_next_image(active_image_index, aquired_semaphore, fence, get_frame_device_mask());
+
+	if (result == VK_SUBOPTIMAL_KHR || result == VK_ERROR_OUT_OF_DATE_KHR)
+	{
+		handle_surface_changes();
+
+		result = swapchain->acquire_next_image(active_image_index, aquired_semaphore, fence, get_frame_device_mask());
+	}
+
+	if (result != VK_SUCCESS)
+	{
+		frame_active = false;
+
+		return VK_NULL_HANDLE;
+	}
+
+	bind_image_render_target();
+
+	return aquired_semaphore;
+}
+
+void RenderContext::begin_headless_frame()
+{
+	active_frame_index = (active_frame_index + 1) % to_u32(frames.size());
+
+	frame_active = true;
+
+	// Nothing is acquired, so the frame only has to be done with its previous submissions
+	wait_frame();
+}
+
+void RenderContext::bind_image_render_target()
+{
+	auto &held_image_index = frame_image_indices[active_frame_index];
+
+	if (held_image_index == active_image_index)
+	{
+		return;
+	}
+
+	if (held_image_index != NO_IMAGE)
+	{
+		image_render_targets[held_image_index] = frames[active_frame_index]->release_render_target();
+	}
+
+	// The image may still be held by the last frame which rendered to it
+	for (size_t i = 0; i < frames.size(); ++i)
+	{
+		if (frame_image_indices[i] == active_image_index)
+		{
+			image_render_targets[active_image_index] = frames[i]->release_render_target();
+			frame_image_indices[i]                   = NO_IMAGE;
+		}
+	}
+
+	frames[active_frame_index]->update_render_target(std::move(image_render_targets[active_image_index]));
+	held_image_index = active_image_index;
+}
+
+void RenderContext::create_image_render_targets()
+{
+	for (size_t i = 0; i < frame_image_indices.size(); ++i)
+	{
+		retire_render_target(frames[i]->release_render_target());
+		frame_image_indices[i] = NO_IMAGE;
+	}
+
+	for (auto &render_target : image_render_targets)
+	{
+		retire_render_target(std::move(render_target));
+	}
+
+	image_render_targets.clear();
+
+	VkExtent2D swapchain_extent = swapchain->get_extent();
+	VkExtent3D extent{swapchain_extent.width, swapchain_extent.height, 1};
+
+	for (auto &image_handle : swapchain->get_images())
+	{
+		core::Image swapchain_image{device, image_handle,
+		                            extent,
+		                            swapchain->get_format(),
+		                            swapchain->get_usage()};
+
+		image_render_targets.push_back(create_render_target_func(std::move(swapchain_image)));
+	}
+}
+
+void RenderContext::replace_swapchain(std::unique_ptr<Swapchain> &&new_swapchain)
+{
+	RetiredSwapchain retired;
+	retired.swapchain = std::move(swapchain);
+
+	// Framebuffers reference the views of the old images, the new ones are created on first use
+	retired.framebuffers = device.get_resource_cache().release_framebuffers();
+
+	retired.pending_frames.assign(frames.size(), true);
+
+	retired_swapchains.push_back(std::move(retired));
+
+	swapchain = std::move(new_swapchain);
+}
+
+void RenderContext::retire_render_target(std::unique_ptr<RenderTarget> &&render_target)
+{
+	if (!render_target)
+	{
+		return;
+	}
+
+	if (retired_swapchains.empty())
+	{
+		// Only reached once the device is idle, when nothing was replaced
+		render_target.reset();
+		return;
+	}
+
+	retired_swapchains.back().render_targets.push_back(std::move(render_target));
+}
+
+void RenderContext::release_retired_swapchains()
+{
+	for (auto &retired : retired_swapchains)
+	{
+		for (size_t i = 0; i < retired.pending_frames.size(); ++i)
+		{
+			// The active frame has just waited for its submissions
+			if (retired.pending_frames[i] && (i == active_frame_index || i >= frames.size() || frames[i]->is_idle()))
+			{
+				retired.pending_frames[i] = false;
+			}
+		}
+	}
+
+	// Swapchains are destroyed in the order they were replaced
+	while (!retired_swapchains.empty() &&
+	       std::none_of(retired_swapchains.front().pending_frames.begin(), retired_swapchains.front().pending_frames.end(), [](bool pending) { return pending; }))
+	{
+		retired_swapchains.pop_front();
+	}
+}
+
+bool RenderContext::has_requested_frame_count() const
+{
+	return swapchain && requested_frame_count > 0;
+}
+
+void RenderContext::reserve_frame_command_buffers(RenderFrame &frame)
+{
+	if (reserved_primary_command_buffers == 0 && reserved_secondary_command_buffers == 0)
+	{
+		return;
+	}
+
+	const auto &queue = device.get_queue_by_role(QueueRole::Graphics);
+	frame.reserve_command_buffers(queue, reserved_command_buffer_reset_mode, reserved_primary_command_buffers, reserved_secondary_command_buffers);
+}
+
 VkSemaphore RenderContext::submit(const Queue &queue, const CommandBuffer &command_buffer, VkSemaphore wait_semaphore, VkPipelineStageFlags wait_pipeline_stage)
 {
+	PROFILE_FUNCTION();
+
 	RenderFrame &frame = get_active_frame();
 
 	VkSemaphore signal_semaphore = frame.request_semaphore();
@@ -346,16 +906,17 @@ VkSemaphore RenderContext::submit(const Queue &queue, const CommandBuffer &comma
 	submit_info.signalSemaphoreCount = 1;
 	submit_info.pSignalSemaphores    = &signal_semaphore;
 
-	VkFence fence = frame.request_fence();
+	submit_frame(queue, submit_info);
 
-	queue.submit({submit_info}, fence);
+	// A semaphore may only be waited for once the submission signaling it was issued
+	flush_submissions();
 
 	return signal_semaphore;
 }
 
 void RenderContext::submit(const Queue &queue, const CommandBuffer &command_buffer)
 {
-	RenderFrame &frame = get_active_frame();
+	PROFILE_FUNCTION();
 
 	VkCommandBuffer cmd_buf = command_buffer.get_handle();
 
@@ -364,20 +925,218 @@ void RenderContext::submit(const Queue &queue, const CommandBuffer &command_buff
 	submit_info.commandBufferCount = 1;
 	submit_info.pCommandBuffers    = &cmd_buf;
 
-	VkFence fence = frame.request_fence();
+	submit_frame(queue, submit_info);
+}
+
+CommandBuffer &RenderContext::request_compute_command_buffer(CommandBuffer::ResetMode reset_mode)
+{
+	assert(frame_active && "RenderContext is inactive, cannot request a compute command buffer. Please call begin()");
+
+	return get_active_frame().request_command_buffer(compute_queue, reset_mode);
+}
+
+void RenderContext::submit_compute(const CommandBuffer &command_buffer, VkPipelineStageFlags wait_pipeline_stage)
+{
+	assert(frame_active && "RenderContext is inactive, cannot submit compute work. Please call begin()");
+
+	RenderFrame &frame = get_active_frame();
+
+	VkSemaphore signal_semaphore = frame.request_semaphore();
+
+	VkCommandBuffer cmd_buf = command_buffer.get_handle();
+
+	VkSubmitInfo submit_info{VK_STRUCTURE_TYPE_SUBMIT_INFO};
+
+	submit_info.commandBufferCount   = 1;
+	submit_info.pCommandBuffers      = &cmd_buf;
+	submit_info.signalSemaphoreCount = 1;
+	submit_info.pSignalSemaphores    = &signal_semaphore;
+
+	// Timeline values are signaled in order by graphics submissions, which wait for this one
+	get_submit_batch(compute_queue)->add(submit_info);
+
+	compute_wait_semaphores.push_back(signal_semaphore);
+	compute_wait_stages.push_back(wait_pipeline_stage);
+}
 
-	queue.submit({submit_info}, fence);
+const Queue &RenderContext::get_compute_queue() const
+{
+	return compute_queue;
+}
+
+bool RenderContext::has_async_compute() const
+{
+	return compute_queue.get_family_index() != queue.get_family_index();
+}
+
+void RenderContext::submit_frame(const Queue &queue, VkSubmitInfo &submit_info)
+{
+	RenderFrame &frame = get_active_frame();
+
+	// Pending compute work of the frame is waited for by the first submission after it
+	std::vector<VkSemaphore>          wait_semaphores(submit_info.pWaitSemaphores, submit_info.pWaitSemaphores + submit_info.waitSemaphoreCount);
+	std::vector<VkPipelineStageFlags> wait_stages(submit_info.pWaitDstStageMask, submit_info.pWaitDstStageMask + submit_info.waitSemaphoreCount);
+
+	if (!compute_wait_semaphores.empty())
+	{
+		wait_semaphores.insert(wait_semaphores.end(), compute_wait_semaphores.begin(), compute_wait_semaphores.end());
+		wait_stages.insert(wait_stages.end(), compute_wait_stages.begin(), compute_wait_stages.end());
+
+		compute_wait_semaphores.clear();
+		compute_wait_stages.clear();
+
+		submit_info.waitSemaphoreCount = to_u32(wait_semaphores.size());
+		submit_info.pWaitSemaphores    = wait_semaphores.data();
+		submit_info.pWaitDstStageMask  = wait_stages.data();
+	}
+
+	SubmitBatch *batch = get_submit_batch(queue);
+
+	if (timeline_semaphore == VK_NULL_HANDLE)
+	{
+		if (batch)
+		{
+			// The fence of the flush covers the submission
+			batch->add(submit_info);
+		}
+		else
+		{
+			queue.submit({submit_info}, frame.request_fence());
+		}
+
+		return;
+	}
+
+	// The timeline semaphore is signaled after the binary semaphores of the submission
+	std::vector<VkSemaphore> signal_semaphores(submit_info.pSignalSemaphores, submit_info.pSignalSemaphores + submit_info.signalSemaphoreCount);
+	signal_semaphores.push_back(timeline_semaphore);
+
+	// Values of binary semaphores are ignored
+	std::vector<uint64_t> signal_values(signal_semaphores.size(), 0);
+	signal_values.back() = ++timeline_value;
+
+	VkTimelineSemaphoreSubmitInfoKHR timeline_info{VK_STRUCTURE_TYPE_TIMELINE_SEMAPHORE_SUBMIT_INFO_KHR};
+	timeline_info.signalSemaphoreValueCount = to_u32(signal_values.size());
+	timeline_info.pSignalSemaphoreValues    = signal_values.data();
+
+	submit_info.pNext                = &timeline_info;
+	submit_info.signalSemaphoreCount = to_u32(signal_semaphores.size());
+	submit_info.pSignalSemaphores    = signal_semaphores.data();
+
+	if (batch)
+	{
+		batch->add(submit_info);
+	}
+	else
+	{
+		queue.submit({submit_info}, VK_NULL_HANDLE);
+	}
+
+	frame.set_timeline_value(timeline_semaphore, timeline_value);
+}
+
+SubmitBatch *RenderContext::get_submit_batch(const Queue &queue)
+{
+	if (queue.get_handle() == this->queue.get_handle())
+	{
+		return &graphics_batch;
+	}
+
+	// Without a dedicated compute queue, compute submissions keep their order among graphics ones
+	if (queue.get_handle() == compute_queue.get_handle())
+	{
+		return &compute_batch;
+	}
+
+	return nullptr;
+}
+
+void RenderContext::submit_deferred(const Queue &queue, const CommandBuffer &command_buffer)
+{
+	SubmitBatch *batch = get_submit_batch(queue);
+
+	if (!batch)
+	{
+		throw std::runtime_error("Deferred submissions need the graphics or compute queue of the render context");
+	}
+
+	batch->add(command_buffer);
+}
+
+void RenderContext::flush_submissions()
+{
+	RenderFrame &frame = get_active_frame();
+
+	// Compute submissions signal semaphores which graphics ones wait for, so they have to be issued first
+	if (!compute_batch.empty())
+	{
+		VK_CHECK(compute_batch.flush(frame.request_fence(), get_frame_device_mask()));
+	}
+
+	if (!graphics_batch.empty())
+	{
+		// Timeline values signaled by the batch cover it, otherwise the frame waits for a fence
+		VK_CHECK(graphics_batch.flush(timeline_semaphore == VK_NULL_HANDLE ? frame.request_fence() : VK_NULL_HANDLE, get_frame_device_mask()));
+	}
 }
 
 void RenderContext::wait_frame()
 {
+	wait_frames_in_flight();
+
 	RenderFrame &frame = get_active_frame();
+
+	// Frames may have been recreated since the budget was set
+	frame.set_descriptor_set_budget(descriptor_set_budget);
 	frame.reset();
+
+	if (!buffer_pool_reservations.empty())
+	{
+		frame.reserve_buffer_pools(buffer_pool_reservations);
+	}
+
+	if (frame_numbers.size() != frames.size())
+	{
+		frame_numbers.assign(frames.size(), 0);
+	}
+
+	frame_numbers[active_frame_index] = ++frame_number;
+
+	// A frame older than the last one of every render frame was waited for when its render frame was reused,
+	// whatever the order swapchain images are acquired in
+	auto oldest_frame_in_flight = *std::min_element(frame_numbers.begin(), frame_numbers.end());
+	device.get_resource_cache().begin_frame(frame_number, oldest_frame_in_flight);
+
+	if (!retired_swapchains.empty())
+	{
+		release_retired_swapchains();
+	}
+}
+
+void RenderContext::wait_frames_in_flight()
+{
+	if (timeline_semaphore == VK_NULL_HANDLE || frames_in_flight == 0 || frame_timeline_values.size() < frames_in_flight)
+	{
+		return;
+	}
+
+	// Frames in flight beyond the limit must have finished before recording another one
+	uint64_t value = frame_timeline_values[frame_timeline_values.size() - frames_in_flight];
+
+	VkSemaphoreWaitInfoKHR wait_info{VK_STRUCTURE_TYPE_SEMAPHORE_WAIT_INFO_KHR};
+	wait_info.semaphoreCount = 1;
+	wait_info.pSemaphores    = &timeline_semaphore;
+	wait_info.pValues        = &value;
+
+	VK_CHECK(vkWaitSemaphoresKHR(device.get_handle(), &wait_info, std::numeric_limits<uint64_t>::max()));
 }
 
 void RenderContext::end_frame(VkSemaphore semaphore)
 {
 	assert(frame_active && "Frame is not active, please call begin_frame");
+	assert(compute_wait_semaphores.empty() && "Compute work of the frame was not followed by a graphics submission");
+
+	flush_submissions();
 
 	if (swapchain)
 	{
@@ -389,7 +1148,41 @@ void RenderContext::end_frame(VkSemaphore semaphore)
 		present_info.pWaitSemaphores    = &semaphore;
 		present_info.swapchainCount     = 1;
 		present_info.pSwapchains        = &vk_swapchain;
-		present_info.pImageIndices      = &active_frame_index;
+		present_info.pImageIndices      = &active_image_index;
+
+		VkPresentIdKHR present_id_info{VK_STRUCTURE_TYPE_PRESENT_ID_KHR};
+
+		if (present_timing)
+		{
+			++present_id;
+
+			present_id_info.swapchainCount = 1;
+			present_id_info.pPresentIds    = &present_id;
+
+			present_info.pNext = &present_id_info;
+
+			pending_presents.push_back({present_id, frame_input_time, Timer::Clock::now()});
+
+			// Presents may never be displayed, for example while the window is hidden
+			if (pending_presents.size() > MAX_PENDING_PRESENTS)
+			{
+				pending_presents.pop_front();
+			}
+		}
+
+		// The device which rendered the frame hands it to the one connected to the display
+		uint32_t                    device_mask = get_frame_device_mask();
+		VkDeviceGroupPresentInfoKHR group_info{VK_STRUCTURE_TYPE_DEVICE_GROUP_PRESENT_INFO_KHR};
+
+		if (device_mask != 0)
+		{
+			group_info.swapchainCount = 1;
+			group_info.pDeviceMasks   = &device_mask;
+			group_info.mode           = VK_DEVICE_GROUP_PRESENT_MODE_REMOTE_BIT_KHR;
+			group_info.pNext          = present_info.pNext;
+
+			present_info.pNext = &group_info;
+		}
 
 		VkResult result = queue.present(present_info);
 
@@ -399,6 +1192,24 @@ void RenderContext::end_frame(VkSemaphore semaphore)
 		}
 	}
 
+	if (timeline_semaphore != VK_NULL_HANDLE)
+	{
+		// Only the last frames can still be limiting the frames in flight
+		frame_timeline_values.push_back(get_active_frame().get_timeline_value());
+
+		while (frame_timeline_values.size() > frames.size())
+		{
+			frame_timeline_values.pop_front();
+		}
+	}
+
+	if (render_pass_analyzer)
+	{
+		render_pass_analyzer->end_frame();
+	}
+
+	device.get_destruction_queue().update();
+
 	// Frame is not active anymore
 	frame_active = false;
 }
@@ -437,6 +1248,12 @@ void RenderContext::recreate_swapchain()
 	device.wait_idle();
 	device.get_resource_cache().clear_framebuffers();
 
+	if (has_requested_frame_count())
+	{
+		create_image_render_targets();
+		return;
+	}
+
 	VkExtent2D swapchain_extent = swapchain->get_extent();
 	VkExtent3D extent{swapchain_extent.width, swapchain_extent.height, 1};
 
@@ -17,6 +17,9 @@
 
 #pragma once
 
+#include <deque>
+#include <functional>
+
 #include "common/helpers.h"
 #include "common/vk_common.h"
 #include "core/command_buffer.h"
@@ -29,14 +32,37 @@
 #include "core/queue.h"
 #include "core/render_pass.h"
 #include "core/shader_module.h"
+#include "core/submit_batch.h"
 #include "core/swapchain.h"
 #include "rendering/pipeline_state.h"
 #include "rendering/render_frame.h"
 #include "rendering/render_target.h"
 #include "resource_cache.h"
+#include "timer.h"
 
 namespace vkb
 {
+class FrameStrategyTuner;
+class GpuProfiler;
+class RenderPassAnalyzer;
+class Stats;
+
+/**
+ * @brief How the swapchain trades throughput and tearing for the latency between rendering and display
+ */
+enum class PresentLatencyMode
+{
+	/// The present modes by priority with the default number of images
+	Default,
+
+	/// Mailbox, or FIFO without it, with two images, each frame starting once the previous one is displayed
+	Low,
+
+	/// Immediate, or mailbox without it, with two images, each frame starting once the previous one is displayed.
+	/// Frames replace the scanned out image as soon as they are rendered, tearing, as front buffer rendering would.
+	Immediate
+};
+
 /**
  * @brief RenderContext acts as a frame manager for the sample, with a lifetime that is the
  * same as that of the Application itself. It acts as a container for RenderFrame objects,
@@ -47,10 +73,13 @@ namespace vkb
  * It requires a Device to be valid on creation, and will take control of a given Swapchain.
  *
  * For normal rendering (using a swapchain), the RenderContext can be created by passing in a
- * swapchain. A RenderFrame will then be created for each Swapchain image.
+ * swapchain. A RenderFrame will then be created for each Swapchain image, unless a frame count
+ * is requested: frames are then used in turn, each one rendering to the image it acquired.
  *
  * For headless rendering (no swapchain), the RenderContext can be given a valid Device, and
- * a width and height. A single RenderFrame will then be created.
+ * a width and height. RenderFrames are then created with their own offscreen images, HEADLESS_FRAME_COUNT
+ * of them unless a frame count is requested. They are used in turn without any acquire or present
+ * semaphore, so the CPU runs ahead until it reaches a frame still in flight or the frames in flight limit.
  */
 class RenderContext
 {
@@ -58,6 +87,9 @@ class RenderContext
 	// The format to use for the RenderTargets if a swapchain isn't created
 	static VkFormat DEFAULT_VK_FORMAT;
 
+	/// Number of render frames in headless mode if no frame count is requested
+	static constexpr uint32_t HEADLESS_FRAME_COUNT = 3;
+
 	/**
 	 * @brief Constructor
 	 * @param device A valid device
@@ -71,7 +103,7 @@ class RenderContext
 
 	RenderContext(RenderContext &&) = delete;
 
-	virtual ~RenderContext() = default;
+	virtual ~RenderContext();
 
 	RenderContext &operator=(const RenderContext &) = delete;
 
@@ -83,7 +115,25 @@ class RenderContext
 	void request_present_mode(const VkPresentModeKHR present_mode);
 
 	/**
-	 * @brief Requests to set a specific image format for the swapchain
+	 * @brief Requests a number of render frames independent of the number of swapchain images, must be called before prepare
+	 *
+	 * Each frame has its own copy of the per frame resources, so fewer frames save memory and latency while
+	 * more frames let the CPU run further ahead. The active frame index then differs from the swapchain image index.
+	 * @param frame_count The number of render frames, or 0 to create one for each swapchain image
+	 */
+	void request_frame_count(uint32_t frame_count);
+
+	/**
+	 * @brief Pre-warms the graphics command pools of every thread of every frame, including frames created later
+	 *        on prepare or when the swapchain is recreated, so that the first frames do not allocate command buffers
+	 * @param primary_count The number of primary command buffers to reserve per thread per frame
+	 * @param secondary_count The number of secondary command buffers to reserve per thread per frame
+	 * @param reset_mode The reset mode the command buffers will be requested with
+	 */
+	void reserve_command_buffers(uint32_t primary_count, uint32_t secondary_count, CommandBuffer::ResetMode reset_mode = CommandBuffer::ResetMode::ResetPool);
+
+	/**
+	 * @brief Requests to set a specific image format for the swapchain, or for the offscreen images in headless mode
 	 */
 	void request_image_format(const VkFormat format);
 
@@ -92,11 +142,149 @@ class RenderContext
 	 */
 	void set_present_mode_priority(const std::vector<VkPresentModeKHR> &present_mode_priority_list);
 
+	/**
+	 * @brief Configures the swapchain for the lowest latency between rendering and display, must be called before prepare
+	 *
+	 * The modes other than PresentLatencyMode::Default override the present mode priority and use two swapchain images.
+	 * With present timing, each frame also waits for the previous one to be displayed before it begins,
+	 * so that it starts right after a vblank and samples its input as late as possible.
+	 */
+	void set_present_latency_mode(PresentLatencyMode mode);
+
+	PresentLatencyMode get_present_latency_mode() const;
+
 	/**
 	 * @brief Sets the order in which the swapchain prioritizes selecting its surface format
 	 */
 	void set_surface_format_priority(const std::vector<VkSurfaceFormatKHR> &surface_format_priority_list);
 
+	/**
+	 * @brief Limits how many frames the CPU records ahead of the GPU, it can be changed at any time
+	 *
+	 * It needs VK_KHR_timeline_semaphore, otherwise frames only wait for their own previous submissions.
+	 * @param count Number of frames in flight, from 1 to the number of render frames, or 0 to not limit them
+	 */
+	void set_frames_in_flight(uint32_t count);
+
+	/**
+	 * @brief Limits the number of descriptor sets each thread of the render frames keeps across frames
+	 * @param budget Number of sets per thread, 0 to keep all of them
+	 */
+	void set_descriptor_set_budget(size_t budget);
+
+	/**
+	 * @brief Sizes the buffer pools of the render frames for a demand up front, so that the first
+	 *        frames do not create their blocks and stream blocks one request at a time
+	 *        Frames are reserved when they are next waited for, including frames created later.
+	 * @param demands Demands of the buffer pools, as returned by get_buffer_pool_high_water_marks in a previous run
+	 */
+	void reserve_buffer_pools(const BufferPoolDemands &demands);
+
+	/**
+	 * @return The peak demand of the buffer pools of every frame and the reserved demand, so that it never decreases
+	 */
+	BufferPoolDemands get_buffer_pool_high_water_marks() const;
+
+	/**
+	 * @return Number of frames begun since the context was created
+	 */
+	uint64_t get_frame_number() const;
+
+	/**
+	 * @return True if submissions of frames signal a timeline semaphore instead of fences
+	 */
+	bool has_timeline_semaphore() const;
+
+	/**
+	 * @brief Sets a function called right before the command buffer of a frame is submitted by submit(CommandBuffer &)
+	 *
+	 * It lets the application update the data read by the GPU with the latest input (late latching),
+	 * the input of the frame is then considered sampled when it is called instead of when the frame began.
+	 * @param callback The function to call with the active frame, or an empty function to disable late latching
+	 */
+	void set_late_latch_callback(std::function<void(RenderFrame &)> callback);
+
+	/**
+	 * @brief Sets the profiler which render pipelines record the GPU time of their subpasses to
+	 * @param profiler A profiler outliving its use by the render context, or nullptr to disable profiling
+	 */
+	void set_gpu_profiler(GpuProfiler *profiler);
+
+	/**
+	 * @return The GPU profiler, or nullptr if profiling is disabled
+	 */
+	GpuProfiler *get_gpu_profiler() const;
+
+	/**
+	 * @brief Sets the stats which render pipelines report the beginning and end of their subpasses to
+	 * @param stats Stats outliving their use by the render context, or nullptr
+	 */
+	void set_stats(Stats *stats);
+
+	/**
+	 * @return The stats subpasses are reported to, or nullptr
+	 */
+	Stats *get_stats() const;
+
+	/**
+	 * @brief Sets the analyzer which render pipelines report their passes to, analyzing them when frames end
+	 * @param analyzer An analyzer outliving its use by the render context, or nullptr to disable the analysis
+	 */
+	void set_render_pass_analyzer(RenderPassAnalyzer *analyzer);
+
+	/**
+	 * @return The render pass analyzer, or nullptr if the analysis is disabled
+	 */
+	RenderPassAnalyzer *get_render_pass_analyzer() const;
+
+	/**
+	 * @brief Sets the tuner which picks the descriptor management and buffer allocation strategies of the frames
+	 *        when begin() starts them, samples then should not clear descriptors or set strategies themselves
+	 * @param tuner A tuner outliving its use by the render context, or nullptr to leave the strategies to the sample
+	 */
+	void set_frame_strategy_tuner(FrameStrategyTuner *tuner);
+
+	/**
+	 * @return The frame strategy tuner, or nullptr if strategies are not tuned
+	 */
+	FrameStrategyTuner *get_frame_strategy_tuner() const;
+
+	/**
+	 * @brief Renders each frame on one physical device of a device group in turn, which presents it through
+	 *        the device connected to the display. Every device otherwise executes every frame.
+	 *
+	 * The graphics and compute submissions of a frame must go through submit() or the submission batches.
+	 * @param enable Whether to alternate devices, ignored for a single device or a group which can't present remotely
+	 */
+	void set_alternate_frame_rendering(bool enable);
+
+	/**
+	 * @return True if frames alternate between the physical devices of a device group
+	 */
+	bool has_alternate_frame_rendering() const;
+
+	/**
+	 * @return The physical device of the device group rendering the active frame, 0 if frames do not alternate
+	 */
+	uint32_t get_frame_device_index() const;
+
+	/**
+	 * @return True if presents are identified to measure when they are displayed, needs VK_KHR_present_wait
+	 */
+	bool has_present_timing() const;
+
+	/**
+	 * @return The time in seconds from sampling input to the display of the last frame known to be presented,
+	 *         it is estimated when the next frames begin so it is rounded up to the frame time
+	 */
+	double get_input_to_present_latency() const;
+
+	/**
+	 * @return The time in seconds from the present of the last frame known to be displayed to its display,
+	 *         which is exact when frames wait for the previous one to be displayed and rounded up to the frame time otherwise
+	 */
+	double get_present_to_display_latency() const;
+
 	/**
 	 * @brief Prepares the RenderFrames for rendering
 	 * @param thread_count The number of threads in the application, necessary to allocate this many resource pools for each RenderFrame
@@ -129,6 +317,13 @@ class RenderContext
 	 */
 	void update_swapchain(const VkExtent2D &extent, const VkSurfaceTransformFlagBitsKHR transform);
 
+	/**
+	 * @brief Adds a usage to the swapchain images, recreating the swapchain only if they miss it
+	 *        Does nothing in headless mode, where render targets are created from offscreen images.
+	 * @param usage The image usage to add
+	 */
+	void add_swapchain_usage(VkImageUsageFlagBits usage);
+
 	/**
 	 * @returns True if a valid swapchain exists in the RenderContext
 	 */
@@ -160,17 +355,64 @@ class RenderContext
 	/**
 	 * @brief begin_frame
 	 *
-	 * @return VkSemaphore
+	 * @return VkSemaphore signaled once the swapchain image is acquired, VK_NULL_HANDLE on failure or in headless mode
 	 */
 	VkSemaphore begin_frame();
 
+	/**
+	 * @brief Submits a command buffer related to a frame to a queue, after waiting for a semaphore
+	 *        The batched submissions of the frame are flushed with it, so that the returned semaphore can be waited for
+	 *        from any queue or the host as soon as this returns.
+	 * @return A semaphore signaled once the command buffer completes
+	 */
 	VkSemaphore submit(const Queue &queue, const CommandBuffer &command_buffer, VkSemaphore wait_semaphore, VkPipelineStageFlags wait_pipeline_stage);
 
 	/**
 	 * @brief Submits a command buffer related to a frame to a queue
+	 *        Submissions to the graphics or compute queue of the context are batched until the next flush_submissions.
 	 */
 	void submit(const Queue &queue, const CommandBuffer &command_buffer);
 
+	/**
+	 * @brief Adds a command buffer of the active frame to the batch of the graphics or compute queue, from any thread
+	 *        It must be added before the last submission of the frame, which then also covers its completion.
+	 */
+	void submit_deferred(const Queue &queue, const CommandBuffer &command_buffer);
+
+	/**
+	 * @brief Issues the batched submissions of the active frame, compute ones first so that graphics can wait for them
+	 *        The frame is flushed once it ends, before its present.
+	 */
+	void flush_submissions();
+
+	/**
+	 * @brief Requests a command buffer of the active frame for the compute queue
+	 * @param reset_mode How to reset the command buffer
+	 * @returns A command buffer allocated from the compute queue pools of the active frame
+	 */
+	CommandBuffer &request_compute_command_buffer(CommandBuffer::ResetMode reset_mode = CommandBuffer::ResetMode::ResetPool);
+
+	/**
+	 * @brief Submits compute work of the active frame to the compute queue
+	 *        The next graphics submission of the frame waits for it at the given stage, so the work
+	 *        overlaps with graphics submitted before it. With an async compute queue, resources
+	 *        with exclusive sharing mode must be released and acquired with queue family ownership
+	 *        transfer barriers on both queues, see get_compute_queue and has_async_compute.
+	 * @param command_buffer A command buffer from request_compute_command_buffer
+	 * @param wait_pipeline_stage The graphics stage which consumes the results of the compute work
+	 */
+	void submit_compute(const CommandBuffer &command_buffer, VkPipelineStageFlags wait_pipeline_stage);
+
+	/**
+	 * @returns The queue used by submit_compute
+	 */
+	const Queue &get_compute_queue() const;
+
+	/**
+	 * @returns True if compute submissions run on a different queue family than graphics ones
+	 */
+	bool has_async_compute() const;
+
 	/**
 	 * @brief Waits a frame to finish its rendering
 	 */
@@ -230,6 +472,21 @@ class RenderContext
 	/// If swapchain exists, then this will be a present supported queue, else a graphics queue
 	const Queue &queue;
 
+	/// A compute queue without graphics support if available, else a general compute queue
+	const Queue &compute_queue;
+
+	/// Submissions of the active frame to the graphics queue, issued at once by flush_submissions
+	SubmitBatch graphics_batch;
+
+	/// Submissions of the active frame to the compute queue, if it is not the graphics one
+	SubmitBatch compute_batch;
+
+	/// Semaphores signaled by compute submissions which the next graphics submission waits for
+	std::vector<VkSemaphore> compute_wait_semaphores;
+
+	/// Graphics stages waiting for the compute semaphores
+	std::vector<VkPipelineStageFlags> compute_wait_stages;
+
 	std::unique_ptr<Swapchain> swapchain;
 
 	SwapchainProperties swapchain_properties;
@@ -255,6 +512,61 @@ class RenderContext
 	/// Current active frame index
 	uint32_t active_frame_index{0};
 
+	/// Number of frames begun, the requests of the resource cache are stamped with it
+	uint64_t frame_number{0};
+
+	/// Number of the last frame begun with each render frame, 0 if it has not been used yet
+	std::vector<uint64_t> frame_numbers;
+
+	/// Descriptor sets per thread kept by the render frames across frames
+	size_t descriptor_set_budget{0};
+
+	/// Demand the buffer pools of the render frames are sized for
+	BufferPoolDemands buffer_pool_reservations;
+
+	/// Index of the swapchain image acquired for the active frame
+	uint32_t active_image_index{0};
+
+	/// Number of render frames requested, 0 if there is one for each swapchain image
+	uint32_t requested_frame_count{0};
+
+	/// Command buffers reserved per thread in the frames, see reserve_command_buffers
+	uint32_t reserved_primary_command_buffers{0};
+
+	uint32_t reserved_secondary_command_buffers{0};
+
+	CommandBuffer::ResetMode reserved_command_buffer_reset_mode{CommandBuffer::ResetMode::ResetPool};
+
+	/// Format of the offscreen images in headless mode
+	VkFormat headless_format{DEFAULT_VK_FORMAT};
+
+	/// Marks a frame holding the render target of no swapchain image
+	static constexpr uint32_t NO_IMAGE = ~0U;
+
+	/// Render targets of the swapchain images which no frame holds, when frames are not one for each image
+	std::vector<std::unique_ptr<RenderTarget>> image_render_targets;
+
+	/// Swapchain image whose render target each frame holds, or NO_IMAGE
+	std::vector<uint32_t> frame_image_indices;
+
+	/**
+	 * @brief A replaced swapchain and the resources created for its images, kept until no frame in flight can use them
+	 */
+	struct RetiredSwapchain
+	{
+		std::unique_ptr<Swapchain> swapchain;
+
+		std::vector<std::unique_ptr<RenderTarget>> render_targets;
+
+		std::unordered_map<std::size_t, Framebuffer> framebuffers;
+
+		/// Frames whose submissions may still use the resources
+		std::vector<bool> pending_frames;
+	};
+
+	/// Replaced swapchains, oldest first
+	std::deque<RetiredSwapchain> retired_swapchains;
+
 	/// Whether a frame is active or not
 	bool frame_active{false};
 
@@ -263,6 +575,148 @@ class RenderContext
 	VkSurfaceTransformFlagBitsKHR pre_transform{VK_SURFACE_TRANSFORM_IDENTITY_BIT_KHR};
 
 	size_t thread_count{1};
+
+	/// Semaphore signaled with increasing values by the submissions of frames, null if timeline semaphores are not enabled
+	VkSemaphore timeline_semaphore{VK_NULL_HANDLE};
+
+	/// Last value signaled on the timeline semaphore
+	uint64_t timeline_value{0};
+
+	/// Values signaled by the last submissions of the most recent frames, oldest first
+	std::deque<uint64_t> frame_timeline_values;
+
+	uint32_t frames_in_flight{0};
+
+	std::function<void(RenderFrame &)> late_latch_callback;
+
+	GpuProfiler *gpu_profiler{nullptr};
+
+	Stats *stats{nullptr};
+
+	RenderPassAnalyzer *render_pass_analyzer{nullptr};
+
+	FrameStrategyTuner *frame_strategy_tuner{nullptr};
+
+	bool present_timing{false};
+
+	bool alternate_frame_rendering{false};
+
+	/// Physical device of the device group rendering the active frame
+	uint32_t frame_device_index{0};
+
+	/**
+	 * @return The mask of the physical device rendering the active frame, 0 if frames do not alternate
+	 */
+	uint32_t get_frame_device_mask() const;
+
+	/// Identifier of the last present
+	uint64_t present_id{0};
+
+	/**
+	 * @brief A present whose display has not been observed yet
+	 */
+	struct PendingPresent
+	{
+		uint64_t present_id;
+
+		/// When the input of the presented frame was sampled
+		Timer::Clock::time_point input_time;
+
+		/// When the frame was queued for presentation
+		Timer::Clock::time_point present_time;
+	};
+
+	/// Presents not known to be displayed, oldest first
+	std::deque<PendingPresent> pending_presents;
+
+	/// Most presents waiting to be displayed, older ones are no longer tracked
+	static constexpr size_t MAX_PENDING_PRESENTS = 16;
+
+	/// When the input of the active frame was sampled
+	Timer::Clock::time_point frame_input_time;
+
+	double input_to_present_latency{0.0};
+
+	double present_to_display_latency{0.0};
+
+	PresentLatencyMode present_latency_mode{PresentLatencyMode::Default};
+
+	/// Longest wait for the previous frame to be displayed before a frame begins, in nanoseconds
+	static constexpr uint64_t DISPLAY_WAIT_TIMEOUT = 100000000;
+
+	/**
+	 * @brief Blocks until the last present is displayed, for the low latency modes
+	 */
+	void wait_for_display();
+
+	/**
+	 * @brief Updates the latency with the presents displayed since the last call, without blocking
+	 */
+	void poll_presents();
+
+	/**
+	 * @brief Submits to a queue, signaling the next timeline value for the active frame if timeline semaphores are enabled
+	 */
+	void submit_frame(const Queue &queue, VkSubmitInfo &submit_info);
+
+	/**
+	 * @return The batch of submissions to a queue, null if it is neither the graphics nor the compute queue
+	 */
+	SubmitBatch *get_submit_batch(const Queue &queue);
+
+	/**
+	 * @brief Blocks until the GPU finished the frames needed to keep the number of frames in flight
+	 */
+	void wait_frames_in_flight();
+
+	/**
+	 * @return True if the number of frames was requested instead of following the swapchain images
+	 */
+	bool has_requested_frame_count() const;
+
+	/**
+	 * @brief Reserves the command buffers requested with reserve_command_buffers in a frame
+	 */
+	void reserve_frame_command_buffers(RenderFrame &frame);
+
+	/**
+	 * @brief Begins the next frame when frames are not one for each swapchain image
+	 *
+	 * The frame is waited before acquiring an image, so its semaphores are free for the acquisition.
+	 */
+	VkSemaphore begin_requested_frame();
+
+	/**
+	 * @brief Begins the next frame in headless mode, which only waits for the frame to be free
+	 */
+	void begin_headless_frame();
+
+	/**
+	 * @brief Moves the render target of the acquired swapchain image to the active frame
+	 */
+	void bind_image_render_target();
+
+	/**
+	 * @brief Creates the render targets of the current swapchain images, taking them back from all frames
+	 */
+	void create_image_render_targets();
+
+	/**
+	 * @brief Replaces the swapchain without waiting for the device, the old swapchain and the framebuffers
+	 *        created for it are destroyed once every frame has finished the submissions which may use them
+	 * @param new_swapchain The swapchain created from the current one
+	 */
+	void replace_swapchain(std::unique_ptr<Swapchain> &&new_swapchain);
+
+	/**
+	 * @brief Keeps a render target of a replaced swapchain alive with it, or destroys it if no swapchain was replaced
+	 */
+	void retire_render_target(std::unique_ptr<RenderTarget> &&render_target);
+
+	/**
+	 * @brief Destroys the retired swapchains which no frame can use anymore, without blocking
+	 */
+	void release_retired_swapchains();
 };
 
 }        // namespace vkb
@@ -17,11 +17,35 @@
 
 #include "render_frame.h"
 
+#include <algorithm>
+#include <limits>
+#include <numeric>
+
 #include "common/logging.h"
 #include "common/utils.h"
 
 namespace vkb
 {
+namespace
+{
+std::unique_ptr<core::Buffer> create_readback_buffer(Device &device, VkDeviceSize size)
+{
+	return std::make_unique<core::Buffer>(device, size,
+	                                      VK_BUFFER_USAGE_TRANSFER_DST_BIT | VK_BUFFER_USAGE_STORAGE_BUFFER_BIT,
+	                                      VMA_MEMORY_USAGE_GPU_TO_CPU);
+}
+}        // namespace
+
+DescriptorSetCounters &DescriptorSetCounters::operator+=(const DescriptorSetCounters &other)
+{
+	requested += other.requested;
+	created += other.created;
+	recreated += other.recreated;
+	evicted += other.evicted;
+
+	return *this;
+}
+
 RenderFrame::RenderFrame(Device &device, std::unique_ptr<RenderTarget> &&render_target, size_t thread_count) :
     device{device},
     fence_pool{device},
@@ -31,22 +55,27 @@ RenderFrame::RenderFrame(Device &device, std::unique_ptr<RenderTarget> &&render_
 {
 	for (auto &usage_it : supported_usage_map)
 	{
-		std::vector<std::pair<BufferPool, BufferBlock *>> usage_buffer_pools;
-		for (size_t i = 0; i < thread_count; ++i)
+		auto pool_index = get_buffer_pool_index(usage_it.first);
+
+		if (pool_index == BUFFER_POOL_USAGE_COUNT || !buffer_pools[pool_index].empty())
 		{
-			usage_buffer_pools.push_back(std::make_pair(BufferPool{device, BUFFER_POOL_BLOCK_SIZE * 1024 * usage_it.second, usage_it.first}, nullptr));
+			throw std::runtime_error("Failed to insert buffer pool");
 		}
 
-		auto res_ins_it = buffer_pools.emplace(usage_it.first, std::move(usage_buffer_pools));
-
-		if (!res_ins_it.second)
+		for (size_t i = 0; i < thread_count; ++i)
 		{
-			throw std::runtime_error("Failed to insert buffer pool");
+			buffer_pools[pool_index].push_back(std::make_pair(BufferPool{device, BUFFER_POOL_BLOCK_SIZE * 1024 * usage_it.second, usage_it.first}, nullptr));
 		}
 	}
 
 	for (size_t i = 0; i < thread_count; ++i)
 	{
+		memory_arenas.push_back(std::make_unique<MemoryArena>());
+		buffer_allocated_bytes.emplace_back(0);
+		buffer_block_requests.emplace_back(0);
+		descriptor_set_counters.emplace_back();
+		cleared_descriptor_set_keys.emplace_back();
+		descriptor_set_last_used.emplace_back();
 		descriptor_pools.push_back(std::make_unique<std::unordered_map<std::size_t, DescriptorPool>>());
 		descriptor_sets.push_back(std::make_unique<std::unordered_map<std::size_t, DescriptorSet>>());
 	}
@@ -64,8 +93,21 @@ void RenderFrame::update_render_target(std::unique_ptr<RenderTarget> &&render_ta
 
 void RenderFrame::reset()
 {
+	if (timeline_semaphore != VK_NULL_HANDLE && timeline_value > 0)
+	{
+		VkSemaphoreWaitInfoKHR wait_info{VK_STRUCTURE_TYPE_SEMAPHORE_WAIT_INFO_KHR};
+		wait_info.semaphoreCount = 1;
+		wait_info.pSemaphores    = &timeline_semaphore;
+		wait_info.pValues        = &timeline_value;
+
+		VK_CHECK(vkWaitSemaphoresKHR(device.get_handle(), &wait_info, std::numeric_limits<uint64_t>::max()));
+	}
+
 	VK_CHECK(fence_pool.wait());
 
+	// The device has written the readbacks of the frame, so their data can be read without waiting
+	collect_readbacks();
+
 	fence_pool.reset();
 
 	for (auto &command_pools_per_queue : command_pools)
@@ -76,9 +118,15 @@ void RenderFrame::reset()
 		}
 	}
 
+	// Command buffers have released their arena allocations when their pools were reset
+	for (auto &memory_arena : memory_arenas)
+	{
+		memory_arena->reset();
+	}
+
 	for (auto &buffer_pools_per_usage : buffer_pools)
 	{
-		for (auto &buffer_pool : buffer_pools_per_usage.second)
+		for (auto &buffer_pool : buffer_pools_per_usage)
 		{
 			buffer_pool.first.reset();
 			buffer_pool.second = nullptr;
@@ -86,6 +134,18 @@ void RenderFrame::reset()
 	}
 
 	semaphore_pool.reset();
+
+	for (auto &render_packet : render_packets)
+	{
+		render_packet->clear();
+	}
+
+	++reset_count;
+
+	if (descriptor_set_budget > 0)
+	{
+		evict_descriptor_sets();
+	}
 }
 
 std::vector<std::unique_ptr<CommandPool>> &RenderFrame::get_command_pools(const Queue &queue, CommandBuffer::ResetMode reset_mode)
@@ -98,6 +158,11 @@ std::vector<std::unique_ptr<CommandPool>> &RenderFrame::get_command_pools(const
 		{
 			device.wait_idle();
 
+			for (auto &command_pool : command_pool_it->second)
+			{
+				retired_command_buffer_counters += command_pool->get_counters();
+			}
+
 			// Delete pools
 			command_pools.erase(command_pool_it);
 		}
@@ -145,13 +210,47 @@ VkSemaphore RenderFrame::request_semaphore()
 	return semaphore_pool.request_semaphore();
 }
 
+void RenderFrame::set_timeline_value(VkSemaphore new_timeline_semaphore, uint64_t value)
+{
+	timeline_semaphore = new_timeline_semaphore;
+	timeline_value     = value;
+}
+
+uint64_t RenderFrame::get_timeline_value() const
+{
+	return timeline_value;
+}
+
+bool RenderFrame::is_idle() const
+{
+	if (timeline_semaphore != VK_NULL_HANDLE && timeline_value > 0)
+	{
+		uint64_t value{0};
+		VK_CHECK(vkGetSemaphoreCounterValueKHR(device.get_handle(), timeline_semaphore, &value));
+
+		if (value < timeline_value)
+		{
+			return false;
+		}
+	}
+
+	return fence_pool.poll() == VK_SUCCESS;
+}
+
+std::unique_ptr<RenderTarget> RenderFrame::release_render_target()
+{
+	return std::move(swapchain_render_target);
+}
+
 RenderTarget &RenderFrame::get_render_target()
 {
+	assert(swapchain_render_target && "The frame does not hold a render target");
 	return *swapchain_render_target;
 }
 
 const RenderTarget &RenderFrame::get_render_target_const() const
 {
+	assert(swapchain_render_target && "The frame does not hold a render target");
 	return *swapchain_render_target;
 }
 
@@ -166,12 +265,55 @@ CommandBuffer &RenderFrame::request_command_buffer(const Queue &queue, CommandBu
 	return (*command_pool_it)->request_command_buffer(level);
 }
 
-DescriptorSet &RenderFrame::request_descriptor_set(DescriptorSetLayout &descriptor_set_layout, const BindingMap<VkDescriptorBufferInfo> &buffer_infos, const BindingMap<VkDescriptorImageInfo> &image_infos, size_t thread_index)
+void RenderFrame::reserve_command_buffers(const Queue &queue, CommandBuffer::ResetMode reset_mode, uint32_t primary_count, uint32_t secondary_count)
+{
+	for (auto &command_pool : get_command_pools(queue, reset_mode))
+	{
+		command_pool->reserve(primary_count, secondary_count);
+	}
+}
+
+DescriptorSet &RenderFrame::request_descriptor_set(DescriptorSetLayout &descriptor_set_layout, const BindingMap<VkDescriptorBufferInfo> &buffer_infos, const BindingMap<VkDescriptorImageInfo> &image_infos,
+                                                   const BindingMap<VkAccelerationStructureKHR> &acceleration_structure_infos, size_t thread_index)
 {
 	assert(thread_index < thread_count && "Thread index is out of bounds");
 
 	auto &descriptor_pool = request_resource(device, nullptr, *descriptor_pools.at(thread_index), descriptor_set_layout);
-	return request_resource(device, nullptr, *descriptor_sets.at(thread_index), descriptor_set_layout, descriptor_pool, buffer_infos, image_infos);
+
+	auto &thread_descriptor_sets = *descriptor_sets.at(thread_index);
+	auto  set_count              = thread_descriptor_sets.size();
+
+	auto &descriptor_set = request_resource(device, nullptr, thread_descriptor_sets, descriptor_set_layout, descriptor_pool, buffer_infos, image_infos, acceleration_structure_infos);
+
+	auto &counters = descriptor_set_counters[thread_index];
+	++counters.requested;
+
+	bool  created      = thread_descriptor_sets.size() != set_count;
+	auto &cleared_keys = cleared_descriptor_set_keys[thread_index];
+
+	if (created)
+	{
+		++counters.created;
+	}
+
+	// Only hash the set again when it was just created or it has to be stamped, requests found in the frame are the common case
+	if (descriptor_set_budget > 0 || (created && !cleared_keys.empty()))
+	{
+		std::size_t hash{0U};
+		hash_param(hash, descriptor_set_layout, descriptor_pool, buffer_infos, image_infos, acceleration_structure_infos);
+
+		if (descriptor_set_budget > 0)
+		{
+			descriptor_set_last_used[thread_index][hash] = reset_count;
+		}
+
+		if (created && cleared_keys.count(hash) > 0)
+		{
+			++counters.recreated;
+		}
+	}
+
+	return descriptor_set;
 }
 
 void RenderFrame::update_descriptor_sets(size_t thread_index)
@@ -185,9 +327,19 @@ void RenderFrame::update_descriptor_sets(size_t thread_index)
 
 void RenderFrame::clear_descriptors()
 {
-	for (auto &desc_sets_per_thread : descriptor_sets)
+	for (size_t thread_index = 0; thread_index < descriptor_sets.size(); ++thread_index)
 	{
-		desc_sets_per_thread->clear();
+		auto &desc_sets_per_thread = *descriptor_sets[thread_index];
+		auto &cleared_keys         = cleared_descriptor_set_keys[thread_index];
+
+		cleared_keys.clear();
+		for (auto &desc_set_it : desc_sets_per_thread)
+		{
+			cleared_keys.insert(desc_set_it.first);
+		}
+
+		desc_sets_per_thread.clear();
+		descriptor_set_last_used[thread_index].clear();
 	}
 
 	for (auto &desc_pools_per_thread : descriptor_pools)
@@ -199,39 +351,199 @@ void RenderFrame::clear_descriptors()
 	}
 }
 
+void RenderFrame::set_descriptor_set_budget(size_t budget)
+{
+	descriptor_set_budget = budget;
+
+	if (descriptor_set_budget == 0)
+	{
+		for (auto &last_used : descriptor_set_last_used)
+		{
+			last_used.clear();
+		}
+	}
+}
+
+size_t RenderFrame::get_descriptor_set_budget() const
+{
+	return descriptor_set_budget;
+}
+
+const RenderPacket &RenderFrame::request_render_packet(sg::Scene &scene, sg::Camera &camera, bool cull)
+{
+	std::lock_guard<std::mutex> guard{render_packet_mutex};
+
+	RenderPacket *unused_packet = nullptr;
+
+	for (auto &render_packet : render_packets)
+	{
+		if (!render_packet->is_extracted())
+		{
+			// Prefer the packet last extracted with the same key, its vectors have the right capacity
+			if (!unused_packet || render_packet->matches(scene, camera, cull))
+			{
+				unused_packet = render_packet.get();
+			}
+		}
+		else if (render_packet->matches(scene, camera, cull))
+		{
+			return *render_packet;
+		}
+	}
+
+	if (!unused_packet)
+	{
+		render_packets.push_back(std::make_unique<RenderPacket>());
+		unused_packet = render_packets.back().get();
+	}
+
+	unused_packet->extract(scene, camera, cull);
+
+	return *unused_packet;
+}
+
+void RenderFrame::evict_descriptor_sets()
+{
+	for (size_t thread_index = 0; thread_index < descriptor_sets.size(); ++thread_index)
+	{
+		auto &thread_descriptor_sets = *descriptor_sets[thread_index];
+
+		if (thread_descriptor_sets.size() <= descriptor_set_budget)
+		{
+			continue;
+		}
+
+		auto &last_used = descriptor_set_last_used[thread_index];
+
+		// Sets requested before the budget was set have no stamp and are the first to go
+		std::vector<std::pair<uint64_t, std::size_t>> sets_by_use;
+		sets_by_use.reserve(thread_descriptor_sets.size());
+
+		for (auto &it : thread_descriptor_sets)
+		{
+			auto last_used_it = last_used.find(it.first);
+			sets_by_use.emplace_back(last_used_it != last_used.end() ? last_used_it->second : 0, it.first);
+		}
+
+		size_t eviction_count = thread_descriptor_sets.size() - descriptor_set_budget;
+
+		std::partial_sort(sets_by_use.begin(), sets_by_use.begin() + eviction_count, sets_by_use.end());
+
+		for (size_t i = 0; i < eviction_count; ++i)
+		{
+			thread_descriptor_sets.erase(sets_by_use[i].second);
+			last_used.erase(sets_by_use[i].second);
+		}
+
+		// Sets are not freed individually, so the pools left holding mostly dropped sets are reset,
+		// and the few sets they still hold are allocated again when they are next requested
+		std::unordered_map<const DescriptorSetLayout *, uint32_t> layout_set_counts;
+
+		for (auto &it : thread_descriptor_sets)
+		{
+			++layout_set_counts[&it.second.get_layout()];
+		}
+
+		for (auto &pool_it : *descriptor_pools[thread_index])
+		{
+			auto &descriptor_pool = pool_it.second;
+			auto  layout          = &descriptor_pool.get_descriptor_set_layout();
+
+			uint32_t set_count = layout_set_counts[layout];
+
+			if (set_count * 2 > descriptor_pool.get_set_count())
+			{
+				continue;
+			}
+
+			for (auto set_it = thread_descriptor_sets.begin(); set_count > 0 && set_it != thread_descriptor_sets.end();)
+			{
+				if (&set_it->second.get_layout() == layout)
+				{
+					last_used.erase(set_it->first);
+					set_it = thread_descriptor_sets.erase(set_it);
+				}
+				else
+				{
+					++set_it;
+				}
+			}
+
+			eviction_count += set_count;
+
+			descriptor_pool.reset();
+		}
+
+		descriptor_set_counters[thread_index].evicted += eviction_count;
+	}
+}
+
 void RenderFrame::set_buffer_allocation_strategy(BufferAllocationStrategy new_strategy)
 {
 	buffer_allocation_strategy = new_strategy;
 }
 
-BufferAllocation RenderFrame::allocate_buffer(const VkBufferUsageFlags usage, const VkDeviceSize size, size_t thread_index)
+BufferAllocationStrategy RenderFrame::get_buffer_allocation_strategy() const
 {
-	assert(thread_index < thread_count && "Thread index is out of bounds");
-
-	uint32_t block_multiplier = supported_usage_map.at(usage);
+	return buffer_allocation_strategy;
+}
 
-	if (size > BUFFER_POOL_BLOCK_SIZE * 1024 * block_multiplier)
+size_t RenderFrame::get_buffer_pool_index(VkBufferUsageFlags usage)
+{
+	switch (usage)
 	{
-		LOGE("Trying to allocate {} buffer of size {}KB which is larger than the buffer pool block size ({} KB)!", buffer_usage_to_string(usage), size / 1024, BUFFER_POOL_BLOCK_SIZE * block_multiplier);
-		throw std::runtime_error("Couldn't allocate render frame buffer.");
+		case VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT:
+			return 0;
+		case VK_BUFFER_USAGE_STORAGE_BUFFER_BIT:
+			return 1;
+		case VK_BUFFER_USAGE_VERTEX_BUFFER_BIT:
+			return 2;
+		case VK_BUFFER_USAGE_INDEX_BUFFER_BIT:
+			return 3;
+		case VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT:
+			return 4;
+		case VK_BUFFER_USAGE_TRANSFER_SRC_BIT:
+			return 5;
+		case VK_BUFFER_USAGE_UNIFORM_TEXEL_BUFFER_BIT:
+			return 6;
+		case VK_BUFFER_USAGE_STORAGE_TEXEL_BUFFER_BIT:
+			return 7;
+		default:
+			return BUFFER_POOL_USAGE_COUNT;
 	}
+}
 
-	// Find a pool for this usage
-	auto buffer_pool_it = buffer_pools.find(usage);
-	if (buffer_pool_it == buffer_pools.end())
+BufferAllocation RenderFrame::allocate_buffer(const VkBufferUsageFlags usage, const VkDeviceSize size, size_t thread_index)
+{
+	assert(thread_index < thread_count && "Thread index is out of bounds");
+
+	// Find a pool for this usage, this is called for every node of a scene so avoid map lookups
+	auto pool_index = get_buffer_pool_index(usage);
+	if (pool_index == BUFFER_POOL_USAGE_COUNT)
 	{
 		LOGE("No buffer pool for buffer usage {}", usage);
 		return BufferAllocation{};
 	}
 
-	auto &buffer_pool  = buffer_pool_it->second.at(thread_index).first;
-	auto &buffer_block = buffer_pool_it->second.at(thread_index).second;
+	auto &buffer_pool  = buffer_pools[pool_index][thread_index].first;
+	auto &buffer_block = buffer_pools[pool_index][thread_index].second;
+
+	if (size > buffer_pool.get_block_size())
+	{
+		// Large streams would otherwise need a block of their own every frame
+		auto data = buffer_pool.allocate_stream(size);
+
+		buffer_allocated_bytes[thread_index] += data.get_size();
+
+		return data;
+	}
 
 	if (buffer_allocation_strategy == BufferAllocationStrategy::OneAllocationPerBuffer || !buffer_block)
 	{
 		// If there is no block associated with the pool or we are creating a buffer for each allocation,
 		// request a new buffer block
 		buffer_block = &buffer_pool.request_buffer_block(to_u32(size));
+		++buffer_block_requests[thread_index];
 	}
 
 	auto data = buffer_block->allocate(to_u32(size));
@@ -240,10 +552,326 @@ BufferAllocation RenderFrame::allocate_buffer(const VkBufferUsageFlags usage, co
 	if (data.empty())
 	{
 		buffer_block = &buffer_pool.request_buffer_block(to_u32(size));
+		++buffer_block_requests[thread_index];
 
 		data = buffer_block->allocate(to_u32(size));
 	}
 
+	buffer_allocated_bytes[thread_index] += data.get_size();
+
 	return data;
 }
+
+BufferAllocation RenderFrame::request_readback(VkDeviceSize size, ReadbackCallback &&callback)
+{
+	std::lock_guard<std::mutex> lock{readback_mutex};
+
+	// Readbacks may be bound as storage buffers, and their data is read as typed values
+	VkDeviceSize alignment = std::max<VkDeviceSize>(device.get_gpu().get_properties().limits.minStorageBufferOffsetAlignment, 16);
+	VkDeviceSize offset    = (readback_offset + alignment - 1) / alignment * alignment;
+
+	if (readback_buffers.empty() || offset + size > readback_buffers.back()->get_size())
+	{
+		readback_buffers.push_back(create_readback_buffer(device, std::max<VkDeviceSize>(size, READBACK_BLOCK_SIZE * 1024)));
+		offset = 0;
+	}
+
+	auto &buffer    = *readback_buffers.back();
+	readback_offset = offset + size;
+
+	readbacks.push_back({&buffer, offset, size, std::move(callback)});
+
+	return BufferAllocation{buffer, size, offset};
+}
+
+void RenderFrame::read_back_query_results(CommandBuffer &                                           command_buffer,
+                                          const QueryPool &                                         query_pool,
+                                          uint32_t                                                  first_query,
+                                          uint32_t                                                  query_count,
+                                          VkQueryResultFlags                                        flags,
+                                          std::function<void(const uint64_t *results, size_t count)> &&callback,
+                                          uint32_t                                                  values_per_query)
+{
+	flags |= VK_QUERY_RESULT_64_BIT;
+
+	if (flags & VK_QUERY_RESULT_WITH_AVAILABILITY_BIT)
+	{
+		++values_per_query;
+	}
+
+	VkDeviceSize stride = values_per_query * sizeof(uint64_t);
+
+	auto readback = request_readback<uint64_t>(query_count * values_per_query, std::move(callback));
+
+	command_buffer.copy_query_pool_results(query_pool, first_query, query_count,
+	                                       readback.get_buffer(), readback.get_offset(), stride, flags);
+}
+
+VkDeviceSize RenderFrame::get_readback_memory_size() const
+{
+	std::lock_guard<std::mutex> lock{readback_mutex};
+
+	VkDeviceSize size{0};
+
+	for (auto &buffer : readback_buffers)
+	{
+		size += buffer->get_size();
+	}
+
+	return size;
+}
+
+void RenderFrame::collect_readbacks()
+{
+	if (readbacks.empty())
+	{
+		return;
+	}
+
+	for (auto &buffer : readback_buffers)
+	{
+		if (!buffer->is_coherent())
+		{
+			vmaInvalidateAllocation(device.get_memory_allocator(), buffer->get_allocation(), 0, VK_WHOLE_SIZE);
+		}
+	}
+
+	for (auto &readback : readbacks)
+	{
+		readback.callback(readback.buffer->get_data() + readback.offset, readback.size);
+	}
+
+	readbacks.clear();
+	readback_offset = 0;
+
+	// Replace the buffers outgrown by the frame with one fitting all of them, so that steady state frames use a single buffer
+	if (readback_buffers.size() > 1)
+	{
+		VkDeviceSize size = get_readback_memory_size();
+
+		readback_buffers.clear();
+		readback_buffers.push_back(create_readback_buffer(device, size));
+	}
+}
+
+MemoryArena &RenderFrame::get_memory_arena(size_t thread_index)
+{
+	assert(thread_index < thread_count && "Thread index is out of bounds");
+
+	return *memory_arenas[thread_index];
+}
+
+size_t RenderFrame::get_memory_arena_block_count() const
+{
+	size_t block_count = 0;
+
+	for (auto &memory_arena : memory_arenas)
+	{
+		block_count += memory_arena->get_block_allocation_count();
+	}
+
+	return block_count;
+}
+
+size_t RenderFrame::get_memory_arena_reserved_size() const
+{
+	size_t reserved_size = 0;
+
+	for (auto &memory_arena : memory_arenas)
+	{
+		reserved_size += memory_arena->get_reserved_size();
+	}
+
+	return reserved_size;
+}
+
+size_t RenderFrame::get_descriptor_pool_count() const
+{
+	size_t pool_count = 0;
+
+	for (auto &desc_pools_per_thread : descriptor_pools)
+	{
+		for (auto &desc_pool : *desc_pools_per_thread)
+		{
+			pool_count += desc_pool.second.get_pool_count();
+		}
+	}
+
+	return pool_count;
+}
+
+uint32_t RenderFrame::get_descriptor_set_capacity() const
+{
+	uint32_t set_capacity = 0;
+
+	for (auto &desc_pools_per_thread : descriptor_pools)
+	{
+		for (auto &desc_pool : *desc_pools_per_thread)
+		{
+			set_capacity += desc_pool.second.get_set_capacity();
+		}
+	}
+
+	return set_capacity;
+}
+
+uint32_t RenderFrame::get_descriptor_set_count() const
+{
+	uint32_t set_count = 0;
+
+	for (auto &desc_pools_per_thread : descriptor_pools)
+	{
+		for (auto &desc_pool : *desc_pools_per_thread)
+		{
+			set_count += desc_pool.second.get_set_count();
+		}
+	}
+
+	return set_count;
+}
+
+DescriptorSetCounters RenderFrame::get_descriptor_set_counters() const
+{
+	DescriptorSetCounters counters;
+
+	for (auto &thread_counters : descriptor_set_counters)
+	{
+		counters += thread_counters;
+	}
+
+	return counters;
+}
+
+void RenderFrame::add_bind_counters(const BindCounters &counters, size_t thread_index)
+{
+	assert(thread_index < thread_count && "Thread index is out of bounds");
+
+	// Counters are only summed, so their order does not matter
+	pipeline_binds.fetch_add(counters.pipeline_binds, std::memory_order_relaxed);
+	pipeline_binds_saved.fetch_add(counters.pipeline_binds_saved, std::memory_order_relaxed);
+	descriptor_set_binds.fetch_add(counters.descriptor_set_binds, std::memory_order_relaxed);
+}
+
+BindCounters RenderFrame::get_bind_counters() const
+{
+	BindCounters counters;
+	counters.pipeline_binds       = pipeline_binds.load(std::memory_order_relaxed);
+	counters.pipeline_binds_saved = pipeline_binds_saved.load(std::memory_order_relaxed);
+	counters.descriptor_set_binds = descriptor_set_binds.load(std::memory_order_relaxed);
+
+	return counters;
+}
+
+void RenderFrame::add_attachment_traffic(const AttachmentTraffic &traffic, size_t thread_index)
+{
+	assert(thread_index < thread_count && "Thread index is out of bounds");
+
+	attachment_read_bytes.fetch_add(traffic.read_bytes, std::memory_order_relaxed);
+	attachment_write_bytes.fetch_add(traffic.write_bytes, std::memory_order_relaxed);
+}
+
+AttachmentTraffic RenderFrame::get_attachment_traffic() const
+{
+	AttachmentTraffic traffic;
+	traffic.read_bytes  = attachment_read_bytes.load(std::memory_order_relaxed);
+	traffic.write_bytes = attachment_write_bytes.load(std::memory_order_relaxed);
+
+	return traffic;
+}
+
+CommandBufferCounters RenderFrame::get_command_buffer_counters() const
+{
+	CommandBufferCounters counters = retired_command_buffer_counters;
+
+	for (auto &command_pools_per_queue : command_pools)
+	{
+		for (auto &command_pool : command_pools_per_queue.second)
+		{
+			counters += command_pool->get_counters();
+		}
+	}
+
+	return counters;
+}
+
+VkDeviceSize RenderFrame::get_buffer_allocated_bytes() const
+{
+	return std::accumulate(buffer_allocated_bytes.begin(), buffer_allocated_bytes.end(), VkDeviceSize{0});
+}
+
+uint64_t RenderFrame::get_buffer_block_request_count() const
+{
+	return std::accumulate(buffer_block_requests.begin(), buffer_block_requests.end(), uint64_t{0});
+}
+
+size_t RenderFrame::get_buffer_block_count() const
+{
+	size_t block_count = 0;
+
+	for (auto &buffer_pools_per_usage : buffer_pools)
+	{
+		for (auto &buffer_pool : buffer_pools_per_usage)
+		{
+			block_count += buffer_pool.first.get_block_count();
+		}
+	}
+
+	return block_count;
+}
+
+VkDeviceSize RenderFrame::get_buffer_pool_memory_size() const
+{
+	VkDeviceSize memory_size = 0;
+
+	for (auto &buffer_pools_per_usage : buffer_pools)
+	{
+		for (auto &buffer_pool : buffer_pools_per_usage)
+		{
+			memory_size += buffer_pool.first.get_memory_size();
+		}
+	}
+
+	return memory_size;
+}
+
+BufferPoolDemands RenderFrame::get_buffer_pool_high_water_marks() const
+{
+	BufferPoolDemands demands;
+
+	for (auto &usage_it : supported_usage_map)
+	{
+		auto &demand = demands[usage_it.first];
+
+		for (auto &buffer_pool : buffer_pools[get_buffer_pool_index(usage_it.first)])
+		{
+			demand.push_back(buffer_pool.first.get_high_water_mark());
+		}
+	}
+
+	return demands;
+}
+
+void RenderFrame::reserve_buffer_pools(const BufferPoolDemands &demands)
+{
+	for (auto &demand_it : demands)
+	{
+		auto pool_index = get_buffer_pool_index(demand_it.first);
+		if (pool_index == BUFFER_POOL_USAGE_COUNT)
+		{
+			continue;
+		}
+
+		auto &pools = buffer_pools[pool_index];
+
+		for (size_t i = 0; i < std::min(pools.size(), demand_it.second.size()); ++i)
+		{
+			pools[i].first.reserve(demand_it.second[i]);
+		}
+	}
+}
+
+size_t RenderFrame::get_thread_count() const
+{
+	return thread_count;
+}
 }        // namespace vkb
@@ -17,6 +17,11 @@
 
 #pragma once
 
+#include <atomic>
+#include <functional>
+#include <mutex>
+#include <type_traits>
+
 #include "buffer_pool.h"
 #include "common/helpers.h"
 #include "common/resource_caching.h"
@@ -29,6 +34,8 @@
 #include "core/query_pool.h"
 #include "core/queue.h"
 #include "fence_pool.h"
+#include "memory_arena.h"
+#include "rendering/render_packet.h"
 #include "rendering/render_target.h"
 #include "semaphore_pool.h"
 
@@ -40,6 +47,29 @@ enum BufferAllocationStrategy
 	MultipleAllocationsPerBuffer
 };
 
+/**
+ * @brief Counts how well the descriptor sets of a frame are reused
+ */
+struct DescriptorSetCounters
+{
+	/// Calls to RenderFrame::request_descriptor_set
+	uint64_t requested{0};
+
+	/// Requests which did not find the set in the frame and allocated it
+	uint64_t created{0};
+
+	/// Created sets which the frame held before clear_descriptors, so keeping them would have saved their allocation
+	uint64_t recreated{0};
+
+	/// Sets dropped when the frame was reset, to keep it within its descriptor set budget
+	uint64_t evicted{0};
+
+	DescriptorSetCounters &operator+=(const DescriptorSetCounters &other);
+};
+
+/// Peak demand of the buffer pools of each usage, with one demand for each thread
+using BufferPoolDemands = std::unordered_map<VkBufferUsageFlags, std::vector<BufferPoolDemand>>;
+
 /**
  * @brief RenderFrame is a container for per-frame data, including BufferPool objects,
  * synchronization primitives (semaphores, fences) and the swapchain RenderTarget.
@@ -66,7 +96,21 @@ class RenderFrame
 	    {VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT, 1},
 	    {VK_BUFFER_USAGE_STORAGE_BUFFER_BIT, 2},        // x2 the size of BUFFER_POOL_BLOCK_SIZE since SSBOs are normally much larger than other types of buffers
 	    {VK_BUFFER_USAGE_VERTEX_BUFFER_BIT, 1},
-	    {VK_BUFFER_USAGE_INDEX_BUFFER_BIT, 1}};
+	    {VK_BUFFER_USAGE_INDEX_BUFFER_BIT, 1},
+	    {VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT, 1},
+	    {VK_BUFFER_USAGE_TRANSFER_SRC_BIT, 1},
+	    {VK_BUFFER_USAGE_UNIFORM_TEXEL_BUFFER_BIT, 1},
+	    {VK_BUFFER_USAGE_STORAGE_TEXEL_BUFFER_BIT, 1}};
+
+	/**
+	 * @brief Block size of the readback buffers of a frame in kilobytes
+	 */
+	static constexpr uint32_t READBACK_BLOCK_SIZE = 64;
+
+	/**
+	 * @brief Receives the data written by the commands of a frame once the device has completed them
+	 */
+	using ReadbackCallback = std::function<void(const uint8_t *data, VkDeviceSize size)>;
 
 	RenderFrame(Device &device, std::unique_ptr<RenderTarget> &&render_target, size_t thread_count = 1);
 
@@ -80,6 +124,11 @@ class RenderFrame
 
 	void reset();
 
+	/**
+	 * @return Whether the device has finished the submissions of the frame, without waiting for them
+	 */
+	bool is_idle() const;
+
 	Device &get_device();
 
 	const FencePool &get_fence_pool() const;
@@ -90,12 +139,31 @@ class RenderFrame
 
 	VkSemaphore request_semaphore();
 
+	/**
+	 * @brief Records that the last submission of the frame signals a timeline semaphore value,
+	 *        reset then waits for the value in addition to the fences of the frame
+	 * @param timeline_semaphore The timeline semaphore signaled by the submission
+	 * @param value The value signaled by the submission
+	 */
+	void set_timeline_value(VkSemaphore timeline_semaphore, uint64_t value);
+
+	/**
+	 * @return The timeline semaphore value signaled by the last submission of the frame, or 0 if there was none
+	 */
+	uint64_t get_timeline_value() const;
+
 	/**
 	 * @brief Called when the swapchain changes
 	 * @param render_target A new render target with updated images
 	 */
 	void update_render_target(std::unique_ptr<RenderTarget> &&render_target);
 
+	/**
+	 * @brief Gives up the render target of the frame, so that another frame renders to its swapchain image
+	 * @return The render target, the frame has none until the next update_render_target
+	 */
+	std::unique_ptr<RenderTarget> release_render_target();
+
 	RenderTarget &get_render_target();
 
 	const RenderTarget &get_render_target_const() const;
@@ -115,20 +183,58 @@ class RenderFrame
 	                                      VkCommandBufferLevel     level        = VK_COMMAND_BUFFER_LEVEL_PRIMARY,
 	                                      size_t                   thread_index = 0);
 
-	DescriptorSet &request_descriptor_set(DescriptorSetLayout &                     descriptor_set_layout,
-	                                      const BindingMap<VkDescriptorBufferInfo> &buffer_infos,
-	                                      const BindingMap<VkDescriptorImageInfo> & image_infos,
-	                                      size_t                                    thread_index = 0);
+	/**
+	 * @brief Allocates command buffers in the command pools of every thread, so that steady state frames do not allocate any
+	 * @param queue The queue command buffers will be submitted on
+	 * @param reset_mode The reset mode the command buffers will be requested with, pools are re-created when it changes
+	 * @param primary_count The number of primary command buffers to reserve per thread
+	 * @param secondary_count The number of secondary command buffers to reserve per thread
+	 */
+	void reserve_command_buffers(const Queue &queue, CommandBuffer::ResetMode reset_mode, uint32_t primary_count, uint32_t secondary_count);
+
+	DescriptorSet &request_descriptor_set(DescriptorSetLayout &                         descriptor_set_layout,
+	                                      const BindingMap<VkDescriptorBufferInfo> &    buffer_infos,
+	                                      const BindingMap<VkDescriptorImageInfo> &     image_infos,
+	                                      const BindingMap<VkAccelerationStructureKHR> &acceleration_structure_infos = {},
+	                                      size_t                                        thread_index                 = 0);
 
+	/**
+	 * @brief Drops the descriptor sets of the frame and resets its descriptor pools
+	 *        The sets dropped are remembered, so that recreating them is counted in get_descriptor_set_counters.
+	 */
 	void clear_descriptors();
 
+	/**
+	 * @brief Limits the number of descriptor sets each thread of the frame keeps across resets.
+	 *        When the frame is reset over budget, its least recently requested sets are dropped,
+	 *        and the descriptor pools holding mostly dropped sets are reset.
+	 * @param budget Number of sets per thread, 0 to keep all of them
+	 */
+	void set_descriptor_set_budget(size_t budget);
+
+	size_t get_descriptor_set_budget() const;
+
+	/**
+	 * @brief Requests the render packet of a scene seen by a camera in this frame,
+	 *        extracting it on the first request after the frame was reset.
+	 *        Subpasses with the same scene, camera and culling mode share the packet.
+	 * @param scene Scene to extract
+	 * @param camera Camera viewing the scene
+	 * @param cull Whether the packet only holds the mesh instances inside of the camera frustum
+	 * @return The packet, valid and unchanged until the frame is reset
+	 */
+	const RenderPacket &request_render_packet(sg::Scene &scene, sg::Camera &camera, bool cull);
+
 	/**
 	 * @brief Sets a new buffer allocation strategy
 	 * @param new_strategy The new buffer allocation strategy
 	 */
 	void set_buffer_allocation_strategy(BufferAllocationStrategy new_strategy);
 
+	BufferAllocationStrategy get_buffer_allocation_strategy() const;
+
 	/**
+	 * @brief Allocates from the buffer pool of a usage, allocations larger than a block are streamed through its stream block
 	 * @param usage Usage of the buffer
 	 * @param size Amount of memory required
 	 * @param thread_index Index of the buffer pool to be used by the current thread
@@ -136,14 +242,262 @@ class RenderFrame
 	 */
 	BufferAllocation allocate_buffer(VkBufferUsageFlags usage, VkDeviceSize size, size_t thread_index = 0);
 
+	/**
+	 * @brief Allocates host readable memory for the commands of the frame to write to, as a storage buffer
+	 *        or the destination of copies. The data is read back when the frame is next reset, once its
+	 *        fences have signaled, so that neither the host nor the device waits for the other.
+	 * @param size Size in bytes of the data written by the commands
+	 * @param callback Called with the data by the thread resetting the frame
+	 * @return The range the commands write to, valid until the frame is reset
+	 */
+	BufferAllocation request_readback(VkDeviceSize size, ReadbackCallback &&callback);
+
+	/**
+	 * @brief Allocates a readback of an array of values, see request_readback
+	 * @param count Number of values written by the commands
+	 * @param callback Called with the values once the frame has completed
+	 */
+	template <class T>
+	BufferAllocation request_readback(size_t count, std::function<void(const T *values, size_t count)> &&callback)
+	{
+		static_assert(std::is_trivially_copyable<T>::value, "Readback values are copied by the device");
+
+		return request_readback(sizeof(T) * count, [callback = std::move(callback)](const uint8_t *data, VkDeviceSize size) {
+			callback(reinterpret_cast<const T *>(data), static_cast<size_t>(size / sizeof(T)));
+		});
+	}
+
+	/**
+	 * @brief Allocates a readback of a single value, see request_readback
+	 * @param callback Called with the value once the frame has completed
+	 */
+	template <class T>
+	BufferAllocation request_readback(std::function<void(const T &value)> &&callback)
+	{
+		static_assert(std::is_trivially_copyable<T>::value, "Readback values are copied by the device");
+
+		return request_readback(sizeof(T), [callback = std::move(callback)](const uint8_t *data, VkDeviceSize) {
+			callback(*reinterpret_cast<const T *>(data));
+		});
+	}
+
+	/**
+	 * @brief Copies the results of queries into a readback of the frame, instead of waiting for them with QueryPool::get_results
+	 *        The copy is recorded outside of a render pass, after the queries have ended.
+	 * @param command_buffer Command buffer of the frame recording the copy
+	 * @param query_pool Pool of the queries
+	 * @param first_query Index of the first query
+	 * @param query_count Number of queries
+	 * @param flags How the results are written, VK_QUERY_RESULT_64_BIT is always added
+	 * @param callback Called with the 64-bit results, followed by the availability of each query if requested by the flags
+	 * @param values_per_query Number of results of each query, which is more than one for pipeline statistics
+	 */
+	void read_back_query_results(CommandBuffer &                                           command_buffer,
+	                             const QueryPool &                                         query_pool,
+	                             uint32_t                                                  first_query,
+	                             uint32_t                                                  query_count,
+	                             VkQueryResultFlags                                        flags,
+	                             std::function<void(const uint64_t *results, size_t count)> &&callback,
+	                             uint32_t                                                  values_per_query = 1);
+
+	/**
+	 * @return The number of bytes of the readback buffers of the frame
+	 */
+	VkDeviceSize get_readback_memory_size() const;
+
 	/**
 	 * @brief Updates all the descriptor sets in the current frame at a specific thread index
 	 */
 	void update_descriptor_sets(size_t thread_index = 0);
 
+	/**
+	 * @brief Retrieves the arena for transient CPU allocations of the frame, it is reset with the frame
+	 * @param thread_index Index of the arena to be used by the current thread
+	 */
+	MemoryArena &get_memory_arena(size_t thread_index = 0);
+
+	/**
+	 * @return The number of heap blocks allocated by the memory arenas of the frame since its creation
+	 */
+	size_t get_memory_arena_block_count() const;
+
+	/**
+	 * @return The number of bytes of the blocks held by the memory arenas of the frame
+	 */
+	size_t get_memory_arena_reserved_size() const;
+
+	/**
+	 * @return The number of Vulkan descriptor pools the frame allocates its descriptor sets from
+	 */
+	size_t get_descriptor_pool_count() const;
+
+	/**
+	 * @return The number of descriptor sets the descriptor pools of the frame can hold
+	 */
+	uint32_t get_descriptor_set_capacity() const;
+
+	/**
+	 * @return The number of descriptor sets allocated from the descriptor pools of the frame
+	 */
+	uint32_t get_descriptor_set_count() const;
+
+	/**
+	 * @return The descriptor set requests of all the threads of the frame since its creation
+	 */
+	DescriptorSetCounters get_descriptor_set_counters() const;
+
+	/**
+	 * @brief Adds the binds of a command buffer of the frame once it ends recording
+	 * @param counters The binds recorded by the command buffer
+	 * @param thread_index Index of the thread which recorded it
+	 */
+	void add_bind_counters(const BindCounters &counters, size_t thread_index = 0);
+
+	/**
+	 * @return The binds recorded by all the command buffers of the frame since its creation
+	 *         It may be called from any thread while command buffers are recorded, as continuous stats sampling does.
+	 */
+	BindCounters get_bind_counters() const;
+
+	/**
+	 * @brief Adds the attachment traffic of a command buffer of the frame once it ends recording
+	 * @param traffic The traffic estimated for the render passes of the command buffer
+	 * @param thread_index Index of the thread which recorded it
+	 */
+	void add_attachment_traffic(const AttachmentTraffic &traffic, size_t thread_index = 0);
+
+	/**
+	 * @return The attachment traffic estimated for all the command buffers of the frame since its creation
+	 *         It may be called from any thread while command buffers are recorded, as continuous stats sampling does.
+	 */
+	AttachmentTraffic get_attachment_traffic() const;
+
+	/**
+	 * @return The command buffers allocated, reused and reset by the command pools of the frame since its creation
+	 */
+	CommandBufferCounters get_command_buffer_counters() const;
+
+	/**
+	 * @return The bytes allocated from the buffer pools of the frame since its creation
+	 */
+	VkDeviceSize get_buffer_allocated_bytes() const;
+
+	/**
+	 * @return The number of buffer blocks requested from the buffer pools of the frame since its creation,
+	 *         which is an allocation each with BufferAllocationStrategy::OneAllocationPerBuffer
+	 */
+	uint64_t get_buffer_block_request_count() const;
+
+	/**
+	 * @return The number of buffer blocks owned by the buffer pools of the frame
+	 */
+	size_t get_buffer_block_count() const;
+
+	/**
+	 * @return The size in bytes of the buffer blocks owned by the buffer pools of the frame
+	 */
+	VkDeviceSize get_buffer_pool_memory_size() const;
+
+	/**
+	 * @return The peak demand of the buffer pools of every usage and thread, since the frame was created
+	 */
+	BufferPoolDemands get_buffer_pool_high_water_marks() const;
+
+	/**
+	 * @brief Creates the blocks the buffer pools need for a demand, for instance measured in a previous run
+	 *        Usages or threads the frame does not have are ignored.
+	 */
+	void reserve_buffer_pools(const BufferPoolDemands &demands);
+
+	/**
+	 * @return The number of threads with their own resource pools in the frame
+	 */
+	size_t get_thread_count() const;
+
   private:
 	Device &device;
 
+	/// Arenas of every thread, declared before the command pools since their command buffers allocate from them
+	std::vector<std::unique_ptr<MemoryArena>> memory_arenas;
+
+	/// Binds recorded by the command buffers of all the threads, atomic as continuous stats sampling reads them from its own thread
+	std::atomic<uint64_t> pipeline_binds{0};
+
+	std::atomic<uint64_t> pipeline_binds_saved{0};
+
+	std::atomic<uint64_t> descriptor_set_binds{0};
+
+	/// Attachment traffic of the command buffers of all the threads, atomic for the same reason as the bind counters
+	std::atomic<uint64_t> attachment_read_bytes{0};
+
+	std::atomic<uint64_t> attachment_write_bytes{0};
+
+	/// Counters of the command pools destroyed when their reset mode changed
+	CommandBufferCounters retired_command_buffer_counters;
+
+	/// Bytes allocated from the buffer pools by every thread
+	std::vector<VkDeviceSize> buffer_allocated_bytes;
+
+	/// Buffer blocks requested from the buffer pools by every thread
+	std::vector<uint64_t> buffer_block_requests;
+
+	/// Descriptor set requests of every thread
+	std::vector<DescriptorSetCounters> descriptor_set_counters;
+
+	/// Keys of the descriptor sets of every thread dropped by the last clear_descriptors
+	std::vector<std::unordered_set<std::size_t>> cleared_descriptor_set_keys;
+
+	/// Sets per thread kept across resets, 0 for no limit
+	size_t descriptor_set_budget{0};
+
+	/// Number of times the frame has been reset, descriptor sets are stamped with it while there is a budget
+	uint64_t reset_count{0};
+
+	/// Reset count at the last request of each descriptor set of every thread
+	std::vector<std::unordered_map<std::size_t, uint64_t>> descriptor_set_last_used;
+
+	/// Render packets extracted in the frame, kept across resets to reuse their memory
+	std::vector<std::unique_ptr<RenderPacket>> render_packets;
+
+	/// Guards render_packets, as subpasses may request packets from several threads
+	std::mutex render_packet_mutex;
+
+	/// A range of a readback buffer and the callback receiving its data
+	struct Readback
+	{
+		const core::Buffer *buffer;
+
+		VkDeviceSize offset;
+
+		VkDeviceSize size;
+
+		ReadbackCallback callback;
+	};
+
+	/// Host readable buffers the readbacks of the frame are allocated from, the last one is active
+	std::vector<std::unique_ptr<core::Buffer>> readback_buffers;
+
+	/// Offset of the free memory in the active readback buffer
+	VkDeviceSize readback_offset{0};
+
+	/// Readbacks requested since the frame was last reset
+	std::vector<Readback> readbacks;
+
+	/// Guards the readbacks, as recording threads may request them concurrently
+	mutable std::mutex readback_mutex;
+
+	/**
+	 * @brief Passes the data of the readbacks of the frame to their callbacks, then keeps a single buffer fitting them all
+	 *        Must only be called once the fences of the frame have been waited for.
+	 */
+	void collect_readbacks();
+
+	/**
+	 * @brief Drops the least recently requested descriptor sets of the threads over budget
+	 *        Must only be called once the fences of the frame have been waited for.
+	 */
+	void evict_descriptor_sets();
+
 	/**
 	 * @brief Retrieve the frame's command pool(s)
 	 * @param queue The queue command buffers will be submitted on
@@ -166,12 +520,25 @@ class RenderFrame
 
 	SemaphorePool semaphore_pool;
 
+	VkSemaphore timeline_semaphore{VK_NULL_HANDLE};
+
+	uint64_t timeline_value{0};
+
 	size_t thread_count;
 
 	std::unique_ptr<RenderTarget> swapchain_render_target;
 
 	BufferAllocationStrategy buffer_allocation_strategy{BufferAllocationStrategy::MultipleAllocationsPerBuffer};
 
-	std::map<VkBufferUsageFlags, std::vector<std::pair<BufferPool, BufferBlock *>>> buffer_pools;
+	/// Number of buffer usages in supported_usage_map
+	static constexpr size_t BUFFER_POOL_USAGE_COUNT = 8;
+
+	/**
+	 * @return The index of the buffer pools for a usage in buffer_pools, or BUFFER_POOL_USAGE_COUNT if it is not supported
+	 */
+	static size_t get_buffer_pool_index(VkBufferUsageFlags usage);
+
+	/// Buffer pools of every supported usage, with a pool and its active block for each thread
+	std::array<std::vector<std::pair<BufferPool, BufferBlock *>>, BUFFER_POOL_USAGE_COUNT> buffer_pools;
 };
 }        // namespace vkb
@@ -0,0 +1,846 @@
+/* Copyright (c) 2020, Arm Limited and Contributors
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 the "License";
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "rendering/render_graph.h"
+
+#include <algorithm>
+#include <numeric>
+
+#include "core/command_buffer.h"
+#include "core/device.h"
+#include "rendering/render_context.h"
+
+namespace vkb
+{
+namespace
+{
+/// Accesses which need to be made available before another access to the image
+constexpr VkAccessFlags IMAGE_WRITE_ACCESS_MASK = VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT | VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT | VK_ACCESS_SHADER_WRITE_BIT | VK_ACCESS_TRANSFER_WRITE_BIT;
+
+struct ImageAccess
+{
+	VkImageLayout layout;
+
+	VkPipelineStageFlags stage;
+
+	VkAccessFlags access;
+};
+
+ImageAccess get_image_access(const RenderGraphPass::ImageUse &use, VkFormat format)
+{
+	VkImageLayout read_layout = is_depth_stencil_format(format) ? VK_IMAGE_LAYOUT_DEPTH_STENCIL_READ_ONLY_OPTIMAL : VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+
+	switch (use.usage)
+	{
+		case RenderGraphUsage::ColorAttachment:
+			return {VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL,
+			        VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT,
+			        VK_ACCESS_COLOR_ATTACHMENT_READ_BIT | VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT};
+		case RenderGraphUsage::DepthStencilAttachment:
+			return {VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL,
+			        VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT | VK_PIPELINE_STAGE_LATE_FRAGMENT_TESTS_BIT,
+			        VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_READ_BIT | VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT};
+		case RenderGraphUsage::InputAttachment:
+			return {read_layout, VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT, VK_ACCESS_INPUT_ATTACHMENT_READ_BIT};
+		default:
+			return {read_layout, use.stage, VK_ACCESS_SHADER_READ_BIT};
+	}
+}
+
+VkImageUsageFlags get_image_usage(RenderGraphUsage usage)
+{
+	switch (usage)
+	{
+		case RenderGraphUsage::ColorAttachment:
+			return VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT;
+		case RenderGraphUsage::DepthStencilAttachment:
+			return VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT;
+		case RenderGraphUsage::InputAttachment:
+			return VK_IMAGE_USAGE_INPUT_ATTACHMENT_BIT;
+		default:
+			return VK_IMAGE_USAGE_SAMPLED_BIT;
+	}
+}
+
+inline bool is_write(RenderGraphUsage usage)
+{
+	return usage == RenderGraphUsage::ColorAttachment || usage == RenderGraphUsage::DepthStencilAttachment;
+}
+}        // namespace
+
+RenderGraphPass::RenderGraphPass(const std::string &name, std::unique_ptr<Subpass> &&subpass) :
+    name{name},
+    subpass{std::move(subpass)}
+{
+}
+
+RenderGraphPass &RenderGraphPass::write_color(uint32_t image)
+{
+	image_uses.push_back({image, RenderGraphUsage::ColorAttachment, VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT});
+	return *this;
+}
+
+RenderGraphPass &RenderGraphPass::write_depth_stencil(uint32_t image)
+{
+	image_uses.push_back({image, RenderGraphUsage::DepthStencilAttachment, VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT});
+	return *this;
+}
+
+RenderGraphPass &RenderGraphPass::read_input_attachment(uint32_t image)
+{
+	image_uses.push_back({image, RenderGraphUsage::InputAttachment, VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT});
+	return *this;
+}
+
+RenderGraphPass &RenderGraphPass::read_texture(uint32_t image, VkPipelineStageFlags stage)
+{
+	image_uses.push_back({image, RenderGraphUsage::Texture, stage});
+	return *this;
+}
+
+const std::string &RenderGraphPass::get_name() const
+{
+	return name;
+}
+
+const std::vector<RenderGraphPass::ImageUse> &RenderGraphPass::get_image_uses() const
+{
+	return image_uses;
+}
+
+std::unique_ptr<Subpass> &RenderGraphPass::get_subpass()
+{
+	return subpass;
+}
+
+RenderGraph::RenderGraph(RenderContext &render_context) :
+    render_context{render_context}
+{
+}
+
+RenderGraph::~RenderGraph()
+{
+	for (auto &frame : frame_images)
+	{
+		if (frame)
+		{
+			destroy_frame_images(*frame);
+		}
+	}
+}
+
+uint32_t RenderGraph::add_image(const std::string &name, VkFormat format, VkSampleCountFlagBits samples)
+{
+	assert(!compiled && "Images cannot be added to a compiled render graph");
+
+	ImageResource image;
+	image.name    = name;
+	image.format  = format;
+	image.samples = samples;
+
+	if (is_depth_stencil_format(format))
+	{
+		image.clear_value.depthStencil = {0.0f, ~0U};
+	}
+	else
+	{
+		image.clear_value.color = {0.0f, 0.0f, 0.0f, 1.0f};
+	}
+
+	images.push_back(image);
+
+	return to_u32(images.size() - 1);
+}
+
+uint32_t RenderGraph::import_attachment(const std::string &name, uint32_t attachment, VkImageLayout final_layout)
+{
+	// The format is only known once the graph is executed with a render target
+	uint32_t image = add_image(name, VK_FORMAT_UNDEFINED);
+
+	images[image].imported     = true;
+	images[image].attachment   = attachment;
+	images[image].final_layout = final_layout;
+
+	return image;
+}
+
+void RenderGraph::set_clear_value(uint32_t image, const VkClearValue &clear_value)
+{
+	images.at(image).clear_value = clear_value;
+}
+
+RenderGraphPass &RenderGraph::add_pass(const std::string &name, std::unique_ptr<Subpass> &&subpass)
+{
+	assert(!compiled && "Passes cannot be added to a compiled render graph");
+
+	passes.push_back(std::make_unique<RenderGraphPass>(name, std::move(subpass)));
+
+	return *passes.back();
+}
+
+bool RenderGraph::can_merge(const RenderPass &render_pass, const RenderGraphPass &pass) const
+{
+	auto is_attachment = [&render_pass](uint32_t image) {
+		return std::find(render_pass.attachments.begin(), render_pass.attachments.end(), image) != render_pass.attachments.end();
+	};
+
+	// Attachments written in a render pass can only be read by later subpasses as input attachments
+	for (auto &use : pass.get_image_uses())
+	{
+		if (use.usage == RenderGraphUsage::Texture && is_attachment(use.image))
+		{
+			return false;
+		}
+
+		for (auto pass_index : render_pass.passes)
+		{
+			for (auto &other_use : passes[pass_index]->get_image_uses())
+			{
+				if (other_use.image != use.image)
+				{
+					continue;
+				}
+
+				// Subpass dependencies only make attachment writes visible to input attachment reads
+				if (other_use.usage == RenderGraphUsage::Texture || is_write(use.usage))
+				{
+					return false;
+				}
+			}
+		}
+	}
+
+	// The render pass has a single depth stencil attachment and attachments share the same sample count
+	uint32_t              depth_stencil_image = ~0U;
+	VkSampleCountFlagBits samples             = images[render_pass.attachments.front()].samples;
+
+	auto is_compatible = [&](uint32_t image) {
+		if (images[image].samples != samples)
+		{
+			return false;
+		}
+
+		if (is_depth_stencil_format(images[image].format))
+		{
+			if (depth_stencil_image != ~0U && depth_stencil_image != image)
+			{
+				return false;
+			}
+
+			depth_stencil_image = image;
+		}
+
+		return true;
+	};
+
+	for (auto image : render_pass.attachments)
+	{
+		if (!is_compatible(image))
+		{
+			return false;
+		}
+	}
+
+	for (auto &use : pass.get_image_uses())
+	{
+		if (use.usage != RenderGraphUsage::Texture && !is_compatible(use.image))
+		{
+			return false;
+		}
+	}
+
+	return true;
+}
+
+void RenderGraph::compile(const RenderTarget &render_target)
+{
+	assert(!compiled && "Render graph is already compiled");
+
+	if (passes.empty())
+	{
+		throw std::runtime_error{"Render graph has no pass"};
+	}
+
+	for (auto &image : images)
+	{
+		if (image.imported)
+		{
+			if (image.attachment >= render_target.get_attachments().size())
+			{
+				throw std::runtime_error{"Render graph imports a missing render target attachment: " + image.name};
+			}
+
+			auto &attachment = render_target.get_attachments()[image.attachment];
+
+			image.format  = attachment.format;
+			image.samples = attachment.samples;
+		}
+	}
+
+	for (size_t pass_index = 0; pass_index < passes.size(); ++pass_index)
+	{
+		auto &pass = *passes[pass_index];
+
+		bool has_attachment = false;
+
+		for (auto &use : pass.get_image_uses())
+		{
+			if (use.image >= images.size())
+			{
+				throw std::runtime_error{"Render graph pass uses an unknown image: " + pass.get_name()};
+			}
+
+			has_attachment |= use.usage != RenderGraphUsage::Texture;
+		}
+
+		if (!has_attachment)
+		{
+			throw std::runtime_error{"Render graph pass has no attachment: " + pass.get_name()};
+		}
+
+		if (render_passes.empty() || !can_merge(render_passes.back(), pass))
+		{
+			render_passes.emplace_back();
+		}
+
+		auto &render_pass       = render_passes.back();
+		auto  render_pass_index = render_passes.size() - 1;
+
+		render_pass.passes.push_back(pass_index);
+
+		for (auto &use : pass.get_image_uses())
+		{
+			auto &image = images[use.image];
+
+			if (!image.used)
+			{
+				// Images start undefined at every frame
+				if (!is_write(use.usage))
+				{
+					throw std::runtime_error{"Render graph image is read before being written: " + image.name};
+				}
+
+				image.used              = true;
+				image.first_render_pass = render_pass_index;
+			}
+
+			image.last_render_pass = render_pass_index;
+			image.usage |= get_image_usage(use.usage);
+
+			if (use.usage != RenderGraphUsage::Texture &&
+			    std::find(render_pass.attachments.begin(), render_pass.attachments.end(), use.image) == render_pass.attachments.end())
+			{
+				render_pass.attachments.push_back(use.image);
+			}
+		}
+	}
+
+	for (auto &image : images)
+	{
+		if (image.imported && image.used && (render_target.get_attachments()[image.attachment].usage & image.usage) != image.usage)
+		{
+			throw std::runtime_error{"Render graph uses an imported attachment without the required image usage: " + image.name};
+		}
+	}
+
+	assign_physical_images();
+
+	compute_barriers();
+
+	create_render_pipelines();
+
+	compiled = true;
+}
+
+void RenderGraph::assign_physical_images()
+{
+	std::vector<uint32_t> order(images.size());
+	std::iota(order.begin(), order.end(), 0U);
+
+	std::stable_sort(order.begin(), order.end(), [this](uint32_t lhs, uint32_t rhs) {
+		return images[lhs].first_render_pass < images[rhs].first_render_pass;
+	});
+
+	for (auto image_index : order)
+	{
+		auto &image = images[image_index];
+
+		if (image.imported || !image.used)
+		{
+			continue;
+		}
+
+		// Content which never leaves a render pass does not need memory on tile based GPUs
+		if (image.first_render_pass == image.last_render_pass && !(image.usage & VK_IMAGE_USAGE_SAMPLED_BIT))
+		{
+			image.usage |= VK_IMAGE_USAGE_TRANSIENT_ATTACHMENT_BIT;
+		}
+
+		// Reuse an image whose last use is before the first use of this one
+		auto it = std::find_if(physical_images.begin(), physical_images.end(), [&image](const PhysicalImage &physical_image) {
+			return physical_image.format == image.format &&
+			       physical_image.samples == image.samples &&
+			       physical_image.usage == image.usage &&
+			       physical_image.last_render_pass < image.first_render_pass;
+		});
+
+		if (it == physical_images.end())
+		{
+			physical_images.push_back({image.format, image.samples, image.usage, image.first_render_pass, image.last_render_pass, 0});
+
+			image.physical_image = to_u32(physical_images.size() - 1);
+		}
+		else
+		{
+			it->last_render_pass = image.last_render_pass;
+
+			image.physical_image = to_u32(std::distance(physical_images.begin(), it));
+		}
+	}
+
+	// Physical images are in order of first use, memory is shared with images whose last use is before it
+	for (auto &physical_image : physical_images)
+	{
+		bool transient = physical_image.usage & VK_IMAGE_USAGE_TRANSIENT_ATTACHMENT_BIT;
+
+		auto it = std::find_if(memory_blocks.begin(), memory_blocks.end(), [&physical_image, transient](const MemoryBlock &memory_block) {
+			return !transient && !memory_block.transient && memory_block.last_render_pass < physical_image.first_render_pass;
+		});
+
+		if (it == memory_blocks.end())
+		{
+			memory_blocks.push_back({physical_image.last_render_pass, transient});
+
+			physical_image.memory_block = to_u32(memory_blocks.size() - 1);
+		}
+		else
+		{
+			it->last_render_pass = physical_image.last_render_pass;
+
+			physical_image.memory_block = to_u32(std::distance(memory_blocks.begin(), it));
+		}
+	}
+}
+
+void RenderGraph::compute_barriers()
+{
+	// Tracks the last access to each memory block, followed by each imported image
+	std::vector<ImageAccess> states(memory_blocks.size() + images.size());
+
+	auto get_state = [&](uint32_t image) -> ImageAccess & {
+		return images[image].imported ? states[memory_blocks.size() + image] : states[physical_images[images[image].physical_image].memory_block];
+	};
+
+	for (uint32_t image = 0; image < images.size(); ++image)
+	{
+		// Imported images are acquired by the wait on the swapchain semaphore
+		get_state(image) = {VK_IMAGE_LAYOUT_UNDEFINED,
+		                    images[image].imported ? VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT : VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT,
+		                    0};
+	}
+
+	for (size_t render_pass_index = 0; render_pass_index < render_passes.size(); ++render_pass_index)
+	{
+		auto &render_pass = render_passes[render_pass_index];
+
+		// Accesses of each image in the render pass, the render pass doing the transitions between its subpasses
+		std::vector<uint32_t>    accessed_images;
+		std::vector<ImageAccess> first_accesses;
+		std::vector<ImageAccess> accesses;
+
+		for (auto pass_index : render_pass.passes)
+		{
+			for (auto &use : passes[pass_index]->get_image_uses())
+			{
+				ImageAccess access = get_image_access(use, images[use.image].format);
+
+				auto it = std::find(accessed_images.begin(), accessed_images.end(), use.image);
+
+				if (it == accessed_images.end())
+				{
+					accessed_images.push_back(use.image);
+					first_accesses.push_back(access);
+					accesses.push_back(access);
+				}
+				else
+				{
+					auto &last_access = accesses[std::distance(accessed_images.begin(), it)];
+
+					last_access.layout = access.layout;
+					last_access.stage |= access.stage;
+					last_access.access |= access.access;
+				}
+			}
+		}
+
+		for (size_t i = 0; i < accessed_images.size(); ++i)
+		{
+			auto  image = accessed_images[i];
+			auto &state = get_state(image);
+
+			// The previous content of an image is discarded by its first write
+			VkImageLayout old_layout = images[image].first_render_pass == render_pass_index ? VK_IMAGE_LAYOUT_UNDEFINED : state.layout;
+
+			bool write_after_access = (accesses[i].access & IMAGE_WRITE_ACCESS_MASK) && state.access != 0;
+
+			if (old_layout != first_accesses[i].layout || (state.access & IMAGE_WRITE_ACCESS_MASK) || write_after_access)
+			{
+				Barrier barrier{image, {}};
+				barrier.memory_barrier.src_stage_mask  = state.stage;
+				barrier.memory_barrier.dst_stage_mask  = accesses[i].stage;
+				barrier.memory_barrier.src_access_mask = state.access & IMAGE_WRITE_ACCESS_MASK;
+				barrier.memory_barrier.dst_access_mask = accesses[i].access;
+				barrier.memory_barrier.old_layout      = old_layout;
+				barrier.memory_barrier.new_layout      = first_accesses[i].layout;
+
+				render_pass.barriers.push_back(barrier);
+			}
+
+			state = accesses[i];
+		}
+	}
+
+	for (uint32_t image = 0; image < images.size(); ++image)
+	{
+		if (!images[image].imported || !images[image].used)
+		{
+			continue;
+		}
+
+		auto &state = get_state(image);
+
+		if (state.layout != images[image].final_layout)
+		{
+			Barrier barrier{image, {}};
+			barrier.memory_barrier.src_stage_mask  = state.stage;
+			barrier.memory_barrier.dst_stage_mask  = VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT;
+			barrier.memory_barrier.src_access_mask = state.access & IMAGE_WRITE_ACCESS_MASK;
+			barrier.memory_barrier.old_layout      = state.layout;
+			barrier.memory_barrier.new_layout      = images[image].final_layout;
+
+			final_barriers.push_back(barrier);
+		}
+	}
+}
+
+void RenderGraph::create_render_pipelines()
+{
+	for (size_t render_pass_index = 0; render_pass_index < render_passes.size(); ++render_pass_index)
+	{
+		auto &render_pass = render_passes[render_pass_index];
+
+		std::vector<LoadStoreInfo> load_store;
+		std::vector<VkClearValue>  clear_value;
+
+		for (auto image : render_pass.attachments)
+		{
+			// Attachments are only stored if a later render pass or the render target needs them
+			LoadStoreInfo info;
+			info.load_op  = images[image].first_render_pass == render_pass_index ? VK_ATTACHMENT_LOAD_OP_CLEAR : VK_ATTACHMENT_LOAD_OP_LOAD;
+			info.store_op = images[image].imported || images[image].last_render_pass > render_pass_index ? VK_ATTACHMENT_STORE_OP_STORE : VK_ATTACHMENT_STORE_OP_DONT_CARE;
+
+			load_store.push_back(info);
+			clear_value.push_back(images[image].clear_value);
+		}
+
+		render_pass.pipeline = std::make_unique<RenderPipeline>();
+		render_pass.pipeline->set_load_store(load_store);
+		render_pass.pipeline->set_clear_value(clear_value);
+
+		for (auto pass_index : render_pass.passes)
+		{
+			auto &pass = *passes[pass_index];
+
+			std::vector<uint32_t> output_attachments;
+			std::vector<uint32_t> input_attachments;
+			bool                  has_depth_stencil = false;
+
+			for (auto &use : pass.get_image_uses())
+			{
+				auto attachment = to_u32(std::distance(render_pass.attachments.begin(), std::find(render_pass.attachments.begin(), render_pass.attachments.end(), use.image)));
+
+				switch (use.usage)
+				{
+					case RenderGraphUsage::ColorAttachment:
+						output_attachments.push_back(attachment);
+						break;
+					case RenderGraphUsage::DepthStencilAttachment:
+						has_depth_stencil = true;
+						break;
+					case RenderGraphUsage::InputAttachment:
+						input_attachments.push_back(attachment);
+						break;
+					default:
+						break;
+				}
+			}
+
+			auto &subpass = pass.get_subpass();
+			subpass->set_output_attachments(output_attachments);
+			subpass->set_input_attachments(input_attachments);
+			subpass->set_disable_depth_stencil_attachment(!has_depth_stencil);
+
+			render_pass.pipeline->add_subpass(std::move(subpass));
+		}
+	}
+}
+
+RenderGraph::FrameImages &RenderGraph::prepare_frame_images(RenderTarget &render_target)
+{
+	uint32_t frame_index = render_context.get_active_frame_index();
+
+	if (frame_images.size() <= frame_index)
+	{
+		frame_images.resize(frame_index + 1);
+	}
+
+	if (!frame_images[frame_index])
+	{
+		frame_images[frame_index] = std::make_unique<FrameImages>();
+	}
+
+	auto &frame = *frame_images[frame_index];
+
+	std::vector<VkImage> imported_images;
+
+	for (auto &image : images)
+	{
+		if (image.imported)
+		{
+			imported_images.push_back(render_target.get_views()[image.attachment].get_image().get_handle());
+		}
+	}
+
+	const VkExtent2D &extent = render_target.get_extent();
+
+	if (frame.extent.width != extent.width || frame.extent.height != extent.height || frame.imported_images != imported_images)
+	{
+		frame.imported_images = imported_images;
+
+		create_frame_images(frame, render_target);
+	}
+
+	// Render targets of frames are recreated along with the swapchain
+	frame.image_views.clear();
+
+	for (auto &image : images)
+	{
+		if (image.imported)
+		{
+			frame.image_views.push_back(&render_target.get_views()[image.attachment]);
+		}
+		else
+		{
+			frame.image_views.push_back(image.used ? &frame.views[image.physical_image] : nullptr);
+		}
+	}
+
+	return frame;
+}
+
+void RenderGraph::create_frame_images(FrameImages &frame, RenderTarget &render_target)
+{
+	const VkExtent2D &extent = render_target.get_extent();
+
+	destroy_frame_images(frame);
+
+	frame.extent = extent;
+
+	Device &   device       = render_context.get_device();
+	VkExtent3D image_extent = {extent.width, extent.height, 1};
+
+	// Memory blocks fit the largest of their images, with a memory type all of them support
+	std::vector<VkMemoryRequirements> block_requirements(memory_blocks.size());
+
+	for (auto &requirements : block_requirements)
+	{
+		requirements = {0, 1, ~0U};
+	}
+
+	std::vector<VkMemoryRequirements> image_requirements(physical_images.size());
+
+	for (size_t i = 0; i < physical_images.size(); ++i)
+	{
+		auto &physical_image = physical_images[i];
+
+		if (memory_blocks[physical_image.memory_block].transient)
+		{
+			continue;
+		}
+
+		image_requirements[i] = core::Image::get_memory_requirements(device, image_extent, physical_image.format, physical_image.usage, physical_image.samples);
+
+		auto &requirements = block_requirements[physical_image.memory_block];
+
+		requirements.size      = std::max(requirements.size, image_requirements[i].size);
+		requirements.alignment = std::max(requirements.alignment, image_requirements[i].alignment);
+		requirements.memoryTypeBits &= image_requirements[i].memoryTypeBits;
+	}
+
+	// Memory the images would need without aliasing
+	VkDeviceSize requested_size = 0;
+
+	for (auto &image : images)
+	{
+		if (!image.imported && image.used)
+		{
+			requested_size += image_requirements[image.physical_image].size;
+		}
+	}
+
+	VkDeviceSize allocated_size = 0;
+
+	frame.memory.assign(memory_blocks.size(), VK_NULL_HANDLE);
+
+	for (size_t i = 0; i < memory_blocks.size(); ++i)
+	{
+		if (memory_blocks[i].transient || block_requirements[i].memoryTypeBits == 0)
+		{
+			continue;
+		}
+
+		VmaAllocationCreateInfo memory_info{};
+		memory_info.usage = VMA_MEMORY_USAGE_GPU_ONLY;
+
+		VK_CHECK(vmaAllocateMemory(device.get_memory_allocator(), &block_requirements[i], &memory_info, &frame.memory[i], nullptr));
+
+		allocated_size += block_requirements[i].size;
+	}
+
+	frame.images.reserve(physical_images.size());
+	frame.views.reserve(physical_images.size());
+
+	for (size_t i = 0; i < physical_images.size(); ++i)
+	{
+		auto &physical_image = physical_images[i];
+
+		VmaAllocation memory = frame.memory[physical_image.memory_block];
+
+		if (memory != VK_NULL_HANDLE)
+		{
+			frame.images.emplace_back(device, image_extent, physical_image.format, physical_image.usage, memory, physical_image.samples);
+		}
+		else
+		{
+			// Transient attachments, or images without a memory type in common with the others of their block
+			frame.images.emplace_back(device, image_extent, physical_image.format, physical_image.usage, VMA_MEMORY_USAGE_GPU_ONLY, physical_image.samples);
+
+			allocated_size += image_requirements[i].size;
+		}
+
+		frame.views.emplace_back(frame.images.back(), VK_IMAGE_VIEW_TYPE_2D);
+	}
+
+	// Transient attachments are not counted, as they are backed by tile memory where lazily allocated memory is available
+	LOGI("Render graph images of a frame: {} KiB of memory for {} KiB of images, {} of {} images are transient attachments",
+	     allocated_size / 1024,
+	     requested_size / 1024,
+	     std::count_if(physical_images.begin(), physical_images.end(), [](const PhysicalImage &physical_image) { return (physical_image.usage & VK_IMAGE_USAGE_TRANSIENT_ATTACHMENT_BIT) != 0; }),
+	     physical_images.size());
+
+	for (auto &render_pass : render_passes)
+	{
+		std::vector<core::ImageView> views;
+
+		for (auto image : render_pass.attachments)
+		{
+			auto &resource = images[image];
+
+			if (resource.imported)
+			{
+				views.emplace_back(render_target.get_image(resource.attachment), VK_IMAGE_VIEW_TYPE_2D);
+			}
+			else
+			{
+				views.emplace_back(frame.images[resource.physical_image], VK_IMAGE_VIEW_TYPE_2D);
+			}
+		}
+
+		frame.render_targets.push_back(std::make_unique<RenderTarget>(std::move(views)));
+	}
+}
+
+void RenderGraph::destroy_frame_images(FrameImages &frame)
+{
+	// The render targets refer to the views, which refer to the images, bound to the memory
+	frame.render_targets.clear();
+	frame.views.clear();
+	frame.images.clear();
+
+	for (auto memory : frame.memory)
+	{
+		if (memory != VK_NULL_HANDLE)
+		{
+			vmaFreeMemory(render_context.get_device().get_memory_allocator(), memory);
+		}
+	}
+
+	frame.memory.clear();
+}
+
+void RenderGraph::execute(CommandBuffer &command_buffer, RenderTarget &render_target)
+{
+	if (!compiled)
+	{
+		compile(render_target);
+	}
+
+	active_frame_images = &prepare_frame_images(render_target);
+
+	for (size_t render_pass_index = 0; render_pass_index < render_passes.size(); ++render_pass_index)
+	{
+		auto &render_pass = render_passes[render_pass_index];
+
+		for (auto &barrier : render_pass.barriers)
+		{
+			command_buffer.image_memory_barrier(*active_frame_images->image_views[barrier.image], barrier.memory_barrier);
+		}
+
+		render_pass.pipeline->draw(command_buffer, *active_frame_images->render_targets[render_pass_index]);
+
+		command_buffer.end_render_pass();
+	}
+
+	for (auto &barrier : final_barriers)
+	{
+		command_buffer.image_memory_barrier(*active_frame_images->image_views[barrier.image], barrier.memory_barrier);
+	}
+}
+
+const core::ImageView &RenderGraph::get_image_view(uint32_t image) const
+{
+	assert(active_frame_images && "Render graph has not been executed");
+	assert(active_frame_images->image_views.at(image) && "Render graph image is not used by any pass");
+
+	return *active_frame_images->image_views[image];
+}
+
+size_t RenderGraph::get_render_pass_count() const
+{
+	return render_passes.size();
+}
+
+size_t RenderGraph::get_physical_image_count() const
+{
+	return physical_images.size();
+}
+
+size_t RenderGraph::get_memory_block_count() const
+{
+	return memory_blocks.size();
+}
+}        // namespace vkb
@@ -0,0 +1,325 @@
+/* Copyright (c) 2020, Arm Limited and Contributors
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 the "License";
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include "common/helpers.h"
+#include "common/vk_common.h"
+#include "rendering/render_pipeline.h"
+#include "rendering/render_target.h"
+
+namespace vkb
+{
+class CommandBuffer;
+class RenderContext;
+
+/**
+ * @brief How a pass of a RenderGraph uses an image
+ */
+enum class RenderGraphUsage
+{
+	ColorAttachment,
+	DepthStencilAttachment,
+	InputAttachment,
+	Texture
+};
+
+/**
+ * @brief A pass of a RenderGraph, a Subpass with the images it reads and writes
+ */
+class RenderGraphPass
+{
+  public:
+	struct ImageUse
+	{
+		uint32_t image;
+
+		RenderGraphUsage usage;
+
+		/// Shader stages sampling the image, only used by textures
+		VkPipelineStageFlags stage;
+	};
+
+	RenderGraphPass(const std::string &name, std::unique_ptr<Subpass> &&subpass);
+
+	/**
+	 * @brief Declares an image written as a color attachment
+	 */
+	RenderGraphPass &write_color(uint32_t image);
+
+	/**
+	 * @brief Declares an image written as the depth stencil attachment
+	 */
+	RenderGraphPass &write_depth_stencil(uint32_t image);
+
+	/**
+	 * @brief Declares an image read as an input attachment, which lets the pass merge with the pass writing it
+	 */
+	RenderGraphPass &read_input_attachment(uint32_t image);
+
+	/**
+	 * @brief Declares an image sampled by shaders, which needs to be written by a previous render pass
+	 * @param image Image to sample, its view is given by RenderGraph::get_image_view
+	 * @param stage Shader stages sampling the image
+	 */
+	RenderGraphPass &read_texture(uint32_t image, VkPipelineStageFlags stage = VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT);
+
+	const std::string &get_name() const;
+
+	const std::vector<ImageUse> &get_image_uses() const;
+
+	/**
+	 * @return The subpass, moved to a RenderPipeline once the graph is compiled
+	 */
+	std::unique_ptr<Subpass> &get_subpass();
+
+  private:
+	std::string name;
+
+	std::unique_ptr<Subpass> subpass;
+
+	/// Images used by the pass in declaration order
+	std::vector<ImageUse> image_uses;
+};
+
+/**
+ * @brief A RenderGraph builds RenderPipeline objects from passes declaring the images they read and write.
+ * Consecutive passes which only exchange images through attachments are merged into the subpasses of a render pass.
+ * The barriers and layout transitions between render passes are computed once when compiling the graph, only where
+ * an image changes layout or a write needs to be made visible.
+ * Images declared by the graph live for a frame, so images with the same description and disjoint lifetimes are
+ * backed by the same core::Image, other images with disjoint lifetimes share memory, and images which stay within
+ * a render pass are lazily allocated transient attachments.
+ */
+class RenderGraph
+{
+  public:
+	RenderGraph(RenderContext &render_context);
+
+	~RenderGraph();
+
+	RenderGraph(const RenderGraph &) = delete;
+
+	RenderGraph(RenderGraph &&) = delete;
+
+	RenderGraph &operator=(const RenderGraph &) = delete;
+
+	RenderGraph &operator=(RenderGraph &&) = delete;
+
+	/**
+	 * @brief Declares an image created by the graph with the extent of the render target, its content is discarded at the end of the frame
+	 * @return Handle of the image in the graph
+	 */
+	uint32_t add_image(const std::string &name, VkFormat format, VkSampleCountFlagBits samples = VK_SAMPLE_COUNT_1_BIT);
+
+	/**
+	 * @brief Declares an attachment of the render target the graph is executed with, such as the swapchain image
+	 *        Its format is the one of the render target the graph is compiled with.
+	 * @param attachment Index of the image in the render target
+	 * @param final_layout Layout the image is transitioned to at the end of the graph
+	 * @return Handle of the image in the graph
+	 */
+	uint32_t import_attachment(const std::string &name, uint32_t attachment, VkImageLayout final_layout = VK_IMAGE_LAYOUT_PRESENT_SRC_KHR);
+
+	/**
+	 * @brief Sets the value an image is cleared to by its first write
+	 *        Color images are cleared to opaque black and depth images to 0 by default
+	 */
+	void set_clear_value(uint32_t image, const VkClearValue &clear_value);
+
+	/**
+	 * @brief Appends a pass, executed after the passes added before it
+	 */
+	RenderGraphPass &add_pass(const std::string &name, std::unique_ptr<Subpass> &&subpass);
+
+	/**
+	 * @brief Merges the passes into render passes and computes the barriers between them
+	 *        Called by the first execute, no pass can be added afterwards.
+	 * @param render_target A render target with the attachments imported by the graph
+	 */
+	void compile(const RenderTarget &render_target);
+
+	/**
+	 * @brief Records the render passes of the graph
+	 * @param command_buffer Command buffer to record to
+	 * @param render_target Render target of the active frame, providing the imported attachments
+	 */
+	void execute(CommandBuffer &command_buffer, RenderTarget &render_target);
+
+	/**
+	 * @return A view of the image for the frame being executed, which subpasses use to bind textures
+	 */
+	const core::ImageView &get_image_view(uint32_t image) const;
+
+	/**
+	 * @return The number of render passes after merging the passes
+	 */
+	size_t get_render_pass_count() const;
+
+	/**
+	 * @return The number of core::Image objects created per frame for the images declared by the graph
+	 */
+	size_t get_physical_image_count() const;
+
+	/**
+	 * @return The number of memory allocations per frame shared by images with disjoint lifetimes
+	 */
+	size_t get_memory_block_count() const;
+
+  private:
+	struct ImageResource
+	{
+		std::string name;
+
+		VkFormat format{VK_FORMAT_UNDEFINED};
+
+		VkSampleCountFlagBits samples{VK_SAMPLE_COUNT_1_BIT};
+
+		VkImageUsageFlags usage{0};
+
+		VkClearValue clear_value{};
+
+		bool imported{false};
+
+		/// Attachment of the render target for imported images
+		uint32_t attachment{0};
+
+		VkImageLayout final_layout{VK_IMAGE_LAYOUT_UNDEFINED};
+
+		/// Index of the physical image for images declared by the graph
+		uint32_t physical_image{0};
+
+		bool used{false};
+
+		/// First and last render passes using the image
+		size_t first_render_pass{0};
+
+		size_t last_render_pass{0};
+	};
+
+	struct PhysicalImage
+	{
+		VkFormat format;
+
+		VkSampleCountFlagBits samples;
+
+		VkImageUsageFlags usage;
+
+		size_t first_render_pass;
+
+		size_t last_render_pass;
+
+		/// Index of the memory block backing the image
+		uint32_t memory_block;
+	};
+
+	/// Memory shared by physical images with disjoint lifetimes
+	struct MemoryBlock
+	{
+		size_t last_render_pass;
+
+		/// Transient attachments have their own lazily allocated memory
+		bool transient;
+	};
+
+	struct Barrier
+	{
+		uint32_t image;
+
+		ImageMemoryBarrier memory_barrier;
+	};
+
+	struct RenderPass
+	{
+		/// Indices of the passes merged into the render pass
+		std::vector<size_t> passes;
+
+		/// Images used as attachments, in attachment order
+		std::vector<uint32_t> attachments;
+
+		/// Barriers recorded before beginning the render pass
+		std::vector<Barrier> barriers;
+
+		std::unique_ptr<RenderPipeline> pipeline;
+	};
+
+	/// Images of a render frame
+	struct FrameImages
+	{
+		VkExtent2D extent{};
+
+		/// Handles of the imported images the render targets refer to
+		std::vector<VkImage> imported_images;
+
+		/// Memory of each memory block, null when the images of a block need their own memory
+		std::vector<VmaAllocation> memory;
+
+		std::vector<core::Image> images;
+
+		std::vector<core::ImageView> views;
+
+		/// Views of each image of the graph, including imported ones
+		std::vector<const core::ImageView *> image_views;
+
+		/// Render target of each render pass
+		std::vector<std::unique_ptr<RenderTarget>> render_targets;
+	};
+
+	/**
+	 * @brief Checks whether a pass can become a subpass of a render pass
+	 */
+	bool can_merge(const RenderPass &render_pass, const RenderGraphPass &pass) const;
+
+	void assign_physical_images();
+
+	void compute_barriers();
+
+	void create_render_pipelines();
+
+	/**
+	 * @brief Creates the images of the active frame, when its render target changed
+	 */
+	FrameImages &prepare_frame_images(RenderTarget &render_target);
+
+	void create_frame_images(FrameImages &frame, RenderTarget &render_target);
+
+	void destroy_frame_images(FrameImages &frame);
+
+	RenderContext &render_context;
+
+	std::vector<ImageResource> images;
+
+	std::vector<std::unique_ptr<RenderGraphPass>> passes;
+
+	std::vector<RenderPass> render_passes;
+
+	std::vector<PhysicalImage> physical_images;
+
+	std::vector<MemoryBlock> memory_blocks;
+
+	/// Barriers recorded after the last render pass
+	std::vector<Barrier> final_barriers;
+
+	/// Images per render frame, kept alive while the frame is in flight
+	std::vector<std::unique_ptr<FrameImages>> frame_images;
+
+	/// Images of the frame being executed
+	FrameImages *active_frame_images{nullptr};
+
+	bool compiled{false};
+};
+}        // namespace vkb
@@ -0,0 +1,179 @@
+/* Copyright (c) 2020, Arm Limited and Contributors
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 the "License";
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "rendering/render_packet.h"
+
+#include <algorithm>
+#include <future>
+
+#include "geometry/frustum.h"
+#include "job_system.h"
+#include "rendering/subpass.h"
+#include "scene_graph/components/camera.h"
+#include "scene_graph/components/light.h"
+#include "scene_graph/components/mesh.h"
+#include "scene_graph/node.h"
+#include "scene_graph/scene.h"
+
+namespace vkb
+{
+namespace
+{
+/// Fewer draws than this have their distances computed on the calling thread
+constexpr size_t PARALLEL_DRAW_COUNT = 256;
+}        // namespace
+
+void RenderPacket::extract(sg::Scene &scene_, sg::Camera &camera_, bool cull_)
+{
+	scene     = &scene_;
+	camera    = &camera_;
+	cull      = cull_;
+	extracted = true;
+
+	view            = camera_.get_view();
+	projection      = camera_.get_pre_rotation() * vulkan_style_projection(camera_.get_projection());
+	view_projection = projection * view;
+	camera_position = glm::vec3(glm::inverse(view)[3]);
+
+	Frustum frustum;
+	frustum.update(view_projection);
+
+	// Lights which cannot reach the frustum light no pixel, whether the meshes are culled on the CPU or not
+	visible_lights.clear();
+	scene_.query_visible_lights(frustum, visible_lights);
+
+	lights.assign(visible_lights.begin(), visible_lights.end());
+
+	draws.clear();
+
+	// World matrices are resolved serially, as they lazily update the cached transforms of parent nodes
+	if (cull)
+	{
+		visible_instances.clear();
+		scene_.query_visible(frustum, visible_instances);
+
+		const auto &mesh_instances = scene_.get_mesh_instances();
+
+		for (auto index : visible_instances)
+		{
+			auto &instance = mesh_instances[index];
+			draws.push_back({instance.node, instance.mesh, instance.node->get_transform().get_world_matrix(), 0.0f});
+		}
+	}
+	else
+	{
+		for (auto mesh : scene_.get_components<sg::Mesh>())
+		{
+			for (auto node : mesh->get_nodes())
+			{
+				draws.push_back({node, mesh, node->get_transform().get_world_matrix(), 0.0f});
+			}
+		}
+	}
+
+	auto compute_distances = [this](size_t first_draw, size_t last_draw) {
+		for (size_t i = first_draw; i < last_draw; ++i)
+		{
+			auto &draw = draws[i];
+
+			const sg::AABB &mesh_bounds = draw.mesh->get_bounds();
+
+			sg::AABB world_bounds{mesh_bounds.get_min(), mesh_bounds.get_max()};
+			world_bounds.transform(draw.world_matrix);
+
+			draw.camera_distance = glm::length(camera_position - world_bounds.get_center());
+		}
+	};
+
+	if (draws.size() < PARALLEL_DRAW_COUNT)
+	{
+		compute_distances(0, draws.size());
+		return;
+	}
+
+	auto &job_system = JobSystem::get();
+
+	std::vector<std::future<void>> chunk_futures;
+
+	// The calling thread computes the first chunk
+	size_t chunk_count = job_system.get_thread_count() + 1;
+	size_t chunk_size  = (draws.size() + chunk_count - 1) / chunk_count;
+
+	for (size_t first_draw = chunk_size; first_draw < draws.size(); first_draw += chunk_size)
+	{
+		size_t last_draw = std::min(first_draw + chunk_size, draws.size());
+
+		chunk_futures.push_back(job_system.push([&compute_distances, first_draw, last_draw](size_t) {
+			compute_distances(first_draw, last_draw);
+		},
+		                                        JobPriority::High));
+	}
+
+	compute_distances(0, std::min(chunk_size, draws.size()));
+
+	for (auto &future : chunk_futures)
+	{
+		job_system.wait(future);
+		future.get();
+	}
+}
+
+void RenderPacket::clear()
+{
+	extracted = false;
+}
+
+bool RenderPacket::is_extracted() const
+{
+	return extracted;
+}
+
+bool RenderPacket::matches(const sg::Scene &scene_, const sg::Camera &camera_, bool cull_) const
+{
+	return scene == &scene_ && camera == &camera_ && cull == cull_;
+}
+
+const std::vector<RenderPacket::Draw> &RenderPacket::get_draws() const
+{
+	return draws;
+}
+
+sg::ComponentSpan<sg::Light> RenderPacket::get_lights() const
+{
+	return {lights.data(), lights.size()};
+}
+
+const glm::mat4 &RenderPacket::get_view() const
+{
+	return view;
+}
+
+const glm::mat4 &RenderPacket::get_projection() const
+{
+	return projection;
+}
+
+const glm::mat4 &RenderPacket::get_view_projection() const
+{
+	return view_projection;
+}
+
+const glm::vec3 &RenderPacket::get_camera_position() const
+{
+	return camera_position;
+}
+}        // namespace vkb
@@ -0,0 +1,133 @@
+/* Copyright (c) 2020, Arm Limited and Contributors
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 the "License";
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+#include "common/error.h"
+
+VKBP_DISABLE_WARNINGS()
+#include "common/glm_common.h"
+VKBP_ENABLE_WARNINGS()
+
+#include "scene_graph/component_span.h"
+
+namespace vkb
+{
+namespace sg
+{
+class Camera;
+class Component;
+class Light;
+class Mesh;
+class Node;
+class Scene;
+}        // namespace sg
+
+/**
+ * @brief A snapshot of what a camera draws of a scene in a frame: its visible mesh instances with
+ *        their world matrices, the lights and the camera matrices
+ *
+ * The packet is extracted once per frame, then only read by the subpasses, so that recording
+ * threads never touch the scene. Extracting resolves the world matrices of the drawn nodes,
+ * which leaves their cached transforms clean for the rest of the frame.
+ */
+class RenderPacket
+{
+  public:
+	/**
+	 * @brief A mesh drawn at a node
+	 */
+	struct Draw
+	{
+		sg::Node *node;
+
+		sg::Mesh *mesh;
+
+		glm::mat4 world_matrix;
+
+		/// Distance from the camera to the center of the world bounds of the mesh
+		float camera_distance;
+	};
+
+	/**
+	 * @brief Fills the packet from a scene, reusing the memory of its last extraction
+	 * @param scene Scene to extract
+	 * @param camera Camera viewing the scene
+	 * @param cull Whether to only keep the mesh instances inside of the camera frustum
+	 */
+	void extract(sg::Scene &scene, sg::Camera &camera, bool cull);
+
+	/**
+	 * @brief Marks the packet as not extracted, keeping its memory
+	 */
+	void clear();
+
+	bool is_extracted() const;
+
+	/**
+	 * @return Whether the packet was extracted from a scene, camera and culling mode
+	 */
+	bool matches(const sg::Scene &scene, const sg::Camera &camera, bool cull) const;
+
+	const std::vector<Draw> &get_draws() const;
+
+	/**
+	 * @return The lights of the scene which reach the camera frustum at extraction, in the order of the scene,
+	 *         which remain valid when lights are added to the scene
+	 */
+	sg::ComponentSpan<sg::Light> get_lights() const;
+
+	const glm::mat4 &get_view() const;
+
+	/// Projection with the Vulkan clip space and the pre-rotation of the camera applied
+	const glm::mat4 &get_projection() const;
+
+	const glm::mat4 &get_view_projection() const;
+
+	const glm::vec3 &get_camera_position() const;
+
+  private:
+	const sg::Scene *scene{nullptr};
+
+	const sg::Camera *camera{nullptr};
+
+	bool cull{false};
+
+	bool extracted{false};
+
+	std::vector<Draw> draws;
+
+	std::vector<sg::Component *> lights;
+
+	/// Lights of the scene reaching the camera frustum
+	std::vector<sg::Light *> visible_lights;
+
+	/// Mesh instances of the scene inside of the camera frustum
+	std::vector<uint32_t> visible_instances;
+
+	glm::mat4 view{1.0f};
+
+	glm::mat4 projection{1.0f};
+
+	glm::mat4 view_projection{1.0f};
+
+	glm::vec3 camera_position{0.0f};
+};
+}        // namespace vkb
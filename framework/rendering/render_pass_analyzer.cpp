@@ -0,0 +1,358 @@
+/* Copyright (c) 2020, Arm Limited and Contributors
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 the "License";
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#include "render_pass_analyzer.h"
+
+#include <algorithm>
+
+#include "common/logging.h"
+#include "core/image.h"
+#include "core/swapchain.h"
+#include "rendering/render_context.h"
+#include "rendering/render_pipeline.h"
+#include "rendering/render_target.h"
+
+namespace vkb
+{
+namespace
+{
+/// Usages through which an image can be read other than as the attachment of a later pass
+constexpr VkImageUsageFlags EXTERNAL_READ_USAGE = VK_IMAGE_USAGE_SAMPLED_BIT | VK_IMAGE_USAGE_STORAGE_BIT | VK_IMAGE_USAGE_TRANSFER_SRC_BIT;
+
+/// Usages through which an image can be written other than as the attachment of a pass
+constexpr VkImageUsageFlags EXTERNAL_WRITE_USAGE = VK_IMAGE_USAGE_STORAGE_BIT | VK_IMAGE_USAGE_TRANSFER_DST_BIT;
+
+float to_mib(VkDeviceSize bytes)
+{
+	return static_cast<float>(bytes) / (1024.0f * 1024.0f);
+}
+}        // namespace
+
+constexpr uint32_t RenderPassAnalyzer::FRAMES_BEFORE_APPLY;
+
+RenderPassAnalyzer::RenderPassAnalyzer(RenderContext &render_context) :
+    render_context{render_context}
+{
+}
+
+void RenderPassAnalyzer::set_auto_apply(bool enable)
+{
+	auto_apply = enable;
+}
+
+void RenderPassAnalyzer::record(RenderPipeline &pipeline, const RenderTarget &render_target, const std::vector<LoadStoreInfo> &load_store, const std::vector<uint32_t> &attachments)
+{
+	Pass pass{&pipeline, render_target.get_extent(), {}};
+
+	for (auto index : attachments)
+	{
+		auto &attachment = render_target.get_attachments()[index];
+		auto &image      = render_target.get_views()[index].get_image();
+
+		// Missing operations are zero initialized by render passes
+		LoadStoreInfo ops{VK_ATTACHMENT_LOAD_OP_LOAD, VK_ATTACHMENT_STORE_OP_STORE};
+		if (index < load_store.size())
+		{
+			ops = load_store[index];
+		}
+
+		VkDeviceSize texels = static_cast<VkDeviceSize>(pass.extent.width) * pass.extent.height * attachment.samples;
+
+		pass.attachments.push_back({index,
+		                            image.get_handle(),
+		                            image.get_usage(),
+		                            ops.load_op,
+		                            ops.store_op,
+		                            texels * std::max(get_bits_per_pixel(attachment.format), 0) / 8});
+	}
+
+	std::lock_guard<std::mutex> lock{mutex};
+
+	passes.push_back(std::move(pass));
+}
+
+void RenderPassAnalyzer::end_frame()
+{
+	std::lock_guard<std::mutex> lock{mutex};
+
+	if (passes.empty())
+	{
+		return;
+	}
+
+	findings.clear();
+
+	// Presented images are read by the presentation engine
+	std::unordered_set<VkImage> external_images;
+	if (render_context.has_swapchain())
+	{
+		auto &swapchain_images = render_context.get_swapchain().get_images();
+		external_images.insert(swapchain_images.begin(), swapchain_images.end());
+	}
+
+	std::unordered_set<VkImage> stored_images;
+	std::unordered_set<VkImage> written_images;
+
+	for (auto &pass : passes)
+	{
+		for (auto &attachment : pass.attachments)
+		{
+			// Loaded before any pass of the frame wrote it, the contents come from a previous frame
+			if (attachment.load_op == VK_ATTACHMENT_LOAD_OP_LOAD && !written_images.count(attachment.image))
+			{
+				persistent_images.insert(attachment.image);
+			}
+
+			written_images.insert(attachment.image);
+
+			if (attachment.store_op == VK_ATTACHMENT_STORE_OP_STORE)
+			{
+				stored_images.insert(attachment.image);
+			}
+		}
+	}
+
+	analyze_merges();
+	analyze_stores(external_images);
+	analyze_loads(stored_images, external_images);
+
+	if (auto_apply)
+	{
+		apply_stores();
+	}
+
+	std::vector<std::string> descriptions;
+	for (auto &finding : findings)
+	{
+		descriptions.push_back(finding.description);
+	}
+
+	if (descriptions != reported)
+	{
+		if (findings.empty())
+		{
+			LOGI("Render pass analysis: no bandwidth to save");
+		}
+		else
+		{
+			LOGI("Render pass analysis: {:.1f} MiB of external memory to save each frame", to_mib(get_bytes_per_frame()));
+
+			for (auto &description : descriptions)
+			{
+				LOGI("  {}", description);
+			}
+		}
+
+		reported = std::move(descriptions);
+	}
+
+	passes.clear();
+}
+
+const std::vector<RenderPassAnalyzer::Finding> &RenderPassAnalyzer::get_findings() const
+{
+	return findings;
+}
+
+VkDeviceSize RenderPassAnalyzer::get_bytes_per_frame() const
+{
+	VkDeviceSize bytes = 0;
+
+	for (auto &finding : findings)
+	{
+		bytes += finding.bytes_per_frame;
+	}
+
+	return bytes;
+}
+
+void RenderPassAnalyzer::analyze_merges()
+{
+	for (size_t i = 0; i + 1 < passes.size(); ++i)
+	{
+		auto &pass = passes[i];
+		auto &next = passes[i + 1];
+
+		if (pass.extent.width != next.extent.width || pass.extent.height != next.extent.height)
+		{
+			continue;
+		}
+
+		// Attachments the next pass loads after this pass stored them would stay on chip in a single render pass
+		VkDeviceSize bytes = 0;
+		uint32_t     count = 0;
+		uint32_t     first = 0;
+
+		for (auto &attachment : next.attachments)
+		{
+			auto stored = std::find_if(pass.attachments.begin(), pass.attachments.end(), [&attachment](const PassAttachment &other) {
+				return other.image == attachment.image && other.store_op == VK_ATTACHMENT_STORE_OP_STORE;
+			});
+
+			if (attachment.load_op == VK_ATTACHMENT_LOAD_OP_LOAD && stored != pass.attachments.end())
+			{
+				if (count++ == 0)
+				{
+					first = attachment.index;
+				}
+
+				bytes += 2 * attachment.size;
+			}
+		}
+
+		if (count > 0)
+		{
+			findings.push_back({Finding::Kind::MergePasses,
+			                    to_u32(i),
+			                    first,
+			                    bytes,
+			                    fmt::format("Passes {} and {} of {}x{} could be subpasses of a render pass, keeping {} attachment(s) on chip and saving {:.1f} MiB",
+			                                i, i + 1, pass.extent.width, pass.extent.height, count, to_mib(bytes))});
+		}
+	}
+}
+
+void RenderPassAnalyzer::analyze_stores(const std::unordered_set<VkImage> &external_images)
+{
+	std::unordered_set<size_t> unused_keys;
+	std::unordered_set<size_t> used_keys;
+
+	for (size_t i = 0; i < passes.size(); ++i)
+	{
+		for (auto &attachment : passes[i].attachments)
+		{
+			if (attachment.store_op != VK_ATTACHMENT_STORE_OP_STORE)
+			{
+				continue;
+			}
+
+			size_t key = 0;
+			hash_combine(key, passes[i].pipeline);
+			hash_combine(key, attachment.index);
+
+			bool used = external_images.count(attachment.image) || persistent_images.count(attachment.image) ||
+			            (attachment.usage & EXTERNAL_READ_USAGE);
+
+			// The stored contents are used if the next pass accessing the image loads them
+			for (size_t j = i + 1; j < passes.size() && !used; ++j)
+			{
+				auto next = std::find_if(passes[j].attachments.begin(), passes[j].attachments.end(), [&attachment](const PassAttachment &other) {
+					return other.image == attachment.image;
+				});
+
+				if (next != passes[j].attachments.end())
+				{
+					used = next->load_op == VK_ATTACHMENT_LOAD_OP_LOAD;
+					break;
+				}
+			}
+
+			if (used)
+			{
+				used_keys.insert(key);
+				continue;
+			}
+
+			unused_keys.insert(key);
+
+			findings.push_back({Finding::Kind::DontCareStore,
+			                    to_u32(i),
+			                    attachment.index,
+			                    attachment.size,
+			                    fmt::format("Attachment {} of pass {} is stored but never read, its store could be DONT_CARE saving {:.1f} MiB",
+			                                attachment.index, i, to_mib(attachment.size))});
+		}
+	}
+
+	// A store is only unused if it is unused by every pass the pipeline draws
+	std::unordered_map<size_t, uint32_t> frames;
+	for (auto key : unused_keys)
+	{
+		if (!used_keys.count(key))
+		{
+			frames[key] = unused_store_frames[key] + 1;
+		}
+	}
+
+	unused_store_frames = std::move(frames);
+}
+
+void RenderPassAnalyzer::analyze_loads(const std::unordered_set<VkImage> &stored_images, const std::unordered_set<VkImage> &external_images)
+{
+	std::unordered_set<VkImage> written_images;
+
+	for (size_t i = 0; i < passes.size(); ++i)
+	{
+		for (auto &attachment : passes[i].attachments)
+		{
+			// Images nothing writes hold undefined contents, loading them is wasted
+			bool wasted = attachment.load_op == VK_ATTACHMENT_LOAD_OP_LOAD &&
+			              !written_images.count(attachment.image) && !stored_images.count(attachment.image) &&
+			              !external_images.count(attachment.image) && !(attachment.usage & EXTERNAL_WRITE_USAGE);
+
+			written_images.insert(attachment.image);
+
+			if (wasted)
+			{
+				findings.push_back({Finding::Kind::DontCareLoad,
+				                    to_u32(i),
+				                    attachment.index,
+				                    attachment.size,
+				                    fmt::format("Attachment {} of pass {} is loaded but never written, its load could be CLEAR or DONT_CARE saving {:.1f} MiB",
+				                                attachment.index, i, to_mib(attachment.size))});
+			}
+		}
+	}
+}
+
+void RenderPassAnalyzer::apply_stores()
+{
+	for (auto &finding : findings)
+	{
+		if (finding.kind != Finding::Kind::DontCareStore)
+		{
+			continue;
+		}
+
+		auto *pipeline = passes[finding.pass].pipeline;
+
+		size_t key = 0;
+		hash_combine(key, pipeline);
+		hash_combine(key, finding.attachment);
+
+		auto it = unused_store_frames.find(key);
+		if (it == unused_store_frames.end() || it->second < FRAMES_BEFORE_APPLY)
+		{
+			continue;
+		}
+
+		unused_store_frames.erase(it);
+
+		auto load_store = pipeline->get_load_store();
+		if (finding.attachment >= load_store.size())
+		{
+			load_store.resize(finding.attachment + 1, {VK_ATTACHMENT_LOAD_OP_LOAD, VK_ATTACHMENT_STORE_OP_STORE});
+		}
+
+		load_store[finding.attachment].store_op = VK_ATTACHMENT_STORE_OP_DONT_CARE;
+		pipeline->set_load_store(load_store);
+
+		LOGI("Render pass analysis: changed the store of attachment {} of pass {} to DONT_CARE", finding.attachment, finding.pass);
+	}
+}
+}        // namespace vkb
@@ -0,0 +1,175 @@
+/* Copyright (c) 2020, Arm Limited and Contributors
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 the "License";
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+#include "common/helpers.h"
+#include "common/vk_common.h"
+
+namespace vkb
+{
+class RenderContext;
+class RenderPipeline;
+class RenderTarget;
+
+/**
+ * @brief Finds the bandwidth render pipelines waste on tile based GPUs
+ *
+ * Render pipelines report their attachments and load store operations when they draw. At the end of
+ * each frame the passes of the frame are analyzed in order to find:
+ * - consecutive passes of the same size where a pass loads what the previous one stored,
+ *   which could be subpasses of a single render pass, keeping the attachment on chip
+ * - attachments stored while nothing reads them afterwards, whose store could be DONT_CARE
+ * - attachments loaded while nothing wrote them, whose load could be CLEAR or DONT_CARE
+ *
+ * Reads through descriptors are not observed, so attachments of images usable by shaders, copies
+ * or presentation are assumed to be read. Findings are logged when they change, and stores can
+ * optionally be changed to DONT_CARE once they were found in enough consecutive frames.
+ */
+class RenderPassAnalyzer
+{
+  public:
+	/**
+	 * @brief A possible saving of bandwidth
+	 */
+	struct Finding
+	{
+		enum class Kind
+		{
+			MergePasses,
+			DontCareStore,
+			DontCareLoad
+		};
+
+		Kind kind;
+
+		/// Index of the pass in its frame, the first of the two passes to merge
+		uint32_t pass;
+
+		/// Attachment of the pass
+		uint32_t attachment;
+
+		/// Bytes of external memory the change would save each frame
+		VkDeviceSize bytes_per_frame;
+
+		std::string description;
+	};
+
+	/// Consecutive frames a store is found unused in before it is changed to DONT_CARE
+	static constexpr uint32_t FRAMES_BEFORE_APPLY{3};
+
+	RenderPassAnalyzer(RenderContext &render_context);
+
+	RenderPassAnalyzer(const RenderPassAnalyzer &) = delete;
+
+	RenderPassAnalyzer(RenderPassAnalyzer &&) = delete;
+
+	~RenderPassAnalyzer() = default;
+
+	RenderPassAnalyzer &operator=(const RenderPassAnalyzer &) = delete;
+
+	RenderPassAnalyzer &operator=(RenderPassAnalyzer &&) = delete;
+
+	/**
+	 * @brief Changes the stores found unused to DONT_CARE on the render pipelines, instead of only reporting them
+	 */
+	void set_auto_apply(bool enable);
+
+	/**
+	 * @brief Reports a pass of the active frame, called by render pipelines before they draw
+	 * @param pipeline Pipeline drawing the pass
+	 * @param render_target Render target of the pass
+	 * @param load_store Load store operations of the attachments, those missing load and store
+	 * @param attachments Indices of the attachments the pass accesses
+	 */
+	void record(RenderPipeline &pipeline, const RenderTarget &render_target, const std::vector<LoadStoreInfo> &load_store, const std::vector<uint32_t> &attachments);
+
+	/**
+	 * @brief Analyzes the passes of the frame, called by the render context when the frame ends
+	 */
+	void end_frame();
+
+	/**
+	 * @return Findings of the last analyzed frame
+	 */
+	const std::vector<Finding> &get_findings() const;
+
+	/**
+	 * @return Bytes of external memory the findings of the last analyzed frame would save each frame
+	 */
+	VkDeviceSize get_bytes_per_frame() const;
+
+  private:
+	struct PassAttachment
+	{
+		uint32_t index;
+
+		VkImage image;
+
+		VkImageUsageFlags usage;
+
+		VkAttachmentLoadOp load_op;
+
+		VkAttachmentStoreOp store_op;
+
+		VkDeviceSize size;
+	};
+
+	struct Pass
+	{
+		RenderPipeline *pipeline;
+
+		VkExtent2D extent;
+
+		std::vector<PassAttachment> attachments;
+	};
+
+	void analyze_loads(const std::unordered_set<VkImage> &stored_images, const std::unordered_set<VkImage> &external_images);
+
+	void analyze_stores(const std::unordered_set<VkImage> &external_images);
+
+	void analyze_merges();
+
+	void apply_stores();
+
+	RenderContext &render_context;
+
+	std::mutex mutex;
+
+	/// Passes of the active frame, in recording order
+	std::vector<Pass> passes;
+
+	/// Images loaded before being written in a frame, which keep their contents across frames
+	std::unordered_set<VkImage> persistent_images;
+
+	/// Consecutive frames each pass attachment was found with an unused store, keyed by pipeline and attachment
+	std::unordered_map<size_t, uint32_t> unused_store_frames;
+
+	std::vector<Finding> findings;
+
+	/// Descriptions of the last logged findings
+	std::vector<std::string> reported;
+
+	bool auto_apply{false};
+};
+}        // namespace vkb
@@ -17,6 +17,12 @@
 
 #include "render_pipeline.h"
 
+#include "job_system.h"
+#include "rendering/render_context.h"
+#include "rendering/render_pass_analyzer.h"
+#include "stats/gpu_profiler.h"
+#include "stats/stats.h"
+
 #include "scene_graph/components/camera.h"
 #include "scene_graph/components/image.h"
 #include "scene_graph/components/material.h"
@@ -58,6 +64,16 @@ std::vector<std::unique_ptr<Subpass>> &RenderPipeline::get_subpasses()
 	return subpasses;
 }
 
+void RenderPipeline::set_parallel_recording(bool enable)
+{
+	parallel_recording = enable;
+}
+
+void RenderPipeline::set_dynamic_rendering(bool enable)
+{
+	dynamic_rendering = enable;
+}
+
 const std::vector<LoadStoreInfo> &RenderPipeline::get_load_store() const
 {
 	return load_store;
@@ -88,6 +104,30 @@ void RenderPipeline::draw(CommandBuffer &command_buffer, RenderTarget &render_ta
 		clear_value.push_back({0.0f, 0.0f, 0.0f, 1.0f});
 	}
 
+	auto *profiler = subpasses[0]->get_render_context().get_gpu_profiler();
+	auto *stats    = subpasses[0]->get_render_context().get_stats();
+	auto *analyzer = subpasses[0]->get_render_context().get_render_pass_analyzer();
+
+	// Input attachments, shading rate attachments and secondary command buffers need a render pass
+	bool begin_dynamic_rendering = dynamic_rendering && subpasses.size() == 1 && contents == VK_SUBPASS_CONTENTS_INLINE &&
+	                               subpasses[0]->get_input_attachments().empty() &&
+	                               subpasses[0]->get_shading_rate_attachment() == VK_ATTACHMENT_UNUSED &&
+	                               subpasses[0]->get_render_context().get_device().is_enabled(VK_KHR_DYNAMIC_RENDERING_EXTENSION_NAME);
+
+	// Scopes are named after the subpasses, or their index
+	auto get_scope_name = [this](size_t i) {
+		auto &name = subpasses[i]->get_debug_name();
+		return name.empty() ? fmt::format("Subpass {}", i) : name;
+	};
+
+	for (size_t i = 0; i < subpasses.size(); ++i)
+	{
+		GpuProfiler::Scope scope{profiler, command_buffer, get_scope_name(i) + " pre-draw"};
+		DEBUG_LABEL_SCOPE(command_buffer, get_scope_name(i) + " pre-draw");
+
+		subpasses[i]->pre_draw(command_buffer);
+	}
+
 	for (size_t i = 0; i < subpasses.size(); ++i)
 	{
 		active_subpass_index = i;
@@ -96,21 +136,121 @@ void RenderPipeline::draw(CommandBuffer &command_buffer, RenderTarget &render_ta
 
 		subpass->update_render_target_attachments();
 
-		if (i == 0)
+		bool static_draw   = subpass->is_static_contents();
+		bool parallel_draw = !static_draw && parallel_recording && subpass->is_parallel_draw_supported();
+
+		// The contents requested by the caller only apply to the first subpass
+		VkSubpassContents subpass_contents = i == 0 ? contents : VK_SUBPASS_CONTENTS_INLINE;
+
+		if (static_draw || parallel_draw)
+		{
+			subpass_contents = VK_SUBPASS_CONTENTS_SECONDARY_COMMAND_BUFFERS;
+
+			begin_dynamic_rendering = false;
+		}
+
+		if (begin_dynamic_rendering)
+		{
+			SubpassInfo subpass_info;
+			subpass_info.output_attachments               = subpass->get_output_attachments();
+			subpass_info.color_resolve_attachments        = subpass->get_color_resolve_attachments();
+			subpass_info.disable_depth_stencil_attachment = subpass->get_disable_depth_stencil_attachment();
+			subpass_info.depth_stencil_resolve_mode       = subpass->get_depth_stencil_resolve_mode();
+			subpass_info.depth_stencil_resolve_attachment = subpass->get_depth_stencil_resolve_attachment();
+			subpass_info.view_mask                        = subpass->get_view_mask();
+
+			command_buffer.begin_rendering(render_target, load_store, clear_value, subpass_info);
+		}
+		else if (i == 0)
+		{
+			command_buffer.begin_render_pass(render_target, load_store, clear_value, subpasses, subpass_contents);
+		}
+		else
+		{
+			command_buffer.next_subpass(subpass_contents);
+		}
+
+		if (analyzer && i == 0)
+		{
+			analyzer->record(*this, render_target, load_store, get_accessed_attachments(render_target, begin_dynamic_rendering));
+		}
+
+		// Secondary command buffers of the subpass inherit the rate
+		command_buffer.set_fragment_shading_rate_state(subpass->get_fragment_shading_rate_state());
+
+		GpuProfiler::Scope scope{profiler, command_buffer, get_scope_name(i)};
+
+		// Labels and queries can only be recorded in subpasses with inline contents
+		DEBUG_LABEL_SCOPE(command_buffer, get_scope_name(i), subpass_contents == VK_SUBPASS_CONTENTS_INLINE);
+
+		bool sample_subpass = stats && subpass_contents == VK_SUBPASS_CONTENTS_INLINE;
+
+		if (sample_subpass)
+		{
+			stats->begin_subpass_sampling(command_buffer, get_scope_name(i));
+		}
+
+		if (static_draw)
+		{
+			subpass->draw_static(command_buffer);
+		}
+		else if (parallel_draw)
 		{
-			command_buffer.begin_render_pass(render_target, load_store, clear_value, subpasses, contents);
+			subpass->draw_parallel(command_buffer, JobSystem::get());
 		}
 		else
 		{
-			command_buffer.next_subpass();
+			subpass->draw(command_buffer);
 		}
 
-		subpass->draw(command_buffer);
+		if (sample_subpass)
+		{
+			stats->end_subpass_sampling(command_buffer);
+		}
 	}
 
 	active_subpass_index = 0;
 }
 
+std::vector<uint32_t> RenderPipeline::get_accessed_attachments(const RenderTarget &render_target, bool dynamic_rendering_pass) const
+{
+	auto &attachments = render_target.get_attachments();
+
+	std::vector<uint32_t> accessed;
+
+	if (!dynamic_rendering_pass)
+	{
+		// Render passes load and store all the attachments of the render target
+		for (uint32_t i = 0; i < to_u32(attachments.size()); ++i)
+		{
+			accessed.push_back(i);
+		}
+
+		return accessed;
+	}
+
+	// Dynamic rendering only loads and stores the color outputs and the first depth stencil attachment
+	for (auto output : subpasses[0]->get_output_attachments())
+	{
+		if (!is_depth_stencil_format(attachments[output].format))
+		{
+			accessed.push_back(output);
+		}
+	}
+
+	if (!subpasses[0]->get_disable_depth_stencil_attachment())
+	{
+		auto it = std::find_if(attachments.begin(), attachments.end(), [](const Attachment &attachment) { return is_depth_stencil_format(attachment.format); });
+
+		if (it != attachments.end())
+		{
+			accessed.push_back(to_u32(std::distance(attachments.begin(), it)));
+		}
+	}
+
+	return accessed;
+}
+
 std::unique_ptr<Subpass> &RenderPipeline::get_active_subpass()
 {
 	return subpasses[active_subpass_index];
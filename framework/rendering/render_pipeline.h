@@ -84,6 +84,20 @@ class RenderPipeline
 
 	std::vector<std::unique_ptr<Subpass>> &get_subpasses();
 
+	/**
+	 * @brief Records the subpasses which support it into secondary command buffers on the workers of the job system
+	 *        Draws are spread over as many workers as the render context has threads besides the calling one,
+	 *        so it should be prepared with a thread more than the workers of JobSystem::get().
+	 */
+	void set_parallel_recording(bool enable);
+
+	/**
+	 * @brief Draws pipelines of a single subpass with dynamic rendering when VK_KHR_dynamic_rendering is enabled,
+	 *        which needs no render pass nor framebuffer. Pipelines of several subpasses keep a render pass so that
+	 *        tile based GPUs can merge them, as do subpasses recorded into secondary command buffers. Enabled by default.
+	 */
+	void set_dynamic_rendering(bool enable);
+
 	/**
 	 * @brief Record draw commands for each Subpass
 	 */
@@ -96,6 +110,11 @@ class RenderPipeline
 	std::unique_ptr<Subpass> &get_active_subpass();
 
   private:
+	/**
+	 * @return Indices of the attachments of the render target which the pass of the pipeline loads and stores
+	 */
+	std::vector<uint32_t> get_accessed_attachments(const RenderTarget &render_target, bool dynamic_rendering_pass) const;
+
 	std::vector<std::unique_ptr<Subpass>> subpasses;
 
 	/// Default to two load store
@@ -105,5 +124,9 @@ class RenderPipeline
 	std::vector<VkClearValue> clear_value = std::vector<VkClearValue>(2);
 
 	size_t active_subpass_index{0};
+
+	bool parallel_recording{false};
+
+	bool dynamic_rendering{true};
 };
 }        // namespace vkb
@@ -30,6 +30,14 @@ struct CompareExtent2D
 		return !(lhs.width == rhs.width && lhs.height == rhs.height) && (lhs.width < rhs.width && lhs.height < rhs.height);
 	}
 };
+
+/**
+ * @brief Shading rate images have a texel per tile of pixels, they are smaller than the other attachments
+ */
+bool is_shading_rate_image(const core::Image &image)
+{
+	return (image.get_usage() & VK_IMAGE_USAGE_FRAGMENT_SHADING_RATE_ATTACHMENT_BIT_KHR) != 0;
+}
 }        // namespace
 
 Attachment::Attachment(VkFormat format, VkSampleCountFlagBits samples, VkImageUsageFlags usage) :
@@ -65,7 +73,13 @@ vkb::RenderTarget::RenderTarget(std::vector<core::Image> &&images) :
 	auto get_image_extent = [](const core::Image &image) { return VkExtent2D{image.get_extent().width, image.get_extent().height}; };
 
 	// Constructs a set of unique image extens given a vector of images
-	std::transform(this->images.begin(), this->images.end(), std::inserter(unique_extent, unique_extent.end()), get_image_extent);
+	for (auto &image : this->images)
+	{
+		if (!is_shading_rate_image(image))
+		{
+			unique_extent.insert(get_image_extent(image));
+		}
+	}
 
 	// Allow only one extent size for a render target
 	if (unique_extent.size() != 1)
@@ -73,7 +87,8 @@ vkb::RenderTarget::RenderTarget(std::vector<core::Image> &&images) :
 		throw VulkanException{VK_ERROR_INITIALIZATION_FAILED, "Extent size is not unique"};
 	}
 
-	extent = *unique_extent.begin();
+	extent      = *unique_extent.begin();
+	render_area = extent;
 
 	for (auto &image : this->images)
 	{
@@ -82,7 +97,44 @@ vkb::RenderTarget::RenderTarget(std::vector<core::Image> &&images) :
 			throw VulkanException{VK_ERROR_INITIALIZATION_FAILED, "Image type is not 2D"};
 		}
 
-		views.emplace_back(image, VK_IMAGE_VIEW_TYPE_2D);
+		// Layered images are rendered by multiview subpasses, one view per layer
+		views.emplace_back(image, image.get_array_layer_count() > 1 ? VK_IMAGE_VIEW_TYPE_2D_ARRAY : VK_IMAGE_VIEW_TYPE_2D);
+
+		attachments.emplace_back(Attachment{image.get_format(), image.get_sample_count(), image.get_usage()});
+	}
+}
+
+vkb::RenderTarget::RenderTarget(std::vector<core::ImageView> &&image_views) :
+    device{const_cast<core::Image &>(image_views.back().get_image()).get_device()},
+    views{std::move(image_views)}
+{
+	assert(!views.empty() && "Should specify at least 1 image view");
+
+	std::set<VkExtent2D, CompareExtent2D> unique_extent;
+
+	// Returns the extent of the image a view refers to as a VkExtent2D structure
+	auto get_view_extent = [](const core::ImageView &view) { return VkExtent2D{view.get_image().get_extent().width, view.get_image().get_extent().height}; };
+
+	for (auto &view : views)
+	{
+		if (!is_shading_rate_image(view.get_image()))
+		{
+			unique_extent.insert(get_view_extent(view));
+		}
+	}
+
+	// Allow only one extent size for a render target
+	if (unique_extent.size() != 1)
+	{
+		throw VulkanException{VK_ERROR_INITIALIZATION_FAILED, "Extent size is not unique"};
+	}
+
+	extent      = *unique_extent.begin();
+	render_area = extent;
+
+	for (auto &view : views)
+	{
+		const core::Image &image = view.get_image();
 
 		attachments.emplace_back(Attachment{image.get_format(), image.get_sample_count(), image.get_usage()});
 	}
@@ -93,11 +145,29 @@ const VkExtent2D &RenderTarget::get_extent() const
 	return extent;
 }
 
+void RenderTarget::set_render_area(const VkExtent2D &area)
+{
+	render_area.width  = std::max(std::min(area.width, extent.width), 1u);
+	render_area.height = std::max(std::min(area.height, extent.height), 1u);
+}
+
+const VkExtent2D &RenderTarget::get_render_area() const
+{
+	return render_area;
+}
+
 const std::vector<core::ImageView> &RenderTarget::get_views() const
 {
 	return views;
 }
 
+core::Image &RenderTarget::get_image(uint32_t attachment)
+{
+	assert(attachment < images.size() && "Attachment is not an image owned by the render target");
+
+	return images[attachment];
+}
+
 const std::vector<Attachment> &RenderTarget::get_attachments() const
 {
 	return attachments;
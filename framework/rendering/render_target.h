@@ -53,6 +53,8 @@ struct Attachment
  *   the minimum amount of information necessary
  * - Creation of a RenderTarget becomes simpler, because the caller can just ask for some
  *   Attachment (s) without having to create the images
+ * All the images share the same extent, except shading rate images with the
+ * VK_IMAGE_USAGE_FRAGMENT_SHADING_RATE_ATTACHMENT_BIT_KHR usage, which have a texel per tile of pixels.
  */
 class RenderTarget
 {
@@ -63,6 +65,12 @@ class RenderTarget
 
 	RenderTarget(std::vector<core::Image> &&images);
 
+	/**
+	 * @brief Creates a render target from views of images owned by somebody else,
+	 *        which have to outlive the render target
+	 */
+	RenderTarget(std::vector<core::ImageView> &&image_views);
+
 	RenderTarget(const RenderTarget &) = delete;
 
 	RenderTarget(RenderTarget &&) = delete;
@@ -73,8 +81,26 @@ class RenderTarget
 
 	const VkExtent2D &get_extent() const;
 
+	/**
+	 * @brief Restricts rendering to the top left corner of the images, which
+	 *        lets a target change resolution without creating images again
+	 * @param area Extent to render to, clamped to the extent of the render target
+	 */
+	void set_render_area(const VkExtent2D &area);
+
+	/**
+	 * @return The extent rendered to, the whole extent of the render target by default
+	 */
+	const VkExtent2D &get_render_area() const;
+
 	const std::vector<core::ImageView> &get_views() const;
 
+	/**
+	 * @param attachment Index of an image owned by the render target
+	 * @return The image of the attachment
+	 */
+	core::Image &get_image(uint32_t attachment);
+
 	const std::vector<Attachment> &get_attachments() const;
 
 	/**
@@ -102,6 +128,8 @@ class RenderTarget
 
 	VkExtent2D extent{};
 
+	VkExtent2D render_area{};
+
 	std::vector<core::Image> images;
 
 	std::vector<core::ImageView> views;
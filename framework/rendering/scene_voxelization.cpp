@@ -0,0 +1,301 @@
+/* Copyright (c) 2020, Arm Limited and Contributors
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 the "License";
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "rendering/scene_voxelization.h"
+
+#include <algorithm>
+#include <limits>
+
+#include "core/command_buffer.h"
+#include "rendering/render_context.h"
+#include "scene_graph/components/aabb.h"
+#include "scene_graph/components/material.h"
+#include "scene_graph/components/mesh.h"
+#include "scene_graph/components/sub_mesh.h"
+#include "scene_graph/node.h"
+#include "scene_graph/scene.h"
+
+namespace vkb
+{
+namespace
+{
+/// Base color of the surfaces in a voxel, and whether it contains any
+constexpr VkFormat VOXEL_FORMAT = VK_FORMAT_R8G8B8A8_UNORM;
+
+/// Fraction of the scene size kept around the scene, for dynamic nodes moving out of it
+constexpr float GRID_PADDING = 0.05f;
+}        // namespace
+
+SceneVoxelization::SceneVoxelization(RenderContext &render_context, sg::Scene &scene, sg::Camera &camera, uint32_t resolution) :
+    render_context{render_context},
+    scene{scene},
+    resolution{resolution}
+{
+	auto &device = render_context.get_device();
+
+	if (!device.get_gpu().get_requested_features().fragmentStoresAndAtomics)
+	{
+		throw std::runtime_error{"Scene voxelization needs the fragmentStoresAndAtomics feature"};
+	}
+
+	VkExtent3D extent{resolution, resolution, resolution};
+
+	voxel_image = std::make_unique<core::Image>(device, extent, VOXEL_FORMAT,
+	                                            VK_IMAGE_USAGE_STORAGE_BIT | VK_IMAGE_USAGE_SAMPLED_BIT | VK_IMAGE_USAGE_TRANSFER_DST_BIT,
+	                                            VMA_MEMORY_USAGE_GPU_ONLY);
+
+	static_image = std::make_unique<core::Image>(device, extent, VOXEL_FORMAT,
+	                                             VK_IMAGE_USAGE_STORAGE_BIT | VK_IMAGE_USAGE_TRANSFER_SRC_BIT | VK_IMAGE_USAGE_TRANSFER_DST_BIT,
+	                                             VMA_MEMORY_USAGE_GPU_ONLY);
+
+	voxel_view  = &voxel_image->request_view(VK_IMAGE_VIEW_TYPE_3D);
+	static_view = &static_image->request_view(VK_IMAGE_VIEW_TYPE_3D);
+
+	std::vector<core::Image> raster_images;
+	raster_images.emplace_back(device, VkExtent3D{resolution, resolution, 1}, VK_FORMAT_R8_UNORM,
+	                           VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT | VK_IMAGE_USAGE_TRANSIENT_ATTACHMENT_BIT, VMA_MEMORY_USAGE_GPU_ONLY);
+	raster_target = std::make_unique<RenderTarget>(std::move(raster_images));
+
+	VkSamplerCreateInfo sampler_info{VK_STRUCTURE_TYPE_SAMPLER_CREATE_INFO};
+	sampler_info.magFilter    = VK_FILTER_LINEAR;
+	sampler_info.minFilter    = VK_FILTER_LINEAR;
+	sampler_info.mipmapMode   = VK_SAMPLER_MIPMAP_MODE_NEAREST;
+	sampler_info.addressModeU = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_BORDER;
+	sampler_info.addressModeV = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_BORDER;
+	sampler_info.addressModeW = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_BORDER;
+	sampler_info.borderColor  = VK_BORDER_COLOR_FLOAT_TRANSPARENT_BLACK;
+
+	voxel_sampler = std::make_unique<core::Sampler>(device, sampler_info);
+
+	auto subpass = std::make_unique<VoxelizationSubpass>(render_context, ShaderSource{"voxelization/voxelize.vert"}, ShaderSource{"voxelization/voxelize.frag"}, scene, camera);
+
+	if (device.is_enabled(VK_EXT_CONSERVATIVE_RASTERIZATION_EXTENSION_NAME))
+	{
+		subpass->set_conservative_rasterization(true);
+	}
+	else
+	{
+		LOGW("VK_EXT_conservative_rasterization is not enabled, triangles thinner than a voxel may be missed by the voxelization");
+	}
+
+	voxelization_subpass = subpass.get();
+
+	voxelization_pipeline.add_subpass(std::move(subpass));
+
+	LoadStoreInfo load_store{};
+	load_store.load_op  = VK_ATTACHMENT_LOAD_OP_DONT_CARE;
+	load_store.store_op = VK_ATTACHMENT_STORE_OP_DONT_CARE;
+	voxelization_pipeline.set_load_store({load_store});
+
+	voxelization_pipeline.set_clear_value(std::vector<VkClearValue>(1));
+
+	for (auto mesh : scene.get_components<sg::Mesh>())
+	{
+		for (auto node : mesh->get_nodes())
+		{
+			static_nodes.emplace(node, node->get_transform().get_world_matrix());
+		}
+	}
+
+	update_grid();
+}
+
+SceneVoxelization::~SceneVoxelization() = default;
+
+void SceneVoxelization::mark_dynamic(sg::Node &node)
+{
+	if (static_nodes.erase(&node) > 0)
+	{
+		dynamic_nodes.insert(&node);
+
+		static_valid = false;
+	}
+}
+
+const VoxelGridUniform &SceneVoxelization::get_grid() const
+{
+	return grid;
+}
+
+core::ImageView &SceneVoxelization::get_voxel_view()
+{
+	return *voxel_view;
+}
+
+bool SceneVoxelization::update_static_nodes()
+{
+	bool moved = false;
+
+	for (auto it = static_nodes.begin(); it != static_nodes.end();)
+	{
+		if (it->first->get_transform().get_world_matrix() != it->second)
+		{
+			dynamic_nodes.insert(it->first);
+			it    = static_nodes.erase(it);
+			moved = true;
+		}
+		else
+		{
+			++it;
+		}
+	}
+
+	return moved;
+}
+
+void SceneVoxelization::update_grid()
+{
+	sg::AABB scene_bounds;
+
+	for (auto mesh : scene.get_components<sg::Mesh>())
+	{
+		for (auto node : mesh->get_nodes())
+		{
+			sg::AABB bounds{mesh->get_bounds().get_min(), mesh->get_bounds().get_max()};
+			bounds.transform(node->get_transform().get_world_matrix());
+
+			scene_bounds.update(bounds.get_min());
+			scene_bounds.update(bounds.get_max());
+		}
+	}
+
+	glm::vec3 min = scene_bounds.get_min();
+	glm::vec3 max = scene_bounds.get_max();
+
+	if (glm::any(glm::greaterThan(min, max)))
+	{
+		min = glm::vec3{-1.0f};
+		max = glm::vec3{1.0f};
+	}
+
+	// A cube with the largest side of the scene, centered on it
+	glm::vec3 extent = max - min;
+	float     size   = std::max(extent.x, std::max(extent.y, extent.z)) * (1.0f + 2.0f * GRID_PADDING);
+	glm::vec3 center = 0.5f * (min + max);
+
+	grid.origin = glm::vec4{center - glm::vec3{0.5f * size}, size / resolution};
+	grid.info   = glm::uvec4{resolution, 0, 0, 0};
+}
+
+std::vector<std::pair<sg::Node *, sg::SubMesh *>> SceneVoxelization::get_nodes(bool dynamic)
+{
+	std::vector<std::pair<sg::Node *, sg::SubMesh *>> nodes;
+
+	for (auto mesh : scene.get_components<sg::Mesh>())
+	{
+		for (auto node : mesh->get_nodes())
+		{
+			if ((dynamic_nodes.count(node) > 0) != dynamic)
+			{
+				continue;
+			}
+
+			for (auto sub_mesh : mesh->get_submeshes())
+			{
+				// Transparent sub meshes do not occlude
+				if (sub_mesh->get_material()->alpha_mode != sg::AlphaMode::Blend)
+				{
+					nodes.emplace_back(node, sub_mesh);
+				}
+			}
+		}
+	}
+
+	return nodes;
+}
+
+void SceneVoxelization::update(CommandBuffer &command_buffer)
+{
+	if (update_static_nodes())
+	{
+		static_valid = false;
+	}
+
+	if (!static_valid)
+	{
+		command_buffer.require_layout(*static_view, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_ACCESS_TRANSFER_WRITE_BIT, true);
+		command_buffer.flush_barriers();
+
+		VkClearColorValue       empty{};
+		VkImageSubresourceRange range = static_view->get_subresource_range();
+		vkCmdClearColorImage(command_buffer.get_handle(), static_image->get_handle(), VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, &empty, 1, &range);
+
+		command_buffer.require_layout(*static_view, VK_IMAGE_LAYOUT_GENERAL, VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT, VK_ACCESS_SHADER_WRITE_BIT);
+
+		voxelize(command_buffer, get_nodes(false), *static_view);
+
+		static_valid = true;
+	}
+
+	// Start from the static voxels
+	command_buffer.require_layout(*static_view, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_ACCESS_TRANSFER_READ_BIT);
+	command_buffer.require_layout(*voxel_view, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_ACCESS_TRANSFER_WRITE_BIT, true);
+
+	VkImageCopy copy_region{};
+	copy_region.srcSubresource = static_view->get_subresource_layers();
+	copy_region.dstSubresource = voxel_view->get_subresource_layers();
+	copy_region.extent         = voxel_image->get_extent();
+
+	command_buffer.copy_image(*static_image, *voxel_image, {copy_region});
+
+	auto dynamic = get_nodes(true);
+
+	if (!dynamic.empty())
+	{
+		command_buffer.require_layout(*voxel_view, VK_IMAGE_LAYOUT_GENERAL, VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT, VK_ACCESS_SHADER_WRITE_BIT);
+
+		voxelize(command_buffer, std::move(dynamic), *voxel_view);
+	}
+
+	command_buffer.require_layout(*voxel_view, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL,
+	                              VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT | VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_ACCESS_SHADER_READ_BIT);
+	command_buffer.flush_barriers();
+
+	grid_uniform_allocation = render_context.get_active_frame().allocate_buffer(VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT, sizeof(VoxelGridUniform));
+	grid_uniform_allocation.update(grid);
+}
+
+void SceneVoxelization::voxelize(CommandBuffer &command_buffer, std::vector<std::pair<sg::Node *, sg::SubMesh *>> &&nodes, core::ImageView &target)
+{
+	voxelization_subpass->set_grid(grid);
+	voxelization_subpass->set_voxels(target);
+	voxelization_subpass->set_nodes(std::move(nodes));
+
+	raster_target->set_layout(0, VK_IMAGE_LAYOUT_UNDEFINED);
+
+	VkViewport viewport{};
+	viewport.width    = static_cast<float>(resolution);
+	viewport.height   = static_cast<float>(resolution);
+	viewport.minDepth = 0.0f;
+	viewport.maxDepth = 1.0f;
+	command_buffer.set_viewport(0, {viewport});
+
+	VkRect2D scissor{};
+	scissor.extent = {resolution, resolution};
+	command_buffer.set_scissor(0, {scissor});
+
+	voxelization_pipeline.draw(command_buffer, *raster_target);
+
+	command_buffer.end_render_pass();
+}
+
+void SceneVoxelization::bind(CommandBuffer &command_buffer, uint32_t first_binding)
+{
+	command_buffer.bind_buffer(grid_uniform_allocation.get_buffer(), grid_uniform_allocation.get_offset(), grid_uniform_allocation.get_size(), 0, first_binding, 0);
+	command_buffer.bind_image(*voxel_view, *voxel_sampler, 0, first_binding + 1, 0);
+}
+}        // namespace vkb
@@ -0,0 +1,167 @@
+/* Copyright (c) 2020, Arm Limited and Contributors
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 the "License";
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <unordered_map>
+#include <unordered_set>
+
+#include "buffer_pool.h"
+#include "core/image.h"
+#include "core/image_view.h"
+#include "core/sampler.h"
+#include "rendering/render_pipeline.h"
+#include "rendering/render_target.h"
+#include "rendering/subpasses/voxelization_subpass.h"
+
+VKBP_DISABLE_WARNINGS()
+#include "common/glm_common.h"
+VKBP_ENABLE_WARNINGS()
+
+namespace vkb
+{
+class CommandBuffer;
+class RenderContext;
+
+namespace sg
+{
+class Camera;
+class Node;
+class Scene;
+class SubMesh;
+}        // namespace sg
+
+/**
+ * @brief Voxelizes a scene into a 3D texture on the GPU, for coarse occlusion and global illumination queries
+ *        which need no geometry processing on the CPU
+ *
+ * The grid is a cube around the bounds of the scene when the voxelization is created. Each voxel holds the base
+ * color of the surfaces it contains, and an alpha of 1 if it contains any. Triangles are voxelized with
+ * conservative rasterization when the device enables VK_EXT_conservative_rasterization.
+ *
+ * The voxels of static nodes are cached and only voxelized again when a static node moves. Every update copies
+ * the cache to the voxels and voxelizes the dynamic nodes on top of it, so the cost of an update grows with the
+ * dynamic nodes rather than with the scene. Nodes are static until their transform changes, or until they
+ * are marked dynamic. Voxelizing needs the fragmentStoresAndAtomics feature.
+ */
+class SceneVoxelization
+{
+  public:
+	/**
+	 * @brief Creates the voxel images and the subpass voxelizing the scene
+	 * @param render_context Render context
+	 * @param scene Scene to voxelize
+	 * @param camera Camera of the scene
+	 * @param resolution Number of voxels along each axis of the grid
+	 */
+	SceneVoxelization(RenderContext &render_context, sg::Scene &scene, sg::Camera &camera, uint32_t resolution = 128);
+
+	SceneVoxelization(const SceneVoxelization &) = delete;
+
+	SceneVoxelization(SceneVoxelization &&) = delete;
+
+	~SceneVoxelization();
+
+	SceneVoxelization &operator=(const SceneVoxelization &) = delete;
+
+	SceneVoxelization &operator=(SceneVoxelization &&) = delete;
+
+	/**
+	 * @brief Voxelizes the node every update, so that moving it does not invalidate the static cache
+	 */
+	void mark_dynamic(sg::Node &node);
+
+	/**
+	 * @brief Records the voxelization of the dynamic nodes, and of the static ones if they moved, outside of a render pass
+	 *        The voxels can then be read by the fragment and compute shaders recorded after it.
+	 */
+	void update(CommandBuffer &command_buffer);
+
+	/**
+	 * @brief Binds the grid uniform and the voxels for the shaders sampling them
+	 * @param first_binding Binding of the grid uniform, followed by the voxels
+	 */
+	void bind(CommandBuffer &command_buffer, uint32_t first_binding);
+
+	const VoxelGridUniform &get_grid() const;
+
+	/**
+	 * @return View of the voxels, in the shader read only layout after an update
+	 */
+	core::ImageView &get_voxel_view();
+
+  private:
+	/**
+	 * @brief Moves the static nodes whose transform changed to the dynamic ones
+	 * @return Whether any static node moved
+	 */
+	bool update_static_nodes();
+
+	/**
+	 * @brief Fits the grid around the bounds of the scene
+	 */
+	void update_grid();
+
+	/**
+	 * @brief Collects the opaque and masked sub meshes of a set of nodes
+	 */
+	std::vector<std::pair<sg::Node *, sg::SubMesh *>> get_nodes(bool dynamic);
+
+	/**
+	 * @brief Voxelizes nodes into an image, which needs to be in the general layout
+	 */
+	void voxelize(CommandBuffer &command_buffer, std::vector<std::pair<sg::Node *, sg::SubMesh *>> &&nodes, core::ImageView &target);
+
+	RenderContext &render_context;
+
+	sg::Scene &scene;
+
+	uint32_t resolution;
+
+	VoxelGridUniform grid{};
+
+	std::unique_ptr<core::Image> voxel_image;
+
+	/// Voxels of the static nodes
+	std::unique_ptr<core::Image> static_image;
+
+	/// Views owned by the voxel images
+	core::ImageView *voxel_view{nullptr};
+
+	core::ImageView *static_view{nullptr};
+
+	std::unique_ptr<core::Sampler> voxel_sampler;
+
+	/// Sets the resolution of the rasterization, its attachment is not written
+	std::unique_ptr<RenderTarget> raster_target;
+
+	/// Voxelizes the nodes, owns the voxelization subpass
+	RenderPipeline voxelization_pipeline;
+
+	VoxelizationSubpass *voxelization_subpass{nullptr};
+
+	/// World matrices of the static nodes when the cache was voxelized
+	std::unordered_map<sg::Node *, glm::mat4> static_nodes;
+
+	std::unordered_set<sg::Node *> dynamic_nodes;
+
+	/// Whether the static voxels match the static nodes
+	bool static_valid{false};
+
+	BufferAllocation grid_uniform_allocation;
+};
+}        // namespace vkb
@@ -0,0 +1,224 @@
+/* Copyright (c) 2020, Arm Limited and Contributors
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 the "License";
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "screenshot_capture.h"
+
+#include <algorithm>
+
+#include "common/logging.h"
+#include "common/strings.h"
+#include "core/command_buffer.h"
+#include "core/image_view.h"
+#include "job_system.h"
+#include "platform/filesystem.h"
+#include "rendering/render_context.h"
+
+namespace vkb
+{
+ScreenshotCapture::ScreenshotCapture(RenderContext &render_context) :
+    render_context{render_context},
+    slots(render_context.get_render_frames().size())
+{
+}
+
+ScreenshotCapture::~ScreenshotCapture()
+{
+	// Copies of the frames still in flight are written once the device is done with them
+	render_context.get_device().wait_idle();
+
+	for (auto &slot : slots)
+	{
+		collect(slot);
+	}
+
+	for (auto &slot : slots)
+	{
+		if (slot.encoding.valid())
+		{
+			slot.encoding.wait();
+		}
+	}
+}
+
+void ScreenshotCapture::set_format(Format format)
+{
+	this->format = format;
+}
+
+void ScreenshotCapture::set_interval(uint32_t interval, const std::string &prefix)
+{
+	this->interval  = interval;
+	interval_prefix = prefix;
+}
+
+void ScreenshotCapture::request(const std::string &filename)
+{
+	requests.push_back(filename);
+}
+
+void ScreenshotCapture::collect()
+{
+	// The frame has been waited for by RenderContext::begin(), so its copy is complete
+	collect(slots.at(render_context.get_active_frame_index()));
+}
+
+void ScreenshotCapture::collect(Slot &slot)
+{
+	if (slot.filename.empty())
+	{
+		return;
+	}
+
+	vmaInvalidateAllocation(render_context.get_device().get_memory_allocator(), slot.buffer->get_allocation(), 0, VK_WHOLE_SIZE);
+
+	const uint8_t *data     = slot.buffer->map();
+	auto           filename = std::move(slot.filename);
+	auto           width    = slot.width;
+	auto           height   = slot.height;
+	auto           swizzle  = slot.swizzle;
+	auto           format   = this->format;
+
+	slot.filename.clear();
+
+	slot.encoding = JobSystem::get().push([=](size_t) { encode(data, filename, width, height, swizzle, format); }, JobPriority::Low);
+}
+
+void ScreenshotCapture::record(CommandBuffer &command_buffer, const core::ImageView &view)
+{
+	std::string filename;
+
+	if (!requests.empty())
+	{
+		filename = requests.front();
+		requests.erase(requests.begin());
+	}
+	else if (interval > 0 && frame_count % interval == 0)
+	{
+		filename = interval_prefix + "-" + std::to_string(frame_count);
+	}
+
+	++frame_count;
+
+	if (filename.empty())
+	{
+		return;
+	}
+
+	auto &slot = slots.at(render_context.get_active_frame_index());
+
+	// The workers write the files in the background, a slow encoding skips a capture rather than stalling the frame
+	if (slot.encoding.valid())
+	{
+		if (slot.encoding.wait_for(std::chrono::seconds(0)) != std::future_status::ready)
+		{
+			LOGW("Skipping screenshot {}, the previous one is still being written", filename);
+			return;
+		}
+
+		slot.encoding.get();
+	}
+
+	const auto rgba_formats = {VK_FORMAT_R8G8B8A8_SRGB, VK_FORMAT_R8G8B8A8_UNORM, VK_FORMAT_R8G8B8A8_SNORM};
+	const auto bgra_formats = {VK_FORMAT_B8G8R8A8_SRGB, VK_FORMAT_B8G8R8A8_UNORM, VK_FORMAT_B8G8R8A8_SNORM};
+
+	slot.swizzle = std::find(bgra_formats.begin(), bgra_formats.end(), view.get_format()) != bgra_formats.end();
+
+	if (!slot.swizzle && std::find(rgba_formats.begin(), rgba_formats.end(), view.get_format()) == rgba_formats.end())
+	{
+		LOGW("Skipping screenshot {}, the render target format {} is not supported", filename, to_string(view.get_format()));
+		return;
+	}
+
+	const auto &extent = view.get_image().get_extent();
+
+	VkDeviceSize size = static_cast<VkDeviceSize>(extent.width) * extent.height * 4;
+
+	if (!slot.buffer || slot.buffer->get_size() != size)
+	{
+		slot.buffer = std::make_unique<core::Buffer>(render_context.get_device(), size, VK_BUFFER_USAGE_TRANSFER_DST_BIT, VMA_MEMORY_USAGE_GPU_TO_CPU);
+	}
+
+	slot.filename = filename;
+	slot.width    = extent.width;
+	slot.height   = extent.height;
+
+	{
+		ImageMemoryBarrier memory_barrier{};
+		memory_barrier.old_layout      = VK_IMAGE_LAYOUT_PRESENT_SRC_KHR;
+		memory_barrier.new_layout      = VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL;
+		memory_barrier.src_access_mask = VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT;
+		memory_barrier.dst_access_mask = VK_ACCESS_TRANSFER_READ_BIT;
+		memory_barrier.src_stage_mask  = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT;
+		memory_barrier.dst_stage_mask  = VK_PIPELINE_STAGE_TRANSFER_BIT;
+
+		command_buffer.image_memory_barrier(view, memory_barrier);
+	}
+
+	VkBufferImageCopy copy_region{};
+	copy_region.imageSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+	copy_region.imageSubresource.layerCount = 1;
+	copy_region.imageExtent                 = {extent.width, extent.height, 1};
+
+	command_buffer.copy_image_to_buffer(view.get_image(), *slot.buffer, {copy_region});
+
+	{
+		ImageMemoryBarrier memory_barrier{};
+		memory_barrier.old_layout      = VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL;
+		memory_barrier.new_layout      = VK_IMAGE_LAYOUT_PRESENT_SRC_KHR;
+		memory_barrier.src_access_mask = VK_ACCESS_TRANSFER_READ_BIT;
+		memory_barrier.src_stage_mask  = VK_PIPELINE_STAGE_TRANSFER_BIT;
+		memory_barrier.dst_stage_mask  = VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT;
+
+		command_buffer.image_memory_barrier(view, memory_barrier);
+	}
+
+	BufferMemoryBarrier buffer_barrier{};
+	buffer_barrier.src_access_mask = VK_ACCESS_TRANSFER_WRITE_BIT;
+	buffer_barrier.dst_access_mask = VK_ACCESS_HOST_READ_BIT;
+	buffer_barrier.src_stage_mask  = VK_PIPELINE_STAGE_TRANSFER_BIT;
+	buffer_barrier.dst_stage_mask  = VK_PIPELINE_STAGE_HOST_BIT;
+
+	command_buffer.buffer_memory_barrier(*slot.buffer, 0, size, buffer_barrier);
+}
+
+void ScreenshotCapture::encode(const uint8_t *data, const std::string &filename, uint32_t width, uint32_t height, bool swizzle, Format format)
+{
+	std::vector<uint8_t> pixels(data, data + width * height * 4);
+
+	for (size_t i = 0; i < pixels.size(); i += 4)
+	{
+		if (swizzle)
+		{
+			std::swap(pixels[i], pixels[i + 2]);
+		}
+
+		// Remove transparency
+		pixels[i + 3] = 255;
+	}
+
+	if (format == Format::QOI)
+	{
+		fs::write_image_qoi(pixels.data(), filename, width, height);
+	}
+	else
+	{
+		fs::write_image(pixels.data(), filename, width, height, 4, width * 4);
+	}
+
+	LOGI("Screenshot {} written", filename);
+}
+}        // namespace vkb
@@ -0,0 +1,139 @@
+/* Copyright (c) 2020, Arm Limited and Contributors
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 the "License";
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <cstdint>
+#include <future>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "core/buffer.h"
+
+namespace vkb
+{
+class CommandBuffer;
+class RenderContext;
+
+namespace core
+{
+class ImageView;
+}        // namespace core
+
+/**
+ * @brief Captures the render target without stalling the frame
+ *
+ * The render target is copied into a readback buffer at the end of the frame's own command buffer.
+ * The copy is retrieved once the render context begins the same frame again, as its fences have
+ * then been waited for, and the image is encoded and written on a worker of the job system.
+ */
+class ScreenshotCapture
+{
+  public:
+	enum class Format
+	{
+		PNG,
+		QOI
+	};
+
+	/**
+	 * @brief Creates a readback slot for each frame of the render context
+	 */
+	ScreenshotCapture(RenderContext &render_context);
+
+	ScreenshotCapture(const ScreenshotCapture &) = delete;
+
+	ScreenshotCapture &operator=(const ScreenshotCapture &) = delete;
+
+	/**
+	 * @brief Waits for the device and for the pending captures to be written
+	 */
+	~ScreenshotCapture();
+
+	/**
+	 * @brief Sets the image file format of the captures
+	 */
+	void set_format(Format format);
+
+	/**
+	 * @brief Captures every Nth frame, named after the frame number
+	 * @param interval Number of frames between captures, 0 to only capture requested frames
+	 * @param prefix Name of the files, followed by the frame number
+	 */
+	void set_interval(uint32_t interval, const std::string &prefix);
+
+	/**
+	 * @brief Captures the next recorded frame
+	 * @param filename Name of the file, without an extension, in the screenshots directory
+	 */
+	void request(const std::string &filename);
+
+	/**
+	 * @brief Hands the copies completed by the active frame to the workers, call it after RenderContext::begin()
+	 */
+	void collect();
+
+	/**
+	 * @brief Records the copy of a render target if the frame is captured, call it once the frame has been drawn
+	 * @param command_buffer Command buffer of the active frame
+	 * @param view The image drawn, in VK_IMAGE_LAYOUT_PRESENT_SRC_KHR layout
+	 */
+	void record(CommandBuffer &command_buffer, const core::ImageView &view);
+
+  private:
+	struct Slot
+	{
+		std::unique_ptr<core::Buffer> buffer;
+
+		/// Name of the copy in the buffer, empty if there is none
+		std::string filename;
+
+		uint32_t width{0};
+
+		uint32_t height{0};
+
+		/// Whether the red and blue components have to be swapped
+		bool swizzle{false};
+
+		/// Encoding of the previous copy, the buffer is reused once it is done
+		std::future<void> encoding;
+	};
+
+	RenderContext &render_context;
+
+	Format format{Format::PNG};
+
+	uint32_t interval{0};
+
+	std::string interval_prefix;
+
+	/// Number of frames recorded
+	uint32_t frame_count{0};
+
+	/// Requested captures, waiting for a frame to be recorded
+	std::vector<std::string> requests;
+
+	std::vector<Slot> slots;
+
+	/// Hands the copy of a completed slot to a worker
+	void collect(Slot &slot);
+
+	/// Swaps the components if needed, makes the image opaque and writes it to file
+	static void encode(const uint8_t *data, const std::string &filename, uint32_t width, uint32_t height, bool swizzle, Format format);
+};
+}        // namespace vkb
@@ -0,0 +1,120 @@
+/* Copyright (c) 2020, Arm Limited and Contributors
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 the "License";
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#include "rendering/shader_permutations.h"
+
+#include "common/logging.h"
+#include "core/command_buffer.h"
+#include "resource_cache.h"
+
+namespace vkb
+{
+void ShaderPermutations::add_feature(const std::string &name, uint32_t constant_id)
+{
+	features[name] = constant_id;
+}
+
+ShaderVariant ShaderPermutations::get_shared_variant(const ShaderVariant &variant, ShaderPermutation &permutation) const
+{
+	permutation.clear();
+
+	for (auto &feature : features)
+	{
+		permutation[feature.second] = to_bytes(0u);
+	}
+
+	ShaderVariant shared_variant;
+
+	for (auto &process : variant.get_processes())
+	{
+		auto definition = process.substr(1);
+
+		// Definitions are either a name, or a name and a value separated by "=" or a space
+		auto name_end = definition.find_first_of("= ");
+		auto name     = definition.substr(0, name_end);
+
+		auto feature = features.find(name);
+
+		if (feature == features.end())
+		{
+			if (process[0] == 'D')
+			{
+				shared_variant.add_define(definition);
+			}
+			else
+			{
+				shared_variant.add_undefine(definition);
+			}
+		}
+		else if (process[0] == 'D')
+		{
+			uint32_t value = 1;
+
+			if (name_end != std::string::npos)
+			{
+				try
+				{
+					value = static_cast<uint32_t>(std::stoul(definition.substr(name_end + 1)));
+				}
+				catch (const std::exception &)
+				{
+					LOGW("Feature {} is not defined with an integer value, it is enabled", name);
+				}
+			}
+
+			permutation[feature->second] = to_bytes(value);
+		}
+		else
+		{
+			permutation[feature->second] = to_bytes(0u);
+		}
+	}
+
+	for (auto &feature : features)
+	{
+		shared_variant.add_define(feature.first + "_CONSTANT_ID=" + std::to_string(feature.second));
+	}
+
+	shared_variant.set_runtime_array_sizes(variant.get_runtime_array_sizes());
+
+	return shared_variant;
+}
+
+void ShaderPermutations::bind(CommandBuffer &command_buffer, const ShaderPermutation &permutation)
+{
+	for (auto &constant : permutation)
+	{
+		command_buffer.set_specialization_constant(constant.first, constant.second);
+	}
+}
+
+void ShaderPermutations::warmup(ResourceCache &resource_cache, const PipelineState &pipeline_state, const std::vector<ShaderPermutation> &permutations)
+{
+	for (auto &permutation : permutations)
+	{
+		PipelineState permutation_state = pipeline_state;
+
+		for (auto &constant : permutation)
+		{
+			permutation_state.set_specialization_constant(constant.first, constant.second);
+		}
+
+		resource_cache.request_graphics_pipeline(permutation_state);
+	}
+}
+}        // namespace vkb
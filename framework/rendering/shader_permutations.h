@@ -0,0 +1,86 @@
+/* Copyright (c) 2020, Arm Limited and Contributors
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 the "License";
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#pragma once
+
+#include <map>
+#include <string>
+#include <vector>
+
+#include "common/helpers.h"
+#include "common/vk_common.h"
+#include "core/shader_module.h"
+#include "rendering/pipeline_state.h"
+
+namespace vkb
+{
+class CommandBuffer;
+class ResourceCache;
+
+/// Values of the specialization constants of a permutation, by constant id
+using ShaderPermutation = std::map<uint32_t, std::vector<uint8_t>>;
+
+/**
+ * @brief Expresses feature toggles of shaders as specialization constants instead of definitions,
+ *        so that all the permutations of a shader share one GLSL compilation
+ *
+ * Variants are built with definitions as usual. The definitions of the features are taken out of them
+ * and turned into specialization constants, and NAME_CONSTANT_ID is defined instead for every feature.
+ * Shaders declare the features as constants, for instance:
+ *
+ *     layout(constant_id = HAS_BASE_COLOR_TEXTURE_CONSTANT_ID) const bool HAS_BASE_COLOR_TEXTURE = false;
+ *
+ * and test them with if instead of #ifdef. Resources only used by a feature are still declared, so a
+ * feature should not remove descriptors or vertex inputs, unless what they are bound to is always valid.
+ */
+class ShaderPermutations
+{
+  public:
+	/**
+	 * @brief Declares a feature toggled through a specialization constant
+	 * @param name Name of the definition the feature replaces
+	 * @param constant_id Constant id of the feature in the shaders
+	 */
+	void add_feature(const std::string &name, uint32_t constant_id);
+
+	/**
+	 * @brief Splits a variant into the definitions compiled into the shaders and the features selected when creating pipelines
+	 * @param variant Variant defining any of the features, either without a value or as NAME=VALUE
+	 * @param[out] permutation Values of all the features, 1 for the ones defined without a value and 0 for the ones not defined
+	 * @return The variant without the feature definitions, shared by all the permutations
+	 */
+	ShaderVariant get_shared_variant(const ShaderVariant &variant, ShaderPermutation &permutation) const;
+
+	/**
+	 * @brief Sets the specialization constants of a permutation for the pipelines of the next draws
+	 */
+	static void bind(CommandBuffer &command_buffer, const ShaderPermutation &permutation);
+
+	/**
+	 * @brief Creates the pipelines of the permutations expected to be drawn, before the first frame needs them
+	 * @param resource_cache The cache requesting the pipelines, which draws requesting the same state then find
+	 * @param pipeline_state State shared by the permutations, with the layout, render pass and fixed function state of the draws
+	 * @param permutations Permutations drawn with the state
+	 */
+	static void warmup(ResourceCache &resource_cache, const PipelineState &pipeline_state, const std::vector<ShaderPermutation> &permutations);
+
+  private:
+	/// Constant ids of the features, by name
+	std::map<std::string, uint32_t> features;
+};
+}        // namespace vkb
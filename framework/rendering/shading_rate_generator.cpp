@@ -0,0 +1,198 @@
+/* Copyright (c) 2020, Arm Limited and Contributors
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 the "License";
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "rendering/shading_rate_generator.h"
+
+#include <algorithm>
+
+#include "core/command_buffer.h"
+#include "rendering/render_context.h"
+
+VKBP_DISABLE_WARNINGS()
+#include "common/glm_common.h"
+VKBP_ENABLE_WARNINGS()
+
+namespace vkb
+{
+namespace
+{
+/// Width and height of the workgroups of the shading rate shader, one invocation per texel
+constexpr uint32_t SHADING_RATE_GROUP_SIZE = 8;
+
+/// Preferred tile size, a tile of 16 pixels keeps the image small while following edges closely
+constexpr uint32_t PREFERRED_TEXEL_SIZE = 16;
+
+struct ShadingRateParameters
+{
+	glm::uvec2 texel_size;
+
+	float fine_threshold;
+
+	float coarse_threshold;
+
+	uint32_t max_rate;
+};
+
+/**
+ * @return The base 2 logarithm of a power of two
+ */
+uint32_t log2(uint32_t value)
+{
+	uint32_t result = 0;
+
+	while (value > 1)
+	{
+		value >>= 1;
+		result++;
+	}
+
+	return result;
+}
+}        // namespace
+
+constexpr VkFormat ShadingRateGenerator::SHADING_RATE_FORMAT;
+
+ShadingRateGenerator::ShadingRateGenerator(RenderContext &render_context) :
+    render_context{render_context},
+    shader{"shading_rate/shading_rate.comp"}
+{
+	auto &device = render_context.get_device();
+
+	if (!is_supported(device))
+	{
+		throw VulkanException{VK_ERROR_FEATURE_NOT_PRESENT, "Shading rate attachments are not supported"};
+	}
+
+	VkPhysicalDeviceFragmentShadingRatePropertiesKHR shading_rate_properties{VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_FRAGMENT_SHADING_RATE_PROPERTIES_KHR};
+
+	VkPhysicalDeviceProperties2KHR properties{VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_PROPERTIES_2_KHR};
+	properties.pNext = &shading_rate_properties;
+	vkGetPhysicalDeviceProperties2KHR(device.get_gpu().get_handle(), &properties);
+
+	// Texel sizes are powers of two
+	auto &min_size = shading_rate_properties.minFragmentShadingRateAttachmentTexelSize;
+	auto &max_size = shading_rate_properties.maxFragmentShadingRateAttachmentTexelSize;
+
+	texel_size.width  = std::min(std::max(PREFERRED_TEXEL_SIZE, min_size.width), max_size.width);
+	texel_size.height = std::min(std::max(PREFERRED_TEXEL_SIZE, min_size.height), max_size.height);
+
+	variant.add_define("GROUP_SIZE " + std::to_string(SHADING_RATE_GROUP_SIZE));
+
+	device.get_resource_cache().request_shader_module(VK_SHADER_STAGE_COMPUTE_BIT, shader, variant);
+
+	VkSamplerCreateInfo sampler_info{VK_STRUCTURE_TYPE_SAMPLER_CREATE_INFO};
+	sampler_info.maxAnisotropy = 1.0f;
+	sampler_info.magFilter     = VK_FILTER_NEAREST;
+	sampler_info.minFilter     = VK_FILTER_NEAREST;
+	sampler_info.mipmapMode    = VK_SAMPLER_MIPMAP_MODE_NEAREST;
+	sampler_info.addressModeU  = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+	sampler_info.addressModeV  = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+	sampler_info.addressModeW  = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+	sampler_info.borderColor   = VK_BORDER_COLOR_FLOAT_OPAQUE_BLACK;
+	source_sampler             = std::make_unique<core::Sampler>(device, sampler_info);
+}
+
+bool ShadingRateGenerator::is_supported(Device &device)
+{
+	if (!device.is_enabled(VK_KHR_FRAGMENT_SHADING_RATE_EXTENSION_NAME))
+	{
+		return false;
+	}
+
+	// The device enables every supported feature of the extension
+	VkPhysicalDeviceFragmentShadingRateFeaturesKHR features{VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_FRAGMENT_SHADING_RATE_FEATURES_KHR};
+
+	VkPhysicalDeviceFeatures2KHR physical_device_features{VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_FEATURES_2_KHR};
+	physical_device_features.pNext = &features;
+	vkGetPhysicalDeviceFeatures2KHR(device.get_gpu().get_handle(), &physical_device_features);
+
+	VkFormatFeatureFlags required_features = VK_FORMAT_FEATURE_FRAGMENT_SHADING_RATE_ATTACHMENT_BIT_KHR | VK_FORMAT_FEATURE_STORAGE_IMAGE_BIT;
+
+	return features.attachmentFragmentShadingRate &&
+	       (device.get_gpu().get_format_properties(SHADING_RATE_FORMAT).optimalTilingFeatures & required_features) == required_features;
+}
+
+const VkExtent2D &ShadingRateGenerator::get_texel_size() const
+{
+	return texel_size;
+}
+
+core::Image ShadingRateGenerator::create_image(const VkExtent2D &extent) const
+{
+	VkExtent3D image_extent{(extent.width + texel_size.width - 1) / texel_size.width,
+	                        (extent.height + texel_size.height - 1) / texel_size.height,
+	                        1};
+
+	return core::Image{render_context.get_device(), image_extent, SHADING_RATE_FORMAT,
+	                   VK_IMAGE_USAGE_FRAGMENT_SHADING_RATE_ATTACHMENT_BIT_KHR | VK_IMAGE_USAGE_STORAGE_BIT,
+	                   VMA_MEMORY_USAGE_GPU_ONLY};
+}
+
+void ShadingRateGenerator::set_thresholds(float fine, float coarse)
+{
+	fine_threshold   = fine;
+	coarse_threshold = std::min(coarse, fine);
+}
+
+void ShadingRateGenerator::set_max_fragment_size(uint32_t size)
+{
+	max_fragment_size = std::max(size, 1u);
+}
+
+void ShadingRateGenerator::record(CommandBuffer &command_buffer, const core::ImageView &source, const core::ImageView &shading_rate)
+{
+	{
+		// The previous rates are overwritten once the subpasses reading them completed
+		ImageMemoryBarrier barrier{};
+		barrier.old_layout      = VK_IMAGE_LAYOUT_UNDEFINED;
+		barrier.new_layout      = VK_IMAGE_LAYOUT_GENERAL;
+		barrier.src_access_mask = 0;
+		barrier.dst_access_mask = VK_ACCESS_SHADER_WRITE_BIT;
+		barrier.src_stage_mask  = VK_PIPELINE_STAGE_FRAGMENT_SHADING_RATE_ATTACHMENT_BIT_KHR;
+		barrier.dst_stage_mask  = VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT;
+
+		command_buffer.image_memory_barrier(shading_rate, barrier);
+	}
+
+	auto &resource_cache  = render_context.get_device().get_resource_cache();
+	auto &shader_module   = resource_cache.request_shader_module(VK_SHADER_STAGE_COMPUTE_BIT, shader, variant);
+	auto &pipeline_layout = resource_cache.request_pipeline_layout({&shader_module});
+
+	command_buffer.bind_pipeline_layout(pipeline_layout);
+
+	command_buffer.bind_image(source, *source_sampler, 0, 0, 0);
+	command_buffer.bind_image(shading_rate, 0, 1, 0);
+
+	command_buffer.push_constants(ShadingRateParameters{{texel_size.width, texel_size.height}, fine_threshold, coarse_threshold, log2(max_fragment_size)});
+
+	auto &extent = shading_rate.get_image().get_extent();
+
+	command_buffer.dispatch((extent.width + SHADING_RATE_GROUP_SIZE - 1) / SHADING_RATE_GROUP_SIZE,
+	                        (extent.height + SHADING_RATE_GROUP_SIZE - 1) / SHADING_RATE_GROUP_SIZE,
+	                        1);
+
+	ImageMemoryBarrier barrier{};
+	barrier.old_layout      = VK_IMAGE_LAYOUT_GENERAL;
+	barrier.new_layout      = VK_IMAGE_LAYOUT_FRAGMENT_SHADING_RATE_ATTACHMENT_OPTIMAL_KHR;
+	barrier.src_access_mask = VK_ACCESS_SHADER_WRITE_BIT;
+	barrier.dst_access_mask = VK_ACCESS_FRAGMENT_SHADING_RATE_ATTACHMENT_READ_BIT_KHR;
+	barrier.src_stage_mask  = VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT;
+	barrier.dst_stage_mask  = VK_PIPELINE_STAGE_FRAGMENT_SHADING_RATE_ATTACHMENT_BIT_KHR;
+
+	command_buffer.image_memory_barrier(shading_rate, barrier);
+}
+}        // namespace vkb
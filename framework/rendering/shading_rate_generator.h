@@ -0,0 +1,108 @@
+/* Copyright (c) 2020, Arm Limited and Contributors
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 the "License";
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <memory>
+
+#include "core/image.h"
+#include "core/image_view.h"
+#include "core/sampler.h"
+#include "core/shader_module.h"
+
+namespace vkb
+{
+class CommandBuffer;
+class Device;
+class RenderContext;
+
+/**
+ * @brief Generates a shading rate image from the luminance of a color image, such as the output of the previous frame
+ *
+ * A compute pass measures the largest luminance difference between neighbouring pixels of each tile, and picks a coarser
+ * fragment size for tiles with less contrast, so that subpasses reading the image as their shading rate attachment shade
+ * fewer pixels where detail is low. Rates the device does not support are clamped to supported ones when rendering.
+ */
+class ShadingRateGenerator
+{
+  public:
+	/// Format of the shading rate images, one texel per tile
+	static constexpr VkFormat SHADING_RATE_FORMAT = VK_FORMAT_R8_UINT;
+
+	ShadingRateGenerator(RenderContext &render_context);
+
+	ShadingRateGenerator(const ShadingRateGenerator &) = delete;
+
+	ShadingRateGenerator(ShadingRateGenerator &&) = delete;
+
+	ShadingRateGenerator &operator=(const ShadingRateGenerator &) = delete;
+
+	ShadingRateGenerator &operator=(ShadingRateGenerator &&) = delete;
+
+	/**
+	 * @return Whether the device can shade with a shading rate attachment written by a compute shader
+	 */
+	static bool is_supported(Device &device);
+
+	/**
+	 * @return Pixels covered by a texel of the shading rate images, for Subpass::set_shading_rate_attachment
+	 */
+	const VkExtent2D &get_texel_size() const;
+
+	/**
+	 * @brief Creates a shading rate image for a render target, which the generator can write to
+	 * @param extent Extent of the other attachments of the render target
+	 */
+	core::Image create_image(const VkExtent2D &extent) const;
+
+	/**
+	 * @param fine_threshold Luminance difference above which a tile is shaded at full rate
+	 * @param coarse_threshold Luminance difference below which a tile is shaded with the largest fragments
+	 */
+	void set_thresholds(float fine_threshold, float coarse_threshold);
+
+	/**
+	 * @param size Largest fragment size, in pixels along both axes
+	 */
+	void set_max_fragment_size(uint32_t size);
+
+	/**
+	 * @brief Records the compute pass, outside of a render pass
+	 * @param command_buffer Command buffer to record the dispatch to
+	 * @param source Color to analyze, in the shader read only layout and visible to compute shaders
+	 * @param shading_rate View of an image from create_image, left in the shading rate attachment layout
+	 */
+	void record(CommandBuffer &command_buffer, const core::ImageView &source, const core::ImageView &shading_rate);
+
+  private:
+	RenderContext &render_context;
+
+	VkExtent2D texel_size{};
+
+	float fine_threshold{0.1f};
+
+	float coarse_threshold{0.03f};
+
+	uint32_t max_fragment_size{4};
+
+	ShaderSource shader;
+
+	ShaderVariant variant;
+
+	std::unique_ptr<core::Sampler> source_sampler;
+};
+}        // namespace vkb
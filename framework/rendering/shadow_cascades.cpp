@@ -0,0 +1,514 @@
+/* Copyright (c) 2020, Arm Limited and Contributors
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 the "License";
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "rendering/shadow_cascades.h"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+#include "core/command_buffer.h"
+#include "rendering/render_context.h"
+#include "rendering/subpasses/shadow_subpass.h"
+#include "scene_graph/components/aabb.h"
+#include "scene_graph/components/light.h"
+#include "scene_graph/components/material.h"
+#include "scene_graph/components/mesh.h"
+#include "scene_graph/components/perspective_camera.h"
+#include "scene_graph/components/sub_mesh.h"
+#include "scene_graph/node.h"
+#include "scene_graph/scene.h"
+
+namespace vkb
+{
+namespace
+{
+/// Cells of the light space grid across a shadow map, a cascade is rendered again when it moves to another cell
+constexpr uint32_t SHADOW_SNAP_DIVISIONS = 16;
+
+/// Fraction of the scene depth kept in front of and behind the scene, for dynamic casters moving out of it
+constexpr float SHADOW_DEPTH_PADDING = 0.25f;
+
+/**
+ * @brief Computes the bounding sphere of a slice of a view frustum, in view space along the view axis
+ * @param near Distance of the near plane of the slice
+ * @param far Distance of the far plane of the slice
+ * @param diagonal_squared Sum of the squared tangents of the half field of view angles
+ * @return The distance of the center along the view axis and the radius
+ */
+glm::vec2 get_slice_sphere(float near, float far, float diagonal_squared)
+{
+	// Center equidistant to the corners of both planes, if it lies within the slice
+	float center = std::min(0.5f * (near + far) * (1.0f + diagonal_squared), far);
+
+	float far_radius  = std::sqrt((far - center) * (far - center) + far * far * diagonal_squared);
+	float near_radius = std::sqrt((center - near) * (center - near) + near * near * diagonal_squared);
+
+	return {center, std::max(far_radius, near_radius)};
+}
+}        // namespace
+
+ShadowCascades::ShadowCascades(RenderContext &render_context, sg::Scene &scene, sg::PerspectiveCamera &camera, sg::Light &light, uint32_t cascade_count, uint32_t resolution) :
+    render_context{render_context},
+    scene{scene},
+    camera{camera},
+    light{light},
+    resolution{resolution}
+{
+	if (cascade_count == 0 || cascade_count > MAX_SHADOW_CASCADE_COUNT)
+	{
+		throw std::runtime_error{"Shadow cascade count must be between 1 and " + std::to_string(MAX_SHADOW_CASCADE_COUNT)};
+	}
+
+	if (light.get_light_type() != sg::LightType::Directional)
+	{
+		throw std::runtime_error{"Shadow cascades need a directional light"};
+	}
+
+	auto &device = render_context.get_device();
+
+	VkFormat format = get_suitable_depth_format(device.get_gpu().get_handle(), true, {VK_FORMAT_D32_SFLOAT, VK_FORMAT_D16_UNORM});
+
+	VkExtent3D extent{resolution, resolution, 1};
+
+	shadow_image = std::make_unique<core::Image>(device, extent, format,
+	                                             VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT | VK_IMAGE_USAGE_SAMPLED_BIT | VK_IMAGE_USAGE_TRANSFER_DST_BIT,
+	                                             VMA_MEMORY_USAGE_GPU_ONLY, VK_SAMPLE_COUNT_1_BIT, 1, cascade_count);
+
+	static_image = std::make_unique<core::Image>(device, extent, format,
+	                                             VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT | VK_IMAGE_USAGE_TRANSFER_SRC_BIT,
+	                                             VMA_MEMORY_USAGE_GPU_ONLY, VK_SAMPLE_COUNT_1_BIT, 1, cascade_count);
+
+	shadow_view = &shadow_image->request_view(VK_IMAGE_VIEW_TYPE_2D_ARRAY);
+
+	cascades.resize(cascade_count);
+
+	for (uint32_t i = 0; i < cascade_count; ++i)
+	{
+		std::vector<core::ImageView> static_views;
+		static_views.emplace_back(*static_image, VK_IMAGE_VIEW_TYPE_2D, VK_FORMAT_UNDEFINED, i, 1);
+		cascades[i].static_target = std::make_unique<RenderTarget>(std::move(static_views));
+
+		std::vector<core::ImageView> shadow_views;
+		shadow_views.emplace_back(*shadow_image, VK_IMAGE_VIEW_TYPE_2D, VK_FORMAT_UNDEFINED, i, 1);
+		cascades[i].shadow_target = std::make_unique<RenderTarget>(std::move(shadow_views));
+	}
+
+	// Hardware filtering of the comparisons gives 2x2 percentage closer filtering
+	bool linear_filter = device.get_gpu().get_format_properties(format).optimalTilingFeatures & VK_FORMAT_FEATURE_SAMPLED_IMAGE_FILTER_LINEAR_BIT;
+
+	VkSamplerCreateInfo sampler_info{VK_STRUCTURE_TYPE_SAMPLER_CREATE_INFO};
+	sampler_info.magFilter     = linear_filter ? VK_FILTER_LINEAR : VK_FILTER_NEAREST;
+	sampler_info.minFilter     = sampler_info.magFilter;
+	sampler_info.mipmapMode    = VK_SAMPLER_MIPMAP_MODE_NEAREST;
+	sampler_info.addressModeU  = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+	sampler_info.addressModeV  = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+	sampler_info.addressModeW  = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+	sampler_info.compareEnable = VK_TRUE;
+	// Reversed depth, fragments at least as close to the light as the casters are lit
+	sampler_info.compareOp   = VK_COMPARE_OP_GREATER_OR_EQUAL;
+	sampler_info.borderColor = VK_BORDER_COLOR_FLOAT_OPAQUE_BLACK;
+
+	shadow_sampler = std::make_unique<core::Sampler>(device, sampler_info);
+
+	auto subpass = std::make_unique<ShadowSubpass>(render_context, ShaderSource{"shadows/shadow_map.vert"}, ShaderSource{"shadows/shadow_map.frag"}, scene, camera);
+
+	shadow_subpass = subpass.get();
+
+	shadow_pipeline.add_subpass(std::move(subpass));
+
+	std::vector<VkClearValue> clear_value(1);
+	clear_value[0].depthStencil = {0.0f, ~0U};
+	shadow_pipeline.set_clear_value(clear_value);
+
+	for (auto mesh : scene.get_components<sg::Mesh>())
+	{
+		for (auto node : mesh->get_nodes())
+		{
+			static_nodes.emplace(node, node->get_transform().get_world_matrix());
+		}
+	}
+}
+
+ShadowCascades::~ShadowCascades() = default;
+
+std::vector<std::string> ShadowCascades::get_shader_definitions()
+{
+	return {"SHADOWS", "MAX_SHADOW_CASCADE_COUNT " + std::to_string(MAX_SHADOW_CASCADE_COUNT)};
+}
+
+void ShadowCascades::set_shadow_distance(float distance)
+{
+	shadow_distance = distance;
+}
+
+void ShadowCascades::set_split_lambda(float lambda)
+{
+	split_lambda = lambda;
+}
+
+void ShadowCascades::set_cascade_updates_per_frame(uint32_t count)
+{
+	cascade_updates_per_frame = count;
+}
+
+void ShadowCascades::set_depth_bias(float constant_factor, float slope_factor)
+{
+	shadow_subpass->set_depth_bias(constant_factor, slope_factor);
+}
+
+void ShadowCascades::mark_dynamic(sg::Node &node)
+{
+	if (static_nodes.erase(&node) > 0)
+	{
+		dynamic_nodes.insert(&node);
+
+		static_nodes_changed = true;
+	}
+}
+
+sg::Light &ShadowCascades::get_light()
+{
+	return light;
+}
+
+bool ShadowCascades::update_static_nodes()
+{
+	bool moved = false;
+
+	for (auto it = static_nodes.begin(); it != static_nodes.end();)
+	{
+		if (it->first->get_transform().get_world_matrix() != it->second)
+		{
+			dynamic_nodes.insert(it->first);
+			it    = static_nodes.erase(it);
+			moved = true;
+		}
+		else
+		{
+			++it;
+		}
+	}
+
+	return moved;
+}
+
+void ShadowCascades::update_light_view(const glm::vec3 &direction)
+{
+	light_direction = direction;
+
+	glm::vec3 up = std::abs(direction.y) > 0.99f ? glm::vec3{0.0f, 0.0f, 1.0f} : glm::vec3{0.0f, 1.0f, 0.0f};
+
+	light_view = glm::lookAt(glm::vec3{0.0f}, direction, up);
+
+	float min_distance = std::numeric_limits<float>::max();
+	float max_distance = std::numeric_limits<float>::lowest();
+
+	for (auto mesh : scene.get_components<sg::Mesh>())
+	{
+		for (auto node : mesh->get_nodes())
+		{
+			glm::mat4 transform = light_view * node->get_transform().get_world_matrix();
+
+			sg::AABB bounds{mesh->get_bounds().get_min(), mesh->get_bounds().get_max()};
+			bounds.transform(transform);
+
+			// The light looks down the negative z axis
+			min_distance = std::min(min_distance, -bounds.get_max().z);
+			max_distance = std::max(max_distance, -bounds.get_min().z);
+		}
+	}
+
+	if (min_distance > max_distance)
+	{
+		min_distance = 0.0f;
+		max_distance = 1.0f;
+	}
+
+	float padding = SHADOW_DEPTH_PADDING * (max_distance - min_distance) + 1.0f;
+
+	depth_range = {min_distance - padding, max_distance + padding};
+}
+
+std::vector<ShadowCascades::Caster> ShadowCascades::get_casters(bool dynamic)
+{
+	std::vector<Caster> casters;
+
+	for (auto mesh : scene.get_components<sg::Mesh>())
+	{
+		for (auto node : mesh->get_nodes())
+		{
+			if ((dynamic_nodes.count(node) > 0) != dynamic)
+			{
+				continue;
+			}
+
+			glm::mat4 transform = light_view * node->get_transform().get_world_matrix();
+
+			sg::AABB bounds{mesh->get_bounds().get_min(), mesh->get_bounds().get_max()};
+			bounds.transform(transform);
+
+			for (auto sub_mesh : mesh->get_submeshes())
+			{
+				// Transparent sub meshes do not cast shadows
+				if (sub_mesh->get_material()->alpha_mode != sg::AlphaMode::Blend)
+				{
+					casters.push_back({node, sub_mesh, glm::vec2{bounds.get_min()}, glm::vec2{bounds.get_max()}});
+				}
+			}
+		}
+	}
+
+	return casters;
+}
+
+void ShadowCascades::update(CommandBuffer &command_buffer, uint32_t light_index)
+{
+	auto &transform = light.get_node()->get_transform();
+
+	glm::vec3 direction = glm::normalize(transform.get_rotation() * light.get_properties().direction);
+
+	if (update_static_nodes())
+	{
+		static_nodes_changed = true;
+	}
+
+	if (direction != light_direction || static_nodes_changed)
+	{
+		update_light_view(direction);
+
+		static_casters       = get_casters(false);
+		static_nodes_changed = false;
+
+		for (auto &cascade : cascades)
+		{
+			cascade.static_valid = false;
+		}
+	}
+
+	float near_plane = std::min(camera.get_near_plane(), camera.get_far_plane());
+	float far_plane  = std::max(camera.get_near_plane(), camera.get_far_plane());
+
+	if (shadow_distance > 0.0f)
+	{
+		far_plane = std::min(far_plane, shadow_distance);
+	}
+
+	float tan_half_y       = std::tan(0.5f * camera.get_field_of_view());
+	float tan_half_x       = tan_half_y * camera.get_aspect_ratio();
+	float diagonal_squared = tan_half_x * tan_half_x + tan_half_y * tan_half_y;
+
+	glm::mat4 camera_world    = glm::inverse(camera.get_view());
+	glm::vec3 camera_position = glm::vec3(camera_world[3]);
+	glm::vec3 camera_forward  = -glm::normalize(glm::vec3(camera_world[2]));
+
+	auto cascade_count = to_u32(cascades.size());
+
+	// The first cascade and the ones taking their turn are updated
+	std::vector<bool> scheduled(cascade_count, false);
+	scheduled[0] = true;
+
+	for (uint32_t i = 0; i < std::min(cascade_updates_per_frame, cascade_count - 1); ++i)
+	{
+		scheduled[next_cascade] = true;
+		next_cascade            = next_cascade + 1 < cascade_count ? next_cascade + 1 : 1;
+	}
+
+	ShadowUniform shadow_uniform{};
+	shadow_uniform.info = {cascade_count, light_index, 0, 0};
+
+	float split_near = near_plane;
+
+	for (uint32_t i = 0; i < cascade_count; ++i)
+	{
+		float ratio         = static_cast<float>(i + 1) / cascade_count;
+		float uniform_split = near_plane + (far_plane - near_plane) * ratio;
+		float log_split     = near_plane * std::pow(far_plane / near_plane, ratio);
+		float split_far     = split_lambda * log_split + (1.0f - split_lambda) * uniform_split;
+
+		glm::vec2 slice_sphere = get_slice_sphere(split_near, split_far, diagonal_squared);
+
+		split_near = split_far;
+
+		// Rounded up so that the radius does not change with floating point noise
+		float radius = std::ceil(slice_sphere.y * 16.0f) / 16.0f;
+
+		// The cell size is a whole number of texels, and the map covers the sphere from anywhere in its cell
+		float snap_texels = static_cast<float>(resolution / SHADOW_SNAP_DIVISIONS);
+		float cell_size   = 2.0f * snap_texels * radius / (resolution - 2.0f * snap_texels);
+		float half_extent = radius + cell_size;
+
+		glm::vec3 center       = camera_position + camera_forward * slice_sphere.x;
+		glm::vec3 light_center = glm::vec3(light_view * glm::vec4(center, 1.0f));
+
+		glm::ivec2 cell{static_cast<int32_t>(std::floor(light_center.x / cell_size + 0.5f)),
+		                static_cast<int32_t>(std::floor(light_center.y / cell_size + 0.5f))};
+
+		auto &cascade = cascades[i];
+
+		if (cell != cascade.cell || !cascade.static_valid)
+		{
+			glm::vec2 snapped_center = glm::vec2(cell) * cell_size;
+
+			glm::mat4 projection = glm::ortho(snapped_center.x - half_extent, snapped_center.x + half_extent,
+			                                  snapped_center.y - half_extent, snapped_center.y + half_extent,
+			                                  depth_range.y, depth_range.x);
+
+			cascade.cell         = cell;
+			cascade.view_proj    = vulkan_style_projection(projection) * light_view;
+			cascade.static_valid = false;
+
+			scheduled[i] = true;
+		}
+
+		cascade.sphere = glm::vec4{center, radius * radius};
+
+		if (scheduled[i])
+		{
+			update_cascade(command_buffer, cascade);
+		}
+
+		shadow_uniform.light_view_proj[i] = cascade.view_proj;
+		shadow_uniform.cascade_spheres[i] = cascade.sphere;
+	}
+
+	shadow_uniform_allocation = render_context.get_active_frame().allocate_buffer(VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT, sizeof(ShadowUniform));
+	shadow_uniform_allocation.update(shadow_uniform);
+}
+
+void ShadowCascades::update_cascade(CommandBuffer &command_buffer, Cascade &cascade)
+{
+	auto &static_view = cascade.static_target->get_views().at(0);
+	auto &shadow_view = cascade.shadow_target->get_views().at(0);
+
+	if (!cascade.static_valid)
+	{
+		render_casters(command_buffer, cascade, static_casters, *cascade.static_target, false);
+
+		ImageMemoryBarrier barrier{};
+		barrier.old_layout      = VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL;
+		barrier.new_layout      = VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL;
+		barrier.src_access_mask = VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT;
+		barrier.dst_access_mask = VK_ACCESS_TRANSFER_READ_BIT;
+		barrier.src_stage_mask  = VK_PIPELINE_STAGE_LATE_FRAGMENT_TESTS_BIT;
+		barrier.dst_stage_mask  = VK_PIPELINE_STAGE_TRANSFER_BIT;
+
+		command_buffer.image_memory_barrier(static_view, barrier);
+
+		cascade.static_valid = true;
+	}
+
+	{
+		// Previous frames may still sample the shadow map, its content is replaced
+		ImageMemoryBarrier barrier{};
+		barrier.old_layout      = VK_IMAGE_LAYOUT_UNDEFINED;
+		barrier.new_layout      = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+		barrier.src_access_mask = 0;
+		barrier.dst_access_mask = VK_ACCESS_TRANSFER_WRITE_BIT;
+		barrier.src_stage_mask  = VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT;
+		barrier.dst_stage_mask  = VK_PIPELINE_STAGE_TRANSFER_BIT;
+
+		command_buffer.image_memory_barrier(shadow_view, barrier);
+	}
+
+	VkImageCopy copy_region{};
+	copy_region.srcSubresource = static_view.get_subresource_layers();
+	copy_region.dstSubresource = shadow_view.get_subresource_layers();
+	copy_region.extent         = {resolution, resolution, 1};
+
+	command_buffer.copy_image(*static_image, *shadow_image, {copy_region});
+
+	{
+		ImageMemoryBarrier barrier{};
+		barrier.old_layout      = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+		barrier.new_layout      = VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL;
+		barrier.src_access_mask = VK_ACCESS_TRANSFER_WRITE_BIT;
+		barrier.dst_access_mask = VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_READ_BIT | VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT;
+		barrier.src_stage_mask  = VK_PIPELINE_STAGE_TRANSFER_BIT;
+		barrier.dst_stage_mask  = VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT | VK_PIPELINE_STAGE_LATE_FRAGMENT_TESTS_BIT;
+
+		command_buffer.image_memory_barrier(shadow_view, barrier);
+	}
+
+	render_casters(command_buffer, cascade, get_casters(true), *cascade.shadow_target, true);
+
+	{
+		ImageMemoryBarrier barrier{};
+		barrier.old_layout      = VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL;
+		barrier.new_layout      = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+		barrier.src_access_mask = VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT;
+		barrier.dst_access_mask = VK_ACCESS_SHADER_READ_BIT;
+		barrier.src_stage_mask  = VK_PIPELINE_STAGE_LATE_FRAGMENT_TESTS_BIT;
+		barrier.dst_stage_mask  = VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT;
+
+		command_buffer.image_memory_barrier(shadow_view, barrier);
+	}
+}
+
+void ShadowCascades::render_casters(CommandBuffer &command_buffer, const Cascade &cascade, const std::vector<Caster> &casters, RenderTarget &render_target, bool load)
+{
+	glm::mat4 inverse_view_proj = glm::inverse(cascade.view_proj);
+
+	// Light space bounds of the cascade, from two opposite corners of its clip space
+	glm::vec2 corner_min = glm::vec2(light_view * inverse_view_proj * glm::vec4{-1.0f, -1.0f, 0.0f, 1.0f});
+	glm::vec2 corner_max = glm::vec2(light_view * inverse_view_proj * glm::vec4{1.0f, 1.0f, 0.0f, 1.0f});
+
+	glm::vec2 cascade_min = glm::min(corner_min, corner_max);
+	glm::vec2 cascade_max = glm::max(corner_min, corner_max);
+
+	std::vector<std::pair<sg::Node *, sg::SubMesh *>> visible_casters;
+
+	for (auto &caster : casters)
+	{
+		if (glm::all(glm::lessThanEqual(caster.min, cascade_max)) && glm::all(glm::greaterThanEqual(caster.max, cascade_min)))
+		{
+			visible_casters.emplace_back(caster.node, caster.sub_mesh);
+		}
+	}
+
+	shadow_subpass->set_light_view_proj(cascade.view_proj);
+	shadow_subpass->set_casters(std::move(visible_casters));
+
+	LoadStoreInfo load_store{};
+	load_store.load_op  = load ? VK_ATTACHMENT_LOAD_OP_LOAD : VK_ATTACHMENT_LOAD_OP_CLEAR;
+	load_store.store_op = VK_ATTACHMENT_STORE_OP_STORE;
+	shadow_pipeline.set_load_store({load_store});
+
+	render_target.set_layout(0, load ? VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL : VK_IMAGE_LAYOUT_UNDEFINED);
+
+	VkViewport viewport{};
+	viewport.width    = static_cast<float>(resolution);
+	viewport.height   = static_cast<float>(resolution);
+	viewport.minDepth = 0.0f;
+	viewport.maxDepth = 1.0f;
+	command_buffer.set_viewport(0, {viewport});
+
+	VkRect2D scissor{};
+	scissor.extent = {resolution, resolution};
+	command_buffer.set_scissor(0, {scissor});
+
+	shadow_pipeline.draw(command_buffer, render_target);
+
+	command_buffer.end_render_pass();
+}
+
+void ShadowCascades::bind(CommandBuffer &command_buffer, uint32_t first_binding)
+{
+	command_buffer.bind_buffer(shadow_uniform_allocation.get_buffer(), shadow_uniform_allocation.get_offset(), shadow_uniform_allocation.get_size(), 0, first_binding, 0);
+	command_buffer.bind_image(*shadow_view, *shadow_sampler, 0, first_binding + 1, 0);
+}
+}        // namespace vkb
@@ -0,0 +1,262 @@
+/* Copyright (c) 2020, Arm Limited and Contributors
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 the "License";
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <unordered_map>
+#include <unordered_set>
+
+#include "buffer_pool.h"
+#include "core/image.h"
+#include "core/image_view.h"
+#include "core/sampler.h"
+#include "rendering/render_pipeline.h"
+#include "rendering/render_target.h"
+
+VKBP_DISABLE_WARNINGS()
+#include "common/glm_common.h"
+VKBP_ENABLE_WARNINGS()
+
+#define MAX_SHADOW_CASCADE_COUNT 4
+
+namespace vkb
+{
+class CommandBuffer;
+class RenderContext;
+class ShadowSubpass;
+
+namespace sg
+{
+class Light;
+class Mesh;
+class Node;
+class PerspectiveCamera;
+class Scene;
+class SubMesh;
+}        // namespace sg
+
+/**
+ * @brief Shadow uniform structure for the shaders sampling the cascades
+ */
+struct alignas(16) ShadowUniform
+{
+	glm::mat4  light_view_proj[MAX_SHADOW_CASCADE_COUNT];
+	glm::vec4  cascade_spheres[MAX_SHADOW_CASCADE_COUNT];        // xyz is the center of a cascade, w its squared radius
+	glm::uvec4 info;                                             // x is the number of cascades, y the index of the shadowed light
+};
+
+/**
+ * @brief Renders cascaded shadow maps of a directional light for a perspective camera
+ *
+ * Each cascade covers a slice of the view frustum with a bounding sphere, so that its size does not change
+ * as the camera rotates, and its position snaps to a coarse light space grid. The depth of static casters
+ * is cached per cascade and only rendered again when the cascade moves to another cell of the grid, the
+ * light rotates or a static caster moves. Every update copies the cache to the shadow map and draws the
+ * dynamic casters on top of it.
+ *
+ * The first cascade is updated every frame while the others take turns, so that the shadow cost grows with
+ * the dynamic casters on screen rather than with the scene. A cascade moving is updated in the same frame.
+ * Nodes are static until their transform changes, or until they are marked dynamic.
+ */
+class ShadowCascades
+{
+  public:
+	/**
+	 * @brief Creates the shadow maps and the subpass rendering them
+	 * @param render_context Render context
+	 * @param scene Scene casting the shadows
+	 * @param camera Camera the cascades split the view of
+	 * @param light Directional light casting the shadows
+	 * @param cascade_count Number of cascades, up to MAX_SHADOW_CASCADE_COUNT
+	 * @param resolution Width and height of the shadow map of each cascade
+	 */
+	ShadowCascades(RenderContext &render_context, sg::Scene &scene, sg::PerspectiveCamera &camera, sg::Light &light,
+	               uint32_t cascade_count = MAX_SHADOW_CASCADE_COUNT, uint32_t resolution = 2048);
+
+	ShadowCascades(const ShadowCascades &) = delete;
+
+	ShadowCascades(ShadowCascades &&) = delete;
+
+	~ShadowCascades();
+
+	ShadowCascades &operator=(const ShadowCascades &) = delete;
+
+	ShadowCascades &operator=(ShadowCascades &&) = delete;
+
+	/**
+	 * @return Definitions for the shaders sampling the cascades
+	 */
+	static std::vector<std::string> get_shader_definitions();
+
+	/**
+	 * @param distance View distance covered by the cascades, the far plane of the camera if 0
+	 */
+	void set_shadow_distance(float distance);
+
+	/**
+	 * @param lambda Blend between uniform (0) and logarithmic (1) splits of the view distance
+	 */
+	void set_split_lambda(float lambda);
+
+	/**
+	 * @param count Number of cascades updated every frame besides the first one
+	 */
+	void set_cascade_updates_per_frame(uint32_t count);
+
+	/**
+	 * @brief Sets the depth bias of casters, see ShadowSubpass::set_depth_bias
+	 */
+	void set_depth_bias(float constant_factor, float slope_factor);
+
+	/**
+	 * @brief Draws the node with the dynamic casters, so that moving it does not invalidate the static caches
+	 */
+	void mark_dynamic(sg::Node &node);
+
+	sg::Light &get_light();
+
+	/**
+	 * @brief Records the rendering of the cascades updated this frame, outside of a render pass
+	 * @param command_buffer Command buffer to record the shadow passes to
+	 * @param light_index Index of the light in the lights read by the shaders, which the shadows apply to
+	 */
+	void update(CommandBuffer &command_buffer, uint32_t light_index);
+
+	/**
+	 * @brief Binds the shadow uniform of the frame and the shadow maps for the shaders sampling them
+	 * @param first_binding Binding of the shadow uniform, followed by the shadow maps
+	 */
+	void bind(CommandBuffer &command_buffer, uint32_t first_binding);
+
+  private:
+	struct Cascade
+	{
+		/// Cell of the light space grid the cascade is centered on
+		glm::ivec2 cell{};
+
+		/// Light view projection the shadow map was rendered with
+		glm::mat4 view_proj{1.0f};
+
+		/// View frustum slice the cascade covers
+		glm::vec4 sphere{};
+
+		/// Whether the static caster cache matches the position of the cascade
+		bool static_valid{false};
+
+		/// Depth of the static casters
+		std::unique_ptr<RenderTarget> static_target;
+
+		/// Shadow map sampled by the shaders
+		std::unique_ptr<RenderTarget> shadow_target;
+	};
+
+	/// Sub mesh drawn into the shadow maps, with its bounds in light space
+	struct Caster
+	{
+		sg::Node *node;
+
+		sg::SubMesh *sub_mesh;
+
+		glm::vec2 min;
+
+		glm::vec2 max;
+	};
+
+	/**
+	 * @brief Moves the static nodes whose transform changed to the dynamic ones
+	 * @return Whether any static node moved
+	 */
+	bool update_static_nodes();
+
+	/**
+	 * @brief Computes the light view and the depth range of the cascades from the bounds of the scene
+	 */
+	void update_light_view(const glm::vec3 &light_direction);
+
+	/**
+	 * @brief Collects the casters of a set of nodes with their light space bounds
+	 */
+	std::vector<Caster> get_casters(bool dynamic);
+
+	/**
+	 * @brief Renders casters overlapping a cascade into a render target
+	 * @param load Whether to keep the depth the target holds, otherwise it is cleared
+	 */
+	void render_casters(CommandBuffer &command_buffer, const Cascade &cascade, const std::vector<Caster> &casters, RenderTarget &render_target, bool load);
+
+	/**
+	 * @brief Renders the static cache of a cascade if it is out of date, then copies it to the shadow map and draws the dynamic casters
+	 */
+	void update_cascade(CommandBuffer &command_buffer, Cascade &cascade);
+
+	RenderContext &render_context;
+
+	sg::Scene &scene;
+
+	sg::PerspectiveCamera &camera;
+
+	sg::Light &light;
+
+	uint32_t resolution;
+
+	float shadow_distance{0.0f};
+
+	float split_lambda{0.75f};
+
+	uint32_t cascade_updates_per_frame{1};
+
+	/// Next cascade updated in turn, the first cascade is updated every frame
+	uint32_t next_cascade{1};
+
+	std::unique_ptr<core::Image> shadow_image;
+
+	/// Static caster caches of all cascades, one array layer per cascade
+	std::unique_ptr<core::Image> static_image;
+
+	/// Array view of the shadow maps of the cascades, owned by the shadow image
+	core::ImageView *shadow_view{nullptr};
+
+	std::unique_ptr<core::Sampler> shadow_sampler;
+
+	/// Renders the casters, owns the shadow subpass
+	RenderPipeline shadow_pipeline;
+
+	ShadowSubpass *shadow_subpass{nullptr};
+
+	std::vector<Cascade> cascades;
+
+	glm::vec3 light_direction{0.0f};
+
+	glm::mat4 light_view{1.0f};
+
+	/// Distances along the light direction between which casters are kept
+	glm::vec2 depth_range{0.0f};
+
+	/// World matrices of the static nodes when the caches were rendered
+	std::unordered_map<sg::Node *, glm::mat4> static_nodes;
+
+	std::unordered_set<sg::Node *> dynamic_nodes;
+
+	/// Whether nodes were moved from the static ones since the static casters were collected
+	bool static_nodes_changed{true};
+
+	/// Static casters with their bounds in the current light view
+	std::vector<Caster> static_casters;
+
+	BufferAllocation shadow_uniform_allocation;
+};
+}        // namespace vkb
@@ -17,6 +17,7 @@
 
 #include "subpass.h"
 
+#include "common/resource_caching.h"
 #include "render_context.h"
 
 namespace vkb
@@ -50,11 +51,124 @@ void Subpass::update_render_target_attachments()
 	render_target.set_output_attachments(output_attachments);
 }
 
+void Subpass::set_static_contents(bool static_contents_)
+{
+	static_contents = static_contents_;
+
+	if (!static_contents)
+	{
+		static_contents_per_frame.clear();
+	}
+}
+
+bool Subpass::is_static_contents() const
+{
+	return static_contents;
+}
+
+void Subpass::invalidate_static_contents()
+{
+	// Other frames may still execute their command buffers, so they are only reset when re-recorded
+	for (auto &static_contents_it : static_contents_per_frame)
+	{
+		static_contents_it.second.hash = 0;
+	}
+}
+
+size_t Subpass::get_static_contents_hash(const CommandBuffer &primary_command_buffer) const
+{
+	const auto &render_pass_binding = primary_command_buffer.get_current_render_pass();
+
+	size_t hash{0U};
+	hash_combine(hash, render_pass_binding.render_pass->get_handle());
+	hash_combine(hash, render_pass_binding.framebuffer->get_handle());
+	hash_combine(hash, render_pass_binding.render_area.width);
+	hash_combine(hash, render_pass_binding.render_area.height);
+	hash_combine(hash, primary_command_buffer.get_current_subpass_index());
+	hash_combine(hash, vertex_shader);
+	hash_combine(hash, fragment_shader);
+	hash_combine(hash, static_cast<std::underlying_type<VkSampleCountFlagBits>::type>(sample_count));
+	hash_combine(hash, depth_stencil_state.depth_test_enable);
+	hash_combine(hash, depth_stencil_state.depth_write_enable);
+	hash_combine(hash, static_cast<std::underlying_type<VkCompareOp>::type>(depth_stencil_state.depth_compare_op));
+
+	for (auto &resource_mode_it : resource_mode_map)
+	{
+		hash_combine(hash, resource_mode_it.first);
+		hash_combine(hash, resource_mode_it.second);
+	}
+
+	// 0 marks outdated command buffers
+	return hash == 0 ? 1 : hash;
+}
+
+void Subpass::draw_static(CommandBuffer &primary_command_buffer)
+{
+	auto &render_frame    = render_context.get_active_frame();
+	auto &static_contents = static_contents_per_frame[&render_frame];
+
+	size_t hash = get_static_contents_hash(primary_command_buffer);
+
+	if (!static_contents.command_buffer)
+	{
+		const auto &queue = render_context.get_device().get_queue_by_role(QueueRole::Graphics);
+
+		// The pool is not reset with the frame, its descriptor sets come from the frame which keeps them cached
+		static_contents.command_pool   = std::make_unique<CommandPool>(render_context.get_device(), queue.get_family_index(), &render_frame, 0, CommandBuffer::ResetMode::ResetIndividually);
+		static_contents.command_buffer = &static_contents.command_pool->request_command_buffer(VK_COMMAND_BUFFER_LEVEL_SECONDARY);
+	}
+	else if (static_contents.hash != hash)
+	{
+		// The frame waited for its previous submissions, so the command buffer is no longer pending
+		static_contents.command_buffer->reset(CommandBuffer::ResetMode::ResetIndividually);
+	}
+
+	auto &command_buffer = *static_contents.command_buffer;
+
+	if (static_contents.hash != hash)
+	{
+		// Several primary command buffers of a frame may execute the static draws
+		command_buffer.begin(VK_COMMAND_BUFFER_USAGE_SIMULTANEOUS_USE_BIT | VK_COMMAND_BUFFER_USAGE_RENDER_PASS_CONTINUE_BIT, &primary_command_buffer);
+
+		// Dynamic state is not inherited from the primary command buffer
+		const auto &extent = primary_command_buffer.get_current_render_pass().render_area;
+
+		VkViewport viewport{};
+		viewport.width    = static_cast<float>(extent.width);
+		viewport.height   = static_cast<float>(extent.height);
+		viewport.minDepth = 0.0f;
+		viewport.maxDepth = 1.0f;
+		command_buffer.set_viewport(0, {viewport});
+
+		VkRect2D scissor{};
+		scissor.extent = extent;
+		command_buffer.set_scissor(0, {scissor});
+
+		draw(command_buffer);
+
+		command_buffer.end();
+
+		static_contents.hash = hash;
+	}
+
+	primary_command_buffer.execute_commands(command_buffer);
+}
+
 RenderContext &Subpass::get_render_context()
 {
 	return render_context;
 }
 
+void Subpass::set_debug_name(const std::string &name)
+{
+	debug_name = name;
+}
+
+const std::string &Subpass::get_debug_name() const
+{
+	return debug_name;
+}
+
 const ShaderSource &Subpass::get_vertex_shader() const
 {
 	return vertex_shader;
@@ -130,6 +244,42 @@ void Subpass::set_depth_stencil_resolve_mode(VkResolveModeFlagBits mode)
 	depth_stencil_resolve_mode = mode;
 }
 
+const FragmentShadingRateState &Subpass::get_fragment_shading_rate_state() const
+{
+	return fragment_shading_rate_state;
+}
+
+void Subpass::set_fragment_shading_rate_state(const FragmentShadingRateState &state)
+{
+	fragment_shading_rate_state = state;
+}
+
+uint32_t Subpass::get_shading_rate_attachment() const
+{
+	return shading_rate_attachment;
+}
+
+const VkExtent2D &Subpass::get_shading_rate_texel_size() const
+{
+	return shading_rate_texel_size;
+}
+
+void Subpass::set_shading_rate_attachment(uint32_t attachment, const VkExtent2D &texel_size)
+{
+	shading_rate_attachment = attachment;
+	shading_rate_texel_size = texel_size;
+}
+
+uint32_t Subpass::get_view_mask() const
+{
+	return view_mask;
+}
+
+void Subpass::set_view_mask(uint32_t view_mask)
+{
+	this->view_mask = view_mask;
+}
+
 void Subpass::set_sample_count(VkSampleCountFlagBits sample_count)
 {
 	this->sample_count = sample_count;
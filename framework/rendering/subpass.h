@@ -19,10 +19,12 @@
 
 #include "buffer_pool.h"
 #include "common/helpers.h"
+#include "core/command_pool.h"
 #include "core/shader_module.h"
 #include "rendering/pipeline_state.h"
 #include "rendering/render_context.h"
 #include "rendering/render_frame.h"
+#include "scene_graph/component_span.h"
 #include "scene_graph/components/light.h"
 #include "scene_graph/node.h"
 
@@ -33,6 +35,7 @@ VKBP_ENABLE_WARNINGS()
 namespace vkb
 {
 class CommandBuffer;
+class JobSystem;
 
 struct alignas(16) Light
 {
@@ -89,8 +92,70 @@ class Subpass
 	 */
 	virtual void draw(CommandBuffer &command_buffer) = 0;
 
+	/**
+	 * @brief Records work the draw depends on which cannot be recorded in a render pass, such as compute dispatches
+	 *        This function is called by the RenderPipeline for every subpass before beginning the render pass.
+	 * @param command_buffer Command buffer to use to record commands
+	 */
+	virtual void pre_draw(CommandBuffer &command_buffer)
+	{}
+
+	/**
+	 * @return Whether the subpass can record its draws with draw_parallel
+	 */
+	virtual bool is_parallel_draw_supported() const
+	{
+		return false;
+	}
+
+	/**
+	 * @brief Records the draws of the subpass into secondary command buffers in parallel,
+	 *        then executes them from the primary command buffer
+	 *        The RenderPipeline calls it instead of draw if the subpass supports it and parallel recording is enabled.
+	 * @param primary_command_buffer Command buffer recording the render pass
+	 * @param job_system Records the secondary command buffers, the worker with index i uses the resource pools of thread index i + 1
+	 */
+	virtual void draw_parallel(CommandBuffer &primary_command_buffer, JobSystem &job_system)
+	{}
+
+	/**
+	 * @brief Declares the draws of the subpass static, such as a shadow pass of static geometry or a skybox
+	 *        The RenderPipeline then replays them with draw_static instead of recording draw every frame.
+	 *        Static draws must only reference resources outliving the frame, not buffers allocated from the render frame.
+	 */
+	void set_static_contents(bool static_contents);
+
+	bool is_static_contents() const;
+
+	/**
+	 * @brief Re-records the static draws of every render frame before their next replay
+	 */
+	void invalidate_static_contents();
+
+	/**
+	 * @brief Hashes the state the static draws depend on, they are re-recorded when the hash changes
+	 *        The default hash covers the render pass, the framebuffer and the pipeline state of the subpass,
+	 *        subpasses override it to add the resources they bind.
+	 * @param primary_command_buffer Command buffer recording the render pass
+	 */
+	virtual size_t get_static_contents_hash(const CommandBuffer &primary_command_buffer) const;
+
+	/**
+	 * @brief Executes the secondary command buffer holding the static draws of the active frame,
+	 *        recording it with draw first if it is outdated
+	 * @param primary_command_buffer Command buffer recording the render pass
+	 */
+	void draw_static(CommandBuffer &primary_command_buffer);
+
 	RenderContext &get_render_context();
 
+	/**
+	 * @brief Names the subpass in tools such as the GPU profiler
+	 */
+	void set_debug_name(const std::string &name);
+
+	const std::string &get_debug_name() const;
+
 	const ShaderSource &get_vertex_shader() const;
 
 	const ShaderSource &get_fragment_shader() const;
@@ -127,6 +192,36 @@ class Subpass
 
 	void set_depth_stencil_resolve_mode(VkResolveModeFlagBits mode);
 
+	const FragmentShadingRateState &get_fragment_shading_rate_state() const;
+
+	/**
+	 * @brief Shades fragments of several pixels with a single invocation, the RenderPipeline sets the rate
+	 *        before drawing the subpass. It has no effect unless VK_KHR_fragment_shading_rate is enabled.
+	 *        The second combiner op needs to differ from KEEP for a shading rate attachment to apply.
+	 */
+	void set_fragment_shading_rate_state(const FragmentShadingRateState &state);
+
+	uint32_t get_shading_rate_attachment() const;
+
+	const VkExtent2D &get_shading_rate_texel_size() const;
+
+	/**
+	 * @brief Reads the fragment shading rate of each texel_size tile of pixels from an attachment of the render target
+	 *        The attachment needs the VK_IMAGE_USAGE_FRAGMENT_SHADING_RATE_ATTACHMENT_BIT_KHR usage and to be loaded by the render pass.
+	 * @param attachment Index of the attachment, VK_ATTACHMENT_UNUSED to disable it
+	 * @param texel_size Pixels covered by a texel of the attachment, within the limits of the device
+	 */
+	void set_shading_rate_attachment(uint32_t attachment, const VkExtent2D &texel_size);
+
+	uint32_t get_view_mask() const;
+
+	/**
+	 * @brief Renders the subpass once per view with VK_KHR_multiview, bit i of the mask rendering to layer i of the attachments
+	 *        The attachments need as many layers as the highest view, and the shaders select their view with gl_ViewIndex.
+	 * @param view_mask Views rendered by the subpass, 0 to disable multiview
+	 */
+	void set_view_mask(uint32_t view_mask);
+
 	/**
 	 * @brief Create a buffer allocation from scene graph lights to be bound to shaders
 	 * 
@@ -136,7 +231,7 @@ class Subpass
 	 * @return BufferAllocation A buffer allocation created for use in shaders
 	 */
 	template <typename T>
-	BufferAllocation allocate_lights(const std::vector<sg::Light *> &scene_lights, size_t max_lights)
+	BufferAllocation allocate_lights(const sg::ComponentSpan<sg::Light> &scene_lights, size_t max_lights)
 	{
 		assert(scene_lights.size() <= max_lights && "Exceeding Max Light Capacity");
 
@@ -170,7 +265,7 @@ class Subpass
 	 * @return BufferAllocation A buffer allocation created for use in shaders
 	 */
 	template <typename T>
-	BufferAllocation allocate_set_num_lights(const std::vector<sg::Light *> &scene_lights, size_t num_lights)
+	BufferAllocation allocate_set_num_lights(const sg::ComponentSpan<sg::Light> &scene_lights, size_t num_lights)
 	{
 		T light_info;
 		light_info.count = to_u32(num_lights);
@@ -206,12 +301,32 @@ class Subpass
 	std::unordered_map<std::string, ShaderResourceMode> resource_mode_map;
 
   private:
+	std::string debug_name{};
+
 	ShaderSource vertex_shader;
 
 	ShaderSource fragment_shader;
 
 	DepthStencilState depth_stencil_state{};
 
+	/**
+	 * @brief Secondary command buffer holding the static draws of a render frame
+	 */
+	struct StaticContents
+	{
+		std::unique_ptr<CommandPool> command_pool;
+
+		CommandBuffer *command_buffer{nullptr};
+
+		// Hash of the dependencies the command buffer was recorded with, 0 if it is outdated
+		size_t hash{0};
+	};
+
+	bool static_contents{false};
+
+	// The static draws are recorded per render frame, a frame only re-records them once its previous submissions completed
+	std::unordered_map<RenderFrame *, StaticContents> static_contents_per_frame;
+
 	/**
 	 * @brief When creating the renderpass, pDepthStencilAttachment will
 	 *        be set to nullptr, which disables depth testing
@@ -236,6 +351,17 @@ class Subpass
 
 	/// Default to no depth stencil resolve attachment
 	uint32_t depth_stencil_resolve_attachment{VK_ATTACHMENT_UNUSED};
+
+	/// Default to shading every pixel
+	FragmentShadingRateState fragment_shading_rate_state{};
+
+	/// Default to no shading rate attachment
+	uint32_t shading_rate_attachment{VK_ATTACHMENT_UNUSED};
+
+	VkExtent2D shading_rate_texel_size{};
+
+	/// Default to a single view, without multiview
+	uint32_t view_mask{0};
 };
 
 }        // namespace vkb
@@ -17,11 +17,14 @@
 
 #include "rendering/subpasses/forward_subpass.h"
 
+#include <algorithm>
+
 #include "common/utils.h"
 #include "common/vk_common.h"
 #include "rendering/render_context.h"
 #include "scene_graph/components/camera.h"
 #include "scene_graph/components/image.h"
+#include "scene_graph/components/light.h"
 #include "scene_graph/components/material.h"
 #include "scene_graph/components/mesh.h"
 #include "scene_graph/components/pbr_material.h"
@@ -33,13 +36,45 @@
 namespace vkb
 {
 ForwardSubpass::ForwardSubpass(RenderContext &render_context, ShaderSource &&vertex_source, ShaderSource &&fragment_source, sg::Scene &scene_, sg::Camera &camera) :
-    GeometrySubpass{render_context, std::move(vertex_source), std::move(fragment_source), scene_, camera}
+    GeometrySubpass{render_context, std::move(vertex_source), std::move(fragment_source), scene_, camera},
+    light_clustering{render_context, camera}
+{
+	set_debug_name("Forward");
+}
+
+void ForwardSubpass::set_clustered_lighting(bool enable)
 {
+	clustered_lighting = enable;
+}
+
+void ForwardSubpass::set_async_light_clustering(bool enable)
+{
+	light_clustering.set_async_compute(enable);
+}
+
+void ForwardSubpass::set_shadow_cascades(ShadowCascades *cascades)
+{
+	shadow_cascades = cascades;
+}
+
+void ForwardSubpass::set_image_based_lighting(ImageBasedLighting *lighting)
+{
+	image_based_lighting = lighting;
 }
 
 void ForwardSubpass::prepare()
 {
-	auto &device = render_context.get_device();
+	if (clustered_lighting && !LightClustering::is_supported(camera))
+	{
+		LOGW("Clustered lighting requires a perspective camera, shading every fragment with every light");
+		clustered_lighting = false;
+	}
+
+	if (clustered_lighting)
+	{
+		light_clustering.prepare();
+	}
+
 	for (auto &mesh : meshes)
 	{
 		for (auto &sub_mesh : mesh->get_submeshes())
@@ -50,17 +85,105 @@ void ForwardSubpass::prepare()
 			variant.add_definitions({"MAX_FORWARD_LIGHT_COUNT " + std::to_string(MAX_FORWARD_LIGHT_COUNT)});
 			variant.add_definitions(light_type_definitions);
 
-			auto &vert_module = device.get_resource_cache().request_shader_module(VK_SHADER_STAGE_VERTEX_BIT, get_vertex_shader(), variant);
-			auto &frag_module = device.get_resource_cache().request_shader_module(VK_SHADER_STAGE_FRAGMENT_BIT, get_fragment_shader(), variant);
+			if (clustered_lighting)
+			{
+				variant.add_definitions(LightClustering::get_shader_definitions());
+			}
+
+			if (shadow_cascades)
+			{
+				variant.add_definitions(ShadowCascades::get_shader_definitions());
+			}
+
+			if (image_based_lighting)
+			{
+				variant.add_definitions(ImageBasedLighting::get_shader_definitions());
+			}
 		}
 	}
+
+	// Builds the bindless and indirect variants on top of the lighting definitions
+	GeometrySubpass::prepare();
+}
+
+void ForwardSubpass::pre_draw(CommandBuffer &command_buffer)
+{
+	auto lights = request_render_packet().get_lights();
+
+	if (clustered_lighting)
+	{
+		light_clustering.record(command_buffer, lights, render_context.get_active_frame().get_render_target().get_render_area());
+	}
+
+	if (shadow_cascades)
+	{
+		auto it     = std::find(lights.begin(), lights.end(), &shadow_cascades->get_light());
+
+		// Clustered lighting sorts directional lights first, keeping their order
+		auto light_index = clustered_lighting ? std::count_if(lights.begin(), it, [](sg::Light *light) { return light->get_light_type() == sg::LightType::Directional; }) :
+		                                        std::distance(lights.begin(), it);
+
+		shadow_cascades->update(command_buffer, it != lights.end() ? to_u32(light_index) : ~0U);
+
+		// The shadow passes set their own viewport
+		const auto &extent = render_context.get_active_frame().get_render_target().get_render_area();
+
+		VkViewport viewport{};
+		viewport.width    = static_cast<float>(extent.width);
+		viewport.height   = static_cast<float>(extent.height);
+		viewport.minDepth = 0.0f;
+		viewport.maxDepth = 1.0f;
+		command_buffer.set_viewport(0, {viewport});
+
+		VkRect2D scissor{};
+		scissor.extent = extent;
+		command_buffer.set_scissor(0, {scissor});
+	}
+
+	GeometrySubpass::pre_draw(command_buffer);
 }
 
 void ForwardSubpass::draw(CommandBuffer &command_buffer)
 {
-	auto lights_buffer = allocate_lights<ForwardLights>(scene.get_components<sg::Light>(), MAX_FORWARD_LIGHT_COUNT);
-	command_buffer.bind_buffer(lights_buffer.get_buffer(), lights_buffer.get_offset(), lights_buffer.get_size(), 0, 4, 0);
+	if (!clustered_lighting)
+	{
+		lights_buffer = allocate_lights<ForwardLights>(request_render_packet().get_lights(), MAX_FORWARD_LIGHT_COUNT);
+	}
 
 	GeometrySubpass::draw(command_buffer);
 }
+
+void ForwardSubpass::draw_parallel(CommandBuffer &primary_command_buffer, JobSystem &job_system)
+{
+	if (!clustered_lighting)
+	{
+		lights_buffer = allocate_lights<ForwardLights>(request_render_packet().get_lights(), MAX_FORWARD_LIGHT_COUNT);
+	}
+
+	GeometrySubpass::draw_parallel(primary_command_buffer, job_system);
+}
+
+void ForwardSubpass::bind_frame_resources(CommandBuffer &command_buffer)
+{
+	if (clustered_lighting)
+	{
+		light_clustering.bind(command_buffer, 4);
+	}
+	else
+	{
+		command_buffer.bind_buffer(lights_buffer.get_buffer(), lights_buffer.get_offset(), lights_buffer.get_size(), 0, 4, 0);
+	}
+
+	if (shadow_cascades)
+	{
+		shadow_cascades->bind(command_buffer, 8);
+	}
+
+	if (image_based_lighting)
+	{
+		image_based_lighting->bind(command_buffer, 18);
+	}
+
+	GeometrySubpass::bind_frame_resources(command_buffer);
+}
 }        // namespace vkb
@@ -20,6 +20,9 @@
 #include "common/error.h"
 
 #include "buffer_pool.h"
+#include "rendering/image_based_lighting.h"
+#include "rendering/light_clustering.h"
+#include "rendering/shadow_cascades.h"
 #include "rendering/subpasses/geometry_subpass.h"
 
 #define MAX_FORWARD_LIGHT_COUNT 16
@@ -65,6 +68,58 @@ class ForwardSubpass : public GeometrySubpass
 	 * @brief Record draw commands
 	 */
 	virtual void draw(CommandBuffer &command_buffer) override;
+
+	virtual void draw_parallel(CommandBuffer &primary_command_buffer, JobSystem &job_system) override;
+
+	/**
+	 * @brief Bins the lights into clusters of screen tiles and depth slices with a compute pass recorded by pre_draw,
+	 *        so that each fragment is only shaded by the lights which can reach its cluster
+	 *        Lifts the MAX_FORWARD_LIGHT_COUNT limit. It requires a perspective camera and needs to be set before prepare.
+	 */
+	void set_clustered_lighting(bool enable);
+
+	/**
+	 * @brief Submits the light clustering pass to the async compute queue of the render context, when it has one,
+	 *        so that it overlaps with the graphics work before the fragment shaders reading the clusters
+	 *        It needs to be set before prepare.
+	 */
+	void set_async_light_clustering(bool enable);
+
+	/**
+	 * @brief Shadows the light of the cascades, which pre_draw updates before the render pass
+	 *        The cascades need to outlive the subpass and to be set before prepare.
+	 */
+	void set_shadow_cascades(ShadowCascades *cascades);
+
+	/**
+	 * @brief Replaces the constant ambient light with the diffuse and specular light of an environment,
+	 *        using the metallic and roughness factors of the materials
+	 *        The lighting needs to outlive the subpass and to be set before prepare.
+	 */
+	void set_image_based_lighting(ImageBasedLighting *lighting);
+
+	/**
+	 * @brief Records the light clustering pass and the shadow passes, if they are enabled, along with the passes of the geometry subpass
+	 */
+	virtual void pre_draw(CommandBuffer &command_buffer) override;
+
+  protected:
+	/**
+	 * @brief Binds the lights of the frame along with the resources of the geometry subpass
+	 */
+	virtual void bind_frame_resources(CommandBuffer &command_buffer) override;
+
+  private:
+	/// Lights of the current frame, shared by the command buffers recording the subpass
+	BufferAllocation lights_buffer;
+
+	bool clustered_lighting{false};
+
+	LightClustering light_clustering;
+
+	ShadowCascades *shadow_cascades{nullptr};
+
+	ImageBasedLighting *image_based_lighting{nullptr};
 };
 
 }        // namespace vkb
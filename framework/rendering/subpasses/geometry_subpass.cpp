@@ -16,172 +16,2510 @@
  */
 
 #include "rendering/subpasses/geometry_subpass.h"
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstring>
+#include <future>
+#include <limits>
+#include <map>
+
+#include "common/helpers.h"
 #include "common/utils.h"
 #include "common/vk_common.h"
+#include "core/framebuffer.h"
+#include "geometry/frustum.h"
+#include "job_system.h"
 #include "rendering/render_context.h"
+#include "rendering/texture_residency.h"
+#include "scene_graph/components/aabb.h"
 #include "scene_graph/components/camera.h"
 #include "scene_graph/components/image.h"
 #include "scene_graph/components/material.h"
 #include "scene_graph/components/mesh.h"
 #include "scene_graph/components/pbr_material.h"
+#include "scene_graph/components/perspective_camera.h"
 #include "scene_graph/components/texture.h"
 #include "scene_graph/node.h"
 #include "scene_graph/scene.h"
+#include "stats/cpu_profiler.h"
+#include "timer.h"
 
 namespace vkb
 {
+namespace
+{
+/// Set in the sort key of transparent draws, so they sort after opaque ones
+constexpr uint64_t DRAW_SORT_TRANSPARENT_BIT = 1ull << 63;
+
+constexpr uint64_t DRAW_SORT_MATERIAL_MASK = 0xffffffffull;
+
+/// Distance bits kept in sort keys, the sign bit of a distance is always zero
+constexpr uint64_t DRAW_SORT_DEPTH_MASK = 0x7fffffffull;
+
+/// Bits of the pipeline and material indices in the keys of draws sorted by state, larger indices share groups
+constexpr uint64_t DRAW_SORT_STATE_PIPELINE_MASK = 0x7fffull;
+
+constexpr uint64_t DRAW_SORT_STATE_MATERIAL_MASK = 0xffffull;
+
+constexpr uint64_t DRAW_SORT_HYBRID_PIPELINE_MASK = 0xfffull;
+
+constexpr uint64_t DRAW_SORT_HYBRID_MATERIAL_MASK = 0x7ffull;
+
+/// Below this many nodes the sort keys are computed on the calling thread
+constexpr size_t DRAW_SORT_PARALLEL_NODE_COUNT = 256;
+
+/// Fewest opaque draws recorded by a thread in parallel draws
+constexpr size_t DRAW_PARALLEL_MIN_RANGE_SIZE = 32;
+
+/// Frames recorded with a constant data strategy before measuring it, while its pipeline layouts and descriptor sets are created
+constexpr uint32_t CONSTANT_DATA_WARMUP_FRAMES = 4;
+
+/// Frames measured for every constant data strategy
+constexpr uint32_t CONSTANT_DATA_MEASURED_FRAMES = 32;
+
+inline const char *to_string(ConstantDataStrategy strategy)
+{
+	switch (strategy)
+	{
+		case ConstantDataStrategy::Automatic:
+			return "automatic";
+		case ConstantDataStrategy::DescriptorSets:
+			return "descriptor sets";
+		case ConstantDataStrategy::DynamicDescriptorSets:
+			return "dynamic descriptor sets";
+		case ConstantDataStrategy::PushDescriptors:
+			return "push descriptors";
+		default:
+			return "unknown";
+	}
+}
+}        // namespace
+
 GeometrySubpass::GeometrySubpass(RenderContext &render_context, ShaderSource &&vertex_source, ShaderSource &&fragment_source, sg::Scene &scene_, sg::Camera &camera) :
     Subpass{render_context, std::move(vertex_source), std::move(fragment_source)},
-    meshes{scene_.get_components<sg::Mesh>()},
+    meshes{scene_.get_components<sg::Mesh>().to_vector()},
     camera{camera},
     scene{scene_}
 {
+	set_debug_name("Geometry");
+}
+
+void GeometrySubpass::prepare()
+{
+	shader_variants.clear();
+
+	if (transparency_mode == TransparencyMode::WeightedBlended &&
+	    (indirect_drawing || gpu_culling || meshlet_rendering || automatic_instancing || occlusion_culling))
+	{
+		LOGW("Weighted blended transparency draws no opaque sub meshes, disabling the paths drawing them");
+
+		indirect_drawing     = false;
+		gpu_culling          = false;
+		meshlet_rendering    = false;
+		automatic_instancing = false;
+		occlusion_culling    = false;
+	}
+
+	if (!views.empty() && !get_render_context().get_device().is_enabled(VK_KHR_MULTIVIEW_EXTENSION_NAME))
+	{
+		LOGW("Drawing several views needs {}, only the camera of the subpass is drawn", VK_KHR_MULTIVIEW_EXTENSION_NAME);
+
+		views.clear();
+		set_view_mask(0);
+	}
+
+	if (!views.empty() && (meshlet_rendering || occlusion_culling || motion_vectors))
+	{
+		LOGW("Meshlets, occlusion culling and motion vectors only handle a single view, disabling them with multiview");
+
+		meshlet_rendering = false;
+		occlusion_culling = false;
+		motion_vectors    = false;
+	}
+
+	lod_levels.clear();
+
+	// Queries are created again for the render frames by pre_draw
+	occlusion_query_pool.reset();
+	occlusion_query_frames.clear();
+	occlusion_states.clear();
+
+	if (occlusion_culling)
+	{
+		occlusion_box_vertex_shader   = ShaderSource{"occlusion_box.vert"};
+		occlusion_box_fragment_shader = ShaderSource{"occlusion_box.frag"};
+	}
+
+	if (bindless_textures)
+	{
+		prepare_bindless_textures();
+	}
+
+	// After the bindless textures, as the table holds the texture indices
+	if (material_table)
+	{
+		prepare_material_table();
+	}
+
+	// After the material table, so that every variant of a sub mesh writes motion vectors
+	if (motion_vectors)
+	{
+		for (auto &mesh : meshes)
+		{
+			for (auto &sub_mesh : mesh->get_submeshes())
+			{
+				ShaderVariant shader_variant = get_shader_variant(*sub_mesh);
+				shader_variant.add_define("MOTION_VECTORS");
+
+				shader_variants[sub_mesh] = std::move(shader_variant);
+			}
+		}
+	}
+
+	// After the motion vectors, so that every variant of a sub mesh draws all the views
+	if (!views.empty())
+	{
+		for (auto &mesh : meshes)
+		{
+			for (auto &sub_mesh : mesh->get_submeshes())
+			{
+				ShaderVariant shader_variant = get_shader_variant(*sub_mesh);
+				shader_variant.add_define("MULTIVIEW");
+				shader_variant.add_define("MAX_VIEW_COUNT=" + std::to_string(MAX_VIEW_COUNT));
+
+				shader_variants[sub_mesh] = std::move(shader_variant);
+			}
+		}
+	}
+
+	if (transparency_mode == TransparencyMode::WeightedBlended)
+	{
+		for (auto &mesh : meshes)
+		{
+			for (auto &sub_mesh : mesh->get_submeshes())
+			{
+				if (sub_mesh->get_material()->alpha_mode == sg::AlphaMode::Blend)
+				{
+					ShaderVariant shader_variant = get_shader_variant(*sub_mesh);
+					shader_variant.add_define("WEIGHTED_BLENDED_OIT");
+
+					shader_variants[sub_mesh] = std::move(shader_variant);
+				}
+			}
+		}
+	}
+
+	previous_models.clear();
+	current_models.clear();
+	motion_history = false;
+
+	// Before the indirect batches, which leave out the sub meshes drawn with meshlets
+	if (meshlet_rendering)
+	{
+		prepare_meshlet_rendering();
+	}
+
+	if (indirect_drawing)
+	{
+		prepare_indirect_batches();
+	}
+
+	if (gpu_culling)
+	{
+		prepare_indirect_culling();
+	}
+
+	instanced_shader_variants.clear();
+
+	// Build all shader variance upfront
+	for (auto &mesh : meshes)
+	{
+		for (auto &sub_mesh : mesh->get_submeshes())
+		{
+			request_shader_modules(get_shader_variant(*sub_mesh));
+
+			if (automatic_instancing && mesh->get_nodes().size() > 1)
+			{
+				ShaderVariant shader_variant = get_shader_variant(*sub_mesh);
+				shader_variant.add_define("INSTANCED_DRAWING");
+
+				request_shader_modules(shader_variant);
+
+				instanced_shader_variants.emplace(sub_mesh, std::move(shader_variant));
+			}
+		}
+	}
+
+	for (auto &batch : indirect_batches)
+	{
+		request_shader_modules(batch.shader_variant);
+	}
+
+	for (auto &meshlet_shader_variant : meshlet_shader_variants)
+	{
+		request_meshlet_shader_modules(meshlet_shader_variant.second);
+	}
+}
+
+void GeometrySubpass::set_async_shader_compilation(bool enable)
+{
+	async_shader_compilation = enable;
+}
+
+void GeometrySubpass::set_bindless_textures(bool enable)
+{
+	bindless_textures = enable;
+}
+
+void GeometrySubpass::set_material_table(bool enable)
+{
+	material_table = enable;
+}
+
+void GeometrySubpass::set_indirect_drawing(bool enable)
+{
+	indirect_drawing = enable;
+}
+
+void GeometrySubpass::set_gpu_culling(bool enable)
+{
+	gpu_culling = enable;
+}
+
+void GeometrySubpass::set_meshlet_rendering(bool enable)
+{
+	meshlet_rendering = enable;
+}
+
+void GeometrySubpass::set_lod_pixel_error(float pixel_error)
+{
+	lod_pixel_error = pixel_error;
+}
+
+void GeometrySubpass::set_occlusion_culling(bool enable)
+{
+	occlusion_culling = enable;
+}
+
+void GeometrySubpass::set_texture_residency(TextureResidency *residency)
+{
+	texture_residency = residency;
+}
+
+void GeometrySubpass::set_cpu_culling(bool enable)
+{
+	cpu_culling = enable;
+}
+
+void GeometrySubpass::set_automatic_instancing(bool enable)
+{
+	automatic_instancing = enable;
+}
+
+void GeometrySubpass::set_draw_order(DrawOrder order)
+{
+	draw_order = order;
+}
+
+void GeometrySubpass::set_transparency_mode(TransparencyMode mode)
+{
+	transparency_mode = mode;
+}
+
+void GeometrySubpass::set_extended_dynamic_state(bool enable)
+{
+	extended_dynamic_state = enable;
+}
+
+void GeometrySubpass::set_constant_data_strategy(ConstantDataStrategy strategy)
+{
+	constant_data_strategy = strategy;
+
+	measured_strategies.clear();
+	constant_data_strategy_chosen = false;
+
+	if (strategy != ConstantDataStrategy::Automatic)
+	{
+		apply_constant_data_strategy(strategy);
+	}
+}
+
+ConstantDataStrategy GeometrySubpass::get_constant_data_strategy() const
+{
+	return active_constant_data_strategy;
+}
+
+void GeometrySubpass::set_frame_uniform_array(bool enable)
+{
+	frame_uniform_array = enable;
+
+	frame_uniform_offsets.clear();
+}
+
+void GeometrySubpass::set_motion_vectors(bool enable)
+{
+	motion_vectors = enable;
+}
+
+void GeometrySubpass::set_views(const std::vector<sg::Camera *> &views)
+{
+	if (views.size() > MAX_VIEW_COUNT)
+	{
+		throw std::runtime_error(fmt::format("Geometry subpass draws at most {} views, {} were set", MAX_VIEW_COUNT, views.size()));
+	}
+
+	this->views = views;
+
+	// View i renders to layer i of the attachments
+	set_view_mask(views.empty() ? 0 : (1u << to_u32(views.size())) - 1);
+}
+
+void GeometrySubpass::update_multiview_uniform()
+{
+	auto &render_frame = get_render_context().get_active_frame();
+
+	multiview_allocation = render_frame.allocate_buffer(VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT, sizeof(MultiviewUniform));
+
+	auto multiview_uniform = multiview_allocation.emplace<MultiviewUniform>();
+
+	for (size_t i = 0; i < views.size(); ++i)
+	{
+		auto &view = *views[i];
+
+		glm::mat4 view_matrix = view.get_view();
+
+		multiview_uniform->view_proj[i]       = view.get_pre_rotation() * vulkan_style_projection(view.get_projection()) * view_matrix;
+		multiview_uniform->camera_position[i] = glm::inverse(view_matrix)[3];
+	}
+}
+
+void GeometrySubpass::update_motion_vectors()
+{
+	std::swap(previous_models, current_models);
+	current_models.clear();
+
+	for (auto &draw : render_packet->get_draws())
+	{
+		current_models[draw.node] = draw.world_matrix;
+	}
+
+	previous_view_proj = motion_history ? current_view_proj : render_packet->get_view_projection();
+	current_view_proj  = render_packet->get_view_projection();
+	motion_history     = true;
+}
+
+const glm::mat4 &GeometrySubpass::get_previous_model(const sg::Node &node, const glm::mat4 &model) const
+{
+	if (motion_vectors)
+	{
+		auto it = previous_models.find(&node);
+
+		if (it != previous_models.end())
+		{
+			return it->second;
+		}
+	}
+
+	return model;
+}
+
+void GeometrySubpass::update_frame_uniform_array(const std::vector<std::pair<sg::Node *, sg::SubMesh *>> &opaque_nodes,
+                                                 const std::vector<std::pair<sg::Node *, sg::SubMesh *>> &transparent_nodes)
+{
+	PROFILE_FUNCTION();
+
+	frame_uniform_offsets.clear();
+
+	// Nodes with several sub meshes are written once
+	std::vector<sg::Node *> nodes;
+	nodes.reserve(opaque_nodes.size() + transparent_nodes.size());
+
+	for (auto *node_list : {&opaque_nodes, &transparent_nodes})
+	{
+		for (auto &node : *node_list)
+		{
+			if (frame_uniform_offsets.emplace(node.first, std::make_pair(nullptr, 0)).second)
+			{
+				nodes.push_back(node.first);
+			}
+		}
+	}
+
+	if (nodes.empty())
+	{
+		return;
+	}
+
+	auto &render_frame = get_render_context().get_active_frame();
+
+	VkDeviceSize alignment = render_context.get_device().get_gpu().get_properties().limits.minUniformBufferOffsetAlignment;
+	VkDeviceSize stride    = (sizeof(GlobalUniform) + alignment - 1) / alignment * alignment;
+
+	// Uniforms are split in allocations fitting a block of the buffer pool
+	size_t nodes_per_allocation = static_cast<size_t>(RenderFrame::BUFFER_POOL_BLOCK_SIZE * 1024 / stride);
+
+	std::vector<BufferAllocation> allocations;
+
+	for (size_t first_node = 0; first_node < nodes.size(); first_node += nodes_per_allocation)
+	{
+		size_t node_count = std::min(nodes_per_allocation, nodes.size() - first_node);
+
+		allocations.push_back(render_frame.allocate_buffer(VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT, stride * node_count));
+	}
+
+	for (size_t i = 0; i < nodes.size(); ++i)
+	{
+		auto &allocation = allocations[i / nodes_per_allocation];
+
+		frame_uniform_offsets[nodes[i]] = {&allocation.get_buffer(), allocation.get_offset() + stride * (i % nodes_per_allocation)};
+	}
+
+	// Buffers are mapped on the calling thread, as mapping is not thread safe
+	std::vector<uint8_t *> mapped_allocations;
+	for (auto &allocation : allocations)
+	{
+		mapped_allocations.push_back(allocation.map());
+	}
+
+	const glm::mat4 &camera_view_proj = render_packet->get_view_projection();
+	const glm::vec3 &camera_position  = render_packet->get_camera_position();
+
+	auto write_uniforms = [&](size_t first_node, size_t last_node) {
+		for (size_t i = first_node; i < last_node; ++i)
+		{
+			auto global_uniform = new (mapped_allocations[i / nodes_per_allocation] + stride * (i % nodes_per_allocation)) GlobalUniform;
+
+			global_uniform->model                     = nodes[i]->get_transform().get_world_matrix();
+			global_uniform->camera_view_proj          = camera_view_proj;
+			global_uniform->camera_position           = camera_position;
+			global_uniform->previous_model            = get_previous_model(*nodes[i], global_uniform->model);
+			global_uniform->previous_camera_view_proj = previous_view_proj;
+		}
+	};
+
+	if (nodes.size() < DRAW_SORT_PARALLEL_NODE_COUNT)
+	{
+		write_uniforms(0, nodes.size());
+	}
+	else
+	{
+		auto &job_system = JobSystem::get();
+
+		std::vector<std::future<void>> chunk_futures;
+
+		// The calling thread writes the first chunk
+		size_t chunk_count = job_system.get_thread_count() + 1;
+		size_t chunk_size  = (nodes.size() + chunk_count - 1) / chunk_count;
+
+		for (size_t first_node = chunk_size; first_node < nodes.size(); first_node += chunk_size)
+		{
+			size_t last_node = std::min(first_node + chunk_size, nodes.size());
+
+			chunk_futures.push_back(job_system.push([&write_uniforms, first_node, last_node](size_t) {
+				write_uniforms(first_node, last_node);
+			},
+			                                        JobPriority::High));
+		}
+
+		write_uniforms(0, std::min(chunk_size, nodes.size()));
+
+		for (auto &future : chunk_futures)
+		{
+			job_system.wait(future);
+			future.get();
+		}
+	}
+
+	for (auto &allocation : allocations)
+	{
+		allocation.flush();
+	}
+}
+
+void GeometrySubpass::apply_constant_data_strategy(ConstantDataStrategy strategy)
+{
+	active_constant_data_strategy = strategy;
+
+	switch (strategy)
+	{
+		case ConstantDataStrategy::DynamicDescriptorSets:
+			resource_mode_map["GlobalUniform"] = ShaderResourceMode::Dynamic;
+			break;
+		case ConstantDataStrategy::PushDescriptors:
+			resource_mode_map["GlobalUniform"] = ShaderResourceMode::Push;
+			break;
+		default:
+			resource_mode_map["GlobalUniform"] = ShaderResourceMode::Static;
+			break;
+	}
+}
+
+void GeometrySubpass::measure_constant_data_strategy(double recording_time)
+{
+	if (measured_strategies.empty())
+	{
+		// Start measuring with the strategies the device supports
+		measured_strategies = {ConstantDataStrategy::DescriptorSets, ConstantDataStrategy::DynamicDescriptorSets};
+
+		if (render_context.get_device().is_enabled(VK_KHR_PUSH_DESCRIPTOR_EXTENSION_NAME) && !bindless_textures)
+		{
+			measured_strategies.push_back(ConstantDataStrategy::PushDescriptors);
+		}
+
+		measured_frame_count = 0;
+		measured_time        = 0.0;
+		fastest_strategy     = {ConstantDataStrategy::DescriptorSets, 0.0};
+
+		apply_constant_data_strategy(measured_strategies.front());
+
+		return;
+	}
+
+	if (++measured_frame_count <= CONSTANT_DATA_WARMUP_FRAMES)
+	{
+		return;
+	}
+
+	measured_time += recording_time;
+
+	if (measured_frame_count < CONSTANT_DATA_WARMUP_FRAMES + CONSTANT_DATA_MEASURED_FRAMES)
+	{
+		return;
+	}
+
+	double average_time = measured_time / CONSTANT_DATA_MEASURED_FRAMES;
+
+	LOGI("Constant data recorded with {} in {:.3f} ms per frame", to_string(measured_strategies.front()), average_time * 1000.0);
+
+	if (fastest_strategy.second == 0.0 || average_time < fastest_strategy.second)
+	{
+		fastest_strategy = {measured_strategies.front(), average_time};
+	}
+
+	measured_strategies.erase(measured_strategies.begin());
+	measured_frame_count = 0;
+	measured_time        = 0.0;
+
+	if (measured_strategies.empty())
+	{
+		LOGI("Constant data strategy chosen: {}", to_string(fastest_strategy.first));
+
+		constant_data_strategy_chosen = true;
+
+		apply_constant_data_strategy(fastest_strategy.first);
+	}
+	else
+	{
+		apply_constant_data_strategy(measured_strategies.front());
+	}
+}
+
+const ShaderVariant &GeometrySubpass::get_shader_variant(const sg::SubMesh &sub_mesh) const
+{
+	auto variant_it = shader_variants.find(&sub_mesh);
+
+	if (variant_it != shader_variants.end())
+	{
+		return variant_it->second;
+	}
+
+	return sub_mesh.get_shader_variant();
+}
+
+void GeometrySubpass::prepare_bindless_textures()
+{
+	bindless_texture_list.clear();
+	bindless_texture_indices.clear();
+
+	auto &gpu = render_context.get_device().get_gpu();
+
+	if (!gpu.get_requested_features().shaderSampledImageArrayDynamicIndexing)
+	{
+		LOGW("Bindless textures need shaderSampledImageArrayDynamicIndexing, binding textures per sub mesh");
+		bindless_textures = false;
+		return;
+	}
+
+	if (!scene.has_component<sg::Texture>())
+	{
+		bindless_textures = false;
+		return;
+	}
+
+	// Textures sharing an image and a sampler, like the layers of a texture array, share an element
+	std::map<std::pair<const sg::Image *, const sg::Sampler *>, uint32_t> element_indices;
+
+	bool texture_arrays = false;
+
+	for (auto texture : scene.get_components<sg::Texture>())
+	{
+		auto element_it = element_indices.emplace(std::make_pair(texture->get_image(), texture->get_sampler()), to_u32(bindless_texture_list.size()));
+
+		if (element_it.second)
+		{
+			bindless_texture_list.push_back(texture);
+		}
+
+		bindless_texture_indices.emplace(texture, element_it.first->second);
+
+		texture_arrays |= texture->get_image()->get_vk_image_view().get_view_type() == VK_IMAGE_VIEW_TYPE_2D_ARRAY;
+	}
+
+	auto limits        = gpu.get_properties().limits;
+	auto max_textures  = std::min(limits.maxPerStageDescriptorSamplers, limits.maxPerStageDescriptorSampledImages);
+	auto texture_count = to_u32(bindless_texture_list.size());
+
+	if (texture_count > max_textures)
+	{
+		LOGW("Scene has {} textures, more than the {} that can be bound as an array, binding textures per sub mesh", texture_count, max_textures);
+		bindless_texture_list.clear();
+		bindless_texture_indices.clear();
+		bindless_textures = false;
+		return;
+	}
+
+	for (auto &mesh : meshes)
+	{
+		for (auto &sub_mesh : mesh->get_submeshes())
+		{
+			ShaderVariant shader_variant = sub_mesh->get_shader_variant();
+			shader_variant.add_define("BINDLESS_TEXTURE_COUNT=" + std::to_string(texture_count));
+
+			if (texture_arrays)
+			{
+				// Images packed by the loader are all viewed as arrays
+				shader_variant.add_define("TEXTURE_ARRAYS");
+			}
+
+			shader_variants.emplace(sub_mesh, std::move(shader_variant));
+		}
+	}
+}
+
+void GeometrySubpass::prepare_material_table()
+{
+	material_indices.clear();
+
+	std::vector<MaterialTableEntry> entries;
+
+	for (auto &mesh : meshes)
+	{
+		for (auto &sub_mesh : mesh->get_submeshes())
+		{
+			auto pbr_material = dynamic_cast<const sg::PBRMaterial *>(sub_mesh->get_material());
+
+			auto material_it = material_indices.emplace(pbr_material, to_u32(entries.size()));
+
+			if (material_it.second)
+			{
+				MaterialTableEntry entry{};
+				entry.base_color_factor = pbr_material->base_color_factor;
+				entry.metallic_factor   = pbr_material->metallic_factor;
+				entry.roughness_factor  = pbr_material->roughness_factor;
+
+				auto texture_it = pbr_material->textures.find("base_color_texture");
+
+				if (texture_it != pbr_material->textures.end())
+				{
+					auto index_it = bindless_texture_indices.find(texture_it->second);
+
+					if (index_it != bindless_texture_indices.end())
+					{
+						entry.base_color_texture_index = index_it->second;
+						entry.base_color_texture_layer = texture_it->second->get_array_layer();
+					}
+				}
+
+				entries.push_back(entry);
+			}
+
+			ShaderVariant shader_variant = get_shader_variant(*sub_mesh);
+			shader_variant.add_define("MATERIAL_TABLE");
+
+			shader_variants[sub_mesh] = std::move(shader_variant);
+		}
+	}
+
+	if (entries.empty())
+	{
+		material_table_buffer.reset();
+		material_table = false;
+		return;
+	}
+
+	material_table_buffer = std::make_unique<core::Buffer>(render_context.get_device(), entries.size() * sizeof(MaterialTableEntry), VK_BUFFER_USAGE_STORAGE_BUFFER_BIT, VMA_MEMORY_USAGE_CPU_TO_GPU);
+	material_table_buffer->update(reinterpret_cast<const uint8_t *>(entries.data()), entries.size() * sizeof(MaterialTableEntry));
+}
+
+void GeometrySubpass::bind_bindless_textures(CommandBuffer &command_buffer)
+{
+	// Bound once per draw, the resource set stays clean for every sub mesh after the first flush
+	for (uint32_t i = 0; i < to_u32(bindless_texture_list.size()); ++i)
+	{
+		auto texture = bindless_texture_list[i];
+
+		command_buffer.bind_image(texture->get_image()->get_vk_image_view(),
+		                          texture->get_sampler()->vk_sampler,
+		                          BINDLESS_TEXTURE_SET, 0, i);
+	}
+}
+
+void GeometrySubpass::prepare_indirect_batches()
+{
+	indirect_batches.clear();
+	indirect_sub_meshes.clear();
+	indirect_commands.reset();
+	indirect_instance_count = 0;
+
+	auto &device   = render_context.get_device();
+	auto  features = device.get_gpu().get_requested_features();
+
+	// Every draw selects its instance data through its first instance
+	if (!features.drawIndirectFirstInstance)
+	{
+		LOGW("Indirect drawing needs drawIndirectFirstInstance, drawing sub meshes one by one");
+		indirect_drawing = false;
+		return;
+	}
+
+	multi_draw_indirect = features.multiDrawIndirect == VK_TRUE;
+
+	// Textures of a multi draw are indexed non uniformly from the bindless array
+	auto descriptor_indexing_features = device.get_gpu().get_requested_extension_features<VkPhysicalDeviceDescriptorIndexingFeaturesEXT>(VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_DESCRIPTOR_INDEXING_FEATURES_EXT);
+
+	bool textures_supported = bindless_textures && device.is_enabled(VK_EXT_DESCRIPTOR_INDEXING_EXTENSION_NAME) &&
+	                          descriptor_indexing_features && descriptor_indexing_features->shaderSampledImageArrayNonUniformIndexing;
+
+	if (bindless_textures && !textures_supported)
+	{
+		LOGW("Indirect draws need shaderSampledImageArrayNonUniformIndexing to index textures, textured sub meshes are drawn one by one");
+	}
+
+	std::map<size_t, size_t> batch_indices;
+
+	for (auto &mesh : meshes)
+	{
+		for (auto &sub_mesh : mesh->get_submeshes())
+		{
+			auto material = sub_mesh->get_material();
+
+			// Merged vertices share a single position dequantization, so quantized sub meshes are drawn one by one
+			if (material->alpha_mode == sg::AlphaMode::Blend || sub_mesh->vertex_indices == 0 || !sub_mesh->index_buffer || !sub_mesh->index_buffer->get_data() ||
+			    (!material->textures.empty() && !textures_supported) || sub_mesh->position_dequantization || meshlet_shader_variants.count(sub_mesh))
+			{
+				continue;
+			}
+
+			// The vertex data is merged on the CPU, so it needs to be mapped
+			bool mapped = std::all_of(sub_mesh->vertex_buffers.begin(), sub_mesh->vertex_buffers.end(),
+			                          [](const std::pair<const std::string, core::Buffer> &vertex_buffer) { return vertex_buffer.second.get_data() != nullptr; }) &&
+			              (!sub_mesh->interleaved_vertex_buffer || sub_mesh->interleaved_vertex_buffer->get_data() != nullptr);
+
+			if (!mapped)
+			{
+				continue;
+			}
+
+			for (auto &node : mesh->get_nodes())
+			{
+				// The front face is fixed for a batch, so it is taken from the transform at prepare time
+				const auto &scale      = node->get_transform().get_scale();
+				VkFrontFace front_face = scale.x * scale.y * scale.z < 0 ? VK_FRONT_FACE_CLOCKWISE : VK_FRONT_FACE_COUNTER_CLOCKWISE;
+
+				ShaderVariant shader_variant = get_shader_variant(*sub_mesh);
+				shader_variant.add_define("INDIRECT_DRAWING");
+
+				// Sub meshes can share a batch if they share a pipeline and a vertex layout
+				size_t batch_key{shader_variant.get_id()};
+				hash_combine(batch_key, front_face);
+				hash_combine(batch_key, material->double_sided);
+				hash_combine(batch_key, sub_mesh->interleaved_vertex_buffer != nullptr);
+
+				std::map<std::string, sg::VertexAttribute> attributes{sub_mesh->get_attributes().begin(), sub_mesh->get_attributes().end()};
+
+				for (auto &attribute : attributes)
+				{
+					hash_combine(batch_key, attribute.first);
+					hash_combine(batch_key, attribute.second.format);
+					hash_combine(batch_key, attribute.second.stride);
+					hash_combine(batch_key, attribute.second.offset);
+				}
+
+				auto batch_it = batch_indices.find(batch_key);
+
+				if (batch_it == batch_indices.end())
+				{
+					IndirectBatch batch;
+					batch.shader_variant = std::move(shader_variant);
+					batch.sub_mesh       = sub_mesh;
+					batch.front_face     = front_face;
+
+					batch_it = batch_indices.emplace(batch_key, indirect_batches.size()).first;
+					indirect_batches.push_back(std::move(batch));
+				}
+
+				indirect_batches[batch_it->second].draws.emplace_back(node, sub_mesh);
+				indirect_batches[batch_it->second].draw_bounds.emplace_back(mesh->get_bounds().get_min(), mesh->get_bounds().get_max());
+			}
+
+			indirect_sub_meshes.insert(sub_mesh);
+		}
+	}
+
+	if (indirect_batches.empty())
+	{
+		return;
+	}
+
+	std::vector<VkDrawIndexedIndirectCommand> commands;
+
+	for (auto &batch : indirect_batches)
+	{
+		batch.command_offset = commands.size() * sizeof(VkDrawIndexedIndirectCommand);
+		batch.first_instance = indirect_instance_count;
+
+		// Sub meshes drawn by several nodes are only merged once
+		std::unordered_map<const sg::SubMesh *, VkDrawIndexedIndirectCommand> sub_mesh_commands;
+
+		std::map<std::string, std::vector<uint8_t>> vertex_data;
+		std::vector<uint8_t>                        interleaved_data;
+		std::vector<uint32_t>                       index_data;
+		uint32_t                                    vertex_count{0};
+
+		for (auto &draw : batch.draws)
+		{
+			auto sub_mesh = draw.second;
+
+			auto command_it = sub_mesh_commands.find(sub_mesh);
+
+			if (command_it == sub_mesh_commands.end())
+			{
+				VkDrawIndexedIndirectCommand command{};
+				command.indexCount    = sub_mesh->vertex_indices;
+				command.instanceCount = 1;
+				command.firstIndex    = to_u32(index_data.size());
+				command.vertexOffset  = static_cast<int32_t>(vertex_count);
+
+				if (sub_mesh->interleaved_vertex_buffer)
+				{
+					auto &vertex_buffer = *sub_mesh->interleaved_vertex_buffer;
+
+					interleaved_data.resize(static_cast<size_t>(vertex_count + sub_mesh->vertices_count) * sub_mesh->vertex_stride);
+
+					auto size = std::min<size_t>(static_cast<size_t>(sub_mesh->vertices_count) * sub_mesh->vertex_stride, vertex_buffer.get_size());
+					std::copy_n(vertex_buffer.get_data(), size, interleaved_data.begin() + static_cast<size_t>(vertex_count) * sub_mesh->vertex_stride);
+				}
+
+				for (auto &vertex_buffer : sub_mesh->vertex_buffers)
+				{
+					sg::VertexAttribute attribute;
+					sub_mesh->get_attribute(vertex_buffer.first, attribute);
+
+					// Keep every attribute aligned to the vertex offset of the draw
+					auto &data = vertex_data[vertex_buffer.first];
+					data.resize(static_cast<size_t>(vertex_count + sub_mesh->vertices_count) * attribute.stride);
+
+					auto size = std::min<size_t>(static_cast<size_t>(sub_mesh->vertices_count) * attribute.stride, vertex_buffer.second.get_size());
+					std::copy_n(vertex_buffer.second.get_data(), size, data.begin() + static_cast<size_t>(vertex_count) * attribute.stride);
+				}
+
+				// Indices are widened to 32 bits so that all draws share one index buffer
+				auto indices = sub_mesh->index_buffer->get_data() + sub_mesh->index_offset;
+
+				for (uint32_t i = 0; i < sub_mesh->vertex_indices; ++i)
+				{
+					if (sub_mesh->index_type == VK_INDEX_TYPE_UINT16)
+					{
+						index_data.push_back(reinterpret_cast<const uint16_t *>(indices)[i]);
+					}
+					else
+					{
+						index_data.push_back(reinterpret_cast<const uint32_t *>(indices)[i]);
+					}
+				}
+
+				vertex_count += sub_mesh->vertices_count;
+
+				command_it = sub_mesh_commands.emplace(sub_mesh, command).first;
+			}
+
+			auto command          = command_it->second;
+			command.firstInstance = indirect_instance_count++;
+
+			commands.push_back(command);
+		}
+
+		for (auto &data : vertex_data)
+		{
+			auto buffer = std::make_unique<core::Buffer>(device, data.second.size(), VK_BUFFER_USAGE_VERTEX_BUFFER_BIT, VMA_MEMORY_USAGE_CPU_TO_GPU);
+			buffer->update(data.second);
+
+			batch.vertex_buffers.emplace(data.first, std::move(buffer));
+		}
+
+		if (!interleaved_data.empty())
+		{
+			batch.interleaved_vertex_buffer = std::make_unique<core::Buffer>(device, interleaved_data.size(), VK_BUFFER_USAGE_VERTEX_BUFFER_BIT, VMA_MEMORY_USAGE_CPU_TO_GPU);
+			batch.interleaved_vertex_buffer->update(interleaved_data);
+		}
+
+		batch.index_buffer = std::make_unique<core::Buffer>(device, index_data.size() * sizeof(uint32_t), VK_BUFFER_USAGE_INDEX_BUFFER_BIT, VMA_MEMORY_USAGE_CPU_TO_GPU);
+		batch.index_buffer->update(reinterpret_cast<const uint8_t *>(index_data.data()), index_data.size() * sizeof(uint32_t));
+	}
+
+	indirect_commands = std::make_unique<core::Buffer>(device, commands.size() * sizeof(VkDrawIndexedIndirectCommand), VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT, VMA_MEMORY_USAGE_CPU_TO_GPU);
+	indirect_commands->update(reinterpret_cast<const uint8_t *>(commands.data()), commands.size() * sizeof(VkDrawIndexedIndirectCommand));
+
+	LOGI("Indirect drawing merged {} draws into {} batches", commands.size(), indirect_batches.size());
+}
+
+void GeometrySubpass::draw_indirect_batches(CommandBuffer &command_buffer)
+{
+	// The model matrix of every draw comes from its instance data
+	auto global_allocation = allocate_instanced_global_uniform(0);
+
+	command_buffer.bind_buffer(global_allocation.get_buffer(), global_allocation.get_offset(), global_allocation.get_size(), 0, 1, 0);
+
+	// Without the culling pass, the instance data of the frame is not written yet
+	if (!culling_recorded)
+	{
+		update_indirect_instances();
+	}
+
+	command_buffer.bind_buffer(indirect_instance_allocation.get_buffer(), indirect_instance_allocation.get_offset(), indirect_instance_allocation.get_size(), 0, INDIRECT_INSTANCE_BINDING, 0);
+
+	auto  frame_index   = render_context.get_active_frame_index();
+	auto &draw_commands = culling_recorded ? *culled_commands[frame_index] : *indirect_commands;
+
+	for (size_t batch_index = 0; batch_index < indirect_batches.size(); ++batch_index)
+	{
+		auto &batch = indirect_batches[batch_index];
+
+		std::vector<ShaderModule *> shader_modules = request_shader_modules(batch.shader_variant);
+
+		if (shader_modules.empty())
+		{
+			// Shaders are still compiling in the background
+			continue;
+		}
+
+		prepare_pipeline_state(command_buffer, batch.front_face, batch.sub_mesh->get_material()->double_sided);
+
+		auto &pipeline_layout = prepare_pipeline_layout(command_buffer, shader_modules);
+
+		command_buffer.bind_pipeline_layout(pipeline_layout);
+
+		prepare_vertex_input_state(command_buffer, pipeline_layout, *batch.sub_mesh);
+
+		if (batch.interleaved_vertex_buffer)
+		{
+			command_buffer.bind_vertex_buffers(0, {std::cref(*batch.interleaved_vertex_buffer)}, {0});
+		}
+
+		for (auto &input_resource : pipeline_layout.get_resources(ShaderResourceType::Input, VK_SHADER_STAGE_VERTEX_BIT))
+		{
+			auto buffer_it = batch.vertex_buffers.find(input_resource.name);
+
+			if (buffer_it != batch.vertex_buffers.end())
+			{
+				std::vector<std::reference_wrapper<const core::Buffer>> buffers;
+				buffers.emplace_back(std::ref(*buffer_it->second));
+
+				command_buffer.bind_vertex_buffers(input_resource.location, std::move(buffers), {0});
+			}
+		}
+
+		command_buffer.bind_index_buffer(*batch.index_buffer, 0, VK_INDEX_TYPE_UINT32);
+
+		auto draw_count = to_u32(batch.draws.size());
+
+		if (culling_recorded && draw_indirect_count)
+		{
+			// Visible draws were packed at the start of the batch and counted by the culling pass
+			command_buffer.draw_indexed_indirect_count(draw_commands, batch.command_offset, *culled_draw_counts[frame_index], batch_index * sizeof(uint32_t),
+			                                           draw_count, sizeof(VkDrawIndexedIndirectCommand));
+		}
+		else if (multi_draw_indirect)
+		{
+			command_buffer.draw_indexed_indirect(draw_commands, batch.command_offset, draw_count, sizeof(VkDrawIndexedIndirectCommand));
+		}
+		else if (draw_count > 0)
+		{
+			// Without multiDrawIndirect every command needs its own call, the draw data still comes from the GPU.
+			// The first call flushes the state of the batch, the others only draw with it
+			command_buffer.draw_indexed_indirect(draw_commands, batch.command_offset, 1, sizeof(VkDrawIndexedIndirectCommand));
+
+			CommandBuffer::RawRecording raw_recording{command_buffer};
+
+			for (uint32_t i = 1; i < draw_count; ++i)
+			{
+				raw_recording.draw_indexed_indirect(draw_commands, batch.command_offset + i * sizeof(VkDrawIndexedIndirectCommand), 1, sizeof(VkDrawIndexedIndirectCommand));
+			}
+		}
+	}
+
+	culling_recorded = false;
+}
+
+void GeometrySubpass::select_lods()
+{
+	// A coarser level is only selected once its error is below this share of the limit
+	const float hysteresis = 0.75f;
+
+	if (lod_pixel_error <= 0.0f)
+	{
+		return;
+	}
+
+	float pixels_per_unit = get_pixels_per_unit();
+
+	for (auto &draw : render_packet->get_draws())
+	{
+		const sg::AABB &bounds = draw.mesh->get_bounds();
+
+		float scale = std::max(glm::length(glm::vec3{draw.world_matrix[0]}),
+		                       std::max(glm::length(glm::vec3{draw.world_matrix[1]}), glm::length(glm::vec3{draw.world_matrix[2]})));
+
+		// Distance to the closest point of the bounding sphere
+		float distance = draw.camera_distance - glm::length(bounds.get_max() - bounds.get_min()) * 0.5f * scale;
+
+		for (auto &sub_mesh : draw.mesh->get_submeshes())
+		{
+			if (sub_mesh->lods.empty())
+			{
+				continue;
+			}
+
+			auto &level = lod_levels[std::make_pair(draw.node, sub_mesh)];
+
+			if (distance <= 0.0f)
+			{
+				level = 0;
+				continue;
+			}
+
+			auto get_pixel_error = [&](uint32_t lod) {
+				return lod == 0 ? 0.0f : sub_mesh->lods[lod - 1].error * scale * pixels_per_unit / distance;
+			};
+
+			level = std::min(level, to_u32(sub_mesh->lods.size()));
+
+			while (level > 0 && get_pixel_error(level) > lod_pixel_error)
+			{
+				--level;
+			}
+
+			while (level < sub_mesh->lods.size() && get_pixel_error(level + 1) <= lod_pixel_error * hysteresis)
+			{
+				++level;
+			}
+		}
+	}
+}
+
+void GeometrySubpass::request_texture_levels()
+{
+	float pixels_per_unit = get_pixels_per_unit();
+
+	for (auto &draw : render_packet->get_draws())
+	{
+		const sg::AABB &bounds = draw.mesh->get_bounds();
+
+		float scale = std::max(glm::length(glm::vec3{draw.world_matrix[0]}),
+		                       std::max(glm::length(glm::vec3{draw.world_matrix[1]}), glm::length(glm::vec3{draw.world_matrix[2]})));
+
+		float radius = glm::length(bounds.get_max() - bounds.get_min()) * 0.5f * scale;
+
+		// Distance to the closest point of the bounding sphere, the camera inside of it needs the finest levels
+		float distance = draw.camera_distance - radius;
+
+		float footprint = distance > 0.0f ? 2.0f * radius * pixels_per_unit / distance : std::numeric_limits<float>::max();
+
+		for (auto &sub_mesh : draw.mesh->get_submeshes())
+		{
+			for (auto &texture : sub_mesh->get_material()->textures)
+			{
+				auto image = texture.second->get_image();
+
+				if (!image)
+				{
+					continue;
+				}
+
+				const auto &extent = image->get_extent();
+
+				// Each level halves the texels across the footprint
+				float texels_per_pixel = static_cast<float>(std::max(extent.width, extent.height)) / std::max(footprint, 1.0f);
+
+				uint32_t level = texels_per_pixel > 1.0f ? static_cast<uint32_t>(std::log2(texels_per_pixel)) : 0;
+
+				texture_residency->request_level(*image, level);
+			}
+		}
+	}
+}
+
+float GeometrySubpass::get_pixels_per_unit() const
+{
+	// Pixels covered by a unit length at a unit distance, whichever way the projection is rotated
+	const auto &projection = render_packet->get_projection();
+
+	return glm::length(glm::vec2{projection[1][0], projection[1][1]}) * 0.5f *
+	       render_context.get_active_frame().get_render_target().get_extent().height;
+}
+
+uint32_t GeometrySubpass::get_lod(const sg::Node &node, const sg::SubMesh &sub_mesh) const
+{
+	auto it = lod_levels.find(std::make_pair(&node, &sub_mesh));
+
+	return it != lod_levels.end() ? it->second : 0;
+}
+
+void GeometrySubpass::draw_submesh_lod(CommandBuffer &command_buffer, sg::SubMesh &sub_mesh, VkFrontFace front_face, const sg::LevelOfDetail &lod)
+{
+	if (prepare_submesh_draw(command_buffer, sub_mesh, get_shader_variant(sub_mesh), front_face))
+	{
+		auto index_buffer = sub_mesh.get_index_buffer();
+		command_buffer.bind_index_buffer(*index_buffer.buffer, index_buffer.offset + sub_mesh.index_offset, sub_mesh.index_type);
+
+		command_buffer.draw_indexed(lod.index_count, 1, lod.first_index, 0, 0);
+	}
+}
+
+void GeometrySubpass::prepare_meshlet_rendering()
+{
+	meshlet_shader_variants.clear();
+
+	if (!render_context.get_device().is_enabled(VK_NV_MESH_SHADER_EXTENSION_NAME))
+	{
+		LOGW("Meshlet rendering needs {}, sub meshes are drawn with vertex shaders", VK_NV_MESH_SHADER_EXTENSION_NAME);
+		return;
+	}
+
+	// The mesh shader reads tightly packed float attributes
+	auto has_attribute = [](const sg::SubMesh &sub_mesh, const std::string &name, VkFormat format, uint32_t stride) {
+		sg::VertexAttribute attribute;
+
+		return sub_mesh.get_vertex_buffer(name).buffer && sub_mesh.get_attribute(name, attribute) &&
+		       attribute.format == format && attribute.stride == stride && attribute.offset == 0;
+	};
+
+	for (auto &mesh : meshes)
+	{
+		for (auto &sub_mesh : mesh->get_submeshes())
+		{
+			if (sub_mesh->meshlet_count == 0 || sub_mesh->get_material()->alpha_mode == sg::AlphaMode::Blend ||
+			    !has_attribute(*sub_mesh, "position", VK_FORMAT_R32G32B32_SFLOAT, 12) ||
+			    !has_attribute(*sub_mesh, "normal", VK_FORMAT_R32G32B32_SFLOAT, 12) ||
+			    !has_attribute(*sub_mesh, "texcoord_0", VK_FORMAT_R32G32_SFLOAT, 8))
+			{
+				continue;
+			}
+
+			ShaderVariant shader_variant = get_shader_variant(*sub_mesh);
+
+			// Both faces of double sided materials are visible
+			if (!sub_mesh->get_material()->double_sided)
+			{
+				shader_variant.add_define("MESHLET_CONE_CULLING");
+			}
+
+			meshlet_shader_variants.emplace(sub_mesh, std::move(shader_variant));
+		}
+	}
+
+	if (!meshlet_shader_variants.empty() && !meshlet_task_shader)
+	{
+		meshlet_task_shader = std::make_unique<ShaderSource>("meshlet.task");
+		meshlet_mesh_shader = std::make_unique<ShaderSource>("meshlet.mesh");
+	}
+}
+
+std::vector<ShaderModule *> GeometrySubpass::request_meshlet_shader_modules(const ShaderVariant &shader_variant)
+{
+	auto &resource_cache = render_context.get_device().get_resource_cache();
+
+	if (!async_shader_compilation)
+	{
+		return {&resource_cache.request_shader_module(VK_SHADER_STAGE_TASK_BIT_NV, *meshlet_task_shader, shader_variant),
+		        &resource_cache.request_shader_module(VK_SHADER_STAGE_MESH_BIT_NV, *meshlet_mesh_shader, shader_variant),
+		        &resource_cache.request_shader_module(VK_SHADER_STAGE_FRAGMENT_BIT, get_fragment_shader(), shader_variant)};
+	}
+
+	auto task_shader_module = resource_cache.request_shader_module_async(VK_SHADER_STAGE_TASK_BIT_NV, *meshlet_task_shader, shader_variant);
+	auto mesh_shader_module = resource_cache.request_shader_module_async(VK_SHADER_STAGE_MESH_BIT_NV, *meshlet_mesh_shader, shader_variant);
+	auto frag_shader_module = resource_cache.request_shader_module_async(VK_SHADER_STAGE_FRAGMENT_BIT, get_fragment_shader(), shader_variant);
+
+	if (!task_shader_module || !mesh_shader_module || !frag_shader_module)
+	{
+		return {};
+	}
+
+	return {task_shader_module, mesh_shader_module, frag_shader_module};
+}
+
+void GeometrySubpass::draw_meshlets(CommandBuffer &command_buffer, sg::SubMesh &sub_mesh, VkFrontFace front_face)
+{
+	std::vector<ShaderModule *> shader_modules = request_meshlet_shader_modules(meshlet_shader_variants.at(&sub_mesh));
+
+	if (shader_modules.empty())
+	{
+		return;
+	}
+
+	prepare_pipeline_state(command_buffer, front_face, sub_mesh.get_material()->double_sided);
+
+	auto &pipeline_layout = prepare_pipeline_layout(command_buffer, shader_modules);
+
+	command_buffer.bind_pipeline_layout(pipeline_layout);
+
+	prepare_push_constants(command_buffer, sub_mesh);
+
+	bind_material_textures(command_buffer, pipeline_layout, sub_mesh);
+
+	// The mesh shader fetches its vertices from storage buffers
+	command_buffer.set_vertex_input_state({});
+
+	// The vertex attributes may be ranges of the shared geometry buffers
+	const sg::GeometryBufferRange buffers[] = {{sub_mesh.meshlet_buffer.get(), 0, sub_mesh.meshlet_buffer->get_size()},
+	                                           {sub_mesh.meshlet_vertex_buffer.get(), 0, sub_mesh.meshlet_vertex_buffer->get_size()},
+	                                           {sub_mesh.meshlet_triangle_buffer.get(), 0, sub_mesh.meshlet_triangle_buffer->get_size()},
+	                                           sub_mesh.get_vertex_buffer("position"),
+	                                           sub_mesh.get_vertex_buffer("normal"),
+	                                           sub_mesh.get_vertex_buffer("texcoord_0")};
+
+	for (uint32_t i = 0; i < 6; ++i)
+	{
+		command_buffer.bind_buffer(*buffers[i].buffer, buffers[i].offset, buffers[i].size, 0, MESHLET_BINDING + i, 0);
+	}
+
+	command_buffer.draw_mesh_tasks((sub_mesh.meshlet_count + MESHLET_TASK_GROUP_SIZE - 1) / MESHLET_TASK_GROUP_SIZE, 0);
+}
+
+std::vector<ShaderModule *> GeometrySubpass::request_shader_modules(const ShaderVariant &shader_variant)
+{
+	auto &resource_cache = render_context.get_device().get_resource_cache();
+
+	if (!async_shader_compilation)
+	{
+		return {&resource_cache.request_shader_module(VK_SHADER_STAGE_VERTEX_BIT, get_vertex_shader(), shader_variant),
+		        &resource_cache.request_shader_module(VK_SHADER_STAGE_FRAGMENT_BIT, get_fragment_shader(), shader_variant)};
+	}
+
+	// Request both stages so they compile in parallel
+	auto vert_shader_module = resource_cache.request_shader_module_async(VK_SHADER_STAGE_VERTEX_BIT, get_vertex_shader(), shader_variant);
+	auto frag_shader_module = resource_cache.request_shader_module_async(VK_SHADER_STAGE_FRAGMENT_BIT, get_fragment_shader(), shader_variant);
+
+	if (!vert_shader_module || !frag_shader_module)
+	{
+		return {};
+	}
+
+	return {vert_shader_module, frag_shader_module};
+}
+
+void GeometrySubpass::get_sorted_nodes(std::vector<std::pair<sg::Node *, sg::SubMesh *>> &opaque_nodes, std::vector<std::pair<sg::Node *, sg::SubMesh *>> &transparent_nodes)
+{
+	const auto &draws = request_render_packet().get_draws();
+
+	sort_entries.clear();
+	sort_nodes.clear();
+
+	for (auto &draw : draws)
+	{
+		// Hidden instances keep their node, so that sort nodes still match the draws
+		if (occlusion_culling && is_occluded(*draw.node, *draw.mesh))
+		{
+			sort_nodes.push_back({sort_entries.size(), 0});
+			continue;
+		}
+
+		sort_nodes.push_back({sort_entries.size(), 0});
+
+		for (auto &sub_mesh : draw.mesh->get_submeshes())
+		{
+			bool transparent = sub_mesh->get_material()->alpha_mode == sg::AlphaMode::Blend;
+
+			// Entries are pushed for the draws of the subpass only, they are not sorted otherwise
+			if ((transparent && transparency_mode == TransparencyMode::Excluded) ||
+			    (!transparent && transparency_mode == TransparencyMode::WeightedBlended))
+			{
+				continue;
+			}
+
+			auto material_it = sort_material_indices.emplace(sub_mesh->get_material(), to_u32(sort_material_indices.size())).first;
+
+			uint64_t key = material_it->second & DRAW_SORT_MATERIAL_MASK;
+
+			if (transparent)
+			{
+				key |= DRAW_SORT_TRANSPARENT_BIT;
+			}
+			else if (draw_order != DrawOrder::FrontToBack)
+			{
+				// Until the distance is known the pipeline index is kept above the material index
+				size_t pipeline_key = get_shader_variant(*sub_mesh).get_id();
+				hash_combine(pipeline_key, sub_mesh->get_material()->double_sided);
+
+				auto pipeline_it = sort_pipeline_indices.emplace(pipeline_key, to_u32(sort_pipeline_indices.size())).first;
+
+				key |= static_cast<uint64_t>(pipeline_it->second) << 32;
+			}
+
+			sort_entries.push_back({key, draw.node, sub_mesh});
+		}
+
+		sort_nodes.back().entry_count = sort_entries.size() - sort_nodes.back().first_entry;
+	}
+
+	bool sorted_transparency = transparency_mode == TransparencyMode::Sorted;
+
+	auto compute_keys = [this, &draws, order = draw_order, sorted_transparency](size_t first_node, size_t last_node) {
+		for (size_t i = first_node; i < last_node; ++i)
+		{
+			auto &sort_node = sort_nodes[i];
+
+			float distance = draws[i].camera_distance;
+
+			// The bits of a positive float sort like the float itself
+			uint32_t distance_bits;
+			std::memcpy(&distance_bits, &distance, sizeof(distance_bits));
+
+			for (size_t j = sort_node.first_entry; j < sort_node.first_entry + sort_node.entry_count; ++j)
+			{
+				auto &entry = sort_entries[j];
+
+				if (entry.key & DRAW_SORT_TRANSPARENT_BIT)
+				{
+					// Transparent draws are sorted back-to-front, or left grouped by material when their order does not matter
+					if (sorted_transparency)
+					{
+						entry.key |= (~distance_bits & DRAW_SORT_DEPTH_MASK) << 32;
+					}
+					continue;
+				}
+
+				uint64_t pipeline_index = entry.key >> 32;
+				uint64_t material_index = entry.key & DRAW_SORT_MATERIAL_MASK;
+
+				switch (order)
+				{
+					case DrawOrder::FrontToBack:
+						entry.key |= (distance_bits & DRAW_SORT_DEPTH_MASK) << 32;
+						break;
+					case DrawOrder::ByState:
+						entry.key = ((pipeline_index & DRAW_SORT_STATE_PIPELINE_MASK) << 48) |
+						            ((material_index & DRAW_SORT_STATE_MATERIAL_MASK) << 32) |
+						            (distance_bits & DRAW_SORT_DEPTH_MASK);
+						break;
+					case DrawOrder::Hybrid:
+						// The exponent of the distance selects its power of two band
+						entry.key = (static_cast<uint64_t>(distance_bits >> 23) << 55) |
+						            ((pipeline_index & DRAW_SORT_HYBRID_PIPELINE_MASK) << 43) |
+						            ((material_index & DRAW_SORT_HYBRID_MATERIAL_MASK) << 32) |
+						            (distance_bits & DRAW_SORT_DEPTH_MASK);
+						break;
+				}
+			}
+		}
+	};
+
+	if (sort_nodes.size() < DRAW_SORT_PARALLEL_NODE_COUNT)
+	{
+		compute_keys(0, sort_nodes.size());
+	}
+	else
+	{
+		auto &job_system = JobSystem::get();
+
+		std::vector<std::future<void>> chunk_futures;
+
+		// The calling thread computes the first chunk
+		size_t chunk_count = job_system.get_thread_count() + 1;
+		size_t chunk_size  = (sort_nodes.size() + chunk_count - 1) / chunk_count;
+
+		for (size_t first_node = chunk_size; first_node < sort_nodes.size(); first_node += chunk_size)
+		{
+			size_t last_node = std::min(first_node + chunk_size, sort_nodes.size());
+
+			chunk_futures.push_back(job_system.push([&compute_keys, first_node, last_node](size_t) {
+				compute_keys(first_node, last_node);
+			},
+			                                        JobPriority::High));
+		}
+
+		compute_keys(0, std::min(chunk_size, sort_nodes.size()));
+
+		for (auto &future : chunk_futures)
+		{
+			job_system.wait(future);
+			future.get();
+		}
+	}
+
+	radix_sort_draws();
+
+	opaque_nodes.clear();
+	transparent_nodes.clear();
+
+	// Opaque draws sort before transparent ones
+	for (auto &entry : sort_entries)
+	{
+		if (entry.key & DRAW_SORT_TRANSPARENT_BIT)
+		{
+			transparent_nodes.emplace_back(entry.node, entry.sub_mesh);
+		}
+		else
+		{
+			opaque_nodes.emplace_back(entry.node, entry.sub_mesh);
+		}
+	}
+}
+
+const RenderPacket &GeometrySubpass::request_render_packet()
+{
+	render_packet = &render_context.get_active_frame().request_render_packet(scene, camera, cpu_culling);
+
+	return *render_packet;
+}
+
+void GeometrySubpass::radix_sort_draws()
+{
+	sort_scratch.resize(sort_entries.size());
+
+	std::array<size_t, 256> offsets;
+
+	// Least significant digit first, each pass is stable so the order of previous digits is kept
+	for (uint32_t shift = 0; shift < 64; shift += 8)
+	{
+		offsets.fill(0);
+
+		for (auto &entry : sort_entries)
+		{
+			offsets[(entry.key >> shift) & 0xff]++;
+		}
+
+		// Skip digits that are the same for every draw, like the top bits of small material indices
+		if (std::find(offsets.begin(), offsets.end(), sort_entries.size()) != offsets.end())
+		{
+			continue;
+		}
+
+		size_t offset = 0;
+		for (auto &count : offsets)
+		{
+			std::swap(offset, count);
+			offset += count;
+		}
+
+		for (auto &entry : sort_entries)
+		{
+			sort_scratch[offsets[(entry.key >> shift) & 0xff]++] = entry;
+		}
+
+		std::swap(sort_entries, sort_scratch);
+	}
+}
+
+void GeometrySubpass::draw(CommandBuffer &command_buffer)
+{
+	PROFILE_FUNCTION();
+
+	Timer timer;
+	timer.start();
+
+	std::vector<std::pair<sg::Node *, sg::SubMesh *>> opaque_nodes;
+	std::vector<std::pair<sg::Node *, sg::SubMesh *>> transparent_nodes;
+
+	get_sorted_nodes(opaque_nodes, transparent_nodes);
+
+	if (motion_vectors)
+	{
+		update_motion_vectors();
+	}
+
+	if (!views.empty())
+	{
+		update_multiview_uniform();
+	}
+
+	select_lods();
+
+	if (texture_residency)
+	{
+		request_texture_levels();
+	}
+
+	if (frame_uniform_array)
+	{
+		update_frame_uniform_array(opaque_nodes, transparent_nodes);
+	}
+
+	command_buffer.set_extended_dynamic_state(extended_dynamic_state);
+
+	bind_frame_resources(command_buffer);
+
+	if (!indirect_batches.empty())
+	{
+		draw_indirect_batches(command_buffer);
+	}
+
+	// Draw opaque objects in front-to-back order
+	draw_opaque_nodes(command_buffer, opaque_nodes, 0, opaque_nodes.size());
+
+	if (occlusion_culling)
+	{
+		draw_occlusion_queries(command_buffer);
+	}
+
+	// Draw transparent objects, in back-to-front order unless they are blended order-independently
+	draw_transparent_nodes(command_buffer, transparent_nodes);
+
+	if (constant_data_strategy == ConstantDataStrategy::Automatic && !constant_data_strategy_chosen)
+	{
+		measure_constant_data_strategy(timer.stop());
+	}
+}
+
+bool GeometrySubpass::is_parallel_draw_supported() const
+{
+	return true;
+}
+
+void GeometrySubpass::draw_parallel(CommandBuffer &primary_command_buffer, JobSystem &job_system)
+{
+	PROFILE_FUNCTION();
+
+	auto &render_frame = render_context.get_active_frame();
+
+	Timer timer;
+	timer.start();
+
+	std::vector<std::pair<sg::Node *, sg::SubMesh *>> opaque_nodes;
+	std::vector<std::pair<sg::Node *, sg::SubMesh *>> transparent_nodes;
+
+	get_sorted_nodes(opaque_nodes, transparent_nodes);
+
+	if (motion_vectors)
+	{
+		update_motion_vectors();
+	}
+
+	if (!views.empty())
+	{
+		update_multiview_uniform();
+	}
+
+	select_lods();
+
+	if (texture_residency)
+	{
+		request_texture_levels();
+	}
+
+	if (frame_uniform_array)
+	{
+		update_frame_uniform_array(opaque_nodes, transparent_nodes);
+	}
+
+	// Thread 0 is left to the calling thread, a render context prepared with a single thread records everything on it
+	size_t range_count = std::min({job_system.get_thread_count(), render_frame.get_thread_count() - 1,
+	                               (opaque_nodes.size() + DRAW_PARALLEL_MIN_RANGE_SIZE - 1) / DRAW_PARALLEL_MIN_RANGE_SIZE});
+	size_t range_size  = range_count > 0 ? (opaque_nodes.size() + range_count - 1) / range_count : 0;
+
+	const auto &queue = render_context.get_device().get_queue_by_role(QueueRole::Graphics);
+
+	// Command buffers are requested here, as the pools of the frame are not thread safe
+	std::vector<CommandBuffer *> secondary_command_buffers;
+	for (size_t i = 0; i <= range_count; ++i)
+	{
+		// The calling thread records the last command buffer with the resource pools of thread 0
+		size_t thread_index = i < range_count ? i + 1 : 0;
+
+		secondary_command_buffers.push_back(&render_frame.request_command_buffer(queue, primary_command_buffer.get_reset_mode(), VK_COMMAND_BUFFER_LEVEL_SECONDARY, thread_index));
+	}
+
+	std::vector<std::future<void>> range_futures;
+
+	for (size_t i = 0; i < range_count; ++i)
+	{
+		size_t first_node = i * range_size;
+		size_t last_node  = std::min(first_node + range_size, opaque_nodes.size());
+
+		range_futures.push_back(job_system.push([this, &primary_command_buffer, &secondary_command_buffers, &opaque_nodes, i, first_node, last_node](size_t) {
+			auto &command_buffer = *secondary_command_buffers[i];
+
+			begin_secondary_command_buffer(command_buffer, primary_command_buffer);
+
+			bind_frame_resources(command_buffer);
+
+			draw_opaque_nodes(command_buffer, opaque_nodes, first_node, last_node, i + 1);
+
+			command_buffer.end();
+		},
+		                                        JobPriority::High));
+	}
+
+	auto &command_buffer = *secondary_command_buffers.back();
+
+	begin_secondary_command_buffer(command_buffer, primary_command_buffer);
+
+	bind_frame_resources(command_buffer);
+
+	if (!indirect_batches.empty())
+	{
+		draw_indirect_batches(command_buffer);
+	}
+
+	// The opaque command buffers are executed first, so the bounds are tested against all the opaque draws
+	if (occlusion_culling)
+	{
+		draw_occlusion_queries(command_buffer);
+	}
+
+	draw_transparent_nodes(command_buffer, transparent_nodes);
+
+	command_buffer.end();
+
+	for (auto &future : range_futures)
+	{
+		job_system.wait(future);
+		future.get();
+	}
+
+	primary_command_buffer.execute_commands(secondary_command_buffers);
+
+	if (constant_data_strategy == ConstantDataStrategy::Automatic && !constant_data_strategy_chosen)
+	{
+		measure_constant_data_strategy(timer.stop());
+	}
+}
+
+void GeometrySubpass::bind_frame_resources(CommandBuffer &command_buffer)
+{
+	if (bindless_textures)
+	{
+		bind_bindless_textures(command_buffer);
+	}
+
+	if (material_table)
+	{
+		command_buffer.bind_buffer(*material_table_buffer, 0, material_table_buffer->get_size(), 0, MATERIAL_TABLE_BINDING, 0);
+	}
+
+	if (!views.empty())
+	{
+		command_buffer.bind_buffer(multiview_allocation.get_buffer(), multiview_allocation.get_offset(), multiview_allocation.get_size(), 0, MULTIVIEW_BINDING, 0);
+	}
+}
+
+void GeometrySubpass::draw_opaque_nodes(CommandBuffer &command_buffer, const std::vector<std::pair<sg::Node *, sg::SubMesh *>> &nodes, size_t first_node, size_t last_node, size_t thread_index)
+{
+	if (!instanced_shader_variants.empty())
+	{
+		draw_instanced_nodes(command_buffer, nodes, first_node, last_node, thread_index);
+		return;
+	}
+
+	for (size_t i = first_node; i < last_node; ++i)
+	{
+		auto &node = nodes[i];
+
+		if (indirect_sub_meshes.count(node.second))
+		{
+			continue;
+		}
+
+		// Invert the front face if the mesh was flipped
+		const auto &scale      = node.first->get_transform().get_scale();
+		bool        flipped    = scale.x * scale.y * scale.z < 0;
+		VkFrontFace front_face = flipped ? VK_FRONT_FACE_CLOCKWISE : VK_FRONT_FACE_COUNTER_CLOCKWISE;
+
+		draw_opaque_node(command_buffer, *node.first, *node.second, front_face, thread_index);
+	}
+}
+
+void GeometrySubpass::draw_opaque_node(CommandBuffer &command_buffer, sg::Node &node, sg::SubMesh &sub_mesh, VkFrontFace front_face, size_t thread_index)
+{
+	update_uniform(command_buffer, node, thread_index);
+
+	if (meshlet_shader_variants.count(&sub_mesh))
+	{
+		draw_meshlets(command_buffer, sub_mesh, front_face);
+		return;
+	}
+
+	if (auto lod = get_lod(node, sub_mesh))
+	{
+		draw_submesh_lod(command_buffer, sub_mesh, front_face, sub_mesh.lods[lod - 1]);
+		return;
+	}
+
+	draw_submesh(command_buffer, sub_mesh, front_face);
+}
+
+void GeometrySubpass::draw_instanced_nodes(CommandBuffer &command_buffer, const std::vector<std::pair<sg::Node *, sg::SubMesh *>> &nodes, size_t first_node, size_t last_node, size_t thread_index)
+{
+	struct InstanceGroup
+	{
+		sg::SubMesh *sub_mesh;
+
+		VkFrontFace front_face;
+
+		std::vector<sg::Node *> nodes;
+	};
+
+	// Groups keep the order of their nearest node
+	std::vector<InstanceGroup>         groups;
+	std::unordered_map<size_t, size_t> group_indices;
+
+	for (size_t i = first_node; i < last_node; ++i)
+	{
+		auto &node = nodes[i];
+
+		if (indirect_sub_meshes.count(node.second))
+		{
+			continue;
+		}
+
+		// Invert the front face if the mesh was flipped
+		const auto &scale      = node.first->get_transform().get_scale();
+		bool        flipped    = scale.x * scale.y * scale.z < 0;
+		VkFrontFace front_face = flipped ? VK_FRONT_FACE_CLOCKWISE : VK_FRONT_FACE_COUNTER_CLOCKWISE;
+
+		size_t group_key = std::hash<sg::SubMesh *>{}(node.second);
+		hash_combine(group_key, front_face);
+
+		auto group_it = group_indices.find(group_key);
+
+		if (group_it == group_indices.end())
+		{
+			group_it = group_indices.emplace(group_key, groups.size()).first;
+			groups.push_back({node.second, front_face, {}});
+		}
+
+		groups[group_it->second].nodes.push_back(node.first);
+	}
+
+	// Sub meshes drawn with meshlets are drawn one by one too
+	auto is_instanced = [this](const InstanceGroup &group) {
+		return group.nodes.size() > 1 && instanced_shader_variants.count(group.sub_mesh) && !meshlet_shader_variants.count(group.sub_mesh);
+	};
+
+	size_t instance_count{0};
+
+	for (auto &group : groups)
+	{
+		if (is_instanced(group))
+		{
+			instance_count += group.nodes.size();
+		}
+	}
+
+	BufferAllocation instance_allocation;
+	BufferAllocation global_allocation;
+
+	if (instance_count > 0)
+	{
+		auto &render_frame = get_render_context().get_active_frame();
+
+		instance_allocation = render_frame.allocate_buffer(VK_BUFFER_USAGE_STORAGE_BUFFER_BIT, instance_count * sizeof(glm::mat4), thread_index);
+
+		global_allocation = allocate_instanced_global_uniform(thread_index);
+	}
+
+	uint32_t first_instance{0};
+
+	for (auto &group : groups)
+	{
+		if (!is_instanced(group))
+		{
+			for (auto node : group.nodes)
+			{
+				draw_opaque_node(command_buffer, *node, *group.sub_mesh, group.front_face, thread_index);
+			}
+
+			continue;
+		}
+
+		auto variant_it = instanced_shader_variants.find(group.sub_mesh);
+
+		for (size_t i = 0; i < group.nodes.size(); ++i)
+		{
+			*instance_allocation.emplace<glm::mat4>((first_instance + i) * sizeof(glm::mat4)) = group.nodes[i]->get_transform().get_world_matrix();
+		}
+
+		// Single draws in between bind their own global uniform
+		command_buffer.bind_buffer(global_allocation.get_buffer(), global_allocation.get_offset(), global_allocation.get_size(), 0, 1, 0);
+
+		if (prepare_submesh_draw(command_buffer, *group.sub_mesh, variant_it->second, group.front_face))
+		{
+			command_buffer.bind_buffer(instance_allocation.get_buffer(), instance_allocation.get_offset(), instance_allocation.get_size(), 0, INSTANCE_MODEL_BINDING, 0);
+
+			auto &sub_mesh = *group.sub_mesh;
+
+			// The instance index selects the model matrix, starting from the first instance of the group
+			if (sub_mesh.vertex_indices != 0)
+			{
+				auto index_buffer = sub_mesh.get_index_buffer();
+				command_buffer.bind_index_buffer(*index_buffer.buffer, index_buffer.offset + sub_mesh.index_offset, sub_mesh.index_type);
+
+				command_buffer.draw_indexed(sub_mesh.vertex_indices, to_u32(group.nodes.size()), 0, 0, first_instance);
+			}
+			else
+			{
+				command_buffer.draw(sub_mesh.vertices_count, to_u32(group.nodes.size()), 0, first_instance);
+			}
+		}
+
+		first_instance += to_u32(group.nodes.size());
+	}
+
+	if (instance_count > 0)
+	{
+		instance_allocation.flush();
+	}
+}
+
+BufferAllocation GeometrySubpass::allocate_instanced_global_uniform(size_t thread_index)
+{
+	auto &render_frame = get_render_context().get_active_frame();
+
+	auto allocation = render_frame.allocate_buffer(VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT, sizeof(GlobalUniform), thread_index);
+
+	auto global_uniform                       = allocation.emplace<GlobalUniform>();
+	global_uniform->camera_view_proj          = render_packet->get_view_projection();
+	global_uniform->model                     = glm::mat4(1.0f);
+	global_uniform->camera_position           = render_packet->get_camera_position();
+	global_uniform->previous_model            = glm::mat4(1.0f);
+	global_uniform->previous_camera_view_proj = previous_view_proj;
+
+	allocation.flush();
+
+	return allocation;
+}
+
+void GeometrySubpass::draw_transparent_nodes(CommandBuffer &command_buffer, const std::vector<std::pair<sg::Node *, sg::SubMesh *>> &nodes, size_t thread_index)
+{
+	if (nodes.empty())
+	{
+		return;
+	}
+
+	ColorBlendState color_blend_state{};
+	color_blend_state.attachments.resize(get_output_attachments().size());
+
+	auto depth_stencil_state = get_depth_stencil_state();
+
+	if (transparency_mode == TransparencyMode::WeightedBlended)
+	{
+		// Colors and alphas are summed, transmittances multiplied, so that the order of the draws does not matter
+		ColorBlendAttachmentState &accumulation = color_blend_state.attachments.at(0);
+		accumulation.blend_enable           = VK_TRUE;
+		accumulation.src_color_blend_factor = VK_BLEND_FACTOR_ONE;
+		accumulation.dst_color_blend_factor = VK_BLEND_FACTOR_ONE;
+		accumulation.src_alpha_blend_factor = VK_BLEND_FACTOR_ONE;
+		accumulation.dst_alpha_blend_factor = VK_BLEND_FACTOR_ONE;
+
+		ColorBlendAttachmentState &revealage = color_blend_state.attachments.at(1);
+		revealage.blend_enable           = VK_TRUE;
+		revealage.src_color_blend_factor = VK_BLEND_FACTOR_ZERO;
+		revealage.dst_color_blend_factor = VK_BLEND_FACTOR_ONE_MINUS_SRC_COLOR;
+		revealage.src_alpha_blend_factor = VK_BLEND_FACTOR_ZERO;
+		revealage.dst_alpha_blend_factor = VK_BLEND_FACTOR_ONE_MINUS_SRC_ALPHA;
+
+		// Transparent fragments are tested against the opaque depth without hiding each other
+		depth_stencil_state.depth_write_enable = VK_FALSE;
+	}
+	else
+	{
+		// Enable alpha blending
+		ColorBlendAttachmentState &color_blend_attachment = color_blend_state.attachments.at(0);
+		color_blend_attachment.blend_enable           = VK_TRUE;
+		color_blend_attachment.src_color_blend_factor = VK_BLEND_FACTOR_SRC_ALPHA;
+		color_blend_attachment.dst_color_blend_factor = VK_BLEND_FACTOR_ONE_MINUS_SRC_ALPHA;
+		color_blend_attachment.src_alpha_blend_factor = VK_BLEND_FACTOR_ONE_MINUS_SRC_ALPHA;
+	}
+
+	command_buffer.set_color_blend_state(color_blend_state);
+
+	command_buffer.set_depth_stencil_state(depth_stencil_state);
+
+	for (auto &node : nodes)
+	{
+		update_uniform(command_buffer, *node.first, thread_index);
+
+		draw_submesh(command_buffer, *node.second);
+	}
+}
+
+void GeometrySubpass::begin_secondary_command_buffer(CommandBuffer &command_buffer, CommandBuffer &primary_command_buffer)
+{
+	command_buffer.begin(VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT | VK_COMMAND_BUFFER_USAGE_RENDER_PASS_CONTINUE_BIT, &primary_command_buffer);
+
+	command_buffer.set_extended_dynamic_state(extended_dynamic_state);
+
+	// Dynamic state is not inherited from the primary command buffer
+	const auto &extent = primary_command_buffer.get_current_render_pass().render_area;
+
+	VkViewport viewport{};
+	viewport.width    = static_cast<float>(extent.width);
+	viewport.height   = static_cast<float>(extent.height);
+	viewport.minDepth = 0.0f;
+	viewport.maxDepth = 1.0f;
+	command_buffer.set_viewport(0, {viewport});
+
+	VkRect2D scissor{};
+	scissor.extent = extent;
+	command_buffer.set_scissor(0, {scissor});
+}
+
+void GeometrySubpass::update_uniform(CommandBuffer &command_buffer, sg::Node &node, size_t thread_index)
+{
+	if (frame_uniform_array)
+	{
+		auto it = frame_uniform_offsets.find(&node);
+
+		if (it != frame_uniform_offsets.end())
+		{
+			command_buffer.bind_buffer(*it->second.first, it->second.second, sizeof(GlobalUniform), 0, 1, 0);
+			return;
+		}
+	}
+
+	auto &render_frame = get_render_context().get_active_frame();
+
+	auto &transform = node.get_transform();
+
+	auto allocation = render_frame.allocate_buffer(VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT, sizeof(GlobalUniform), thread_index);
+
+	// Write the uniform straight into the mapped buffer
+	auto global_uniform = allocation.emplace<GlobalUniform>();
+
+	// The camera matrices come from the render packet, so that recording threads do not read the camera
+	global_uniform->camera_view_proj = render_packet->get_view_projection();
+
+	global_uniform->model = transform.get_world_matrix();
+
+	global_uniform->camera_position = render_packet->get_camera_position();
+
+	global_uniform->previous_model = get_previous_model(node, global_uniform->model);
+
+	global_uniform->previous_camera_view_proj = previous_view_proj;
+
+	allocation.flush();
+
+	command_buffer.bind_buffer(allocation.get_buffer(), allocation.get_offset(), allocation.get_size(), 0, 1, 0);
+}
+
+void GeometrySubpass::draw_submesh(CommandBuffer &command_buffer, sg::SubMesh &sub_mesh, VkFrontFace front_face)
+{
+	if (prepare_submesh_draw(command_buffer, sub_mesh, get_shader_variant(sub_mesh), front_face))
+	{
+		draw_submesh_command(command_buffer, sub_mesh);
+	}
 }
 
-void GeometrySubpass::prepare()
+bool GeometrySubpass::prepare_submesh_draw(CommandBuffer &command_buffer, sg::SubMesh &sub_mesh, const ShaderVariant &shader_variant, VkFrontFace front_face)
 {
-	// Build all shader variance upfront
-	auto &device = render_context.get_device();
-	for (auto &mesh : meshes)
+	std::vector<ShaderModule *> shader_modules = request_shader_modules(shader_variant);
+
+	if (shader_modules.empty())
 	{
-		for (auto &sub_mesh : mesh->get_submeshes())
+		// Shaders are still compiling in the background
+		return false;
+	}
+
+	prepare_pipeline_state(command_buffer, front_face, sub_mesh.get_material()->double_sided);
+
+	MultisampleState multisample_state{};
+	multisample_state.rasterization_samples = sample_count;
+	command_buffer.set_multisample_state(multisample_state);
+
+	auto &pipeline_layout = prepare_pipeline_layout(command_buffer, shader_modules);
+
+	command_buffer.bind_pipeline_layout(pipeline_layout);
+
+	prepare_push_constants(command_buffer, sub_mesh);
+
+	bind_material_textures(command_buffer, pipeline_layout, sub_mesh);
+
+	if (sub_mesh.position_dequantization)
+	{
+		command_buffer.bind_buffer(*sub_mesh.position_dequantization, 0, sub_mesh.position_dequantization->get_size(), 0, POSITION_DEQUANTIZATION_BINDING, 0);
+	}
+
+	prepare_vertex_input_state(command_buffer, pipeline_layout, sub_mesh);
+
+	if (sub_mesh.has_interleaved_vertices())
+	{
+		auto vertex_buffer = sub_mesh.get_interleaved_vertex_buffer();
+
+		// Every attribute is fetched from the one binding
+		command_buffer.bind_vertex_buffers(0, {std::cref(*vertex_buffer.buffer)}, {vertex_buffer.offset});
+
+		return true;
+	}
+
+	auto vertex_input_resources = pipeline_layout.get_resources(ShaderResourceType::Input, VK_SHADER_STAGE_VERTEX_BIT);
+
+	// Find submesh vertex buffers matching the shader input attribute names
+	for (auto &input_resource : vertex_input_resources)
+	{
+		auto vertex_buffer = sub_mesh.get_vertex_buffer(input_resource.name);
+
+		if (vertex_buffer.buffer)
 		{
-			auto &variant     = sub_mesh->get_shader_variant();
-			auto &vert_module = device.get_resource_cache().request_shader_module(VK_SHADER_STAGE_VERTEX_BIT, get_vertex_shader(), variant);
-			auto &frag_module = device.get_resource_cache().request_shader_module(VK_SHADER_STAGE_FRAGMENT_BIT, get_fragment_shader(), variant);
+			std::vector<std::reference_wrapper<const core::Buffer>> buffers;
+			buffers.emplace_back(std::ref(*vertex_buffer.buffer));
+
+			// Bind vertex buffers only for the attribute locations defined
+			command_buffer.bind_vertex_buffers(input_resource.location, std::move(buffers), {vertex_buffer.offset});
 		}
 	}
+
+	return true;
 }
 
-void GeometrySubpass::get_sorted_nodes(std::multimap<float, std::pair<sg::Node *, sg::SubMesh *>> &opaque_nodes, std::multimap<float, std::pair<sg::Node *, sg::SubMesh *>> &transparent_nodes)
+void GeometrySubpass::bind_material_textures(CommandBuffer &command_buffer, PipelineLayout &pipeline_layout, sg::SubMesh &sub_mesh)
 {
-	auto camera_transform = camera.get_node()->get_transform().get_world_matrix();
+	// Materials index the bindless array instead, when the shader declares it
+	if (bindless_textures && pipeline_layout.has_descriptor_set_layout(BINDLESS_TEXTURE_SET))
+	{
+		return;
+	}
 
-	for (auto &mesh : meshes)
+	DescriptorSetLayout &descriptor_set_layout = pipeline_layout.get_descriptor_set_layout(0);
+
+	for (auto &texture : sub_mesh.get_material()->textures)
 	{
-		for (auto &node : mesh->get_nodes())
+		if (auto layout_binding = descriptor_set_layout.get_layout_binding(texture.first))
 		{
-			auto node_transform = node->get_transform().get_world_matrix();
+			command_buffer.bind_image(texture.second->get_image()->get_vk_image_view(),
+			                          texture.second->get_sampler()->vk_sampler,
+			                          0, layout_binding->binding, 0);
+		}
+	}
+}
 
-			const sg::AABB &mesh_bounds = mesh->get_bounds();
+void GeometrySubpass::update_indirect_instances()
+{
+	auto &render_frame = get_render_context().get_active_frame();
 
-			sg::AABB world_bounds{mesh_bounds.get_min(), mesh_bounds.get_max()};
-			world_bounds.transform(node_transform);
+	// Transforms and materials are the only per draw data written by the CPU every frame
+	indirect_instance_allocation = render_frame.allocate_buffer(VK_BUFFER_USAGE_STORAGE_BUFFER_BIT, indirect_instance_count * sizeof(IndirectInstance));
 
-			float distance = glm::length(glm::vec3(camera_transform[3]) - world_bounds.get_center());
+	uint32_t instance_offset{0};
 
-			for (auto &sub_mesh : mesh->get_submeshes())
+	for (auto &batch : indirect_batches)
+	{
+		for (auto &draw : batch.draws)
+		{
+			auto pbr_material = dynamic_cast<const sg::PBRMaterial *>(draw.second->get_material());
+
+			auto instance                      = indirect_instance_allocation.emplace<IndirectInstance>(instance_offset);
+			instance->model                    = draw.first->get_transform().get_world_matrix();
+			instance->base_color_factor        = pbr_material->base_color_factor;
+			instance->metallic_factor          = pbr_material->metallic_factor;
+			instance->roughness_factor         = pbr_material->roughness_factor;
+			instance->base_color_texture_index = 0;
+			instance->base_color_texture_layer = 0;
+
+			auto texture_it = pbr_material->textures.find("base_color_texture");
+
+			if (texture_it != pbr_material->textures.end())
 			{
-				if (sub_mesh->get_material()->alpha_mode == sg::AlphaMode::Blend)
-				{
-					transparent_nodes.emplace(distance, std::make_pair(node, sub_mesh));
-				}
-				else
+				auto index_it = bindless_texture_indices.find(texture_it->second);
+
+				if (index_it != bindless_texture_indices.end())
 				{
-					opaque_nodes.emplace(distance, std::make_pair(node, sub_mesh));
+					instance->base_color_texture_index = index_it->second;
+					instance->base_color_texture_layer = texture_it->second->get_array_layer();
 				}
 			}
+
+			instance_offset += sizeof(IndirectInstance);
 		}
 	}
+
+	indirect_instance_allocation.flush();
 }
 
-void GeometrySubpass::draw(CommandBuffer &command_buffer)
+void GeometrySubpass::prepare_indirect_culling()
 {
-	std::multimap<float, std::pair<sg::Node *, sg::SubMesh *>> opaque_nodes;
-	std::multimap<float, std::pair<sg::Node *, sg::SubMesh *>> transparent_nodes;
+	culled_commands.clear();
+	culled_draw_counts.clear();
+	indirect_bounds.reset();
 
-	get_sorted_nodes(opaque_nodes, transparent_nodes);
+	if (indirect_batches.empty())
+	{
+		gpu_culling = false;
+		return;
+	}
 
-	// Draw opaque objects in front-to-back order
-	for (auto node_it = opaque_nodes.begin(); node_it != opaque_nodes.end(); node_it++)
+	draw_indirect_count = render_context.get_device().is_enabled(VK_KHR_DRAW_INDIRECT_COUNT_EXTENSION_NAME);
+
+	culling_shader = ShaderSource{"indirect_culling.comp"};
+
+	// Matches DrawBounds in indirect_culling.comp
+	struct DrawBounds
 	{
-		update_uniform(command_buffer, *node_it->second.first);
+		glm::vec4 bounds_min;
+		glm::vec4 bounds_max;
+		uint32_t  batch_index;
+		uint32_t  first_command;
+		uint32_t  padding[2];
+	};
 
-		// Invert the front face if the mesh was flipped
-		const auto &scale      = node_it->second.first->get_transform().get_scale();
-		bool        flipped    = scale.x * scale.y * scale.z < 0;
-		VkFrontFace front_face = flipped ? VK_FRONT_FACE_CLOCKWISE : VK_FRONT_FACE_COUNTER_CLOCKWISE;
+	std::vector<DrawBounds> draw_bounds;
+
+	for (uint32_t batch_index = 0; batch_index < to_u32(indirect_batches.size()); ++batch_index)
+	{
+		auto &batch = indirect_batches[batch_index];
+
+		for (auto &bounds : batch.draw_bounds)
+		{
+			DrawBounds draw{};
+			draw.bounds_min    = glm::vec4(bounds.first, 1.0f);
+			draw.bounds_max    = glm::vec4(bounds.second, 1.0f);
+			draw.batch_index   = batch_index;
+			draw.first_command = to_u32(batch.command_offset / sizeof(VkDrawIndexedIndirectCommand));
 
-		draw_submesh(command_buffer, *node_it->second.second, front_face);
+			draw_bounds.push_back(draw);
+		}
 	}
 
-	// Enable alpha blending
-	ColorBlendAttachmentState color_blend_attachment{};
-	color_blend_attachment.blend_enable           = VK_TRUE;
-	color_blend_attachment.src_color_blend_factor = VK_BLEND_FACTOR_SRC_ALPHA;
-	color_blend_attachment.dst_color_blend_factor = VK_BLEND_FACTOR_ONE_MINUS_SRC_ALPHA;
-	color_blend_attachment.src_alpha_blend_factor = VK_BLEND_FACTOR_ONE_MINUS_SRC_ALPHA;
+	auto &device = render_context.get_device();
 
-	ColorBlendState color_blend_state{};
-	color_blend_state.attachments.resize(get_output_attachments().size());
-	color_blend_state.attachments[0] = color_blend_attachment;
-	command_buffer.set_color_blend_state(color_blend_state);
+	indirect_bounds = std::make_unique<core::Buffer>(device, draw_bounds.size() * sizeof(DrawBounds), VK_BUFFER_USAGE_STORAGE_BUFFER_BIT, VMA_MEMORY_USAGE_CPU_TO_GPU);
+	indirect_bounds->update(reinterpret_cast<const uint8_t *>(draw_bounds.data()), draw_bounds.size() * sizeof(DrawBounds));
+
+	for (size_t i = 0; i < render_context.get_render_frames().size(); ++i)
+	{
+		culled_commands.push_back(std::make_unique<core::Buffer>(device, indirect_commands->get_size(),
+		                                                         VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT,
+		                                                         VMA_MEMORY_USAGE_GPU_ONLY, 0));
+		culled_draw_counts.push_back(std::make_unique<core::Buffer>(device, indirect_batches.size() * sizeof(uint32_t),
+		                                                            VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+		                                                            VMA_MEMORY_USAGE_GPU_ONLY, 0));
+	}
+}
+
+void GeometrySubpass::pre_draw(CommandBuffer &command_buffer)
+{
+	// Queries are reset outside of the render pass
+	if (occlusion_culling)
+	{
+		update_occlusion_queries(command_buffer);
+	}
+
+	if (!gpu_culling || indirect_batches.empty())
+	{
+		return;
+	}
+
+	// The culling pass reads the instance data, so it is written before the render pass
+	update_indirect_instances();
+
+	auto  frame_index = render_context.get_active_frame_index();
+	auto &commands    = *culled_commands[frame_index];
+	auto &draw_counts = *culled_draw_counts[frame_index];
+	auto  draw_count  = to_u32(indirect_commands->get_size() / sizeof(VkDrawIndexedIndirectCommand));
+
+	{
+		// The commands and counts of this frame may still be read by the previous use of the frame
+		BufferMemoryBarrier barrier{};
+		barrier.src_stage_mask  = VK_PIPELINE_STAGE_DRAW_INDIRECT_BIT;
+		barrier.dst_stage_mask  = VK_PIPELINE_STAGE_TRANSFER_BIT | VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT;
+		barrier.src_access_mask = 0;
+		barrier.dst_access_mask = VK_ACCESS_TRANSFER_WRITE_BIT | VK_ACCESS_SHADER_WRITE_BIT;
 
-	command_buffer.set_depth_stencil_state(get_depth_stencil_state());
+		command_buffer.buffer_memory_barrier(commands, 0, VK_WHOLE_SIZE, barrier);
+		command_buffer.buffer_memory_barrier(draw_counts, 0, VK_WHOLE_SIZE, barrier);
+	}
 
-	// Draw transparent objects in back-to-front order
-	for (auto node_it = transparent_nodes.rbegin(); node_it != transparent_nodes.rend(); node_it++)
+	if (draw_indirect_count)
 	{
-		update_uniform(command_buffer, *node_it->second.first);
+		command_buffer.update_buffer(draw_counts, 0, std::vector<uint8_t>(to_u32(draw_counts.get_size()), 0));
 
-		draw_submesh(command_buffer, *node_it->second.second);
+		BufferMemoryBarrier barrier{};
+		barrier.src_stage_mask  = VK_PIPELINE_STAGE_TRANSFER_BIT;
+		barrier.dst_stage_mask  = VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT;
+		barrier.src_access_mask = VK_ACCESS_TRANSFER_WRITE_BIT;
+		barrier.dst_access_mask = VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT;
+
+		command_buffer.buffer_memory_barrier(draw_counts, 0, VK_WHOLE_SIZE, barrier);
 	}
+
+	auto &resource_cache  = render_context.get_device().get_resource_cache();
+	auto &shader_module   = resource_cache.request_shader_module(VK_SHADER_STAGE_COMPUTE_BIT, culling_shader);
+	auto &pipeline_layout = resource_cache.request_pipeline_layout({&shader_module});
+
+	command_buffer.bind_pipeline_layout(pipeline_layout);
+
+	command_buffer.bind_buffer(*indirect_commands, 0, indirect_commands->get_size(), 0, 0, 0);
+	command_buffer.bind_buffer(commands, 0, commands.get_size(), 0, 1, 0);
+	command_buffer.bind_buffer(draw_counts, 0, draw_counts.get_size(), 0, 2, 0);
+	command_buffer.bind_buffer(indirect_instance_allocation.get_buffer(), indirect_instance_allocation.get_offset(), indirect_instance_allocation.get_size(), 0, 3, 0);
+	command_buffer.bind_buffer(*indirect_bounds, 0, indirect_bounds->get_size(), 0, 4, 0);
+
+	// Matches CullingUniform in indirect_culling.comp
+	struct CullingUniform
+	{
+		glm::vec4 planes[6];
+		uint32_t  draw_count;
+		uint32_t  compact;
+	};
+
+	Frustum frustum;
+	frustum.update(camera.get_pre_rotation() * vkb::vulkan_style_projection(camera.get_projection()) * camera.get_view());
+
+	CullingUniform culling_uniform{};
+	std::copy(frustum.get_planes().begin(), frustum.get_planes().end(), culling_uniform.planes);
+	culling_uniform.draw_count = draw_count;
+	culling_uniform.compact    = draw_indirect_count ? 1 : 0;
+
+	command_buffer.push_constants(culling_uniform);
+
+	command_buffer.dispatch((draw_count + 63) / 64, 1, 1);
+
+	BufferMemoryBarrier barrier{};
+	barrier.src_stage_mask  = VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT;
+	barrier.dst_stage_mask  = VK_PIPELINE_STAGE_DRAW_INDIRECT_BIT;
+	barrier.src_access_mask = VK_ACCESS_SHADER_WRITE_BIT;
+	barrier.dst_access_mask = VK_ACCESS_INDIRECT_COMMAND_READ_BIT;
+
+	command_buffer.buffer_memory_barrier(commands, 0, VK_WHOLE_SIZE, barrier);
+	command_buffer.buffer_memory_barrier(draw_counts, 0, VK_WHOLE_SIZE, barrier);
+
+	culling_recorded = true;
 }
 
-void GeometrySubpass::update_uniform(CommandBuffer &command_buffer, sg::Node &node, size_t thread_index)
+void GeometrySubpass::update_occlusion_queries(CommandBuffer &command_buffer)
 {
-	GlobalUniform global_uniform;
+	auto frame_count = to_u32(render_context.get_render_frames().size());
 
-	global_uniform.camera_view_proj = camera.get_pre_rotation() * vkb::vulkan_style_projection(camera.get_projection()) * camera.get_view();
+	if (!occlusion_query_pool || occlusion_query_frames.size() != frame_count)
+	{
+		VkQueryPoolCreateInfo query_pool_info{VK_STRUCTURE_TYPE_QUERY_POOL_CREATE_INFO};
+		query_pool_info.queryType  = VK_QUERY_TYPE_OCCLUSION;
+		query_pool_info.queryCount = frame_count * MAX_OCCLUSION_QUERIES;
 
-	auto &render_frame = get_render_context().get_active_frame();
+		occlusion_query_pool = std::make_unique<QueryPool>(render_context.get_device(), query_pool_info);
 
-	auto &transform = node.get_transform();
+		occlusion_query_frames.clear();
+		occlusion_query_frames.resize(frame_count);
+	}
 
-	auto allocation = render_frame.allocate_buffer(VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT, sizeof(GlobalUniform), thread_index);
+	// Oldest frames first, so that newer results replace older ones
+	std::vector<uint32_t> pending_frames;
+	for (uint32_t i = 0; i < frame_count; ++i)
+	{
+		if (!occlusion_query_frames[i].instances.empty())
+		{
+			pending_frames.push_back(i);
+		}
+	}
 
-	global_uniform.model = transform.get_world_matrix();
+	std::sort(pending_frames.begin(), pending_frames.end(), [this](uint32_t a, uint32_t b) {
+		return occlusion_query_frames[a].frame_number < occlusion_query_frames[b].frame_number;
+	});
 
-	global_uniform.camera_position = glm::vec3(glm::inverse(camera.get_view())[3]);
+	// Samples passed by every query, followed by its availability
+	std::vector<uint64_t> results;
 
-	allocation.update(global_uniform);
+	for (auto frame_index : pending_frames)
+	{
+		auto &query_frame = occlusion_query_frames[frame_index];
+		auto  query_count = to_u32(query_frame.instances.size());
 
-	command_buffer.bind_buffer(allocation.get_buffer(), allocation.get_offset(), allocation.get_size(), 0, 1, 0);
+		results.assign(query_count * 2, 0);
+
+		// Without VK_QUERY_RESULT_WAIT_BIT this returns VK_NOT_READY, rather than waiting, while queries are pending
+		VkResult result = occlusion_query_pool->get_results(frame_index * MAX_OCCLUSION_QUERIES, query_count,
+		                                                    results.size() * sizeof(uint64_t), results.data(), 2 * sizeof(uint64_t),
+		                                                    VK_QUERY_RESULT_64_BIT | VK_QUERY_RESULT_WITH_AVAILABILITY_BIT);
+
+		if (result != VK_SUCCESS && result != VK_NOT_READY)
+		{
+			continue;
+		}
+
+		bool all_available = true;
+
+		for (uint32_t i = 0; i < query_count; ++i)
+		{
+			if (results[i * 2 + 1] == 0)
+			{
+				all_available = false;
+				continue;
+			}
+
+			auto &state = occlusion_states[query_frame.instances[i]];
+
+			if (state.frame_number <= query_frame.frame_number)
+			{
+				state.frame_number = query_frame.frame_number;
+				state.occluded     = results[i * 2] == 0;
+			}
+		}
+
+		if (all_available)
+		{
+			query_frame.instances.clear();
+		}
+	}
+
+	// The previous queries of the active frame completed before the frame was reused, so they were read above
+	auto  frame_index = render_context.get_active_frame_index();
+	auto &query_frame = occlusion_query_frames[frame_index];
+
+	query_frame.frame_number = render_context.get_frame_number();
+	query_frame.instances.clear();
+
+	command_buffer.reset_query_pool(*occlusion_query_pool, frame_index * MAX_OCCLUSION_QUERIES, MAX_OCCLUSION_QUERIES);
+
+	occlusion_queries_reset = true;
 }
 
-void GeometrySubpass::draw_submesh(CommandBuffer &command_buffer, sg::SubMesh &sub_mesh, VkFrontFace front_face)
+void GeometrySubpass::draw_occlusion_queries(CommandBuffer &command_buffer)
 {
-	auto &device = command_buffer.get_device();
+	// The subpass may be drawn without pre_draw, then no queries were reset for the frame
+	if (!occlusion_queries_reset)
+	{
+		return;
+	}
 
-	prepare_pipeline_state(command_buffer, front_face, sub_mesh.get_material()->double_sided);
+	occlusion_queries_reset = false;
+
+	auto &resource_cache     = render_context.get_device().get_resource_cache();
+	auto &vert_shader_module = resource_cache.request_shader_module(VK_SHADER_STAGE_VERTEX_BIT, occlusion_box_vertex_shader);
+	auto &frag_shader_module = resource_cache.request_shader_module(VK_SHADER_STAGE_FRAGMENT_BIT, occlusion_box_fragment_shader);
+	auto &pipeline_layout    = resource_cache.request_pipeline_layout({&vert_shader_module, &frag_shader_module});
+
+	command_buffer.bind_pipeline_layout(pipeline_layout);
+
+	// The vertex shader builds the box from the vertex index
+	command_buffer.set_vertex_input_state({});
+
+	RasterizationState rasterization_state{};
+	rasterization_state.cull_mode = VK_CULL_MODE_NONE;
+	command_buffer.set_rasterization_state(rasterization_state);
 
 	MultisampleState multisample_state{};
 	multisample_state.rasterization_samples = sample_count;
 	command_buffer.set_multisample_state(multisample_state);
 
-	auto &vert_shader_module = device.get_resource_cache().request_shader_module(VK_SHADER_STAGE_VERTEX_BIT, get_vertex_shader(), sub_mesh.get_shader_variant());
-	auto &frag_shader_module = device.get_resource_cache().request_shader_module(VK_SHADER_STAGE_FRAGMENT_BIT, get_fragment_shader(), sub_mesh.get_shader_variant());
+	// Faces of the bounds lying on the surface of their mesh count as visible
+	DepthStencilState depth_stencil_state = get_depth_stencil_state();
+	depth_stencil_state.depth_write_enable = VK_FALSE;
 
-	std::vector<ShaderModule *> shader_modules{&vert_shader_module, &frag_shader_module};
+	if (depth_stencil_state.depth_compare_op == VK_COMPARE_OP_GREATER)
+	{
+		depth_stencil_state.depth_compare_op = VK_COMPARE_OP_GREATER_OR_EQUAL;
+	}
+	else if (depth_stencil_state.depth_compare_op == VK_COMPARE_OP_LESS)
+	{
+		depth_stencil_state.depth_compare_op = VK_COMPARE_OP_LESS_OR_EQUAL;
+	}
+	command_buffer.set_depth_stencil_state(depth_stencil_state);
 
-	auto &pipeline_layout = prepare_pipeline_layout(command_buffer, shader_modules);
+	ColorBlendState color_blend_state{};
+	color_blend_state.attachments.resize(get_output_attachments().size());
+	for (auto &attachment : color_blend_state.attachments)
+	{
+		attachment.color_write_mask = 0;
+	}
+	command_buffer.set_color_blend_state(color_blend_state);
 
-	command_buffer.bind_pipeline_layout(pipeline_layout);
+	// Matches BoxUniform in occlusion_box.vert
+	struct BoxUniform
+	{
+		glm::mat4 view_proj;
+		glm::vec4 bounds_min;
+		glm::vec4 bounds_max;
+	};
 
-	prepare_push_constants(command_buffer, sub_mesh);
+	BoxUniform box_uniform{};
+	box_uniform.view_proj = render_packet->get_view_projection();
 
-	DescriptorSetLayout &descriptor_set_layout = pipeline_layout.get_descriptor_set_layout(0);
+	float near_plane = 0.0f;
+	if (auto perspective_camera = dynamic_cast<const sg::PerspectiveCamera *>(&camera))
+	{
+		near_plane = perspective_camera->get_near_plane();
+	}
 
-	for (auto &texture : sub_mesh.get_material()->textures)
+	glm::mat4 view = camera.get_view();
+
+	auto  frame_index = render_context.get_active_frame_index();
+	auto &query_frame = occlusion_query_frames[frame_index];
+
+	for (auto &draw : render_packet->get_draws())
 	{
-		if (auto layout_binding = descriptor_set_layout.get_layout_binding(texture.first))
+		bool indirect_only = std::all_of(draw.mesh->get_submeshes().begin(), draw.mesh->get_submeshes().end(), [this](const sg::SubMesh *sub_mesh) {
+			return indirect_sub_meshes.count(sub_mesh) > 0;
+		});
+
+		if (indirect_only)
 		{
-			command_buffer.bind_image(texture.second->get_image()->get_vk_image_view(),
-			                          texture.second->get_sampler()->vk_sampler,
-			                          0, layout_binding->binding, 0);
+			continue;
+		}
+
+		const sg::AABB &mesh_bounds = draw.mesh->get_bounds();
+
+		glm::mat4 world_matrix = draw.world_matrix;
+
+		sg::AABB world_bounds{mesh_bounds.get_min(), mesh_bounds.get_max()};
+		world_bounds.transform(world_matrix);
+
+		// Bounds reaching past the near plane are clipped, so their query could miss visible fragments of the instance
+		bool clipped = false;
+		for (uint32_t corner = 0; corner < 8 && !clipped; ++corner)
+		{
+			glm::vec3 position = glm::mix(world_bounds.get_min(), world_bounds.get_max(), glm::vec3(corner & 1, (corner >> 1) & 1, (corner >> 2) & 1));
+
+			clipped = -(view * glm::vec4(position, 1.0f)).z <= near_plane;
+		}
+
+		if (clipped || query_frame.instances.size() >= MAX_OCCLUSION_QUERIES)
+		{
+			// Drawn in the next frames until queried again
+			occlusion_states.erase({draw.node, draw.mesh});
+			continue;
 		}
+
+		box_uniform.bounds_min = glm::vec4(world_bounds.get_min(), 1.0f);
+		box_uniform.bounds_max = glm::vec4(world_bounds.get_max(), 1.0f);
+
+		command_buffer.push_constants(box_uniform);
+
+		uint32_t query = frame_index * MAX_OCCLUSION_QUERIES + to_u32(query_frame.instances.size());
+
+		command_buffer.begin_query(*occlusion_query_pool, query, 0);
+		command_buffer.draw(36, 1, 0, 0);
+		command_buffer.end_query(*occlusion_query_pool, query);
+
+		query_frame.instances.emplace_back(draw.node, draw.mesh);
+	}
+}
+
+bool GeometrySubpass::is_occluded(const sg::Node &node, const sg::Mesh &mesh) const
+{
+	auto it = occlusion_states.find({&node, &mesh});
+
+	if (it == occlusion_states.end() || !it->second.occluded)
+	{
+		return false;
 	}
 
+	// Results older than the frames in flight are from before the instance was last out of view
+	return it->second.frame_number + occlusion_query_frames.size() + 1 >= render_context.get_frame_number();
+}
+
+void GeometrySubpass::prepare_vertex_input_state(CommandBuffer &command_buffer, PipelineLayout &pipeline_layout, const sg::SubMesh &sub_mesh)
+{
 	auto vertex_input_resources = pipeline_layout.get_resources(ShaderResourceType::Input, VK_SHADER_STAGE_VERTEX_BIT);
 
 	VertexInputState vertex_input_state;
@@ -196,38 +2534,34 @@ void GeometrySubpass::draw_submesh(CommandBuffer &command_buffer, sg::SubMesh &s
 		}
 
 		VkVertexInputAttributeDescription vertex_attribute{};
-		vertex_attribute.binding  = input_resource.location;
+		vertex_attribute.binding  = sub_mesh.has_interleaved_vertices() ? 0 : input_resource.location;
 		vertex_attribute.format   = attribute.format;
 		vertex_attribute.location = input_resource.location;
 		vertex_attribute.offset   = attribute.offset;
 
 		vertex_input_state.attributes.push_back(vertex_attribute);
 
-		VkVertexInputBindingDescription vertex_binding{};
-		vertex_binding.binding = input_resource.location;
-		vertex_binding.stride  = attribute.stride;
+		if (!sub_mesh.has_interleaved_vertices())
+		{
+			VkVertexInputBindingDescription vertex_binding{};
+			vertex_binding.binding = input_resource.location;
+			vertex_binding.stride  = attribute.stride;
 
-		vertex_input_state.bindings.push_back(vertex_binding);
+			vertex_input_state.bindings.push_back(vertex_binding);
+		}
 	}
 
-	command_buffer.set_vertex_input_state(vertex_input_state);
-
-	// Find submesh vertex buffers matching the shader input attribute names
-	for (auto &input_resource : vertex_input_resources)
+	// Interleaved attributes share a single binding
+	if (sub_mesh.has_interleaved_vertices() && !vertex_input_state.attributes.empty())
 	{
-		const auto &buffer_iter = sub_mesh.vertex_buffers.find(input_resource.name);
-
-		if (buffer_iter != sub_mesh.vertex_buffers.end())
-		{
-			std::vector<std::reference_wrapper<const core::Buffer>> buffers;
-			buffers.emplace_back(std::ref(buffer_iter->second));
+		VkVertexInputBindingDescription vertex_binding{};
+		vertex_binding.binding = 0;
+		vertex_binding.stride  = sub_mesh.vertex_stride;
 
-			// Bind vertex buffers only for the attribute locations defined
-			command_buffer.bind_vertex_buffers(input_resource.location, std::move(buffers), {0});
-		}
+		vertex_input_state.bindings.push_back(vertex_binding);
 	}
 
-	draw_submesh_command(command_buffer, sub_mesh);
+	command_buffer.set_vertex_input_state(vertex_input_state);
 }
 
 void GeometrySubpass::prepare_pipeline_state(CommandBuffer &command_buffer, VkFrontFace front_face, bool double_sided_material)
@@ -263,19 +2597,50 @@ PipelineLayout &GeometrySubpass::prepare_pipeline_layout(CommandBuffer &command_
 
 void GeometrySubpass::prepare_push_constants(CommandBuffer &command_buffer, sg::SubMesh &sub_mesh)
 {
+	if (material_table)
+	{
+		// Materials of the sub meshes were all added to the table at prepare
+		MaterialIndexUniform material_index_uniform{material_indices.at(sub_mesh.get_material())};
+
+		command_buffer.push_constants(material_index_uniform);
+
+		return;
+	}
+
 	auto pbr_material = dynamic_cast<const sg::PBRMaterial *>(sub_mesh.get_material());
 
+	// Variants without the texture array bind textures per sub mesh, and their layout has the smaller push constant range
+	if (bindless_textures && command_buffer.get_pipeline_state().get_pipeline_layout().has_descriptor_set_layout(BINDLESS_TEXTURE_SET))
+	{
+		BindlessPBRMaterialUniform pbr_material_uniform{};
+		pbr_material_uniform.base_color_factor = pbr_material->base_color_factor;
+		pbr_material_uniform.metallic_factor   = pbr_material->metallic_factor;
+		pbr_material_uniform.roughness_factor  = pbr_material->roughness_factor;
+
+		auto texture_it = pbr_material->textures.find("base_color_texture");
+
+		if (texture_it != pbr_material->textures.end())
+		{
+			auto index_it = bindless_texture_indices.find(texture_it->second);
+
+			if (index_it != bindless_texture_indices.end())
+			{
+				pbr_material_uniform.base_color_texture_index = index_it->second;
+				pbr_material_uniform.base_color_texture_layer = texture_it->second->get_array_layer();
+			}
+		}
+
+		command_buffer.push_constants(pbr_material_uniform);
+
+		return;
+	}
+
 	PBRMaterialUniform pbr_material_uniform{};
 	pbr_material_uniform.base_color_factor = pbr_material->base_color_factor;
 	pbr_material_uniform.metallic_factor   = pbr_material->metallic_factor;
 	pbr_material_uniform.roughness_factor  = pbr_material->roughness_factor;
 
-	auto data = to_bytes(pbr_material_uniform);
-
-	if (!data.empty())
-	{
-		command_buffer.push_constants(data);
-	}
+	command_buffer.push_constants(pbr_material_uniform);
 }
 
 void GeometrySubpass::draw_submesh_command(CommandBuffer &command_buffer, sg::SubMesh &sub_mesh)
@@ -284,7 +2649,8 @@ void GeometrySubpass::draw_submesh_command(CommandBuffer &command_buffer, sg::Su
 	if (sub_mesh.vertex_indices != 0)
 	{
 		// Bind index buffer of submesh
-		command_buffer.bind_index_buffer(*sub_mesh.index_buffer, sub_mesh.index_offset, sub_mesh.index_type);
+		auto index_buffer = sub_mesh.get_index_buffer();
+		command_buffer.bind_index_buffer(*index_buffer.buffer, index_buffer.offset + sub_mesh.index_offset, sub_mesh.index_type);
 
 		// Draw submesh using indexed data
 		command_buffer.draw_indexed(sub_mesh.vertex_indices, 1, 0, 0, 0);
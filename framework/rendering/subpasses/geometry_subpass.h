@@ -23,17 +23,27 @@ VKBP_DISABLE_WARNINGS()
 #include "common/glm_common.h"
 VKBP_ENABLE_WARNINGS()
 
+#include <map>
+#include <unordered_set>
+
+#include "core/buffer.h"
+#include "core/query_pool.h"
 #include "rendering/subpass.h"
 
 namespace vkb
 {
+class TextureResidency;
+
 namespace sg
 {
 class Scene;
 class Node;
+class Material;
 class Mesh;
 class SubMesh;
+struct LevelOfDetail;
 class Camera;
+class Texture;
 }        // namespace sg
 
 /**
@@ -46,6 +56,12 @@ struct alignas(16) GlobalUniform
 	glm::mat4 camera_view_proj;
 
 	glm::vec3 camera_position;
+
+	/// Model matrix of the node in the previous frame, read by shaders writing motion vectors
+	alignas(16) glm::mat4 previous_model;
+
+	/// View projection of the previous frame, read by shaders writing motion vectors
+	glm::mat4 previous_camera_view_proj;
 };
 
 /**
@@ -60,6 +76,129 @@ struct PBRMaterialUniform
 	float roughness_factor;
 };
 
+/**
+ * @brief PBR material uniform for base shader with bindless textures
+ */
+struct BindlessPBRMaterialUniform
+{
+	glm::vec4 base_color_factor;
+
+	float metallic_factor;
+
+	float roughness_factor;
+
+	uint32_t base_color_texture_index;
+
+	/// Layer of the base color texture, for images packed into texture arrays
+	uint32_t base_color_texture_layer;
+};
+
+/// Most views a geometry subpass draws with VK_KHR_multiview
+constexpr uint32_t MAX_VIEW_COUNT = 6;
+
+/**
+ * @brief Cameras of the views drawn with VK_KHR_multiview for base shader, selected through the view index
+ */
+struct alignas(16) MultiviewUniform
+{
+	glm::mat4 view_proj[MAX_VIEW_COUNT];
+
+	/// Positions of the cameras, w is unused
+	glm::vec4 camera_position[MAX_VIEW_COUNT];
+};
+
+/**
+ * @brief Factors of a PBR material in the material table, std430 layout
+ */
+struct MaterialTableEntry
+{
+	glm::vec4 base_color_factor;
+
+	float metallic_factor;
+
+	float roughness_factor;
+
+	/// Index of the base color texture in the bindless array, 0 without bindless textures
+	uint32_t base_color_texture_index;
+
+	/// Layer of the base color texture, for images packed into texture arrays
+	uint32_t base_color_texture_layer;
+};
+
+/**
+ * @brief Push constants of a draw reading its material from the material table
+ */
+struct MaterialIndexUniform
+{
+	uint32_t material_index;
+};
+
+/**
+ * @brief Per draw data of indirect drawing for base shader, read through the instance index
+ */
+struct alignas(16) IndirectInstance
+{
+	glm::mat4 model;
+
+	glm::vec4 base_color_factor;
+
+	float metallic_factor;
+
+	float roughness_factor;
+
+	uint32_t base_color_texture_index;
+
+	uint32_t base_color_texture_layer;
+};
+
+/**
+ * @brief Order of the opaque draws of a geometry subpass, transparent draws follow the TransparencyMode
+ */
+enum class DrawOrder
+{
+	/// Nearest draws first to reduce overdraw, grouped by material at equal distance
+	FrontToBack,
+
+	/// Draws grouped by pipeline then material to reduce state changes, front-to-back within a group
+	ByState,
+
+	/// Draws grouped by power of two distance bands, then by pipeline and material within a band
+	Hybrid,
+};
+
+/**
+ * @brief How a geometry subpass draws the sub meshes with blended materials
+ */
+enum class TransparencyMode
+{
+	/// Sorted back-to-front on the CPU every frame and blended over the opaque draws, in the same subpass
+	Sorted,
+
+	/// Left out, so that a following subpass in weighted blended mode draws them
+	Excluded,
+
+	/// Only the transparent draws, in any order, accumulated into two output attachments for a TransparencyResolveSubpass
+	WeightedBlended,
+};
+
+/**
+ * @brief How the global uniform of every draw of a geometry subpass is bound
+ */
+enum class ConstantDataStrategy
+{
+	/// Measures the recording time of the strategies the device supports on the first frames, then keeps the fastest
+	Automatic,
+
+	/// A descriptor set written for every draw
+	DescriptorSets,
+
+	/// A descriptor set shared by the draws, which select their uniform with a dynamic offset
+	DynamicDescriptorSets,
+
+	/// Descriptors of set 0 written into the command buffer with VK_KHR_push_descriptor
+	PushDescriptors,
+};
+
 /**
  * @brief This subpass is responsible for rendering a Scene
  */
@@ -85,7 +224,402 @@ class GeometrySubpass : public Subpass
 	 */
 	virtual void draw(CommandBuffer &command_buffer) override;
 
+	virtual bool is_parallel_draw_supported() const override;
+
+	/**
+	 * @brief Record draw commands, with the opaque draws split across secondary command buffers recorded in parallel
+	 *
+	 * Every secondary command buffer covers the whole render area. The indirect and transparent draws
+	 * are recorded by the calling thread in the last secondary command buffer, to keep their order.
+	 */
+	virtual void draw_parallel(CommandBuffer &primary_command_buffer, JobSystem &job_system) override;
+
+	/**
+	 * @brief Compiles shader variants in the background instead of stalling the frame
+	 *        that first needs them. Sub meshes are skipped until their shaders are ready.
+	 */
+	void set_async_shader_compilation(bool enable);
+
+	/**
+	 * @brief Binds all the scene textures once as an array, with materials selecting theirs through
+	 *        push constants, instead of binding the textures of every sub mesh
+	 *
+	 * It must be set before prepare. The fragment shader needs to declare the array when
+	 * BINDLESS_TEXTURE_COUNT is defined, as base.frag does, and the device needs the
+	 * shaderSampledImageArrayDynamicIndexing feature enabled. Otherwise textures are bound per sub mesh.
+	 */
+	void set_bindless_textures(bool enable);
+
+	/**
+	 * @brief Packs the factors of the materials drawn by the subpass into one storage buffer at
+	 *        prepare, uploaded once, so that draws only push the index of their material
+	 *
+	 * It must be set before prepare. The fragment shader needs to read the table when
+	 * MATERIAL_TABLE is defined, as base.frag and deferred/geometry.frag do.
+	 */
+	void set_material_table(bool enable);
+
+	/**
+	 * @brief Draws opaque indexed sub meshes with one indirect draw per pipeline, from vertex and
+	 *        index data merged at prepare time, so that recording cost does not grow with the scene
+	 *
+	 * It must be set before prepare. The shaders need to read the per draw IndirectInstance when
+	 * INDIRECT_DRAWING is defined, as base.vert and base.frag do, and the device needs the
+	 * drawIndirectFirstInstance feature enabled. Textured sub meshes also need bindless textures
+	 * with shaderSampledImageArrayNonUniformIndexing. Other sub meshes are drawn one by one.
+	 */
+	void set_indirect_drawing(bool enable);
+
+	/**
+	 * @brief Culls the draws of the indirect batches against the camera frustum in a compute pass
+	 *        recorded by pre_draw, so that the CPU does not test them
+	 *
+	 * It needs indirect drawing. With VK_KHR_draw_indirect_count enabled visible draws are compacted
+	 * and counted on the GPU, otherwise culled draws are left in place with no instance.
+	 */
+	void set_gpu_culling(bool enable);
+
+	/**
+	 * @brief Skips the mesh instances outside of the camera frustum when sorting the draws,
+	 *        querying the bounding volume hierarchy of the scene
+	 */
+	void set_cpu_culling(bool enable);
+
+	/**
+	 * @brief Draws opaque sub meshes with meshlets through task and mesh shaders, culling every meshlet
+	 *        against the camera frustum and its normal cone in the task shader
+	 *
+	 * It must be set before prepare and needs VK_NV_mesh_shader enabled with its task and mesh shader
+	 * features. Sub meshes need meshlets built by the loader and float positions, normals and texture
+	 * coordinates in vertex buffers with storage usage. Other sub meshes, and every sub mesh on devices
+	 * without mesh shaders, are drawn by the other paths, culled per draw by GPU culling if enabled.
+	 */
+	void set_meshlet_rendering(bool enable);
+
+	/**
+	 * @brief Draws a coarser level of detail of a sub mesh when its simplification error, projected on the
+	 *        render target from the bounds of its node, stays below a number of pixels
+	 *
+	 * A node only switches to a coarser level once its error is well below the limit, so that nodes
+	 * around the limit do not alternate between levels. Sub meshes get levels of detail from
+	 * MeshOptimizationOptions::lod_count. Indirect, instanced and meshlet draws keep the full sub meshes.
+	 * @param pixel_error Largest projected error in pixels, 0 to always draw the full sub meshes
+	 */
+	void set_lod_pixel_error(float pixel_error);
+
+	/**
+	 * @brief Skips the mesh instances whose world bounds were hidden behind the opaque draws of a previous frame
+	 *
+	 * After the opaque draws, the bounds of every mesh instance are drawn within an occlusion query, without
+	 * writing depth or color. pre_draw reads the results once they are available instead of waiting for them,
+	 * so an instance coming into view may appear a frame or more late. Instances whose bounds reach the near
+	 * plane are always drawn. The sub meshes drawn by the indirect batches are not affected.
+	 */
+	void set_occlusion_culling(bool enable);
+
+	/**
+	 * @brief Requests from a residency manager the mip levels of the textures of every draw, from the number of
+	 *        pixels the bounds of its node cover on the render target, assuming that a texture covers them once
+	 * @param residency Manager of the scene images, or nullptr
+	 */
+	void set_texture_residency(TextureResidency *residency);
+
+	/**
+	 * @brief Occlusion queries of a frame, further mesh instances are drawn without one
+	 */
+	static constexpr uint32_t MAX_OCCLUSION_QUERIES = 4096;
+
+	/**
+	 * @brief Records the culling pass of the indirect batches, if GPU culling is enabled,
+	 *        and reads the occlusion queries of previous frames, if occlusion culling is enabled
+	 */
+	virtual void pre_draw(CommandBuffer &command_buffer) override;
+
+	/**
+	 * @brief Descriptor set of the bindless texture array
+	 */
+	static constexpr uint32_t BINDLESS_TEXTURE_SET = 1;
+
+	/**
+	 * @brief Binding of the indirect instance buffer in descriptor set 0
+	 */
+	static constexpr uint32_t INDIRECT_INSTANCE_BINDING = 3;
+
+	/**
+	 * @brief Binding of the material table in descriptor set 0
+	 */
+	static constexpr uint32_t MATERIAL_TABLE_BINDING = 10;
+
+	/**
+	 * @brief Binding of the position dequantization uniform of sub meshes with quantized positions in descriptor set 0
+	 */
+	static constexpr uint32_t POSITION_DEQUANTIZATION_BINDING = 11;
+
+	/**
+	 * @brief First binding of the meshlet buffers in descriptor set 0, followed by the meshlet vertices,
+	 *        the meshlet triangles, then the positions, normals and texture coordinates
+	 */
+	static constexpr uint32_t MESHLET_BINDING = 12;
+
+	/**
+	 * @brief Meshlets culled by a task shader workgroup
+	 */
+	static constexpr uint32_t MESHLET_TASK_GROUP_SIZE = 32;
+
+	/**
+	 * @brief Draws the opaque nodes sharing a sub mesh and a front face with a single instanced draw
+	 *
+	 * Model matrices are read from a per frame storage buffer, so update_uniform is not called
+	 * for instanced nodes. The shaders need to read them through the instance index when
+	 * INSTANCED_DRAWING is defined, as base.vert does. Sub meshes drawn once, and the ones drawn
+	 * with meshlets, are still drawn one by one with their level of detail. Instanced draws use
+	 * the full sub meshes.
+	 */
+	void set_automatic_instancing(bool enable);
+
+	/**
+	 * @brief Binding of the instance model matrices in descriptor set 0, shaders use either them or the indirect instances
+	 */
+	static constexpr uint32_t INSTANCE_MODEL_BINDING = 3;
+
+	/**
+	 * @brief Selects how opaque draws are sorted, trading overdraw against pipeline and descriptor set binds
+	 *
+	 * The binds recorded by a frame are reported by the pipeline_binds to descriptor_set_binds stats.
+	 */
+	void set_draw_order(DrawOrder order);
+
+	/**
+	 * @brief Selects how transparent sub meshes are drawn
+	 *
+	 * It must be set before prepare. In weighted blended mode the subpass draws no opaque sub meshes, and the paths
+	 * drawing only opaque ones, such as indirect drawing, are disabled. Its output attachments are the accumulation and
+	 * the revealage created by TransparencyResolveSubpass::get_create_func, and the fragment shader writes them when
+	 * WEIGHTED_BLENDED_OIT is defined, as base.frag does. The draws are grouped by material, with no sort by distance.
+	 */
+	void set_transparency_mode(TransparencyMode mode);
+
+	/**
+	 * @brief Sets the cull mode, the front face and the depth stencil state of draws with dynamic state,
+	 *        so that materials differing only by them share pipelines
+	 *
+	 * It has no effect unless the device enabled VK_EXT_extended_dynamic_state.
+	 */
+	void set_extended_dynamic_state(bool enable);
+
+	/**
+	 * @brief Selects how update_uniform binds the global uniform, through the resource mode of GlobalUniform
+	 *
+	 * Push descriptors need VK_KHR_push_descriptor enabled, the automatic strategy only measures them then
+	 * and without bindless textures. Subpasses overriding update_uniform or prepare_pipeline_layout may ignore it.
+	 */
+	void set_constant_data_strategy(ConstantDataStrategy strategy);
+
+	/**
+	 * @return The strategy used by the draws, which the automatic strategy changes while measuring
+	 */
+	ConstantDataStrategy get_constant_data_strategy() const;
+
+	/**
+	 * @brief Writes the global uniforms of all the nodes of the frame contiguously before recording,
+	 *        so that update_uniform only binds an offset into them instead of allocating one per draw
+	 *
+	 * Uniforms are aligned to minUniformBufferOffsetAlignment and written in parallel. With the dynamic
+	 * descriptor sets strategy, draws share one descriptor set and only change its dynamic offset.
+	 * Subpasses overriding update_uniform do not read them.
+	 */
+	void set_frame_uniform_array(bool enable);
+
+	/**
+	 * @brief Writes the screen space motion of every pixel since the previous frame to the output attachment
+	 *        following the others, from the current and previous model and view projection matrices
+	 *
+	 * It must be set before prepare. The shaders need to write the motion, in texture coordinates, when
+	 * MOTION_VECTORS is defined, as deferred/geometry.vert and deferred/geometry.frag do. Nodes missing
+	 * from the previous frame, and the draws reading their model matrices from a buffer, only get the
+	 * motion of the camera.
+	 */
+	void set_motion_vectors(bool enable);
+
+	/**
+	 * @brief Draws the scene from several cameras in a single pass with VK_KHR_multiview, view i rendering to layer i of the attachments
+	 *
+	 * It must be set before prepare, and the render target images need a layer per view. Every draw is recorded
+	 * once and the shaders read the camera of their view from the multiview uniform when MULTIVIEW is defined,
+	 * as base.vert and base.frag do. Culling and sorting still use the camera of the subpass, which should see
+	 * everything the views see. Meshlets, occlusion culling and motion vectors are disabled with multiview.
+	 * @param views Cameras of the views, at most MAX_VIEW_COUNT, or empty to only draw the camera of the subpass
+	 */
+	void set_views(const std::vector<sg::Camera *> &views);
+
+	/**
+	 * @brief Binding of the multiview uniform in descriptor set 0
+	 */
+	static constexpr uint32_t MULTIVIEW_BINDING = 21;
+
   protected:
+	/**
+	 * @brief Requests the vertex and fragment shader modules for a variant
+	 * @return The shader modules, or an empty vector if they are still being compiled in the background
+	 */
+	std::vector<ShaderModule *> request_shader_modules(const ShaderVariant &shader_variant);
+
+	/**
+	 * @return The shader variant to draw a sub mesh with, which selects bindless textures if they are enabled
+	 */
+	const ShaderVariant &get_shader_variant(const sg::SubMesh &sub_mesh) const;
+
+	/**
+	 * @brief Collects the scene textures and builds the bindless shader variants,
+	 *        disabling bindless textures if the device does not support them
+	 */
+	void prepare_bindless_textures();
+
+	/**
+	 * @brief Writes the factors of the materials of the sub meshes to the material table
+	 *        and builds the shader variants reading it
+	 */
+	void prepare_material_table();
+
+	/**
+	 * @brief Binds the scene textures to the bindless texture array
+	 */
+	void bind_bindless_textures(CommandBuffer &command_buffer);
+
+	/**
+	 * @brief Groups the eligible sub meshes into indirect batches and merges their geometry
+	 */
+	void prepare_indirect_batches();
+
+	/**
+	 * @brief Writes the per draw data of the frame and records the indirect draws of all batches
+	 */
+	void draw_indirect_batches(CommandBuffer &command_buffer);
+
+	/**
+	 * @brief Writes the transforms and materials of the indirect draws for the current frame
+	 */
+	void update_indirect_instances();
+
+	/**
+	 * @brief Creates the bounds of the indirect draws read by the culling pass
+	 */
+	void prepare_indirect_culling();
+
+	/**
+	 * @brief Selects the sub meshes drawn with task and mesh shaders
+	 */
+	void prepare_meshlet_rendering();
+
+	/**
+	 * @brief Requests the task, mesh and fragment shaders of a meshlet shader variant
+	 * @return Empty if the shaders are still being compiled in the background
+	 */
+	std::vector<ShaderModule *> request_meshlet_shader_modules(const ShaderVariant &shader_variant);
+
+	/**
+	 * @brief Draws the meshlets of a sub mesh, after the uniform of its node was bound
+	 */
+	void draw_meshlets(CommandBuffer &command_buffer, sg::SubMesh &sub_mesh, VkFrontFace front_face);
+
+	/**
+	 * @brief Binds the material textures of a sub mesh, unless the shaders read the bindless array
+	 */
+	void bind_material_textures(CommandBuffer &command_buffer, PipelineLayout &pipeline_layout, sg::SubMesh &sub_mesh);
+
+	/**
+	 * @brief Selects the level of detail of the sub meshes of every draw of the render packet
+	 *        It is called before recording, the draws only read the selected levels.
+	 */
+	void select_lods();
+
+	/**
+	 * @brief Requests the mip levels the textures of the draws of the render packet need from the residency manager
+	 */
+	void request_texture_levels();
+
+	/**
+	 * @return Pixels of the render target covered by a unit length at a unit distance from the camera
+	 */
+	float get_pixels_per_unit() const;
+
+	/**
+	 * @return The level of detail selected for a sub mesh of a node, 0 for the full sub mesh
+	 */
+	uint32_t get_lod(const sg::Node &node, const sg::SubMesh &sub_mesh) const;
+
+	/**
+	 * @brief Draws a coarser level of detail of a sub mesh
+	 */
+	void draw_submesh_lod(CommandBuffer &command_buffer, sg::SubMesh &sub_mesh, VkFrontFace front_face, const sg::LevelOfDetail &lod);
+
+	/**
+	 * @brief Reads the available results of the occlusion queries of previous frames,
+	 *        then resets the queries of the active frame
+	 */
+	void update_occlusion_queries(CommandBuffer &command_buffer);
+
+	/**
+	 * @brief Draws the world bounds of the mesh instances of the render packet within occlusion queries
+	 *        It is called after the opaque draws, whose depth the bounds are tested against.
+	 */
+	void draw_occlusion_queries(CommandBuffer &command_buffer);
+
+	/**
+	 * @return Whether the latest occlusion query of a mesh instance found it hidden
+	 */
+	bool is_occluded(const sg::Node &node, const sg::Mesh &mesh) const;
+
+	/**
+	 * @brief Sets the vertex input state matching the shader inputs with the attributes of a sub mesh
+	 */
+	void prepare_vertex_input_state(CommandBuffer &command_buffer, PipelineLayout &pipeline_layout, const sg::SubMesh &sub_mesh);
+
+	/**
+	 * @brief Binds the resources shared by every draw of the frame
+	 *        It is called on every command buffer recording draws of the subpass.
+	 */
+	virtual void bind_frame_resources(CommandBuffer &command_buffer);
+
+	/**
+	 * @brief Draws a range of opaque nodes, skipping the ones drawn by the indirect batches
+	 *        With automatic instancing, nodes sharing a sub mesh and a front face are drawn together.
+	 */
+	void draw_opaque_nodes(CommandBuffer &command_buffer, const std::vector<std::pair<sg::Node *, sg::SubMesh *>> &nodes, size_t first_node, size_t last_node, size_t thread_index = 0);
+
+	/**
+	 * @brief Draws the nodes of a range grouped by sub mesh and front face, with their model matrices in an instance buffer
+	 */
+	void draw_instanced_nodes(CommandBuffer &command_buffer, const std::vector<std::pair<sg::Node *, sg::SubMesh *>> &nodes, size_t first_node, size_t last_node, size_t thread_index);
+
+	/**
+	 * @brief Draws an opaque node on its own, with meshlets or at its level of detail when the sub mesh has them
+	 */
+	void draw_opaque_node(CommandBuffer &command_buffer, sg::Node &node, sg::SubMesh &sub_mesh, VkFrontFace front_face, size_t thread_index);
+
+	/**
+	 * @brief Allocates a global uniform with an identity model matrix, for draws reading their model matrix from a buffer
+	 */
+	BufferAllocation allocate_instanced_global_uniform(size_t thread_index);
+
+	/**
+	 * @brief Binds the pipeline, material and vertex buffers to draw a sub mesh with
+	 * @return False if the shaders of the variant are still being compiled in the background
+	 */
+	bool prepare_submesh_draw(CommandBuffer &command_buffer, sg::SubMesh &sub_mesh, const ShaderVariant &shader_variant, VkFrontFace front_face);
+
+	/**
+	 * @brief Enables alpha blending and draws the transparent nodes
+	 */
+	void draw_transparent_nodes(CommandBuffer &command_buffer, const std::vector<std::pair<sg::Node *, sg::SubMesh *>> &nodes, size_t thread_index = 0);
+
+	/**
+	 * @brief Begins a secondary command buffer continuing the render pass of the primary one
+	 * @param command_buffer A secondary command buffer of the active frame
+	 * @param primary_command_buffer Command buffer recording the render pass
+	 */
+	void begin_secondary_command_buffer(CommandBuffer &command_buffer, CommandBuffer &primary_command_buffer);
+
 	virtual void update_uniform(CommandBuffer &command_buffer, sg::Node &node, size_t thread_index = 0);
 
 	void draw_submesh(CommandBuffer &command_buffer, sg::SubMesh &sub_mesh, VkFrontFace front_face = VK_FRONT_FACE_COUNTER_CLOCKWISE);
@@ -101,15 +635,315 @@ class GeometrySubpass : public Subpass
 	/**
 	 * @brief Sorts objects based on distance from camera and classifies them
 	 *        into opaque and transparent in the arrays provided
+	 *
+	 * Opaque objects are returned in the order selected by set_draw_order, transparent objects are
+	 * returned back-to-front when they are sorted, and grouped by material in weighted blended mode.
+	 * Only the objects the transparency mode draws are returned. The objects come from the render packet
+	 * of the frame, which is requested here and then read by the draws.
 	 */
-	void get_sorted_nodes(std::multimap<float, std::pair<sg::Node *, sg::SubMesh *>> &opaque_nodes,
-	                      std::multimap<float, std::pair<sg::Node *, sg::SubMesh *>> &transparent_nodes);
+	void get_sorted_nodes(std::vector<std::pair<sg::Node *, sg::SubMesh *>> &opaque_nodes,
+	                      std::vector<std::pair<sg::Node *, sg::SubMesh *>> &transparent_nodes);
+
+	/**
+	 * @brief Requests the render packet of the scene seen by the camera in the active frame,
+	 *        culled to the camera frustum when CPU culling is enabled
+	 */
+	const RenderPacket &request_render_packet();
+
+	/**
+	 * @brief Sorts the draws in sort_entries by key
+	 */
+	void radix_sort_draws();
+
+	/**
+	 * @brief Writes the global uniforms of the nodes to draw into the uniform array of the frame
+	 */
+	void update_frame_uniform_array(const std::vector<std::pair<sg::Node *, sg::SubMesh *>> &opaque_nodes,
+	                                const std::vector<std::pair<sg::Node *, sg::SubMesh *>> &transparent_nodes);
+
+	/**
+	 * @brief Sets the resource mode of the global uniform for a strategy
+	 */
+	void apply_constant_data_strategy(ConstantDataStrategy strategy);
+
+	/**
+	 * @brief Accounts the recording time of a frame to the measured strategy,
+	 *        moving to the next one or keeping the fastest once it has been measured long enough
+	 */
+	void measure_constant_data_strategy(double recording_time);
+
+	/**
+	 * @brief Keeps the model matrices and the view projection of the render packet,
+	 *        moving the ones of the last frame to the previous ones
+	 */
+	void update_motion_vectors();
+
+	/**
+	 * @return The model matrix of a node in the previous frame, or its current one without motion vectors
+	 */
+	const glm::mat4 &get_previous_model(const sg::Node &node, const glm::mat4 &model) const;
+
+	/**
+	 * @brief Writes the cameras of the views into the multiview uniform of the frame
+	 */
+	void update_multiview_uniform();
 
 	sg::Camera &camera;
 
 	std::vector<sg::Mesh *> meshes;
 
 	sg::Scene &scene;
+
+	bool async_shader_compilation{false};
+
+	bool bindless_textures{false};
+
+	/// Textures bound to the bindless array, in array order
+	std::vector<sg::Texture *> bindless_texture_list;
+
+	/// Index of every texture in the bindless array
+	std::unordered_map<const sg::Texture *, uint32_t> bindless_texture_indices;
+
+	/// Shader variants of the sub meshes with the definitions of the bindless texture array and the material table
+	std::unordered_map<const sg::SubMesh *, ShaderVariant> shader_variants;
+
+	bool material_table{false};
+
+	/// Factors of all the materials drawn, indexed by material_indices
+	std::unique_ptr<core::Buffer> material_table_buffer;
+
+	/// Index of every material in the material table
+	std::unordered_map<const sg::Material *, uint32_t> material_indices;
+
+	/**
+	 * @brief Sub meshes sharing a pipeline, drawn with a single indirect draw
+	 */
+	struct IndirectBatch
+	{
+		ShaderVariant shader_variant;
+
+		/// Sub mesh the vertex attributes and material state are taken from
+		const sg::SubMesh *sub_mesh{nullptr};
+
+		VkFrontFace front_face{VK_FRONT_FACE_COUNTER_CLOCKWISE};
+
+		/// Nodes and sub meshes in draw order, the draw index is the instance index
+		std::vector<std::pair<sg::Node *, sg::SubMesh *>> draws;
+
+		/// Local bounds of the mesh of every draw
+		std::vector<std::pair<glm::vec3, glm::vec3>> draw_bounds;
+
+		/// Vertex data of all the draws, for every attribute
+		std::unordered_map<std::string, std::unique_ptr<core::Buffer>> vertex_buffers;
+
+		/// Vertex data of all the draws, when their vertices are interleaved
+		std::unique_ptr<core::Buffer> interleaved_vertex_buffer;
+
+		/// 32-bit index data of all the draws
+		std::unique_ptr<core::Buffer> index_buffer;
+
+		/// Offset of the first draw command of the batch in indirect_commands
+		VkDeviceSize command_offset{0};
+
+		/// Index of the first draw of the batch in the indirect instances
+		uint32_t first_instance{0};
+	};
+
+	bool indirect_drawing{false};
+
+	bool meshlet_rendering{false};
+
+	float lod_pixel_error{0.0f};
+
+	TextureResidency *texture_residency{nullptr};
+
+	/// Level of detail selected for every node and sub mesh, kept between frames for hysteresis
+	std::map<std::pair<const sg::Node *, const sg::SubMesh *>, uint32_t> lod_levels;
+
+	bool occlusion_culling{false};
+
+	/**
+	 * @brief Occlusion queries of a render frame, in the range of the frame in the query pool
+	 */
+	struct OcclusionQueryFrame
+	{
+		/// Frame number the queries were recorded in
+		uint64_t frame_number{0};
+
+		/// Mesh instance of every query, cleared once all their results were read
+		std::vector<std::pair<const sg::Node *, const sg::Mesh *>> instances;
+	};
+
+	/**
+	 * @brief Latest result read for a mesh instance
+	 */
+	struct OcclusionState
+	{
+		/// Frame number of the query
+		uint64_t frame_number{0};
+
+		bool occluded{false};
+	};
+
+	/// Created by pre_draw with MAX_OCCLUSION_QUERIES for every render frame
+	std::unique_ptr<QueryPool> occlusion_query_pool;
+
+	std::vector<OcclusionQueryFrame> occlusion_query_frames;
+
+	std::map<std::pair<const sg::Node *, const sg::Mesh *>, OcclusionState> occlusion_states;
+
+	/// Whether the queries of the active frame were reset by pre_draw
+	bool occlusion_queries_reset{false};
+
+	ShaderSource occlusion_box_vertex_shader;
+
+	ShaderSource occlusion_box_fragment_shader;
+
+	/// Shader variants of the sub meshes drawn with task and mesh shaders
+	std::unordered_map<const sg::SubMesh *, ShaderVariant> meshlet_shader_variants;
+
+	/// Loaded when meshlet rendering is used
+	std::unique_ptr<ShaderSource> meshlet_task_shader;
+
+	std::unique_ptr<ShaderSource> meshlet_mesh_shader;
+
+	bool automatic_instancing{false};
+
+	DrawOrder draw_order{DrawOrder::FrontToBack};
+
+	TransparencyMode transparency_mode{TransparencyMode::Sorted};
+
+	bool extended_dynamic_state{false};
+
+	/// Strategy requested, which may be automatic
+	ConstantDataStrategy constant_data_strategy{ConstantDataStrategy::DescriptorSets};
+
+	/// Strategy used by the draws
+	ConstantDataStrategy active_constant_data_strategy{ConstantDataStrategy::DescriptorSets};
+
+	/// Strategies the automatic strategy still has to measure, the active one first
+	std::vector<ConstantDataStrategy> measured_strategies;
+
+	/// Whether the automatic strategy chose its strategy
+	bool constant_data_strategy_chosen{false};
+
+	/// Frames recorded with the active strategy while measuring, including the warm-up ones
+	uint32_t measured_frame_count{0};
+
+	/// Recording time of the measured frames of the active strategy, in seconds
+	double measured_time{0.0};
+
+	/// Fastest strategy measured so far, with its average recording time per frame
+	std::pair<ConstantDataStrategy, double> fastest_strategy{ConstantDataStrategy::DescriptorSets, 0.0};
+
+	bool frame_uniform_array{false};
+
+	/// Buffer and offset of the global uniform of every node of the frame, read by update_uniform
+	std::unordered_map<const sg::Node *, std::pair<const core::Buffer *, VkDeviceSize>> frame_uniform_offsets;
+
+	/// Variants of the sub meshes reading their model matrices from the instance buffer
+	std::unordered_map<const sg::SubMesh *, ShaderVariant> instanced_shader_variants;
+
+	bool motion_vectors{false};
+
+	/// Model matrices of the nodes drawn by the previous frame
+	std::unordered_map<const sg::Node *, glm::mat4> previous_models;
+
+	/// Model matrices of the nodes drawn by the current frame
+	std::unordered_map<const sg::Node *, glm::mat4> current_models;
+
+	/// Cameras drawn with VK_KHR_multiview, empty without multiview
+	std::vector<sg::Camera *> views;
+
+	/// Cameras of the views for the current frame
+	BufferAllocation multiview_allocation;
+
+	glm::mat4 previous_view_proj{1.0f};
+
+	glm::mat4 current_view_proj{1.0f};
+
+	/// Whether a frame was drawn since prepare, otherwise the previous matrices are the current ones
+	bool motion_history{false};
+
+	/// Whether the device can issue several draws with one indirect command
+	bool multi_draw_indirect{false};
+
+	std::vector<IndirectBatch> indirect_batches;
+
+	/// Draw commands of all the batches, they only change with the scene so they are written once
+	std::unique_ptr<core::Buffer> indirect_commands;
+
+	/// Sub meshes drawn by the indirect batches, skipped when drawing one by one
+	std::unordered_set<const sg::SubMesh *> indirect_sub_meshes;
+
+	uint32_t indirect_instance_count{0};
+
+	/**
+	 * @brief A draw to sort
+	 *
+	 * The top bit of the key is set for transparent draws, followed by the distance
+	 * from the camera (inverted for transparent draws) and the material index.
+	 * Opaque draws sorted by state put the pipeline and material indices before the distance.
+	 */
+	struct DrawSortEntry
+	{
+		uint64_t key;
+
+		sg::Node *node;
+
+		sg::SubMesh *sub_mesh;
+	};
+
+	/**
+	 * @brief A draw of the render packet, whose distance gives the key of its sub mesh draws
+	 */
+	struct DrawSortNode
+	{
+		/// Range of the draws of the node in sort_entries
+		size_t first_entry;
+
+		size_t entry_count;
+	};
+
+	std::vector<DrawSortEntry> sort_entries;
+
+	std::vector<DrawSortNode> sort_nodes;
+
+	bool cpu_culling{false};
+
+	/// Render packet of the frame drawn, requested by get_sorted_nodes
+	const RenderPacket *render_packet{nullptr};
+
+	/// Scratch space of the radix sort
+	std::vector<DrawSortEntry> sort_scratch;
+
+	/// Index of every material seen, in the order they were first drawn
+	std::unordered_map<const sg::Material *, uint32_t> sort_material_indices;
+
+	/// Index of every pipeline seen, keyed by the shader variant and the culling state of the draw
+	std::unordered_map<size_t, uint32_t> sort_pipeline_indices;
+
+	/// Instance data of the indirect draws for the current frame
+	BufferAllocation indirect_instance_allocation;
+
+	bool gpu_culling{false};
+
+	/// Whether culled draws are compacted and drawn with VK_KHR_draw_indirect_count
+	bool draw_indirect_count{false};
+
+	/// Whether the culling pass was recorded for the current frame
+	bool culling_recorded{false};
+
+	ShaderSource culling_shader;
+
+	/// Local bounds, batch and first command of every indirect draw
+	std::unique_ptr<core::Buffer> indirect_bounds;
+
+	/// Culled draw commands of every render frame, since they are written by the GPU
+	std::vector<std::unique_ptr<core::Buffer>> culled_commands;
+
+	/// Visible draw count of every batch, for every render frame
+	std::vector<std::unique_ptr<core::Buffer>> culled_draw_counts;
 };
 
 }        // namespace vkb
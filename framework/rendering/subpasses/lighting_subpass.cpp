@@ -24,27 +24,97 @@
 
 namespace vkb
 {
+
 LightingSubpass::LightingSubpass(RenderContext &render_context, ShaderSource &&vertex_shader, ShaderSource &&fragment_shader, sg::Camera &cam, sg::Scene &scene_) :
     Subpass{render_context, std::move(vertex_shader), std::move(fragment_shader)},
     camera{cam},
-    scene{scene_}
+    scene{scene_},
+    light_clustering{render_context, cam}
+{
+	set_debug_name("Lighting");
+}
+
+void LightingSubpass::set_clustered_lighting(bool enable)
+{
+	clustered_lighting = enable;
+}
+
+void LightingSubpass::set_async_light_clustering(bool enable)
 {
+	light_clustering.set_async_compute(enable);
+}
+
+void LightingSubpass::set_ray_traced_visibility(bool enable)
+{
+	ray_traced_visibility = enable;
+}
+
+void LightingSubpass::set_image_based_lighting(ImageBasedLighting *lighting)
+{
+	image_based_lighting = lighting;
 }
 
 void LightingSubpass::prepare()
 {
+	if (clustered_lighting && !LightClustering::is_supported(camera))
+	{
+		LOGW("Clustered lighting requires a perspective camera, shading every pixel with every light");
+		clustered_lighting = false;
+	}
+
 	lighting_variant.add_definitions({"MAX_DEFERRED_LIGHT_COUNT " + std::to_string(MAX_DEFERRED_LIGHT_COUNT)});
 	lighting_variant.add_definitions(light_type_definitions);
+
+	if (clustered_lighting)
+	{
+		lighting_variant.add_definitions(LightClustering::get_shader_definitions());
+
+		light_clustering.prepare();
+	}
+
+	if (ray_traced_visibility)
+	{
+		lighting_variant.add_define("RAY_TRACED_VISIBILITY");
+	}
+
+	if (image_based_lighting)
+	{
+		lighting_variant.add_definitions(ImageBasedLighting::get_shader_definitions());
+	}
+
 	// Build all shaders upfront
 	auto &resource_cache = render_context.get_device().get_resource_cache();
 	resource_cache.request_shader_module(VK_SHADER_STAGE_VERTEX_BIT, get_vertex_shader(), lighting_variant);
 	resource_cache.request_shader_module(VK_SHADER_STAGE_FRAGMENT_BIT, get_fragment_shader(), lighting_variant);
 }
 
+void LightingSubpass::pre_draw(CommandBuffer &command_buffer)
+{
+	if (!clustered_lighting)
+	{
+		return;
+	}
+
+	auto &render_frame = render_context.get_active_frame();
+
+	// The geometry subpass without CPU culling shares this packet
+	auto &render_packet = render_frame.request_render_packet(scene, camera, false);
+
+	light_clustering.record(command_buffer, render_packet.get_lights(), render_frame.get_render_target().get_render_area());
+}
+
 void LightingSubpass::draw(CommandBuffer &command_buffer)
 {
-	auto light_buffer = allocate_lights<DeferredLights>(scene.get_components<sg::Light>(), MAX_DEFERRED_LIGHT_COUNT);
-	command_buffer.bind_buffer(light_buffer.get_buffer(), light_buffer.get_offset(), light_buffer.get_size(), 0, 4, 0);
+	if (clustered_lighting)
+	{
+		light_clustering.bind(command_buffer, 4);
+	}
+	else
+	{
+		auto &render_packet = render_context.get_active_frame().request_render_packet(scene, camera, false);
+		auto  light_buffer  = allocate_lights<DeferredLights>(render_packet.get_lights(), MAX_DEFERRED_LIGHT_COUNT);
+		command_buffer.bind_buffer(light_buffer.get_buffer(), light_buffer.get_offset(), light_buffer.get_size(), 0, 4, 0);
+	}
 
 	// Get shaders from cache
 	auto &resource_cache     = command_buffer.get_device().get_resource_cache();
@@ -71,6 +141,16 @@ void LightingSubpass::draw(CommandBuffer &command_buffer)
 	auto &normal_view = target_views.at(3);
 	command_buffer.bind_input(normal_view, 0, 2, 0);
 
+	if (ray_traced_visibility)
+	{
+		command_buffer.bind_input(target_views.at(get_input_attachments().at(3)), 0, 8, 0);
+	}
+
+	if (image_based_lighting)
+	{
+		image_based_lighting->bind(command_buffer, 9);
+	}
+
 	// Set cull mode to front as full screen triangle is clock-wise
 	RasterizationState rasterization_state;
 	rasterization_state.cull_mode = VK_CULL_MODE_FRONT_BIT;
@@ -80,12 +160,15 @@ void LightingSubpass::draw(CommandBuffer &command_buffer)
 	LightUniform light_uniform;
 
 	// Inverse resolution
-	light_uniform.inv_resolution.x = 1.0f / render_target.get_extent().width;
-	light_uniform.inv_resolution.y = 1.0f / render_target.get_extent().height;
+	light_uniform.inv_resolution.x = 1.0f / render_target.get_render_area().width;
+	light_uniform.inv_resolution.y = 1.0f / render_target.get_render_area().height;
 
 	// Inverse view projection
 	light_uniform.inv_view_proj = glm::inverse(vulkan_style_projection(camera.get_projection()) * camera.get_view());
 
+	// Camera position, for the view direction of the environment reflections
+	light_uniform.camera_position = glm::inverse(camera.get_view())[3];
+
 	// Allocate a buffer using the buffer pool from the active frame to store uniform values and bind it
 	auto &render_frame = get_render_context().get_active_frame();
 	auto  allocation   = render_frame.allocate_buffer(VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT, sizeof(LightUniform));
@@ -18,6 +18,8 @@
 #pragma once
 
 #include "buffer_pool.h"
+#include "rendering/image_based_lighting.h"
+#include "rendering/light_clustering.h"
 #include "rendering/subpass.h"
 
 VKBP_DISABLE_WARNINGS()
@@ -43,6 +45,7 @@ class Scene;
 struct alignas(16) LightUniform
 {
 	glm::mat4 inv_view_proj;
+	glm::vec4 camera_position;
 	glm::vec2 inv_resolution;
 };
 
@@ -64,12 +67,51 @@ class LightingSubpass : public Subpass
 
 	void draw(CommandBuffer &command_buffer) override;
 
+	/**
+	 * @brief Bins the lights into clusters of screen tiles and depth slices with a compute pass recorded by pre_draw,
+	 *        so that each pixel is only shaded by the lights which can reach its cluster
+	 *        Lifts the MAX_DEFERRED_LIGHT_COUNT limit. It requires a perspective camera and needs to be set before prepare.
+	 */
+	void set_clustered_lighting(bool enable);
+
+	/**
+	 * @brief Submits the light clustering pass to the async compute queue of the render context, when it has one,
+	 *        so that it overlaps with the graphics work before the fragment shaders reading the clusters
+	 *        It needs to be set before prepare.
+	 */
+	void set_async_light_clustering(bool enable);
+
+	/**
+	 * @brief Scales the first directional light by the red channel of the fourth input attachment, and the ambient
+	 *        light by its green channel, as written by a RayTracedShadowSubpass. It needs to be set before prepare.
+	 */
+	void set_ray_traced_visibility(bool enable);
+
+	/**
+	 * @brief Replaces the constant ambient light with the light of an environment, reflected by a rough dielectric
+	 *        as the G-buffer has no material properties. The lighting needs to outlive the subpass and to be set before prepare.
+	 */
+	void set_image_based_lighting(ImageBasedLighting *lighting);
+
+	/**
+	 * @brief Records the light clustering pass, if clustered lighting is enabled
+	 */
+	virtual void pre_draw(CommandBuffer &command_buffer) override;
+
   private:
 	sg::Camera &camera;
 
 	sg::Scene &scene;
 
 	ShaderVariant lighting_variant;
+
+	bool clustered_lighting{false};
+
+	bool ray_traced_visibility{false};
+
+	LightClustering light_clustering;
+
+	ImageBasedLighting *image_based_lighting{nullptr};
 };
 
 }        // namespace vkb
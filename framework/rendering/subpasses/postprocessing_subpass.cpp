@@ -29,6 +29,8 @@ PostProcessingSubpass::PostProcessingSubpass(RenderContext &render_context, Shad
     camera{cam},
     scene{scene_}
 {
+	set_debug_name("Post-processing");
+
 	// Create texture samplers
 	VkSamplerCreateInfo sampler_info{VK_STRUCTURE_TYPE_SAMPLER_CREATE_INFO};
 	sampler_info.maxAnisotropy = 1.0f;
@@ -53,6 +55,37 @@ void PostProcessingSubpass::prepare()
 	postprocessing_variant_ms_depth.add_definitions({"MS_DEPTH"});
 	resource_cache.request_shader_module(VK_SHADER_STAGE_VERTEX_BIT, get_vertex_shader(), postprocessing_variant_ms_depth);
 	resource_cache.request_shader_module(VK_SHADER_STAGE_FRAGMENT_BIT, get_fragment_shader(), postprocessing_variant_ms_depth);
+
+	if (temporal_upscaler)
+	{
+		temporal_upscaler->prepare();
+	}
+
+	if (compute_chain)
+	{
+		compute_chain->prepare();
+	}
+}
+
+void PostProcessingSubpass::pre_draw(CommandBuffer &command_buffer)
+{
+	auto &render_target = get_render_context().get_active_frame().get_render_target();
+
+	const core::ImageView *color = &render_target.get_views().at(full_screen_color);
+
+	if (temporal_upscaler)
+	{
+		temporal_upscaler->record(command_buffer, *color, render_target.get_views().at(motion_vectors), render_target.get_render_area());
+
+		color = &temporal_upscaler->get_output();
+
+		render_target.set_render_area(render_target.get_extent());
+	}
+
+	if (compute_chain)
+	{
+		compute_chain->record(command_buffer, *color);
+	}
 }
 
 void PostProcessingSubpass::draw(CommandBuffer &command_buffer)
@@ -73,9 +106,37 @@ void PostProcessingSubpass::draw(CommandBuffer &command_buffer)
 	auto &render_target = get_render_context().get_active_frame().get_render_target();
 	auto &target_views  = render_target.get_views();
 
+	const core::ImageView *color = &target_views.at(full_screen_color);
+
+	if (compute_chain)
+	{
+		color = &compute_chain->get_output();
+	}
+	else if (temporal_upscaler)
+	{
+		color = &temporal_upscaler->get_output();
+	}
+
 	// Bind depth and color to texture samplers
 	command_buffer.bind_image(target_views.at(full_screen_depth), *depth_sampler, 0, 0, 0);
-	command_buffer.bind_image(target_views.at(full_screen_color), *color_sampler, 0, 1, 0);
+	command_buffer.bind_image(*color, *color_sampler, 0, 1, 0);
+
+	if (temporal_upscaler)
+	{
+		// The viewport was set for the render area of the scene, before pre_draw widened it
+		const auto &extent = render_target.get_render_area();
+
+		VkViewport viewport{};
+		viewport.width    = static_cast<float>(extent.width);
+		viewport.height   = static_cast<float>(extent.height);
+		viewport.minDepth = 0.0f;
+		viewport.maxDepth = 1.0f;
+		command_buffer.set_viewport(0, {viewport});
+
+		VkRect2D scissor{};
+		scissor.extent = extent;
+		command_buffer.set_scissor(0, {scissor});
+	}
 
 	// Disable culling
 	RasterizationState rasterization_state;
@@ -95,6 +156,11 @@ void PostProcessingSubpass::draw(CommandBuffer &command_buffer)
 
 	// Draw full screen triangle
 	command_buffer.draw(3, 1, 0, 0);
+
+	if (temporal_upscaler)
+	{
+		temporal_upscaler->update_jitter(d_camera);
+	}
 }
 
 void PostProcessingSubpass::set_full_screen_color(uint32_t attachment)
@@ -111,4 +177,15 @@ void PostProcessingSubpass::set_ms_depth(bool enable)
 {
 	ms_depth = enable;
 }
+
+void PostProcessingSubpass::set_compute_chain(PostProcessingChain *chain)
+{
+	compute_chain = chain;
+}
+
+void PostProcessingSubpass::set_temporal_upscaler(TemporalUpscaler *upscaler, uint32_t motion_vectors_)
+{
+	temporal_upscaler = upscaler;
+	motion_vectors    = motion_vectors_;
+}
 }        // namespace vkb
@@ -17,7 +17,9 @@
 
 #pragma once
 
+#include "rendering/postprocessing_chain.h"
 #include "rendering/subpass.h"
+#include "rendering/temporal_upscaler.h"
 
 namespace vkb
 {
@@ -51,6 +53,11 @@ class PostProcessingSubpass : public Subpass
 
 	virtual void prepare() override;
 
+	/**
+	 * @brief Records the temporal upscaler and the compute chain, if any, before the render pass begins
+	 */
+	virtual void pre_draw(CommandBuffer &command_buffer) override;
+
 	void draw(CommandBuffer &command_buffer) override;
 
 	void set_full_screen_color(uint32_t attachment);
@@ -59,6 +66,26 @@ class PostProcessingSubpass : public Subpass
 
 	void set_ms_depth(bool enable);
 
+	/**
+	 * @brief Processes the full screen color with a chain of compute dispatches, and binds
+	 *        its output to the fragment shader instead of the color itself
+	 *        Needs to be set before prepare, and outlive the subpass.
+	 * @param chain Compute chain, or nullptr to bind the full screen color directly
+	 */
+	void set_compute_chain(PostProcessingChain *chain);
+
+	/**
+	 * @brief Reconstructs the full screen color at the extent of the render target from the render area it was
+	 *        drawn to, and processes or binds the reconstruction instead of the color itself
+	 *
+	 * The render area of the render target is widened to its extent before the render pass, so that the
+	 * pass draws at full resolution, while the depth keeps the render area of the scene. After drawing,
+	 * the camera is jittered for the next frame. Needs to be set before prepare, and outlive the subpass.
+	 * @param upscaler Temporal upscaler, or nullptr to draw at the render area
+	 * @param motion_vectors Attachment with the motion vectors of the scene, in the shader read only layout
+	 */
+	void set_temporal_upscaler(TemporalUpscaler *upscaler, uint32_t motion_vectors);
+
   private:
 	sg::Camera &camera;
 
@@ -79,6 +106,12 @@ class PostProcessingSubpass : public Subpass
 	 */
 	bool ms_depth{false};
 
+	PostProcessingChain *compute_chain{nullptr};
+
+	TemporalUpscaler *temporal_upscaler{nullptr};
+
+	uint32_t motion_vectors{0};
+
 	/**
 	 * @brief Variant where depth is not multisampled
 	 */
@@ -0,0 +1,186 @@
+/* Copyright (c) 2020, Arm Limited and Contributors
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 the "License";
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "rendering/subpasses/ray_traced_shadow_subpass.h"
+
+#include <algorithm>
+
+#include "rendering/acceleration_structure_builder.h"
+#include "rendering/render_context.h"
+#include "scene_graph/components/camera.h"
+#include "scene_graph/components/light.h"
+#include "scene_graph/node.h"
+#include "scene_graph/scene.h"
+
+namespace vkb
+{
+namespace
+{
+/// Visibility, ambient visibility and depth of the accumulated pixels, w tells written pixels apart
+constexpr VkFormat HISTORY_FORMAT = VK_FORMAT_R16G16B16A16_SFLOAT;
+}        // namespace
+
+RayTracedShadowSubpass::RayTracedShadowSubpass(RenderContext &               render_context,
+                                               ShaderSource &&               vertex_shader,
+                                               ShaderSource &&               fragment_shader,
+                                               sg::Camera &                  camera,
+                                               sg::Scene &                   scene,
+                                               AccelerationStructureBuilder &acceleration_structures) :
+    Subpass{render_context, std::move(vertex_shader), std::move(fragment_shader)},
+    camera{camera},
+    scene{scene},
+    acceleration_structures{acceleration_structures}
+{
+	set_debug_name("Ray traced shadows");
+
+	// The depth is read as an input attachment
+	set_disable_depth_stencil_attachment(true);
+}
+
+void RayTracedShadowSubpass::set_trace_stride(uint32_t stride)
+{
+	trace_stride = std::max(stride, 1u);
+}
+
+void RayTracedShadowSubpass::set_ambient_occlusion_radius(float radius)
+{
+	ambient_occlusion_radius = radius;
+}
+
+void RayTracedShadowSubpass::set_history_weight(float weight)
+{
+	history_weight = weight;
+}
+
+void RayTracedShadowSubpass::set_ray_offset(float offset)
+{
+	ray_offset = offset;
+}
+
+void RayTracedShadowSubpass::prepare()
+{
+	auto &resource_cache = render_context.get_device().get_resource_cache();
+	resource_cache.request_shader_module(VK_SHADER_STAGE_VERTEX_BIT, get_vertex_shader(), visibility_variant);
+	resource_cache.request_shader_module(VK_SHADER_STAGE_FRAGMENT_BIT, get_fragment_shader(), visibility_variant);
+}
+
+void RayTracedShadowSubpass::create_history(const VkExtent2D &new_extent)
+{
+	auto &device = render_context.get_device();
+
+	extent = new_extent;
+
+	history_views.clear();
+	history_images.clear();
+
+	for (int i = 0; i < 2; ++i)
+	{
+		history_images.push_back(std::make_unique<core::Image>(device, VkExtent3D{extent.width, extent.height, 1}, HISTORY_FORMAT,
+		                                                       VK_IMAGE_USAGE_STORAGE_BIT, VMA_MEMORY_USAGE_GPU_ONLY));
+		history_views.push_back(&history_images.back()->request_view(VK_IMAGE_VIEW_TYPE_2D));
+	}
+
+	history_valid = false;
+}
+
+void RayTracedShadowSubpass::pre_draw(CommandBuffer &command_buffer)
+{
+	auto &render_area = render_context.get_active_frame().get_render_target().get_render_area();
+
+	if (history_images.empty() || render_area.width != extent.width || render_area.height != extent.height)
+	{
+		create_history(render_area);
+	}
+
+	// The fragment shader reads the history written by the previous frame, and writes the other one
+	auto &history_in  = *history_views[frame_index % 2];
+	auto &history_out = *history_views[(frame_index + 1) % 2];
+
+	command_buffer.require_layout(history_in, VK_IMAGE_LAYOUT_GENERAL, VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT, VK_ACCESS_SHADER_READ_BIT, !history_valid);
+	command_buffer.require_layout(history_out, VK_IMAGE_LAYOUT_GENERAL, VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT, VK_ACCESS_SHADER_WRITE_BIT, true);
+	command_buffer.flush_barriers();
+
+	if (!acceleration_structures.get_top_level())
+	{
+		acceleration_structures.record_top_level(command_buffer.get_handle());
+	}
+}
+
+void RayTracedShadowSubpass::draw(CommandBuffer &command_buffer)
+{
+	auto &resource_cache     = command_buffer.get_device().get_resource_cache();
+	auto &vert_shader_module = resource_cache.request_shader_module(VK_SHADER_STAGE_VERTEX_BIT, get_vertex_shader(), visibility_variant);
+	auto &frag_shader_module = resource_cache.request_shader_module(VK_SHADER_STAGE_FRAGMENT_BIT, get_fragment_shader(), visibility_variant);
+
+	std::vector<ShaderModule *> shader_modules{&vert_shader_module, &frag_shader_module};
+
+	auto &pipeline_layout = resource_cache.request_pipeline_layout(shader_modules);
+	command_buffer.bind_pipeline_layout(pipeline_layout);
+
+	// Bind depth and normal as input attachments
+	auto &render_target = get_render_context().get_active_frame().get_render_target();
+	auto &target_views  = render_target.get_views();
+
+	command_buffer.bind_input(target_views.at(get_input_attachments().at(0)), 0, 0, 0);
+	command_buffer.bind_input(target_views.at(get_input_attachments().at(1)), 0, 1, 0);
+
+	// Set cull mode to front as full screen triangle is clock-wise
+	RasterizationState rasterization_state;
+	rasterization_state.cull_mode = VK_CULL_MODE_FRONT_BIT;
+	command_buffer.set_rasterization_state(rasterization_state);
+
+	auto view_proj = vulkan_style_projection(camera.get_projection()) * camera.get_view();
+
+	VisibilityUniform visibility_uniform;
+	visibility_uniform.inv_view_proj  = glm::inverse(view_proj);
+	visibility_uniform.prev_view_proj = history_valid ? prev_view_proj : view_proj;
+	visibility_uniform.parameters     = {ambient_occlusion_radius, history_weight, ray_offset, history_valid ? 1.0f : 0.0f};
+	visibility_uniform.resolution     = {static_cast<float>(extent.width), static_cast<float>(extent.height)};
+
+	// Tiles are traced in scanline order of their pixels over consecutive frames
+	uint32_t tile_pixel       = frame_index % (trace_stride * trace_stride);
+	visibility_uniform.frame  = {frame_index, trace_stride, tile_pixel % trace_stride, tile_pixel / trace_stride};
+
+	visibility_uniform.light_direction = glm::vec4(0.0f);
+	for (auto light : scene.get_components<sg::Light>())
+	{
+		if (light->get_light_type() == sg::LightType::Directional)
+		{
+			auto &transform                    = light->get_node()->get_transform();
+			visibility_uniform.light_direction = glm::vec4(glm::normalize(transform.get_rotation() * light->get_properties().direction), 1.0f);
+			break;
+		}
+	}
+
+	auto &render_frame = get_render_context().get_active_frame();
+	auto  allocation   = render_frame.allocate_buffer(VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT, sizeof(VisibilityUniform));
+	allocation.update(visibility_uniform);
+	command_buffer.bind_buffer(allocation.get_buffer(), allocation.get_offset(), allocation.get_size(), 0, 2, 0);
+
+	command_buffer.bind_acceleration_structure(*acceleration_structures.get_top_level(), 0, 3, 0);
+
+	command_buffer.bind_image(*history_views[frame_index % 2], 0, 4, 0);
+	command_buffer.bind_image(*history_views[(frame_index + 1) % 2], 0, 5, 0);
+
+	// Draw full screen triangle
+	command_buffer.draw(3, 1, 0, 0);
+
+	prev_view_proj = view_proj;
+	history_valid  = true;
+	frame_index++;
+}
+}        // namespace vkb
@@ -0,0 +1,160 @@
+/* Copyright (c) 2020, Arm Limited and Contributors
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 the "License";
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <memory>
+#include <vector>
+
+#include "core/image.h"
+#include "rendering/subpass.h"
+
+VKBP_DISABLE_WARNINGS()
+#include "common/glm_common.h"
+VKBP_ENABLE_WARNINGS()
+
+namespace vkb
+{
+class AccelerationStructureBuilder;
+
+namespace sg
+{
+class Camera;
+class Scene;
+}        // namespace sg
+
+/**
+ * @brief Uniform of the ray traced shadows
+ *        The view projection of the previous frame reprojects the accumulated visibility.
+ */
+struct alignas(16) VisibilityUniform
+{
+	glm::mat4 inv_view_proj;
+
+	glm::mat4 prev_view_proj;
+
+	/// Direction of the shadowing light, w is 0 if the scene has no directional light
+	glm::vec4 light_direction;
+
+	/// Ambient occlusion radius, history weight, ray offset, and whether the history is valid
+	glm::vec4 parameters;
+
+	/// Frame index, trace stride, and the pixel of every tile traced this frame
+	glm::uvec4 frame;
+
+	glm::vec2 resolution;
+};
+
+/**
+ * @brief Traces the shadow of the first directional light of a scene and its ambient occlusion with ray queries,
+ *        against the acceleration structures of the scene, from the depth and normal written by a GeometrySubpass
+ *
+ * It runs between the GeometrySubpass and the LightingSubpass of a deferred pipeline. Its output attachment gets
+ * the light visibility in red and the ambient visibility in green, which LightingSubpass::set_ray_traced_visibility
+ * reads. The inputs are the depth and the normal attachments, in this order.
+ *
+ * Only one pixel of every tile of stride by stride pixels is traced each frame. The others reproject the visibility
+ * accumulated over the previous frames, which also averages the single ambient occlusion ray a pixel traces.
+ * Disoccluded pixels are always traced.
+ *
+ * It needs the ray query feature of VK_KHR_ray_tracing, fragment stores and shaders compiled for SPIR-V 1.4.
+ */
+class RayTracedShadowSubpass : public Subpass
+{
+  public:
+	/**
+	 * @param render_context Render context
+	 * @param vertex_shader Vertex shader of a full screen triangle, such as deferred/lighting.vert
+	 * @param fragment_shader Fragment shader tracing the rays, such as ray_traced_shadows/visibility.frag
+	 * @param camera Camera the depth was rendered with
+	 * @param scene Scene whose first directional light casts the shadows
+	 * @param acceleration_structures Acceleration structures of the scene, with the bottom levels built.
+	 *        The top level acceleration structure is built by the first frame if it was not already.
+	 */
+	RayTracedShadowSubpass(RenderContext &               render_context,
+	                       ShaderSource &&               vertex_shader,
+	                       ShaderSource &&               fragment_shader,
+	                       sg::Camera &                  camera,
+	                       sg::Scene &                   scene,
+	                       AccelerationStructureBuilder &acceleration_structures);
+
+	virtual ~RayTracedShadowSubpass() = default;
+
+	virtual void prepare() override;
+
+	/**
+	 * @brief Builds the top level acceleration structure if needed, and makes the history of the previous frame visible
+	 */
+	virtual void pre_draw(CommandBuffer &command_buffer) override;
+
+	virtual void draw(CommandBuffer &command_buffer) override;
+
+	/**
+	 * @brief Traces one pixel of every tile of stride by stride pixels per frame, 1 traces every pixel
+	 */
+	void set_trace_stride(uint32_t stride);
+
+	/**
+	 * @param radius Length of the ambient occlusion rays, 0 disables ambient occlusion
+	 */
+	void set_ambient_occlusion_radius(float radius);
+
+	/**
+	 * @param weight Weight of the accumulated visibility when a new trace is blended in, 0 disables temporal accumulation
+	 */
+	void set_history_weight(float weight);
+
+	/**
+	 * @param offset Distance rays start at from surfaces along their normal, which keeps surfaces from shadowing themselves
+	 */
+	void set_ray_offset(float offset);
+
+  private:
+	void create_history(const VkExtent2D &extent);
+
+	sg::Camera &camera;
+
+	sg::Scene &scene;
+
+	AccelerationStructureBuilder &acceleration_structures;
+
+	ShaderVariant visibility_variant;
+
+	uint32_t trace_stride{2};
+
+	float ambient_occlusion_radius{1.0f};
+
+	float history_weight{0.9f};
+
+	float ray_offset{0.01f};
+
+	VkExtent2D extent{};
+
+	/// Visibility accumulated over the previous frames, read and written alternately by consecutive frames
+	std::vector<std::unique_ptr<core::Image>> history_images;
+
+	/// Views owned by the history images
+	std::vector<core::ImageView *> history_views;
+
+	/// Whether the history image read by the next frame was written by the previous one
+	bool history_valid{false};
+
+	uint32_t frame_index{0};
+
+	glm::mat4 prev_view_proj{1.0f};
+};
+}        // namespace vkb
@@ -0,0 +1,109 @@
+/* Copyright (c) 2020, Arm Limited and Contributors
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 the "License";
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "rendering/subpasses/shadow_subpass.h"
+
+#include "rendering/render_context.h"
+#include "scene_graph/components/material.h"
+#include "scene_graph/components/sub_mesh.h"
+#include "scene_graph/node.h"
+
+namespace vkb
+{
+ShadowSubpass::ShadowSubpass(RenderContext &render_context, ShaderSource &&vertex_source, ShaderSource &&fragment_source, sg::Scene &scene_, sg::Camera &camera) :
+    GeometrySubpass{render_context, std::move(vertex_source), std::move(fragment_source), scene_, camera}
+{
+	set_debug_name("Shadow");
+}
+
+void ShadowSubpass::set_light_view_proj(const glm::mat4 &view_proj)
+{
+	light_view_proj = view_proj;
+}
+
+void ShadowSubpass::set_casters(std::vector<std::pair<sg::Node *, sg::SubMesh *>> &&casters_)
+{
+	casters = std::move(casters_);
+}
+
+void ShadowSubpass::set_depth_bias(float constant_factor, float slope_factor)
+{
+	depth_bias_constant_factor = constant_factor;
+	depth_bias_slope_factor    = slope_factor;
+}
+
+bool ShadowSubpass::is_parallel_draw_supported() const
+{
+	return false;
+}
+
+void ShadowSubpass::draw(CommandBuffer &command_buffer)
+{
+	for (auto &caster : casters)
+	{
+		update_uniform(command_buffer, *caster.first);
+
+		// Invert the front face if the mesh was flipped
+		const auto &scale      = caster.first->get_transform().get_scale();
+		bool        flipped    = scale.x * scale.y * scale.z < 0;
+		VkFrontFace front_face = flipped ? VK_FRONT_FACE_CLOCKWISE : VK_FRONT_FACE_COUNTER_CLOCKWISE;
+
+		draw_submesh(command_buffer, *caster.second, front_face);
+	}
+}
+
+void ShadowSubpass::update_uniform(CommandBuffer &command_buffer, sg::Node &node, size_t thread_index)
+{
+	auto &render_frame = get_render_context().get_active_frame();
+
+	auto allocation = render_frame.allocate_buffer(VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT, sizeof(GlobalUniform), thread_index);
+
+	auto global_uniform = allocation.emplace<GlobalUniform>();
+
+	global_uniform->camera_view_proj = light_view_proj;
+
+	global_uniform->model = node.get_transform().get_world_matrix();
+
+	global_uniform->camera_position = glm::vec3(glm::inverse(camera.get_view())[3]);
+
+	allocation.flush();
+
+	command_buffer.bind_buffer(allocation.get_buffer(), allocation.get_offset(), allocation.get_size(), 0, 1, 0);
+}
+
+void ShadowSubpass::prepare_pipeline_state(CommandBuffer &command_buffer, VkFrontFace front_face, bool double_sided_material)
+{
+	RasterizationState rasterization_state{};
+	rasterization_state.front_face        = front_face;
+	rasterization_state.depth_bias_enable = VK_TRUE;
+
+	if (double_sided_material)
+	{
+		rasterization_state.cull_mode = VK_CULL_MODE_NONE;
+	}
+
+	command_buffer.set_rasterization_state(rasterization_state);
+	command_buffer.set_depth_bias(depth_bias_constant_factor, 0.0f, depth_bias_slope_factor);
+
+	MultisampleState multisample_state{};
+	multisample_state.rasterization_samples = sample_count;
+	command_buffer.set_multisample_state(multisample_state);
+}
+
+void ShadowSubpass::prepare_push_constants(CommandBuffer &command_buffer, sg::SubMesh &sub_mesh)
+{}
+}        // namespace vkb
@@ -0,0 +1,85 @@
+/* Copyright (c) 2020, Arm Limited and Contributors
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 the "License";
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include "rendering/subpasses/geometry_subpass.h"
+
+namespace vkb
+{
+/**
+ * @brief Renders the depth of shadow casters from the point of view of a light
+ *        The casters and the light view projection are set before every draw, usually by ShadowCascades.
+ */
+class ShadowSubpass : public GeometrySubpass
+{
+  public:
+	/**
+	 * @brief Constructs a subpass rendering shadow maps
+	 * @param render_context Render context
+	 * @param vertex_shader Vertex shader source
+	 * @param fragment_shader Fragment shader source
+	 * @param scene Scene to render on this subpass
+	 * @param camera Camera of the scene, which the shadow maps are rendered for
+	 */
+	ShadowSubpass(RenderContext &render_context, ShaderSource &&vertex_shader, ShaderSource &&fragment_shader, sg::Scene &scene, sg::Camera &camera);
+
+	virtual ~ShadowSubpass() = default;
+
+	/**
+	 * @brief Draws the casters with the light view projection
+	 */
+	virtual void draw(CommandBuffer &command_buffer) override;
+
+	virtual bool is_parallel_draw_supported() const override;
+
+	/**
+	 * @param view_proj Projection and view of the light, as written to the depth of the shadow map
+	 */
+	void set_light_view_proj(const glm::mat4 &view_proj);
+
+	/**
+	 * @param casters Opaque sub meshes to draw and their nodes
+	 */
+	void set_casters(std::vector<std::pair<sg::Node *, sg::SubMesh *>> &&casters);
+
+	/**
+	 * @brief Sets the depth bias applied to casters, which keeps surfaces from shadowing themselves
+	 *        Biases are negative, as the shadow maps use reversed depth like the scene.
+	 */
+	void set_depth_bias(float constant_factor, float slope_factor);
+
+  protected:
+	virtual void update_uniform(CommandBuffer &command_buffer, sg::Node &node, size_t thread_index = 0) override;
+
+	virtual void prepare_pipeline_state(CommandBuffer &command_buffer, VkFrontFace front_face, bool double_sided_material) override;
+
+	/**
+	 * @brief Pushes no material, as only the depth of casters is rendered
+	 */
+	virtual void prepare_push_constants(CommandBuffer &command_buffer, sg::SubMesh &sub_mesh) override;
+
+  private:
+	glm::mat4 light_view_proj{1.0f};
+
+	std::vector<std::pair<sg::Node *, sg::SubMesh *>> casters;
+
+	float depth_bias_constant_factor{-1.25f};
+
+	float depth_bias_slope_factor{-1.75f};
+};
+}        // namespace vkb
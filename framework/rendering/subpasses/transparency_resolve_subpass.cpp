@@ -0,0 +1,122 @@
+/* Copyright (c) 2020, Arm Limited and Contributors
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 the "License";
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "transparency_resolve_subpass.h"
+
+#include "common/vk_common.h"
+#include "rendering/render_context.h"
+
+namespace vkb
+{
+constexpr VkFormat TransparencyResolveSubpass::ACCUMULATION_FORMAT;
+
+constexpr VkFormat TransparencyResolveSubpass::REVEALAGE_FORMAT;
+
+TransparencyResolveSubpass::TransparencyResolveSubpass(RenderContext &render_context, ShaderSource &&vertex_shader, ShaderSource &&fragment_shader) :
+    Subpass{render_context, std::move(vertex_shader), std::move(fragment_shader)}
+{
+	set_debug_name("Transparency resolve");
+}
+
+RenderTarget::CreateFunc TransparencyResolveSubpass::get_create_func()
+{
+	return [](core::Image &&swapchain_image) -> std::unique_ptr<RenderTarget> {
+		auto &device = swapchain_image.get_device();
+		auto &extent = swapchain_image.get_extent();
+
+		VkFormat depth_format = get_suitable_depth_format(device.get_gpu().get_handle());
+
+		core::Image depth_image{device, extent,
+		                        depth_format,
+		                        VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT | VK_IMAGE_USAGE_TRANSIENT_ATTACHMENT_BIT,
+		                        VMA_MEMORY_USAGE_GPU_ONLY};
+
+		core::Image accumulation_image{device, extent,
+		                               ACCUMULATION_FORMAT,
+		                               VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT | VK_IMAGE_USAGE_INPUT_ATTACHMENT_BIT | VK_IMAGE_USAGE_TRANSIENT_ATTACHMENT_BIT,
+		                               VMA_MEMORY_USAGE_GPU_ONLY};
+
+		core::Image revealage_image{device, extent,
+		                            REVEALAGE_FORMAT,
+		                            VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT | VK_IMAGE_USAGE_INPUT_ATTACHMENT_BIT | VK_IMAGE_USAGE_TRANSIENT_ATTACHMENT_BIT,
+		                            VMA_MEMORY_USAGE_GPU_ONLY};
+
+		std::vector<core::Image> images;
+		images.push_back(std::move(swapchain_image));
+		images.push_back(std::move(depth_image));
+		images.push_back(std::move(accumulation_image));
+		images.push_back(std::move(revealage_image));
+
+		return std::make_unique<RenderTarget>(std::move(images));
+	};
+}
+
+void TransparencyResolveSubpass::prepare()
+{
+	// Build all shaders upfront
+	auto &resource_cache = render_context.get_device().get_resource_cache();
+	resource_cache.request_shader_module(VK_SHADER_STAGE_VERTEX_BIT, get_vertex_shader());
+	resource_cache.request_shader_module(VK_SHADER_STAGE_FRAGMENT_BIT, get_fragment_shader());
+}
+
+void TransparencyResolveSubpass::draw(CommandBuffer &command_buffer)
+{
+	// Get shaders from cache
+	auto &resource_cache     = command_buffer.get_device().get_resource_cache();
+	auto &vert_shader_module = resource_cache.request_shader_module(VK_SHADER_STAGE_VERTEX_BIT, get_vertex_shader());
+	auto &frag_shader_module = resource_cache.request_shader_module(VK_SHADER_STAGE_FRAGMENT_BIT, get_fragment_shader());
+
+	std::vector<ShaderModule *> shader_modules{&vert_shader_module, &frag_shader_module};
+
+	// Create pipeline layout and bind it
+	auto &pipeline_layout = resource_cache.request_pipeline_layout(shader_modules);
+	command_buffer.bind_pipeline_layout(pipeline_layout);
+
+	// Bind the accumulation and the revealage as input attachments
+	auto auto &target_views    = target_views  = get_render_context().get_active_frame().get_render_target().get_views();
+	auto &input_indices   = get_input_attachments();
+	command_buffer.bind_input(target_views.at(input_indices.at(0)), 0, 0, 0);
+	command_buffer.bind_input(target_views.at(input_indices.at(1)), 0, 1, 0);
+
+	// Blend over the opaque color by the coverage of the transparent fragments
+	ColorBlendAttachmentState color_blend_attachment{};
+	color_blend_attachment.blend_enable           = VK_TRUE;
+	color_blend_attachment.src_color_blend_factor = VK_BLEND_FACTOR_SRC_ALPHA;
+	color_blend_attachment.dst_color_blend_factor = VK_BLEND_FACTOR_ONE_MINUS_SRC_ALPHA;
+	color_blend_attachment.src_alpha_blend_factor = VK_BLEND_FACTOR_ONE;
+	color_blend_attachment.dst_alpha_blend_factor = VK_BLEND_FACTOR_ONE_MINUS_SRC_ALPHA;
+
+	ColorBlendState color_blend_state{};
+	color_blend_state.attachments.resize(get_output_attachments().size());
+	color_blend_state.attachments[0] = color_blend_attachment;
+	command_buffer.set_color_blend_state(color_blend_state);
+
+	// The depth was already tested when accumulating
+	DepthStencilState depth_stencil_state{};
+	depth_stencil_state.depth_test_enable  = VK_FALSE;
+	depth_stencil_state.depth_write_enable = VK_FALSE;
+	command_buffer.set_depth_stencil_state(depth_stencil_state);
+
+	// Set cull mode to front as full screen triangle is clock-wise
+	RasterizationState rasterization_state;
+	rasterization_state.cull_mode = VK_CULL_MODE_FRONT_BIT;
+	command_buffer.set_rasterization_state(rasterization_state);
+
+	// Draw full screen triangle
+	command_buffer.draw(3, 1, 0, 0);
+}
+}        // namespace vkb
@@ -0,0 +1,65 @@
+/* Copyright (c) 2020, Arm Limited and Contributors
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 the "License";
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include "rendering/render_target.h"
+#include "rendering/subpass.h"
+
+namespace vkb
+{
+/**
+ * @brief Composites the transparent objects drawn by a GeometrySubpass in weighted blended mode over the opaque color
+ *
+ * The geometry subpass writes the accumulation and the revealage attachments, which this subpass reads as input
+ * attachments while blending over the swapchain image. The accumulation needs to be cleared to 0 and the revealage to 1.
+ */
+class TransparencyResolveSubpass : public Subpass
+{
+  public:
+	/**
+	 * @brief Format of the premultiplied color and alpha sums, weighted by depth
+	 */
+	static constexpr VkFormat ACCUMULATION_FORMAT{VK_FORMAT_R16G16B16A16_SFLOAT};
+
+	/**
+	 * @brief Format of the product of the transmittances of the transparent fragments
+	 */
+	static constexpr VkFormat REVEALAGE_FORMAT{VK_FORMAT_R16_SFLOAT};
+
+	/**
+	 * @param render_context Render context
+	 * @param vertex_shader Full screen triangle vertex shader, postprocessing/postprocessing.vert
+	 * @param fragment_shader Resolve fragment shader, transparency/resolve.frag
+	 */
+	TransparencyResolveSubpass(RenderContext &render_context, ShaderSource &&vertex_shader, ShaderSource &&fragment_shader);
+
+	/**
+	 * @brief Creates render targets with the swapchain image, a depth attachment, then the accumulation and the
+	 *        revealage attachments, all transient but the swapchain image
+	 */
+	static RenderTarget::CreateFunc get_create_func();
+
+	virtual void prepare() override;
+
+	/**
+	 * @brief Reads the accumulation and the revealage from the first two input attachments of the subpass
+	 */
+	void draw(CommandBuffer &command_buffer) override;
+};
+
+}        // namespace vkb
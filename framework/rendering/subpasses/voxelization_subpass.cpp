@@ -0,0 +1,148 @@
+/* Copyright (c) 2020, Arm Limited and Contributors
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 the "License";
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "rendering/subpasses/voxelization_subpass.h"
+
+#include "core/image_view.h"
+#include "rendering/render_context.h"
+#include "scene_graph/components/camera.h"
+#include "scene_graph/components/sub_mesh.h"
+#include "scene_graph/node.h"
+
+namespace vkb
+{
+VoxelizationSubpass::VoxelizationSubpass(RenderContext &render_context, ShaderSource &&vertex_source, ShaderSource &&fragment_source, sg::Scene &scene_, sg::Camera &camera) :
+    GeometrySubpass{render_context, std::move(vertex_source), std::move(fragment_source), scene_, camera}
+{
+	set_debug_name("Voxelization");
+
+	// Fragments are stored to the voxels regardless of their depth
+	set_disable_depth_stencil_attachment(true);
+}
+
+void VoxelizationSubpass::set_grid(const VoxelGridUniform &grid_)
+{
+	grid = grid_;
+}
+
+void VoxelizationSubpass::set_voxels(core::ImageView &voxels_)
+{
+	voxels = &voxels_;
+}
+
+void VoxelizationSubpass::set_nodes(std::vector<std::pair<sg::Node *, sg::SubMesh *>> &&nodes_)
+{
+	nodes = std::move(nodes_);
+}
+
+void VoxelizationSubpass::set_conservative_rasterization(bool enable)
+{
+	conservative_rasterization = enable;
+}
+
+bool VoxelizationSubpass::is_parallel_draw_supported() const
+{
+	return false;
+}
+
+void VoxelizationSubpass::draw(CommandBuffer &command_buffer)
+{
+	if (!voxels || nodes.empty())
+	{
+		return;
+	}
+
+	auto &render_frame = get_render_context().get_active_frame();
+
+	auto allocation = render_frame.allocate_buffer(VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT, sizeof(VoxelGridUniform));
+	allocation.update(grid);
+
+	command_buffer.bind_image(*voxels, 0, 2, 0);
+	command_buffer.bind_buffer(allocation.get_buffer(), allocation.get_offset(), allocation.get_size(), 0, 3, 0);
+
+	// Maps world positions to the unit cube of the grid
+	float     grid_size = grid.origin.w * grid.info.x;
+	glm::mat4 to_grid   = glm::scale(glm::mat4(1.0f), glm::vec3(1.0f / grid_size)) * glm::translate(glm::mat4(1.0f), -glm::vec3(grid.origin));
+
+	for (int axis = 0; axis < 3; ++axis)
+	{
+		// The axis is the depth, the two others span the render target
+		glm::mat4 projection(0.0f);
+		projection[(axis + 1) % 3][0] = 2.0f;
+		projection[(axis + 2) % 3][1] = 2.0f;
+		projection[axis][2]           = 1.0f;
+		projection[3]                 = glm::vec4(-1.0f, -1.0f, 0.0f, 1.0f);
+
+		axis_view_proj = projection * to_grid;
+
+		for (auto &node : nodes)
+		{
+			update_uniform(command_buffer, *node.first);
+
+			// Invert the front face if the mesh was flipped
+			const auto &scale      = node.first->get_transform().get_scale();
+			bool        flipped    = scale.x * scale.y * scale.z < 0;
+			VkFrontFace front_face = flipped ? VK_FRONT_FACE_CLOCKWISE : VK_FRONT_FACE_COUNTER_CLOCKWISE;
+
+			draw_submesh(command_buffer, *node.second, front_face);
+		}
+	}
+}
+
+void VoxelizationSubpass::update_uniform(CommandBuffer &command_buffer, sg::Node &node, size_t thread_index)
+{
+	auto &render_frame = get_render_context().get_active_frame();
+
+	auto allocation = render_frame.allocate_buffer(VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT, sizeof(GlobalUniform), thread_index);
+
+	auto global_uniform = allocation.emplace<GlobalUniform>();
+
+	global_uniform->camera_view_proj = axis_view_proj;
+
+	global_uniform->model = node.get_transform().get_world_matrix();
+
+	global_uniform->camera_position = glm::vec3(glm::inverse(camera.get_view())[3]);
+
+	allocation.flush();
+
+	command_buffer.bind_buffer(allocation.get_buffer(), allocation.get_offset(), allocation.get_size(), 0, 1, 0);
+}
+
+void VoxelizationSubpass::prepare_pipeline_state(CommandBuffer &command_buffer, VkFrontFace front_face, bool double_sided_material)
+{
+	// Both sides of triangles are seen along the axes
+	RasterizationState rasterization_state{};
+	rasterization_state.front_face = front_face;
+	rasterization_state.cull_mode  = VK_CULL_MODE_NONE;
+
+	if (conservative_rasterization)
+	{
+		rasterization_state.conservative_rasterization_mode = VK_CONSERVATIVE_RASTERIZATION_MODE_OVERESTIMATE_EXT;
+	}
+
+	command_buffer.set_rasterization_state(rasterization_state);
+
+	DepthStencilState depth_stencil_state{};
+	depth_stencil_state.depth_test_enable  = VK_FALSE;
+	depth_stencil_state.depth_write_enable = VK_FALSE;
+	command_buffer.set_depth_stencil_state(depth_stencil_state);
+
+	MultisampleState multisample_state{};
+	multisample_state.rasterization_samples = sample_count;
+	command_buffer.set_multisample_state(multisample_state);
+}
+}        // namespace vkb
@@ -0,0 +1,105 @@
+/* Copyright (c) 2020, Arm Limited and Contributors
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 the "License";
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include "rendering/subpasses/geometry_subpass.h"
+
+namespace vkb
+{
+namespace core
+{
+class ImageView;
+}
+
+/**
+ * @brief Grid uniform structure for the voxelization shaders and the shaders reading the voxels
+ */
+struct alignas(16) VoxelGridUniform
+{
+	glm::vec4  origin;        // xyz is the minimum corner of the grid, w the size of a voxel
+	glm::uvec4 info;          // x is the number of voxels along each axis
+};
+
+/**
+ * @brief Voxelizes sub meshes into a 3D storage image, writing their base color to the voxels they touch
+ *
+ * Every node is rasterized with an orthographic projection along each of the three axes of the grid, so that each
+ * triangle covers voxels from an axis it is not parallel to, and fragments store to the voxel of their position.
+ * Conservative rasterization keeps thin triangles from falling between fragments. The render target only
+ * sets the resolution of the rasterization, its single attachment is not written.
+ * The nodes, the grid and the voxel image are set before every draw, usually by SceneVoxelization.
+ */
+class VoxelizationSubpass : public GeometrySubpass
+{
+  public:
+	/**
+	 * @param render_context Render context
+	 * @param vertex_shader Vertex shader source, such as voxelization/voxelize.vert
+	 * @param fragment_shader Fragment shader source, such as voxelization/voxelize.frag
+	 * @param scene Scene to voxelize
+	 * @param camera Camera of the scene
+	 */
+	VoxelizationSubpass(RenderContext &render_context, ShaderSource &&vertex_shader, ShaderSource &&fragment_shader, sg::Scene &scene, sg::Camera &camera);
+
+	virtual ~VoxelizationSubpass() = default;
+
+	/**
+	 * @brief Draws the nodes along the three axes of the grid
+	 */
+	virtual void draw(CommandBuffer &command_buffer) override;
+
+	virtual bool is_parallel_draw_supported() const override;
+
+	/**
+	 * @param grid Bounds and resolution of the voxel grid
+	 */
+	void set_grid(const VoxelGridUniform &grid);
+
+	/**
+	 * @param voxels View of the 3D storage image the fragments are stored to, in the general layout
+	 */
+	void set_voxels(core::ImageView &voxels);
+
+	/**
+	 * @param nodes Sub meshes to voxelize and their nodes
+	 */
+	void set_nodes(std::vector<std::pair<sg::Node *, sg::SubMesh *>> &&nodes);
+
+	/**
+	 * @brief Rasterizes every pixel a triangle touches, the device needs VK_EXT_conservative_rasterization
+	 */
+	void set_conservative_rasterization(bool enable);
+
+  protected:
+	virtual void update_uniform(CommandBuffer &command_buffer, sg::Node &node, size_t thread_index = 0) override;
+
+	virtual void prepare_pipeline_state(CommandBuffer &command_buffer, VkFrontFace front_face, bool double_sided_material) override;
+
+  private:
+	VoxelGridUniform grid{};
+
+	core::ImageView *voxels{nullptr};
+
+	std::vector<std::pair<sg::Node *, sg::SubMesh *>> nodes;
+
+	bool conservative_rasterization{false};
+
+	/// Orthographic projection of the grid along the axis being drawn
+	glm::mat4 axis_view_proj{1.0f};
+};
+}        // namespace vkb
@@ -0,0 +1,196 @@
+/* Copyright (c) 2020, Arm Limited and Contributors
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 the "License";
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "rendering/temporal_upscaler.h"
+
+#include <algorithm>
+
+#include "core/command_buffer.h"
+#include "rendering/render_context.h"
+#include "scene_graph/components/perspective_camera.h"
+
+namespace vkb
+{
+namespace
+{
+/// Width and height of the workgroups of the upscaling shader, one invocation per output pixel
+constexpr uint32_t UPSCALE_GROUP_SIZE = 8;
+
+constexpr VkFormat HISTORY_FORMAT = VK_FORMAT_R16G16B16A16_SFLOAT;
+
+/// Positions of the jitter sequence before it repeats, enough to cover a pixel for the common scales
+constexpr uint32_t JITTER_PHASE_COUNT = 8;
+
+struct UpscaleParameters
+{
+	/// Render area divided by the extent of the inputs
+	glm::vec2 render_scale;
+
+	glm::vec2 jitter;
+
+	/// Jitter of the current frame minus the one of the previous frame, both included in the motion vectors
+	glm::vec2 jitter_delta;
+
+	float history_weight;
+
+	uint32_t history_valid;
+};
+
+/**
+ * @return Element of the Halton sequence of a base, in [0, 1)
+ */
+float halton(uint32_t index, uint32_t base)
+{
+	float result   = 0.0f;
+	float fraction = 1.0f;
+
+	for (; index > 0; index /= base)
+	{
+		fraction /= base;
+		result += fraction * (index % base);
+	}
+
+	return result;
+}
+}        // namespace
+
+constexpr VkFormat TemporalUpscaler::MOTION_VECTOR_FORMAT;
+
+TemporalUpscaler::TemporalUpscaler(RenderContext &render_context) :
+    render_context{render_context},
+    upscale_shader{"postprocessing/temporal_upscale.comp"}
+{
+	VkSamplerCreateInfo sampler_info{VK_STRUCTURE_TYPE_SAMPLER_CREATE_INFO};
+	sampler_info.maxAnisotropy = 1.0f;
+	sampler_info.magFilter     = VK_FILTER_LINEAR;
+	sampler_info.minFilter     = VK_FILTER_LINEAR;
+	sampler_info.mipmapMode    = VK_SAMPLER_MIPMAP_MODE_NEAREST;
+	sampler_info.addressModeU  = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+	sampler_info.addressModeV  = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+	sampler_info.addressModeW  = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+	sampler_info.borderColor   = VK_BORDER_COLOR_FLOAT_OPAQUE_BLACK;
+	linear_sampler             = std::make_unique<core::Sampler>(render_context.get_device(), sampler_info);
+}
+
+void TemporalUpscaler::prepare()
+{
+	auto &resource_cache = render_context.get_device().get_resource_cache();
+	resource_cache.request_shader_module(VK_SHADER_STAGE_COMPUTE_BIT, upscale_shader, upscale_variant);
+
+	// Images are created for the extent of the first inputs
+	extent        = {};
+	history_valid = false;
+}
+
+void TemporalUpscaler::set_history_weight(float weight)
+{
+	history_weight = std::min(std::max(weight, 0.0f), 1.0f);
+}
+
+void TemporalUpscaler::create_history(const VkExtent2D &new_extent)
+{
+	auto &device = render_context.get_device();
+
+	extent = new_extent;
+
+	history_views.clear();
+	history_images.clear();
+
+	for (int i = 0; i < 2; ++i)
+	{
+		history_images.push_back(std::make_unique<core::Image>(device, VkExtent3D{extent.width, extent.height, 1}, HISTORY_FORMAT,
+		                                                       VK_IMAGE_USAGE_STORAGE_BIT | VK_IMAGE_USAGE_SAMPLED_BIT, VMA_MEMORY_USAGE_GPU_ONLY));
+		history_views.push_back(&history_images.back()->request_view(VK_IMAGE_VIEW_TYPE_2D));
+	}
+
+	history_valid = false;
+}
+
+void TemporalUpscaler::record(CommandBuffer &command_buffer, const core::ImageView &color, const core::ImageView &motion_vectors, const VkExtent2D &render_area_)
+{
+	const auto &input_extent = color.get_image().get_extent();
+
+	if (history_images.empty() || input_extent.width != extent.width || input_extent.height != extent.height)
+	{
+		create_history({input_extent.width, input_extent.height});
+	}
+
+	render_area = render_area_;
+
+	// The previous reconstruction is read as the history, and the other image is written
+	auto &history_in  = *history_views[output_index];
+	auto &history_out = *history_views[(output_index + 1) % 2];
+
+	command_buffer.require_layout(history_in, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_ACCESS_SHADER_READ_BIT, !history_valid);
+	command_buffer.require_layout(history_out, VK_IMAGE_LAYOUT_GENERAL, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_ACCESS_SHADER_WRITE_BIT, true);
+
+	auto &resource_cache  = render_context.get_device().get_resource_cache();
+	auto &shader_module   = resource_cache.request_shader_module(VK_SHADER_STAGE_COMPUTE_BIT, upscale_shader, upscale_variant);
+	auto &pipeline_layout = resource_cache.request_pipeline_layout({&shader_module});
+
+	command_buffer.bind_pipeline_layout(pipeline_layout);
+
+	command_buffer.bind_image(color, *linear_sampler, 0, 0, 0);
+	command_buffer.bind_image(motion_vectors, *linear_sampler, 0, 1, 0);
+	command_buffer.bind_image(history_in, *linear_sampler, 0, 2, 0);
+	command_buffer.bind_image(history_out, 0, 3, 0);
+
+	UpscaleParameters parameters{};
+	parameters.render_scale   = {static_cast<float>(render_area.width) / extent.width, static_cast<float>(render_area.height) / extent.height};
+	parameters.jitter         = jitter;
+	parameters.jitter_delta   = jitter - previous_jitter;
+	parameters.history_weight = history_weight;
+	parameters.history_valid  = history_valid ? 1 : 0;
+	command_buffer.push_constants(parameters);
+
+	command_buffer.dispatch((extent.width + UPSCALE_GROUP_SIZE - 1) / UPSCALE_GROUP_SIZE,
+	                        (extent.height + UPSCALE_GROUP_SIZE - 1) / UPSCALE_GROUP_SIZE,
+	                        1);
+
+	command_buffer.require_layout(history_out, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL,
+	                              VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT | VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT, VK_ACCESS_SHADER_READ_BIT);
+	command_buffer.flush_barriers();
+
+	output_index  = (output_index + 1) % 2;
+	history_valid = true;
+}
+
+void TemporalUpscaler::update_jitter(sg::PerspectiveCamera &camera)
+{
+	if (render_area.width == 0 || render_area.height == 0)
+	{
+		return;
+	}
+
+	jitter_index = (jitter_index + 1) % JITTER_PHASE_COUNT;
+
+	// Offsets within a pixel of the render area, from a low discrepancy sequence which spreads them evenly
+	glm::vec2 offset{halton(jitter_index + 1, 2) - 0.5f, halton(jitter_index + 1, 3) - 0.5f};
+
+	previous_jitter = jitter;
+	jitter          = offset / glm::vec2{static_cast<float>(render_area.width), static_cast<float>(render_area.height)};
+
+	// Texture coordinates span half the clip space, whose y axis is flipped by the Vulkan projection
+	camera.set_jitter({2.0f * jitter.x, -2.0f * jitter.y});
+}
+
+const core::ImageView &TemporalUpscaler::get_output() const
+{
+	assert(!history_views.empty() && "Temporal upscaler was not recorded");
+	return *history_views[output_index];
+}
+}        // namespace vkb
@@ -0,0 +1,143 @@
+/* Copyright (c) 2020, Arm Limited and Contributors
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 the "License";
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <memory>
+#include <vector>
+
+#include "common/error.h"
+
+VKBP_DISABLE_WARNINGS()
+#include "common/glm_common.h"
+VKBP_ENABLE_WARNINGS()
+
+#include "core/image.h"
+#include "core/image_view.h"
+#include "core/sampler.h"
+#include "core/shader_module.h"
+
+namespace vkb
+{
+class CommandBuffer;
+class RenderContext;
+
+namespace sg
+{
+class PerspectiveCamera;
+}
+
+/**
+ * @brief Reconstructs a color image at full resolution from frames rendered to a smaller render area,
+ *        with a history of the previous reconstructions reprojected by motion vectors
+ *
+ * The camera is jittered by a different fraction of a pixel every frame, so that consecutive frames
+ * sample different positions within the pixels. A compute pass fetches the reconstruction of the
+ * previous frame where the motion vectors of a pixel come from, clamps it to the colors around the
+ * pixel in the current frame to reject disoccluded and changed contents, then blends the current
+ * frame into it. The reconstruction becomes the history of the next frame.
+ */
+class TemporalUpscaler
+{
+  public:
+	/// Format of the motion vector attachments, in texture coordinates as GeometrySubpass writes them
+	static constexpr VkFormat MOTION_VECTOR_FORMAT = VK_FORMAT_R16G16_SFLOAT;
+
+	TemporalUpscaler(RenderContext &render_context);
+
+	TemporalUpscaler(const TemporalUpscaler &) = delete;
+
+	TemporalUpscaler(TemporalUpscaler &&) = delete;
+
+	TemporalUpscaler &operator=(const TemporalUpscaler &) = delete;
+
+	TemporalUpscaler &operator=(TemporalUpscaler &&) = delete;
+
+	/**
+	 * @brief Builds the shader and discards the history
+	 */
+	void prepare();
+
+	/**
+	 * @param weight Weight of the history in the blend with the current frame, higher values smooth more over time
+	 */
+	void set_history_weight(float weight);
+
+	/**
+	 * @brief Records the reconstruction, outside of a render pass
+	 *        The history is created again if the extent of the inputs changes.
+	 * @param command_buffer Command buffer to record the dispatch to
+	 * @param color HDR color of the frame, in the shader read only layout and visible to compute shaders
+	 * @param motion_vectors Motion vectors of the frame, in the same layout
+	 * @param render_area Part of the inputs the frame was rendered to, from their origin
+	 */
+	void record(CommandBuffer &command_buffer, const core::ImageView &color, const core::ImageView &motion_vectors, const VkExtent2D &render_area);
+
+	/**
+	 * @brief Moves the jitter to the next position of its sequence and applies it to the camera, for the next frame
+	 *        It is called once per frame after record, and scales the jitter to the render area recorded.
+	 */
+	void update_jitter(sg::PerspectiveCamera &camera);
+
+	/**
+	 * @return The reconstruction of the last recording, at the extent of its inputs and in the shader read only layout
+	 */
+	const core::ImageView &get_output() const;
+
+  private:
+	/**
+	 * @brief Creates the history images for an extent
+	 */
+	void create_history(const VkExtent2D &extent);
+
+	RenderContext &render_context;
+
+	ShaderSource upscale_shader;
+
+	ShaderVariant upscale_variant;
+
+	std::unique_ptr<core::Sampler> linear_sampler;
+
+	float history_weight{0.9f};
+
+	VkExtent2D extent{};
+
+	/// Reconstructions the frames alternate between, one is read as the history while the other is written
+	std::vector<std::unique_ptr<core::Image>> history_images;
+
+	/// Views owned by the history images
+	std::vector<core::ImageView *> history_views;
+
+	/// Whether the history holds a reconstruction of the previous frame
+	bool history_valid{false};
+
+	/// Index of the history image written by the last recording
+	size_t output_index{0};
+
+	/// Render area of the last recording
+	VkExtent2D render_area{};
+
+	/// Position in the jitter sequence
+	uint32_t jitter_index{0};
+
+	/// Jitter of the current frame, in texture coordinates of the render area
+	glm::vec2 jitter{0.0f};
+
+	/// Jitter of the previous frame, in texture coordinates of the render area
+	glm::vec2 previous_jitter{0.0f};
+};
+}        // namespace vkb
@@ -0,0 +1,316 @@
+/* Copyright (c) 2020, Arm Limited and Contributors
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 the "License";
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "rendering/texture_residency.h"
+
+#include <algorithm>
+
+#include "common/helpers.h"
+#include "common/logging.h"
+#include "core/device.h"
+#include "core/staging_manager.h"
+#include "rendering/render_context.h"
+#include "scene_graph/components/image.h"
+#include "scene_graph/scene.h"
+
+namespace vkb
+{
+TextureResidency::TextureResidency(RenderContext &render_context, sg::Scene &scene, VkDeviceSize budget) :
+    render_context{render_context},
+    budget{budget}
+{
+	for (auto image : scene.get_components<sg::Image>())
+	{
+		auto &mipmaps = image->get_mipmaps();
+
+		// Levels are uploaded again from the data of the image, once per image
+		if (image->get_layers() != 1 || image->has_gpu_mipmaps() || image->get_data().empty() || mipmaps.size() < 2 ||
+		    image->get_vk_image_view().get_view_type() != VK_IMAGE_VIEW_TYPE_2D)
+		{
+			continue;
+		}
+
+		ManagedImage managed_image{image};
+
+		while (managed_image.max_level + 1 < mipmaps.size() &&
+		       std::max(mipmaps[managed_image.max_level].extent.width, mipmaps[managed_image.max_level].extent.height) > MIN_RESIDENT_EXTENT)
+		{
+			++managed_image.max_level;
+		}
+
+		if (managed_image.max_level == 0)
+		{
+			continue;
+		}
+
+		managed_image.needed_frame = render_context.get_frame_number();
+
+		resident_size += get_size(managed_image, 0);
+
+		image_indices.emplace(image, managed_images.size());
+		managed_images.push_back(managed_image);
+	}
+
+	LOGI("Texture residency manages {} of {} images", managed_images.size(), scene.get_components<sg::Image>().size());
+}
+
+void TextureResidency::request_level(const sg::Image &image, uint32_t level)
+{
+	auto it = image_indices.find(&image);
+
+	if (it != image_indices.end())
+	{
+		auto &managed_image       = managed_images[it->second];
+		managed_image.frame_level = std::min(managed_image.frame_level, level);
+	}
+}
+
+void TextureResidency::update()
+{
+	auto frame_number = render_context.get_frame_number();
+	auto frame_count  = render_context.get_render_frames().size();
+	auto frame_index  = render_context.get_active_frame_index();
+
+	if (stale_frames.size() != frame_count)
+	{
+		stale_frames.assign(frame_count, false);
+	}
+
+	// Every render frame cleared its descriptor sets since these images were replaced, and completed the work using them
+	retired_images.erase(std::remove_if(retired_images.begin(), retired_images.end(), [frame_number, frame_count](const RetiredImage &retired_image) {
+		                     return frame_number >= retired_image.frame_number + frame_count;
+	                     }),
+	                     retired_images.end());
+
+	for (auto &managed_image : managed_images)
+	{
+		uint32_t level            = std::min(managed_image.frame_level, managed_image.max_level);
+		managed_image.frame_level = ~0u;
+
+		// Finer levels are needed at once, coarser ones only once the finer ones were not requested for a while
+		if (level <= managed_image.needed_level || frame_number > managed_image.needed_frame + EVICTION_DELAY)
+		{
+			managed_image.needed_level = level;
+			managed_image.needed_frame = frame_number;
+		}
+	}
+
+	VkDeviceSize available_size = get_available_size();
+	VkDeviceSize uploaded_size  = 0;
+
+	bool replaced = false;
+
+	if (resident_size > available_size)
+	{
+		std::vector<ManagedImage *> unneeded_images;
+
+		for (auto &managed_image : managed_images)
+		{
+			if (managed_image.needed_level > managed_image.resident_level)
+			{
+				unneeded_images.push_back(&managed_image);
+			}
+		}
+
+		// Drop the levels freeing the most memory first
+		std::sort(unneeded_images.begin(), unneeded_images.end(), [this](const ManagedImage *a, const ManagedImage *b) {
+			return get_size(*a, a->resident_level) - get_size(*a, a->needed_level) > get_size(*b, b->resident_level) - get_size(*b, b->needed_level);
+		});
+
+		for (auto managed_image : unneeded_images)
+		{
+			if (resident_size <= available_size || uploaded_size >= upload_budget)
+			{
+				break;
+			}
+
+			uploaded_size += get_size(*managed_image, managed_image->needed_level);
+
+			make_resident(*managed_image, managed_image->needed_level);
+			replaced = true;
+		}
+	}
+
+	std::vector<ManagedImage *> missing_images;
+
+	for (auto &managed_image : managed_images)
+	{
+		if (managed_image.needed_level < managed_image.resident_level)
+		{
+			missing_images.push_back(&managed_image);
+		}
+	}
+
+	// Images missing the most levels first
+	std::sort(missing_images.begin(), missing_images.end(), [](const ManagedImage *a, const ManagedImage *b) {
+		return a->resident_level - a->needed_level > b->resident_level - b->needed_level;
+	});
+
+	for (auto managed_image : missing_images)
+	{
+		if (uploaded_size >= upload_budget)
+		{
+			break;
+		}
+
+		VkDeviceSize current_size = get_size(*managed_image, managed_image->resident_level);
+
+		// The finest level fitting in the budget, which may not be the one needed yet
+		for (uint32_t level = managed_image->needed_level; level < managed_image->resident_level; ++level)
+		{
+			VkDeviceSize size = get_size(*managed_image, level);
+
+			if (resident_size - current_size + size <= available_size && (uploaded_size == 0 || uploaded_size + size <= upload_budget))
+			{
+				uploaded_size += size;
+
+				make_resident(*managed_image, level);
+				replaced = true;
+				break;
+			}
+		}
+	}
+
+	if (!replaced)
+	{
+		return;
+	}
+
+	// Work submitted to the graphics queue after the flush sees the uploads
+	render_context.get_device().get_staging_manager().flush();
+
+	// Cached descriptor sets refer to the replaced views, each render frame drops them the next time it is active
+	stale_frames.assign(frame_count, true);
+
+	render_context.get_active_frame().clear_descriptors();
+	stale_frames[frame_index] = false;
+}
+
+void TextureResidency::set_budget(VkDeviceSize budget_)
+{
+	budget = budget_;
+}
+
+void TextureResidency::set_upload_budget(VkDeviceSize upload_budget_)
+{
+	upload_budget = upload_budget_;
+}
+
+uint32_t TextureResidency::get_resident_level(const sg::Image &image) const
+{
+	auto it = image_indices.find(&image);
+
+	return it != image_indices.end() ? managed_images[it->second].resident_level : 0;
+}
+
+VkDeviceSize TextureResidency::get_resident_size() const
+{
+	return resident_size;
+}
+
+uint32_t TextureResidency::get_pending_count() const
+{
+	return to_u32(std::count_if(managed_images.begin(), managed_images.end(), [](const ManagedImage &managed_image) {
+		return managed_image.needed_level < managed_image.resident_level;
+	}));
+}
+
+VkDeviceSize TextureResidency::get_size(const ManagedImage &managed_image, uint32_t first_level) const
+{
+	// Levels are stored from the finest to the coarsest
+	return managed_image.image->get_data().size() - managed_image.image->get_mipmaps()[first_level].offset;
+}
+
+VkDeviceSize TextureResidency::get_available_size() const
+{
+	if (budget != 0)
+	{
+		return budget;
+	}
+
+	VmaAllocator allocator = render_context.get_device().get_memory_allocator();
+
+	const VkPhysicalDeviceMemoryProperties *memory_properties = nullptr;
+	vmaGetMemoryProperties(allocator, &memory_properties);
+
+	// Estimated from the heap sizes by the allocator without VK_EXT_memory_budget
+	VmaBudget budgets[VK_MAX_MEMORY_HEAPS];
+	vmaGetBudget(allocator, budgets);
+
+	VkDeviceSize device_local_usage  = 0;
+	VkDeviceSize device_local_budget = 0;
+
+	for (uint32_t heap_index = 0; heap_index < memory_properties->memoryHeapCount; ++heap_index)
+	{
+		if (memory_properties->memoryHeaps[heap_index].flags & VK_MEMORY_HEAP_DEVICE_LOCAL_BIT)
+		{
+			device_local_usage += budgets[heap_index].usage;
+			device_local_budget += budgets[heap_index].budget;
+		}
+	}
+
+	// The memory not used by the managed images is left to the rest of the application
+	VkDeviceSize other_usage   = device_local_usage - std::min(device_local_usage, resident_size);
+	VkDeviceSize images_budget   = static_cast<VkDeviceSize>(device_local_budget * AVAILABLE_MEMORY_SHARE);
+
+	return images_budget > other_usage ? images_budget - other_usage : 0;
+}
+
+void TextureResidency::make_resident(ManagedImage &managed_image, uint32_t first_level)
+{
+	auto &image   = *managed_image.image;
+	auto &mipmaps = image.get_mipmaps();
+	auto &device  = render_context.get_device();
+
+	auto vk_image = std::make_unique<core::Image>(device,
+	                                              mipmaps[first_level].extent,
+	                                              image.get_format(),
+	                                              VK_IMAGE_USAGE_SAMPLED_BIT | VK_IMAGE_USAGE_TRANSFER_DST_BIT,
+	                                              VMA_MEMORY_USAGE_GPU_ONLY,
+	                                              VK_SAMPLE_COUNT_1_BIT,
+	                                              to_u32(mipmaps.size()) - first_level);
+
+	auto vk_image_view = std::make_unique<core::ImageView>(*vk_image, VK_IMAGE_VIEW_TYPE_2D);
+
+	VkDeviceSize first_offset = mipmaps[first_level].offset;
+
+	std::vector<VkBufferImageCopy> regions;
+
+	for (uint32_t level = first_level; level < to_u32(mipmaps.size()); ++level)
+	{
+		VkBufferImageCopy region{};
+		region.bufferOffset              = mipmaps[level].offset - first_offset;
+		region.imageSubresource          = vk_image_view->get_subresource_layers();
+		region.imageSubresource.mipLevel = level - first_level;
+		region.imageExtent               = mipmaps[level].extent;
+
+		regions.push_back(region);
+	}
+
+	VkDeviceSize size = get_size(managed_image, first_level);
+
+	device.get_staging_manager().copy_to_image(image.get_data().data() + first_offset, size, *vk_image, regions, vk_image_view->get_subresource_range());
+
+	image.swap_vk_image(vk_image, vk_image_view);
+
+	retired_images.push_back({std::move(vk_image), std::move(vk_image_view), render_context.get_frame_number()});
+
+	resident_size = resident_size - get_size(managed_image, managed_image.resident_level) + size;
+
+	managed_image.resident_level = first_level;
+}
+}        // namespace vkb
@@ -0,0 +1,182 @@
+/* Copyright (c) 2020, Arm Limited and Contributors
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 the "License";
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <memory>
+#include <unordered_map>
+#include <vector>
+
+#include "common/vk_common.h"
+#include "core/image.h"
+#include "core/image_view.h"
+
+namespace vkb
+{
+class RenderContext;
+
+namespace sg
+{
+class Image;
+class Scene;
+}        // namespace sg
+
+/**
+ * @brief Keeps the mip levels of the scene images within a device memory budget, dropping the finest levels
+ *        of the images that are not needed at full resolution and uploading them again once they are
+ *
+ * Every frame, request_level records the finest level a draw needs from an image, which GeometrySubpass
+ * estimates from the screen footprint of the nodes using it. update() then recreates the images whose
+ * resident levels differ from the finest level requested over the last frames: missing levels are uploaded
+ * through the staging manager while they fit in the budget, and unneeded levels are dropped once the
+ * budget is exceeded. The coarsest levels, down to MIN_RESIDENT_EXTENT, always stay resident.
+ *
+ * Only 2D images with all their mip levels in their data are managed, so the scene has to be loaded with
+ * GLTFLoader::set_keep_image_data, and without GPU mipmap generation or texture arrays.
+ */
+class TextureResidency
+{
+  public:
+	/**
+	 * @brief Registers the images of a scene
+	 * @param render_context Context the scene is drawn with
+	 * @param scene Scene whose images are managed
+	 * @param budget Device memory for the managed images in bytes, 0 to use what VK_EXT_memory_budget
+	 *        reports as available, or the device local heap size without the extension
+	 */
+	TextureResidency(RenderContext &render_context, sg::Scene &scene, VkDeviceSize budget = 0);
+
+	TextureResidency(const TextureResidency &) = delete;
+
+	TextureResidency(TextureResidency &&) = delete;
+
+	~TextureResidency() = default;
+
+	TextureResidency &operator=(const TextureResidency &) = delete;
+
+	TextureResidency &operator=(TextureResidency &&) = delete;
+
+	/**
+	 * @brief Records the finest mip level a draw of the frame needs from an image
+	 *        Images which are not managed are ignored.
+	 */
+	void request_level(const sg::Image &image, uint32_t level);
+
+	/**
+	 * @brief Uploads the levels missing from the images requested in the last frames and drops the unneeded ones
+	 *        when over budget. It is called after the render context began the frame, before recording it.
+	 */
+	void update();
+
+	void set_budget(VkDeviceSize budget);
+
+	/**
+	 * @brief Limits the bytes uploaded by an update, so that streaming does not stall frames
+	 */
+	void set_upload_budget(VkDeviceSize upload_budget);
+
+	/**
+	 * @return Finest mip level resident for an image, 0 for images which are not managed
+	 */
+	uint32_t get_resident_level(const sg::Image &image) const;
+
+	/**
+	 * @return Bytes of the resident levels of the managed images
+	 */
+	VkDeviceSize get_resident_size() const;
+
+	/**
+	 * @return Number of images whose finest resident level is coarser than requested
+	 */
+	uint32_t get_pending_count() const;
+
+	/// Width or height a level needs to exceed to be dropped
+	static constexpr uint32_t MIN_RESIDENT_EXTENT = 128;
+
+	/// Frames during which a level stays needed after it was last requested
+	static constexpr uint64_t EVICTION_DELAY = 120;
+
+	/// Share of the available device memory the images use when the budget comes from VK_EXT_memory_budget
+	static constexpr float AVAILABLE_MEMORY_SHARE = 0.8f;
+
+  private:
+	struct ManagedImage
+	{
+		sg::Image *image;
+
+		/// Finest level resident in the Vulkan image of the image
+		uint32_t resident_level{0};
+
+		/// Coarsest level that can become the finest resident one
+		uint32_t max_level{0};
+
+		/// Finest level requested during the frame
+		uint32_t frame_level{~0u};
+
+		/// Finest level requested over the last EVICTION_DELAY frames
+		uint32_t needed_level{0};
+
+		/// Frame in which needed_level was last requested
+		uint64_t needed_frame{0};
+	};
+
+	/**
+	 * @brief A Vulkan image replaced by update, destroyed once the frames in flight do not use it
+	 */
+	struct RetiredImage
+	{
+		std::unique_ptr<core::Image> image;
+
+		std::unique_ptr<core::ImageView> image_view;
+
+		uint64_t frame_number;
+	};
+
+	/**
+	 * @return Bytes of the levels of an image from a level to the coarsest one
+	 */
+	VkDeviceSize get_size(const ManagedImage &managed_image, uint32_t first_level) const;
+
+	/**
+	 * @return The bytes that the managed images may use now
+	 */
+	VkDeviceSize get_available_size() const;
+
+	/**
+	 * @brief Creates the Vulkan image of an image with the levels from first_level and records the uploads of their data
+	 */
+	void make_resident(ManagedImage &managed_image, uint32_t first_level);
+
+	RenderContext &render_context;
+
+	VkDeviceSize budget;
+
+	VkDeviceSize upload_budget{16 * 1024 * 1024};
+
+	std::vector<ManagedImage> managed_images;
+
+	/// Index of every managed image in managed_images
+	std::unordered_map<const sg::Image *, size_t> image_indices;
+
+	std::vector<RetiredImage> retired_images;
+
+	/// Render frames whose descriptor sets may still refer to the views of replaced images
+	std::vector<bool> stale_frames;
+
+	VkDeviceSize resident_size{0};
+};
+}        // namespace vkb
@@ -0,0 +1,616 @@
+/* Copyright (c) 2020, Arm Limited and Contributors
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 the "License";
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "rendering/virtual_texture.h"
+
+#include <algorithm>
+#include <cstring>
+#include <functional>
+#include <stdexcept>
+
+#include "common/error.h"
+#include "common/helpers.h"
+#include "common/logging.h"
+#include "common/strings.h"
+#include "common/vk_common.h"
+#include "core/device.h"
+#include "scene_graph/components/image.h"
+
+namespace vkb
+{
+namespace
+{
+/// Identifies a tile file, "VTEX" in little endian
+constexpr uint32_t TILE_MAGIC = 0x58455456;
+
+constexpr uint32_t TILE_VERSION = 1;
+
+/// Alignment of the pages in a tile file
+constexpr size_t TILE_ALIGNMENT = 16;
+
+struct TileHeader
+{
+	uint32_t magic;
+	uint32_t version;
+	uint32_t format;
+	uint32_t width;
+	uint32_t height;
+	uint32_t level_count;
+	uint32_t page_size;
+	uint32_t page_border;
+};
+
+/**
+ * @return Bytes of each component of a format a box filter can average, 0 for other formats
+ */
+uint32_t get_component_bytes(VkFormat format)
+{
+	switch (format)
+	{
+		case VK_FORMAT_R8_UNORM:
+		case VK_FORMAT_R8G8_UNORM:
+		case VK_FORMAT_R8G8B8A8_UNORM:
+		case VK_FORMAT_R8G8B8A8_SRGB:
+		case VK_FORMAT_B8G8R8A8_UNORM:
+		case VK_FORMAT_B8G8R8A8_SRGB:
+			return 1;
+		case VK_FORMAT_R16_UNORM:
+		case VK_FORMAT_R16G16_UNORM:
+		case VK_FORMAT_R16G16B16A16_UNORM:
+			return 2;
+		default:
+			return 0;
+	}
+}
+
+/**
+ * @brief Averages 2x2 blocks of texels into the next mip level
+ */
+std::vector<uint8_t> downsample(const std::vector<uint8_t> &data, uint32_t width, uint32_t height, uint32_t texel_bytes, uint32_t component_bytes)
+{
+	const uint32_t next_width      = width / 2;
+	const uint32_t next_height     = height / 2;
+	const uint32_t component_count = texel_bytes / component_bytes;
+
+	std::vector<uint8_t> next(static_cast<size_t>(next_width) * next_height * texel_bytes);
+
+	auto read = [&](uint32_t x, uint32_t y, uint32_t component) -> uint32_t {
+		const uint8_t *texel = &data[(static_cast<size_t>(y) * width + x) * texel_bytes + component * component_bytes];
+		return component_bytes == 1 ? texel[0] : static_cast<uint32_t>(texel[0] | (texel[1] << 8));
+	};
+
+	for (uint32_t y = 0; y < next_height; ++y)
+	{
+		for (uint32_t x = 0; x < next_width; ++x)
+		{
+			uint8_t *texel = &next[(static_cast<size_t>(y) * next_width + x) * texel_bytes];
+
+			for (uint32_t c = 0; c < component_count; ++c)
+			{
+				uint32_t sum = read(2 * x, 2 * y, c) + read(2 * x + 1, 2 * y, c) + read(2 * x, 2 * y + 1, c) + read(2 * x + 1, 2 * y + 1, c);
+				uint32_t avg = (sum + 2) / 4;
+
+				texel[c * component_bytes] = static_cast<uint8_t>(avg & 0xff);
+				if (component_bytes == 2)
+				{
+					texel[c * component_bytes + 1] = static_cast<uint8_t>(avg >> 8);
+				}
+			}
+		}
+	}
+
+	return next;
+}
+
+/**
+ * @brief Packs the slot and the level of a resident page into a page table texel, with 1 in alpha
+ */
+uint32_t pack_page_table_entry(uint32_t slot_x, uint32_t slot_y, uint32_t level)
+{
+	return slot_x | (slot_y << 8) | (level << 16) | (1u << 24);
+}
+}        // namespace
+
+constexpr uint32_t VirtualTexture::PAGE_SIZE;
+constexpr uint32_t VirtualTexture::PAGE_BORDER;
+
+std::vector<uint8_t> VirtualTexture::build_tiles(const sg::Image &image)
+{
+	const VkFormat format     = image.get_format();
+	const auto &   extent     = image.get_extent();
+	const int32_t  texel_bits = get_bits_per_pixel(format);
+
+	if (texel_bits <= 0 || texel_bits % 8 != 0)
+	{
+		throw std::runtime_error{"Virtual texture format not supported: " + to_string(format)};
+	}
+
+	if (extent.width % PAGE_SIZE != 0 || extent.height % PAGE_SIZE != 0)
+	{
+		throw std::runtime_error{"Virtual texture size must be a multiple of the page size: " + image.get_name()};
+	}
+
+	const uint32_t texel_bytes = static_cast<uint32_t>(texel_bits) / 8;
+	const uint32_t slot_size   = PAGE_SIZE + 2 * PAGE_BORDER;
+	const size_t   page_bytes  = static_cast<size_t>(slot_size) * slot_size * texel_bytes;
+
+	// Every level has a whole number of pages, so that the pages of a level halve those of the previous one
+	uint32_t level_count = 0;
+	while ((extent.width >> level_count) >= PAGE_SIZE && (extent.height >> level_count) >= PAGE_SIZE &&
+	       (extent.width >> level_count) % PAGE_SIZE == 0 && (extent.height >> level_count) % PAGE_SIZE == 0)
+	{
+		++level_count;
+	}
+
+	// Take the levels the image provides, and generate the others from the previous level
+	const auto &                      mipmaps = image.get_mipmaps();
+	std::vector<std::vector<uint8_t>> level_data(level_count);
+
+	for (uint32_t level = 0; level < level_count; ++level)
+	{
+		const uint32_t width  = extent.width >> level;
+		const uint32_t height = extent.height >> level;
+		const size_t   size   = static_cast<size_t>(width) * height * texel_bytes;
+
+		if (level < mipmaps.size() && mipmaps[level].extent.width == width && mipmaps[level].extent.height == height &&
+		    mipmaps[level].offset + size <= image.get_data().size())
+		{
+			auto begin = image.get_data().begin() + mipmaps[level].offset;
+			level_data[level].assign(begin, begin + size);
+		}
+		else
+		{
+			const uint32_t component_bytes = get_component_bytes(format);
+			if (component_bytes == 0)
+			{
+				throw std::runtime_error{"Cannot generate virtual texture levels for format: " + to_string(format)};
+			}
+
+			level_data[level] = downsample(level_data[level - 1], width * 2, height * 2, texel_bytes, component_bytes);
+		}
+	}
+
+	TileHeader header{};
+	header.magic       = TILE_MAGIC;
+	header.version     = TILE_VERSION;
+	header.format      = static_cast<uint32_t>(format);
+	header.width       = extent.width;
+	header.height      = extent.height;
+	header.level_count = level_count;
+	header.page_size   = PAGE_SIZE;
+	header.page_border = PAGE_BORDER;
+
+	const size_t data_offset = (sizeof(TileHeader) + TILE_ALIGNMENT - 1) & ~(TILE_ALIGNMENT - 1);
+
+	size_t page_count = 0;
+	for (uint32_t level = 0; level < level_count; ++level)
+	{
+		page_count += static_cast<size_t>((extent.width >> level) / PAGE_SIZE) * ((extent.height >> level) / PAGE_SIZE);
+	}
+
+	std::vector<uint8_t> tiles(data_offset + page_count * page_bytes);
+	std::memcpy(tiles.data(), &header, sizeof(TileHeader));
+
+	// Copy each page with its border, clamping to the edges of the level
+	uint8_t *page = tiles.data() + data_offset;
+
+	for (uint32_t level = 0; level < level_count; ++level)
+	{
+		const int32_t width  = static_cast<int32_t>(extent.width >> level);
+		const int32_t height = static_cast<int32_t>(extent.height >> level);
+
+		for (int32_t page_y = 0; page_y < height / static_cast<int32_t>(PAGE_SIZE); ++page_y)
+		{
+			for (int32_t page_x = 0; page_x < width / static_cast<int32_t>(PAGE_SIZE); ++page_x)
+			{
+				for (int32_t y = 0; y < static_cast<int32_t>(slot_size); ++y)
+				{
+					int32_t source_y = std::min(std::max(page_y * static_cast<int32_t>(PAGE_SIZE) + y - static_cast<int32_t>(PAGE_BORDER), 0), height - 1);
+
+					for (int32_t x = 0; x < static_cast<int32_t>(slot_size); ++x)
+					{
+						int32_t source_x = std::min(std::max(page_x * static_cast<int32_t>(PAGE_SIZE) + x - static_cast<int32_t>(PAGE_BORDER), 0), width - 1);
+
+						std::memcpy(page + (static_cast<size_t>(y) * slot_size + x) * texel_bytes,
+						            &level_data[level][(static_cast<size_t>(source_y) * width + source_x) * texel_bytes],
+						            texel_bytes);
+					}
+				}
+
+				page += page_bytes;
+			}
+		}
+	}
+
+	return tiles;
+}
+
+VirtualTexture::VirtualTexture(Device &device, fs::MappedFile &&tiles_file, uint32_t cache_slots, uint32_t upload_budget) :
+    device{device},
+    tiles{std::move(tiles_file)},
+    cache_slots{cache_slots},
+    upload_budget{upload_budget}
+{
+	TileHeader header{};
+	if (tiles.size() < sizeof(TileHeader))
+	{
+		throw std::runtime_error{"Virtual texture tile file is truncated"};
+	}
+	std::memcpy(&header, tiles.data(), sizeof(TileHeader));
+
+	if (header.magic != TILE_MAGIC || header.version != TILE_VERSION ||
+	    header.page_size != PAGE_SIZE || header.page_border != PAGE_BORDER || header.level_count == 0)
+	{
+		throw std::runtime_error{"Virtual texture tile file is invalid or out of date"};
+	}
+
+	format = static_cast<VkFormat>(header.format);
+
+	const uint32_t slot_size = PAGE_SIZE + 2 * PAGE_BORDER;
+	page_bytes               = static_cast<size_t>(slot_size) * slot_size * (get_bits_per_pixel(format) / 8);
+	data_offset              = (sizeof(TileHeader) + TILE_ALIGNMENT - 1) & ~(TILE_ALIGNMENT - 1);
+
+	for (uint32_t level = 0; level < header.level_count; ++level)
+	{
+		Level info{};
+		info.page_count_x = (header.width >> level) / PAGE_SIZE;
+		info.page_count_y = (header.height >> level) / PAGE_SIZE;
+		info.first_page   = page_count;
+
+		levels.push_back(info);
+		page_count += info.page_count_x * info.page_count_y;
+	}
+
+	if (tiles.size() < data_offset + page_count * page_bytes)
+	{
+		throw std::runtime_error{"Virtual texture tile file is truncated"};
+	}
+
+	// Slots are addressed by 8 bits in the page table
+	const uint32_t pinned_count = levels.back().page_count_x * levels.back().page_count_y;
+	if (cache_slots == 0 || cache_slots > 256 || cache_slots * cache_slots <= pinned_count)
+	{
+		throw std::runtime_error{fmt::format("Virtual texture cache of {0}x{0} pages cannot hold the {1} pages of its coarsest level", cache_slots, pinned_count)};
+	}
+
+	page_slots.resize(page_count, ~0u);
+	page_table_data.resize(page_count);
+	slots.resize(cache_slots * cache_slots);
+	for (uint32_t slot = cache_slots * cache_slots; slot > 0; --slot)
+	{
+		free_slots.push_back(slot - 1);
+	}
+
+	VkExtent3D cache_extent{cache_slots * slot_size, cache_slots * slot_size, 1};
+	cache      = std::make_unique<core::Image>(device, cache_extent, format, VK_IMAGE_USAGE_SAMPLED_BIT | VK_IMAGE_USAGE_TRANSFER_DST_BIT, VMA_MEMORY_USAGE_GPU_ONLY);
+	cache_view = std::make_unique<core::ImageView>(*cache, VK_IMAGE_VIEW_TYPE_2D);
+
+	VkExtent3D page_table_extent{levels[0].page_count_x, levels[0].page_count_y, 1};
+	page_table      = std::make_unique<core::Image>(device, page_table_extent, VK_FORMAT_R8G8B8A8_UINT, VK_IMAGE_USAGE_SAMPLED_BIT | VK_IMAGE_USAGE_TRANSFER_DST_BIT,
+                                               VMA_MEMORY_USAGE_GPU_ONLY, VK_SAMPLE_COUNT_1_BIT, to_u32(levels.size()));
+	page_table_view = std::make_unique<core::ImageView>(*page_table, VK_IMAGE_VIEW_TYPE_2D);
+
+	// The border of the pages lets the cache be filtered linearly, without sampling the neighbouring slots
+	VkSamplerCreateInfo sampler_info{VK_STRUCTURE_TYPE_SAMPLER_CREATE_INFO};
+	sampler_info.magFilter    = VK_FILTER_LINEAR;
+	sampler_info.minFilter    = VK_FILTER_LINEAR;
+	sampler_info.mipmapMode   = VK_SAMPLER_MIPMAP_MODE_NEAREST;
+	sampler_info.addressModeU = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+	sampler_info.addressModeV = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+	sampler_info.addressModeW = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+	sampler_info.maxLod       = 0.0f;
+	cache_sampler             = std::make_unique<core::Sampler>(device, sampler_info);
+
+	sampler_info.magFilter = VK_FILTER_NEAREST;
+	sampler_info.minFilter = VK_FILTER_NEAREST;
+	sampler_info.maxLod    = static_cast<float>(levels.size());
+	page_table_sampler     = std::make_unique<core::Sampler>(device, sampler_info);
+
+	feedback = std::make_unique<core::Buffer>(device, page_count * sizeof(uint32_t), VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT, VMA_MEMORY_USAGE_GPU_TO_CPU);
+	std::memset(feedback->map(), 0, page_count * sizeof(uint32_t));
+	feedback->flush();
+
+	VirtualTextureUniform uniform_data{};
+	uniform_data.page_count_x = levels[0].page_count_x;
+	uniform_data.page_count_y = levels[0].page_count_y;
+	uniform_data.level_count  = to_u32(levels.size());
+	uniform_data.cache_slots  = cache_slots;
+	uniform_data.page_size    = PAGE_SIZE;
+	uniform_data.page_border  = PAGE_BORDER;
+
+	uniform = std::make_unique<core::Buffer>(device, sizeof(VirtualTextureUniform), VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT, VMA_MEMORY_USAGE_CPU_TO_GPU);
+	uniform->update(&uniform_data, sizeof(VirtualTextureUniform));
+
+	// Room for the pages of an update, or of the coarsest level, followed by the page table
+	staging = std::make_unique<core::Buffer>(device, std::max(upload_budget, pinned_count) * page_bytes + page_count * sizeof(uint32_t),
+	                                         VK_BUFFER_USAGE_TRANSFER_SRC_BIT, VMA_MEMORY_USAGE_CPU_ONLY);
+
+	VkQueue queue = device.get_queue_by_role(QueueRole::Graphics).get_handle();
+
+	VkCommandBuffer command_buffer = device.create_command_buffer(VK_COMMAND_BUFFER_LEVEL_PRIMARY, true);
+
+	VkImageSubresourceRange subresource_range{VK_IMAGE_ASPECT_COLOR_BIT, 0, 1, 0, 1};
+	set_image_layout(command_buffer, cache->get_handle(), VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL, subresource_range);
+	subresource_range.levelCount = to_u32(levels.size());
+	set_image_layout(command_buffer, page_table->get_handle(), VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL, subresource_range);
+
+	device.flush_command_buffer(command_buffer, queue);
+
+	// Pin the coarsest level, which every page falls back to
+	std::vector<uint32_t> pinned(pinned_count);
+	for (uint32_t i = 0; i < pinned_count; ++i)
+	{
+		pinned[i] = levels.back().first_page + i;
+	}
+	upload_pages(queue, pinned);
+}
+
+void VirtualTexture::reset_feedback(VkCommandBuffer command_buffer)
+{
+	vkCmdFillBuffer(command_buffer, feedback->get_handle(), 0, VK_WHOLE_SIZE, 0);
+
+	VkBufferMemoryBarrier barrier{VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER};
+	barrier.srcAccessMask       = VK_ACCESS_TRANSFER_WRITE_BIT;
+	barrier.dstAccessMask       = VK_ACCESS_SHADER_WRITE_BIT;
+	barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+	barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+	barrier.buffer              = feedback->get_handle();
+	barrier.size                = VK_WHOLE_SIZE;
+
+	vkCmdPipelineBarrier(command_buffer, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT, 0, 0, nullptr, 1, &barrier, 0, nullptr);
+}
+
+void VirtualTexture::flush_feedback(VkCommandBuffer command_buffer)
+{
+	VkBufferMemoryBarrier barrier{VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER};
+	barrier.srcAccessMask       = VK_ACCESS_SHADER_WRITE_BIT;
+	barrier.dstAccessMask       = VK_ACCESS_HOST_READ_BIT;
+	barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+	barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+	barrier.buffer              = feedback->get_handle();
+	barrier.size                = VK_WHOLE_SIZE;
+
+	vkCmdPipelineBarrier(command_buffer, VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT, VK_PIPELINE_STAGE_HOST_BIT, 0, 0, nullptr, 1, &barrier, 0, nullptr);
+}
+
+void VirtualTexture::update()
+{
+	++update_count;
+
+	vmaInvalidateAllocation(device.get_memory_allocator(), feedback->get_allocation(), 0, VK_WHOLE_SIZE);
+	const uint32_t *requested = reinterpret_cast<const uint32_t *>(feedback->map());
+
+	// Request the missing pages along with their missing ancestors, and keep the resident ones in use
+	std::vector<bool> queued(page_count, false);
+	requests.clear();
+
+	for (uint32_t page = 0; page < page_count; ++page)
+	{
+		if (requested[page] == 0)
+		{
+			continue;
+		}
+
+		uint32_t level   = get_page_level(page);
+		uint32_t current = page;
+
+		while (true)
+		{
+			if (page_slots[current] != ~0u)
+			{
+				slots[page_slots[current]].last_used = update_count;
+			}
+			else if (!queued[current])
+			{
+				queued[current] = true;
+				requests.push_back(current);
+			}
+
+			if (level + 1 == levels.size())
+			{
+				break;
+			}
+
+			uint32_t local = current - levels[level].first_page;
+			uint32_t x     = local % levels[level].page_count_x;
+			uint32_t y     = local / levels[level].page_count_x;
+
+			++level;
+			current = levels[level].first_page + (y / 2) * levels[level].page_count_x + x / 2;
+		}
+	}
+
+	if (requests.empty())
+	{
+		return;
+	}
+
+	// Pages are numbered from the finest level, so coarser pages come first when sorted backwards
+	std::sort(requests.begin(), requests.end(), std::greater<uint32_t>());
+
+	std::vector<uint32_t> uploads(requests.begin(), requests.begin() + std::min<size_t>(requests.size(), upload_budget));
+	upload_pages(device.get_queue_by_role(QueueRole::Graphics).get_handle(), uploads);
+}
+
+VkDescriptorImageInfo VirtualTexture::get_cache_descriptor() const
+{
+	return {cache_sampler->get_handle(), cache_view->get_handle(), VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL};
+}
+
+VkDescriptorImageInfo VirtualTexture::get_page_table_descriptor() const
+{
+	return {page_table_sampler->get_handle(), page_table_view->get_handle(), VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL};
+}
+
+VkDescriptorBufferInfo VirtualTexture::get_feedback_descriptor() const
+{
+	return {feedback->get_handle(), 0, VK_WHOLE_SIZE};
+}
+
+VkDescriptorBufferInfo VirtualTexture::get_uniform_descriptor() const
+{
+	return {uniform->get_handle(), 0, sizeof(VirtualTextureUniform)};
+}
+
+uint32_t VirtualTexture::get_resident_page_count() const
+{
+	return to_u32(slots.size() - free_slots.size());
+}
+
+uint32_t VirtualTexture::get_pending_page_count() const
+{
+	return to_u32(requests.size());
+}
+
+uint32_t VirtualTexture::acquire_slot()
+{
+	if (!free_slots.empty())
+	{
+		uint32_t slot = free_slots.back();
+		free_slots.pop_back();
+		return slot;
+	}
+
+	// Evict the least recently used page, keeping the pinned level and the pages in use this update
+	const uint32_t pinned_level = to_u32(levels.size() - 1);
+
+	uint32_t lru_slot = ~0u;
+	for (uint32_t slot = 0; slot < slots.size(); ++slot)
+	{
+		if (slots[slot].last_used < update_count && get_page_level(slots[slot].page) != pinned_level &&
+		    (lru_slot == ~0u || slots[slot].last_used < slots[lru_slot].last_used))
+		{
+			lru_slot = slot;
+		}
+	}
+
+	if (lru_slot != ~0u)
+	{
+		page_slots[slots[lru_slot].page] = ~0u;
+	}
+
+	return lru_slot;
+}
+
+void VirtualTexture::upload_pages(VkQueue queue, const std::vector<uint32_t> &pages)
+{
+	const uint32_t slot_size = PAGE_SIZE + 2 * PAGE_BORDER;
+
+	std::vector<VkBufferImageCopy> page_copies;
+
+	for (uint32_t page : pages)
+	{
+		uint32_t slot = acquire_slot();
+		if (slot == ~0u)
+		{
+			// Every page is in use, the others fall back to their ancestors
+			break;
+		}
+
+		slots[slot].page      = page;
+		slots[slot].last_used = update_count;
+		page_slots[page]      = slot;
+
+		size_t staging_offset = page_copies.size() * page_bytes;
+		staging->update(tiles.data() + data_offset + page * page_bytes, page_bytes, staging_offset);
+
+		VkBufferImageCopy copy{};
+		copy.bufferOffset     = staging_offset;
+		copy.imageSubresource = {VK_IMAGE_ASPECT_COLOR_BIT, 0, 0, 1};
+		copy.imageOffset      = {static_cast<int32_t>((slot % cache_slots) * slot_size), static_cast<int32_t>((slot / cache_slots) * slot_size), 0};
+		copy.imageExtent      = {slot_size, slot_size, 1};
+
+		page_copies.push_back(copy);
+	}
+
+	if (page_copies.empty())
+	{
+		return;
+	}
+
+	update_page_table();
+
+	size_t page_table_offset = staging->get_size() - page_count * sizeof(uint32_t);
+	staging->update(reinterpret_cast<const uint8_t *>(page_table_data.data()), page_count * sizeof(uint32_t), page_table_offset);
+
+	std::vector<VkBufferImageCopy> page_table_copies;
+	for (uint32_t level = 0; level < levels.size(); ++level)
+	{
+		VkBufferImageCopy copy{};
+		copy.bufferOffset     = page_table_offset + levels[level].first_page * sizeof(uint32_t);
+		copy.imageSubresource = {VK_IMAGE_ASPECT_COLOR_BIT, level, 0, 1};
+		copy.imageExtent      = {levels[level].page_count_x, levels[level].page_count_y, 1};
+
+		page_table_copies.push_back(copy);
+	}
+
+	VkCommandBuffer command_buffer = device.create_command_buffer(VK_COMMAND_BUFFER_LEVEL_PRIMARY, true);
+
+	VkImageSubresourceRange subresource_range{VK_IMAGE_ASPECT_COLOR_BIT, 0, 1, 0, 1};
+	set_image_layout(command_buffer, cache->get_handle(), VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, subresource_range);
+	vkCmdCopyBufferToImage(command_buffer, staging->get_handle(), cache->get_handle(), VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, to_u32(page_copies.size()), page_copies.data());
+	set_image_layout(command_buffer, cache->get_handle(), VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL, subresource_range);
+
+	subresource_range.levelCount = to_u32(levels.size());
+	set_image_layout(command_buffer, page_table->get_handle(), VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, subresource_range);
+	vkCmdCopyBufferToImage(command_buffer, staging->get_handle(), page_table->get_handle(), VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, to_u32(page_table_copies.size()), page_table_copies.data());
+	set_image_layout(command_buffer, page_table->get_handle(), VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL, subresource_range);
+
+	device.flush_command_buffer(command_buffer, queue);
+
+	// Drop the uploaded pages from the pending requests
+	requests.erase(std::remove_if(requests.begin(), requests.end(), [this](uint32_t page) { return page_slots[page] != ~0u; }), requests.end());
+}
+
+void VirtualTexture::update_page_table()
+{
+	// Parents are resolved before their children, starting from the pinned level
+	for (uint32_t level = to_u32(levels.size()); level-- > 0;)
+	{
+		const Level &info = levels[level];
+
+		for (uint32_t y = 0; y < info.page_count_y; ++y)
+		{
+			for (uint32_t x = 0; x < info.page_count_x; ++x)
+			{
+				uint32_t page = info.first_page + y * info.page_count_x + x;
+				uint32_t slot = page_slots[page];
+
+				if (slot != ~0u)
+				{
+					page_table_data[page] = pack_page_table_entry(slot % cache_slots, slot / cache_slots, level);
+				}
+				else
+				{
+					const Level &parent   = levels[level + 1];
+					page_table_data[page] = page_table_data[parent.first_page + (y / 2) * parent.page_count_x + x / 2];
+				}
+			}
+		}
+	}
+}
+
+uint32_t VirtualTexture::get_page_level(uint32_t page) const
+{
+	uint32_t level = 0;
+	while (level + 1 < levels.size() && page >= levels[level + 1].first_page)
+	{
+		++level;
+	}
+	return level;
+}
+}        // namespace vkb
@@ -0,0 +1,245 @@
+/* Copyright (c) 2020, Arm Limited and Contributors
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 the "License";
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "core/buffer.h"
+#include "core/image.h"
+#include "core/image_view.h"
+#include "core/sampler.h"
+#include "platform/filesystem.h"
+
+namespace vkb
+{
+class Device;
+
+namespace sg
+{
+class Image;
+}        // namespace sg
+
+/**
+ * @brief Parameters for the shaders resolving virtual texture coordinates, matching a std140 uniform block
+ */
+struct alignas(16) VirtualTextureUniform
+{
+	uint32_t page_count_x;        // Pages across the first level
+	uint32_t page_count_y;        // Pages down the first level
+	uint32_t level_count;         // Levels of the page table
+	uint32_t cache_slots;         // Slots across and down the physical page cache
+	uint32_t page_size;           // Texels across a page, without its border
+	uint32_t page_border;         // Texels of the border around each page in the cache
+};
+
+/**
+ * @brief Streams the pages of a large texture into a fixed size cache, so that its memory is bounded by the cache
+ *
+ * The texture is split into square pages for each mip level and stored in a tile file, which is mapped rather than
+ * read so that only the pages the GPU asks for are loaded. The shaders look up a page table to find where a page
+ * lives in the physical cache texture, falling back to the finest resident parent page, and flag the pages they
+ * would like to sample in a feedback buffer. Every update reads the feedback, streams a budget of missing pages,
+ * coarsest first, and replaces the least recently used pages once the cache is full. The pages of the coarsest
+ * level are always resident, so that every lookup resolves to a page.
+ *
+ * The page table holds one RGBA8_UINT texel per page of each level: the slot of the resident page across and down
+ * the cache, its level, and 1 in alpha. The feedback buffer holds one uint per page, for each level in turn.
+ */
+class VirtualTexture
+{
+  public:
+	/// Texels across a page, without its border
+	static constexpr uint32_t PAGE_SIZE = 128;
+
+	/// Texels copied from the neighbouring pages around each page, so that linear filtering does not need them
+	static constexpr uint32_t PAGE_BORDER = 1;
+
+	/**
+	 * @brief Splits an image into the pages of a tile file, generating the mip levels it lacks
+	 * @param image Image with a width and height multiple of PAGE_SIZE, and 8 or 16 bit unorm components
+	 *        unless it provides all the mip levels of the tile file
+	 * @return The contents of the tile file
+	 */
+	static std::vector<uint8_t> build_tiles(const sg::Image &image);
+
+	/**
+	 * @brief Creates the page cache and uploads the coarsest level of a tile file
+	 * @param device Device to create the resources on
+	 * @param tiles Mapped tile file, see build_tiles
+	 * @param cache_slots Pages across and down the physical cache
+	 * @param upload_budget Maximum number of pages streamed in per update
+	 * @throws std::runtime_error if the tile file is invalid or the coarsest level does not fit in the cache
+	 */
+	VirtualTexture(Device &device, fs::MappedFile &&tiles, uint32_t cache_slots = 8, uint32_t upload_budget = 8);
+
+	VirtualTexture(const VirtualTexture &) = delete;
+
+	VirtualTexture(VirtualTexture &&) = delete;
+
+	~VirtualTexture() = default;
+
+	VirtualTexture &operator=(const VirtualTexture &) = delete;
+
+	VirtualTexture &operator=(VirtualTexture &&) = delete;
+
+	/**
+	 * @brief Records clearing the feedback buffer, before the draws writing to it
+	 */
+	void reset_feedback(VkCommandBuffer command_buffer);
+
+	/**
+	 * @brief Records making the feedback written by the draws available to the host, after them
+	 */
+	void flush_feedback(VkCommandBuffer command_buffer);
+
+	/**
+	 * @brief Reads the feedback of the last frame and streams in the pages it requested
+	 *        The frame writing the feedback must have completed, and the uploads are complete on return
+	 */
+	void update();
+
+	/**
+	 * @return Descriptor of the physical page cache, sampled with linear filtering
+	 */
+	VkDescriptorImageInfo get_cache_descriptor() const;
+
+	/**
+	 * @return Descriptor of the page table, read with texelFetch by a usampler2D
+	 */
+	VkDescriptorImageInfo get_page_table_descriptor() const;
+
+	/**
+	 * @return Descriptor of the storage buffer the shaders flag the pages they need in
+	 */
+	VkDescriptorBufferInfo get_feedback_descriptor() const;
+
+	/**
+	 * @return Descriptor of the uniform buffer holding a VirtualTextureUniform
+	 */
+	VkDescriptorBufferInfo get_uniform_descriptor() const;
+
+	/**
+	 * @return Number of pages in the physical cache
+	 */
+	uint32_t get_resident_page_count() const;
+
+	/**
+	 * @return Number of pages requested by the last feedback and not yet resident
+	 */
+	uint32_t get_pending_page_count() const;
+
+  private:
+	struct Level
+	{
+		/// Pages across the level
+		uint32_t page_count_x;
+
+		/// Pages down the level
+		uint32_t page_count_y;
+
+		/// Index of the first page of the level, in the feedback and in the tile file
+		uint32_t first_page;
+	};
+
+	struct Slot
+	{
+		/// Page held by the slot, ~0 if the slot is free
+		uint32_t page{~0u};
+
+		/// Update the page was last requested in
+		uint64_t last_used{0};
+	};
+
+	/**
+	 * @return A slot for a new page, evicting the least recently used page if needed, or ~0 if every page is in use
+	 */
+	uint32_t acquire_slot();
+
+	/**
+	 * @brief Copies the pages to their slot and records the upload, along with the page table if it changed
+	 */
+	void upload_pages(VkQueue queue, const std::vector<uint32_t> &pages);
+
+	/**
+	 * @brief Points every page of the page table to its finest resident ancestor
+	 */
+	void update_page_table();
+
+	/**
+	 * @return The level a page belongs to
+	 */
+	uint32_t get_page_level(uint32_t page) const;
+
+	Device &device;
+
+	/// Mapped tile file the pages are read from
+	fs::MappedFile tiles;
+
+	/// Offset of the first page in the tile file
+	size_t data_offset{0};
+
+	/// Bytes of a page, including its border
+	size_t page_bytes{0};
+
+	VkFormat format{VK_FORMAT_UNDEFINED};
+
+	std::vector<Level> levels;
+
+	uint32_t page_count{0};
+
+	uint32_t cache_slots;
+
+	uint32_t upload_budget;
+
+	/// Slot of each page in the cache, ~0 if it is not resident
+	std::vector<uint32_t> page_slots;
+
+	std::vector<Slot> slots;
+
+	/// Slots free for new pages
+	std::vector<uint32_t> free_slots;
+
+	/// Pages requested by the last feedback and not resident, coarsest first
+	std::vector<uint32_t> requests;
+
+	/// Page table texels of every level, uploaded when they change
+	std::vector<uint32_t> page_table_data;
+
+	uint64_t update_count{0};
+
+	std::unique_ptr<core::Image> cache;
+
+	std::unique_ptr<core::ImageView> cache_view;
+
+	std::unique_ptr<core::Sampler> cache_sampler;
+
+	std::unique_ptr<core::Image> page_table;
+
+	std::unique_ptr<core::ImageView> page_table_view;
+
+	std::unique_ptr<core::Sampler> page_table_sampler;
+
+	std::unique_ptr<core::Buffer> feedback;
+
+	std::unique_ptr<core::Buffer> uniform;
+
+	std::unique_ptr<core::Buffer> staging;
+};
+}        // namespace vkb
@@ -17,8 +17,16 @@
 
 #include "resource_binding_state.h"
 
+#include "common/helpers.h"
+
 namespace vkb
 {
+ResourceBindingState::ResourceBindingState(MemoryArena *arena) :
+    arena{arena},
+    resource_sets{ArenaAllocator<std::pair<const uint32_t, ResourceSet>>{arena}}
+{
+}
+
 void ResourceBindingState::reset()
 {
 	clear_dirty();
@@ -38,40 +46,67 @@ void ResourceBindingState::clear_dirty()
 
 void ResourceBindingState::clear_dirty(uint32_t set)
 {
-	resource_sets[set].clear_dirty();
+	get_resource_set(set).clear_dirty();
 }
 
 void ResourceBindingState::bind_buffer(const core::Buffer &buffer, VkDeviceSize offset, VkDeviceSize range, uint32_t set, uint32_t binding, uint32_t array_element)
 {
-	resource_sets[set].bind_buffer(buffer, offset, range, binding, array_element);
+	get_resource_set(set).bind_buffer(buffer, offset, range, binding, array_element);
 
 	dirty = true;
 }
 
 void ResourceBindingState::bind_image(const core::ImageView &image_view, const core::Sampler &sampler, uint32_t set, uint32_t binding, uint32_t array_element)
 {
-	resource_sets[set].bind_image(image_view, sampler, binding, array_element);
+	get_resource_set(set).bind_image(image_view, sampler, binding, array_element);
 
 	dirty = true;
 }
 
 void ResourceBindingState::bind_input(const core::ImageView &image_view, uint32_t set, uint32_t binding, uint32_t array_element)
 {
-	resource_sets[set].bind_input(image_view, binding, array_element);
+	get_resource_set(set).bind_input(image_view, binding, array_element);
+
+	dirty = true;
+}
+
+void ResourceBindingState::bind_acceleration_structure(const core::AccelerationStructure &acceleration_structure, uint32_t set, uint32_t binding, uint32_t array_element)
+{
+	get_resource_set(set).bind_acceleration_structure(acceleration_structure, binding, array_element);
 
 	dirty = true;
 }
 
-const std::unordered_map<uint32_t, ResourceSet> &ResourceBindingState::get_resource_sets()
+const ResourceBindingState::ResourceSetMap &ResourceBindingState::get_resource_sets()
 {
 	return resource_sets;
 }
 
+ResourceSet &ResourceBindingState::get_resource_set(uint32_t set)
+{
+	auto set_it = resource_sets.find(set);
+
+	if (set_it == resource_sets.end())
+	{
+		// Resource sets are constructed explicitly so that their bindings share the arena
+		set_it = resource_sets.emplace(set, ResourceSet{arena}).first;
+	}
+
+	return set_it->second;
+}
+
+ResourceSet::ResourceSet(MemoryArena *arena) :
+    resource_bindings{ArenaAllocator<ResourceBinding>{arena}}
+{
+}
+
 void ResourceSet::reset()
 {
 	clear_dirty();
 
 	resource_bindings.clear();
+
+	hash = 0;
 }
 
 bool ResourceSet::is_dirty() const
@@ -86,39 +121,101 @@ void ResourceSet::clear_dirty()
 
 void ResourceSet::clear_dirty(uint32_t binding, uint32_t array_element)
 {
-	resource_bindings[binding][array_element].dirty = false;
+	get_resource_binding(binding, array_element).info.dirty = false;
 }
 
-void ResourceSet::bind_buffer(const core::Buffer &buffer, VkDeviceSize offset, VkDeviceSize range, uint32_t binding, uint32_t array_element)
+template <typename F>
+void ResourceSet::update_resource_binding(uint32_t binding, uint32_t array_element, F update)
 {
-	resource_bindings[binding][array_element].dirty  = true;
-	resource_bindings[binding][array_element].buffer = &buffer;
-	resource_bindings[binding][array_element].offset = offset;
-	resource_bindings[binding][array_element].range  = range;
+	auto &resource_binding = get_resource_binding(binding, array_element);
+
+	hash -= hash_resource_binding(resource_binding);
+
+	update(resource_binding.info);
+	resource_binding.info.dirty = true;
+
+	hash += hash_resource_binding(resource_binding);
 
 	dirty = true;
 }
 
-void ResourceSet::bind_image(const core::ImageView &image_view, const core::Sampler &sampler, uint32_t binding, uint32_t array_element)
+void ResourceSet::bind_buffer(const core::Buffer &buffer, VkDeviceSize offset, VkDeviceSize range, uint32_t binding, uint32_t array_element)
 {
-	resource_bindings[binding][array_element].dirty      = true;
-	resource_bindings[binding][array_element].image_view = &image_view;
-	resource_bindings[binding][array_element].sampler    = &sampler;
+	update_resource_binding(binding, array_element, [&](ResourceInfo &resource_info) {
+		resource_info.buffer = &buffer;
+		resource_info.offset = offset;
+		resource_info.range  = range;
+	});
+}
 
-	dirty = true;
+void ResourceSet::bind_image(const core::ImageView &image_view, const core::Sampler &sampler, uint32_t binding, uint32_t array_element)
+{
+	update_resource_binding(binding, array_element, [&](ResourceInfo &resource_info) {
+		resource_info.image_view = &image_view;
+		resource_info.sampler    = &sampler;
+	});
 }
 
 void ResourceSet::bind_input(const core::ImageView &image_view, const uint32_t binding, const uint32_t array_element)
 {
-	resource_bindings[binding][array_element].dirty      = true;
-	resource_bindings[binding][array_element].image_view = &image_view;
+	update_resource_binding(binding, array_element, [&](ResourceInfo &resource_info) {
+		resource_info.image_view = &image_view;
+	});
+}
 
-	dirty = true;
+void ResourceSet::bind_acceleration_structure(const core::AccelerationStructure &acceleration_structure, uint32_t binding, uint32_t array_element)
+{
+	update_resource_binding(binding, array_element, [&](ResourceInfo &resource_info) {
+		resource_info.acceleration_structure = &acceleration_structure;
+	});
 }
 
-const BindingMap<ResourceInfo> &ResourceSet::get_resource_bindings() const
+const ResourceSet::ResourceBindings &ResourceSet::get_resource_bindings() const
 {
 	return resource_bindings;
 }
 
+size_t ResourceSet::get_hash() const
+{
+	return hash;
+}
+
+ResourceBinding &ResourceSet::get_resource_binding(uint32_t binding, uint32_t array_element)
+{
+	auto binding_it = std::lower_bound(resource_bindings.begin(), resource_bindings.end(), std::make_pair(binding, array_element),
+	                                   [](const ResourceBinding &resource_binding, const std::pair<uint32_t, uint32_t> &key) {
+		                                   return std::make_pair(resource_binding.binding, resource_binding.array_element) < key;
+	                                   });
+
+	if (binding_it == resource_bindings.end() || binding_it->binding != binding || binding_it->array_element != array_element)
+	{
+		ResourceBinding resource_binding;
+		resource_binding.binding       = binding;
+		resource_binding.array_element = array_element;
+
+		binding_it = resource_bindings.insert(binding_it, resource_binding);
+
+		hash += hash_resource_binding(*binding_it);
+	}
+
+	return *binding_it;
+}
+
+size_t ResourceSet::hash_resource_binding(const ResourceBinding &resource_binding)
+{
+	// The dirty flag is left out, it does not change the descriptor set built from the binding
+	size_t result{0};
+
+	hash_combine(result, resource_binding.binding);
+	hash_combine(result, resource_binding.array_element);
+	hash_combine(result, resource_binding.info.buffer);
+	hash_combine(result, resource_binding.info.offset);
+	hash_combine(result, resource_binding.info.range);
+	hash_combine(result, resource_binding.info.image_view);
+	hash_combine(result, resource_binding.info.sampler);
+	hash_combine(result, resource_binding.info.acceleration_structure);
+
+	return result;
+}
+
 }        // namespace vkb
@@ -18,9 +18,11 @@
 #pragma once
 
 #include "common/vk_common.h"
+#include "core/acceleration_structure.h"
 #include "core/buffer.h"
 #include "core/image_view.h"
 #include "core/sampler.h"
+#include "memory_arena.h"
 
 namespace vkb
 {
@@ -42,6 +44,20 @@ struct ResourceInfo
 	const core::ImageView *image_view{nullptr};
 
 	const core::Sampler *sampler{nullptr};
+
+	const core::AccelerationStructure *acceleration_structure{nullptr};
+};
+
+/**
+ * @brief A resource bound to an array element of a binding
+ */
+struct ResourceBinding
+{
+	uint32_t binding{0};
+
+	uint32_t array_element{0};
+
+	ResourceInfo info;
 };
 
 /**
@@ -53,6 +69,13 @@ struct ResourceInfo
 class ResourceSet
 {
   public:
+	using ResourceBindings = std::vector<ResourceBinding, ArenaAllocator<ResourceBinding>>;
+
+	/**
+	 * @param arena The arena bindings are allocated from, or null to use the heap
+	 */
+	ResourceSet(MemoryArena *arena = nullptr);
+
 	void reset();
 
 	bool is_dirty() const;
@@ -67,12 +90,39 @@ class ResourceSet
 
 	void bind_input(const core::ImageView &image_view, uint32_t binding, uint32_t array_element);
 
-	const BindingMap<ResourceInfo> &get_resource_bindings() const;
+	void bind_acceleration_structure(const core::AccelerationStructure &acceleration_structure, uint32_t binding, uint32_t array_element);
+
+	/**
+	 * @return The bound resources, sorted by binding and array element
+	 */
+	const ResourceBindings &get_resource_bindings() const;
+
+	/**
+	 * @return A hash of the bound resources, kept up to date by every bind
+	 */
+	size_t get_hash() const;
 
   private:
 	bool dirty{false};
 
-	BindingMap<ResourceInfo> resource_bindings;
+	/// Flat list of bindings sorted by binding and array element
+	ResourceBindings resource_bindings;
+
+	/// Sum of the hashes of all the resource bindings, so that a bind only replaces the hash of one entry
+	size_t hash{0};
+
+	ResourceBinding &get_resource_binding(uint32_t binding, uint32_t array_element);
+
+	/**
+	 * @brief Updates a resource binding, keeping the hash of the set in sync
+	 * @param binding The binding to update
+	 * @param array_element The array element to update
+	 * @param update A function modifying the resource info
+	 */
+	template <typename F>
+	void update_resource_binding(uint32_t binding, uint32_t array_element, F update);
+
+	static size_t hash_resource_binding(const ResourceBinding &resource_binding);
 };
 
 /**
@@ -84,6 +134,13 @@ class ResourceSet
 class ResourceBindingState
 {
   public:
+	using ResourceSetMap = std::unordered_map<uint32_t, ResourceSet, std::hash<uint32_t>, std::equal_to<uint32_t>, ArenaAllocator<std::pair<const uint32_t, ResourceSet>>>;
+
+	/**
+	 * @param arena The arena resource sets are allocated from, or null to use the heap
+	 */
+	ResourceBindingState(MemoryArena *arena = nullptr);
+
 	void reset();
 
 	bool is_dirty();
@@ -98,11 +155,17 @@ class ResourceBindingState
 
 	void bind_input(const core::ImageView &image_view, uint32_t set, uint32_t binding, uint32_t array_element);
 
-	const std::unordered_map<uint32_t, ResourceSet> &get_resource_sets();
+	void bind_acceleration_structure(const core::AccelerationStructure &acceleration_structure, uint32_t set, uint32_t binding, uint32_t array_element);
+
+	const ResourceSetMap &get_resource_sets();
 
   private:
 	bool dirty{false};
 
-	std::unordered_map<uint32_t, ResourceSet> resource_sets;
+	MemoryArena *arena;
+
+	ResourceSetMap resource_sets;
+
+	ResourceSet &get_resource_set(uint32_t set);
 };
 }        // namespace vkb
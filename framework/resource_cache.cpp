@@ -17,22 +17,229 @@
 
 #include "resource_cache.h"
 
+#include <algorithm>
+#include <unordered_set>
+
 #include "common/resource_caching.h"
 #include "core/device.h"
+#include "job_system.h"
+#include "stats/cpu_profiler.h"
 
 namespace vkb
 {
 namespace
 {
+#ifdef VKB_DEBUG_MARKERS
+template <class Handle>
+void set_debug_name(Device &device, VkObjectType object_type, Handle handle, const char *type_name, std::size_t hash)
+{
+	device.set_debug_name(object_type, reinterpret_cast<uint64_t>(handle), fmt::format("{} {:016x}", type_name, hash).c_str());
+}
+
+template <class T>
+void set_debug_name(Device & /*device*/, T & /*resource*/, std::size_t /*hash*/)
+{
+	// Shader modules and descriptor pools do not wrap a single Vulkan object
+}
+
+void set_debug_name(Device &device, PipelineLayout &resource, std::size_t hash)
+{
+	set_debug_name(device, VK_OBJECT_TYPE_PIPELINE_LAYOUT, resource.get_handle(), "PipelineLayout", hash);
+}
+
+void set_debug_name(Device &device, DescriptorSetLayout &resource, std::size_t hash)
+{
+	set_debug_name(device, VK_OBJECT_TYPE_DESCRIPTOR_SET_LAYOUT, resource.get_handle(), "DescriptorSetLayout", hash);
+}
+
+void set_debug_name(Device &device, DescriptorSet &resource, std::size_t hash)
+{
+	set_debug_name(device, VK_OBJECT_TYPE_DESCRIPTOR_SET, resource.get_handle(), "DescriptorSet", hash);
+}
+
+void set_debug_name(Device &device, RenderPass &resource, std::size_t hash)
+{
+	set_debug_name(device, VK_OBJECT_TYPE_RENDER_PASS, resource.get_handle(), "RenderPass", hash);
+}
+
+void set_debug_name(Device &device, Framebuffer &resource, std::size_t hash)
+{
+	set_debug_name(device, VK_OBJECT_TYPE_FRAMEBUFFER, resource.get_handle(), "Framebuffer", hash);
+}
+
+void set_debug_name(Device &device, GraphicsPipeline &resource, std::size_t hash)
+{
+	set_debug_name(device, VK_OBJECT_TYPE_PIPELINE, resource.get_handle(), "GraphicsPipeline", hash);
+}
+
+void set_debug_name(Device &device, ComputePipeline &resource, std::size_t hash)
+{
+	set_debug_name(device, VK_OBJECT_TYPE_PIPELINE, resource.get_handle(), "ComputePipeline", hash);
+}
+
+void set_debug_name(Device &device, core::Sampler &resource, std::size_t hash)
+{
+	set_debug_name(device, VK_OBJECT_TYPE_SAMPLER, resource.get_handle(), "Sampler", hash);
+}
+#endif
+
 template <class T, class... A>
-T &request_resource(Device &device, ResourceRecord &recorder, std::mutex &resource_mutex, std::unordered_map<std::size_t, T> &resources, A &... args)
+T &request_resource(Device &device, ResourceRecord &recorder, std::mutex &resource_mutex, std::unordered_map<std::size_t, T> &resources, ResourceIndex<T> &index, bool concurrent_lookup, uint64_t frame_index, A &... args)
 {
-	std::lock_guard<std::mutex> guard(resource_mutex);
+	// Objects of the types with a budget are stamped with the frame of their last request
+	bool        hashed = concurrent_lookup || index.budget > 0;
+	std::size_t hash{0U};
+
+	if (hashed)
+	{
+		hash_param(hash, args...);
+	}
+
+	if (concurrent_lookup)
+	{
+		auto snapshot = std::atomic_load(&index.snapshot);
+
+		if (snapshot)
+		{
+			auto res_it = snapshot->find(hash);
+
+			if (res_it != snapshot->end())
+			{
+				index.hits.fetch_add(1, std::memory_order_relaxed);
+
+				if (res_it->second.last_used)
+				{
+					res_it->second.last_used->store(frame_index, std::memory_order_relaxed);
+				}
+
+#ifdef VKB_VERIFY_CACHE_KEYS
+				if (!matches_key(*res_it->second.resource, args...))
+				{
+					throw std::runtime_error{std::string{"Hash collision of cache object ("} + typeid(T).name() + ")"};
+				}
+#endif
+				return *res_it->second.resource;
+			}
+		}
+	}
+
+	std::unique_lock<std::mutex> guard(resource_mutex, std::try_to_lock);
+
+	if (!guard.owns_lock())
+	{
+		index.contentions.fetch_add(1, std::memory_order_relaxed);
+		guard.lock();
+	}
+
+	size_t resource_count = resources.size();
 
 	auto &res = request_resource(device, &recorder, resources, args...);
 
+	if (index.budget > 0)
+	{
+		index.last_used[hash].store(frame_index, std::memory_order_relaxed);
+	}
+
+	if (resources.size() == resource_count)
+	{
+		index.hits.fetch_add(1, std::memory_order_relaxed);
+	}
+	else
+	{
+		index.misses.fetch_add(1, std::memory_order_relaxed);
+
+		if (!hashed)
+		{
+			hash_param(hash, args...);
+		}
+
+		index.created[hash] = {frame_index, std::chrono::steady_clock::now()};
+
+		if (concurrent_lookup)
+		{
+			index.publish(resources);
+		}
+
+#ifdef VKB_DEBUG_MARKERS
+		// Objects are named after the hash they are cached with, so that captures tell apart the variants of a type
+		set_debug_name(device, res, hash);
+#endif
+	}
+
 	return res;
 }
+
+template <class T>
+void accumulate_creation_stats(PipelineCreationStats &stats, const std::unordered_map<std::size_t, T> &pipelines)
+{
+	for (auto &it : pipelines)
+	{
+		auto &feedback = it.second.get_creation_feedback();
+
+		stats.pipeline_count++;
+		stats.feedback_count += feedback.valid ? 1 : 0;
+		stats.cache_hits += feedback.cache_hit ? 1 : 0;
+		stats.total_duration += feedback.duration;
+		stats.max_duration = std::max(stats.max_duration, feedback.duration);
+	}
+}
+template <class T>
+void set_resource_budget(std::unordered_map<std::size_t, T> &resources, ResourceIndex<T> &index, size_t budget, uint64_t frame_index)
+{
+	index.budget = budget;
+	index.last_used.clear();
+
+	if (budget > 0)
+	{
+		// Objects cached before the budget was set count as requested by the current frame
+		for (auto &it : resources)
+		{
+			index.last_used[it.first].store(frame_index, std::memory_order_relaxed);
+		}
+	}
+}
+
+template <class T>
+size_t evict_resources(std::unordered_map<std::size_t, T> &resources, ResourceIndex<T> &index, uint64_t oldest_frame_in_flight, bool concurrent_lookup)
+{
+	if (index.budget == 0 || resources.size() <= index.budget)
+	{
+		return 0;
+	}
+
+	// Only objects which no frame in flight has requested can be destroyed
+	std::vector<std::pair<uint64_t, std::size_t>> candidates;
+
+	for (auto &it : index.last_used)
+	{
+		auto last_used = it.second.load(std::memory_order_relaxed);
+
+		if (last_used < oldest_frame_in_flight)
+		{
+			candidates.emplace_back(last_used, it.first);
+		}
+	}
+
+	size_t eviction_count = std::min(resources.size() - index.budget, candidates.size());
+
+	std::partial_sort(candidates.begin(), candidates.begin() + eviction_count, candidates.end());
+
+	for (size_t i = 0; i < eviction_count; ++i)
+	{
+		resources.erase(candidates[i].second);
+		index.last_used.erase(candidates[i].second);
+		index.created.erase(candidates[i].second);
+	}
+
+	index.evictions.fetch_add(eviction_count, std::memory_order_relaxed);
+
+	if (eviction_count > 0 && concurrent_lookup)
+	{
+		index.publish(resources);
+	}
+
+	return eviction_count;
+}
 }        // namespace
 
 ResourceCache::ResourceCache(Device &device) :
@@ -40,14 +247,31 @@ ResourceCache::ResourceCache(Device &device) :
 {
 }
 
-void ResourceCache::warmup(const std::vector<uint8_t> &data)
+ResourceCache::~ResourceCache()
 {
-	recorder.set_data(data);
+	// Wait for background compilations, as they refer to the device
+	for (auto &pending_shader_module : pending_shader_modules)
+	{
+		JobSystem::get().wait(pending_shader_module.second);
+	}
+}
+
+void ResourceCache::warmup(const std::vector<uint8_t> &data, uint32_t thread_count)
+{
+	warmup(data.data(), data.size(), thread_count);
+}
+
+void ResourceCache::warmup(const uint8_t *data, size_t size, uint32_t thread_count)
+{
+	replayer.play(*this, data, size, thread_count);
+}
 
-	replayer.play(*this, recorder);
+const ResourceReplayStats &ResourceCache::get_warmup_stats() const
+{
+	return replayer.get_stats();
 }
 
-std::vector<uint8_t> ResourceCache::serialize()
+const std::vector<uint8_t> &ResourceCache::serialize() const
 {
 	return recorder.get_data();
 }
@@ -57,50 +281,391 @@ void ResourceCache::set_pipeline_cache(VkPipelineCache new_pipeline_cache)
 	pipeline_cache = new_pipeline_cache;
 }
 
+VkPipelineCache ResourceCache::get_pipeline_cache() const
+{
+	return pipeline_cache;
+}
+
+Device &ResourceCache::get_device()
+{
+	return device;
+}
+
+void ResourceCache::set_concurrent_lookup(bool enable)
+{
+	if (enable == concurrent_lookup)
+	{
+		return;
+	}
+
+	concurrent_lookup = enable;
+
+	if (concurrent_lookup)
+	{
+		// Publish the objects which have been cached so far
+		shader_module_index.publish(state.shader_modules);
+		pipeline_layout_index.publish(state.pipeline_layouts);
+		descriptor_set_layout_index.publish(state.descriptor_set_layouts);
+		descriptor_pool_index.publish(state.descriptor_pools);
+		render_pass_index.publish(state.render_passes);
+		graphics_pipeline_index.publish(state.graphics_pipelines);
+		compute_pipeline_index.publish(state.compute_pipelines);
+		descriptor_set_index.publish(state.descriptor_sets);
+		framebuffer_index.publish(state.framebuffers);
+		sampler_index.publish(state.samplers);
+	}
+	else
+	{
+		shader_module_index.clear();
+		pipeline_layout_index.clear();
+		descriptor_set_layout_index.clear();
+		descriptor_pool_index.clear();
+		render_pass_index.clear();
+		graphics_pipeline_index.clear();
+		compute_pipeline_index.clear();
+		descriptor_set_index.clear();
+		framebuffer_index.clear();
+		sampler_index.clear();
+	}
+}
+
+bool ResourceCache::is_concurrent_lookup() const
+{
+	return concurrent_lookup;
+}
+
+ResourceCacheStats ResourceCache::get_stats() const
+{
+	ResourceCacheStats stats;
+
+	stats.shader_modules         = shader_module_index.get_counters();
+	stats.pipeline_layouts       = pipeline_layout_index.get_counters();
+	stats.descriptor_set_layouts = descriptor_set_layout_index.get_counters();
+	stats.descriptor_pools       = descriptor_pool_index.get_counters();
+	stats.render_passes          = render_pass_index.get_counters();
+	stats.graphics_pipelines     = graphics_pipeline_index.get_counters();
+	stats.compute_pipelines      = compute_pipeline_index.get_counters();
+	stats.descriptor_sets        = descriptor_set_index.get_counters();
+	stats.framebuffers           = framebuffer_index.get_counters();
+	stats.samplers               = sampler_index.get_counters();
+
+	return stats;
+}
+
+PipelineCreationStats ResourceCache::get_pipeline_creation_stats()
+{
+	PipelineCreationStats stats;
+
+	{
+		std::lock_guard<std::mutex> guard(graphics_pipeline_mutex);
+		accumulate_creation_stats(stats, state.graphics_pipelines);
+	}
+
+	{
+		std::lock_guard<std::mutex> guard(compute_pipeline_mutex);
+		accumulate_creation_stats(stats, state.compute_pipelines);
+	}
+
+	return stats;
+}
+
+ResourceCacheUsage ResourceCache::get_usage() const
+{
+	ResourceCacheUsage usage;
+
+	usage.shader_modules         = shader_module_index.get_usage(creation_time);
+	usage.pipeline_layouts       = pipeline_layout_index.get_usage(creation_time);
+	usage.descriptor_set_layouts = descriptor_set_layout_index.get_usage(creation_time);
+	usage.descriptor_pools       = descriptor_pool_index.get_usage(creation_time);
+	usage.render_passes          = render_pass_index.get_usage(creation_time);
+	usage.graphics_pipelines     = graphics_pipeline_index.get_usage(creation_time);
+	usage.compute_pipelines      = compute_pipeline_index.get_usage(creation_time);
+	usage.descriptor_sets        = descriptor_set_index.get_usage(creation_time);
+	usage.framebuffers           = framebuffer_index.get_usage(creation_time);
+	usage.samplers               = sampler_index.get_usage(creation_time);
+
+	return usage;
+}
+
+void ResourceCache::reset_stats()
+{
+	shader_module_index.reset_counters();
+	pipeline_layout_index.reset_counters();
+	descriptor_set_layout_index.reset_counters();
+	descriptor_pool_index.reset_counters();
+	render_pass_index.reset_counters();
+	graphics_pipeline_index.reset_counters();
+	compute_pipeline_index.reset_counters();
+	descriptor_set_index.reset_counters();
+	framebuffer_index.reset_counters();
+	sampler_index.reset_counters();
+}
+
+void ResourceCache::set_budget(const ResourceCacheBudget &budget)
+{
+	set_resource_budget(state.descriptor_sets, descriptor_set_index, budget.descriptor_sets, frame_index);
+	set_resource_budget(state.framebuffers, framebuffer_index, budget.framebuffers, frame_index);
+	set_resource_budget(state.graphics_pipelines, graphics_pipeline_index, budget.graphics_pipelines, frame_index);
+	set_resource_budget(state.compute_pipelines, compute_pipeline_index, budget.compute_pipelines, frame_index);
+
+	if (concurrent_lookup)
+	{
+		// The snapshots point to the stamps which have just been replaced
+		descriptor_set_index.publish(state.descriptor_sets);
+		framebuffer_index.publish(state.framebuffers);
+		graphics_pipeline_index.publish(state.graphics_pipelines);
+		compute_pipeline_index.publish(state.compute_pipelines);
+	}
+}
+
+ResourceCacheBudget ResourceCache::get_budget() const
+{
+	ResourceCacheBudget budget;
+
+	budget.descriptor_sets    = descriptor_set_index.budget;
+	budget.framebuffers       = framebuffer_index.budget;
+	budget.graphics_pipelines = graphics_pipeline_index.budget;
+	budget.compute_pipelines  = compute_pipeline_index.budget;
+
+	return budget;
+}
+
+size_t ResourceCache::begin_frame(uint64_t new_frame_index, uint64_t oldest_frame_in_flight)
+{
+	frame_index = new_frame_index;
+
+	size_t descriptor_set_evictions = evict_resources(state.descriptor_sets, descriptor_set_index, oldest_frame_in_flight, concurrent_lookup);
+
+	if (descriptor_set_evictions > 0)
+	{
+		// Sets are not freed individually, only the pools of the layouts which have no set left can be reset
+		std::unordered_set<const DescriptorSetLayout *> used_layouts;
+
+		for (auto &it : state.descriptor_sets)
+		{
+			used_layouts.insert(&it.second.get_layout());
+		}
+
+		for (auto &it : state.descriptor_pools)
+		{
+			if (used_layouts.count(&it.second.get_descriptor_set_layout()) == 0)
+			{
+				it.second.reset();
+			}
+		}
+	}
+
+	return descriptor_set_evictions +
+	       evict_resources(state.framebuffers, framebuffer_index, oldest_frame_in_flight, concurrent_lookup) +
+	       evict_resources(state.graphics_pipelines, graphics_pipeline_index, oldest_frame_in_flight, concurrent_lookup) +
+	       evict_resources(state.compute_pipelines, compute_pipeline_index, oldest_frame_in_flight, concurrent_lookup);
+}
+
 ShaderModule &ResourceCache::request_shader_module(VkShaderStageFlagBits stage, const ShaderSource &glsl_source, const ShaderVariant &shader_variant)
 {
+	PROFILE_FUNCTION();
+
+	std::string entry_point{"main"};
+	return request_resource(device, recorder, shader_module_mutex, state.shader_modules, shader_module_index, concurrent_lookup, frame_index, stage, glsl_source, entry_point, shader_variant);
+}
+
+ShaderModule *ResourceCache::request_shader_module_async(VkShaderStageFlagBits stage, const ShaderSource &glsl_source, const ShaderVariant &shader_variant)
+{
+	PROFILE_FUNCTION();
+
 	std::string entry_point{"main"};
-	return request_resource(device, recorder, shader_module_mutex, state.shader_modules, stage, glsl_source, entry_point, shader_variant);
+
+	std::size_t hash{0U};
+	hash_param(hash, stage, glsl_source, entry_point, shader_variant);
+
+	if (concurrent_lookup)
+	{
+		if (auto snapshot = std::atomic_load(&shader_module_index.snapshot))
+		{
+			auto res_it = snapshot->find(hash);
+
+			if (res_it != snapshot->end())
+			{
+				shader_module_index.hits.fetch_add(1, std::memory_order_relaxed);
+
+				return res_it->second.resource;
+			}
+		}
+	}
+
+	std::lock_guard<std::mutex> guard(shader_module_mutex);
+
+	auto pending_it = pending_shader_modules.find(hash);
+
+	auto res_it = state.shader_modules.find(hash);
+
+	if (res_it != state.shader_modules.end())
+	{
+		// A synchronous request may have built it in the meantime
+		if (pending_it != pending_shader_modules.end())
+		{
+			pending_shader_modules.erase(pending_it);
+		}
+
+		shader_module_index.hits.fetch_add(1, std::memory_order_relaxed);
+
+		return &res_it->second;
+	}
+
+	if (pending_it == pending_shader_modules.end())
+	{
+		LOGD("Queueing background compilation of shader \"{}\"", glsl_source.get_filename());
+
+		pending_shader_modules.emplace(hash, JobSystem::get().push([this, stage, glsl_source, entry_point, shader_variant](size_t) {
+			return ShaderModule{device, stage, glsl_source, entry_point, shader_variant};
+		},
+		                                                                   JobPriority::Low));
+
+		return nullptr;
+	}
+
+	if (pending_it->second.wait_for(std::chrono::seconds(0)) != std::future_status::ready)
+	{
+		return nullptr;
+	}
+
+	auto future = std::move(pending_it->second);
+	pending_shader_modules.erase(pending_it);
+
+	shader_module_index.misses.fetch_add(1, std::memory_order_relaxed);
+	shader_module_index.created[hash] = {frame_index, std::chrono::steady_clock::now()};
+
+	auto &shader_module = insert_resource(&recorder, state.shader_modules, future.get(), stage, glsl_source, entry_point, shader_variant);
+
+	if (concurrent_lookup)
+	{
+		shader_module_index.publish(state.shader_modules);
+	}
+
+	return &shader_module;
+}
+
+size_t ResourceCache::get_pending_shader_module_count()
+{
+	std::lock_guard<std::mutex> guard(shader_module_mutex);
+
+	return pending_shader_modules.size();
+}
+
+std::vector<ShaderModule *> ResourceCache::get_shader_modules()
+{
+	std::lock_guard<std::mutex> guard(shader_module_mutex);
+
+	std::vector<ShaderModule *> shader_modules;
+	shader_modules.reserve(state.shader_modules.size());
+
+	for (auto &it : state.shader_modules)
+	{
+		shader_modules.push_back(&it.second);
+	}
+
+	return shader_modules;
 }
 
 PipelineLayout &ResourceCache::request_pipeline_layout(const std::vector<ShaderModule *> &shader_modules)
 {
-	return request_resource(device, recorder, pipeline_layout_mutex, state.pipeline_layouts, shader_modules);
+	PROFILE_FUNCTION();
+
+	return request_resource(device, recorder, pipeline_layout_mutex, state.pipeline_layouts, pipeline_layout_index, concurrent_lookup, frame_index, shader_modules);
 }
 
 DescriptorSetLayout &ResourceCache::request_descriptor_set_layout(const uint32_t set_index, const std::vector<ShaderResource> &set_resources)
 {
-	return request_resource(device, recorder, descriptor_set_layout_mutex, state.descriptor_set_layouts, set_index, set_resources);
+	PROFILE_FUNCTION();
+
+	return request_resource(device, recorder, descriptor_set_layout_mutex, state.descriptor_set_layouts, descriptor_set_layout_index, concurrent_lookup, frame_index, set_index, set_resources);
 }
 
 GraphicsPipeline &ResourceCache::request_graphics_pipeline(PipelineState &pipeline_state)
 {
-	return request_resource(device, recorder, graphics_pipeline_mutex, state.graphics_pipelines, pipeline_cache, pipeline_state);
+	PROFILE_FUNCTION();
+
+	return request_resource(device, recorder, graphics_pipeline_mutex, state.graphics_pipelines, graphics_pipeline_index, concurrent_lookup, frame_index, pipeline_cache, pipeline_state);
 }
 
 ComputePipeline &ResourceCache::request_compute_pipeline(PipelineState &pipeline_state)
 {
-	return request_resource(device, recorder, compute_pipeline_mutex, state.compute_pipelines, pipeline_cache, pipeline_state);
+	PROFILE_FUNCTION();
+
+	return request_resource(device, recorder, compute_pipeline_mutex, state.compute_pipelines, compute_pipeline_index, concurrent_lookup, frame_index, pipeline_cache, pipeline_state);
+}
+
+GraphicsPipeline &ResourceCache::add_graphics_pipeline(PipelineState &pipeline_state, GraphicsPipeline &&graphics_pipeline)
+{
+	std::lock_guard<std::mutex> guard(graphics_pipeline_mutex);
+
+	size_t resource_count = state.graphics_pipelines.size();
+
+	auto &res = insert_resource(&recorder, state.graphics_pipelines, std::move(graphics_pipeline), pipeline_cache, pipeline_state);
+
+	std::size_t hash{0U};
+	hash_param(hash, pipeline_cache, pipeline_state);
+
+	if (graphics_pipeline_index.budget > 0)
+	{
+		graphics_pipeline_index.last_used[hash].store(frame_index, std::memory_order_relaxed);
+	}
+
+	if (state.graphics_pipelines.size() != resource_count)
+	{
+		graphics_pipeline_index.misses.fetch_add(1, std::memory_order_relaxed);
+		graphics_pipeline_index.created[hash] = {frame_index, std::chrono::steady_clock::now()};
+
+		if (concurrent_lookup)
+		{
+			graphics_pipeline_index.publish(state.graphics_pipelines);
+		}
+	}
+
+	return res;
 }
 
-DescriptorSet &ResourceCache::request_descriptor_set(DescriptorSetLayout &descriptor_set_layout, const BindingMap<VkDescriptorBufferInfo> &buffer_infos, const BindingMap<VkDescriptorImageInfo> &image_infos)
+DescriptorSet &ResourceCache::request_descriptor_set(DescriptorSetLayout &descriptor_set_layout, const BindingMap<VkDescriptorBufferInfo> &buffer_infos, const BindingMap<VkDescriptorImageInfo> &image_infos,
+                                                     const BindingMap<VkAccelerationStructureKHR> &acceleration_structure_infos)
 {
-	auto &descriptor_pool = request_resource(device, recorder, descriptor_set_mutex, state.descriptor_pools, descriptor_set_layout);
-	return request_resource(device, recorder, descriptor_set_mutex, state.descriptor_sets, descriptor_set_layout, descriptor_pool, buffer_infos, image_infos);
+	PROFILE_FUNCTION();
+
+	auto &descriptor_pool = request_resource(device, recorder, descriptor_set_mutex, state.descriptor_pools, descriptor_pool_index, concurrent_lookup, frame_index, descriptor_set_layout);
+	return request_resource(device, recorder, descriptor_set_mutex, state.descriptor_sets, descriptor_set_index, concurrent_lookup, frame_index, descriptor_set_layout, descriptor_pool, buffer_infos, image_infos, acceleration_structure_infos);
 }
 
 RenderPass &ResourceCache::request_render_pass(const std::vector<Attachment> &attachments, const std::vector<LoadStoreInfo> &load_store_infos, const std::vector<SubpassInfo> &subpasses)
 {
-	return request_resource(device, recorder, render_pass_mutex, state.render_passes, attachments, load_store_infos, subpasses);
+	PROFILE_FUNCTION();
+
+	return request_resource(device, recorder, render_pass_mutex, state.render_passes, render_pass_index, concurrent_lookup, frame_index, attachments, load_store_infos, subpasses);
 }
 
 Framebuffer &ResourceCache::request_framebuffer(const RenderTarget &render_target, const RenderPass &render_pass)
 {
-	return request_resource(device, recorder, framebuffer_mutex, state.framebuffers, render_target, render_pass);
+	PROFILE_FUNCTION();
+
+	return request_resource(device, recorder, framebuffer_mutex, state.framebuffers, framebuffer_index, concurrent_lookup, frame_index, render_target, render_pass);
+}
+
+core::Sampler &ResourceCache::request_sampler(const VkSamplerCreateInfo &info)
+{
+	PROFILE_FUNCTION();
+
+	assert(info.pNext == nullptr && "Chained sampler creation structures are not part of the cache key");
+
+	return request_resource(device, recorder, sampler_mutex, state.samplers, sampler_index, concurrent_lookup, frame_index, info);
 }
 
 void ResourceCache::clear_pipelines()
 {
+	graphics_pipeline_index.clear();
+	compute_pipeline_index.clear();
+	graphics_pipeline_index.last_used.clear();
+	compute_pipeline_index.last_used.clear();
+	graphics_pipeline_index.created.clear();
+	compute_pipeline_index.created.clear();
+
 	state.graphics_pipelines.clear();
 	state.compute_pipelines.clear();
 }
@@ -183,25 +748,78 @@ void ResourceCache::update_descriptor_sets(const std::vector<core::ImageView> &o
 
 		// Generate new key
 		size_t new_key = 0U;
-		hash_param(new_key, descriptor_set.get_layout(), descriptor_set.get_buffer_infos(), descriptor_set.get_image_infos());
+		hash_param(new_key, descriptor_set.get_layout(), descriptor_set.get_buffer_infos(), descriptor_set.get_image_infos(), descriptor_set.get_acceleration_structure_infos());
 
 		// Add (key, resource) to the cache
 		state.descriptor_sets.emplace(new_key, std::move(descriptor_set));
+
+		// Keep when the set was last requested under its new key
+		auto last_used_it = descriptor_set_index.last_used.find(match);
+		if (last_used_it != descriptor_set_index.last_used.end())
+		{
+			auto last_used = last_used_it->second.load(std::memory_order_relaxed);
+			descriptor_set_index.last_used.erase(last_used_it);
+			descriptor_set_index.last_used[new_key].store(last_used, std::memory_order_relaxed);
+		}
+
+		auto created_it = descriptor_set_index.created.find(match);
+		if (created_it != descriptor_set_index.created.end())
+		{
+			auto creation = created_it->second;
+			descriptor_set_index.created.erase(created_it);
+			descriptor_set_index.created[new_key] = creation;
+		}
+	}
+
+	if (concurrent_lookup && !matches.empty())
+	{
+		descriptor_set_index.publish(state.descriptor_sets);
 	}
 }
 
 void ResourceCache::clear_framebuffers()
 {
+	framebuffer_index.clear();
+	framebuffer_index.last_used.clear();
+	framebuffer_index.created.clear();
+
 	state.framebuffers.clear();
 }
 
+std::unordered_map<std::size_t, Framebuffer> ResourceCache::release_framebuffers()
+{
+	framebuffer_index.clear();
+	framebuffer_index.last_used.clear();
+	framebuffer_index.created.clear();
+
+	std::unordered_map<std::size_t, Framebuffer> framebuffers;
+	std::swap(framebuffers, state.framebuffers);
+
+	return framebuffers;
+}
+
 void ResourceCache::clear()
 {
+	shader_module_index.clear();
+	pipeline_layout_index.clear();
+	descriptor_set_index.clear();
+	descriptor_set_layout_index.clear();
+	render_pass_index.clear();
+	sampler_index.clear();
+	descriptor_set_index.last_used.clear();
+	shader_module_index.created.clear();
+	pipeline_layout_index.created.clear();
+	descriptor_set_index.created.clear();
+	descriptor_set_layout_index.created.clear();
+	render_pass_index.created.clear();
+	sampler_index.created.clear();
+
 	state.shader_modules.clear();
 	state.pipeline_layouts.clear();
 	state.descriptor_sets.clear();
 	state.descriptor_set_layouts.clear();
 	state.render_passes.clear();
+	state.samplers.clear();
 	clear_pipelines();
 	clear_framebuffers();
 }
@@ -17,6 +17,11 @@
 
 #pragma once
 
+#include <atomic>
+#include <chrono>
+#include <future>
+#include <memory>
+#include <mutex>
 #include <string>
 #include <unordered_map>
 #include <vector>
@@ -27,6 +32,7 @@
 #include "core/descriptor_set_layout.h"
 #include "core/framebuffer.h"
 #include "core/pipeline.h"
+#include "core/sampler.h"
 #include "resource_record.h"
 #include "resource_replay.h"
 
@@ -62,6 +68,255 @@ struct ResourceCacheState
 	std::unordered_map<std::size_t, DescriptorSet> descriptor_sets;
 
 	std::unordered_map<std::size_t, Framebuffer> framebuffers;
+
+	std::unordered_map<std::size_t, core::Sampler> samplers;
+};
+
+/**
+ * @brief Lookup counters for one resource type of the Resource Cache
+ */
+struct ResourceCacheCounters
+{
+	/// Requests served by an object already in the cache
+	uint64_t hits{0};
+
+	/// Requests which had to build a new object
+	uint64_t misses{0};
+
+	/// Requests which had to wait for the lock held by another thread
+	uint64_t contentions{0};
+
+	/// Objects removed from the cache to keep it within budget
+	uint64_t evictions{0};
+};
+
+/**
+ * @brief Per-type lookup counters of the Resource Cache
+ */
+struct ResourceCacheStats
+{
+	ResourceCacheCounters shader_modules;
+
+	ResourceCacheCounters pipeline_layouts;
+
+	ResourceCacheCounters descriptor_set_layouts;
+
+	ResourceCacheCounters descriptor_pools;
+
+	ResourceCacheCounters render_passes;
+
+	ResourceCacheCounters graphics_pipelines;
+
+	ResourceCacheCounters compute_pipelines;
+
+	ResourceCacheCounters descriptor_sets;
+
+	ResourceCacheCounters framebuffers;
+
+	ResourceCacheCounters samplers;
+};
+
+/**
+ * @brief Largest number of objects of the types of the Resource Cache which can be evicted,
+ *        0 lets a type grow without bound
+ */
+struct ResourceCacheBudget
+{
+	size_t descriptor_sets{0};
+
+	size_t framebuffers{0};
+
+	size_t graphics_pipelines{0};
+
+	size_t compute_pipelines{0};
+};
+
+/**
+ * @brief Creation feedback of the pipelines in the Resource Cache
+ */
+struct PipelineCreationStats
+{
+	/// Number of graphics and compute pipelines created
+	uint32_t pipeline_count{0};
+
+	/// Pipelines for which the driver reported creation feedback
+	uint32_t feedback_count{0};
+
+	/// Pipelines the driver found in the pipeline cache
+	uint32_t cache_hits{0};
+
+	/// Time spent creating all the pipelines, in milliseconds
+	double total_duration{0.0};
+
+	/// Time spent creating the slowest pipeline, in milliseconds
+	double max_duration{0.0};
+};
+
+/**
+ * @brief When an object of the Resource Cache was created and last requested
+ */
+struct ResourceUsage
+{
+	/// Frame the object was created in
+	uint64_t created_frame{0};
+
+	/// Time the object was created at, in seconds since the creation of the Resource Cache
+	double created_time{0.0};
+
+	/// Whether the frame of the last request is tracked, which is only the case for the types with a budget
+	bool last_used_tracked{false};
+
+	/// Frame of the last request of the object
+	uint64_t last_used_frame{0};
+};
+
+/**
+ * @brief Usage of each object of the Resource Cache, by hash as in ResourceCacheState
+ */
+struct ResourceCacheUsage
+{
+	std::unordered_map<std::size_t, ResourceUsage> shader_modules;
+
+	std::unordered_map<std::size_t, ResourceUsage> pipeline_layouts;
+
+	std::unordered_map<std::size_t, ResourceUsage> descriptor_set_layouts;
+
+	std::unordered_map<std::size_t, ResourceUsage> descriptor_pools;
+
+	std::unordered_map<std::size_t, ResourceUsage> render_passes;
+
+	std::unordered_map<std::size_t, ResourceUsage> graphics_pipelines;
+
+	std::unordered_map<std::size_t, ResourceUsage> compute_pipelines;
+
+	std::unordered_map<std::size_t, ResourceUsage> descriptor_sets;
+
+	std::unordered_map<std::size_t, ResourceUsage> framebuffers;
+
+	std::unordered_map<std::size_t, ResourceUsage> samplers;
+};
+
+/**
+ * @brief Read-only view of one of the maps in ResourceCacheState.
+ * A new snapshot is published every time an object is added to the map, so that
+ * requests that hit the cache can look it up without taking the per-type lock.
+ * The cached objects are nodes of an unordered_map, so their address does not
+ * change when a later insertion rehashes the map.
+ */
+template <class T>
+struct ResourceIndex
+{
+	struct Entry
+	{
+		T *resource;
+
+		/// Frame of the last request of the object, nullptr if its type has no budget
+		std::atomic<uint64_t> *last_used;
+	};
+
+	struct Creation
+	{
+		uint64_t frame;
+
+		std::chrono::steady_clock::time_point time;
+	};
+
+	using Map = std::unordered_map<std::size_t, Entry>;
+
+	/// Must only be accessed with std::atomic_load and std::atomic_store
+	std::shared_ptr<const Map> snapshot;
+
+	/// Number of objects above which the least recently used ones are evicted, 0 to never evict them
+	size_t budget{0};
+
+	/**
+	 * @brief Frame of the last request of each cached object, only tracked while there is a budget.
+	 *        Entries are added and removed with the per-type lock held, hits on the snapshot only store to them.
+	 */
+	std::unordered_map<std::size_t, std::atomic<uint64_t>> last_used;
+
+	/// Frame and time of creation of each cached object, accessed with the per-type lock held
+	std::unordered_map<std::size_t, Creation> created;
+
+	std::atomic<uint64_t> hits{0};
+
+	std::atomic<uint64_t> misses{0};
+
+	std::atomic<uint64_t> contentions{0};
+
+	std::atomic<uint64_t> evictions{0};
+
+	/**
+	 * @brief Rebuilds the snapshot from the current content of the map
+	 * @param resources The map of cached objects, its lock must be held by the caller
+	 */
+	void publish(std::unordered_map<std::size_t, T> &resources)
+	{
+		auto map = std::make_shared<Map>();
+		map->reserve(resources.size());
+
+		for (auto &it : resources)
+		{
+			auto last_used_it = last_used.find(it.first);
+
+			map->emplace(it.first, Entry{&it.second, last_used_it != last_used.end() ? &last_used_it->second : nullptr});
+		}
+
+		std::atomic_store(&snapshot, std::shared_ptr<const Map>{std::move(map)});
+	}
+
+	void clear()
+	{
+		std::atomic_store(&snapshot, std::shared_ptr<const Map>{});
+	}
+
+	ResourceCacheCounters get_counters() const
+	{
+		ResourceCacheCounters counters;
+
+		counters.hits        = hits.load(std::memory_order_relaxed);
+		counters.misses      = misses.load(std::memory_order_relaxed);
+		counters.contentions = contentions.load(std::memory_order_relaxed);
+		counters.evictions   = evictions.load(std::memory_order_relaxed);
+
+		return counters;
+	}
+
+	/**
+	 * @param cache_creation_time Time the creation times are relative to
+	 * @return The usage of each cached object by hash
+	 */
+	std::unordered_map<std::size_t, ResourceUsage> get_usage(std::chrono::steady_clock::time_point cache_creation_time) const
+	{
+		std::unordered_map<std::size_t, ResourceUsage> usage;
+		usage.reserve(created.size());
+
+		for (auto &it : created)
+		{
+			auto &resource_usage = usage[it.first];
+
+			resource_usage.created_frame = it.second.frame;
+			resource_usage.created_time  = std::chrono::duration<double>(it.second.time - cache_creation_time).count();
+
+			auto last_used_it = last_used.find(it.first);
+
+			if (last_used_it != last_used.end())
+			{
+				resource_usage.last_used_tracked = true;
+				resource_usage.last_used_frame   = last_used_it->second.load(std::memory_order_relaxed);
+			}
+		}
+
+		return usage;
+	}
+
+	void reset_counters()
+	{
+		hits.store(0, std::memory_order_relaxed);
+		misses.store(0, std::memory_order_relaxed);
+		contentions.store(0, std::memory_order_relaxed);
+		evictions.store(0, std::memory_order_relaxed);
+	}
 };
 
 /**
@@ -74,13 +329,20 @@ struct ResourceCacheState
  * The resource cache is also linked with ResourceRecord and ResourceReplay. Replay can warm-up
  * the cache on app startup by creating all necessary objects.
  * The cache holds pointers to objects and has a mapping from such pointers to hashes.
- * It can only be destroyed in bulk, single elements cannot be removed.
+ * It is destroyed in bulk, except for the types given a budget: their least recently used objects
+ * are evicted at the start of a frame, once the frames which requested them have retired.
+ *
+ * Every request is serialized on a per-type mutex. When recording from many threads,
+ * concurrent lookup can be enabled so that requests hitting the cache skip the lock and
+ * only misses, which need to build a new object, are serialized.
  */
 class ResourceCache
 {
   public:
 	ResourceCache(Device &device);
 
+	~ResourceCache();
+
 	ResourceCache(const ResourceCache &) = delete;
 
 	ResourceCache(ResourceCache &&) = delete;
@@ -89,14 +351,106 @@ class ResourceCache
 
 	ResourceCache &operator=(ResourceCache &&) = delete;
 
-	void warmup(const std::vector<uint8_t> &data);
-
-	std::vector<uint8_t> serialize();
+	/**
+	 * @brief Creates all the objects recorded in a serialized stream
+	 * @param data The data returned by serialize() in a previous run
+	 * @param thread_count Number of threads used to create graphics pipelines, 1 creates them on the calling thread
+	 */
+	void warmup(const std::vector<uint8_t> &data, uint32_t thread_count = 1);
+
+	/**
+	 * @brief Creates all the objects recorded in a serialized stream, read from memory such as a mapped file
+	 * @param data The data returned by serialize() in a previous run
+	 * @param size The size of the data in bytes
+	 * @param thread_count Number of threads used to create graphics pipelines, 1 creates them on the calling thread
+	 */
+	void warmup(const uint8_t *data, size_t size, uint32_t thread_count = 1);
+
+	/**
+	 * @return Timings of the last warmup()
+	 */
+	const ResourceReplayStats &get_warmup_stats() const;
+
+	/**
+	 * @return The stream recording the objects created so far, replayed objects included, to warm up a later run with
+	 */
+	const std::vector<uint8_t> &serialize() const;
 
 	void set_pipeline_cache(VkPipelineCache pipeline_cache);
 
+	VkPipelineCache get_pipeline_cache() const;
+
+	Device &get_device();
+
+	/**
+	 * @brief Enables lock-free lookups for requests which hit the cache
+	 * @param enable Whether hits should bypass the per-type locks
+	 * @note Must not be called while other threads are requesting resources
+	 */
+	void set_concurrent_lookup(bool enable);
+
+	bool is_concurrent_lookup() const;
+
+	/**
+	 * @return The hit, miss and contention counters of each resource type
+	 */
+	ResourceCacheStats get_stats() const;
+
+	void reset_stats();
+
+	/**
+	 * @brief Reports when the cached objects were created and last requested, to find the ones which linger
+	 * @return The usage of the cached objects of each type, by hash
+	 * @note Must not be called while other threads are requesting resources
+	 */
+	ResourceCacheUsage get_usage() const;
+
+	/**
+	 * @brief Sets how many descriptor sets, framebuffers and pipelines the cache keeps
+	 * @param budget Number of objects of each type above which the least recently used are evicted
+	 * @note Must not be called while other threads are requesting resources
+	 */
+	void set_budget(const ResourceCacheBudget &budget);
+
+	ResourceCacheBudget get_budget() const;
+
+	/**
+	 * @brief Stamps the following requests with a new frame, and evicts the objects over budget
+	 *        which were not requested by the frames the GPU may still be executing
+	 * @param frame_index Index of the frame about to be recorded, it increases with every frame
+	 * @param oldest_frame_in_flight Index of the oldest frame whose submissions may not have completed
+	 * @return Number of objects evicted
+	 * @note Must not be called while other threads are requesting resources
+	 */
+	size_t begin_frame(uint64_t frame_index, uint64_t oldest_frame_in_flight);
+
+	/**
+	 * @return The creation time and pipeline cache hits of the cached graphics and compute pipelines
+	 */
+	PipelineCreationStats get_pipeline_creation_stats();
+
 	ShaderModule &request_shader_module(VkShaderStageFlagBits stage, const ShaderSource &glsl_source, const ShaderVariant &shader_variant = {});
 
+	/**
+	 * @brief Requests a shader module without waiting for it to be compiled.
+	 *        The first request for a variant queues its compilation as a low priority job,
+	 *        following requests return the shader module once it is ready.
+	 *        Callers can skip the draw or use a fallback pipeline in the meantime.
+	 * @return The shader module, or nullptr if it is still being compiled
+	 * @throws VulkanException if the background compilation failed
+	 */
+	ShaderModule *request_shader_module_async(VkShaderStageFlagBits stage, const ShaderSource &glsl_source, const ShaderVariant &shader_variant = {});
+
+	/**
+	 * @return Number of shader modules queued or being compiled in the background
+	 */
+	size_t get_pending_shader_module_count();
+
+	/**
+	 * @return The cached shader modules, whose addresses stay valid until the cache is cleared
+	 */
+	std::vector<ShaderModule *> get_shader_modules();
+
 	PipelineLayout &request_pipeline_layout(const std::vector<ShaderModule *> &shader_modules);
 
 	DescriptorSetLayout &request_descriptor_set_layout(const uint32_t set_index, const std::vector<ShaderResource> &set_resources);
@@ -105,9 +459,18 @@ class ResourceCache
 
 	ComputePipeline &request_compute_pipeline(PipelineState &pipeline_state);
 
-	DescriptorSet &request_descriptor_set(DescriptorSetLayout &                     descriptor_set_layout,
-	                                      const BindingMap<VkDescriptorBufferInfo> &buffer_infos,
-	                                      const BindingMap<VkDescriptorImageInfo> & image_infos);
+	/**
+	 * @brief Adds a graphics pipeline that was created outside of the cache
+	 * @param pipeline_state The state the pipeline was created with
+	 * @param graphics_pipeline The pipeline to take ownership of
+	 * @return The cached pipeline for the given state
+	 */
+	GraphicsPipeline &add_graphics_pipeline(PipelineState &pipeline_state, GraphicsPipeline &&graphics_pipeline);
+
+	DescriptorSet &request_descriptor_set(DescriptorSetLayout &                         descriptor_set_layout,
+	                                      const BindingMap<VkDescriptorBufferInfo> &    buffer_infos,
+	                                      const BindingMap<VkDescriptorImageInfo> &     image_infos,
+	                                      const BindingMap<VkAccelerationStructureKHR> &acceleration_structure_infos = {});
 
 	RenderPass &request_render_pass(const std::vector<Attachment> &   attachments,
 	                                const std::vector<LoadStoreInfo> &load_store_infos,
@@ -116,6 +479,12 @@ class ResourceCache
 	Framebuffer &request_framebuffer(const RenderTarget &render_target,
 	                                 const RenderPass &  render_pass);
 
+	/**
+	 * @brief Requests a sampler, shared by all the requests with the same creation details
+	 * @param info Creation details, which must not chain structures with pNext
+	 */
+	core::Sampler &request_sampler(const VkSamplerCreateInfo &info);
+
 	void clear_pipelines();
 
 	/// @brief Update those descriptor sets referring to old views
@@ -125,6 +494,13 @@ class ResourceCache
 
 	void clear_framebuffers();
 
+	/**
+	 * @brief Removes the framebuffers from the cache without destroying them,
+	 *        so that they can be kept until the frames using them are done
+	 * @return The framebuffers by hash
+	 */
+	std::unordered_map<std::size_t, Framebuffer> release_framebuffers();
+
 	void clear();
 
 	const ResourceCacheState &get_internal_state() const;
@@ -140,6 +516,37 @@ class ResourceCache
 
 	ResourceCacheState state;
 
+	bool concurrent_lookup{false};
+
+	/// Frame the requests are stamped with, for the types with a budget
+	uint64_t frame_index{0};
+
+	/// Time the creation times of the cached objects are relative to
+	std::chrono::steady_clock::time_point creation_time{std::chrono::steady_clock::now()};
+
+	ResourceIndex<ShaderModule> shader_module_index;
+
+	ResourceIndex<PipelineLayout> pipeline_layout_index;
+
+	ResourceIndex<DescriptorSetLayout> descriptor_set_layout_index;
+
+	ResourceIndex<DescriptorPool> descriptor_pool_index;
+
+	ResourceIndex<RenderPass> render_pass_index;
+
+	ResourceIndex<GraphicsPipeline> graphics_pipeline_index;
+
+	ResourceIndex<ComputePipeline> compute_pipeline_index;
+
+	ResourceIndex<DescriptorSet> descriptor_set_index;
+
+	ResourceIndex<Framebuffer> framebuffer_index;
+
+	ResourceIndex<core::Sampler> sampler_index;
+
+	/// Shader modules compiled in the background, by hash of their request
+	std::unordered_map<std::size_t, std::future<ShaderModule>> pending_shader_modules;
+
 	std::mutex descriptor_set_mutex;
 
 	std::mutex pipeline_layout_mutex;
@@ -155,5 +562,7 @@ class ResourceCache
 	std::mutex compute_pipeline_mutex;
 
 	std::mutex framebuffer_mutex;
+
+	std::mutex sampler_mutex;
 };
 }        // namespace vkb
@@ -17,6 +17,9 @@
 
 #include "resource_record.h"
 
+#include <algorithm>
+
+#include "common/helpers.h"
 #include "core/pipeline.h"
 #include "core/pipeline_layout.h"
 #include "core/render_pass.h"
@@ -27,108 +30,238 @@ namespace vkb
 {
 namespace
 {
-inline void write_subpass_info(std::ostringstream &os, const std::vector<SubpassInfo> &value)
+template <typename T>
+inline void write(std::vector<uint8_t> &data, const T &value)
+{
+	static_assert(std::is_trivially_copyable<T>::value, "Only plain data is written as bytes");
+
+	auto bytes = reinterpret_cast<const uint8_t *>(&value);
+	data.insert(data.end(), bytes, bytes + sizeof(T));
+}
+
+inline void write(std::vector<uint8_t> &data, const std::string &value)
 {
-	write(os, value.size());
+	write(data, to_u32(value.size()));
+	data.insert(data.end(), value.begin(), value.end());
+}
+
+template <typename T>
+inline void write(std::vector<uint8_t> &data, const std::vector<T> &value)
+{
+	static_assert(std::is_trivially_copyable<T>::value, "Only vectors of plain data are written as bytes");
+
+	write(data, to_u32(value.size()));
+
+	auto bytes = reinterpret_cast<const uint8_t *>(value.data());
+	data.insert(data.end(), bytes, bytes + value.size() * sizeof(T));
+}
+
+template <typename T, typename S>
+inline void write(std::vector<uint8_t> &data, const std::map<T, S> &value)
+{
+	write(data, to_u32(value.size()));
+
+	for (const auto &item : value)
+	{
+		write(data, item.first);
+		write(data, item.second);
+	}
+}
+
+template <typename T, typename... Args>
+inline void write(std::vector<uint8_t> &data, const T &first_arg, const Args &... args)
+{
+	write(data, first_arg);
+
+	write(data, args...);
+}
+
+inline void write_subpass_info(std::vector<uint8_t> &data, const std::vector<SubpassInfo> &value)
+{
+	write(data, to_u32(value.size()));
 	for (const SubpassInfo &item : value)
 	{
-		write(os, item.input_attachments);
-		write(os, item.output_attachments);
+		write(data,
+		      item.input_attachments,
+		      item.output_attachments,
+		      item.color_resolve_attachments,
+		      item.disable_depth_stencil_attachment,
+		      item.depth_stencil_resolve_attachment,
+		      item.depth_stencil_resolve_mode,
+		      item.shading_rate_attachment,
+		      item.shading_rate_texel_size,
+		      item.view_mask);
 	}
 }
 
-inline void write_processes(std::ostringstream &os, const std::vector<std::string> &value)
+inline void write_processes(std::vector<uint8_t> &data, const std::vector<std::string> &value)
 {
-	write(os, value.size());
+	write(data, to_u32(value.size()));
 	for (const std::string &item : value)
 	{
-		write(os, item);
+		write(data, item);
 	}
 }
 }        // namespace
 
-void ResourceRecord::set_data(const std::vector<uint8_t> &data)
+ResourceChunkReader::ResourceChunkReader(const uint8_t *data, size_t size) :
+    data{data},
+    size{size}
+{}
+
+void ResourceChunkReader::read(std::string &value)
+{
+	uint32_t count{0};
+	read(count);
+
+	if (auto bytes = read_bytes(count))
+	{
+		value.assign(reinterpret_cast<const char *>(bytes), count);
+	}
+}
+
+bool ResourceChunkReader::is_valid() const
+{
+	return valid;
+}
+
+const uint8_t *ResourceChunkReader::read_bytes(size_t count)
 {
-	stream.str(std::string{data.begin(), data.end()});
+	if (!valid || count > size - offset)
+	{
+		valid = false;
+		return nullptr;
+	}
+
+	const uint8_t *bytes = data + offset;
+	offset += count;
+
+	return bytes;
 }
 
-std::vector<uint8_t> ResourceRecord::get_data()
+ResourceRecord::ResourceRecord()
 {
-	std::string str = stream.str();
+	write(data, ResourceRecordHeader{RESOURCE_RECORD_MAGIC, RESOURCE_RECORD_VERSION});
+}
 
-	return std::vector<uint8_t>{str.begin(), str.end()};
+const std::vector<uint8_t> &ResourceRecord::get_data() const
+{
+	return data;
 }
 
-const std::ostringstream &ResourceRecord::get_stream()
+void ResourceRecord::begin_chunk(ResourceType type)
 {
-	return stream;
+	chunk_offset = data.size();
+
+	write(data, ResourceChunkHeader{type, 0, 0});
+}
+
+void ResourceRecord::end_chunk()
+{
+	size_t payload_offset = chunk_offset + sizeof(ResourceChunkHeader);
+
+	size_t checksum{0};
+	hash_bytes(checksum, data.data() + payload_offset, data.size() - payload_offset);
+
+	ResourceChunkHeader header{};
+	std::memcpy(&header, data.data() + chunk_offset, sizeof(header));
+
+	header.size     = to_u32(data.size() - payload_offset);
+	header.checksum = checksum;
+
+	std::memcpy(data.data() + chunk_offset, &header, sizeof(header));
 }
 
 size_t ResourceRecord::register_shader_module(VkShaderStageFlagBits stage, const ShaderSource &glsl_source, const std::string &entry_point, const ShaderVariant &shader_variant)
 {
+	std::lock_guard<std::mutex> guard(mutex);
+
 	shader_module_indices.push_back(shader_module_indices.size());
 
-	write(stream, ResourceType::ShaderModule, stage, glsl_source.get_data(), entry_point, shader_variant.get_preamble());
+	begin_chunk(ResourceType::ShaderModule);
+
+	write(data, stage, glsl_source.get_data(), entry_point, shader_variant.get_preamble());
+
+	write_processes(data, shader_variant.get_processes());
 
-	write_processes(stream, shader_variant.get_processes());
+	end_chunk();
 
 	return shader_module_indices.back();
 }
 
 size_t ResourceRecord::register_pipeline_layout(const std::vector<ShaderModule *> &shader_modules)
 {
+	std::lock_guard<std::mutex> guard(mutex);
+
 	pipeline_layout_indices.push_back(pipeline_layout_indices.size());
 
-	std::vector<size_t> shader_indices(shader_modules.size());
+	std::vector<uint32_t> shader_indices(shader_modules.size());
 	std::transform(shader_modules.begin(), shader_modules.end(), shader_indices.begin(),
-	               [this](ShaderModule *shader_module) { return shader_module_to_index.at(shader_module); });
+	               [this](ShaderModule *shader_module) { return to_u32(shader_module_to_index.at(shader_module)); });
+
+	begin_chunk(ResourceType::PipelineLayout);
 
-	write(stream,
-	      ResourceType::PipelineLayout,
+	write(data,
 	      shader_indices);
 
+	end_chunk();
+
 	return pipeline_layout_indices.back();
 }
 
 size_t ResourceRecord::register_render_pass(const std::vector<Attachment> &attachments, const std::vector<LoadStoreInfo> &load_store_infos, const std::vector<SubpassInfo> &subpasses)
 {
+	std::lock_guard<std::mutex> guard(mutex);
+
 	render_pass_indices.push_back(render_pass_indices.size());
 
-	write(stream,
-	      ResourceType::RenderPass,
+	begin_chunk(ResourceType::RenderPass);
+
+	write(data,
 	      attachments,
 	      load_store_infos);
 
-	write_subpass_info(stream, subpasses);
+	write_subpass_info(data, subpasses);
+
+	end_chunk();
 
 	return render_pass_indices.back();
 }
 
 size_t ResourceRecord::register_graphics_pipeline(VkPipelineCache /*pipeline_cache*/, PipelineState &pipeline_state)
 {
+	std::lock_guard<std::mutex> guard(mutex);
+
 	graphics_pipeline_indices.push_back(graphics_pipeline_indices.size());
 
 	auto &pipeline_layout = pipeline_state.get_pipeline_layout();
 	auto  render_pass     = pipeline_state.get_render_pass();
 
-	write(stream,
-	      ResourceType::GraphicsPipeline,
-	      pipeline_layout_to_index.at(&pipeline_layout),
-	      render_pass_to_index.at(render_pass),
+	// Pipelines of dynamic rendering have no render pass to replay them with
+	if (!render_pass)
+	{
+		return graphics_pipeline_indices.back();
+	}
+
+	begin_chunk(ResourceType::GraphicsPipeline);
+
+	write(data,
+	      to_u32(pipeline_layout_to_index.at(&pipeline_layout)),
+	      to_u32(render_pass_to_index.at(render_pass)),
 	      pipeline_state.get_subpass_index());
 
 	auto &specialization_constant_state = pipeline_state.get_specialization_constant_state().get_specialization_constant_state();
 
-	write(stream,
+	write(data,
 	      specialization_constant_state);
 
 	auto &vertex_input_state = pipeline_state.get_vertex_input_state();
 
-	write(stream,
+	write(data,
 	      vertex_input_state.attributes,
 	      vertex_input_state.bindings);
 
-	write(stream,
+	write(data,
 	      pipeline_state.get_input_assembly_state(),
 	      pipeline_state.get_rasterization_state(),
 	      pipeline_state.get_viewport_state(),
@@ -137,31 +270,41 @@ size_t ResourceRecord::register_graphics_pipeline(VkPipelineCache /*pipeline_cac
 
 	auto &color_blend_state = pipeline_state.get_color_blend_state();
 
-	write(stream,
+	write(data,
 	      color_blend_state.logic_op,
 	      color_blend_state.logic_op_enable,
 	      color_blend_state.attachments);
 
+	end_chunk();
+
 	return graphics_pipeline_indices.back();
 }
 
 void ResourceRecord::set_shader_module(size_t index, const ShaderModule &shader_module)
 {
+	std::lock_guard<std::mutex> guard(mutex);
+
 	shader_module_to_index[&shader_module] = index;
 }
 
 void ResourceRecord::set_pipeline_layout(size_t index, const PipelineLayout &pipeline_layout)
 {
+	std::lock_guard<std::mutex> guard(mutex);
+
 	pipeline_layout_to_index[&pipeline_layout] = index;
 }
 
 void ResourceRecord::set_render_pass(size_t index, const RenderPass &render_pass)
 {
+	std::lock_guard<std::mutex> guard(mutex);
+
 	render_pass_to_index[&render_pass] = index;
 }
 
 void ResourceRecord::set_graphics_pipeline(size_t index, const GraphicsPipeline &graphics_pipeline)
 {
+	std::lock_guard<std::mutex> guard(mutex);
+
 	graphics_pipeline_to_index[&graphics_pipeline] = index;
 }
 
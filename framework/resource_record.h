@@ -17,6 +17,11 @@
 
 #pragma once
 
+#include <cstring>
+#include <map>
+#include <mutex>
+#include <string>
+#include <type_traits>
 #include <vector>
 
 #include "rendering/pipeline_state.h"
@@ -28,7 +33,7 @@ class PipelineLayout;
 class RenderPass;
 class ShaderModule;
 
-enum class ResourceType
+enum class ResourceType : uint32_t
 {
 	ShaderModule,
 	PipelineLayout,
@@ -36,17 +41,134 @@ enum class ResourceType
 	GraphicsPipeline
 };
 
+/// Identifies resource record streams, the characters "VKRR" in little endian
+constexpr uint32_t RESOURCE_RECORD_MAGIC = 0x52524b56;
+
+/// Must be increased whenever the layout of a chunk changes, streams of other versions are not replayed
+constexpr uint32_t RESOURCE_RECORD_VERSION = 2;
+
 /**
- * @brief Writes Vulkan objects in a memory stream.
+ * @brief Beginning of a resource record stream, followed by its chunks
  */
-class ResourceRecord
+struct ResourceRecordHeader
+{
+	uint32_t magic;
+
+	uint32_t version;
+};
+
+/**
+ * @brief Beginning of the chunk of a resource, followed by its payload
+ */
+struct ResourceChunkHeader
+{
+	ResourceType type;
+
+	/// Size of the payload in bytes
+	uint32_t size;
+
+	/// Checksum of the payload, from hash_bytes
+	uint64_t checksum;
+};
+
+/**
+ * @brief Reads the values of a chunk payload in place, such as from a mapped file
+ *
+ * Counts of strings, vectors and maps are 32-bit. Reads past the end of the payload
+ * leave their values unchanged and make the reader invalid.
+ */
+class ResourceChunkReader
 {
   public:
-	void set_data(const std::vector<uint8_t> &data);
+	ResourceChunkReader(const uint8_t *data, size_t size);
+
+	template <typename T>
+	void read(T &value)
+	{
+		static_assert(std::is_trivially_copyable<T>::value, "Only plain data is read as bytes");
+
+		if (auto bytes = read_bytes(sizeof(T)))
+		{
+			std::memcpy(&value, bytes, sizeof(T));
+		}
+	}
+
+	void read(std::string &value);
+
+	template <typename T>
+	void read(std::vector<T> &value)
+	{
+		static_assert(std::is_trivially_copyable<T>::value, "Only vectors of plain data are read as bytes");
+
+		uint32_t count{0};
+		read(count);
+
+		if (auto bytes = read_bytes(count * sizeof(T)))
+		{
+			value.resize(count);
+			std::memcpy(value.data(), bytes, count * sizeof(T));
+		}
+	}
+
+	template <typename T, typename S>
+	void read(std::map<T, S> &value)
+	{
+		uint32_t count{0};
+		read(count);
+
+		for (uint32_t i = 0; i < count && valid; ++i)
+		{
+			std::pair<T, S> item;
+			read(item.first, item.second);
+
+			value.insert(std::move(item));
+		}
+	}
+
+	template <typename T, typename... Args>
+	void read(T &first_arg, Args &... args)
+	{
+		read(first_arg);
+
+		read(args...);
+	}
+
+	/**
+	 * @return Whether all the reads were within the payload
+	 */
+	bool is_valid() const;
 
-	std::vector<uint8_t> get_data();
+  private:
+	/**
+	 * @return The next bytes of the payload, or nullptr if fewer remain
+	 */
+	const uint8_t *read_bytes(size_t count);
+
+	const uint8_t *data;
+
+	size_t size;
 
-	const std::ostringstream &get_stream();
+	size_t offset{0};
+
+	bool valid{true};
+};
+
+/**
+ * @brief Records the creation of Vulkan objects as a stream of chunks, which ResourceReplay creates them from again
+ *
+ * The stream starts with a ResourceRecordHeader, then every recorded object appends a chunk with its type,
+ * size and checksum, so that replay scans it once and stops at a truncated or corrupted chunk. Objects refer
+ * to earlier ones by their index among the chunks of their type.
+ */
+class ResourceRecord
+{
+  public:
+	ResourceRecord();
+
+	/**
+	 * @return The recorded stream, appended to in place
+	 */
+	const std::vector<uint8_t> &get_data() const;
 
 	size_t register_shader_module(VkShaderStageFlagBits stage,
 	                              const ShaderSource &  glsl_source,
@@ -71,7 +193,20 @@ class ResourceRecord
 	void set_graphics_pipeline(size_t index, const GraphicsPipeline &graphics_pipeline);
 
   private:
-	std::ostringstream stream;
+	/**
+	 * @brief Starts the chunk of an object, whose size and checksum are written by end_chunk
+	 */
+	void begin_chunk(ResourceType type);
+
+	void end_chunk();
+
+	/// Guards the stream and the indices, as objects of different types are recorded concurrently
+	std::mutex mutex;
+
+	std::vector<uint8_t> data;
+
+	/// Offset of the header of the chunk being written
+	size_t chunk_offset{0};
 
 	std::vector<size_t> shader_module_indices;
 
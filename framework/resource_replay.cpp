@@ -17,35 +17,62 @@
 
 #include "resource_replay.h"
 
+#include <algorithm>
+#include <cstring>
+#include <numeric>
+
+#include <ctpl_stl.h>
+
+#include "common/helpers.h"
 #include "common/logging.h"
 #include "common/vk_common.h"
+#include "core/pipeline.h"
 #include "rendering/pipeline_state.h"
 #include "resource_cache.h"
+#include "timer.h"
 
 namespace vkb
 {
 namespace
 {
-inline void read_subpass_info(std::istringstream &is, std::vector<SubpassInfo> &value)
+/// Largest number of subpasses or processes read from a chunk, so that a corrupted count does not allocate without bound
+constexpr uint32_t MAX_CHUNK_ITEM_COUNT = 1024;
+
+inline void read_subpass_info(ResourceChunkReader &reader, std::vector<SubpassInfo> &value)
 {
-	std::size_t size;
-	read(is, size);
-	value.resize(size);
+	uint32_t size{0};
+	reader.read(size);
+	value.resize(std::min(size, MAX_CHUNK_ITEM_COUNT));
 	for (SubpassInfo &subpass : value)
 	{
-		read(is, subpass.input_attachments);
-		read(is, subpass.output_attachments);
+		reader.read(subpass.input_attachments,
+		            subpass.output_attachments,
+		            subpass.color_resolve_attachments,
+		            subpass.disable_depth_stencil_attachment,
+		            subpass.depth_stencil_resolve_attachment,
+		            subpass.depth_stencil_resolve_mode,
+		            subpass.shading_rate_attachment,
+		            subpass.shading_rate_texel_size,
+		            subpass.view_mask);
 	}
 }
 
-inline void read_processes(std::istringstream &is, std::vector<std::string> &value)
+inline void read_processes(ResourceChunkReader &reader, std::vector<std::string> &value)
 {
-	std::size_t size;
-	read(is, size);
-	value.resize(size);
+	uint32_t size{0};
+	reader.read(size);
+	value.resize(std::min(size, MAX_CHUNK_ITEM_COUNT));
 	for (std::string &item : value)
 	{
-		read(is, item);
+		reader.read(item);
+	}
+}
+
+inline void check_chunk(const ResourceChunkReader &reader)
+{
+	if (!reader.is_valid())
+	{
+		throw std::runtime_error("Chunk is shorter than its contents");
 	}
 }
 }        // namespace
@@ -58,38 +85,137 @@ ResourceReplay::ResourceReplay()
 	stream_resources[ResourceType::GraphicsPipeline] = std::bind(&ResourceReplay::create_graphics_pipeline, this, std::placeholders::_1, std::placeholders::_2);
 }
 
-void ResourceReplay::play(ResourceCache &resource_cache, ResourceRecord &recorder)
+void ResourceReplay::play(ResourceCache &resource_cache, const uint8_t *data, size_t size, uint32_t thread_count)
 {
-	std::istringstream stream{recorder.get_stream().str()};
+	Timer timer;
+	timer.start();
+
+	stats              = {};
+	stats.thread_count = std::max(thread_count, 1U);
 
-	while (true)
+	std::unique_ptr<ctpl::thread_pool> pool;
+
+	if (stats.thread_count > 1)
 	{
-		// Read command id
-		ResourceType resource_type;
-		read(stream, resource_type);
+		pool        = std::make_unique<ctpl::thread_pool>(stats.thread_count);
+		thread_pool = pool.get();
+	}
+
+	ResourceRecordHeader header{};
 
-		if (stream.eof())
+	if (size >= sizeof(header))
+	{
+		std::memcpy(&header, data, sizeof(header));
+	}
+
+	if (header.magic != RESOURCE_RECORD_MAGIC || header.version != RESOURCE_RECORD_VERSION)
+	{
+		LOGW("Discarding resource stream of another format or version");
+	}
+	else
+	{
+		play_chunks(resource_cache, data + sizeof(header), size - sizeof(header));
+	}
+
+	resolve_graphics_pipelines(resource_cache);
+
+	thread_pool = nullptr;
+
+	stats.wall_time = timer.stop();
+
+	if (!stats.pipeline_creation_times.empty())
+	{
+		auto minmax = std::minmax_element(stats.pipeline_creation_times.begin(), stats.pipeline_creation_times.end());
+		auto total  = std::accumulate(stats.pipeline_creation_times.begin(), stats.pipeline_creation_times.end(), 0.0);
+
+		LOGI("Replayed {} graphics pipelines with {} threads in {:.3f} s (per pipeline min {:.2f} ms, avg {:.2f} ms, max {:.2f} ms)",
+		     stats.pipeline_creation_times.size(),
+		     stats.thread_count,
+		     stats.wall_time,
+		     *minmax.first * 1000.0,
+		     total * 1000.0 / stats.pipeline_creation_times.size(),
+		     *minmax.second * 1000.0);
+	}
+}
+
+void ResourceReplay::play_chunks(ResourceCache &resource_cache, const uint8_t *data, size_t size)
+{
+	size_t offset = 0;
+
+	while (size - offset >= sizeof(ResourceChunkHeader))
+	{
+		ResourceChunkHeader chunk_header;
+		std::memcpy(&chunk_header, data + offset, sizeof(chunk_header));
+		offset += sizeof(chunk_header);
+
+		if (chunk_header.size > size - offset)
 		{
-			break;
+			LOGW("Resource stream is truncated, stopping its replay");
+			return;
 		}
 
-		// Find command function for the given command id
-		auto cmd_it = stream_resources.find(resource_type);
+		const uint8_t *payload = data + offset;
+		offset += chunk_header.size;
 
-		// Check if command replayer supports the given command
-		if (cmd_it != stream_resources.end())
+		size_t checksum{0};
+		hash_bytes(checksum, payload, chunk_header.size);
+
+		if (static_cast<uint64_t>(checksum) != chunk_header.checksum)
 		{
-			// Run command function
-			cmd_it->second(resource_cache, stream);
+			LOGW("Resource stream is corrupted, stopping its replay");
+			return;
 		}
-		else
+
+		auto cmd_it = stream_resources.find(chunk_header.type);
+
+		// Later chunks only refer to chunks of the same types
+		if (cmd_it == stream_resources.end())
 		{
 			LOGE("Replay command not supported.");
+			continue;
+		}
+
+		ResourceChunkReader reader{payload, chunk_header.size};
+
+		try
+		{
+			cmd_it->second(resource_cache, reader);
+		}
+		catch (const std::exception &ex)
+		{
+			// Objects are created from the chunks before, but later ones may refer to this one
+			LOGW("Malformed resource chunk, stopping replay. {}", ex.what());
+			return;
 		}
 	}
+
+	if (offset != size)
+	{
+		LOGW("Resource stream is truncated, stopping its replay");
+	}
+}
+
+const ResourceReplayStats &ResourceReplay::get_stats() const
+{
+	return stats;
 }
 
-void ResourceReplay::create_shader_module(ResourceCache &resource_cache, std::istringstream &stream)
+void ResourceReplay::resolve_graphics_pipelines(ResourceCache &resource_cache)
+{
+	for (auto &pending : pending_graphics_pipelines)
+	{
+		auto result = pending.future.get();
+
+		auto &graphics_pipeline = resource_cache.add_graphics_pipeline(*pending.pipeline_state, std::move(result.first));
+
+		graphics_pipelines.push_back(&graphics_pipeline);
+		stats.pipeline_creation_times.push_back(result.second);
+	}
+
+	pending_graphics_pipelines.clear();
+}
+
+void ResourceReplay::create_shader_module(ResourceCache &resource_cache, ResourceChunkReader &reader)
 {
 	VkShaderStageFlagBits    stage{};
 	std::vector<uint8_t>     glsl_code;
@@ -97,13 +223,14 @@ void ResourceReplay::create_shader_module(ResourceCache &resource_cache, std::is
 	std::string              preamble;
 	std::vector<std::string> processes;
 
-	read(stream,
-	     stage,
-	     glsl_code,
-	     entry_point,
-	     preamble);
+	reader.read(stage,
+	            glsl_code,
+	            entry_point,
+	            preamble);
+
+	read_processes(reader, processes);
 
-	read_processes(stream, processes);
+	check_chunk(reader);
 
 	ShaderSource  shader_source(std::move(glsl_code));
 	ShaderVariant shader_variant(std::move(preamble), std::move(processes));
@@ -113,59 +240,58 @@ void ResourceReplay::create_shader_module(ResourceCache &resource_cache, std::is
 	shader_modules.push_back(&shader_module);
 }
 
-void ResourceReplay::create_pipeline_layout(ResourceCache &resource_cache, std::istringstream &stream)
+void ResourceReplay::create_pipeline_layout(ResourceCache &resource_cache, ResourceChunkReader &reader)
 {
-	std::vector<size_t> shader_indices;
+	std::vector<uint32_t> shader_indices;
+
+	reader.read(shader_indices);
 
-	read(stream,
-	     shader_indices);
+	check_chunk(reader);
 
 	std::vector<ShaderModule *> shader_stages(shader_indices.size());
 	std::transform(shader_indices.begin(), shader_indices.end(), shader_stages.begin(),
-	               [&](size_t shader_index) { return shader_modules.at(shader_index); });
+	               [&](uint32_t shader_index) { return shader_modules.at(shader_index); });
 
 	auto &pipeline_layout = resource_cache.request_pipeline_layout(shader_stages);
 
 	pipeline_layouts.push_back(&pipeline_layout);
 }
 
-void ResourceReplay::create_render_pass(ResourceCache &resource_cache, std::istringstream &stream)
+void ResourceReplay::create_render_pass(ResourceCache &resource_cache, ResourceChunkReader &reader)
 {
 	std::vector<Attachment>    attachments;
 	std::vector<LoadStoreInfo> load_store_infos;
 	std::vector<SubpassInfo>   subpasses;
 
-	read(stream,
-	     attachments,
-	     load_store_infos);
+	reader.read(attachments,
+	            load_store_infos);
 
-	read_subpass_info(stream, subpasses);
+	read_subpass_info(reader, subpasses);
+
+	check_chunk(reader);
 
 	auto &render_pass = resource_cache.request_render_pass(attachments, load_store_infos, subpasses);
 
 	render_passes.push_back(&render_pass);
 }
 
-void ResourceReplay::create_graphics_pipeline(ResourceCache &resource_cache, std::istringstream &stream)
+void ResourceReplay::create_graphics_pipeline(ResourceCache &resource_cache, ResourceChunkReader &reader)
 {
-	size_t   pipeline_layout_index{};
-	size_t   render_pass_index{};
+	uint32_t pipeline_layout_index{};
+	uint32_t render_pass_index{};
 	uint32_t subpass_index{};
 
-	read(stream,
-	     pipeline_layout_index,
-	     render_pass_index,
-	     subpass_index);
+	reader.read(pipeline_layout_index,
+	            render_pass_index,
+	            subpass_index);
 
 	std::map<uint32_t, std::vector<uint8_t>> specialization_constant_state{};
-	read(stream,
-	     specialization_constant_state);
+	reader.read(specialization_constant_state);
 
 	VertexInputState vertex_input_sate{};
 
-	read(stream,
-	     vertex_input_sate.attributes,
-	     vertex_input_sate.bindings);
+	reader.read(vertex_input_sate.attributes,
+	            vertex_input_sate.bindings);
 
 	InputAssemblyState input_assembly_state{};
 	RasterizationState rasterization_state{};
@@ -173,21 +299,23 @@ void ResourceReplay::create_graphics_pipeline(ResourceCache &resource_cache, std
 	MultisampleState   multisample_state{};
 	DepthStencilState  depth_stencil_state{};
 
-	read(stream,
-	     input_assembly_state,
-	     rasterization_state,
-	     viewport_state,
-	     multisample_state,
-	     depth_stencil_state);
+	reader.read(input_assembly_state,
+	            rasterization_state,
+	            viewport_state,
+	            multisample_state,
+	            depth_stencil_state);
 
 	ColorBlendState color_blend_state{};
 
-	read(stream,
-	     color_blend_state.logic_op,
-	     color_blend_state.logic_op_enable,
-	     color_blend_state.attachments);
+	reader.read(color_blend_state.logic_op,
+	            color_blend_state.logic_op_enable,
+	            color_blend_state.attachments);
+
+	check_chunk(reader);
+
+	auto pipeline_state_ptr = std::make_unique<PipelineState>();
+	auto &pipeline_state    = *pipeline_state_ptr;
 
-	PipelineState pipeline_state{};
 	pipeline_state.set_pipeline_layout(*pipeline_layouts.at(pipeline_layout_index));
 	pipeline_state.set_render_pass(*render_passes.at(render_pass_index));
 
@@ -205,8 +333,38 @@ void ResourceReplay::create_graphics_pipeline(ResourceCache &resource_cache, std
 	pipeline_state.set_depth_stencil_state(depth_stencil_state);
 	pipeline_state.set_color_blend_state(color_blend_state);
 
+	if (thread_pool)
+	{
+		// Pipeline creation only reads the already created layout and render pass, so it can run on a worker
+		auto &device         = resource_cache.get_device();
+		auto  pipeline_cache = resource_cache.get_pipeline_cache();
+
+		PendingGraphicsPipeline pending;
+		pending.future = thread_pool->push(
+		    [&device, pipeline_cache, &pipeline_state](size_t) {
+			    Timer timer;
+			    timer.start();
+
+			    GraphicsPipeline graphics_pipeline{device, pipeline_cache, pipeline_state};
+
+			    double creation_time = timer.stop();
+
+			    return std::make_pair(std::move(graphics_pipeline), creation_time);
+		    });
+		pending.pipeline_state = std::move(pipeline_state_ptr);
+
+		pending_graphics_pipelines.push_back(std::move(pending));
+
+		return;
+	}
+
+	Timer timer;
+	timer.start();
+
 	auto &graphics_pipeline = resource_cache.request_graphics_pipeline(pipeline_state);
 
+	stats.pipeline_creation_times.push_back(timer.stop());
+
 	graphics_pipelines.push_back(&graphics_pipeline);
 }
 }        // namespace vkb
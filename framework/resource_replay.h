@@ -17,12 +17,35 @@
 
 #pragma once
 
+#include <future>
+
+#include "core/pipeline.h"
 #include "resource_record.h"
 
+namespace ctpl
+{
+class thread_pool;
+}
+
 namespace vkb
 {
 class ResourceCache;
 
+/**
+ * @brief Timings of a replay, in seconds
+ */
+struct ResourceReplayStats
+{
+	/// Number of threads used to create graphics pipelines
+	uint32_t thread_count{1};
+
+	/// Time taken by the whole replay
+	double wall_time{0.0};
+
+	/// Creation time of each graphics pipeline, in the order they were recorded
+	std::vector<double> pipeline_creation_times;
+};
+
 /**
  * @brief Reads Vulkan objects from a memory stream and creates them in the resource cache.
  */
@@ -31,19 +54,52 @@ class ResourceReplay
   public:
 	ResourceReplay();
 
-	void play(ResourceCache &resource_cache, ResourceRecord &recorder);
+	/**
+	 * @brief Creates all the objects recorded in a stream, scanning its chunks once in place
+	 *
+	 * Streams of another format or version are ignored. Replay stops at the first truncated, corrupted
+	 * or malformed chunk, keeping the objects created from the chunks before it.
+	 * @param resource_cache The cache to create the objects in
+	 * @param data The stream of a ResourceRecord, which can be a mapped file
+	 * @param size The size of the stream in bytes
+	 * @param thread_count Number of worker threads creating graphics pipelines. Shader modules, pipeline layouts and
+	 *        render passes are always created on the calling thread, as pipelines depend on them.
+	 */
+	void play(ResourceCache &resource_cache, const uint8_t *data, size_t size, uint32_t thread_count = 1);
+
+	const ResourceReplayStats &get_stats() const;
 
   protected:
-	void create_shader_module(ResourceCache &resource_cache, std::istringstream &stream);
+	void create_shader_module(ResourceCache &resource_cache, ResourceChunkReader &reader);
 
-	void create_pipeline_layout(ResourceCache &resource_cache, std::istringstream &stream);
+	void create_pipeline_layout(ResourceCache &resource_cache, ResourceChunkReader &reader);
 
-	void create_render_pass(ResourceCache &resource_cache, std::istringstream &stream);
+	void create_render_pass(ResourceCache &resource_cache, ResourceChunkReader &reader);
 
-	void create_graphics_pipeline(ResourceCache &resource_cache, std::istringstream &stream);
+	void create_graphics_pipeline(ResourceCache &resource_cache, ResourceChunkReader &reader);
 
   private:
-	using ResourceFunc = std::function<void(ResourceCache &, std::istringstream &)>;
+	/**
+	 * @brief A graphics pipeline being created by a worker thread
+	 */
+	struct PendingGraphicsPipeline
+	{
+		std::unique_ptr<PipelineState> pipeline_state;
+
+		std::future<std::pair<GraphicsPipeline, double>> future;
+	};
+
+	/**
+	 * @brief Adds the pipelines created by worker threads to the cache, in the order they were recorded
+	 */
+	void resolve_graphics_pipelines(ResourceCache &resource_cache);
+
+	/**
+	 * @brief Replays the chunks of a stream after its header, until the end or the first chunk which cannot be replayed
+	 */
+	void play_chunks(ResourceCache &resource_cache, const uint8_t *data, size_t size);
+
+	using ResourceFunc = std::function<void(ResourceCache &, ResourceChunkReader &)>;
 
 	std::unordered_map<ResourceType, ResourceFunc> stream_resources;
 
@@ -54,5 +110,12 @@ class ResourceReplay
 	std::vector<const RenderPass *> render_passes;
 
 	std::vector<const GraphicsPipeline *> graphics_pipelines;
+
+	/// Worker pool used while playing with more than one thread
+	ctpl::thread_pool *thread_pool{nullptr};
+
+	std::vector<PendingGraphicsPipeline> pending_graphics_pipelines;
+
+	ResourceReplayStats stats;
 };
 }        // namespace vkb
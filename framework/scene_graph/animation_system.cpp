@@ -0,0 +1,292 @@
+/* Copyright (c) 2020, Arm Limited and Contributors
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 the "License";
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "animation_system.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <future>
+
+#include "job_system.h"
+#include "scene_graph/components/transform.h"
+#include "timer.h"
+
+namespace vkb
+{
+namespace sg
+{
+constexpr size_t AnimationSystem::PARALLEL_CHANNEL_COUNT;
+
+std::atomic<int64_t> AnimationSystem::total_update_time{0};
+
+void AnimationSystem::add_channel(Transform &transform, AnimationTarget target, const std::vector<float> &times, const std::vector<glm::vec4> &values)
+{
+	assert(!times.empty() && times.size() == values.size() && "Animation channel needs a value for every keyframe");
+
+	auto &group = groups[static_cast<size_t>(target)];
+
+	group.transforms.push_back(&transform);
+	group.key_offsets.push_back(static_cast<uint32_t>(group.key_times.size()));
+	group.key_counts.push_back(static_cast<uint32_t>(times.size()));
+	group.last_keys.push_back(0);
+
+	group.key_times.insert(group.key_times.end(), times.begin(), times.end());
+
+	for (size_t c = 0; c < 4; ++c)
+	{
+		for (auto &value : values)
+		{
+			group.key_values[c].push_back(value[static_cast<glm::length_t>(c)]);
+		}
+	}
+
+	group.factors.push_back(0.0f);
+
+	for (size_t c = 0; c < 4; ++c)
+	{
+		group.from[c].push_back(0.0f);
+		group.to[c].push_back(0.0f);
+		group.results[c].push_back(0.0f);
+	}
+
+	duration = std::max(duration, times.back());
+}
+
+std::vector<AnimationSystem::Channel> AnimationSystem::get_channels() const
+{
+	std::vector<Channel> channels;
+
+	for (size_t target = 0; target < groups.size(); ++target)
+	{
+		auto &group = groups[target];
+
+		for (size_t i = 0; i < group.size(); ++i)
+		{
+			Channel channel{group.transforms[i], static_cast<AnimationTarget>(target), {}, {}};
+
+			auto first = group.key_offsets[i];
+			auto last  = first + group.key_counts[i];
+
+			channel.times.assign(group.key_times.begin() + first, group.key_times.begin() + last);
+
+			for (auto key = first; key < last; ++key)
+			{
+				channel.values.emplace_back(group.key_values[0][key], group.key_values[1][key], group.key_values[2][key], group.key_values[3][key]);
+			}
+
+			channels.push_back(std::move(channel));
+		}
+	}
+
+	return channels;
+}
+
+void AnimationSystem::clear()
+{
+	groups   = {};
+	time     = 0.0f;
+	duration = 0.0f;
+}
+
+void AnimationSystem::evaluate(ChannelGroup &group, bool spherical, size_t first, size_t last) const
+{
+	// Find the keyframes around the time, clamping to the first and last ones
+	for (size_t i = first; i < last; ++i)
+	{
+		const float *times = &group.key_times[group.key_offsets[i]];
+		uint32_t     count = group.key_counts[i];
+		uint32_t     key   = group.last_keys[i];
+
+		if (key >= count || times[key] > time)
+		{
+			key = 0;
+		}
+
+		while (key + 1 < count && times[key + 1] <= time)
+		{
+			++key;
+		}
+
+		group.last_keys[i] = key;
+
+		uint32_t next = std::min(key + 1, count - 1);
+
+		float span       = times[next] - times[key];
+		group.factors[i] = span > 0.0f ? glm::clamp((time - times[key]) / span, 0.0f, 1.0f) : 0.0f;
+
+		for (size_t c = 0; c < 4; ++c)
+		{
+			group.from[c][i] = group.key_values[c][group.key_offsets[i] + key];
+			group.to[c][i]   = group.key_values[c][group.key_offsets[i] + next];
+		}
+	}
+
+	const float *t = group.factors.data();
+
+	if (!spherical)
+	{
+		for (size_t c = 0; c < 3; ++c)
+		{
+			const float *from   = group.from[c].data();
+			const float *to     = group.to[c].data();
+			float *      result = group.results[c].data();
+
+			for (size_t i = first; i < last; ++i)
+			{
+				result[i] = from[i] + (to[i] - from[i]) * t[i];
+			}
+		}
+
+		return;
+	}
+
+	const float *fx = group.from[0].data();
+	const float *fy = group.from[1].data();
+	const float *fz = group.from[2].data();
+	const float *fw = group.from[3].data();
+	const float *tx = group.to[0].data();
+	const float *ty = group.to[1].data();
+	const float *tz = group.to[2].data();
+	const float *tw = group.to[3].data();
+	float *      rx = group.results[0].data();
+	float *      ry = group.results[1].data();
+	float *      rz = group.results[2].data();
+	float *      rw = group.results[3].data();
+
+	// Branchless slerp along the shortest arc, falling back to a normalized lerp for close rotations
+	for (size_t i = first; i < last; ++i)
+	{
+		float cos_theta = fx[i] * tx[i] + fy[i] * ty[i] + fz[i] * tz[i] + fw[i] * tw[i];
+		float sign      = cos_theta < 0.0f ? -1.0f : 1.0f;
+		cos_theta       = std::min(cos_theta * sign, 1.0f);
+
+		float theta     = std::acos(cos_theta);
+		float sin_theta = std::sin(theta);
+		bool  close     = sin_theta < 1e-3f;
+
+		float from_weight = close ? 1.0f - t[i] : std::sin((1.0f - t[i]) * theta) / sin_theta;
+		float to_weight   = (close ? t[i] : std::sin(t[i] * theta) / sin_theta) * sign;
+
+		float x = fx[i] * from_weight + tx[i] * to_weight;
+		float y = fy[i] * from_weight + ty[i] * to_weight;
+		float z = fz[i] * from_weight + tz[i] * to_weight;
+		float w = fw[i] * from_weight + tw[i] * to_weight;
+
+		float inverse_length = 1.0f / std::sqrt(x * x + y * y + z * z + w * w);
+
+		rx[i] = x * inverse_length;
+		ry[i] = y * inverse_length;
+		rz[i] = z * inverse_length;
+		rw[i] = w * inverse_length;
+	}
+}
+
+void AnimationSystem::update(float delta_time)
+{
+	if (get_channel_count() == 0)
+	{
+		return;
+	}
+
+	auto begin = Timer::Clock::now();
+
+	time += delta_time;
+	if (duration > 0.0f)
+	{
+		time = std::fmod(time, duration);
+	}
+
+	auto &job_system = JobSystem::get();
+
+	for (size_t target = 0; target < groups.size(); ++target)
+	{
+		auto &group     = groups[target];
+		bool  spherical = static_cast<AnimationTarget>(target) == AnimationTarget::Rotation;
+
+		if (group.size() < PARALLEL_CHANNEL_COUNT)
+		{
+			evaluate(group, spherical, 0, group.size());
+			continue;
+		}
+
+		std::vector<std::future<void>> range_futures;
+
+		size_t range_count = job_system.get_thread_count() + 1;
+		size_t range_size  = (group.size() + range_count - 1) / range_count;
+
+		for (size_t range_first = range_size; range_first < group.size(); range_first += range_size)
+		{
+			size_t range_last = std::min(range_first + range_size, group.size());
+
+			range_futures.push_back(job_system.push([this, &group, spherical, range_first, range_last](size_t) {
+				evaluate(group, spherical, range_first, range_last);
+			},
+			                                        JobPriority::High));
+		}
+
+		evaluate(group, spherical, 0, std::min(range_size, group.size()));
+
+		for (auto &future : range_futures)
+		{
+			job_system.wait(future);
+		}
+	}
+
+	// Setting the properties marks the transforms to update in their hierarchy, which is not thread safe
+	auto &translations = groups[static_cast<size_t>(AnimationTarget::Translation)];
+	for (size_t i = 0; i < translations.size(); ++i)
+	{
+		translations.transforms[i]->set_translation({translations.results[0][i], translations.results[1][i], translations.results[2][i]});
+	}
+
+	auto &rotations = groups[static_cast<size_t>(AnimationTarget::Rotation)];
+	for (size_t i = 0; i < rotations.size(); ++i)
+	{
+		rotations.transforms[i]->set_rotation(glm::quat{rotations.results[3][i], rotations.results[0][i], rotations.results[1][i], rotations.results[2][i]});
+	}
+
+	auto &scales = groups[static_cast<size_t>(AnimationTarget::Scale)];
+	for (size_t i = 0; i < scales.size(); ++i)
+	{
+		scales.transforms[i]->set_scale({scales.results[0][i], scales.results[1][i], scales.results[2][i]});
+	}
+
+	total_update_time += std::chrono::duration_cast<std::chrono::nanoseconds>(Timer::Clock::now() - begin).count();
+}
+
+size_t AnimationSystem::get_channel_count() const
+{
+	size_t count = 0;
+	for (auto &group : groups)
+	{
+		count += group.size();
+	}
+	return count;
+}
+
+float AnimationSystem::get_duration() const
+{
+	return duration;
+}
+
+double AnimationSystem::get_total_update_time()
+{
+	return static_cast<double>(total_update_time.load()) * 1e-9;
+}
+}        // namespace sg
+}        // namespace vkb
@@ -0,0 +1,165 @@
+/* Copyright (c) 2020, Arm Limited and Contributors
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 the "License";
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <vector>
+
+#include "common/error.h"
+
+VKBP_DISABLE_WARNINGS()
+#include "common/glm_common.h"
+VKBP_ENABLE_WARNINGS()
+
+namespace vkb
+{
+namespace sg
+{
+class Transform;
+
+/**
+ * @brief Property of a transform animated by a channel
+ */
+enum class AnimationTarget
+{
+	Translation,
+	Rotation,
+	Scale
+};
+
+/**
+ * @brief Evaluates the keyframe channels of many transforms in batches
+ *
+ * Channels are grouped by target, with their keyframes and per frame evaluation data
+ * in structure of arrays layout, so that interpolation runs as straight loops over
+ * contiguous components which the compiler vectorizes. Large groups are split across
+ * the workers of the job system. The results are then written to the transforms, which
+ * invalidates them in their hierarchy.
+ */
+class AnimationSystem
+{
+  public:
+	/// Below this many channels a group is evaluated on the calling thread
+	static constexpr size_t PARALLEL_CHANNEL_COUNT = 1024;
+
+	/**
+	 * @brief The keyframes of a channel, as they are given to add_channel
+	 */
+	struct Channel
+	{
+		Transform *transform;
+
+		AnimationTarget target;
+
+		std::vector<float> times;
+
+		std::vector<glm::vec4> values;
+	};
+
+	/**
+	 * @brief Adds a channel linearly interpolating keyframes, rotations being spherically interpolated
+	 * @param transform Transform to animate, which must outlive the system
+	 * @param target Property of the transform to animate
+	 * @param times Ascending time of every keyframe, in seconds
+	 * @param values Value of every keyframe, xyz for translations and scales, a quaternion as xyzw for rotations
+	 */
+	void add_channel(Transform &transform, AnimationTarget target, const std::vector<float> &times, const std::vector<glm::vec4> &values);
+
+	/**
+	 * @brief Removes all the channels
+	 */
+	void clear();
+
+	/**
+	 * @brief Advances the time and writes the interpolated values of all channels to their transforms
+	 *        The animation loops over the duration of its longest channel.
+	 * @param delta_time Time since the last update, in seconds
+	 */
+	void update(float delta_time);
+
+	size_t get_channel_count() const;
+
+	/**
+	 * @return A copy of every channel, grouped by target
+	 */
+	std::vector<Channel> get_channels() const;
+
+	/**
+	 * @return Length of the animation, in seconds
+	 */
+	float get_duration() const;
+
+	/**
+	 * @return Time spent in the updates of all animation systems since the start of the application, in seconds
+	 */
+	static double get_total_update_time();
+
+  private:
+	/**
+	 * @brief Channels of a target, and their evaluation
+	 */
+	struct ChannelGroup
+	{
+		std::vector<Transform *> transforms;
+
+		/// First keyframe and keyframe count of every channel
+		std::vector<uint32_t> key_offsets;
+
+		std::vector<uint32_t> key_counts;
+
+		/// Keyframe found by the last update, searched from first as time usually moves forward
+		std::vector<uint32_t> last_keys;
+
+		/// Time and components of all keyframes
+		std::vector<float> key_times;
+
+		std::array<std::vector<float>, 4> key_values;
+
+		/// Interpolation factor, keyframe values around the time and result of every channel
+		std::vector<float> factors;
+
+		std::array<std::vector<float>, 4> from;
+
+		std::array<std::vector<float>, 4> to;
+
+		std::array<std::vector<float>, 4> results;
+
+		size_t size() const
+		{
+			return transforms.size();
+		}
+	};
+
+	/**
+	 * @brief Evaluates a range of the channels of a group
+	 */
+	void evaluate(ChannelGroup &group, bool spherical, size_t first, size_t last) const;
+
+	std::array<ChannelGroup, 3> groups;
+
+	float time{0.0f};
+
+	float duration{0.0f};
+
+	/// Sum of the update times of all systems, in nanoseconds
+	static std::atomic<int64_t> total_update_time;
+};
+}        // namespace sg
+}        // namespace vkb
@@ -0,0 +1,213 @@
+/* Copyright (c) 2020, Arm Limited and Contributors
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 the "License";
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <cassert>
+#include <cstddef>
+#include <iterator>
+#include <stdexcept>
+#include <vector>
+
+namespace vkb
+{
+namespace sg
+{
+class Component;
+
+/**
+ * @brief Non-owning view over the dense array of the scene components of a type, casted to that type
+ *
+ * The view is invalidated when components of the same type are added to or removed from the scene.
+ */
+template <class T>
+class ComponentSpan
+{
+  public:
+	class Iterator
+	{
+	  public:
+		using iterator_category = std::random_access_iterator_tag;
+		using value_type        = T *;
+		using difference_type   = std::ptrdiff_t;
+		using pointer           = T *const *;
+		using reference         = T *;
+
+		Iterator(Component *const *it) :
+		    it{it}
+		{}
+
+		T *operator*() const
+		{
+			return static_cast<T *>(*it);
+		}
+
+		T *operator[](difference_type n) const
+		{
+			return static_cast<T *>(it[n]);
+		}
+
+		Iterator &operator++()
+		{
+			++it;
+			return *this;
+		}
+
+		Iterator operator++(int)
+		{
+			return Iterator{it++};
+		}
+
+		Iterator &operator--()
+		{
+			--it;
+			return *this;
+		}
+
+		Iterator operator--(int)
+		{
+			return Iterator{it--};
+		}
+
+		Iterator &operator+=(difference_type n)
+		{
+			it += n;
+			return *this;
+		}
+
+		Iterator &operator-=(difference_type n)
+		{
+			it -= n;
+			return *this;
+		}
+
+		Iterator operator+(difference_type n) const
+		{
+			return Iterator{it + n};
+		}
+
+		Iterator operator-(difference_type n) const
+		{
+			return Iterator{it - n};
+		}
+
+		difference_type operator-(const Iterator &other) const
+		{
+			return it - other.it;
+		}
+
+		bool operator==(const Iterator &other) const
+		{
+			return it == other.it;
+		}
+
+		bool operator!=(const Iterator &other) const
+		{
+			return it != other.it;
+		}
+
+		bool operator<(const Iterator &other) const
+		{
+			return it < other.it;
+		}
+
+		bool operator>(const Iterator &other) const
+		{
+			return it > other.it;
+		}
+
+		bool operator<=(const Iterator &other) const
+		{
+			return it <= other.it;
+		}
+
+		bool operator>=(const Iterator &other) const
+		{
+			return it >= other.it;
+		}
+
+	  private:
+		Component *const *it;
+	};
+
+	ComponentSpan() = default;
+
+	ComponentSpan(Component *const *data, size_t count) :
+	    data{data},
+	    count{count}
+	{}
+
+	Iterator begin() const
+	{
+		return Iterator{data};
+	}
+
+	Iterator end() const
+	{
+		return Iterator{data + count};
+	}
+
+	size_t size() const
+	{
+		return count;
+	}
+
+	bool empty() const
+	{
+		return count == 0;
+	}
+
+	T *operator[](size_t index) const
+	{
+		assert(index < count && "ComponentSpan index out of range");
+		return static_cast<T *>(data[index]);
+	}
+
+	T *at(size_t index) const
+	{
+		if (index >= count)
+		{
+			throw std::out_of_range("ComponentSpan index out of range");
+		}
+		return static_cast<T *>(data[index]);
+	}
+
+	T *front() const
+	{
+		return (*this)[0];
+	}
+
+	T *back() const
+	{
+		return (*this)[count - 1];
+	}
+
+	/**
+	 * @return A copy of the pointers, which remains valid when components are added to the scene
+	 */
+	std::vector<T *> to_vector() const
+	{
+		return {begin(), end()};
+	}
+
+  private:
+	Component *const *data{nullptr};
+
+	size_t count{0};
+};
+}        // namespace sg
+}        // namespace vkb
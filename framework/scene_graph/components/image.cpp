@@ -17,6 +17,7 @@
 
 #include "image.h"
 
+#include <cstring>
 #include <mutex>
 
 #include "common/error.h"
@@ -27,15 +28,51 @@ VKBP_DISABLE_WARNINGS()
 VKBP_ENABLE_WARNINGS()
 
 #include "common/utils.h"
+#include "platform/asset_archive.h"
 #include "platform/filesystem.h"
 #include "scene_graph/components/image/astc.h"
 #include "scene_graph/components/image/ktx.h"
+#ifdef VKB_KTX2
+#	include "scene_graph/components/image/ktx2.h"
+#endif
 #include "scene_graph/components/image/stb.h"
 
 namespace vkb
 {
 namespace sg
 {
+namespace
+{
+/// Must be increased whenever the layout of packed images changes
+constexpr uint32_t PACKED_IMAGE_VERSION = 2;
+
+/// Data of packed images starts at a multiple of this, relative to the start of the packed image
+constexpr size_t PACKED_IMAGE_DATA_ALIGNMENT = 16;
+
+struct PackedImageHeader
+{
+	uint32_t version;
+
+	VkFormat format;
+
+	uint32_t layers;
+
+	uint32_t mip_count;
+
+	/// Number of array layers in the offsets table, 0 if the image has no offsets
+	uint32_t offset_layers;
+
+	uint32_t data_offset;
+
+	/// Whether the levels above 0 are generated on the GPU, in which case only level 0 is stored
+	uint32_t gpu_mipmaps;
+
+	uint32_t reserved;
+
+	uint64_t data_size;
+};
+}        // namespace
+
 bool is_astc(const VkFormat format)
 {
 	return (format == VK_FORMAT_ASTC_4x4_UNORM_BLOCK ||
@@ -121,10 +158,12 @@ void Image::create_vk_image(Device &device, VkImageViewType image_view_type, VkI
 {
 	assert(!vk_image && !vk_image_view && "Vulkan image already constructed");
 
+	transcode(device);
+
 	vk_image = std::make_unique<core::Image>(device,
 	                                         get_extent(),
 	                                         format,
-	                                         VK_IMAGE_USAGE_SAMPLED_BIT | VK_IMAGE_USAGE_TRANSFER_DST_BIT,
+	                                         VK_IMAGE_USAGE_SAMPLED_BIT | VK_IMAGE_USAGE_TRANSFER_DST_BIT | (gpu_mipmaps ? VK_IMAGE_USAGE_TRANSFER_SRC_BIT : 0),
 	                                         VMA_MEMORY_USAGE_GPU_ONLY,
 	                                         VK_SAMPLE_COUNT_1_BIT,
 	                                         to_u32(mipmaps.size()),
@@ -135,6 +174,10 @@ void Image::create_vk_image(Device &device, VkImageViewType image_view_type, VkI
 	vk_image_view = std::make_unique<core::ImageView>(*vk_image, image_view_type);
 }
 
+void Image::transcode(Device & /*device*/)
+{
+}
+
 const core::Image &Image::get_vk_image() const
 {
 	assert(vk_image && "Vulkan image was not created");
@@ -147,6 +190,12 @@ const core::ImageView &Image::get_vk_image_view() const
 	return *vk_image_view;
 }
 
+void Image::swap_vk_image(std::unique_ptr<core::Image> &image, std::unique_ptr<core::ImageView> &image_view)
+{
+	std::swap(vk_image, image);
+	std::swap(vk_image_view, image_view);
+}
+
 Mipmap &Image::get_mipmap(const size_t index)
 {
 	return mipmaps.at(index);
@@ -198,6 +247,38 @@ void Image::generate_mipmaps()
 	}
 }
 
+void Image::add_gpu_mipmaps()
+{
+	assert(mipmaps.size() == 1 && "Mipmaps already generated");
+
+	if (mipmaps.size() > 1)
+	{
+		return;        // Do not generate again
+	}
+
+	while (mipmaps.back().extent.width > 1 || mipmaps.back().extent.height > 1)
+	{
+		auto &prev_mipmap = mipmaps.back();
+
+		// The level has no data, its offset is not used
+		Mipmap next_mipmap{};
+		next_mipmap.level  = prev_mipmap.level + 1;
+		next_mipmap.offset = 0;
+		next_mipmap.extent = {std::max<uint32_t>(1u, prev_mipmap.extent.width / 2),
+		                      std::max<uint32_t>(1u, prev_mipmap.extent.height / 2),
+		                      1u};
+
+		mipmaps.emplace_back(std::move(next_mipmap));
+	}
+
+	gpu_mipmaps = mipmaps.size() > 1;
+}
+
+bool Image::has_gpu_mipmaps() const
+{
+	return gpu_mipmaps;
+}
+
 std::vector<Mipmap> &Image::get_mut_mipmaps()
 {
 	return mipmaps;
@@ -246,28 +327,139 @@ void Image::set_offsets(const std::vector<std::vector<VkDeviceSize>> &o)
 
 std::unique_ptr<Image> Image::load(const std::string &name, const std::string &uri)
 {
-	std::unique_ptr<Image> image{nullptr};
+	// The file is decoded straight from its mapping
+	if (auto archive = fs::AssetArchive::get_mounted())
+	{
+		// Images in the mounted archive are already transcoded
+		if (auto entry = archive->find(uri))
+		{
+			if (entry->type == fs::AssetArchive::EntryType::Image)
+			{
+				return unpack(name, archive->get_data(*entry), static_cast<size_t>(entry->size));
+			}
 
-	auto data = fs::read_asset(uri);
+			return decode(name, uri, archive->get_data(*entry), static_cast<size_t>(entry->size));
+		}
+	}
+
+	auto file = fs::map_asset(uri);
+
+	return decode(name, uri, file.data(), file.size());
+}
+
+std::unique_ptr<Image> Image::decode(const std::string &name, const std::string &uri, const uint8_t *data, size_t size)
+{
+	std::unique_ptr<Image> image{nullptr};
 
 	// Get extension
 	auto extension = get_extension(uri);
 
 	if (extension == "png" || extension == "jpg")
 	{
-		image = std::make_unique<Stb>(name, data);
+		image = std::make_unique<Stb>(name, data, size);
 	}
 	else if (extension == "astc")
 	{
-		image = std::make_unique<Astc>(name, data);
+		image = std::make_unique<Astc>(name, data, size);
 	}
 	else if (extension == "ktx")
 	{
-		image = std::make_unique<Ktx>(name, data);
+		image = std::make_unique<Ktx>(name, data, size);
+	}
+#ifdef VKB_KTX2
+	else if (extension == "ktx2")
+	{
+		image = std::make_unique<Ktx2>(name, data, size);
 	}
+#endif
 
 	return image;
 }
 
+std::unique_ptr<Image> Image::unpack(const std::string &name, const uint8_t *data, size_t size)
+{
+	PackedImageHeader header;
+	if (size < sizeof(header))
+	{
+		throw std::runtime_error{"Packed image " + name + " is truncated"};
+	}
+	std::memcpy(&header, data, sizeof(header));
+
+	if (header.version != PACKED_IMAGE_VERSION)
+	{
+		throw std::runtime_error{"Packed image " + name + " has an unsupported version"};
+	}
+
+	size_t mipmaps_size = header.mip_count * sizeof(Mipmap);
+	size_t offsets_size = header.offset_layers * header.mip_count * sizeof(VkDeviceSize);
+
+	if (header.mip_count == 0 ||
+	    sizeof(header) + mipmaps_size + offsets_size > header.data_offset ||
+	    header.data_offset + header.data_size > size)
+	{
+		throw std::runtime_error{"Packed image " + name + " is truncated"};
+	}
+
+	std::vector<Mipmap> mipmaps(header.mip_count);
+	std::memcpy(mipmaps.data(), data + sizeof(header), mipmaps_size);
+
+	std::vector<std::vector<VkDeviceSize>> offsets(header.offset_layers, std::vector<VkDeviceSize>(header.mip_count));
+	for (uint32_t layer = 0; layer < header.offset_layers; ++layer)
+	{
+		std::memcpy(offsets[layer].data(), data + sizeof(header) + mipmaps_size + layer * header.mip_count * sizeof(VkDeviceSize), header.mip_count * sizeof(VkDeviceSize));
+	}
+
+	// The data is already in its upload layout, a single copy is needed
+	auto pixels = data + header.data_offset;
+
+	auto image = std::make_unique<Image>(name, std::vector<uint8_t>(pixels, pixels + header.data_size), std::move(mipmaps));
+	image->set_format(header.format);
+	image->set_layers(header.layers);
+	image->set_offsets(offsets);
+	image->gpu_mipmaps = header.gpu_mipmaps != 0;
+
+	return image;
+}
+
+std::vector<uint8_t> Image::pack() const
+{
+	// The offsets table is only valid when it has an entry for every mip level of every layer
+	auto offset_layers = to_u32(offsets.size());
+	for (auto &layer_offsets : offsets)
+	{
+		if (layer_offsets.size() != mipmaps.size())
+		{
+			throw std::runtime_error{"Image " + get_name() + " has incomplete offsets"};
+		}
+	}
+
+	size_t mipmaps_size = mipmaps.size() * sizeof(Mipmap);
+	size_t offsets_size = offset_layers * mipmaps.size() * sizeof(VkDeviceSize);
+
+	PackedImageHeader header{};
+	header.version       = PACKED_IMAGE_VERSION;
+	header.format        = format;
+	header.layers        = layers;
+	header.mip_count     = to_u32(mipmaps.size());
+	header.offset_layers = offset_layers;
+	header.gpu_mipmaps   = gpu_mipmaps ? 1 : 0;
+	header.data_offset   = to_u32((sizeof(header) + mipmaps_size + offsets_size + PACKED_IMAGE_DATA_ALIGNMENT - 1) & ~(PACKED_IMAGE_DATA_ALIGNMENT - 1));
+	header.data_size     = data.size();
+
+	std::vector<uint8_t> packed(header.data_offset + data.size(), 0);
+
+	std::memcpy(packed.data(), &header, sizeof(header));
+	std::memcpy(packed.data() + sizeof(header), mipmaps.data(), mipmaps_size);
+
+	for (uint32_t layer = 0; layer < offset_layers; ++layer)
+	{
+		std::memcpy(packed.data() + sizeof(header) + mipmaps_size + layer * mipmaps.size() * sizeof(VkDeviceSize), offsets[layer].data(), mipmaps.size() * sizeof(VkDeviceSize));
+	}
+
+	std::copy(data.begin(), data.end(), packed.begin() + header.data_offset);
+
+	return packed;
+}
+
 }        // namespace sg
 }        // namespace vkb
@@ -60,6 +60,33 @@ class Image : public Component
 
 	static std::unique_ptr<Image> load(const std::string &name, const std::string &uri);
 
+	/**
+	 * @brief Decodes an image file already read in memory
+	 * @param name Name of the component
+	 * @param uri Path of the file, its extension selects the decoder
+	 * @param data Contents of the file
+	 * @param size Size of the file in bytes
+	 * @return The decoded image, or nullptr if the extension is not supported
+	 */
+	static std::unique_ptr<Image> decode(const std::string &name, const std::string &uri, const uint8_t *data, size_t size);
+
+	/**
+	 * @brief Creates an image from the output of pack, its data is copied as is without decoding
+	 * @param name Name of the component
+	 * @param data Packed image, as stored in an asset archive
+	 * @param size Size of the packed image in bytes
+	 * @throws runtime_error if the packed image is truncated or of another version
+	 */
+	static std::unique_ptr<Image> unpack(const std::string &name, const uint8_t *data, size_t size);
+
+	/**
+	 * @brief Serializes the format, layers, mip levels and data of the image
+	 *        The data is stored with the layout described by get_mipmaps and get_offsets,
+	 *        so that it can be copied to a staging buffer in a single read
+	 * @return The packed image
+	 */
+	std::vector<uint8_t> pack() const;
+
 	virtual ~Image() = default;
 
 	virtual std::type_index get_type() override;
@@ -80,12 +107,36 @@ class Image : public Component
 
 	void generate_mipmaps();
 
+	/**
+	 * @brief Describes a full mip chain without generating its data
+	 *        Only level 0 is uploaded, the other levels have to be generated on the GPU
+	 */
+	void add_gpu_mipmaps();
+
+	/**
+	 * @return Whether the mip levels above 0 are generated on the GPU
+	 */
+	bool has_gpu_mipmaps() const;
+
 	void create_vk_image(Device &device, VkImageViewType image_view_type = VK_IMAGE_VIEW_TYPE_2D, VkImageCreateFlags flags = 0);
 
 	const core::Image &get_vk_image() const;
 
 	const core::ImageView &get_vk_image_view() const;
 
+	/**
+	 * @brief Exchanges the Vulkan image and its view with others, like ones holding fewer mip levels
+	 *        The previous image and view are returned in the arguments, and have to outlive the frames using them.
+	 */
+	void swap_vk_image(std::unique_ptr<core::Image> &image, std::unique_ptr<core::ImageView> &image_view);
+
+	/**
+	 * @brief Converts the data to a format the device supports, called before the Vulkan image is created
+	 *        The data of most images is already in its final format, in which case this does nothing,
+	 *        as do later calls once it was converted
+	 */
+	virtual void transcode(Device &device);
+
   protected:
 	std::vector<uint8_t> &get_mut_data();
 
@@ -122,6 +173,8 @@ class Image : public Component
 	std::unique_ptr<core::Image> vk_image;
 
 	std::unique_ptr<core::ImageView> vk_image_view;
+
+	bool gpu_mipmaps{false};
 };
 
 }        // namespace sg
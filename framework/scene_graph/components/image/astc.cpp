@@ -17,7 +17,11 @@
 
 #include "scene_graph/components/image/astc.h"
 
+#include <algorithm>
+#include <future>
 #include <mutex>
+#include <sstream>
+#include <thread>
 
 #include "common/error.h"
 
@@ -30,12 +34,100 @@ VKBP_DISABLE_WARNINGS()
 #include <astc_codec_internals.h>
 VKBP_ENABLE_WARNINGS()
 
+#include "common/helpers.h"
+#include "common/logging.h"
+#include "job_system.h"
+#include "platform/filesystem.h"
+
 #define MAGIC_FILE_CONSTANT 0x5CA1AB13
 
 namespace vkb
 {
 namespace sg
 {
+namespace
+{
+/// Must be increased whenever the decoder output changes
+constexpr uint32_t DECODE_CACHE_VERSION = 1;
+
+const std::string DECODE_CACHE_FOLDER = "astc_cache/";
+
+/// Guards the decode cache files, as images are decoded from several threads
+std::mutex decode_cache_mutex;
+
+inline std::string get_decode_cache_filename(size_t key)
+{
+	std::stringstream filename;
+	filename << DECODE_CACHE_FOLDER << std::hex << key << ".bin";
+	return filename.str();
+}
+
+inline size_t get_decode_cache_key(BlockDim blockdim, VkExtent3D extent, const uint8_t *data, size_t size)
+{
+	size_t key = 0;
+
+	hash_combine(key, DECODE_CACHE_VERSION);
+	hash_combine(key, blockdim.x);
+	hash_combine(key, blockdim.y);
+	hash_combine(key, blockdim.z);
+	hash_combine(key, extent.width);
+	hash_combine(key, extent.height);
+	hash_combine(key, extent.depth);
+	hash_combine(key, std::string{data, data + size});
+
+	return key;
+}
+
+bool read_decode_cache(size_t key, VkExtent3D &extent, std::vector<uint8_t> &decoded)
+{
+	std::vector<uint8_t> file_data;
+
+	try
+	{
+		std::lock_guard<std::mutex> guard(decode_cache_mutex);
+
+		file_data = fs::read_temp(get_decode_cache_filename(key));
+	}
+	catch (const std::runtime_error &)
+	{
+		return false;
+	}
+
+	std::istringstream is{std::string{file_data.begin(), file_data.end()}};
+
+	size_t stored_key{0};
+	read(is, stored_key, extent.width, extent.height, extent.depth, decoded);
+
+	return is && stored_key == key && decoded.size() == extent.width * extent.height * extent.depth * 4;
+}
+
+void write_decode_cache(size_t key, const VkExtent3D &extent, const std::vector<uint8_t> &decoded)
+{
+	std::ostringstream os;
+	write(os, key, extent.width, extent.height, extent.depth, decoded);
+
+	std::string str = os.str();
+
+	try
+	{
+		std::lock_guard<std::mutex> guard(decode_cache_mutex);
+
+		auto temp_directory = fs::path::get(fs::path::Type::Temp);
+
+		if (!fs::is_directory(temp_directory + DECODE_CACHE_FOLDER))
+		{
+			fs::create_path(temp_directory, DECODE_CACHE_FOLDER);
+		}
+
+		fs::write_temp({str.begin(), str.end()}, get_decode_cache_filename(key));
+	}
+	catch (const std::runtime_error &ex)
+	{
+		LOGW("Failed to cache decoded astc image. {}", ex.what());
+	}
+}
+}        // namespace
+
 BlockDim to_blockdim(const VkFormat format)
 {
 	switch (format)
@@ -113,7 +205,7 @@ void Astc::init()
 	}
 }
 
-void Astc::decode(BlockDim blockdim, VkExtent3D extent, const uint8_t *data_)
+void Astc::decode(BlockDim blockdim, VkExtent3D extent, const uint8_t *data_, size_t size)
 {
 	// Actual decoding
 	astc_decode_mode decode_mode = DECODE_LDR_SRGB;
@@ -144,57 +236,102 @@ void Astc::decode(BlockDim blockdim, VkExtent3D extent, const uint8_t *data_)
 	int yblocks = (ysize + ydim - 1) / ydim;
 	int zblocks = (zsize + zdim - 1) / zdim;
 
+	if (size < static_cast<size_t>(xblocks * yblocks * zblocks * 16))
+	{
+		throw std::runtime_error{"Error reading astc: invalid memory"};
+	}
+
+	set_format(VK_FORMAT_R8G8B8A8_SRGB);
+
+	// Reuse the output of a previous run
+	auto cache_key = get_decode_cache_key(blockdim, extent, data_, size);
+
+	VkExtent3D           decoded_extent{};
+	std::vector<uint8_t> decoded;
+
+	if (read_decode_cache(cache_key, decoded_extent, decoded))
+	{
+		set_data(decoded.data(), decoded.size());
+		set_width(decoded_extent.width);
+		set_height(decoded_extent.height);
+		set_depth(decoded_extent.depth);
+		return;
+	}
+
 	auto astc_image = allocate_image(bitness, xsize, ysize, zsize, 0);
 	initialize_image(astc_image);
 
-	imageblock pb;
-	for (int z = 0; z < zblocks; z++)
+	// Decode rows of blocks in parallel, each block writes a distinct area of the image
+	// Loader jobs waiting for the decode run the queued rows meanwhile, so they do not block the workers
+	auto &job_system = JobSystem::get();
+
+	int row_count  = zblocks * yblocks;
+	int task_count = std::min(static_cast<int>(job_system.get_thread_count()), row_count);
+
+	std::vector<std::future<void>> row_futures;
+
+	for (int task_index = 0; task_index < task_count; task_index++)
 	{
-		for (int y = 0; y < yblocks; y++)
-		{
-			for (int x = 0; x < xblocks; x++)
+		row_futures.push_back(job_system.push([&, task_index](size_t) {
+			imageblock pb;
+
+			// Interleave rows so that tasks get a similar amount of work
+			for (int row = task_index; row < row_count; row += task_count)
 			{
-				int            offset = (((z * yblocks + y) * xblocks) + x) * 16;
-				const uint8_t *bp     = data_ + offset;
+				int z = row / yblocks;
+				int y = row % yblocks;
 
-				physical_compressed_block pcb = *reinterpret_cast<const physical_compressed_block *>(bp);
-				symbolic_compressed_block scb;
+				for (int x = 0; x < xblocks; x++)
+				{
+					int            offset = (((z * yblocks + y) * xblocks) + x) * 16;
+					const uint8_t *bp     = data_ + offset;
 
-				physical_to_symbolic(xdim, ydim, zdim, pcb, &scb);
-				decompress_symbolic_block(decode_mode, xdim, ydim, zdim, x * xdim, y * ydim, z * zdim, &scb, &pb);
-				write_imageblock(astc_image, &pb, xdim, ydim, zdim, x * xdim, y * ydim, z * zdim, swz_decode);
+					physical_compressed_block pcb = *reinterpret_cast<const physical_compressed_block *>(bp);
+					symbolic_compressed_block scb;
+
+					physical_to_symbolic(xdim, ydim, zdim, pcb, &scb);
+					decompress_symbolic_block(decode_mode, xdim, ydim, zdim, x * xdim, y * ydim, z * zdim, &scb, &pb);
+					write_imageblock(astc_image, &pb, xdim, ydim, zdim, x * xdim, y * ydim, z * zdim, swz_decode);
+				}
 			}
-		}
+		}));
+	}
+
+	for (auto &row_future : row_futures)
+	{
+		job_system.wait(row_future);
+		row_future.get();
 	}
 
 	set_data(astc_image->imagedata8[0][0], astc_image->xsize * astc_image->ysize * astc_image->zsize * 4);
-	set_format(VK_FORMAT_R8G8B8A8_SRGB);
 	set_width(static_cast<uint32_t>(astc_image->xsize));
 	set_height(static_cast<uint32_t>(astc_image->ysize));
 	set_depth(static_cast<uint32_t>(astc_image->zsize));
 
 	destroy_image(astc_image);
+
+	write_decode_cache(cache_key, get_extent(), get_data());
 }
 
 Astc::Astc(const Image &image) :
     Image{image.get_name()}
 {
 	init();
-	decode(to_blockdim(image.get_format()), image.get_extent(), image.get_data().data());
+	decode(to_blockdim(image.get_format()), image.get_extent(), image.get_data().data(), image.get_data().size());
 }
 
-Astc::Astc(const std::string &name, const std::vector<uint8_t> &data) :
+Astc::Astc(const std::string &name, const uint8_t *data, size_t size) :
     Image{name}
 {
 	init();
 
 	// Read header
-	if (data.size() < sizeof(AstcHeader))
+	if (size < sizeof(AstcHeader))
 	{
 		throw std::runtime_error{"Error reading astc: invalid memory"};
 	}
 	AstcHeader header{};
-	std::memcpy(&header, data.data(), sizeof(AstcHeader));
+	std::memcpy(&header, data, sizeof(AstcHeader));
 	uint32_t magicval = header.magic[0] + 256 * static_cast<uint32_t>(header.magic[1]) + 65536 * static_cast<uint32_t>(header.magic[2]) + 16777216 * static_cast<uint32_t>(header.magic[3]);
 	if (magicval != MAGIC_FILE_CONSTANT)
 	{
@@ -211,7 +348,7 @@ Astc::Astc(const std::string &name, const std::vector<uint8_t> &data) :
 	    /* height = */ static_cast<uint32_t>(header.ysize[0] + 256 * header.ysize[1] + 65536 * header.ysize[2]),
 	    /* depth  = */ static_cast<uint32_t>(header.zsize[0] + 256 * header.zsize[1] + 65536 * header.zsize[2])};
 
-	decode(blockdim, extent, data.data() + sizeof(AstcHeader));
+	decode(blockdim, extent, data + sizeof(AstcHeader), size - sizeof(AstcHeader));
 }
 
 }        // namespace sg
@@ -44,19 +44,22 @@ class Astc : public Image
 	 * @brief Decodes ASTC data with an ASTC header
 	 * @param name Name of the component
 	 * @param data ASTC data with header
+	 * @param size Size of the data in bytes
 	 */
-	Astc(const std::string &name, const std::vector<uint8_t> &data);
+	Astc(const std::string &name, const uint8_t *data, size_t size);
 
 	virtual ~Astc() = default;
 
   private:
 	/**
-	 * @brief Decodes ASTC data
+	 * @brief Decodes ASTC data, splitting rows of blocks across threads
+	 *        The decoded image is cached, so that later runs do not decode it again
 	 * @param blockdim Dimensions of the block
 	 * @param extent Extent of the image
 	 * @param data Pointer to ASTC image data
+	 * @param size Size of the ASTC image data
 	 */
-	void decode(BlockDim blockdim, VkExtent3D extent, const uint8_t *data);
+	void decode(BlockDim blockdim, VkExtent3D extent, const uint8_t *data, size_t size);
 
 	/**
 	 * @brief Initializes ASTC library
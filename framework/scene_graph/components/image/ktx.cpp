@@ -61,11 +61,11 @@ static KTX_error_code KTXAPIENTRY optimal_tiling_callback(int mip_level,
 	return KTX_SUCCESS;
 }
 
-Ktx::Ktx(const std::string &name, const std::vector<uint8_t> &data) :
+Ktx::Ktx(const std::string &name, const uint8_t *data, size_t size) :
     Image{name}
 {
-	auto data_buffer = reinterpret_cast<const ktx_uint8_t *>(data.data());
-	auto data_size   = static_cast<ktx_size_t>(data.size());
+	auto data_buffer = reinterpret_cast<const ktx_uint8_t *>(data);
+	auto data_size   = static_cast<ktx_size_t>(size);
 
 	ktxTexture *texture;
 	auto        load_ktx_result = ktxTexture_CreateFromMemory(data_buffer,
@@ -77,6 +77,18 @@ Ktx::Ktx(const std::string &name, const std::vector<uint8_t> &data) :
 		throw std::runtime_error{"Error loading KTX texture: " + name};
 	}
 
+	load_texture(texture, vkGetFormatFromOpenGLInternalFormat(texture->glInternalformat));
+
+	ktxTexture_Destroy(texture);
+}
+
+Ktx::Ktx(const std::string &name) :
+    Image{name}
+{
+}
+
+void Ktx::load_texture(ktxTexture *texture, VkFormat format)
+{
 	if (texture->pData)
 	{
 		// Already loaded
@@ -91,7 +103,7 @@ Ktx::Ktx(const std::string &name, const std::vector<uint8_t> &data) :
 		auto load_data_result = ktxTexture_LoadImageData(texture, mut_data.data(), size);
 		if (load_data_result != KTX_SUCCESS)
 		{
-			throw std::runtime_error{"Error loading KTX image data: " + name};
+			throw std::runtime_error{"Error loading KTX image data: " + get_name()};
 		}
 	}
 
@@ -111,8 +123,7 @@ Ktx::Ktx(const std::string &name, const std::vector<uint8_t> &data) :
 	}
 
 	// Update format
-	auto updated_format = vkGetFormatFromOpenGLInternalFormat(texture->glInternalformat);
-	set_format(updated_format);
+	set_format(format);
 
 	// Update mip levels
 	auto &mipmap_levels = get_mut_mipmaps();
@@ -160,8 +171,6 @@ Ktx::Ktx(const std::string &name, const std::vector<uint8_t> &data) :
 		}
 		set_offsets(offsets);
 	}
-
-	ktxTexture_Destroy(texture);
 }
 
 }        // namespace sg
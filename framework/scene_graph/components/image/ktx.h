@@ -20,6 +20,8 @@
 #include "common/error.h"
 #include "scene_graph/components/image.h"
 
+struct ktxTexture;
+
 namespace vkb
 {
 namespace sg
@@ -27,9 +29,19 @@ namespace sg
 class Ktx : public Image
 {
   public:
-	Ktx(const std::string &name, const std::vector<uint8_t> &data);
+	Ktx(const std::string &name, const uint8_t *data, size_t size);
 
 	virtual ~Ktx() = default;
+
+  protected:
+	Ktx(const std::string &name);
+
+	/**
+	 * @brief Takes the data, extent, mip levels and layer offsets of a texture whose image data is loaded
+	 * @param texture The texture
+	 * @param format The Vulkan format of the image data
+	 */
+	void load_texture(ktxTexture *texture, VkFormat format);
 };
 
 }        // namespace sg
@@ -0,0 +1,133 @@
+/* Copyright (c) 2020, Arm Limited and Contributors
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 the "License";
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "scene_graph/components/image/ktx2.h"
+
+#include <algorithm>
+#include <iterator>
+
+#include "common/logging.h"
+#include "common/strings.h"
+#include "core/device.h"
+
+VKBP_DISABLE_WARNINGS()
+#include <ktx.h>
+VKBP_ENABLE_WARNINGS()
+
+namespace vkb
+{
+namespace sg
+{
+namespace
+{
+struct TranscodeFormat
+{
+	VkFormat unorm;
+
+	VkFormat srgb;
+
+	ktx_transcode_fmt_e ktx_format;
+};
+
+/// Transcode targets in order of preference, uncompressed RGBA8 is always supported
+const TranscodeFormat TRANSCODE_FORMATS[] = {
+    {VK_FORMAT_ASTC_4x4_UNORM_BLOCK, VK_FORMAT_ASTC_4x4_SRGB_BLOCK, KTX_TTF_ASTC_4x4_RGBA},
+    {VK_FORMAT_BC7_UNORM_BLOCK, VK_FORMAT_BC7_SRGB_BLOCK, KTX_TTF_BC7_RGBA},
+    {VK_FORMAT_ETC2_R8G8B8A8_UNORM_BLOCK, VK_FORMAT_ETC2_R8G8B8A8_SRGB_BLOCK, KTX_TTF_ETC2_RGBA},
+    {VK_FORMAT_R8G8B8A8_UNORM, VK_FORMAT_R8G8B8A8_SRGB, KTX_TTF_RGBA32}};
+}        // namespace
+
+Ktx2::Ktx2(const std::string &name, const uint8_t *data, size_t size) :
+    Ktx{name}
+{
+	auto result = ktxTexture2_CreateFromMemory(reinterpret_cast<const ktx_uint8_t *>(data),
+	                                           static_cast<ktx_size_t>(size),
+	                                           KTX_TEXTURE_CREATE_LOAD_IMAGE_DATA_BIT,
+	                                           &texture);
+	if (result != KTX_SUCCESS)
+	{
+		throw std::runtime_error{"Error loading KTX2 texture: " + name};
+	}
+
+	if (!ktxTexture2_NeedsTranscoding(texture))
+	{
+		// Already in a block or pixel format
+		load_texture(ktxTexture(texture), static_cast<VkFormat>(texture->vkFormat));
+
+		ktxTexture_Destroy(ktxTexture(texture));
+		texture = nullptr;
+	}
+}
+
+Ktx2::~Ktx2()
+{
+	if (texture)
+	{
+		ktxTexture_Destroy(ktxTexture(texture));
+	}
+}
+
+bool Ktx2::needs_transcoding() const
+{
+	return texture != nullptr;
+}
+
+VkFormat Ktx2::select_transcode_format(const Device &device, bool srgb)
+{
+	for (auto &format : TRANSCODE_FORMATS)
+	{
+		auto vk_format = srgb ? format.srgb : format.unorm;
+
+		if (device.is_image_format_supported(vk_format))
+		{
+			return vk_format;
+		}
+	}
+
+	return srgb ? VK_FORMAT_R8G8B8A8_SRGB : VK_FORMAT_R8G8B8A8_UNORM;
+}
+
+void Ktx2::transcode(Device &device)
+{
+	if (!texture)
+	{
+		return;
+	}
+
+	bool srgb = ktxTexture2_GetOETF(texture) == KHR_DF_TRANSFER_SRGB;
+
+	auto format = select_transcode_format(device, srgb);
+
+	auto it = std::find_if(std::begin(TRANSCODE_FORMATS), std::end(TRANSCODE_FORMATS), [format](const TranscodeFormat &transcode_format) {
+		return transcode_format.unorm == format || transcode_format.srgb == format;
+	});
+
+	auto result = ktxTexture2_TranscodeBasis(texture, it->ktx_format, 0);
+	if (result != KTX_SUCCESS)
+	{
+		throw std::runtime_error{"Error transcoding KTX2 texture: " + get_name()};
+	}
+
+	LOGD("Transcoded {} to {}", get_name(), to_string(format));
+
+	load_texture(ktxTexture(texture), format);
+
+	ktxTexture_Destroy(ktxTexture(texture));
+	texture = nullptr;
+}
+}        // namespace sg
+}        // namespace vkb
@@ -0,0 +1,65 @@
+/* Copyright (c) 2020, Arm Limited and Contributors
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 the "License";
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include "common/error.h"
+#include "scene_graph/components/image/ktx.h"
+
+struct ktxTexture2;
+
+namespace vkb
+{
+class Device;
+
+namespace sg
+{
+/**
+ * @brief A KTX2 image, which may be supercompressed with Basis Universal
+ *        Basis Universal images are transcoded when their Vulkan image is created,
+ *        to the best block format the device supports.
+ */
+class Ktx2 : public Ktx
+{
+  public:
+	Ktx2(const std::string &name, const uint8_t *data, size_t size);
+
+	virtual ~Ktx2();
+
+	/**
+	 * @return Whether the image data is Basis Universal, waiting to be transcoded
+	 */
+	bool needs_transcoding() const;
+
+	/**
+	 * @brief Chooses the format to transcode Basis Universal images to
+	 *        ASTC 4x4 is preferred, then BC7, then ETC2, falling back to uncompressed RGBA8
+	 * @param device The device the images are sampled on
+	 * @param srgb Whether the image holds sRGB encoded colors
+	 * @return The format
+	 */
+	static VkFormat select_transcode_format(const Device &device, bool srgb);
+
+  protected:
+	virtual void transcode(Device &device) override;
+
+  private:
+	/// The texture waiting to be transcoded, nullptr once its data is taken
+	ktxTexture2 *texture{nullptr};
+};
+}        // namespace sg
+}        // namespace vkb
@@ -69,10 +69,26 @@ float PerspectiveCamera::get_aspect_ratio()
 	return aspect_ratio;
 }
 
+void PerspectiveCamera::set_jitter(const glm::vec2 &new_jitter)
+{
+	jitter = new_jitter;
+}
+
+const glm::vec2 &PerspectiveCamera::get_jitter() const
+{
+	return jitter;
+}
+
 glm::mat4 PerspectiveCamera::get_projection()
 {
 	// Note: Using Revsered depth-buffer for increased precision, so Znear and Zfar are flipped
-	return glm::perspective(fov, aspect_ratio, far_plane, near_plane);
+	glm::mat4 projection = glm::perspective(fov, aspect_ratio, far_plane, near_plane);
+
+	// Shifts the clip space position by the jitter once divided by w, which equals -z
+	projection[2][0] -= jitter.x;
+	projection[2][1] -= jitter.y;
+
+	return projection;
 }
 }        // namespace sg
 }        // namespace vkb
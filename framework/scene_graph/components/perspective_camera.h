@@ -58,6 +58,15 @@ class PerspectiveCamera : public Camera
 
 	float get_field_of_view();
 
+	/**
+	 * @brief Offsets the projection by a fraction of a pixel, so that consecutive frames sample different
+	 *        positions within the pixels for temporal reconstruction
+	 * @param jitter Offset in normalized device coordinates, before the Vulkan clip space is applied
+	 */
+	void set_jitter(const glm::vec2 &jitter);
+
+	const glm::vec2 &get_jitter() const;
+
 	virtual glm::mat4 get_projection() override;
 
   private:
@@ -74,6 +83,8 @@ class PerspectiveCamera : public Camera
 	float far_plane{100.0};
 
 	float near_plane{0.1f};
+
+	glm::vec2 jitter{0.0f};
 };
 }        // namespace sg
 }        // namespace vkb
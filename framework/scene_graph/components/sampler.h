@@ -32,7 +32,11 @@ namespace sg
 class Sampler : public Component
 {
   public:
-	Sampler(const std::string &name, core::Sampler &&vk_sampler);
+	/**
+	 * @param name Name of the component
+	 * @param vk_sampler Sampler shared through the resource cache, which outlives the component
+	 */
+	Sampler(const std::string &name, core::Sampler &vk_sampler);
 
 	Sampler(Sampler &&other) = default;
 
@@ -40,7 +44,7 @@ class Sampler : public Component
 
 	virtual std::type_index get_type() override;
 
-	core::Sampler vk_sampler;
+	core::Sampler &vk_sampler;
 };
 }        // namespace sg
 }        // namespace vkb
@@ -50,6 +50,94 @@ bool SubMesh::get_attribute(const std::string &attribute_name, VertexAttribute &
 	return true;
 }
 
+const std::unordered_map<std::string, VertexAttribute> &SubMesh::get_attributes() const
+{
+	return vertex_attributes;
+}
+
+GeometryBufferRange SubMesh::get_vertex_buffer(const std::string &name) const
+{
+	auto buffer_it = vertex_buffers.find(name);
+
+	if (buffer_it != vertex_buffers.end())
+	{
+		return {&buffer_it->second, 0, buffer_it->second.get_size()};
+	}
+
+	auto allocation_it = vertex_allocations.find(name);
+
+	if (allocation_it != vertex_allocations.end())
+	{
+		return {&allocation_it->second.get_buffer(), allocation_it->second.get_offset(), allocation_it->second.get_size()};
+	}
+
+	return {};
+}
+
+GeometryBufferRange SubMesh::get_interleaved_vertex_buffer() const
+{
+	if (interleaved_vertex_buffer)
+	{
+		return {interleaved_vertex_buffer.get(), 0, interleaved_vertex_buffer->get_size()};
+	}
+
+	if (!interleaved_vertex_allocation.empty())
+	{
+		return {&interleaved_vertex_allocation.get_buffer(), interleaved_vertex_allocation.get_offset(), interleaved_vertex_allocation.get_size()};
+	}
+
+	return {};
+}
+
+GeometryBufferRange SubMesh::get_index_buffer() const
+{
+	if (index_buffer)
+	{
+		return {index_buffer.get(), 0, index_buffer->get_size()};
+	}
+
+	if (!index_allocation.empty())
+	{
+		return {&index_allocation.get_buffer(), index_allocation.get_offset(), index_allocation.get_size()};
+	}
+
+	return {};
+}
+
+bool SubMesh::has_interleaved_vertices() const
+{
+	return interleaved_vertex_buffer || !interleaved_vertex_allocation.empty();
+}
+
+void SubMesh::move_to_geometry_buffers(GeometryAllocator &allocator, VkBufferUsageFlags usage)
+{
+	auto upload = [&allocator, usage](core::Buffer &buffer) {
+		auto allocation = allocator.upload(buffer.map(), buffer.get_size(), usage);
+		buffer.unmap();
+
+		return allocation;
+	};
+
+	for (auto &vertex_buffer : vertex_buffers)
+	{
+		vertex_allocations[vertex_buffer.first] = upload(vertex_buffer.second);
+	}
+
+	vertex_buffers.clear();
+
+	if (interleaved_vertex_buffer)
+	{
+		interleaved_vertex_allocation = upload(*interleaved_vertex_buffer);
+		interleaved_vertex_buffer.reset();
+	}
+
+	if (index_buffer)
+	{
+		index_allocation = upload(*index_buffer);
+		index_buffer.reset();
+	}
+}
+
 void SubMesh::set_material(const Material &new_material)
 {
 	material = &new_material;
@@ -88,6 +176,24 @@ void SubMesh::compute_shader_variant()
 		std::transform(attrib_name.begin(), attrib_name.end(), attrib_name.begin(), ::toupper);
 		shader_variant.add_define("HAS_" + attrib_name);
 	}
+
+	// Compressed attributes are decoded by the vertex shader
+	VertexAttribute attribute;
+
+	if (get_attribute("position", attribute) && attribute.format == VK_FORMAT_R16G16B16A16_UNORM)
+	{
+		shader_variant.add_define("QUANTIZED_POSITION");
+	}
+
+	if (get_attribute("normal", attribute) && attribute.format == VK_FORMAT_R16G16_SNORM)
+	{
+		shader_variant.add_define("OCTAHEDRAL_NORMAL");
+	}
+
+	if (get_attribute("tangent", attribute) && attribute.format == VK_FORMAT_R16G16B16A16_SNORM)
+	{
+		shader_variant.add_define("OCTAHEDRAL_TANGENT");
+	}
 }
 
 ShaderVariant &SubMesh::get_mut_shader_variant()
@@ -25,7 +25,9 @@
 
 #include "common/vk_common.h"
 #include "core/buffer.h"
+#include "core/geometry_allocator.h"
 #include "core/shader_module.h"
+#include "geometry/triangle_bvh.h"
 #include "scene_graph/component.h"
 
 namespace vkb
@@ -43,6 +45,30 @@ struct VertexAttribute
 	std::uint32_t offset = 0;
 };
 
+/**
+ * @brief A coarser level of detail of a sub mesh, drawing its vertices with fewer triangles
+ */
+struct LevelOfDetail
+{
+	/// First index of the level in the index buffer, after the indices of the full sub mesh
+	std::uint32_t first_index = 0;
+
+	std::uint32_t index_count = 0;
+
+	/// Largest distance a vertex was moved by the simplification, in the local space of the sub mesh
+	float error = 0.0f;
+};
+
+/// The buffer and the bytes of it holding some geometry of a sub mesh, the buffer is null if the sub mesh has no such geometry
+struct GeometryBufferRange
+{
+	const core::Buffer *buffer = nullptr;
+
+	VkDeviceSize offset = 0;
+
+	VkDeviceSize size = 0;
+};
+
 class SubMesh : public Component
 {
   public:
@@ -60,12 +86,79 @@ class SubMesh : public Component
 
 	std::unordered_map<std::string, core::Buffer> vertex_buffers;
 
+	/// Holds every vertex attribute when the vertices are interleaved, in which case vertex_buffers is empty
+	std::unique_ptr<core::Buffer> interleaved_vertex_buffer;
+
+	/// Size of an interleaved vertex, attributes are at their offset within it
+	std::uint32_t vertex_stride = 0;
+
 	std::unique_ptr<core::Buffer> index_buffer;
 
+	/// Ranges of the shared geometry buffers holding the vertex attributes, once moved there from vertex_buffers
+	std::unordered_map<std::string, GeometryAllocation> vertex_allocations;
+
+	/// Range of the shared geometry buffers holding the interleaved vertices, once moved there from interleaved_vertex_buffer
+	GeometryAllocation interleaved_vertex_allocation;
+
+	/// Range of the shared geometry buffers holding the indices, once moved there from index_buffer
+	GeometryAllocation index_allocation;
+
+	/// Levels of detail from finest to coarsest, their indices are stored in the index buffer
+	std::vector<LevelOfDetail> lods;
+
+	/// Offset and scale of the positions stored as VK_FORMAT_R16G16B16A16_UNORM relative to the bounds of the sub mesh,
+	/// read by shaders with QUANTIZED_POSITION defined. Null when positions are not quantized.
+	std::unique_ptr<core::Buffer> position_dequantization;
+
+	/// Meshlets of the sub mesh as sg::Meshlet, null unless the loader built them
+	std::unique_ptr<core::Buffer> meshlet_buffer;
+
+	/// Vertex indices of the meshlets into the vertex buffers
+	std::unique_ptr<core::Buffer> meshlet_vertex_buffer;
+
+	/// Local vertex indices of the meshlet triangles, one byte each
+	std::unique_ptr<core::Buffer> meshlet_triangle_buffer;
+
+	std::uint32_t meshlet_count = 0;
+
+	/// CPU copy of the triangles in local space for Scene::ray_cast, null unless the loader kept it
+	std::unique_ptr<TriangleBVH> triangle_bvh;
+
 	void set_attribute(const std::string &name, const VertexAttribute &attribute);
 
 	bool get_attribute(const std::string &name, VertexAttribute &attribute) const;
 
+	const std::unordered_map<std::string, VertexAttribute> &get_attributes() const;
+
+	/**
+	 * @brief Finds the vertex data of an attribute, in its own vertex buffer or in a shared geometry buffer
+	 */
+	GeometryBufferRange get_vertex_buffer(const std::string &name) const;
+
+	/**
+	 * @brief Finds the interleaved vertex data, in its own vertex buffer or in a shared geometry buffer
+	 */
+	GeometryBufferRange get_interleaved_vertex_buffer() const;
+
+	/**
+	 * @brief Finds the index data, in its own index buffer or in a shared geometry buffer
+	 *        The indices of the sub mesh start index_offset bytes after the offset of the range
+	 */
+	GeometryBufferRange get_index_buffer() const;
+
+	/**
+	 * @return True if every vertex attribute is fetched from a single interleaved vertex buffer
+	 */
+	bool has_interleaved_vertices() const;
+
+	/**
+	 * @brief Copies the vertex and index buffers of the sub mesh to ranges of shared device local buffers, and releases them
+	 *        The copies are submitted by the next flush of the staging manager of the device
+	 * @param allocator The allocator of the shared geometry buffers
+	 * @param usage Usage of the shared buffers, with at least the vertex and index buffer usages
+	 */
+	void move_to_geometry_buffers(GeometryAllocator &allocator, VkBufferUsageFlags usage);
+
 	void set_material(const Material &material);
 
 	const Material *get_material() const;
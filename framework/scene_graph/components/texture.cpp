@@ -53,5 +53,15 @@ Sampler *Texture::get_sampler()
 	assert(sampler && "Texture has no sampler");
 	return sampler;
 }
+
+void Texture::set_array_layer(uint32_t layer)
+{
+	array_layer = layer;
+}
+
+uint32_t Texture::get_array_layer() const
+{
+	return array_layer;
+}
 }        // namespace sg
 }        // namespace vkb
@@ -51,9 +51,18 @@ class Texture : public Component
 
 	Sampler *get_sampler();
 
+	/**
+	 * @brief Selects the layer of the image sampled by the texture, for images packed into texture arrays
+	 */
+	void set_array_layer(uint32_t layer);
+
+	uint32_t get_array_layer() const;
+
   private:
 	Image *image{nullptr};
 
+	uint32_t array_layer{0};
+
 	Sampler *sampler{nullptr};
 };
 }        // namespace sg
@@ -23,6 +23,7 @@ VKBP_DISABLE_WARNINGS()
 VKBP_ENABLE_WARNINGS()
 
 #include "scene_graph/node.h"
+#include "scene_graph/transform_hierarchy.h"
 
 namespace vkb
 {
@@ -106,10 +107,31 @@ glm::mat4 Transform::get_world_matrix()
 void Transform::invalidate_world_matrix()
 {
 	update_world_matrix = true;
+
+	if (hierarchy)
+	{
+		hierarchy->invalidate(hierarchy_index);
+	}
+}
+
+TransformHierarchy *Transform::get_hierarchy() const
+{
+	return hierarchy;
+}
+
+uint32_t Transform::get_hierarchy_index() const
+{
+	return hierarchy_index;
 }
 
 void Transform::update_world_transform()
 {
+	// The simulation may be moving the node, the hierarchy publishes its world matrix between frames
+	if (hierarchy && hierarchy->is_deferred_publish())
+	{
+		return;
+	}
+
 	if (!update_world_matrix)
 	{
 		return;
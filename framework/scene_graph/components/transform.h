@@ -36,6 +36,7 @@ namespace vkb
 namespace sg
 {
 class Node;
+class TransformHierarchy;
 
 class Transform : public Component
 {
@@ -73,7 +74,19 @@ class Transform : public Component
 	 */
 	void invalidate_world_matrix();
 
+	/**
+	 * @return The hierarchy updating the world matrix, or nullptr if it is computed on request
+	 */
+	TransformHierarchy *get_hierarchy() const;
+
+	/**
+	 * @return Index of the transform in its hierarchy, if it has one
+	 */
+	uint32_t get_hierarchy_index() const;
+
   private:
+	friend class TransformHierarchy;
+
 	Node &node;
 
 	glm::vec3 translation = glm::vec3(0.0, 0.0, 0.0);
@@ -86,6 +99,11 @@ class Transform : public Component
 
 	bool update_world_matrix = false;
 
+	TransformHierarchy *hierarchy{nullptr};
+
+	/// Index of the transform in its hierarchy
+	uint32_t hierarchy_index{0};
+
 	void update_world_transform();
 };
 
@@ -0,0 +1,189 @@
+/* Copyright (c) 2020, Arm Limited and Contributors
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 the "License";
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "meshlet_builder.h"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+#include "common/helpers.h"
+
+namespace vkb
+{
+namespace sg
+{
+namespace
+{
+/**
+ * @brief Computes the bounding sphere and the normal cone of a finished meshlet
+ */
+void compute_meshlet_bounds(Meshlet &meshlet, const std::vector<uint32_t> &meshlet_vertices, const std::vector<uint8_t> &meshlet_triangles, const std::vector<glm::vec3> &positions)
+{
+	glm::vec3 min{std::numeric_limits<float>::max()};
+	glm::vec3 max{std::numeric_limits<float>::lowest()};
+
+	for (uint32_t v = 0; v < meshlet.vertex_count; ++v)
+	{
+		const auto &position = positions[meshlet_vertices[meshlet.vertex_offset + v]];
+
+		min = glm::min(min, position);
+		max = glm::max(max, position);
+	}
+
+	meshlet.center = (min + max) * 0.5f;
+	meshlet.radius = 0.0f;
+
+	for (uint32_t v = 0; v < meshlet.vertex_count; ++v)
+	{
+		meshlet.radius = std::max(meshlet.radius, glm::distance(meshlet.center, positions[meshlet_vertices[meshlet.vertex_offset + v]]));
+	}
+
+	std::vector<glm::vec3> normals;
+	normals.reserve(meshlet.triangle_count);
+
+	glm::vec3 axis{0.0f};
+
+	for (uint32_t t = 0; t < meshlet.triangle_count; ++t)
+	{
+		const uint8_t *triangle = &meshlet_triangles[meshlet.triangle_offset + t * 3];
+
+		const auto &a = positions[meshlet_vertices[meshlet.vertex_offset + triangle[0]]];
+		const auto &b = positions[meshlet_vertices[meshlet.vertex_offset + triangle[1]]];
+		const auto &c = positions[meshlet_vertices[meshlet.vertex_offset + triangle[2]]];
+
+		glm::vec3 normal = glm::cross(b - a, c - a);
+		float     length = glm::length(normal);
+
+		// Degenerate triangles face nowhere
+		if (length > 0.0f)
+		{
+			normals.push_back(normal / length);
+			axis += normals.back();
+		}
+	}
+
+	float axis_length = glm::length(axis);
+
+	meshlet.cone_axis   = axis_length > 0.0f ? axis / axis_length : glm::vec3{0.0f, 0.0f, 1.0f};
+	meshlet.cone_cutoff = 1.0f;
+
+	if (axis_length == 0.0f)
+	{
+		return;
+	}
+
+	float min_dot = 1.0f;
+
+	for (auto &normal : normals)
+	{
+		min_dot = std::min(min_dot, glm::dot(meshlet.cone_axis, normal));
+	}
+
+	// Cones wider than a hemisphere cannot be culled from any direction
+	if (min_dot > 0.0f)
+	{
+		meshlet.cone_cutoff = std::sqrt(1.0f - min_dot * min_dot);
+	}
+}
+}        // namespace
+
+MeshletBuilder::MeshletBuilder(uint32_t max_vertices, uint32_t max_triangles) :
+    max_vertices{std::min(max_vertices, 255u)},
+    max_triangles{max_triangles}
+{
+}
+
+void MeshletBuilder::build(const std::vector<uint32_t> &indices, const std::vector<glm::vec3> &positions,
+                           std::vector<Meshlet> &meshlets, std::vector<uint32_t> &meshlet_vertices, std::vector<uint8_t> &meshlet_triangles) const
+{
+	meshlets.clear();
+	meshlet_vertices.clear();
+	meshlet_triangles.clear();
+
+	// Local index of every vertex in the current meshlet, 0xFF when it is not in it
+	std::vector<uint8_t> local_indices(positions.size(), 0xFF);
+
+	Meshlet meshlet{};
+
+	auto finish_meshlet = [&]() {
+		if (meshlet.triangle_count == 0)
+		{
+			return;
+		}
+
+		compute_meshlet_bounds(meshlet, meshlet_vertices, meshlet_triangles, positions);
+
+		for (uint32_t v = 0; v < meshlet.vertex_count; ++v)
+		{
+			local_indices[meshlet_vertices[meshlet.vertex_offset + v]] = 0xFF;
+		}
+
+		meshlet_triangles.resize((meshlet_triangles.size() + 3) & ~size_t{3}, 0);
+
+		meshlets.push_back(meshlet);
+
+		meshlet                 = {};
+		meshlet.vertex_offset   = to_u32(meshlet_vertices.size());
+		meshlet.triangle_offset = to_u32(meshlet_triangles.size());
+	};
+
+	for (size_t i = 0; i + 2 < indices.size(); i += 3)
+	{
+		const uint32_t *triangle = &indices[i];
+
+		if (triangle[0] >= positions.size() || triangle[1] >= positions.size() || triangle[2] >= positions.size())
+		{
+			continue;
+		}
+
+		uint32_t new_vertices = 0;
+
+		for (uint32_t k = 0; k < 3; ++k)
+		{
+			// Repeated vertices of a degenerate triangle are only added once
+			bool repeated = (k > 0 && triangle[k] == triangle[0]) || (k > 1 && triangle[k] == triangle[1]);
+
+			if (local_indices[triangle[k]] == 0xFF && !repeated)
+			{
+				++new_vertices;
+			}
+		}
+
+		if (meshlet.vertex_count + new_vertices > max_vertices || meshlet.triangle_count + 1 > max_triangles)
+		{
+			finish_meshlet();
+		}
+
+		for (uint32_t k = 0; k < 3; ++k)
+		{
+			if (local_indices[triangle[k]] == 0xFF)
+			{
+				local_indices[triangle[k]] = static_cast<uint8_t>(meshlet.vertex_count++);
+				meshlet_vertices.push_back(triangle[k]);
+			}
+
+			meshlet_triangles.push_back(local_indices[triangle[k]]);
+		}
+
+		++meshlet.triangle_count;
+	}
+
+	finish_meshlet();
+}
+}        // namespace sg
+}        // namespace vkb
@@ -0,0 +1,93 @@
+/* Copyright (c) 2020, Arm Limited and Contributors
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 the "License";
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+#include "common/error.h"
+
+VKBP_DISABLE_WARNINGS()
+#include "common/glm_common.h"
+VKBP_ENABLE_WARNINGS()
+
+namespace vkb
+{
+namespace sg
+{
+/**
+ * @brief A small cluster of triangles with its own vertices, culled as a whole by the task shader
+ *
+ * The layout matches the Meshlet struct read as std430 by the meshlet shaders.
+ */
+struct alignas(16) Meshlet
+{
+	/// Center of the bounding sphere in the local space of the sub mesh
+	glm::vec3 center;
+
+	float radius;
+
+	/// Average normal of the triangles
+	glm::vec3 cone_axis;
+
+	/// Sine of the half angle of the cone holding every triangle normal, 1 if the meshlet cannot be backface culled
+	float cone_cutoff;
+
+	/// First vertex of the meshlet in the meshlet vertices
+	uint32_t vertex_offset;
+
+	/// First byte of the meshlet in the meshlet triangles, a multiple of 4
+	uint32_t triangle_offset;
+
+	uint32_t vertex_count;
+
+	uint32_t triangle_count;
+};
+
+/**
+ * @brief Splits indexed triangle lists into meshlets of bounded vertex and triangle counts
+ *
+ * Triangles are added in index order, so meshlets are as coherent as the index buffer is.
+ */
+class MeshletBuilder
+{
+  public:
+	/**
+	 * @param max_vertices Maximum number of vertices of a meshlet, at most 255
+	 * @param max_triangles Maximum number of triangles of a meshlet
+	 */
+	MeshletBuilder(uint32_t max_vertices = 64, uint32_t max_triangles = 124);
+
+	/**
+	 * @brief Builds the meshlets of a triangle list
+	 * @param indices Vertex indices of the triangles
+	 * @param positions Positions of the vertices
+	 * @param meshlets Receives the meshlets
+	 * @param meshlet_vertices Receives the vertex indices of every meshlet
+	 * @param meshlet_triangles Receives three local vertex indices per triangle, each meshlet padded to 4 bytes
+	 */
+	void build(const std::vector<uint32_t> &indices, const std::vector<glm::vec3> &positions,
+	           std::vector<Meshlet> &meshlets, std::vector<uint32_t> &meshlet_vertices, std::vector<uint8_t> &meshlet_triangles) const;
+
+  private:
+	uint32_t max_vertices;
+
+	uint32_t max_triangles;
+};
+}        // namespace sg
+}        // namespace vkb
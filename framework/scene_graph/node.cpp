@@ -17,8 +17,12 @@
 
 #include "node.h"
 
+#include <algorithm>
+#include <stdexcept>
+
 #include "component.h"
 #include "components/transform.h"
+#include "transform_hierarchy.h"
 
 namespace vkb
 {
@@ -46,6 +50,11 @@ void Node::set_parent(Node &p)
 {
 	parent = &p;
 
+	if (auto hierarchy = transform.get_hierarchy())
+	{
+		hierarchy->invalidate_structure();
+	}
+
 	transform.invalidate_world_matrix();
 }
 
@@ -57,6 +66,11 @@ Node *Node::get_parent() const
 void Node::add_child(Node &child)
 {
 	children.push_back(&child);
+
+	if (auto hierarchy = transform.get_hierarchy())
+	{
+		hierarchy->invalidate_structure();
+	}
 }
 
 const std::vector<Node *> &Node::get_children() const
@@ -66,7 +80,8 @@ const std::vector<Node *> &Node::get_children() const
 
 void Node::set_component(Component &component)
 {
-	auto it = components.find(component.get_type());
+	auto type = component.get_type();
+	auto it   = std::find_if(components.begin(), components.end(), [&type](const std::pair<std::type_index, Component *> &c) { return c.first == type; });
 
 	if (it != components.end())
 	{
@@ -74,18 +89,27 @@ void Node::set_component(Component &component)
 	}
 	else
 	{
-		components.insert(std::make_pair(component.get_type(), &component));
+		components.emplace_back(type, &component);
 	}
 }
 
 Component &Node::get_component(const std::type_index index)
 {
-	return *components.at(index);
+	for (auto &c : components)
+	{
+		if (c.first == index)
+		{
+			return *c.second;
+		}
+	}
+
+	throw std::out_of_range("Node has no component of type " + std::string(index.name()));
 }
 
 bool Node::has_component(const std::type_index index)
 {
-	return components.count(index) > 0;
+	return std::any_of(components.begin(), components.end(),
+	                   [&index](const std::pair<std::type_index, Component *> &c) { return c.first == index; });
 }
 
 }        // namespace sg
@@ -21,6 +21,7 @@
 #include <string>
 #include <typeindex>
 #include <unordered_map>
+#include <utility>
 #include <vector>
 
 #include "scene_graph/components/transform.h"
@@ -85,7 +86,8 @@ class Node
 
 	std::vector<Node *> children;
 
-	std::unordered_map<std::type_index, Component *> components;
+	/// A node has few components, which are faster to find in a flat array than a hash map
+	std::vector<std::pair<std::type_index, Component *>> components;
 };
 }        // namespace sg
 }        // namespace vkb
@@ -17,19 +17,102 @@
 
 #include "scene.h"
 
+#include <future>
 #include <queue>
 
 #include "common/error.h"
 #include "component.h"
+#include "components/light.h"
+#include "components/mesh.h"
 #include "components/sub_mesh.h"
+#include "geometry/frustum.h"
+#include "job_system.h"
 #include "node.h"
 
 namespace vkb
 {
 namespace sg
 {
+namespace
+{
+BVH::Bounds get_world_bounds(const AABB &bounds, const glm::mat4 &world_matrix)
+{
+	// The extent of the transformed box along every axis is the sum of the absolute contributions of the local axes
+	glm::vec3 center = glm::vec3(world_matrix * glm::vec4(bounds.get_center(), 1.0f));
+	glm::vec3 extent = (bounds.get_max() - bounds.get_min()) * 0.5f;
+
+	glm::mat3 basis{world_matrix};
+	glm::vec3 world_extent = glm::abs(basis[0]) * extent.x + glm::abs(basis[1]) * extent.y + glm::abs(basis[2]) * extent.z;
+
+	return {center - world_extent, center + world_extent};
+}
+
+/**
+ * @return Whether the world matrix of a transform may have changed in the last update of a hierarchy
+ */
+bool is_transform_updated(const std::vector<uint8_t> &updated_flags, Transform &transform)
+{
+	// Nodes outside of the hierarchy compute their world matrix on request, so they are always considered updated
+	auto index = transform.get_hierarchy_index();
+	return !transform.get_hierarchy() || index >= updated_flags.size() || updated_flags[index];
+}
+
+/// Fewer lights than this have their bounds computed on the calling thread
+constexpr size_t PARALLEL_LIGHT_COUNT = 1024;
+
+/**
+ * @return Whether a light only reaches a bounded volume, which directional lights and lights without a range do not
+ */
+bool is_light_bounded(Light &light)
+{
+	return light.get_light_type() != LightType::Directional && light.get_properties().range > 0.0f && light.get_node() != nullptr;
+}
+
+/**
+ * @brief Bounds the volume a bounded light reaches, a sphere for point lights and the sphere around the cone of spot lights
+ */
+BVH::Bounds get_light_bounds(Light &light)
+{
+	const auto &properties = light.get_properties();
+
+	// The position and direction the shaders receive, see Subpass::allocate_lights
+	auto &    transform = light.get_node()->get_transform();
+	glm::vec3 position  = transform.get_translation();
+
+	glm::vec3 center = position;
+	float     radius = properties.range;
+
+	float angle = properties.outer_cone_angle;
+
+	if (light.get_light_type() == LightType::Spot && angle > 0.0f && angle < glm::half_pi<float>())
+	{
+		glm::vec3 direction = glm::normalize(transform.get_rotation() * properties.direction);
+
+		if (angle < glm::quarter_pi<float>())
+		{
+			// The sphere through the apex and the rim of a narrow cone
+			radius = properties.range / (2.0f * std::cos(angle));
+			center = position + direction * radius;
+		}
+		else
+		{
+			// The sphere around the rim of a wide cone, which holds the apex
+			radius = properties.range * std::sin(angle);
+			center = position + direction * (properties.range * std::cos(angle));
+		}
+	}
+
+	return {center - glm::vec3(radius), center + glm::vec3(radius)};
+}
+}        // namespace
+
+Scene::Scene() :
+    transform_hierarchy{std::make_unique<TransformHierarchy>()}
+{}
+
 Scene::Scene(const std::string &name) :
-    name{name}
+    name{name},
+    transform_hierarchy{std::make_unique<TransformHierarchy>()}
 {}
 
 void Scene::set_name(const std::string &new_name)
@@ -56,11 +139,19 @@ void Scene::add_node(std::unique_ptr<Node> &&n)
 void Scene::add_child(Node &child)
 {
 	root->add_child(child);
+
+	transform_hierarchy->invalidate_structure();
+
+	bvh_dirty       = true;
+	light_bvh_dirty = true;
 }
 
 std::unique_ptr<Component> Scene::get_model(uint32_t index)
 {
-	auto meshes = std::move(components.at(typeid(SubMesh)));
+	auto &storage = components.at(typeid(SubMesh));
+	auto  meshes  = std::move(storage.owned);
+	storage.owned.clear();
+	storage.pointers.clear();
 
 	return std::move(meshes.at(index));
 }
@@ -69,34 +160,56 @@ void Scene::add_component(std::unique_ptr<Component> &&component, Node &node)
 {
 	node.set_component(*component);
 
-	if (component)
-	{
-		components[component->get_type()].push_back(std::move(component));
-	}
+	add_component(std::move(component));
 }
 
 void Scene::add_component(std::unique_ptr<Component> &&component)
 {
 	if (component)
 	{
-		components[component->get_type()].push_back(std::move(component));
+		if (component->get_type() == typeid(Mesh))
+		{
+			bvh_dirty = true;
+		}
+		else if (component->get_type() == typeid(Light))
+		{
+			light_bvh_dirty = true;
+		}
+
+		auto &storage = components[component->get_type()];
+		storage.pointers.push_back(component.get());
+		storage.owned.push_back(std::move(component));
 	}
 }
 
 void Scene::set_components(const std::type_index &type_info, std::vector<std::unique_ptr<Component>> &&new_components)
 {
-	components[type_info] = std::move(new_components);
+	if (type_info == typeid(Mesh))
+	{
+		bvh_dirty = true;
+	}
+	else if (type_info == typeid(Light))
+	{
+		light_bvh_dirty = true;
+	}
+
+	auto &storage = components[type_info];
+	storage.owned = std::move(new_components);
+
+	storage.pointers.resize(storage.owned.size());
+	std::transform(storage.owned.begin(), storage.owned.end(), storage.pointers.begin(),
+	               [](const std::unique_ptr<Component> &component) { return component.get(); });
 }
 
 const std::vector<std::unique_ptr<Component>> &Scene::get_components(const std::type_index &type_info) const
 {
-	return components.at(type_info);
+	return components.at(type_info).owned;
 }
 
 bool Scene::has_component(const std::type_index &type_info) const
 {
 	auto component = components.find(type_info);
-	return (component != components.end() && !component->second.empty());
+	return (component != components.end() && !component->second.owned.empty());
 }
 
 Node *Scene::find_node(const std::string &node_name)
@@ -129,11 +242,358 @@ Node *Scene::find_node(const std::string &node_name)
 void Scene::set_root_node(Node &node)
 {
 	root = &node;
+
+	transform_hierarchy->set_root_node(node);
+
+	bvh_dirty       = true;
+	light_bvh_dirty = true;
 }
 
 Node &Scene::get_root_node()
 {
 	return *root;
 }
+
+void Scene::update_transforms()
+{
+	transform_hierarchy->update();
+
+	// The BVHs are refitted from the transforms of the nodes, once they are published
+	if (!transform_hierarchy->is_deferred_publish())
+	{
+		if (bvh_enabled)
+		{
+			update_bvh();
+		}
+
+		if (light_bvh_enabled)
+		{
+			update_light_bvh();
+		}
+	}
+}
+
+void Scene::set_deferred_transforms(bool enable)
+{
+	if (!enable && transform_hierarchy->is_deferred_publish())
+	{
+		publish_transforms();
+	}
+
+	transform_hierarchy->set_deferred_publish(enable);
+}
+
+void Scene::publish_transforms()
+{
+	transform_hierarchy->publish();
+
+	if (bvh_enabled)
+	{
+		update_bvh();
+	}
+
+	if (light_bvh_enabled)
+	{
+		update_light_bvh();
+	}
+}
+
+TransformHierarchy &Scene::get_transform_hierarchy()
+{
+	return *transform_hierarchy;
+}
+
+AnimationSystem &Scene::get_animation_system()
+{
+	return animation_system;
+}
+
+const BVH &Scene::get_bvh()
+{
+	if (!bvh_enabled || bvh_dirty)
+	{
+		bvh_enabled = true;
+		update_bvh();
+	}
+
+	return bvh;
+}
+
+const std::vector<Scene::MeshInstance> &Scene::get_mesh_instances()
+{
+	get_bvh();
+
+	return mesh_instances;
+}
+
+void Scene::query_visible(const Frustum &frustum, std::vector<uint32_t> &instances)
+{
+	get_bvh().query_frustum(frustum, instances);
+}
+
+void Scene::query_visible_lights(const Frustum &frustum, std::vector<Light *> &lights)
+{
+	if (!light_bvh_enabled || light_bvh_dirty)
+	{
+		light_bvh_enabled = true;
+		update_light_bvh();
+	}
+
+	visible_light_indices.clear();
+	light_bvh.query_frustum(frustum, visible_light_indices);
+
+	for (auto &index : visible_light_indices)
+	{
+		index = bounded_light_indices[index];
+	}
+
+	visible_light_indices.insert(visible_light_indices.end(), unbounded_light_indices.begin(), unbounded_light_indices.end());
+
+	// Keeps the order of the scene, so that the lights keep their indices in the shaders from a frame to the next
+	std::sort(visible_light_indices.begin(), visible_light_indices.end());
+
+	auto scene_lights = get_components<Light>();
+
+	for (auto index : visible_light_indices)
+	{
+		lights.push_back(scene_lights[index]);
+	}
+}
+
+Node *Scene::pick(const glm::vec3 &origin, const glm::vec3 &direction)
+{
+	RayHit hit;
+
+	if (!ray_cast(origin, direction, hit))
+	{
+		return nullptr;
+	}
+
+	return hit.node;
+}
+
+bool Scene::ray_cast(const glm::vec3 &origin, const glm::vec3 &direction, RayHit &hit, float max_distance)
+{
+	auto &scene_bvh = get_bvh();
+
+	RayHit nearest_hit;
+
+	auto intersect_instance = [&](uint32_t instance_index, float nearest) {
+		auto &instance = mesh_instances[instance_index];
+
+		// The parameter along the ray is kept by affine transforms, so local distances are world distances
+		glm::mat4 inverse_world_matrix = glm::inverse(instance.node->get_transform().get_world_matrix());
+		glm::vec3 local_origin         = glm::vec3(inverse_world_matrix * glm::vec4(origin, 1.0f));
+		glm::vec3 local_direction      = glm::vec3(inverse_world_matrix * glm::vec4(direction, 0.0f));
+
+		bool instance_hit = false;
+
+		auto record_hit = [&](SubMesh *submesh, uint32_t triangle, float distance) {
+			nearest              = distance;
+			nearest_hit.node     = instance.node;
+			nearest_hit.mesh     = instance.mesh;
+			nearest_hit.submesh  = submesh;
+			nearest_hit.triangle = triangle;
+			nearest_hit.distance = distance;
+			instance_hit         = true;
+		};
+
+		bool test_bounds = false;
+
+		for (auto submesh : instance.mesh->get_submeshes())
+		{
+			float    distance;
+			uint32_t triangle;
+
+			if (!submesh->triangle_bvh)
+			{
+				test_bounds = true;
+			}
+			else if (submesh->triangle_bvh->intersect(local_origin, local_direction, distance, triangle, nearest))
+			{
+				record_hit(submesh, triangle, distance);
+			}
+		}
+
+		if (test_bounds)
+		{
+			auto &bounds = instance.mesh->get_bounds();
+
+			BVH::Bounds local_bounds;
+			local_bounds.min = bounds.get_min();
+			local_bounds.max = bounds.get_max();
+
+			float distance = local_bounds.intersect_ray(local_origin, 1.0f / local_direction, nearest);
+
+			if (distance < nearest)
+			{
+				record_hit(nullptr, 0, distance);
+			}
+		}
+
+		return instance_hit ? nearest : std::numeric_limits<float>::infinity();
+	};
+
+	uint32_t instance;
+	float    distance;
+
+	if (!scene_bvh.query_ray(origin, direction, intersect_instance, instance, distance, max_distance))
+	{
+		return false;
+	}
+
+	hit          = nearest_hit;
+	hit.position = origin + direction * distance;
+
+	return true;
+}
+
+void Scene::invalidate_bvh()
+{
+	bvh_dirty       = true;
+	light_bvh_dirty = true;
+}
+
+void Scene::update_bvh()
+{
+	if (bvh_dirty || transform_hierarchy->was_rebuilt())
+	{
+		mesh_instances.clear();
+
+		for (auto mesh : get_components<Mesh>())
+		{
+			for (auto node : mesh->get_nodes())
+			{
+				mesh_instances.push_back({node, mesh});
+			}
+		}
+
+		instance_bounds.resize(mesh_instances.size());
+
+		for (size_t i = 0; i < mesh_instances.size(); ++i)
+		{
+			auto &instance     = mesh_instances[i];
+			instance_bounds[i] = get_world_bounds(instance.mesh->get_bounds(), instance.node->get_transform().get_world_matrix());
+		}
+
+		bvh.build(instance_bounds);
+
+		bvh_dirty = false;
+		return;
+	}
+
+	const auto &updated_flags = transform_hierarchy->get_updated_flags();
+
+	std::vector<uint32_t> changed_instances;
+
+	for (uint32_t i = 0; i < mesh_instances.size(); ++i)
+	{
+		auto &instance  = mesh_instances[i];
+		auto &transform = instance.node->get_transform();
+
+		if (is_transform_updated(updated_flags, transform))
+		{
+			instance_bounds[i] = get_world_bounds(instance.mesh->get_bounds(), transform.get_world_matrix());
+			changed_instances.push_back(i);
+		}
+	}
+
+	if (!changed_instances.empty())
+	{
+		bvh.refit(instance_bounds, changed_instances);
+	}
+}
+
+void Scene::update_light_bvh()
+{
+	auto scene_lights = get_components<Light>();
+
+	if (light_bvh_dirty || transform_hierarchy->was_rebuilt())
+	{
+		bounded_lights.clear();
+		bounded_light_indices.clear();
+		unbounded_light_indices.clear();
+
+		for (uint32_t i = 0; i < scene_lights.size(); ++i)
+		{
+			auto light = scene_lights[i];
+
+			if (is_light_bounded(*light))
+			{
+				bounded_lights.push_back(light);
+				bounded_light_indices.push_back(i);
+			}
+			else
+			{
+				unbounded_light_indices.push_back(i);
+			}
+		}
+
+		light_bounds.resize(bounded_lights.size());
+
+		auto compute_bounds = [this](size_t first_light, size_t last_light) {
+			for (size_t i = first_light; i < last_light; ++i)
+			{
+				light_bounds[i] = get_light_bounds(*bounded_lights[i]);
+			}
+		};
+
+		if (bounded_lights.size() < PARALLEL_LIGHT_COUNT)
+		{
+			compute_bounds(0, bounded_lights.size());
+		}
+		else
+		{
+			auto &job_system = JobSystem::get();
+
+			std::vector<std::future<void>> chunk_futures;
+
+			// The calling thread computes the first chunk
+			size_t chunk_count = job_system.get_thread_count() + 1;
+			size_t chunk_size  = (bounded_lights.size() + chunk_count - 1) / chunk_count;
+
+			for (size_t first_light = chunk_size; first_light < bounded_lights.size(); first_light += chunk_size)
+			{
+				size_t last_light = std::min(first_light + chunk_size, bounded_lights.size());
+
+				chunk_futures.push_back(job_system.push([&compute_bounds, first_light, last_light](size_t) {
+					compute_bounds(first_light, last_light);
+				},
+				                                        JobPriority::High));
+			}
+
+			compute_bounds(0, std::min(chunk_size, bounded_lights.size()));
+
+			for (auto &future : chunk_futures)
+			{
+				job_system.wait(future);
+				future.get();
+			}
+		}
+
+		light_bvh.build(light_bounds);
+
+		light_bvh_dirty = false;
+		return;
+	}
+
+	const auto &updated_flags = transform_hierarchy->get_updated_flags();
+
+	std::vector<uint32_t> changed_lights;
+
+	for (uint32_t i = 0; i < bounded_lights.size(); ++i)
+	{
+		if (is_transform_updated(updated_flags, bounded_lights[i]->get_node()->get_transform()))
+		{
+			light_bounds[i] = get_light_bounds(*bounded_lights[i]);
+			changed_lights.push_back(i);
+		}
+	}
+
+	if (!changed_lights.empty())
+	{
+		light_bvh.refit(light_bounds, changed_lights);
+	}
+}
 }        // namespace sg
 }        // namespace vkb
\ No newline at end of file
@@ -24,15 +24,22 @@
 #include <unordered_map>
 #include <vector>
 
+#include "geometry/bvh.h"
+#include "scene_graph/animation_system.h"
+#include "scene_graph/component_span.h"
 #include "scene_graph/components/light.h"
 #include "scene_graph/components/texture.h"
+#include "scene_graph/transform_hierarchy.h"
 
 namespace vkb
 {
+class Frustum;
+
 namespace sg
 {
 class Node;
 class Component;
+class Mesh;
 class SubMesh;
 
 /// @brief A collection of nodes organized in a tree structure.
@@ -40,7 +47,39 @@ class SubMesh;
 class Scene
 {
   public:
-	Scene() = default;
+	/**
+	 * @brief A mesh drawn at a node, the primitives of the scene BVH
+	 */
+	struct MeshInstance
+	{
+		Node *node;
+
+		Mesh *mesh;
+	};
+
+	/**
+	 * @brief The nearest surface hit by a ray cast into the scene
+	 */
+	struct RayHit
+	{
+		Node *node{nullptr};
+
+		Mesh *mesh{nullptr};
+
+		/// The hit sub mesh, or null if the ray hit the bounds of a mesh without triangle BVHs
+		SubMesh *submesh{nullptr};
+
+		/// Index of the hit triangle in the triangle BVH of the sub mesh
+		uint32_t triangle{0};
+
+		/// Distance to the hit along the direction of the ray, in units of its length
+		float distance{0.0f};
+
+		/// Position of the hit in world space
+		glm::vec3 position{0.0f};
+	};
+
+	Scene();
 
 	Scene(const std::string &name);
 
@@ -91,24 +130,19 @@ class Scene
 	}
 
 	/**
-	 * @return List of pointers to components casted to the given template type
+	 * @return View of the components of the given template type, without copying them
 	 */
 	template <class T>
-	std::vector<T *> get_components() const
+	ComponentSpan<T> get_components() const
 	{
-		std::vector<T *> result;
-		if (has_component(typeid(T)))
+		auto it = components.find(typeid(T));
+		if (it == components.end())
 		{
-			auto &scene_components = get_components(typeid(T));
-
-			result.resize(scene_components.size());
-			std::transform(scene_components.begin(), scene_components.end(), result.begin(),
-			               [](const std::unique_ptr<Component> &component) -> T * {
-				               return dynamic_cast<T *>(component.get());
-			               });
+			return {};
 		}
 
-		return result;
+		auto &pointers = it->second.pointers;
+		return {pointers.data(), pointers.size()};
 	}
 
 	/**
@@ -130,6 +164,88 @@ class Scene
 
 	Node &get_root_node();
 
+	/**
+	 * @brief Updates the world matrices of the nodes under the root node whose transform changed,
+	 *        along with their descendants
+	 */
+	void update_transforms();
+
+	/**
+	 * @brief Defers writing the world matrices to the nodes until publish_transforms(),
+	 *        so that update_transforms() can run on a simulation thread while the nodes are drawn
+	 */
+	void set_deferred_transforms(bool enable);
+
+	/**
+	 * @brief Writes the world matrices of the last update_transforms() to the nodes and refits the BVH
+	 * @note Must be called when update_transforms() is not running, for instance between frames
+	 */
+	void publish_transforms();
+
+	TransformHierarchy &get_transform_hierarchy();
+
+	/**
+	 * @brief The keyframe animations of the transforms of the scene, updated by the sample before its scripts
+	 */
+	AnimationSystem &get_animation_system();
+
+	/**
+	 * @brief Bounding volume hierarchy over the world bounds of the mesh instances
+	 *
+	 * It is built on first use, then refitted by update_transforms() as nodes move,
+	 * and rebuilt when the scene structure changes.
+	 */
+	const BVH &get_bvh();
+
+	/**
+	 * @return The mesh instances, indexed by the primitives of the BVH
+	 */
+	const std::vector<MeshInstance> &get_mesh_instances();
+
+	/**
+	 * @brief Finds the mesh instances whose world bounds intersect a frustum
+	 * @param frustum Frustum in world space
+	 * @param instances Receives the indices of the visible mesh instances
+	 */
+	void query_visible(const Frustum &frustum, std::vector<uint32_t> &instances);
+
+	/**
+	 * @brief Finds the lights which can reach a frustum, from a bounding volume hierarchy over the volumes of the
+	 *        point and spot lights with a range. Directional lights and lights without a range are always found.
+	 *
+	 * The hierarchy is built on first use and refitted by update_transforms() as the light nodes move.
+	 * @param frustum Frustum in world space
+	 * @param lights Receives the lights, in the order of the scene components
+	 */
+	void query_visible_lights(const Frustum &frustum, std::vector<Light *> &lights);
+
+	/**
+	 * @brief Finds the nearest mesh instance whose world bounds are hit by a ray
+	 * @param origin Origin of the ray in world space
+	 * @param direction Direction of the ray
+	 * @return The node of the instance, or nullptr if none is hit
+	 */
+	Node *pick(const glm::vec3 &origin, const glm::vec3 &direction);
+
+	/**
+	 * @brief Finds the nearest surface hit by a ray
+	 *        The scene BVH selects the instances whose world bounds are hit, nearest first. The ray is then
+	 *        transformed to the local space of each instance and tested against the triangle BVHs of its sub
+	 *        meshes, kept by the loader with GLTFLoader::set_ray_cast_geometry. Sub meshes without them are
+	 *        hit at the bounds of their mesh.
+	 * @param origin Origin of the ray in world space
+	 * @param direction Direction of the ray
+	 * @param hit Receives the nearest hit
+	 * @param max_distance Hits farther than this distance are ignored
+	 * @return True if the ray hits a surface
+	 */
+	bool ray_cast(const glm::vec3 &origin, const glm::vec3 &direction, RayHit &hit, float max_distance = std::numeric_limits<float>::max());
+
+	/**
+	 * @brief Rebuilds the BVHs on next use, after meshes were added to nodes or the range or cone of lights changed
+	 */
+	void invalidate_bvh();
+
   private:
 	std::string name;
 
@@ -138,7 +254,66 @@ class Scene
 
 	Node *root{nullptr};
 
-	std::unordered_map<std::type_index, std::vector<std::unique_ptr<Component>>> components;
+	/// Declared after the nodes, as it detaches from their transforms when destroyed
+	std::unique_ptr<TransformHierarchy> transform_hierarchy;
+
+	AnimationSystem animation_system;
+
+	struct ComponentStorage
+	{
+		/// Owns the components
+		std::vector<std::unique_ptr<Component>> owned;
+
+		/// Dense array of the components, in the same order, which spans iterate over
+		std::vector<Component *> pointers;
+	};
+
+	std::unordered_map<std::type_index, ComponentStorage> components;
+
+	/**
+	 * @brief Builds the BVH if it is invalid, or refits the instances whose transform changed
+	 */
+	void update_bvh();
+
+	/**
+	 * @brief Builds the light BVH if it is invalid, or refits the lights whose transform changed
+	 */
+	void update_light_bvh();
+
+	/// Whether the BVH was used, so that it is kept up to date
+	bool bvh_enabled{false};
+
+	bool bvh_dirty{true};
+
+	BVH bvh;
+
+	std::vector<MeshInstance> mesh_instances;
+
+	/// World bounds of the mesh instances
+	std::vector<BVH::Bounds> instance_bounds;
+
+	/// Whether lights were queried, so that their BVH is kept up to date
+	bool light_bvh_enabled{false};
+
+	bool light_bvh_dirty{true};
+
+	/// Bounding volume hierarchy over the volumes of the bounded lights
+	BVH light_bvh;
+
+	/// Lights with a volume, indexed by the primitives of the light BVH
+	std::vector<Light *> bounded_lights;
+
+	/// Index of every bounded light in the light components
+	std::vector<uint32_t> bounded_light_indices;
+
+	/// Index of every light in the light components which reaches any frustum
+	std::vector<uint32_t> unbounded_light_indices;
+
+	/// World bounds of the bounded lights
+	std::vector<BVH::Bounds> light_bounds;
+
+	/// Scratch space of the light queries
+	std::vector<uint32_t> visible_light_indices;
 };
 }        // namespace sg
 }        // namespace vkb
\ No newline at end of file
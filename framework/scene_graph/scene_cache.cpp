@@ -0,0 +1,693 @@
+/* Copyright (c) 2020, Arm Limited and Contributors
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 the "License";
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "scene_graph/scene_cache.h"
+
+#include <algorithm>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+#include <unordered_map>
+
+#include "common/helpers.h"
+#include "core/device.h"
+#include "scene_graph/components/camera.h"
+#include "scene_graph/components/image.h"
+#include "scene_graph/components/light.h"
+#include "scene_graph/components/mesh.h"
+#include "scene_graph/components/pbr_material.h"
+#include "scene_graph/components/perspective_camera.h"
+#include "scene_graph/components/sampler.h"
+#include "scene_graph/components/sub_mesh.h"
+#include "scene_graph/components/texture.h"
+#include "scene_graph/components/transform.h"
+#include "scene_graph/node.h"
+#include "scene_graph/scene.h"
+
+namespace vkb
+{
+namespace sg
+{
+namespace
+{
+/// "VKSC"
+constexpr uint32_t SCENE_CACHE_MAGIC = 0x43534B56;
+
+/// Index of a missing reference
+constexpr uint32_t NO_INDEX = ~0u;
+
+/// Blobs start at a multiple of this, relative to the start of the cache
+constexpr size_t BLOB_ALIGNMENT = 16;
+
+/**
+ * @brief Appends values to a cache
+ */
+class CacheWriter
+{
+  public:
+	template <class T>
+	void write(const T &value)
+	{
+		static_assert(std::is_trivially_copyable<T>::value, "Only trivially copyable values can be written");
+
+		auto bytes = reinterpret_cast<const uint8_t *>(&value);
+		data.insert(data.end(), bytes, bytes + sizeof(T));
+	}
+
+	void write_string(const std::string &value)
+	{
+		write(to_u32(value.size()));
+		data.insert(data.end(), value.begin(), value.end());
+	}
+
+	void write_blob(const uint8_t *blob, size_t size)
+	{
+		write(static_cast<uint64_t>(size));
+		data.resize((data.size() + BLOB_ALIGNMENT - 1) & ~(BLOB_ALIGNMENT - 1), 0);
+		data.insert(data.end(), blob, blob + size);
+	}
+
+	std::vector<uint8_t> data;
+};
+
+/**
+ * @brief Reads the values of a cache in the order they were written, blobs are returned in place
+ */
+class CacheReader
+{
+  public:
+	CacheReader(const uint8_t *data, size_t size) :
+	    data{data},
+	    size{size}
+	{}
+
+	template <class T>
+	T read()
+	{
+		T value;
+		std::memcpy(&value, advance(sizeof(T)), sizeof(T));
+		return value;
+	}
+
+	std::string read_string()
+	{
+		auto length = read<uint32_t>();
+		auto chars  = reinterpret_cast<const char *>(advance(length));
+		return {chars, chars + length};
+	}
+
+	const uint8_t *read_blob(size_t &blob_size)
+	{
+		blob_size = static_cast<size_t>(read<uint64_t>());
+		advance(((position + BLOB_ALIGNMENT - 1) & ~(BLOB_ALIGNMENT - 1)) - position);
+		return advance(blob_size);
+	}
+
+  private:
+	const uint8_t *advance(size_t count)
+	{
+		if (count > size - position)
+		{
+			throw std::runtime_error{"Scene cache is truncated"};
+		}
+
+		auto current = data + position;
+		position += count;
+		return current;
+	}
+
+	const uint8_t *data;
+
+	size_t size;
+
+	size_t position{0};
+};
+
+/**
+ * @brief Maps the components of a type to their index in the scene
+ */
+template <class T>
+std::unordered_map<const T *, uint32_t> get_component_indices(const Scene &scene)
+{
+	std::unordered_map<const T *, uint32_t> indices;
+
+	auto components = scene.get_components<T>();
+	for (size_t i = 0; i < components.size(); ++i)
+	{
+		indices[components.at(i)] = to_u32(i);
+	}
+
+	return indices;
+}
+
+template <class T>
+uint32_t find_index(const std::unordered_map<const T *, uint32_t> &indices, const T *component)
+{
+	auto it = indices.find(component);
+	return it == indices.end() ? NO_INDEX : it->second;
+}
+
+template <class T>
+T *get_component(const std::vector<T *> &components, uint32_t index)
+{
+	if (index == NO_INDEX)
+	{
+		return nullptr;
+	}
+
+	if (index >= components.size())
+	{
+		throw std::runtime_error{"Scene cache has an invalid reference"};
+	}
+
+	return components[index];
+}
+
+/**
+ * @brief Moves components to the scene, returning their address in the same order
+ */
+template <class T>
+std::vector<T *> add_components(Scene &scene, std::vector<std::unique_ptr<T>> &&components)
+{
+	std::vector<T *> pointers(components.size());
+	std::transform(components.begin(), components.end(), pointers.begin(), [](const std::unique_ptr<T> &component) { return component.get(); });
+
+	scene.set_components(std::move(components));
+
+	return pointers;
+}
+}        // namespace
+
+constexpr uint32_t SceneCache::VERSION;
+
+std::vector<uint8_t> SceneCache::write(Scene &scene, const std::vector<std::vector<uint8_t>> &packed_images, const std::vector<VkSamplerCreateInfo> &sampler_infos)
+{
+	CacheWriter writer;
+
+	writer.write(SCENE_CACHE_MAGIC);
+	writer.write(VERSION);
+	writer.write_string(scene.get_name());
+
+	auto images = scene.get_components<Image>();
+	if (images.size() != packed_images.size())
+	{
+		throw std::runtime_error{"Scene cache needs the data of every image"};
+	}
+
+	writer.write(to_u32(images.size()));
+	for (size_t i = 0; i < images.size(); ++i)
+	{
+		writer.write_string(images.at(i)->get_name());
+		writer.write_blob(packed_images[i].data(), packed_images[i].size());
+	}
+
+	auto samplers = scene.get_components<Sampler>();
+	if (samplers.size() != sampler_infos.size())
+	{
+		throw std::runtime_error{"Scene cache needs the create info of every sampler"};
+	}
+
+	writer.write(to_u32(samplers.size()));
+	for (size_t i = 0; i < samplers.size(); ++i)
+	{
+		auto sampler_info  = sampler_infos[i];
+		sampler_info.pNext = nullptr;
+
+		writer.write_string(samplers.at(i)->get_name());
+		writer.write(sampler_info);
+	}
+
+	auto image_indices   = get_component_indices<Image>(scene);
+	auto sampler_indices = get_component_indices<Sampler>(scene);
+
+	auto textures = scene.get_components<Texture>();
+	writer.write(to_u32(textures.size()));
+	for (auto texture : textures)
+	{
+		writer.write_string(texture->get_name());
+		writer.write(find_index<Image>(image_indices, texture->get_image()));
+		writer.write(find_index<Sampler>(sampler_indices, texture->get_sampler()));
+	}
+
+	auto texture_indices = get_component_indices<Texture>(scene);
+
+	auto materials = scene.get_components<PBRMaterial>();
+	writer.write(to_u32(materials.size()));
+	for (auto material : materials)
+	{
+		writer.write_string(material->get_name());
+		writer.write(material->base_color_factor);
+		writer.write(material->metallic_factor);
+		writer.write(material->roughness_factor);
+		writer.write(material->emissive);
+		writer.write(static_cast<uint32_t>(material->double_sided));
+		writer.write(material->alpha_cutoff);
+		writer.write(material->alpha_mode);
+
+		writer.write(to_u32(material->textures.size()));
+		for (auto &texture : material->textures)
+		{
+			writer.write_string(texture.first);
+			writer.write(find_index<Texture>(texture_indices, texture.second));
+		}
+	}
+
+	auto material_indices = get_component_indices<PBRMaterial>(scene);
+
+	auto submeshes = scene.get_components<SubMesh>();
+	writer.write(to_u32(submeshes.size()));
+	for (auto submesh : submeshes)
+	{
+		writer.write(submesh->index_type);
+		writer.write(submesh->index_offset);
+		writer.write(submesh->vertices_count);
+		writer.write(submesh->vertex_indices);
+		writer.write(find_index<PBRMaterial>(material_indices, dynamic_cast<const PBRMaterial *>(submesh->get_material())));
+
+		writer.write(to_u32(submesh->get_attributes().size()));
+		for (auto &attribute : submesh->get_attributes())
+		{
+			writer.write_string(attribute.first);
+			writer.write(attribute.second);
+		}
+
+		writer.write(to_u32(submesh->vertex_buffers.size()));
+		for (auto &vertex_buffer : submesh->vertex_buffers)
+		{
+			writer.write_string(vertex_buffer.first);
+			writer.write_blob(vertex_buffer.second.get_data(), static_cast<size_t>(vertex_buffer.second.get_size()));
+		}
+
+		writer.write(static_cast<uint32_t>(submesh->interleaved_vertex_buffer != nullptr));
+		if (submesh->interleaved_vertex_buffer)
+		{
+			writer.write(submesh->vertex_stride);
+			writer.write_blob(submesh->interleaved_vertex_buffer->get_data(), static_cast<size_t>(submesh->interleaved_vertex_buffer->get_size()));
+		}
+
+		writer.write(static_cast<uint32_t>(submesh->index_buffer != nullptr));
+		if (submesh->index_buffer)
+		{
+			writer.write_blob(submesh->index_buffer->get_data(), static_cast<size_t>(submesh->index_buffer->get_size()));
+		}
+
+		writer.write(to_u32(submesh->lods.size()));
+		for (auto &lod : submesh->lods)
+		{
+			writer.write(lod);
+		}
+	}
+
+	auto submesh_indices = get_component_indices<SubMesh>(scene);
+
+	auto meshes = scene.get_components<Mesh>();
+	writer.write(to_u32(meshes.size()));
+	for (auto mesh : meshes)
+	{
+		writer.write_string(mesh->get_name());
+		writer.write(mesh->get_bounds().get_min());
+		writer.write(mesh->get_bounds().get_max());
+
+		writer.write(to_u32(mesh->get_submeshes().size()));
+		for (auto submesh : mesh->get_submeshes())
+		{
+			writer.write(find_index<SubMesh>(submesh_indices, submesh));
+		}
+	}
+
+	auto cameras = scene.get_components<Camera>();
+	writer.write(to_u32(cameras.size()));
+	for (auto camera : cameras)
+	{
+		auto perspective_camera = dynamic_cast<PerspectiveCamera *>(camera);
+		if (!perspective_camera)
+		{
+			throw std::runtime_error{"Scene cache only stores perspective cameras"};
+		}
+
+		writer.write_string(camera->get_name());
+		writer.write(perspective_camera->get_aspect_ratio());
+		writer.write(perspective_camera->get_field_of_view());
+		writer.write(perspective_camera->get_near_plane());
+		writer.write(perspective_camera->get_far_plane());
+	}
+
+	auto lights = scene.get_components<Light>();
+	writer.write(to_u32(lights.size()));
+	for (auto light : lights)
+	{
+		writer.write_string(light->get_name());
+		writer.write(light->get_light_type());
+		writer.write(light->get_properties());
+	}
+
+	auto mesh_indices   = get_component_indices<Mesh>(scene);
+	auto camera_indices = get_component_indices<Camera>(scene);
+	auto light_indices  = get_component_indices<Light>(scene);
+
+	// Nodes are stored breadth first from the root, so that parents come before their children
+	std::vector<Node *>                        nodes{&scene.get_root_node()};
+	std::unordered_map<const Node *, uint32_t> node_indices{{nodes[0], 0}};
+
+	for (size_t i = 0; i < nodes.size(); ++i)
+	{
+		for (auto child : nodes[i]->get_children())
+		{
+			node_indices[child] = to_u32(nodes.size());
+			nodes.push_back(child);
+		}
+	}
+
+	writer.write(to_u32(nodes.size()));
+	for (size_t i = 0; i < nodes.size(); ++i)
+	{
+		auto  node      = nodes[i];
+		auto &transform = node->get_transform();
+
+		writer.write(static_cast<uint64_t>(node->get_id()));
+		writer.write_string(node->get_name());
+		writer.write(transform.get_translation());
+		writer.write(transform.get_rotation());
+		writer.write(transform.get_scale());
+
+		// The parent of a child of the root may not be set, the root is its parent in the hierarchy
+		uint32_t parent = NO_INDEX;
+		if (i > 0)
+		{
+			parent = node->get_parent() ? find_index<Node>(node_indices, node->get_parent()) : 0;
+		}
+		writer.write(parent);
+
+		writer.write(node->has_component<Mesh>() ? find_index<Mesh>(mesh_indices, &node->get_component<Mesh>()) : NO_INDEX);
+		writer.write(node->has_component<Camera>() ? find_index<Camera>(camera_indices, &node->get_component<Camera>()) : NO_INDEX);
+		writer.write(node->has_component<Light>() ? find_index<Light>(light_indices, &node->get_component<Light>()) : NO_INDEX);
+	}
+
+	auto channels = scene.get_animation_system().get_channels();
+
+	// Channels of transforms outside of the hierarchy can't be restored
+	channels.erase(std::remove_if(channels.begin(), channels.end(), [&node_indices](const AnimationSystem::Channel &channel) {
+		               return node_indices.find(&channel.transform->get_node()) == node_indices.end();
+	               }),
+	               channels.end());
+
+	writer.write(to_u32(channels.size()));
+	for (auto &channel : channels)
+	{
+		writer.write(node_indices.at(&channel.transform->get_node()));
+		writer.write(channel.target);
+		writer.write(to_u32(channel.times.size()));
+		writer.write_blob(reinterpret_cast<const uint8_t *>(channel.times.data()), channel.times.size() * sizeof(float));
+		writer.write_blob(reinterpret_cast<const uint8_t *>(channel.values.data()), channel.values.size() * sizeof(glm::vec4));
+	}
+
+	return std::move(writer.data);
+}
+
+std::unique_ptr<Scene> SceneCache::read(Device &device, const uint8_t *data, size_t size, VkBufferUsageFlags geometry_buffer_usage)
+{
+	CacheReader reader{data, size};
+
+	if (reader.read<uint32_t>() != SCENE_CACHE_MAGIC || reader.read<uint32_t>() != VERSION)
+	{
+		throw std::runtime_error{"Scene cache has an unsupported version"};
+	}
+
+	auto scene = std::make_unique<Scene>(reader.read_string());
+
+	std::vector<std::unique_ptr<Image>> image_components(reader.read<uint32_t>());
+	for (auto &image : image_components)
+	{
+		auto   name = reader.read_string();
+		size_t blob_size;
+		auto   blob = reader.read_blob(blob_size);
+
+		image = Image::unpack(name, blob, blob_size);
+	}
+	auto images = add_components(*scene, std::move(image_components));
+
+	std::vector<std::unique_ptr<Sampler>> sampler_components(reader.read<uint32_t>());
+	for (auto &sampler : sampler_components)
+	{
+		auto name         = reader.read_string();
+		auto sampler_info = reader.read<VkSamplerCreateInfo>();
+
+		sampler = std::make_unique<Sampler>(name, device.get_resource_cache().request_sampler(sampler_info));
+	}
+	auto samplers = add_components(*scene, std::move(sampler_components));
+
+	std::vector<std::unique_ptr<Texture>> texture_components(reader.read<uint32_t>());
+	for (auto &texture : texture_components)
+	{
+		texture = std::make_unique<Texture>(reader.read_string());
+
+		if (auto image = get_component(images, reader.read<uint32_t>()))
+		{
+			texture->set_image(*image);
+		}
+
+		if (auto sampler = get_component(samplers, reader.read<uint32_t>()))
+		{
+			texture->set_sampler(*sampler);
+		}
+	}
+	auto textures = add_components(*scene, std::move(texture_components));
+
+	std::vector<std::unique_ptr<PBRMaterial>> material_components(reader.read<uint32_t>());
+	for (auto &material : material_components)
+	{
+		material = std::make_unique<PBRMaterial>(reader.read_string());
+
+		material->base_color_factor = reader.read<glm::vec4>();
+		material->metallic_factor   = reader.read<float>();
+		material->roughness_factor  = reader.read<float>();
+		material->emissive          = reader.read<glm::vec3>();
+		material->double_sided      = reader.read<uint32_t>() != 0;
+		material->alpha_cutoff      = reader.read<float>();
+		material->alpha_mode        = reader.read<AlphaMode>();
+
+		auto texture_count = reader.read<uint32_t>();
+		for (uint32_t i = 0; i < texture_count; ++i)
+		{
+			auto name = reader.read_string();
+
+			material->textures[name] = get_component(textures, reader.read<uint32_t>());
+		}
+	}
+	auto materials = add_components(*scene, std::move(material_components));
+
+	auto create_buffer = [&device, &reader, geometry_buffer_usage](VkBufferUsageFlags usage) {
+		size_t blob_size;
+		auto   blob = reader.read_blob(blob_size);
+
+		// Copied straight from the cache to host visible memory, like the buffers of a parsed scene
+		core::Buffer buffer{device, blob_size, usage | geometry_buffer_usage, VMA_MEMORY_USAGE_GPU_TO_CPU};
+		buffer.update(blob, blob_size);
+
+		return buffer;
+	};
+
+	std::vector<std::unique_ptr<SubMesh>> submesh_components(reader.read<uint32_t>());
+	for (auto &submesh : submesh_components)
+	{
+		submesh = std::make_unique<SubMesh>();
+
+		submesh->index_type     = reader.read<VkIndexType>();
+		submesh->index_offset   = reader.read<uint32_t>();
+		submesh->vertices_count = reader.read<uint32_t>();
+		submesh->vertex_indices = reader.read<uint32_t>();
+
+		auto material_index = reader.read<uint32_t>();
+
+		auto attribute_count = reader.read<uint32_t>();
+		for (uint32_t i = 0; i < attribute_count; ++i)
+		{
+			auto name = reader.read_string();
+
+			submesh->set_attribute(name, reader.read<VertexAttribute>());
+		}
+
+		auto vertex_buffer_count = reader.read<uint32_t>();
+		for (uint32_t i = 0; i < vertex_buffer_count; ++i)
+		{
+			auto name = reader.read_string();
+
+			submesh->vertex_buffers.insert(std::make_pair(name, create_buffer(VK_BUFFER_USAGE_VERTEX_BUFFER_BIT)));
+		}
+
+		if (reader.read<uint32_t>())
+		{
+			submesh->vertex_stride             = reader.read<uint32_t>();
+			submesh->interleaved_vertex_buffer = std::make_unique<core::Buffer>(create_buffer(VK_BUFFER_USAGE_VERTEX_BUFFER_BIT));
+		}
+
+		if (reader.read<uint32_t>())
+		{
+			submesh->index_buffer = std::make_unique<core::Buffer>(create_buffer(VK_BUFFER_USAGE_INDEX_BUFFER_BIT));
+		}
+
+		submesh->lods.resize(reader.read<uint32_t>());
+		for (auto &lod : submesh->lods)
+		{
+			lod = reader.read<LevelOfDetail>();
+		}
+
+		// The material sets the shader variant, along with the attributes set before
+		if (auto material = get_component(materials, material_index))
+		{
+			submesh->set_material(*material);
+		}
+	}
+	auto submeshes = add_components(*scene, std::move(submesh_components));
+
+	std::vector<std::unique_ptr<Mesh>> mesh_components(reader.read<uint32_t>());
+	for (auto &mesh : mesh_components)
+	{
+		mesh = std::make_unique<Mesh>(reader.read_string());
+
+		auto min = reader.read<glm::vec3>();
+		auto max = reader.read<glm::vec3>();
+		if (glm::all(glm::lessThanEqual(min, max)))
+		{
+			mesh->update_bounds({min, max});
+		}
+
+		auto submesh_count = reader.read<uint32_t>();
+		for (uint32_t i = 0; i < submesh_count; ++i)
+		{
+			if (auto submesh = get_component(submeshes, reader.read<uint32_t>()))
+			{
+				mesh->add_submesh(*submesh);
+			}
+		}
+	}
+	auto meshes = add_components(*scene, std::move(mesh_components));
+
+	std::vector<std::unique_ptr<Camera>> camera_components(reader.read<uint32_t>());
+	for (auto &camera : camera_components)
+	{
+		auto perspective_camera = std::make_unique<PerspectiveCamera>(reader.read_string());
+
+		perspective_camera->set_aspect_ratio(reader.read<float>());
+		perspective_camera->set_field_of_view(reader.read<float>());
+		perspective_camera->set_near_plane(reader.read<float>());
+		perspective_camera->set_far_plane(reader.read<float>());
+
+		camera = std::move(perspective_camera);
+	}
+	auto cameras = add_components(*scene, std::move(camera_components));
+
+	std::vector<std::unique_ptr<Light>> light_components(reader.read<uint32_t>());
+	for (auto &light : light_components)
+	{
+		light = std::make_unique<Light>(reader.read_string());
+
+		light->set_light_type(reader.read<LightType>());
+		light->set_properties(reader.read<LightProperties>());
+	}
+	auto lights = add_components(*scene, std::move(light_components));
+
+	std::vector<std::unique_ptr<Node>> nodes(reader.read<uint32_t>());
+	if (nodes.empty())
+	{
+		throw std::runtime_error{"Scene cache has no root node"};
+	}
+
+	for (size_t i = 0; i < nodes.size(); ++i)
+	{
+		auto id   = static_cast<size_t>(reader.read<uint64_t>());
+		auto name = reader.read_string();
+
+		auto node = std::make_unique<Node>(id, name);
+
+		auto &transform = node->get_transform();
+		transform.set_translation(reader.read<glm::vec3>());
+		transform.set_rotation(reader.read<glm::quat>());
+		transform.set_scale(reader.read<glm::vec3>());
+
+		// Parents come first, except for the root which has none
+		auto parent_index = reader.read<uint32_t>();
+		if (i > 0)
+		{
+			if (parent_index >= i)
+			{
+				throw std::runtime_error{"Scene cache has an invalid reference"};
+			}
+
+			auto &parent = *nodes[parent_index];
+			node->set_parent(parent);
+			parent.add_child(*node);
+		}
+
+		if (auto mesh = get_component(meshes, reader.read<uint32_t>()))
+		{
+			node->set_component(*mesh);
+			mesh->add_node(*node);
+		}
+
+		if (auto camera = get_component(cameras, reader.read<uint32_t>()))
+		{
+			node->set_component(*camera);
+			camera->set_node(*node);
+		}
+
+		if (auto light = get_component(lights, reader.read<uint32_t>()))
+		{
+			node->set_component(*light);
+			light->set_node(*node);
+		}
+
+		nodes[i] = std::move(node);
+	}
+
+	auto channel_count = reader.read<uint32_t>();
+	for (uint32_t i = 0; i < channel_count; ++i)
+	{
+		auto node_index = reader.read<uint32_t>();
+		if (node_index >= nodes.size())
+		{
+			throw std::runtime_error{"Scene cache has an invalid reference"};
+		}
+
+		auto target    = reader.read<AnimationTarget>();
+		auto key_count = reader.read<uint32_t>();
+
+		size_t times_size;
+		auto   times_data = reader.read_blob(times_size);
+		size_t values_size;
+		auto   values_data = reader.read_blob(values_size);
+
+		if (key_count == 0 || times_size != key_count * sizeof(float) || values_size != key_count * sizeof(glm::vec4))
+		{
+			throw std::runtime_error{"Scene cache has an invalid animation channel"};
+		}
+
+		std::vector<float>     times(key_count);
+		std::vector<glm::vec4> values(key_count);
+		std::memcpy(times.data(), times_data, times_size);
+		std::memcpy(values.data(), values_data, values_size);
+
+		scene->get_animation_system().add_channel(nodes[node_index]->get_transform(), target, times, values);
+	}
+
+	scene->set_root_node(*nodes[0]);
+	scene->set_nodes(std::move(nodes));
+
+	return scene;
+}
+}        // namespace sg
+}        // namespace vkb
@@ -0,0 +1,70 @@
+/* Copyright (c) 2020, Arm Limited and Contributors
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 the "License";
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+#include "common/vk_common.h"
+
+namespace vkb
+{
+class Device;
+
+namespace sg
+{
+class Scene;
+
+/**
+ * @brief Flat binary form of a loaded scene, written after a first load so that later loads skip parsing
+ *
+ * The cache holds the nodes and their transforms, the components of the scene and the animation channels,
+ * with references between them stored as indices. Vertex, index and image data are stored in their final
+ * layout, and copied straight from the cache to their buffer when it is read.
+ */
+class SceneCache
+{
+  public:
+	/// Must be increased whenever the layout of the cache changes
+	static constexpr uint32_t VERSION = 2;
+
+	/**
+	 * @brief Serializes a scene
+	 * @param scene The scene, whose meshes are drawn from host visible buffers
+	 * @param packed_images The output of sg::Image::pack for every image of the scene, in the order of its components
+	 * @param sampler_infos The create info of every sampler of the scene, in the order of its components
+	 * @return The cache
+	 * @throws runtime_error if the scene has components the cache can't store
+	 */
+	static std::vector<uint8_t> write(Scene &scene, const std::vector<std::vector<uint8_t>> &packed_images, const std::vector<VkSamplerCreateInfo> &sampler_infos);
+
+	/**
+	 * @brief Recreates a scene from a cache
+	 *        The images are returned with their data, their Vulkan image is neither created nor uploaded.
+	 * @param device The device to create the buffers and samplers with
+	 * @param data The cache, usually mapped in memory
+	 * @param size The size of the cache in bytes
+	 * @param geometry_buffer_usage Usages added to the vertex and index buffers of sub meshes
+	 * @return The scene
+	 * @throws runtime_error if the cache is truncated or of another version
+	 */
+	static std::unique_ptr<Scene> read(Device &device, const uint8_t *data, size_t size, VkBufferUsageFlags geometry_buffer_usage = 0);
+};
+}        // namespace sg
+}        // namespace vkb
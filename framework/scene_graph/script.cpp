@@ -35,6 +35,10 @@ void Script::input_event(const InputEvent & /*input_event*/)
 {
 }
 
+void Script::input_snapshot(const InputSnapshot & /*input*/)
+{
+}
+
 void Script::resize(uint32_t /*width*/, uint32_t /*height*/)
 {
 }
@@ -23,6 +23,7 @@
 #include <vector>
 
 #include "platform/input_events.h"
+#include "platform/input_snapshot.h"
 #include "scene_graph/component.h"
 
 namespace vkb
@@ -49,6 +50,11 @@ class Script : public Component
 
 	virtual void input_event(const InputEvent &input_event);
 
+	/**
+	 * @brief Receives the input of the frame, folded from its events, before update
+	 */
+	virtual void input_snapshot(const InputSnapshot &input);
+
 	virtual void resize(uint32_t width, uint32_t height);
 
 	Node &get_node();
@@ -56,67 +56,67 @@ void FreeCamera::update(float delta_time)
 
 	float mul_translation = speed_multiplier;
 
-	if (key_pressed[KeyCode::W])
+	if (input.is_key_pressed(KeyCode::W))
 	{
 		delta_translation.z -= TRANSLATION_MOVE_STEP;
 	}
-	if (key_pressed[KeyCode::S])
+	if (input.is_key_pressed(KeyCode::S))
 	{
 		delta_translation.z += TRANSLATION_MOVE_STEP;
 	}
-	if (key_pressed[KeyCode::A])
+	if (input.is_key_pressed(KeyCode::A))
 	{
 		delta_translation.x -= TRANSLATION_MOVE_STEP;
 	}
-	if (key_pressed[KeyCode::D])
+	if (input.is_key_pressed(KeyCode::D))
 	{
 		delta_translation.x += TRANSLATION_MOVE_STEP;
 	}
-	if (key_pressed[KeyCode::LeftControl])
+	if (input.is_key_pressed(KeyCode::LeftControl))
 	{
 		mul_translation *= (1.0f * TRANSLATION_MOVE_SPEED);
 	}
-	if (key_pressed[KeyCode::LeftShift])
+	if (input.is_key_pressed(KeyCode::LeftShift))
 	{
 		mul_translation *= (1.0f / TRANSLATION_MOVE_SPEED);
 	}
 
-	if (key_pressed[KeyCode::I])
+	if (input.is_key_pressed(KeyCode::I))
 	{
 		delta_rotation.x += KEY_ROTATION_MOVE_WEIGHT;
 	}
-	if (key_pressed[KeyCode::K])
+	if (input.is_key_pressed(KeyCode::K))
 	{
 		delta_rotation.x -= KEY_ROTATION_MOVE_WEIGHT;
 	}
-	if (key_pressed[KeyCode::J])
+	if (input.is_key_pressed(KeyCode::J))
 	{
 		delta_rotation.y += KEY_ROTATION_MOVE_WEIGHT;
 	}
-	if (key_pressed[KeyCode::L])
+	if (input.is_key_pressed(KeyCode::L))
 	{
 		delta_rotation.y -= KEY_ROTATION_MOVE_WEIGHT;
 	}
 
-	if (mouse_button_pressed[MouseButton::Left] && mouse_button_pressed[MouseButton::Right])
+	if (input.is_mouse_button_pressed(MouseButton::Left) && input.is_mouse_button_pressed(MouseButton::Right))
 	{
-		delta_rotation.z += TRANSLATION_MOVE_WEIGHT * mouse_move_delta.x;
+		delta_rotation.z += TRANSLATION_MOVE_WEIGHT * input.get_mouse_delta().x;
 	}
-	else if (mouse_button_pressed[MouseButton::Right])
+	else if (input.is_mouse_button_pressed(MouseButton::Right))
 	{
-		delta_rotation.x -= ROTATION_MOVE_WEIGHT * mouse_move_delta.y;
-		delta_rotation.y -= ROTATION_MOVE_WEIGHT * mouse_move_delta.x;
+		delta_rotation.x -= ROTATION_MOVE_WEIGHT * input.get_mouse_delta().y;
+		delta_rotation.y -= ROTATION_MOVE_WEIGHT * input.get_mouse_delta().x;
 	}
-	else if (mouse_button_pressed[MouseButton::Left])
+	else if (input.is_mouse_button_pressed(MouseButton::Left))
 	{
-		delta_translation.x += TRANSLATION_MOVE_WEIGHT * mouse_move_delta.x;
-		delta_translation.y += TRANSLATION_MOVE_WEIGHT * -mouse_move_delta.y;
+		delta_translation.x += TRANSLATION_MOVE_WEIGHT * input.get_mouse_delta().x;
+		delta_translation.y += TRANSLATION_MOVE_WEIGHT * -input.get_mouse_delta().y;
 	}
 
-	if (touch_pointer_pressed[0])
+	if (input.is_touch_pointer_pressed(0))
 	{
-		delta_rotation.x -= ROTATION_MOVE_WEIGHT * touch_move_delta.y;
-		delta_rotation.y -= ROTATION_MOVE_WEIGHT * touch_move_delta.x;
+		delta_rotation.x -= ROTATION_MOVE_WEIGHT * input.get_touch_delta().y;
+		delta_rotation.y -= ROTATION_MOVE_WEIGHT * input.get_touch_delta().x;
 
 		if (touch_pointer_time > TOUCH_DOWN_MOVE_FORWARD_WAIT_TIME)
 		{
@@ -127,6 +127,10 @@ void FreeCamera::update(float delta_time)
 			touch_pointer_time += delta_time;
 		}
 	}
+	else
+	{
+		touch_pointer_time = 0.0f;
+	}
 
 	delta_translation *= mul_translation * delta_time;
 	delta_rotation *= delta_time;
@@ -144,77 +148,11 @@ void FreeCamera::update(float delta_time)
 		transform.set_translation(transform.get_translation() + delta_translation * glm::conjugate(orientation));
 		transform.set_rotation(orientation);
 	}
-
-	mouse_move_delta = {};
-	touch_move_delta = {};
 }
 
-void FreeCamera::input_event(const InputEvent &input_event)
+void FreeCamera::input_snapshot(const InputSnapshot &new_input)
 {
-	if (input_event.get_source() == EventSource::Keyboard)
-	{
-		const auto &key_event = static_cast<const KeyInputEvent &>(input_event);
-
-		if (key_event.get_action() == KeyAction::Down ||
-		    key_event.get_action() == KeyAction::Repeat)
-		{
-			key_pressed[key_event.get_code()] = true;
-		}
-		else
-		{
-			key_pressed[key_event.get_code()] = false;
-		}
-	}
-	else if (input_event.get_source() == EventSource::Mouse)
-	{
-		const auto &mouse_button = static_cast<const MouseButtonInputEvent &>(input_event);
-
-		glm::vec2 mouse_pos{std::floor(mouse_button.get_pos_x()), std::floor(mouse_button.get_pos_y())};
-
-		if (mouse_button.get_action() == MouseAction::Down)
-		{
-			mouse_button_pressed[mouse_button.get_button()] = true;
-		}
-
-		if (mouse_button.get_action() == MouseAction::Up)
-		{
-			mouse_button_pressed[mouse_button.get_button()] = false;
-		}
-
-		if (mouse_button.get_action() == MouseAction::Move)
-		{
-			mouse_move_delta = mouse_pos - mouse_last_pos;
-
-			mouse_last_pos = mouse_pos;
-		}
-	}
-	else if (input_event.get_source() == EventSource::Touchscreen)
-	{
-		const auto &touch_event = static_cast<const TouchInputEvent &>(input_event);
-
-		glm::vec2 touch_pos{std::floor(touch_event.get_pos_x()), std::floor(touch_event.get_pos_y())};
-
-		if (touch_event.get_action() == TouchAction::Down)
-		{
-			touch_pointer_pressed[touch_event.get_pointer_id()] = true;
-
-			touch_last_pos = touch_pos;
-		}
-
-		if (touch_event.get_action() == TouchAction::Up)
-		{
-			touch_pointer_pressed[touch_event.get_pointer_id()] = false;
-
-			touch_pointer_time = 0.0f;
-		}
-
-		if (touch_event.get_action() == TouchAction::Move && touch_event.get_pointer_id() == 0)
-		{
-			touch_move_delta = touch_pos - touch_last_pos;
-
-			touch_last_pos = touch_pos;
-		}
-	}
+	input = new_input;
 }
 
 void FreeCamera::resize(uint32_t width, uint32_t height)
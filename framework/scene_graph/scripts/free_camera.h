@@ -20,7 +20,6 @@
 #include <memory>
 #include <string>
 #include <typeinfo>
-#include <unordered_map>
 #include <vector>
 
 #include "common/error.h"
@@ -56,28 +55,17 @@ class FreeCamera : public Script
 
 	virtual void update(float delta_time) override;
 
-	virtual void input_event(const InputEvent &input_event) override;
+	virtual void input_snapshot(const InputSnapshot &input) override;
 
 	virtual void resize(uint32_t width, uint32_t height) override;
 
   private:
 	float speed_multiplier{3.0f};
 
-	glm::vec2 mouse_move_delta{0.0f};
-
-	glm::vec2 mouse_last_pos{0.0f};
-
-	glm::vec2 touch_move_delta{0.0f};
-
-	glm::vec2 touch_last_pos{0.0f};
-
 	float touch_pointer_time{0.0f};
 
-	std::unordered_map<KeyCode, bool> key_pressed;
-
-	std::unordered_map<MouseButton, bool> mouse_button_pressed;
-
-	std::unordered_map<int32_t, bool> touch_pointer_pressed;
+	/// Input of the frame being updated
+	InputSnapshot input;
 };
 }        // namespace sg
 }        // namespace vkb
@@ -0,0 +1,261 @@
+/* Copyright (c) 2020, Arm Limited and Contributors
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 the "License";
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "scene_graph/stress_scene.h"
+
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+#include "common/logging.h"
+#include "common/utils.h"
+#include "core/device.h"
+#include "scene_graph/components/mesh.h"
+#include "scene_graph/components/pbr_material.h"
+#include "scene_graph/components/perspective_camera.h"
+#include "scene_graph/components/sub_mesh.h"
+#include "scene_graph/node.h"
+#include "scene_graph/scene.h"
+
+namespace vkb
+{
+namespace sg
+{
+namespace
+{
+/**
+ * @brief Creates a vertex buffer holding the data of an attribute, and sets the attribute
+ */
+template <typename T>
+void add_vertex_attribute(Device &device, SubMesh &submesh, const std::string &name, VkFormat format, const std::vector<T> &data)
+{
+	core::Buffer buffer{device,
+	                    data.size() * sizeof(T),
+	                    VK_BUFFER_USAGE_VERTEX_BUFFER_BIT,
+	                    VMA_MEMORY_USAGE_CPU_TO_GPU};
+	buffer.update(reinterpret_cast<const uint8_t *>(data.data()), data.size() * sizeof(T));
+
+	submesh.vertex_buffers.insert(std::make_pair(name, std::move(buffer)));
+
+	VertexAttribute attribute;
+	attribute.format = format;
+	attribute.stride = to_u32(sizeof(T));
+
+	submesh.set_attribute(name, attribute);
+}
+
+/**
+ * @brief Creates the sub mesh of a sphere, which differs from the spheres of other indices
+ *        by its tessellation and its height
+ */
+std::unique_ptr<SubMesh> create_sphere(Device &device, uint32_t index, Mesh &mesh)
+{
+	const uint32_t segments = 8 + 4 * (index % 8);
+	const uint32_t rings    = segments / 2;
+	const float    height   = 0.5f + 0.125f * static_cast<float>((index / 8) % 5);
+
+	std::vector<glm::vec3> positions;
+	std::vector<glm::vec3> normals;
+	std::vector<glm::vec2> texcoords;
+
+	for (uint32_t ring = 0; ring <= rings; ++ring)
+	{
+		float v     = static_cast<float>(ring) / static_cast<float>(rings);
+		float theta = v * glm::pi<float>();
+
+		for (uint32_t segment = 0; segment <= segments; ++segment)
+		{
+			float u   = static_cast<float>(segment) / static_cast<float>(segments);
+			float phi = u * glm::two_pi<float>();
+
+			glm::vec3 normal{std::sin(theta) * std::cos(phi), std::cos(theta), std::sin(theta) * std::sin(phi)};
+
+			positions.push_back(0.5f * glm::vec3{normal.x, normal.y * height, normal.z});
+			normals.push_back(glm::normalize(glm::vec3{normal.x * height, normal.y, normal.z * height}));
+			texcoords.emplace_back(u, v);
+		}
+	}
+
+	std::vector<uint16_t> indices;
+
+	for (uint32_t ring = 0; ring < rings; ++ring)
+	{
+		for (uint32_t segment = 0; segment < segments; ++segment)
+		{
+			auto first  = static_cast<uint16_t>(ring * (segments + 1) + segment);
+			auto second = static_cast<uint16_t>(first + segments + 1);
+
+			indices.insert(indices.end(), {first, second, static_cast<uint16_t>(first + 1)});
+			indices.insert(indices.end(), {second, static_cast<uint16_t>(second + 1), static_cast<uint16_t>(first + 1)});
+		}
+	}
+
+	auto submesh = std::make_unique<SubMesh>();
+
+	add_vertex_attribute(device, *submesh, "position", VK_FORMAT_R32G32B32_SFLOAT, positions);
+	add_vertex_attribute(device, *submesh, "normal", VK_FORMAT_R32G32B32_SFLOAT, normals);
+	add_vertex_attribute(device, *submesh, "texcoord_0", VK_FORMAT_R32G32_SFLOAT, texcoords);
+
+	submesh->vertices_count = to_u32(positions.size());
+	submesh->vertex_indices = to_u32(indices.size());
+	submesh->index_type     = VK_INDEX_TYPE_UINT16;
+
+	submesh->index_buffer = std::make_unique<core::Buffer>(device,
+	                                                       indices.size() * sizeof(uint16_t),
+	                                                       VK_BUFFER_USAGE_INDEX_BUFFER_BIT,
+	                                                       VMA_MEMORY_USAGE_CPU_TO_GPU);
+	submesh->index_buffer->update(reinterpret_cast<const uint8_t *>(indices.data()), indices.size() * sizeof(uint16_t));
+
+	mesh.update_bounds(positions, indices);
+
+	return submesh;
+}
+}        // namespace
+
+std::unique_ptr<Scene> create_stress_scene(Device &device, const StressSceneOptions &options)
+{
+	auto scene = std::make_unique<Scene>("stress_scene");
+
+	const uint32_t node_count     = std::max(options.node_count, 1u);
+	const uint32_t mesh_count     = std::max(std::min(options.mesh_count, node_count), 1u);
+	const uint32_t material_count = std::max(std::min(options.material_count, mesh_count), 1u);
+
+	if (options.material_count > mesh_count)
+	{
+		LOGW("Stress scene has {} materials for {} meshes, only {} of them are used", options.material_count, mesh_count, material_count);
+	}
+
+	for (uint32_t i = 0; i < material_count; ++i)
+	{
+		auto material = std::make_unique<PBRMaterial>("stress_material_" + std::to_string(i));
+
+		// Hues spread around the color wheel
+		float hue                   = glm::two_pi<float>() * static_cast<float>(i) / static_cast<float>(material_count);
+		material->base_color_factor = glm::vec4{0.5f + 0.5f * glm::cos(hue + glm::vec3{0.0f, 2.0944f, 4.1888f}), 1.0f};
+		material->metallic_factor   = static_cast<float>(i % 2);
+		material->roughness_factor  = 0.25f + 0.5f * static_cast<float>(i % 3) / 2.0f;
+
+		scene->add_component(std::move(material));
+	}
+
+	auto materials = scene->get_components<PBRMaterial>();
+
+	for (uint32_t i = 0; i < mesh_count; ++i)
+	{
+		auto mesh = std::make_unique<Mesh>("stress_mesh_" + std::to_string(i));
+
+		auto submesh = create_sphere(device, i, *mesh);
+		submesh->set_material(*materials.at(i % material_count));
+
+		mesh->add_submesh(*submesh);
+
+		scene->add_component(std::move(submesh));
+		scene->add_component(std::move(mesh));
+	}
+
+	auto meshes = scene->get_components<Mesh>();
+
+	// Nodes form a complete tree, with as many children per node as needed to hold the nodes in the requested depth
+	const uint32_t hierarchy_depth = std::max(options.hierarchy_depth, 1u);
+	const uint32_t branching       = std::max(static_cast<uint32_t>(std::ceil(std::pow(static_cast<double>(node_count), 1.0 / hierarchy_depth))), 2u);
+
+	const uint32_t grid_side   = static_cast<uint32_t>(std::ceil(std::sqrt(static_cast<double>(node_count))));
+	const float    grid_extent = static_cast<float>(grid_side) * options.spacing;
+
+	std::vector<std::unique_ptr<Node>> nodes;
+	nodes.reserve(node_count + 1);
+
+	auto root_node = std::make_unique<Node>(0, "stress_scene");
+
+	std::vector<glm::vec3> world_positions(node_count);
+
+	for (uint32_t i = 0; i < node_count; ++i)
+	{
+		world_positions[i] = options.spacing * glm::vec3{static_cast<float>(i % grid_side) - 0.5f * static_cast<float>(grid_side - 1),
+		                                                 0.0f,
+		                                                 static_cast<float>(i / grid_side) - 0.5f * static_cast<float>(grid_side - 1)};
+
+		auto node = std::make_unique<Node>(i + 1, "stress_node_" + std::to_string(i));
+
+		// The first nodes are children of the root, the others are children of earlier nodes, filling a level before the next
+		Node *    parent          = root_node.get();
+		glm::vec3 parent_position = glm::vec3{0.0f};
+
+		if (i >= branching)
+		{
+			uint32_t parent_index = (i - branching) / branching;
+
+			parent          = nodes.at(parent_index).get();
+			parent_position = world_positions[parent_index];
+		}
+
+		node->get_transform().set_translation(world_positions[i] - parent_position);
+
+		node->set_parent(*parent);
+		parent->add_child(*node);
+
+		auto mesh = meshes.at(i % mesh_count);
+		node->set_component(*mesh);
+		mesh->add_node(*node);
+
+		nodes.push_back(std::move(node));
+	}
+
+	scene->set_root_node(*root_node);
+	nodes.push_back(std::move(root_node));
+
+	scene->set_nodes(std::move(nodes));
+
+	auto camera_node = std::make_unique<Node>(-1, "default_camera");
+
+	auto camera = std::make_unique<PerspectiveCamera>("default_camera");
+	camera->set_aspect_ratio(1.77f);
+	camera->set_field_of_view(1.0f);
+	camera->set_near_plane(0.1f);
+	camera->set_far_plane(4.0f * grid_extent + 10.0f);
+	camera->set_node(*camera_node);
+
+	// Above the near edge of the grid, looking down at its center
+	camera_node->get_transform().set_translation(glm::vec3{0.0f, 0.5f, 0.9f} * grid_extent + glm::vec3{0.0f, options.spacing, 0.0f});
+	camera_node->get_transform().set_rotation(glm::angleAxis(glm::radians(-30.0f), glm::vec3{1.0f, 0.0f, 0.0f}));
+	camera_node->set_component(*camera);
+
+	scene->add_component(std::move(camera));
+	scene->add_child(*camera_node);
+	scene->add_node(std::move(camera_node));
+
+	// Lights on a grid of their own, each reaching the nodes of its cell
+	const uint32_t light_side = static_cast<uint32_t>(std::ceil(std::sqrt(static_cast<double>(options.light_count))));
+
+	for (uint32_t i = 0; i < options.light_count; ++i)
+	{
+		glm::vec2 cell{static_cast<float>(i % light_side) + 0.5f, static_cast<float>(i / light_side) + 0.5f};
+
+		LightProperties properties;
+		properties.color     = glm::vec3{0.6f} + 0.4f * glm::vec3{static_cast<float>(i % 2), static_cast<float>((i / 2) % 2), static_cast<float>((i / 4) % 2)};
+		properties.intensity = 4.0f;
+		properties.range     = 2.0f * grid_extent / static_cast<float>(light_side);
+
+		glm::vec2 position = (cell / static_cast<float>(light_side) - 0.5f) * grid_extent;
+
+		add_point_light(*scene, glm::vec3{position.x, 3.0f * options.spacing, position.y}, properties);
+	}
+
+	return scene;
+}
+}        // namespace sg
+}        // namespace vkb
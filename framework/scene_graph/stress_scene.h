@@ -0,0 +1,66 @@
+/* Copyright (c) 2020, Arm Limited and Contributors
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 the "License";
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <cstdint>
+#include <memory>
+
+namespace vkb
+{
+class Device;
+
+namespace sg
+{
+class Scene;
+
+/**
+ * @brief Parameters of a procedural scene built to find the scaling limits of the renderer
+ */
+struct StressSceneOptions
+{
+	/// Nodes drawing a mesh
+	uint32_t node_count{1024};
+
+	/// Unique meshes, spheres of different tessellations and proportions drawn by the nodes in turn
+	uint32_t mesh_count{16};
+
+	/// Unique materials, assigned to the meshes in turn so that at most mesh_count of them are drawn
+	uint32_t material_count{16};
+
+	/// Point lights above the nodes
+	uint32_t light_count{4};
+
+	/// Levels of nodes under the root, 1 for every node to be a child of the root
+	uint32_t hierarchy_depth{1};
+
+	/// Distance between neighbouring nodes, which are laid out on a square grid
+	float spacing{2.0f};
+};
+
+/**
+ * @brief Builds a scene of meshes on a grid, without loading any asset
+ *
+ * The scene has a perspective camera on a node named "default_camera", above the grid and looking at it,
+ * for add_free_camera to find. The meshes have positions, normals and texture coordinates, their materials
+ * are untextured.
+ * @param device Device creating the vertex and index buffers
+ * @param options Size of the scene
+ */
+std::unique_ptr<Scene> create_stress_scene(Device &device, const StressSceneOptions &options);
+}        // namespace sg
+}        // namespace vkb
@@ -0,0 +1,196 @@
+/* Copyright (c) 2020, Arm Limited and Contributors
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 the "License";
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "scene_graph/texture_array_packer.h"
+
+#include <algorithm>
+#include <map>
+#include <tuple>
+
+#include "common/logging.h"
+#include "common/utils.h"
+#include "core/device.h"
+#include "scene_graph/components/image.h"
+
+namespace vkb
+{
+namespace sg
+{
+namespace
+{
+/**
+ * @brief Layers of images sharing a format, extent and mip chain
+ *
+ * The data is laid out level by level, with the layers of a level next to each other,
+ * so that a single copy region uploads a level of every layer.
+ */
+class TextureArray : public Image
+{
+  public:
+	TextureArray(const std::string &name, const std::vector<Image *> &images) :
+	    Image{name}
+	{
+		auto &first = *images.front();
+
+		set_format(first.get_format());
+		set_layers(to_u32(images.size()));
+
+		// Levels generated on the GPU have no data
+		size_t level_count = first.has_gpu_mipmaps() ? 1 : first.get_mipmaps().size();
+
+		auto &mipmaps = get_mut_mipmaps();
+		mipmaps.assign(first.get_mipmaps().begin(), first.get_mipmaps().begin() + level_count);
+
+		std::vector<std::vector<VkDeviceSize>> offsets(images.size(), std::vector<VkDeviceSize>(level_count));
+
+		auto &data = get_mut_data();
+
+		for (size_t level = 0; level < level_count; ++level)
+		{
+			size_t level_size = get_level_size(first, level);
+
+			mipmaps[level].offset = to_u32(data.size());
+
+			for (size_t layer = 0; layer < images.size(); ++layer)
+			{
+				auto &image_data   = images[layer]->get_data();
+				auto  level_offset = images[layer]->get_mipmaps()[level].offset;
+
+				offsets[layer][level] = data.size();
+
+				data.insert(data.end(), image_data.begin() + level_offset, image_data.begin() + level_offset + level_size);
+			}
+		}
+
+		set_offsets(offsets);
+
+		if (first.has_gpu_mipmaps())
+		{
+			add_gpu_mipmaps();
+		}
+	}
+
+	virtual ~TextureArray() = default;
+
+	/**
+	 * @return The size of a level of an image, from the offset of the next level in its data
+	 */
+	static size_t get_level_size(const Image &image, size_t level)
+	{
+		auto &mipmaps = image.get_mipmaps();
+
+		size_t offset = mipmaps[level].offset;
+		size_t end    = image.get_data().size();
+
+		// Levels are not always stored in order
+		size_t level_count = image.has_gpu_mipmaps() ? 1 : mipmaps.size();
+		for (size_t i = 0; i < level_count; ++i)
+		{
+			if (mipmaps[i].offset > offset)
+			{
+				end = std::min<size_t>(end, mipmaps[i].offset);
+			}
+		}
+
+		return end - offset;
+	}
+};
+}        // namespace
+
+TextureArrayPacker::TextureArrayPacker(uint32_t max_extent, uint32_t max_layers) :
+    max_extent{max_extent},
+    max_layers{max_layers}
+{
+}
+
+std::vector<std::unique_ptr<Image>> TextureArrayPacker::pack(Device &device, std::vector<std::unique_ptr<Image>> &&images, std::vector<TextureArrayPlacement> &placements) const
+{
+	auto layer_limit = std::min(max_layers, device.get_gpu().get_properties().limits.maxImageArrayLayers);
+
+	// Images can only share an array when every level has the same size
+	using GroupKey = std::tuple<VkFormat, uint32_t, uint32_t, size_t, bool, size_t>;
+
+	std::map<GroupKey, std::vector<size_t>> groups;
+
+	std::vector<size_t> unpacked_images;
+
+	for (size_t i = 0; i < images.size(); ++i)
+	{
+		auto &image = *images[i];
+
+		image.transcode(device);
+
+		const auto &extent = image.get_extent();
+
+		if (image.get_layers() != 1 || extent.depth != 1 || extent.width > max_extent || extent.height > max_extent || image.get_data().empty())
+		{
+			unpacked_images.push_back(i);
+			continue;
+		}
+
+		groups[GroupKey{image.get_format(), extent.width, extent.height, image.get_mipmaps().size(), image.has_gpu_mipmaps(), image.get_data().size()}].push_back(i);
+	}
+
+	std::vector<std::unique_ptr<Image>> packed_images;
+
+	placements.assign(images.size(), {0, 0});
+
+	size_t array_count = 0;
+
+	for (auto &group : groups)
+	{
+		auto &indices = group.second;
+
+		if (indices.size() == 1)
+		{
+			unpacked_images.push_back(indices.front());
+			continue;
+		}
+
+		for (size_t first = 0; first < indices.size(); first += layer_limit)
+		{
+			size_t last = std::min<size_t>(first + layer_limit, indices.size());
+
+			std::vector<Image *> layers;
+			for (size_t i = first; i < last; ++i)
+			{
+				placements[indices[i]] = {to_u32(packed_images.size()), to_u32(i - first)};
+				layers.push_back(images[indices[i]].get());
+			}
+
+			packed_images.push_back(std::make_unique<TextureArray>(images[indices[first]]->get_name() + "_array", layers));
+
+			array_count++;
+		}
+	}
+
+	size_t packed_image_count = images.size() - unpacked_images.size();
+
+	for (auto index : unpacked_images)
+	{
+		placements[index] = {to_u32(packed_images.size()), 0};
+		packed_images.push_back(std::move(images[index]));
+	}
+
+	LOGI("Packed {} images into {} texture arrays, {} images left alone", packed_image_count, array_count, unpacked_images.size());
+
+	images.clear();
+
+	return packed_images;
+}
+}        // namespace sg
+}        // namespace vkb
@@ -0,0 +1,78 @@
+/* Copyright (c) 2020, Arm Limited and Contributors
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 the "License";
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+#include "common/vk_common.h"
+
+namespace vkb
+{
+class Device;
+
+namespace sg
+{
+class Image;
+
+/**
+ * @brief Where an image ended up after packing
+ */
+struct TextureArrayPlacement
+{
+	/// Index of the image holding it in the packed images
+	uint32_t image;
+
+	/// Array layer of the image holding it
+	uint32_t layer;
+};
+
+/**
+ * @brief Groups small images of the same format, extent and mip chain into 2D texture arrays at load time,
+ *        so that their textures share one image and one descriptor, selecting a layer instead
+ *
+ * Images are packed before their Vulkan image is created, while their data is still on the CPU.
+ * Every packed image, including those left in an array of one layer, has to be created with
+ * VK_IMAGE_VIEW_TYPE_2D_ARRAY and sampled as an array.
+ */
+class TextureArrayPacker
+{
+  public:
+	/**
+	 * @param max_extent Images wider or taller than this are left in their own array
+	 * @param max_layers Maximum number of layers of an array, clamped to the limit of the device
+	 */
+	TextureArrayPacker(uint32_t max_extent = 512, uint32_t max_layers = 256);
+
+	/**
+	 * @brief Packs the images, transcoding them first since packing needs their final format
+	 * @param device Device the arrays will be created on
+	 * @param images Images without a Vulkan image
+	 * @param placements Receives the placement of every image, in the order of images
+	 * @return The packed images, arrays first then the images left alone
+	 */
+	std::vector<std::unique_ptr<Image>> pack(Device &device, std::vector<std::unique_ptr<Image>> &&images, std::vector<TextureArrayPlacement> &placements) const;
+
+  private:
+	uint32_t max_extent;
+
+	uint32_t max_layers;
+};
+}        // namespace sg
+}        // namespace vkb
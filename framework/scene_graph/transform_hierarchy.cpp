@@ -0,0 +1,295 @@
+/* Copyright (c) 2020, Arm Limited and Contributors
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 the "License";
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "transform_hierarchy.h"
+
+#include <algorithm>
+#include <future>
+
+#include "job_system.h"
+#include "scene_graph/node.h"
+
+namespace vkb
+{
+namespace sg
+{
+namespace
+{
+/// Below this many transforms a level is updated on the calling thread
+constexpr size_t PARALLEL_LEVEL_SIZE = 1024;
+}        // namespace
+
+constexpr uint32_t TransformHierarchy::NO_PARENT;
+
+TransformHierarchy::~TransformHierarchy()
+{
+	for (auto transform : transforms)
+	{
+		transform->hierarchy = nullptr;
+	}
+}
+
+void TransformHierarchy::set_root_node(Node &root_node)
+{
+	root = &root_node;
+
+	structure_dirty = true;
+}
+
+void TransformHierarchy::invalidate_structure()
+{
+	structure_dirty = true;
+}
+
+void TransformHierarchy::invalidate(uint32_t index)
+{
+	dirty_flags[index] = 1;
+
+	dirty = true;
+}
+
+void TransformHierarchy::build()
+{
+	for (auto transform : transforms)
+	{
+		transform->hierarchy = nullptr;
+	}
+
+	transforms.clear();
+	parent_indices.clear();
+	level_offsets.clear();
+
+	if (root)
+	{
+		std::vector<Node *> level_nodes{root};
+		std::vector<Node *> next_level_nodes;
+
+		// Parent of every node of the current level, as the tree is walked breadth first
+		std::vector<uint32_t> level_parents{NO_PARENT};
+		std::vector<uint32_t> next_level_parents;
+
+		while (!level_nodes.empty())
+		{
+			level_offsets.push_back(transforms.size());
+
+			for (size_t i = 0; i < level_nodes.size(); ++i)
+			{
+				auto node  = level_nodes[i];
+				auto index = static_cast<uint32_t>(transforms.size());
+
+				auto &transform = node->get_transform();
+
+				transform.hierarchy       = this;
+				transform.hierarchy_index = index;
+
+				transforms.push_back(&transform);
+
+				// Children added to the scene root without setting their parent do not inherit its transform
+				auto parent_index = level_parents[i];
+				if (parent_index != NO_PARENT && node->get_parent() != &transforms[parent_index]->get_node())
+				{
+					parent_index = NO_PARENT;
+				}
+				parent_indices.push_back(parent_index);
+
+				for (auto child : node->get_children())
+				{
+					next_level_nodes.push_back(child);
+					next_level_parents.push_back(index);
+				}
+			}
+
+			std::swap(level_nodes, next_level_nodes);
+			std::swap(level_parents, next_level_parents);
+
+			next_level_nodes.clear();
+			next_level_parents.clear();
+		}
+	}
+
+	level_offsets.push_back(transforms.size());
+
+	local_matrices.assign(transforms.size(), glm::mat4(1.0f));
+	world_matrices.assign(transforms.size(), glm::mat4(1.0f));
+	dirty_flags.assign(transforms.size(), 1);
+
+	structure_dirty = false;
+	dirty           = true;
+}
+
+void TransformHierarchy::update()
+{
+	if (updated_count > 0)
+	{
+		std::fill(updated_flags.begin(), updated_flags.end(), 0);
+	}
+
+	updated_count = 0;
+	rebuilt       = structure_dirty;
+
+	if (structure_dirty)
+	{
+		build();
+	}
+
+	if (!dirty)
+	{
+		return;
+	}
+
+	auto &job_system = JobSystem::get();
+
+	// Parents are in previous levels, so every level only depends on the ones already updated
+	for (size_t level = 0; level + 1 < level_offsets.size(); ++level)
+	{
+		size_t first = level_offsets[level];
+		size_t last  = level_offsets[level + 1];
+
+		if (last - first < PARALLEL_LEVEL_SIZE)
+		{
+			updated_count += update_range(first, last);
+			continue;
+		}
+
+		std::vector<std::future<size_t>> range_futures;
+
+		size_t range_count = job_system.get_thread_count() + 1;
+		size_t range_size  = (last - first + range_count - 1) / range_count;
+
+		for (size_t range_first = first + range_size; range_first < last; range_first += range_size)
+		{
+			size_t range_last = std::min(range_first + range_size, last);
+
+			range_futures.push_back(job_system.push([this, range_first, range_last](size_t) {
+				return update_range(range_first, range_last);
+			},
+			                                        JobPriority::High));
+		}
+
+		updated_count += update_range(first, std::min(first + range_size, last));
+
+		for (auto &future : range_futures)
+		{
+			job_system.wait(future);
+			updated_count += future.get();
+		}
+	}
+
+	// The flags are kept for the users of the last update, the cleared ones are the next dirty flags
+	updated_flags.resize(dirty_flags.size());
+	std::swap(dirty_flags, updated_flags);
+	std::fill(dirty_flags.begin(), dirty_flags.end(), 0);
+
+	dirty = false;
+}
+
+size_t TransformHierarchy::update_range(size_t first, size_t last)
+{
+	size_t count = 0;
+
+	for (size_t i = first; i < last; ++i)
+	{
+		auto parent_index = parent_indices[i];
+
+		if (parent_index != NO_PARENT && dirty_flags[parent_index])
+		{
+			dirty_flags[i] = 1;
+		}
+
+		if (!dirty_flags[i])
+		{
+			continue;
+		}
+
+		local_matrices[i] = transforms[i]->get_matrix();
+
+		// Same composition as Transform::get_world_matrix
+		if (parent_index == NO_PARENT)
+		{
+			world_matrices[i] = local_matrices[i];
+		}
+		else
+		{
+			world_matrices[i] = local_matrices[i] * world_matrices[parent_index];
+		}
+
+		if (!deferred_publish)
+		{
+			transforms[i]->world_matrix        = world_matrices[i];
+			transforms[i]->update_world_matrix = false;
+		}
+
+		count++;
+	}
+
+	return count;
+}
+
+void TransformHierarchy::set_deferred_publish(bool enable)
+{
+	deferred_publish = enable;
+}
+
+bool TransformHierarchy::is_deferred_publish() const
+{
+	return deferred_publish;
+}
+
+void TransformHierarchy::publish()
+{
+	// Rebuilding changes the transforms the components point to, so it is only done while they are not in use
+	if (structure_dirty)
+	{
+		update();
+	}
+
+	for (size_t i = 0; i < transforms.size(); ++i)
+	{
+		if (rebuilt || (i < updated_flags.size() && updated_flags[i]))
+		{
+			transforms[i]->world_matrix        = world_matrices[i];
+			transforms[i]->update_world_matrix = false;
+		}
+	}
+}
+
+const std::vector<uint32_t> &TransformHierarchy::get_parent_indices() const
+{
+	return parent_indices;
+}
+
+const std::vector<glm::mat4> &TransformHierarchy::get_world_matrices() const
+{
+	return world_matrices;
+}
+
+size_t TransformHierarchy::get_updated_count() const
+{
+	return updated_count;
+}
+
+const std::vector<uint8_t> &TransformHierarchy::get_updated_flags() const
+{
+	return updated_flags;
+}
+
+bool TransformHierarchy::was_rebuilt() const
+{
+	return rebuilt;
+}
+}        // namespace sg
+}        // namespace vkb
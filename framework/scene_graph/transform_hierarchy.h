@@ -0,0 +1,163 @@
+/* Copyright (c) 2020, Arm Limited and Contributors
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 the "License";
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+#include "common/error.h"
+
+VKBP_DISABLE_WARNINGS()
+#include "common/glm_common.h"
+VKBP_ENABLE_WARNINGS()
+
+namespace vkb
+{
+namespace sg
+{
+class Node;
+class Transform;
+
+/**
+ * @brief The transforms of a node tree flattened in breadth-first order, so that parents come before their children
+ *
+ * Local and world matrices are stored in contiguous arrays and updated in a single pass over the
+ * hierarchy, recomputing only the transforms which changed and their descendants. The resulting
+ * world matrices are written back to the Transform components.
+ *
+ * With deferred publishing, the world matrices are only written back by publish(), so that
+ * a simulation thread can update the hierarchy while another thread reads the components.
+ */
+class TransformHierarchy
+{
+  public:
+	/// Parent index of the roots of the hierarchy
+	static constexpr uint32_t NO_PARENT = ~0U;
+
+	TransformHierarchy() = default;
+
+	TransformHierarchy(const TransformHierarchy &) = delete;
+
+	TransformHierarchy(TransformHierarchy &&) = delete;
+
+	~TransformHierarchy();
+
+	TransformHierarchy &operator=(const TransformHierarchy &) = delete;
+
+	TransformHierarchy &operator=(TransformHierarchy &&) = delete;
+
+	/**
+	 * @brief Sets the tree of nodes to flatten, it is rebuilt on the next update
+	 */
+	void set_root_node(Node &root);
+
+	/**
+	 * @brief Rebuilds the hierarchy on the next update, after nodes were added or reparented
+	 */
+	void invalidate_structure();
+
+	/**
+	 * @brief Marks a transform to update with its descendants
+	 * @param index Index of the transform in the hierarchy
+	 */
+	void invalidate(uint32_t index);
+
+	/**
+	 * @brief Updates the world matrices of the invalidated transforms and their descendants
+	 *        Levels with many transforms to update are split across the workers of the job system.
+	 */
+	void update();
+
+	/**
+	 * @brief Defers writing the world matrices to the Transform components until publish()
+	 * @note Must be called when no other thread uses the hierarchy
+	 */
+	void set_deferred_publish(bool enable);
+
+	bool is_deferred_publish() const;
+
+	/**
+	 * @brief Writes the world matrices of the last update to the Transform components.
+	 *        The structure is rebuilt first if it was invalidated, with every world matrix updated.
+	 * @note Must be called when no other thread uses the hierarchy or the Transform components
+	 */
+	void publish();
+
+	const std::vector<uint32_t> &get_parent_indices() const;
+
+	const std::vector<glm::mat4> &get_world_matrices() const;
+
+	/**
+	 * @return The number of world matrices computed by the last update
+	 */
+	size_t get_updated_count() const;
+
+	/**
+	 * @return Whether each transform was updated by the last update, all false if none was
+	 */
+	const std::vector<uint8_t> &get_updated_flags() const;
+
+	/**
+	 * @return Whether the hierarchy was rebuilt by the last update, changing the transform indices
+	 */
+	bool was_rebuilt() const;
+
+  private:
+	/**
+	 * @brief Flattens the tree of the root node, detaching the transforms of the previous one
+	 */
+	void build();
+
+	/**
+	 * @brief Updates the transforms of a range of a level
+	 * @return The number of world matrices computed
+	 */
+	size_t update_range(size_t first, size_t last);
+
+	Node *root{nullptr};
+
+	bool structure_dirty{false};
+
+	/// Whether any transform was invalidated since the last update
+	bool dirty{false};
+
+	std::vector<Transform *> transforms;
+
+	std::vector<uint32_t> parent_indices;
+
+	std::vector<glm::mat4> local_matrices;
+
+	std::vector<glm::mat4> world_matrices;
+
+	/// Whether each transform or one of its ancestors changed
+	std::vector<uint8_t> dirty_flags;
+
+	/// Dirty flags of the last update
+	std::vector<uint8_t> updated_flags;
+
+	bool rebuilt{false};
+
+	bool deferred_publish{false};
+
+	/// Index of the first transform of every depth in the tree, followed by the transform count
+	std::vector<size_t> level_offsets;
+
+	size_t updated_count{0};
+};
+}        // namespace sg
+}        // namespace vkb
@@ -21,6 +21,8 @@
 
 namespace vkb
 {
+constexpr uint32_t SemaphorePool::TRIM_PERIOD;
+
 SemaphorePool::SemaphorePool(Device &device) :
     device{device}
 {
@@ -67,7 +69,23 @@ VkSemaphore SemaphorePool::request_semaphore()
 
 void SemaphorePool::reset()
 {
+	high_water_mark = std::max(high_water_mark, active_semaphore_count);
+
 	active_semaphore_count = 0;
+
+	if (++reset_count >= TRIM_PERIOD)
+	{
+		// Semaphores beyond the high water mark were not requested over the whole period, so no wait is pending on them
+		for (size_t i = high_water_mark; i < semaphores.size(); ++i)
+		{
+			vkDestroySemaphore(device.get_handle(), semaphores[i], nullptr);
+		}
+
+		semaphores.resize(std::min<size_t>(semaphores.size(), high_water_mark));
+
+		high_water_mark = 0;
+		reset_count     = 0;
+	}
 }
 
 uint32_t SemaphorePool::get_active_semaphore_count() const
@@ -41,15 +41,30 @@ class SemaphorePool
 
 	VkSemaphore request_semaphore();
 
+	/**
+	 * @brief Makes the semaphores requested since the last reset available again
+	 *        Every TRIM_PERIOD resets, the semaphores beyond the most requested over the period are destroyed.
+	 */
 	void reset();
 
 	uint32_t get_active_semaphore_count() const;
 
+	/**
+	 * @brief Number of resets over which the peak number of requested semaphores is tracked
+	 */
+	static constexpr uint32_t TRIM_PERIOD{256};
+
   private:
 	Device &device;
 
 	std::vector<VkSemaphore> semaphores;
 
 	uint32_t active_semaphore_count{0};
+
+	/// Most semaphores requested between two resets since the last trim
+	uint32_t high_water_mark{0};
+
+	/// Resets since the last trim
+	uint32_t reset_count{0};
 };
 }        // namespace vkb
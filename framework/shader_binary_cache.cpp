@@ -0,0 +1,228 @@
+/* Copyright (c) 2020, Arm Limited and Contributors
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 the "License";
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "shader_binary_cache.h"
+
+#include <map>
+#include <sstream>
+
+#include "common/error.h"
+
+VKBP_DISABLE_WARNINGS()
+#include <glslang/Include/revision.h>
+#include <glslang/Public/ShaderLang.h>
+VKBP_ENABLE_WARNINGS()
+
+#include "common/helpers.h"
+#include "glsl_compiler.h"
+#include "common/logging.h"
+#include "platform/filesystem.h"
+
+namespace vkb
+{
+namespace
+{
+/// Must be increased whenever the file layout or the reflection of shader resources changes
+constexpr uint32_t SHADER_BINARY_CACHE_VERSION = 1;
+
+const std::string SHADER_BINARY_CACHE_FOLDER = "shader_cache/";
+
+inline std::string get_filename(size_t key)
+{
+	std::stringstream filename;
+	filename << SHADER_BINARY_CACHE_FOLDER << std::hex << key << ".bin";
+	return filename.str();
+}
+
+inline void write_resource(std::ostringstream &os, const ShaderResource &resource)
+{
+	write(os,
+	      resource.stages,
+	      resource.type,
+	      resource.mode,
+	      resource.set,
+	      resource.binding,
+	      resource.location,
+	      resource.input_attachment_index,
+	      resource.vec_size,
+	      resource.columns,
+	      resource.array_size,
+	      resource.offset,
+	      resource.size,
+	      resource.constant_id,
+	      resource.name);
+}
+
+inline void read_resource(std::istringstream &is, ShaderResource &resource)
+{
+	read(is,
+	     resource.stages,
+	     resource.type,
+	     resource.mode,
+	     resource.set,
+	     resource.binding,
+	     resource.location,
+	     resource.input_attachment_index,
+	     resource.vec_size,
+	     resource.columns,
+	     resource.array_size,
+	     resource.offset,
+	     resource.size,
+	     resource.constant_id,
+	     resource.name);
+}
+}        // namespace
+
+bool ShaderBinaryCache::enabled = true;
+
+std::mutex ShaderBinaryCache::file_mutex;
+
+void ShaderBinaryCache::set_enabled(bool enabled_)
+{
+	enabled = enabled_;
+}
+
+bool ShaderBinaryCache::is_enabled()
+{
+	return enabled;
+}
+
+size_t ShaderBinaryCache::get_key(VkShaderStageFlagBits stage, const ShaderSource &glsl_source, const std::string &entry_point, const ShaderVariant &shader_variant)
+{
+	size_t key = 0;
+
+	hash_combine(key, SHADER_BINARY_CACHE_VERSION);
+	hash_combine(key, static_cast<std::underlying_type<VkShaderStageFlagBits>::type>(stage));
+	hash_combine(key, glsl_source.get_id());
+	hash_combine(key, entry_point);
+	hash_combine(key, shader_variant.get_id());
+
+	// Runtime array sizes change the reflected resources, sort them for a stable key
+	std::map<std::string, size_t> runtime_array_sizes{shader_variant.get_runtime_array_sizes().begin(),
+	                                                  shader_variant.get_runtime_array_sizes().end()};
+
+	for (auto &runtime_array_size : runtime_array_sizes)
+	{
+		hash_combine(key, runtime_array_size.first);
+		hash_combine(key, runtime_array_size.second);
+	}
+
+	// A different compiler may generate different code
+	hash_combine(key, std::string{glslang::GetGlslVersionString()});
+#ifdef GLSLANG_PATCH_LEVEL
+	hash_combine(key, GLSLANG_PATCH_LEVEL);
+#endif
+
+	// The same source generates different code for another target environment
+	hash_combine(key, static_cast<int>(GLSLCompiler::get_target_language()));
+	hash_combine(key, static_cast<int>(GLSLCompiler::get_target_language_version()));
+
+	return key;
+}
+
+bool ShaderBinaryCache::load(size_t key, std::vector<uint32_t> &spirv, std::vector<ShaderResource> &resources)
+{
+	if (!enabled)
+	{
+		return false;
+	}
+
+	std::vector<uint8_t> data;
+
+	try
+	{
+		std::lock_guard<std::mutex> guard(file_mutex);
+
+		data = fs::read_temp(get_filename(key));
+	}
+	catch (const std::runtime_error &)
+	{
+		return false;
+	}
+
+	std::istringstream is{std::string{data.begin(), data.end()}};
+
+	uint32_t version{0};
+	size_t   stored_key{0};
+	read(is, version, stored_key);
+
+	if (version != SHADER_BINARY_CACHE_VERSION || stored_key != key)
+	{
+		return false;
+	}
+
+	std::vector<uint32_t> cached_spirv;
+	read(is, cached_spirv);
+
+	size_t resource_count{0};
+	read(is, resource_count);
+
+	std::vector<ShaderResource> cached_resources(resource_count);
+	for (auto &resource : cached_resources)
+	{
+		read_resource(is, resource);
+	}
+
+	if (!is || cached_spirv.empty())
+	{
+		LOGW("Discarding corrupted shader cache entry {}", get_filename(key));
+		return false;
+	}
+
+	spirv     = std::move(cached_spirv);
+	resources = std::move(cached_resources);
+
+	return true;
+}
+
+void ShaderBinaryCache::store(size_t key, const std::vector<uint32_t> &spirv, const std::vector<ShaderResource> &resources)
+{
+	if (!enabled)
+	{
+		return;
+	}
+
+	std::ostringstream os;
+
+	write(os, SHADER_BINARY_CACHE_VERSION, key, spirv, resources.size());
+
+	for (auto &resource : resources)
+	{
+		write_resource(os, resource);
+	}
+
+	std::string str = os.str();
+
+	try
+	{
+		std::lock_guard<std::mutex> guard(file_mutex);
+
+		auto temp_directory = fs::path::get(fs::path::Type::Temp);
+
+		if (!fs::is_directory(temp_directory + SHADER_BINARY_CACHE_FOLDER))
+		{
+			fs::create_path(temp_directory, SHADER_BINARY_CACHE_FOLDER);
+		}
+
+		fs::write_temp({str.begin(), str.end()}, get_filename(key));
+	}
+	catch (const std::runtime_error &ex)
+	{
+		LOGW("Failed to write shader cache entry. {}", ex.what());
+	}
+}
+}        // namespace vkb
@@ -0,0 +1,76 @@
+/* Copyright (c) 2020, Arm Limited and Contributors
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 the "License";
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "core/shader_module.h"
+
+namespace vkb
+{
+/**
+ * @brief On-disk cache of compiled shaders.
+ * Stores the SPIR-V generated by GLSLCompiler together with the resources reflected by
+ * SPIRVReflection, so that a ShaderModule built in a later run skips both glslang and spirv-cross.
+ * Entries are keyed on the shader stage, source, entry point, variant and glslang version,
+ * and are stored in a folder of the temporary directory.
+ */
+class ShaderBinaryCache
+{
+  public:
+	/**
+	 * @brief Enables or disables the cache for all shader modules created afterwards
+	 */
+	static void set_enabled(bool enabled);
+
+	static bool is_enabled();
+
+	/**
+	 * @brief Generates the key identifying a compiled shader
+	 */
+	static size_t get_key(VkShaderStageFlagBits stage,
+	                      const ShaderSource &  glsl_source,
+	                      const std::string &   entry_point,
+	                      const ShaderVariant & shader_variant);
+
+	/**
+	 * @brief Reads a compiled shader from the cache
+	 * @param key The key returned by get_key()
+	 * @param[out] spirv The SPIR-V code of the shader
+	 * @param[out] resources The reflected shader resources
+	 * @return True if the shader was found in the cache
+	 */
+	static bool load(size_t key, std::vector<uint32_t> &spirv, std::vector<ShaderResource> &resources);
+
+	/**
+	 * @brief Writes a compiled shader to the cache
+	 * @param key The key returned by get_key()
+	 * @param spirv The SPIR-V code of the shader
+	 * @param resources The reflected shader resources
+	 */
+	static void store(size_t key, const std::vector<uint32_t> &spirv, const std::vector<ShaderResource> &resources);
+
+  private:
+	static bool enabled;
+
+	/// Shader modules can be created from several threads
+	static std::mutex file_mutex;
+};
+}        // namespace vkb
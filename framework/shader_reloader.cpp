@@ -0,0 +1,147 @@
+/* Copyright (c) 2020, Arm Limited and Contributors
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 the "License";
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "shader_reloader.h"
+
+#include "common/logging.h"
+#include "core/device.h"
+#include "job_system.h"
+#include "platform/filesystem.h"
+#include "resource_cache.h"
+
+namespace vkb
+{
+constexpr double ShaderReloader::POLL_INTERVAL;
+
+ShaderReloader::ShaderReloader(ResourceCache &resource_cache) :
+    resource_cache{resource_cache}
+{
+	poll_timer.start();
+}
+
+ShaderReloader::~ShaderReloader()
+{
+	if (pending_reload.valid())
+	{
+		JobSystem::get().wait(pending_reload);
+	}
+}
+
+void ShaderReloader::update()
+{
+	if (pending_reload.valid())
+	{
+		if (pending_reload.wait_for(std::chrono::seconds(0)) != std::future_status::ready)
+		{
+			return;
+		}
+
+		auto reloads = pending_reload.get();
+
+		for (auto &reload : reloads)
+		{
+			reload.first->replace(std::move(*reload.second));
+		}
+
+		if (!reloads.empty())
+		{
+			LOGI("Reloaded {} shader modules", reloads.size());
+		}
+
+		poll_timer.lap();
+	}
+
+	if (poll_timer.elapsed() < POLL_INTERVAL)
+	{
+		return;
+	}
+
+	std::vector<ShaderInfo> shaders;
+
+	for (auto *shader_module : resource_cache.get_shader_modules())
+	{
+		// Modules compiled from memory can't be reloaded
+		if (!shader_module->get_filename().empty())
+		{
+			shaders.push_back({shader_module, shader_module->get_stage(), shader_module->get_filename(), shader_module->get_entry_point(), shader_module->get_variant()});
+		}
+	}
+
+	pending_reload = JobSystem::get().push([this, shaders](size_t) { return reload(shaders); }, JobPriority::Low);
+}
+
+std::vector<ShaderReloader::Reload> ShaderReloader::reload(const std::vector<ShaderInfo> &shaders)
+{
+	// Sources of the files which changed since they were last checked
+	std::unordered_map<std::string, std::unique_ptr<ShaderSource>> changed_sources;
+
+	for (auto &shader : shaders)
+	{
+		if (changed_sources.count(shader.filename))
+		{
+			continue;
+		}
+
+		int64_t modification_time = fs::get_shader_modification_time(shader.filename);
+
+		auto it = modification_times.find(shader.filename);
+
+		if (it == modification_times.end())
+		{
+			// The first check only records the time, the module was compiled from the current file
+			modification_times.emplace(shader.filename, modification_time);
+		}
+		else if (it->second != modification_time && modification_time != 0)
+		{
+			it->second = modification_time;
+
+			try
+			{
+				changed_sources[shader.filename] = std::make_unique<ShaderSource>(shader.filename);
+			}
+			catch (const std::exception &e)
+			{
+				LOGE("Failed to read shader \"{}\": {}", shader.filename, e.what());
+			}
+		}
+	}
+
+	std::vector<Reload> reloads;
+
+	for (auto &shader : shaders)
+	{
+		auto source_it = changed_sources.find(shader.filename);
+
+		if (source_it == changed_sources.end() || !source_it->second)
+		{
+			continue;
+		}
+
+		try
+		{
+			reloads.emplace_back(shader.shader_module, std::make_unique<ShaderModule>(resource_cache.get_device(), shader.stage, *source_it->second, shader.entry_point, shader.variant));
+		}
+		catch (const std::exception &)
+		{
+			// The compilation errors are logged by the module
+			LOGE("Keeping the previous version of shader \"{}\"", shader.filename);
+		}
+	}
+
+	return reloads;
+}
+}        // namespace vkb
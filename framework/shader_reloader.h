@@ -0,0 +1,95 @@
+/* Copyright (c) 2020, Arm Limited and Contributors
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 the "License";
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <future>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "core/shader_module.h"
+#include "timer.h"
+
+namespace vkb
+{
+class ResourceCache;
+
+/**
+ * @brief Watches the shader files of the modules in a resource cache, and recompiles the modules whose
+ *        file changed while the application runs
+ *
+ * Files are checked and modules recompiled by a low priority job. The recompiled modules replace the
+ * cached ones when update() is called between two frames, so that the pipeline layouts and pipelines
+ * requested with them from the next frame are rebuilt, while the ones of the other shaders are kept.
+ * A shader which fails to compile keeps its previous version.
+ */
+class ShaderReloader
+{
+  public:
+	/// Time between two checks of the shader files
+	static constexpr double POLL_INTERVAL{0.5};
+
+	ShaderReloader(ResourceCache &resource_cache);
+
+	~ShaderReloader();
+
+	ShaderReloader(const ShaderReloader &) = delete;
+
+	ShaderReloader &operator=(const ShaderReloader &) = delete;
+
+	/**
+	 * @brief Swaps in the modules recompiled since the last call, and starts a check of the files if it is time to.
+	 *        Must be called when no frame is being recorded.
+	 */
+	void update();
+
+  private:
+	/// A cached module and its recompiled version
+	using Reload = std::pair<ShaderModule *, std::unique_ptr<ShaderModule>>;
+
+	/// What the job needs to recompile a module, copied as the cached module is used meanwhile
+	struct ShaderInfo
+	{
+		ShaderModule *shader_module;
+
+		VkShaderStageFlagBits stage;
+
+		std::string filename;
+
+		std::string entry_point;
+
+		ShaderVariant variant;
+	};
+
+	/**
+	 * @brief Checks the files of the shaders and recompiles the ones which changed, runs in a job
+	 */
+	std::vector<Reload> reload(const std::vector<ShaderInfo> &shaders);
+
+	ResourceCache &resource_cache;
+
+	/// Last write time of each file seen so far, only accessed by the job while one is running
+	std::unordered_map<std::string, int64_t> modification_times;
+
+	std::future<std::vector<Reload>> pending_reload;
+
+	Timer poll_timer;
+};
+}        // namespace vkb
@@ -17,6 +17,8 @@
 
 #include "spirv_reflection.h"
 
+#include <map>
+
 namespace vkb
 {
 namespace
@@ -369,10 +371,66 @@ inline void read_shader_resource<ShaderResourceType::BufferStorage>(const spirv_
 		resources.push_back(shader_resource);
 	}
 }
+
+template <>
+inline void read_shader_resource<ShaderResourceType::AccelerationStructure>(const spirv_cross::Compiler &compiler,
+                                                                            VkShaderStageFlagBits        stage,
+                                                                            std::vector<ShaderResource> &resources,
+                                                                            const ShaderVariant &        variant)
+{
+	auto acceleration_structure_resources = compiler.get_shader_resources().acceleration_structures;
+
+	for (auto &resource : acceleration_structure_resources)
+	{
+		ShaderResource shader_resource{};
+		shader_resource.type   = ShaderResourceType::AccelerationStructure;
+		shader_resource.stages = stage;
+		shader_resource.name   = resource.name;
+
+		read_resource_array_size(compiler, resource, shader_resource, variant);
+		read_resource_decoration<spv::DecorationDescriptorSet>(compiler, resource, shader_resource, variant);
+		read_resource_decoration<spv::DecorationBinding>(compiler, resource, shader_resource, variant);
+
+		resources.push_back(shader_resource);
+	}
+}
 }        // namespace
 
+std::unordered_map<size_t, std::vector<ShaderResource>> SPIRVReflection::reflection_cache;
+
+std::mutex SPIRVReflection::reflection_cache_mutex;
+
 bool SPIRVReflection::reflect_shader_resources(VkShaderStageFlagBits stage, const std::vector<uint32_t> &spirv, std::vector<ShaderResource> &resources, const ShaderVariant &variant)
 {
+	size_t key = 0;
+
+	hash_combine(key, static_cast<std::underlying_type<VkShaderStageFlagBits>::type>(stage));
+	hash_combine(key, std::string{reinterpret_cast<const char *>(spirv.data()), spirv.size() * sizeof(uint32_t)});
+
+	// Runtime array sizes change the reflected sizes of storage buffers, sort them for a stable key
+	std::map<std::string, size_t> runtime_array_sizes{variant.get_runtime_array_sizes().begin(),
+	                                                  variant.get_runtime_array_sizes().end()};
+
+	for (auto &runtime_array_size : runtime_array_sizes)
+	{
+		hash_combine(key, runtime_array_size.first);
+		hash_combine(key, runtime_array_size.second);
+	}
+
+	{
+		std::lock_guard<std::mutex> guard(reflection_cache_mutex);
+
+		auto it = reflection_cache.find(key);
+
+		if (it != reflection_cache.end())
+		{
+			resources.insert(resources.end(), it->second.begin(), it->second.end());
+			return true;
+		}
+	}
+
+	std::vector<ShaderResource> reflected_resources;
+
 	spirv_cross::CompilerGLSL compiler{spirv};
 
 	auto opts                     = compiler.get_common_options();
@@ -380,13 +438,26 @@ bool SPIRVReflection::reflect_shader_resources(VkShaderStageFlagBits stage, cons
 
 	compiler.set_common_options(opts);
 
-	parse_shader_resources(compiler, stage, resources, variant);
-	parse_push_constants(compiler, stage, resources, variant);
-	parse_specialization_constants(compiler, stage, resources, variant);
+	parse_shader_resources(compiler, stage, reflected_resources, variant);
+	parse_push_constants(compiler, stage, reflected_resources, variant);
+	parse_specialization_constants(compiler, stage, reflected_resources, variant);
+
+	resources.insert(resources.end(), reflected_resources.begin(), reflected_resources.end());
+
+	std::lock_guard<std::mutex> guard(reflection_cache_mutex);
+
+	reflection_cache.emplace(key, std::move(reflected_resources));
 
 	return true;
 }
 
+void SPIRVReflection::clear_cache()
+{
+	std::lock_guard<std::mutex> guard(reflection_cache_mutex);
+
+	reflection_cache.clear();
+}
+
 void SPIRVReflection::parse_shader_resources(const spirv_cross::Compiler &compiler, VkShaderStageFlagBits stage, std::vector<ShaderResource> &resources, const ShaderVariant &variant)
 {
 	read_shader_resource<ShaderResourceType::Input>(compiler, stage, resources, variant);
@@ -398,6 +469,7 @@ void SPIRVReflection::parse_shader_resources(const spirv_cross::Compiler &compil
 	read_shader_resource<ShaderResourceType::Sampler>(compiler, stage, resources, variant);
 	read_shader_resource<ShaderResourceType::BufferUniform>(compiler, stage, resources, variant);
 	read_shader_resource<ShaderResourceType::BufferStorage>(compiler, stage, resources, variant);
+	read_shader_resource<ShaderResourceType::AccelerationStructure>(compiler, stage, resources, variant);
 }
 
 void SPIRVReflection::parse_push_constants(const spirv_cross::Compiler &compiler, VkShaderStageFlagBits stage, std::vector<ShaderResource> &resources, const ShaderVariant &variant)
@@ -17,6 +17,7 @@
 
 #pragma once
 
+#include <mutex>
 #include <string>
 #include <unordered_map>
 #include <vector>
@@ -33,10 +34,12 @@ VKBP_ENABLE_WARNINGS()
 namespace vkb
 {
 /// Generate a list of shader resource based on SPIRV reflection code, and provided ShaderVariant
+/// The resources reflected from a SPIRV code are kept for the whole run, so that the variants
+/// compiling to the same code, and the shader modules created again, skip spirv-cross.
 class SPIRVReflection
 {
   public:
-	/// @brief Reflects shader resources from SPIRV code
+	/// @brief Reflects shader resources from SPIRV code, or copies them from a previous reflection of the same code
 	/// @param stage The Vulkan shader stage flag
 	/// @param spirv The SPIRV code of shader
 	/// @param[out] resources The list of reflected shader resources
@@ -46,7 +49,16 @@ class SPIRVReflection
 	                              std::vector<ShaderResource> &resources,
 	                              const ShaderVariant &        variant);
 
+	/// @brief Releases the resources kept from previous reflections
+	static void clear_cache();
+
   private:
+	/// Reflected resources by hash of the stage, SPIRV code and runtime array sizes
+	static std::unordered_map<size_t, std::vector<ShaderResource>> reflection_cache;
+
+	/// Shader modules can be created from several threads
+	static std::mutex reflection_cache_mutex;
+
 	void parse_shader_resources(const spirv_cross::Compiler &compiler,
 	                            VkShaderStageFlagBits        stage,
 	                            std::vector<ShaderResource> &resources,
@@ -0,0 +1,46 @@
+/* Copyright (c) 2020, Arm Limited and Contributors
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 the "License";
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "animation_stats_provider.h"
+
+#include "scene_graph/animation_system.h"
+
+namespace vkb
+{
+AnimationStatsProvider::AnimationStatsProvider(std::set<StatIndex> &requested_stats) :
+    last_update_time{sg::AnimationSystem::get_total_update_time()}
+{
+	requested_stats.erase(StatIndex::animation_time);
+}
+
+bool AnimationStatsProvider::is_available(StatIndex index) const
+{
+	return index == StatIndex::animation_time;
+}
+
+StatsProvider::Counters AnimationStatsProvider::sample(float delta_time)
+{
+	double update_time = sg::AnimationSystem::get_total_update_time();
+
+	Counters res;
+	res[StatIndex::animation_time].result = update_time - last_update_time;
+
+	last_update_time = update_time;
+
+	return res;
+}
+}        // namespace vkb
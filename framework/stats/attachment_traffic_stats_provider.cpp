@@ -0,0 +1,59 @@
+/* Copyright (c) 2020, Arm Limited and Contributors
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 the "License";
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#include "attachment_traffic_stats_provider.h"
+
+#include "rendering/render_context.h"
+
+namespace vkb
+{
+AttachmentTrafficStatsProvider::AttachmentTrafficStatsProvider(std::set<StatIndex> &requested_stats, RenderContext &render_context) :
+    render_context{render_context}
+{
+	// The traffic is always estimated by command buffers
+	requested_stats.erase(StatIndex::estimated_ext_read_bytes);
+	requested_stats.erase(StatIndex::estimated_ext_write_bytes);
+}
+
+bool AttachmentTrafficStatsProvider::is_available(StatIndex index) const
+{
+	return index == StatIndex::estimated_ext_read_bytes ||
+	       index == StatIndex::estimated_ext_write_bytes;
+}
+
+StatsProvider::Counters AttachmentTrafficStatsProvider::sample(float delta_time)
+{
+	AttachmentTraffic traffic;
+
+	for (auto &render_frame : render_context.get_render_frames())
+	{
+		traffic += render_frame->get_attachment_traffic();
+	}
+
+	// Scaled by time as the measured bandwidth is
+	double scale = delta_time != 0.0f ? 1.0 / delta_time : 0.0;
+
+	Counters res;
+	res[StatIndex::estimated_ext_read_bytes].result  = static_cast<double>(traffic.read_bytes - last_traffic.read_bytes) * scale;
+	res[StatIndex::estimated_ext_write_bytes].result = static_cast<double>(traffic.write_bytes - last_traffic.write_bytes) * scale;
+
+	last_traffic = traffic;
+
+	return res;
+}
+}        // namespace vkb
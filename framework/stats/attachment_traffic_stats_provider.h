@@ -0,0 +1,66 @@
+/* Copyright (c) 2020, Arm Limited and Contributors
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 the "License";
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#pragma once
+
+#include "core/command_buffer.h"
+#include "stats_provider.h"
+
+namespace vkb
+{
+class RenderContext;
+
+/**
+ * @brief Reports the external memory bandwidth the attachments of the render passes of the render frames
+ *        are estimated to use
+ *
+ * Each render pass reads the attachments it loads and writes those it stores or resolves, over its render
+ * area and for each sample. Color attachments of Arm GPUs are assumed compressed by AFBC unless their usage
+ * prevents it. The stats have the unit of the measured gpu_ext_read_bytes and gpu_ext_write_bytes, to be
+ * compared with them, the difference being the traffic of other resources and the error of the estimate.
+ */
+class AttachmentTrafficStatsProvider : public StatsProvider
+{
+  public:
+	/**
+	 * @brief Constructs an AttachmentTrafficStatsProvider
+	 * @param requested_stats Set of stats to be collected. Supported stats will be removed from the set.
+	 * @param render_context The render context whose frames are observed
+	 */
+	AttachmentTrafficStatsProvider(std::set<StatIndex> &requested_stats, RenderContext &render_context);
+
+	/**
+	 * @brief Checks if this provider can supply the given enabled stat
+	 * @param index The stat index
+	 * @return True if the stat is available, false otherwise
+	 */
+	bool is_available(StatIndex index) const override;
+
+	/**
+	 * @brief Retrieve a new sample set
+	 * @param delta_time Time since last sample
+	 */
+	Counters sample(float delta_time) override;
+
+  private:
+	RenderContext &render_context;
+
+	/// Traffic estimated for all the frames at the previous sample
+	AttachmentTraffic last_traffic;
+};
+}        // namespace vkb
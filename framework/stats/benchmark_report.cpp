@@ -0,0 +1,155 @@
+/* Copyright (c) 2020, Arm Limited and Contributors
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 the "License";
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "stats/benchmark_report.h"
+
+#include <algorithm>
+#include <cmath>
+#include <numeric>
+
+#include "common/logging.h"
+#include "platform/filesystem.h"
+
+namespace vkb
+{
+namespace
+{
+/**
+ * @brief Percentile of sorted samples, interpolated between the closest ranks
+ */
+double percentile(const std::vector<double> &sorted_samples, double fraction)
+{
+	double rank  = fraction * (sorted_samples.size() - 1);
+	size_t lower = static_cast<size_t>(std::floor(rank));
+	size_t upper = std::min(lower + 1, sorted_samples.size() - 1);
+
+	return sorted_samples[lower] + (sorted_samples[upper] - sorted_samples[lower]) * (rank - lower);
+}
+}        // namespace
+
+void BenchmarkReport::set_group(const std::string &group_)
+{
+	group = group_;
+}
+
+const std::string &BenchmarkReport::get_group() const
+{
+	return group;
+}
+
+void BenchmarkReport::set_device(const std::string &device)
+{
+	this->device = device;
+}
+
+void BenchmarkReport::add_sample(const std::string &metric, double value)
+{
+	samples[group][metric].push_back(value);
+}
+
+BenchmarkReport::Summary BenchmarkReport::summarize(std::vector<double> values)
+{
+	Summary summary;
+
+	if (values.empty())
+	{
+		return summary;
+	}
+
+	std::sort(values.begin(), values.end());
+
+	summary.count = values.size();
+	summary.mean  = std::accumulate(values.begin(), values.end(), 0.0) / values.size();
+	summary.min   = values.front();
+	summary.max   = values.back();
+	summary.p50   = percentile(values, 0.50);
+	summary.p95   = percentile(values, 0.95);
+	summary.p99   = percentile(values, 0.99);
+
+	double variance = 0.0;
+
+	for (auto value : values)
+	{
+		variance += (value - summary.mean) * (value - summary.mean);
+	}
+
+	summary.stddev = std::sqrt(variance / values.size());
+
+	double first_quartile = percentile(values, 0.25);
+	double third_quartile = percentile(values, 0.75);
+	double fence          = 1.5 * (third_quartile - first_quartile);
+
+	summary.outliers = std::count_if(values.begin(), values.end(), [&](double value) {
+		return value < first_quartile - fence || value > third_quartile + fence;
+	});
+
+	return summary;
+}
+
+bool BenchmarkReport::write_json(const std::string &filename, uint32_t warmup_frames) const
+{
+	nlohmann::json groups = nlohmann::json::object();
+
+	for (auto &group_samples : samples)
+	{
+		nlohmann::json metrics = nlohmann::json::object();
+
+		for (auto &metric_samples : group_samples.second)
+		{
+			auto summary = summarize(metric_samples.second);
+
+			metrics[metric_samples.first] = {
+			    {"count", summary.count},
+			    {"mean", summary.mean},
+			    {"stddev", summary.stddev},
+			    {"min", summary.min},
+			    {"max", summary.max},
+			    {"p50", summary.p50},
+			    {"p95", summary.p95},
+			    {"p99", summary.p99},
+			    {"outliers", summary.outliers},
+			};
+		}
+
+		groups[group_samples.first] = metrics;
+	}
+
+	nlohmann::json data = {
+	    {"device", device},
+	    {"warmup_frames", warmup_frames},
+	    {"groups", groups},
+	};
+
+	return fs::write_json(data, filename);
+}
+
+void BenchmarkReport::log() const
+{
+	for (auto &group_samples : samples)
+	{
+		LOGI("Benchmark results of {}:", group_samples.first);
+
+		for (auto &metric_samples : group_samples.second)
+		{
+			auto summary = summarize(metric_samples.second);
+
+			LOGI("    {}: mean {:.3f}, stddev {:.3f}, p50 {:.3f}, p95 {:.3f}, p99 {:.3f}, {} outliers in {} samples",
+			     metric_samples.first, summary.mean, summary.stddev, summary.p50, summary.p95, summary.p99, summary.outliers, summary.count);
+		}
+	}
+}
+}        // namespace vkb
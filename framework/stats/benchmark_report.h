@@ -0,0 +1,102 @@
+/* Copyright (c) 2020, Arm Limited and Contributors
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 the "License";
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <map>
+#include <string>
+#include <vector>
+
+namespace vkb
+{
+/**
+ * @brief Collects per frame samples of benchmark metrics, and writes their statistics
+ *
+ * Samples are grouped, so that runs of several applications can share a report.
+ */
+class BenchmarkReport
+{
+  public:
+	/**
+	 * @brief Statistics of the samples of a metric
+	 */
+	struct Summary
+	{
+		size_t count{0};
+
+		double mean{0.0};
+
+		double stddev{0.0};
+
+		double min{0.0};
+
+		double max{0.0};
+
+		double p50{0.0};
+
+		double p95{0.0};
+
+		double p99{0.0};
+
+		/// Samples outside the Tukey fences, 1.5 interquartile ranges beyond the quartiles
+		size_t outliers{0};
+	};
+
+	/**
+	 * @brief Selects the group which following samples are added to
+	 */
+	void set_group(const std::string &group);
+
+	const std::string &get_group() const;
+
+	/**
+	 * @brief Sets the name of the device the benchmark runs on, recorded in the report
+	 */
+	void set_device(const std::string &device);
+
+	/**
+	 * @brief Adds a sample of a metric to the current group
+	 */
+	void add_sample(const std::string &metric, double value);
+
+	/**
+	 * @brief Computes the statistics of a set of samples
+	 */
+	static Summary summarize(std::vector<double> values);
+
+	/**
+	 * @brief Writes the statistics of every metric of every group to a JSON file
+	 * @param filename Name of the file, in the graphs directory
+	 * @param warmup_frames Frames run before the samples, recorded in the report
+	 * @return True if the file was written
+	 */
+	bool write_json(const std::string &filename, uint32_t warmup_frames) const;
+
+	/**
+	 * @brief Logs the statistics of every metric of every group
+	 */
+	void log() const;
+
+  private:
+	std::string group{};
+
+	std::string device{};
+
+	/// Samples of the metrics of each group
+	std::map<std::string, std::map<std::string, std::vector<double>>> samples;
+};
+}        // namespace vkb
@@ -0,0 +1,58 @@
+/* Copyright (c) 2020, Arm Limited and Contributors
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 the "License";
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "bind_stats_provider.h"
+
+#include "rendering/render_context.h"
+
+namespace vkb
+{
+BindStatsProvider::BindStatsProvider(std::set<StatIndex> &requested_stats, RenderContext &render_context) :
+    render_context{render_context}
+{
+	// The counters are always recorded by command buffers
+	requested_stats.erase(StatIndex::pipeline_binds);
+	requested_stats.erase(StatIndex::pipeline_binds_saved);
+	requested_stats.erase(StatIndex::descriptor_set_binds);
+}
+
+bool BindStatsProvider::is_available(StatIndex index) const
+{
+	return index == StatIndex::pipeline_binds ||
+	       index == StatIndex::pipeline_binds_saved ||
+	       index == StatIndex::descriptor_set_binds;
+}
+
+StatsProvider::Counters BindStatsProvider::sample(float delta_time)
+{
+	BindCounters counters;
+
+	for (auto &render_frame : render_context.get_render_frames())
+	{
+		counters += render_frame->get_bind_counters();
+	}
+
+	Counters res;
+	res[StatIndex::pipeline_binds].result       = static_cast<double>(counters.pipeline_binds - last_counters.pipeline_binds);
+	res[StatIndex::pipeline_binds_saved].result = static_cast<double>(counters.pipeline_binds_saved - last_counters.pipeline_binds_saved);
+	res[StatIndex::descriptor_set_binds].result = static_cast<double>(counters.descriptor_set_binds - last_counters.descriptor_set_binds);
+
+	last_counters = counters;
+
+	return res;
+}
+}        // namespace vkb
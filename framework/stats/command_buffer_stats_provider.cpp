@@ -0,0 +1,64 @@
+/* Copyright (c) 2020, Arm Limited and Contributors
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 the "License";
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "command_buffer_stats_provider.h"
+
+#include "rendering/render_context.h"
+
+namespace vkb
+{
+CommandBufferStatsProvider::CommandBufferStatsProvider(std::set<StatIndex> &requested_stats, RenderContext &render_context) :
+    render_context{render_context}
+{
+	// The counters are always kept by command pools
+	requested_stats.erase(StatIndex::command_buffer_allocations);
+	requested_stats.erase(StatIndex::command_buffer_reuses);
+	requested_stats.erase(StatIndex::command_buffer_resets);
+}
+
+bool CommandBufferStatsProvider::is_available(StatIndex index) const
+{
+	return index == StatIndex::command_buffer_allocations ||
+	       index == StatIndex::command_buffer_reuses ||
+	       index == StatIndex::command_buffer_resets;
+}
+
+StatsProvider::Counters CommandBufferStatsProvider::sample(float delta_time)
+{
+	CommandBufferCounters counters;
+
+	for (auto &render_frame : render_context.get_render_frames())
+	{
+		counters += render_frame->get_command_buffer_counters();
+	}
+
+	// Counters start over when frames are re-created
+	if (counters.allocated < last_counters.allocated || counters.reused < last_counters.reused || counters.reset < last_counters.reset)
+	{
+		last_counters = {};
+	}
+
+	Counters res;
+	res[StatIndex::command_buffer_allocations].result = static_cast<double>(counters.allocated - last_counters.allocated);
+	res[StatIndex::command_buffer_reuses].result      = static_cast<double>(counters.reused - last_counters.reused);
+	res[StatIndex::command_buffer_resets].result      = static_cast<double>(counters.reset - last_counters.reset);
+
+	last_counters = counters;
+
+	return res;
+}
+}        // namespace vkb
@@ -0,0 +1,149 @@
+/* Copyright (c) 2020, Arm Limited and Contributors
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 the "License";
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "stats/cpu_profiler.h"
+
+#include <limits>
+
+#include "common/helpers.h"
+#include "common/logging.h"
+#include "platform/filesystem.h"
+
+namespace vkb
+{
+constexpr size_t CpuProfiler::MAX_THREAD_EVENT_COUNT;
+
+CpuProfiler::Scope::Scope(const char *name) :
+    name{name},
+    begin{Timer::Clock::now()}
+{
+}
+
+CpuProfiler::Scope::~Scope()
+{
+	CpuProfiler::get().record(name, begin, Timer::Clock::now());
+}
+
+CpuProfiler &CpuProfiler::get()
+{
+	static CpuProfiler profiler;
+	return profiler;
+}
+
+CpuProfiler::CpuProfiler() :
+    start_time{Timer::Clock::now()}
+{
+}
+
+CpuProfiler::ThreadEvents &CpuProfiler::get_thread_events()
+{
+	// Threads register their buffer on their first scope, buffers live as long as the profiler
+	thread_local ThreadEvents *thread_events = nullptr;
+
+	if (!thread_events)
+	{
+		std::lock_guard<std::mutex> lock{threads_mutex};
+
+		threads.push_back(std::make_unique<ThreadEvents>());
+		thread_events            = threads.back().get();
+		thread_events->thread_id = to_u32(threads.size() - 1);
+	}
+
+	return *thread_events;
+}
+
+void CpuProfiler::record(const char *name, Timer::Clock::time_point begin, Timer::Clock::time_point end)
+{
+	auto &thread_events = get_thread_events();
+
+	std::lock_guard<std::mutex> lock{thread_events.mutex};
+
+	if (thread_events.events.size() < MAX_THREAD_EVENT_COUNT)
+	{
+		thread_events.events.push_back({name,
+		                                std::chrono::duration_cast<std::chrono::nanoseconds>(begin - start_time).count(),
+		                                std::chrono::duration_cast<std::chrono::nanoseconds>(end - begin).count()});
+	}
+}
+
+bool CpuProfiler::write_chrome_trace(const std::string &filename)
+{
+	return write_chrome_trace(filename, Timer::Clock::time_point::min(), Timer::Clock::time_point::max());
+}
+
+bool CpuProfiler::write_chrome_trace(const std::string &filename, Timer::Clock::time_point begin, Timer::Clock::time_point end)
+{
+	// Clamped so that the unbounded range does not overflow
+	int64_t range_begin = begin <= start_time ? std::numeric_limits<int64_t>::min() : std::chrono::duration_cast<std::chrono::nanoseconds>(begin - start_time).count();
+	int64_t range_end   = end == Timer::Clock::time_point::max() ? std::numeric_limits<int64_t>::max() : std::chrono::duration_cast<std::chrono::nanoseconds>(end - start_time).count();
+
+	nlohmann::json trace_events = nlohmann::json::array();
+
+	{
+		std::lock_guard<std::mutex> threads_lock{threads_mutex};
+
+		for (auto &thread_events : threads)
+		{
+			std::lock_guard<std::mutex> lock{thread_events->mutex};
+
+			// Complete events, with times in microseconds
+			for (auto &event : thread_events->events)
+			{
+				if (event.begin + event.duration < range_begin || event.begin > range_end)
+				{
+					continue;
+				}
+
+				trace_events.push_back({
+				    {"name", event.name},
+				    {"ph", "X"},
+				    {"ts", event.begin / 1000.0},
+				    {"dur", event.duration / 1000.0},
+				    {"pid", 0},
+				    {"tid", thread_events->thread_id},
+				});
+			}
+		}
+	}
+
+	nlohmann::json data = {
+	    {"traceEvents", trace_events},
+	    {"displayTimeUnit", "ms"},
+	};
+
+	bool written = fs::write_json(data, filename);
+
+	if (written)
+	{
+		LOGI("CPU trace written to {}", filename);
+	}
+
+	return written;
+}
+
+void CpuProfiler::clear()
+{
+	std::lock_guard<std::mutex> threads_lock{threads_mutex};
+
+	for (auto &thread_events : threads)
+	{
+		std::lock_guard<std::mutex> lock{thread_events->mutex};
+
+		thread_events->events.clear();
+	}
+}
+}        // namespace vkb
@@ -0,0 +1,143 @@
+/* Copyright (c) 2020, Arm Limited and Contributors
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 the "License";
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "timer.h"
+
+/**
+ * @brief Scoped CPU profiling, enabled by building with VKB_CPU_PROFILING
+ *        Without it the macros expand to nothing and cost nothing.
+ *        Names must be string literals, or outlive the profiler.
+ */
+#ifdef VKB_CPU_PROFILING
+#	define PROFILE_CONCATENATE_IMPL(a, b) a##b
+#	define PROFILE_CONCATENATE(a, b) PROFILE_CONCATENATE_IMPL(a, b)
+#	define PROFILE_SCOPE(name) ::vkb::CpuProfiler::Scope PROFILE_CONCATENATE(profile_scope_, __LINE__){name}
+#	define PROFILE_FUNCTION() PROFILE_SCOPE(__FUNCTION__)
+#else
+#	define PROFILE_SCOPE(name)
+#	define PROFILE_FUNCTION()
+#endif
+
+namespace vkb
+{
+/**
+ * @brief Records the time of named scopes on every thread, in a buffer per thread,
+ *        and writes them to a file in the Chrome trace event format, which
+ *        chrome://tracing and Perfetto can open
+ */
+class CpuProfiler
+{
+  public:
+	/**
+	 * @brief Records a scope of the calling thread during its lifetime
+	 */
+	class Scope
+	{
+	  public:
+		Scope(const char *name);
+
+		Scope(const Scope &) = delete;
+
+		Scope(Scope &&) = delete;
+
+		~Scope();
+
+		Scope &operator=(const Scope &) = delete;
+
+		Scope &operator=(Scope &&) = delete;
+
+	  private:
+		const char *name;
+
+		Timer::Clock::time_point begin;
+	};
+
+	static CpuProfiler &get();
+
+	/**
+	 * @brief Records a scope of the calling thread
+	 */
+	void record(const char *name, Timer::Clock::time_point begin, Timer::Clock::time_point end);
+
+	/**
+	 * @brief Writes the scopes recorded so far
+	 * @param filename Name of the file, in the graphs directory
+	 * @return True if the file was written
+	 */
+	bool write_chrome_trace(const std::string &filename);
+
+	/**
+	 * @brief Writes the scopes recorded so far which overlap a time range
+	 * @param filename Name of the file, in the graphs directory
+	 * @param begin Beginning of the range
+	 * @param end End of the range
+	 * @return True if the file was written
+	 */
+	bool write_chrome_trace(const std::string &filename, Timer::Clock::time_point begin, Timer::Clock::time_point end);
+
+	/**
+	 * @brief Discards the scopes recorded so far
+	 */
+	void clear();
+
+  private:
+	/**
+	 * @brief A scope recorded by a thread
+	 */
+	struct Event
+	{
+		const char *name;
+
+		/// Nanoseconds from the start of the profiler
+		int64_t begin;
+
+		int64_t duration;
+	};
+
+	/**
+	 * @brief Events of a thread, only locked by it when recording and by writes
+	 */
+	struct ThreadEvents
+	{
+		std::mutex mutex;
+
+		uint32_t thread_id;
+
+		std::vector<Event> events;
+	};
+
+	CpuProfiler();
+
+	ThreadEvents &get_thread_events();
+
+	/// Events a thread keeps at most, later ones are dropped
+	static constexpr size_t MAX_THREAD_EVENT_COUNT = 1 << 20;
+
+	Timer::Clock::time_point start_time;
+
+	std::mutex threads_mutex;
+
+	std::vector<std::unique_ptr<ThreadEvents>> threads;
+};
+}        // namespace vkb
@@ -0,0 +1,76 @@
+/* Copyright (c) 2020, Arm Limited and Contributors
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 the "License";
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "descriptor_pool_stats_provider.h"
+
+#include "rendering/render_context.h"
+
+namespace vkb
+{
+DescriptorPoolStatsProvider::DescriptorPoolStatsProvider(std::set<StatIndex> &requested_stats, RenderContext &render_context) :
+    render_context{render_context}
+{
+	requested_stats.erase(StatIndex::descriptor_pools);
+	requested_stats.erase(StatIndex::descriptor_pool_usage);
+	requested_stats.erase(StatIndex::descriptor_set_cache_hit_rate);
+}
+
+bool DescriptorPoolStatsProvider::is_available(StatIndex index) const
+{
+	return index == StatIndex::descriptor_pools ||
+	       index == StatIndex::descriptor_pool_usage ||
+	       index == StatIndex::descriptor_set_cache_hit_rate;
+}
+
+StatsProvider::Counters DescriptorPoolStatsProvider::sample(float delta_time)
+{
+	size_t   pool_count   = 0;
+	uint32_t set_capacity = 0;
+	uint32_t set_count    = 0;
+
+	DescriptorSetCounters counters;
+
+	for (auto &render_frame : render_context.get_render_frames())
+	{
+		pool_count += render_frame->get_descriptor_pool_count();
+		set_capacity += render_frame->get_descriptor_set_capacity();
+		set_count += render_frame->get_descriptor_set_count();
+		counters += render_frame->get_descriptor_set_counters();
+	}
+
+	// Counters start over when frames are re-created
+	if (counters.requested < last_counters.requested || counters.created < last_counters.created)
+	{
+		last_counters = {};
+	}
+
+	auto requested = counters.requested - last_counters.requested;
+	auto created   = counters.created - last_counters.created;
+
+	last_counters = counters;
+
+	Counters res;
+	res[StatIndex::descriptor_pools].result = static_cast<double>(pool_count);
+
+	// The unused part of the pools is their fragmentation, sets are only released by resetting whole pools
+	res[StatIndex::descriptor_pool_usage].result = set_capacity > 0 ? static_cast<double>(set_count) / set_capacity : 0.0;
+
+	res[StatIndex::descriptor_set_cache_hit_rate].result = requested > 0 ? static_cast<double>(requested - created) / requested : 0.0;
+
+	return res;
+}
+}        // namespace vkb
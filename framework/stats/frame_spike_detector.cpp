@@ -0,0 +1,240 @@
+/* Copyright (c) 2020, Arm Limited and Contributors
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 the "License";
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "stats/frame_spike_detector.h"
+
+#include <algorithm>
+
+#include "common/logging.h"
+#include "core/device.h"
+#include "platform/filesystem.h"
+#include "rendering/render_context.h"
+#include "resource_cache.h"
+#include "stats/cpu_profiler.h"
+
+namespace vkb
+{
+namespace
+{
+/**
+ * @return The difference between a cumulative counter and its previous value, 0 if it was reset
+ */
+uint64_t counter_delta(uint64_t value, uint64_t last_value)
+{
+	return value >= last_value ? value - last_value : value;
+}
+}        // namespace
+
+FrameSpikeDetector::FrameSpikeDetector(RenderContext &render_context, const std::string &prefix, size_t history_size,
+                                       float threshold, float min_spike, size_t max_capture_count) :
+    render_context{render_context},
+    prefix{prefix},
+    history_size{std::max<size_t>(history_size, 2)},
+    threshold{threshold},
+    min_spike{min_spike},
+    max_capture_count{max_capture_count},
+    last_frame_end{Timer::Clock::now()}
+{
+	frames.reserve(this->history_size);
+	sorted_frame_times.reserve(this->history_size);
+}
+
+void FrameSpikeDetector::end_frame(float delta_time, const GpuProfiler *gpu_profiler)
+{
+	// Once the history is full, the oldest frame is overwritten and its vectors reused
+	if (frames.size() < history_size)
+	{
+		frames.emplace_back();
+	}
+
+	Frame &frame = frames[next_frame];
+	next_frame   = (next_frame + 1) % history_size;
+
+	frame.index      = frame_index++;
+	frame.begin      = last_frame_end;
+	frame.end        = Timer::Clock::now();
+	frame.frame_time = delta_time * 1000.0f;
+	last_frame_end   = frame.end;
+
+	frame.gpu_time = 0.0f;
+	frame.gpu_timings.clear();
+
+	if (gpu_profiler)
+	{
+		for (auto &timing : gpu_profiler->get_timings())
+		{
+			if (timing.depth == 0 && timing.name == "Frame")
+			{
+				frame.gpu_time = timing.last_time;
+			}
+
+			frame.gpu_timings.push_back(timing);
+		}
+	}
+
+	auto stats = render_context.get_device().get_resource_cache().get_stats();
+
+	uint64_t pipeline_misses = stats.graphics_pipelines.misses + stats.compute_pipelines.misses;
+
+	frame.shader_modules_built   = counter_delta(stats.shader_modules.misses, last_shader_module_misses);
+	frame.pipelines_built        = counter_delta(pipeline_misses, last_pipeline_misses);
+	frame.descriptor_pools_built = counter_delta(stats.descriptor_pools.misses, last_descriptor_pool_misses);
+	frame.descriptor_sets_built  = counter_delta(stats.descriptor_sets.misses, last_descriptor_set_misses);
+
+	last_shader_module_misses   = stats.shader_modules.misses;
+	last_pipeline_misses        = pipeline_misses;
+	last_descriptor_pool_misses = stats.descriptor_pools.misses;
+	last_descriptor_set_misses  = stats.descriptor_sets.misses;
+
+	size_t   descriptor_pool_count = 0;
+	uint64_t buffer_block_requests = 0;
+
+	for (auto &render_frame : render_context.get_render_frames())
+	{
+		descriptor_pool_count += render_frame->get_descriptor_pool_count();
+		buffer_block_requests += render_frame->get_buffer_block_request_count();
+	}
+
+	frame.descriptor_pool_count = descriptor_pool_count;
+	frame.buffer_block_requests = counter_delta(buffer_block_requests, last_buffer_block_requests);
+	last_buffer_block_requests  = buffer_block_requests;
+
+	VmaBudget budgets[VK_MAX_MEMORY_HEAPS];
+	vmaGetBudget(render_context.get_device().get_memory_allocator(), budgets);
+
+	const VkPhysicalDeviceMemoryProperties *memory_properties = nullptr;
+	vmaGetMemoryProperties(render_context.get_device().get_memory_allocator(), &memory_properties);
+
+	frame.memory_usage = 0;
+	for (uint32_t heap_index = 0; heap_index < memory_properties->memoryHeapCount; ++heap_index)
+	{
+		frame.memory_usage += budgets[heap_index].usage;
+	}
+
+	if (cooldown > 0)
+	{
+		--cooldown;
+		return;
+	}
+
+	if (capture_count >= max_capture_count)
+	{
+		return;
+	}
+
+	float median = get_median_frame_time();
+
+	if (median > 0.0f && frame.frame_time > median * threshold && frame.frame_time - median > min_spike)
+	{
+		write_capture(frame, median);
+
+		// Wait for the captured frames to leave the history before capturing again
+		cooldown = history_size;
+	}
+}
+
+size_t FrameSpikeDetector::get_capture_count() const
+{
+	return capture_count;
+}
+
+float FrameSpikeDetector::get_median_frame_time()
+{
+	// The median is only meaningful over a full history, and excludes the frame just recorded
+	if (frames.size() < history_size)
+	{
+		return 0.0f;
+	}
+
+	sorted_frame_times.clear();
+
+	size_t last_frame = (next_frame + history_size - 1) % history_size;
+	for (size_t i = 0; i < frames.size(); ++i)
+	{
+		if (i != last_frame)
+		{
+			sorted_frame_times.push_back(frames[i].frame_time);
+		}
+	}
+
+	auto middle = sorted_frame_times.begin() + sorted_frame_times.size() / 2;
+	std::nth_element(sorted_frame_times.begin(), middle, sorted_frame_times.end());
+
+	return *middle;
+}
+
+void FrameSpikeDetector::write_capture(const Frame &spike, float median)
+{
+	nlohmann::json frames_data = nlohmann::json::array();
+
+	// From the oldest frame to the spike
+	for (size_t i = 0; i < frames.size(); ++i)
+	{
+		const Frame &frame = frames[(next_frame + i) % frames.size()];
+
+		nlohmann::json gpu_scopes = nlohmann::json::array();
+		for (auto &timing : frame.gpu_timings)
+		{
+			gpu_scopes.push_back({
+			    {"name", timing.name},
+			    {"depth", timing.depth},
+			    {"ms", timing.last_time},
+			});
+		}
+
+		frames_data.push_back({
+		    {"frame", frame.index},
+		    {"frame_ms", frame.frame_time},
+		    {"gpu_frame_ms", frame.gpu_time},
+		    {"gpu_scopes", gpu_scopes},
+		    {"shader_modules_built", frame.shader_modules_built},
+		    {"pipelines_built", frame.pipelines_built},
+		    {"descriptor_pools_built", frame.descriptor_pools_built},
+		    {"descriptor_sets_built", frame.descriptor_sets_built},
+		    {"descriptor_pools", frame.descriptor_pool_count},
+		    {"buffer_block_requests", frame.buffer_block_requests},
+		    {"memory_usage", frame.memory_usage},
+		});
+	}
+
+	nlohmann::json data = {
+	    {"spike_frame", spike.index},
+	    {"spike_ms", spike.frame_time},
+	    {"median_ms", median},
+	    {"threshold", threshold},
+	    {"gpu_latency_frames", render_context.get_render_frames().size()},
+	    {"frames", frames_data},
+	};
+
+	std::string name = prefix + "_spike_" + std::to_string(spike.index);
+
+	if (!fs::write_json(data, name + ".json"))
+	{
+		LOGE("Failed to write frame spike capture {}", name);
+		return;
+	}
+
+#ifdef VKB_CPU_PROFILING
+	const Frame &oldest = frames[next_frame % frames.size()];
+	CpuProfiler::get().write_chrome_trace(name + "_cpu_trace.json", oldest.begin, spike.end);
+#endif
+
+	++capture_count;
+
+	LOGW("Frame {} took {:.2f} ms against a median of {:.2f} ms, wrote {}", spike.index, spike.frame_time, median, name);
+}
+}        // namespace vkb
@@ -0,0 +1,168 @@
+/* Copyright (c) 2020, Arm Limited and Contributors
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 the "License";
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "stats/gpu_profiler.h"
+#include "timer.h"
+
+namespace vkb
+{
+class RenderContext;
+
+/**
+ * @brief Detects frames much longer than the recent ones, and writes what happened in the frames before them
+ *
+ * Each frame is compared to the median time of the frames before it. When it exceeds the median by the
+ * threshold ratio and by a minimum number of milliseconds, the recorded history is written to a JSON file
+ * in the graphs directory: the time of each frame, the GPU scopes of the GPU profiler if there is one,
+ * the resource cache misses (shader modules, pipelines, descriptor pools and sets built), the descriptor
+ * pools of the render frames, buffer block requests and device memory usage. Builds with
+ * VKB_CPU_PROFILING also write the CPU scopes of the frames as a Chrome trace.
+ *
+ * GPU timings are read back frames after they were recorded, so those of a frame lag its CPU time by the
+ * number of frames in flight.
+ */
+class FrameSpikeDetector
+{
+  public:
+	/**
+	 * @brief What a frame did, as recorded when it ended
+	 */
+	struct Frame
+	{
+		uint64_t index{0};
+
+		Timer::Clock::time_point begin;
+
+		Timer::Clock::time_point end;
+
+		/// Milliseconds between the updates of the frame and of the previous one
+		float frame_time{0.0f};
+
+		/// Milliseconds of the "Frame" scope of the last frame measured by the GPU profiler
+		float gpu_time{0.0f};
+
+		/// Scopes of the last frame measured by the GPU profiler
+		std::vector<GpuProfiler::Timing> gpu_timings;
+
+		/// Resource cache misses during the frame, each of which built an object
+		uint64_t shader_modules_built{0};
+
+		uint64_t pipelines_built{0};
+
+		uint64_t descriptor_pools_built{0};
+
+		uint64_t descriptor_sets_built{0};
+
+		/// Descriptor pools of the render frames at the end of the frame
+		size_t descriptor_pool_count{0};
+
+		/// Buffer blocks requested from the buffer pools of the render frames during the frame
+		uint64_t buffer_block_requests{0};
+
+		/// Bytes of device memory used at the end of the frame
+		uint64_t memory_usage{0};
+	};
+
+	/**
+	 * @param render_context Context of the frames
+	 * @param prefix Prefix of the files written, followed by the index of the frame of the spike
+	 * @param history_size Number of frames written by a capture, and of frames the median is computed over
+	 * @param threshold Ratio of a spike to the median frame time
+	 * @param min_spike Milliseconds the spike exceeds the median time by at least
+	 * @param max_capture_count Number of captures written at most
+	 */
+	FrameSpikeDetector(RenderContext &render_context, const std::string &prefix, size_t history_size = 120,
+	                   float threshold = 2.0f, float min_spike = 4.0f, size_t max_capture_count = 8);
+
+	FrameSpikeDetector(const FrameSpikeDetector &) = delete;
+
+	FrameSpikeDetector(FrameSpikeDetector &&) = delete;
+
+	FrameSpikeDetector &operator=(const FrameSpikeDetector &) = delete;
+
+	FrameSpikeDetector &operator=(FrameSpikeDetector &&) = delete;
+
+	/**
+	 * @brief Records the frame which just ended, and writes a capture if it is a spike
+	 * @param delta_time Seconds since the previous frame
+	 * @param gpu_profiler Profiler of the GPU time of the frames, can be null
+	 */
+	void end_frame(float delta_time, const GpuProfiler *gpu_profiler);
+
+	/**
+	 * @return The number of captures written
+	 */
+	size_t get_capture_count() const;
+
+  private:
+	/**
+	 * @return The median frame time of the recorded frames, 0 if they are too few
+	 */
+	float get_median_frame_time();
+
+	/**
+	 * @brief Writes the recorded frames, ending with the spike
+	 */
+	void write_capture(const Frame &spike, float median);
+
+	RenderContext &render_context;
+
+	std::string prefix;
+
+	size_t history_size;
+
+	float threshold;
+
+	float min_spike;
+
+	size_t max_capture_count;
+
+	size_t capture_count{0};
+
+	/// Frames recorded, used as a ring whose oldest frame is at next_frame once it is full
+	std::vector<Frame> frames;
+
+	size_t next_frame{0};
+
+	uint64_t frame_index{0};
+
+	/// Frames to record after a capture before detecting spikes again, so that a stall is captured once
+	size_t cooldown{0};
+
+	Timer::Clock::time_point last_frame_end;
+
+	/// Cumulative counters at the end of the previous frame, the frames record their differences
+	uint64_t last_shader_module_misses{0};
+
+	uint64_t last_pipeline_misses{0};
+
+	uint64_t last_descriptor_pool_misses{0};
+
+	uint64_t last_descriptor_set_misses{0};
+
+	uint64_t last_buffer_block_requests{0};
+
+	/// Frame times sorted to find their median, kept to reuse its memory
+	std::vector<float> sorted_frame_times;
+};
+}        // namespace vkb
@@ -0,0 +1,317 @@
+/* Copyright (c) 2020, Arm Limited and Contributors
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 the "License";
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "stats/gpu_profiler.h"
+
+#include <algorithm>
+
+#include "core/command_buffer.h"
+#include "platform/filesystem.h"
+#include "rendering/render_context.h"
+
+namespace vkb
+{
+namespace
+{
+/// Weight of the latest frame in the smoothed timings
+constexpr float TIMING_SMOOTHING = 0.1f;
+}        // namespace
+
+GpuProfiler::Scope::Scope(GpuProfiler *profiler, CommandBuffer &command_buffer, const std::string &name) :
+    profiler{profiler},
+    command_buffer{command_buffer}
+{
+	if (profiler)
+	{
+		profiler->begin_scope(command_buffer, name);
+	}
+}
+
+GpuProfiler::Scope::~Scope()
+{
+	if (profiler)
+	{
+		profiler->end_scope(command_buffer);
+	}
+}
+
+GpuProfiler::GpuProfiler(RenderContext &render_context, uint32_t max_scope_count) :
+    render_context{render_context},
+    max_scope_count{max_scope_count}
+{
+	if (!is_supported(render_context))
+	{
+		throw std::runtime_error{"Timestamps are not supported, GPU profiling is not available"};
+	}
+
+	auto &device = render_context.get_device();
+
+	timestamp_period = device.get_gpu().get_properties().limits.timestampPeriod;
+
+	// Timestamps of both queues are compared on the timeline
+	uint32_t valid_bits = std::min(device.get_queue_by_role(QueueRole::Graphics).get_properties().timestampValidBits,
+	                               render_context.get_compute_queue().get_properties().timestampValidBits);
+
+	if (valid_bits < 64)
+	{
+		timestamp_mask = (1ULL << valid_bits) - 1;
+	}
+}
+
+bool GpuProfiler::is_supported(RenderContext &render_context)
+{
+	return render_context.get_device().get_gpu().get_properties().limits.timestampComputeAndGraphics;
+}
+
+void GpuProfiler::create_query_pool()
+{
+	auto frame_count = to_u32(render_context.get_render_frames().size());
+
+	VkQueryPoolCreateInfo query_pool_info{VK_STRUCTURE_TYPE_QUERY_POOL_CREATE_INFO};
+	query_pool_info.queryType  = VK_QUERY_TYPE_TIMESTAMP;
+	query_pool_info.queryCount = frame_count * max_scope_count * 4;
+
+	query_pool = std::make_unique<QueryPool>(render_context.get_device(), query_pool_info);
+
+	frame_scopes.clear();
+	frame_scopes.resize(frame_count);
+
+	frame_scope_counts.clear();
+	frame_scope_counts.resize(frame_count);
+}
+
+uint32_t GpuProfiler::get_first_query(uint32_t frame, bool async_compute) const
+{
+	return (frame * 2 + (async_compute ? 1 : 0)) * max_scope_count * 2;
+}
+
+void GpuProfiler::begin_frame(CommandBuffer &command_buffer)
+{
+	if (!query_pool || frame_scopes.size() != render_context.get_render_frames().size())
+	{
+		create_query_pool();
+	}
+
+	frame_index = render_context.get_active_frame_index();
+
+	read_results();
+
+	frame_scopes[frame_index].clear();
+	frame_scope_counts[frame_index] = {};
+	open_scopes.clear();
+
+	command_buffer.reset_query_pool(*query_pool, get_first_query(frame_index, false), max_scope_count * 2);
+
+	frame_active          = true;
+	compute_queries_reset = false;
+}
+
+void GpuProfiler::begin_scope(CommandBuffer &command_buffer, const std::string &name)
+{
+	if (!frame_active || frame_index != render_context.get_active_frame_index())
+	{
+		// The frame did not reset its queries
+		open_scopes.push_back(~size_t{0});
+		return;
+	}
+
+	auto &scopes = frame_scopes[frame_index];
+
+	// Async compute command buffers run on another queue family than graphics ones
+	bool async_compute = render_context.has_async_compute() &&
+	                     command_buffer.get_queue_family_index() == render_context.get_compute_queue().get_family_index();
+
+	auto &scope_count = frame_scope_counts[frame_index][async_compute ? 1 : 0];
+
+	if (scope_count >= max_scope_count)
+	{
+		open_scopes.push_back(~size_t{0});
+		return;
+	}
+
+	// The compute submissions run before the graphics one resetting the frame queries
+	if (async_compute && !compute_queries_reset)
+	{
+		command_buffer.reset_query_pool(*query_pool, get_first_query(frame_index, true), max_scope_count * 2);
+		compute_queries_reset = true;
+	}
+
+	uint32_t begin_query = get_first_query(frame_index, async_compute) + scope_count * 2;
+	scope_count++;
+
+	command_buffer.write_timestamp(VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, *query_pool, begin_query);
+
+	open_scopes.push_back(scopes.size());
+	scopes.push_back({name, to_u32(open_scopes.size() - 1), begin_query + 1, async_compute});
+}
+
+void GpuProfiler::end_scope(CommandBuffer &command_buffer)
+{
+	assert(!open_scopes.empty() && "No GPU profiler scope to end");
+
+	size_t scope_index = open_scopes.back();
+	open_scopes.pop_back();
+
+	if (scope_index != ~size_t{0} && frame_index == render_context.get_active_frame_index())
+	{
+		command_buffer.write_timestamp(VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, *query_pool, frame_scopes[frame_index][scope_index].end_query);
+	}
+}
+
+void GpuProfiler::read_results()
+{
+	auto &scopes = frame_scopes[frame_index];
+
+	if (scopes.empty())
+	{
+		return;
+	}
+
+	// Timestamps of the graphics range, followed by the ones of the compute range
+	auto &scope_counts = frame_scope_counts[frame_index];
+
+	std::vector<uint64_t> timestamps((scope_counts[0] + scope_counts[1]) * 2);
+
+	for (uint32_t range = 0; range < 2; ++range)
+	{
+		if (scope_counts[range] == 0)
+		{
+			continue;
+		}
+
+		uint64_t *range_timestamps = timestamps.data() + (range == 0 ? 0 : scope_counts[0] * 2);
+
+		// The frame waited for its submission, results which are not available mean that its scopes were not submitted
+		VkResult result = query_pool->get_results(get_first_query(frame_index, range == 1), scope_counts[range] * 2,
+		                                          scope_counts[range] * 2 * sizeof(uint64_t), range_timestamps, sizeof(uint64_t),
+		                                          VK_QUERY_RESULT_64_BIT);
+		if (result != VK_SUCCESS)
+		{
+			return;
+		}
+	}
+
+	// Index of the begin timestamp of a scope, the end one follows it
+	auto get_timestamp_index = [&](const ScopeRecord &scope) -> size_t {
+		uint32_t begin_query = scope.end_query - 1;
+		return scope.async_compute ? scope_counts[0] * 2 + begin_query - get_first_query(frame_index, true) :
+		                             begin_query - get_first_query(frame_index, false);
+	};
+
+	uint64_t frame_begin = timestamps[get_timestamp_index(scopes[0])];
+
+	for (auto &scope : scopes)
+	{
+		uint64_t begin = timestamps[get_timestamp_index(scope)];
+
+		// Timestamps may wrap around, a scope began earlier if it is more than half the range behind
+		if (((begin - frame_begin) & timestamp_mask) > (timestamp_mask >> 1))
+		{
+			frame_begin = begin;
+		}
+	}
+
+	// Scopes with the same name are measured together
+	std::vector<Timing>                     frame_timings;
+	std::unordered_map<std::string, size_t> timing_indices;
+	uint64_t                                frame_ticks{0};
+
+	for (auto &scope : scopes)
+	{
+		size_t   index  = get_timestamp_index(scope);
+		uint64_t offset = (timestamps[index] - frame_begin) & timestamp_mask;
+		uint64_t ticks  = (timestamps[index + 1] - timestamps[index]) & timestamp_mask;
+		float    time   = static_cast<float>(ticks) * timestamp_period * 0.000001f;
+		float    start  = static_cast<float>(offset) * timestamp_period * 0.000001f;
+
+		frame_ticks = std::max(frame_ticks, offset + ticks);
+
+		auto it = timing_indices.find(scope.name);
+
+		if (it == timing_indices.end())
+		{
+			timing_indices.emplace(scope.name, frame_timings.size());
+			frame_timings.push_back({scope.name, scope.depth, time, time, start, scope.async_compute});
+		}
+		else
+		{
+			frame_timings[it->second].time += time;
+			frame_timings[it->second].last_time += time;
+		}
+	}
+
+	frame_span = static_cast<float>(frame_ticks) * timestamp_period * 0.000001f;
+
+	for (auto &timing : frame_timings)
+	{
+		auto it = statistics.find(timing.name);
+
+		if (it == statistics.end())
+		{
+			it = statistics.emplace(timing.name, ScopeStatistics{}).first;
+			statistics_order.push_back(timing.name);
+
+			it->second.smoothed_time = timing.time;
+		}
+
+		auto &scope_statistics = it->second;
+
+		scope_statistics.smoothed_time += (timing.time - scope_statistics.smoothed_time) * TIMING_SMOOTHING;
+		scope_statistics.total_time += timing.time;
+		scope_statistics.max_time = std::max(scope_statistics.max_time, timing.time);
+		scope_statistics.count++;
+
+		timing.time = scope_statistics.smoothed_time;
+	}
+
+	timings = std::move(frame_timings);
+}
+
+const std::vector<GpuProfiler::Timing> &GpuProfiler::get_timings() const
+{
+	return timings;
+}
+
+float GpuProfiler::get_frame_span() const
+{
+	return frame_span;
+}
+
+bool GpuProfiler::write_json(const std::string &filename) const
+{
+	nlohmann::json scopes = nlohmann::json::array();
+
+	for (auto &name : statistics_order)
+	{
+		auto &scope_statistics = statistics.at(name);
+
+		scopes.push_back({
+		    {"name", name},
+		    {"frames", scope_statistics.count},
+		    {"average_ms", scope_statistics.total_time / scope_statistics.count},
+		    {"max_ms", scope_statistics.max_time},
+		});
+	}
+
+	nlohmann::json data = {
+	    {"timestamp_period", timestamp_period},
+	    {"scopes", scopes},
+	};
+
+	return fs::write_json(data, filename);
+}
+}        // namespace vkb
@@ -0,0 +1,233 @@
+/* Copyright (c) 2020, Arm Limited and Contributors
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 the "License";
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "common/helpers.h"
+#include "common/vk_common.h"
+#include "core/query_pool.h"
+
+namespace vkb
+{
+class CommandBuffer;
+class RenderContext;
+
+/**
+ * @brief Measures the GPU time of named scopes of command buffers with timestamp queries
+ *
+ * Each render frame owns a range of a timestamp query pool, used as a ring. The results of a frame
+ * are read when it begins again, after it waited for its previous submission, so reading them never
+ * stalls, and timings are a number of frames late.
+ *
+ * Scopes recorded to command buffers of the async compute queue use a second range of the frame, reset
+ * by the first of them, as compute submissions of a frame run before its graphics ones. Timings also keep
+ * the start of scopes in the frame, which shows how compute and graphics work overlap.
+ */
+class GpuProfiler
+{
+  public:
+	/**
+	 * @brief Timing of a scope, from its last measured frame
+	 */
+	struct Timing
+	{
+		std::string name;
+
+		/// Number of scopes the scope is nested in
+		uint32_t depth;
+
+		/// Milliseconds, smoothed over recent frames
+		float time;
+
+		/// Milliseconds of the last measured frame
+		float last_time;
+
+		/// Milliseconds from the first timestamp of the last measured frame to the beginning of the scope
+		float start;
+
+		/// Whether the scope ran on the async compute queue
+		bool async_compute;
+	};
+
+	/**
+	 * @brief Records a scope of a command buffer during its lifetime
+	 */
+	class Scope
+	{
+	  public:
+		Scope(GpuProfiler *profiler, CommandBuffer &command_buffer, const std::string &name);
+
+		Scope(const Scope &) = delete;
+
+		Scope(Scope &&) = delete;
+
+		~Scope();
+
+		Scope &operator=(const Scope &) = delete;
+
+		Scope &operator=(Scope &&) = delete;
+
+	  private:
+		/// Null if profiling is disabled
+		GpuProfiler *profiler;
+
+		CommandBuffer &command_buffer;
+	};
+
+	/**
+	 * @param render_context Context of the frames to profile
+	 * @param max_scope_count Number of scopes a frame can record, others are ignored
+	 */
+	GpuProfiler(RenderContext &render_context, uint32_t max_scope_count = 64);
+
+	GpuProfiler(const GpuProfiler &) = delete;
+
+	GpuProfiler(GpuProfiler &&) = delete;
+
+	GpuProfiler &operator=(const GpuProfiler &) = delete;
+
+	GpuProfiler &operator=(GpuProfiler &&) = delete;
+
+	/**
+	 * @return True if the GPU supports timestamps on graphics and compute queues
+	 */
+	static bool is_supported(RenderContext &render_context);
+
+	/**
+	 * @brief Reads the results of the active frame and resets its queries
+	 * @param command_buffer The first command buffer of the frame, outside of a render pass
+	 */
+	void begin_frame(CommandBuffer &command_buffer);
+
+	/**
+	 * @brief Writes a timestamp beginning a scope, nested in the scopes not ended yet
+	 *        Scopes must begin and end in the same command buffer, or in command buffers submitted in order.
+	 */
+	void begin_scope(CommandBuffer &command_buffer, const std::string &name);
+
+	/**
+	 * @brief Writes a timestamp ending the innermost scope
+	 */
+	void end_scope(CommandBuffer &command_buffer);
+
+	/**
+	 * @return The timings of the scopes of the last measured frame, in the order they began
+	 */
+	const std::vector<Timing> &get_timings() const;
+
+	/**
+	 * @return Milliseconds from the first timestamp to the last one of the last measured frame
+	 */
+	float get_frame_span() const;
+
+	/**
+	 * @brief Writes the average and maximum time of every scope measured to a JSON file
+	 * @param filename Name of the file, in the graphs directory
+	 * @return True if the file was written
+	 */
+	bool write_json(const std::string &filename) const;
+
+  private:
+	/**
+	 * @brief A scope recorded by a frame
+	 */
+	struct ScopeRecord
+	{
+		std::string name;
+
+		uint32_t depth;
+
+		/// Query of the end timestamp, the begin one precedes it
+		uint32_t end_query;
+
+		/// Whether the scope uses the compute range of the frame
+		bool async_compute;
+	};
+
+	/**
+	 * @brief Times of a scope over all the frames measured
+	 */
+	struct ScopeStatistics
+	{
+		float smoothed_time{0.0f};
+
+		double total_time{0.0};
+
+		float max_time{0.0f};
+
+		uint32_t count{0};
+	};
+
+	/**
+	 * @brief Creates the query pool for the current number of render frames
+	 */
+	void create_query_pool();
+
+	/**
+	 * @brief Turns the results of the active frame into timings
+	 */
+	void read_results();
+
+	/**
+	 * @return The first query of the range of a frame for graphics or async compute scopes
+	 */
+	uint32_t get_first_query(uint32_t frame, bool async_compute) const;
+
+	RenderContext &render_context;
+
+	uint32_t max_scope_count;
+
+	/// Nanoseconds per timestamp tick
+	float timestamp_period{1.0f};
+
+	/// Mask of the valid bits of timestamps
+	uint64_t timestamp_mask{~0ULL};
+
+	std::unique_ptr<QueryPool> query_pool;
+
+	/// Index of the frame recording, its queries begin at frame_index * max_scope_count * 2
+	uint32_t frame_index{0};
+
+	/// Whether a frame reset its queries, scopes are only recorded after begin_frame
+	bool frame_active{false};
+
+	/// Whether the first async compute scope of the frame reset the compute range
+	bool compute_queries_reset{false};
+
+	/// Number of graphics and async compute scopes recorded by each frame
+	std::vector<std::array<uint32_t, 2>> frame_scope_counts;
+
+	/// Scopes recorded by each frame
+	std::vector<std::vector<ScopeRecord>> frame_scopes;
+
+	/// Indices in the frame scopes of the scopes not ended yet
+	std::vector<size_t> open_scopes;
+
+	std::vector<Timing> timings;
+
+	float frame_span{0.0f};
+
+	std::unordered_map<std::string, ScopeStatistics> statistics;
+
+	/// Names of the scopes in the order they were first measured
+	std::vector<std::string> statistics_order;
+};
+}        // namespace vkb
@@ -16,13 +16,17 @@
  * limitations under the License.
  */
 
+#include <algorithm>
+
 #include "common/error.h"
 
 #include "hwcpipe_stats_provider.h"
 
 namespace vkb
 {
-HWCPipeStatsProvider::HWCPipeStatsProvider(std::set<StatIndex> &requested_stats)
+HWCPipeStatsProvider::HWCPipeStatsProvider(std::set<StatIndex> &requested_stats, const CounterSamplingConfig &sampling_config) :
+    sampling_config{sampling_config},
+    background_sampling{sampling_config.mode == CounterSamplingMode::Polling && sampling_config.background_counters}
 {
 	// Mapping of stats to their hwcpipe availability
 	// clang-format off
@@ -55,7 +59,9 @@ HWCPipeStatsProvider::HWCPipeStatsProvider(std::set<StatIndex> &requested_stats)
 	    {StatIndex::gpu_ext_write_stalls,  {hwcpipe::GpuCounter::ExternalMemoryWriteStalls}},
 	    {StatIndex::gpu_ext_read_bytes,    {hwcpipe::GpuCounter::ExternalMemoryReadBytes}},
 	    {StatIndex::gpu_ext_write_bytes,   {hwcpipe::GpuCounter::ExternalMemoryWriteBytes}},
-	    {StatIndex::gpu_tex_cycles,        {hwcpipe::GpuCounter::ShaderTextureCycles}}};
+	    {StatIndex::gpu_tex_cycles,        {hwcpipe::GpuCounter::ShaderTextureCycles}},
+	    {StatIndex::gpu_ext_bytes_per_frame,       {hwcpipe::GpuCounter::ExternalMemoryReadBytes, StatScaling::None,      hwcpipe::GpuCounter::MaxValue, hwcpipe::GpuCounter::ExternalMemoryWriteBytes}},
+	    {StatIndex::gpu_fragment_cycles_per_pixel, {hwcpipe::GpuCounter::FragmentCycles,          StatScaling::ByCounter, hwcpipe::GpuCounter::Pixels}}};
 	// clang-format on
 
 	hwcpipe::CpuCounterSet enabled_cpu_counters{};
@@ -79,6 +85,8 @@ HWCPipeStatsProvider::HWCPipeStatsProvider(std::set<StatIndex> &requested_stats)
 					enabled_gpu_counters.insert(res->second.gpu_counter);
 					if (res->second.divisor_gpu_counter != hwcpipe::GpuCounter::MaxValue)
 						enabled_gpu_counters.insert(res->second.divisor_gpu_counter);
+					if (res->second.summed_gpu_counter != hwcpipe::GpuCounter::MaxValue)
+						enabled_gpu_counters.insert(res->second.summed_gpu_counter);
 					break;
 			}
 		}
@@ -172,61 +180,163 @@ static double get_gpu_counter_value(const hwcpipe::GpuMeasurements *gpu, hwcpipe
 	return 0.0;
 }
 
-StatsProvider::Counters HWCPipeStatsProvider::sample(float delta_time)
+HWCPipeStatsProvider::RawValues HWCPipeStatsProvider::read_values(const hwcpipe::Measurements &m) const
 {
-	Counters              res;
-	hwcpipe::Measurements m = hwcpipe->sample();
+	RawValues values;
 
-	// Map from hwcpipe measurement to our sample result for each counter
-	for (auto iter : stat_data)
+	// Map from hwcpipe measurement to the value and divisor of each counter
+	for (auto &iter : stat_data)
 	{
-		StatIndex       index = iter.first;
-		const StatData &data  = iter.second;
+		const StatData &data = iter.second;
 
-		double d = 0.0;
+		double value   = 0.0;
+		double divisor = 0.0;
 		if (data.type == StatType::Cpu)
 		{
-			d = get_cpu_counter_value(m.cpu, data.cpu_counter);
+			value = get_cpu_counter_value(m.cpu, data.cpu_counter);
 
-			if (data.scaling == StatScaling::ByDeltaTime && delta_time != 0.0f)
-			{
-				d /= delta_time;
-			}
-			else if (data.scaling == StatScaling::ByCounter)
-			{
-				double divisor = get_cpu_counter_value(m.cpu, data.divisor_cpu_counter);
-				if (divisor != 0.0)
-					d /= divisor;
-				else
-					d = 0.0;
-			}
+			if (data.scaling == StatScaling::ByCounter)
+				divisor = get_cpu_counter_value(m.cpu, data.divisor_cpu_counter);
 		}
 		else if (data.type == StatType::Gpu)
 		{
-			d = get_gpu_counter_value(m.gpu, data.gpu_counter);
+			value = get_gpu_counter_value(m.gpu, data.gpu_counter);
 
-			if (data.scaling == StatScaling::ByDeltaTime && delta_time != 0.0f)
-			{
-				d /= delta_time;
-			}
-			else if (data.scaling == StatScaling::ByCounter)
-			{
-				double divisor = get_gpu_counter_value(m.gpu, data.divisor_gpu_counter);
-				if (divisor != 0.0)
-					d /= divisor;
-				else
-					d = 0.0;
-			}
+			if (data.summed_gpu_counter != hwcpipe::GpuCounter::MaxValue)
+				value += get_gpu_counter_value(m.gpu, data.summed_gpu_counter);
+
+			if (data.scaling == StatScaling::ByCounter)
+				divisor = get_gpu_counter_value(m.gpu, data.divisor_gpu_counter);
 		}
-		res[index].result = d;
+		values[iter.first] = {value, divisor};
+	}
+
+	return values;
+}
+
+StatsProvider::Counters HWCPipeStatsProvider::compute_counters(const RawValues &values, float delta_time) const
+{
+	Counters res;
+
+	for (auto &iter : values)
+	{
+		const StatData &data = stat_data.at(iter.first);
+
+		double d = iter.second.first;
+
+		if (data.scaling == StatScaling::ByDeltaTime && delta_time != 0.0f)
+		{
+			d /= delta_time;
+		}
+		else if (data.scaling == StatScaling::ByCounter)
+		{
+			double divisor = iter.second.second;
+			if (divisor != 0.0)
+				d /= divisor;
+			else
+				d = 0.0;
+		}
+		res[iter.first].result = d;
 	}
 
 	return res;
 }
 
+StatsProvider::Counters HWCPipeStatsProvider::sample(float delta_time)
+{
+	if (background_sampling)
+	{
+		std::lock_guard<std::mutex> lock(background_mutex);
+
+		frame_boundaries.push_back(std::chrono::steady_clock::now());
+
+		Counters res;
+		if (frame_completed)
+		{
+			std::swap(res, completed_frame);
+			frame_completed = false;
+		}
+		return res;
+	}
+
+	return compute_counters(read_values(hwcpipe->sample()), delta_time);
+}
+
 StatsProvider::Counters HWCPipeStatsProvider::continuous_sample(float delta_time)
 {
 	return sample(delta_time);
 }
 
+void HWCPipeStatsProvider::background_sample()
+{
+	if (!background_sampling)
+	{
+		return;
+	}
+
+	hwcpipe::Measurements m   = hwcpipe->sample();
+	auto                  now = std::chrono::steady_clock::now();
+
+	std::vector<std::chrono::steady_clock::time_point> boundaries;
+	{
+		std::lock_guard<std::mutex> lock(background_mutex);
+
+		while (!frame_boundaries.empty() && frame_boundaries.front() <= now)
+		{
+			boundaries.push_back(frame_boundaries.front());
+			frame_boundaries.pop_front();
+		}
+	}
+
+	// The first sample only starts the counters
+	if (last_sample_time == std::chrono::steady_clock::time_point{})
+	{
+		last_sample_time = now;
+		frame_start_time = now;
+		return;
+	}
+
+	RawValues values = read_values(m);
+
+	auto sample_duration = std::chrono::duration<double>(now - last_sample_time).count();
+
+	auto accumulate = [this, &values](double fraction) {
+		for (auto &iter : values)
+		{
+			auto &frame_value = frame_values[iter.first];
+			frame_value.first += iter.second.first * fraction;
+			frame_value.second += iter.second.second * fraction;
+		}
+	};
+
+	// Fraction of the sample already accounted to previous frames
+	double consumed = 0.0;
+
+	for (auto boundary : boundaries)
+	{
+		boundary = std::max(boundary, last_sample_time);
+
+		double fraction = sample_duration > 0.0 ? std::chrono::duration<double>(boundary - last_sample_time).count() / sample_duration : 1.0;
+
+		accumulate(fraction - consumed);
+		consumed = fraction;
+
+		auto frame_time = std::chrono::duration<float>(boundary - frame_start_time).count();
+
+		Counters frame = compute_counters(frame_values, frame_time);
+
+		frame_values.clear();
+		frame_start_time = boundary;
+
+		std::lock_guard<std::mutex> lock(background_mutex);
+
+		completed_frame = std::move(frame);
+		frame_completed = true;
+	}
+
+	accumulate(1.0 - consumed);
+
+	last_sample_time = now;
+}
+
 }        // namespace vkb
@@ -25,6 +25,10 @@ VKBP_DISABLE_WARNINGS()
 #include <hwcpipe.h>
 VKBP_ENABLE_WARNINGS()
 
+#include <chrono>
+#include <deque>
+#include <mutex>
+
 #include "stats_provider.h"
 
 namespace vkb
@@ -46,6 +50,7 @@ class HWCPipeStatsProvider : public StatsProvider
 		hwcpipe::CpuCounter divisor_cpu_counter;
 		hwcpipe::GpuCounter gpu_counter;
 		hwcpipe::GpuCounter divisor_gpu_counter;
+		hwcpipe::GpuCounter summed_gpu_counter{hwcpipe::GpuCounter::MaxValue};
 
 		StatData() = default;
 
@@ -69,25 +74,32 @@ class HWCPipeStatsProvider : public StatsProvider
 		 * @param c The GPU counter to be gathered
 		 * @param stat_scaling The scaling to be applied to the stat
 		 * @param divisor The GPU counter to be used as divisor if scaling is ByCounter
+		 * @param summed The GPU counter added to the gathered one, if any
 		 */
 		StatData(hwcpipe::GpuCounter c,
 		         StatScaling         stat_scaling = StatScaling::ByDeltaTime,
-		         hwcpipe::GpuCounter divisor      = hwcpipe::GpuCounter::MaxValue) :
+		         hwcpipe::GpuCounter divisor      = hwcpipe::GpuCounter::MaxValue,
+		         hwcpipe::GpuCounter summed       = hwcpipe::GpuCounter::MaxValue) :
 		    type(StatType::Gpu),
 		    scaling(stat_scaling),
 		    gpu_counter(c),
-		    divisor_gpu_counter(divisor)
+		    divisor_gpu_counter(divisor),
+		    summed_gpu_counter(summed)
 		{}
 	};
 
 	using StatDataMap = std::unordered_map<StatIndex, StatData, StatIndexHash>;
 
+	/// Raw value and divisor of every stat, accumulated over a sample or a frame
+	using RawValues = std::unordered_map<StatIndex, std::pair<double, double>, StatIndexHash>;
+
   public:
 	/**
 	 * @brief Constructs a HWCPipeStateProvider
 	 * @param requested_stats Set of stats to be collected. Supported stats will be removed from the set.
+	 * @param sampling_config Sampling configuration, selecting whether counters are sampled in the background
 	 */
-	HWCPipeStatsProvider(std::set<StatIndex> &requested_stats);
+	HWCPipeStatsProvider(std::set<StatIndex> &requested_stats, const CounterSamplingConfig &sampling_config);
 
 	/**
 	 * @brief Checks if this provider can supply the given enabled stat
@@ -104,6 +116,9 @@ class HWCPipeStatsProvider : public StatsProvider
 
 	/**
 	 * @brief Retrieve a new sample set from polled sampling
+	 *
+	 * With background counters this marks the end of the frame for the worker thread, and returns
+	 * the values of the last frame it completed, or no values if it completed none since the last call.
 	 * @param delta_time Time since last sample
 	 */
 	Counters sample(float delta_time) override;
@@ -114,7 +129,25 @@ class HWCPipeStatsProvider : public StatsProvider
 	 */
 	Counters continuous_sample(float delta_time) override;
 
+	/**
+	 * @brief Samples the counters on the worker thread and splits them between the frames they overlap,
+	 *        in proportion of the time of the sample spent in each frame
+	 */
+	void background_sample() override;
+
   private:
+	/**
+	 * @brief Reads the value and the divisor of every stat from a measurement
+	 */
+	RawValues read_values(const hwcpipe::Measurements &measurements) const;
+
+	/**
+	 * @brief Computes the stats from their raw values
+	 * @param values Raw values over a period of time
+	 * @param delta_time Length of the period, in seconds
+	 */
+	Counters compute_counters(const RawValues &values, float delta_time) const;
+
 	// The hwcpipe instance
 	std::unique_ptr<hwcpipe::HWCPipe> hwcpipe{};
 
@@ -123,6 +156,29 @@ class HWCPipeStatsProvider : public StatsProvider
 
 	// Counter sampling configuration
 	CounterSamplingConfig sampling_config;
+
+	// Whether the counters are sampled by the worker thread, in polling mode
+	bool background_sampling{false};
+
+	// Guards the frame boundaries and the completed frame shared by both threads
+	std::mutex background_mutex;
+
+	// End times of the frames recorded by sample(), which the worker thread did not reach yet
+	std::deque<std::chrono::steady_clock::time_point> frame_boundaries;
+
+	// Stats of the last frame completed by the worker thread, until sample() reads them
+	Counters completed_frame;
+
+	bool frame_completed{false};
+
+	// Time of the last background sample, only used by the worker thread
+	std::chrono::steady_clock::time_point last_sample_time;
+
+	// Start time of the frame being accumulated, only used by the worker thread
+	std::chrono::steady_clock::time_point frame_start_time;
+
+	// Raw values accumulated over the frame, only used by the worker thread
+	RawValues frame_values;
 };
 
 }        // namespace vkb
@@ -0,0 +1,65 @@
+/* Copyright (c) 2020, Arm Limited and Contributors
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 the "License";
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "latency_stats_provider.h"
+
+#include "rendering/render_context.h"
+
+namespace vkb
+{
+LatencyStatsProvider::LatencyStatsProvider(std::set<StatIndex> &requested_stats, RenderContext &render_context) :
+    render_context{render_context}
+{
+	if (render_context.has_present_timing())
+	{
+		requested_stats.erase(StatIndex::input_to_present_latency);
+		requested_stats.erase(StatIndex::present_to_display_latency);
+	}
+
+	requested_stats.erase(StatIndex::queue_submit_latency);
+}
+
+bool LatencyStatsProvider::is_available(StatIndex index) const
+{
+	return ((index == StatIndex::input_to_present_latency || index == StatIndex::present_to_display_latency) && render_context.has_present_timing()) ||
+	       index == StatIndex::queue_submit_latency;
+}
+
+StatsProvider::Counters LatencyStatsProvider::sample(float delta_time)
+{
+	Counters res;
+
+	if (render_context.has_present_timing())
+	{
+		res[StatIndex::input_to_present_latency].result   = render_context.get_input_to_present_latency();
+		res[StatIndex::present_to_display_latency].result = render_context.get_present_to_display_latency();
+	}
+
+	auto &queue = render_context.get_device().get_suitable_graphics_queue();
+
+	uint64_t count = queue.get_submit_count();
+	double   time  = queue.get_submit_time();
+
+	// Average of the submissions since the last sample, submissions from other threads included
+	res[StatIndex::queue_submit_latency].result = count > submit_count ? (time - submit_time) / (count - submit_count) : 0.0;
+
+	submit_count = count;
+	submit_time  = time;
+
+	return res;
+}
+}        // namespace vkb
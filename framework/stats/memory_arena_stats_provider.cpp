@@ -0,0 +1,53 @@
+/* Copyright (c) 2020, Arm Limited and Contributors
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 the "License";
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "memory_arena_stats_provider.h"
+
+#include "rendering/render_context.h"
+
+namespace vkb
+{
+MemoryArenaStatsProvider::MemoryArenaStatsProvider(std::set<StatIndex> &requested_stats, RenderContext &render_context) :
+    render_context{render_context}
+{
+	// We always, and only, support StatIndex::frame_arena_allocations
+	requested_stats.erase(StatIndex::frame_arena_allocations);
+}
+
+bool MemoryArenaStatsProvider::is_available(StatIndex index) const
+{
+	return index == StatIndex::frame_arena_allocations;
+}
+
+StatsProvider::Counters MemoryArenaStatsProvider::sample(float delta_time)
+{
+	size_t block_count = 0;
+
+	for (auto &render_frame : render_context.get_render_frames())
+	{
+		block_count += render_frame->get_memory_arena_block_count();
+	}
+
+	// Once the arenas reach the peak usage of a frame, this should stay at zero
+	Counters res;
+	res[StatIndex::frame_arena_allocations].result = static_cast<double>(block_count - last_block_count);
+
+	last_block_count = block_count;
+
+	return res;
+}
+}        // namespace vkb
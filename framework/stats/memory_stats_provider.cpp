@@ -0,0 +1,118 @@
+/* Copyright (c) 2020, Arm Limited and Contributors
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 the "License";
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "memory_stats_provider.h"
+
+#include "core/device.h"
+#include "rendering/render_context.h"
+
+namespace vkb
+{
+MemoryStatsProvider::MemoryStatsProvider(std::set<StatIndex> &requested_stats, RenderContext &render_context) :
+    render_context{render_context}
+{
+	count_allocations = requested_stats.count(StatIndex::memory_allocations) > 0;
+
+	// The allocator always provides these stats, with or without VK_EXT_memory_budget
+	requested_stats.erase(StatIndex::device_local_memory_usage);
+	requested_stats.erase(StatIndex::device_local_memory_budget);
+	requested_stats.erase(StatIndex::host_memory_usage);
+	requested_stats.erase(StatIndex::host_memory_budget);
+	requested_stats.erase(StatIndex::memory_allocations);
+	requested_stats.erase(StatIndex::buffer_pool_bytes);
+	requested_stats.erase(StatIndex::buffer_block_requests);
+}
+
+bool MemoryStatsProvider::is_available(StatIndex index) const
+{
+	return index == StatIndex::device_local_memory_usage ||
+	       index == StatIndex::device_local_memory_budget ||
+	       index == StatIndex::host_memory_usage ||
+	       index == StatIndex::host_memory_budget ||
+	       index == StatIndex::memory_allocations ||
+	       index == StatIndex::buffer_pool_bytes ||
+	       index == StatIndex::buffer_block_requests;
+}
+
+StatsProvider::Counters MemoryStatsProvider::sample(float delta_time)
+{
+	VmaAllocator allocator = render_context.get_device().get_memory_allocator();
+
+	vmaSetCurrentFrameIndex(allocator, ++frame_index);
+
+	const VkPhysicalDeviceMemoryProperties *memory_properties = nullptr;
+	vmaGetMemoryProperties(allocator, &memory_properties);
+
+	VmaBudget budgets[VK_MAX_MEMORY_HEAPS];
+	vmaGetBudget(allocator, budgets);
+
+	VkDeviceSize device_local_usage  = 0;
+	VkDeviceSize device_local_budget = 0;
+	VkDeviceSize host_usage          = 0;
+	VkDeviceSize host_budget         = 0;
+
+	for (uint32_t heap_index = 0; heap_index < memory_properties->memoryHeapCount; ++heap_index)
+	{
+		if (memory_properties->memoryHeaps[heap_index].flags & VK_MEMORY_HEAP_DEVICE_LOCAL_BIT)
+		{
+			device_local_usage += budgets[heap_index].usage;
+			device_local_budget += budgets[heap_index].budget;
+		}
+		else
+		{
+			host_usage += budgets[heap_index].usage;
+			host_budget += budgets[heap_index].budget;
+		}
+	}
+
+	VkDeviceSize buffer_allocated_bytes = 0;
+	uint64_t     buffer_block_requests  = 0;
+
+	for (auto &render_frame : render_context.get_render_frames())
+	{
+		buffer_allocated_bytes += render_frame->get_buffer_allocated_bytes();
+		buffer_block_requests += render_frame->get_buffer_block_request_count();
+	}
+
+	// Counters start over when frames are re-created
+	if (buffer_block_requests < last_buffer_block_requests)
+	{
+		last_buffer_block_requests = 0;
+	}
+
+	Counters res;
+	res[StatIndex::device_local_memory_usage].result  = static_cast<double>(device_local_usage);
+	res[StatIndex::device_local_memory_budget].result = static_cast<double>(device_local_budget);
+	res[StatIndex::host_memory_usage].result          = static_cast<double>(host_usage);
+	res[StatIndex::host_memory_budget].result         = static_cast<double>(host_budget);
+	res[StatIndex::buffer_pool_bytes].result          = static_cast<double>(buffer_allocated_bytes - last_buffer_allocated_bytes);
+	res[StatIndex::buffer_block_requests].result      = static_cast<double>(buffer_block_requests - last_buffer_block_requests);
+
+	if (count_allocations)
+	{
+		VmaStats stats;
+		vmaCalculateStats(allocator, &stats);
+
+		res[StatIndex::memory_allocations].result = static_cast<double>(stats.total.allocationCount);
+	}
+
+	last_buffer_allocated_bytes = buffer_allocated_bytes;
+	last_buffer_block_requests  = buffer_block_requests;
+
+	return res;
+}
+}        // namespace vkb
@@ -0,0 +1,72 @@
+/* Copyright (c) 2020, Arm Limited and Contributors
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 the "License";
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include "common/vk_common.h"
+#include "stats_provider.h"
+
+namespace vkb
+{
+class RenderContext;
+
+/**
+ * @brief Reports the memory usage and budget of the heaps of the device, the allocations of
+ *        the memory allocator, and the bytes allocated from the buffer pools of the render frames
+ *
+ * Usage and budget come from the driver when VK_EXT_memory_budget is enabled, and are
+ * otherwise estimated by the allocator from its own allocations.
+ */
+class MemoryStatsProvider : public StatsProvider
+{
+  public:
+	/**
+	 * @brief Constructs a MemoryStatsProvider
+	 * @param requested_stats Set of stats to be collected. Supported stats will be removed from the set.
+	 * @param render_context The render context whose device and frames are observed
+	 */
+	MemoryStatsProvider(std::set<StatIndex> &requested_stats, RenderContext &render_context);
+
+	/**
+	 * @brief Checks if this provider can supply the given enabled stat
+	 * @param index The stat index
+	 * @return True if the stat is available, false otherwise
+	 */
+	bool is_available(StatIndex index) const override;
+
+	/**
+	 * @brief Retrieve a new sample set
+	 * @param delta_time Time since last sample
+	 */
+	Counters sample(float delta_time) override;
+
+  private:
+	RenderContext &render_context;
+
+	/// Whether the allocations are counted, which walks every block of the allocator
+	bool count_allocations{false};
+
+	/// Frame index given to the allocator, which refreshes its budget when it changes
+	uint32_t frame_index{0};
+
+	/// Bytes allocated from the buffer pools of all the frames at the previous sample
+	VkDeviceSize last_buffer_allocated_bytes{0};
+
+	/// Buffer blocks requested by all the frames at the previous sample
+	uint64_t last_buffer_block_requests{0};
+};
+}        // namespace vkb
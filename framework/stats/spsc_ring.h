@@ -0,0 +1,99 @@
+/* Copyright (c) 2020, Arm Limited and Contributors
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 the "License";
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <atomic>
+#include <vector>
+
+namespace vkb
+{
+/**
+ * @brief Bounded lock-free queue with a single producer thread and a single consumer thread
+ *
+ * Slots are allocated once at construction; pushing into a full ring fails instead of waiting.
+ */
+template <typename T>
+class SpscRing
+{
+  public:
+	/**
+	 * @brief Constructs a SpscRing
+	 * @param capacity Maximum number of values held at once
+	 */
+	explicit SpscRing(size_t capacity) :
+	    slots(capacity + 1)
+	{}
+
+	SpscRing(const SpscRing &) = delete;
+
+	SpscRing &operator=(const SpscRing &) = delete;
+
+	/**
+	 * @brief Moves a value into the ring, must only be called by the producer thread
+	 * @return False if the ring is full, in which case the value is left untouched
+	 */
+	bool push(T &&value)
+	{
+		auto write = write_index.load(std::memory_order_relaxed);
+		auto next  = (write + 1) % slots.size();
+
+		if (next == read_index.load(std::memory_order_acquire))
+		{
+			return false;
+		}
+
+		slots[write] = std::move(value);
+
+		// Publish the slot to the consumer
+		write_index.store(next, std::memory_order_release);
+
+		return true;
+	}
+
+	/**
+	 * @brief Moves the oldest value out of the ring, must only be called by the consumer thread
+	 * @return False if the ring is empty
+	 */
+	bool pop(T &value)
+	{
+		auto read = read_index.load(std::memory_order_relaxed);
+
+		if (read == write_index.load(std::memory_order_acquire))
+		{
+			return false;
+		}
+
+		value = std::move(slots[read]);
+
+		// Hand the slot back to the producer
+		read_index.store((read + 1) % slots.size(), std::memory_order_release);
+
+		return true;
+	}
+
+  private:
+	/// One more slot than the capacity, so that a full ring can be told apart from an empty one
+	std::vector<T> slots;
+
+	/// Next slot to read, only written by the consumer
+	std::atomic<size_t> read_index{0};
+
+	/// Next slot to write, only written by the producer
+	std::atomic<size_t> write_index{0};
+};
+}        // namespace vkb
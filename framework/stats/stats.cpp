@@ -17,11 +17,25 @@
  */
 
 #include "stats/stats.h"
+
+#include <iterator>
+#include <limits>
+
 #include "common/error.h"
 #include "core/device.h"
 
+#include "animation_stats_provider.h"
+#include "attachment_traffic_stats_provider.h"
+#include "bind_stats_provider.h"
+#include "command_buffer_stats_provider.h"
+#include "descriptor_pool_stats_provider.h"
 #include "frame_time_stats_provider.h"
 #include "hwcpipe_stats_provider.h"
+#include "latency_stats_provider.h"
+#include "memory_arena_stats_provider.h"
+#include "memory_stats_provider.h"
+#include "stats_recorder.h"
+#include "thermal_stats_provider.h"
 #include "vulkan_stats_provider.h"
 
 namespace vkb
@@ -64,7 +78,16 @@ void Stats::request_stats(const std::set<StatIndex> &wanted_stats,
 	// All supported stats will be removed from the given 'stats' set by the provider's constructor
 	// so subsequent providers only see requests for stats that aren't already supported.
 	providers.emplace_back(std::make_unique<FrameTimeStatsProvider>(stats));
-	providers.emplace_back(std::make_unique<HWCPipeStatsProvider>(stats));
+	providers.emplace_back(std::make_unique<MemoryArenaStatsProvider>(stats, render_context));
+	providers.emplace_back(std::make_unique<BindStatsProvider>(stats, render_context));
+	providers.emplace_back(std::make_unique<AttachmentTrafficStatsProvider>(stats, render_context));
+	providers.emplace_back(std::make_unique<CommandBufferStatsProvider>(stats, render_context));
+	providers.emplace_back(std::make_unique<DescriptorPoolStatsProvider>(stats, render_context));
+	providers.emplace_back(std::make_unique<MemoryStatsProvider>(stats, render_context));
+	providers.emplace_back(std::make_unique<LatencyStatsProvider>(stats, render_context));
+	providers.emplace_back(std::make_unique<AnimationStatsProvider>(stats));
+	providers.emplace_back(std::make_unique<ThermalStatsProvider>(stats));
+	providers.emplace_back(std::make_unique<HWCPipeStatsProvider>(stats, sampling_config));
 	providers.emplace_back(std::make_unique<VulkanStatsProvider>(stats, sampling_config, render_context));
 
 	// In continuous sampling mode we still need to update the frame times as if we are polling
@@ -73,7 +96,7 @@ void Stats::request_stats(const std::set<StatIndex> &wanted_stats,
 
 	for (const auto &stat : requested_stats)
 	{
-		counters[stat] = std::vector<float>(buffer_size, 0);
+		counters[static_cast<size_t>(stat)].resize(buffer_size);
 	}
 
 	if (sampling_config.mode == CounterSamplingMode::Continuous)
@@ -88,6 +111,15 @@ void Stats::request_stats(const std::set<StatIndex> &wanted_stats,
 		// Reduce smoothing for continuous sampling
 		alpha_smoothing = 0.6f;
 	}
+	else if (sampling_config.background_counters)
+	{
+		// The worker thread only samples the providers accumulating counters for update()
+		stop_worker = std::make_unique<std::promise<void>>();
+
+		worker_thread = std::thread([this] {
+			continuous_sampling_worker(stop_worker->get_future());
+		});
+	}
 
 	for (const auto &stat_index : requested_stats)
 	{
@@ -104,10 +136,9 @@ void Stats::resize(const size_t width)
 	// which means every sixteen pixels represent one graph value
 	size_t buffers_size = width >> 4;
 
-	for (auto &counter : counters)
+	for (const auto &stat : requested_stats)
 	{
-		counter.second.resize(buffers_size);
-		counter.second.shrink_to_fit();
+		counters[static_cast<size_t>(stat)].resize(buffers_size);
 	}
 }
 
@@ -119,18 +150,12 @@ bool Stats::is_available(const StatIndex index) const
 	return false;
 }
 
-static void add_smoothed_value(std::vector<float> &values, float value, float alpha)
+static void add_smoothed_value(StatBuffer &values, float value, float alpha)
 {
 	assert(values.size() >= 2 && "Buffers size should be greater than 2");
 
-	if (values.size() == values.capacity())
-	{
-		// Shift values to the left to make space at the end and update counters
-		std::rotate(values.begin(), values.begin() + 1, values.end());
-	}
-
 	// Use an exponential moving average to smooth values
-	values.back() = value * alpha + *(values.end() - 2) * (1.0f - alpha);
+	values.push(value * alpha + values.latest() * (1.0f - alpha));
 }
 
 void Stats::update(float delta_time)
@@ -151,23 +176,13 @@ void Stats::update(float delta_time)
 		}
 		case CounterSamplingMode::Continuous:
 		{
-			// Check that we have no pending samples to be shown
+			// Once the pending samples are shown, read the ones captured by the worker thread since
 			if (pending_samples.size() == 0)
 			{
-				std::unique_lock<std::mutex> lock(continuous_sampling_mutex);
-				if (!should_add_to_continuous_samples)
-				{
-					// If we have no pending samples, we let the worker thread
-					// capture samples for the next frame
-					should_add_to_continuous_samples = true;
-				}
-				else
+				StatsProvider::Counters sample;
+				while (continuous_samples.pop(sample))
 				{
-					// The worker thread has captured a frame, so we stop it
-					// and read the samples
-					should_add_to_continuous_samples = false;
-					pending_samples                  = continuous_samples;
-					continuous_samples.clear();
+					pending_samples.push_back(std::move(sample));
 				}
 			}
 
@@ -205,8 +220,15 @@ void Stats::continuous_sampling_worker(std::future<void> should_terminate)
 {
 	worker_timer.tick();
 
+	bool continuous = sampling_config.mode == CounterSamplingMode::Continuous;
+
 	for (auto &p : providers)
-		p->continuous_sample(0.0f);
+	{
+		if (continuous)
+			p->continuous_sample(0.0f);
+		else
+			p->background_sample();
+	}
 
 	while (should_terminate.wait_for(std::chrono::seconds(0)) != std::future_status::ready)
 	{
@@ -220,6 +242,13 @@ void Stats::continuous_sampling_worker(std::future<void> should_terminate)
 			delta_time += static_cast<float>(worker_timer.tick());
 		}
 
+		if (!continuous)
+		{
+			for (auto &p : providers)
+				p->background_sample();
+			continue;
+		}
+
 		// Sample counters
 		StatsProvider::Counters sample;
 		for (auto &p : providers)
@@ -228,21 +257,43 @@ void Stats::continuous_sampling_worker(std::future<void> should_terminate)
 			sample.insert(s.begin(), s.end());
 		}
 
-		// Add the new sample to the vector of continuous samples
-		{
-			std::unique_lock<std::mutex> lock(continuous_sampling_mutex);
-			continuous_samples.push_back(sample);
-		}
+		// Hand the new sample to the main thread; if it is too far behind, the sample is dropped
+		continuous_samples.push(std::move(sample));
 	}
 }
 
+void Stats::start_recording(const std::string &filename)
+{
+	recorder = std::make_unique<StatsRecorder>(filename, std::vector<StatIndex>{requested_stats.begin(), requested_stats.end()});
+}
+
+void Stats::stop_recording()
+{
+	recorder.reset();
+}
+
+bool Stats::is_recording() const
+{
+	return recorder != nullptr;
+}
+
 void Stats::push_sample(const StatsProvider::Counters &sample)
 {
-	for (auto &c : counters)
+	if (recorder)
 	{
-		StatIndex           idx    = c.first;
-		std::vector<float> &values = c.second;
+		std::array<float, static_cast<size_t>(StatIndex::count)> values;
+		values.fill(std::numeric_limits<float>::quiet_NaN());
+
+		for (const auto &counter : sample)
+		{
+			values[static_cast<size_t>(counter.first)] = static_cast<float>(counter.second.result);
+		}
+
+		recorder->record(values);
+	}
 
+	for (const auto &idx : requested_stats)
+	{
 		// Find the counter matching this StatIndex in the Sample
 		const auto &smp = sample.find(idx);
 		if (smp == sample.end())
@@ -250,7 +301,7 @@ void Stats::push_sample(const StatsProvider::Counters &sample)
 
 		float measurement = static_cast<float>(smp->second.result);
 
-		add_smoothed_value(values, measurement, alpha_smoothing);
+		add_smoothed_value(counters[static_cast<size_t>(idx)], measurement, alpha_smoothing);
 	}
 }
 
@@ -268,6 +319,31 @@ void Stats::end_sampling(CommandBuffer &cb)
 		p->end_sampling(cb);
 }
 
+void Stats::begin_subpass_sampling(CommandBuffer &cb, const std::string &name)
+{
+	for (auto &p : providers)
+		p->begin_subpass_sampling(cb, name);
+}
+
+void Stats::end_subpass_sampling(CommandBuffer &cb)
+{
+	for (auto &p : providers)
+		p->end_subpass_sampling(cb);
+}
+
+std::vector<StatsProvider::ScopeCounters> Stats::get_subpass_counters() const
+{
+	std::vector<StatsProvider::ScopeCounters> subpass_counters;
+
+	for (auto &p : providers)
+	{
+		auto scope_counters = p->get_scope_counters();
+		std::move(scope_counters.begin(), scope_counters.end(), std::back_inserter(subpass_counters));
+	}
+
+	return subpass_counters;
+}
+
 const StatGraphData &Stats::get_graph_data(StatIndex index) const
 {
 	for (auto &p : providers)
@@ -278,6 +354,62 @@ const StatGraphData &Stats::get_graph_data(StatIndex index) const
 	return StatsProvider::default_graph_data(index);
 }
 
+void StatBuffer::resize(size_t size)
+{
+	// Keep the latest values, in order, at the end of the new buffer
+	std::vector<float> resized(size, 0.0f);
+
+	size_t kept = std::min(size, values.size());
+	for (size_t i = 0; i < kept; ++i)
+	{
+		resized[size - 1 - i] = values[(offset + values.size() - 1 - i) % values.size()];
+	}
+
+	values = std::move(resized);
+	offset = 0;
+}
+
+void StatBuffer::push(float value)
+{
+	if (values.empty())
+	{
+		return;
+	}
+
+	values[offset] = value;
+	offset         = (offset + 1) % values.size();
+}
+
+float StatBuffer::latest() const
+{
+	if (values.empty())
+	{
+		return 0.0f;
+	}
+
+	return values[(offset + values.size() - 1) % values.size()];
+}
+
+const std::vector<float> &StatBuffer::get_values() const
+{
+	return values;
+}
+
+size_t StatBuffer::get_offset() const
+{
+	return offset;
+}
+
+size_t StatBuffer::size() const
+{
+	return values.size();
+}
+
+bool StatBuffer::empty() const
+{
+	return values.empty();
+}
+
 StatGraphData::StatGraphData(const std::string &name,
                              const std::string &graph_label_format,
                              float              scale_factor,
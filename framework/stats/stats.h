@@ -18,15 +18,16 @@
 
 #pragma once
 
+#include <array>
 #include <cstdint>
 #include <ctime>
 #include <future>
-#include <map>
 #include <set>
 #include <vector>
 
 #include "common/error.h"
 
+#include "spsc_ring.h"
 #include "stats_common.h"
 #include "stats_provider.h"
 #include "timer.h"
@@ -36,6 +37,7 @@ namespace vkb
 class Device;
 class CommandBuffer;
 class RenderContext;
+class StatsRecorder;
 
 /*
  * @brief Helper class for querying statistics about the CPU and the GPU
@@ -88,9 +90,9 @@ class Stats
 	 * @param index The stat index of the data requested
 	 * @return The data of the specified stat
 	 */
-	const std::vector<float> &get_data(StatIndex index) const
+	const StatBuffer &get_data(StatIndex index) const
 	{
-		return counters.at(index);
+		return counters[static_cast<size_t>(index)];
 	};
 
 	/**
@@ -135,6 +137,42 @@ class Stats
 	 */
 	void end_sampling(CommandBuffer &cb);
 
+	/**
+	 * @brief A subpass that we want to collect stats about has just begun
+	 *
+	 * Providers sampling with subpass attribution bracket each subpass recorded
+	 * inline between begin_sampling() and end_sampling() with their own queries,
+	 * so that counters can be broken down by subpass.
+	 * @param cb The command buffer
+	 * @param name The name of the subpass
+	 */
+	void begin_subpass_sampling(CommandBuffer &cb, const std::string &name);
+
+	/**
+	 * @brief A subpass that we want to collect stats about is about to end
+	 * @param cb The command buffer
+	 */
+	void end_subpass_sampling(CommandBuffer &cb);
+
+	/**
+	 * @return The counters attributed to each subpass by the last update, for providers sampling with subpass attribution
+	 */
+	std::vector<StatsProvider::ScopeCounters> get_subpass_counters() const;
+
+	/**
+	 * @brief Starts streaming the raw, unsmoothed samples of the requested stats to a CSV file
+	 *        Requested stats must not change while recording
+	 * @param filename Name of the file, in the graphs directory
+	 */
+	void start_recording(const std::string &filename);
+
+	/**
+	 * @brief Writes the remaining samples and closes the recording
+	 */
+	void stop_recording();
+
+	bool is_recording() const;
+
   private:
 	/// The render context
 	RenderContext &render_context;
@@ -163,8 +201,11 @@ class Stats
 	/// Alpha smoothing for running average
 	float alpha_smoothing{0.2f};
 
-	/// Circular buffers for counter data
-	std::map<StatIndex, std::vector<float>> counters{};
+	/// Recorder of raw samples, null unless recording
+	std::unique_ptr<StatsRecorder> recorder;
+
+	/// Circular buffers for counter data, indexed by StatIndex
+	std::array<StatBuffer, static_cast<size_t>(StatIndex::count)> counters{};
 
 	/// Worker thread for continuous sampling
 	std::thread worker_thread;
@@ -172,20 +213,18 @@ class Stats
 	/// Promise to stop the worker thread
 	std::unique_ptr<std::promise<void>> stop_worker;
 
-	/// A mutex for accessing measurements during continuous sampling
-	std::mutex continuous_sampling_mutex;
-
-	/// The samples read during continuous sampling
-	std::vector<StatsProvider::Counters> continuous_samples;
+	/// Maximum number of samples the worker thread may be ahead of the main thread
+	static constexpr size_t CONTINUOUS_SAMPLE_CAPACITY{256};
 
-	/// A flag specifying if the worker thread should add entries to continuous_samples
-	bool should_add_to_continuous_samples{false};
+	/// The samples read during continuous sampling, handed from the worker thread to the main thread
+	SpscRing<StatsProvider::Counters> continuous_samples{CONTINUOUS_SAMPLE_CAPACITY};
 
 	/// The samples waiting to be displayed
 	std::vector<StatsProvider::Counters> pending_samples;
 
 	/// The worker thread function for continuous sampling;
-	/// it adds a new entry to continuous_samples at every interval
+	/// it adds a new entry to continuous_samples at every interval,
+	/// or only samples the background counters of the providers in polling mode
 	void continuous_sampling_worker(std::future<void> should_terminate);
 
 	/// Updates circular buffers for CPU and GPU counters
@@ -20,6 +20,7 @@
 
 #include <chrono>
 #include <string>
+#include <vector>
 
 namespace vkb
 {
@@ -58,7 +59,44 @@ enum class StatIndex
 	gpu_ext_write_stalls,
 	gpu_ext_read_bytes,
 	gpu_ext_write_bytes,
+	estimated_ext_read_bytes,
+	estimated_ext_write_bytes,
 	gpu_tex_cycles,
+	gpu_ext_bytes_per_frame,
+	gpu_fragment_cycles_per_pixel,
+
+	frame_arena_allocations,
+
+	pipeline_binds,
+	pipeline_binds_saved,
+	descriptor_set_binds,
+
+	command_buffer_allocations,
+	command_buffer_reuses,
+	command_buffer_resets,
+
+	descriptor_pools,
+	descriptor_pool_usage,
+	descriptor_set_cache_hit_rate,
+
+	device_local_memory_usage,
+	device_local_memory_budget,
+	host_memory_usage,
+	host_memory_budget,
+	memory_allocations,
+	buffer_pool_bytes,
+	buffer_block_requests,
+
+	input_to_present_latency,
+	queue_submit_latency,
+	present_to_display_latency,
+
+	animation_time,
+
+	thermal_headroom,
+
+	/// Number of stat indices, not a stat
+	count,
 };
 
 struct StatIndexHash
@@ -95,12 +133,65 @@ struct CounterSamplingConfig
 	/// Sampling mode (polling or continuous)
 	CounterSamplingMode mode;
 
-	/// Sampling interval in continuous mode
+	/// Sampling interval in continuous mode, and of background counters
 	std::chrono::milliseconds interval{1};
 
+	/// In polling mode, sample the hardware counters on the worker thread at the sampling interval instead of
+	/// on update(), where the values of the last frame the worker thread completed are read
+	bool background_counters{false};
+
 	/// Speed of circular buffer updates in continuous mode;
 	/// at speed = 1.0f a new sample is displayed over 1 second.
 	float speed{0.5f};
+
+	/// Attribute counters to each subpass drawn between begin_sampling() and end_sampling(),
+	/// if the providers can do so; only polling mode supports it.
+	bool subpass_attribution{false};
+};
+
+/**
+ * @brief Fixed capacity circular buffer of the latest values of a stat
+ *
+ * Pushing a value overwrites the oldest one, so that values are never shifted.
+ */
+class StatBuffer
+{
+  public:
+	/**
+	 * @brief Sets the capacity of the buffer, keeping its latest values
+	 * @param size Number of values, the buffer is filled with zeros
+	 */
+	void resize(size_t size);
+
+	/**
+	 * @brief Replaces the oldest value
+	 */
+	void push(float value);
+
+	/**
+	 * @return The latest value pushed, or zero if there is none
+	 */
+	float latest() const;
+
+	/**
+	 * @return The values in storage order, starting with the oldest at get_offset()
+	 */
+	const std::vector<float> &get_values() const;
+
+	/**
+	 * @return The index of the oldest value in get_values()
+	 */
+	size_t get_offset() const;
+
+	size_t size() const;
+
+	bool empty() const;
+
+  private:
+	std::vector<float> values;
+
+	/// Index of the oldest value, which is overwritten next
+	size_t offset{0};
 };
 
 // Per-statistic graph data
@@ -48,12 +48,46 @@ std::map<StatIndex, StatGraphData> StatsProvider::default_graph_map{
     {StatIndex::gpu_fragment_jobs,     {"Fragment Jobs",                               "{:4.0f}/s"}},
     {StatIndex::gpu_fragment_cycles,   {"Fragment Cycles",                             "{:4.1f} M/s",   float(1e-6)}},
     {StatIndex::gpu_tex_cycles,        {"Shader Texture Cycles",                       "{:4.0f} k/s",   float(1e-3)}},
+    {StatIndex::gpu_ext_bytes_per_frame,       {"External Bytes Per Frame",            "{:4.1f} MiB",   1.0f / (1024.0f * 1024.0f)}},
+    {StatIndex::gpu_fragment_cycles_per_pixel, {"Fragment Cycles Per Pixel",           "{:4.2f}"}},
     {StatIndex::gpu_ext_reads,         {"External Reads",                              "{:4.1f} M/s",   float(1e-6)}},
     {StatIndex::gpu_ext_writes,        {"External Writes",                             "{:4.1f} M/s",   float(1e-6)}},
     {StatIndex::gpu_ext_read_stalls,   {"External Read Stalls",                        "{:4.1f} M/s",   float(1e-6)}},
     {StatIndex::gpu_ext_write_stalls,  {"External Write Stalls",                       "{:4.1f} M/s",   float(1e-6)}},
     {StatIndex::gpu_ext_read_bytes,    {"External Read Bytes",                         "{:4.1f} MiB/s", 1.0f / (1024.0f * 1024.0f)}},
     {StatIndex::gpu_ext_write_bytes,   {"External Write Bytes",                        "{:4.1f} MiB/s", 1.0f / (1024.0f * 1024.0f)}},
+    {StatIndex::estimated_ext_read_bytes,  {"Estimated Attachment Read Bytes",         "{:4.1f} MiB/s", 1.0f / (1024.0f * 1024.0f)}},
+    {StatIndex::estimated_ext_write_bytes, {"Estimated Attachment Write Bytes",        "{:4.1f} MiB/s", 1.0f / (1024.0f * 1024.0f)}},
+
+    {StatIndex::frame_arena_allocations, {"Frame Arena Block Allocations",             "{:4.0f}"}},
+
+    {StatIndex::pipeline_binds,          {"Pipeline Binds",                            "{:4.0f}"}},
+    {StatIndex::pipeline_binds_saved,    {"Pipeline Binds Saved",                      "{:4.0f}"}},
+    {StatIndex::descriptor_set_binds,    {"Descriptor Set Binds",                      "{:4.0f}"}},
+
+    {StatIndex::command_buffer_allocations, {"Command Buffer Allocations",             "{:4.0f}"}},
+    {StatIndex::command_buffer_reuses,      {"Command Buffer Reuses",                  "{:4.0f}"}},
+    {StatIndex::command_buffer_resets,      {"Command Buffer Resets",                  "{:4.0f}"}},
+
+    {StatIndex::descriptor_pools,        {"Descriptor Pools",                          "{:4.0f}"}},
+    {StatIndex::descriptor_pool_usage,   {"Descriptor Pool Usage",                     "{:3.1f}%",      100.0f,                       true,     100.0f}},
+    {StatIndex::descriptor_set_cache_hit_rate, {"Descriptor Set Cache Hit Rate",       "{:3.1f}%",      100.0f,                       true,     100.0f}},
+
+    {StatIndex::device_local_memory_usage,  {"Device Local Memory Usage",              "{:4.1f} MiB",   1.0f / (1024.0f * 1024.0f)}},
+    {StatIndex::device_local_memory_budget, {"Device Local Memory Budget",             "{:4.1f} MiB",   1.0f / (1024.0f * 1024.0f)}},
+    {StatIndex::host_memory_usage,          {"Host Memory Usage",                      "{:4.1f} MiB",   1.0f / (1024.0f * 1024.0f)}},
+    {StatIndex::host_memory_budget,         {"Host Memory Budget",                     "{:4.1f} MiB",   1.0f / (1024.0f * 1024.0f)}},
+    {StatIndex::memory_allocations,         {"Memory Allocations",                     "{:4.0f}"}},
+    {StatIndex::buffer_pool_bytes,          {"Buffer Pool Bytes per Frame",            "{:4.1f} KiB",   1.0f / 1024.0f}},
+    {StatIndex::buffer_block_requests,      {"Buffer Block Requests",                  "{:4.0f}"}},
+
+    {StatIndex::input_to_present_latency, {"Input to Present Latency",                 "{:3.1f} ms",    1000.0f}},
+    {StatIndex::queue_submit_latency,     {"Queue Submit Latency",                     "{:3.3f} ms",    1000.0f}},
+    {StatIndex::present_to_display_latency, {"Present to Display Latency",             "{:3.1f} ms",    1000.0f}},
+
+    {StatIndex::animation_time,           {"Animation Time",                           "{:3.2f} ms",    1000.0f}},
+
+    {StatIndex::thermal_headroom,         {"Thermal Headroom",                         "{:3.0f}%",      100.0f,                       true,     100.0f}},
     // clang-format on
 };
 
@@ -21,7 +21,9 @@
 
 #include <map>
 #include <set>
+#include <string>
 #include <unordered_map>
+#include <vector>
 
 namespace vkb
 {
@@ -40,6 +42,16 @@ class StatsProvider
 
 	using Counters = std::unordered_map<StatIndex, Counter, StatIndexHash>;
 
+	/**
+	 * @brief Counters attributed to a named scope of a command buffer, such as a subpass
+	 */
+	struct ScopeCounters
+	{
+		std::string name;
+
+		Counters counters;
+	};
+
 	/**
 	 * @brief Virtual Destructor
 	 */
@@ -83,6 +95,14 @@ class StatsProvider
 		return Counters();
 	}
 
+	/**
+	 * @brief Samples counters on the worker thread in polling mode with background counters,
+	 *        for providers accumulating them until sample() is called on the main thread
+	 */
+	virtual void background_sample()
+	{
+	}
+
 	/**
 	 * @brief A command buffer that we want stats about has just begun
 	 * @param cb The command buffer
@@ -97,6 +117,30 @@ class StatsProvider
 	virtual void end_sampling(CommandBuffer &cb)
 	{}
 
+	/**
+	 * @brief A subpass that we want stats about has just begun, within a sampled command buffer
+	 * @param cb The command buffer, recording the subpass inline
+	 * @param name The name of the subpass
+	 */
+	virtual void begin_subpass_sampling(CommandBuffer &cb, const std::string &name)
+	{}
+
+	/**
+	 * @brief A subpass that we want stats about is about to end
+	 * @param cb The command buffer
+	 */
+	virtual void end_subpass_sampling(CommandBuffer &cb)
+	{}
+
+	/**
+	 * @brief Retrieve the counters attributed to each subpass by the last sample
+	 * @return The counters of each subpass, in recording order, or none if the provider can't attribute them
+	 */
+	virtual std::vector<ScopeCounters> get_scope_counters() const
+	{
+		return {};
+	}
+
   protected:
 	static std::map<StatIndex, StatGraphData> default_graph_map;
 };
@@ -0,0 +1,127 @@
+/* Copyright (c) 2020, Arm Limited and Contributors
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 the "License";
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "stats_recorder.h"
+
+#include <chrono>
+#include <cmath>
+
+#include "common/logging.h"
+#include "platform/filesystem.h"
+#include "stats_provider.h"
+
+namespace vkb
+{
+namespace
+{
+/// How long the writer thread sleeps once it has written all the rows
+constexpr std::chrono::milliseconds WRITE_INTERVAL{100};
+}        // namespace
+
+StatsRecorder::StatsRecorder(const std::string &filename, const std::vector<StatIndex> &stats) :
+    stats{stats}
+{
+	auto path = fs::path::get(fs::path::Type::Graphs, filename);
+
+	file.open(path, std::ios::out | std::ios::trunc);
+
+	if (!file.good())
+	{
+		throw std::runtime_error("Could not open stats recording " + path);
+	}
+
+	// Enough digits for millisecond timestamps over hours of recording
+	file.precision(9);
+
+	file << "time";
+	for (auto stat : stats)
+	{
+		file << "," << StatsProvider::default_graph_data(stat).name;
+	}
+	file << "\n";
+
+	LOGI("Recording stats to {}", path);
+
+	timer.start();
+
+	writer_thread = std::thread([this] { write_rows(); });
+}
+
+StatsRecorder::~StatsRecorder()
+{
+	running = false;
+
+	if (writer_thread.joinable())
+	{
+		writer_thread.join();
+	}
+
+	if (dropped_rows > 0)
+	{
+		LOGW("Stats recording dropped {} samples", dropped_rows);
+	}
+}
+
+void StatsRecorder::record(const std::array<float, static_cast<size_t>(StatIndex::count)> &values)
+{
+	Row row;
+	row.time   = timer.elapsed();
+	row.values = values;
+
+	if (!rows.push(std::move(row)))
+	{
+		++dropped_rows;
+	}
+}
+
+void StatsRecorder::write_rows()
+{
+	// Check the flag before draining, so that rows pushed before destruction are all written
+	bool keep_running = true;
+
+	while (keep_running)
+	{
+		keep_running = running;
+
+		Row row;
+		while (rows.pop(row))
+		{
+			file << row.time;
+
+			for (auto stat : stats)
+			{
+				file << ",";
+
+				float value = row.values[static_cast<size_t>(stat)];
+				if (!std::isnan(value))
+				{
+					file << value;
+				}
+			}
+
+			file << "\n";
+		}
+
+		if (keep_running)
+		{
+			std::this_thread::sleep_for(WRITE_INTERVAL);
+		}
+	}
+
+	file.flush();
+}
+}        // namespace vkb
@@ -0,0 +1,95 @@
+/* Copyright (c) 2020, Arm Limited and Contributors
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 the "License";
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <fstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "spsc_ring.h"
+#include "stats_common.h"
+#include "timer.h"
+
+namespace vkb
+{
+/**
+ * @brief Streams raw samples of stats to a CSV file on a background thread
+ *
+ * The thread recording samples only copies them into a lock-free ring; formatting and file
+ * writes happen on the writer thread, so long captures do not disturb the measured frames.
+ */
+class StatsRecorder
+{
+  public:
+	/**
+	 * @brief Opens the file and starts the writer thread
+	 * @param filename Name of the CSV file, in the graphs directory
+	 * @param stats Stats recorded, one column each after the time column
+	 */
+	StatsRecorder(const std::string &filename, const std::vector<StatIndex> &stats);
+
+	StatsRecorder(const StatsRecorder &) = delete;
+
+	StatsRecorder &operator=(const StatsRecorder &) = delete;
+
+	/**
+	 * @brief Writes the remaining samples and closes the file
+	 */
+	~StatsRecorder();
+
+	/**
+	 * @brief Records a row of samples, must always be called from the same thread
+	 * @param values Raw value of each stat, indexed by StatIndex; stats without a sample are NaN
+	 */
+	void record(const std::array<float, static_cast<size_t>(StatIndex::count)> &values);
+
+  private:
+	struct Row
+	{
+		/// Seconds since the recording started
+		double time{0.0};
+
+		std::array<float, static_cast<size_t>(StatIndex::count)> values{};
+	};
+
+	/// Maximum number of rows waiting for the writer thread
+	static constexpr size_t ROW_CAPACITY{4096};
+
+	/// Stats recorded, in column order
+	std::vector<StatIndex> stats;
+
+	std::ofstream file;
+
+	Timer timer;
+
+	SpscRing<Row> rows{ROW_CAPACITY};
+
+	/// Rows dropped because the writer thread fell behind
+	size_t dropped_rows{0};
+
+	std::atomic<bool> running{true};
+
+	std::thread writer_thread;
+
+	/// Writes the rows in the ring until the recorder is destroyed
+	void write_rows();
+};
+}        // namespace vkb
@@ -0,0 +1,54 @@
+/* Copyright (c) 2020, Arm Limited and Contributors
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 the "License";
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "thermal_stats_provider.h"
+
+#include <cmath>
+
+#include "platform/platform.h"
+
+namespace vkb
+{
+ThermalStatsProvider::ThermalStatsProvider(std::set<StatIndex> &requested_stats) :
+    available{!std::isnan(Platform::get_thermal_headroom())}
+{
+	if (available)
+	{
+		requested_stats.erase(StatIndex::thermal_headroom);
+	}
+}
+
+bool ThermalStatsProvider::is_available(StatIndex index) const
+{
+	return available && index == StatIndex::thermal_headroom;
+}
+
+StatsProvider::Counters ThermalStatsProvider::sample(float delta_time)
+{
+	Counters res;
+
+	// The headroom is queried at most once per second, stats between queries repeat the last one
+	float headroom = Platform::get_thermal_headroom();
+
+	if (!std::isnan(headroom))
+	{
+		res[StatIndex::thermal_headroom].result = headroom;
+	}
+
+	return res;
+}
+}        // namespace vkb
@@ -74,6 +74,10 @@ VulkanStatsProvider::VulkanStatsProvider(std::set<StatIndex> &        requested_
 
 	bool performance_impact = false;
 
+	// Performance queries may only begin and end inside a subpass for counters in command scope
+	subpass_attribution = sampling_config.subpass_attribution;
+	bool command_scope  = true;
+
 	// Now build stat_data by matching vendor_data to Vulkan counter data
 	for (auto &s : vendor_data)
 	{
@@ -114,6 +118,7 @@ VulkanStatsProvider::VulkanStatsProvider(std::set<StatIndex> &        requested_
 
 			// Record the counter data
 			counter_indices.emplace_back(ctr_idx);
+			command_scope &= counters[ctr_idx].scope == VK_PERFORMANCE_COUNTER_SCOPE_COMMAND_KHR;
 			if (init.divisor_name == "")
 			{
 				stat_data[index] = StatData(ctr_idx, counters[ctr_idx].storage);
@@ -121,6 +126,7 @@ VulkanStatsProvider::VulkanStatsProvider(std::set<StatIndex> &        requested_
 			else
 			{
 				counter_indices.emplace_back(div_idx);
+				command_scope &= counters[div_idx].scope == VK_PERFORMANCE_COUNTER_SCOPE_COMMAND_KHR;
 				stat_data[index] = StatData(ctr_idx, counters[ctr_idx].storage, init.scaling,
 				                            div_idx, counters[div_idx].storage);
 			}
@@ -133,6 +139,12 @@ VulkanStatsProvider::VulkanStatsProvider(std::set<StatIndex> &        requested_
 	if (counter_indices.size() == 0)
 		return;        // No stats available
 
+	if (subpass_attribution && !command_scope)
+	{
+		LOGW("Requested Vulkan stats cannot be collected per subpass, sampling whole command buffers instead");
+		subpass_attribution = false;
+	}
+
 	// Acquire the profiling lock, without which we can't collect stats
 	VkAcquireProfilingLockInfoKHR info{};
 	info.sType   = VK_STRUCTURE_TYPE_ACQUIRE_PROFILING_LOCK_INFO_KHR;
@@ -218,6 +230,12 @@ bool VulkanStatsProvider::create_query_pools(uint32_t queue_family_index)
 	const PhysicalDevice &gpu              = device.get_gpu();
 	uint32_t              num_framebuffers = uint32_t(render_context.get_render_frames().size());
 
+	if (subpass_attribution)
+	{
+		queries_per_frame = MAX_SUBPASS_QUERIES;
+		subpass_names.resize(num_framebuffers);
+	}
+
 	// Now we know the available counters, we can build a query pool that will collect them.
 	// We will check that the counters can be collected in a single pass. Multi-pass would
 	// be a big performance hit so for these samples, we don't want to use it.
@@ -240,7 +258,7 @@ bool VulkanStatsProvider::create_query_pools(uint32_t queue_family_index)
 	pool_create_info.sType      = VK_STRUCTURE_TYPE_QUERY_POOL_CREATE_INFO;
 	pool_create_info.pNext      = &perf_create_info;
 	pool_create_info.queryType  = VK_QUERY_TYPE_PERFORMANCE_QUERY_KHR;
-	pool_create_info.queryCount = num_framebuffers;
+	pool_create_info.queryCount = num_framebuffers * queries_per_frame;
 
 	query_pool = std::make_unique<QueryPool>(device, pool_create_info);
 
@@ -253,7 +271,7 @@ bool VulkanStatsProvider::create_query_pools(uint32_t queue_family_index)
 	// Reset the query pool before first use. We cannot do these in the command buffer
 	// as that is invalid usage for performance queries due to the potential for multple
 	// passes being required.
-	query_pool->host_reset(0, num_framebuffers);
+	query_pool->host_reset(0, num_framebuffers * queries_per_frame);
 
 	if (has_timestamps)
 	{
@@ -331,7 +349,15 @@ void VulkanStatsProvider::begin_sampling(CommandBuffer &cb)
 	}
 
 	if (query_pool)
-		cb.begin_query(*query_pool, active_frame_idx, VkQueryControlFlags(0));
+	{
+		// With subpass attribution, each subpass begins its own query instead
+		if (subpass_attribution)
+			subpass_names[active_frame_idx].clear();
+		else
+			cb.begin_query(*query_pool, active_frame_idx, VkQueryControlFlags(0));
+	}
+
+	sampling = true;
 }
 
 void VulkanStatsProvider::end_sampling(CommandBuffer &cb)
@@ -340,18 +366,14 @@ void VulkanStatsProvider::end_sampling(CommandBuffer &cb)
 
 	if (query_pool)
 	{
-		// Perform a barrier to ensure all previous commands complete before ending the query
-		// This does not block later commands from executing as we use BOTTOM_OF_PIPE in the
-		// dst stage mask
-		vkCmdPipelineBarrier(cb.get_handle(),
-		                     VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT,
-		                     VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT,
-		                     0, 0, nullptr, 0, nullptr, 0, nullptr);
-		cb.end_query(*query_pool, active_frame_idx);
+		if (!subpass_attribution)
+			end_performance_query(cb, active_frame_idx);
 
 		++queries_ready;
 	}
 
+	sampling = false;
+
 	if (timestamp_pool)
 	{
 		cb.reset_query_pool(*timestamp_pool, active_frame_idx * 2 + 1, 1);
@@ -360,6 +382,56 @@ void VulkanStatsProvider::end_sampling(CommandBuffer &cb)
 	}
 }
 
+void VulkanStatsProvider::begin_subpass_sampling(CommandBuffer &cb, const std::string &name)
+{
+	if (!query_pool || !subpass_attribution || !sampling)
+		return;
+
+	uint32_t active_frame_idx = render_context.get_active_frame_index();
+	auto &   names            = subpass_names[active_frame_idx];
+
+	if (names.size() == MAX_SUBPASS_QUERIES)
+		return;        // Out of queries for this frame
+
+	cb.begin_query(*query_pool, active_frame_idx * queries_per_frame + uint32_t(names.size()), VkQueryControlFlags(0));
+	names.push_back(name);
+
+	subpass_active = true;
+}
+
+void VulkanStatsProvider::end_subpass_sampling(CommandBuffer &cb)
+{
+	if (!subpass_active)
+		return;
+
+	uint32_t active_frame_idx = render_context.get_active_frame_index();
+	auto &   names            = subpass_names[active_frame_idx];
+
+	// No barrier here as it would need a subpass self-dependency, counters in command scope
+	// only measure the commands recorded within the query anyway
+	cb.end_query(*query_pool, active_frame_idx * queries_per_frame + uint32_t(names.size()) - 1);
+
+	subpass_active = false;
+}
+
+void VulkanStatsProvider::end_performance_query(CommandBuffer &cb, uint32_t query)
+{
+	// Perform a barrier to ensure all previous commands complete before ending the query
+	// This does not block later commands from executing as we use BOTTOM_OF_PIPE in the
+	// dst stage mask
+	cb.flush_barriers();
+	vkCmdPipelineBarrier(cb.get_handle(),
+	                     VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT,
+	                     VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT,
+	                     0, 0, nullptr, 0, nullptr, 0, nullptr);
+	cb.end_query(*query_pool, query);
+}
+
+std::vector<StatsProvider::ScopeCounters> VulkanStatsProvider::get_scope_counters() const
+{
+	return scope_counters;
+}
+
 static double get_counter_value(const VkPerformanceCounterResultKHR &result,
                                 VkPerformanceCounterStorageKHR       storage)
 {
@@ -408,6 +480,58 @@ float VulkanStatsProvider::get_best_delta_time(float sw_delta_time) const
 	return delta_time;
 }
 
+VulkanStatsProvider::RawCounterMap VulkanStatsProvider::read_counters(const VkPerformanceCounterResultKHR *results) const
+{
+	RawCounterMap raw_counters;
+
+	// Parse the results - they are in the order we gave in counter_indices
+	for (const auto &s : stat_data)
+	{
+		bool   need_divisor  = (s.second.scaling == StatScaling::ByCounter);
+		double divisor_value = 1.0;
+		double value         = 0.0;
+		bool   found_ctr = false, found_div = !need_divisor;
+
+		for (uint32_t i = 0; !(found_ctr && found_div) && i < counter_indices.size(); i++)
+		{
+			if (s.second.counter_index == counter_indices[i])
+			{
+				value     = get_counter_value(results[i], s.second.storage);
+				found_ctr = true;
+			}
+			if (need_divisor && s.second.divisor_counter_index == counter_indices[i])
+			{
+				divisor_value = get_counter_value(results[i], s.second.divisor_storage);
+				found_div     = true;
+			}
+		}
+
+		if (found_ctr && found_div)
+			raw_counters[s.first] = {value, divisor_value};
+	}
+
+	return raw_counters;
+}
+
+StatsProvider::Counters VulkanStatsProvider::scale_counters(const RawCounterMap &raw_counters, float delta_time) const
+{
+	Counters out;
+
+	for (const auto &c : raw_counters)
+	{
+		StatScaling scaling = stat_data.at(c.first).scaling;
+		double      value   = c.second.value;
+
+		if (scaling == StatScaling::ByDeltaTime && delta_time != 0.0)
+			value /= delta_time;
+		else if (scaling == StatScaling::ByCounter && c.second.divisor != 0.0)
+			value /= c.second.divisor;
+		out[c.first].result = value;
+	}
+
+	return out;
+}
+
 StatsProvider::Counters VulkanStatsProvider::sample(float delta_time)
 {
 	Counters out;
@@ -416,11 +540,23 @@ StatsProvider::Counters VulkanStatsProvider::sample(float delta_time)
 
 	uint32_t active_frame_idx = render_context.get_active_frame_index();
 
+	// Without subpass attribution the whole command buffer is in a single query
+	uint32_t first_query = active_frame_idx * queries_per_frame;
+	uint32_t num_queries = subpass_attribution ? uint32_t(subpass_names[active_frame_idx].size()) : 1;
+
+	if (num_queries == 0)
+	{
+		// No subpass was sampled in this frame
+		scope_counters.clear();
+		--queries_ready;
+		return out;
+	}
+
 	VkDeviceSize stride = sizeof(VkPerformanceCounterResultKHR) * counter_indices.size();
 
-	std::vector<VkPerformanceCounterResultKHR> results(counter_indices.size());
+	std::vector<VkPerformanceCounterResultKHR> results(counter_indices.size() * num_queries);
 
-	VkResult r = query_pool->get_results(active_frame_idx, 1,
+	VkResult r = query_pool->get_results(first_query, num_queries,
 	                                     results.size() * sizeof(VkPerformanceCounterResultKHR),
 	                                     results.data(), stride, VK_QUERY_RESULT_WAIT_BIT);
 	if (r != VK_SUCCESS)
@@ -429,42 +565,34 @@ StatsProvider::Counters VulkanStatsProvider::sample(float delta_time)
 	// Use timestamps to get a more accurate delta if available
 	delta_time = get_best_delta_time(delta_time);
 
-	// Parse the results - they are in the order we gave in counter_indices
-	for (const auto &s : stat_data)
+	if (subpass_attribution)
 	{
-		StatIndex si = s.first;
-
-		bool   need_divisor  = (stat_data[si].scaling == StatScaling::ByCounter);
-		double divisor_value = 1.0;
-		double value         = 0.0;
-		bool   found_ctr = false, found_div = !need_divisor;
+		// Rates of subpasses are over the whole command buffer, so that they add up to its own
+		RawCounterMap totals;
+		scope_counters.clear();
 
-		for (uint32_t i = 0; !(found_ctr && found_div) && i < counter_indices.size(); i++)
+		for (uint32_t q = 0; q < num_queries; q++)
 		{
-			if (s.second.counter_index == counter_indices[i])
-			{
-				value     = get_counter_value(results[i], stat_data[si].storage);
-				found_ctr = true;
-			}
-			if (need_divisor && s.second.divisor_counter_index == counter_indices[i])
+			auto raw_counters = read_counters(&results[q * counter_indices.size()]);
+
+			for (const auto &c : raw_counters)
 			{
-				divisor_value = get_counter_value(results[i], stat_data[si].divisor_storage);
-				found_div     = true;
+				totals[c.first].value += c.second.value;
+				totals[c.first].divisor += c.second.divisor;
 			}
-		}
 
-		if (found_ctr && found_div)
-		{
-			if (stat_data[si].scaling == StatScaling::ByDeltaTime && delta_time != 0.0)
-				value /= delta_time;
-			else if (stat_data[si].scaling == StatScaling::ByCounter && divisor_value != 0.0)
-				value /= divisor_value;
-			out[si].result = value;
+			scope_counters.push_back({subpass_names[active_frame_idx][q], scale_counters(raw_counters, delta_time)});
 		}
+
+		out = scale_counters(totals, delta_time);
+	}
+	else
+	{
+		out = scale_counters(read_counters(results.data()), delta_time);
 	}
 
-	// Now reset the query we just fetched the results from
-	query_pool->host_reset(active_frame_idx, 1);
+	// Now reset the queries we just fetched the results from
+	query_pool->host_reset(first_query, num_queries);
 
 	--queries_ready;
 
@@ -73,8 +73,15 @@ class VulkanStatsProvider : public StatsProvider
 		StatGraphData graph_data;
 	};
 
+	struct RawCounter
+	{
+		double value{0.0};
+		double divisor{0.0};
+	};
+
 	using StatDataMap   = std::unordered_map<StatIndex, StatData, StatIndexHash>;
 	using VendorStatMap = std::unordered_map<StatIndex, VendorStat, StatIndexHash>;
+	using RawCounterMap = std::unordered_map<StatIndex, RawCounter, StatIndexHash>;
 
   public:
 	/**
@@ -122,6 +129,27 @@ class VulkanStatsProvider : public StatsProvider
 	 */
 	void end_sampling(CommandBuffer &cb) override;
 
+	/**
+	 * @brief A subpass that we want stats about has just begun, within a sampled command buffer
+	 * @param cb The command buffer, recording the subpass inline
+	 * @param name The name of the subpass
+	 */
+	void begin_subpass_sampling(CommandBuffer &cb, const std::string &name) override;
+
+	/**
+	 * @brief A subpass that we want stats about is about to end
+	 * @param cb The command buffer
+	 */
+	void end_subpass_sampling(CommandBuffer &cb) override;
+
+	/**
+	 * @brief Retrieve the counters attributed to each subpass by the last sample
+	 */
+	std::vector<ScopeCounters> get_scope_counters() const override;
+
+	/// Maximum number of subpasses attributed per frame, the following ones are only part of the totals
+	static constexpr uint32_t MAX_SUBPASS_QUERIES = 16;
+
   private:
 	bool is_supported(const CounterSamplingConfig &sampling_config) const;
 
@@ -131,6 +159,12 @@ class VulkanStatsProvider : public StatsProvider
 
 	float get_best_delta_time(float sw_delta_time) const;
 
+	RawCounterMap read_counters(const VkPerformanceCounterResultKHR *results) const;
+
+	Counters scale_counters(const RawCounterMap &raw_counters, float delta_time) const;
+
+	void end_performance_query(CommandBuffer &cb, uint32_t query);
+
   private:
 	// The render context
 	RenderContext &render_context;
@@ -158,6 +192,24 @@ class VulkanStatsProvider : public StatsProvider
 
 	// How many queries have been ended?
 	uint32_t queries_ready = 0;
+
+	// Whether each subpass gets its own query instead of the whole command buffer
+	bool subpass_attribution{false};
+
+	// Number of performance queries of each frame in the query pool
+	uint32_t queries_per_frame{1};
+
+	// Whether a command buffer is being sampled
+	bool sampling{false};
+
+	// Whether a subpass query has begun and not ended yet
+	bool subpass_active{false};
+
+	// Names of the subpasses whose queries were recorded for each frame
+	std::vector<std::vector<std::string>> subpass_names;
+
+	// Counters of each subpass from the last sample
+	std::vector<ScopeCounters> scope_counters;
 };
 
 }        // namespace vkb
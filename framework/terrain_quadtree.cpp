@@ -0,0 +1,181 @@
+/* Copyright (c) 2020, Arm Limited and Contributors
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 the "License";
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "terrain_quadtree.h"
+
+#include <algorithm>
+#include <limits>
+
+#include "geometry/frustum.h"
+#include "heightmap.h"
+
+namespace vkb
+{
+namespace
+{
+/**
+ * @return Whether a sphere intersects an axis aligned box
+ */
+bool intersects_sphere(const glm::vec3 &min, const glm::vec3 &max, const glm::vec3 &center, float radius)
+{
+	glm::vec3 closest = glm::clamp(center, min, max);
+	glm::vec3 delta   = closest - center;
+	return glm::dot(delta, delta) <= radius * radius;
+}
+}        // namespace
+
+TerrainQuadtree::TerrainQuadtree(HeightMap &heightmap, uint32_t resolution, const glm::vec2 &origin, float size, float height_scale, uint32_t lod_count) :
+    origin{origin},
+    size{size},
+    lod_count{lod_count}
+{
+	const uint32_t leaf_count = 1u << (lod_count - 1);
+
+	// Leaves cover their height map samples up to the first sample of the next leaf
+	height_bounds.resize(lod_count);
+	height_bounds[0].resize(leaf_count * leaf_count);
+
+	for (uint32_t y = 0; y < leaf_count; ++y)
+	{
+		for (uint32_t x = 0; x < leaf_count; ++x)
+		{
+			float min_height = std::numeric_limits<float>::max();
+			float max_height = std::numeric_limits<float>::lowest();
+
+			for (uint32_t sy = y * resolution / leaf_count; sy <= std::min((y + 1) * resolution / leaf_count, resolution - 1); ++sy)
+			{
+				for (uint32_t sx = x * resolution / leaf_count; sx <= std::min((x + 1) * resolution / leaf_count, resolution - 1); ++sx)
+				{
+					float height = heightmap.get_height(sx, sy);
+					min_height   = std::min(min_height, height);
+					max_height   = std::max(max_height, height);
+				}
+			}
+
+			height_bounds[0][y * leaf_count + x] = glm::vec2(-max_height, -min_height) * height_scale;
+		}
+	}
+
+	for (uint32_t lod = 1; lod < lod_count; ++lod)
+	{
+		const uint32_t count       = leaf_count >> lod;
+		const uint32_t child_count = count * 2;
+
+		height_bounds[lod].resize(count * count);
+
+		for (uint32_t y = 0; y < count; ++y)
+		{
+			for (uint32_t x = 0; x < count; ++x)
+			{
+				glm::vec2 bounds = height_bounds[lod - 1][(2 * y) * child_count + 2 * x];
+				for (uint32_t child = 1; child < 4; ++child)
+				{
+					const glm::vec2 &child_bounds = height_bounds[lod - 1][(2 * y + child / 2) * child_count + 2 * x + child % 2];
+
+					bounds.x = std::min(bounds.x, child_bounds.x);
+					bounds.y = std::max(bounds.y, child_bounds.y);
+				}
+				height_bounds[lod][y * count + x] = bounds;
+			}
+		}
+	}
+}
+
+void TerrainQuadtree::set_lod_range(float range)
+{
+	lod_range = range;
+}
+
+float TerrainQuadtree::get_lod_range() const
+{
+	return lod_range;
+}
+
+uint32_t TerrainQuadtree::get_max_node_count() const
+{
+	const uint32_t leaf_count = 1u << (lod_count - 1);
+	return leaf_count * leaf_count;
+}
+
+void TerrainQuadtree::select(const glm::vec3 &camera_position, Frustum &frustum, std::vector<Node> &nodes) const
+{
+	nodes.clear();
+
+	// The root is drawn when the camera is beyond the coarsest range
+	const uint32_t root = lod_count - 1;
+	if (!select_node(root, 0, 0, camera_position, frustum, nodes))
+	{
+		nodes.push_back({origin, size, get_range(root)});
+	}
+}
+
+bool TerrainQuadtree::select_node(uint32_t lod, uint32_t x, uint32_t y, const glm::vec3 &camera_position, Frustum &frustum, std::vector<Node> &nodes) const
+{
+	glm::vec3 min;
+	glm::vec3 max;
+	get_bounds(lod, x, y, min, max);
+
+	// Culled nodes are handled, as their area is not drawn at all
+	if (!frustum.check_sphere(0.5f * (min + max), 0.5f * glm::length(max - min)))
+	{
+		return true;
+	}
+
+	if (!intersects_sphere(min, max, camera_position, get_range(lod)))
+	{
+		return false;
+	}
+
+	const float node_size = size / static_cast<float>(1u << (lod_count - 1 - lod));
+
+	if (lod == 0 || !intersects_sphere(min, max, camera_position, get_range(lod - 1)))
+	{
+		nodes.push_back({glm::vec2(min.x, min.z), node_size, get_range(lod)});
+		return true;
+	}
+
+	// Children out of their range are drawn at their size, fully morphed into this level
+	for (uint32_t child = 0; child < 4; ++child)
+	{
+		uint32_t child_x = 2 * x + child % 2;
+		uint32_t child_y = 2 * y + child / 2;
+
+		if (!select_node(lod - 1, child_x, child_y, camera_position, frustum, nodes))
+		{
+			glm::vec2 child_offset = origin + glm::vec2(child_x, child_y) * (0.5f * node_size);
+			nodes.push_back({child_offset, 0.5f * node_size, get_range(lod - 1)});
+		}
+	}
+
+	return true;
+}
+
+void TerrainQuadtree::get_bounds(uint32_t lod, uint32_t x, uint32_t y, glm::vec3 &min, glm::vec3 &max) const
+{
+	const uint32_t   count     = 1u << (lod_count - 1 - lod);
+	const float      node_size = size / static_cast<float>(count);
+	const glm::vec2 &bounds    = height_bounds[lod][y * count + x];
+
+	min = glm::vec3(origin.x + x * node_size, bounds.x, origin.y + y * node_size);
+	max = glm::vec3(min.x + node_size, bounds.y, min.z + node_size);
+}
+
+float TerrainQuadtree::get_range(uint32_t lod) const
+{
+	return lod_range * static_cast<float>(1u << lod);
+}
+}        // namespace vkb
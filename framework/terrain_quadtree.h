@@ -0,0 +1,119 @@
+/* Copyright (c) 2020, Arm Limited and Contributors
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 the "License";
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <vector>
+
+#include "common/error.h"
+
+VKBP_DISABLE_WARNINGS()
+#include "common/glm_common.h"
+VKBP_ENABLE_WARNINGS()
+
+namespace vkb
+{
+class Frustum;
+class HeightMap;
+
+/**
+ * @brief Selects the nodes of a continuous distance-dependent level of detail (CDLOD) terrain
+ *
+ * The terrain is a quadtree whose leaves are the finest nodes. Each level of detail covers twice the distance of
+ * the previous one, and a node is drawn when the camera is within its range but not within the range of its
+ * children. Every node is drawn with the same grid mesh, whose vertices morph towards the grid of the parent level
+ * as they approach the end of the node range, so that neighbouring levels meet without cracks. The number of
+ * vertices drawn depends on the ranges rather than on the size of the terrain.
+ */
+class TerrainQuadtree
+{
+  public:
+	/**
+	 * @brief Node to draw, matching the per instance data of the grid mesh
+	 */
+	struct Node
+	{
+		/// Corner of the node on the xz plane
+		glm::vec2 offset;
+
+		/// Width and depth of the node
+		float size;
+
+		/// Distance from the camera where the node is fully morphed into its parent
+		float range;
+	};
+
+	/**
+	 * @brief Computes the height bounds of each node from a height map
+	 * @param heightmap Height map the terrain is displaced by, along negative y
+	 * @param resolution Samples across the height map, the patch size it was loaded with
+	 * @param origin Corner of the terrain on the xz plane
+	 * @param size Width and depth of the terrain
+	 * @param height_scale Displacement of the terrain for the highest height map value
+	 * @param lod_count Levels of detail, the leaves are 2^(lod_count - 1) times smaller than the terrain
+	 */
+	TerrainQuadtree(HeightMap &heightmap, uint32_t resolution, const glm::vec2 &origin, float size, float height_scale, uint32_t lod_count);
+
+	/**
+	 * @param range Distance covered by the finest level of detail, each following level covering twice the previous one
+	 */
+	void set_lod_range(float range);
+
+	float get_lod_range() const;
+
+	/**
+	 * @return The largest number of nodes a selection can return
+	 */
+	uint32_t get_max_node_count() const;
+
+	/**
+	 * @brief Selects the nodes to draw from a camera position, skipping those outside of the view frustum
+	 * @param camera_position Position of the camera
+	 * @param frustum View frustum of the camera
+	 * @param nodes Nodes to draw, replaced by the selection
+	 */
+	void select(const glm::vec3 &camera_position, Frustum &frustum, std::vector<Node> &nodes) const;
+
+  private:
+	/**
+	 * @brief Selects a node, or its children if the camera is close enough
+	 * @return Whether the node was handled, false if it is out of its range so the parent has to draw its area
+	 */
+	bool select_node(uint32_t lod, uint32_t x, uint32_t y, const glm::vec3 &camera_position, Frustum &frustum, std::vector<Node> &nodes) const;
+
+	/**
+	 * @brief Computes the bounds of a node, with the height of the displaced terrain
+	 */
+	void get_bounds(uint32_t lod, uint32_t x, uint32_t y, glm::vec3 &min, glm::vec3 &max) const;
+
+	/**
+	 * @return Distance covered by a level of detail
+	 */
+	float get_range(uint32_t lod) const;
+
+	glm::vec2 origin;
+
+	float size;
+
+	uint32_t lod_count;
+
+	float lod_range{8.0f};
+
+	/// Lowest and highest y of the nodes, per level of detail from the leaves, in row major order
+	std::vector<std::vector<glm::vec2>> height_bounds;
+};
+}        // namespace vkb
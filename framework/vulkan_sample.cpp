@@ -17,6 +17,9 @@
 
 #include "vulkan_sample.h"
 
+#include <cctype>
+#include <cstring>
+
 #include "common/error.h"
 
 VKBP_DISABLE_WARNINGS()
@@ -31,11 +34,14 @@ VKBP_ENABLE_WARNINGS()
 #include "common/utils.h"
 #include "common/vk_common.h"
 #include "gltf_loader.h"
+#include "job_system.h"
+#include "platform/filesystem.h"
 #include "platform/platform.h"
 #include "platform/window.h"
 #include "scene_graph/components/camera.h"
 #include "scene_graph/script.h"
 #include "scene_graph/scripts/free_camera.h"
+#include "stats/cpu_profiler.h"
 
 #if defined(VK_USE_PLATFORM_ANDROID_KHR)
 #	include "platform/android/android_platform.h"
@@ -43,17 +49,114 @@ VKBP_ENABLE_WARNINGS()
 
 namespace vkb
 {
+namespace
+{
+/**
+ * @brief Identifies the device and driver which produced persisted cache data,
+ *        it is written at the beginning of every file in the pipeline cache directory
+ */
+struct PipelineCacheKey
+{
+	uint32_t vendor_id{0};
+
+	uint32_t device_id{0};
+
+	uint32_t driver_version{0};
+
+	uint8_t pipeline_cache_uuid[VK_UUID_SIZE]{};
+};
+
+PipelineCacheKey get_pipeline_cache_key(const PhysicalDevice &gpu)
+{
+	auto properties = gpu.get_properties();
+
+	PipelineCacheKey key{};
+	key.vendor_id      = properties.vendorID;
+	key.device_id      = properties.deviceID;
+	key.driver_version = properties.driverVersion;
+	std::memcpy(key.pipeline_cache_uuid, properties.pipelineCacheUUID, VK_UUID_SIZE);
+
+	return key;
+}
+
+/**
+ * @brief Maps a file written by write_keyed_file, its payload follows the key
+ * @return The mapped file, or nullptr if the file is missing or was produced by another device or driver
+ */
+std::unique_ptr<fs::MappedFile> map_keyed_file(const std::string &filename, const PipelineCacheKey &key)
+{
+	std::unique_ptr<fs::MappedFile> file;
+
+	try
+	{
+		file = std::make_unique<fs::MappedFile>(filename);
+	}
+	catch (std::runtime_error &ex)
+	{
+		LOGW("No persisted cache data found. {}", ex.what());
+		return nullptr;
+	}
+
+	if (file->size() < sizeof(PipelineCacheKey) || std::memcmp(file->data(), &key, sizeof(PipelineCacheKey)) != 0)
+	{
+		LOGW("Discarding stale cache data from a different device or driver: {}", filename);
+		return nullptr;
+	}
+
+	return file;
+}
+
+void write_keyed_file(const std::string &filename, const PipelineCacheKey &key, const std::vector<uint8_t> &payload)
+{
+	std::vector<uint8_t> data = to_bytes(key);
+	data.insert(data.end(), payload.begin(), payload.end());
+
+	fs::write_file(data, filename);
+}
+
+std::string get_pipeline_cache_prefix(const std::string &directory, const std::string &sample_name)
+{
+	std::string prefix = sample_name;
+	std::replace_if(
+	    prefix.begin(), prefix.end(), [](char c) { return !std::isalnum(static_cast<unsigned char>(c)); }, '_');
+
+	return directory + "/" + prefix;
+}
+}        // namespace
+
 VulkanSample::~VulkanSample()
 {
+	// The simulation refers to the scene
+	if (simulation.valid())
+	{
+		simulation.wait();
+	}
+
 	if (device)
 	{
 		device->wait_idle();
+
+		save_pipeline_cache();
+	}
+
+	if (render_context && !pipeline_cache_directory.empty())
+	{
+		save_buffer_pool_demands();
 	}
 
+	screenshot_capture.reset();
+	scene_loader.reset();
 	scene.reset();
 
 	stats.reset();
 	gui.reset();
+	dynamic_resolution.reset();
+	multisample_resolve.reset();
+	frame_spike_detector.reset();
+	gpu_profiler.reset();
+	render_pass_analyzer.reset();
+	frame_strategy_tuner.reset();
+	shader_reloader.reset();
 	render_context.reset();
 	device.reset();
 
@@ -68,6 +171,16 @@ VulkanSample::~VulkanSample()
 void VulkanSample::set_render_pipeline(RenderPipeline &&rp)
 {
 	render_pipeline = std::make_unique<RenderPipeline>(std::move(rp));
+
+	if (parallel_recording)
+	{
+		render_pipeline->set_parallel_recording(true);
+	}
+
+	if (multisample_resolve)
+	{
+		multisample_resolve->apply(*render_pipeline);
+	}
 }
 
 RenderPipeline &VulkanSample::get_render_pipeline()
@@ -87,12 +200,12 @@ bool VulkanSample::prepare(Platform &platform)
 
 	// Creating the vulkan instance
 	add_instance_extension(platform.get_surface_extension());
-	instance = std::make_unique<Instance>(get_name(), get_instance_extensions(), get_validation_layers(), is_headless());
+	instance = std::make_unique<Instance>(get_name(), get_instance_extensions(), get_validation_layers(), is_headless(), api_version);
 
 	// Getting a valid vulkan surface from the platform
 	surface = platform.get_window().create_surface(*instance);
 
-	auto &gpu = instance->get_suitable_gpu();
+	auto &gpu = gpu_index < 0 ? instance->get_suitable_gpu(surface) : instance->get_gpu(static_cast<size_t>(gpu_index));
 
 	// Request to enable ASTC
 	if (gpu.get_features().textureCompressionASTC_LDR)
@@ -103,16 +216,29 @@ bool VulkanSample::prepare(Platform &platform)
 	// Request sample required GPU features
 	request_gpu_features(gpu);
 
+	// Pipelines report their creation time and whether they hit the pipeline cache
+	add_device_extension(VK_EXT_PIPELINE_CREATION_FEEDBACK_EXTENSION_NAME, true);
+
 	// Creating vulkan device, specifying the swapchain extension always
 	if (!is_headless() || instance->is_enabled(VK_EXT_HEADLESS_SURFACE_EXTENSION_NAME))
 	{
 		add_device_extension(VK_KHR_SWAPCHAIN_EXTENSION_NAME);
 	}
 
-	device = std::make_unique<vkb::Device>(gpu, surface, get_device_extensions());
+	device = std::make_unique<vkb::Device>(gpu, surface, get_device_extensions(), device_group ? instance->get_gpu_group(gpu) : std::vector<PhysicalDevice *>{});
+
+	if (shader_reload)
+	{
+		shader_reloader = std::make_unique<ShaderReloader>(device->get_resource_cache());
+	}
 
 	// Preparing render context for rendering
 	render_context = std::make_unique<vkb::RenderContext>(*device, surface, platform.get_window().get_width(), platform.get_window().get_height());
+	if (device_group)
+	{
+		render_context->set_alternate_frame_rendering(true);
+	}
+
 	render_context->set_present_mode_priority({VK_PRESENT_MODE_FIFO_KHR,
 	                                           VK_PRESENT_MODE_MAILBOX_KHR});
 
@@ -121,22 +247,464 @@ bool VulkanSample::prepare(Platform &platform)
 	                                             {VK_FORMAT_R8G8B8A8_UNORM, VK_COLOR_SPACE_SRGB_NONLINEAR_KHR},
 	                                             {VK_FORMAT_B8G8R8A8_UNORM, VK_COLOR_SPACE_SRGB_NONLINEAR_KHR}});
 
+	if (frame_count > 0)
+	{
+		render_context->request_frame_count(frame_count);
+	}
+
+	render_context->set_present_latency_mode(present_latency_mode);
+
+	if (resource_cache_budget > 0)
+	{
+		ResourceCacheBudget budget;
+		budget.descriptor_sets    = resource_cache_budget;
+		budget.framebuffers       = resource_cache_budget;
+		budget.graphics_pipelines = resource_cache_budget;
+		budget.compute_pipelines  = resource_cache_budget;
+
+		device->get_resource_cache().set_budget(budget);
+		render_context->set_descriptor_set_budget(resource_cache_budget);
+	}
+
 	prepare_render_context();
 
+	if (multisample_resolve && multisample_resolve->get_info().color_resolve_mode == ColorResolveMode::Separate)
+	{
+		// The multisampled color is resolved to the swapchain images with a transfer
+		render_context->add_swapchain_usage(VK_IMAGE_USAGE_TRANSFER_DST_BIT);
+	}
+
 	stats = std::make_unique<vkb::Stats>(*render_context);
+	render_context->set_stats(stats.get());
+
+	// Benchmarks sample the GPU time of frames
+	if (gpu_profiling || frame_spike_capture || is_benchmark_mode())
+	{
+		if (GpuProfiler::is_supported(*render_context))
+		{
+			gpu_profiler = std::make_unique<GpuProfiler>(*render_context);
+			render_context->set_gpu_profiler(gpu_profiler.get());
+		}
+		else
+		{
+			LOGW("GPU profiling needs timestamp support, it is disabled");
+		}
+	}
+
+	if (frame_spike_capture)
+	{
+		frame_spike_detector = std::make_unique<FrameSpikeDetector>(*render_context, get_name());
+	}
+
+	if (render_pass_analysis)
+	{
+		render_pass_analyzer = std::make_unique<RenderPassAnalyzer>(*render_context);
+		render_context->set_render_pass_analyzer(render_pass_analyzer.get());
+	}
+
+	if (frame_strategy_tuning)
+	{
+		frame_strategy_tuner = std::make_unique<FrameStrategyTuner>();
+		render_context->set_frame_strategy_tuner(frame_strategy_tuner.get());
+	}
+
+	if (!pipeline_cache_directory.empty())
+	{
+		load_pipeline_cache();
+		load_buffer_pool_demands();
+	}
 
 	return true;
 }
 
+void VulkanSample::set_pipeline_cache_directory(const std::string &directory)
+{
+	pipeline_cache_directory = directory;
+}
+
+void VulkanSample::set_progressive_scene_loading(bool progressive)
+{
+	progressive_scene_loading = progressive;
+}
+
+void VulkanSample::set_interleaved_scene_vertices(bool interleaved)
+{
+	interleaved_scene_vertices = interleaved;
+}
+
+void VulkanSample::set_scene_cache(bool enable)
+{
+	scene_cache = enable;
+}
+
+void VulkanSample::set_asset_memory_cache(bool enable)
+{
+	asset_memory_cache = enable;
+}
+
+void VulkanSample::set_scene_geometry_buffer_usage(VkBufferUsageFlags usage)
+{
+	scene_geometry_buffer_usage = usage;
+}
+
+void VulkanSample::set_shared_scene_geometry(bool shared)
+{
+	shared_scene_geometry = shared;
+}
+
+void VulkanSample::record_benchmark_samples(BenchmarkReport &report)
+{
+	if (device)
+	{
+		report.set_device(device->get_gpu().get_properties().deviceName);
+
+		VmaStats memory_stats;
+		vmaCalculateStats(device->get_memory_allocator(), &memory_stats);
+
+		report.add_sample("device_memory_mb", memory_stats.total.usedBytes / (1024.0 * 1024.0));
+	}
+
+	if (gpu_profiler)
+	{
+		for (const auto &timing : gpu_profiler->get_timings())
+		{
+			if (timing.depth == 0 && timing.name == "Frame")
+			{
+				report.add_sample("gpu_frame_time_ms", timing.last_time);
+			}
+		}
+	}
+
+	if (stats)
+	{
+		for (const auto &stat_index : stats->get_requested_stats())
+		{
+			if (stats->is_available(stat_index) && !stats->get_data(stat_index).empty())
+			{
+				const auto &graph_data = stats->get_graph_data(stat_index);
+
+				report.add_sample(graph_data.name, stats->get_data(stat_index).latest() * graph_data.scale_factor);
+			}
+		}
+	}
+}
+
+void VulkanSample::set_gpu_profiling(bool enable)
+{
+	gpu_profiling = enable;
+}
+
+void VulkanSample::set_frame_spike_capture(bool enable)
+{
+	frame_spike_capture = enable;
+}
+
+void VulkanSample::set_stats_recording(bool enable)
+{
+	stats_recording = enable;
+}
+
+void VulkanSample::set_render_pass_analysis(bool enable)
+{
+	render_pass_analysis = enable;
+}
+
+void VulkanSample::set_frame_strategy_tuning(bool enable)
+{
+	frame_strategy_tuning = enable;
+}
+
+void VulkanSample::set_decoupled_simulation(bool enable)
+{
+	decoupled_simulation = enable;
+}
+
+void VulkanSample::set_parallel_recording(bool enable)
+{
+	parallel_recording = enable;
+}
+
+void VulkanSample::apply_settings(const VulkanSampleSettings &settings)
+{
+	if (!settings.pipeline_cache_directory.empty())
+	{
+		set_pipeline_cache_directory(settings.pipeline_cache_directory);
+	}
+
+	// Options only enable features, so that the ones a sample enables itself are kept
+	progressive_scene_loading |= settings.progressive_scene_loading;
+	scene_cache               |= settings.scene_cache;
+	asset_memory_cache        |= settings.asset_memory_cache;
+	gpu_profiling             |= settings.gpu_profiling;
+	frame_spike_capture       |= settings.frame_spike_capture;
+	stats_recording           |= settings.stats_recording;
+	render_pass_analysis      |= settings.render_pass_analysis;
+	frame_strategy_tuning     |= settings.frame_strategy_tuning;
+	decoupled_simulation      |= settings.decoupled_simulation;
+	parallel_recording        |= settings.parallel_recording;
+	shader_reload             |= settings.shader_reload;
+
+	if (settings.device_group)
+	{
+		set_device_group(true);
+	}
+
+	if (settings.multisample.sample_count != VK_SAMPLE_COUNT_1_BIT)
+	{
+		set_multisample(settings.multisample);
+	}
+
+	if (settings.frame_count > 0)
+	{
+		set_frame_count(settings.frame_count);
+	}
+
+	if (settings.present_latency_mode != PresentLatencyMode::Default)
+	{
+		set_present_latency_mode(settings.present_latency_mode);
+	}
+
+	if (settings.resource_cache_budget > 0)
+	{
+		set_resource_cache_budget(settings.resource_cache_budget);
+	}
+
+	if (settings.screenshots)
+	{
+		set_screenshot_interval(settings.screenshot_interval, settings.screenshot_format);
+	}
+
+	if (settings.gpu_index >= 0)
+	{
+		set_gpu_index(to_u32(settings.gpu_index));
+	}
+
+	if (settings.configuration_index >= 0)
+	{
+		configuration.expand_permutations();
+
+		if (!configuration.select(to_u32(settings.configuration_index)))
+		{
+			LOGW("Sample has {} configurations, ignoring configuration {}", configuration.size(), settings.configuration_index);
+		}
+	}
+}
+
+void VulkanSample::set_shader_reload(bool enable)
+{
+	shader_reload = enable;
+}
+
+void VulkanSample::set_device_group(bool enable)
+{
+	device_group = enable;
+
+	if (enable)
+	{
+		add_instance_extension(VK_KHR_DEVICE_GROUP_CREATION_EXTENSION_NAME, true);
+		add_device_extension(VK_KHR_DEVICE_GROUP_EXTENSION_NAME, true);
+	}
+}
+
+void VulkanSample::set_multisample(const MultisampleInfo &info)
+{
+	multisample_info = info;
+
+	if (info.depth_resolve_mode != VK_RESOLVE_MODE_NONE)
+	{
+		add_instance_extension(VK_KHR_GET_PHYSICAL_DEVICE_PROPERTIES_2_EXTENSION_NAME, true);
+		add_device_extension(VK_KHR_CREATE_RENDERPASS_2_EXTENSION_NAME, true);
+		add_device_extension(VK_KHR_MAINTENANCE2_EXTENSION_NAME, true);
+		add_device_extension(VK_KHR_MULTIVIEW_EXTENSION_NAME, true);
+		add_device_extension(VK_KHR_DEPTH_STENCIL_RESOLVE_EXTENSION_NAME, true);
+	}
+}
+
+void VulkanSample::set_gpu_index(uint32_t index)
+{
+	gpu_index = index;
+}
+
+void VulkanSample::set_frame_count(uint32_t count)
+{
+	frame_count = count;
+}
+
+void VulkanSample::set_present_latency_mode(PresentLatencyMode mode)
+{
+	present_latency_mode = mode;
+}
+
+void VulkanSample::set_resource_cache_budget(uint32_t count)
+{
+	resource_cache_budget = count;
+}
+
+void VulkanSample::set_api_version(uint32_t version)
+{
+	api_version = version;
+}
+
+void VulkanSample::set_screenshot_interval(uint32_t interval, ScreenshotCapture::Format format)
+{
+	screenshot_interval = interval;
+	screenshot_format   = format;
+}
+
+void VulkanSample::load_pipeline_cache()
+{
+	if (!fs::is_directory(pipeline_cache_directory))
+	{
+		fs::create_directory(pipeline_cache_directory);
+	}
+
+	auto key    = get_pipeline_cache_key(device->get_gpu());
+	auto prefix = get_pipeline_cache_prefix(pipeline_cache_directory, get_name());
+
+	// The driver reads the pipeline cache straight from the mapped file
+	auto pipeline_file = map_keyed_file(prefix + "_pipeline_cache.data", key);
+
+	VkPipelineCacheCreateInfo create_info{VK_STRUCTURE_TYPE_PIPELINE_CACHE_CREATE_INFO};
+
+	if (pipeline_file)
+	{
+		create_info.initialDataSize = pipeline_file->size() - sizeof(PipelineCacheKey);
+		create_info.pInitialData    = pipeline_file->data() + sizeof(PipelineCacheKey);
+	}
+
+	VK_CHECK(vkCreatePipelineCache(device->get_handle(), &create_info, nullptr, &persistent_pipeline_cache));
+
+	auto &resource_cache = device->get_resource_cache();
+
+	resource_cache.set_pipeline_cache(persistent_pipeline_cache);
+
+	// Rebuild all shaders, layouts, render passes and pipelines the sample used in a previous run
+	auto resource_file = map_keyed_file(prefix + "_resources.data", key);
+
+	if (resource_file && resource_file->size() > sizeof(PipelineCacheKey))
+	{
+		auto thread_count = std::thread::hardware_concurrency();
+		thread_count      = thread_count == 0 ? 1 : thread_count;
+
+		Timer timer;
+		timer.start();
+
+		resource_cache.warmup(resource_file->data() + sizeof(PipelineCacheKey), resource_file->size() - sizeof(PipelineCacheKey), thread_count);
+
+		LOGI("Resource cache warmed up in {:.3f} seconds", timer.stop());
+	}
+}
+
+void VulkanSample::save_pipeline_cache()
+{
+	if (persistent_pipeline_cache == VK_NULL_HANDLE)
+	{
+		return;
+	}
+
+	auto key    = get_pipeline_cache_key(device->get_gpu());
+	auto prefix = get_pipeline_cache_prefix(pipeline_cache_directory, get_name());
+
+	size_t size{};
+	VK_CHECK(vkGetPipelineCacheData(device->get_handle(), persistent_pipeline_cache, &size, nullptr));
+
+	std::vector<uint8_t> pipeline_data(size);
+	VK_CHECK(vkGetPipelineCacheData(device->get_handle(), persistent_pipeline_cache, &size, pipeline_data.data()));
+
+	try
+	{
+		write_keyed_file(prefix + "_pipeline_cache.data", key, pipeline_data);
+		write_keyed_file(prefix + "_resources.data", key, device->get_resource_cache().serialize());
+	}
+	catch (std::runtime_error &ex)
+	{
+		LOGE("Failed to save the pipeline cache. {}", ex.what());
+	}
+
+	device->get_resource_cache().set_pipeline_cache(VK_NULL_HANDLE);
+
+	vkDestroyPipelineCache(device->get_handle(), persistent_pipeline_cache, nullptr);
+	persistent_pipeline_cache = VK_NULL_HANDLE;
+}
+
+void VulkanSample::load_buffer_pool_demands()
+{
+	auto key    = get_pipeline_cache_key(device->get_gpu());
+	auto prefix = get_pipeline_cache_prefix(pipeline_cache_directory, get_name());
+
+	auto file = map_keyed_file(prefix + "_buffer_pools.data", key);
+
+	if (!file)
+	{
+		return;
+	}
+
+	std::istringstream is{std::string{reinterpret_cast<const char *>(file->data()) + sizeof(PipelineCacheKey), file->size() - sizeof(PipelineCacheKey)}};
+
+	std::map<VkBufferUsageFlags, std::vector<BufferPoolDemand>> demands;
+	read(is, demands);
+
+	if (!is)
+	{
+		LOGW("Discarding truncated buffer pool demands");
+		return;
+	}
+
+	render_context->reserve_buffer_pools({demands.begin(), demands.end()});
+}
+
+void VulkanSample::save_buffer_pool_demands()
+{
+	auto key    = get_pipeline_cache_key(device->get_gpu());
+	auto prefix = get_pipeline_cache_prefix(pipeline_cache_directory, get_name());
+
+	auto high_water_marks = render_context->get_buffer_pool_high_water_marks();
+
+	// Ordered, so that the file only changes with the demands
+	std::ostringstream os;
+	write(os, std::map<VkBufferUsageFlags, std::vector<BufferPoolDemand>>{high_water_marks.begin(), high_water_marks.end()});
+
+	std::string str = os.str();
+
+	try
+	{
+		write_keyed_file(prefix + "_buffer_pools.data", key, {str.begin(), str.end()});
+	}
+	catch (std::runtime_error &ex)
+	{
+		LOGE("Failed to save the buffer pool demands. {}", ex.what());
+	}
+}
+
 void VulkanSample::prepare_render_context()
 {
-	render_context->prepare();
+	// The main thread records with the resource pools of thread 0, the workers with the following ones
+	size_t thread_count = parallel_recording ? JobSystem::get().get_thread_count() + 1 : 1;
+
+	// Samples which create their own render targets are not multisampled
+	if (multisample_info.sample_count != VK_SAMPLE_COUNT_1_BIT)
+	{
+		multisample_resolve = std::make_unique<MultisampleResolve>(*device, multisample_info);
+
+		render_context->prepare(thread_count, multisample_resolve->get_create_func());
+	}
+	else
+	{
+		render_context->prepare(thread_count);
+	}
 }
 
 void VulkanSample::update_scene(float delta_time)
+{
+	simulate_scene(delta_time, latch_input());
+}
+
+void VulkanSample::simulate_scene(float delta_time, const InputSnapshot &input)
 {
 	if (scene)
 	{
+		scene->get_animation_system().update(delta_time);
+
 		//Update scripts
 		if (scene->has_component<sg::Script>())
 		{
@@ -144,9 +712,13 @@ void VulkanSample::update_scene(float delta_time)
 
 			for (auto script : scripts)
 			{
+				script->input_snapshot(input);
 				script->update(delta_time);
 			}
 		}
+
+		// Scripts move nodes, so world matrices are updated once they have run
+		scene->update_transforms();
 	}
 }
 
@@ -154,6 +726,12 @@ void VulkanSample::update_stats(float delta_time)
 {
 	if (stats)
 	{
+		// Samples request their stats while preparing, so the recording starts with the first frame
+		if (stats_recording && !stats->is_recording())
+		{
+			stats->start_recording(get_name() + "_stats.csv");
+		}
+
 		stats->update(delta_time);
 
 		static float stats_view_count = 0.0f;
@@ -179,7 +757,7 @@ void VulkanSample::update_gui(float delta_time)
 
 		gui->new_frame();
 
-		gui->show_top_window(get_name(), stats.get(), &get_debug_info());
+		gui->show_top_window(get_name(), stats.get(), &get_debug_info(), gpu_profiler.get());
 
 		// Samples can override this
 		draw_gui();
@@ -190,24 +768,103 @@ void VulkanSample::update_gui(float delta_time)
 
 void VulkanSample::update(float delta_time)
 {
-	update_scene(delta_time);
+	PROFILE_FUNCTION();
+
+	// The delta time and the work since the last update are those of the previous frame
+	if (frame_spike_detector)
+	{
+		frame_spike_detector->end_frame(delta_time, gpu_profiler.get());
+	}
 
-	update_gui(delta_time);
+	// No frame is being recorded, so the shaders can be swapped
+	if (shader_reloader)
+	{
+		shader_reloader->update();
+	}
+
+	if (scene_loader && scene_loader->stream_images(SCENE_STREAMING_BUDGET) == 0)
+	{
+		LOGI("Scene images loaded");
+		scene_loader.reset();
+	}
+
+	if (decoupled_simulation && scene)
+	{
+		// The first frame has no simulated scene to draw yet
+		if (!scene_simulated)
+		{
+			scene->set_deferred_transforms(true);
+			update_scene(delta_time);
+		}
+
+		// The frame draws the scene simulated during the previous frame
+		scene->publish_transforms();
+
+		// The GUI may change the scene, so it is updated before the simulation starts
+		update_gui(delta_time);
+
+		// The next frame does not know its delta time yet, it is simulated with the one of this frame
+		simulation      = JobSystem::get().push([this, delta_time, input = latch_input()](size_t) { simulate_scene(delta_time, input); }, JobPriority::High);
+		scene_simulated = true;
+	}
+	else
+	{
+		update_scene(delta_time);
+
+		update_gui(delta_time);
+	}
 
 	auto &command_buffer = render_context->begin();
 
+	if (!screenshot_capture)
+	{
+		screenshot_capture = std::make_unique<ScreenshotCapture>(*render_context);
+		screenshot_capture->set_format(screenshot_format);
+		screenshot_capture->set_interval(screenshot_interval, get_name());
+	}
+
+	screenshot_capture->collect();
+
 	// Collect the performance data for the sample graphs
 	update_stats(delta_time);
 
 	command_buffer.begin(VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT);
 	stats->begin_sampling(command_buffer);
 
-	draw(command_buffer, render_context->get_active_frame().get_render_target());
+	if (gpu_profiler)
+	{
+		gpu_profiler->begin_frame(command_buffer);
+	}
+
+	{
+		GpuProfiler::Scope scope{gpu_profiler.get(), command_buffer, "Frame"};
+		DEBUG_LABEL_SCOPE(command_buffer, get_name());
+
+		if (dynamic_resolution)
+		{
+			draw(command_buffer, dynamic_resolution->begin(command_buffer));
+
+			dynamic_resolution->end(command_buffer);
+		}
+		else
+		{
+			draw(command_buffer, render_context->get_active_frame().get_render_target());
+		}
+	}
+
+	screenshot_capture->record(command_buffer, render_context->get_active_frame().get_render_target().get_views().at(0));
 
 	stats->end_sampling(command_buffer);
 	command_buffer.end();
 
 	render_context->submit(command_buffer);
+
+	// Input events and the overrides of update may change the scene after this returns
+	if (simulation.valid())
+	{
+		JobSystem::get().wait(simulation);
+		simulation.get();
+	}
 }
 
 void VulkanSample::draw(CommandBuffer &command_buffer, RenderTarget &render_target)
@@ -226,10 +883,13 @@ void VulkanSample::draw(CommandBuffer &command_buffer, RenderTarget &render_targ
 
 		command_buffer.image_memory_barrier(views.at(0), memory_barrier);
 
-		// Skip 1 as it is handled later as a depth-stencil attachment
+		// Skip 1 as it is handled later as a depth-stencil attachment, as are other depth stencil images
 		for (size_t i = 2; i < views.size(); ++i)
 		{
-			command_buffer.image_memory_barrier(views.at(i), memory_barrier);
+			if (!is_depth_stencil_format(views.at(i).get_format()))
+			{
+				command_buffer.image_memory_barrier(views.at(i), memory_barrier);
+			}
 		}
 	}
 
@@ -243,10 +903,42 @@ void VulkanSample::draw(CommandBuffer &command_buffer, RenderTarget &render_targ
 		memory_barrier.dst_stage_mask  = VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT | VK_PIPELINE_STAGE_LATE_FRAGMENT_TESTS_BIT;
 
 		command_buffer.image_memory_barrier(views.at(1), memory_barrier);
+
+		for (size_t i = 2; i < views.size(); ++i)
+		{
+			if (is_depth_stencil_format(views.at(i).get_format()))
+			{
+				command_buffer.image_memory_barrier(views.at(i), memory_barrier);
+			}
+		}
+	}
+
+	if (gui)
+	{
+		gui->update_cache(command_buffer);
 	}
 
 	draw_renderpass(command_buffer, render_target);
 
+	if (multisample_resolve)
+	{
+		multisample_resolve->resolve(command_buffer, render_target);
+	}
+
+	if (dynamic_resolution)
+	{
+		// The offscreen color is upscaled to the swapchain image
+		ImageMemoryBarrier memory_barrier{};
+		memory_barrier.old_layout      = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
+		memory_barrier.new_layout      = VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL;
+		memory_barrier.src_access_mask = VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT;
+		memory_barrier.dst_access_mask = VK_ACCESS_TRANSFER_READ_BIT;
+		memory_barrier.src_stage_mask  = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT;
+		memory_barrier.dst_stage_mask  = VK_PIPELINE_STAGE_TRANSFER_BIT;
+
+		command_buffer.image_memory_barrier(views.at(0), memory_barrier);
+	}
+	else
 	{
 		ImageMemoryBarrier memory_barrier{};
 		memory_barrier.old_layout      = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
@@ -261,7 +953,7 @@ void VulkanSample::draw(CommandBuffer &command_buffer, RenderTarget &render_targ
 
 void VulkanSample::draw_renderpass(CommandBuffer &command_buffer, RenderTarget &render_target)
 {
-	auto &extent = render_target.get_extent();
+	auto &extent = render_target.get_render_area();
 
 	VkViewport viewport{};
 	viewport.width    = static_cast<float>(extent.width);
@@ -330,6 +1022,9 @@ void VulkanSample::input_event(const InputEvent &input_event)
 
 	if (!gui_captures_event)
 	{
+		// Scripts also receive the events folded into the input of the frame
+		input_snapshot.add(input_event);
+
 		if (scene->has_component<sg::Script>())
 		{
 			auto scripts = scene->get_components<sg::Script>();
@@ -346,7 +1041,10 @@ void VulkanSample::input_event(const InputEvent &input_event)
 		const auto &key_event = static_cast<const KeyInputEvent &>(input_event);
 		if (key_event.get_action() == KeyAction::Down && key_event.get_code() == KeyCode::PrintScreen)
 		{
-			screenshot(*render_context, "screenshot-" + get_name());
+			if (screenshot_capture)
+			{
+				screenshot_capture->request("screenshot-" + get_name());
+			}
 		}
 
 		if (key_event.get_code() == KeyCode::F6 && key_event.get_action() == KeyAction::Down)
@@ -356,9 +1054,29 @@ void VulkanSample::input_event(const InputEvent &input_event)
 				LOGE("Failed to save Graphs");
 			}
 		}
+
+		if (key_event.get_code() == KeyCode::F7 && key_event.get_action() == KeyAction::Down)
+		{
+			if (!device->write_memory_stats(get_name() + "_memory_stats.json"))
+			{
+				LOGE("Failed to save memory stats");
+			}
+		}
 	}
 }
 
+const InputSnapshot &VulkanSample::get_input_snapshot() const
+{
+	return input_snapshot;
+}
+
+InputSnapshot VulkanSample::latch_input()
+{
+	InputSnapshot input = input_snapshot;
+	input_snapshot.next_frame();
+	return input;
+}
+
 void VulkanSample::finish()
 {
 	Application::finish();
@@ -367,6 +1085,15 @@ void VulkanSample::finish()
 	{
 		device->wait_idle();
 	}
+
+	if (gpu_profiler)
+	{
+		gpu_profiler->write_json(get_name() + "_gpu_profile.json");
+	}
+
+#ifdef VKB_CPU_PROFILING
+	CpuProfiler::get().write_chrome_trace(get_name() + "_cpu_trace.json");
+#endif
 }
 
 Device &VulkanSample::get_device()
@@ -412,15 +1139,28 @@ void VulkanSample::update_debug_window()
 
 void VulkanSample::load_scene(const std::string &path)
 {
-	GLTFLoader loader{*device};
+	auto loader = std::make_unique<GLTFLoader>(*device);
+
+	loader->set_progressive_loading(progressive_scene_loading);
+	loader->set_interleaved_vertices(interleaved_scene_vertices);
+	loader->set_scene_cache(scene_cache);
+	loader->set_asset_memory_cache(asset_memory_cache);
+	loader->set_geometry_buffer_usage(scene_geometry_buffer_usage);
+	loader->set_shared_geometry_buffers(shared_scene_geometry);
 
-	scene = loader.read_scene_from_file(path);
+	scene = loader->read_scene_from_file(path);
 
 	if (!scene)
 	{
 		LOGE("Cannot load scene: {}", path.c_str());
 		throw std::runtime_error("Cannot load scene: " + path);
 	}
+
+	// Keep the loader to stream the images in
+	if (progressive_scene_loading)
+	{
+		scene_loader = std::move(loader);
+	}
 }
 
 VkSurfaceKHR VulkanSample::get_surface()
@@ -17,21 +17,92 @@
 
 #pragma once
 
+#include <future>
+
 #include "common/error.h"
 #include "common/utils.h"
 #include "common/vk_common.h"
 #include "core/instance.h"
 #include "gui.h"
 #include "platform/application.h"
+#include "rendering/dynamic_resolution.h"
+#include "rendering/frame_strategy_tuner.h"
+#include "rendering/multisample_resolve.h"
 #include "rendering/render_context.h"
+#include "rendering/render_pass_analyzer.h"
 #include "rendering/render_pipeline.h"
+#include "rendering/screenshot_capture.h"
 #include "scene_graph/node.h"
 #include "scene_graph/scene.h"
 #include "scene_graph/scripts/node_animation.h"
+#include "shader_reloader.h"
+#include "stats/frame_spike_detector.h"
+#include "stats/gpu_profiler.h"
 #include "stats/stats.h"
 
 namespace vkb
 {
+class GLTFLoader;
+
+/**
+ * @brief Options of the framework applied to a Vulkan sample before it is prepared, read once from
+ *        the command line so that each sample of a batch gets them without parsing it again
+ */
+struct VulkanSampleSettings
+{
+	/// Directory the pipeline cache and the buffer pool demands are persisted to, empty to not persist them
+	std::string pipeline_cache_directory;
+
+	bool progressive_scene_loading{false};
+
+	bool scene_cache{false};
+
+	/// Whether the scenes are loaded through the AssetMemoryCache, set for the samples of a batch run in one process
+	bool asset_memory_cache{false};
+
+	bool gpu_profiling{false};
+
+	bool frame_spike_capture{false};
+
+	bool stats_recording{false};
+
+	bool render_pass_analysis{false};
+
+	bool frame_strategy_tuning{false};
+
+	bool decoupled_simulation{false};
+
+	bool parallel_recording{false};
+
+	bool device_group{false};
+
+	bool shader_reload{false};
+
+	/// Multisampling of the render pipelines, if the sample count is more than one
+	MultisampleInfo multisample{};
+
+	/// Number of render frames, 0 for the default of the render context
+	uint32_t frame_count{0};
+
+	PresentLatencyMode present_latency_mode{PresentLatencyMode::Default};
+
+	/// Objects of each evictable type kept by the resource cache and the render frames, 0 for no limit
+	uint32_t resource_cache_budget{0};
+
+	/// Whether the frames are captured, at screenshot_interval
+	bool screenshots{false};
+
+	uint32_t screenshot_interval{0};
+
+	ScreenshotCapture::Format screenshot_format{ScreenshotCapture::Format::PNG};
+
+	/// Index of the physical device to run on, -1 for the most suitable one
+	int gpu_index{-1};
+
+	/// Configuration the sample runs with, -1 to leave it to the sample
+	int configuration_index{-1};
+};
+
 /**
  * @mainpage Overview of the framework
  *
@@ -121,6 +192,16 @@ class VulkanSample : public Application
 
 	virtual void input_event(const InputEvent &input_event) override;
 
+	/**
+	 * @brief The input received since the scene was last updated, for late latching it before submitting a frame
+	 */
+	const InputSnapshot &get_input_snapshot() const;
+
+	/**
+	 * @brief Adds the GPU time of the frame, if it can be measured, and the latest values of the requested stats
+	 */
+	virtual void record_benchmark_samples(BenchmarkReport &report) override;
+
 	virtual void finish() override;
 
 	/** 
@@ -144,6 +225,163 @@ class VulkanSample : public Application
 
 	sg::Scene &get_scene();
 
+	/**
+	 * @brief Sets a directory where the pipeline cache and the recorded cache resources are
+	 *        persisted, so that a later launch can warm up the ResourceCache at startup
+	 * @param directory The directory to store the data in, an empty string disables persistence
+	 */
+	void set_pipeline_cache_directory(const std::string &directory);
+
+	/**
+	 * @brief Applies the framework options read from the command line, must be called before prepare
+	 *
+	 * A configuration index selects one of the permutations of the settings of the sample configuration.
+	 */
+	void apply_settings(const VulkanSampleSettings &settings);
+
+	/**
+	 * @brief Makes load_scene return before the scene images are loaded
+	 *        Images are then uploaded over the following frames, within a per frame budget
+	 */
+	void set_progressive_scene_loading(bool progressive);
+
+	/**
+	 * @brief Makes load_scene interleave the vertex attributes of each sub mesh in a single buffer
+	 */
+	void set_interleaved_scene_vertices(bool interleaved);
+
+	/**
+	 * @brief Makes load_scene write a binary cache of the scene after parsing it, and read it on later launches
+	 */
+	void set_scene_cache(bool enable);
+
+	/**
+	 * @brief Makes load_scene keep the parsed glTF file and the decoded images in memory for the process, and
+	 *        load them from there, see GLTFLoader::set_asset_memory_cache
+	 */
+	void set_asset_memory_cache(bool enable);
+
+	/**
+	 * @brief Adds usages to the vertex and index buffers of the scene loaded by load_scene
+	 *        See GLTFLoader::set_geometry_buffer_usage.
+	 */
+	void set_scene_geometry_buffer_usage(VkBufferUsageFlags usage);
+
+	/**
+	 * @brief Makes load_scene suballocate the vertex and index data of the sub meshes from shared geometry buffers
+	 *        See GLTFLoader::set_shared_geometry_buffers.
+	 */
+	void set_shared_scene_geometry(bool shared);
+
+	/**
+	 * @brief Measures the GPU time of the frames and their subpasses, shown in the GUI
+	 *        and written to a JSON file when the sample finishes
+	 *        Must be called before prepare, and needs timestamp support.
+	 */
+	void set_gpu_profiling(bool enable);
+
+	/**
+	 * @brief Writes what happened in the frames before the frames much longer than the recent ones,
+	 *        with their GPU scopes, resource cache misses and memory usage
+	 *        Must be called before prepare, enables GPU profiling.
+	 */
+	void set_frame_spike_capture(bool enable);
+
+	/**
+	 * @brief Streams the raw samples of the requested stats of every frame to a CSV file
+	 */
+	void set_stats_recording(bool enable);
+
+	/**
+	 * @brief Logs the render passes which could be merged and the attachment loads and stores which could be skipped,
+	 *        with the bandwidth it would save. Must be called before prepare.
+	 */
+	void set_render_pass_analysis(bool enable);
+
+	/**
+	 * @brief Renders multisampled to the render targets of the render context, see MultisampleResolve
+	 *        Must be called before prepare, and applies to the render pipeline set afterwards. Samples which
+	 *        create their own render targets or use dynamic resolution are not multisampled.
+	 *        Enables VK_KHR_depth_stencil_resolve if available when depth is resolved.
+	 */
+	void set_multisample(const MultisampleInfo &info);
+
+	/**
+	 * @brief Lets a FrameStrategyTuner pick whether the render frames cache their descriptor sets and how
+	 *        they allocate buffers, from the descriptor set and buffer block requests measured at runtime
+	 *        Must be called before prepare.
+	 */
+	void set_frame_strategy_tuning(bool enable);
+
+	/**
+	 * @brief Simulates the scene of the next frame on a worker of the job system while the current frame
+	 *        is recorded, from the world matrices the simulation published during the previous frame.
+	 *        The scene is drawn one frame later, and must only be changed by the animations and scripts,
+	 *        or outside of update. Must be called before prepare.
+	 */
+	void set_decoupled_simulation(bool enable);
+
+	/**
+	 * @brief Prepares the render context with a thread per worker of JobSystem::get() besides the main thread,
+	 *        and records the render pipelines of the sample in parallel on them. Must be called before prepare.
+	 */
+	void set_parallel_recording(bool enable);
+
+	/**
+	 * @brief Combines the GPUs of the device group of the selected GPU in the device, and renders
+	 *        frames on each of them in turn. Must be called before prepare.
+	 */
+	void set_device_group(bool enable);
+
+	/**
+	 * @brief Recompiles the shaders of the resource cache when their file changes, and rebuilds
+	 *        the pipelines using them. Must be called before prepare.
+	 */
+	void set_shader_reload(bool enable);
+
+	/**
+	 * @brief Runs the sample on a given physical device rather than the most suitable one
+	 *        Must be called before prepare.
+	 * @param index Index of the physical device, in the order they are enumerated
+	 */
+	void set_gpu_index(uint32_t index);
+
+	/**
+	 * @brief Captures the rendered frames at a fixed interval, named after the sample and the frame number
+	 * @param interval Number of frames between captures, 0 to only capture on request
+	 * @param format File format of the captures
+	 */
+	void set_screenshot_interval(uint32_t interval, ScreenshotCapture::Format format = ScreenshotCapture::Format::PNG);
+
+	/**
+	 * @brief Renders with a number of frames used in turn, so the CPU records up to that many frames ahead of the GPU
+	 *        Must be called before prepare.
+	 * @param count Number of render frames, 0 for the default of the render context
+	 */
+	void set_frame_count(uint32_t count);
+
+	/**
+	 * @brief Configures the swapchain for a low latency to the display, as kiosks rendering straight to the display want.
+	 *        Must be called before prepare.
+	 * @param mode The trade-off between throughput, tearing and latency
+	 */
+	void set_present_latency_mode(PresentLatencyMode mode);
+
+	/**
+	 * @brief Bounds the descriptor sets, framebuffers and pipelines cached, evicting the least recently used
+	 *        once the frames using them have retired. Must be called before prepare.
+	 * @param count Number of objects of each type kept by the resource cache, and of descriptor sets per thread
+	 *        kept by the render frames, 0 for no limit
+	 */
+	void set_resource_cache_budget(uint32_t count);
+
+	/**
+	 * @brief Creates the instance for a Vulkan API version, lowered to the version the instance supports
+	 *        Must be called before prepare.
+	 * @param version The Vulkan API version, such as VK_API_VERSION_1_1
+	 */
+	void set_api_version(uint32_t version);
+
   protected:
 	/**
 	 * @brief The Vulkan instance
@@ -174,12 +412,60 @@ class VulkanSample : public Application
 
 	std::unique_ptr<Stats> stats{nullptr};
 
+	/**
+	 * @brief If set by the concrete sample, frames render offscreen at a scale driven by their GPU time
+	 *        and are upscaled to the swapchain, see draw
+	 */
+	std::unique_ptr<DynamicResolution> dynamic_resolution{nullptr};
+
+	/**
+	 * @brief Multisampling of the render targets of the render context, null if it is disabled
+	 */
+	std::unique_ptr<MultisampleResolve> multisample_resolve{nullptr};
+
+	/**
+	 * @brief Profiler of the GPU time of the frames, null if profiling is disabled
+	 */
+	std::unique_ptr<GpuProfiler> gpu_profiler{nullptr};
+
+	/**
+	 * @brief Detector of the frame time spikes, null if their capture is disabled
+	 */
+	std::unique_ptr<FrameSpikeDetector> frame_spike_detector{nullptr};
+
+	/**
+	 * @brief Analyzer of the bandwidth the render passes waste, null if the analysis is disabled
+	 */
+	std::unique_ptr<RenderPassAnalyzer> render_pass_analyzer{nullptr};
+
+	/**
+	 * @brief Tuner of the strategies of the render frames, null if the sample sets them
+	 */
+	std::unique_ptr<FrameStrategyTuner> frame_strategy_tuner{nullptr};
+
+	/**
+	 * @brief Reloads the shaders which change while the sample runs, if enabled
+	 */
+	std::unique_ptr<ShaderReloader> shader_reloader{nullptr};
+
 	/**
 	 * @brief Update scene
 	 * @param delta_time
 	 */
 	void update_scene(float delta_time);
 
+	/**
+	 * @brief Runs the animations and scripts of the scene and updates its transforms
+	 * @param delta_time
+	 * @param input The input of the frame, passed to the scripts before their update
+	 */
+	void simulate_scene(float delta_time, const InputSnapshot &input);
+
+	/**
+	 * @brief Takes the input received since the last call, starting a new snapshot
+	 */
+	InputSnapshot latch_input();
+
 	/**
 	 * @brief Update counter values
 	 * @param delta_time
@@ -194,6 +480,8 @@ class VulkanSample : public Application
 
 	/**
 	 * @brief Prepares the render target and draws to it, calling draw_renderpass
+	 *        With dynamic resolution the render target is offscreen, and its color is left in the
+	 *        transfer source layout instead of the present one
 	 * @param command_buffer The command buffer to record the commands to
 	 * @param render_target The render target that is being drawn to
 	 */
@@ -287,10 +575,105 @@ class VulkanSample : public Application
 	Configuration configuration{};
 
   private:
+	/**
+	 * @brief Creates the persistent pipeline cache and warms up the resource cache
+	 *        with the data saved by a previous run on the same device and driver
+	 */
+	void load_pipeline_cache();
+
+	/**
+	 * @brief Saves the pipeline cache and the recorded resources to the pipeline cache directory
+	 */
+	void save_pipeline_cache();
+
+	/**
+	 * @brief Sizes the buffer pools of the render context for the peak demand saved by a previous run on the same device and driver
+	 */
+	void load_buffer_pool_demands();
+
+	/**
+	 * @brief Saves the peak demand of the buffer pools of the render context to the pipeline cache directory
+	 */
+	void save_buffer_pool_demands();
+
+	/** @brief Directory where the pipeline cache is persisted, empty if disabled */
+	std::string pipeline_cache_directory{};
+
+	/** @brief Pipeline cache created from the data persisted in pipeline_cache_directory */
+	VkPipelineCache persistent_pipeline_cache{VK_NULL_HANDLE};
+
 	/** @brief Set of device extensions to be enabled for this example and wether they are optional (must be set in the derived constructor) */
 	std::unordered_map<const char *, bool> device_extensions;
 
 	/** @brief Set of instance extensions to be enabled for this example and whether they are optional (must be set in the derived constructor) */
 	std::unordered_map<const char *, bool> instance_extensions;
+
+	/** @brief Maximum amount of image data uploaded per frame while the scene images stream in */
+	static constexpr VkDeviceSize SCENE_STREAMING_BUDGET{16 * 1024 * 1024};
+
+	bool progressive_scene_loading{false};
+
+	bool interleaved_scene_vertices{false};
+
+	bool scene_cache{false};
+
+	bool asset_memory_cache{false};
+
+	VkBufferUsageFlags scene_geometry_buffer_usage{0};
+
+	bool shared_scene_geometry{false};
+
+	bool gpu_profiling{false};
+
+	bool frame_spike_capture{false};
+
+	bool stats_recording{false};
+
+	bool render_pass_analysis{false};
+
+	MultisampleInfo multisample_info{};
+
+	bool frame_strategy_tuning{false};
+
+	bool decoupled_simulation{false};
+
+	bool parallel_recording{false};
+
+	bool device_group{false};
+
+	bool shader_reload{false};
+
+	/** @brief Input events not captured by the GUI since the scene was last updated */
+	InputSnapshot input_snapshot;
+
+	/** @brief Simulation of the scene of the next frame, valid while it runs during update */
+	std::future<void> simulation;
+
+	/** @brief Whether the scene of the frame was simulated by the previous frame */
+	bool scene_simulated{false};
+
+	/** @brief Index of the physical device to run on, the most suitable one if negative */
+	int64_t gpu_index{-1};
+
+	uint32_t screenshot_interval{0};
+
+	/** @brief Number of render frames requested, 0 for the default of the render context */
+	uint32_t frame_count{0};
+
+	PresentLatencyMode present_latency_mode{PresentLatencyMode::Default};
+
+	/** @brief Number of objects of each evictable type cached, 0 for no limit */
+	uint32_t resource_cache_budget{0};
+
+	/** @brief Vulkan API version the instance is created for */
+	uint32_t api_version{VK_API_VERSION_1_0};
+
+	ScreenshotCapture::Format screenshot_format{ScreenshotCapture::Format::PNG};
+
+	/** @brief Asynchronous capture of the rendered frames, created with the first frame */
+	std::unique_ptr<ScreenshotCapture> screenshot_capture{nullptr};
+
+	/** @brief Loader streaming the images of a progressively loaded scene, null once they are all resident */
+	std::unique_ptr<GLTFLoader> scene_loader{nullptr};
 };
 }        // namespace vkb
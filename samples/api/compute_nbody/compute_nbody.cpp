@@ -16,11 +16,39 @@
  */
 
 /*
-  * Compute shader N-body simulation using two passes and shared compute shader memory
+  * Compute shader N-body simulation using two passes and shared compute shader memory,
+  * or a uniform grid that is sorted on the GPU every frame for larger particle counts
   */
 
 #include "compute_nbody.h"
 
+namespace
+{
+// Frames skipped after each benchmark step is set up
+constexpr uint32_t BENCHMARK_WARMUP_FRAMES = 16;
+
+// Frames measured at each benchmark step
+constexpr uint32_t BENCHMARK_MEASURED_FRAMES = 128;
+
+// Largest particle count the benchmark runs all pairs evaluation with, as larger counts can take long enough to trigger device timeouts
+constexpr uint32_t ALL_PAIRS_BENCHMARK_LIMIT = 250000;
+
+// Fine cells combined into one coarse cell along each axis, matches COARSE_FACTOR in the grid shaders
+constexpr uint32_t GRID_COARSE_FACTOR = 4;
+
+constexpr uint32_t GRID_CELL_COUNT = GRID_DIM * GRID_DIM * GRID_DIM;
+
+constexpr uint32_t GRID_COARSE_CELL_COUNT = GRID_CELL_COUNT / (GRID_COARSE_FACTOR * GRID_COARSE_FACTOR * GRID_COARSE_FACTOR);
+
+// Half size of the cube covered by the grid, centered at the origin
+constexpr float GRID_EXTENT = 16.0f;
+
+const char *force_method_name(int32_t force_method)
+{
+	return force_method == ComputeNBody::UNIFORM_GRID ? "uniform grid" : "all pairs";
+}
+}        // namespace
+
 ComputeNBody::ComputeNBody()
 {
 	title       = "Compute shader N-body system";
@@ -31,6 +59,13 @@ ComputeNBody::ComputeNBody()
 	camera.set_rotation(glm::vec3(-26.0f, 75.0f, 0.0f));
 	camera.set_translation(glm::vec3(0.0f, 0.0f, -14.0f));
 	camera.translation_speed = 2.5f;
+
+	// The default count first, followed by the counts of the scalability benchmark
+	particle_counts = {6 * PARTICLES_PER_ATTRACTOR, 10000, 100000, 250000, 500000, 1000000};
+	for (auto count : particle_counts)
+	{
+		particle_count_names.push_back(std::to_string(count));
+	}
 }
 
 ComputeNBody::~ComputeNBody()
@@ -53,6 +88,25 @@ ComputeNBody::~ComputeNBody()
 		vkDestroyPipeline(get_device().get_handle(), compute.pipeline_integrate, nullptr);
 		vkDestroySemaphore(get_device().get_handle(), compute.semaphore, nullptr);
 		vkDestroyCommandPool(get_device().get_handle(), compute.command_pool, nullptr);
+		if (compute.query_pool != VK_NULL_HANDLE)
+		{
+			vkDestroyQueryPool(get_device().get_handle(), compute.query_pool, nullptr);
+		}
+
+		// Grid
+		grid.cell_counts.reset();
+		grid.cell_offsets.reset();
+		grid.particle_slots.reset();
+		grid.sorted_positions.reset();
+		grid.cell_masses.reset();
+		vkDestroyPipelineLayout(get_device().get_handle(), grid.pipeline_layout, nullptr);
+		vkDestroyDescriptorSetLayout(get_device().get_handle(), grid.descriptor_set_layout, nullptr);
+		vkDestroyPipeline(get_device().get_handle(), grid.pipeline_count, nullptr);
+		vkDestroyPipeline(get_device().get_handle(), grid.pipeline_scan, nullptr);
+		vkDestroyPipeline(get_device().get_handle(), grid.pipeline_scatter, nullptr);
+		vkDestroyPipeline(get_device().get_handle(), grid.pipeline_cells, nullptr);
+		vkDestroyPipeline(get_device().get_handle(), grid.pipeline_coarse, nullptr);
+		vkDestroyPipeline(get_device().get_handle(), grid.pipeline_calculate, nullptr);
 
 		vkDestroySampler(get_device().get_handle(), textures.particle.sampler, nullptr);
 		vkDestroySampler(get_device().get_handle(), textures.gradient.sampler, nullptr);
@@ -141,7 +195,6 @@ void ComputeNBody::build_command_buffers()
 		VkDeviceSize offsets[1] = {0};
 		vkCmdBindVertexBuffers(draw_cmd_buffers[i], 0, 1, compute.storage_buffer->get(), offsets);
 		vkCmdDraw(draw_cmd_buffers[i], num_particles, 1, 0, 0);
-		draw_ui(draw_cmd_buffers[i]);
 		vkCmdEndRenderPass(draw_cmd_buffers[i]);
 
 		// Release barrier
@@ -204,11 +257,24 @@ void ComputeNBody::build_compute_command_buffer()
 		    0, nullptr);
 	}
 
+	if (compute.query_pool != VK_NULL_HANDLE)
+	{
+		vkCmdResetQueryPool(compute.command_buffer, compute.query_pool, 0, 2);
+		vkCmdWriteTimestamp(compute.command_buffer, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, compute.query_pool, 0);
+	}
+
 	// First pass: Calculate particle movement
 	// -------------------------------------------------------------------------------------------------------
-	vkCmdBindPipeline(compute.command_buffer, VK_PIPELINE_BIND_POINT_COMPUTE, compute.pipeline_calculate);
-	vkCmdBindDescriptorSets(compute.command_buffer, VK_PIPELINE_BIND_POINT_COMPUTE, compute.pipeline_layout, 0, 1, &compute.descriptor_set, 0, 0);
-	vkCmdDispatch(compute.command_buffer, num_particles / 256, 1, 1);
+	if (force_method == UNIFORM_GRID)
+	{
+		record_grid_dispatches();
+	}
+	else
+	{
+		vkCmdBindPipeline(compute.command_buffer, VK_PIPELINE_BIND_POINT_COMPUTE, compute.pipeline_calculate);
+		vkCmdBindDescriptorSets(compute.command_buffer, VK_PIPELINE_BIND_POINT_COMPUTE, compute.pipeline_layout, 0, 1, &compute.descriptor_set, 0, 0);
+		vkCmdDispatch(compute.command_buffer, num_particles / 256, 1, 1);
+	}
 
 	// Add memory barrier to ensure that the computer shader has finished writing to the buffer
 	VkBufferMemoryBarrier memory_barrier = vkb::initializers::buffer_memory_barrier();
@@ -231,8 +297,17 @@ void ComputeNBody::build_compute_command_buffer()
 	// Second pass: Integrate particles
 	// -------------------------------------------------------------------------------------------------------
 	vkCmdBindPipeline(compute.command_buffer, VK_PIPELINE_BIND_POINT_COMPUTE, compute.pipeline_integrate);
+	if (force_method == UNIFORM_GRID)
+	{
+		vkCmdBindDescriptorSets(compute.command_buffer, VK_PIPELINE_BIND_POINT_COMPUTE, compute.pipeline_layout, 0, 1, &compute.descriptor_set, 0, 0);
+	}
 	vkCmdDispatch(compute.command_buffer, num_particles / 256, 1, 1);
 
+	if (compute.query_pool != VK_NULL_HANDLE)
+	{
+		vkCmdWriteTimestamp(compute.command_buffer, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, compute.query_pool, 1);
+	}
+
 	// Release
 	if (graphics.queue_family_index != compute.queue_family_index)
 	{
@@ -261,6 +336,75 @@ void ComputeNBody::build_compute_command_buffer()
 	vkEndCommandBuffer(compute.command_buffer);
 }
 
+// Sorts the particles into the uniform grid with a counting sort (count, prefix sum, scatter),
+// reduces the cells to their centers of mass and evaluates the forces from the grid
+void ComputeNBody::record_grid_dispatches()
+{
+	// The cell counts are cleared once the previous frame's grid passes are done with them
+	VkMemoryBarrier memory_barrier = vkb::initializers::memory_barrier();
+	memory_barrier.srcAccessMask   = VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT;
+	memory_barrier.dstAccessMask   = VK_ACCESS_TRANSFER_WRITE_BIT;
+	vkCmdPipelineBarrier(
+	    compute.command_buffer,
+	    VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+	    VK_PIPELINE_STAGE_TRANSFER_BIT,
+	    VK_FLAGS_NONE,
+	    1, &memory_barrier,
+	    0, nullptr,
+	    0, nullptr);
+
+	vkCmdFillBuffer(compute.command_buffer, grid.cell_counts->get_handle(), 0, VK_WHOLE_SIZE, 0);
+
+	memory_barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+	memory_barrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT;
+	vkCmdPipelineBarrier(
+	    compute.command_buffer,
+	    VK_PIPELINE_STAGE_TRANSFER_BIT,
+	    VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+	    VK_FLAGS_NONE,
+	    1, &memory_barrier,
+	    0, nullptr,
+	    0, nullptr);
+
+	vkCmdBindDescriptorSets(compute.command_buffer, VK_PIPELINE_BIND_POINT_COMPUTE, grid.pipeline_layout, 0, 1, &grid.descriptor_set, 0, 0);
+
+	struct GridPass
+	{
+		VkPipeline pipeline;
+		uint32_t   group_count;
+	};
+
+	// The prefix sum runs as a single work group, every other pass as one invocation per particle or cell
+	const std::array<GridPass, 6> passes = {{{grid.pipeline_count, num_particles / 256},
+	                                         {grid.pipeline_scan, 1},
+	                                         {grid.pipeline_scatter, num_particles / 256},
+	                                         {grid.pipeline_cells, (GRID_CELL_COUNT + 255) / 256},
+	                                         {grid.pipeline_coarse, (GRID_COARSE_CELL_COUNT + 255) / 256},
+	                                         {grid.pipeline_calculate, num_particles / 256}}};
+
+	// Every pass reads what the previous passes wrote
+	memory_barrier.srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT;
+	memory_barrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT;
+
+	for (size_t i = 0; i < passes.size(); ++i)
+	{
+		if (i > 0)
+		{
+			vkCmdPipelineBarrier(
+			    compute.command_buffer,
+			    VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+			    VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+			    VK_FLAGS_NONE,
+			    1, &memory_barrier,
+			    0, nullptr,
+			    0, nullptr);
+		}
+
+		vkCmdBindPipeline(compute.command_buffer, VK_PIPELINE_BIND_POINT_COMPUTE, passes[i].pipeline);
+		vkCmdDispatch(compute.command_buffer, passes[i].group_count, 1, 1);
+	}
+}
+
 // Setup and fill the compute shader storage buffers containing the particles
 void ComputeNBody::prepare_storage_buffers()
 {
@@ -280,7 +424,10 @@ void ComputeNBody::prepare_storage_buffers()
 	};
 #endif
 
-	num_particles = static_cast<uint32_t>(attractors.size()) * PARTICLES_PER_ATTRACTOR;
+	// Particles per attractor are kept a multiple of 128, so that the total count is a multiple of the work group size
+	const uint32_t particles_per_attractor = std::max(128u, particle_counts[particle_count_index] / static_cast<uint32_t>(attractors.size()) / 128 * 128);
+
+	num_particles = static_cast<uint32_t>(attractors.size()) * particles_per_attractor;
 
 	// Initial particle positions
 	std::vector<Particle> particle_buffer(num_particles);
@@ -290,9 +437,9 @@ void ComputeNBody::prepare_storage_buffers()
 
 	for (uint32_t i = 0; i < static_cast<uint32_t>(attractors.size()); i++)
 	{
-		for (uint32_t j = 0; j < PARTICLES_PER_ATTRACTOR; j++)
+		for (uint32_t j = 0; j < particles_per_attractor; j++)
 		{
-			Particle &particle = particle_buffer[i * PARTICLES_PER_ATTRACTOR + j];
+			Particle &particle = particle_buffer[i * particles_per_attractor + j];
 
 			// First particle in group as heavy center of gravity
 			if (j == 0)
@@ -366,21 +513,52 @@ void ComputeNBody::prepare_storage_buffers()
 	}
 
 	device->flush_command_buffer(copy_command, queue, true);
+
+	prepare_grid_buffers();
+}
+
+// The grid buffers are only accessed by the compute queue
+void ComputeNBody::prepare_grid_buffers()
+{
+	grid.cell_counts = std::make_unique<vkb::core::Buffer>(get_device(),
+	                                                       GRID_CELL_COUNT * sizeof(uint32_t),
+	                                                       VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+	                                                       VMA_MEMORY_USAGE_GPU_ONLY);
+
+	grid.cell_offsets = std::make_unique<vkb::core::Buffer>(get_device(),
+	                                                        GRID_CELL_COUNT * sizeof(uint32_t),
+	                                                        VK_BUFFER_USAGE_STORAGE_BUFFER_BIT,
+	                                                        VMA_MEMORY_USAGE_GPU_ONLY);
+
+	grid.particle_slots = std::make_unique<vkb::core::Buffer>(get_device(),
+	                                                          num_particles * sizeof(glm::uvec2),
+	                                                          VK_BUFFER_USAGE_STORAGE_BUFFER_BIT,
+	                                                          VMA_MEMORY_USAGE_GPU_ONLY);
+
+	grid.sorted_positions = std::make_unique<vkb::core::Buffer>(get_device(),
+	                                                            num_particles * sizeof(glm::vec4),
+	                                                            VK_BUFFER_USAGE_STORAGE_BUFFER_BIT,
+	                                                            VMA_MEMORY_USAGE_GPU_ONLY);
+
+	grid.cell_masses = std::make_unique<vkb::core::Buffer>(get_device(),
+	                                                       (GRID_CELL_COUNT + GRID_COARSE_CELL_COUNT) * sizeof(glm::vec4),
+	                                                       VK_BUFFER_USAGE_STORAGE_BUFFER_BIT,
+	                                                       VMA_MEMORY_USAGE_GPU_ONLY);
 }
 
 void ComputeNBody::setup_descriptor_pool()
 {
 	std::vector<VkDescriptorPoolSize> pool_sizes =
 	    {
-	        vkb::initializers::descriptor_pool_size(VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, 2),
-	        vkb::initializers::descriptor_pool_size(VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, 1),
+	        vkb::initializers::descriptor_pool_size(VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, 3),
+	        vkb::initializers::descriptor_pool_size(VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, 7),
 	        vkb::initializers::descriptor_pool_size(VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, 2)};
 
 	VkDescriptorPoolCreateInfo descriptor_pool_create_info =
 	    vkb::initializers::descriptor_pool_create_info(
 	        static_cast<uint32_t>(pool_sizes.size()),
 	        pool_sizes.data(),
-	        2);
+	        3);
 
 	VK_CHECK(vkCreateDescriptorPool(get_device().get_handle(), &descriptor_pool_create_info, nullptr, &descriptor_pool));
 }
@@ -586,24 +764,34 @@ void ComputeNBody::prepare_compute()
 
 	VK_CHECK(vkAllocateDescriptorSets(get_device().get_handle(), &alloc_info, &compute.descriptor_set));
 
-	VkDescriptorBufferInfo            storage_buffer_descriptor = create_descriptor(*compute.storage_buffer);
-	VkDescriptorBufferInfo            uniform_buffer_descriptor = create_descriptor(*compute.uniform_buffer);
-	std::vector<VkWriteDescriptorSet> compute_write_descriptor_sets =
-	    {
-	        // Binding 0 : Particle position storage buffer
-	        vkb::initializers::write_descriptor_set(
-	            compute.descriptor_set,
-	            VK_DESCRIPTOR_TYPE_STORAGE_BUFFER,
-	            0,
-	            &storage_buffer_descriptor),
-	        // Binding 1 : Uniform buffer
-	        vkb::initializers::write_descriptor_set(
-	            compute.descriptor_set,
-	            VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER,
-	            1,
-	            &uniform_buffer_descriptor)};
+	// Grid passes
+	std::vector<VkDescriptorSetLayoutBinding> grid_set_layout_bindings = {
+	    // Binding 0 : Particle position storage buffer
+	    vkb::initializers::descriptor_set_layout_binding(VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, VK_SHADER_STAGE_COMPUTE_BIT, 0),
+	    // Binding 1 : Uniform buffer
+	    vkb::initializers::descriptor_set_layout_binding(VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, VK_SHADER_STAGE_COMPUTE_BIT, 1),
+	    // Binding 2 : Cell counts
+	    vkb::initializers::descriptor_set_layout_binding(VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, VK_SHADER_STAGE_COMPUTE_BIT, 2),
+	    // Binding 3 : Cell offsets
+	    vkb::initializers::descriptor_set_layout_binding(VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, VK_SHADER_STAGE_COMPUTE_BIT, 3),
+	    // Binding 4 : Particle slots
+	    vkb::initializers::descriptor_set_layout_binding(VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, VK_SHADER_STAGE_COMPUTE_BIT, 4),
+	    // Binding 5 : Sorted particle positions
+	    vkb::initializers::descriptor_set_layout_binding(VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, VK_SHADER_STAGE_COMPUTE_BIT, 5),
+	    // Binding 6 : Cell centers of mass
+	    vkb::initializers::descriptor_set_layout_binding(VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, VK_SHADER_STAGE_COMPUTE_BIT, 6),
+	};
 
-	vkUpdateDescriptorSets(get_device().get_handle(), static_cast<uint32_t>(compute_write_descriptor_sets.size()), compute_write_descriptor_sets.data(), 0, NULL);
+	descriptor_layout = vkb::initializers::descriptor_set_layout_create_info(grid_set_layout_bindings.data(), static_cast<uint32_t>(grid_set_layout_bindings.size()));
+	VK_CHECK(vkCreateDescriptorSetLayout(get_device().get_handle(), &descriptor_layout, nullptr, &grid.descriptor_set_layout));
+
+	pipeline_layout_create_info = vkb::initializers::pipeline_layout_create_info(&grid.descriptor_set_layout, 1);
+	VK_CHECK(vkCreatePipelineLayout(get_device().get_handle(), &pipeline_layout_create_info, nullptr, &grid.pipeline_layout));
+
+	alloc_info = vkb::initializers::descriptor_set_allocate_info(descriptor_pool, &grid.descriptor_set_layout, 1);
+	VK_CHECK(vkAllocateDescriptorSets(get_device().get_handle(), &alloc_info, &grid.descriptor_set));
+
+	update_compute_descriptor_sets();
 
 	// Create pipelines
 	VkComputePipelineCreateInfo compute_pipeline_create_info = vkb::initializers::compute_pipeline_create_info(compute.pipeline_layout, 0);
@@ -642,6 +830,59 @@ void ComputeNBody::prepare_compute()
 	compute_pipeline_create_info.stage = load_shader("compute_nbody/particle_integrate.comp", VK_SHADER_STAGE_COMPUTE_BIT);
 	VK_CHECK(vkCreateComputePipelines(get_device().get_handle(), pipeline_cache, 1, &compute_pipeline_create_info, nullptr, &compute.pipeline_integrate));
 
+	// Grid passes share one set of specialization constants, the force constants match the all pairs pass
+	struct GridSpecializationData
+	{
+		uint32_t grid_dim;
+		float    grid_extent;
+		float    gravity;
+		float    power;
+		float    soften;
+	} grid_specialization_data;
+
+	std::vector<VkSpecializationMapEntry> grid_specialization_map_entries = {
+	    vkb::initializers::specialization_map_entry(0, offsetof(GridSpecializationData, grid_dim), sizeof(uint32_t)),
+	    vkb::initializers::specialization_map_entry(1, offsetof(GridSpecializationData, grid_extent), sizeof(float)),
+	    vkb::initializers::specialization_map_entry(2, offsetof(GridSpecializationData, gravity), sizeof(float)),
+	    vkb::initializers::specialization_map_entry(3, offsetof(GridSpecializationData, power), sizeof(float)),
+	    vkb::initializers::specialization_map_entry(4, offsetof(GridSpecializationData, soften), sizeof(float))};
+
+	grid_specialization_data.grid_dim    = GRID_DIM;
+	grid_specialization_data.grid_extent = GRID_EXTENT;
+	grid_specialization_data.gravity     = specialization_data.gravity;
+	grid_specialization_data.power       = specialization_data.power;
+	grid_specialization_data.soften      = specialization_data.soften;
+
+	VkSpecializationInfo grid_specialization_info =
+	    vkb::initializers::specialization_info(static_cast<uint32_t>(grid_specialization_map_entries.size()), grid_specialization_map_entries.data(), sizeof(grid_specialization_data), &grid_specialization_data);
+
+	const std::vector<std::pair<const char *, VkPipeline *>> grid_pipelines = {
+	    {"compute_nbody/grid_count.comp", &grid.pipeline_count},
+	    {"compute_nbody/grid_scan.comp", &grid.pipeline_scan},
+	    {"compute_nbody/grid_scatter.comp", &grid.pipeline_scatter},
+	    {"compute_nbody/grid_cells.comp", &grid.pipeline_cells},
+	    {"compute_nbody/grid_coarse.comp", &grid.pipeline_coarse},
+	    {"compute_nbody/grid_calculate.comp", &grid.pipeline_calculate}};
+
+	VkComputePipelineCreateInfo grid_pipeline_create_info = vkb::initializers::compute_pipeline_create_info(grid.pipeline_layout, 0);
+	for (auto &grid_pipeline : grid_pipelines)
+	{
+		grid_pipeline_create_info.stage                     = load_shader(grid_pipeline.first, VK_SHADER_STAGE_COMPUTE_BIT);
+		grid_pipeline_create_info.stage.pSpecializationInfo = &grid_specialization_info;
+		VK_CHECK(vkCreateComputePipelines(get_device().get_handle(), pipeline_cache, 1, &grid_pipeline_create_info, nullptr, grid_pipeline.second));
+	}
+
+	// Dispatch timestamps, if the compute queue supports them
+	compute.query_pool = VK_NULL_HANDLE;
+	if (get_device().get_gpu().get_queue_family_properties()[compute.queue_family_index].timestampValidBits > 0)
+	{
+		VkQueryPoolCreateInfo query_pool_info = {};
+		query_pool_info.sType                 = VK_STRUCTURE_TYPE_QUERY_POOL_CREATE_INFO;
+		query_pool_info.queryType             = VK_QUERY_TYPE_TIMESTAMP;
+		query_pool_info.queryCount            = 2;
+		VK_CHECK(vkCreateQueryPool(get_device().get_handle(), &query_pool_info, nullptr, &compute.query_pool));
+	}
+
 	// Separate command pool as queue family for compute may be different than graphics
 	VkCommandPoolCreateInfo command_pool_create_info = {};
 	command_pool_create_info.sType                   = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
@@ -672,8 +913,13 @@ void ComputeNBody::prepare_compute()
 	// Build a single command buffer containing the compute dispatch commands
 	build_compute_command_buffer();
 
-	// If necessary, acquire and immediately release the storage buffer, so that the initial acquire
-	// from the graphics command buffers are matched up properly.
+	prepare_storage_buffer_ownership();
+}
+
+// If necessary, acquire and immediately release the storage buffer, so that the initial acquire
+// from the graphics command buffers are matched up properly.
+void ComputeNBody::prepare_storage_buffer_ownership()
+{
 	if (graphics.queue_family_index != compute.queue_family_index)
 	{
 		VkCommandBuffer transfer_command;
@@ -758,6 +1004,59 @@ void ComputeNBody::prepare_compute()
 	}
 }
 
+void ComputeNBody::update_compute_descriptor_sets()
+{
+	VkDescriptorBufferInfo            storage_buffer_descriptor = create_descriptor(*compute.storage_buffer);
+	VkDescriptorBufferInfo            uniform_buffer_descriptor = create_descriptor(*compute.uniform_buffer);
+	std::vector<VkWriteDescriptorSet> compute_write_descriptor_sets =
+	    {
+	        // Binding 0 : Particle position storage buffer
+	        vkb::initializers::write_descriptor_set(
+	            compute.descriptor_set,
+	            VK_DESCRIPTOR_TYPE_STORAGE_BUFFER,
+	            0,
+	            &storage_buffer_descriptor),
+	        // Binding 1 : Uniform buffer
+	        vkb::initializers::write_descriptor_set(
+	            compute.descriptor_set,
+	            VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER,
+	            1,
+	            &uniform_buffer_descriptor)};
+
+	VkDescriptorBufferInfo cell_counts_descriptor      = create_descriptor(*grid.cell_counts);
+	VkDescriptorBufferInfo cell_offsets_descriptor     = create_descriptor(*grid.cell_offsets);
+	VkDescriptorBufferInfo particle_slots_descriptor   = create_descriptor(*grid.particle_slots);
+	VkDescriptorBufferInfo sorted_positions_descriptor = create_descriptor(*grid.sorted_positions);
+	VkDescriptorBufferInfo cell_masses_descriptor      = create_descriptor(*grid.cell_masses);
+
+	compute_write_descriptor_sets.push_back(vkb::initializers::write_descriptor_set(grid.descriptor_set, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, 0, &storage_buffer_descriptor));
+	compute_write_descriptor_sets.push_back(vkb::initializers::write_descriptor_set(grid.descriptor_set, VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, 1, &uniform_buffer_descriptor));
+	compute_write_descriptor_sets.push_back(vkb::initializers::write_descriptor_set(grid.descriptor_set, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, 2, &cell_counts_descriptor));
+	compute_write_descriptor_sets.push_back(vkb::initializers::write_descriptor_set(grid.descriptor_set, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, 3, &cell_offsets_descriptor));
+	compute_write_descriptor_sets.push_back(vkb::initializers::write_descriptor_set(grid.descriptor_set, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, 4, &particle_slots_descriptor));
+	compute_write_descriptor_sets.push_back(vkb::initializers::write_descriptor_set(grid.descriptor_set, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, 5, &sorted_positions_descriptor));
+	compute_write_descriptor_sets.push_back(vkb::initializers::write_descriptor_set(grid.descriptor_set, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, 6, &cell_masses_descriptor));
+
+	vkUpdateDescriptorSets(get_device().get_handle(), static_cast<uint32_t>(compute_write_descriptor_sets.size()), compute_write_descriptor_sets.data(), 0, NULL);
+}
+
+// Recreates the particles with the selected count and records the compute command buffer again
+void ComputeNBody::rebuild_compute_resources(bool particles)
+{
+	// Neither the storage buffers nor the command buffers may still be in use
+	vkDeviceWaitIdle(get_device().get_handle());
+
+	if (particles)
+	{
+		prepare_storage_buffers();
+		prepare_storage_buffer_ownership();
+		update_compute_descriptor_sets();
+		build_command_buffers();
+	}
+
+	build_compute_command_buffer();
+}
+
 // Prepare and initialize uniform buffer containing shader uniforms
 void ComputeNBody::prepare_uniform_buffers()
 {
@@ -845,11 +1144,98 @@ bool ComputeNBody::prepare(vkb::Platform &platform)
 	return true;
 }
 
+// Reads the timestamps of the last dispatch that has completed, returns false if no new result is available
+bool ComputeNBody::read_dispatch_time()
+{
+	if (compute.query_pool == VK_NULL_HANDLE)
+	{
+		return false;
+	}
+
+	std::array<uint64_t, 2> timestamps{};
+	if (vkGetQueryPoolResults(get_device().get_handle(), compute.query_pool, 0, 2, sizeof(timestamps), timestamps.data(), sizeof(uint64_t), VK_QUERY_RESULT_64_BIT) != VK_SUCCESS)
+	{
+		return false;
+	}
+
+	compute.dispatch_time = static_cast<float>(timestamps[1] - timestamps[0]) * get_device().get_gpu().get_properties().limits.timestampPeriod / 1000000.0f;
+	return true;
+}
+
+void ComputeNBody::begin_benchmark_step(size_t step)
+{
+	benchmark.step             = step;
+	benchmark.frames           = 0;
+	benchmark.frame_time       = 0.0f;
+	benchmark.dispatch_time    = 0.0f;
+	benchmark.dispatch_samples = 0;
+
+	particle_count_index = static_cast<int32_t>(step);
+	rebuild_particles    = true;
+}
+
+void ComputeNBody::update_benchmark(float delta_time, bool dispatch_timed)
+{
+	// Skip the first frames of each step, they still include the particle upload
+	if (++benchmark.frames <= BENCHMARK_WARMUP_FRAMES)
+	{
+		return;
+	}
+
+	benchmark.frame_time += delta_time;
+	if (dispatch_timed)
+	{
+		benchmark.dispatch_time += compute.dispatch_time;
+		benchmark.dispatch_samples++;
+	}
+
+	if (benchmark.frames < BENCHMARK_WARMUP_FRAMES + BENCHMARK_MEASURED_FRAMES)
+	{
+		return;
+	}
+
+	BenchmarkResult result;
+	result.particle_count    = num_particles;
+	result.frames_per_second = BENCHMARK_MEASURED_FRAMES / benchmark.frame_time;
+	result.dispatch_time     = benchmark.dispatch_samples > 0 ? benchmark.dispatch_time / benchmark.dispatch_samples : 0.0f;
+	benchmark.results.push_back(result);
+
+	LOGI("N-body {}: {} particles, {:.1f} frames/s, {:.3f} ms dispatch time", force_method_name(force_method), result.particle_count, result.frames_per_second, result.dispatch_time);
+
+	// The first particle count is the default one, the benchmark covers the others
+	size_t next_step = benchmark.step + 1;
+	if (next_step < particle_counts.size() && (force_method == UNIFORM_GRID || particle_counts[next_step] <= ALL_PAIRS_BENCHMARK_LIMIT))
+	{
+		begin_benchmark_step(next_step);
+		return;
+	}
+
+	if (next_step < particle_counts.size())
+	{
+		LOGI("N-body {}: skipping counts above {} particles", force_method_name(force_method), ALL_PAIRS_BENCHMARK_LIMIT);
+	}
+
+	benchmark.running    = false;
+	particle_count_index = benchmark.selected_count;
+	rebuild_particles    = true;
+}
+
 void ComputeNBody::render(float delta_time)
 {
 	if (!prepared)
 		return;
+	if (rebuild_particles || rebuild_compute)
+	{
+		rebuild_compute_resources(rebuild_particles);
+		rebuild_particles = false;
+		rebuild_compute   = false;
+	}
 	draw();
+	bool dispatch_timed = read_dispatch_time();
+	if (benchmark.running)
+	{
+		update_benchmark(delta_time, dispatch_timed);
+	}
 	update_compute_uniform_buffers(delta_time);
 	if (camera.updated)
 	{
@@ -857,6 +1243,48 @@ void ComputeNBody::render(float delta_time)
 	}
 }
 
+void ComputeNBody::on_update_ui_overlay(vkb::Drawer &drawer)
+{
+	if (drawer.header("Settings"))
+	{
+		// Settings are locked while the benchmark steps through the particle counts
+		if (benchmark.running)
+		{
+			drawer.text("Benchmarking %s...", force_method_name(force_method));
+		}
+		else
+		{
+			if (drawer.combo_box("Force evaluation", &force_method, {"All pairs", "Uniform grid"}))
+			{
+				rebuild_compute = true;
+			}
+			if (drawer.combo_box("Particles", &particle_count_index, particle_count_names))
+			{
+				rebuild_particles = true;
+			}
+			if (drawer.button("Scalability benchmark"))
+			{
+				benchmark.running        = true;
+				benchmark.selected_count = particle_count_index;
+				benchmark.results.clear();
+				begin_benchmark_step(1);
+			}
+		}
+	}
+	if (drawer.header("Statistics"))
+	{
+		drawer.text("Particles: %d", num_particles);
+		if (compute.query_pool != VK_NULL_HANDLE)
+		{
+			drawer.text("Dispatch time: %.3f ms", compute.dispatch_time);
+		}
+		for (auto &result : benchmark.results)
+		{
+			drawer.text("%d particles: %.1f fps, %.3f ms", result.particle_count, result.frames_per_second, result.dispatch_time);
+		}
+	}
+}
+
 void ComputeNBody::resize(const uint32_t width, const uint32_t height)
 {
 	ApiVulkanSample::resize(width, height);
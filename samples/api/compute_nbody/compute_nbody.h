@@ -16,7 +16,8 @@
  */
 
 /*
- * Compute shader N-body simulation using two passes and shared compute shader memory
+ * Compute shader N-body simulation using two passes and shared compute shader memory,
+ * or a uniform grid that is sorted on the GPU every frame for larger particle counts
  */
 
 #pragma once
@@ -30,11 +31,28 @@
 #	define PARTICLES_PER_ATTRACTOR 4 * 1024
 #endif
 
+// Cells per axis of the uniform grid, must be a multiple of the coarse factor (4) used by the grid shaders
+#define GRID_DIM 32
+
 class ComputeNBody : public ApiVulkanSample
 {
   public:
 	uint32_t num_particles;
 
+	// Force evaluation methods
+	enum ForceMethod : int32_t
+	{
+		ALL_PAIRS    = 0,        // Every particle against every other particle
+		UNIFORM_GRID = 1         // Exact near field from the sorted grid, far field from cell centers of mass
+	};
+
+	int32_t                  force_method         = UNIFORM_GRID;
+	int32_t                  particle_count_index = 0;        // Index into particle_counts
+	std::vector<uint32_t>    particle_counts;                 // Selectable particle counts, the first one is the default count
+	std::vector<std::string> particle_count_names;
+	bool                     rebuild_particles = false;       // Particles are recreated with the selected count before the next frame
+	bool                     rebuild_compute   = false;       // The compute command buffer is recorded again before the next frame
+
 	struct
 	{
 		Texture particle;
@@ -78,6 +96,8 @@ class ComputeNBody : public ApiVulkanSample
 		VkDescriptorSetLayout              descriptor_set_layout_blur;
 		VkDescriptorSet                    descriptor_set_blur;
 		uint32_t                           queue_family_index;
+		VkQueryPool                        query_pool;                   // Timestamps at the start and end of the dispatches
+		float                              dispatch_time = 0.0f;         // Last available dispatch time in milliseconds
 		struct ComputeUBO
 		{                              // Compute shader uniform block object
 			float   delta_time;        //		Frame delta time
@@ -85,6 +105,45 @@ class ComputeNBody : public ApiVulkanSample
 		} ubo;
 	} compute;
 
+	// Resources for the uniform grid force evaluation
+	struct
+	{
+		std::unique_ptr<vkb::core::Buffer> cell_counts;                  // Number of particles in each cell
+		std::unique_ptr<vkb::core::Buffer> cell_offsets;                 // First sorted index of each cell (exclusive prefix sum of the counts)
+		std::unique_ptr<vkb::core::Buffer> particle_slots;               // Cell and slot inside that cell of each particle
+		std::unique_ptr<vkb::core::Buffer> sorted_positions;             // Particle positions sorted by cell
+		std::unique_ptr<vkb::core::Buffer> cell_masses;                  // Centers of mass of the fine cells, followed by the coarse cells
+		VkDescriptorSetLayout              descriptor_set_layout;        // Grid shader binding layout
+		VkDescriptorSet                    descriptor_set;               // Grid shader bindings
+		VkPipelineLayout                   pipeline_layout;              // Layout of the grid pipelines
+		VkPipeline                         pipeline_count;               // Counts the particles of each cell
+		VkPipeline                         pipeline_scan;                // Prefix sum of the cell counts
+		VkPipeline                         pipeline_scatter;             // Sorts the particle positions by cell
+		VkPipeline                         pipeline_cells;               // Centers of mass of the fine cells
+		VkPipeline                         pipeline_coarse;              // Centers of mass of the coarse cells
+		VkPipeline                         pipeline_calculate;           // Velocity calculation from the grid
+	} grid;
+
+	// Scalability benchmark stepping through particle_counts
+	struct BenchmarkResult
+	{
+		uint32_t particle_count;
+		float    frames_per_second;
+		float    dispatch_time;        // Average dispatch time in milliseconds
+	};
+
+	struct
+	{
+		bool                         running          = false;
+		int32_t                      selected_count   = 0;           // Particle count index to restore once the benchmark is done
+		size_t                       step             = 0;           // Index into particle_counts
+		uint32_t                     frames           = 0;           // Frames rendered at the current step
+		float                        frame_time       = 0.0f;        // Accumulated time of the measured frames in seconds
+		float                        dispatch_time    = 0.0f;        // Accumulated dispatch time of the measured frames in milliseconds
+		uint32_t                     dispatch_samples = 0;
+		std::vector<BenchmarkResult> results;
+	} benchmark;
+
 	// SSBO particle declaration
 	struct Particle
 	{
@@ -98,7 +157,15 @@ class ComputeNBody : public ApiVulkanSample
 	void         load_assets();
 	void         build_command_buffers() override;
 	void         build_compute_command_buffer();
+	void         record_grid_dispatches();
 	void         prepare_storage_buffers();
+	void         prepare_grid_buffers();
+	void         prepare_storage_buffer_ownership();
+	void         update_compute_descriptor_sets();
+	void         rebuild_compute_resources(bool particles);
+	bool         read_dispatch_time();
+	void         begin_benchmark_step(size_t step);
+	void         update_benchmark(float delta_time, bool dispatch_timed);
 	void         setup_descriptor_pool();
 	void         setup_descriptor_set_layout();
 	void         setup_descriptor_set();
@@ -111,6 +178,7 @@ class ComputeNBody : public ApiVulkanSample
 	void         draw();
 	bool         prepare(vkb::Platform &platform) override;
 	virtual void render(float delta_time) override;
+	virtual void on_update_ui_overlay(vkb::Drawer &drawer) override;
 	virtual void resize(const uint32_t width, const uint32_t height) override;
 };
 
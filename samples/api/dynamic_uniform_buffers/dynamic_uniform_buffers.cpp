@@ -123,8 +123,6 @@ void DynamicUniformBuffers::build_command_buffers()
 			vkCmdDrawIndexed(draw_cmd_buffers[i], index_count, 1, 0, 0, 0);
 		}
 
-		draw_ui(draw_cmd_buffers[i]);
-
 		vkCmdEndRenderPass(draw_cmd_buffers[i]);
 
 		VK_CHECK(vkEndCommandBuffer(draw_cmd_buffers[i]));
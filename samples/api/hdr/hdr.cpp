@@ -26,6 +26,9 @@
 HDR::HDR()
 {
 	title = "High dynamic range rendering";
+
+	// The uniform buffers are ring-buffered per swap chain image, so the CPU may record ahead of the GPU
+	frames_in_flight = 2;
 }
 
 HDR::~HDR()
@@ -121,18 +124,22 @@ void HDR::build_command_buffers()
 
 			VkDeviceSize offsets[1] = {0};
 
+			// Each command buffer reads the uniform regions of its swap chain image (binding 0: matrices, binding 2: params)
+			std::array<uint32_t, 2> dynamic_offsets = {get_ring_uniform_offset(sizeof(ubo_vs), i),
+			                                           get_ring_uniform_offset(sizeof(ubo_params), i)};
+
 			// Skybox
 			if (display_skybox)
 			{
 				vkCmdBindPipeline(draw_cmd_buffers[i], VK_PIPELINE_BIND_POINT_GRAPHICS, pipelines.skybox);
-				vkCmdBindDescriptorSets(draw_cmd_buffers[i], VK_PIPELINE_BIND_POINT_GRAPHICS, pipeline_layouts.models, 0, 1, &descriptor_sets.skybox, 0, NULL);
+				vkCmdBindDescriptorSets(draw_cmd_buffers[i], VK_PIPELINE_BIND_POINT_GRAPHICS, pipeline_layouts.models, 0, 1, &descriptor_sets.skybox, vkb::to_u32(dynamic_offsets.size()), dynamic_offsets.data());
 
 				draw_model(models.skybox, draw_cmd_buffers[i]);
 			}
 
 			// 3D object
 			vkCmdBindPipeline(draw_cmd_buffers[i], VK_PIPELINE_BIND_POINT_GRAPHICS, pipelines.reflect);
-			vkCmdBindDescriptorSets(draw_cmd_buffers[i], VK_PIPELINE_BIND_POINT_GRAPHICS, pipeline_layouts.models, 0, 1, &descriptor_sets.object, 0, NULL);
+			vkCmdBindDescriptorSets(draw_cmd_buffers[i], VK_PIPELINE_BIND_POINT_GRAPHICS, pipeline_layouts.models, 0, 1, &descriptor_sets.object, vkb::to_u32(dynamic_offsets.size()), dynamic_offsets.data());
 
 			draw_model(models.objects[models.object_index], draw_cmd_buffers[i]);
 
@@ -215,8 +222,6 @@ void HDR::build_command_buffers()
 				vkCmdDraw(draw_cmd_buffers[i], 3, 1, 0, 0);
 			}
 
-			draw_ui(draw_cmd_buffers[i]);
-
 			vkCmdEndRenderPass(draw_cmd_buffers[i]);
 		}
 
@@ -343,7 +348,7 @@ void HDR::prepare_offscreen_buffer()
 		subpass.pDepthStencilAttachment = &depth_reference;
 
 		// Use subpass dependencies for attachment layput transitions
-		std::array<VkSubpassDependency, 2> dependencies;
+		std::array<VkSubpassDependency, 3> dependencies;
 
 		dependencies[0].srcSubpass      = VK_SUBPASS_EXTERNAL;
 		dependencies[0].dstSubpass      = 0;
@@ -361,13 +366,22 @@ void HDR::prepare_offscreen_buffer()
 		dependencies[1].dstAccessMask   = VK_ACCESS_MEMORY_READ_BIT;
 		dependencies[1].dependencyFlags = VK_DEPENDENCY_BY_REGION_BIT;
 
+		// The offscreen depth buffer is shared by all frames in flight, so its writes are ordered against the previous frame's
+		dependencies[2].srcSubpass      = VK_SUBPASS_EXTERNAL;
+		dependencies[2].dstSubpass      = 0;
+		dependencies[2].srcStageMask    = VK_PIPELINE_STAGE_LATE_FRAGMENT_TESTS_BIT;
+		dependencies[2].dstStageMask    = VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT | VK_PIPELINE_STAGE_LATE_FRAGMENT_TESTS_BIT;
+		dependencies[2].srcAccessMask   = VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT;
+		dependencies[2].dstAccessMask   = VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_READ_BIT | VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT;
+		dependencies[2].dependencyFlags = 0;
+
 		VkRenderPassCreateInfo render_pass_create_info = {};
 		render_pass_create_info.sType                  = VK_STRUCTURE_TYPE_RENDER_PASS_CREATE_INFO;
 		render_pass_create_info.pAttachments           = attachment_descriptions.data();
 		render_pass_create_info.attachmentCount        = static_cast<uint32_t>(attachment_descriptions.size());
 		render_pass_create_info.subpassCount           = 1;
 		render_pass_create_info.pSubpasses             = &subpass;
-		render_pass_create_info.dependencyCount        = 2;
+		render_pass_create_info.dependencyCount        = 3;
 		render_pass_create_info.pDependencies          = dependencies.data();
 
 		VK_CHECK(vkCreateRenderPass(get_device().get_handle(), &render_pass_create_info, nullptr, &offscreen.render_pass));
@@ -525,7 +539,7 @@ void HDR::load_assets()
 void HDR::setup_descriptor_pool()
 {
 	std::vector<VkDescriptorPoolSize> pool_sizes = {
-	    vkb::initializers::descriptor_pool_size(VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, 4),
+	    vkb::initializers::descriptor_pool_size(VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC, 4),
 	    vkb::initializers::descriptor_pool_size(VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, 6)};
 	uint32_t                   num_descriptor_sets = 4;
 	VkDescriptorPoolCreateInfo descriptor_pool_create_info =
@@ -536,9 +550,9 @@ void HDR::setup_descriptor_pool()
 void HDR::setup_descriptor_set_layout()
 {
 	std::vector<VkDescriptorSetLayoutBinding> set_layout_bindings = {
-	    vkb::initializers::descriptor_set_layout_binding(VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, VK_SHADER_STAGE_VERTEX_BIT, 0),
+	    vkb::initializers::descriptor_set_layout_binding(VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC, VK_SHADER_STAGE_VERTEX_BIT, 0),
 	    vkb::initializers::descriptor_set_layout_binding(VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, VK_SHADER_STAGE_FRAGMENT_BIT, 1),
-	    vkb::initializers::descriptor_set_layout_binding(VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, VK_SHADER_STAGE_FRAGMENT_BIT, 2),
+	    vkb::initializers::descriptor_set_layout_binding(VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC, VK_SHADER_STAGE_FRAGMENT_BIT, 2),
 	};
 
 	VkDescriptorSetLayoutCreateInfo descriptor_layout_create_info =
@@ -589,26 +603,26 @@ void HDR::setup_descriptor_sets()
 	// 3D object descriptor set
 	VK_CHECK(vkAllocateDescriptorSets(get_device().get_handle(), &alloc_info, &descriptor_sets.object));
 
-	VkDescriptorBufferInfo            matrix_buffer_descriptor     = create_descriptor(*uniform_buffers.matrices);
+	VkDescriptorBufferInfo            matrix_buffer_descriptor     = create_descriptor(*uniform_buffers.matrices, sizeof(ubo_vs));
 	VkDescriptorImageInfo             environment_image_descriptor = create_descriptor(textures.envmap);
-	VkDescriptorBufferInfo            params_buffer_descriptor     = create_descriptor(*uniform_buffers.params);
+	VkDescriptorBufferInfo            params_buffer_descriptor     = create_descriptor(*uniform_buffers.params, sizeof(ubo_params));
 	std::vector<VkWriteDescriptorSet> write_descriptor_sets        = {
-        vkb::initializers::write_descriptor_set(descriptor_sets.object, VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, 0, &matrix_buffer_descriptor),
+        vkb::initializers::write_descriptor_set(descriptor_sets.object, VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC, 0, &matrix_buffer_descriptor),
         vkb::initializers::write_descriptor_set(descriptor_sets.object, VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, 1, &environment_image_descriptor),
-        vkb::initializers::write_descriptor_set(descriptor_sets.object, VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, 2, &params_buffer_descriptor),
+        vkb::initializers::write_descriptor_set(descriptor_sets.object, VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC, 2, &params_buffer_descriptor),
     };
 	vkUpdateDescriptorSets(get_device().get_handle(), static_cast<uint32_t>(write_descriptor_sets.size()), write_descriptor_sets.data(), 0, NULL);
 
 	// Sky box descriptor set
 	VK_CHECK(vkAllocateDescriptorSets(get_device().get_handle(), &alloc_info, &descriptor_sets.skybox));
 
-	matrix_buffer_descriptor     = create_descriptor(*uniform_buffers.matrices);
+	matrix_buffer_descriptor     = create_descriptor(*uniform_buffers.matrices, sizeof(ubo_vs));
 	environment_image_descriptor = create_descriptor(textures.envmap);
-	params_buffer_descriptor     = create_descriptor(*uniform_buffers.params);
+	params_buffer_descriptor     = create_descriptor(*uniform_buffers.params, sizeof(ubo_params));
 	write_descriptor_sets        = {
-        vkb::initializers::write_descriptor_set(descriptor_sets.skybox, VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, 0, &matrix_buffer_descriptor),
+        vkb::initializers::write_descriptor_set(descriptor_sets.skybox, VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC, 0, &matrix_buffer_descriptor),
         vkb::initializers::write_descriptor_set(descriptor_sets.skybox, VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, 1, &environment_image_descriptor),
-        vkb::initializers::write_descriptor_set(descriptor_sets.skybox, VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, 2, &params_buffer_descriptor),
+        vkb::initializers::write_descriptor_set(descriptor_sets.skybox, VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC, 2, &params_buffer_descriptor),
     };
 	vkUpdateDescriptorSets(get_device().get_handle(), static_cast<uint32_t>(write_descriptor_sets.size()), write_descriptor_sets.data(), 0, NULL);
 
@@ -817,20 +831,13 @@ void HDR::prepare_pipelines()
 // Prepare and initialize uniform buffer containing shader uniforms
 void HDR::prepare_uniform_buffers()
 {
-	// Matrices vertex shader uniform buffer
-	uniform_buffers.matrices = std::make_unique<vkb::core::Buffer>(get_device(),
-	                                                               sizeof(ubo_vs),
-	                                                               VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT,
-	                                                               VMA_MEMORY_USAGE_CPU_TO_GPU);
-
-	// Params
-	uniform_buffers.params = std::make_unique<vkb::core::Buffer>(get_device(),
-	                                                             sizeof(ubo_params),
-	                                                             VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT,
-	                                                             VMA_MEMORY_USAGE_CPU_TO_GPU);
+	// Matrices vertex shader uniform buffer, one region per swap chain image
+	uniform_buffers.matrices = create_ring_uniform_buffer(sizeof(ubo_vs));
+
+	// Params, one region per swap chain image
+	uniform_buffers.params = create_ring_uniform_buffer(sizeof(ubo_params));
 
 	update_uniform_buffers();
-	update_params();
 }
 
 void HDR::update_uniform_buffers()
@@ -838,17 +845,16 @@ void HDR::update_uniform_buffers()
 	ubo_vs.projection       = camera.matrices.perspective;
 	ubo_vs.modelview        = camera.matrices.view * models.transforms[models.object_index];
 	ubo_vs.skybox_modelview = camera.matrices.view;
-	uniform_buffers.matrices->convert_and_update(ubo_vs);
-}
-
-void HDR::update_params()
-{
-	uniform_buffers.params->convert_and_update(ubo_params);
 }
 
 void HDR::draw()
 {
 	ApiVulkanSample::prepare_frame();
+
+	// Only the acquired image's regions are written, the other regions may still be read by frames in flight
+	update_ring_uniform_buffer(*uniform_buffers.matrices, ubo_vs);
+	update_ring_uniform_buffer(*uniform_buffers.params, ubo_params);
+
 	submit_info.commandBufferCount = 1;
 	submit_info.pCommandBuffers    = &draw_cmd_buffers[current_buffer];
 	VK_CHECK(vkQueueSubmit(queue, 1, &submit_info, VK_NULL_HANDLE));
@@ -894,23 +900,14 @@ void HDR::on_update_ui_overlay(vkb::Drawer &drawer)
 {
 	if (drawer.header("Settings"))
 	{
+		// Changed settings are picked up when the framework records the command buffers again, after the frames in flight
 		if (drawer.combo_box("Object type", &models.object_index, object_names))
 		{
 			update_uniform_buffers();
-			build_command_buffers();
-		}
-		if (drawer.input_float("Exposure", &ubo_params.exposure, 0.025f, 3))
-		{
-			update_params();
-		}
-		if (drawer.checkbox("Bloom", &bloom))
-		{
-			build_command_buffers();
-		}
-		if (drawer.checkbox("Skybox", &display_skybox))
-		{
-			build_command_buffers();
 		}
+		drawer.input_float("Exposure", &ubo_params.exposure, 0.025f, 3);
+		drawer.checkbox("Bloom", &bloom);
+		drawer.checkbox("Skybox", &display_skybox);
 	}
 }
 
@@ -24,6 +24,13 @@
 Instancing::Instancing()
 {
 	title = "Instanced mesh rendering";
+
+	// Stress mode counts, starting at the default count and scaling up to millions of instances
+	for (uint32_t count = INSTANCE_COUNT; count <= (1u << 21); count *= 4)
+	{
+		instance_counts.push_back(count);
+		instance_count_names.push_back(std::to_string(count));
+	}
 }
 
 Instancing::~Instancing()
@@ -31,12 +38,18 @@ Instancing::~Instancing()
 	if (device)
 	{
 		vkDestroyPipeline(get_device().get_handle(), pipelines.instanced_rocks, nullptr);
+		vkDestroyPipeline(get_device().get_handle(), pipelines.instanced_rocks_animated, nullptr);
 		vkDestroyPipeline(get_device().get_handle(), pipelines.planet, nullptr);
 		vkDestroyPipeline(get_device().get_handle(), pipelines.starfield, nullptr);
 		vkDestroyPipelineLayout(get_device().get_handle(), pipeline_layout, nullptr);
 		vkDestroyDescriptorSetLayout(get_device().get_handle(), descriptor_set_layout, nullptr);
-		vkDestroyBuffer(get_device().get_handle(), instance_buffer.buffer, nullptr);
-		vkFreeMemory(get_device().get_handle(), instance_buffer.memory, nullptr);
+		vkDestroyPipeline(get_device().get_handle(), compute.pipeline, nullptr);
+		vkDestroyPipelineLayout(get_device().get_handle(), compute.pipeline_layout, nullptr);
+		vkDestroyDescriptorSetLayout(get_device().get_handle(), compute.descriptor_set_layout, nullptr);
+		if (compute.query_pool != VK_NULL_HANDLE)
+		{
+			vkDestroyQueryPool(get_device().get_handle(), compute.query_pool, nullptr);
+		}
 		vkDestroySampler(get_device().get_handle(), textures.rocks.sampler, nullptr);
 		vkDestroySampler(get_device().get_handle(), textures.planet.sampler, nullptr);
 	}
@@ -67,6 +80,15 @@ void Instancing::request_gpu_features(vkb::PhysicalDevice &gpu)
 };
 
 void Instancing::build_command_buffers()
+{
+	for (uint32_t i = 0; i < draw_cmd_buffers.size(); ++i)
+	{
+		build_command_buffer(i);
+	}
+}
+
+// Records the draw command buffer of one swapchain image, in compute mode this also records the instance update feeding the draw
+void Instancing::build_command_buffer(uint32_t i)
 {
 	VkCommandBufferBeginInfo command_buffer_begin_info = vkb::initializers::command_buffer_begin_info();
 
@@ -81,56 +103,96 @@ void Instancing::build_command_buffers()
 	render_pass_begin_info.clearValueCount          = 2;
 	render_pass_begin_info.pClearValues             = clear_values;
 
-	for (int32_t i = 0; i < draw_cmd_buffers.size(); ++i)
-	{
-		// Set target frame buffer
-		render_pass_begin_info.framebuffer = framebuffers[i];
+	// Set target frame buffer
+	render_pass_begin_info.framebuffer = framebuffers[i];
 
-		VK_CHECK(vkBeginCommandBuffer(draw_cmd_buffers[i], &command_buffer_begin_info));
+	VK_CHECK(vkBeginCommandBuffer(draw_cmd_buffers[i], &command_buffer_begin_info));
 
-		vkCmdBeginRenderPass(draw_cmd_buffers[i], &render_pass_begin_info, VK_SUBPASS_CONTENTS_INLINE);
-
-		VkViewport viewport = vkb::initializers::viewport(static_cast<float>(width), static_cast<float>(height), 0.0f, 1.0f);
-		vkCmdSetViewport(draw_cmd_buffers[i], 0, 1, &viewport);
+	if (compute.query_pool != VK_NULL_HANDLE)
+	{
+		vkCmdResetQueryPool(draw_cmd_buffers[i], compute.query_pool, 0, 4);
+	}
 
-		VkRect2D scissor = vkb::initializers::rect2D(width, height, 0, 0);
-		vkCmdSetScissor(draw_cmd_buffers[i], 0, 1, &scissor);
+	VkBuffer instance_vertex_buffer = instance_buffer.base->get_handle();
+	if (update_mode == COMPUTE_INSTANCES)
+	{
+		if (compute.query_pool != VK_NULL_HANDLE)
+		{
+			vkCmdWriteTimestamp(draw_cmd_buffers[i], VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, compute.query_pool, 0);
+		}
+
+		// Animate the instances straight into the vertex buffer drawn from this frame
+		// The other buffer of the pair may still be fetched by the previous frame's draw, so no write-after-read barrier is needed
+		vkCmdBindPipeline(draw_cmd_buffers[i], VK_PIPELINE_BIND_POINT_COMPUTE, compute.pipeline);
+		vkCmdBindDescriptorSets(draw_cmd_buffers[i], VK_PIPELINE_BIND_POINT_COMPUTE, compute.pipeline_layout, 0, 1, &compute.descriptor_sets[compute.frame_index], 0, nullptr);
+		vkCmdDispatch(draw_cmd_buffers[i], (instance_count + 255) / 256, 1, 1);
+
+		if (compute.query_pool != VK_NULL_HANDLE)
+		{
+			vkCmdWriteTimestamp(draw_cmd_buffers[i], VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, compute.query_pool, 1);
+		}
+
+		// The instanced draw fetches the compute output as vertex attributes
+		VkBufferMemoryBarrier buffer_barrier = vkb::initializers::buffer_memory_barrier();
+		buffer_barrier.buffer                = instance_buffer.animated[compute.frame_index]->get_handle();
+		buffer_barrier.size                  = instance_buffer.size;
+		buffer_barrier.srcAccessMask         = VK_ACCESS_SHADER_WRITE_BIT;
+		buffer_barrier.dstAccessMask         = VK_ACCESS_VERTEX_ATTRIBUTE_READ_BIT;
+		buffer_barrier.srcQueueFamilyIndex   = VK_QUEUE_FAMILY_IGNORED;
+		buffer_barrier.dstQueueFamilyIndex   = VK_QUEUE_FAMILY_IGNORED;
+		vkCmdPipelineBarrier(draw_cmd_buffers[i], VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_PIPELINE_STAGE_VERTEX_INPUT_BIT, 0, 0, nullptr, 1, &buffer_barrier, 0, nullptr);
+
+		instance_vertex_buffer = instance_buffer.animated[compute.frame_index]->get_handle();
+	}
 
-		VkDeviceSize offsets[1] = {0};
+	vkCmdBeginRenderPass(draw_cmd_buffers[i], &render_pass_begin_info, VK_SUBPASS_CONTENTS_INLINE);
 
-		// Star field
-		vkCmdBindDescriptorSets(draw_cmd_buffers[i], VK_PIPELINE_BIND_POINT_GRAPHICS, pipeline_layout, 0, 1, &descriptor_sets.planet, 0, NULL);
-		vkCmdBindPipeline(draw_cmd_buffers[i], VK_PIPELINE_BIND_POINT_GRAPHICS, pipelines.starfield);
-		vkCmdDraw(draw_cmd_buffers[i], 4, 1, 0, 0);
+	VkViewport viewport = vkb::initializers::viewport(static_cast<float>(width), static_cast<float>(height), 0.0f, 1.0f);
+	vkCmdSetViewport(draw_cmd_buffers[i], 0, 1, &viewport);
 
-		// Planet
-		auto &planet_vertex_buffer = models.planet->vertex_buffers.at("vertex_buffer");
-		auto &planet_index_buffer  = models.planet->index_buffer;
-		vkCmdBindDescriptorSets(draw_cmd_buffers[i], VK_PIPELINE_BIND_POINT_GRAPHICS, pipeline_layout, 0, 1, &descriptor_sets.planet, 0, NULL);
-		vkCmdBindPipeline(draw_cmd_buffers[i], VK_PIPELINE_BIND_POINT_GRAPHICS, pipelines.planet);
-		vkCmdBindVertexBuffers(draw_cmd_buffers[i], 0, 1, planet_vertex_buffer.get(), offsets);
-		vkCmdBindIndexBuffer(draw_cmd_buffers[i], planet_index_buffer->get_handle(), 0, VK_INDEX_TYPE_UINT32);
-		vkCmdDrawIndexed(draw_cmd_buffers[i], models.planet->vertex_indices, 1, 0, 0, 0);
+	VkRect2D scissor = vkb::initializers::rect2D(width, height, 0, 0);
+	vkCmdSetScissor(draw_cmd_buffers[i], 0, 1, &scissor);
 
-		// Instanced rocks
-		auto &rock_vertex_buffer = models.rock->vertex_buffers.at("vertex_buffer");
-		auto &rock_index_buffer  = models.rock->index_buffer;
-		vkCmdBindDescriptorSets(draw_cmd_buffers[i], VK_PIPELINE_BIND_POINT_GRAPHICS, pipeline_layout, 0, 1, &descriptor_sets.instanced_rocks, 0, NULL);
-		vkCmdBindPipeline(draw_cmd_buffers[i], VK_PIPELINE_BIND_POINT_GRAPHICS, pipelines.instanced_rocks);
-		// Binding point 0 : Mesh vertex buffer
-		vkCmdBindVertexBuffers(draw_cmd_buffers[i], 0, 1, rock_vertex_buffer.get(), offsets);
-		// Binding point 1 : Instance data buffer
-		vkCmdBindVertexBuffers(draw_cmd_buffers[i], 1, 1, &instance_buffer.buffer, offsets);
-		vkCmdBindIndexBuffer(draw_cmd_buffers[i], rock_index_buffer->get_handle(), 0, VK_INDEX_TYPE_UINT32);
-		// Render instances
-		vkCmdDrawIndexed(draw_cmd_buffers[i], models.rock->vertex_indices, INSTANCE_COUNT, 0, 0, 0);
+	VkDeviceSize offsets[1] = {0};
 
-		draw_ui(draw_cmd_buffers[i]);
+	// Star field
+	vkCmdBindDescriptorSets(draw_cmd_buffers[i], VK_PIPELINE_BIND_POINT_GRAPHICS, pipeline_layout, 0, 1, &descriptor_sets.planet, 0, NULL);
+	vkCmdBindPipeline(draw_cmd_buffers[i], VK_PIPELINE_BIND_POINT_GRAPHICS, pipelines.starfield);
+	vkCmdDraw(draw_cmd_buffers[i], 4, 1, 0, 0);
 
-		vkCmdEndRenderPass(draw_cmd_buffers[i]);
+	// Planet
+	auto &planet_vertex_buffer = models.planet->vertex_buffers.at("vertex_buffer");
+	auto &planet_index_buffer  = models.planet->index_buffer;
+	vkCmdBindDescriptorSets(draw_cmd_buffers[i], VK_PIPELINE_BIND_POINT_GRAPHICS, pipeline_layout, 0, 1, &descriptor_sets.planet, 0, NULL);
+	vkCmdBindPipeline(draw_cmd_buffers[i], VK_PIPELINE_BIND_POINT_GRAPHICS, pipelines.planet);
+	vkCmdBindVertexBuffers(draw_cmd_buffers[i], 0, 1, planet_vertex_buffer.get(), offsets);
+	vkCmdBindIndexBuffer(draw_cmd_buffers[i], planet_index_buffer->get_handle(), 0, VK_INDEX_TYPE_UINT32);
+	vkCmdDrawIndexed(draw_cmd_buffers[i], models.planet->vertex_indices, 1, 0, 0, 0);
 
-		VK_CHECK(vkEndCommandBuffer(draw_cmd_buffers[i]));
+	// Instanced rocks
+	auto &rock_vertex_buffer = models.rock->vertex_buffers.at("vertex_buffer");
+	auto &rock_index_buffer  = models.rock->index_buffer;
+	vkCmdBindDescriptorSets(draw_cmd_buffers[i], VK_PIPELINE_BIND_POINT_GRAPHICS, pipeline_layout, 0, 1, &descriptor_sets.instanced_rocks, 0, NULL);
+	vkCmdBindPipeline(draw_cmd_buffers[i], VK_PIPELINE_BIND_POINT_GRAPHICS, update_mode == COMPUTE_INSTANCES ? pipelines.instanced_rocks_animated : pipelines.instanced_rocks);
+	// Binding point 0 : Mesh vertex buffer
+	vkCmdBindVertexBuffers(draw_cmd_buffers[i], 0, 1, rock_vertex_buffer.get(), offsets);
+	// Binding point 1 : Instance data buffer
+	vkCmdBindVertexBuffers(draw_cmd_buffers[i], 1, 1, &instance_vertex_buffer, offsets);
+	vkCmdBindIndexBuffer(draw_cmd_buffers[i], rock_index_buffer->get_handle(), 0, VK_INDEX_TYPE_UINT32);
+	// Render instances
+	if (compute.query_pool != VK_NULL_HANDLE)
+	{
+		vkCmdWriteTimestamp(draw_cmd_buffers[i], VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, compute.query_pool, 2);
+	}
+	vkCmdDrawIndexed(draw_cmd_buffers[i], models.rock->vertex_indices, instance_count, 0, 0, 0);
+	if (compute.query_pool != VK_NULL_HANDLE)
+	{
+		vkCmdWriteTimestamp(draw_cmd_buffers[i], VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, compute.query_pool, 3);
 	}
+
+	vkCmdEndRenderPass(draw_cmd_buffers[i]);
+
+	VK_CHECK(vkEndCommandBuffer(draw_cmd_buffers[i]));
 }
 
 void Instancing::load_assets()
@@ -150,18 +212,19 @@ void Instancing::load_assets()
 
 void Instancing::setup_descriptor_pool()
 {
-	// Example uses one ubo
+	// Example uses one ubo for rendering, the compute update adds one ubo and two storage buffers per animated buffer
 	std::vector<VkDescriptorPoolSize> pool_sizes =
 	    {
-	        vkb::initializers::descriptor_pool_size(VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, 2),
+	        vkb::initializers::descriptor_pool_size(VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, 4),
 	        vkb::initializers::descriptor_pool_size(VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, 2),
+	        vkb::initializers::descriptor_pool_size(VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, 4),
 	    };
 
 	VkDescriptorPoolCreateInfo descriptor_pool_create_info =
 	    vkb::initializers::descriptor_pool_create_info(
 	        vkb::to_u32(pool_sizes.size()),
 	        pool_sizes.data(),
-	        2);
+	        4);
 
 	VK_CHECK(vkCreateDescriptorPool(get_device().get_handle(), &descriptor_pool_create_info, nullptr, &descriptor_pool));
 }
@@ -340,6 +403,13 @@ void Instancing::prepare_pipelines()
 	input_state.vertexAttributeDescriptionCount = static_cast<uint32_t>(attribute_descriptions.size());
 	VK_CHECK(vkCreateGraphicsPipelines(get_device().get_handle(), pipeline_cache, 1, &pipeline_create_info, nullptr, &pipelines.instanced_rocks));
 
+	// Same input layout, but the instances are already animated by the compute update
+	VkBool32                 pre_transformed      = VK_TRUE;
+	VkSpecializationMapEntry specialization_entry = vkb::initializers::specialization_map_entry(0, 0, sizeof(VkBool32));
+	VkSpecializationInfo     specialization_info  = vkb::initializers::specialization_info(1, &specialization_entry, sizeof(VkBool32), &pre_transformed);
+	shader_stages[0].pSpecializationInfo          = &specialization_info;
+	VK_CHECK(vkCreateGraphicsPipelines(get_device().get_handle(), pipeline_cache, 1, &pipeline_create_info, nullptr, &pipelines.instanced_rocks_animated));
+
 	// Planet rendering pipeline
 	shader_stages[0] = load_shader("instancing/planet.vert", VK_SHADER_STAGE_VERTEX_BIT);
 	shader_stages[1] = load_shader("instancing/planet.frag", VK_SHADER_STAGE_FRAGMENT_BIT);
@@ -362,14 +432,14 @@ void Instancing::prepare_pipelines()
 void Instancing::prepare_instance_data()
 {
 	std::vector<InstanceData> instance_data;
-	instance_data.resize(INSTANCE_COUNT);
+	instance_data.resize(instance_count);
 
 	std::default_random_engine              rnd_generator(is_benchmark_mode() ? 0 : (unsigned) time(nullptr));
 	std::uniform_real_distribution<float>   uniform_dist(0.0, 1.0);
 	std::uniform_int_distribution<uint32_t> rnd_texture_index(0, textures.rocks.image->get_vk_image().get_array_layer_count());
 
 	// Distribute rocks randomly on two different rings
-	for (auto i = 0; i < INSTANCE_COUNT / 2; i++)
+	for (auto i = 0; i < instance_count / 2; i++)
 	{
 		glm::vec2 ring0{7.0f, 11.0f};
 		glm::vec2 ring1{14.0f, 18.0f};
@@ -388,11 +458,11 @@ void Instancing::prepare_instance_data()
 		// Outer ring
 		rho                                                                 = sqrt((pow(ring1[1], 2.0f) - pow(ring1[0], 2.0f)) * uniform_dist(rnd_generator) + pow(ring1[0], 2.0f));
 		theta                                                               = 2.0f * glm::pi<float>() * uniform_dist(rnd_generator);
-		instance_data[static_cast<size_t>(i + INSTANCE_COUNT / 2)].pos      = glm::vec3(rho * cos(theta), uniform_dist(rnd_generator) * 0.5f - 0.25f, rho * sin(theta));
-		instance_data[static_cast<size_t>(i + INSTANCE_COUNT / 2)].rot      = glm::vec3(glm::pi<float>() * uniform_dist(rnd_generator), glm::pi<float>() * uniform_dist(rnd_generator), glm::pi<float>() * uniform_dist(rnd_generator));
-		instance_data[static_cast<size_t>(i + INSTANCE_COUNT / 2)].scale    = 1.5f + uniform_dist(rnd_generator) - uniform_dist(rnd_generator);
-		instance_data[static_cast<size_t>(i + INSTANCE_COUNT / 2)].texIndex = rnd_texture_index(rnd_generator);
-		instance_data[static_cast<size_t>(i + INSTANCE_COUNT / 2)].scale *= 0.75f;
+		instance_data[static_cast<size_t>(i + instance_count / 2)].pos      = glm::vec3(rho * cos(theta), uniform_dist(rnd_generator) * 0.5f - 0.25f, rho * sin(theta));
+		instance_data[static_cast<size_t>(i + instance_count / 2)].rot      = glm::vec3(glm::pi<float>() * uniform_dist(rnd_generator), glm::pi<float>() * uniform_dist(rnd_generator), glm::pi<float>() * uniform_dist(rnd_generator));
+		instance_data[static_cast<size_t>(i + instance_count / 2)].scale    = 1.5f + uniform_dist(rnd_generator) - uniform_dist(rnd_generator);
+		instance_data[static_cast<size_t>(i + instance_count / 2)].texIndex = rnd_texture_index(rnd_generator);
+		instance_data[static_cast<size_t>(i + instance_count / 2)].scale *= 0.75f;
 	}
 
 	instance_buffer.size = instance_data.size() * sizeof(InstanceData);
@@ -401,47 +471,144 @@ void Instancing::prepare_instance_data()
 	// Instanced data is static, copy to device local memory
 	// On devices with separate memory types for host visible and device local memory this will result in better performance
 	// On devices with unified memory types (DEVICE_LOCAL_BIT and HOST_VISIBLE_BIT supported at once) this isn't necessary and you could skip the staging
+	vkb::core::Buffer staging_buffer{get_device(), instance_buffer.size, VK_BUFFER_USAGE_TRANSFER_SRC_BIT, VMA_MEMORY_USAGE_CPU_ONLY};
+	staging_buffer.update(instance_data.data(), instance_buffer.size);
+
+	// The initial data is also read by the compute update
+	instance_buffer.base = std::make_unique<vkb::core::Buffer>(get_device(),
+	                                                           instance_buffer.size,
+	                                                           VK_BUFFER_USAGE_VERTEX_BUFFER_BIT | VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+	                                                           VMA_MEMORY_USAGE_GPU_ONLY);
 
-	struct
+	// Written by the compute update every frame, never by the host
+	for (auto &animated : instance_buffer.animated)
 	{
-		VkDeviceMemory memory;
-		VkBuffer       buffer;
-	} staging_buffer;
-
-	staging_buffer.buffer = get_device().create_buffer(
-	    VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
-	    VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
-	    instance_buffer.size,
-	    &staging_buffer.memory,
-	    instance_data.data());
-
-	instance_buffer.buffer = get_device().create_buffer(
-	    VK_BUFFER_USAGE_VERTEX_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT,
-	    VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
-	    instance_buffer.size,
-	    &instance_buffer.memory);
-
-	// Copy to staging buffer
+		animated = std::make_unique<vkb::core::Buffer>(get_device(),
+		                                               instance_buffer.size,
+		                                               VK_BUFFER_USAGE_VERTEX_BUFFER_BIT | VK_BUFFER_USAGE_STORAGE_BUFFER_BIT,
+		                                               VMA_MEMORY_USAGE_GPU_ONLY);
+	}
+
+	// Copy to device local buffer
 	VkCommandBuffer copy_command = device->create_command_buffer(VK_COMMAND_BUFFER_LEVEL_PRIMARY, true);
 
 	VkBufferCopy copy_region = {};
 	copy_region.size         = instance_buffer.size;
 	vkCmdCopyBuffer(
 	    copy_command,
-	    staging_buffer.buffer,
-	    instance_buffer.buffer,
+	    staging_buffer.get_handle(),
+	    instance_buffer.base->get_handle(),
 	    1,
 	    &copy_region);
 
 	device->flush_command_buffer(copy_command, queue, true);
 
-	instance_buffer.descriptor.range  = instance_buffer.size;
-	instance_buffer.descriptor.buffer = instance_buffer.buffer;
-	instance_buffer.descriptor.offset = 0;
+	compute.ubo.instance_count = instance_count;
+}
+
+void Instancing::prepare_compute()
+{
+	std::vector<VkDescriptorSetLayoutBinding> set_layout_bindings =
+	    {
+	        // Binding 0 : Animation speeds and instance count
+	        vkb::initializers::descriptor_set_layout_binding(
+	            VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER,
+	            VK_SHADER_STAGE_COMPUTE_BIT,
+	            0),
+	        // Binding 1 : Initial instance data
+	        vkb::initializers::descriptor_set_layout_binding(
+	            VK_DESCRIPTOR_TYPE_STORAGE_BUFFER,
+	            VK_SHADER_STAGE_COMPUTE_BIT,
+	            1),
+	        // Binding 2 : Animated instances, bound as the instance vertex buffer afterwards
+	        vkb::initializers::descriptor_set_layout_binding(
+	            VK_DESCRIPTOR_TYPE_STORAGE_BUFFER,
+	            VK_SHADER_STAGE_COMPUTE_BIT,
+	            2),
+	    };
+
+	VkDescriptorSetLayoutCreateInfo descriptor_layout_create_info =
+	    vkb::initializers::descriptor_set_layout_create_info(
+	        set_layout_bindings.data(),
+	        vkb::to_u32(set_layout_bindings.size()));
+
+	VK_CHECK(vkCreateDescriptorSetLayout(get_device().get_handle(), &descriptor_layout_create_info, nullptr, &compute.descriptor_set_layout));
+
+	VkPipelineLayoutCreateInfo pipeline_layout_create_info =
+	    vkb::initializers::pipeline_layout_create_info(
+	        &compute.descriptor_set_layout,
+	        1);
+
+	VK_CHECK(vkCreatePipelineLayout(get_device().get_handle(), &pipeline_layout_create_info, nullptr, &compute.pipeline_layout));
+
+	VkComputePipelineCreateInfo compute_pipeline_create_info = vkb::initializers::compute_pipeline_create_info(compute.pipeline_layout, 0);
+	compute_pipeline_create_info.stage                       = load_shader("instancing/instance_update.comp", VK_SHADER_STAGE_COMPUTE_BIT);
+	VK_CHECK(vkCreateComputePipelines(get_device().get_handle(), pipeline_cache, 1, &compute_pipeline_create_info, nullptr, &compute.pipeline));
+
+	// Timestamps around the instance update and the instanced draw, if the graphics queue supports them
+	if (get_device().get_suitable_graphics_queue().get_properties().timestampValidBits > 0)
+	{
+		VkQueryPoolCreateInfo query_pool_info = {};
+		query_pool_info.sType                 = VK_STRUCTURE_TYPE_QUERY_POOL_CREATE_INFO;
+		query_pool_info.queryType             = VK_QUERY_TYPE_TIMESTAMP;
+		query_pool_info.queryCount            = 4;
+		VK_CHECK(vkCreateQueryPool(get_device().get_handle(), &query_pool_info, nullptr, &compute.query_pool));
+	}
+}
+
+void Instancing::update_compute_descriptor_sets()
+{
+	VkDescriptorBufferInfo uniform_descriptor = create_descriptor(*compute.uniform_buffer);
+	VkDescriptorBufferInfo base_descriptor    = create_descriptor(*instance_buffer.base);
+
+	for (size_t i = 0; i < compute.descriptor_sets.size(); ++i)
+	{
+		if (compute.descriptor_sets[i] == VK_NULL_HANDLE)
+		{
+			VkDescriptorSetAllocateInfo descriptor_set_alloc_info = vkb::initializers::descriptor_set_allocate_info(descriptor_pool, &compute.descriptor_set_layout, 1);
+			VK_CHECK(vkAllocateDescriptorSets(get_device().get_handle(), &descriptor_set_alloc_info, &compute.descriptor_sets[i]));
+		}
+
+		VkDescriptorBufferInfo            animated_descriptor   = create_descriptor(*instance_buffer.animated[i]);
+		std::vector<VkWriteDescriptorSet> write_descriptor_sets = {
+		    vkb::initializers::write_descriptor_set(compute.descriptor_sets[i], VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, 0, &uniform_descriptor),        // Binding 0 : Compute uniform buffer
+		    vkb::initializers::write_descriptor_set(compute.descriptor_sets[i], VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, 1, &base_descriptor),           // Binding 1 : Initial instances
+		    vkb::initializers::write_descriptor_set(compute.descriptor_sets[i], VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, 2, &animated_descriptor)        // Binding 2 : Animated instances
+		};
+		vkUpdateDescriptorSets(get_device().get_handle(), vkb::to_u32(write_descriptor_sets.size()), write_descriptor_sets.data(), 0, NULL);
+	}
+}
+
+void Instancing::rebuild_instance_resources()
+{
+	// Neither the instance buffers nor the command buffers may still be in use
+	vkDeviceWaitIdle(get_device().get_handle());
+
+	instance_count = instance_counts[instance_count_index];
+	prepare_instance_data();
+	update_compute_descriptor_sets();
+	build_command_buffers();
+}
+
+// Reads the timestamps of the last frame, the device is idle after each submission in this sample
+void Instancing::read_timestamps()
+{
+	if (compute.query_pool == VK_NULL_HANDLE)
+	{
+		return;
+	}
 
-	// Destroy staging resources
-	vkDestroyBuffer(get_device().get_handle(), staging_buffer.buffer, nullptr);
-	vkFreeMemory(get_device().get_handle(), staging_buffer.memory, nullptr);
+	float                   period = get_device().get_gpu().get_properties().limits.timestampPeriod / 1000000.0f;
+	std::array<uint64_t, 2> timestamps{};
+	if (update_mode == COMPUTE_INSTANCES &&
+	    vkGetQueryPoolResults(get_device().get_handle(), compute.query_pool, 0, 2, sizeof(timestamps), timestamps.data(), sizeof(uint64_t), VK_QUERY_RESULT_64_BIT) == VK_SUCCESS)
+	{
+		compute.update_time = static_cast<float>(timestamps[1] - timestamps[0]) * period;
+	}
+	if (vkGetQueryPoolResults(get_device().get_handle(), compute.query_pool, 2, 2, sizeof(timestamps), timestamps.data(), sizeof(uint64_t), VK_QUERY_RESULT_64_BIT) == VK_SUCCESS)
+	{
+		compute.draw_time = static_cast<float>(timestamps[1] - timestamps[0]) * period;
+	}
 }
 
 void Instancing::prepare_uniform_buffers()
@@ -451,6 +618,11 @@ void Instancing::prepare_uniform_buffers()
 	                                                            VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT,
 	                                                            VMA_MEMORY_USAGE_CPU_TO_GPU);
 
+	compute.uniform_buffer = std::make_unique<vkb::core::Buffer>(get_device(),
+	                                                             sizeof(compute.ubo),
+	                                                             VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT,
+	                                                             VMA_MEMORY_USAGE_CPU_TO_GPU);
+
 	update_uniform_buffer(0.0f);
 }
 
@@ -466,12 +638,24 @@ void Instancing::update_uniform_buffer(float delta_time)
 	}
 
 	uniform_buffers.scene->convert_and_update(ubo_vs);
+
+	// The compute update evaluates the same animation before the draw
+	compute.ubo.loc_speed  = ubo_vs.loc_speed;
+	compute.ubo.glob_speed = ubo_vs.glob_speed;
+	compute.uniform_buffer->convert_and_update(compute.ubo);
 }
 
 void Instancing::draw()
 {
 	ApiVulkanSample::prepare_frame();
 
+	// Alternate the animated instance buffers, the command buffer is recorded again to pick up this frame's buffer
+	if (update_mode == COMPUTE_INSTANCES)
+	{
+		compute.frame_index = (compute.frame_index + 1) % vkb::to_u32(instance_buffer.animated.size());
+		build_command_buffer(current_buffer);
+	}
+
 	// Command buffer to be sumitted to the queue
 	submit_info.commandBufferCount = 1;
 	submit_info.pCommandBuffers    = &draw_cmd_buffers[current_buffer];
@@ -480,6 +664,8 @@ void Instancing::draw()
 	VK_CHECK(vkQueueSubmit(queue, 1, &submit_info, VK_NULL_HANDLE));
 
 	ApiVulkanSample::submit_frame();
+
+	read_timestamps();
 }
 
 bool Instancing::prepare(vkb::Platform &platform)
@@ -500,8 +686,10 @@ bool Instancing::prepare(vkb::Platform &platform)
 	prepare_uniform_buffers();
 	setup_descriptor_set_layout();
 	prepare_pipelines();
+	prepare_compute();
 	setup_descriptor_pool();
 	setup_descriptor_set();
+	update_compute_descriptor_sets();
 	build_command_buffers();
 	prepared = true;
 	return true;
@@ -513,6 +701,11 @@ void Instancing::render(float delta_time)
 	{
 		return;
 	}
+	if (rebuild_instances)
+	{
+		rebuild_instance_resources();
+		rebuild_instances = false;
+	}
 	draw();
 	if (!paused || camera.updated)
 	{
@@ -522,9 +715,28 @@ void Instancing::render(float delta_time)
 
 void Instancing::on_update_ui_overlay(vkb::Drawer &drawer)
 {
+	if (drawer.header("Settings"))
+	{
+		if (drawer.combo_box("Instance update", &update_mode, {"Static (vertex shader)", "Compute (double-buffered)"}))
+		{
+			rebuild_instances = true;
+		}
+		if (drawer.combo_box("Instances", &instance_count_index, instance_count_names))
+		{
+			rebuild_instances = true;
+		}
+	}
 	if (drawer.header("Statistics"))
 	{
-		drawer.text("Instances: %d", INSTANCE_COUNT);
+		drawer.text("Instances: %d", instance_count);
+		if (compute.query_pool != VK_NULL_HANDLE)
+		{
+			if (update_mode == COMPUTE_INSTANCES)
+			{
+				drawer.text("Instance update: %.3f ms", compute.update_time);
+			}
+			drawer.text("Instanced draw: %.3f ms", compute.draw_time);
+		}
 	}
 }
 
@@ -52,15 +52,49 @@ class Instancing : public ApiVulkanSample
 		float     scale;
 		uint32_t  texIndex;
 	};
+	// How the per-instance data is animated each frame
+	enum InstanceUpdateMode
+	{
+		STATIC_INSTANCES,        // Static instance buffer, animation is evaluated per vertex from the uniform speeds
+		COMPUTE_INSTANCES        // A compute pass writes the animated instances straight into a vertex buffer
+	};
+
 	// Contains the instanced data
 	struct InstanceBuffer
 	{
-		VkBuffer               buffer = VK_NULL_HANDLE;
-		VkDeviceMemory         memory = VK_NULL_HANDLE;
-		size_t                 size   = 0;
-		VkDescriptorBufferInfo descriptor;
+		std::unique_ptr<vkb::core::Buffer>                base;            // Initial instance data, also bound directly in static mode
+		std::array<std::unique_ptr<vkb::core::Buffer>, 2> animated;        // Double-buffered compute output, alternated across frames
+		size_t                                            size = 0;
 	} instance_buffer;
 
+	// Resources for the compute instance update
+	struct
+	{
+		VkDescriptorSetLayout          descriptor_set_layout = VK_NULL_HANDLE;
+		std::array<VkDescriptorSet, 2> descriptor_sets{};        // One per animated output buffer
+		VkPipelineLayout               pipeline_layout = VK_NULL_HANDLE;
+		VkPipeline                     pipeline        = VK_NULL_HANDLE;
+		VkQueryPool                    query_pool      = VK_NULL_HANDLE;        // Timestamps around the update and around the instanced draw
+		uint32_t                       frame_index     = 0;                     // Animated buffer written and drawn from in the current frame
+		float                          update_time     = 0.0f;
+		float                          draw_time       = 0.0f;
+
+		struct ComputeUBO
+		{
+			float    loc_speed;
+			float    glob_speed;
+			uint32_t instance_count;
+		} ubo;
+		std::unique_ptr<vkb::core::Buffer> uniform_buffer;
+	} compute;
+
+	int                      update_mode          = STATIC_INSTANCES;
+	int                      instance_count_index = 0;                     // Stress mode scales the instance count through this list
+	uint32_t                 instance_count       = INSTANCE_COUNT;
+	std::vector<uint32_t>    instance_counts;
+	std::vector<std::string> instance_count_names;
+	bool                     rebuild_instances = false;        // Instance buffers and command buffers are recreated before the next frame
+
 	struct UBOVS
 	{
 		glm::mat4 projection;
@@ -79,6 +113,7 @@ class Instancing : public ApiVulkanSample
 	struct Pipelines
 	{
 		VkPipeline instanced_rocks;
+		VkPipeline instanced_rocks_animated;        // Draws instances pre-transformed by the compute update
 		VkPipeline planet;
 		VkPipeline starfield;
 	} pipelines;
@@ -100,8 +135,13 @@ class Instancing : public ApiVulkanSample
 	void         setup_descriptor_set();
 	void         prepare_pipelines();
 	void         prepare_instance_data();
+	void         prepare_compute();
+	void         update_compute_descriptor_sets();
 	void         prepare_uniform_buffers();
 	void         update_uniform_buffer(float delta_time);
+	void         build_command_buffer(uint32_t index);
+	void         rebuild_instance_resources();
+	void         read_timestamps();
 	void         draw();
 	bool         prepare(vkb::Platform &platform) override;
 	virtual void render(float delta_time) override;
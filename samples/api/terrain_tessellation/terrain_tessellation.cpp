@@ -23,6 +23,18 @@
 
 #include "heightmap.h"
 
+namespace
+{
+// Quads across and down the grid mesh every CDLOD node is drawn with
+constexpr uint32_t CDLOD_GRID_SIZE = 32;
+
+// Levels of detail of the CDLOD quadtree, the finest nodes being 1 / 2^(CDLOD_LOD_COUNT - 1) of the terrain
+constexpr uint32_t CDLOD_LOD_COUNT = 6;
+
+// Height map samples across the terrain for the height bounds of the CDLOD nodes
+constexpr uint32_t CDLOD_HEIGHTMAP_RESOLUTION = 256;
+}        // namespace
+
 TerrainTessellation::TerrainTessellation()
 {
 	title = "Dynamic terrain tessellation";
@@ -34,11 +46,19 @@ TerrainTessellation::~TerrainTessellation()
 	{
 		// Clean up used Vulkan resources
 		// Note : Inherited destructor cleans up resources stored in base class
-		vkDestroyPipeline(get_device().get_handle(), pipelines.terrain, nullptr);
+		if (pipelines.terrain != VK_NULL_HANDLE)
+		{
+			vkDestroyPipeline(get_device().get_handle(), pipelines.terrain, nullptr);
+		}
 		if (pipelines.wireframe != VK_NULL_HANDLE)
 		{
 			vkDestroyPipeline(get_device().get_handle(), pipelines.wireframe, nullptr);
 		}
+		vkDestroyPipeline(get_device().get_handle(), pipelines.cdlod, nullptr);
+		if (pipelines.cdlod_wireframe != VK_NULL_HANDLE)
+		{
+			vkDestroyPipeline(get_device().get_handle(), pipelines.cdlod_wireframe, nullptr);
+		}
 		vkDestroyPipeline(get_device().get_handle(), pipelines.skysphere, nullptr);
 
 		vkDestroyPipelineLayout(get_device().get_handle(), pipeline_layouts.skysphere, nullptr);
@@ -49,9 +69,9 @@ TerrainTessellation::~TerrainTessellation()
 
 		uniform_buffers.skysphere_vertex.reset();
 		uniform_buffers.terrain_tessellation.reset();
+		uniform_buffers.cdlod.reset();
 
-		textures.heightmap.image.reset();
-		vkDestroySampler(get_device().get_handle(), textures.heightmap.sampler, nullptr);
+		heightmap.reset();
 		textures.skysphere.image.reset();
 		vkDestroySampler(get_device().get_handle(), textures.skysphere.sampler, nullptr);
 		textures.terrain_array.image.reset();
@@ -70,15 +90,11 @@ void TerrainTessellation::request_gpu_features(vkb::PhysicalDevice &gpu)
 {
 	auto &requested_features = gpu.get_mutable_requested_features();
 
-	// Tessellation shader support is required for this example
+	// Without tessellation shaders the terrain is drawn in CDLOD mode only
 	if (gpu.get_features().tessellationShader)
 	{
 		requested_features.tessellationShader = VK_TRUE;
 	}
-	else
-	{
-		throw vkb::VulkanException(VK_ERROR_FEATURE_NOT_PRESENT, "Selected GPU does not support tessellation shaders!");
-	}
 
 	// Fill mode non solid is required for wireframe display
 	if (gpu.get_features().fillModeNonSolid)
@@ -92,6 +108,16 @@ void TerrainTessellation::request_gpu_features(vkb::PhysicalDevice &gpu)
 		requested_features.pipelineStatisticsQuery = VK_TRUE;
 	}
 
+	// Shaders flag the height map pages they need in a storage buffer
+	if (gpu.get_features().fragmentStoresAndAtomics)
+	{
+		requested_features.fragmentStoresAndAtomics = VK_TRUE;
+	}
+	else
+	{
+		throw vkb::VulkanException(VK_ERROR_FEATURE_NOT_PRESENT, "Selected GPU does not support stores from fragment shaders!");
+	}
+
 	// Enable anisotropic filtering if supported
 	if (gpu.get_features().samplerAnisotropy)
 	{
@@ -125,9 +151,11 @@ void TerrainTessellation::setup_query_result_buffer()
 		VkQueryPoolCreateInfo query_pool_info = {};
 		query_pool_info.sType                 = VK_STRUCTURE_TYPE_QUERY_POOL_CREATE_INFO;
 		query_pool_info.queryType             = VK_QUERY_TYPE_PIPELINE_STATISTICS;
-		query_pool_info.pipelineStatistics =
-		    VK_QUERY_PIPELINE_STATISTIC_VERTEX_SHADER_INVOCATIONS_BIT |
-		    VK_QUERY_PIPELINE_STATISTIC_TESSELLATION_EVALUATION_SHADER_INVOCATIONS_BIT;
+		query_pool_info.pipelineStatistics    = VK_QUERY_PIPELINE_STATISTIC_VERTEX_SHADER_INVOCATIONS_BIT;
+		if (get_device().get_gpu().get_features().tessellationShader)
+		{
+			query_pool_info.pipelineStatistics |= VK_QUERY_PIPELINE_STATISTIC_TESSELLATION_EVALUATION_SHADER_INVOCATIONS_BIT;
+		}
 		query_pool_info.queryCount = 2;
 		VK_CHECK(vkCreateQueryPool(get_device().get_handle(), &query_pool_info, NULL, &query_pool));
 	}
@@ -157,29 +185,25 @@ void TerrainTessellation::load_assets()
 	// Terrain textures are stored in a texture array with layers corresponding to terrain height
 	textures.terrain_array = load_texture_array("textures/terrain_texturearray_rgba.ktx");
 
-	// Height data is stored in a one-channel texture
-	textures.heightmap = load_texture("textures/terrain_heightmap_r16.ktx");
-
-	VkSamplerCreateInfo sampler_create_info = vkb::initializers::sampler_create_info();
+	// Height data is stored in a one-channel texture, split into the pages of a tile file the first time it is loaded
+	const std::string tile_file = "terrain_heightmap_r16.vtex";
+	try
+	{
+		heightmap = std::make_unique<vkb::VirtualTexture>(get_device(), vkb::fs::map_temp(tile_file));
+	}
+	catch (const std::runtime_error &)
+	{
+		auto image = vkb::sg::Image::load("terrain_heightmap_r16", "textures/terrain_heightmap_r16.ktx");
+		vkb::fs::write_temp(vkb::VirtualTexture::build_tiles(*image), tile_file);
+		image.reset();
 
-	// Setup a mirroring sampler for the height map
-	vkDestroySampler(get_device().get_handle(), textures.heightmap.sampler, nullptr);
-	sampler_create_info.magFilter    = VK_FILTER_LINEAR;
-	sampler_create_info.minFilter    = VK_FILTER_LINEAR;
-	sampler_create_info.mipmapMode   = VK_SAMPLER_MIPMAP_MODE_LINEAR;
-	sampler_create_info.addressModeU = VK_SAMPLER_ADDRESS_MODE_MIRRORED_REPEAT;
-	sampler_create_info.addressModeV = sampler_create_info.addressModeU;
-	sampler_create_info.addressModeW = sampler_create_info.addressModeU;
-	sampler_create_info.compareOp    = VK_COMPARE_OP_NEVER;
-	sampler_create_info.minLod       = 0.0f;
-	sampler_create_info.maxLod       = static_cast<float>(textures.heightmap.image->get_mipmaps().size());
-	sampler_create_info.borderColor  = VK_BORDER_COLOR_FLOAT_OPAQUE_WHITE;
-	VK_CHECK(vkCreateSampler(get_device().get_handle(), &sampler_create_info, nullptr, &textures.heightmap.sampler));
+		heightmap = std::make_unique<vkb::VirtualTexture>(get_device(), vkb::fs::map_temp(tile_file));
+	}
 
 	// Setup a repeating sampler for the terrain texture layers
 	VkSampler sampler;
 	vkDestroySampler(get_device().get_handle(), textures.terrain_array.sampler, nullptr);
-	sampler_create_info              = vkb::initializers::sampler_create_info();
+	VkSamplerCreateInfo sampler_create_info = vkb::initializers::sampler_create_info();
 	sampler_create_info.magFilter    = VK_FILTER_LINEAR;
 	sampler_create_info.minFilter    = VK_FILTER_LINEAR;
 	sampler_create_info.mipmapMode   = VK_SAMPLER_MIPMAP_MODE_LINEAR;
@@ -230,6 +254,8 @@ void TerrainTessellation::build_command_buffers()
 			vkCmdResetQueryPool(draw_cmd_buffers[i], query_pool, 0, 2);
 		}
 
+		heightmap->reset_feedback(draw_cmd_buffers[i]);
+
 		vkCmdBeginRenderPass(draw_cmd_buffers[i], &render_pass_begin_info, VK_SUBPASS_CONTENTS_INLINE);
 
 		VkViewport viewport = vkb::initializers::viewport((float) width, (float) height, 0.0f, 1.0f);
@@ -254,21 +280,34 @@ void TerrainTessellation::build_command_buffers()
 			vkCmdBeginQuery(draw_cmd_buffers[i], query_pool, 0, 0);
 		}
 		// Render
-		vkCmdBindPipeline(draw_cmd_buffers[i], VK_PIPELINE_BIND_POINT_GRAPHICS, wireframe ? pipelines.wireframe : pipelines.terrain);
-		vkCmdBindDescriptorSets(draw_cmd_buffers[i], VK_PIPELINE_BIND_POINT_GRAPHICS, pipeline_layouts.terrain, 0, 1, &descriptor_sets.terrain, 0, NULL);
-		vkCmdBindVertexBuffers(draw_cmd_buffers[i], 0, 1, terrain.vertices->get(), offsets);
-		vkCmdBindIndexBuffer(draw_cmd_buffers[i], terrain.indices->get_handle(), 0, VK_INDEX_TYPE_UINT32);
-		vkCmdDrawIndexed(draw_cmd_buffers[i], terrain.index_count, 1, 0, 0, 0);
+		if (cdlod)
+		{
+			// The instance count is written with the selected nodes, without recording the command buffers again
+			vkCmdBindPipeline(draw_cmd_buffers[i], VK_PIPELINE_BIND_POINT_GRAPHICS, wireframe ? pipelines.cdlod_wireframe : pipelines.cdlod);
+			vkCmdBindDescriptorSets(draw_cmd_buffers[i], VK_PIPELINE_BIND_POINT_GRAPHICS, pipeline_layouts.terrain, 0, 1, &descriptor_sets.terrain, 0, NULL);
+			vkCmdBindVertexBuffers(draw_cmd_buffers[i], 0, 1, cdlod_terrain.vertices->get(), offsets);
+			vkCmdBindVertexBuffers(draw_cmd_buffers[i], 1, 1, cdlod_terrain.instances->get(), offsets);
+			vkCmdBindIndexBuffer(draw_cmd_buffers[i], cdlod_terrain.indices->get_handle(), 0, VK_INDEX_TYPE_UINT32);
+			vkCmdDrawIndexedIndirect(draw_cmd_buffers[i], cdlod_terrain.indirect->get_handle(), 0, 1, sizeof(VkDrawIndexedIndirectCommand));
+		}
+		else
+		{
+			vkCmdBindPipeline(draw_cmd_buffers[i], VK_PIPELINE_BIND_POINT_GRAPHICS, wireframe ? pipelines.wireframe : pipelines.terrain);
+			vkCmdBindDescriptorSets(draw_cmd_buffers[i], VK_PIPELINE_BIND_POINT_GRAPHICS, pipeline_layouts.terrain, 0, 1, &descriptor_sets.terrain, 0, NULL);
+			vkCmdBindVertexBuffers(draw_cmd_buffers[i], 0, 1, terrain.vertices->get(), offsets);
+			vkCmdBindIndexBuffer(draw_cmd_buffers[i], terrain.indices->get_handle(), 0, VK_INDEX_TYPE_UINT32);
+			vkCmdDrawIndexed(draw_cmd_buffers[i], terrain.index_count, 1, 0, 0, 0);
+		}
 		if (get_device().get_gpu().get_features().pipelineStatisticsQuery)
 		{
 			// End pipeline statistics query
 			vkCmdEndQuery(draw_cmd_buffers[i], query_pool, 0);
 		}
 
-		draw_ui(draw_cmd_buffers[i]);
-
 		vkCmdEndRenderPass(draw_cmd_buffers[i]);
 
+		heightmap->flush_feedback(draw_cmd_buffers[i]);
+
 		VK_CHECK(vkEndCommandBuffer(draw_cmd_buffers[i]));
 	}
 }
@@ -411,12 +450,87 @@ void TerrainTessellation::generate_terrain()
 	delete[] indices;
 }
 
+// Generate the grid mesh drawn for every CDLOD node, and the quadtree selecting the nodes
+void TerrainTessellation::generate_cdlod_terrain()
+{
+	// Grid vertices hold their integer position on the grid, so that the shader can find the odd ones to morph
+	std::vector<glm::vec2> vertices;
+	for (uint32_t y = 0; y <= CDLOD_GRID_SIZE; y++)
+	{
+		for (uint32_t x = 0; x <= CDLOD_GRID_SIZE; x++)
+		{
+			vertices.emplace_back(static_cast<float>(x), static_cast<float>(y));
+		}
+	}
+
+	std::vector<uint32_t> indices;
+	for (uint32_t y = 0; y < CDLOD_GRID_SIZE; y++)
+	{
+		for (uint32_t x = 0; x < CDLOD_GRID_SIZE; x++)
+		{
+			uint32_t index = x + y * (CDLOD_GRID_SIZE + 1);
+			indices.insert(indices.end(), {index, index + CDLOD_GRID_SIZE + 1, index + 1,
+			                               index + 1, index + CDLOD_GRID_SIZE + 1, index + CDLOD_GRID_SIZE + 2});
+		}
+	}
+	cdlod_terrain.index_count = vkb::to_u32(indices.size());
+
+	// For the sake of simplicity we won't stage the grid to the gpu memory
+	cdlod_terrain.vertices = std::make_unique<vkb::core::Buffer>(get_device(),
+	                                                             vertices.size() * sizeof(glm::vec2),
+	                                                             VK_BUFFER_USAGE_VERTEX_BUFFER_BIT,
+	                                                             VMA_MEMORY_USAGE_CPU_TO_GPU);
+	cdlod_terrain.vertices->update(vertices.data(), vertices.size() * sizeof(glm::vec2));
+
+	cdlod_terrain.indices = std::make_unique<vkb::core::Buffer>(get_device(),
+	                                                            indices.size() * sizeof(uint32_t),
+	                                                            VK_BUFFER_USAGE_INDEX_BUFFER_BIT,
+	                                                            VMA_MEMORY_USAGE_CPU_TO_GPU);
+	cdlod_terrain.indices->update(indices.data(), indices.size() * sizeof(uint32_t));
+
+	// The terrain covers the same area as the tessellated patches
+	const float     terrain_size = 128.0f;
+	const glm::vec2 terrain_origin(-63.0f);
+
+	vkb::HeightMap heightmap("textures/terrain_heightmap_r16.ktx", CDLOD_HEIGHTMAP_RESOLUTION);
+	cdlod_terrain.quadtree = std::make_unique<vkb::TerrainQuadtree>(heightmap, CDLOD_HEIGHTMAP_RESOLUTION, terrain_origin, terrain_size,
+	                                                                ubo_tess.displacement_factor, CDLOD_LOD_COUNT);
+
+	// Sized for the largest selection, so that the vertex count is bounded whatever the view
+	cdlod_terrain.instances = std::make_unique<vkb::core::Buffer>(get_device(),
+	                                                              cdlod_terrain.quadtree->get_max_node_count() * sizeof(vkb::TerrainQuadtree::Node),
+	                                                              VK_BUFFER_USAGE_VERTEX_BUFFER_BIT,
+	                                                              VMA_MEMORY_USAGE_CPU_TO_GPU);
+
+	cdlod_terrain.indirect = std::make_unique<vkb::core::Buffer>(get_device(),
+	                                                             sizeof(VkDrawIndexedIndirectCommand),
+	                                                             VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT,
+	                                                             VMA_MEMORY_USAGE_CPU_TO_GPU);
+
+	ubo_cdlod.terrain   = glm::vec4(terrain_origin, terrain_size, 0.0f);
+	ubo_cdlod.grid_size = static_cast<float>(CDLOD_GRID_SIZE);
+}
+
+// Select the CDLOD nodes in view and write them to the instance and indirect draw buffers
+void TerrainTessellation::update_cdlod_nodes()
+{
+	cdlod_terrain.quadtree->select(glm::vec3(ubo_cdlod.camera_pos), frustum, cdlod_terrain.nodes);
+
+	cdlod_terrain.instances->update(cdlod_terrain.nodes.data(), cdlod_terrain.nodes.size() * sizeof(vkb::TerrainQuadtree::Node));
+
+	VkDrawIndexedIndirectCommand draw_command{};
+	draw_command.indexCount    = cdlod_terrain.index_count;
+	draw_command.instanceCount = vkb::to_u32(cdlod_terrain.nodes.size());
+	cdlod_terrain.indirect->update(&draw_command, sizeof(VkDrawIndexedIndirectCommand));
+}
+
 void TerrainTessellation::setup_descriptor_pool()
 {
 	std::vector<VkDescriptorPoolSize> pool_sizes =
 	    {
-	        vkb::initializers::descriptor_pool_size(VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, 3),
-	        vkb::initializers::descriptor_pool_size(VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, 3)};
+	        vkb::initializers::descriptor_pool_size(VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, 5),
+	        vkb::initializers::descriptor_pool_size(VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, 4),
+	        vkb::initializers::descriptor_pool_size(VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, 1)};
 
 	VkDescriptorPoolCreateInfo descriptor_pool_create_info =
 	    vkb::initializers::descriptor_pool_create_info(
@@ -433,24 +547,51 @@ void TerrainTessellation::setup_descriptor_set_layouts()
 	VkPipelineLayoutCreateInfo                pipeline_layout_create_info;
 	std::vector<VkDescriptorSetLayoutBinding> set_layout_bindings;
 
+	// Stages displacing the terrain, tessellation stages are only valid when the feature is enabled
+	VkShaderStageFlags terrain_stages = VK_SHADER_STAGE_VERTEX_BIT;
+	if (get_device().get_gpu().get_features().tessellationShader)
+	{
+		terrain_stages |= VK_SHADER_STAGE_TESSELLATION_CONTROL_BIT | VK_SHADER_STAGE_TESSELLATION_EVALUATION_BIT;
+	}
+
 	// Terrain
 	set_layout_bindings =
 	    {
-	        // Binding 0 : Shared Tessellation shader ubo
+	        // Binding 0 : Shared Tessellation shader ubo, also read by the CDLOD vertex shader
 	        vkb::initializers::descriptor_set_layout_binding(
 	            VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER,
-	            VK_SHADER_STAGE_TESSELLATION_CONTROL_BIT | VK_SHADER_STAGE_TESSELLATION_EVALUATION_BIT,
+	            terrain_stages,
 	            0),
-	        // Binding 1 : Height map
+	        // Binding 1 : Height map page cache
 	        vkb::initializers::descriptor_set_layout_binding(
 	            VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER,
-	            VK_SHADER_STAGE_TESSELLATION_CONTROL_BIT | VK_SHADER_STAGE_TESSELLATION_EVALUATION_BIT | VK_SHADER_STAGE_FRAGMENT_BIT,
+	            terrain_stages | VK_SHADER_STAGE_FRAGMENT_BIT,
 	            1),
-	        // Binding 3 : Terrain texture array layers
+	        // Binding 2 : Terrain texture array layers
 	        vkb::initializers::descriptor_set_layout_binding(
 	            VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER,
 	            VK_SHADER_STAGE_FRAGMENT_BIT,
 	            2),
+	        // Binding 3 : Height map page table
+	        vkb::initializers::descriptor_set_layout_binding(
+	            VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER,
+	            terrain_stages | VK_SHADER_STAGE_FRAGMENT_BIT,
+	            3),
+	        // Binding 4 : Height map virtual texture parameters
+	        vkb::initializers::descriptor_set_layout_binding(
+	            VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER,
+	            terrain_stages | VK_SHADER_STAGE_FRAGMENT_BIT,
+	            4),
+	        // Binding 5 : Height map page feedback
+	        vkb::initializers::descriptor_set_layout_binding(
+	            VK_DESCRIPTOR_TYPE_STORAGE_BUFFER,
+	            VK_SHADER_STAGE_FRAGMENT_BIT,
+	            5),
+	        // Binding 6 : CDLOD vertex shader ubo
+	        vkb::initializers::descriptor_set_layout_binding(
+	            VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER,
+	            VK_SHADER_STAGE_VERTEX_BIT,
+	            6),
 	    };
 
 	descriptor_layout = vkb::initializers::descriptor_set_layout_create_info(set_layout_bindings.data(), static_cast<uint32_t>(set_layout_bindings.size()));
@@ -489,8 +630,12 @@ void TerrainTessellation::setup_descriptor_sets()
 	VK_CHECK(vkAllocateDescriptorSets(get_device().get_handle(), &alloc_info, &descriptor_sets.terrain));
 
 	VkDescriptorBufferInfo terrain_buffer_descriptor   = create_descriptor(*uniform_buffers.terrain_tessellation);
-	VkDescriptorImageInfo  heightmap_image_descriptor  = create_descriptor(textures.heightmap);
+	VkDescriptorImageInfo  heightmap_image_descriptor  = heightmap->get_cache_descriptor();
 	VkDescriptorImageInfo  terrainmap_image_descriptor = create_descriptor(textures.terrain_array);
+	VkDescriptorImageInfo  page_table_descriptor       = heightmap->get_page_table_descriptor();
+	VkDescriptorBufferInfo virtual_texture_descriptor  = heightmap->get_uniform_descriptor();
+	VkDescriptorBufferInfo feedback_descriptor         = heightmap->get_feedback_descriptor();
+	VkDescriptorBufferInfo cdlod_buffer_descriptor     = create_descriptor(*uniform_buffers.cdlod);
 	write_descriptor_sets =
 	    {
 	        // Binding 0 : Shared tessellation shader ubo
@@ -499,7 +644,7 @@ void TerrainTessellation::setup_descriptor_sets()
 	            VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER,
 	            0,
 	            &terrain_buffer_descriptor),
-	        // Binding 1 : Displacement map
+	        // Binding 1 : Displacement map page cache
 	        vkb::initializers::write_descriptor_set(
 	            descriptor_sets.terrain,
 	            VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER,
@@ -511,6 +656,30 @@ void TerrainTessellation::setup_descriptor_sets()
 	            VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER,
 	            2,
 	            &terrainmap_image_descriptor),
+	        // Binding 3 : Displacement map page table
+	        vkb::initializers::write_descriptor_set(
+	            descriptor_sets.terrain,
+	            VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER,
+	            3,
+	            &page_table_descriptor),
+	        // Binding 4 : Displacement map virtual texture parameters
+	        vkb::initializers::write_descriptor_set(
+	            descriptor_sets.terrain,
+	            VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER,
+	            4,
+	            &virtual_texture_descriptor),
+	        // Binding 5 : Displacement map page feedback
+	        vkb::initializers::write_descriptor_set(
+	            descriptor_sets.terrain,
+	            VK_DESCRIPTOR_TYPE_STORAGE_BUFFER,
+	            5,
+	            &feedback_descriptor),
+	        // Binding 6 : CDLOD vertex shader ubo
+	        vkb::initializers::write_descriptor_set(
+	            descriptor_sets.terrain,
+	            VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER,
+	            6,
+	            &cdlod_buffer_descriptor),
 	    };
 	vkUpdateDescriptorSets(get_device().get_handle(), static_cast<uint32_t>(write_descriptor_sets.size()), write_descriptor_sets.data(), 0, NULL);
 
@@ -614,12 +783,6 @@ void TerrainTessellation::prepare_pipelines()
 
 	std::array<VkPipelineShaderStageCreateInfo, 4> shader_stages;
 
-	// Terrain tessellation pipeline
-	shader_stages[0] = load_shader("terrain_tessellation/terrain.vert", VK_SHADER_STAGE_VERTEX_BIT);
-	shader_stages[1] = load_shader("terrain_tessellation/terrain.frag", VK_SHADER_STAGE_FRAGMENT_BIT);
-	shader_stages[2] = load_shader("terrain_tessellation/terrain.tesc", VK_SHADER_STAGE_TESSELLATION_CONTROL_BIT);
-	shader_stages[3] = load_shader("terrain_tessellation/terrain.tese", VK_SHADER_STAGE_TESSELLATION_EVALUATION_BIT);
-
 	VkGraphicsPipelineCreateInfo pipeline_create_info =
 	    vkb::initializers::pipeline_create_info(pipeline_layouts.terrain, render_pass, 0);
 
@@ -636,14 +799,58 @@ void TerrainTessellation::prepare_pipelines()
 	pipeline_create_info.pStages             = shader_stages.data();
 	pipeline_create_info.renderPass          = render_pass;
 
-	VK_CHECK(vkCreateGraphicsPipelines(get_device().get_handle(), pipeline_cache, 1, &pipeline_create_info, nullptr, &pipelines.terrain));
+	// Terrain tessellation pipeline
+	if (get_device().get_gpu().get_features().tessellationShader)
+	{
+		shader_stages[0] = load_shader("terrain_tessellation/terrain.vert", VK_SHADER_STAGE_VERTEX_BIT);
+		shader_stages[1] = load_shader("terrain_tessellation/terrain.frag", VK_SHADER_STAGE_FRAGMENT_BIT);
+		shader_stages[2] = load_shader("terrain_tessellation/terrain.tesc", VK_SHADER_STAGE_TESSELLATION_CONTROL_BIT);
+		shader_stages[3] = load_shader("terrain_tessellation/terrain.tese", VK_SHADER_STAGE_TESSELLATION_EVALUATION_BIT);
+
+		VK_CHECK(vkCreateGraphicsPipelines(get_device().get_handle(), pipeline_cache, 1, &pipeline_create_info, nullptr, &pipelines.terrain));
 
-	// Terrain wireframe pipeline
+		// Terrain wireframe pipeline
+		if (get_device().get_gpu().get_features().fillModeNonSolid)
+		{
+			rasterization_state.polygonMode = VK_POLYGON_MODE_LINE;
+			VK_CHECK(vkCreateGraphicsPipelines(get_device().get_handle(), pipeline_cache, 1, &pipeline_create_info, nullptr, &pipelines.wireframe));
+		}
+	}
+
+	// CDLOD terrain pipeline, drawing an instance of the grid for each node
+	std::vector<VkVertexInputBindingDescription> cdlod_vertex_input_bindings = {
+	    vkb::initializers::vertex_input_binding_description(0, sizeof(glm::vec2), VK_VERTEX_INPUT_RATE_VERTEX),
+	    vkb::initializers::vertex_input_binding_description(1, sizeof(vkb::TerrainQuadtree::Node), VK_VERTEX_INPUT_RATE_INSTANCE),
+	};
+
+	std::vector<VkVertexInputAttributeDescription> cdlod_vertex_input_attributes = {
+	    vkb::initializers::vertex_input_attribute_description(0, 0, VK_FORMAT_R32G32_SFLOAT, 0),                   // Grid position
+	    vkb::initializers::vertex_input_attribute_description(1, 1, VK_FORMAT_R32G32B32A32_SFLOAT, 0),             // Node
+	};
+
+	VkPipelineVertexInputStateCreateInfo cdlod_vertex_input_state = vkb::initializers::pipeline_vertex_input_state_create_info();
+	cdlod_vertex_input_state.vertexBindingDescriptionCount        = static_cast<uint32_t>(cdlod_vertex_input_bindings.size());
+	cdlod_vertex_input_state.pVertexBindingDescriptions           = cdlod_vertex_input_bindings.data();
+	cdlod_vertex_input_state.vertexAttributeDescriptionCount      = static_cast<uint32_t>(cdlod_vertex_input_attributes.size());
+	cdlod_vertex_input_state.pVertexAttributeDescriptions         = cdlod_vertex_input_attributes.data();
+
+	// Both sides are drawn, as the grid is not closed
+	rasterization_state.polygonMode           = VK_POLYGON_MODE_FILL;
+	rasterization_state.cullMode              = VK_CULL_MODE_NONE;
+	input_assembly_state_create_info.topology = VK_PRIMITIVE_TOPOLOGY_TRIANGLE_LIST;
+	pipeline_create_info.pVertexInputState    = &cdlod_vertex_input_state;
+	pipeline_create_info.pTessellationState   = nullptr;
+	pipeline_create_info.stageCount           = 2;
+	shader_stages[0]                          = load_shader("terrain_tessellation/cdlod.vert", VK_SHADER_STAGE_VERTEX_BIT);
+	shader_stages[1]                          = load_shader("terrain_tessellation/terrain.frag", VK_SHADER_STAGE_FRAGMENT_BIT);
+	VK_CHECK(vkCreateGraphicsPipelines(get_device().get_handle(), pipeline_cache, 1, &pipeline_create_info, nullptr, &pipelines.cdlod));
+
+	// CDLOD terrain wireframe pipeline
 	if (get_device().get_gpu().get_features().fillModeNonSolid)
 	{
 		rasterization_state.polygonMode = VK_POLYGON_MODE_LINE;
-		VK_CHECK(vkCreateGraphicsPipelines(get_device().get_handle(), pipeline_cache, 1, &pipeline_create_info, nullptr, &pipelines.wireframe));
-	};
+		VK_CHECK(vkCreateGraphicsPipelines(get_device().get_handle(), pipeline_cache, 1, &pipeline_create_info, nullptr, &pipelines.cdlod_wireframe));
+	}
 
 	// Skysphere pipeline
 
@@ -651,10 +858,12 @@ void TerrainTessellation::prepare_pipelines()
 	vertex_input_bindings[0].stride = sizeof(::Vertex);
 
 	rasterization_state.polygonMode = VK_POLYGON_MODE_FILL;
+	rasterization_state.cullMode    = VK_CULL_MODE_BACK_BIT;
 	// Revert to triangle list topology
 	input_assembly_state_create_info.topology = VK_PRIMITIVE_TOPOLOGY_TRIANGLE_LIST;
 	// Reset tessellation state
 	pipeline_create_info.pTessellationState = nullptr;
+	pipeline_create_info.pVertexInputState  = &vertex_input_state;
 	// Don't write to depth buffer
 	depth_stencil_state.depthWriteEnable = VK_FALSE;
 	pipeline_create_info.stageCount      = 2;
@@ -679,6 +888,12 @@ void TerrainTessellation::prepare_uniform_buffers()
 	                                                                       VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT,
 	                                                                       VMA_MEMORY_USAGE_CPU_TO_GPU);
 
+	// CDLOD terrain vertex shader uniform buffer
+	uniform_buffers.cdlod = std::make_unique<vkb::core::Buffer>(get_device(),
+	                                                            sizeof(ubo_cdlod),
+	                                                            VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT,
+	                                                            VMA_MEMORY_USAGE_CPU_TO_GPU);
+
 	update_uniform_buffers();
 }
 
@@ -711,6 +926,11 @@ void TerrainTessellation::update_uniform_buffers()
 	// Skysphere vertex shader
 	ubo_vs.mvp = camera.matrices.perspective * glm::mat4(glm::mat3(camera.matrices.view));
 	uniform_buffers.skysphere_vertex->convert_and_update(ubo_vs.mvp);
+
+	// CDLOD terrain vertex shader, the nodes are selected for the new view
+	ubo_cdlod.camera_pos = glm::inverse(ubo_tess.modelview)[3];
+	uniform_buffers.cdlod->convert_and_update(ubo_cdlod);
+	update_cdlod_nodes();
 }
 
 void TerrainTessellation::draw()
@@ -731,6 +951,9 @@ void TerrainTessellation::draw()
 	}
 
 	ApiVulkanSample::submit_frame();
+
+	// The frame is complete, stream in the height map pages it requested
+	heightmap->update();
 }
 
 bool TerrainTessellation::prepare(vkb::Platform &platform)
@@ -747,8 +970,12 @@ bool TerrainTessellation::prepare(vkb::Platform &platform)
 	camera.set_translation(glm::vec3(18.0f, 22.5f, 57.5f));
 	camera.translation_speed = 7.5f;
 
+	// Without tessellation shaders the terrain can only be drawn in CDLOD mode
+	cdlod = !get_device().get_gpu().get_features().tessellationShader;
+
 	load_assets();
 	generate_terrain();
+	generate_cdlod_terrain();
 	if (get_device().get_gpu().get_features().pipelineStatisticsQuery)
 	{
 		setup_query_result_buffer();
@@ -779,13 +1006,33 @@ void TerrainTessellation::on_update_ui_overlay(vkb::Drawer &drawer)
 {
 	if (drawer.header("Settings"))
 	{
-		if (drawer.checkbox("Tessellation", &tessellation))
+		if (get_device().get_gpu().get_features().tessellationShader)
 		{
-			update_uniform_buffers();
+			if (drawer.checkbox("CDLOD", &cdlod))
+			{
+				build_command_buffers();
+			}
 		}
-		if (drawer.input_float("Factor", &ubo_tess.tessellation_factor, 0.05f, 2))
+		if (cdlod)
 		{
-			update_uniform_buffers();
+			float lod_range = cdlod_terrain.quadtree->get_lod_range();
+			if (drawer.input_float("LOD range", &lod_range, 0.5f, 1))
+			{
+				cdlod_terrain.quadtree->set_lod_range(std::max(lod_range, 1.0f));
+				update_uniform_buffers();
+			}
+			drawer.text("Nodes: %d", vkb::to_u32(cdlod_terrain.nodes.size()));
+		}
+		else
+		{
+			if (drawer.checkbox("Tessellation", &tessellation))
+			{
+				update_uniform_buffers();
+			}
+			if (drawer.input_float("Factor", &ubo_tess.tessellation_factor, 0.05f, 2))
+			{
+				update_uniform_buffers();
+			}
 		}
 		if (get_device().get_gpu().get_features().fillModeNonSolid)
 		{
@@ -795,12 +1042,20 @@ void TerrainTessellation::on_update_ui_overlay(vkb::Drawer &drawer)
 			}
 		}
 	}
+	if (drawer.header("Height map pages"))
+	{
+		drawer.text("Resident: %d", heightmap->get_resident_page_count());
+		drawer.text("Pending: %d", heightmap->get_pending_page_count());
+	}
 	if (get_device().get_gpu().get_features().pipelineStatisticsQuery)
 	{
 		if (drawer.header("Pipeline statistics"))
 		{
 			drawer.text("VS invocations: %d", pipeline_stats[0]);
-			drawer.text("TE invocations: %d", pipeline_stats[1]);
+			if (get_device().get_gpu().get_features().tessellationShader)
+			{
+				drawer.text("TE invocations: %d", pipeline_stats[1]);
+			}
 		}
 	}
 }
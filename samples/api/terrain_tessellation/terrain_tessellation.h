@@ -24,20 +24,26 @@
 #include "api_vulkan_sample.h"
 #include "core/buffer.h"
 #include "geometry/frustum.h"
+#include "rendering/virtual_texture.h"
+#include "terrain_quadtree.h"
 
 class TerrainTessellation : public ApiVulkanSample
 {
   public:
 	bool wireframe    = false;
 	bool tessellation = true;
+	// Draws the terrain with instanced grids selected from a quadtree, rather than with tessellation shaders
+	bool cdlod = false;
 
 	struct
 	{
-		Texture heightmap;
 		Texture skysphere;
 		Texture terrain_array;
 	} textures;
 
+	// Height data is streamed into a page cache, so that only the pages in view use memory
+	std::unique_ptr<vkb::VirtualTexture> heightmap;
+
 	std::unique_ptr<vkb::sg::SubMesh> skysphere;
 
 	struct Vertex
@@ -54,10 +60,23 @@ class TerrainTessellation : public ApiVulkanSample
 		uint32_t                           index_count;
 	} terrain;
 
+	// Continuous distance-dependent level of detail terrain
+	struct
+	{
+		std::unique_ptr<vkb::TerrainQuadtree>   quadtree;
+		std::vector<vkb::TerrainQuadtree::Node> nodes;
+		std::unique_ptr<vkb::core::Buffer>      vertices;
+		std::unique_ptr<vkb::core::Buffer>      indices;
+		std::unique_ptr<vkb::core::Buffer>      instances;
+		std::unique_ptr<vkb::core::Buffer>      indirect;
+		uint32_t                                index_count;
+	} cdlod_terrain;
+
 	struct
 	{
 		std::unique_ptr<vkb::core::Buffer> terrain_tessellation;
 		std::unique_ptr<vkb::core::Buffer> skysphere_vertex;
+		std::unique_ptr<vkb::core::Buffer> cdlod;
 	} uniform_buffers;
 
 	// Shared values for tessellation control and evaluation stages
@@ -80,10 +99,23 @@ class TerrainTessellation : public ApiVulkanSample
 		glm::mat4 mvp;
 	} ubo_vs;
 
+	// CDLOD terrain vertex shader stage
+	struct
+	{
+		glm::vec4 camera_pos;
+		// Corner of the terrain in xy, its size in z
+		glm::vec4 terrain;
+		float     grid_size;
+		// Fraction of a node range after which its vertices start morphing into the parent level
+		float     morph_start_ratio = 0.7f;
+	} ubo_cdlod;
+
 	struct Pipelines
 	{
-		VkPipeline terrain;
-		VkPipeline wireframe = VK_NULL_HANDLE;
+		VkPipeline terrain         = VK_NULL_HANDLE;
+		VkPipeline wireframe       = VK_NULL_HANDLE;
+		VkPipeline cdlod;
+		VkPipeline cdlod_wireframe = VK_NULL_HANDLE;
 		VkPipeline skysphere;
 	} pipelines;
 
@@ -125,6 +157,8 @@ class TerrainTessellation : public ApiVulkanSample
 	void         load_assets();
 	void         build_command_buffers() override;
 	void         generate_terrain();
+	void         generate_cdlod_terrain();
+	void         update_cdlod_nodes();
 	void         setup_descriptor_pool();
 	void         setup_descriptor_set_layouts();
 	void         setup_descriptor_sets();
@@ -26,6 +26,9 @@ TextureLoading::TextureLoading()
 	zoom     = -2.5f;
 	rotation = {0.0f, 15.0f, 0.0f};
 	title    = "Texture loading";
+
+	// The uniform buffer is ring-buffered per swap chain image, so the CPU may record ahead of the GPU
+	frames_in_flight = 2;
 }
 
 TextureLoading::~TextureLoading()
@@ -39,6 +42,10 @@ TextureLoading::~TextureLoading()
 
 		vkDestroyPipelineLayout(get_device().get_handle(), pipeline_layout, nullptr);
 		vkDestroyDescriptorSetLayout(get_device().get_handle(), descriptor_set_layout, nullptr);
+
+		// Levels still being streamed must land before the image is destroyed
+		get_device().get_staging_manager().wait_idle();
+		streaming.image.reset();
 	}
 
 	destroy_texture(texture);
@@ -82,22 +89,49 @@ void TextureLoading::load_texture()
 	// Texture data contains 4 channels (RGBA) with unnormalized 8-bit values, this is the most commonly supported format
 	VkFormat format = VK_FORMAT_R8G8B8A8_UNORM;
 
-	ktxTexture *   ktx_texture;
-	KTX_error_code result;
+	// The file is mapped rather than read, only its header is parsed up front and the mip levels are staged straight from the mapping
+	streaming.file = std::make_unique<vkb::fs::MappedFile>(filename);
 
-	result = ktxTexture_CreateFromNamedFile(filename.c_str(), KTX_TEXTURE_CREATE_LOAD_IMAGE_DATA_BIT, &ktx_texture);
-
-	if (ktx_texture == nullptr)
+	ktxTexture *ktx_texture = nullptr;
+	if (ktxTexture_CreateFromMemory(streaming.file->data(), streaming.file->size(), KTX_TEXTURE_CREATE_NO_FLAGS, &ktx_texture) != KTX_SUCCESS)
 	{
 		throw std::runtime_error("Couldn't load texture");
 	}
 
-	//assert(!tex2D.empty());
+	if (ktx_texture->classId != ktxTexture1_c)
+	{
+		ktxTexture_Destroy(ktx_texture);
+		throw std::runtime_error("Texture streaming expects a KTX 1 file");
+	}
 
 	texture.width      = ktx_texture->baseWidth;
 	texture.height     = ktx_texture->baseHeight;
 	texture.mip_levels = ktx_texture->numLevels;
 
+	// KTX 1 stores the levels after the 64 byte header and the key/value data, each one preceded by its size and padded to 4 bytes
+	VkDeviceSize offset = 64 + ktx_texture->kvDataLen;
+	for (uint32_t i = 0; i < texture.mip_levels; i++)
+	{
+		uint32_t image_size = 0;
+		if (offset + sizeof(image_size) <= streaming.file->size())
+		{
+			memcpy(&image_size, streaming.file->data() + offset, sizeof(image_size));
+		}
+		offset += sizeof(image_size);
+
+		if (image_size != ktxTexture_GetImageSize(ktx_texture, i) || offset + image_size > streaming.file->size())
+		{
+			ktxTexture_Destroy(ktx_texture);
+			throw std::runtime_error("Truncated or swapped KTX texture levels");
+		}
+
+		streaming.level_offsets.push_back(offset);
+		streaming.level_sizes.push_back(image_size);
+		offset += (image_size + 3) & ~3u;
+	}
+
+	ktxTexture_Destroy(ktx_texture);
+
 	// We prefer using staging to copy the texture data to a device local optimal image
 	VkBool32 use_staging = true;
 
@@ -115,58 +149,11 @@ void TextureLoading::load_texture()
 	VkMemoryAllocateInfo memory_allocate_info = vkb::initializers::memory_allocate_info();
 	VkMemoryRequirements memory_requirements  = {};
 
-	ktx_uint8_t *ktx_image_data   = ktxTexture_GetData(ktx_texture);
-	ktx_size_t   ktx_texture_size = ktxTexture_GetSize(ktx_texture);
-
 	if (use_staging)
 	{
 		// Copy data to an optimal tiled image
-		// This loads the texture data into a host local buffer that is copied to the optimal tiled image on the device
-
-		// Create a host-visible staging buffer that contains the raw image data
-		// This buffer will be the data source for copying texture data to the optimal tiled image on the device
-		VkBuffer       staging_buffer;
-		VkDeviceMemory staging_memory;
-
-		VkBufferCreateInfo buffer_create_info = vkb::initializers::buffer_create_info();
-		buffer_create_info.size               = ktx_texture_size;
-		// This buffer is used as a transfer source for the buffer copy
-		buffer_create_info.usage       = VK_BUFFER_USAGE_TRANSFER_SRC_BIT;
-		buffer_create_info.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
-		VK_CHECK(vkCreateBuffer(get_device().get_handle(), &buffer_create_info, nullptr, &staging_buffer));
-
-		// Get memory requirements for the staging buffer (alignment, memory type bits)
-		vkGetBufferMemoryRequirements(get_device().get_handle(), staging_buffer, &memory_requirements);
-		memory_allocate_info.allocationSize = memory_requirements.size;
-		// Get memory type index for a host visible buffer
-		memory_allocate_info.memoryTypeIndex = get_device().get_memory_type(memory_requirements.memoryTypeBits, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
-		VK_CHECK(vkAllocateMemory(get_device().get_handle(), &memory_allocate_info, nullptr, &staging_memory));
-		VK_CHECK(vkBindBufferMemory(get_device().get_handle(), staging_buffer, staging_memory, 0));
-
-		// Copy texture data into host local staging buffer
-
-		uint8_t *data;
-		VK_CHECK(vkMapMemory(get_device().get_handle(), staging_memory, 0, memory_requirements.size, 0, (void **) &data));
-		memcpy(data, ktx_image_data, ktx_texture_size);
-		vkUnmapMemory(get_device().get_handle(), staging_memory);
-
-		// Setup buffer copy regions for each mip level
-		std::vector<VkBufferImageCopy> buffer_copy_regions;
-		for (uint32_t i = 0; i < texture.mip_levels; i++)
-		{
-			ktx_size_t        offset;
-			KTX_error_code    result                           = ktxTexture_GetImageOffset(ktx_texture, i, 0, 0, &offset);
-			VkBufferImageCopy buffer_copy_region               = {};
-			buffer_copy_region.imageSubresource.aspectMask     = VK_IMAGE_ASPECT_COLOR_BIT;
-			buffer_copy_region.imageSubresource.mipLevel       = i;
-			buffer_copy_region.imageSubresource.baseArrayLayer = 0;
-			buffer_copy_region.imageSubresource.layerCount     = 1;
-			buffer_copy_region.imageExtent.width               = ktx_texture->baseWidth >> i;
-			buffer_copy_region.imageExtent.height              = ktx_texture->baseHeight >> i;
-			buffer_copy_region.imageExtent.depth               = 1;
-			buffer_copy_region.bufferOffset                    = offset;
-			buffer_copy_regions.push_back(buffer_copy_region);
-		}
+		// The mip levels are copied one at a time through the staging ring of the device, starting with the smallest one,
+		// so the texture can be displayed at a reduced quality while the larger levels are still on their way
 
 		// Create optimal tiled target image on the device
 		VkImageCreateInfo image_create_info = vkb::initializers::image_create_info();
@@ -189,11 +176,9 @@ void TextureLoading::load_texture()
 		VK_CHECK(vkAllocateMemory(get_device().get_handle(), &memory_allocate_info, nullptr, &texture.device_memory));
 		VK_CHECK(vkBindImageMemory(get_device().get_handle(), texture.image, texture.device_memory, 0));
 
-		VkCommandBuffer copy_command = device->create_command_buffer(VK_COMMAND_BUFFER_LEVEL_PRIMARY, true);
-
-		// Image memory barriers for the texture image
+		VkCommandBuffer layout_command = device->create_command_buffer(VK_COMMAND_BUFFER_LEVEL_PRIMARY, true);
 
-		// The sub resource range describes the regions of the image that will be transitioned using the memory barriers below
+		// The sub resource range describes the regions of the image that will be transitioned using the memory barrier below
 		VkImageSubresourceRange subresource_range = {};
 		// Image only contains color data
 		subresource_range.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
@@ -204,63 +189,38 @@ void TextureLoading::load_texture()
 		// The 2D texture only has one layer
 		subresource_range.layerCount = 1;
 
-		// Transition the texture image layout to transfer target, so we can safely copy our buffer data to it.
+		// The view covers all the levels, so the ones that are not resident yet must already be in the shader read layout
+		// They are never sampled though, the shader clamps the level of detail to the resident levels
 		VkImageMemoryBarrier image_memory_barrier = vkb::initializers::image_memory_barrier();
 
 		image_memory_barrier.image            = texture.image;
 		image_memory_barrier.subresourceRange = subresource_range;
 		image_memory_barrier.srcAccessMask    = 0;
-		image_memory_barrier.dstAccessMask    = VK_ACCESS_TRANSFER_WRITE_BIT;
+		image_memory_barrier.dstAccessMask    = VK_ACCESS_SHADER_READ_BIT;
 		image_memory_barrier.oldLayout        = VK_IMAGE_LAYOUT_UNDEFINED;
-		image_memory_barrier.newLayout        = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
-
-		// Insert a memory dependency at the proper pipeline stages that will execute the image layout transition
-		// Source pipeline stage is host write/read exection (VK_PIPELINE_STAGE_HOST_BIT)
-		// Destination pipeline stage is copy command exection (VK_PIPELINE_STAGE_TRANSFER_BIT)
-		vkCmdPipelineBarrier(
-		    copy_command,
-		    VK_PIPELINE_STAGE_HOST_BIT,
-		    VK_PIPELINE_STAGE_TRANSFER_BIT,
-		    0,
-		    0, nullptr,
-		    0, nullptr,
-		    1, &image_memory_barrier);
-
-		// Copy mip levels from staging buffer
-		vkCmdCopyBufferToImage(
-		    copy_command,
-		    staging_buffer,
-		    texture.image,
-		    VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
-		    static_cast<uint32_t>(buffer_copy_regions.size()),
-		    buffer_copy_regions.data());
-
-		// Once the data has been uploaded we transfer to the texture image to the shader read layout, so it can be sampled from
-		image_memory_barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
-		image_memory_barrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
-		image_memory_barrier.oldLayout     = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
-		image_memory_barrier.newLayout     = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+		image_memory_barrier.newLayout        = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
 
-		// Insert a memory dependency at the proper pipeline stages that will execute the image layout transition
-		// Source pipeline stage stage is copy command exection (VK_PIPELINE_STAGE_TRANSFER_BIT)
-		// Destination pipeline stage fragment shader access (VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT)
 		vkCmdPipelineBarrier(
-		    copy_command,
-		    VK_PIPELINE_STAGE_TRANSFER_BIT,
+		    layout_command,
+		    VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT,
 		    VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT,
 		    0,
 		    0, nullptr,
 		    0, nullptr,
 		    1, &image_memory_barrier);
 
+		device->flush_command_buffer(layout_command, queue, true);
+
 		// Store current layout for later reuse
 		texture.image_layout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
 
-		device->flush_command_buffer(copy_command, queue, true);
+		// Each level goes through the staging manager, which takes a framework image
+		streaming.image          = std::make_unique<vkb::core::Image>(get_device(), texture.image, VkExtent3D{texture.width, texture.height, 1}, format, image_create_info.usage);
+		streaming.next_level     = texture.mip_levels;
+		streaming.resident_level = texture.mip_levels - 1;
 
-		// Clean up staging resources
-		vkFreeMemory(get_device().get_handle(), staging_memory, nullptr);
-		vkDestroyBuffer(get_device().get_handle(), staging_buffer, nullptr);
+		// Only the smallest level is waited for, so the first frame has something to sample, the others are streamed in draw()
+		get_device().get_staging_manager().wait(stream_next_mip_level());
 	}
 	else
 	{
@@ -293,12 +253,12 @@ void TextureLoading::load_texture()
 		VK_CHECK(vkBindImageMemory(get_device().get_handle(), mappable_image, mappable_memory, 0));
 
 		// Map image memory
-		void *     data;
-		ktx_size_t ktx_image_size = ktxTexture_GetImageSize(ktx_texture, 0);
+		void *data;
 		VK_CHECK(vkMapMemory(get_device().get_handle(), mappable_memory, 0, memory_requirements.size, 0, &data));
 		// Copy image data of the first mip level into memory
-		memcpy(data, ktx_image_data, ktx_image_size);
+		memcpy(data, streaming.file->data() + streaming.level_offsets[0], streaming.level_sizes[0]);
 		vkUnmapMemory(get_device().get_handle(), mappable_memory);
+		streaming.file.reset();
 
 		// Linear tiled images don't need to be staged and can be directly used as textures
 		texture.image         = mappable_image;
@@ -395,6 +355,40 @@ void TextureLoading::load_texture()
 	VK_CHECK(vkCreateImageView(get_device().get_handle(), &view, nullptr, &texture.view));
 }
 
+// Stage the next finer mip level of the texture, the shader starts sampling it once its copy completed
+uint64_t TextureLoading::stream_next_mip_level()
+{
+	uint32_t level = --streaming.next_level;
+
+	VkBufferImageCopy buffer_copy_region               = {};
+	buffer_copy_region.imageSubresource.aspectMask     = VK_IMAGE_ASPECT_COLOR_BIT;
+	buffer_copy_region.imageSubresource.mipLevel       = level;
+	buffer_copy_region.imageSubresource.baseArrayLayer = 0;
+	buffer_copy_region.imageSubresource.layerCount     = 1;
+	buffer_copy_region.imageExtent.width               = std::max(texture.width >> level, 1u);
+	buffer_copy_region.imageExtent.height              = std::max(texture.height >> level, 1u);
+	buffer_copy_region.imageExtent.depth               = 1;
+	buffer_copy_region.bufferOffset                    = 0;
+
+	VkImageSubresourceRange subresource_range = {};
+	subresource_range.aspectMask              = VK_IMAGE_ASPECT_COLOR_BIT;
+	subresource_range.baseMipLevel            = level;
+	subresource_range.levelCount              = 1;
+	subresource_range.layerCount              = 1;
+
+	auto &staging = get_device().get_staging_manager();
+	staging.copy_to_image(streaming.file->data() + streaming.level_offsets[level], streaming.level_sizes[level], *streaming.image, {buffer_copy_region}, subresource_range);
+
+	// The data is in the staging ring now, the file is no longer needed after the last level
+	if (level == 0)
+	{
+		streaming.file.reset();
+	}
+
+	// Frames submitted before the copy completes keep sampling the coarser levels, so they never wait for it
+	return staging.flush([this, level]() { streaming.resident_level = level; });
+}
+
 // Free all Vulkan resources used by a texture object
 void TextureLoading::destroy_texture(Texture texture)
 {
@@ -436,7 +430,9 @@ void TextureLoading::build_command_buffers()
 		VkRect2D scissor = vkb::initializers::rect2D(width, height, 0, 0);
 		vkCmdSetScissor(draw_cmd_buffers[i], 0, 1, &scissor);
 
-		vkCmdBindDescriptorSets(draw_cmd_buffers[i], VK_PIPELINE_BIND_POINT_GRAPHICS, pipeline_layout, 0, 1, &descriptor_set, 0, NULL);
+		// Each command buffer reads the uniform region of its swap chain image
+		uint32_t dynamic_offset = get_ring_uniform_offset(sizeof(ubo_vs), i);
+		vkCmdBindDescriptorSets(draw_cmd_buffers[i], VK_PIPELINE_BIND_POINT_GRAPHICS, pipeline_layout, 0, 1, &descriptor_set, 1, &dynamic_offset);
 		vkCmdBindPipeline(draw_cmd_buffers[i], VK_PIPELINE_BIND_POINT_GRAPHICS, pipelines.solid);
 
 		VkDeviceSize offsets[1] = {0};
@@ -445,8 +441,6 @@ void TextureLoading::build_command_buffers()
 
 		vkCmdDrawIndexed(draw_cmd_buffers[i], index_count, 1, 0, 0, 0);
 
-		draw_ui(draw_cmd_buffers[i]);
-
 		vkCmdEndRenderPass(draw_cmd_buffers[i]);
 
 		VK_CHECK(vkEndCommandBuffer(draw_cmd_buffers[i]));
@@ -455,8 +449,19 @@ void TextureLoading::build_command_buffers()
 
 void TextureLoading::draw()
 {
+	// Retire the completed copies, and stream the next level once the previous one is resident
+	get_device().get_staging_manager().update();
+	if (streaming.next_level > 0 && streaming.resident_level == streaming.next_level)
+	{
+		stream_next_mip_level();
+	}
+	ubo_vs.min_lod = static_cast<float>(streaming.resident_level);
+
 	ApiVulkanSample::prepare_frame();
 
+	// Only the acquired image's region is written, the other regions may still be read by frames in flight
+	update_ring_uniform_buffer(*uniform_buffer_vs, ubo_vs);
+
 	// Command buffer to be sumitted to the queue
 	submit_info.commandBufferCount = 1;
 	submit_info.pCommandBuffers    = &draw_cmd_buffers[current_buffer];
@@ -506,7 +511,7 @@ void TextureLoading::setup_descriptor_pool()
 	// Example uses one ubo and one image sampler
 	std::vector<VkDescriptorPoolSize> pool_sizes =
 	    {
-	        vkb::initializers::descriptor_pool_size(VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, 1),
+	        vkb::initializers::descriptor_pool_size(VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC, 1),
 	        vkb::initializers::descriptor_pool_size(VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, 1)};
 
 	VkDescriptorPoolCreateInfo descriptor_pool_create_info =
@@ -522,9 +527,9 @@ void TextureLoading::setup_descriptor_set_layout()
 {
 	std::vector<VkDescriptorSetLayoutBinding> set_layout_bindings =
 	    {
-	        // Binding 0 : Vertex shader uniform buffer
+	        // Binding 0 : Vertex shader uniform buffer, offset to the region of the swap chain image
 	        vkb::initializers::descriptor_set_layout_binding(
-	            VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER,
+	            VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC,
 	            VK_SHADER_STAGE_VERTEX_BIT,
 	            0),
 	        // Binding 1 : Fragment shader image sampler
@@ -558,7 +563,7 @@ void TextureLoading::setup_descriptor_set()
 
 	VK_CHECK(vkAllocateDescriptorSets(get_device().get_handle(), &alloc_info, &descriptor_set));
 
-	VkDescriptorBufferInfo buffer_descriptor = create_descriptor(*uniform_buffer_vs);
+	VkDescriptorBufferInfo buffer_descriptor = create_descriptor(*uniform_buffer_vs, sizeof(ubo_vs));
 
 	// Setup a descriptor image info for the current texture to be used as a combined image sampler
 	VkDescriptorImageInfo image_descriptor;
@@ -571,7 +576,7 @@ void TextureLoading::setup_descriptor_set()
 	        // Binding 0 : Vertex shader uniform buffer
 	        vkb::initializers::write_descriptor_set(
 	            descriptor_set,
-	            VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER,
+	            VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC,
 	            0,
 	            &buffer_descriptor),
 	        // Binding 1 : Fragment shader texture sampler
@@ -680,11 +685,8 @@ void TextureLoading::prepare_pipelines()
 // Prepare and initialize uniform buffer containing shader uniforms
 void TextureLoading::prepare_uniform_buffers()
 {
-	// Vertex shader uniform buffer block
-	uniform_buffer_vs = std::make_unique<vkb::core::Buffer>(get_device(),
-	                                                        sizeof(ubo_vs),
-	                                                        VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT,
-	                                                        VMA_MEMORY_USAGE_CPU_TO_GPU);
+	// Vertex shader uniform buffer block, one region per swap chain image
+	uniform_buffer_vs = create_ring_uniform_buffer(sizeof(ubo_vs));
 
 	update_uniform_buffers();
 }
@@ -702,7 +704,7 @@ void TextureLoading::update_uniform_buffers()
 
 	ubo_vs.view_pos = glm::vec4(0.0f, 0.0f, -zoom, 0.0f);
 
-	uniform_buffer_vs->convert_and_update(ubo_vs);
+	// Uploaded to the acquired image's region in draw()
 }
 
 bool TextureLoading::prepare(vkb::Platform &platform)
@@ -743,6 +745,7 @@ void TextureLoading::on_update_ui_overlay(vkb::Drawer &drawer)
 		{
 			update_uniform_buffers();
 		}
+		drawer.text("Resident mip levels: %d / %d", texture.mip_levels - streaming.resident_level, texture.mip_levels);
 	}
 }
 
@@ -24,6 +24,7 @@
 #include <ktx.h>
 
 #include "api_vulkan_sample.h"
+#include "platform/filesystem.h"
 
 // Vertex layout for this example
 struct TextureLoadingVertexStructure
@@ -49,6 +50,17 @@ class TextureLoading : public ApiVulkanSample
 		uint32_t       mip_levels;
 	} texture;
 
+	// Mip levels streamed smallest-first through the device's staging ring, the shader clamps sampling to the resident ones
+	struct
+	{
+		std::unique_ptr<vkb::fs::MappedFile> file;                 // Mapping of the KTX file, released once every level is staged
+		std::unique_ptr<vkb::core::Image>    image;                // Non-owning wrapper of texture.image for the staging manager
+		std::vector<VkDeviceSize>            level_offsets;        // Offset of the data of each level in the file
+		std::vector<VkDeviceSize>            level_sizes;          // Size of the data of each level
+		uint32_t                             next_level{0};        // Next level to upload is next_level - 1, counting down to 0
+		uint32_t                             resident_level{0};    // Finest level whose upload completed
+	} streaming;
+
 	std::unique_ptr<vkb::core::Buffer> vertex_buffer;
 	std::unique_ptr<vkb::core::Buffer> index_buffer;
 	uint32_t                           index_count;
@@ -61,6 +73,7 @@ class TextureLoading : public ApiVulkanSample
 		glm::mat4 model;
 		glm::vec4 view_pos;
 		float     lod_bias = 0.0f;
+		float     min_lod  = 0.0f;
 	} ubo_vs;
 
 	struct
@@ -76,6 +89,7 @@ class TextureLoading : public ApiVulkanSample
 	~TextureLoading();
 	virtual void request_gpu_features(vkb::PhysicalDevice &gpu) override;
 	void         load_texture();
+	uint64_t     stream_next_mip_level();
 	void         destroy_texture(Texture texture);
 	void         build_command_buffers() override;
 	void         draw();
@@ -26,6 +26,9 @@ TextureMipMapGeneration::TextureMipMapGeneration()
 	zoom     = -2.5f;
 	rotation = {0.0f, 15.0f, 0.0f};
 	title    = "Texture MipMap generation";
+
+	// The uniform buffer is ring-buffered per swap chain image, so camera movement does not wait for the GPU
+	frames_in_flight = 2;
 }
 
 TextureMipMapGeneration::~TextureMipMapGeneration()
@@ -350,13 +353,13 @@ void TextureMipMapGeneration::build_command_buffers()
 		VkRect2D scissor = vkb::initializers::rect2D(width, height, 0, 0);
 		vkCmdSetScissor(draw_cmd_buffers[i], 0, 1, &scissor);
 
-		vkCmdBindDescriptorSets(draw_cmd_buffers[i], VK_PIPELINE_BIND_POINT_GRAPHICS, pipeline_layout, 0, 1, &descriptor_set, 0, NULL);
+		// Each command buffer reads the uniform region of its swap chain image
+		uint32_t dynamic_offset = get_ring_uniform_offset(sizeof(ubo), i);
+		vkCmdBindDescriptorSets(draw_cmd_buffers[i], VK_PIPELINE_BIND_POINT_GRAPHICS, pipeline_layout, 0, 1, &descriptor_set, 1, &dynamic_offset);
 		vkCmdBindPipeline(draw_cmd_buffers[i], VK_PIPELINE_BIND_POINT_GRAPHICS, pipeline);
 
 		draw_model(scene, draw_cmd_buffers[i]);
 
-		draw_ui(draw_cmd_buffers[i]);
-
 		vkCmdEndRenderPass(draw_cmd_buffers[i]);
 
 		VK_CHECK(vkEndCommandBuffer(draw_cmd_buffers[i]));
@@ -367,6 +370,9 @@ void TextureMipMapGeneration::draw()
 {
 	ApiVulkanSample::prepare_frame();
 
+	// Only the acquired image's region is written, the other regions may still be read by frames in flight
+	update_ring_uniform_buffer(*uniform_buffer, ubo);
+
 	// Command buffer to be sumitted to the queue
 	submit_info.commandBufferCount = 1;
 	submit_info.pCommandBuffers    = &draw_cmd_buffers[current_buffer];
@@ -382,7 +388,7 @@ void TextureMipMapGeneration::setup_descriptor_pool()
 	// Example uses one ubo and one image sampler
 	std::vector<VkDescriptorPoolSize> pool_sizes =
 	    {
-	        vkb::initializers::descriptor_pool_size(VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, 1),
+	        vkb::initializers::descriptor_pool_size(VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC, 1),
 	        vkb::initializers::descriptor_pool_size(VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE, 1),
 	        vkb::initializers::descriptor_pool_size(VK_DESCRIPTOR_TYPE_SAMPLER, 3),
 	    };
@@ -400,9 +406,9 @@ void TextureMipMapGeneration::setup_descriptor_set_layout()
 {
 	std::vector<VkDescriptorSetLayoutBinding> set_layout_bindings =
 	    {
-	        // Binding 0 : Parameter uniform buffer
+	        // Binding 0 : Parameter uniform buffer, offset to the region of the swap chain image
 	        vkb::initializers::descriptor_set_layout_binding(
-	            VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER,
+	            VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC,
 	            VK_SHADER_STAGE_VERTEX_BIT | VK_SHADER_STAGE_FRAGMENT_BIT,
 	            0),
 	        // Binding 1 : Fragment shader image sampler
@@ -443,7 +449,7 @@ void TextureMipMapGeneration::setup_descriptor_set()
 
 	VK_CHECK(vkAllocateDescriptorSets(get_device().get_handle(), &alloc_info, &descriptor_set));
 
-	VkDescriptorBufferInfo buffer_descriptor = create_descriptor(*uniform_buffer);
+	VkDescriptorBufferInfo buffer_descriptor = create_descriptor(*uniform_buffer, sizeof(ubo));
 
 	VkDescriptorImageInfo image_descriptor;
 	image_descriptor.imageView   = texture.view;
@@ -455,7 +461,7 @@ void TextureMipMapGeneration::setup_descriptor_set()
 	        // Binding 0 : Vertex shader uniform buffer
 	        vkb::initializers::write_descriptor_set(
 	            descriptor_set,
-	            VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER,
+	            VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC,
 	            0,
 	            &buffer_descriptor),
 	        // Binding 1 : Fragment shader texture sampler
@@ -570,11 +576,8 @@ void TextureMipMapGeneration::prepare_pipelines()
 
 void TextureMipMapGeneration::prepare_uniform_buffers()
 {
-	// Shared parameter uniform buffer block
-	uniform_buffer = std::make_unique<vkb::core::Buffer>(get_device(),
-	                                                     sizeof(ubo),
-	                                                     VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT,
-	                                                     VMA_MEMORY_USAGE_CPU_TO_GPU);
+	// Shared parameter uniform buffer block, with a region per swap chain image
+	uniform_buffer = create_ring_uniform_buffer(sizeof(ubo));
 
 	update_uniform_buffers();
 }
@@ -590,7 +593,8 @@ void TextureMipMapGeneration::update_uniform_buffers(float delta_time)
 	{
 		timer -= 1.0f;
 	}
-	uniform_buffer->convert_and_update(ubo);
+
+	// Uploaded to the acquired image's region in draw()
 }
 
 bool TextureMipMapGeneration::prepare(vkb::Platform &platform)
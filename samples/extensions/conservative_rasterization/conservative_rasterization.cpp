@@ -325,8 +325,6 @@ void ConservativeRasterization::build_command_buffers()
 			vkCmdBindDescriptorSets(draw_cmd_buffers[i], VK_PIPELINE_BIND_POINT_GRAPHICS, pipeline_layouts.scene, 0, 1, &descriptor_sets.scene, 0, nullptr);
 			vkCmdDraw(draw_cmd_buffers[i], 3, 1, 0, 0);
 
-			draw_ui(draw_cmd_buffers[i]);
-
 			vkCmdEndRenderPass(draw_cmd_buffers[i]);
 		}
 
@@ -457,8 +457,6 @@ void DebugUtils::build_command_buffers()
 				vkCmdDraw(draw_cmd_buffers[i], 3, 1, 0, 0);
 			}
 
-			draw_ui(draw_cmd_buffers[i]);
-
 			vkCmdEndRenderPass(draw_cmd_buffers[i]);
 
 			cmd_end_label(draw_cmd_buffers[i]);
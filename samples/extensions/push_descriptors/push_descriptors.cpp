@@ -147,8 +147,6 @@ void PushDescriptors::build_command_buffers()
 			draw_model(models.cube, draw_cmd_buffers[i]);
 		}
 
-		draw_ui(draw_cmd_buffers[i]);
-
 		vkCmdEndRenderPass(draw_cmd_buffers[i]);
 
 		VK_CHECK(vkEndCommandBuffer(draw_cmd_buffers[i]));
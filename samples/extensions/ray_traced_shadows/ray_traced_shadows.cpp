@@ -0,0 +1,253 @@
+/* Copyright (c) 2020, Arm Limited and Contributors
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 the "License";
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/*
+ * Important note:
+ *
+ * The VK_KHR_ray_tracing extension is currently considered a BETA extension.
+ *
+ * This means that it is not yet production ready and subject to change until it's finalized.
+ *
+ * In order to use this sample you may also need special developer drivers.
+ */
+
+#include "ray_traced_shadows.h"
+
+#include "common/vk_common.h"
+#include "glsl_compiler.h"
+#include "gui.h"
+#include "platform/platform.h"
+#include "rendering/render_pipeline.h"
+#include "rendering/subpasses/geometry_subpass.h"
+#include "rendering/subpasses/lighting_subpass.h"
+#include "scene_graph/components/light.h"
+#include "scene_graph/scene.h"
+#include "stats/stats.h"
+
+namespace
+{
+/// Light visibility and ambient visibility written by the ray traced shadow subpass
+constexpr VkFormat VISIBILITY_FORMAT = VK_FORMAT_R8G8_UNORM;
+
+/// Distance rays start at from surfaces, in the units of the Sponza scene
+constexpr float RAY_OFFSET = 1.0f;
+
+constexpr int MAX_TRACE_STRIDE = 4;
+}        // namespace
+
+RayTracedShadows::RayTracedShadows()
+{
+	// The ray tracing extension and its dependencies on top of Vulkan 1.1
+	set_api_version(VK_API_VERSION_1_1);
+
+	add_device_extension(VK_KHR_MAINTENANCE3_EXTENSION_NAME);
+	add_device_extension(VK_KHR_GET_MEMORY_REQUIREMENTS_2_EXTENSION_NAME);
+	add_device_extension(VK_KHR_RAY_TRACING_EXTENSION_NAME);
+	add_device_extension(VK_KHR_BUFFER_DEVICE_ADDRESS_EXTENSION_NAME);
+	add_device_extension(VK_KHR_DEFERRED_HOST_OPERATIONS_EXTENSION_NAME);
+	add_device_extension(VK_EXT_DESCRIPTOR_INDEXING_EXTENSION_NAME);
+	add_device_extension(VK_KHR_PIPELINE_LIBRARY_EXTENSION_NAME);
+	add_device_extension(VK_KHR_SPIRV_1_4_EXTENSION_NAME);
+	add_device_extension(VK_KHR_SHADER_FLOAT_CONTROLS_EXTENSION_NAME);
+
+	// The acceleration structures are built from the vertex and index buffers of the scene
+	set_scene_geometry_buffer_usage(VK_BUFFER_USAGE_SHADER_DEVICE_ADDRESS_BIT);
+}
+
+RayTracedShadows::~RayTracedShadows()
+{
+	if (device)
+	{
+		device->wait_idle();
+	}
+
+	acceleration_structures.reset();
+
+	vkb::GLSLCompiler::reset_target_environment();
+}
+
+void RayTracedShadows::request_gpu_features(vkb::PhysicalDevice &gpu)
+{
+	// The visibility history is written by a fragment shader
+	if (gpu.get_features().fragmentStoresAndAtomics)
+	{
+		gpu.get_mutable_requested_features().fragmentStoresAndAtomics = VK_TRUE;
+	}
+	else
+	{
+		throw std::runtime_error("Requested required feature <VkPhysicalDeviceFeatures::fragmentStoresAndAtomics> is not supported");
+	}
+
+	auto &requested_buffer_device_address_features               = gpu.request_extension_features<VkPhysicalDeviceBufferDeviceAddressFeatures>(VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_BUFFER_DEVICE_ADDRESS_FEATURES);
+	requested_buffer_device_address_features.bufferDeviceAddress = VK_TRUE;
+
+	auto &requested_ray_tracing_features      = gpu.request_extension_features<VkPhysicalDeviceRayTracingFeaturesKHR>(VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_RAY_TRACING_FEATURES_KHR);
+	requested_ray_tracing_features.rayTracing = VK_TRUE;
+	requested_ray_tracing_features.rayQuery   = VK_TRUE;
+}
+
+std::unique_ptr<vkb::RenderTarget> RayTracedShadows::create_render_target(vkb::core::Image &&swapchain_image)
+{
+	auto &device = swapchain_image.get_device();
+	auto &extent = swapchain_image.get_extent();
+
+	VkImageUsageFlags usage = VK_IMAGE_USAGE_INPUT_ATTACHMENT_BIT | VK_IMAGE_USAGE_TRANSIENT_ATTACHMENT_BIT;
+
+	vkb::core::Image depth_image{device,
+	                             extent,
+	                             vkb::get_suitable_depth_format(device.get_gpu().get_handle()),
+	                             VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT | usage,
+	                             VMA_MEMORY_USAGE_GPU_ONLY};
+
+	vkb::core::Image albedo_image{device, extent, VK_FORMAT_R8G8B8A8_UNORM, VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT | usage, VMA_MEMORY_USAGE_GPU_ONLY};
+
+	vkb::core::Image normal_image{device, extent, VK_FORMAT_A2B10G10R10_UNORM_PACK32, VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT | usage, VMA_MEMORY_USAGE_GPU_ONLY};
+
+	vkb::core::Image visibility_image{device, extent, VISIBILITY_FORMAT, VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT | usage, VMA_MEMORY_USAGE_GPU_ONLY};
+
+	std::vector<vkb::core::Image> images;
+
+	// Attachment 0
+	images.push_back(std::move(swapchain_image));
+
+	// Attachment 1
+	images.push_back(std::move(depth_image));
+
+	// Attachment 2
+	images.push_back(std::move(albedo_image));
+
+	// Attachment 3
+	images.push_back(std::move(normal_image));
+
+	// Attachment 4
+	images.push_back(std::move(visibility_image));
+
+	return std::make_unique<vkb::RenderTarget>(std::move(images));
+}
+
+void RayTracedShadows::prepare_render_context()
+{
+	get_render_context().prepare(1, [this](vkb::core::Image &&swapchain_image) { return create_render_target(std::move(swapchain_image)); });
+}
+
+bool RayTracedShadows::prepare(vkb::Platform &platform)
+{
+	if (!VulkanSample::prepare(platform))
+	{
+		return false;
+	}
+
+	// Ray queries are only available to shaders compiled for SPIR-V 1.4
+	vkb::GLSLCompiler::set_target_environment(glslang::EShTargetSpv, glslang::EShTargetSpv_1_4);
+
+	load_scene("scenes/sponza/Sponza01.gltf");
+
+	// Shade the scene with a single directional light casting the shadows
+	scene->clear_components<vkb::sg::Light>();
+
+	vkb::sg::LightProperties light_properties;
+	light_properties.intensity = 1.5f;
+	vkb::add_directional_light(*scene, glm::quat(glm::vec3(glm::radians(-70.0f), glm::radians(20.0f), 0.0f)), light_properties);
+
+	auto &camera_node = vkb::add_free_camera(*scene, "main_camera", get_render_context().get_surface_extent());
+	camera            = dynamic_cast<vkb::sg::PerspectiveCamera *>(&camera_node.get_component<vkb::sg::Camera>());
+
+	// Build the bottom level acceleration structures upfront, the top level one is built by the first frame
+	acceleration_structures = std::make_unique<vkb::AccelerationStructureBuilder>(get_device());
+	acceleration_structures->add_scene(*scene);
+	acceleration_structures->build_bottom_level(get_device().get_queue_by_flags(VK_QUEUE_GRAPHICS_BIT, 0).get_handle());
+
+	// Geometry subpass
+	auto geometry_vs      = vkb::ShaderSource{"deferred/geometry.vert"};
+	auto geometry_fs      = vkb::ShaderSource{"deferred/geometry.frag"};
+	auto geometry_subpass = std::make_unique<vkb::GeometrySubpass>(get_render_context(), std::move(geometry_vs), std::move(geometry_fs), *scene, *camera);
+
+	// Outputs are depth, albedo, and normal
+	geometry_subpass->set_output_attachments({1, 2, 3});
+
+	// Ray traced shadow subpass
+	auto visibility_vs = vkb::ShaderSource{"deferred/lighting.vert"};
+	auto visibility_fs = vkb::ShaderSource{"ray_traced_shadows/visibility.frag"};
+	auto visibility    = std::make_unique<vkb::RayTracedShadowSubpass>(get_render_context(), std::move(visibility_vs), std::move(visibility_fs), *camera, *scene, *acceleration_structures);
+
+	// Inputs are depth and normal from the geometry subpass, output is the visibility
+	visibility->set_input_attachments({1, 3});
+	visibility->set_output_attachments({4});
+	visibility->set_ray_offset(RAY_OFFSET);
+	shadow_subpass = visibility.get();
+
+	// Lighting subpass
+	auto lighting_vs      = vkb::ShaderSource{"deferred/lighting.vert"};
+	auto lighting_fs      = vkb::ShaderSource{"deferred/lighting.frag"};
+	auto lighting_subpass = std::make_unique<vkb::LightingSubpass>(get_render_context(), std::move(lighting_vs), std::move(lighting_fs), *camera, *scene);
+
+	// Inputs are depth, albedo, and normal from the geometry subpass, and the visibility
+	lighting_subpass->set_input_attachments({1, 2, 3, 4});
+	lighting_subpass->set_ray_traced_visibility(true);
+
+	std::vector<std::unique_ptr<vkb::Subpass>> subpasses{};
+	subpasses.push_back(std::move(geometry_subpass));
+	subpasses.push_back(std::move(visibility));
+	subpasses.push_back(std::move(lighting_subpass));
+
+	auto render_pipeline = vkb::RenderPipeline{std::move(subpasses)};
+
+	// The visibility is cleared and not stored, like the rest of the G-buffer
+	auto load_store = vkb::gbuffer::get_clear_all_store_swapchain();
+	load_store.push_back(load_store[3]);
+	render_pipeline.set_load_store(load_store);
+
+	auto clear_value = vkb::gbuffer::get_clear_value();
+	clear_value.push_back(VkClearValue{});
+	clear_value.back().color = {{1.0f, 1.0f, 0.0f, 0.0f}};
+	render_pipeline.set_clear_value(clear_value);
+
+	set_render_pipeline(std::move(render_pipeline));
+
+	stats->request_stats({vkb::StatIndex::frame_times});
+
+	gui = std::make_unique<vkb::Gui>(*this, platform.get_window(), stats.get());
+
+	return true;
+}
+
+void RayTracedShadows::update(float delta_time)
+{
+	shadow_subpass->set_trace_stride(static_cast<uint32_t>(trace_stride));
+	shadow_subpass->set_ambient_occlusion_radius(ambient_occlusion_radius);
+	shadow_subpass->set_history_weight(history_weight);
+
+	VulkanSample::update(delta_time);
+}
+
+void RayTracedShadows::draw_gui()
+{
+	gui->show_options_window(
+	    /* body = */ [this]() {
+		    ImGui::PushItemWidth(ImGui::GetWindowWidth() * 0.55f);
+		    ImGui::SliderInt("Trace stride", &trace_stride, 1, MAX_TRACE_STRIDE);
+		    ImGui::SliderFloat("AO radius", &ambient_occlusion_radius, 0.0f, 500.0f);
+		    ImGui::SliderFloat("History weight", &history_weight, 0.0f, 0.98f);
+		    ImGui::PopItemWidth();
+	    },
+	    /* lines = */ 3);
+}
+
+std::unique_ptr<vkb::VulkanSample> create_ray_traced_shadows()
+{
+	return std::make_unique<RayTracedShadows>();
+}
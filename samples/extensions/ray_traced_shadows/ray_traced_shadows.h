@@ -0,0 +1,65 @@
+/* Copyright (c) 2020, Arm Limited and Contributors
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 the "License";
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <memory>
+
+#include "rendering/acceleration_structure_builder.h"
+#include "rendering/subpasses/ray_traced_shadow_subpass.h"
+#include "scene_graph/components/perspective_camera.h"
+#include "vulkan_sample.h"
+
+/**
+ * @brief Deferred renderer shading the Sponza scene with ray traced shadows and ambient occlusion,
+ *        traced with ray queries by a subpass between the geometry and the lighting subpasses
+ */
+class RayTracedShadows : public vkb::VulkanSample
+{
+  public:
+	RayTracedShadows();
+
+	virtual ~RayTracedShadows();
+
+	virtual bool prepare(vkb::Platform &platform) override;
+
+	virtual void request_gpu_features(vkb::PhysicalDevice &gpu) override;
+
+	virtual void update(float delta_time) override;
+
+  private:
+	std::unique_ptr<vkb::RenderTarget> create_render_target(vkb::core::Image &&swapchain_image);
+
+	virtual void prepare_render_context() override;
+
+	virtual void draw_gui() override;
+
+	vkb::sg::PerspectiveCamera *camera{nullptr};
+
+	std::unique_ptr<vkb::AccelerationStructureBuilder> acceleration_structures;
+
+	/// Owned by the render pipeline
+	vkb::RayTracedShadowSubpass *shadow_subpass{nullptr};
+
+	int trace_stride{2};
+
+	float ambient_occlusion_radius{100.0f};
+
+	float history_weight{0.9f};
+};
+
+std::unique_ptr<vkb::VulkanSample> create_ray_traced_shadows();
@@ -31,87 +31,14 @@
 
 #include "raytracing_basic.h"
 
-/*
-	Create a scratch buffer used as a temporary storage in various ray tracing structures
-*/
-RayTracingScratchBuffer::RayTracingScratchBuffer(vkb::Device &device, VkAccelerationStructureKHR acceleration_structure) :
-    device(device)
-{
-	VkMemoryRequirements2 memory_requirements_2{};
-	memory_requirements_2.sType = VK_STRUCTURE_TYPE_MEMORY_REQUIREMENTS_2;
-
-	VkAccelerationStructureMemoryRequirementsInfoKHR acceleration_memory_requirements{};
-	acceleration_memory_requirements.sType                 = VK_STRUCTURE_TYPE_ACCELERATION_STRUCTURE_MEMORY_REQUIREMENTS_INFO_KHR;
-	acceleration_memory_requirements.type                  = VK_ACCELERATION_STRUCTURE_MEMORY_REQUIREMENTS_TYPE_BUILD_SCRATCH_KHR;
-	acceleration_memory_requirements.buildType             = VK_ACCELERATION_STRUCTURE_BUILD_TYPE_DEVICE_KHR;
-	acceleration_memory_requirements.accelerationStructure = acceleration_structure;
-	vkGetAccelerationStructureMemoryRequirementsKHR(device.get_handle(), &acceleration_memory_requirements, &memory_requirements_2);
-
-	VkBufferCreateInfo buffer_create_info{};
-	buffer_create_info.sType       = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
-	buffer_create_info.size        = memory_requirements_2.memoryRequirements.size;
-	buffer_create_info.usage       = VK_BUFFER_USAGE_RAY_TRACING_BIT_KHR | VK_BUFFER_USAGE_SHADER_DEVICE_ADDRESS_BIT;
-	buffer_create_info.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
-	VK_CHECK(vkCreateBuffer(device.get_handle(), &buffer_create_info, nullptr, &buffer));
-
-	VkMemoryRequirements memory_requirements{};
-	vkGetBufferMemoryRequirements(device.get_handle(), buffer, &memory_requirements);
-
-	VkMemoryAllocateFlagsInfo memory_allocate_flags_info{};
-	memory_allocate_flags_info.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_FLAGS_INFO;
-	memory_allocate_flags_info.flags = VK_MEMORY_ALLOCATE_DEVICE_ADDRESS_BIT_KHR;
-
-	VkMemoryAllocateInfo memory_allocate_info{};
-	memory_allocate_info.sType           = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
-	memory_allocate_info.pNext           = &memory_allocate_flags_info;
-	memory_allocate_info.allocationSize  = memory_requirements.size;
-	memory_allocate_info.memoryTypeIndex = device.get_memory_type(memory_requirements.memoryTypeBits, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
-	VK_CHECK(vkAllocateMemory(device.get_handle(), &memory_allocate_info, nullptr, &memory));
-	VK_CHECK(vkBindBufferMemory(device.get_handle(), buffer, memory, 0));
-
-	VkBufferDeviceAddressInfoKHR buffer_device_address_info{};
-	buffer_device_address_info.sType  = VK_STRUCTURE_TYPE_BUFFER_DEVICE_ADDRESS_INFO;
-	buffer_device_address_info.buffer = buffer;
-	device_address                    = vkGetBufferDeviceAddressKHR(device.get_handle(), &buffer_device_address_info);
-}
-
-RayTracingScratchBuffer::~RayTracingScratchBuffer()
+namespace
 {
-	// Scratch buffers can be safely deleted after the acceleration structure has been built
-	if (memory != VK_NULL_HANDLE)
-	{
-		vkFreeMemory(device.get_handle(), memory, nullptr);
-	}
-	if (buffer != VK_NULL_HANDLE)
-	{
-		vkDestroyBuffer(device.get_handle(), buffer, nullptr);
-	}
-}
+/// Number of instances of the triangle in the top level acceleration structure
+constexpr uint32_t INSTANCE_COUNT = 3;
 
-/*
-	Create memory that will be attached to an acceleration structure
-*/
-RayTracingObjectMemory::RayTracingObjectMemory(vkb::Device &device, VkAccelerationStructureKHR acceleration_structure) :
-    device(device)
-{
-	VkMemoryRequirements2 memory_requirements_2{};
-	memory_requirements_2.sType = VK_STRUCTURE_TYPE_MEMORY_REQUIREMENTS_2;
-
-	VkAccelerationStructureMemoryRequirementsInfoKHR acceleration_memory_requirements{};
-	acceleration_memory_requirements.sType                 = VK_STRUCTURE_TYPE_ACCELERATION_STRUCTURE_MEMORY_REQUIREMENTS_INFO_KHR;
-	acceleration_memory_requirements.type                  = VK_ACCELERATION_STRUCTURE_MEMORY_REQUIREMENTS_TYPE_OBJECT_KHR;
-	acceleration_memory_requirements.buildType             = VK_ACCELERATION_STRUCTURE_BUILD_TYPE_DEVICE_KHR;
-	acceleration_memory_requirements.accelerationStructure = acceleration_structure;
-	vkGetAccelerationStructureMemoryRequirementsKHR(device.get_handle(), &acceleration_memory_requirements, &memory_requirements_2);
-
-	VkMemoryRequirements memory_requirements = memory_requirements_2.memoryRequirements;
-
-	VkMemoryAllocateInfo memory_allocate_info{};
-	memory_allocate_info.sType           = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
-	memory_allocate_info.allocationSize  = memory_requirements.size;
-	memory_allocate_info.memoryTypeIndex = device.get_memory_type(memory_requirements.memoryTypeBits, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
-	VK_CHECK(vkAllocateMemory(device.get_handle(), &memory_allocate_info, nullptr, &memory));
-}
+/// Distance between two instances along the x axis
+constexpr float INSTANCE_SPACING = 1.2f;
+}        // namespace
 
 RaytracingBasic::RaytracingBasic()
 {
@@ -137,10 +64,8 @@ RaytracingBasic::~RaytracingBasic()
 		vkDestroyImageView(get_device().get_handle(), storage_image.view, nullptr);
 		vkDestroyImage(get_device().get_handle(), storage_image.image, nullptr);
 		vkFreeMemory(get_device().get_handle(), storage_image.memory, nullptr);
-		vkDestroyAccelerationStructureKHR(device->get_handle(), bottom_level_acceleration_structure, nullptr);
-		vkDestroyAccelerationStructureKHR(device->get_handle(), top_level_acceleration_structure, nullptr);
-		vertex_buffer.reset();
-		index_buffer.reset();
+		acceleration_structure_builder.reset();
+		triangle.reset();
 		shader_binding_table.reset();
 		ubo.reset();
 	}
@@ -208,17 +133,6 @@ void RaytracingBasic::create_storage_image()
 	get_device().flush_command_buffer(command_buffer, queue);
 }
 
-/*
-	Gets the device address from a buffer that's required for some of the ray tracing acceleration structures
-*/
-uint64_t RaytracingBasic::get_buffer_device_address(VkBuffer buffer)
-{
-	VkBufferDeviceAddressInfoKHR buffer_device_address_info{};
-	buffer_device_address_info.sType  = VK_STRUCTURE_TYPE_BUFFER_DEVICE_ADDRESS_INFO;
-	buffer_device_address_info.buffer = buffer;
-	return vkGetBufferDeviceAddressKHR(device->get_handle(), &buffer_device_address_info);
-}
-
 /*
 	Create scene geometry and ray tracing acceleration structures
 */
@@ -242,210 +156,82 @@ void RaytracingBasic::create_scene()
 		auto vertex_buffer_size = vertices.size() * sizeof(Vertex);
 		auto index_buffer_size  = indices.size() * sizeof(uint32_t);
 
+		triangle = std::make_unique<vkb::sg::SubMesh>();
+
 		// Create buffers
 		// For the sake of simplicity we won't stage the vertex data to the gpu memory
 		// Vertex buffer
-		vertex_buffer = std::make_unique<vkb::core::Buffer>(get_device(),
-		                                                    vertex_buffer_size,
-		                                                    VK_BUFFER_USAGE_VERTEX_BUFFER_BIT | VK_BUFFER_USAGE_SHADER_DEVICE_ADDRESS_BIT,
-		                                                    VMA_MEMORY_USAGE_CPU_TO_GPU);
-		vertex_buffer->update(vertices.data(), vertex_buffer_size);
+		vkb::core::Buffer vertex_buffer{get_device(),
+		                                vertex_buffer_size,
+		                                VK_BUFFER_USAGE_VERTEX_BUFFER_BIT | VK_BUFFER_USAGE_SHADER_DEVICE_ADDRESS_BIT,
+		                                VMA_MEMORY_USAGE_CPU_TO_GPU};
+		vertex_buffer.update(vertices.data(), vertex_buffer_size);
+		triangle->vertex_buffers.insert(std::make_pair("position", std::move(vertex_buffer)));
+
+		vkb::sg::VertexAttribute position;
+		position.format = VK_FORMAT_R32G32B32_SFLOAT;
+		position.stride = sizeof(Vertex);
+		triangle->set_attribute("position", position);
+		triangle->vertices_count = static_cast<uint32_t>(vertices.size());
 
 		// Index buffer
-		index_buffer = std::make_unique<vkb::core::Buffer>(get_device(),
-		                                                   index_buffer_size,
-		                                                   VK_BUFFER_USAGE_INDEX_BUFFER_BIT | VK_BUFFER_USAGE_SHADER_DEVICE_ADDRESS_BIT,
-		                                                   VMA_MEMORY_USAGE_CPU_TO_GPU);
-		index_buffer->update(indices.data(), index_buffer_size);
-
-		VkDeviceOrHostAddressConstKHR vertex_data_device_address{};
-		VkDeviceOrHostAddressConstKHR index_data_device_address{};
-
-		vertex_data_device_address.deviceAddress = get_buffer_device_address(vertex_buffer->get_handle());
-		index_data_device_address.deviceAddress  = get_buffer_device_address(index_buffer->get_handle());
-
-		VkAccelerationStructureCreateGeometryTypeInfoKHR acceleration_create_geometry_info{};
-		acceleration_create_geometry_info.sType             = VK_STRUCTURE_TYPE_ACCELERATION_STRUCTURE_CREATE_GEOMETRY_TYPE_INFO_KHR;
-		acceleration_create_geometry_info.geometryType      = VK_GEOMETRY_TYPE_TRIANGLES_KHR;
-		acceleration_create_geometry_info.maxPrimitiveCount = 1;
-		acceleration_create_geometry_info.indexType         = VK_INDEX_TYPE_UINT32;
-		acceleration_create_geometry_info.maxVertexCount    = static_cast<uint32_t>(vertices.size());
-		acceleration_create_geometry_info.vertexFormat      = VK_FORMAT_R32G32B32_SFLOAT;
-		acceleration_create_geometry_info.allowsTransforms  = VK_FALSE;
-
-		VkAccelerationStructureCreateInfoKHR acceleration_create_info{};
-		acceleration_create_info.sType            = VK_STRUCTURE_TYPE_ACCELERATION_STRUCTURE_CREATE_INFO_KHR;
-		acceleration_create_info.type             = VK_ACCELERATION_STRUCTURE_TYPE_BOTTOM_LEVEL_KHR;
-		acceleration_create_info.flags            = VK_BUILD_ACCELERATION_STRUCTURE_PREFER_FAST_TRACE_BIT_KHR;
-		acceleration_create_info.maxGeometryCount = 1;
-		acceleration_create_info.pGeometryInfos   = &acceleration_create_geometry_info;
-		VK_CHECK(vkCreateAccelerationStructureKHR(device->get_handle(), &acceleration_create_info, nullptr, &bottom_level_acceleration_structure));
-
-		// Bind object memory to the top level acceleration structure
-		RayTracingObjectMemory object_memory(get_device(), bottom_level_acceleration_structure);
-
-		VkBindAccelerationStructureMemoryInfoKHR bind_acceleration_memory_info{};
-		bind_acceleration_memory_info.sType                 = VK_STRUCTURE_TYPE_BIND_ACCELERATION_STRUCTURE_MEMORY_INFO_KHR;
-		bind_acceleration_memory_info.accelerationStructure = bottom_level_acceleration_structure;
-		bind_acceleration_memory_info.memory                = object_memory.memory;
-		VK_CHECK(vkBindAccelerationStructureMemoryKHR(device->get_handle(), 1, &bind_acceleration_memory_info));
-
-		VkAccelerationStructureGeometryKHR acceleration_geometry{};
-		acceleration_geometry.sType                                       = VK_STRUCTURE_TYPE_ACCELERATION_STRUCTURE_GEOMETRY_KHR;
-		acceleration_geometry.flags                                       = VK_GEOMETRY_OPAQUE_BIT_KHR;
-		acceleration_geometry.geometryType                                = VK_GEOMETRY_TYPE_TRIANGLES_KHR;
-		acceleration_geometry.geometry.triangles.sType                    = VK_STRUCTURE_TYPE_ACCELERATION_STRUCTURE_GEOMETRY_TRIANGLES_DATA_KHR;
-		acceleration_geometry.geometry.triangles.vertexFormat             = VK_FORMAT_R32G32B32_SFLOAT;
-		acceleration_geometry.geometry.triangles.vertexData.deviceAddress = vertex_data_device_address.deviceAddress;
-		acceleration_geometry.geometry.triangles.vertexStride             = sizeof(Vertex);
-		acceleration_geometry.geometry.triangles.indexType                = VK_INDEX_TYPE_UINT32;
-		acceleration_geometry.geometry.triangles.indexData.deviceAddress  = index_data_device_address.deviceAddress;
-
-		std::vector<VkAccelerationStructureGeometryKHR> acceleration_geometries           = {acceleration_geometry};
-		VkAccelerationStructureGeometryKHR *            acceleration_structure_geometries = acceleration_geometries.data();
-
-		// Create a small scratch buffer used during build of the bottom level acceleration structure
-		RayTracingScratchBuffer scratch_buffer(get_device(), bottom_level_acceleration_structure);
-
-		VkAccelerationStructureBuildGeometryInfoKHR acceleration_build_geometry_info{};
-		acceleration_build_geometry_info.sType                     = VK_STRUCTURE_TYPE_ACCELERATION_STRUCTURE_BUILD_GEOMETRY_INFO_KHR;
-		acceleration_build_geometry_info.type                      = VK_ACCELERATION_STRUCTURE_TYPE_BOTTOM_LEVEL_KHR;
-		acceleration_build_geometry_info.flags                     = VK_BUILD_ACCELERATION_STRUCTURE_PREFER_FAST_TRACE_BIT_KHR;
-		acceleration_build_geometry_info.update                    = VK_FALSE;
-		acceleration_build_geometry_info.dstAccelerationStructure  = bottom_level_acceleration_structure;
-		acceleration_build_geometry_info.geometryArrayOfPointers   = VK_FALSE;
-		acceleration_build_geometry_info.geometryCount             = 1;
-		acceleration_build_geometry_info.ppGeometries              = &acceleration_structure_geometries;
-		acceleration_build_geometry_info.scratchData.deviceAddress = scratch_buffer.device_address;
-
-		VkAccelerationStructureBuildOffsetInfoKHR acceleration_build_offset_info{};
-		acceleration_build_offset_info.primitiveCount  = 1;
-		acceleration_build_offset_info.primitiveOffset = 0x0;
-		acceleration_build_offset_info.firstVertex     = 0;
-		acceleration_build_offset_info.transformOffset = 0x0;
-
-		std::vector<VkAccelerationStructureBuildOffsetInfoKHR *> acceleration_build_offsets = {&acceleration_build_offset_info};
-
-		if (ray_tracing_features.rayTracingHostAccelerationStructureCommands)
-		{
-			// Implementation supports building acceleration structure building on host
-			VK_CHECK(vkBuildAccelerationStructureKHR(device->get_handle(), 1, &acceleration_build_geometry_info, acceleration_build_offsets.data()));
-		}
-		else
-		{
-			// Acceleration structure needs to be build on the device
-			VkCommandBuffer command_buffer = get_device().create_command_buffer(VK_COMMAND_BUFFER_LEVEL_PRIMARY, true);
-			vkCmdBuildAccelerationStructureKHR(command_buffer, 1, &acceleration_build_geometry_info, acceleration_build_offsets.data());
-			get_device().flush_command_buffer(command_buffer, queue);
-		}
+		triangle->index_buffer = std::make_unique<vkb::core::Buffer>(get_device(),
+		                                                             index_buffer_size,
+		                                                             VK_BUFFER_USAGE_INDEX_BUFFER_BIT | VK_BUFFER_USAGE_SHADER_DEVICE_ADDRESS_BIT,
+		                                                             VMA_MEMORY_USAGE_CPU_TO_GPU);
+		triangle->index_buffer->update(indices.data(), index_buffer_size);
+		triangle->index_type     = VK_INDEX_TYPE_UINT32;
+		triangle->vertex_indices = static_cast<uint32_t>(indices.size());
+
+		// The builder batches the builds of every sub mesh added, and compacts the built acceleration structures
+		acceleration_structure_builder = std::make_unique<vkb::AccelerationStructureBuilder>(get_device());
 
-		VkAccelerationStructureDeviceAddressInfoKHR acceleration_device_address_info{};
-		acceleration_device_address_info.sType                 = VK_STRUCTURE_TYPE_ACCELERATION_STRUCTURE_DEVICE_ADDRESS_INFO_KHR;
-		acceleration_device_address_info.accelerationStructure = bottom_level_acceleration_structure;
+		uint32_t bottom_level = acceleration_structure_builder->add_sub_mesh(*triangle);
+		acceleration_structure_builder->build_bottom_level(queue);
 
-		bottom_level_acceleration_structure_handle = vkGetAccelerationStructureDeviceAddressKHR(device->get_handle(), &acceleration_device_address_info);
+		/*
+			Instances of the triangle in the top level acceleration structure, moved every frame
+		*/
+		for (uint32_t i = 0; i < INSTANCE_COUNT; ++i)
+		{
+			instances.push_back(acceleration_structure_builder->add_instance(bottom_level, glm::mat4(1.0f)));
+		}
 	}
 
 	/*
 		Create the top level acceleration structure containing geometry instances
 	*/
+	update_instances(0.0f);
+}
+
+/*
+	Moves the instances, and updates the top level acceleration structure accordingly
+*/
+void RaytracingBasic::update_instances(float delta_time)
+{
+	animation_time += delta_time;
+
+	for (uint32_t i = 0; i < INSTANCE_COUNT; ++i)
 	{
-		VkAccelerationStructureCreateGeometryTypeInfoKHR acceleration_create_geometry_info{};
-		acceleration_create_geometry_info.sType             = VK_STRUCTURE_TYPE_ACCELERATION_STRUCTURE_CREATE_GEOMETRY_TYPE_INFO_KHR;
-		acceleration_create_geometry_info.geometryType      = VK_GEOMETRY_TYPE_INSTANCES_KHR;
-		acceleration_create_geometry_info.maxPrimitiveCount = 1;
-		acceleration_create_geometry_info.allowsTransforms  = VK_FALSE;
-
-		VkAccelerationStructureCreateInfoKHR acceleration_create_info{};
-		acceleration_create_info.sType            = VK_STRUCTURE_TYPE_ACCELERATION_STRUCTURE_CREATE_INFO_KHR;
-		acceleration_create_info.type             = VK_ACCELERATION_STRUCTURE_TYPE_TOP_LEVEL_KHR;
-		acceleration_create_info.flags            = VK_BUILD_ACCELERATION_STRUCTURE_PREFER_FAST_TRACE_BIT_KHR;
-		acceleration_create_info.maxGeometryCount = 1;
-		acceleration_create_info.pGeometryInfos   = &acceleration_create_geometry_info;
-		VK_CHECK(vkCreateAccelerationStructureKHR(device->get_handle(), &acceleration_create_info, nullptr, &top_level_acceleration_structure));
-
-		// Bind object memory to the top level acceleration structure
-		RayTracingObjectMemory object_memory(get_device(), top_level_acceleration_structure);
-
-		VkBindAccelerationStructureMemoryInfoKHR bind_acceleration_memory_info{};
-		bind_acceleration_memory_info.sType                 = VK_STRUCTURE_TYPE_BIND_ACCELERATION_STRUCTURE_MEMORY_INFO_KHR;
-		bind_acceleration_memory_info.accelerationStructure = top_level_acceleration_structure;
-		bind_acceleration_memory_info.memory                = object_memory.memory;
-		VK_CHECK(vkBindAccelerationStructureMemoryKHR(device->get_handle(), 1, &bind_acceleration_memory_info));
-
-		VkTransformMatrixKHR transform_matrix = {
-		    1.0f, 0.0f, 0.0f, 0.0f,
-		    0.0f, 1.0f, 0.0f, 0.0f,
-		    0.0f, 0.0f, 1.0f, 0.0f};
-
-		VkAccelerationStructureInstanceKHR instance{};
-		instance.transform                              = transform_matrix;
-		instance.instanceCustomIndex                    = 0;
-		instance.mask                                   = 0xFF;
-		instance.instanceShaderBindingTableRecordOffset = 0;
-		instance.flags                                  = VK_GEOMETRY_INSTANCE_TRIANGLE_FACING_CULL_DISABLE_BIT_KHR;
-		instance.accelerationStructureReference         = bottom_level_acceleration_structure_handle;
-
-		std::unique_ptr<vkb::core::Buffer> instances_buffer = std::make_unique<vkb::core::Buffer>(get_device(),
-		                                                                                          sizeof(instance),
-		                                                                                          VK_BUFFER_USAGE_SHADER_DEVICE_ADDRESS_BIT,
-		                                                                                          VMA_MEMORY_USAGE_CPU_TO_GPU);
-		instances_buffer->update(&instance, sizeof(VkAccelerationStructureInstanceKHR));
-
-		VkDeviceOrHostAddressConstKHR instance_data_device_address{};
-		instance_data_device_address.deviceAddress = get_buffer_device_address(instances_buffer->get_handle());
-
-		VkAccelerationStructureGeometryKHR acceleration_geometry{};
-		acceleration_geometry.sType                                 = VK_STRUCTURE_TYPE_ACCELERATION_STRUCTURE_GEOMETRY_KHR;
-		acceleration_geometry.flags                                 = VK_GEOMETRY_OPAQUE_BIT_KHR;
-		acceleration_geometry.geometryType                          = VK_GEOMETRY_TYPE_INSTANCES_KHR;
-		acceleration_geometry.geometry.instances.sType              = VK_STRUCTURE_TYPE_ACCELERATION_STRUCTURE_GEOMETRY_INSTANCES_DATA_KHR;
-		acceleration_geometry.geometry.instances.arrayOfPointers    = VK_FALSE;
-		acceleration_geometry.geometry.instances.data.deviceAddress = instance_data_device_address.deviceAddress;
-
-		std::vector<VkAccelerationStructureGeometryKHR> acceleration_geometries           = {acceleration_geometry};
-		VkAccelerationStructureGeometryKHR *            acceleration_structure_geometries = acceleration_geometries.data();
-
-		// Create a small scratch buffer used during build of the top level acceleration structure
-		RayTracingScratchBuffer scratch_buffer(get_device(), top_level_acceleration_structure);
-
-		VkAccelerationStructureBuildGeometryInfoKHR acceleration_build_geometry_info{};
-		acceleration_build_geometry_info.sType                     = VK_STRUCTURE_TYPE_ACCELERATION_STRUCTURE_BUILD_GEOMETRY_INFO_KHR;
-		acceleration_build_geometry_info.type                      = VK_ACCELERATION_STRUCTURE_TYPE_TOP_LEVEL_KHR;
-		acceleration_build_geometry_info.flags                     = VK_BUILD_ACCELERATION_STRUCTURE_PREFER_FAST_TRACE_BIT_KHR;
-		acceleration_build_geometry_info.update                    = VK_FALSE;
-		acceleration_build_geometry_info.srcAccelerationStructure  = VK_NULL_HANDLE;
-		acceleration_build_geometry_info.dstAccelerationStructure  = top_level_acceleration_structure;
-		acceleration_build_geometry_info.geometryArrayOfPointers   = VK_FALSE;
-		acceleration_build_geometry_info.geometryCount             = 1;
-		acceleration_build_geometry_info.ppGeometries              = &acceleration_structure_geometries;
-		acceleration_build_geometry_info.scratchData.deviceAddress = scratch_buffer.device_address;
-
-		VkAccelerationStructureBuildOffsetInfoKHR acceleration_build_offset_info{};
-		acceleration_build_offset_info.primitiveCount                                       = 1;
-		acceleration_build_offset_info.primitiveOffset                                      = 0x0;
-		acceleration_build_offset_info.firstVertex                                          = 0;
-		acceleration_build_offset_info.transformOffset                                      = 0x0;
-		std::vector<VkAccelerationStructureBuildOffsetInfoKHR *> acceleration_build_offsets = {&acceleration_build_offset_info};
-
-		if (ray_tracing_features.rayTracingHostAccelerationStructureCommands)
-		{
-			// Implementation supports building acceleration structure building on host
-			VK_CHECK(vkBuildAccelerationStructureKHR(device->get_handle(), 1, &acceleration_build_geometry_info, acceleration_build_offsets.data()));
-		}
-		else
-		{
-			// Acceleration structure needs to be build on the device
-			VkCommandBuffer command_buffer = get_device().create_command_buffer(VK_COMMAND_BUFFER_LEVEL_PRIMARY, true);
-			vkCmdBuildAccelerationStructureKHR(command_buffer, 1, &acceleration_build_geometry_info, acceleration_build_offsets.data());
-			get_device().flush_command_buffer(command_buffer, queue);
-		}
+		float x = (static_cast<float>(i) - static_cast<float>(INSTANCE_COUNT - 1) / 2.0f) * INSTANCE_SPACING;
 
-		VkAccelerationStructureDeviceAddressInfoKHR acceleration_device_address_info{};
-		acceleration_device_address_info.sType                 = VK_STRUCTURE_TYPE_ACCELERATION_STRUCTURE_DEVICE_ADDRESS_INFO_KHR;
-		acceleration_device_address_info.accelerationStructure = top_level_acceleration_structure;
+		glm::mat4 transform = glm::translate(glm::mat4(1.0f), glm::vec3(x, 0.0f, 0.0f));
+		transform           = glm::rotate(transform, animation_time * static_cast<float>(i + 1), glm::vec3(0.0f, 1.0f, 0.0f));
+		transform           = glm::scale(transform, glm::vec3(0.5f));
 
-		top_level_acceleration_structure_handle = vkGetAccelerationStructureDeviceAddressKHR(device->get_handle(), &acceleration_device_address_info);
+		acceleration_structure_builder->set_instance_transform(instances[i], transform);
+	}
+
+	// Only the first build creates the top level acceleration structure, later ones update it in place
+	VkCommandBuffer command_buffer = get_device().create_command_buffer(VK_COMMAND_BUFFER_LEVEL_PRIMARY, true);
+	bool            created        = acceleration_structure_builder->record_top_level(command_buffer);
+	get_device().flush_command_buffer(command_buffer, queue);
+
+	if (created && prepared)
+	{
+		// The draw command buffers refer to the descriptor set, which refers to the previous acceleration structure
+		update_acceleration_structure_descriptor();
+		build_command_buffers();
 	}
 }
 
@@ -481,6 +267,30 @@ void RaytracingBasic::create_descriptor_sets()
 	VkDescriptorSetAllocateInfo descriptor_set_allocate_info = vkb::initializers::descriptor_set_allocate_info(descriptor_pool, &descriptor_set_layout, 1);
 	VK_CHECK(vkAllocateDescriptorSets(get_device().get_handle(), &descriptor_set_allocate_info, &descriptor_set));
 
+	VkDescriptorImageInfo image_descriptor{};
+	image_descriptor.imageView   = storage_image.view;
+	image_descriptor.imageLayout = VK_IMAGE_LAYOUT_GENERAL;
+
+	VkDescriptorBufferInfo buffer_descriptor = create_descriptor(*ubo);
+
+	VkWriteDescriptorSet result_image_write   = vkb::initializers::write_descriptor_set(descriptor_set, VK_DESCRIPTOR_TYPE_STORAGE_IMAGE, 1, &image_descriptor);
+	VkWriteDescriptorSet uniform_buffer_write = vkb::initializers::write_descriptor_set(descriptor_set, VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, 2, &buffer_descriptor);
+
+	std::vector<VkWriteDescriptorSet> write_descriptor_sets = {
+	    result_image_write,
+	    uniform_buffer_write};
+	vkUpdateDescriptorSets(get_device().get_handle(), static_cast<uint32_t>(write_descriptor_sets.size()), write_descriptor_sets.data(), 0, VK_NULL_HANDLE);
+
+	update_acceleration_structure_descriptor();
+}
+
+/*
+	Write the top level acceleration structure to the descriptor set
+*/
+void RaytracingBasic::update_acceleration_structure_descriptor()
+{
+	VkAccelerationStructureKHR top_level_acceleration_structure = acceleration_structure_builder->get_top_level()->get_handle();
+
 	VkWriteDescriptorSetAccelerationStructureKHR descriptor_acceleration_structure_info{};
 	descriptor_acceleration_structure_info.sType                      = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET_ACCELERATION_STRUCTURE_KHR;
 	descriptor_acceleration_structure_info.accelerationStructureCount = 1;
@@ -495,20 +305,7 @@ void RaytracingBasic::create_descriptor_sets()
 	acceleration_structure_write.descriptorCount = 1;
 	acceleration_structure_write.descriptorType  = VK_DESCRIPTOR_TYPE_ACCELERATION_STRUCTURE_KHR;
 
-	VkDescriptorImageInfo image_descriptor{};
-	image_descriptor.imageView   = storage_image.view;
-	image_descriptor.imageLayout = VK_IMAGE_LAYOUT_GENERAL;
-
-	VkDescriptorBufferInfo buffer_descriptor = create_descriptor(*ubo);
-
-	VkWriteDescriptorSet result_image_write   = vkb::initializers::write_descriptor_set(descriptor_set, VK_DESCRIPTOR_TYPE_STORAGE_IMAGE, 1, &image_descriptor);
-	VkWriteDescriptorSet uniform_buffer_write = vkb::initializers::write_descriptor_set(descriptor_set, VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, 2, &buffer_descriptor);
-
-	std::vector<VkWriteDescriptorSet> write_descriptor_sets = {
-	    acceleration_structure_write,
-	    result_image_write,
-	    uniform_buffer_write};
-	vkUpdateDescriptorSets(get_device().get_handle(), static_cast<uint32_t>(write_descriptor_sets.size()), write_descriptor_sets.data(), 0, VK_NULL_HANDLE);
+	vkUpdateDescriptorSets(get_device().get_handle(), 1, &acceleration_structure_write, 0, VK_NULL_HANDLE);
 }
 
 /*
@@ -779,6 +576,8 @@ void RaytracingBasic::render(float delta_time)
 {
 	if (!prepared)
 		return;
+	// The previous frame completed, its reads of the top level acceleration structure are done
+	update_instances(delta_time);
 	draw();
 	if (camera.updated)
 		update_uniform_buffers();
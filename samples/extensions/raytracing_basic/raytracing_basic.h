@@ -32,46 +32,32 @@
 #pragma once
 
 #include "api_vulkan_sample.h"
+#include "rendering/acceleration_structure_builder.h"
+#include "scene_graph/components/sub_mesh.h"
 
 // Indices for the different ray tracing shader types used in this example
 #define INDEX_RAYGEN 0
 #define INDEX_CLOSEST_HIT 1
 #define INDEX_MISS 2
 
-// Holds data for a ray tracing scratch buffer that is used as a temporary storage
-struct RayTracingScratchBuffer
-{
-	vkb::Device &  device;
-	uint64_t       device_address = 0;
-	VkBuffer       buffer         = VK_NULL_HANDLE;
-	VkDeviceMemory memory         = VK_NULL_HANDLE;
-	RayTracingScratchBuffer(vkb::Device &device, VkAccelerationStructureKHR acceleration_structure);
-	~RayTracingScratchBuffer();
-};
-
-// Holds data for a memory object bound to an acceleration structure
-struct RayTracingObjectMemory
-{
-	vkb::Device &  device;
-	uint64_t       device_address = 0;
-	VkDeviceMemory memory         = VK_NULL_HANDLE;
-	RayTracingObjectMemory(vkb::Device &device, VkAccelerationStructureKHR acceleration_structure);
-};
-
 class RaytracingBasic : public ApiVulkanSample
 {
   public:
 	VkPhysicalDeviceRayTracingPropertiesKHR ray_tracing_properties{};
 	VkPhysicalDeviceRayTracingFeaturesKHR   ray_tracing_features{};
 
-	VkAccelerationStructureKHR bottom_level_acceleration_structure;
-	uint64_t                   bottom_level_acceleration_structure_handle = 0;
-	VkAccelerationStructureKHR top_level_acceleration_structure;
-	uint64_t                   top_level_acceleration_structure_handle = 0;
+	// The triangle the bottom level acceleration structure is built from
+	std::unique_ptr<vkb::sg::SubMesh> triangle;
+
+	// Builds the acceleration structures, and updates the top level one as the instances move
+	std::unique_ptr<vkb::AccelerationStructureBuilder> acceleration_structure_builder;
+
+	// Instances of the triangle in the top level acceleration structure
+	std::vector<uint32_t> instances;
+
+	// Time the instances have been rotating for
+	float animation_time{0.0f};
 
-	std::unique_ptr<vkb::core::Buffer> vertex_buffer;
-	std::unique_ptr<vkb::core::Buffer> index_buffer;
-	uint32_t                           index_count;
 	std::unique_ptr<vkb::core::Buffer> shader_binding_table;
 
 	struct StorageImage
@@ -100,11 +86,12 @@ class RaytracingBasic : public ApiVulkanSample
 	~RaytracingBasic();
 
 	void         request_gpu_features(vkb::PhysicalDevice &gpu) override;
-	uint64_t     get_buffer_device_address(VkBuffer buffer);
 	void         create_storage_image();
 	void         create_scene();
 	void         create_shader_binding_table();
 	void         create_descriptor_sets();
+	void         update_acceleration_structure_descriptor();
+	void         update_instances(float delta_time);
 	void         create_ray_tracing_pipeline();
 	void         create_uniform_buffer();
 	void         build_command_buffers() override;
@@ -66,7 +66,8 @@ bool AFBCSample::prepare(vkb::Platform &platform)
 
 	set_render_pipeline(std::move(render_pipeline));
 
-	stats->request_stats({vkb::StatIndex::gpu_ext_write_bytes});
+	stats->request_stats({vkb::StatIndex::gpu_ext_write_bytes,
+	                      vkb::StatIndex::estimated_ext_write_bytes});
 
 	gui = std::make_unique<vkb::Gui>(*this, platform.get_window(), stats.get());
 
@@ -20,6 +20,8 @@
 #include <algorithm>
 #include <numeric>
 
+#include <nlohmann/json.hpp>
+
 #include "core/device.h"
 #include "core/pipeline_layout.h"
 #include "core/shader_module.h"
@@ -52,11 +54,21 @@ CommandBufferUsage::CommandBufferUsage()
 
 bool CommandBufferUsage::prepare(vkb::Platform &platform)
 {
+	// The sweep reads the GPU time of the frames
+	const bool sweep = get_options().contains("--sweep");
+	if (sweep)
+	{
+		set_gpu_profiling(true);
+	}
+
 	if (!VulkanSample::prepare(platform))
 	{
 		return false;
 	}
 
+	// Secondary command buffers are recorded from several threads, so cache hits should not take a lock
+	device->get_resource_cache().set_concurrent_lookup(true);
+
 	load_scene("scenes/bonza/Bonza4X.gltf");
 
 	auto &camera_node = vkb::add_free_camera(*scene, "main_camera", get_render_context().get_surface_extent());
@@ -91,12 +103,143 @@ bool CommandBufferUsage::prepare(vkb::Platform &platform)
 	// Show number of opaque meshes in debug window
 	get_debug_info().insert<vkb::field::Static, uint32_t>("opaque_mesh_count", opaque_mesh_count);
 
+	if (sweep)
+	{
+		this->platform = &platform;
+		prepare_sweep(opaque_mesh_count);
+	}
+
 	return true;
 }
 
+void CommandBufferUsage::prepare_sweep(uint32_t opaque_mesh_count)
+{
+	// Thread counts double up to the maximum, which is always included
+	std::vector<uint32_t> thread_counts;
+	for (uint32_t thread_count = 1; thread_count < max_thread_count; thread_count *= 2)
+	{
+		thread_counts.push_back(thread_count);
+	}
+	thread_counts.push_back(max_thread_count);
+
+	// Secondary command buffer counts giving the draws per buffer, 0 draws per buffer meaning the primary command buffer only
+	std::vector<uint32_t> secondary_cmd_buf_counts;
+	for (uint32_t draws_per_buffer : {0u, 1u, 4u, 16u, 64u})
+	{
+		uint32_t count = 0;
+		if (draws_per_buffer > 0)
+		{
+			count = std::max(std::min((opaque_mesh_count + draws_per_buffer - 1) / draws_per_buffer, max_secondary_command_buffer_count), 1u);
+		}
+		if (std::find(secondary_cmd_buf_counts.begin(), secondary_cmd_buf_counts.end(), count) == secondary_cmd_buf_counts.end())
+		{
+			secondary_cmd_buf_counts.push_back(count);
+		}
+	}
+
+	for (auto reset_mode : {vkb::CommandBuffer::ResetMode::ResetPool, vkb::CommandBuffer::ResetMode::ResetIndividually, vkb::CommandBuffer::ResetMode::AlwaysAllocate})
+	{
+		for (uint32_t secondary_cmd_buf_count : secondary_cmd_buf_counts)
+		{
+			for (uint32_t thread_count : thread_counts)
+			{
+				// Without secondary command buffers there is nothing to record in other threads
+				if (secondary_cmd_buf_count == 0 && thread_count > 1)
+				{
+					break;
+				}
+
+				SweepPoint point;
+				point.thread_count            = thread_count;
+				point.reset_mode              = reset_mode;
+				point.secondary_cmd_buf_count = secondary_cmd_buf_count;
+				sweep_points.push_back(point);
+			}
+		}
+	}
+
+	LOGI("Sweeping {} configurations of command buffer recording", sweep_points.size());
+}
+
+void CommandBufferUsage::update_sweep(double record_time, double submit_time)
+{
+	auto &point = sweep_points[sweep_point_index];
+
+	if (sweep_frame_index >= SWEEP_WARMUP_FRAMES)
+	{
+		point.record_time += record_time / SWEEP_MEASURED_FRAMES;
+		point.submit_time += submit_time / SWEEP_MEASURED_FRAMES;
+
+		// Timestamps are read back from an older frame, recorded with the same point after the warmup
+		for (auto &timing : gpu_profiler->get_timings())
+		{
+			if (timing.depth == 0 && timing.name == "Frame")
+			{
+				point.gpu_time += timing.last_time / SWEEP_MEASURED_FRAMES;
+			}
+		}
+	}
+
+	if (++sweep_frame_index < SWEEP_WARMUP_FRAMES + SWEEP_MEASURED_FRAMES)
+	{
+		return;
+	}
+
+	sweep_frame_index = 0;
+	if (++sweep_point_index == sweep_points.size())
+	{
+		write_sweep();
+		sweep_points.clear();
+		platform->close();
+	}
+}
+
+void CommandBufferUsage::write_sweep() const
+{
+	auto reset_mode_name = [](vkb::CommandBuffer::ResetMode reset_mode) {
+		switch (reset_mode)
+		{
+			case vkb::CommandBuffer::ResetMode::ResetIndividually:
+				return "reset_buffer";
+			case vkb::CommandBuffer::ResetMode::AlwaysAllocate:
+				return "allocate_and_free";
+			default:
+				return "reset_pool";
+		}
+	};
+
+	nlohmann::json points = nlohmann::json::array();
+
+	const SweepPoint *fastest = nullptr;
+	for (auto &point : sweep_points)
+	{
+		points.push_back({{"threads", point.thread_count},
+		                  {"reset_mode", reset_mode_name(point.reset_mode)},
+		                  {"secondary_command_buffers", point.secondary_cmd_buf_count},
+		                  {"record_ms", point.record_time},
+		                  {"submit_ms", point.submit_time},
+		                  {"gpu_ms", point.gpu_time}});
+
+		if (!fastest || point.record_time + point.submit_time < fastest->record_time + fastest->submit_time)
+		{
+			fastest = &point;
+		}
+	}
+
+	nlohmann::json sweep = {{"warmup_frames", SWEEP_WARMUP_FRAMES},
+	                        {"measured_frames", SWEEP_MEASURED_FRAMES},
+	                        {"points", points}};
+
+	vkb::fs::write_json(sweep, "command_buffer_usage_sweep.json");
+
+	LOGI("Fastest recording: {} threads, {} secondary command buffers, {} ({:.3f} ms recording, {:.3f} ms submitting)",
+	     fastest->thread_count, fastest->secondary_cmd_buf_count, reset_mode_name(fastest->reset_mode), fastest->record_time, fastest->submit_time);
+}
+
 void CommandBufferUsage::prepare_render_context()
 {
 	max_thread_count = std::max(std::thread::hardware_concurrency(), MIN_THREAD_COUNT);
+	thread_limit     = max_thread_count;
 	get_render_context().prepare(max_thread_count);
 }
 
@@ -104,13 +247,24 @@ void CommandBufferUsage::update(float delta_time)
 {
 	auto &subpass_state = static_cast<ForwardSubpassSecondary *>(render_pipeline->get_active_subpass().get())->get_state();
 
+	const bool sweeping = !sweep_points.empty();
+	if (sweeping)
+	{
+		// The sweep point overrides the GUI
+		auto &point                   = sweep_points[sweep_point_index];
+		gui_secondary_cmd_buf_count   = static_cast<int>(point.secondary_cmd_buf_count);
+		gui_command_buffer_reset_mode = static_cast<int>(point.reset_mode);
+		gui_multi_threading           = point.thread_count > 1;
+		thread_limit                  = point.thread_count;
+	}
+
 	// Process GUI input
 	subpass_state.secondary_cmd_buf_count = vkb::to_u32(gui_secondary_cmd_buf_count);
 
 	use_secondary_command_buffers = subpass_state.secondary_cmd_buf_count > 0;
 
 	// If there are not enough command buffers to keep all threads busy, use fewer threads
-	subpass_state.thread_count = std::min(subpass_state.secondary_cmd_buf_count, max_thread_count);
+	subpass_state.thread_count = std::min(subpass_state.secondary_cmd_buf_count, thread_limit);
 
 	subpass_state.command_buffer_reset_mode = static_cast<vkb::CommandBuffer::ResetMode>(gui_command_buffer_reset_mode);
 
@@ -129,12 +283,31 @@ void CommandBufferUsage::update(float delta_time)
 	primary_command_buffer.begin(VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT);
 	stats->begin_sampling(primary_command_buffer);
 
-	draw(primary_command_buffer, render_context.get_active_frame().get_render_target());
+	if (gpu_profiler)
+	{
+		gpu_profiler->begin_frame(primary_command_buffer);
+	}
+
+	sweep_timer.start();
+
+	{
+		vkb::GpuProfiler::Scope scope{gpu_profiler.get(), primary_command_buffer, "Frame"};
+		draw(primary_command_buffer, render_context.get_active_frame().get_render_target());
+	}
+
+	const double record_time = sweep_timer.elapsed<vkb::Timer::Milliseconds>();
 
 	stats->end_sampling(primary_command_buffer);
 	primary_command_buffer.end();
 
 	render_context.submit(primary_command_buffer);
+
+	const double submit_time = sweep_timer.stop<vkb::Timer::Milliseconds>() - record_time;
+
+	if (sweeping)
+	{
+		update_sweep(record_time, submit_time);
+	}
 }
 
 void CommandBufferUsage::draw_gui()
@@ -286,27 +459,15 @@ vkb::CommandBuffer *CommandBufferUsage::ForwardSubpassSecondary::record_draw_sec
 }
 void CommandBufferUsage::ForwardSubpassSecondary::draw(vkb::CommandBuffer &primary_command_buffer)
 {
-	std::multimap<float, std::pair<vkb::sg::Node *, vkb::sg::SubMesh *>> opaque_nodes;
-
-	std::multimap<float, std::pair<vkb::sg::Node *, vkb::sg::SubMesh *>> transparent_nodes;
-
-	get_sorted_nodes(opaque_nodes, transparent_nodes);
-
-	// Sort opaque objects in front-to-back order
+	// Opaque objects are sorted in front-to-back order, transparent objects in back-to-front order
 	// Note: sorting objects does not help on PowerVR, so it can be avoided to save CPU cycles
 	std::vector<std::pair<vkb::sg::Node *, vkb::sg::SubMesh *>> sorted_opaque_nodes;
-	for (auto node_it = opaque_nodes.begin(); node_it != opaque_nodes.end(); node_it++)
-	{
-		sorted_opaque_nodes.push_back(node_it->second);
-	}
-	const auto opaque_submeshes = vkb::to_u32(sorted_opaque_nodes.size());
 
-	// Sort transparent objects in back-to-front order
 	std::vector<std::pair<vkb::sg::Node *, vkb::sg::SubMesh *>> sorted_transparent_nodes;
-	for (auto node_it = transparent_nodes.rbegin(); node_it != transparent_nodes.rend(); node_it++)
-	{
-		sorted_transparent_nodes.push_back(node_it->second);
-	}
+
+	get_sorted_nodes(sorted_opaque_nodes, sorted_transparent_nodes);
+
+	const auto opaque_submeshes      = vkb::to_u32(sorted_opaque_nodes.size());
 	const auto transparent_submeshes = vkb::to_u32(sorted_transparent_nodes.size());
 
 	light_buffer = allocate_lights<vkb::ForwardLights>(scene.get_components<vkb::sg::Light>(), MAX_FORWARD_LIGHT_COUNT);
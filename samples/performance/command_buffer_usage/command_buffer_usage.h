@@ -19,6 +19,8 @@
 
 #include <ctpl_stl.h>
 
+#include "timer.h"
+
 #include "buffer_pool.h"
 #include "common/utils.h"
 #include "rendering/render_pipeline.h"
@@ -134,6 +136,66 @@ class CommandBufferUsage : public vkb::VulkanSample
 
 	void draw_gui() override;
 
+	/**
+	 * @brief A configuration of the sweep, and its timings averaged over the measured frames
+	 */
+	struct SweepPoint
+	{
+		uint32_t thread_count{1};
+
+		vkb::CommandBuffer::ResetMode reset_mode{vkb::CommandBuffer::ResetMode::ResetPool};
+
+		/// Number of secondary command buffers for opaque meshes, 0 to record them in the primary command buffer
+		uint32_t secondary_cmd_buf_count{0};
+
+		/// CPU time recording the frame, in milliseconds
+		double record_time{0.0};
+
+		/// CPU time submitting the frame, in milliseconds
+		double submit_time{0.0};
+
+		/// GPU time of the frame, in milliseconds, 0 if the GPU timestamps are not supported
+		double gpu_time{0.0};
+	};
+
+	/**
+	 * @brief Builds the sweep over thread counts, reset modes and draws per secondary command buffer
+	 * @param opaque_mesh_count Number of opaque meshes divided between the secondary command buffers
+	 */
+	void prepare_sweep(uint32_t opaque_mesh_count);
+
+	/**
+	 * @brief Accumulates the timings of the frame into the current sweep point,
+	 *        moving to the next one once enough frames were measured
+	 */
+	void update_sweep(double record_time, double submit_time);
+
+	/**
+	 * @brief Writes the sweep results to a JSON file in the graphs directory and logs the fastest point
+	 */
+	void write_sweep() const;
+
+	/// Frames rendered with a sweep point before measuring it, so that frames in flight with the previous point retire
+	static constexpr uint32_t SWEEP_WARMUP_FRAMES{10};
+
+	/// Frames measured for each sweep point
+	static constexpr uint32_t SWEEP_MEASURED_FRAMES{30};
+
+	/// Points of the sweep, empty unless running with --sweep
+	std::vector<SweepPoint> sweep_points;
+
+	/// Index of the sweep point being rendered
+	size_t sweep_point_index{0};
+
+	/// Frames rendered with the current sweep point
+	uint32_t sweep_frame_index{0};
+
+	/// Platform closed once the sweep is over
+	vkb::Platform *platform{nullptr};
+
+	/// Measures the CPU time of recording and submitting the frames of the sweep
+	vkb::Timer sweep_timer;
+
 	int gui_secondary_cmd_buf_count{0};
 
 	uint32_t max_secondary_command_buffer_count{100};
@@ -147,6 +209,9 @@ class CommandBufferUsage : public vkb::VulkanSample
 	const uint32_t MIN_THREAD_COUNT{4};
 
 	uint32_t max_thread_count{0};
+
+	/// Maximum number of threads used for recording, lower than max_thread_count while sweeping
+	uint32_t thread_limit{0};
 };
 
 std::unique_ptr<vkb::VulkanSample> create_command_buffer_usage();
@@ -0,0 +1,495 @@
+/* Copyright (c) 2020, Arm Limited and Contributors
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 the "License";
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "compute_primitives.h"
+
+#include <algorithm>
+#include <numeric>
+#include <random>
+
+#include "common/logging.h"
+#include "common/vk_common.h"
+#include "glsl_compiler.h"
+#include "gui.h"
+#include "platform/platform.h"
+#include "rendering/render_pipeline.h"
+#include "scene_graph/scene.h"
+#include "stats/stats.h"
+
+namespace
+{
+const char *primitive_names[] = {"Scan", "Reduction", "Compaction", "Radix sort"};
+
+const uint32_t element_counts[] = {64 * 1024, 256 * 1024, 1024 * 1024, 4 * 1024 * 1024};
+
+const char *element_count_names[] = {"64K", "256K", "1M", "4M"};
+
+constexpr uint32_t MAX_ELEMENT_COUNT = 4 * 1024 * 1024;
+
+enum Primitive
+{
+	SCAN,
+	REDUCTION,
+	COMPACTION,
+	RADIX_SORT
+};
+
+std::unique_ptr<vkb::core::Buffer> create_buffer(vkb::Device &device, VkBufferUsageFlags usage, VmaMemoryUsage memory_usage)
+{
+	return std::make_unique<vkb::core::Buffer>(device, MAX_ELEMENT_COUNT * sizeof(uint32_t), usage, memory_usage);
+}
+
+void buffer_barrier(vkb::CommandBuffer &command_buffer, const vkb::core::Buffer &buffer,
+                    VkPipelineStageFlags src_stage_mask, VkAccessFlags src_access_mask,
+                    VkPipelineStageFlags dst_stage_mask, VkAccessFlags dst_access_mask)
+{
+	vkb::BufferMemoryBarrier barrier;
+	barrier.src_stage_mask  = src_stage_mask;
+	barrier.dst_stage_mask  = dst_stage_mask;
+	barrier.src_access_mask = src_access_mask;
+	barrier.dst_access_mask = dst_access_mask;
+
+	command_buffer.buffer_memory_barrier(buffer, 0, VK_WHOLE_SIZE, barrier);
+}
+}        // namespace
+
+ComputePrimitives::ComputePrimitives()
+{
+	// Subgroup arithmetic needs Vulkan 1.1
+	set_api_version(VK_API_VERSION_1_1);
+	set_gpu_profiling(true);
+
+	auto &config = get_configuration();
+
+	for (int i = 0; i < 4; ++i)
+	{
+		config.insert<vkb::IntSetting>(i, selected_primitive, i);
+	}
+}
+
+ComputePrimitives::~ComputePrimitives()
+{
+	if (device)
+	{
+		device->wait_idle();
+	}
+
+	vkb::GLSLCompiler::reset_target_environment();
+}
+
+bool ComputePrimitives::prepare(vkb::Platform &platform)
+{
+	if (!VulkanSample::prepare(platform))
+	{
+		return false;
+	}
+
+	// Subgroup operations are only available to shaders compiled for SPIR-V 1.3
+	if (instance->get_api_version() >= VK_API_VERSION_1_1 && get_device().get_gpu().get_properties().apiVersion >= VK_API_VERSION_1_1)
+	{
+		vkb::GLSLCompiler::set_target_environment(glslang::EShTargetSpv, glslang::EShTargetSpv_1_3);
+	}
+
+	scan       = std::make_unique<vkb::GpuScan>(get_device(), MAX_ELEMENT_COUNT);
+	reduction  = std::make_unique<vkb::GpuReduction>(get_device(), MAX_ELEMENT_COUNT);
+	compaction = std::make_unique<vkb::GpuCompaction>(get_device(), MAX_ELEMENT_COUNT);
+	radix_sort = std::make_unique<vkb::GpuRadixSort>(get_device(), MAX_ELEMENT_COUNT);
+
+	LOGI("Compute primitives {} subgroup arithmetic", scan->uses_subgroups() ? "use" : "do not use");
+
+	create_data();
+
+	// The sample has no scene, only the GUI is drawn
+	scene = std::make_unique<vkb::sg::Scene>();
+
+	vkb::RenderPipeline render_pipeline;
+	render_pipeline.add_subpass(std::make_unique<PrimitiveSubpass>(get_render_context(), *this));
+	set_render_pipeline(std::move(render_pipeline));
+
+	stats->request_stats({vkb::StatIndex::frame_times});
+	gui = std::make_unique<vkb::Gui>(*this, platform.get_window(), stats.get());
+
+	return true;
+}
+
+void ComputePrimitives::create_data()
+{
+	std::mt19937                            generator{1234};
+	std::uniform_int_distribution<uint32_t> value_distribution{0, 255};
+	std::uniform_int_distribution<uint32_t> flag_distribution{0, 1};
+	std::uniform_int_distribution<uint32_t> key_distribution;
+
+	input_data.resize(MAX_ELEMENT_COUNT);
+	flag_data.resize(MAX_ELEMENT_COUNT);
+	key_data.resize(MAX_ELEMENT_COUNT);
+
+	std::vector<uint32_t> index_data(MAX_ELEMENT_COUNT);
+
+	for (uint32_t i = 0; i < MAX_ELEMENT_COUNT; ++i)
+	{
+		input_data[i] = value_distribution(generator);
+		flag_data[i]  = flag_distribution(generator);
+		key_data[i]   = key_distribution(generator);
+		index_data[i] = i;
+	}
+
+	auto &device = get_device();
+
+	VkBufferUsageFlags usage = VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_SRC_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT;
+
+	input              = create_buffer(device, usage, VMA_MEMORY_USAGE_GPU_ONLY);
+	flags              = create_buffer(device, usage, VMA_MEMORY_USAGE_GPU_ONLY);
+	unsorted_keys      = create_buffer(device, usage, VMA_MEMORY_USAGE_GPU_ONLY);
+	unsorted_values    = create_buffer(device, usage, VMA_MEMORY_USAGE_GPU_ONLY);
+	keys               = create_buffer(device, usage, VMA_MEMORY_USAGE_GPU_ONLY);
+	values             = create_buffer(device, usage, VMA_MEMORY_USAGE_GPU_ONLY);
+	result             = create_buffer(device, usage, VMA_MEMORY_USAGE_GPU_ONLY);
+	result_count       = std::make_unique<vkb::core::Buffer>(device, sizeof(uint32_t), usage, VMA_MEMORY_USAGE_GPU_ONLY);
+	readback           = create_buffer(device, VK_BUFFER_USAGE_TRANSFER_DST_BIT, VMA_MEMORY_USAGE_GPU_TO_CPU);
+	readback_auxiliary = create_buffer(device, VK_BUFFER_USAGE_TRANSFER_DST_BIT, VMA_MEMORY_USAGE_GPU_TO_CPU);
+
+	std::vector<vkb::core::Buffer> staging_buffers;
+
+	auto &queue = device.get_queue_by_flags(VK_QUEUE_GRAPHICS_BIT, 0);
+
+	auto &command_buffer = device.request_command_buffer();
+
+	command_buffer.begin(VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT);
+
+	auto upload = [&](vkb::core::Buffer &buffer, std::vector<uint32_t> &data) {
+		vkb::core::Buffer staging_buffer{device, data.size() * sizeof(uint32_t), VK_BUFFER_USAGE_TRANSFER_SRC_BIT, VMA_MEMORY_USAGE_CPU_ONLY};
+		staging_buffer.update(data.data(), data.size() * sizeof(uint32_t));
+
+		command_buffer.copy_buffer(staging_buffer, buffer, data.size() * sizeof(uint32_t));
+
+		buffer_barrier(command_buffer, buffer,
+		               VK_PIPELINE_STAGE_TRANSFER_BIT, VK_ACCESS_TRANSFER_WRITE_BIT,
+		               VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT | VK_PIPELINE_STAGE_TRANSFER_BIT, VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_TRANSFER_READ_BIT);
+
+		staging_buffers.push_back(std::move(staging_buffer));
+	};
+
+	upload(*input, input_data);
+	upload(*flags, flag_data);
+	upload(*unsorted_keys, key_data);
+	upload(*unsorted_values, index_data);
+
+	command_buffer.end();
+
+	auto &fence_pool = device.get_transient_fence_pool();
+
+	VkFence fence = fence_pool.request_fence();
+
+	queue.submit(command_buffer, fence);
+
+	VK_CHECK(fence_pool.wait(fence));
+
+	device.get_command_pool().reset_pool();
+}
+
+void ComputePrimitives::record_primitive(vkb::CommandBuffer &command_buffer)
+{
+	uint32_t count = element_counts[selected_count];
+
+	vkb::GpuProfiler::Scope scope{get_render_context().get_gpu_profiler(), command_buffer, primitive_names[selected_primitive]};
+
+	switch (selected_primitive)
+	{
+		case SCAN:
+			scan->record(command_buffer, *input, *result, count);
+			break;
+		case REDUCTION:
+			reduction->record(command_buffer, *input, *result, count);
+			break;
+		case COMPACTION:
+			compaction->record(command_buffer, *input, *flags, *result, *result_count, count);
+			break;
+		default:
+			radix_sort->record(command_buffer, *keys, values.get(), count);
+			break;
+	}
+}
+
+void ComputePrimitives::record_readback(vkb::CommandBuffer &command_buffer)
+{
+	uint32_t count = element_counts[selected_count];
+
+	const vkb::core::Buffer *source           = result.get();
+	const vkb::core::Buffer *auxiliary_source = nullptr;
+	VkDeviceSize             auxiliary_size   = 0;
+
+	if (selected_primitive == COMPACTION)
+	{
+		auxiliary_source = result_count.get();
+		auxiliary_size   = sizeof(uint32_t);
+	}
+	else if (selected_primitive == RADIX_SORT)
+	{
+		source           = keys.get();
+		auxiliary_source = values.get();
+		auxiliary_size   = count * sizeof(uint32_t);
+	}
+
+	buffer_barrier(command_buffer, *source,
+	               VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_ACCESS_SHADER_WRITE_BIT,
+	               VK_PIPELINE_STAGE_TRANSFER_BIT, VK_ACCESS_TRANSFER_READ_BIT);
+
+	if (auxiliary_source)
+	{
+		buffer_barrier(command_buffer, *auxiliary_source,
+		               VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_ACCESS_SHADER_WRITE_BIT,
+		               VK_PIPELINE_STAGE_TRANSFER_BIT, VK_ACCESS_TRANSFER_READ_BIT);
+	}
+
+	command_buffer.copy_buffer(*source, *readback, count * sizeof(uint32_t));
+
+	buffer_barrier(command_buffer, *readback,
+	               VK_PIPELINE_STAGE_TRANSFER_BIT, VK_ACCESS_TRANSFER_WRITE_BIT,
+	               VK_PIPELINE_STAGE_HOST_BIT, VK_ACCESS_HOST_READ_BIT);
+
+	if (auxiliary_source)
+	{
+		command_buffer.copy_buffer(*auxiliary_source, *readback_auxiliary, auxiliary_size);
+
+		buffer_barrier(command_buffer, *readback_auxiliary,
+		               VK_PIPELINE_STAGE_TRANSFER_BIT, VK_ACCESS_TRANSFER_WRITE_BIT,
+		               VK_PIPELINE_STAGE_HOST_BIT, VK_ACCESS_HOST_READ_BIT);
+	}
+
+	validated_primitive = selected_primitive;
+	validated_count     = count;
+}
+
+void ComputePrimitives::update(float delta_time)
+{
+	VulkanSample::update(delta_time);
+
+	if (validation_recorded)
+	{
+		validation_recorded = false;
+
+		get_device().wait_idle();
+
+		auto mismatch     = validate();
+		validation_status = mismatch.empty() ? std::string{primitive_names[validated_primitive]} + " matches the CPU" : mismatch;
+
+		LOGI("Validation: {}", validation_status);
+	}
+}
+
+std::string ComputePrimitives::validate()
+{
+	auto allocator = get_device().get_memory_allocator();
+
+	vmaInvalidateAllocation(allocator, readback->get_allocation(), 0, VK_WHOLE_SIZE);
+	vmaInvalidateAllocation(allocator, readback_auxiliary->get_allocation(), 0, VK_WHOLE_SIZE);
+
+	auto gpu_result    = reinterpret_cast<const uint32_t *>(readback->map());
+	auto gpu_auxiliary = reinterpret_cast<const uint32_t *>(readback_auxiliary->map());
+
+	auto mismatch = [](const char *what, size_t index, uint32_t expected, uint32_t value) {
+		return fmt::format("{} {} is {}, expected {}", what, index, value, expected);
+	};
+
+	std::string status;
+
+	switch (validated_primitive)
+	{
+		case SCAN:
+		{
+			uint32_t sum = 0;
+
+			for (uint32_t i = 0; i < validated_count && status.empty(); ++i)
+			{
+				if (gpu_result[i] != sum)
+				{
+					status = mismatch("Prefix sum", i, sum, gpu_result[i]);
+				}
+				sum += input_data[i];
+			}
+			break;
+		}
+		case REDUCTION:
+		{
+			uint32_t sum = std::accumulate(input_data.begin(), input_data.begin() + validated_count, 0U);
+
+			if (gpu_result[0] != sum)
+			{
+				status = mismatch("Sum", 0, sum, gpu_result[0]);
+			}
+			break;
+		}
+		case COMPACTION:
+		{
+			uint32_t kept = 0;
+
+			for (uint32_t i = 0; i < validated_count && status.empty(); ++i)
+			{
+				if (flag_data[i] != 0)
+				{
+					if (gpu_result[kept] != input_data[i])
+					{
+						status = mismatch("Kept value", kept, input_data[i], gpu_result[kept]);
+					}
+					++kept;
+				}
+			}
+
+			if (status.empty() && gpu_auxiliary[0] != kept)
+			{
+				status = mismatch("Count", 0, kept, gpu_auxiliary[0]);
+			}
+			break;
+		}
+		default:
+		{
+			// The sort is stable, so the sorted indices are unique
+			std::vector<uint32_t> indices(validated_count);
+			std::iota(indices.begin(), indices.end(), 0U);
+			std::stable_sort(indices.begin(), indices.end(), [this](uint32_t a, uint32_t b) { return key_data[a] < key_data[b]; });
+
+			for (uint32_t i = 0; i < validated_count && status.empty(); ++i)
+			{
+				if (gpu_result[i] != key_data[indices[i]])
+				{
+					status = mismatch("Key", i, key_data[indices[i]], gpu_result[i]);
+				}
+				else if (gpu_auxiliary[i] != indices[i])
+				{
+					status = mismatch("Value", i, indices[i], gpu_auxiliary[i]);
+				}
+			}
+			break;
+		}
+	}
+
+	readback->unmap();
+	readback_auxiliary->unmap();
+
+	return status;
+}
+
+void ComputePrimitives::draw_gui()
+{
+	float time = 0.0f;
+
+	if (auto profiler = get_render_context().get_gpu_profiler())
+	{
+		for (auto &timing : profiler->get_timings())
+		{
+			if (timing.name == primitive_names[selected_primitive])
+			{
+				time = timing.time;
+			}
+		}
+	}
+
+	gui->show_options_window(
+	    /* body = */ [&]() {
+		    for (int i = 0; i < 4; ++i)
+		    {
+			    if (i > 0)
+			    {
+				    ImGui::SameLine();
+			    }
+			    ImGui::RadioButton(primitive_names[i], &selected_primitive, i);
+		    }
+
+		    for (int i = 0; i < 4; ++i)
+		    {
+			    if (i > 0)
+			    {
+				    ImGui::SameLine();
+			    }
+			    ImGui::RadioButton(element_count_names[i], &selected_count, i);
+		    }
+
+		    if (time > 0.0f)
+		    {
+			    // Elements per millisecond to millions of elements per second
+			    ImGui::Text("%.3f ms, %.0f M elements/s, %s subgroups", time, element_counts[selected_count] / (time * 1000.0f),
+			                scan->uses_subgroups() ? "with" : "without");
+		    }
+		    else
+		    {
+			    ImGui::Text("GPU time not available, %s subgroups", scan->uses_subgroups() ? "with" : "without");
+		    }
+
+		    if (ImGui::Button("Validate"))
+		    {
+			    validation_requested = true;
+		    }
+		    ImGui::SameLine();
+		    ImGui::Text("%s", validation_status.c_str());
+	    },
+	    /* lines = */ 4);
+}
+
+ComputePrimitives::PrimitiveSubpass::PrimitiveSubpass(vkb::RenderContext &render_context, ComputePrimitives &sample) :
+    vkb::Subpass{render_context, vkb::ShaderSource{}, vkb::ShaderSource{}},
+    sample{sample}
+{
+}
+
+void ComputePrimitives::PrimitiveSubpass::prepare()
+{
+}
+
+void ComputePrimitives::PrimitiveSubpass::pre_draw(vkb::CommandBuffer &command_buffer)
+{
+	uint32_t count = element_counts[sample.selected_count];
+
+	if (sample.selected_primitive == RADIX_SORT)
+	{
+		// The sort is in place, start from the unsorted keys and values every frame
+		buffer_barrier(command_buffer, *sample.keys,
+		               VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT | VK_PIPELINE_STAGE_TRANSFER_BIT, VK_ACCESS_SHADER_WRITE_BIT,
+		               VK_PIPELINE_STAGE_TRANSFER_BIT, VK_ACCESS_TRANSFER_WRITE_BIT);
+		buffer_barrier(command_buffer, *sample.values,
+		               VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT | VK_PIPELINE_STAGE_TRANSFER_BIT, VK_ACCESS_SHADER_WRITE_BIT,
+		               VK_PIPELINE_STAGE_TRANSFER_BIT, VK_ACCESS_TRANSFER_WRITE_BIT);
+
+		command_buffer.copy_buffer(*sample.unsorted_keys, *sample.keys, count * sizeof(uint32_t));
+		command_buffer.copy_buffer(*sample.unsorted_values, *sample.values, count * sizeof(uint32_t));
+
+		buffer_barrier(command_buffer, *sample.keys,
+		               VK_PIPELINE_STAGE_TRANSFER_BIT, VK_ACCESS_TRANSFER_WRITE_BIT,
+		               VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT);
+		buffer_barrier(command_buffer, *sample.values,
+		               VK_PIPELINE_STAGE_TRANSFER_BIT, VK_ACCESS_TRANSFER_WRITE_BIT,
+		               VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT);
+	}
+
+	sample.record_primitive(command_buffer);
+
+	if (sample.validation_requested)
+	{
+		sample.validation_requested = false;
+		sample.validation_recorded  = true;
+
+		sample.record_readback(command_buffer);
+	}
+}
+
+void ComputePrimitives::PrimitiveSubpass::draw(vkb::CommandBuffer &command_buffer)
+{
+}
+
+std::unique_ptr<vkb::VulkanSample> create_compute_primitives()
+{
+	return std::make_unique<ComputePrimitives>();
+}
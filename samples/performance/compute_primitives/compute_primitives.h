@@ -0,0 +1,143 @@
+/* Copyright (c) 2020, Arm Limited and Contributors
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 the "License";
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "rendering/compute_primitives.h"
+#include "rendering/subpass.h"
+#include "vulkan_sample.h"
+
+/**
+ * @brief Benchmarks the compute primitives of the framework over a number of elements,
+ *        and validates their results against a CPU reference
+ */
+class ComputePrimitives : public vkb::VulkanSample
+{
+  public:
+	ComputePrimitives();
+
+	virtual ~ComputePrimitives();
+
+	virtual bool prepare(vkb::Platform &platform) override;
+
+	virtual void update(float delta_time) override;
+
+	/**
+	 * @brief Records the selected primitive before the render pass, which only draws the GUI
+	 */
+	class PrimitiveSubpass : public vkb::Subpass
+	{
+	  public:
+		PrimitiveSubpass(vkb::RenderContext &render_context, ComputePrimitives &sample);
+
+		virtual void prepare() override;
+
+		virtual void pre_draw(vkb::CommandBuffer &command_buffer) override;
+
+		virtual void draw(vkb::CommandBuffer &command_buffer) override;
+
+	  private:
+		ComputePrimitives &sample;
+	};
+
+  private:
+	/**
+	 * @brief Creates the input buffers from random data, kept for the CPU reference
+	 */
+	void create_data();
+
+	/**
+	 * @brief Records the selected primitive over the selected number of elements
+	 */
+	void record_primitive(vkb::CommandBuffer &command_buffer);
+
+	/**
+	 * @brief Copies the results of the primitive to the readback buffers
+	 */
+	void record_readback(vkb::CommandBuffer &command_buffer);
+
+	/**
+	 * @brief Compares the read back results with the CPU reference
+	 * @return A description of the first mismatch, or an empty string if the results match
+	 */
+	std::string validate();
+
+	virtual void draw_gui() override;
+
+	/// Index of the primitive recorded each frame
+	int selected_primitive{0};
+
+	/// Index of the number of elements
+	int selected_count{2};
+
+	std::unique_ptr<vkb::GpuScan> scan;
+
+	std::unique_ptr<vkb::GpuReduction> reduction;
+
+	std::unique_ptr<vkb::GpuCompaction> compaction;
+
+	std::unique_ptr<vkb::GpuRadixSort> radix_sort;
+
+	/// Values scanned, reduced and compacted
+	std::vector<uint32_t> input_data;
+
+	/// 1 for the values kept by the compaction, 0 for the others
+	std::vector<uint32_t> flag_data;
+
+	/// Keys sorted, with their indices as values
+	std::vector<uint32_t> key_data;
+
+	std::unique_ptr<vkb::core::Buffer> input;
+
+	std::unique_ptr<vkb::core::Buffer> flags;
+
+	/// Unsorted keys and values, copied to the sorted buffers every frame
+	std::unique_ptr<vkb::core::Buffer> unsorted_keys;
+
+	std::unique_ptr<vkb::core::Buffer> unsorted_values;
+
+	std::unique_ptr<vkb::core::Buffer> keys;
+
+	std::unique_ptr<vkb::core::Buffer> values;
+
+	std::unique_ptr<vkb::core::Buffer> result;
+
+	std::unique_ptr<vkb::core::Buffer> result_count;
+
+	/// Result or sorted keys of the validated frame
+	std::unique_ptr<vkb::core::Buffer> readback;
+
+	/// Sorted values or compaction count of the validated frame
+	std::unique_ptr<vkb::core::Buffer> readback_auxiliary;
+
+	bool validation_requested{false};
+
+	/// Whether the last recorded frame copied its results to the readback buffers
+	bool validation_recorded{false};
+
+	int validated_primitive{0};
+
+	uint32_t validated_count{0};
+
+	std::string validation_status;
+};
+
+std::unique_ptr<vkb::VulkanSample> create_compute_primitives();
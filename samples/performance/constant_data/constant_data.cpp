@@ -355,10 +355,8 @@ void ConstantData::DescriptorSetSubpass::update_uniform(vkb::CommandBuffer &comm
 
 	mvp = fill_mvp(node, camera);
 
-	// Ensure the container doesn't hold more bytes than are needed
-	auto data = vkb::to_bytes(mvp);
-	data.resize(struct_size);
-	allocation.update(data);
+	// Only upload the bytes that are needed
+	allocation.update(reinterpret_cast<const uint8_t *>(&mvp), struct_size);
 
 	command_buffer.bind_buffer(allocation.get_buffer(), allocation.get_offset(), allocation.get_size(), 0, 1, 0);
 }
@@ -490,7 +488,8 @@ void ConstantData::BufferArraySubpass::draw_submesh_command(vkb::CommandBuffer &
 	if (sub_mesh.vertex_indices != 0)
 	{
 		// Bind index buffer of submesh
-		command_buffer.bind_index_buffer(*sub_mesh.index_buffer, sub_mesh.index_offset, sub_mesh.index_type);
+		auto index_buffer = sub_mesh.get_index_buffer();
+		command_buffer.bind_index_buffer(*index_buffer.buffer, index_buffer.offset + sub_mesh.index_offset, sub_mesh.index_type);
 
 		command_buffer.draw_indexed(sub_mesh.vertex_indices, 1, 0, 0, instance_index++);
 	}
@@ -58,7 +58,7 @@ bool DescriptorManagement::prepare(vkb::Platform &platform)
 	set_render_pipeline(std::move(render_pipeline));
 
 	// Add a GUI with the stats you want to monitor
-	stats->request_stats({vkb::StatIndex::frame_times});
+	stats->request_stats({vkb::StatIndex::frame_times, vkb::StatIndex::descriptor_set_cache_hit_rate, vkb::StatIndex::buffer_block_requests});
 	gui = std::make_unique<vkb::Gui>(*this, platform.get_window(), stats.get());
 
 	return true;
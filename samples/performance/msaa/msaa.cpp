@@ -127,7 +127,9 @@ bool MSAASample::prepare(vkb::Platform &platform)
 
 	stats->request_stats({vkb::StatIndex::frame_times,
 	                      vkb::StatIndex::gpu_ext_read_bytes,
-	                      vkb::StatIndex::gpu_ext_write_bytes});
+	                      vkb::StatIndex::gpu_ext_write_bytes,
+	                      vkb::StatIndex::estimated_ext_read_bytes,
+	                      vkb::StatIndex::estimated_ext_write_bytes});
 
 	gui = std::make_unique<vkb::Gui>(*this, platform.get_window(), stats.get());
 
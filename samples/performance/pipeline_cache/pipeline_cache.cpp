@@ -167,8 +167,21 @@ void PipelineCache::draw_gui()
 		    {
 			    ImGui::Text("Pipeline rebuild frame time: N/A");
 		    }
+
+		    // Pipelines missing the driver cache were compiled from scratch
+		    auto creation_stats = device->get_resource_cache().get_pipeline_creation_stats();
+		    if (creation_stats.feedback_count > 0)
+		    {
+			    ImGui::Text("Pipeline cache hits: %u/%u, creation: %.1f ms (slowest %.1f ms)",
+			                creation_stats.cache_hits, creation_stats.feedback_count, creation_stats.total_duration, creation_stats.max_duration);
+		    }
+		    else
+		    {
+			    ImGui::Text("Pipeline cache hits: N/A, creation: %.1f ms (slowest %.1f ms)",
+			                creation_stats.total_duration, creation_stats.max_duration);
+		    }
 	    },
-	    /* lines = */ 2);
+	    /* lines = */ 3);
 }
 
 void PipelineCache::update(float delta_time)
@@ -34,21 +34,29 @@ RenderSubpasses::RenderSubpasses()
 	config.insert<vkb::IntSetting>(0, configs[Config::RenderTechnique].value, 0);
 	config.insert<vkb::IntSetting>(0, configs[Config::TransientAttachments].value, 0);
 	config.insert<vkb::IntSetting>(0, configs[Config::GBufferSize].value, 0);
+	config.insert<vkb::IntSetting>(0, configs[Config::LightClustering].value, 0);
+	config.insert<vkb::IntSetting>(0, configs[Config::ShadingRate].value, 0);
 
 	// Use two render passes
 	config.insert<vkb::IntSetting>(1, configs[Config::RenderTechnique].value, 1);
 	config.insert<vkb::IntSetting>(1, configs[Config::TransientAttachments].value, 0);
 	config.insert<vkb::IntSetting>(1, configs[Config::GBufferSize].value, 0);
+	config.insert<vkb::IntSetting>(1, configs[Config::LightClustering].value, 0);
+	config.insert<vkb::IntSetting>(1, configs[Config::ShadingRate].value, 0);
 
 	// Disable transient attachments
 	config.insert<vkb::IntSetting>(2, configs[Config::RenderTechnique].value, 0);
 	config.insert<vkb::IntSetting>(2, configs[Config::TransientAttachments].value, 1);
 	config.insert<vkb::IntSetting>(2, configs[Config::GBufferSize].value, 0);
+	config.insert<vkb::IntSetting>(2, configs[Config::LightClustering].value, 0);
+	config.insert<vkb::IntSetting>(2, configs[Config::ShadingRate].value, 0);
 
 	// Increase G-buffer size
 	config.insert<vkb::IntSetting>(3, configs[Config::RenderTechnique].value, 0);
 	config.insert<vkb::IntSetting>(3, configs[Config::TransientAttachments].value, 0);
 	config.insert<vkb::IntSetting>(3, configs[Config::GBufferSize].value, 1);
+	config.insert<vkb::IntSetting>(3, configs[Config::LightClustering].value, 0);
+	config.insert<vkb::IntSetting>(3, configs[Config::ShadingRate].value, 0);
 }
 
 std::unique_ptr<vkb::RenderTarget> RenderSubpasses::create_render_target(vkb::core::Image &&swapchain_image)
@@ -181,6 +189,31 @@ void RenderSubpasses::update(float delta_time)
 		}
 	}
 
+	// Check whether the user changed where the lights are clustered or the shading rate of the lighting
+	if (configs[Config::LightClustering].value != last_light_clustering ||
+	    configs[Config::ShadingRate].value != last_shading_rate)
+	{
+		LOGI("Changing lighting subpass");
+		last_light_clustering = configs[Config::LightClustering].value;
+		last_shading_rate     = configs[Config::ShadingRate].value;
+
+		if (last_shading_rate != 0 && !get_device().is_enabled(VK_KHR_FRAGMENT_SHADING_RATE_EXTENSION_NAME))
+		{
+			LOGW("Fragment shading rate is not supported, pixels are shaded at full rate");
+		}
+
+		get_device().wait_idle();
+
+		// Reset frames, their synchronization objects and their command buffers
+		for (auto &frame : get_render_context().get_render_frames())
+		{
+			frame->reset();
+		}
+
+		render_pipeline          = create_one_renderpass_two_subpasses();
+		lighting_render_pipeline = create_lighting_renderpass();
+	}
+
 	// Check whether the user switched the attachment or the G-buffer option
 	if (configs[Config::TransientAttachments].value != last_transient_attachment ||
 	    configs[Config::GBufferSize].value != last_g_buffer_size)
@@ -279,6 +312,20 @@ void RenderSubpasses::draw_gui()
 	    /* lines = */ vkb::to_u32(lines));
 }
 
+void RenderSubpasses::configure_lighting_subpass(vkb::LightingSubpass &lighting_subpass)
+{
+	// The async compute option falls back to the graphics queue when there is no separate compute queue family
+	lighting_subpass.set_clustered_lighting(configs[Config::LightClustering].value != 0);
+	lighting_subpass.set_async_light_clustering(configs[Config::LightClustering].value == 2);
+
+	// Lighting is fragment bound, a coarser rate shades a single pixel per fragment of 2x2 or 4x4 pixels
+	uint32_t fragment_size = 1u << configs[Config::ShadingRate].value;
+
+	vkb::FragmentShadingRateState shading_rate_state{};
+	shading_rate_state.fragment_size = {fragment_size, fragment_size};
+	lighting_subpass.set_fragment_shading_rate_state(shading_rate_state);
+}
+
 std::unique_ptr<vkb::RenderPipeline> RenderSubpasses::create_one_renderpass_two_subpasses()
 {
 	// Geometry subpass
@@ -297,6 +344,8 @@ std::unique_ptr<vkb::RenderPipeline> RenderSubpasses::create_one_renderpass_two_
 	// Inputs are depth, albedo, and normal from the geometry subpass
 	lighting_subpass->set_input_attachments({1, 2, 3});
 
+	configure_lighting_subpass(*lighting_subpass);
+
 	// Create subpasses pipeline
 	std::vector<std::unique_ptr<vkb::Subpass>> subpasses{};
 	subpasses.push_back(std::move(scene_subpass));
@@ -343,6 +392,9 @@ std::unique_ptr<vkb::RenderPipeline> RenderSubpasses::create_lighting_renderpass
 
 	// Inputs are depth, albedo, and normal from the geometry subpass
 	lighting_subpass->set_input_attachments({1, 2, 3});
+
+	configure_lighting_subpass(*lighting_subpass);
+
 	// Create lighting pipeline
 	std::vector<std::unique_ptr<vkb::Subpass>> lighting_subpasses{};
 	lighting_subpasses.push_back(std::move(lighting_subpass));
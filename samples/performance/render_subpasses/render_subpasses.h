@@ -21,6 +21,11 @@
 #include "scene_graph/components/perspective_camera.h"
 #include "vulkan_sample.h"
 
+namespace vkb
+{
+class LightingSubpass;
+}        // namespace vkb
+
 /**
   * @brief The RenderSubpasses sample shows how a significant amount of bandwidth
   *        (L2 cache ext reads and writes) can be saved, by using sub-passes instead
@@ -59,6 +64,11 @@ class RenderSubpasses : public vkb::VulkanSample
 	 */
 	std::unique_ptr<vkb::RenderPipeline> create_lighting_renderpass();
 
+	/**
+	 * @brief Enables clustered lighting on the graphics or the async compute queue, and sets the shading rate, as configured
+	 */
+	void configure_lighting_subpass(vkb::LightingSubpass &lighting_subpass);
+
 	/**
 	 * @brief Draws using the good pipeline: one render pass with two sub-passes
 	 */
@@ -97,7 +107,9 @@ class RenderSubpasses : public vkb::VulkanSample
 		{
 			RenderTechnique,
 			TransientAttachments,
-			GBufferSize
+			GBufferSize,
+			LightClustering,
+			ShadingRate
 		} type;
 
 		/// Used as label by the GUI
@@ -113,6 +125,8 @@ class RenderSubpasses : public vkb::VulkanSample
 	uint16_t last_render_technique{0};
 	uint16_t last_transient_attachment{0};
 	uint16_t last_g_buffer_size{0};
+	uint16_t last_light_clustering{0};
+	uint16_t last_shading_rate{0};
 
 	VkFormat          albedo_format{VK_FORMAT_R8G8B8A8_UNORM};
 	VkFormat          normal_format{VK_FORMAT_A2B10G10R10_UNORM_PACK32};
@@ -130,6 +144,14 @@ class RenderSubpasses : public vkb::VulkanSample
 	    {/* config      = */ Config::GBufferSize,
 	     /* description = */ "G-Buffer size",
 	     /* options     = */ {"128-bit", "More"},
+	     /* value       = */ 0},
+	    {/* config      = */ Config::LightClustering,
+	     /* description = */ "Light clustering",
+	     /* options     = */ {"Disabled", "Graphics queue", "Async compute"},
+	     /* value       = */ 0},
+	    {/* config      = */ Config::ShadingRate,
+	     /* description = */ "Lighting shading rate",
+	     /* options     = */ {"1x1", "2x2", "4x4"},
 	     /* value       = */ 0}};
 };
 
@@ -0,0 +1,285 @@
+/* Copyright (c) 2020, Arm Limited and Contributors
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 the "License";
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "scene_scaling.h"
+
+#include <algorithm>
+
+#include <nlohmann/json.hpp>
+
+#include "common/logging.h"
+#include "common/utils.h"
+#include "gui.h"
+#include "platform/filesystem.h"
+#include "platform/platform.h"
+#include "rendering/render_pipeline.h"
+#include "rendering/subpasses/forward_subpass.h"
+#include "scene_graph/components/mesh.h"
+#include "stats/stats.h"
+
+namespace
+{
+const uint32_t node_counts[] = {256, 1024, 4096, 16384};
+
+const char *node_count_names[] = {"256", "1K", "4K", "16K"};
+
+const uint32_t light_counts[] = {0, 4, 16, 64};
+
+const char *light_count_names[] = {"0", "4", "16", "64"};
+}        // namespace
+
+constexpr uint32_t SceneScaling::SWEEP_WARMUP_FRAMES;
+constexpr uint32_t SceneScaling::SWEEP_MEASURED_FRAMES;
+
+SceneScaling::SceneScaling()
+{
+	scene_options.node_count  = node_counts[gui_node_count];
+	scene_options.light_count = light_counts[gui_light_count];
+}
+
+bool SceneScaling::prepare(vkb::Platform &platform)
+{
+	// The sweep reads the GPU time of the frames
+	const bool sweep = get_options().contains("--sweep");
+	if (sweep)
+	{
+		set_gpu_profiling(true);
+	}
+
+	if (!VulkanSample::prepare(platform))
+	{
+		return false;
+	}
+
+	build_scene(scene_options);
+
+	stats->request_stats({vkb::StatIndex::frame_times, vkb::StatIndex::cpu_cycles});
+
+	gui = std::make_unique<vkb::Gui>(*this, platform.get_window(), stats.get());
+
+	if (sweep)
+	{
+		this->platform = &platform;
+		prepare_sweep();
+	}
+
+	return true;
+}
+
+void SceneScaling::build_scene(const vkb::sg::StressSceneOptions &options)
+{
+	// The render pipeline refers to the previous scene, and the frames in flight to its buffers
+	get_device().wait_idle();
+
+	render_pipeline.reset();
+
+	for (auto &render_frame : get_render_context().get_render_frames())
+	{
+		render_frame->clear_descriptors();
+	}
+
+	scene = vkb::sg::create_stress_scene(get_device(), options);
+
+	auto &camera_node = vkb::add_free_camera(*scene, "default_camera", get_render_context().get_surface_extent());
+	camera            = dynamic_cast<vkb::sg::PerspectiveCamera *>(&camera_node.get_component<vkb::sg::Camera>());
+
+	auto scene_subpass = std::make_unique<vkb::ForwardSubpass>(get_render_context(), vkb::ShaderSource{"base.vert"}, vkb::ShaderSource{"base.frag"}, *scene, *camera);
+
+	// Beyond the lights of the forward uniform, the lights are binned into clusters
+	scene_subpass->set_clustered_lighting(options.light_count > MAX_FORWARD_LIGHT_COUNT);
+
+	vkb::RenderPipeline render_pipeline;
+	render_pipeline.add_subpass(std::move(scene_subpass));
+
+	set_render_pipeline(std::move(render_pipeline));
+
+	draw_count = 0;
+	for (auto mesh : scene->get_components<vkb::sg::Mesh>())
+	{
+		draw_count += vkb::to_u32(mesh->get_nodes().size() * mesh->get_submeshes().size());
+	}
+
+	scene_options = options;
+
+	LOGI("Stress scene of {} nodes, {} meshes, {} materials, {} lights and {} levels",
+	     options.node_count, options.mesh_count, options.material_count, options.light_count, options.hierarchy_depth);
+}
+
+void SceneScaling::prepare_sweep()
+{
+	const vkb::sg::StressSceneOptions base_options;
+
+	auto add_curve = [&](const char *parameter, std::initializer_list<uint32_t> values, uint32_t vkb::sg::StressSceneOptions::*member) {
+		for (uint32_t value : values)
+		{
+			SweepPoint point;
+			point.parameter       = parameter;
+			point.value           = value;
+			point.options         = base_options;
+			point.options.*member = value;
+
+			// Materials are assigned to meshes, so there are enough meshes to use every material
+			point.options.mesh_count = std::max(point.options.mesh_count, point.options.material_count);
+
+			sweep_points.push_back(point);
+		}
+	};
+
+	add_curve("node_count", {256, 1024, 4096, 16384}, &vkb::sg::StressSceneOptions::node_count);
+	add_curve("mesh_count", {1, 4, 16, 64, 256, 1024}, &vkb::sg::StressSceneOptions::mesh_count);
+	add_curve("material_count", {1, 4, 16, 64, 256}, &vkb::sg::StressSceneOptions::material_count);
+	add_curve("light_count", {0, 4, 16, 64, 256}, &vkb::sg::StressSceneOptions::light_count);
+	add_curve("hierarchy_depth", {1, 2, 4, 8}, &vkb::sg::StressSceneOptions::hierarchy_depth);
+
+	LOGI("Sweeping {} stress scenes", sweep_points.size());
+}
+
+void SceneScaling::update(float delta_time)
+{
+	const bool sweeping = !sweep_points.empty();
+
+	if (sweeping)
+	{
+		// Each point starts with its own scene
+		if (sweep_frame_index == 0)
+		{
+			build_scene(sweep_points[sweep_point_index].options);
+		}
+	}
+	else if (node_counts[gui_node_count] != scene_options.node_count || light_counts[gui_light_count] != scene_options.light_count)
+	{
+		auto options        = scene_options;
+		options.node_count  = node_counts[gui_node_count];
+		options.light_count = light_counts[gui_light_count];
+
+		build_scene(options);
+	}
+
+	VulkanSample::update(delta_time);
+
+	if (sweeping)
+	{
+		update_sweep();
+	}
+}
+
+void SceneScaling::render(vkb::CommandBuffer &command_buffer)
+{
+	record_timer.start();
+
+	VulkanSample::render(command_buffer);
+
+	record_time = record_timer.stop<vkb::Timer::Milliseconds>();
+}
+
+void SceneScaling::update_sweep()
+{
+	auto &point = sweep_points[sweep_point_index];
+
+	if (sweep_frame_index >= SWEEP_WARMUP_FRAMES)
+	{
+		point.record_time += record_time / SWEEP_MEASURED_FRAMES;
+
+		// Timestamps are read back from an older frame, recorded with the same scene after the warmup
+		for (auto &timing : gpu_profiler->get_timings())
+		{
+			if (timing.depth == 0 && timing.name == "Frame")
+			{
+				point.gpu_time += timing.last_time / SWEEP_MEASURED_FRAMES;
+			}
+		}
+	}
+
+	if (++sweep_frame_index < SWEEP_WARMUP_FRAMES + SWEEP_MEASURED_FRAMES)
+	{
+		return;
+	}
+
+	VmaStats memory_stats;
+	vmaCalculateStats(get_device().get_memory_allocator(), &memory_stats);
+
+	point.draw_count   = draw_count;
+	point.memory_usage = memory_stats.total.usedBytes / (1024.0 * 1024.0);
+
+	LOGI("{} {}: {:.3f} ms recording {} draws, {:.3f} ms on the GPU, {:.1f} MB", point.parameter, point.value,
+	     point.record_time, point.draw_count, point.gpu_time, point.memory_usage);
+
+	sweep_frame_index = 0;
+	if (++sweep_point_index == sweep_points.size())
+	{
+		write_sweep();
+		sweep_points.clear();
+		platform->close();
+	}
+}
+
+void SceneScaling::write_sweep() const
+{
+	nlohmann::json curves = nlohmann::json::object();
+
+	for (auto &point : sweep_points)
+	{
+		curves[point.parameter].push_back({{"value", point.value},
+		                                   {"record_ms", point.record_time},
+		                                   {"gpu_ms", point.gpu_time},
+		                                   {"draws", point.draw_count},
+		                                   {"memory_mb", point.memory_usage}});
+	}
+
+	const vkb::sg::StressSceneOptions base_options;
+
+	nlohmann::json base = {{"node_count", base_options.node_count},
+	                       {"mesh_count", base_options.mesh_count},
+	                       {"material_count", base_options.material_count},
+	                       {"light_count", base_options.light_count},
+	                       {"hierarchy_depth", base_options.hierarchy_depth}};
+
+	nlohmann::json sweep = {{"warmup_frames", SWEEP_WARMUP_FRAMES},
+	                        {"measured_frames", SWEEP_MEASURED_FRAMES},
+	                        {"base", base},
+	                        {"curves", curves}};
+
+	vkb::fs::write_json(sweep, "scene_scaling_sweep.json");
+}
+
+void SceneScaling::draw_gui()
+{
+	gui->show_options_window(
+	    /* body = */ [&]() {
+		    ImGui::Text("Nodes:");
+		    for (int i = 0; i < 4; ++i)
+		    {
+			    ImGui::SameLine();
+			    ImGui::RadioButton(node_count_names[i], &gui_node_count, i);
+		    }
+
+		    ImGui::Text("Lights:");
+		    for (int i = 0; i < 4; ++i)
+		    {
+			    ImGui::SameLine();
+			    ImGui::RadioButton(light_count_names[i], &gui_light_count, i);
+		    }
+
+		    ImGui::Text("%u draws recorded in %.3f ms", draw_count, record_time);
+	    },
+	    /* lines = */ 3);
+}
+
+std::unique_ptr<vkb::VulkanSample> create_scene_scaling()
+{
+	return std::make_unique<SceneScaling>();
+}
@@ -0,0 +1,133 @@
+/* Copyright (c) 2020, Arm Limited and Contributors
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 the "License";
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <vector>
+
+#include "scene_graph/components/perspective_camera.h"
+#include "scene_graph/stress_scene.h"
+#include "timer.h"
+#include "vulkan_sample.h"
+
+/**
+ * @brief Renders procedural scenes of growing size, to find where the CPU recording time,
+ *        the draws and the memory of the renderer stop scaling
+ *
+ * With --sweep, each parameter of the scene is swept while the others keep their base value,
+ * and the curves are written to a JSON file before the sample exits. Run it with --headless
+ * so that presentation does not pace the frames.
+ */
+class SceneScaling : public vkb::VulkanSample
+{
+  public:
+	SceneScaling();
+
+	virtual ~SceneScaling() = default;
+
+	virtual bool prepare(vkb::Platform &platform) override;
+
+	virtual void update(float delta_time) override;
+
+  private:
+	/**
+	 * @brief A scene of the sweep, and its measurements averaged over the measured frames
+	 */
+	struct SweepPoint
+	{
+		/// Name of the swept parameter, which the point belongs to the curve of
+		const char *parameter{nullptr};
+
+		uint32_t value{0};
+
+		vkb::sg::StressSceneOptions options;
+
+		/// CPU time recording the render pipeline, in milliseconds
+		double record_time{0.0};
+
+		/// GPU time of the frame, in milliseconds, 0 if the GPU timestamps are not supported
+		double gpu_time{0.0};
+
+		uint32_t draw_count{0};
+
+		/// Device memory used once the scene is drawn, in megabytes
+		double memory_usage{0.0};
+	};
+
+	/**
+	 * @brief Replaces the scene and the render pipeline drawing it
+	 */
+	void build_scene(const vkb::sg::StressSceneOptions &options);
+
+	/**
+	 * @brief Builds the sweep over each parameter of the scene
+	 */
+	void prepare_sweep();
+
+	/**
+	 * @brief Accumulates the measurements of the frame into the current sweep point,
+	 *        moving to the next one once enough frames were measured
+	 */
+	void update_sweep();
+
+	/**
+	 * @brief Writes the curves of the sweep to a JSON file in the graphs directory
+	 */
+	void write_sweep() const;
+
+	virtual void render(vkb::CommandBuffer &command_buffer) override;
+
+	virtual void draw_gui() override;
+
+	/// Frames rendered with a sweep point before measuring it, so that its pipelines are built and frames in flight retire
+	static constexpr uint32_t SWEEP_WARMUP_FRAMES{10};
+
+	/// Frames measured for each sweep point
+	static constexpr uint32_t SWEEP_MEASURED_FRAMES{30};
+
+	/// Options of the scene drawn
+	vkb::sg::StressSceneOptions scene_options;
+
+	vkb::sg::PerspectiveCamera *camera{nullptr};
+
+	/// Sub meshes drawn by the nodes of the scene
+	uint32_t draw_count{0};
+
+	/// Measures the CPU time of recording the render pipeline
+	vkb::Timer record_timer;
+
+	/// CPU time of recording the render pipeline in the last frame, in milliseconds
+	double record_time{0.0};
+
+	/// Points of the sweep, empty unless running with --sweep
+	std::vector<SweepPoint> sweep_points;
+
+	/// Index of the sweep point being rendered
+	size_t sweep_point_index{0};
+
+	/// Frames rendered with the current sweep point
+	uint32_t sweep_frame_index{0};
+
+	/// Platform closed once the sweep is over
+	vkb::Platform *platform{nullptr};
+
+	int gui_node_count{1};
+
+	int gui_light_count{1};
+};
+
+std::unique_ptr<vkb::VulkanSample> create_scene_scaling();
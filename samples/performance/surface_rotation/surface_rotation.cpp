@@ -202,8 +202,7 @@ void SurfaceRotation::handle_no_resize_rotations()
 
 void SurfaceRotation::recreate_swapchain()
 {
-	get_device().wait_idle();
-
+	// The render context retires the old swapchain once the frames in flight are done with it
 	auto surface_extent = get_render_context().get_surface_extent();
 
 	get_render_context().update_swapchain(surface_extent, select_pre_transform());
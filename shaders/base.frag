@@ -16,9 +16,24 @@
  * limitations under the License.
  */
 
+#ifdef MULTIVIEW
+#extension GL_EXT_multiview : require
+#endif
+
+#if defined(INDIRECT_DRAWING) && defined(BINDLESS_TEXTURE_COUNT)
+// Draws of a multi draw may index different textures
+#extension GL_EXT_nonuniform_qualifier : require
+#endif
+
 precision highp float;
 
-#ifdef HAS_BASE_COLOR_TEXTURE
+#if defined(BINDLESS_TEXTURE_COUNT) && defined(TEXTURE_ARRAYS)
+// All the texture arrays of the scene, materials select an array and one of its layers
+layout(set = 1, binding = 0) uniform sampler2DArray bindless_textures[BINDLESS_TEXTURE_COUNT];
+#elif defined(BINDLESS_TEXTURE_COUNT)
+// All the textures of the scene, indexed with a dynamically uniform index from the push constants
+layout(set = 1, binding = 0) uniform sampler2D bindless_textures[BINDLESS_TEXTURE_COUNT];
+#elif defined(HAS_BASE_COLOR_TEXTURE)
 layout(set = 0, binding = 0) uniform sampler2D base_color_texture;
 #endif
 
@@ -26,7 +41,19 @@ layout(location = 0) in vec4 in_pos;
 layout(location = 1) in vec2 in_uv;
 layout(location = 2) in vec3 in_normal;
 
+#ifdef INDIRECT_DRAWING
+layout(location = 3) flat in uint in_instance_index;
+#endif
+
+#ifdef WEIGHTED_BLENDED_OIT
+// Weighted sum of the premultiplied colors and of the alphas of the transparent fragments, added in any order
+layout(location = 0) out vec4 o_accumulation;
+
+// Product of the transmittances of the transparent fragments, multiplied in any order
+layout(location = 1) out float o_revealage;
+#else
 layout(location = 0) out vec4 o_color;
+#endif
 
 layout(set = 0, binding = 1) uniform GlobalUniform
 {
@@ -36,6 +63,26 @@ layout(set = 0, binding = 1) uniform GlobalUniform
 }
 global_uniform;
 
+#ifdef MULTIVIEW
+// Cameras of the views drawn at once
+layout(set = 0, binding = 21) uniform MultiviewUniform
+{
+	mat4 view_proj[MAX_VIEW_COUNT];
+	vec4 camera_position[MAX_VIEW_COUNT];
+}
+multiview_uniform;
+
+vec3 get_camera_position()
+{
+	return multiview_uniform.camera_position[gl_ViewIndex].xyz;
+}
+#else
+vec3 get_camera_position()
+{
+	return global_uniform.camera_position;
+}
+#endif
+
 struct Light
 {
 	vec4 position;         // position.w represents type of light
@@ -44,13 +91,96 @@ struct Light
 	vec2 info;             // (only used for spot lights) info.x represents light inner cone angle, info.y represents light outer cone angle
 };
 
+#ifdef CLUSTERED_LIGHTING
+layout(std430, set = 0, binding = 4) readonly buffer LightsInfo
+{
+	Light light[];
+}
+lights;
+
+layout(std430, set = 0, binding = 5) readonly buffer ClusterLightCounts
+{
+	uint counts[];
+}
+cluster_light_counts;
+
+layout(std430, set = 0, binding = 6) readonly buffer ClusterLightIndices
+{
+	uint indices[];
+}
+cluster_light_indices;
+
+layout(set = 0, binding = 7) uniform ClusterUniform
+{
+	mat4  view;
+	mat4  inv_projection;
+	vec4  depth_range;        // x is the near plane, y the far plane, z the number of slices over log(far / near)
+	uvec4 counts;             // x is the number of lights, y the number of directional lights
+	vec2  inv_resolution;     // Maps fragment coordinates to screen tiles
+}
+cluster_uniform;
+
+// Finds the cluster of the fragment from its screen tile and its view depth
+uint get_cluster(vec3 pos)
+{
+	float view_depth = -(cluster_uniform.view * vec4(pos, 1.0)).z;
+	uint  slice      = uint(max(log(view_depth / cluster_uniform.depth_range.x) * cluster_uniform.depth_range.z, 0.0));
+	uvec2 tile       = uvec2(clamp(gl_FragCoord.xy * cluster_uniform.inv_resolution, vec2(0.0), vec2(0.999999)) * vec2(LIGHT_CLUSTER_COUNT_X, LIGHT_CLUSTER_COUNT_Y));
+	return (min(slice, uint(LIGHT_CLUSTER_COUNT_Z - 1)) * LIGHT_CLUSTER_COUNT_Y + tile.y) * LIGHT_CLUSTER_COUNT_X + tile.x;
+}
+#else
 layout(set = 0, binding = 4) uniform LightsInfo
 {
 	uint  count;
 	Light light[MAX_FORWARD_LIGHT_COUNT];
 }
 lights;
+#endif
+
+#ifdef INDIRECT_DRAWING
+struct IndirectInstance
+{
+	mat4  model;
+	vec4  base_color_factor;
+	float metallic_factor;
+	float roughness_factor;
+	uint  base_color_texture_index;
+	uint  base_color_texture_layer;
+};
 
+// Materials of indirect draws come with the per draw data instead of push constants
+layout(std430, set = 0, binding = 3) readonly buffer IndirectInstances
+{
+	IndirectInstance instances[];
+}
+indirect_instances;
+
+#define pbr_material_uniform indirect_instances.instances[in_instance_index]
+#elif defined(MATERIAL_TABLE)
+struct Material
+{
+	vec4  base_color_factor;
+	float metallic_factor;
+	float roughness_factor;
+	uint  base_color_texture_index;
+	uint  base_color_texture_layer;
+};
+
+// Factors of all the materials, uploaded once, draws only push the index of theirs
+layout(std430, set = 0, binding = 10) readonly buffer MaterialTable
+{
+	Material materials[];
+}
+material_table;
+
+layout(push_constant, std430) uniform MaterialIndexUniform
+{
+	uint material_index;
+}
+material_index_uniform;
+
+#define pbr_material_uniform material_table.materials[material_index_uniform.material_index]
+#else
 // Push constants come with a limitation in the size of data.
 // The standard requires at least 128 bytes
 layout(push_constant, std430) uniform PBRMaterialUniform
@@ -58,8 +188,68 @@ layout(push_constant, std430) uniform PBRMaterialUniform
 	vec4  base_color_factor;
 	float metallic_factor;
 	float roughness_factor;
+#ifdef BINDLESS_TEXTURE_COUNT
+	uint base_color_texture_index;
+	uint base_color_texture_layer;
+#endif
 }
 pbr_material_uniform;
+#endif
+
+#ifdef SHADOWS
+precision highp sampler2DArrayShadow;
+
+layout(set = 0, binding = 8) uniform ShadowUniform
+{
+	mat4  light_view_proj[MAX_SHADOW_CASCADE_COUNT];
+	vec4  cascade_spheres[MAX_SHADOW_CASCADE_COUNT];        // xyz is the center of a cascade, w its squared radius
+	uvec4 info;                                             // x is the number of cascades, y the index of the shadowed light
+}
+shadow_uniform;
+
+layout(set = 0, binding = 9) uniform sampler2DArrayShadow shadow_maps;
+#endif
+
+#ifdef IMAGE_BASED_LIGHTING
+layout(set = 0, binding = 18) uniform samplerCube irradiance_map;
+layout(set = 0, binding = 19) uniform samplerCube prefiltered_map;
+layout(set = 0, binding = 20) uniform sampler2D brdf_lut;
+
+// Light of the environment reaching the fragment, with the split sum approximation for the specular part
+vec3 get_image_based_lighting(vec3 normal, vec3 albedo, float metallic, float roughness)
+{
+	vec3  view    = normalize(get_camera_position() - in_pos.xyz);
+	float n_dot_v = max(dot(normal, view), 0.0);
+	vec3  f0      = mix(vec3(0.04), albedo, metallic);
+
+	vec3 diffuse     = texture(irradiance_map, normal).rgb * albedo * (1.0 - metallic);
+	vec3 prefiltered = textureLod(prefiltered_map, reflect(-view, normal), roughness * float(IBL_PREFILTERED_MIP_COUNT - 1)).rgb;
+	vec2 brdf        = texture(brdf_lut, vec2(n_dot_v, roughness)).rg;
+
+	return diffuse + prefiltered * (f0 * brdf.x + brdf.y);
+}
+#endif
+
+// Fraction of a light reaching the fragment, sampled from the first cascade containing it
+float get_shadow(uint index)
+{
+#ifdef SHADOWS
+	if (index == shadow_uniform.info.y)
+	{
+		for (uint i = 0U; i < shadow_uniform.info.x; i++)
+		{
+			vec3 offset = in_pos.xyz - shadow_uniform.cascade_spheres[i].xyz;
+
+			if (dot(offset, offset) < shadow_uniform.cascade_spheres[i].w)
+			{
+				vec4 coord = shadow_uniform.light_view_proj[i] * vec4(in_pos.xyz, 1.0);
+				return texture(shadow_maps, vec4(coord.xy * 0.5 + 0.5, float(i), coord.z));
+			}
+		}
+	}
+#endif
+	return 1.0;
+}
 
 vec3 apply_directional_light(uint index, vec3 normal)
 {
@@ -69,7 +259,7 @@ vec3 apply_directional_light(uint index, vec3 normal)
 
 	float ndotl = clamp(dot(normal, world_to_light), 0.0, 1.0);
 
-	return ndotl * lights.light[index].color.w * lights.light[index].color.rgb;
+	return ndotl * lights.light[index].color.w * lights.light[index].color.rgb * get_shadow(index);
 }
 
 vec3 apply_point_light(uint index, vec3 normal)
@@ -93,6 +283,25 @@ void main(void)
 
 	vec3 light_contribution = vec3(0.0);
 
+#ifdef CLUSTERED_LIGHTING
+	for (uint i = 0U; i < cluster_uniform.counts.y; i++)
+	{
+		light_contribution += apply_directional_light(i, normal);
+	}
+
+	uint cluster = get_cluster(in_pos.xyz);
+	uint count   = cluster_light_counts.counts[cluster];
+
+	for (uint i = 0U; i < count; i++)
+	{
+		uint index = cluster_light_indices.indices[cluster * MAX_LIGHTS_PER_CLUSTER + i];
+
+		if (lights.light[index].position.w == POINT_LIGHT)
+		{
+			light_contribution += apply_point_light(index, normal);
+		}
+	}
+#else
 	for (uint i = 0U; i < lights.count; i++)
 	{
 		if (lights.light[i].position.w == DIRECTIONAL_LIGHT)
@@ -104,16 +313,45 @@ void main(void)
 			light_contribution += apply_point_light(i, normal);
 		}
 	}
+#endif
 
 	vec4 base_color = vec4(1.0, 0.0, 0.0, 1.0);
 
-#ifdef HAS_BASE_COLOR_TEXTURE
+#if defined(HAS_BASE_COLOR_TEXTURE) && defined(BINDLESS_TEXTURE_COUNT) && defined(TEXTURE_ARRAYS)
+	vec3 base_color_uv = vec3(in_uv, float(pbr_material_uniform.base_color_texture_layer));
+#ifdef INDIRECT_DRAWING
+	base_color = texture(bindless_textures[nonuniformEXT(pbr_material_uniform.base_color_texture_index)], base_color_uv);
+#else
+	base_color = texture(bindless_textures[pbr_material_uniform.base_color_texture_index], base_color_uv);
+#endif
+#elif defined(HAS_BASE_COLOR_TEXTURE) && defined(BINDLESS_TEXTURE_COUNT)
+#ifdef INDIRECT_DRAWING
+	base_color = texture(bindless_textures[nonuniformEXT(pbr_material_uniform.base_color_texture_index)], in_uv);
+#else
+	base_color = texture(bindless_textures[pbr_material_uniform.base_color_texture_index], in_uv);
+#endif
+#elif defined(HAS_BASE_COLOR_TEXTURE)
 	base_color = texture(base_color_texture, in_uv);
 #else
 	base_color = pbr_material_uniform.base_color_factor;
 #endif
 
+#ifdef IMAGE_BASED_LIGHTING
+	vec3 ambient_color = get_image_based_lighting(normal, base_color.xyz, pbr_material_uniform.metallic_factor, pbr_material_uniform.roughness_factor);
+#else
 	vec3 ambient_color = vec3(0.2) * base_color.xyz;
+#endif
+
+	vec4 color = vec4(ambient_color + light_contribution * base_color.xyz, base_color.w);
 
-	o_color = vec4(ambient_color + light_contribution * base_color.xyz, base_color.w);
+#ifdef WEIGHTED_BLENDED_OIT
+	// Nearer and more opaque fragments weigh more, as in equation 10 of McGuire and Bavoil's weighted blended OIT
+	float distance = length(get_camera_position() - in_pos.xyz);
+	float weight   = color.a * clamp(10.0 / (1e-5 + pow(distance / 5.0, 2.0) + pow(distance / 200.0, 6.0)), 1e-2, 3e3);
+
+	o_accumulation = vec4(color.rgb * color.a, color.a) * weight;
+	o_revealage    = color.a;
+#else
+	o_color = color;
+#endif
 }
@@ -16,9 +16,21 @@
  * limitations under the License.
  */
 
+#ifdef MULTIVIEW
+#extension GL_EXT_multiview : require
+#endif
+
+#ifdef QUANTIZED_POSITION
+layout(location = 0) in vec4 position;
+#else
 layout(location = 0) in vec3 position;
+#endif
 layout(location = 1) in vec2 texcoord_0;
+#ifdef OCTAHEDRAL_NORMAL
+layout(location = 2) in vec2 normal;
+#else
 layout(location = 2) in vec3 normal;
+#endif
 
 layout(set = 0, binding = 1) uniform GlobalUniform {
     mat4 model;
@@ -26,17 +38,100 @@ layout(set = 0, binding = 1) uniform GlobalUniform {
     vec3 camera_position;
 } global_uniform;
 
+#ifdef MULTIVIEW
+// Cameras of the views drawn at once, the view projection of the global uniform is the one of the subpass camera
+layout(set = 0, binding = 21) uniform MultiviewUniform {
+    mat4 view_proj[MAX_VIEW_COUNT];
+    vec4 camera_position[MAX_VIEW_COUNT];
+} multiview_uniform;
+#endif
+
+#ifdef QUANTIZED_POSITION
+// Positions are stored as unorm relative to the bounds of their sub mesh
+layout(set = 0, binding = 11) uniform PositionDequantization {
+    vec4 offset;
+    vec4 scale;
+} position_dequantization;
+#endif
+
+#ifdef OCTAHEDRAL_NORMAL
+vec3 octahedral_decode(vec2 e)
+{
+    vec3 n = vec3(e, 1.0 - abs(e.x) - abs(e.y));
+
+    if (n.z < 0.0)
+    {
+        n.xy = (1.0 - abs(n.yx)) * vec2(n.x >= 0.0 ? 1.0 : -1.0, n.y >= 0.0 ? 1.0 : -1.0);
+    }
+
+    return normalize(n);
+}
+#endif
+
+#ifdef INDIRECT_DRAWING
+struct IndirectInstance
+{
+    mat4  model;
+    vec4  base_color_factor;
+    float metallic_factor;
+    float roughness_factor;
+    uint  base_color_texture_index;
+    uint  base_color_texture_layer;
+};
+
+// Per draw data, every indirect draw selects its own instance through its first instance
+layout(std430, set = 0, binding = 3) readonly buffer IndirectInstances {
+    IndirectInstance instances[];
+} indirect_instances;
+#endif
+
+#ifdef INSTANCED_DRAWING
+// Model matrices of the nodes of an instanced draw, selected through the instance index
+layout(std430, set = 0, binding = 3) readonly buffer InstanceModels {
+    mat4 models[];
+} instance_models;
+#endif
+
 layout (location = 0) out vec4 o_pos;
 layout (location = 1) out vec2 o_uv;
 layout (location = 2) out vec3 o_normal;
+#ifdef INDIRECT_DRAWING
+layout (location = 3) flat out uint o_instance_index;
+#endif
 
 void main(void)
 {
-    o_pos = global_uniform.model * vec4(position, 1.0);
+#ifdef QUANTIZED_POSITION
+    vec3 local_position = position_dequantization.offset.xyz + position_dequantization.scale.xyz * position.xyz;
+#else
+    vec3 local_position = position;
+#endif
+
+#ifdef OCTAHEDRAL_NORMAL
+    vec3 local_normal = octahedral_decode(normal);
+#else
+    vec3 local_normal = normal;
+#endif
+
+#ifdef INDIRECT_DRAWING
+    mat4 model = indirect_instances.instances[gl_InstanceIndex].model;
+
+    o_instance_index = uint(gl_InstanceIndex);
+#elif defined(INSTANCED_DRAWING)
+    mat4 model = instance_models.models[gl_InstanceIndex];
+#else
+    mat4 model = global_uniform.model;
+#endif
+
+    o_pos = model * vec4(local_position, 1.0);
 
     o_uv = texcoord_0;
 
-    o_normal = mat3(global_uniform.model) * normal;
+    o_normal = mat3(model) * local_normal;
 
+#ifdef MULTIVIEW
+    gl_Position = multiview_uniform.view_proj[gl_ViewIndex] * o_pos;
+#else
     gl_Position = global_uniform.view_proj * o_pos;
+#endif
 }
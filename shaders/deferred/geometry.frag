@@ -25,21 +25,54 @@ layout (set=0, binding=0) uniform sampler2D base_color_texture;
 layout (location = 0) in vec4 in_pos;
 layout (location = 1) in vec2 in_uv;
 layout (location = 2) in vec3 in_normal;
+#ifdef MOTION_VECTORS
+layout (location = 3) in vec4 in_current_position;
+layout (location = 4) in vec4 in_previous_position;
+#endif
 
 layout (location = 0) out vec4 o_albedo;
 layout (location = 1) out vec4 o_normal;
+#ifdef MOTION_VECTORS
+// Motion since the previous frame in texture coordinates, the previous position of a pixel is its position minus it
+layout (location = 2) out vec2 o_motion;
+#endif
 
 layout(set = 0, binding = 1) uniform GlobalUniform {
     mat4 model;
     mat4 view_proj;
     vec3 camera_position;
+#ifdef MOTION_VECTORS
+    mat4 previous_model;
+    mat4 previous_view_proj;
+#endif
 } global_uniform;
 
+#ifdef MATERIAL_TABLE
+struct Material {
+    vec4 base_color_factor;
+    float metallic_factor;
+    float roughness_factor;
+    uint base_color_texture_index;
+    uint base_color_texture_layer;
+};
+
+// Factors of all the materials, uploaded once, draws only push the index of theirs
+layout(std430, set = 0, binding = 10) readonly buffer MaterialTable {
+    Material materials[];
+} material_table;
+
+layout(push_constant, std430) uniform MaterialIndexUniform {
+    uint material_index;
+} material_index_uniform;
+
+#define pbr_material_uniform material_table.materials[material_index_uniform.material_index]
+#else
 layout(push_constant, std430) uniform PBRMaterialUniform {
     vec4 base_color_factor;
     float metallic_factor;
     float roughness_factor;
 } pbr_material_uniform;
+#endif
 
 void main(void)
 {
@@ -56,4 +89,8 @@ void main(void)
 #endif
 
     o_albedo = base_color;
+
+#ifdef MOTION_VECTORS
+    o_motion = 0.5 * (in_current_position.xy / in_current_position.w - in_previous_position.xy / in_previous_position.w);
+#endif
 }
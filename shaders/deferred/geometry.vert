@@ -16,27 +16,83 @@
  * limitations under the License.
  */
 
+#ifdef QUANTIZED_POSITION
+layout(location = 0) in vec4 position;
+#else
 layout(location = 0) in vec3 position;
+#endif
 layout(location = 1) in vec2 texcoord_0;
+#ifdef OCTAHEDRAL_NORMAL
+layout(location = 2) in vec2 normal;
+#else
 layout(location = 2) in vec3 normal;
+#endif
 
 layout(set = 0, binding = 1) uniform GlobalUniform {
     mat4 model;
     mat4 view_proj;
     vec3 camera_position;
+#ifdef MOTION_VECTORS
+    mat4 previous_model;
+    mat4 previous_view_proj;
+#endif
 } global_uniform;
 
+#ifdef QUANTIZED_POSITION
+// Positions are stored as unorm relative to the bounds of their sub mesh
+layout(set = 0, binding = 11) uniform PositionDequantization {
+    vec4 offset;
+    vec4 scale;
+} position_dequantization;
+#endif
+
+#ifdef OCTAHEDRAL_NORMAL
+vec3 octahedral_decode(vec2 e)
+{
+    vec3 n = vec3(e, 1.0 - abs(e.x) - abs(e.y));
+
+    if (n.z < 0.0)
+    {
+        n.xy = (1.0 - abs(n.yx)) * vec2(n.x >= 0.0 ? 1.0 : -1.0, n.y >= 0.0 ? 1.0 : -1.0);
+    }
+
+    return normalize(n);
+}
+#endif
+
 layout (location = 0) out vec4 o_pos;
 layout (location = 1) out vec2 o_uv;
 layout (location = 2) out vec3 o_normal;
+#ifdef MOTION_VECTORS
+layout (location = 3) out vec4 o_current_position;
+layout (location = 4) out vec4 o_previous_position;
+#endif
 
 void main(void)
 {
-    o_pos = global_uniform.model * vec4(position, 1.0);
+#ifdef QUANTIZED_POSITION
+    vec3 local_position = position_dequantization.offset.xyz + position_dequantization.scale.xyz * position.xyz;
+#else
+    vec3 local_position = position;
+#endif
+
+#ifdef OCTAHEDRAL_NORMAL
+    vec3 local_normal = octahedral_decode(normal);
+#else
+    vec3 local_normal = normal;
+#endif
+
+    o_pos = global_uniform.model * vec4(local_position, 1.0);
 
     o_uv = texcoord_0;
 
-    o_normal = mat3(global_uniform.model) * normal;
+    o_normal = mat3(global_uniform.model) * local_normal;
 
     gl_Position = global_uniform.view_proj * o_pos;
+
+#ifdef MOTION_VECTORS
+    // Clip space positions are divided per fragment, as their interpolation is only linear before the division
+    o_current_position  = gl_Position;
+    o_previous_position = global_uniform.previous_view_proj * global_uniform.previous_model * vec4(local_position, 1.0);
+#endif
 }
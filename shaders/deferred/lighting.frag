@@ -21,12 +21,18 @@ layout(input_attachment_index = 0, binding = 0) uniform subpassInput i_depth;
 layout(input_attachment_index = 1, binding = 1) uniform subpassInput i_albedo;
 layout(input_attachment_index = 2, binding = 2) uniform subpassInput i_normal;
 
+#ifdef RAY_TRACED_VISIBILITY
+// x is the visibility of the first directional light, y the ambient visibility
+layout(input_attachment_index = 3, binding = 8) uniform subpassInput i_visibility;
+#endif
+
 layout(location = 0) in vec2 in_uv;
 layout(location = 0) out vec4 o_color;
 
 layout(set = 0, binding = 3) uniform GlobalUniform
 {
     mat4 inv_view_proj;
+    vec4 camera_position;
     vec2 inv_resolution;
 }
 global_uniform;
@@ -39,12 +45,65 @@ struct Light
     vec2 info;             // (only used for spot lights) info.x represents light inner cone angle, info.y represents light outer cone angle
 };
 
+#ifdef CLUSTERED_LIGHTING
+layout(std430, set = 0, binding = 4) readonly buffer LightsInfo
+{
+    Light lights[];
+}
+lights;
+
+layout(std430, set = 0, binding = 5) readonly buffer ClusterLightCounts
+{
+    uint counts[];
+}
+cluster_light_counts;
+
+layout(std430, set = 0, binding = 6) readonly buffer ClusterLightIndices
+{
+    uint indices[];
+}
+cluster_light_indices;
+
+layout(set = 0, binding = 7) uniform ClusterUniform
+{
+    mat4  view;
+    mat4  inv_projection;
+    vec4  depth_range;        // x is the near plane, y the far plane, z the number of slices over log(far / near)
+    uvec4 counts;             // x is the number of lights, y the number of directional lights
+    vec2  inv_resolution;     // Maps fragment coordinates to screen tiles
+}
+cluster_uniform;
+#else
 layout(set = 0, binding = 4) uniform LightsInfo
 {
     uint  count;
     Light lights[MAX_DEFERRED_LIGHT_COUNT];
 }
 lights;
+#endif
+
+#ifdef IMAGE_BASED_LIGHTING
+layout(set = 0, binding = 9) uniform samplerCube irradiance_map;
+layout(set = 0, binding = 10) uniform samplerCube prefiltered_map;
+layout(set = 0, binding = 11) uniform sampler2D brdf_lut;
+
+// The G-buffer stores no material properties, so the environment is reflected by a rough dielectric
+#define IBL_ROUGHNESS 0.8
+#define IBL_F0 0.04
+
+// Light of the environment reaching the pixel, with the split sum approximation for the specular part
+vec3 get_image_based_lighting(vec3 pos, vec3 normal, vec3 albedo)
+{
+    vec3  view    = normalize(global_uniform.camera_position.xyz - pos);
+    float n_dot_v = max(dot(normal, view), 0.0);
+
+    vec3 diffuse     = texture(irradiance_map, normal).rgb * albedo;
+    vec3 prefiltered = textureLod(prefiltered_map, reflect(-view, normal), IBL_ROUGHNESS * float(IBL_PREFILTERED_MIP_COUNT - 1)).rgb;
+    vec2 brdf        = texture(brdf_lut, vec2(n_dot_v, IBL_ROUGHNESS)).rg;
+
+    return diffuse + prefiltered * (IBL_F0 * brdf.x + brdf.y);
+}
+#endif
 
 vec3 apply_directional_light(uint index, vec3 normal)
 {
@@ -77,21 +136,57 @@ void main()
     vec3 normal = subpassLoad(i_normal).xyz;
     normal      = normalize(2.0 * normal - 1.0);
 
-    // Calculate lighting
+#ifdef RAY_TRACED_VISIBILITY
+    vec2 visibility = subpassLoad(i_visibility).xy;
+#else
+    vec2 visibility = vec2(1.0);
+#endif
+
+    // Calculate lighting, ray traced shadows only darken the first directional light
     vec3 L = vec3(0.0);
+    float light_visibility = visibility.x;
+#ifdef CLUSTERED_LIGHTING
+    for (uint i = 0U; i < cluster_uniform.counts.y; i++)
+    {
+        L += light_visibility * apply_directional_light(i, normal);
+        light_visibility = 1.0;
+    }
+
+    // Find the cluster of the pixel from its screen tile and its view depth
+    float view_depth = -(cluster_uniform.view * vec4(pos, 1.0)).z;
+    uint  slice      = uint(max(log(view_depth / cluster_uniform.depth_range.x) * cluster_uniform.depth_range.z, 0.0));
+    uvec2 tile       = uvec2(clamp(gl_FragCoord.xy * cluster_uniform.inv_resolution, vec2(0.0), vec2(0.999999)) * vec2(LIGHT_CLUSTER_COUNT_X, LIGHT_CLUSTER_COUNT_Y));
+    uint  cluster    = (min(slice, uint(LIGHT_CLUSTER_COUNT_Z - 1)) * LIGHT_CLUSTER_COUNT_Y + tile.y) * LIGHT_CLUSTER_COUNT_X + tile.x;
+
+    uint count = cluster_light_counts.counts[cluster];
+    for (uint i = 0U; i < count; i++)
+    {
+        uint index = cluster_light_indices.indices[cluster * MAX_LIGHTS_PER_CLUSTER + i];
+        if (lights.lights[index].position.w == POINT_LIGHT)
+        {
+            L += apply_point_light(index, pos, normal);
+        }
+    }
+#else
     for (uint i = 0U; i < lights.count; i++)
     {
         if (lights.lights[i].position.w == DIRECTIONAL_LIGHT)
         {
-            L += apply_directional_light(i, normal);
+            L += light_visibility * apply_directional_light(i, normal);
+            light_visibility = 1.0;
         }
         if (lights.lights[i].position.w == POINT_LIGHT)
         {
             L += apply_point_light(i, pos, normal);
         }
     }
+#endif
 
-    vec3 ambient_color = vec3(0.2) * albedo.xyz;
+#ifdef IMAGE_BASED_LIGHTING
+    vec3 ambient_color = get_image_based_lighting(pos, normal, albedo.xyz) * visibility.y;
+#else
+    vec3 ambient_color = vec3(0.2) * visibility.y * albedo.xyz;
+#endif
     
     o_color = vec4(ambient_color + L * albedo.xyz, 1.0);
 }
\ No newline at end of file
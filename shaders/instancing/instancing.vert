@@ -38,6 +38,9 @@ layout (binding = 0) uniform UBO
 	float globSpeed;
 } ubo;
 
+// Set when the instances were already animated by instance_update.comp
+layout (constant_id = 0) const bool PRE_TRANSFORMED = false;
+
 layout (location = 0) out vec3 outNormal;
 layout (location = 1) out vec3 outColor;
 layout (location = 2) out vec3 outUV;
@@ -49,27 +52,29 @@ void main()
 	outColor = vec3(1.0);
 	outUV = vec3(inUV, instanceTexIndex);
 
+	float locSpeed = PRE_TRANSFORMED ? 0.0 : ubo.locSpeed;
+
 	mat3 mx, my, mz;
 	
 	// rotate around x
-	float s = sin(instanceRot.x + ubo.locSpeed);
-	float c = cos(instanceRot.x + ubo.locSpeed);
+	float s = sin(instanceRot.x + locSpeed);
+	float c = cos(instanceRot.x + locSpeed);
 
 	mx[0] = vec3(c, s, 0.0);
 	mx[1] = vec3(-s, c, 0.0);
 	mx[2] = vec3(0.0, 0.0, 1.0);
 	
 	// rotate around y
-	s = sin(instanceRot.y + ubo.locSpeed);
-	c = cos(instanceRot.y + ubo.locSpeed);
+	s = sin(instanceRot.y + locSpeed);
+	c = cos(instanceRot.y + locSpeed);
 
 	my[0] = vec3(c, 0.0, s);
 	my[1] = vec3(0.0, 1.0, 0.0);
 	my[2] = vec3(-s, 0.0, c);
 	
 	// rot around z
-	s = sin(instanceRot.z + ubo.locSpeed);
-	c = cos(instanceRot.z + ubo.locSpeed);	
+	s = sin(instanceRot.z + locSpeed);
+	c = cos(instanceRot.z + locSpeed);	
 	
 	mz[0] = vec3(1.0, 0.0, 0.0);
 	mz[1] = vec3(0.0, c, s);
@@ -77,13 +82,16 @@ void main()
 	
 	mat3 rotMat = mz * my * mx;
 
-	mat4 gRotMat;
-	s = sin(instanceRot.y + ubo.globSpeed);
-	c = cos(instanceRot.y + ubo.globSpeed);
-	gRotMat[0] = vec4(c, 0.0, s, 0.0);
-	gRotMat[1] = vec4(0.0, 1.0, 0.0, 0.0);
-	gRotMat[2] = vec4(-s, 0.0, c, 0.0);
-	gRotMat[3] = vec4(0.0, 0.0, 0.0, 1.0);	
+	mat4 gRotMat = mat4(1.0);
+	if (!PRE_TRANSFORMED)
+	{
+		s = sin(instanceRot.y + ubo.globSpeed);
+		c = cos(instanceRot.y + ubo.globSpeed);
+		gRotMat[0] = vec4(c, 0.0, s, 0.0);
+		gRotMat[1] = vec4(0.0, 1.0, 0.0, 0.0);
+		gRotMat[2] = vec4(-s, 0.0, c, 0.0);
+		gRotMat[3] = vec4(0.0, 0.0, 0.0, 1.0);
+	}
 	
 	vec4 locPos = vec4(inPos.xyz * rotMat, 1.0);
 	vec4 pos = vec4((locPos.xyz * instanceScale) + instancePos, 1.0);
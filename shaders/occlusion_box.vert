@@ -0,0 +1,50 @@
+#version 450
+/* Copyright (c) 2020, Arm Limited and Contributors
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 the "License";
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+// Draws the world bounds of a mesh instance as 36 vertices, for an occlusion query
+
+layout(push_constant, std430) uniform BoxUniform
+{
+	mat4 view_proj;
+	vec4 bounds_min;
+	vec4 bounds_max;
+}
+box_uniform;
+
+// Two triangles for each face of the box, indexing the corners selected by the bits of their index
+const uint corner_indices[36] = uint[](
+    0, 2, 6, 0, 6, 4,
+    1, 5, 7, 1, 7, 3,
+    0, 4, 5, 0, 5, 1,
+    2, 3, 7, 2, 7, 6,
+    0, 1, 3, 0, 3, 2,
+    4, 6, 7, 4, 7, 5);
+
+out gl_PerVertex
+{
+	vec4 gl_Position;
+};
+
+void main(void)
+{
+	uint corner = corner_indices[gl_VertexIndex];
+
+	vec3 position = mix(box_uniform.bounds_min.xyz, box_uniform.bounds_max.xyz, vec3(corner & 1u, (corner >> 1) & 1u, (corner >> 2) & 1u));
+
+	gl_Position = box_uniform.view_proj * vec4(position, 1.0);
+}
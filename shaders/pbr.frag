@@ -63,12 +63,51 @@ struct Light
 	vec2 info;             // (only used for spot lights) info.x represents light inner cone angle, info.y represents light outer cone angle
 };
 
+#ifdef CLUSTERED_LIGHTING
+layout(std430, set = 0, binding = 4) readonly buffer LightsInfo
+{
+	Light lights[];
+}
+lights;
+
+layout(std430, set = 0, binding = 5) readonly buffer ClusterLightCounts
+{
+	uint counts[];
+}
+cluster_light_counts;
+
+layout(std430, set = 0, binding = 6) readonly buffer ClusterLightIndices
+{
+	uint indices[];
+}
+cluster_light_indices;
+
+layout(set = 0, binding = 7) uniform ClusterUniform
+{
+	mat4  view;
+	mat4  inv_projection;
+	vec4  depth_range;        // x is the near plane, y the far plane, z the number of slices over log(far / near)
+	uvec4 counts;             // x is the number of lights, y the number of directional lights
+	vec2  inv_resolution;     // Maps fragment coordinates to screen tiles
+}
+cluster_uniform;
+
+// Finds the cluster of the fragment from its screen tile and its view depth
+uint get_cluster(vec3 pos)
+{
+	float view_depth = -(cluster_uniform.view * vec4(pos, 1.0)).z;
+	uint  slice      = uint(max(log(view_depth / cluster_uniform.depth_range.x) * cluster_uniform.depth_range.z, 0.0));
+	uvec2 tile       = uvec2(clamp(gl_FragCoord.xy * cluster_uniform.inv_resolution, vec2(0.0), vec2(0.999999)) * vec2(LIGHT_CLUSTER_COUNT_X, LIGHT_CLUSTER_COUNT_Y));
+	return (min(slice, uint(LIGHT_CLUSTER_COUNT_Z - 1)) * LIGHT_CLUSTER_COUNT_Y + tile.y) * LIGHT_CLUSTER_COUNT_X + tile.x;
+}
+#else
 layout(set = 0, binding = 4) uniform LightsInfo
 {
 	uint  count;
 	Light lights[MAX_FORWARD_LIGHT_COUNT];
 }
 lights;
+#endif
 
 layout(push_constant, std430) uniform PBRMaterialUniform
 {
@@ -165,6 +204,41 @@ vec3 saturate(vec3 t)
 	return clamp(t, 0.0, 1.0);
 }
 
+#ifdef SHADOWS
+precision highp sampler2DArrayShadow;
+
+layout(set = 0, binding = 8) uniform ShadowUniform
+{
+	mat4  light_view_proj[MAX_SHADOW_CASCADE_COUNT];
+	vec4  cascade_spheres[MAX_SHADOW_CASCADE_COUNT];        // xyz is the center of a cascade, w its squared radius
+	uvec4 info;                                             // x is the number of cascades, y the index of the shadowed light
+}
+shadow_uniform;
+
+layout(set = 0, binding = 9) uniform sampler2DArrayShadow shadow_maps;
+#endif
+
+// Fraction of a light reaching the fragment, sampled from the first cascade containing it
+float get_shadow(uint index)
+{
+#ifdef SHADOWS
+	if (index == shadow_uniform.info.y)
+	{
+		for (uint i = 0U; i < shadow_uniform.info.x; i++)
+		{
+			vec3 offset = in_pos.xyz - shadow_uniform.cascade_spheres[i].xyz;
+
+			if (dot(offset, offset) < shadow_uniform.cascade_spheres[i].w)
+			{
+				vec4 coord = shadow_uniform.light_view_proj[i] * vec4(in_pos.xyz, 1.0);
+				return texture(shadow_maps, vec4(coord.xy * 0.5 + 0.5, float(i), coord.z));
+			}
+		}
+	}
+#endif
+	return 1.0;
+}
+
 vec3 apply_directional_light(uint index, vec3 normal)
 {
 	vec3 world_to_light = -lights.lights[index].direction.xyz;
@@ -173,7 +247,7 @@ vec3 apply_directional_light(uint index, vec3 normal)
 
 	float ndotl = clamp(dot(normal, world_to_light), 0.0, 1.0);
 
-	return ndotl * lights.lights[index].color.w * lights.lights[index].color.rgb;
+	return ndotl * lights.lights[index].color.w * lights.lights[index].color.rgb * get_shadow(index);
 }
 
 vec3 apply_point_light(uint index, vec3 normal)
@@ -203,6 +277,35 @@ vec3 get_light_direction(uint index)
 	}
 }
 
+// Specular and diffuse contribution of a light
+vec3 apply_light(uint index, vec3 N, vec3 V, float NdotV, float roughness, float F90, vec3 diffuse_color)
+{
+	vec3 L = get_light_direction(index);
+	vec3 H = normalize(V + L);
+
+	float LdotH = saturate(dot(L, H));
+	float NdotH = saturate(dot(N, H));
+	float NdotL = saturate(dot(N, L));
+
+	vec3  F   = F_Schlick(F0, F90, LdotH);
+	float Vis = V_SmithGGXCorrelated(NdotV, NdotL, roughness);
+	float D   = D_GGX(NdotH, roughness);
+	vec3  Fr  = F * D * Vis;
+
+	float Fd = Fr_DisneyDiffuse(NdotV, NdotL, LdotH, roughness);
+
+	if (lights.lights[index].position.w == DIRECTIONAL_LIGHT)
+	{
+		return apply_directional_light(index, N) * (diffuse_color * (vec3(1.0) - F) * Fd + Fr);
+	}
+	if (lights.lights[index].position.w == POINT_LIGHT)
+	{
+		return apply_point_light(index, N) * (diffuse_color * (vec3(1.0) - F) * Fd + Fr);
+	}
+
+	return vec3(0.0);
+}
+
 void main(void)
 {
 	// vec3 position = vec3(0, 0, 0);
@@ -231,31 +334,25 @@ void main(void)
 	vec3 LightContribution = vec3(0.0);
 	vec3 diffuse_color     = base_color.rgb * (1.0 - metallic);
 
-	for (uint i = 0U; i < lights.count; ++i)
+#ifdef CLUSTERED_LIGHTING
+	for (uint i = 0U; i < cluster_uniform.counts.y; ++i)
 	{
-		vec3 L = get_light_direction(i);
-		vec3 H = normalize(V + L);
-
-		float LdotH = saturate(dot(L, H));
-		float NdotH = saturate(dot(N, H));
-		float NdotL = saturate(dot(N, L));
-
-		vec3  F   = F_Schlick(F0, F90, LdotH);
-		float Vis = V_SmithGGXCorrelated(NdotV, NdotL, roughness);
-		float D   = D_GGX(NdotH, roughness);
-		vec3  Fr  = F * D * Vis;
+		LightContribution += apply_light(i, N, V, NdotV, roughness, F90, diffuse_color);
+	}
 
-		float Fd = Fr_DisneyDiffuse(NdotV, NdotL, LdotH, roughness);
+	uint cluster = get_cluster(in_pos);
+	uint count   = cluster_light_counts.counts[cluster];
 
-		if (lights.lights[i].position.w == DIRECTIONAL_LIGHT)
-		{
-			LightContribution += apply_directional_light(i, N) * (diffuse_color * (vec3(1.0) - F) * Fd + Fr);
-		}
-		if (lights.lights[i].position.w == POINT_LIGHT)
-		{
-			LightContribution += apply_point_light(i, N) * (diffuse_color * (vec3(1.0) - F) * Fd + Fr);
-		}
+	for (uint i = 0U; i < count; ++i)
+	{
+		LightContribution += apply_light(cluster_light_indices.indices[cluster * MAX_LIGHTS_PER_CLUSTER + i], N, V, NdotV, roughness, F90, diffuse_color);
 	}
+#else
+	for (uint i = 0U; i < lights.count; ++i)
+	{
+		LightContribution += apply_light(i, N, V, NdotV, roughness, F90, diffuse_color);
+	}
+#endif
 
 	// [1] Tempory irradiance to fix dark metals
 	// TODO: add specular irradiance for realistic metals
@@ -36,12 +36,14 @@ struct Light
 	vec4 color;
 };
 
+#ifndef CLUSTERED_LIGHTING
 layout(set = 0, binding = 4) uniform LightsInfo
 {
 	uint  count;
 	Light lights[MAX_FORWARD_LIGHT_COUNT];
 }
 lights;
+#endif
 
 layout(location = 0) out vec3 o_pos;
 layout(location = 1) out vec2 o_uv;
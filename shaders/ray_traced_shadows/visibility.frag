@@ -0,0 +1,159 @@
+#version 460
+/* Copyright (c) 2020, Arm Limited and Contributors
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 the "License";
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#extension GL_EXT_ray_query : require
+
+precision highp float;
+
+layout(input_attachment_index = 0, binding = 0) uniform subpassInput i_depth;
+layout(input_attachment_index = 1, binding = 1) uniform subpassInput i_normal;
+
+layout(location = 0) in vec2 in_uv;
+layout(location = 0) out vec4 o_visibility;
+
+layout(set = 0, binding = 2) uniform VisibilityUniform
+{
+    mat4  inv_view_proj;
+    mat4  prev_view_proj;
+    vec4  light_direction;        // w is 0 if there is no directional light
+    vec4  parameters;             // x is the ambient occlusion radius, y the history weight, z the ray offset, w whether the history is valid
+    uvec4 frame;                  // x is the frame index, y the trace stride, zw the pixel of every tile traced this frame
+    vec2  resolution;
+}
+visibility_uniform;
+
+layout(set = 0, binding = 3) uniform accelerationStructureEXT top_level;
+
+layout(set = 0, binding = 4, rgba16f) uniform readonly image2D history_in;
+layout(set = 0, binding = 5, rgba16f) uniform writeonly image2D history_out;
+
+// Relative depth difference beyond which the reprojected history belongs to another surface
+const float DEPTH_THRESHOLD = 0.05;
+
+const float PI = 3.14159265359;
+
+uint hash(uint x)
+{
+    x ^= x >> 16;
+    x *= 0x7feb352dU;
+    x ^= x >> 15;
+    x *= 0x846ca68bU;
+    x ^= x >> 16;
+    return x;
+}
+
+float random(inout uint state)
+{
+    state = hash(state);
+    return float(state >> 8) / 16777216.0;
+}
+
+// Returns 1 if nothing is hit from origin along direction within t_max
+float trace(vec3 origin, vec3 direction, float t_max)
+{
+    rayQueryEXT ray_query;
+    rayQueryInitializeEXT(ray_query, top_level, gl_RayFlagsTerminateOnFirstHitEXT | gl_RayFlagsOpaqueEXT, 0xFF, origin, 0.0, direction, t_max);
+
+    while (rayQueryProceedEXT(ray_query))
+    {
+    }
+
+    return rayQueryGetIntersectionTypeEXT(ray_query, true) == gl_RayQueryCommittedIntersectionNoneEXT ? 1.0 : 0.0;
+}
+
+vec3 cosine_weighted_direction(vec3 normal, inout uint state)
+{
+    float u = random(state);
+    float v = random(state);
+
+    float r   = sqrt(u);
+    float phi = 2.0 * PI * v;
+
+    vec3 tangent   = normalize(abs(normal.z) < 0.999 ? cross(normal, vec3(0.0, 0.0, 1.0)) : cross(normal, vec3(1.0, 0.0, 0.0)));
+    vec3 bitangent = cross(normal, tangent);
+
+    return normalize(r * cos(phi) * tangent + r * sin(phi) * bitangent + sqrt(1.0 - u) * normal);
+}
+
+void main()
+{
+    ivec2 pixel = ivec2(gl_FragCoord.xy);
+    float depth = subpassLoad(i_depth).x;
+
+    // Reversed depth is cleared to 0, which the sky keeps
+    if (depth == 0.0)
+    {
+        imageStore(history_out, pixel, vec4(1.0, 1.0, 0.0, 0.0));
+        o_visibility = vec4(1.0);
+        return;
+    }
+
+    // Retrieve position from depth
+    vec4 clip    = vec4(in_uv * 2.0 - 1.0, depth, 1.0);
+    vec4 world_w = visibility_uniform.inv_view_proj * clip;
+    vec3 pos     = world_w.xyz / world_w.w;
+
+    // Transform from [0,1] to [-1,1]
+    vec3 normal = normalize(2.0 * subpassLoad(i_normal).xyz - 1.0);
+
+    // Find the visibility the previous frames accumulated at this position
+    vec4 history       = vec4(0.0);
+    bool history_valid = false;
+
+    if (visibility_uniform.parameters.w > 0.0)
+    {
+        vec4 prev_clip = visibility_uniform.prev_view_proj * vec4(pos, 1.0);
+        vec3 prev_ndc  = prev_clip.xyz / prev_clip.w;
+        ivec2 prev_pixel = ivec2((prev_ndc.xy * 0.5 + 0.5) * visibility_uniform.resolution);
+
+        if (all(greaterThanEqual(prev_pixel, ivec2(0))) && all(lessThan(prev_pixel, ivec2(visibility_uniform.resolution))))
+        {
+            history       = imageLoad(history_in, prev_pixel);
+            history_valid = history.w > 0.0 && abs(history.z - prev_ndc.z) < DEPTH_THRESHOLD * prev_ndc.z;
+        }
+    }
+
+    uvec2 tile_pixel = uvec2(pixel) % visibility_uniform.frame.y;
+    bool  traced     = !history_valid || all(equal(tile_pixel, visibility_uniform.frame.zw));
+
+    vec2 visibility = history.xy;
+
+    if (traced)
+    {
+        vec3 origin = pos + normal * visibility_uniform.parameters.z;
+
+        vec2 current = vec2(1.0);
+
+        if (visibility_uniform.light_direction.w > 0.0)
+        {
+            vec3 to_light = -visibility_uniform.light_direction.xyz;
+            current.x     = dot(normal, to_light) > 0.0 ? trace(origin, to_light, 10000.0) : 0.0;
+        }
+
+        if (visibility_uniform.parameters.x > 0.0)
+        {
+            uint state = hash(uint(pixel.x) + hash(uint(pixel.y) + hash(visibility_uniform.frame.x)));
+            current.y  = trace(origin, cosine_weighted_direction(normal, state), visibility_uniform.parameters.x);
+        }
+
+        visibility = history_valid ? mix(current, history.xy, visibility_uniform.parameters.y) : current;
+    }
+
+    imageStore(history_out, pixel, vec4(visibility, depth, 1.0));
+    o_visibility = vec4(visibility, 0.0, 1.0);
+}
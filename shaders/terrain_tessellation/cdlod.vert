@@ -0,0 +1,116 @@
+#version 450
+/* Copyright (c) 2020, Arm Limited and Contributors
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 the "License";
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+layout (set = 0, binding = 0) uniform UBO 
+{
+	mat4 projection;
+	mat4 modelview;
+	vec4 lightPos;
+	vec4 frustumPlanes[6];
+	float displacementFactor;
+	float tessellationFactor;
+	vec2 viewportDim;
+	float tessellatedEdgeSize;
+} ubo; 
+
+layout (set = 0, binding = 1) uniform sampler2D samplerHeight; 
+
+layout (set = 0, binding = 3) uniform usampler2D pageTable;
+
+layout (set = 0, binding = 4) uniform VirtualTexture
+{
+	uvec2 pageCount;
+	uint levelCount;
+	uint cacheSlots;
+	uint pageSize;
+	uint pageBorder;
+} vt;
+
+// Samples the height map from the finest resident page covering the requested level
+float sampleHeight(vec2 uv, uint level)
+{
+	uv = clamp(uv, vec2(0.0), vec2(1.0));
+	level = min(level, vt.levelCount - 1u);
+
+	// The page table points to the page itself or to its finest resident ancestor
+	uvec2 pages = vt.pageCount >> level;
+	uvec4 entry = texelFetch(pageTable, ivec2(min(uvec2(uv * vec2(pages)), pages - 1u)), int(level));
+
+	vec2 residentPages = vec2(vt.pageCount >> entry.z);
+	vec2 inPage = uv * residentPages - min(floor(uv * residentPages), residentPages - 1.0);
+
+	float slotSize = float(vt.pageSize + 2u * vt.pageBorder);
+	vec2 texel = vec2(entry.xy) * slotSize + float(vt.pageBorder) + inPage * float(vt.pageSize);
+	return textureLod(samplerHeight, texel / (float(vt.cacheSlots) * slotSize), 0.0).r;
+}
+
+layout (set = 0, binding = 6) uniform CDLOD
+{
+	vec4 cameraPos;
+	vec4 terrain;
+	float gridSize;
+	float morphStartRatio;
+} cdlod;
+
+layout (location = 0) in vec2 inGridPos;
+layout (location = 1) in vec4 inNode;
+
+layout (location = 0) out vec3 outNormal;
+layout (location = 1) out vec2 outUV;
+layout (location = 2) out vec3 outViewVec;
+layout (location = 3) out vec3 outLightVec;
+layout (location = 4) out vec3 outEyePos;
+layout (location = 5) out vec3 outWorldPos;
+
+// Displacement of the terrain at a position of the xz plane, the terrain covering terrain.z from terrain.xy
+float terrainHeight(vec2 pos)
+{
+	return sampleHeight((pos - cdlod.terrain.xy) / cdlod.terrain.z, 0u) * ubo.displacementFactor;
+}
+
+void main()
+{
+	// The node holds its corner in xy, its size in z and the distance where it is fully morphed in w
+	float quadSize = inNode.z / cdlod.gridSize;
+	vec2 pos = inNode.xy + inGridPos * quadSize;
+
+	// Morph the odd vertices onto the grid of the parent level as they approach the end of the node range
+	float range = inNode.w;
+	float morphStart = mix(0.5 * range, range, cdlod.morphStartRatio);
+	float dist = distance(vec3(pos.x, -terrainHeight(pos), pos.y), cdlod.cameraPos.xyz);
+	float morph = clamp((dist - morphStart) / (range - morphStart), 0.0, 1.0);
+	pos -= fract(inGridPos * 0.5) * 2.0 * quadSize * morph;
+
+	vec4 worldPos = vec4(pos.x, -terrainHeight(pos), pos.y, 1.0);
+
+	// Normal from the heights of the neighbouring grid vertices
+	float left = terrainHeight(pos - vec2(quadSize, 0.0));
+	float right = terrainHeight(pos + vec2(quadSize, 0.0));
+	float back = terrainHeight(pos - vec2(0.0, quadSize));
+	float front = terrainHeight(pos + vec2(0.0, quadSize));
+	outNormal = normalize(vec3(left - right, 2.0 * quadSize, back - front));
+
+	outUV = (pos - cdlod.terrain.xy) / cdlod.terrain.z;
+	gl_Position = ubo.projection * ubo.modelview * worldPos;
+
+	// Calculate vectors for lighting based on the displaced position
+	outViewVec = -worldPos.xyz;
+	outLightVec = normalize(ubo.lightPos.xyz + outViewVec);
+	outWorldPos = worldPos.xyz;
+	outEyePos = vec3(ubo.modelview * worldPos);
+}
@@ -18,6 +18,64 @@
 
 layout (set = 0, binding = 1) uniform sampler2D samplerHeight; 
 layout (set = 0, binding = 2) uniform sampler2DArray samplerLayers;
+layout (set = 0, binding = 3) uniform usampler2D pageTable;
+
+layout (set = 0, binding = 4) uniform VirtualTexture
+{
+	uvec2 pageCount;
+	uint levelCount;
+	uint cacheSlots;
+	uint pageSize;
+	uint pageBorder;
+} vt;
+
+// Samples the height map from the finest resident page covering the requested level
+float sampleHeight(vec2 uv, uint level)
+{
+	uv = clamp(uv, vec2(0.0), vec2(1.0));
+	level = min(level, vt.levelCount - 1u);
+
+	// The page table points to the page itself or to its finest resident ancestor
+	uvec2 pages = vt.pageCount >> level;
+	uvec4 entry = texelFetch(pageTable, ivec2(min(uvec2(uv * vec2(pages)), pages - 1u)), int(level));
+
+	vec2 residentPages = vec2(vt.pageCount >> entry.z);
+	vec2 inPage = uv * residentPages - min(floor(uv * residentPages), residentPages - 1.0);
+
+	float slotSize = float(vt.pageSize + 2u * vt.pageBorder);
+	vec2 texel = vec2(entry.xy) * slotSize + float(vt.pageBorder) + inPage * float(vt.pageSize);
+	return textureLod(samplerHeight, texel / (float(vt.cacheSlots) * slotSize), 0.0).r;
+}
+
+layout (std430, set = 0, binding = 5) writeonly buffer Feedback
+{
+	uint requested[];
+} feedback;
+
+// Level of the height map with a texel per fragment
+uint getLevel(vec2 uv)
+{
+	vec2 texel = uv * vec2(vt.pageCount * vt.pageSize);
+	vec2 dx = dFdx(texel);
+	vec2 dy = dFdy(texel);
+	float lod = 0.5 * log2(max(dot(dx, dx), dot(dy, dy)));
+	return uint(clamp(lod, 0.0, float(vt.levelCount - 1u)));
+}
+
+// Flags the page of the height map the fragment needs, for the page cache to stream it in
+void requestPage(vec2 uv, uint level)
+{
+	uint firstPage = 0u;
+	for (uint i = 0u; i < level; i++)
+	{
+		uvec2 levelPages = vt.pageCount >> i;
+		firstPage += levelPages.x * levelPages.y;
+	}
+
+	uvec2 pages = vt.pageCount >> level;
+	uvec2 page = min(uvec2(clamp(uv, vec2(0.0), vec2(1.0)) * vec2(pages)), pages - 1u);
+	feedback.requested[firstPage + page.y * pages.x + page.x] = 1u;
+}
 
 layout (location = 0) in vec3 inNormal;
 layout (location = 1) in vec2 inUV;
@@ -42,7 +100,9 @@ vec3 sampleTerrainLayer()
 	vec3 color = vec3(0.0);
 	
 	// Get height from displacement map
-	float height = textureLod(samplerHeight, inUV, 0.0).r * 255.0;
+	uint level = getLevel(inUV);
+	requestPage(inUV, level);
+	float height = sampleHeight(inUV, level) * 255.0;
 	
 	for (int i = 0; i < 6; i++)
 	{
@@ -23,12 +23,23 @@ layout (location = 1) in float inLodBias;
 layout (location = 2) in vec3 inNormal;
 layout (location = 3) in vec3 inViewVec;
 layout (location = 4) in vec3 inLightVec;
+layout (location = 5) in float inMinLod;
 
 layout (location = 0) out vec4 outFragColor;
 
 void main() 
 {
-	vec4 color = texture(samplerColor, inUV, inLodBias);
+	vec4 color;
+	if (inMinLod > 0.0)
+	{
+		// Finer mip levels are still streamed in, clamp to the resident ones
+		float lod = max(textureQueryLod(samplerColor, inUV).y + inLodBias, inMinLod);
+		color = textureLod(samplerColor, inUV, lod);
+	}
+	else
+	{
+		color = texture(samplerColor, inUV, inLodBias);
+	}
 
 	vec3 N = normalize(inNormal);
 	vec3 L = normalize(inLightVec);
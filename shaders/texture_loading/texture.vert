@@ -26,6 +26,7 @@ layout (binding = 0) uniform UBO
 	mat4 model;
 	vec4 viewPos;
 	float lodBias;
+	float minLod;
 } ubo;
 
 layout (location = 0) out vec2 outUV;
@@ -33,6 +34,7 @@ layout (location = 1) out float outLodBias;
 layout (location = 2) out vec3 outNormal;
 layout (location = 3) out vec3 outViewVec;
 layout (location = 4) out vec3 outLightVec;
+layout (location = 5) out float outMinLod;
 
 out gl_PerVertex 
 {
@@ -43,6 +45,7 @@ void main()
 {
 	outUV = inUV;
 	outLodBias = ubo.lodBias;
+	outMinLod = ubo.minLod;
 
 	vec3 worldPos = vec3(ubo.model * vec4(inPos, 1.0));
 
@@ -0,0 +1,51 @@
+#version 450
+/* Copyright (c) 2020, Arm Limited and Contributors
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 the "License";
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+precision highp float;
+
+layout(input_attachment_index = 0, binding = 0) uniform subpassInput i_accumulation;
+layout(input_attachment_index = 1, binding = 1) uniform subpassInput i_revealage;
+
+layout(location = 0) in vec2 in_uv;
+
+layout(location = 0) out vec4 o_color;
+
+// Composites the transparent fragments accumulated in weighted blended mode over the opaque color,
+// blended with the source alpha, which is the coverage of the transparent fragments
+void main(void)
+{
+	float revealage = subpassLoad(i_revealage).r;
+
+	// No transparent fragment covers the pixel
+	if (revealage >= 1.0)
+	{
+		discard;
+	}
+
+	vec4 accumulation = subpassLoad(i_accumulation);
+
+	// Sums of many fragments may overflow half floats
+	if (isinf(max(max(abs(accumulation.r), abs(accumulation.g)), abs(accumulation.b))))
+	{
+		accumulation.rgb = vec3(accumulation.a);
+	}
+
+	vec3 average_color = accumulation.rgb / max(accumulation.a, 1e-5);
+
+	o_color = vec4(average_color, 1.0 - revealage);
+}
@@ -0,0 +1,63 @@
+#version 450
+/* Copyright (c) 2020, Arm Limited and Contributors
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 the "License";
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+precision highp float;
+
+#ifdef HAS_BASE_COLOR_TEXTURE
+layout(set = 0, binding = 0) uniform sampler2D base_color_texture;
+#endif
+
+layout(location = 0) in vec3 in_pos;
+layout(location = 1) in vec2 in_uv;
+
+layout(set = 0, binding = 2, rgba8) uniform writeonly image3D voxels;
+
+layout(set = 0, binding = 3) uniform VoxelGridUniform
+{
+    vec4  origin;        // xyz is the minimum corner of the grid, w the size of a voxel
+    uvec4 info;          // x is the number of voxels along each axis
+}
+voxel_grid;
+
+layout(push_constant, std430) uniform PBRMaterialUniform
+{
+    vec4  base_color_factor;
+    float metallic_factor;
+    float roughness_factor;
+}
+pbr_material_uniform;
+
+void main(void)
+{
+    // Conservative rasterization may extrapolate the position slightly outside of the triangle
+    ivec3 voxel = ivec3(floor((in_pos - voxel_grid.origin.xyz) / voxel_grid.origin.w));
+
+    if (any(lessThan(voxel, ivec3(0))) || any(greaterThanEqual(voxel, ivec3(voxel_grid.info.x))))
+    {
+        return;
+    }
+
+#ifdef HAS_BASE_COLOR_TEXTURE
+    vec4 base_color = texture(base_color_texture, in_uv);
+#else
+    vec4 base_color = pbr_material_uniform.base_color_factor;
+#endif
+
+    // Alpha marks the voxel as occupied
+    imageStore(voxels, voxel, vec4(base_color.rgb, 1.0));
+}
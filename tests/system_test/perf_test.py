@@ -0,0 +1,228 @@
+'''
+Copyright (c) 2020, Arm Limited and Contributors
+
+SPDX-License-Identifier: Apache-2.0
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+'''
+
+import sys, os, re, json, platform, subprocess, argparse
+
+# Settings
+samples                = []
+build_path             = ""
+build_config           = ""
+benchmark_frames       = 500
+warmup_frames          = 100
+update_baselines       = False
+script_path            = os.path.dirname(os.path.realpath(__file__))
+root_path              = os.path.join(script_path, "../../")
+baselines_path         = os.path.join(script_path, "perf_baselines/")
+report_path            = "output/graphs/benchmark.json"
+frame_time_metrics     = ("cpu_frame_time_ms", "gpu_frame_time_ms")
+frame_time_percentiles = ("p50", "p95", "p99")
+memory_metrics         = ("device_memory_mb",)
+frame_time_threshold   = 0.10 # How much slower than the baseline a frame time percentile may be before it fails
+memory_threshold       = 0.05 # How much higher than the baseline a memory high-water mark may be before it fails
+default_samples        = ["afbc", "command_buffer_usage", "constant_data", "descriptor_management", "layout_transitions",
+                          "msaa", "pipeline_barriers", "render_passes", "render_subpasses", "specialization_constants",
+                          "swapchain_images", "wait_idle"]
+
+def get_app_path():
+    """
+    @brief  Gets the path to the desktop application, relative to the root of the project
+    @return The path of the vulkan_samples executable
+    """
+    if platform.system() == "Windows":
+        return "{}app/bin/{}/{}/vulkan_samples.exe".format(build_path, build_config, platform.machine())
+    return "{}app/bin/{}/vulkan_samples".format(build_path, platform.machine())
+
+def run_benchmark(sample):
+    """
+    @brief   Runs a sample in headless benchmark mode and reads the report it writes
+    @param   sample The id of the sample to run
+    @return  The metrics of the sample from the benchmark report, or None if the run failed
+    """
+    path = os.path.join(root_path, get_app_path())
+    report = os.path.join(root_path, report_path)
+    arguments = ["--sample", sample, "--headless", "--benchmark", str(benchmark_frames), "--benchmark-warmup", str(warmup_frames)]
+    if os.path.isfile(report):
+        os.remove(report)
+    try:
+        subprocess.run([path] + arguments, cwd=root_path, check=True)
+    except FileNotFoundError:
+        print("\t\t(Error) Couldn't find application ({})".format(path))
+        return None
+    except subprocess.CalledProcessError as e:
+        print("\t\t(Error) Application exited with code {} ({})".format(e.returncode, path))
+        return None
+    try:
+        with open(report) as report_file:
+            data = json.load(report_file)
+    except (FileNotFoundError, ValueError):
+        print("\t\t(Error) Couldn't read benchmark report ({})".format(report))
+        return None
+    if sample not in data["groups"]:
+        print("\t\t(Error) Benchmark report has no results for {}".format(sample))
+        return None
+    return data["device"], data["groups"][sample]
+
+def get_baseline_file(device):
+    """
+    @brief   Gets the baseline file of a GPU
+    @param   device The name of the GPU, as reported by the driver
+    @return  The path to the baseline file
+    """
+    return baselines_path + re.sub(r"[^A-Za-z0-9]+", "_", device).strip("_").lower() + ".json"
+
+def load_baselines(device):
+    """
+    @brief   Loads the stored baselines of a GPU
+    @param   device The name of the GPU
+    @return  A dictionary of the baseline metrics of each sample, empty if there are none
+    """
+    baseline_file = get_baseline_file(device)
+    if not os.path.isfile(baseline_file):
+        return {}
+    with open(baseline_file) as f:
+        return json.load(f)["samples"]
+
+def save_baselines(device, baselines):
+    """
+    @brief   Stores the baselines of a GPU
+    @param   device    The name of the GPU
+    @param   baselines A dictionary of the baseline metrics of each sample
+    """
+    if not os.path.exists(baselines_path):
+        os.makedirs(baselines_path)
+    with open(get_baseline_file(device), "w") as f:
+        json.dump({"device": device, "samples": baselines}, f, indent=4, sort_keys=True)
+        f.write("\n")
+
+def make_baseline(metrics):
+    """
+    @brief   Extracts the values that are compared against from the metrics of a run
+    @param   metrics The metrics of a sample from the benchmark report
+    @return  A dictionary with the frame time percentiles and memory high-water marks
+    """
+    baseline = {}
+    for metric in frame_time_metrics:
+        if metric in metrics:
+            baseline[metric] = {percentile: metrics[metric][percentile] for percentile in frame_time_percentiles}
+    for metric in memory_metrics:
+        if metric in metrics:
+            baseline[metric] = {"max": metrics[metric]["max"]}
+    return baseline
+
+def compare(current, baseline):
+    """
+    @brief   Compares the values of a run against its baseline
+    @param   current  The baseline dictionary made from the current run
+    @param   baseline The stored baseline dictionary
+    @return  True if no value regressed past its threshold
+    """
+    result = True
+    for metric, values in sorted(baseline.items()):
+        threshold = memory_threshold if metric in memory_metrics else frame_time_threshold
+        for key, base_value in sorted(values.items()):
+            if metric not in current or key not in current[metric]:
+                print("\t\t(Error) {} {} missing from the run".format(metric, key))
+                result = False
+                continue
+            value = current[metric][key]
+            change = (value - base_value) / base_value if base_value > 0 else 0.0
+            regressed = change > threshold
+            print("\t\t{:<20} {:<4} {:>10.3f} (baseline {:>10.3f}, {:+.1f}%){}".format(metric, key, value, base_value, 100 * change, " REGRESSED" if regressed else ""))
+            if regressed:
+                result = False
+    return result
+
+def main():
+    """
+    @brief Runs the performance test
+    """
+    print("=== Performance Test started! ===")
+    passed = 0
+    failed = 0
+    missing = 0
+
+    # Baselines are loaded per GPU, as reported by the first run on it
+    baselines = None
+    for sample in samples:
+        print("\t=== Benchmarking {} ===".format(sample))
+        run = run_benchmark(sample)
+        if run is None:
+            failed += 1
+            continue
+        device, metrics = run
+        if baselines is None:
+            baselines = load_baselines(device)
+            print("\t\tDevice: {} ({})".format(device, get_baseline_file(device)))
+        current = make_baseline(metrics)
+        if update_baselines:
+            baselines[sample] = current
+            print("\t\t=== Baseline updated ===")
+            passed += 1
+        elif sample not in baselines:
+            print("\t\t=== No baseline for this GPU, run with -U to create one ===")
+            missing += 1
+        elif compare(current, baselines[sample]):
+            print("\t\t=== Passed! ===")
+            passed += 1
+        else:
+            print("\t\t=== Failed. ===")
+            failed += 1
+
+    if update_baselines and baselines is not None:
+        save_baselines(device, baselines)
+
+    if failed == 0:
+        print("=== Success: {} passed - {} without baseline ===".format(passed, missing))
+        exit(0)
+    else:
+        print("=== Failed: {} passed - {} failed - {} without baseline ===".format(passed, failed, missing))
+        exit(1)
+
+if __name__ == "__main__":
+    argparser = argparse.ArgumentParser(formatter_class=argparse.ArgumentDefaultsHelpFormatter, description="A script that benchmarks samples headlessly and compares their frame times and memory usage against stored baselines of the GPU")
+    argparser.add_argument("-B", "--build", required=True, help="relative path to the cmake build directory")
+    argparser.add_argument("-C", "--config", required=True, help="build configuration to use")
+    argparser.add_argument("-S", "--samples", default=default_samples, nargs="+", help="if set the specified samples will be benchmarked instead")
+    argparser.add_argument("-F", "--frames", type=int, default=benchmark_frames, help="number of measured frames of each benchmark")
+    argparser.add_argument("-W", "--warmup", type=int, default=warmup_frames, help="number of frames run before measuring")
+    argparser.add_argument("-T", "--threshold", type=float, default=frame_time_threshold, help="allowed relative increase of a frame time percentile")
+    argparser.add_argument("-M", "--memory-threshold", type=float, default=memory_threshold, help="allowed relative increase of a memory high-water mark")
+    argparser.add_argument("-U", "--update", action='store_true', help="flag to store the results as the baselines of the GPU instead of comparing")
+
+    args = vars(argparser.parse_args())
+    build_path           = args["build"]
+    build_config         = args["config"]
+    samples              = args["samples"]
+    benchmark_frames     = args["frames"]
+    warmup_frames        = args["warmup"]
+    frame_time_threshold = args["threshold"]
+    memory_threshold     = args["memory_threshold"]
+    update_baselines     = args["update"]
+
+    if build_path[-1] != "/":
+        build_path += "/"
+
+    # Run script and handle keyboard interruption
+    try:
+        main()
+    except KeyboardInterrupt:
+        print("Performance Test Aborted")
+        try:
+            sys.exit(0)
+        except SystemExit:
+            os._exit(0)
@@ -0,0 +1,105 @@
+/* Copyright (c) 2020, Arm Limited and Contributors
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 the "License";
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "common/logging.h"
+#include "common/utils.h"
+#include "platform/asset_archive.h"
+#include "platform/filesystem.h"
+#include "scene_graph/components/image.h"
+
+namespace
+{
+/**
+ * @brief Transcodes an image file to the layout it is uploaded with, including its mip chain
+ * @return The packed image, or an empty vector if the file is not an image
+ */
+std::vector<uint8_t> pack_image(const std::string &uri, const std::vector<uint8_t> &file_data)
+{
+	auto image = vkb::sg::Image::decode(uri, uri, file_data.data(), file_data.size());
+
+	// Supercompressed images are transcoded for the device they are loaded on, so they are stored as is
+	if (!image || image->get_format() == VK_FORMAT_UNDEFINED)
+	{
+		return {};
+	}
+
+	// Mip levels are generated here rather than at load time, which is only possible for RGBA8 images
+	if (image->get_mipmaps().size() == 1 && image->get_layers() == 1 && image->get_offsets().empty() &&
+	    image->get_format() == VK_FORMAT_R8G8B8A8_UNORM)
+	{
+		image->generate_mipmaps();
+	}
+
+	return image->pack();
+}
+}        // namespace
+
+/**
+ * @brief Packs assets in an archive read by vkb::fs::AssetArchive
+ *        Paths are given relative to the assets directory, and are the keys the assets are found with at runtime.
+ */
+int main(int argc, char *argv[])
+{
+	if (argc < 4)
+	{
+		std::cerr << "Usage: asset_packer <assets directory> <output archive> <asset path>..." << std::endl;
+		return EXIT_FAILURE;
+	}
+
+	std::string assets_directory = argv[1];
+	if (assets_directory.back() != '/')
+	{
+		assets_directory += '/';
+	}
+
+	vkb::fs::AssetArchiveBuilder builder;
+
+	try
+	{
+		for (int i = 3; i < argc; ++i)
+		{
+			std::string uri = argv[i];
+
+			auto file_data = vkb::fs::read_file(assets_directory + uri);
+
+			auto packed_image = pack_image(uri, file_data);
+			if (!packed_image.empty())
+			{
+				LOGI("Packing image {} ({} bytes)", uri, packed_image.size());
+				builder.add(uri, vkb::fs::AssetArchive::EntryType::Image, std::move(packed_image));
+			}
+			else
+			{
+				LOGI("Packing file {} ({} bytes)", uri, file_data.size());
+				builder.add(uri, vkb::fs::AssetArchive::EntryType::File, std::move(file_data));
+			}
+		}
+
+		builder.write(argv[2]);
+	}
+	catch (const std::exception &e)
+	{
+		LOGE("Failed to pack assets: {}", e.what());
+		return EXIT_FAILURE;
+	}
+
+	return EXIT_SUCCESS;
+}
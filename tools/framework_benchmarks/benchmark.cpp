@@ -0,0 +1,224 @@
+/* Copyright (c) 2020, Arm Limited and Contributors
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 the "License";
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "benchmark.h"
+
+#include <algorithm>
+#include <fstream>
+#include <iostream>
+
+#include <nlohmann/json.hpp>
+
+#include "common/logging.h"
+#include "core/device.h"
+#include "core/instance.h"
+#include "rendering/render_context.h"
+
+namespace vkb
+{
+namespace benchmark
+{
+namespace
+{
+/// Iterations a benchmark runs at most, whatever its time
+constexpr uint64_t MAX_ITERATION_COUNT = 1000000000;
+}        // namespace
+
+State::State(uint64_t iteration_count) :
+    iteration_count{iteration_count}
+{
+}
+
+bool State::keep_running()
+{
+	if (iteration == 0)
+	{
+		start = Timer::Clock::now();
+	}
+
+	if (iteration < iteration_count)
+	{
+		++iteration;
+		return true;
+	}
+
+	if (!paused)
+	{
+		elapsed_time += Timer::Clock::now() - start;
+	}
+
+	return false;
+}
+
+void State::pause_timing()
+{
+	if (!paused)
+	{
+		elapsed_time += Timer::Clock::now() - start;
+		paused = true;
+	}
+}
+
+void State::resume_timing()
+{
+	if (paused)
+	{
+		start  = Timer::Clock::now();
+		paused = false;
+	}
+}
+
+uint64_t State::get_iteration() const
+{
+	return iteration > 0 ? iteration - 1 : 0;
+}
+
+uint64_t State::get_iteration_count() const
+{
+	return iteration_count;
+}
+
+double State::get_elapsed_time() const
+{
+	return static_cast<double>(elapsed_time.count());
+}
+
+HeadlessContext::HeadlessContext() = default;
+
+HeadlessContext::~HeadlessContext()
+{
+	if (device)
+	{
+		device->wait_idle();
+	}
+}
+
+Device &HeadlessContext::get_device()
+{
+	if (!device)
+	{
+		instance = std::make_unique<Instance>("framework_benchmarks", std::unordered_map<const char *, bool>{}, std::vector<const char *>{}, true);
+		device   = std::make_unique<Device>(instance->get_suitable_gpu(), VK_NULL_HANDLE);
+
+		LOGI("Benchmarking on {}", device->get_gpu().get_properties().deviceName);
+	}
+
+	return *device;
+}
+
+RenderContext &HeadlessContext::get_render_context()
+{
+	if (!render_context)
+	{
+		render_context = std::make_unique<RenderContext>(get_device(), VK_NULL_HANDLE, 1280, 720);
+		render_context->prepare();
+	}
+
+	return *render_context;
+}
+
+VertexInputState get_base_vertex_input_state()
+{
+	VertexInputState vertex_input_state;
+
+	vertex_input_state.bindings = {{0, 3 * sizeof(float), VK_VERTEX_INPUT_RATE_VERTEX},
+	                               {1, 2 * sizeof(float), VK_VERTEX_INPUT_RATE_VERTEX},
+	                               {2, 3 * sizeof(float), VK_VERTEX_INPUT_RATE_VERTEX}};
+
+	vertex_input_state.attributes = {{0, 0, VK_FORMAT_R32G32B32_SFLOAT, 0},
+	                                 {1, 1, VK_FORMAT_R32G32_SFLOAT, 0},
+	                                 {2, 2, VK_FORMAT_R32G32B32_SFLOAT, 0}};
+
+	return vertex_input_state;
+}
+
+void Registry::add(const std::string &name, Function &&function)
+{
+	benchmarks.push_back({name, std::move(function)});
+}
+
+bool Registry::run(const std::string &filter, double min_time, const std::string &json_filename) const
+{
+	nlohmann::json results = nlohmann::json::array();
+
+	bool success = true;
+
+	std::cout << fmt::format("{:<48} {:>12} {:>14}", "Benchmark", "Iterations", "ns/iteration") << std::endl;
+
+	for (auto &benchmark : benchmarks)
+	{
+		if (!filter.empty() && benchmark.name.find(filter) == std::string::npos)
+		{
+			continue;
+		}
+
+		uint64_t iteration_count = 1;
+		double   elapsed_time    = 0.0;
+
+		try
+		{
+			// Each run predicts the iterations reaching the minimum time from the previous one
+			while (true)
+			{
+				State state{iteration_count};
+				benchmark.function(state);
+
+				elapsed_time = state.get_elapsed_time();
+
+				if (elapsed_time >= min_time * 1e9 || iteration_count >= MAX_ITERATION_COUNT)
+				{
+					break;
+				}
+
+				double growth   = elapsed_time > 0.0 ? 1.4 * min_time * 1e9 / elapsed_time : 10.0;
+				iteration_count = std::min(static_cast<uint64_t>(iteration_count * std::min(std::max(growth, 2.0), 10.0)), MAX_ITERATION_COUNT);
+			}
+		}
+		catch (const std::exception &e)
+		{
+			LOGE("Benchmark {} failed: {}", benchmark.name, e.what());
+			success = false;
+			continue;
+		}
+
+		double time_per_iteration = elapsed_time / iteration_count;
+
+		std::cout << fmt::format("{:<48} {:>12} {:>14.1f}", benchmark.name, iteration_count, time_per_iteration) << std::endl;
+
+		results.push_back({
+		    {"name", benchmark.name},
+		    {"iterations", iteration_count},
+		    {"ns_per_iteration", time_per_iteration},
+		});
+	}
+
+	if (!json_filename.empty())
+	{
+		std::ofstream file{json_filename};
+		file << results.dump(2) << std::endl;
+
+		if (!file)
+		{
+			LOGE("Failed to write benchmark results to {}", json_filename);
+			success = false;
+		}
+	}
+
+	return success;
+}
+}        // namespace benchmark
+}        // namespace vkb
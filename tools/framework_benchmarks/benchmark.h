@@ -0,0 +1,155 @@
+/* Copyright (c) 2020, Arm Limited and Contributors
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 the "License";
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "rendering/pipeline_state.h"
+#include "timer.h"
+
+namespace vkb
+{
+class Device;
+class Instance;
+class RenderContext;
+
+namespace benchmark
+{
+/**
+ * @brief Runs the timed loop of a benchmark, which measures the CPU time of an iteration
+ *
+ * The loop runs a fixed number of iterations, chosen by the runner to last long enough:
+ * @code
+ * while (state.keep_running())
+ * {
+ *     ...
+ * }
+ * @endcode
+ * Work between pause_timing and resume_timing, like resetting what the iterations filled, is not measured.
+ */
+class State
+{
+  public:
+	State(uint64_t iteration_count);
+
+	/**
+	 * @return True while iterations are left, starting the timer on the first call and stopping it after the last
+	 */
+	bool keep_running();
+
+	void pause_timing();
+
+	void resume_timing();
+
+	/**
+	 * @return Index of the current iteration
+	 */
+	uint64_t get_iteration() const;
+
+	uint64_t get_iteration_count() const;
+
+	/**
+	 * @return Nanoseconds measured over the iterations
+	 */
+	double get_elapsed_time() const;
+
+  private:
+	uint64_t iteration_count;
+
+	/// Iterations started, so the current one is iteration - 1
+	uint64_t iteration{0};
+
+	Timer::Clock::time_point start;
+
+	std::chrono::nanoseconds elapsed_time{0};
+
+	bool paused{false};
+};
+
+using Function = std::function<void(State &)>;
+
+/**
+ * @brief A device without a surface, created when a benchmark first needs it and shared by the following ones
+ */
+class HeadlessContext
+{
+  public:
+	HeadlessContext();
+
+	~HeadlessContext();
+
+	Device &get_device();
+
+	/**
+	 * @return A render context of headless frames prepared for a single thread
+	 */
+	RenderContext &get_render_context();
+
+  private:
+	std::unique_ptr<Instance> instance;
+
+	std::unique_ptr<Device> device;
+
+	std::unique_ptr<RenderContext> render_context;
+};
+
+/**
+ * @brief A named set of benchmarks, run in the order they were added
+ */
+class Registry
+{
+  public:
+	void add(const std::string &name, Function &&function);
+
+	/**
+	 * @brief Runs each benchmark whose name contains the filter, and prints its time per iteration
+	 *        The iteration count grows until the measured time reaches the minimum time.
+	 * @param filter Part of the names of the benchmarks to run, empty to run them all
+	 * @param min_time Seconds each benchmark is measured for at least
+	 * @param json_filename File the results are written to, empty to only print them
+	 * @return False if a benchmark threw, or the results could not be written
+	 */
+	bool run(const std::string &filter, double min_time, const std::string &json_filename) const;
+
+  private:
+	struct Benchmark
+	{
+		std::string name;
+
+		Function function;
+	};
+
+	std::vector<Benchmark> benchmarks;
+};
+
+/**
+ * @return The vertex input of the positions, texture coordinates and normals read by base.vert, each in its own binding
+ */
+VertexInputState get_base_vertex_input_state();
+
+void register_resource_cache_benchmarks(Registry &registry, HeadlessContext &context);
+
+void register_recording_benchmarks(Registry &registry, HeadlessContext &context);
+
+void register_scene_benchmarks(Registry &registry);
+}        // namespace benchmark
+}        // namespace vkb
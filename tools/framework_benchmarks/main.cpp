@@ -0,0 +1,64 @@
+/* Copyright (c) 2020, Arm Limited and Contributors
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 the "License";
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <iostream>
+#include <string>
+
+#include "benchmark.h"
+
+/**
+ * @brief Measures the CPU cost of the hot paths of the framework, on a headless device
+ *        Run from the root of the repository, so that the shaders are found.
+ */
+int main(int argc, char *argv[])
+{
+	std::string filter;
+	std::string json_filename;
+	double      min_time = 0.5;
+
+	for (int i = 1; i < argc; ++i)
+	{
+		std::string arg = argv[i];
+
+		if (i + 1 < argc && arg == "--filter")
+		{
+			filter = argv[++i];
+		}
+		else if (i + 1 < argc && arg == "--min-time")
+		{
+			min_time = std::stod(argv[++i]);
+		}
+		else if (i + 1 < argc && arg == "--json")
+		{
+			json_filename = argv[++i];
+		}
+		else
+		{
+			std::cerr << "Usage: framework_benchmarks [--filter <part of names>] [--min-time <seconds>] [--json <output file>]" << std::endl;
+			return EXIT_FAILURE;
+		}
+	}
+
+	vkb::benchmark::Registry        registry;
+	vkb::benchmark::HeadlessContext context;
+
+	vkb::benchmark::register_resource_cache_benchmarks(registry, context);
+	vkb::benchmark::register_recording_benchmarks(registry, context);
+	vkb::benchmark::register_scene_benchmarks(registry);
+
+	return registry.run(filter, min_time, json_filename) ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,208 @@
+/* Copyright (c) 2020, Arm Limited and Contributors
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 the "License";
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "benchmark.h"
+
+#include <algorithm>
+#include <array>
+
+#include "buffer_pool.h"
+#include "core/buffer.h"
+#include "core/device.h"
+#include "rendering/render_context.h"
+#include "resource_cache.h"
+
+namespace vkb
+{
+namespace benchmark
+{
+namespace
+{
+/// Size of the uniform allocations, the size of the global uniform of the samples rounded up
+constexpr uint32_t UNIFORM_ALLOCATION_SIZE = 256;
+
+/// Draws recorded in a frame before the benchmark submits it and begins the next one
+constexpr uint64_t DRAWS_PER_FRAME = 4096;
+
+/**
+ * @return The pipeline layout of the base shaders, with the shader modules held by the cache of the device
+ */
+PipelineLayout &request_base_pipeline_layout(Device &device)
+{
+	auto &cache = device.get_resource_cache();
+
+	auto &vertex_shader   = cache.request_shader_module(VK_SHADER_STAGE_VERTEX_BIT, ShaderSource{"base.vert"});
+	auto &fragment_shader = cache.request_shader_module(VK_SHADER_STAGE_FRAGMENT_BIT, ShaderSource{"base.frag"});
+
+	return cache.request_pipeline_layout({&vertex_shader, &fragment_shader});
+}
+
+/**
+ * @return The size of the push constants declared by a pipeline layout
+ */
+uint32_t get_push_constants_size(const PipelineLayout &pipeline_layout)
+{
+	uint32_t size = 0;
+
+	for (auto &resource : pipeline_layout.get_resources(ShaderResourceType::PushConstant))
+	{
+		size = std::max(size, resource.offset + resource.size);
+	}
+
+	return size;
+}
+}        // namespace
+
+void register_recording_benchmarks(Registry &registry, HeadlessContext &context)
+{
+	registry.add("buffer_pool/allocate", [&context](State &state) {
+		// Large enough for a block to serve most of the allocations between two resets
+		BufferPool pool{context.get_device(), 1024 * 1024, VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT};
+
+		const uint64_t allocations_per_reset = 4096;
+
+		while (state.keep_running())
+		{
+			if (state.get_iteration() % allocations_per_reset == 0)
+			{
+				state.pause_timing();
+				pool.reset();
+				state.resume_timing();
+			}
+
+			auto &block      = pool.request_buffer_block(UNIFORM_ALLOCATION_SIZE);
+			auto  allocation = block.allocate(UNIFORM_ALLOCATION_SIZE);
+
+			if (allocation.empty())
+			{
+				throw std::runtime_error("Buffer pool allocation failed");
+			}
+		}
+	});
+
+	registry.add("descriptor_set/reset_update", [&context](State &state) {
+		auto &device          = context.get_device();
+		auto &pipeline_layout = request_base_pipeline_layout(device);
+		auto &set_layout      = pipeline_layout.get_descriptor_set_layout(0);
+
+		core::Buffer buffer{device, 2 * UNIFORM_ALLOCATION_SIZE, VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT, VMA_MEMORY_USAGE_CPU_TO_GPU};
+
+		// Two contents the set alternates between, so that each update writes different descriptors
+		std::vector<BindingMap<VkDescriptorBufferInfo>> buffer_infos(2);
+		for (auto &resource : pipeline_layout.get_resources(ShaderResourceType::BufferUniform))
+		{
+			if (resource.set != 0)
+			{
+				continue;
+			}
+
+			for (uint32_t i = 0; i < 2; ++i)
+			{
+				buffer_infos[i][resource.binding][0] = {buffer.get_handle(), i * UNIFORM_ALLOCATION_SIZE, std::min(resource.size, UNIFORM_ALLOCATION_SIZE)};
+			}
+		}
+
+		ResourceCache cache{device};
+		auto &        descriptor_set = cache.request_descriptor_set(set_layout, buffer_infos[0], {});
+
+		while (state.keep_running())
+		{
+			descriptor_set.reset(buffer_infos[state.get_iteration() % 2]);
+			descriptor_set.update();
+		}
+	});
+
+	registry.add("command_buffer/bind_draw", [&context](State &state) {
+		auto &device          = context.get_device();
+		auto &render_context  = context.get_render_context();
+		auto &pipeline_layout = request_base_pipeline_layout(device);
+		auto  uniforms        = pipeline_layout.get_resources(ShaderResourceType::BufferUniform);
+
+		std::vector<uint8_t> push_constants(get_push_constants_size(pipeline_layout), 0);
+
+		// A single triangle, the buffer holds the positions, texture coordinates and normals of the three bindings
+		core::Buffer vertex_buffer{device, 3 * sizeof(float) * 8, VK_BUFFER_USAGE_VERTEX_BUFFER_BIT, VMA_MEMORY_USAGE_CPU_TO_GPU};
+		core::Buffer index_buffer{device, 3 * sizeof(uint32_t), VK_BUFFER_USAGE_INDEX_BUFFER_BIT, VMA_MEMORY_USAGE_CPU_TO_GPU};
+
+		std::vector<uint8_t> zeros(static_cast<size_t>(vertex_buffer.get_size()), 0);
+		vertex_buffer.update(zeros);
+		index_buffer.convert_and_update(std::array<uint32_t, 3>{0, 1, 2});
+
+		std::vector<LoadStoreInfo> load_store_infos{{VK_ATTACHMENT_LOAD_OP_CLEAR, VK_ATTACHMENT_STORE_OP_STORE},
+		                                            {VK_ATTACHMENT_LOAD_OP_CLEAR, VK_ATTACHMENT_STORE_OP_DONT_CARE}};
+
+		std::vector<VkClearValue> clear_values(2);
+		clear_values[1].depthStencil = {0.0f, ~0U};
+
+		SubpassInfo subpass_info{};
+		subpass_info.output_attachments = {0};
+
+		std::vector<SubpassInfo> subpass_infos{subpass_info};
+
+		ColorBlendState color_blend_state;
+		color_blend_state.attachments.resize(1);
+
+		auto begin_frame = [&]() -> CommandBuffer & {
+			auto &command_buffer = render_context.begin();
+			command_buffer.begin(VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT);
+
+			command_buffer.begin_render_pass(render_context.get_active_frame().get_render_target(), load_store_infos, clear_values, subpass_infos);
+			command_buffer.bind_pipeline_layout(pipeline_layout);
+			command_buffer.set_vertex_input_state(get_base_vertex_input_state());
+			command_buffer.set_color_blend_state(color_blend_state);
+			command_buffer.bind_vertex_buffers(0, {vertex_buffer, vertex_buffer, vertex_buffer}, {0, 12, 20});
+			command_buffer.bind_index_buffer(index_buffer, 0, VK_INDEX_TYPE_UINT32);
+
+			return command_buffer;
+		};
+
+		auto end_frame = [&](CommandBuffer &command_buffer) {
+			command_buffer.end_render_pass();
+			command_buffer.end();
+
+			render_context.submit(command_buffer);
+		};
+
+		CommandBuffer *command_buffer = &begin_frame();
+
+		while (state.keep_running())
+		{
+			if (state.get_iteration() > 0 && state.get_iteration() % DRAWS_PER_FRAME == 0)
+			{
+				state.pause_timing();
+				end_frame(*command_buffer);
+				command_buffer = &begin_frame();
+				state.resume_timing();
+			}
+
+			// Each draw binds uniforms of its own, as the draws of a scene do for their transforms
+			auto &frame = render_context.get_active_frame();
+			for (auto &uniform : uniforms)
+			{
+				auto allocation = frame.allocate_buffer(VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT, UNIFORM_ALLOCATION_SIZE);
+				command_buffer->bind_buffer(allocation.get_buffer(), allocation.get_offset(), std::min(uniform.size, UNIFORM_ALLOCATION_SIZE), uniform.set, uniform.binding, 0);
+			}
+
+			command_buffer->push_constants(push_constants);
+			command_buffer->draw_indexed(3, 1, 0, 0, 0);
+		}
+
+		end_frame(*command_buffer);
+	});
+}
+}        // namespace benchmark
+}        // namespace vkb
@@ -0,0 +1,425 @@
+/* Copyright (c) 2020, Arm Limited and Contributors
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 the "License";
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "benchmark.h"
+
+#include <algorithm>
+
+#include "common/logging.h"
+#include "common/resource_caching.h"
+#include "core/device.h"
+#include "rendering/render_context.h"
+#include "resource_cache.h"
+
+namespace vkb
+{
+namespace benchmark
+{
+namespace
+{
+/**
+ * @brief The objects the requests of the benchmarks depend on, held by a cache of their own
+ *        so that the cache of a benchmark only holds the objects it measures
+ */
+struct CacheSetup
+{
+	CacheSetup(HeadlessContext &context) :
+	    cache{context.get_device()},
+	    render_target{context.get_render_context().get_render_frames().at(0)->get_render_target()}
+	{
+		auto &device = context.get_device();
+
+
+		vertex_shader   = &cache.request_shader_module(VK_SHADER_STAGE_VERTEX_BIT, vertex_source);
+		fragment_shader = &cache.request_shader_module(VK_SHADER_STAGE_FRAGMENT_BIT, fragment_source);
+		pipeline_layout = &cache.request_pipeline_layout({vertex_shader, fragment_shader});
+
+		for (auto &resource : pipeline_layout->get_resources())
+		{
+			if (resource.set == 0)
+			{
+				set_resources.push_back(resource);
+			}
+		}
+
+		// The render pass matches the render targets of the context, so that framebuffers can be built for it
+		attachments = render_target.get_attachments();
+
+		load_store_infos = {{VK_ATTACHMENT_LOAD_OP_CLEAR, VK_ATTACHMENT_STORE_OP_STORE},
+		                    {VK_ATTACHMENT_LOAD_OP_CLEAR, VK_ATTACHMENT_STORE_OP_DONT_CARE}};
+
+		SubpassInfo subpass_info{};
+		subpass_info.output_attachments = {0};
+		subpass_infos                   = {subpass_info};
+
+		render_pass = &cache.request_render_pass(attachments, load_store_infos, subpass_infos);
+
+		ColorBlendState color_blend_state;
+		color_blend_state.attachments.resize(1);
+
+		pipeline_state.set_pipeline_layout(*pipeline_layout);
+		pipeline_state.set_render_pass(*render_pass);
+		pipeline_state.set_vertex_input_state(get_base_vertex_input_state());
+		pipeline_state.set_color_blend_state(color_blend_state);
+
+		sampler_info              = {VK_STRUCTURE_TYPE_SAMPLER_CREATE_INFO};
+		sampler_info.magFilter    = VK_FILTER_LINEAR;
+		sampler_info.minFilter    = VK_FILTER_LINEAR;
+		sampler_info.mipmapMode   = VK_SAMPLER_MIPMAP_MODE_LINEAR;
+		sampler_info.maxLod       = VK_LOD_CLAMP_NONE;
+		sampler_info.addressModeU = VK_SAMPLER_ADDRESS_MODE_REPEAT;
+		sampler_info.addressModeV = VK_SAMPLER_ADDRESS_MODE_REPEAT;
+		sampler_info.addressModeW = VK_SAMPLER_ADDRESS_MODE_REPEAT;
+
+		// Uniform buffer offsets are aligned, so that each key of the descriptor set misses binds a valid range
+		uniform_alignment = std::max<VkDeviceSize>(device.get_gpu().get_properties().limits.minUniformBufferOffsetAlignment, 256);
+		uniform_buffer    = std::make_unique<core::Buffer>(device, UNIFORM_KEY_COUNT * uniform_alignment, VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT, VMA_MEMORY_USAGE_CPU_TO_GPU);
+	}
+
+	/**
+	 * @return Uniform buffers bound to every uniform binding of set 0, at the offset of a key
+	 */
+	BindingMap<VkDescriptorBufferInfo> get_buffer_infos(uint64_t key) const
+	{
+		BindingMap<VkDescriptorBufferInfo> buffer_infos;
+
+		for (auto &resource : set_resources)
+		{
+			if (resource.type == ShaderResourceType::BufferUniform)
+			{
+				buffer_infos[resource.binding][0] = {uniform_buffer->get_handle(), key * uniform_alignment, std::min<VkDeviceSize>(resource.size, uniform_alignment)};
+			}
+		}
+
+		return buffer_infos;
+	}
+
+	DescriptorSetLayout &get_descriptor_set_layout() const
+	{
+		return pipeline_layout->get_descriptor_set_layout(0);
+	}
+
+	/// Different offsets bound by the descriptor sets
+	static constexpr uint64_t UNIFORM_KEY_COUNT = 256;
+
+	ResourceCache cache;
+
+	RenderTarget &render_target;
+
+	ShaderSource vertex_source{"base.vert"};
+
+	ShaderSource fragment_source{"base.frag"};
+
+	ShaderModule *vertex_shader{nullptr};
+
+	ShaderModule *fragment_shader{nullptr};
+
+	PipelineLayout *pipeline_layout{nullptr};
+
+	std::vector<ShaderResource> set_resources;
+
+	std::vector<Attachment> attachments;
+
+	std::vector<LoadStoreInfo> load_store_infos;
+
+	std::vector<SubpassInfo> subpass_infos;
+
+	RenderPass *render_pass{nullptr};
+
+	PipelineState pipeline_state;
+
+	VkSamplerCreateInfo sampler_info{};
+
+	VkDeviceSize uniform_alignment{256};
+
+	std::unique_ptr<core::Buffer> uniform_buffer;
+};
+
+constexpr uint64_t CacheSetup::UNIFORM_KEY_COUNT;
+
+/**
+ * @brief Measures requests served by the cache, after a first request built the object
+ */
+template <typename Request>
+void run_hits(State &state, Device &device, Request request)
+{
+	ResourceCache cache{device};
+	request(cache, 0);
+
+	while (state.keep_running())
+	{
+		request(cache, 0);
+	}
+}
+
+/**
+ * @brief Measures requests building a new object, with a new key for each iteration
+ *        The cache is replaced outside of the measured time once it holds a number of objects,
+ *        which bounds the objects alive and lets the keys repeat.
+ * @param key_count Number of different keys the request builds objects for, 1 to replace the cache every iteration
+ */
+template <typename Request>
+void run_misses(State &state, Device &device, uint64_t key_count, Request request)
+{
+	std::unique_ptr<ResourceCache> cache;
+
+	while (state.keep_running())
+	{
+		uint64_t key = state.get_iteration() % key_count;
+
+		if (key == 0)
+		{
+			state.pause_timing();
+			cache.reset();
+			cache = std::make_unique<ResourceCache>(device);
+			state.resume_timing();
+		}
+
+		request(*cache, key);
+	}
+}
+}        // namespace
+
+void register_resource_cache_benchmarks(Registry &registry, HeadlessContext &context)
+{
+	registry.add("hash_param/shader_module_key", [](State &state) {
+		ShaderSource  source{"base.frag"};
+		ShaderVariant variant;
+		variant.add_define("HAS_BASE_COLOR_TEXTURE");
+
+		std::string entry_point{"main"};
+
+		size_t hash = 0;
+		while (state.keep_running())
+		{
+			hash_param(hash, VK_SHADER_STAGE_FRAGMENT_BIT, source, entry_point, variant);
+		}
+
+		// Keeps the hashing from being optimized out
+		if (hash == 1)
+		{
+			LOGI("Unlikely hash");
+		}
+	});
+
+	registry.add("hash_param/render_pass_key", [](State &state) {
+		std::vector<Attachment> attachments{{VK_FORMAT_R8G8B8A8_UNORM, VK_SAMPLE_COUNT_1_BIT, VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT},
+		                                    {VK_FORMAT_A2B10G10R10_UNORM_PACK32, VK_SAMPLE_COUNT_1_BIT, VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT},
+		                                    {VK_FORMAT_D32_SFLOAT, VK_SAMPLE_COUNT_1_BIT, VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT}};
+
+		std::vector<LoadStoreInfo> load_store_infos(attachments.size());
+
+		SubpassInfo subpass_info{};
+		subpass_info.output_attachments = {0, 1};
+
+		std::vector<SubpassInfo> subpass_infos{subpass_info};
+
+		size_t hash = 0;
+		while (state.keep_running())
+		{
+			hash_param(hash, attachments, load_store_infos, subpass_infos);
+		}
+
+		if (hash == 1)
+		{
+			LOGI("Unlikely hash");
+		}
+	});
+
+	registry.add("hash_param/descriptor_buffer_infos", [](State &state) {
+		BindingMap<VkDescriptorBufferInfo> buffer_infos;
+		for (uint32_t binding = 0; binding < 4; ++binding)
+		{
+			buffer_infos[binding][0] = {VK_NULL_HANDLE, binding * 256, 256};
+		}
+
+		BindingMap<VkDescriptorImageInfo> image_infos;
+
+		size_t hash = 0;
+		while (state.keep_running())
+		{
+			hash_param(hash, buffer_infos, image_infos);
+		}
+
+		if (hash == 1)
+		{
+			LOGI("Unlikely hash");
+		}
+	});
+
+	registry.add("hash_param/sampler_key", [](State &state) {
+		VkSamplerCreateInfo info{VK_STRUCTURE_TYPE_SAMPLER_CREATE_INFO};
+		info.maxLod = VK_LOD_CLAMP_NONE;
+
+		size_t hash = 0;
+		while (state.keep_running())
+		{
+			hash_param(hash, info);
+		}
+
+		if (hash == 1)
+		{
+			LOGI("Unlikely hash");
+		}
+	});
+
+	registry.add("resource_cache/shader_module_hit", [&context](State &state) {
+		CacheSetup setup{context};
+
+		run_hits(state, context.get_device(), [&](ResourceCache &cache, uint64_t) {
+			cache.request_shader_module(VK_SHADER_STAGE_VERTEX_BIT, setup.vertex_source);
+		});
+	});
+
+	registry.add("resource_cache/shader_module_miss", [&context](State &state) {
+		CacheSetup setup{context};
+
+		// Each key is a variant, compiled from GLSL
+		run_misses(state, context.get_device(), 64, [&](ResourceCache &cache, uint64_t key) {
+			ShaderVariant variant;
+			variant.add_define("BENCHMARK_KEY " + std::to_string(key));
+
+			cache.request_shader_module(VK_SHADER_STAGE_VERTEX_BIT, setup.vertex_source, variant);
+		});
+	});
+
+	registry.add("resource_cache/pipeline_layout_hit", [&context](State &state) {
+		CacheSetup setup{context};
+
+		run_hits(state, context.get_device(), [&](ResourceCache &cache, uint64_t) {
+			cache.request_pipeline_layout({setup.vertex_shader, setup.fragment_shader});
+		});
+	});
+
+	registry.add("resource_cache/pipeline_layout_miss", [&context](State &state) {
+		CacheSetup setup{context};
+
+		run_misses(state, context.get_device(), 1, [&](ResourceCache &cache, uint64_t) {
+			cache.request_pipeline_layout({setup.vertex_shader, setup.fragment_shader});
+		});
+	});
+
+	registry.add("resource_cache/descriptor_set_layout_hit", [&context](State &state) {
+		CacheSetup setup{context};
+
+		run_hits(state, context.get_device(), [&](ResourceCache &cache, uint64_t) {
+			cache.request_descriptor_set_layout(0, setup.set_resources);
+		});
+	});
+
+	registry.add("resource_cache/descriptor_set_layout_miss", [&context](State &state) {
+		CacheSetup setup{context};
+
+		run_misses(state, context.get_device(), 1, [&](ResourceCache &cache, uint64_t) {
+			cache.request_descriptor_set_layout(0, setup.set_resources);
+		});
+	});
+
+	registry.add("resource_cache/render_pass_hit", [&context](State &state) {
+		CacheSetup setup{context};
+
+		run_hits(state, context.get_device(), [&](ResourceCache &cache, uint64_t) {
+			cache.request_render_pass(setup.attachments, setup.load_store_infos, setup.subpass_infos);
+		});
+	});
+
+	registry.add("resource_cache/render_pass_miss", [&context](State &state) {
+		CacheSetup setup{context};
+
+		run_misses(state, context.get_device(), 1, [&](ResourceCache &cache, uint64_t) {
+			cache.request_render_pass(setup.attachments, setup.load_store_infos, setup.subpass_infos);
+		});
+	});
+
+	registry.add("resource_cache/graphics_pipeline_hit", [&context](State &state) {
+		CacheSetup setup{context};
+
+		run_hits(state, context.get_device(), [&](ResourceCache &cache, uint64_t) {
+			cache.request_graphics_pipeline(setup.pipeline_state);
+		});
+	});
+
+	registry.add("resource_cache/graphics_pipeline_miss", [&context](State &state) {
+		CacheSetup setup{context};
+
+		// Every cache has an empty pipeline cache, so each miss compiles the pipeline
+		run_misses(state, context.get_device(), 1, [&](ResourceCache &cache, uint64_t) {
+			cache.request_graphics_pipeline(setup.pipeline_state);
+		});
+	});
+
+	registry.add("resource_cache/descriptor_set_hit", [&context](State &state) {
+		CacheSetup setup{context};
+		auto       buffer_infos = setup.get_buffer_infos(0);
+
+		run_hits(state, context.get_device(), [&](ResourceCache &cache, uint64_t) {
+			cache.request_descriptor_set(setup.get_descriptor_set_layout(), buffer_infos, {});
+		});
+	});
+
+	registry.add("resource_cache/descriptor_set_miss", [&context](State &state) {
+		CacheSetup setup{context};
+
+		std::vector<BindingMap<VkDescriptorBufferInfo>> buffer_infos;
+		for (uint64_t key = 0; key < CacheSetup::UNIFORM_KEY_COUNT; ++key)
+		{
+			buffer_infos.push_back(setup.get_buffer_infos(key));
+		}
+
+		run_misses(state, context.get_device(), CacheSetup::UNIFORM_KEY_COUNT, [&](ResourceCache &cache, uint64_t key) {
+			cache.request_descriptor_set(setup.get_descriptor_set_layout(), buffer_infos[key], {});
+		});
+	});
+
+	registry.add("resource_cache/framebuffer_hit", [&context](State &state) {
+		CacheSetup setup{context};
+
+		run_hits(state, context.get_device(), [&](ResourceCache &cache, uint64_t) {
+			cache.request_framebuffer(setup.render_target, *setup.render_pass);
+		});
+	});
+
+	registry.add("resource_cache/framebuffer_miss", [&context](State &state) {
+		CacheSetup setup{context};
+
+		run_misses(state, context.get_device(), 1, [&](ResourceCache &cache, uint64_t) {
+			cache.request_framebuffer(setup.render_target, *setup.render_pass);
+		});
+	});
+
+	registry.add("resource_cache/sampler_hit", [&context](State &state) {
+		CacheSetup setup{context};
+
+		run_hits(state, context.get_device(), [&](ResourceCache &cache, uint64_t) {
+			cache.request_sampler(setup.sampler_info);
+		});
+	});
+
+	registry.add("resource_cache/sampler_miss", [&context](State &state) {
+		CacheSetup setup{context};
+
+		// Well below the sampler allocation limit of 4000
+		run_misses(state, context.get_device(), 1024, [&](ResourceCache &cache, uint64_t key) {
+			auto info       = setup.sampler_info;
+			info.mipLodBias = 0.001f * static_cast<float>(key);
+
+			cache.request_sampler(info);
+		});
+	});
+}
+}        // namespace benchmark
+}        // namespace vkb
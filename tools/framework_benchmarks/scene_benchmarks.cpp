@@ -0,0 +1,128 @@
+/* Copyright (c) 2020, Arm Limited and Contributors
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 the "License";
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "benchmark.h"
+
+#include "common/logging.h"
+#include "scene_graph/components/transform.h"
+#include "scene_graph/node.h"
+#include "scene_graph/transform_hierarchy.h"
+
+namespace vkb
+{
+namespace benchmark
+{
+namespace
+{
+/**
+ * @brief Nodes parented in a chain, each node the child of the previous one
+ */
+std::vector<std::unique_ptr<sg::Node>> create_chain(uint32_t depth)
+{
+	std::vector<std::unique_ptr<sg::Node>> nodes;
+
+	for (uint32_t i = 0; i < depth; ++i)
+	{
+		auto node = std::make_unique<sg::Node>(i, "node_" + std::to_string(i));
+		node->get_transform().set_translation(glm::vec3(1.0f, 0.0f, 0.0f));
+
+		if (!nodes.empty())
+		{
+			node->set_parent(*nodes.back());
+			nodes.back()->add_child(*node);
+		}
+
+		nodes.push_back(std::move(node));
+	}
+
+	return nodes;
+}
+
+void register_world_matrix_benchmarks(Registry &registry, uint32_t depth)
+{
+	auto suffix = "_depth_" + std::to_string(depth);
+
+	registry.add("transform/world_matrix_cached" + suffix, [depth](State &state) {
+		auto  nodes = create_chain(depth);
+		auto &leaf  = nodes.back()->get_transform();
+		leaf.get_world_matrix();
+
+		float sum = 0.0f;
+		while (state.keep_running())
+		{
+			sum += leaf.get_world_matrix()[3][0];
+		}
+
+		// Keeps the requests from being optimized out
+		if (sum < 0.0f)
+		{
+			LOGI("Unexpected translation");
+		}
+	});
+
+	registry.add("transform/world_matrix_dirty" + suffix, [depth](State &state) {
+		auto  nodes = create_chain(depth);
+		auto &leaf  = nodes.back()->get_transform();
+
+		float sum = 0.0f;
+		while (state.keep_running())
+		{
+			// Every node of the chain moved, so the request recomputes the whole chain
+			state.pause_timing();
+			for (auto &node : nodes)
+			{
+				node->get_transform().invalidate_world_matrix();
+			}
+			state.resume_timing();
+
+			sum += leaf.get_world_matrix()[3][0];
+		}
+
+		if (sum < 0.0f)
+		{
+			LOGI("Unexpected translation");
+		}
+	});
+
+	registry.add("transform_hierarchy/update_root_moved" + suffix, [depth](State &state) {
+		auto nodes = create_chain(depth);
+
+		sg::TransformHierarchy hierarchy;
+		hierarchy.set_root_node(*nodes.front());
+		hierarchy.update();
+
+		auto &root = nodes.front()->get_transform();
+
+		while (state.keep_running())
+		{
+			state.pause_timing();
+			root.invalidate_world_matrix();
+			state.resume_timing();
+
+			hierarchy.update();
+		}
+	});
+}
+}        // namespace
+
+void register_scene_benchmarks(Registry &registry)
+{
+	register_world_matrix_benchmarks(registry, 8);
+	register_world_matrix_benchmarks(registry, 64);
+}
+}        // namespace benchmark
+}        // namespace vkb